@@ -19,7 +19,8 @@
 
 static napi_value Runner(napi_env env,
                          napi_callback_info info,
-                         napi_value property_key) {
+                         napi_value property_key,
+                         node_api_property_key property_key_handle) {
   napi_value argv[2], undefined, js_array_length, start, end;
   size_t argc = 2;
   napi_valuetype val_type = napi_undefined;
@@ -55,9 +56,16 @@ static napi_value Runner(napi_env env,
   // Start the benchmark.
   napi_call_function(env, argv[0], start, 0, nullptr, nullptr);
 
-  for (uint32_t idx = 0; idx < array_length; idx++) {
-    NODE_API_CALL(
-        napi_set_property(env, native_array[idx], property_key, undefined));
+  if (property_key_handle != nullptr) {
+    for (uint32_t idx = 0; idx < array_length; idx++) {
+      NODE_API_CALL(node_api_set_property_by_key(
+          env, native_array[idx], property_key_handle, undefined));
+    }
+  } else {
+    for (uint32_t idx = 0; idx < array_length; idx++) {
+      NODE_API_CALL(
+          napi_set_property(env, native_array[idx], property_key, undefined));
+    }
   }
 
   // Conclude the benchmark.
@@ -73,14 +81,26 @@ static napi_value RunPropertyKey(napi_env env, napi_callback_info info) {
   napi_value property_key;
   NODE_API_CALL(node_api_create_property_key_utf16(
       env, u"prop", NAPI_AUTO_LENGTH, &property_key));
-  return Runner(env, info, property_key);
+  return Runner(env, info, property_key, nullptr);
+}
+
+static napi_value RunPropertyKeyHandle(napi_env env, napi_callback_info info) {
+  napi_value property_key, result;
+  node_api_property_key property_key_handle;
+  NODE_API_CALL(node_api_create_property_key_utf16(
+      env, u"prop", NAPI_AUTO_LENGTH, &property_key));
+  NODE_API_CALL(node_api_create_property_key_handle(
+      env, property_key, &property_key_handle));
+  result = Runner(env, info, property_key, property_key_handle);
+  NODE_API_CALL(node_api_delete_property_key_handle(env, property_key_handle));
+  return result;
 }
 
 static napi_value RunNormalString(napi_env env, napi_callback_info info) {
   napi_value property_key;
   NODE_API_CALL(
       napi_create_string_utf16(env, u"prop", NAPI_AUTO_LENGTH, &property_key));
-  return Runner(env, info, property_key);
+  return Runner(env, info, property_key, nullptr);
 }
 
 NAPI_MODULE_INIT() {
@@ -94,6 +114,15 @@ NAPI_MODULE_INIT() {
        static_cast<napi_property_attributes>(napi_writable | napi_configurable |
                                              napi_enumerable),
        nullptr},
+      {"RunPropertyKeyHandle",
+       nullptr,
+       RunPropertyKeyHandle,
+       nullptr,
+       nullptr,
+       nullptr,
+       static_cast<napi_property_attributes>(napi_writable | napi_configurable |
+                                             napi_enumerable),
+       nullptr},
       {"RunNormalString",
        nullptr,
        RunNormalString,
@@ -6,7 +6,7 @@ const binding = require(`./build/${common.buildType}/binding`);
 
 const bench = common.createBenchmark(main, {
   n: [5e6],
-  implem: ['RunPropertyKey', 'RunNormalString'],
+  implem: ['RunPropertyKey', 'RunPropertyKeyHandle', 'RunNormalString'],
 });
 
 function main({ n, implem }) {
@@ -595,6 +595,52 @@ shared_optgroup.add_argument('--shared-zstd-libpath',
     dest='shared_zstd_libpath',
     help='a directory to search for the shared zstd DLL')
 
+shared_optgroup.add_argument('--shared-libdeflate',
+    action='store_true',
+    dest='shared_libdeflate',
+    default=None,
+    help='link to a shared libdeflate DLL and use it for one-shot ' +
+         'zlib compression and decompression')
+
+shared_optgroup.add_argument('--shared-libdeflate-includes',
+    action='store',
+    dest='shared_libdeflate_includes',
+    help='directory containing libdeflate header files')
+
+shared_optgroup.add_argument('--shared-libdeflate-libname',
+    action='store',
+    dest='shared_libdeflate_libname',
+    default='deflate',
+    help='alternative lib name to link to [default: %(default)s]')
+
+shared_optgroup.add_argument('--shared-libdeflate-libpath',
+    action='store',
+    dest='shared_libdeflate_libpath',
+    help='a directory to search for the shared libdeflate DLL')
+
+shared_optgroup.add_argument('--shared-mimalloc',
+    action='store_true',
+    dest='shared_mimalloc',
+    default=None,
+    help='link to a shared mimalloc DLL built with MI_OVERRIDE and use it ' +
+         'in place of the system malloc')
+
+shared_optgroup.add_argument('--shared-mimalloc-includes',
+    action='store',
+    dest='shared_mimalloc_includes',
+    help='directory containing mimalloc header files')
+
+shared_optgroup.add_argument('--shared-mimalloc-libname',
+    action='store',
+    dest='shared_mimalloc_libname',
+    default='mimalloc',
+    help='alternative lib name to link to [default: %(default)s]')
+
+shared_optgroup.add_argument('--shared-mimalloc-libpath',
+    action='store',
+    dest='shared_mimalloc_libpath',
+    help='a directory to search for the shared mimalloc DLL')
+
 parser.add_argument_group(shared_optgroup)
 
 for builtin in shareable_builtins:
@@ -1439,9 +1485,11 @@ def configure_node_lib_files(o):
   o['variables']['node_library_files'] = SearchFiles('lib', 'js')
 
 def configure_node_cctest_sources(o):
+  # test/cctest/benchmark has its own main() and is built by the
+  # cctest_benchmark target instead.
+  sources = SearchFiles('test/cctest', 'cc') + SearchFiles('test/cctest', 'h')
   o['variables']['node_cctest_sources'] = [ 'src/node_snapshot_stub.cc' ] + \
-    SearchFiles('test/cctest', 'cc') + \
-    SearchFiles('test/cctest', 'h')
+    [ f for f in sources if not f.startswith('test/cctest/benchmark/') ]
 
 def configure_node(o):
   if options.dest_os == 'android':
@@ -2286,6 +2334,8 @@ configure_library('ngtcp2', output, pkgname='libngtcp2')
 configure_sqlite(output);
 configure_library('uvwasi', output)
 configure_library('zstd', output, pkgname='libzstd')
+configure_library('libdeflate', output, pkgname='libdeflate')
+configure_library('mimalloc', output, pkgname='mimalloc')
 configure_v8(output, configurations)
 configure_openssl(output)
 configure_intl(output)
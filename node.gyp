@@ -17,6 +17,8 @@
     'node_use_amaro%': 'true',
     'node_shared_brotli%': 'false',
     'node_shared_zstd%': 'false',
+    'node_shared_libdeflate%': 'false',
+    'node_shared_mimalloc%': 'false',
     'node_shared_zlib%': 'false',
     'node_shared_http_parser%': 'false',
     'node_shared_cares%': 'false',
@@ -73,16 +75,19 @@
       'src/async_context_frame.cc',
       'src/async_wrap.cc',
       'src/base_object.cc',
+      'src/buffer_pool.cc',
       'src/cares_wrap.cc',
       'src/cleanup_queue.cc',
       'src/compile_cache.cc',
       'src/connect_wrap.cc',
       'src/connection_wrap.cc',
+      'src/cppgc_async_wrap.cc',
       'src/dataqueue/queue.cc',
       'src/debug_utils.cc',
       'src/embedded_data.cc',
       'src/encoding_binding.cc',
       'src/env.cc',
+      'src/event_loop_phases.cc',
       'src/fs_event_wrap.cc',
       'src/handle_wrap.cc',
       'src/heap_utils.cc',
@@ -117,18 +122,22 @@
       'src/node_errors.cc',
       'src/node_external_reference.cc',
       'src/node_file.cc',
+      'src/node_fs_watcher.cc',
       'src/node_http_parser.cc',
       'src/node_http2.cc',
       'src/node_i18n.cc',
+      'src/node_json.cc',
       'src/node_main_instance.cc',
       'src/node_messaging.cc',
       'src/node_metadata.cc',
       'src/node_modules.cc',
+      'src/node_numa.cc',
       'src/node_options.cc',
       'src/node_os.cc',
       'src/node_perf.cc',
       'src/node_platform.cc',
       'src/node_postmortem_metadata.cc',
+      'src/node_prestart.cc',
       'src/node_process_events.cc',
       'src/node_process_methods.cc',
       'src/node_process_object.cc',
@@ -145,6 +154,7 @@
       'src/node_symbols.cc',
       'src/node_task_queue.cc',
       'src/node_task_runner.cc',
+      'src/node_thread_stats.cc',
       'src/node_trace_events.cc',
       'src/node_types.cc',
       'src/node_url.cc',
@@ -165,6 +175,7 @@
       'src/permission/worker_permission.cc',
       'src/permission/net_permission.cc',
       'src/pipe_wrap.cc',
+      'src/process_handle.cc',
       'src/process_wrap.cc',
       'src/signal_wrap.cc',
       'src/spawn_sync.cc',
@@ -174,11 +185,14 @@
       'src/string_bytes.cc',
       'src/string_decoder.cc',
       'src/tcp_wrap.cc',
+      'src/threadpool_limiter.cc',
       'src/timers.cc',
+      'src/timer_wheel.cc',
       'src/timer_wrap.cc',
       'src/tracing/agent.cc',
       'src/tracing/node_trace_buffer.cc',
       'src/tracing/node_trace_writer.cc',
+      'src/tracing/perfetto_trace_writer.cc',
       'src/tracing/trace_event.cc',
       'src/tracing/traced_value.cc',
       'src/tty_wrap.cc',
@@ -197,6 +211,7 @@
       'src/base_object-inl.h',
       'src/base_object_types.h',
       'src/blob_serializer_deserializer.h',
+      'src/buffer_pool.h',
       'src/blob_serializer_deserializer-inl.h',
       'src/callback_queue.h',
       'src/callback_queue-inl.h',
@@ -205,6 +220,8 @@
       'src/compile_cache.h',
       'src/connect_wrap.h',
       'src/connection_wrap.h',
+      'src/cppgc_async_wrap.h',
+      'src/cppgc_async_wrap-inl.h',
       'src/cppgc_helpers.h',
       'src/cppgc_helpers.cc',
       'src/dataqueue/queue.h',
@@ -215,6 +232,7 @@
       'src/env_properties.h',
       'src/env.h',
       'src/env-inl.h',
+      'src/event_loop_phases.h',
       'src/handle_wrap.h',
       'src/histogram.h',
       'src/histogram-inl.h',
@@ -244,12 +262,15 @@
       'src/node_external_reference.h',
       'src/node_file.h',
       'src/node_file-inl.h',
+      'src/node_fs_watcher.h',
       'src/node_http_common.h',
       'src/node_http_common-inl.h',
+      'src/node_http_parser.h',
       'src/node_http2.h',
       'src/node_http2_state.h',
       'src/node_i18n.h',
       'src/node_internals.h',
+      'src/node_json.h',
       'src/node_main_instance.h',
       'src/node_mem.h',
       'src/node_mem-inl.h',
@@ -257,12 +278,14 @@
       'src/node_metadata.h',
       'src/node_mutex.h',
       'src/node_modules.h',
+      'src/node_numa.h',
       'src/node_object_wrap.h',
       'src/node_options.h',
       'src/node_options-inl.h',
       'src/node_perf.h',
       'src/node_perf_common.h',
       'src/node_platform.h',
+      'src/node_prestart.h',
       'src/node_process.h',
       'src/node_process-inl.h',
       'src/node_realm.h',
@@ -277,6 +300,7 @@
       'src/node_sockaddr.h',
       'src/node_sockaddr-inl.h',
       'src/node_stat_watcher.h',
+      'src/node_thread_stats.h',
       'src/node_union_bytes.h',
       'src/node_url.h',
       'src/node_url_pattern.h',
@@ -286,6 +310,7 @@
       'src/node_wasi.h',
       'src/node_watchdog.h',
       'src/node_worker.h',
+      'src/node_zlib.h',
       'src/path.h',
       'src/permission/child_process_permission.h',
       'src/permission/fs_permission.h',
@@ -295,6 +320,8 @@
       'src/permission/worker_permission.h',
       'src/permission/net_permission.h',
       'src/pipe_wrap.h',
+      'src/process_handle.h',
+      'src/proto_writer.h',
       'src/req_wrap.h',
       'src/req_wrap-inl.h',
       'src/spawn_sync.h',
@@ -306,17 +333,21 @@
       'src/string_decoder.h',
       'src/string_decoder-inl.h',
       'src/tcp_wrap.h',
+      'src/threadpool_limiter.h',
       'src/timers.h',
       'src/tracing/agent.h',
       'src/tracing/node_trace_buffer.h',
       'src/tracing/node_trace_writer.h',
+      'src/tracing/perfetto_trace_writer.h',
       'src/tracing/trace_event.h',
       'src/tracing/trace_event_common.h',
       'src/tracing/traced_value.h',
+      'src/timer_wheel.h',
       'src/timer_wrap.h',
       'src/timer_wrap-inl.h',
       'src/tty_wrap.h',
       'src/udp_wrap.h',
+      'src/url_pattern_regexp_cache.h',
       'src/util.h',
       'src/util-inl.h',
     ],
@@ -407,17 +438,33 @@
     ],
     'node_cctest_openssl_sources': [
       'test/cctest/test_crypto_clienthello.cc',
+      'test/cctest/test_crypto_ktls.cc',
       'test/cctest/test_node_crypto.cc',
       'test/cctest/test_node_crypto_env.cc',
       'test/cctest/test_quic_cid.cc',
       'test/cctest/test_quic_error.cc',
       'test/cctest/test_quic_tokens.cc',
     ],
+    'node_cctest_sqlite_sources': [
+      'test/cctest/test_sqlite_statement_cache.cc',
+      'test/cctest/test_webstorage.cc',
+    ],
     'node_cctest_inspector_sources': [
       'test/cctest/inspector/test_node_protocol.cc',
       'test/cctest/test_inspector_socket.cc',
       'test/cctest/test_inspector_socket_server.cc',
     ],
+    'node_cctest_benchmark_sources': [
+      'test/cctest/node_test_fixture.cc',
+      'test/cctest/node_test_fixture.h',
+      'test/cctest/benchmark/bench_dataqueue.cc',
+      'test/cctest/benchmark/bench_http_parser.cc',
+      'test/cctest/benchmark/bench_messaging.cc',
+      'test/cctest/benchmark/bench_string_bytes.cc',
+      'test/cctest/benchmark/bench_zlib.cc',
+      'test/cctest/benchmark/microbenchmark.cc',
+      'test/cctest/benchmark/microbenchmark.h',
+    ],
     'node_sqlite_sources': [
       'src/node_sqlite.cc',
       'src/node_webstorage.cc',
@@ -1231,6 +1278,9 @@
            ],
            'sources!': [ '<@(node_cctest_inspector_sources)' ],
         }],
+        [ 'node_use_sqlite!="true"', {
+          'sources!': [ '<@(node_cctest_sqlite_sources)' ],
+        }],
         ['OS=="solaris"', {
           'ldflags': [ '-I<(SHARED_INTERMEDIATE_DIR)' ]
         }],
@@ -1257,6 +1307,77 @@
       ],
     }, # cctest
 
+    {
+      'target_name': 'cctest_benchmark',
+      'type': 'executable',
+
+      'dependencies': [
+        '<(node_lib_target_name)',
+        'deps/googletest/googletest.gyp:gtest',
+        'deps/histogram/histogram.gyp:histogram',
+        'deps/nbytes/nbytes.gyp:nbytes',
+        'tools/v8_gypfiles/abseil.gyp:abseil',
+      ],
+
+      'includes': [
+        'node.gypi'
+      ],
+
+      'include_dirs': [
+        'src',
+        'tools/msvs/genfiles',
+        'deps/v8/include',
+        'deps/cares/include',
+        'deps/uv/include',
+        'test/cctest',
+      ],
+
+      'defines': [
+        'NODE_ARCH="<(target_arch)"',
+        'NODE_PLATFORM="<(OS)"',
+        'NODE_WANT_INTERNALS=1',
+      ],
+
+      'sources': [ '<@(node_cctest_benchmark_sources)' ],
+
+      'conditions': [
+        [ 'node_use_openssl=="true"', {
+          'defines': [
+            'HAVE_OPENSSL=1',
+          ],
+        }],
+        ['v8_enable_inspector==1', {
+          'defines': [
+            'HAVE_INSPECTOR=1',
+          ],
+        }, {
+          'defines': [
+            'HAVE_INSPECTOR=0',
+          ],
+        }],
+        # Skip the benchmarks while building shared lib node for Windows
+        [ 'OS=="win" and node_shared=="true"', {
+          'type': 'none',
+        }],
+        [ 'node_shared=="true"', {
+          'xcode_settings': {
+            'OTHER_LDFLAGS': [ '-Wl,-rpath,@loader_path', ],
+          },
+        }],
+        ['OS=="win"', {
+          'libraries': [
+            'Dbghelp.lib',
+            'winmm.lib',
+            'Ws2_32.lib',
+          ],
+        }],
+        # Avoid excessive LTO
+        ['enable_lto=="true"', {
+          'ldflags': [ '-fno-lto' ],
+        }],
+      ],
+    }, # cctest_benchmark
+
     {
       'target_name': 'embedtest',
       'type': 'executable',
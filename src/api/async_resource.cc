@@ -17,9 +17,10 @@ AsyncResource::AsyncResource(Isolate* isolate,
                              const char* name,
                              async_id trigger_async_id)
     : env_(Environment::GetCurrent(isolate)),
-      resource_(isolate, resource),
-      context_frame_(isolate, async_context_frame::current(isolate)) {
+      resource_(isolate, resource) {
   CHECK_NOT_NULL(env_);
+  async_context_frame::retain(
+      isolate, &context_frame_, async_context_frame::current(isolate));
   async_context_ = EmitAsyncInit(isolate, resource, name, trigger_async_id);
 }
 
@@ -80,8 +80,10 @@ InternalCallbackScope::InternalCallbackScope(Environment* env,
 
   isolate->SetIdle(false);
 
-  prior_context_frame_.Reset(
-      isolate, async_context_frame::exchange(isolate, context_frame));
+  async_context_frame::retain(
+      isolate,
+      &prior_context_frame_,
+      async_context_frame::exchange(isolate, context_frame));
 
   env->async_hooks()->push_async_context(
     async_context_.async_id, async_context_.trigger_async_id, object);
@@ -141,6 +143,8 @@ void InternalCallbackScope::Close() {
   if (!env_->can_call_into_js()) return;
 
   auto weakref_cleanup = OnScopeLeave([&]() { env_->RunWeakRefCleanup(); });
+  EventLoopPhaseTimer::Scope phase_scope(env_->event_loop_phase_timer(),
+                                         EventLoopPhase::kMicrotasks);
 
   Local<Context> context = env_->context();
   if (!tick_info->has_tick_scheduled()) {
@@ -177,6 +181,13 @@ void InternalCallbackScope::Close() {
   perform_stopping_check();
 }
 
+CallbackBatchScope::CallbackBatchScope(Environment* env, Local<Object> object) {
+  // The callbacks of the batch run in nested scopes, which leave the task
+  // queues to this one.
+  if (env->options()->coalesce_task_queues)
+    scope_.emplace(env, object, async_context{0, 0});
+}
+
 MaybeLocal<Value> InternalMakeCallback(Environment* env,
                                        Local<Object> resource,
                                        Local<Object> recv,
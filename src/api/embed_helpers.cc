@@ -4,6 +4,7 @@
 #include "node_snapshot_builder.h"
 
 using v8::Context;
+using v8::ContextDependants;
 using v8::Function;
 using v8::Global;
 using v8::HandleScope;
@@ -85,6 +86,7 @@ struct CommonEnvironmentSetup::Impl {
   DeleteFnPtr<IsolateData, FreeIsolateData> isolate_data;
   DeleteFnPtr<Environment, FreeEnvironment> env;
   Global<Context> main_context;
+  bool from_snapshot = false;
 };
 
 CommonEnvironmentSetup::CommonEnvironmentSetup(
@@ -162,25 +164,72 @@ CommonEnvironmentSetup::CommonEnvironmentSetup(
     impl_->isolate_data.reset(CreateIsolateData(
         isolate, loop, platform, impl_->allocator.get(), snapshot_data));
     impl_->isolate_data->set_snapshot_config(snapshot_config);
+    impl_->from_snapshot = snapshot_data != nullptr;
 
-    if (snapshot_data) {
-      impl_->env.reset(make_env(this));
-      if (impl_->env) {
-        impl_->main_context.Reset(isolate, impl_->env->context());
-      }
-      return;
-    }
+    InitializeEnvironment(errors, make_env);
+  }
+}
 
-    Local<Context> context = NewContext(isolate);
-    impl_->main_context.Reset(isolate, context);
-    if (context.IsEmpty()) {
-      errors->push_back("Failed to initialize V8 Context");
-      return;
-    }
+void CommonEnvironmentSetup::InitializeEnvironment(
+    std::vector<std::string>* errors,
+    const std::function<Environment*(const CommonEnvironmentSetup*)>&
+        make_env) {
+  Isolate* isolate = impl_->isolate;
+  HandleScope handle_scope(isolate);
 
-    Context::Scope context_scope(context);
+  if (impl_->from_snapshot) {
     impl_->env.reset(make_env(this));
+    if (impl_->env) {
+      impl_->main_context.Reset(isolate, impl_->env->context());
+    }
+    return;
+  }
+
+  Local<Context> context = NewContext(isolate);
+  impl_->main_context.Reset(isolate, context);
+  if (context.IsEmpty()) {
+    errors->push_back("Failed to initialize V8 Context");
+    return;
   }
+
+  Context::Scope context_scope(context);
+  impl_->env.reset(make_env(this));
+}
+
+Environment* CommonEnvironmentSetup::ResetEnvironmentImpl(
+    std::vector<std::string>* errors,
+    const std::function<Environment*(const CommonEnvironmentSetup*)>&
+        make_env) {
+  CHECK_NOT_NULL(errors);
+  CHECK(!impl_->snapshot_creator.has_value());
+  Isolate* isolate = impl_->isolate;
+  CHECK_NOT_NULL(isolate);
+
+  Locker locker(isolate);
+  Isolate::Scope isolate_scope(isolate);
+  impl_->main_context.Reset();
+  impl_->env.reset();
+  // Most of the heap is garbage of the old Environment now, which V8 can
+  // take into account when scheduling the next garbage collection.
+  isolate->ContextDisposedNotification(ContextDependants::kNoDependants);
+
+  size_t error_count = errors->size();
+  {
+    HandleScope handle_scope(isolate);
+    TryCatch bootstrapCatch(isolate);
+    auto print_Exception = OnScopeLeave([&]() {
+      if (bootstrapCatch.HasCaught()) {
+        errors->push_back(FormatCaughtException(
+            isolate, isolate->GetCurrentContext(), bootstrapCatch));
+      }
+    });
+    InitializeEnvironment(errors, make_env);
+  }
+  if (errors->size() != error_count) {
+    impl_->main_context.Reset();
+    impl_->env.reset();
+  }
+  return impl_->env.get();
 }
 
 CommonEnvironmentSetup::CommonEnvironmentSetup(
@@ -1,5 +1,6 @@
 #include <cstdlib>
 #include "env_properties.h"
+#include "large_pages/node_large_page.h"
 #include "node.h"
 #include "node_builtins.h"
 #include "node_context_data.h"
@@ -106,6 +107,16 @@ MaybeLocal<Value> PrepareStackTraceCallback(Local<Context> context,
   return result;
 }
 
+NodeArrayBufferAllocator::NodeArrayBufferAllocator()
+    : huge_page_threshold_(per_process::cli_options->huge_page_threshold) {}
+
+void NodeArrayBufferAllocator::MaybeAdviseHugePages(void* data, size_t size) {
+  // Large allocations get fresh pages from mmap(), so this takes effect
+  // before they are first touched, including for zero-filled ones.
+  if (huge_page_threshold_ != 0 && size >= huge_page_threshold_)
+    AdviseTransparentHugePages(data, size);
+}
+
 void* NodeArrayBufferAllocator::Allocate(size_t size) {
   void* ret;
   if (zero_fill_field_ || per_process::cli_options->zero_fill_all_buffers)
@@ -114,6 +125,7 @@ void* NodeArrayBufferAllocator::Allocate(size_t size) {
     ret = allocator_->AllocateUninitialized(size);
   if (ret != nullptr) [[likely]] {
     total_mem_usage_.fetch_add(size, std::memory_order_relaxed);
+    MaybeAdviseHugePages(ret, size);
   }
   return ret;
 }
@@ -122,6 +134,7 @@ void* NodeArrayBufferAllocator::AllocateUninitialized(size_t size) {
   void* ret = allocator_->AllocateUninitialized(size);
   if (ret != nullptr) [[likely]] {
     total_mem_usage_.fetch_add(size, std::memory_order_relaxed);
+    MaybeAdviseHugePages(ret, size);
   }
   return ret;
 }
@@ -272,6 +285,13 @@ void SetIsolateMiscHandlers(v8::Isolate* isolate, const IsolateSettings& s) {
     isolate->SetWasmStreamingCallback(wasm_web_api::StartStreamingCompilation);
   }
 
+  if (wasm_web_api::SharedModuleCache::Get() != nullptr) {
+    isolate->SetWasmInstanceCallback(
+        wasm_web_api::RetainInstantiatedModule);
+    isolate->SetWasmAsyncResolvePromiseCallback(
+        wasm_web_api::ResolveWasmPromise);
+  }
+
   if (per_process::cli_options->get_per_isolate_options()
           ->experimental_shadow_realm) {
     isolate->SetHostCreateShadowRealmContextCallback(
@@ -10,11 +10,17 @@
 
 #include "v8.h"
 
+using v8::ArrayBuffer;
 using v8::Context;
+using v8::Float64Array;
+using v8::FunctionCallbackInfo;
+using v8::Global;
+using v8::HandleScope;
 using v8::Isolate;
 using v8::Local;
 using v8::Object;
 using v8::String;
+using v8::Undefined;
 using v8::Value;
 
 namespace node {
@@ -25,7 +31,7 @@ namespace async_context_frame {
 //
 Scope::Scope(Isolate* isolate, Local<Value> object) : isolate_(isolate) {
   auto prior = exchange(isolate, object);
-  prior_.Reset(isolate, prior);
+  retain(isolate, &prior_, prior);
 }
 
 Scope::~Scope() {
@@ -33,19 +39,107 @@ Scope::~Scope() {
   set(isolate_, value);
 }
 
+//
+// CPU time attribution
+//
+void CpuTimeTracker::Enable() {
+  if (enabled_) return;
+  last_ = ThreadCpuTime();
+  enabled_ = true;
+}
+
+uint64_t CpuTimeTracker::ThreadCpuTime() {
+  uv_rusage_t usage;
+  if (uv_getrusage_thread(&usage) != 0) return 0;
+  return (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000000ULL +
+         usage.ru_utime.tv_usec + usage.ru_stime.tv_usec;
+}
+
+void CpuTimeTracker::Charge(Environment* env, Local<Value> frame) {
+  uint64_t now = ThreadCpuTime();
+  uint64_t elapsed = now > last_ ? now - last_ : 0;
+  last_ = now;
+  if (elapsed == 0 || !frame->IsObject()) return;
+
+  HandleScope handle_scope(env->isolate());
+  Local<Value> counter;
+  if (!frame.As<Object>()
+           ->GetPrivate(env->context(),
+                        env->cpu_time_counter_private_symbol())
+           .ToLocal(&counter) ||
+      !counter->IsFloat64Array()) {
+    return;
+  }
+  Local<Float64Array> array = counter.As<Float64Array>();
+  double* data = reinterpret_cast<double*>(
+      static_cast<char*>(array->Buffer()->Data()) + array->ByteOffset());
+  data[0] += elapsed;
+}
+
 Local<Value> current(Isolate* isolate) {
   return isolate->GetContinuationPreservedEmbedderData();
 }
 
 void set(Isolate* isolate, Local<Value> value) {
+  if (value.IsEmpty()) value = Undefined(isolate);
+  // Callbacks mostly run in the frame that is already current, which then
+  // needs neither the Environment lookup nor a CPU time charge.
+  if (value == current(isolate)) return;
+
   auto env = Environment::GetCurrent(isolate);
   if (!env->options()->async_context_frame) {
     return;
   }
 
+  CpuTimeTracker* tracker = env->async_context_frame_cpu_time_tracker();
+  if (tracker->enabled()) [[unlikely]] {
+    tracker->Charge(env, current(isolate));
+  }
+
   isolate->SetContinuationPreservedEmbedderData(value);
 }
 
+// trackCpuTime(frame) attaches a counter to |frame| and returns it, a
+// Float64Array whose only element is the thread CPU time in microseconds
+// spent while the frame was current. Calling it again for the same frame
+// returns the same counter.
+static void TrackCpuTime(const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+  Isolate* isolate = env->isolate();
+  Local<Context> context = env->context();
+  CHECK(args[0]->IsObject());
+  Local<Object> frame = args[0].As<Object>();
+
+  CpuTimeTracker* tracker = env->async_context_frame_cpu_time_tracker();
+  if (!tracker->enabled()) {
+    tracker->Enable();
+  } else if (current(isolate)->StrictEquals(frame)) {
+    // Do not charge time spent before tracking started to a new counter.
+    tracker->Charge(env, current(isolate));
+  }
+
+  Local<Value> counter;
+  if (!frame->GetPrivate(context, env->cpu_time_counter_private_symbol())
+           .ToLocal(&counter)) {
+    return;
+  }
+  if (!counter->IsFloat64Array()) {
+    Local<ArrayBuffer> buffer = ArrayBuffer::New(isolate, sizeof(double));
+    counter = Float64Array::New(buffer, 0, 1);
+    if (frame
+            ->SetPrivate(
+                context, env->cpu_time_counter_private_symbol(), counter)
+            .IsNothing()) {
+      return;
+    }
+  }
+  args.GetReturnValue().Set(counter);
+}
+
+void RegisterExternalReferences(ExternalReferenceRegistry* registry) {
+  registry->Register(TrackCpuTime);
+}
+
 // NOTE: It's generally recommended to use async_context_frame::Scope
 // but sometimes (such as enterWith) a direct exchange is needed.
 Local<Value> exchange(Isolate* isolate, Local<Value> value) {
@@ -54,12 +148,22 @@ Local<Value> exchange(Isolate* isolate, Local<Value> value) {
   return prior;
 }
 
+void retain(Isolate* isolate, Global<Value>* slot, Local<Value> frame) {
+  if (frame.IsEmpty() || frame->IsUndefined()) {
+    slot->Reset();
+  } else {
+    slot->Reset(isolate, frame);
+  }
+}
+
 void CreatePerContextProperties(Local<Object> target,
                                 Local<Value> unused,
                                 Local<Context> context,
                                 void* priv) {
   Environment* env = Environment::GetCurrent(context);
 
+  SetMethod(context, target, "trackCpuTime", TrackCpuTime);
+
   Local<String> getContinuationPreservedEmbedderData = FIXED_ONE_BYTE_STRING(
       env->isolate(), "getContinuationPreservedEmbedderData");
   Local<String> setContinuationPreservedEmbedderData = FIXED_ONE_BYTE_STRING(
@@ -87,3 +191,5 @@ void CreatePerContextProperties(Local<Object> target,
 
 NODE_BINDING_CONTEXT_AWARE_INTERNAL(
     async_context_frame, node::async_context_frame::CreatePerContextProperties)
+NODE_BINDING_EXTERNAL_REFERENCE(
+    async_context_frame, node::async_context_frame::RegisterExternalReferences)
@@ -9,6 +9,9 @@
 #include <cstdint>
 
 namespace node {
+
+class Environment;
+
 namespace async_context_frame {
 
 class Scope {
@@ -21,10 +24,40 @@ class Scope {
   v8::Global<v8::Value> prior_;
 };
 
+// Attributes the thread CPU time spent while a frame is current to that
+// frame, for the frames that trackCpuTime() attached a counter to. Time is
+// charged whenever Node.js switches frames, i.e. when a callback from
+// native code is entered or left. V8 switches frames on its own for promise
+// reactions, so time spent in those is charged to the frame that was
+// current when native code last switched frames.
+class CpuTimeTracker {
+ public:
+  bool enabled() const { return enabled_; }
+  void Enable();
+
+  // Charges the CPU time since the last switch to |frame|.
+  void Charge(Environment* env, v8::Local<v8::Value> frame);
+
+ private:
+  static uint64_t ThreadCpuTime();
+
+  bool enabled_ = false;
+  // Thread CPU time at the last frame switch, in microseconds.
+  uint64_t last_ = 0;
+};
+
 v8::Local<v8::Value> current(v8::Isolate* isolate);
 void set(v8::Isolate* isolate, v8::Local<v8::Value> value);
 v8::Local<v8::Value> exchange(v8::Isolate* isolate, v8::Local<v8::Value> value);
 
+// Keeps |frame| alive in |slot|. Unless AsyncLocalStorage is in use, every
+// frame is undefined, so undefined is kept as an empty handle instead of a
+// global one. Empty handles read back as empty Locals, which set() treats
+// as undefined.
+void retain(v8::Isolate* isolate,
+            v8::Global<v8::Value>* slot,
+            v8::Local<v8::Value> frame);
+
 }  // namespace async_context_frame
 }  // namespace node
 
@@ -34,12 +34,40 @@ inline AsyncWrap::ProviderType AsyncWrap::provider_type() const {
   return provider_type_;
 }
 
+// A wrap that is reused for another provider, like the pooled HTTP
+// parsers, is counted as destroyed for the old provider and created for
+// the new one.
 inline AsyncWrap::ProviderType AsyncWrap::set_provider_type(
     AsyncWrap::ProviderType provider) {
+  if (provider == provider_type_) return provider_type_;
+  if (counted_) {
+    env()->async_wrap_counters()->Destroyed(provider_type_);
+    counted_ = false;
+  }
   provider_type_ = provider;
+  CountCreated();
   return provider_type_;
 }
 
+inline void AsyncWrap::CountCreated() {
+  AsyncWrapCounters* counters = env()->async_wrap_counters();
+  if (!counters->enabled() || provider_type_ == PROVIDER_NONE) return;
+  counters->Created(provider_type_);
+  counted_ = true;
+}
+
+inline void AsyncWrapCounters::Created(AsyncWrap::ProviderType provider) {
+  size_t base = static_cast<size_t>(provider) * kFieldCount;
+  (*counters_)[base + kCreated] += 1;
+  (*counters_)[base + kLive] += 1;
+}
+
+inline void AsyncWrapCounters::Destroyed(AsyncWrap::ProviderType provider) {
+  size_t base = static_cast<size_t>(provider) * kFieldCount;
+  (*counters_)[base + kDestroyed] += 1;
+  (*counters_)[base + kLive] -= 1;
+}
+
 inline double AsyncWrap::get_async_id() const {
   return async_id_;
 }
@@ -22,6 +22,7 @@
 #include "async_wrap.h"  // NOLINT(build/include_inline)
 #include "async_context_frame.h"
 #include "async_wrap-inl.h"
+#include "cppgc_async_wrap.h"
 #include "env-inl.h"
 #include "node_errors.h"
 #include "node_external_reference.h"
@@ -109,12 +110,17 @@ void AsyncWrap::EmitPromiseResolve(Environment* env, double async_id) {
 
 
 void AsyncWrap::EmitTraceEventBefore() {
-  switch (provider_type()) {
+  EmitTraceEventBefore(provider_type(), get_async_id());
+}
+
+
+void AsyncWrap::EmitTraceEventBefore(ProviderType type, double async_id) {
+  switch (type) {
 #define V(PROVIDER)                                                           \
     case PROVIDER_ ## PROVIDER:                                               \
       TRACE_EVENT_NESTABLE_ASYNC_BEGIN0(                                      \
         TRACING_CATEGORY_NODE1(async_hooks),                                  \
-        #PROVIDER "_CALLBACK", static_cast<int64_t>(get_async_id()));         \
+        #PROVIDER "_CALLBACK", static_cast<int64_t>(async_id));               \
       break;
     NODE_ASYNC_PROVIDER_TYPES(V)
 #undef V
@@ -306,6 +312,15 @@ void AsyncWrap::AsyncReset(const FunctionCallbackInfo<Value>& args) {
 }
 
 
+// getProviderCounters() enables the AsyncWrapCounters of the Environment
+// and returns their BigUint64Array.
+void AsyncWrap::GetProviderCounters(const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+  AsyncWrapCounters* counters = env->async_wrap_counters();
+  counters->Enable(env->isolate());
+  args.GetReturnValue().Set(counters->counters()->GetJSArray());
+}
+
 void AsyncWrap::GetProviderType(const FunctionCallbackInfo<Value>& args) {
   AsyncWrap* wrap;
   args.GetReturnValue().Set(AsyncWrap::PROVIDER_NONE);
@@ -373,6 +388,7 @@ void AsyncWrap::CreatePerIsolateProperties(IsolateData* isolate_data,
   SetMethod(isolate, target, "setPromiseHooks", SetPromiseHooks);
   SetMethod(isolate, target, "getPromiseHooks", GetPromiseHooks);
   SetMethod(isolate, target, "registerDestroyHook", RegisterDestroyHook);
+  SetMethod(isolate, target, "getProviderCounters", GetProviderCounters);
   AsyncWrap::GetConstructorTemplate(isolate_data);
 }
 
@@ -443,6 +459,15 @@ void AsyncWrap::CreatePerContextProperties(Local<Object> target,
   SET_HOOKS_CONSTANT(kUsesExecutionAsyncResource);
   SET_HOOKS_CONSTANT(kStackLength);
 #undef SET_HOOKS_CONSTANT
+#define SET_COUNTERS_CONSTANT(name, field)                                    \
+  FORCE_SET_TARGET_FIELD(                                                     \
+      constants, name, Integer::New(isolate, AsyncWrapCounters::field))
+
+  SET_COUNTERS_CONSTANT("kProviderCreated", kCreated);
+  SET_COUNTERS_CONSTANT("kProviderDestroyed", kDestroyed);
+  SET_COUNTERS_CONSTANT("kProviderLive", kLive);
+  SET_COUNTERS_CONSTANT("kProviderFieldCount", kFieldCount);
+#undef SET_COUNTERS_CONSTANT
   FORCE_SET_TARGET_FIELD(target, "constants", constants);
 
   Local<Object> async_providers = Object::New(isolate);
@@ -482,6 +507,8 @@ void AsyncWrap::RegisterExternalReferences(
   registry->Register(AsyncWrap::GetAsyncId);
   registry->Register(AsyncWrap::AsyncReset);
   registry->Register(AsyncWrap::GetProviderType);
+  registry->Register(AsyncWrap::GetProviderCounters);
+  CppgcAsyncWrap::RegisterExternalReferences(registry);
 }
 
 AsyncWrap::AsyncWrap(Environment* env,
@@ -491,6 +518,7 @@ AsyncWrap::AsyncWrap(Environment* env,
     : AsyncWrap(env, object) {
   CHECK_NE(provider, PROVIDER_NONE);
   provider_type_ = provider;
+  CountCreated();
 
   // Use AsyncReset() call to execute the init() callbacks.
   AsyncReset(object, execution_async_id);
@@ -498,9 +526,11 @@ AsyncWrap::AsyncWrap(Environment* env,
 }
 
 AsyncWrap::AsyncWrap(Environment* env, Local<Object> object)
-    : BaseObject(env, object),
-      context_frame_(env->isolate(),
-                     async_context_frame::current(env->isolate())) {}
+    : BaseObject(env, object) {
+  async_context_frame::retain(env->isolate(),
+                              &context_frame_,
+                              async_context_frame::current(env->isolate()));
+}
 
 // This method is necessary to work around one specific problem:
 // Before the init() hook runs, if there is one, the BaseObject() constructor
@@ -530,15 +560,26 @@ bool AsyncWrap::IsDoneInitializing() const {
 AsyncWrap::~AsyncWrap() {
   EmitTraceEventDestroy();
   EmitDestroy(true /* from gc */);
+  if (counted_) env()->async_wrap_counters()->Destroyed(provider_type_);
+}
+
+void AsyncWrapCounters::Enable(Isolate* isolate) {
+  if (enabled()) return;
+  counters_ = std::make_unique<AliasedBigUint64Array>(
+      isolate, size_t{AsyncWrap::PROVIDERS_LENGTH} * kFieldCount);
 }
 
 void AsyncWrap::EmitTraceEventDestroy() {
-  switch (provider_type()) {
+  EmitTraceEventDestroy(provider_type(), get_async_id());
+}
+
+void AsyncWrap::EmitTraceEventDestroy(ProviderType type, double async_id) {
+  switch (type) {
   #define V(PROVIDER)                                                         \
     case PROVIDER_ ## PROVIDER:                                               \
       TRACE_EVENT_NESTABLE_ASYNC_END0(                                        \
         TRACING_CATEGORY_NODE1(async_hooks),                                  \
-        #PROVIDER, static_cast<int64_t>(get_async_id()));                     \
+        #PROVIDER, static_cast<int64_t>(async_id));                           \
       break;
     NODE_ASYNC_PROVIDER_TYPES(V)
   #undef V
@@ -601,19 +642,33 @@ void AsyncWrap::AsyncReset(Local<Object> resource, double execution_async_id) {
     }
   }
 
-  switch (provider_type()) {
+  EmitTraceEventInit(env(), provider_type(), async_id_, trigger_async_id_);
+
+  async_context_frame::retain(
+      isolate, &context_frame_, async_context_frame::current(isolate));
+
+  EmitAsyncInit(env(), resource,
+                env()->async_hooks()->provider_string(provider_type()),
+                async_id_, trigger_async_id_);
+}
+
+void AsyncWrap::EmitTraceEventInit(Environment* env,
+                                   ProviderType type,
+                                   double async_id,
+                                   double trigger_async_id) {
+  switch (type) {
 #define V(PROVIDER)                                                           \
     case PROVIDER_ ## PROVIDER:                                               \
       if (*TRACE_EVENT_API_GET_CATEGORY_GROUP_ENABLED(                        \
           TRACING_CATEGORY_NODE1(async_hooks))) {                             \
         auto data = tracing::TracedValue::Create();                           \
         data->SetInteger("executionAsyncId",                                  \
-                         static_cast<int64_t>(env()->execution_async_id()));  \
+                         static_cast<int64_t>(env->execution_async_id()));    \
         data->SetInteger("triggerAsyncId",                                    \
-                         static_cast<int64_t>(get_trigger_async_id()));       \
+                         static_cast<int64_t>(trigger_async_id));             \
         TRACE_EVENT_NESTABLE_ASYNC_BEGIN1(                                    \
           TRACING_CATEGORY_NODE1(async_hooks),                                \
-          #PROVIDER, static_cast<int64_t>(get_async_id()),                    \
+          #PROVIDER, static_cast<int64_t>(async_id),                          \
           "data", std::move(data));                                           \
         }                                                                     \
       break;
@@ -622,12 +677,6 @@ void AsyncWrap::AsyncReset(Local<Object> resource, double execution_async_id) {
     default:
       UNREACHABLE();
   }
-
-  context_frame_.Reset(isolate, async_context_frame::current(isolate));
-
-  EmitAsyncInit(env(), resource,
-                env()->async_hooks()->provider_string(provider_type()),
-                async_id_, trigger_async_id_);
 }
 
 void AsyncWrap::EmitAsyncInit(Environment* env,
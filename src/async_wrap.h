@@ -24,6 +24,7 @@
 
 #if defined(NODE_WANT_INTERNALS) && NODE_WANT_INTERNALS
 
+#include "aliased_buffer.h"
 #include "base_object.h"
 #include "v8.h"
 
@@ -34,6 +35,7 @@ namespace node {
 #define NODE_ASYNC_NON_CRYPTO_PROVIDER_TYPES(V)                                \
   V(NONE)                                                                      \
   V(DIRHANDLE)                                                                 \
+  V(DIRWALKER)                                                                 \
   V(DNSCHANNEL)                                                                \
   V(ELDHISTOGRAM)                                                              \
   V(FILEHANDLE)                                                                \
@@ -66,6 +68,7 @@ namespace node {
   V(QUIC_SESSION)                                                              \
   V(QUIC_STREAM)                                                               \
   V(QUIC_UDP)                                                                  \
+  V(SHAREDRINGBUFFER)                                                          \
   V(SHUTDOWNWRAP)                                                              \
   V(SIGNALWRAP)                                                                \
   V(STATWATCHER)                                                               \
@@ -158,6 +161,8 @@ class AsyncWrap : public BaseObject {
       const v8::FunctionCallbackInfo<v8::Value>& args);
   static void AsyncReset(const v8::FunctionCallbackInfo<v8::Value>& args);
   static void GetProviderType(const v8::FunctionCallbackInfo<v8::Value>& args);
+  static void GetProviderCounters(
+      const v8::FunctionCallbackInfo<v8::Value>& args);
   static void QueueDestroyAsyncId(
     const v8::FunctionCallbackInfo<v8::Value>& args);
   static void SetCallbackTrampoline(
@@ -177,8 +182,16 @@ class AsyncWrap : public BaseObject {
   void EmitDestroy(bool from_gc = false);
 
   void EmitTraceEventBefore();
-  static void EmitTraceEventAfter(ProviderType type, double async_id);
   void EmitTraceEventDestroy();
+  // These take the values that they need, for wraps that are not AsyncWraps
+  // and for callers that may outlive the AsyncWrap.
+  static void EmitTraceEventInit(Environment* env,
+                                 ProviderType type,
+                                 double async_id,
+                                 double trigger_async_id);
+  static void EmitTraceEventBefore(ProviderType type, double async_id);
+  static void EmitTraceEventAfter(ProviderType type, double async_id);
+  static void EmitTraceEventDestroy(ProviderType type, double async_id);
 
   static void DestroyAsyncIdsCallback(Environment* env);
 
@@ -224,8 +237,13 @@ class AsyncWrap : public BaseObject {
   bool IsDoneInitializing() const override;
 
  private:
+  inline void CountCreated();
+
   ProviderType provider_type_ = PROVIDER_NONE;
   bool init_hook_ran_ = false;
+  // Whether the creation of this wrap was counted by the Environment's
+  // AsyncWrapCounters, i.e. whether its destruction has to be counted.
+  bool counted_ = false;
   // Because the values may be Reset(), cannot be made const.
   double async_id_ = kInvalidAsyncId;
   double trigger_async_id_ = kInvalidAsyncId;
@@ -233,6 +251,33 @@ class AsyncWrap : public BaseObject {
   v8::Global<v8::Value> context_frame_;
 };
 
+// Counts the AsyncWraps of an Environment by provider type once enabled,
+// so that the churn of short-lived wraps like WriteWrap or FSReqCallback
+// can be scraped as metrics. The counters are laid out as
+// [provider * kFieldCount + field]. Wraps that were created before the
+// counters were enabled are not counted. Only used on the Environment's
+// thread.
+class AsyncWrapCounters {
+ public:
+  enum Field { kCreated, kDestroyed, kLive, kFieldCount };
+
+  AsyncWrapCounters() = default;
+  AsyncWrapCounters(const AsyncWrapCounters&) = delete;
+  AsyncWrapCounters& operator=(const AsyncWrapCounters&) = delete;
+
+  // Does nothing if already enabled.
+  void Enable(v8::Isolate* isolate);
+  bool enabled() const { return counters_ != nullptr; }
+  // The BigUint64Array with the counters, or nullptr if not enabled.
+  AliasedBigUint64Array* counters() { return counters_.get(); }
+
+  inline void Created(AsyncWrap::ProviderType provider);
+  inline void Destroyed(AsyncWrap::ProviderType provider);
+
+ private:
+  std::unique_ptr<AliasedBigUint64Array> counters_;
+};
+
 }  // namespace node
 
 #endif  // defined(NODE_WANT_INTERNALS) && NODE_WANT_INTERNALS
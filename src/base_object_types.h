@@ -18,11 +18,12 @@ namespace node {
   V(process_binding_data, process::BindingData)                                \
   V(timers_binding_data, timers::BindingData)                                  \
   V(url_binding_data, url::BindingData)                                        \
-  V(modules_binding_data, modules::BindingData)
+  V(modules_binding_data, modules::BindingData)                                \
+  V(http_parser_binding_data, http_parser::BindingData)                        \
+  V(zlib_binding_data, ZlibBindingData)
 
 #define UNSERIALIZABLE_BINDING_TYPES(V)                                        \
   V(http2_binding_data, http2::BindingData)                                    \
-  V(http_parser_binding_data, http_parser::BindingData)                        \
   V(quic_binding_data, quic::BindingData)
 
 // List of (non-binding) BaseObjects that are serializable in the snapshot.
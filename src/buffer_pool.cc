@@ -0,0 +1,101 @@
+#include "buffer_pool.h"
+
+#include <cstdlib>
+
+#include "util-inl.h"
+
+namespace node {
+
+using v8::ArrayBuffer;
+using v8::BackingStore;
+
+BufferPool::~BufferPool() {
+  CHECK_EQ(outstanding_, 0);
+  for (void* slab : slabs_) free(slab);
+}
+
+size_t BufferPool::SizeClassIndex(size_t length) {
+  size_t index = 0;
+  size_t block_size = kMinBlockSize;
+  while (block_size < length) {
+    block_size <<= 1;
+    index++;
+  }
+  return index;
+}
+
+bool BufferPool::Grow(size_t index) {
+  SizeClass& size_class = classes_[index];
+  if (size_class.slab_count == kMaxSlabsPerClass) return false;
+  char* slab = static_cast<char*>(malloc(kSlabSize));
+  if (slab == nullptr) return false;
+  slabs_.push_back(slab);
+  size_class.slab_count++;
+
+  const size_t block_size = kMinBlockSize << index;
+  for (size_t offset = kSlabSize; offset >= block_size; offset -= block_size) {
+    FreeBlock* block = reinterpret_cast<FreeBlock*>(slab + offset - block_size);
+    block->next = size_class.free_list;
+    size_class.free_list = block;
+  }
+  return true;
+}
+
+void* BufferPool::Allocate(size_t length) {
+  if (!IsPooledLength(length)) return nullptr;
+  const size_t index = SizeClassIndex(length);
+  Mutex::ScopedLock lock(mutex_);
+  CHECK(!detached_);
+  SizeClass& size_class = classes_[index];
+  if (size_class.free_list == nullptr && !Grow(index)) return nullptr;
+  FreeBlock* block = size_class.free_list;
+  size_class.free_list = block->next;
+  outstanding_++;
+  return block;
+}
+
+void BufferPool::Release(void* data, size_t length, void* deleter_data) {
+  BufferPool* pool = static_cast<BufferPool*>(deleter_data);
+  CHECK(IsPooledLength(length));
+  bool delete_pool;
+  {
+    Mutex::ScopedLock lock(pool->mutex_);
+    SizeClass& size_class = pool->classes_[SizeClassIndex(length)];
+    FreeBlock* block = static_cast<FreeBlock*>(data);
+    block->next = size_class.free_list;
+    size_class.free_list = block;
+    CHECK_GT(pool->outstanding_, 0);
+    pool->outstanding_--;
+    delete_pool = pool->detached_ && pool->outstanding_ == 0;
+  }
+  if (delete_pool) delete pool;
+}
+
+std::unique_ptr<BackingStore> BufferPool::NewBackingStore(size_t length) {
+#if defined(V8_ENABLE_SANDBOX)
+  // Backing stores have to be allocated inside of the sandbox.
+  return nullptr;
+#else
+  void* data = Allocate(length);
+  if (data == nullptr) return nullptr;
+  return ArrayBuffer::NewBackingStore(data, length, Release, this);
+#endif
+}
+
+void BufferPool::Detach() {
+  bool delete_pool;
+  {
+    Mutex::ScopedLock lock(mutex_);
+    CHECK(!detached_);
+    detached_ = true;
+    delete_pool = outstanding_ == 0;
+  }
+  if (delete_pool) delete this;
+}
+
+size_t BufferPool::outstanding_blocks() const {
+  Mutex::ScopedLock lock(mutex_);
+  return outstanding_;
+}
+
+}  // namespace node
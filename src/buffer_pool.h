@@ -0,0 +1,84 @@
+#ifndef SRC_BUFFER_POOL_H_
+#define SRC_BUFFER_POOL_H_
+
+#if defined(NODE_WANT_INTERNALS) && NODE_WANT_INTERNALS
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "node_mutex.h"
+#include "v8.h"
+
+namespace node {
+
+// A size-classed slab allocator for the small Buffers that are created from
+// C++, i.e. Buffer::New(env, length) and Buffer::Copy(env, ...). Blocks are
+// handed to V8 as external backing stores whose deleter puts them back on
+// the free list of their size class, so that e.g. socket reads reuse memory
+// instead of going through malloc() and free() for every chunk.
+//
+// Backing store deleters can run on any thread and after the Environment has
+// been torn down, so all state is guarded by a mutex and the pool deletes
+// itself once it has been detached and every block has been returned.
+class BufferPool {
+ public:
+  static constexpr size_t kMinBlockSize = 64;
+  static constexpr size_t kMaxBlockSize = 8192;
+  // 64, 128, 256, ..., 8192 bytes.
+  static constexpr size_t kSizeClassCount = 8;
+  static constexpr size_t kSlabSize = 64 * 1024;
+  // Bounds the memory that each size class may hold on to.
+  static constexpr size_t kMaxSlabsPerClass = 8;
+
+  BufferPool() = default;
+  BufferPool(const BufferPool&) = delete;
+  BufferPool& operator=(const BufferPool&) = delete;
+
+  static constexpr bool IsPooledLength(size_t length) {
+    return length > 0 && length <= kMaxBlockSize;
+  }
+
+  // Returns a block of at least `length` bytes, or nullptr if `length` is not
+  // pooled or its size class has reached kMaxSlabsPerClass.
+  void* Allocate(size_t length);
+  // Returns a block obtained from Allocate(length) to the pool. Usable as a
+  // v8::BackingStore deleter with the pool as `deleter_data`.
+  static void Release(void* data, size_t length, void* deleter_data);
+
+  // Returns an uninitialized backing store of exactly `length` bytes that is
+  // backed by the pool, or nullptr if the caller has to allocate it itself.
+  std::unique_ptr<v8::BackingStore> NewBackingStore(size_t length);
+
+  // Called by the owning Environment instead of deleting the pool.
+  void Detach();
+
+  size_t outstanding_blocks() const;
+
+ private:
+  struct FreeBlock {
+    FreeBlock* next;
+  };
+
+  struct SizeClass {
+    FreeBlock* free_list = nullptr;
+    size_t slab_count = 0;
+  };
+
+  ~BufferPool();
+
+  static size_t SizeClassIndex(size_t length);
+  bool Grow(size_t index);
+
+  Mutex mutex_;
+  SizeClass classes_[kSizeClassCount];
+  std::vector<void*> slabs_;
+  size_t outstanding_ = 0;
+  bool detached_ = false;
+};
+
+}  // namespace node
+
+#endif  // defined(NODE_WANT_INTERNALS) && NODE_WANT_INTERNALS
+
+#endif  // SRC_BUFFER_POOL_H_
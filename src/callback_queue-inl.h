@@ -5,19 +5,32 @@
 
 #include "callback_queue.h"
 
+#include <new>
+
 namespace node {
 
 template <typename R, typename... Args>
 template <typename Fn>
-std::unique_ptr<typename CallbackQueue<R, Args...>::Callback>
+typename CallbackQueue<R, Args...>::CallbackPointer
 CallbackQueue<R, Args...>::CreateCallback(Fn&& fn, CallbackFlags::Flags flags) {
-  return std::make_unique<CallbackImpl<Fn>>(std::move(fn), flags);
+  using Impl = CallbackImpl<Fn>;
+  if constexpr (sizeof(Impl) <= Slab::kSlotSize &&
+                alignof(Impl) <= alignof(std::max_align_t)) {
+    if (slab_) {
+      void* slot = slab_->Allocate();
+      Impl* callback = new (slot) Impl(std::move(fn), flags);
+      callback->slab_ = slab_.get();
+      callback->slot_ = slot;
+      return CallbackPointer(callback);
+    }
+  }
+  return CallbackPointer(new Impl(std::move(fn), flags));
 }
 
 template <typename R, typename... Args>
-std::unique_ptr<typename CallbackQueue<R, Args...>::Callback>
+typename CallbackQueue<R, Args...>::CallbackPointer
 CallbackQueue<R, Args...>::Shift() {
-  std::unique_ptr<Callback> ret = std::move(head_);
+  CallbackPointer ret = std::move(head_);
   if (ret) {
     head_ = ret->get_next();
     if (!head_)
@@ -28,7 +41,7 @@ CallbackQueue<R, Args...>::Shift() {
 }
 
 template <typename R, typename... Args>
-void CallbackQueue<R, Args...>::Push(std::unique_ptr<Callback> cb) {
+void CallbackQueue<R, Args...>::Push(CallbackPointer cb) {
   Callback* prev_tail = tail_;
 
   size_++;
@@ -66,17 +79,50 @@ CallbackFlags::Flags CallbackQueue<R, Args...>::Callback::flags() const {
 }
 
 template <typename R, typename... Args>
-std::unique_ptr<typename CallbackQueue<R, Args...>::Callback>
+typename CallbackQueue<R, Args...>::CallbackPointer
 CallbackQueue<R, Args...>::Callback::get_next() {
   return std::move(next_);
 }
 
 template <typename R, typename... Args>
-void CallbackQueue<R, Args...>::Callback::set_next(
-    std::unique_ptr<Callback> next) {
+void CallbackQueue<R, Args...>::Callback::set_next(CallbackPointer next) {
   next_ = std::move(next);
 }
 
+template <typename R, typename... Args>
+void CallbackQueue<R, Args...>::Deleter::operator()(Callback* callback) const {
+  Slab* slab = callback->slab_;
+  if (slab == nullptr) {
+    delete callback;
+    return;
+  }
+  void* slot = callback->slot_;
+  callback->~Callback();
+  slab->Free(slot);
+}
+
+template <typename R, typename... Args>
+void* CallbackQueue<R, Args...>::Slab::Allocate() {
+  if (free_ == nullptr) {
+    std::unique_ptr<Slot[]> chunk(new Slot[kSlotsPerChunk]);
+    for (size_t i = 0; i < kSlotsPerChunk; i++) {
+      chunk[i].next = free_;
+      free_ = &chunk[i];
+    }
+    chunks_.push_back(std::move(chunk));
+  }
+  Slot* slot = free_;
+  free_ = slot->next;
+  return slot->data;
+}
+
+template <typename R, typename... Args>
+void CallbackQueue<R, Args...>::Slab::Free(void* slot) {
+  Slot* free_slot = reinterpret_cast<Slot*>(slot);
+  free_slot->next = free_;
+  free_ = free_slot;
+}
+
 template <typename R, typename... Args>
 template <typename Fn>
 CallbackQueue<R, Args...>::CallbackImpl<Fn>::CallbackImpl(
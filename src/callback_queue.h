@@ -4,7 +4,9 @@
 #if defined(NODE_WANT_INTERNALS) && NODE_WANT_INTERNALS
 
 #include <atomic>
+#include <cstddef>
 #include <memory>
+#include <vector>
 
 namespace node {
 
@@ -21,9 +23,27 @@ enum Flags {
 // `Shift()`.
 // The `refed` flag is left for easier use in situations in which some of these
 // should be run even if nothing else is keeping the event loop alive.
+// A queue that is only used on one thread can allocate small callbacks from a
+// slab of fixed-size slots that are reused once the callbacks have been
+// destroyed, so that queueing them does not call malloc.
 template <typename R, typename... Args>
 class CallbackQueue {
  public:
+  enum Allocation {
+    kHeapAllocated,
+    kSlabAllocated,
+  };
+
+  class Callback;
+  class Slab;
+
+  // Destroys a callback and returns its slot to the slab it came from, if
+  // any.
+  struct Deleter {
+    inline void operator()(Callback* callback) const;
+  };
+  using CallbackPointer = std::unique_ptr<Callback, Deleter>;
+
   class Callback {
    public:
     explicit inline Callback(CallbackFlags::Flags flags);
@@ -34,21 +54,53 @@ class CallbackQueue {
     inline CallbackFlags::Flags flags() const;
 
    private:
-    inline std::unique_ptr<Callback> get_next();
-    inline void set_next(std::unique_ptr<Callback> next);
+    inline CallbackPointer get_next();
+    inline void set_next(CallbackPointer next);
 
     CallbackFlags::Flags flags_;
-    std::unique_ptr<Callback> next_;
+    CallbackPointer next_;
+    Slab* slab_ = nullptr;
+    void* slot_ = nullptr;
 
     friend class CallbackQueue;
   };
 
+  // Fixed-size slots for callbacks, allocated in chunks that are kept until
+  // the slab is destroyed. Not thread-safe.
+  class Slab {
+   public:
+    static constexpr size_t kSlotSize = 128;
+
+    Slab() = default;
+    Slab(const Slab&) = delete;
+    Slab& operator=(const Slab&) = delete;
+
+    inline void* Allocate();
+    inline void Free(void* slot);
+
+   private:
+    static constexpr size_t kSlotsPerChunk = 64;
+
+    union Slot {
+      Slot* next;
+      alignas(std::max_align_t) char data[kSlotSize];
+    };
+
+    std::vector<std::unique_ptr<Slot[]>> chunks_;
+    Slot* free_ = nullptr;
+  };
+
+  // The slab of a kSlabAllocated queue must outlive the callbacks it creates,
+  // so they should not be moved to other queues that outlive it.
+  explicit CallbackQueue(Allocation allocation = kHeapAllocated) {
+    if (allocation == kSlabAllocated) slab_ = std::make_unique<Slab>();
+  }
+
   template <typename Fn>
-  inline std::unique_ptr<Callback> CreateCallback(
-      Fn&& fn, CallbackFlags::Flags);
+  inline CallbackPointer CreateCallback(Fn&& fn, CallbackFlags::Flags);
 
-  inline std::unique_ptr<Callback> Shift();
-  inline void Push(std::unique_ptr<Callback> cb);
+  inline CallbackPointer Shift();
+  inline void Push(CallbackPointer cb);
   // ConcatMove adds elements from 'other' to the end of this list, and clears
   // 'other' afterwards.
   inline void ConcatMove(CallbackQueue&& other);
@@ -68,7 +120,10 @@ class CallbackQueue {
   };
 
   std::atomic<size_t> size_ {0};
-  std::unique_ptr<Callback> head_;
+  // Declared before head_, so that it is destroyed after the queued
+  // callbacks.
+  std::unique_ptr<Slab> slab_;
+  CallbackPointer head_;
   Callback* tail_ = nullptr;
 };
 
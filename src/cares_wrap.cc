@@ -34,7 +34,9 @@
 #include "uv.h"
 #include "v8.h"
 
+#include <algorithm>
 #include <cerrno>
+#include <climits>
 #include <cstring>
 #include <memory>
 #include <vector>
@@ -78,6 +80,7 @@ using v8::LocalVector;
 using v8::Maybe;
 using v8::MaybeLocal;
 using v8::Nothing;
+using v8::Number;
 using v8::Null;
 using v8::Object;
 using v8::String;
@@ -791,10 +794,16 @@ ChannelWrap::ChannelWrap(
       Environment* env,
       Local<Object> object,
       int timeout,
-      int tries)
+      int tries,
+      unsigned int max_cache_ttl,
+      int server_retry_chance,
+      uint32_t server_retry_delay)
     : AsyncWrap(env, object, PROVIDER_DNSCHANNEL),
       timeout_(timeout),
-      tries_(tries) {
+      tries_(tries),
+      max_cache_ttl_(max_cache_ttl),
+      server_retry_chance_(server_retry_chance),
+      server_retry_delay_(server_retry_delay) {
   MakeWeak();
 
   Setup();
@@ -808,25 +817,52 @@ void ChannelWrap::MemoryInfo(MemoryTracker* tracker) const {
 
 void ChannelWrap::New(const FunctionCallbackInfo<Value>& args) {
   CHECK(args.IsConstructCall());
-  CHECK_EQ(args.Length(), 2);
+  CHECK_GE(args.Length(), 2);
   CHECK(args[0]->IsInt32());
   CHECK(args[1]->IsInt32());
   const int timeout = args[0].As<Int32>()->Value();
   const int tries = args[1].As<Int32>()->Value();
+  // The optional maxCacheTtl (seconds) enables the c-ares query cache, which
+  // keeps answers for the smaller of their TTL and this value and caches
+  // NXDOMAIN/NODATA answers for the SOA minimum TTL.
+  unsigned int max_cache_ttl = 0;
+  if (args.Length() > 2 && args[2]->IsUint32()) {
+    max_cache_ttl = args[2].As<Uint32>()->Value();
+  }
+  // The optional serverRetryChance and serverRetryDelay (milliseconds)
+  // control how soon c-ares sends queries to a server that failed again.
+  int server_retry_chance = -1;
+  uint32_t server_retry_delay = 0;
+  if (args.Length() > 4 && args[3]->IsUint32() && args[4]->IsUint32()) {
+    server_retry_chance = static_cast<int>(
+        std::min<uint32_t>(args[3].As<Uint32>()->Value(), USHRT_MAX));
+    server_retry_delay = args[4].As<Uint32>()->Value();
+  }
   Environment* env = Environment::GetCurrent(args);
-  new ChannelWrap(env, args.This(), timeout, tries);
+  new ChannelWrap(env,
+                  args.This(),
+                  timeout,
+                  tries,
+                  max_cache_ttl,
+                  server_retry_chance,
+                  server_retry_delay);
 }
 
 GetAddrInfoReqWrap::GetAddrInfoReqWrap(Environment* env,
                                        Local<Object> req_wrap_obj,
-                                       uint8_t order)
+                                       uint8_t order,
+                                       std::string hostname,
+                                       const struct addrinfo& hints)
     : ReqWrap(env, req_wrap_obj, AsyncWrap::PROVIDER_GETADDRINFOREQWRAP),
-      order_(order) {}
+      order_(order),
+      hostname_(std::move(hostname)),
+      hints_(hints) {}
 
-GetNameInfoReqWrap::GetNameInfoReqWrap(
-    Environment* env,
-    Local<Object> req_wrap_obj)
-    : ReqWrap(env, req_wrap_obj, AsyncWrap::PROVIDER_GETNAMEINFOREQWRAP) {}
+GetNameInfoReqWrap::GetNameInfoReqWrap(Environment* env,
+                                       Local<Object> req_wrap_obj,
+                                       const struct sockaddr_storage& addr)
+    : ReqWrap(env, req_wrap_obj, AsyncWrap::PROVIDER_GETNAMEINFOREQWRAP),
+      addr_(addr) {}
 
 /* This is called once per second by loop->timer. It is used to constantly */
 /* call back into c-ares for possibly processing timeouts. */
@@ -866,7 +902,15 @@ void ChannelWrap::Setup() {
   options.sock_state_cb_data = this;
   options.timeout = timeout_;
   options.tries = tries_;
-  options.qcache_max_ttl = 0;
+  options.qcache_max_ttl = max_cache_ttl_;
+  int optmask = ARES_OPT_FLAGS | ARES_OPT_TIMEOUTMS | ARES_OPT_SOCK_STATE_CB |
+                ARES_OPT_TRIES | ARES_OPT_QUERY_CACHE;
+  if (server_retry_chance_ >= 0) {
+    options.server_failover_opts.retry_chance =
+        static_cast<unsigned short>(server_retry_chance_);  // NOLINT
+    options.server_failover_opts.retry_delay = server_retry_delay_;
+    optmask |= ARES_OPT_SERVER_FAILOVER;
+  }
 
   int r;
   if (!library_inited_) {
@@ -879,9 +923,6 @@ void ChannelWrap::Setup() {
   }
 
   /* We do the call to ares_init_option for caller. */
-  const int optmask = ARES_OPT_FLAGS | ARES_OPT_TIMEOUTMS |
-                      ARES_OPT_SOCK_STATE_CB | ARES_OPT_TRIES |
-                      ARES_OPT_QUERY_CACHE;
   r = ares_init_options(&channel_, &options, optmask);
 
   if (r != ARES_SUCCESS) {
@@ -891,6 +932,23 @@ void ChannelWrap::Setup() {
   }
 
   library_inited_ = true;
+  ares_set_server_state_callback(channel_, OnServerState, this);
+}
+
+void ChannelWrap::OnServerState(const char* server,
+                                ares_bool_t success,
+                                int flags,
+                                void* data) {
+  ChannelWrap* channel = static_cast<ChannelWrap*>(data);
+  ServerStats& stats = channel->server_stats_[server];
+  if (success) {
+    stats[IDX_DNS_SERVER_STATS_SUCCESSES]++;
+    stats[IDX_DNS_SERVER_STATS_CONSECUTIVE_FAILURES] = 0;
+  } else {
+    stats[IDX_DNS_SERVER_STATS_FAILURES]++;
+    stats[IDX_DNS_SERVER_STATS_CONSECUTIVE_FAILURES]++;
+  }
+  if (flags & ARES_SERV_STATE_TCP) stats[IDX_DNS_SERVER_STATS_TCP_QUERIES]++;
 }
 
 void ChannelWrap::StartTimer() {
@@ -1681,7 +1739,7 @@ static void Query(const FunctionCallbackInfo<Value>& args) {
 
   Local<Object> req_wrap_obj = args[0].As<Object>();
   Local<String> string = args[1].As<String>();
-  auto wrap = std::make_unique<Wrap>(channel, req_wrap_obj);
+  Wrap* wrap = Wrap::New(channel, req_wrap_obj);
 
   node::Utf8Value utf8name(env->isolate(), string);
   auto plain_name = utf8name.ToStringView();
@@ -1690,21 +1748,44 @@ static void Query(const FunctionCallbackInfo<Value>& args) {
   int err = wrap->Send(name.c_str());
   if (err) {
     channel->ModifyActivityQueryCount(-1);
-  } else {
-    // Release ownership of the pointer allowing the ownership to be transferred
-    USE(wrap.release());
+    wrap->Done();
   }
 
   args.GetReturnValue().Set(err);
 }
 
 
-void AfterGetAddrInfo(uv_getaddrinfo_t* req, int status, struct addrinfo* res) {
-  auto cleanup = OnScopeLeave([&]() { uv_freeaddrinfo(res); });
-  BaseObjectPtr<GetAddrInfoReqWrap> req_wrap{
-      static_cast<GetAddrInfoReqWrap*>(req->data)};
-  Environment* env = req_wrap->env();
+void CollectAddresses(const struct addrinfo* res,
+                      std::vector<LookupCache::Address>* addresses) {
+  for (auto p = res; p != nullptr; p = p->ai_next) {
+    CHECK_EQ(p->ai_socktype, SOCK_STREAM);
+
+    const char* addr;
+    if (p->ai_family == AF_INET) {
+      addr = reinterpret_cast<char*>(
+          &(reinterpret_cast<struct sockaddr_in*>(p->ai_addr)->sin_addr));
+    } else if (p->ai_family == AF_INET6) {
+      addr = reinterpret_cast<char*>(
+          &(reinterpret_cast<struct sockaddr_in6*>(p->ai_addr)->sin6_addr));
+    } else {
+      continue;
+    }
+
+    char ip[INET6_ADDRSTRLEN];
+    if (uv_inet_ntop(p->ai_family, addr, ip, sizeof(ip)))
+      continue;
 
+    addresses->push_back({p->ai_family, ip});
+  }
+}
+
+// Hands the result of a lookup, whether it came from the threadpool, from
+// a LookupCache or from c-ares, to the JS oncomplete callback.
+void EmitLookupResult(AsyncWrap* req_wrap,
+                      uint8_t order,
+                      int status,
+                      const std::vector<LookupCache::Address>& addresses) {
+  Environment* env = req_wrap->env();
   HandleScope handle_scope(env->isolate());
   Context::Scope context_scope(env->context());
 
@@ -1714,31 +1795,20 @@ void AfterGetAddrInfo(uv_getaddrinfo_t* req, int status, struct addrinfo* res) {
   };
 
   uint32_t n = 0;
-  const uint8_t order = req_wrap->order();
 
   if (status == 0) {
     Local<Array> results = Array::New(env->isolate());
 
     auto add = [&](bool want_ipv4, bool want_ipv6) -> Maybe<void> {
-      for (auto p = res; p != nullptr; p = p->ai_next) {
-        CHECK_EQ(p->ai_socktype, SOCK_STREAM);
-
-        const char* addr;
-        if (want_ipv4 && p->ai_family == AF_INET) {
-          addr = reinterpret_cast<char*>(
-              &(reinterpret_cast<struct sockaddr_in*>(p->ai_addr)->sin_addr));
-        } else if (want_ipv6 && p->ai_family == AF_INET6) {
-          addr = reinterpret_cast<char*>(
-              &(reinterpret_cast<struct sockaddr_in6*>(p->ai_addr)->sin6_addr));
-        } else {
+      for (const LookupCache::Address& address : addresses) {
+        if (!(want_ipv4 && address.family == AF_INET) &&
+            !(want_ipv6 && address.family == AF_INET6)) {
           continue;
         }
 
-        char ip[INET6_ADDRSTRLEN];
-        if (uv_inet_ntop(p->ai_family, addr, ip, sizeof(ip)))
-          continue;
-
-        Local<String> s = OneByteString(env->isolate(), ip);
+        Local<String> s = OneByteString(env->isolate(),
+                                        address.address.data(),
+                                        address.address.size());
         if (results->Set(env->context(), n, s).IsNothing())
           return Nothing<void>();
         n++;
@@ -1773,7 +1843,7 @@ void AfterGetAddrInfo(uv_getaddrinfo_t* req, int status, struct addrinfo* res) {
 
   TRACE_EVENT_NESTABLE_ASYNC_END2(TRACING_CATEGORY_NODE2(dns, native),
                                   "lookup",
-                                  req_wrap.get(),
+                                  req_wrap,
                                   "count",
                                   n,
                                   "order",
@@ -1783,6 +1853,31 @@ void AfterGetAddrInfo(uv_getaddrinfo_t* req, int status, struct addrinfo* res) {
   req_wrap->MakeCallback(env->oncomplete_string(), arraysize(argv), argv);
 }
 
+void AfterGetAddrInfo(uv_getaddrinfo_t* req, int status, struct addrinfo* res) {
+  auto cleanup = OnScopeLeave([&]() { uv_freeaddrinfo(res); });
+  BaseObjectPtr<GetAddrInfoReqWrap> req_wrap{
+      static_cast<GetAddrInfoReqWrap*>(req->data)};
+  Environment* env = req_wrap->env();
+  env->threadpool_work_limiter()->Finish(ThreadPoolWorkClass::kDns,
+                                         req_wrap.get());
+
+  // Detach the waiters before calling into JS, so that a lookup started
+  // from a callback does not join a request that has already completed.
+  std::vector<BaseObjectPtr<GetAddrInfoReqWrap>> waiters;
+  if (LookupCache* cache = req_wrap->cache()) {
+    cache->Store(req_wrap->cache_key(), status, res);
+    waiters = cache->TakeWaiters(req_wrap->cache_key());
+  }
+
+  std::vector<LookupCache::Address> addresses;
+  if (status == 0) CollectAddresses(res, &addresses);
+  EmitLookupResult(req_wrap.get(), req_wrap->order(), status, addresses);
+  for (const BaseObjectPtr<GetAddrInfoReqWrap>& waiter : waiters) {
+    EmitLookupResult(waiter.get(), waiter->order(), status, addresses);
+    waiter->Detach();
+  }
+}
+
 
 void AfterGetNameInfo(uv_getnameinfo_t* req,
                       int status,
@@ -1791,6 +1886,8 @@ void AfterGetNameInfo(uv_getnameinfo_t* req,
   BaseObjectPtr<GetNameInfoReqWrap> req_wrap{
       static_cast<GetNameInfoReqWrap*>(req->data)};
   Environment* env = req_wrap->env();
+  env->threadpool_work_limiter()->Finish(ThreadPoolWorkClass::kDns,
+                                         req_wrap.get());
 
   HandleScope handle_scope(env->isolate());
   Context::Scope context_scope(env->context());
@@ -1890,27 +1987,68 @@ void GetAddrInfo(const FunctionCallbackInfo<Value>& args) {
 
   Local<Uint32> order = args[4].As<Uint32>();
 
-  auto req_wrap =
-      std::make_unique<GetAddrInfoReqWrap>(env, req_wrap_obj, order->Value());
-
   struct addrinfo hints;
   memset(&hints, 0, sizeof(hints));
   hints.ai_family = family;
   hints.ai_socktype = SOCK_STREAM;
   hints.ai_flags = flags;
 
+  LookupCache* cache = nullptr;
+  if (args[5]->IsObject()) {
+    ASSIGN_OR_RETURN_UNWRAP(&cache, args[5].As<Object>());
+  }
+
+  std::string cache_key;
+  const LookupCache::Entry* cached = nullptr;
+  if (cache != nullptr) {
+    cache_key = LookupCache::MakeKey(ascii_hostname, hints);
+    cached = cache->Lookup(cache_key, ascii_hostname, hints);
+  }
+
+  auto req_wrap = std::make_unique<GetAddrInfoReqWrap>(
+      env, req_wrap_obj, order->Value(), std::move(ascii_hostname), hints);
+
   TRACE_EVENT_NESTABLE_ASYNC_BEGIN2(TRACING_CATEGORY_NODE2(dns, native),
                                     "lookup",
                                     req_wrap.get(),
                                     "hostname",
-                                    TRACE_STR_COPY(ascii_hostname.data()),
+                                    TRACE_STR_COPY(req_wrap->hostname()),
                                     "family",
                                     family == AF_INET    ? "ipv4"
                                     : family == AF_INET6 ? "ipv6"
                                                          : "unspec");
 
-  int err = req_wrap->Dispatch(
-      uv_getaddrinfo, AfterGetAddrInfo, ascii_hostname.data(), nullptr, &hints);
+  if (cached != nullptr) {
+    // The callback must still be asynchronous. Copy the entry, since it may
+    // be replaced or evicted before the immediate runs.
+    BaseObjectPtr<GetAddrInfoReqWrap> strong_ref{req_wrap.release()};
+    env->SetImmediate([strong_ref, status = cached->status,
+                       addresses = cached->addresses](Environment*) {
+      EmitLookupResult(
+          strong_ref.get(), strong_ref->order(), status, addresses);
+      strong_ref->Detach();
+    });
+    args.GetReturnValue().Set(0);
+    return;
+  }
+
+  if (cache != nullptr) {
+    if (cache->AddWaiter(cache_key, req_wrap.get())) {
+      USE(req_wrap.release());
+      args.GetReturnValue().Set(0);
+      return;
+    }
+    req_wrap->set_cache(cache, std::move(cache_key));
+  }
+
+  // Keep the request object alive while the request is queued.
+  req_wrap->ClearWeak();
+  int err = env->threadpool_work_limiter()->Schedule(ThreadPoolWorkClass::kDns,
+                                                     req_wrap.get());
+  if (err != 0 && cache != nullptr) {
+    // Nothing can have joined yet, since we have not returned to JS.
+    CHECK(cache->TakeWaiters(req_wrap->cache_key()).empty());
+  }
   if (err == 0)
     // Release ownership of the pointer allowing the ownership to be transferred
     USE(req_wrap.release());
@@ -1933,7 +2071,8 @@ void GetNameInfo(const FunctionCallbackInfo<Value>& args) {
   CHECK(uv_ip4_addr(*ip, port, reinterpret_cast<sockaddr_in*>(&addr)) == 0 ||
         uv_ip6_addr(*ip, port, reinterpret_cast<sockaddr_in6*>(&addr)) == 0);
 
-  auto req_wrap = std::make_unique<GetNameInfoReqWrap>(env, req_wrap_obj);
+  auto req_wrap =
+      std::make_unique<GetNameInfoReqWrap>(env, req_wrap_obj, addr);
 
   TRACE_EVENT_NESTABLE_ASYNC_BEGIN2(
       TRACING_CATEGORY_NODE2(dns, native), "lookupService", req_wrap.get(),
@@ -1945,10 +2084,10 @@ void GetNameInfo(const FunctionCallbackInfo<Value>& args) {
       [[unlikely]] {
     req_wrap->InsufficientPermissionError(*ip);
   } else {
-    err = req_wrap->Dispatch(uv_getnameinfo,
-                             AfterGetNameInfo,
-                             reinterpret_cast<struct sockaddr*>(&addr),
-                             NI_NAMEREQD);
+    // Keep the request object alive while the request is queued.
+    req_wrap->ClearWeak();
+    err = env->threadpool_work_limiter()->Schedule(ThreadPoolWorkClass::kDns,
+                                                   req_wrap.get());
   }
 
   if (err == 0)
@@ -2077,12 +2216,39 @@ void SetServers(const FunctionCallbackInfo<Value>& args) {
   else
     err = ARES_EBADSTR;
 
-  if (err == ARES_SUCCESS)
+  if (err == ARES_SUCCESS) {
     channel->set_is_servers_default(false);
+    channel->clear_server_stats();
+  }
 
   args.GetReturnValue().Set(err);
 }
 
+// getServerStats(): returns [server, stats] pairs, where stats is an array
+// indexed by IDX_DNS_SERVER_STATS_*.
+void GetServerStats(const FunctionCallbackInfo<Value>& args) {
+  ChannelWrap* channel;
+  ASSIGN_OR_RETURN_UNWRAP(&channel, args.This());
+  Isolate* isolate = args.GetIsolate();
+
+  LocalVector<Value> servers(isolate);
+  servers.reserve(channel->server_stats().size());
+  for (const auto& [server, server_stats] : channel->server_stats()) {
+    LocalVector<Value> stats(isolate);
+    stats.reserve(IDX_DNS_SERVER_STATS_COUNT);
+    for (double stat : server_stats) {
+      stats.push_back(Number::New(isolate, stat));
+    }
+    Local<Value> entry[] = {
+        OneByteString(isolate, server.c_str()),
+        Array::New(isolate, stats.data(), stats.size()),
+    };
+    servers.push_back(Array::New(isolate, entry, arraysize(entry)));
+  }
+  args.GetReturnValue().Set(
+      Array::New(isolate, servers.data(), servers.size()));
+}
+
 void SetLocalAddress(const FunctionCallbackInfo<Value>& args) {
   Environment* env = Environment::GetCurrent(args);
   ChannelWrap* channel;
@@ -2170,6 +2336,465 @@ void StrError(const FunctionCallbackInfo<Value>& args) {
 
 }  // namespace
 
+int GetAddrInfoReqWrap::SubmitWork() {
+  return Dispatch(uv_getaddrinfo,
+                  AfterGetAddrInfo,
+                  hostname_.c_str(),
+                  nullptr,
+                  &hints_);
+}
+
+void GetAddrInfoReqWrap::OnSubmitError(int status) {
+  // The request was queued by the limiter and has failed to dispatch, so
+  // the error can no longer be returned from GetAddrInfo().
+  BaseObjectPtr<GetAddrInfoReqWrap> req_wrap{this};
+  Detach();
+  // Like AfterGetAddrInfo(), detach the waiters before calling into JS.
+  std::vector<BaseObjectPtr<GetAddrInfoReqWrap>> waiters;
+  if (cache_) waiters = cache_->TakeWaiters(cache_key_);
+  HandleScope handle_scope(env()->isolate());
+  Context::Scope context_scope(env()->context());
+  Local<Value> argv[] = {Integer::New(env()->isolate(), status),
+                         Null(env()->isolate())};
+  TRACE_EVENT_NESTABLE_ASYNC_END2(TRACING_CATEGORY_NODE2(dns, native),
+                                  "lookup",
+                                  this,
+                                  "count",
+                                  0,
+                                  "order",
+                                  order_);
+  MakeCallback(env()->oncomplete_string(), arraysize(argv), argv);
+
+  std::vector<LookupCache::Address> no_addresses;
+  for (const BaseObjectPtr<GetAddrInfoReqWrap>& waiter : waiters) {
+    EmitLookupResult(waiter.get(), waiter->order(), status, no_addresses);
+    waiter->Detach();
+  }
+}
+
+int GetNameInfoReqWrap::SubmitWork() {
+  return Dispatch(uv_getnameinfo,
+                  AfterGetNameInfo,
+                  reinterpret_cast<const struct sockaddr*>(&addr_),
+                  NI_NAMEREQD);
+}
+
+void GetNameInfoReqWrap::OnSubmitError(int status) {
+  // See GetAddrInfoReqWrap::OnSubmitError().
+  BaseObjectPtr<GetNameInfoReqWrap> req_wrap{this};
+  Detach();
+  HandleScope handle_scope(env()->isolate());
+  Context::Scope context_scope(env()->context());
+  Local<Value> argv[] = {Integer::New(env()->isolate(), status),
+                         Null(env()->isolate()),
+                         Null(env()->isolate())};
+  TRACE_EVENT_NESTABLE_ASYNC_END2(TRACING_CATEGORY_NODE2(dns, native),
+                                  "lookupService",
+                                  this,
+                                  "hostname",
+                                  "",
+                                  "service",
+                                  "");
+  MakeCallback(env()->oncomplete_string(), arraysize(argv), argv);
+}
+
+// Re-resolves a name in the background for LookupCache::Lookup(). This goes
+// through the same threadpool limiter as dns.lookup() but has no JS object,
+// so it only keeps the Environment alive for as long as it is in flight.
+class LookupCache::Refresh final : public ThreadPoolWorkLimiter::Work {
+ public:
+  Refresh(LookupCache* cache,
+          std::string key,
+          std::string hostname,
+          const struct addrinfo& hints)
+      : cache_(cache),
+        key_(std::move(key)),
+        hostname_(std::move(hostname)),
+        hints_(hints) {
+    req_.data = this;
+  }
+
+  int SubmitWork() override {
+    int err = uv_getaddrinfo(cache_->env()->event_loop(),
+                             &req_,
+                             AfterRefresh,
+                             hostname_.c_str(),
+                             nullptr,
+                             &hints_);
+    if (err == 0) cache_->env()->IncreaseWaitingRequestCounter();
+    return err;
+  }
+
+  void OnSubmitError(int status) override { Done(status, nullptr); }
+
+ private:
+  static void AfterRefresh(uv_getaddrinfo_t* req,
+                           int status,
+                           struct addrinfo* res) {
+    Refresh* refresh = static_cast<Refresh*>(req->data);
+    Environment* env = refresh->cache_->env();
+    env->DecreaseWaitingRequestCounter();
+    env->threadpool_work_limiter()->Finish(ThreadPoolWorkClass::kDns, refresh);
+    refresh->Done(status, res);
+    uv_freeaddrinfo(res);
+  }
+
+  void Done(int status, const struct addrinfo* res) {
+    std::unique_ptr<Refresh> self(this);
+    auto it = cache_->entries_.find(key_);
+    if (it != cache_->entries_.end()) it->second.refreshing = false;
+    // A failed refresh leaves the old answer in place until it expires.
+    if (status == 0) cache_->Store(key_, status, res);
+  }
+
+  BaseObjectPtr<LookupCache> cache_;
+  const std::string key_;
+  const std::string hostname_;
+  const struct addrinfo hints_;
+  uv_getaddrinfo_t req_;
+};
+
+LookupCache::LookupCache(Environment* env,
+                         Local<Object> object,
+                         uint64_t ttl,
+                         uint64_t negative_ttl,
+                         size_t max_entries)
+    : BaseObject(env, object),
+      ttl_(ttl),
+      negative_ttl_(negative_ttl),
+      max_entries_(max_entries) {
+  MakeWeak();
+}
+
+LookupCache::~LookupCache() = default;
+
+// new LookupCache(ttl, negativeTtl, maxEntries)
+void LookupCache::New(const FunctionCallbackInfo<Value>& args) {
+  CHECK(args.IsConstructCall());
+  CHECK(args[0]->IsUint32());
+  CHECK(args[1]->IsUint32());
+  CHECK(args[2]->IsUint32());
+  Environment* env = Environment::GetCurrent(args);
+  new LookupCache(env,
+                  args.This(),
+                  args[0].As<Uint32>()->Value(),
+                  args[1].As<Uint32>()->Value(),
+                  args[2].As<Uint32>()->Value());
+}
+
+// getStats(): returns an array indexed by IDX_LOOKUP_CACHE_STATS_*.
+void LookupCache::GetStats(const FunctionCallbackInfo<Value>& args) {
+  LookupCache* cache;
+  ASSIGN_OR_RETURN_UNWRAP(&cache, args.This());
+  Isolate* isolate = args.GetIsolate();
+  cache->stats_[IDX_LOOKUP_CACHE_STATS_SIZE] =
+      static_cast<double>(cache->entries_.size());
+  LocalVector<Value> stats(isolate);
+  stats.reserve(IDX_LOOKUP_CACHE_STATS_COUNT);
+  for (double stat : cache->stats_) {
+    stats.push_back(Number::New(isolate, stat));
+  }
+  args.GetReturnValue().Set(Array::New(isolate, stats.data(), stats.size()));
+}
+
+void LookupCache::Clear(const FunctionCallbackInfo<Value>& args) {
+  LookupCache* cache;
+  ASSIGN_OR_RETURN_UNWRAP(&cache, args.This());
+  // Entries with a refresh in flight are simply re-added when it completes.
+  cache->entries_.clear();
+}
+
+std::string LookupCache::MakeKey(const std::string& hostname,
+                                 const struct addrinfo& hints) {
+  std::string key = hostname;
+  key += '\0';
+  key += std::to_string(hints.ai_family);
+  key += ':';
+  key += std::to_string(hints.ai_flags);
+  return key;
+}
+
+const LookupCache::Entry* LookupCache::Lookup(const std::string& key,
+                                              const std::string& hostname,
+                                              const struct addrinfo& hints) {
+  auto it = entries_.find(key);
+  if (it == entries_.end()) {
+    stats_[IDX_LOOKUP_CACHE_STATS_MISSES]++;
+    return nullptr;
+  }
+
+  Entry& entry = it->second;
+  const uint64_t now = uv_now(env()->event_loop());
+  if (now >= entry.expiry) {
+    entries_.erase(it);
+    stats_[IDX_LOOKUP_CACHE_STATS_MISSES]++;
+    return nullptr;
+  }
+
+  stats_[IDX_LOOKUP_CACHE_STATS_HITS]++;
+  if (entry.status != 0) {
+    stats_[IDX_LOOKUP_CACHE_STATS_NEGATIVE_HITS]++;
+  } else if (!entry.refreshing && entry.expiry - now <= ttl_ / 10) {
+    auto refresh = std::make_unique<Refresh>(this, key, hostname, hints);
+    if (env()->threadpool_work_limiter()->Schedule(ThreadPoolWorkClass::kDns,
+                                                   refresh.get()) == 0) {
+      USE(refresh.release());
+      entry.refreshing = true;
+      stats_[IDX_LOOKUP_CACHE_STATS_PREFETCHES]++;
+    }
+  }
+  return &entry;
+}
+
+void LookupCache::Store(const std::string& key,
+                        int status,
+                        const struct addrinfo* res) {
+  uint64_t ttl;
+  if (status == 0) {
+    ttl = ttl_;
+  } else if (status == UV_EAI_NONAME || status == UV_EAI_NODATA) {
+    ttl = negative_ttl_;
+  } else {
+    return;
+  }
+  if (ttl == 0 || max_entries_ == 0) return;
+
+  auto it = entries_.find(key);
+  if (it == entries_.end()) {
+    if (entries_.size() >= max_entries_) Evict();
+    it = entries_.emplace(key, Entry{}).first;
+  }
+
+  Entry& entry = it->second;
+  entry.status = status;
+  entry.addresses.clear();
+  if (status == 0) CollectAddresses(res, &entry.addresses);
+  entry.expiry = uv_now(env()->event_loop()) + ttl;
+}
+
+bool LookupCache::AddWaiter(const std::string& key,
+                            GetAddrInfoReqWrap* req_wrap) {
+  auto [it, inserted] = waiters_.try_emplace(key);
+  if (inserted) return false;
+  it->second.emplace_back(req_wrap);
+  stats_[IDX_LOOKUP_CACHE_STATS_COALESCED]++;
+  return true;
+}
+
+std::vector<BaseObjectPtr<GetAddrInfoReqWrap>> LookupCache::TakeWaiters(
+    const std::string& key) {
+  std::vector<BaseObjectPtr<GetAddrInfoReqWrap>> waiters;
+  auto it = waiters_.find(key);
+  if (it != waiters_.end()) {
+    waiters = std::move(it->second);
+    waiters_.erase(it);
+  }
+  return waiters;
+}
+
+// Makes room for one more entry: drops everything that has expired, or the
+// entry closest to expiry if nothing has.
+void LookupCache::Evict() {
+  const uint64_t now = uv_now(env()->event_loop());
+  auto soonest = entries_.end();
+  for (auto it = entries_.begin(); it != entries_.end();) {
+    if (it->second.expiry <= now) {
+      it = entries_.erase(it);
+      stats_[IDX_LOOKUP_CACHE_STATS_EVICTIONS]++;
+      continue;
+    }
+    if (soonest == entries_.end() ||
+        it->second.expiry < soonest->second.expiry) {
+      soonest = it;
+    }
+    ++it;
+  }
+  if (entries_.size() >= max_entries_ && soonest != entries_.end()) {
+    entries_.erase(soonest);
+    stats_[IDX_LOOKUP_CACHE_STATS_EVICTIONS]++;
+  }
+}
+
+void LookupCache::MemoryInfo(MemoryTracker* tracker) const {
+  size_t size = 0;
+  for (const auto& [key, entry] : entries_) {
+    size += key.size() + sizeof(entry);
+    for (const Address& address : entry.addresses)
+      size += sizeof(address) + address.address.size();
+  }
+  tracker->TrackFieldWithSize("entries", size);
+}
+
+AddrInfoQueryWrap::AddrInfoQueryWrap(ChannelWrap* channel,
+                                     Local<Object> req_wrap_obj,
+                                     uint8_t order)
+    : AsyncWrap(
+          channel->env(), req_wrap_obj, AsyncWrap::PROVIDER_GETADDRINFOREQWRAP),
+      channel_(channel),
+      order_(order) {}
+
+AddrInfoQueryWrap::~AddrInfoQueryWrap() {
+  // Let Callback() know that this object no longer exists.
+  if (callback_ptr_ != nullptr) *callback_ptr_ = nullptr;
+}
+
+void AddrInfoQueryWrap::Send(const char* name,
+                             const struct ares_addrinfo_hints& hints) {
+  channel_->EnsureServers();
+  TRACE_EVENT_NESTABLE_ASYNC_BEGIN1(TRACING_CATEGORY_NODE2(dns, native),
+                                    "lookup",
+                                    this,
+                                    "hostname",
+                                    TRACE_STR_COPY(name));
+  CHECK_NULL(callback_ptr_);
+  callback_ptr_ = new AddrInfoQueryWrap*(this);
+  ares_getaddrinfo(channel_->cares_channel(),
+                   name,
+                   nullptr,
+                   &hints,
+                   Callback,
+                   callback_ptr_);
+}
+
+void AddrInfoQueryWrap::Callback(void* arg,
+                                 int status,
+                                 int timeouts,
+                                 struct ares_addrinfo* res) {
+  auto cleanup = OnScopeLeave([&]() { ares_freeaddrinfo(res); });
+  std::unique_ptr<AddrInfoQueryWrap*> wrap_ptr{
+      static_cast<AddrInfoQueryWrap**>(arg)};
+  AddrInfoQueryWrap* wrap = *wrap_ptr;
+  if (wrap == nullptr) return;
+  wrap->callback_ptr_ = nullptr;
+
+  // Report errors the way getaddrinfo() would, so that callers can treat
+  // both lookup paths alike.
+  int uv_status;
+  switch (status) {
+    case ARES_SUCCESS:
+      uv_status = 0;
+      break;
+    case ARES_ENOTFOUND:
+    case ARES_ENONAME:
+      uv_status = UV_EAI_NONAME;
+      break;
+    case ARES_ENODATA:
+      uv_status = UV_EAI_NODATA;
+      break;
+    case ARES_EBADFAMILY:
+      uv_status = UV_EAI_FAMILY;
+      break;
+    case ARES_EBADFLAGS:
+    case ARES_EBADHINTS:
+      uv_status = UV_EAI_BADFLAGS;
+      break;
+    case ARES_ENOMEM:
+      uv_status = UV_EAI_MEMORY;
+      break;
+    case ARES_ECANCELLED:
+    case ARES_EDESTRUCTION:
+      uv_status = UV_EAI_CANCELED;
+      break;
+    case ARES_ETIMEOUT:
+    case ARES_ECONNREFUSED:
+    case ARES_ESERVFAIL:
+      uv_status = UV_EAI_AGAIN;
+      break;
+    default:
+      uv_status = UV_EAI_FAIL;
+      break;
+  }
+
+  auto addresses = std::make_shared<std::vector<LookupCache::Address>>();
+  if (status == ARES_SUCCESS && res != nullptr) {
+    for (auto p = res->nodes; p != nullptr; p = p->ai_next) {
+      const void* addr;
+      if (p->ai_family == AF_INET) {
+        addr = &(reinterpret_cast<struct sockaddr_in*>(p->ai_addr)->sin_addr);
+      } else if (p->ai_family == AF_INET6) {
+        addr =
+            &(reinterpret_cast<struct sockaddr_in6*>(p->ai_addr)->sin6_addr);
+      } else {
+        continue;
+      }
+      char ip[INET6_ADDRSTRLEN];
+      if (uv_inet_ntop(p->ai_family, addr, ip, sizeof(ip))) continue;
+      addresses->push_back({p->ai_family, ip});
+    }
+  }
+
+  // c-ares may invoke this synchronously from within ares_getaddrinfo(),
+  // e.g. for names found in the hosts file, so defer the JS callback.
+  BaseObjectPtr<AddrInfoQueryWrap> strong_ref{wrap};
+  wrap->env()->SetImmediate([strong_ref, uv_status, addresses](Environment*) {
+    EmitLookupResult(
+        strong_ref.get(), strong_ref->order_, uv_status, *addresses);
+    // Delete once strong_ref goes out of scope.
+    strong_ref->Detach();
+  });
+
+  wrap->channel_->set_query_last_ok(status != ARES_ECONNREFUSED);
+  wrap->channel_->ModifyActivityQueryCount(-1);
+}
+
+namespace {
+
+// channel.getaddrinfo(req, hostname, family, hints, order)
+void ChannelGetAddrInfo(const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+  ChannelWrap* channel;
+  ASSIGN_OR_RETURN_UNWRAP(&channel, args.This());
+
+  CHECK(args[0]->IsObject());
+  CHECK(args[1]->IsString());
+  CHECK(args[2]->IsInt32());
+  CHECK(args[4]->IsUint32());
+  Local<Object> req_wrap_obj = args[0].As<Object>();
+  node::Utf8Value hostname(env->isolate(), args[1]);
+
+  ERR_ACCESS_DENIED_IF_INSUFFICIENT_PERMISSIONS(
+      env, permission::PermissionScope::kNet, hostname.ToStringView(), args);
+
+  std::string ascii_hostname = ada::idna::to_ascii(hostname.ToStringView());
+
+  int32_t flags = 0;
+  if (args[3]->IsInt32()) {
+    flags = args[3].As<Int32>()->Value();
+  }
+
+  struct ares_addrinfo_hints hints;
+  memset(&hints, 0, sizeof(hints));
+  switch (args[2].As<Int32>()->Value()) {
+    case 0:
+      hints.ai_family = AF_UNSPEC;
+      break;
+    case 4:
+      hints.ai_family = AF_INET;
+      break;
+    case 6:
+      hints.ai_family = AF_INET6;
+      break;
+    default:
+      UNREACHABLE("bad address family");
+  }
+  hints.ai_socktype = SOCK_STREAM;
+  if (flags & AI_ADDRCONFIG) hints.ai_flags |= ARES_AI_ADDRCONFIG;
+  if (flags & AI_V4MAPPED) hints.ai_flags |= ARES_AI_V4MAPPED;
+  if (flags & AI_ALL) hints.ai_flags |= ARES_AI_ALL;
+
+  const uint8_t order = args[4].As<Uint32>()->Value();
+  auto wrap =
+      std::make_unique<AddrInfoQueryWrap>(channel, req_wrap_obj, order);
+
+  channel->ModifyActivityQueryCount(1);
+  // Ownership passes to the ares callback.
+  wrap.release()->Send(ascii_hostname.c_str(), hints);
+
+  args.GetReturnValue().Set(0);
+}
+
+}  // anonymous namespace
+
 inline void safe_free_hostent(struct hostent* host) {
   int idx;
 
@@ -2232,7 +2857,7 @@ void Initialize(Local<Object> target,
 
   Local<FunctionTemplate> qrw =
       BaseObject::MakeLazilyInitializedJSTemplate(env);
-  qrw->Inherit(AsyncWrap::GetConstructorTemplate(env));
+  qrw->Inherit(CppgcAsyncWrap::GetConstructorTemplate(env->isolate_data()));
   SetConstructorFunction(context, target, "QueryReqWrap", qrw);
 
   Local<FunctionTemplate> channel_wrap =
@@ -2248,10 +2873,29 @@ void Initialize(Local<Object> target,
 
   SetProtoMethodNoSideEffect(isolate, channel_wrap, "getServers", GetServers);
   SetProtoMethod(isolate, channel_wrap, "setServers", SetServers);
+  SetProtoMethodNoSideEffect(
+      isolate, channel_wrap, "getServerStats", GetServerStats);
   SetProtoMethod(isolate, channel_wrap, "setLocalAddress", SetLocalAddress);
   SetProtoMethod(isolate, channel_wrap, "cancel", Cancel);
+  SetProtoMethod(isolate, channel_wrap, "getaddrinfo", ChannelGetAddrInfo);
 
   SetConstructorFunction(context, target, "ChannelWrap", channel_wrap);
+
+  Local<FunctionTemplate> lookup_cache =
+      NewFunctionTemplate(isolate, LookupCache::New);
+  lookup_cache->InstanceTemplate()->SetInternalFieldCount(
+      LookupCache::kInternalFieldCount);
+  SetProtoMethodNoSideEffect(
+      isolate, lookup_cache, "getStats", LookupCache::GetStats);
+  SetProtoMethod(isolate, lookup_cache, "clear", LookupCache::Clear);
+  SetConstructorFunction(context, target, "LookupCache", lookup_cache);
+
+#define V(name) NODE_DEFINE_CONSTANT(target, IDX_LOOKUP_CACHE_STATS_##name);
+  LOOKUP_CACHE_STATS(V)
+#undef V
+#define V(name) NODE_DEFINE_CONSTANT(target, IDX_DNS_SERVER_STATS_##name);
+  DNS_SERVER_STATS(V)
+#undef V
 }
 
 void RegisterExternalReferences(ExternalReferenceRegistry* registry) {
@@ -2268,8 +2912,13 @@ void RegisterExternalReferences(ExternalReferenceRegistry* registry) {
 
   registry->Register(GetServers);
   registry->Register(SetServers);
+  registry->Register(GetServerStats);
   registry->Register(SetLocalAddress);
   registry->Register(Cancel);
+  registry->Register(ChannelGetAddrInfo);
+  registry->Register(LookupCache::New);
+  registry->Register(LookupCache::GetStats);
+  registry->Register(LookupCache::Clear);
 }
 
 }  // namespace cares_wrap
@@ -7,6 +7,9 @@
 
 #include "async_wrap.h"
 #include "base_object.h"
+#include "cppgc/allocation.h"
+#include "cppgc/persistent.h"
+#include "cppgc_async_wrap-inl.h"
 #include "env.h"
 #include "memory_tracker.h"
 #include "node.h"
@@ -18,7 +21,12 @@
 #include "v8.h"
 #include "uv.h"
 
+#include <array>
+#include <map>
+#include <string>
+#include <unordered_map>
 #include <unordered_set>
+#include <vector>
 
 #ifdef __POSIX__
 # include <netdb.h>
@@ -36,6 +44,7 @@ constexpr uint8_t DNS_ORDER_IPV4_FIRST = 1;
 constexpr uint8_t DNS_ORDER_IPV6_FIRST = 2;
 
 class ChannelWrap;
+class GetAddrInfoReqWrap;
 
 inline void safe_free_hostent(struct hostent* host);
 
@@ -150,13 +159,35 @@ struct NodeAresTask final : public MemoryRetainer {
   using List = std::unordered_set<NodeAresTask*, Hash, Equal>;
 };
 
+#define DNS_SERVER_STATS(V)                                                    \
+  V(SUCCESSES)                                                                 \
+  V(FAILURES)                                                                  \
+  V(CONSECUTIVE_FAILURES)                                                      \
+  V(TCP_QUERIES)
+
+enum DnsServerStatsIndex {
+#define V(name) IDX_DNS_SERVER_STATS_##name,
+  DNS_SERVER_STATS(V)
+#undef V
+  IDX_DNS_SERVER_STATS_COUNT
+};
+
 class ChannelWrap final : public AsyncWrap {
  public:
+  // c-ares already prefers the servers with the fewest consecutive failures
+  // and, among those, the lowest average latency. A negative
+  // server_retry_chance keeps its defaults for how often a failed server is
+  // retried; otherwise a failed server is retried for one in
+  // server_retry_chance queries, or never for 0, once server_retry_delay
+  // milliseconds have passed since it failed.
   ChannelWrap(
       Environment* env,
       v8::Local<v8::Object> object,
       int timeout,
-      int tries);
+      int tries,
+      unsigned int max_cache_ttl,
+      int server_retry_chance,
+      uint32_t server_retry_delay);
   ~ChannelWrap() override;
 
   static void New(const v8::FunctionCallbackInfo<v8::Value>& args);
@@ -177,6 +208,14 @@ class ChannelWrap final : public AsyncWrap {
   inline int active_query_count() { return active_query_count_; }
   inline NodeAresTask::List* task_list() { return &task_list_; }
 
+  // Query outcomes per server, indexed by IDX_DNS_SERVER_STATS_* and keyed
+  // by the server in ares_get_servers_csv() format.
+  using ServerStats = std::array<double, IDX_DNS_SERVER_STATS_COUNT>;
+  inline const std::map<std::string, ServerStats>& server_stats() const {
+    return server_stats_;
+  }
+  inline void clear_server_stats() { server_stats_.clear(); }
+
   void MemoryInfo(MemoryTracker* tracker) const override;
   SET_MEMORY_INFO_NAME(ChannelWrap)
   SET_SELF_SIZE(ChannelWrap)
@@ -184,6 +223,11 @@ class ChannelWrap final : public AsyncWrap {
   static void AresTimeout(uv_timer_t* handle);
 
  private:
+  static void OnServerState(const char* server,
+                            ares_bool_t success,
+                            int flags,
+                            void* data);
+
   uv_timer_t* timer_handle_ = nullptr;
   ares_channel channel_ = nullptr;
   bool query_last_ok_ = true;
@@ -191,35 +235,159 @@ class ChannelWrap final : public AsyncWrap {
   bool library_inited_ = false;
   int timeout_;
   int tries_;
+  // Upper bound, in seconds, on how long c-ares may cache query responses.
+  // Zero disables the c-ares query cache.
+  unsigned int max_cache_ttl_;
+  int server_retry_chance_;
+  uint32_t server_retry_delay_;
   int active_query_count_ = 0;
   NodeAresTask::List task_list_;
+  std::map<std::string, ServerStats> server_stats_;
+};
+
+#define LOOKUP_CACHE_STATS(V)                                                  \
+  V(SIZE)                                                                      \
+  V(HITS)                                                                      \
+  V(MISSES)                                                                    \
+  V(NEGATIVE_HITS)                                                             \
+  V(PREFETCHES)                                                                \
+  V(EVICTIONS)                                                                 \
+  V(COALESCED)
+
+enum LookupCacheStatsIndex {
+#define V(name) IDX_LOOKUP_CACHE_STATS_##name,
+  LOOKUP_CACHE_STATS(V)
+#undef V
+  IDX_LOOKUP_CACHE_STATS_COUNT
+};
+
+// An optional cache for dns.lookup() results, shared by the lookups that
+// pass it to getaddrinfo(). getaddrinfo() does not report record TTLs, so
+// successful results are kept for a fixed ttl and NONAME/NODATA failures for
+// negative_ttl, both in milliseconds. A hit that arrives in the last tenth
+// of an entry's lifetime is answered from the cache and also starts a
+// background refresh, so that busy names never fall out of the cache.
+//
+// Independently of caching, lookups sharing a LookupCache are coalesced:
+// while one lookup for a key is on the threadpool, identical lookups wait
+// for its result instead of each taking a thread. A cache with a ttl of 0
+// therefore only coalesces.
+class LookupCache final : public BaseObject {
+ public:
+  struct Address {
+    int family;
+    std::string address;
+  };
+
+  struct Entry {
+    int status;
+    std::vector<Address> addresses;
+    uint64_t expiry;  // uv_now() in milliseconds
+    bool refreshing = false;
+  };
+
+  LookupCache(Environment* env,
+              v8::Local<v8::Object> object,
+              uint64_t ttl,
+              uint64_t negative_ttl,
+              size_t max_entries);
+  ~LookupCache() override;
+
+  static void New(const v8::FunctionCallbackInfo<v8::Value>& args);
+  static void GetStats(const v8::FunctionCallbackInfo<v8::Value>& args);
+  static void Clear(const v8::FunctionCallbackInfo<v8::Value>& args);
+
+  static std::string MakeKey(const std::string& hostname,
+                             const struct addrinfo& hints);
+
+  // Returns the live entry for key, or nullptr. May start a refresh.
+  const Entry* Lookup(const std::string& key,
+                      const std::string& hostname,
+                      const struct addrinfo& hints);
+  // Records the outcome of a lookup. Transient failures are not cached.
+  void Store(const std::string& key, int status, const struct addrinfo* res);
+
+  // Returns true if a lookup for key is already running, in which case
+  // req_wrap receives that lookup's result. Otherwise marks key as running
+  // and returns false; the caller must then call TakeWaiters() once done.
+  bool AddWaiter(const std::string& key, GetAddrInfoReqWrap* req_wrap);
+  std::vector<BaseObjectPtr<GetAddrInfoReqWrap>> TakeWaiters(
+      const std::string& key);
+
+  void MemoryInfo(MemoryTracker* tracker) const override;
+  SET_MEMORY_INFO_NAME(LookupCache)
+  SET_SELF_SIZE(LookupCache)
+
+ private:
+  class Refresh;
+
+  void Evict();
+
+  const uint64_t ttl_;
+  const uint64_t negative_ttl_;
+  const size_t max_entries_;
+  std::unordered_map<std::string, Entry> entries_;
+  using WaiterList = std::vector<BaseObjectPtr<GetAddrInfoReqWrap>>;
+  std::unordered_map<std::string, WaiterList> waiters_;
+  double stats_[IDX_LOOKUP_CACHE_STATS_COUNT] = {};
 };
 
-class GetAddrInfoReqWrap final : public ReqWrap<uv_getaddrinfo_t> {
+// dns.lookup() and dns.lookupService() run on the libuv threadpool and are
+// subject to the Environment's ThreadPoolWorkClass::kDns limit, so the
+// arguments are kept around until the request is actually dispatched.
+class GetAddrInfoReqWrap final : public ReqWrap<uv_getaddrinfo_t>,
+                                 public ThreadPoolWorkLimiter::Work {
  public:
   GetAddrInfoReqWrap(Environment* env,
                      v8::Local<v8::Object> req_wrap_obj,
-                     uint8_t order);
+                     uint8_t order,
+                     std::string hostname,
+                     const struct addrinfo& hints);
 
   SET_NO_MEMORY_INFO()
   SET_MEMORY_INFO_NAME(GetAddrInfoReqWrap)
   SET_SELF_SIZE(GetAddrInfoReqWrap)
 
   uint8_t order() const { return order_; }
+  const char* hostname() const { return hostname_.c_str(); }
+
+  // Lookups that miss the cache store their result in it on completion.
+  void set_cache(LookupCache* cache, std::string key) {
+    cache_.reset(cache);
+    cache_key_ = std::move(key);
+  }
+  LookupCache* cache() const { return cache_.get(); }
+  const std::string& cache_key() const { return cache_key_; }
+
+  int SubmitWork() override;
+  void OnSubmitError(int status) override;
 
  private:
   const uint8_t order_;
+  const std::string hostname_;
+  const struct addrinfo hints_;
+  BaseObjectPtr<LookupCache> cache_;
+  std::string cache_key_;
 };
 
-class GetNameInfoReqWrap final : public ReqWrap<uv_getnameinfo_t> {
+class GetNameInfoReqWrap final : public ReqWrap<uv_getnameinfo_t>,
+                                 public ThreadPoolWorkLimiter::Work {
  public:
-  GetNameInfoReqWrap(Environment* env, v8::Local<v8::Object> req_wrap_obj);
+  GetNameInfoReqWrap(Environment* env,
+                     v8::Local<v8::Object> req_wrap_obj,
+                     const struct sockaddr_storage& addr);
 
   SET_INSUFFICIENT_PERMISSION_ERROR_CALLBACK(permission::PermissionScope::kNet)
 
   SET_NO_MEMORY_INFO()
   SET_MEMORY_INFO_NAME(GetNameInfoReqWrap)
   SET_SELF_SIZE(GetNameInfoReqWrap)
+
+  int SubmitWork() override;
+  void OnSubmitError(int status) override;
+
+ private:
+  const struct sockaddr_storage addr_;
 };
 
 struct ResponseData final {
@@ -229,20 +397,78 @@ struct ResponseData final {
   MallocedBuffer<unsigned char> buf;
 };
 
+// ChannelWrap#getaddrinfo(): the same results as dns.lookup(), but resolved
+// by ares_getaddrinfo() on the event loop instead of by getaddrinfo() on the
+// threadpool. c-ares reads the hosts file and resolv.conf itself, so this
+// matches libc only where NSS is configured as "files dns".
+class AddrInfoQueryWrap final : public AsyncWrap {
+ public:
+  AddrInfoQueryWrap(ChannelWrap* channel,
+                    v8::Local<v8::Object> req_wrap_obj,
+                    uint8_t order);
+  ~AddrInfoQueryWrap() override;
+
+  void Send(const char* name, const struct ares_addrinfo_hints& hints);
+
+  SET_NO_MEMORY_INFO()
+  SET_MEMORY_INFO_NAME(AddrInfoQueryWrap)
+  SET_SELF_SIZE(AddrInfoQueryWrap)
+
+ private:
+  static void Callback(void* arg,
+                       int status,
+                       int timeouts,
+                       struct ares_addrinfo* res);
+
+  BaseObjectPtr<ChannelWrap> channel_;
+  const uint8_t order_;
+  // See QueryWrap::callback_ptr_.
+  AddrInfoQueryWrap** callback_ptr_ = nullptr;
+};
+
+// Managed by cppgc. While c-ares has the query, the pointer that it passes
+// to Callback() keeps the wrap alive, and after that the immediate that runs
+// AfterResponse() does.
 template <typename Traits>
-class QueryWrap final : public AsyncWrap {
+class QueryWrap final : public CppgcAsyncWrap {
  public:
+  using Persistent = cppgc::Persistent<QueryWrap<Traits>>;
+
   QueryWrap(ChannelWrap* channel, v8::Local<v8::Object> req_wrap_obj)
-      : AsyncWrap(channel->env(), req_wrap_obj, AsyncWrap::PROVIDER_QUERYWRAP),
-        channel_(channel),
-        trace_name_(Traits::name) {}
+      : channel_(channel), trace_name_(Traits::name) {
+    CppgcAsyncWrap::Wrap(
+        this, channel->env(), req_wrap_obj, AsyncWrap::PROVIDER_QUERYWRAP);
+  }
+
+  ~QueryWrap() override { this->Finalize(); }
+
+  static QueryWrap<Traits>* New(ChannelWrap* channel,
+                                v8::Local<v8::Object> req_wrap_obj) {
+    return cppgc::MakeGarbageCollected<QueryWrap<Traits>>(
+        channel->env()->cppgc_allocation_handle(), channel, req_wrap_obj);
+  }
 
-  ~QueryWrap() {
-    CHECK_EQ(false, persistent().IsEmpty());
+  SET_CPPGC_NAME(QueryWrap)
+  void Trace(cppgc::Visitor* visitor) const final {
+    CppgcAsyncWrap::Trace(visitor);
+  }
+
+  void Clean(Realm* realm) override {
+    // Let Callback() know that this object no longer exists, before the
+    // channel can go away and cancel the query.
+    if (callback_ptr_ != nullptr) {
+      callback_ptr_->Clear();
+      callback_ptr_ = nullptr;
+    }
+    channel_.reset();
+    CppgcAsyncWrap::Clean(realm);
+  }
 
-    // Let Callback() know that this object no longer exists.
-    if (callback_ptr_ != nullptr)
-      *callback_ptr_ = nullptr;
+  // Runs the destroy hooks and lets go of the channel once the query has
+  // completed, so that neither waits for the garbage collector.
+  void Done() {
+    EmitDestroy();
+    channel_.reset();
   }
 
   int Send(const char* name) {
@@ -308,17 +534,14 @@ class QueryWrap final : public AsyncWrap {
 
   void* MakeCallbackPointer() {
     CHECK_NULL(callback_ptr_);
-    callback_ptr_ = new QueryWrap<Traits>*(this);
+    callback_ptr_ = new Persistent(this);
     return callback_ptr_;
   }
 
-  static QueryWrap<Traits>* FromCallbackPointer(void* arg) {
-    std::unique_ptr<QueryWrap<Traits>*> wrap_ptr {
-        static_cast<QueryWrap<Traits>**>(arg)
-    };
-    QueryWrap<Traits>* wrap = *wrap_ptr.get();
-    if (wrap == nullptr) return nullptr;
-    wrap->callback_ptr_ = nullptr;
+  static Persistent FromCallbackPointer(void* arg) {
+    std::unique_ptr<Persistent> wrap_ptr{static_cast<Persistent*>(arg)};
+    Persistent wrap = std::move(*wrap_ptr);
+    if (wrap) wrap->callback_ptr_ = nullptr;
     return wrap;
   }
 
@@ -326,8 +549,8 @@ class QueryWrap final : public AsyncWrap {
                        ares_status_t status,
                        size_t timeouts,
                        const ares_dns_record_t* dnsrec) {
-    QueryWrap<Traits>* wrap = FromCallbackPointer(arg);
-    if (wrap == nullptr) return;
+    Persistent wrap = FromCallbackPointer(arg);
+    if (!wrap) return;
 
     unsigned char* buf_copy = nullptr;
     size_t answer_len = 0;
@@ -352,8 +575,8 @@ class QueryWrap final : public AsyncWrap {
       int status,
       int timeouts,
       struct hostent* host) {
-    QueryWrap<Traits>* wrap = FromCallbackPointer(arg);
-    if (wrap == nullptr) return;
+    Persistent wrap = FromCallbackPointer(arg);
+    if (!wrap) return;
 
     struct hostent* host_copy = nullptr;
     if (status == ARES_SUCCESS) {
@@ -371,13 +594,13 @@ class QueryWrap final : public AsyncWrap {
   }
 
   void QueuePermissionModelResponseCallback(const char* resource) {
-    BaseObjectPtr<QueryWrap<Traits>> strong_ref{this};
+    Persistent strong_ref{this};
     const std::string res{resource};
     env()->SetImmediate([this, strong_ref, res](Environment*) {
+      // Clean() has run if the Realm is shutting down.
+      if (realm() == nullptr) return;
       InsufficientPermissionError(res);
-
-      // Delete once strong_ref goes out of scope.
-      Detach();
+      Done();
     });
 
     channel_->set_query_last_ok(true);
@@ -385,12 +608,12 @@ class QueryWrap final : public AsyncWrap {
   }
 
   void QueueResponseCallback(int status) {
-    BaseObjectPtr<QueryWrap<Traits>> strong_ref{this};
+    Persistent strong_ref{this};
     env()->SetImmediate([this, strong_ref](Environment*) {
+      // Clean() has run if the Realm is shutting down.
+      if (realm() == nullptr) return;
       AfterResponse();
-
-      // Delete once strong_ref goes out of scope.
-      Detach();
+      Done();
     });
 
     channel_->set_query_last_ok(status != ARES_ECONNREFUSED);
@@ -421,7 +644,6 @@ class QueryWrap final : public AsyncWrap {
     }
   }
 
-  SET_MEMORY_INFO_NAME(QueryWrap)
   SET_SELF_SIZE(QueryWrap<Traits>)
 
  private:
@@ -429,9 +651,9 @@ class QueryWrap final : public AsyncWrap {
 
   std::unique_ptr<ResponseData> response_data_;
   const char* trace_name_;
-  // Pointer to pointer to 'this' that can be reset from the destructor,
-  // in order to let Callback() know that 'this' no longer exists.
-  QueryWrap<Traits>** callback_ptr_ = nullptr;
+  // The pointer that c-ares passes to Callback(). Clean() clears it to let
+  // Callback() know that 'this' no longer exists.
+  Persistent* callback_ptr_ = nullptr;
 };
 
 #define QUERY_TYPES(V)                                                         \
@@ -1,9 +1,14 @@
 #include "compile_cache.h"
+#include <algorithm>
+#include <atomic>
+#include <deque>
 #include <string>
+#include <vector>
 #include "debug_utils-inl.h"
 #include "env-inl.h"
 #include "node_file.h"
 #include "node_internals.h"
+#include "node_mutex.h"
 #include "node_version.h"
 #include "path.h"
 #include "util.h"
@@ -13,6 +18,10 @@
 #include <unistd.h>  // getuid
 #endif
 
+#ifndef _WIN32
+#include <sys/mman.h>  // mmap
+#endif
+
 namespace node {
 
 using v8::Function;
@@ -20,6 +29,7 @@ using v8::Local;
 using v8::Module;
 using v8::ScriptCompiler;
 using v8::String;
+using v8::UnboundScript;
 
 namespace {
 std::string Uint32ToHex(uint32_t crc) {
@@ -74,6 +84,11 @@ inline void CompileCacheHandler::Debug(const char* format,
 
 ScriptCompiler::CachedData* CompileCacheEntry::CopyCache() const {
   DCHECK_NOT_NULL(cache);
+  if (cache->buffer_policy == ScriptCompiler::CachedData::BufferNotOwned) {
+    // Loaded from the packed cache, whose mapping outlives the compilation.
+    return new ScriptCompiler::CachedData(
+        cache->data, cache->length, ScriptCompiler::CachedData::BufferNotOwned);
+  }
   int cache_size = cache->length;
   uint8_t* data = new uint8_t[cache_size];
   memcpy(data, cache->data, cache_size);
@@ -97,6 +112,10 @@ const char* CompileCacheEntry::type_name() const {
       return "TransformedTypeScript";
     case CachedCodeType::kTransformedTypeScriptWithSourceMaps:
       return "TransformedTypeScriptWithSourceMaps";
+    case CachedCodeType::kVmScript:
+      return "VmScript";
+    case CachedCodeType::kWasm:
+      return "Wasm";
     default:
       UNREACHABLE();
   }
@@ -223,6 +242,442 @@ void CompileCacheHandler::ReadCacheFile(CompileCacheEntry* entry) {
   Debug(" success, size=%d\n", total_read);
 }
 
+// Used for identifying and verifying a file is a packed compile cache.
+// See comments in CompileCacheHandler::PersistPack().
+constexpr uint32_t kPackMagicNumber = 0x8adfdbb3;
+constexpr char kPackFilename[] = "pack";
+
+CompileCacheHandler::~CompileCacheHandler() {
+  // Finish the write in progress, if any, before tearing down.
+  writer_.reset();
+  warmup_.reset();
+  UnloadPack();
+}
+
+void CompileCacheHandler::LoadPack() {
+  Debug("[compile cache] loading packed cache %s...", pack_filename_);
+
+  uv_fs_t req;
+  auto defer_req_cleanup = OnScopeLeave([&req]() { uv_fs_req_cleanup(&req); });
+  uv_file file =
+      uv_fs_open(nullptr, &req, pack_filename_.c_str(), O_RDONLY, 0, nullptr);
+  if (req.result < 0) {
+    Debug(" %s\n", uv_strerror(req.result));
+    return;
+  }
+  uv_fs_req_cleanup(&req);
+  auto defer_close = OnScopeLeave([file]() {
+    uv_fs_t close_req;
+    CHECK_EQ(0, uv_fs_close(nullptr, &close_req, file, nullptr));
+    uv_fs_req_cleanup(&close_req);
+  });
+
+  int err = uv_fs_fstat(nullptr, &req, file, nullptr);
+  if (err < 0) {
+    Debug(" %s\n", uv_strerror(err));
+    return;
+  }
+  size_t size = static_cast<size_t>(req.statbuf.st_size);
+  uv_fs_req_cleanup(&req);
+  if (size < kPackHeaderSize) {
+    Debug(" file too small, size=%d\n", size);
+    return;
+  }
+
+#ifdef _WIN32
+  // Read the whole pack with a single read instead.
+  std::unique_ptr<uint8_t[]> buffer(new uint8_t[size]);
+  uv_buf_t buf = uv_buf_init(reinterpret_cast<char*>(buffer.get()), size);
+  int bytes_read = uv_fs_read(nullptr, &req, file, &buf, 1, 0, nullptr);
+  if (bytes_read != static_cast<int>(size)) {
+    Debug(" reading failed, bytes read %d\n", bytes_read);
+    return;
+  }
+  pack_buffer_ = std::move(buffer);
+  pack_data_ = pack_buffer_.get();
+#else
+  void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file, 0);
+  if (mapping == MAP_FAILED) {
+    Debug(" mmap failed, %s\n", uv_strerror(uv_translate_sys_error(errno)));
+    return;
+  }
+  pack_data_ = static_cast<const uint8_t*>(mapping);
+#endif
+  pack_size_ = size;
+
+  uint32_t header[kPackHeaderCount];
+  memcpy(header, pack_data_, sizeof(header));
+  if (header[kMagicNumberOffset] != kPackMagicNumber) {
+    Debug(" magic number mismatch: expected %d, actual %d\n",
+          kPackMagicNumber,
+          header[kMagicNumberOffset]);
+    return UnloadPack();
+  }
+  uint32_t count = header[kPackEntryCountOffset];
+  if (count > (size - kPackHeaderSize) / sizeof(PackIndexEntry)) {
+    Debug(" index out of bounds, entries=%d\n", count);
+    return UnloadPack();
+  }
+  const char* index_ptr =
+      reinterpret_cast<const char*>(pack_data_) + kPackHeaderSize;
+  size_t index_size = count * sizeof(PackIndexEntry);
+  if (header[kPackIndexHashOffset] != GetHash(index_ptr, index_size)) {
+    Debug(" index hash mismatch\n");
+    return UnloadPack();
+  }
+
+  const PackIndexEntry* index =
+      reinterpret_cast<const PackIndexEntry*>(index_ptr);
+  pack_index_.reserve(count);
+  for (uint32_t i = 0; i < count; ++i) {
+    if (index[i].offset > size ||
+        index[i].cache_size > size - index[i].offset) {
+      Debug(" entry %d out of bounds\n", i);
+      return UnloadPack();
+    }
+    pack_index_.emplace(index[i].cache_key, &index[i]);
+  }
+  Debug(" success, entries=%d, size=%d\n", count, size);
+}
+
+void CompileCacheHandler::UnloadPack() {
+  pack_index_.clear();
+  if (pack_data_ == nullptr) return;
+#ifdef _WIN32
+  pack_buffer_.reset();
+#else
+  CHECK_EQ(munmap(const_cast<uint8_t*>(pack_data_), pack_size_), 0);
+#endif
+  pack_data_ = nullptr;
+  pack_size_ = 0;
+}
+
+// Verifies, and for ES modules deserializes, the entries of the packed
+// cache that the previous run used, on worker threads, while the main
+// thread gets on with bootstrapping and running the first modules.
+// ReadFromPack() claims an entry from here before looking at it itself.
+class CompileCacheWarmup {
+ public:
+  struct Item {
+    const CompileCacheHandler::PackIndexEntry* index;
+    // Only set for ES modules. CompileFunction(), which the CommonJS loader
+    // uses, cannot consume a deserialization task.
+    std::unique_ptr<ScriptCompiler::ConsumeCodeCacheTask> task;
+    std::atomic<int> state{kPending};
+    bool verified = false;
+  };
+
+  enum : int { kPending, kRunning, kDone };
+
+  CompileCacheWarmup() = default;
+  ~CompileCacheWarmup() {
+    if (job_) job_->Cancel();
+  }
+
+  void Add(std::unique_ptr<Item> item) {
+    uint32_t key = item->index->cache_key;
+    items_.push_back(std::move(item));
+    by_key_.emplace(key, items_.back().get());
+  }
+
+  void Start(v8::Platform* platform, const uint8_t* pack_data);
+
+  // Takes over the warmup of |key|, waiting for a worker that is already
+  // processing it. Returns false if |key| is not being warmed up.
+  bool Claim(uint32_t key,
+             bool* verified,
+             std::unique_ptr<ScriptCompiler::ConsumeCodeCacheTask>* task) {
+    auto it = by_key_.find(key);
+    if (it == by_key_.end()) return false;
+    Item* item = it->second;
+    by_key_.erase(it);
+
+    int expected = kPending;
+    if (item->state.compare_exchange_strong(expected, kDone)) {
+      // Not started yet; the caller verifies the entry itself, and a task
+      // that never ran must not be handed to V8.
+      *verified = false;
+      item->task.reset();
+      return true;
+    }
+    {
+      Mutex::ScopedLock lock(mutex_);
+      while (item->state.load() != kDone) done_cond_.Wait(lock);
+    }
+    *verified = item->verified;
+    if (item->verified) *task = std::move(item->task);
+    return true;
+  }
+
+  size_t size() const { return items_.size(); }
+
+ private:
+  class WarmupTask final : public v8::JobTask {
+   public:
+    WarmupTask(CompileCacheWarmup* warmup, const uint8_t* pack_data)
+        : warmup_(warmup), pack_data_(pack_data) {}
+
+    void Run(v8::JobDelegate* delegate) override {
+      while (!delegate->ShouldYield()) {
+        size_t i = next_.fetch_add(1, std::memory_order_relaxed);
+        if (i >= warmup_->items_.size()) break;
+        Item* item = warmup_->items_[i].get();
+        int expected = kPending;
+        if (!item->state.compare_exchange_strong(expected, kRunning))
+          continue;
+
+        const char* data =
+            reinterpret_cast<const char*>(pack_data_ + item->index->offset);
+        item->verified = item->index->cache_hash ==
+                         GetHash(data, item->index->cache_size);
+        if (item->verified && item->task) item->task->Run();
+
+        Mutex::ScopedLock lock(warmup_->mutex_);
+        item->state.store(kDone);
+        warmup_->done_cond_.Broadcast(lock);
+      }
+    }
+
+    size_t GetMaxConcurrency(size_t worker_count) const override {
+      size_t next = next_.load(std::memory_order_relaxed);
+      size_t total = warmup_->items_.size();
+      return next >= total ? 0 : std::min<size_t>(total - next, 4);
+    }
+
+   private:
+    CompileCacheWarmup* warmup_;
+    const uint8_t* pack_data_;
+    std::atomic<size_t> next_{0};
+  };
+
+  std::vector<std::unique_ptr<Item>> items_;
+  // Only used on the main thread.
+  std::unordered_map<uint32_t, Item*> by_key_;
+  Mutex mutex_;
+  ConditionVariable done_cond_;
+  std::unique_ptr<v8::JobHandle> job_;
+};
+
+void CompileCacheWarmup::Start(v8::Platform* platform,
+                               const uint8_t* pack_data) {
+  if (items_.empty()) return;
+  job_ = platform->PostJob(v8::TaskPriority::kUserVisible,
+                           std::make_unique<WarmupTask>(this, pack_data));
+}
+
+void CompileCacheHandler::StartWarmup() {
+  if (pack_index_.empty()) return;
+  auto warmup = std::make_unique<CompileCacheWarmup>();
+  for (auto& pair : pack_index_) {
+    const PackIndexEntry* index = pair.second;
+    if (!(index->type & kPackEntryUsedFlag)) continue;
+    auto item = std::make_unique<CompileCacheWarmup::Item>();
+    item->index = index;
+    // Code caches of functions, i.e. of CommonJS modules, cannot be consumed
+    // off-thread.
+    uint32_t type = index->type & ~kPackEntryUsedFlag;
+    if (type == static_cast<uint32_t>(CachedCodeType::kESM) ||
+        type == static_cast<uint32_t>(CachedCodeType::kVmScript)) {
+      // The data stays in the mapping, which outlives the warmup.
+      item->task.reset(ScriptCompiler::StartConsumingCodeCache(
+          isolate_,
+          std::make_unique<ScriptCompiler::CachedData>(
+              pack_data_ + index->offset,
+              index->cache_size,
+              ScriptCompiler::CachedData::BufferNotOwned)));
+    }
+    warmup->Add(std::move(item));
+  }
+  Debug("[compile cache] warming up %d entries of the packed cache\n",
+        warmup->size());
+  warmup->Start(platform_, pack_data_);
+  warmup_ = std::move(warmup);
+}
+
+void CompileCacheHandler::ReadFromPack(CompileCacheEntry* entry) {
+  Debug("[compile cache] looking up %s %s in packed cache...",
+        entry->type_name(),
+        entry->source_filename);
+  auto it = pack_index_.find(entry->cache_key);
+  if (it == pack_index_.end()) {
+    Debug(" not found\n");
+    return;
+  }
+  const PackIndexEntry* index = it->second;
+  bool verified = false;
+  std::unique_ptr<ScriptCompiler::ConsumeCodeCacheTask> task;
+  bool warmed_up =
+      warmup_ && warmup_->Claim(entry->cache_key, &verified, &task);
+  if ((index->type & ~kPackEntryUsedFlag) !=
+          static_cast<uint32_t>(entry->type) ||
+      index->code_size != entry->code_size ||
+      index->code_hash != entry->code_hash) {
+    Debug(" code mismatch\n");
+    return;
+  }
+  const uint8_t* data = pack_data_ + index->offset;
+  if (!verified) {
+    uint32_t cache_hash =
+        GetHash(reinterpret_cast<const char*>(data), index->cache_size);
+    if (index->cache_hash != cache_hash) {
+      Debug(" cache hash mismatch: expected %d, actual %d\n",
+            index->cache_hash,
+            cache_hash);
+      return;
+    }
+  }
+
+  // The data stays in the mapping, which outlives the entry.
+  entry->cache.reset(new ScriptCompiler::CachedData(
+      data, index->cache_size, ScriptCompiler::CachedData::BufferNotOwned));
+  entry->consume_task = std::move(task);
+  Debug(" success%s, size=%d\n",
+        warmed_up ? " (warmed up)" : "",
+        index->cache_size);
+}
+
+/**
+ * Persist the compile cache accumulated in memory, together with the
+ * entries of the existing pack that were not used in this process, into a
+ * new pack, which then replaces the old one atomically.
+ *
+ * Layout of a pack file:
+ *   [uint32_t] magic number
+ *   [uint32_t] entry count
+ *   [uint32_t] index hash
+ *   [uint32_t] reserved
+ *   [PackIndexEntry] x entry count, sorted by nothing in particular
+ *   .... compile cache contents, at the offsets given in the index ....
+ */
+void CompileCacheHandler::PersistPack() {
+  struct PackedEntry {
+    PackIndexEntry index;
+    const uint8_t* data;
+  };
+  std::vector<PackedEntry> entries;
+  entries.reserve(compiler_cache_store_.size() + pack_index_.size());
+  bool dirty = false;
+
+  for (auto& pair : compiler_cache_store_) {
+    CompileCacheEntry* entry = pair.second.get();
+    auto packed = pack_index_.find(entry->cache_key);
+    if (entry->cache == nullptr) {
+      // The source changed since the pack was written, drop the stale entry.
+      if (packed != pack_index_.end()) dirty = true;
+      continue;
+    }
+    if (entry->refreshed) {
+      dirty = true;
+    } else if (packed == pack_index_.end()) {
+      continue;
+    }
+    PackIndexEntry index{};
+    index.cache_key = entry->cache_key;
+    // Remember which entries this run used, for the next warmup.
+    index.type = static_cast<uint32_t>(entry->type) | kPackEntryUsedFlag;
+    index.code_size = entry->code_size;
+    index.code_hash = entry->code_hash;
+    index.cache_size = static_cast<uint32_t>(entry->cache->length);
+    index.cache_hash =
+        entry->refreshed
+            ? GetHash(reinterpret_cast<const char*>(entry->cache->data),
+                      index.cache_size)
+            : packed->second->cache_hash;
+    entries.push_back({index, entry->cache->data});
+  }
+  for (auto& pair : pack_index_) {
+    if (compiler_cache_store_.count(pair.first) != 0) continue;
+    PackIndexEntry index = *pair.second;
+    index.type &= ~kPackEntryUsedFlag;
+    entries.push_back({index, pack_data_ + pair.second->offset});
+  }
+
+  if (!dirty) {
+    Debug("[compile cache] skip persisting packed cache because it was the "
+          "same\n");
+    return;
+  }
+
+  std::vector<char> head(kPackHeaderSize +
+                         entries.size() * sizeof(PackIndexEntry));
+  std::vector<uv_buf_t> bufs;
+  bufs.reserve(entries.size() + 1);
+  bufs.push_back(uv_buf_init(head.data(), head.size()));
+  uint64_t offset = head.size();
+  PackIndexEntry* index =
+      reinterpret_cast<PackIndexEntry*>(head.data() + kPackHeaderSize);
+  for (size_t i = 0; i < entries.size(); ++i) {
+    index[i] = entries[i].index;
+    index[i].offset = offset;
+    offset += index[i].cache_size;
+    bufs.push_back(uv_buf_init(
+        reinterpret_cast<char*>(const_cast<uint8_t*>(entries[i].data)),
+        index[i].cache_size));
+  }
+  uint32_t header[kPackHeaderCount] = {};
+  header[kMagicNumberOffset] = kPackMagicNumber;
+  header[kPackEntryCountOffset] = static_cast<uint32_t>(entries.size());
+  header[kPackIndexHashOffset] =
+      GetHash(head.data() + kPackHeaderSize, head.size() - kPackHeaderSize);
+  memcpy(head.data(), header, sizeof(header));
+
+  uv_fs_t mkstemp_req;
+  auto cleanup_mkstemp =
+      OnScopeLeave([&mkstemp_req]() { uv_fs_req_cleanup(&mkstemp_req); });
+  std::string pack_filename_tmp = pack_filename_ + ".XXXXXX";
+  Debug("[compile cache] writing %d entries to packed cache...",
+        entries.size());
+  int err = uv_fs_mkstemp(
+      nullptr, &mkstemp_req, pack_filename_tmp.c_str(), nullptr);
+  if (err < 0) {
+    Debug("failed. %s\n", uv_strerror(err));
+    return;
+  }
+
+  // Write in chunks to stay below IOV_MAX.
+  constexpr size_t kBufsPerWrite = 64;
+  int64_t position = 0;
+  for (size_t i = 0; i < bufs.size() && err >= 0; i += kBufsPerWrite) {
+    unsigned int nbufs =
+        static_cast<unsigned int>(std::min(kBufsPerWrite, bufs.size() - i));
+    uv_fs_t write_req;
+    err = uv_fs_write(nullptr,
+                      &write_req,
+                      mkstemp_req.result,
+                      bufs.data() + i,
+                      nbufs,
+                      position,
+                      nullptr);
+    uv_fs_req_cleanup(&write_req);
+    if (err >= 0) position += err;
+  }
+  uv_fs_t close_req;
+  int close_err =
+      uv_fs_close(nullptr, &close_req, mkstemp_req.result, nullptr);
+  uv_fs_req_cleanup(&close_req);
+  if (err >= 0) err = close_err;
+  if (err >= 0 && static_cast<uint64_t>(position) != offset) err = UV_EIO;
+
+  if (err >= 0) {
+    uv_fs_t rename_req;
+    err = uv_fs_rename(nullptr,
+                       &rename_req,
+                       mkstemp_req.path,
+                       pack_filename_.c_str(),
+                       nullptr);
+    uv_fs_req_cleanup(&rename_req);
+  }
+  if (err < 0) {
+    Debug("failed: %s\n", uv_strerror(err));
+    uv_fs_t unlink_req;
+    uv_fs_unlink(nullptr, &unlink_req, mkstemp_req.path, nullptr);
+    uv_fs_req_cleanup(&unlink_req);
+    return;
+  }
+  Debug("success, size=%d\n", offset);
+  for (auto& pair : compiler_cache_store_) pair.second->persisted = true;
+}
+
 CompileCacheEntry* CompileCacheHandler::GetOrInsert(Local<String> code,
                                                     Local<String> filename,
                                                     CachedCodeType type) {
@@ -261,11 +716,36 @@ CompileCacheEntry* CompileCacheHandler::GetOrInsert(Local<String> code,
 
   // TODO(joyeecheung): if we fail enough times, stop trying for any future
   // files.
-  ReadCacheFile(result);
+  if (pack_filename_.empty()) {
+    ReadCacheFile(result);
+  } else {
+    ReadFromPack(result);
+  }
 
   return result;
 }
 
+uint32_t CompileCacheHandler::ExtendHash(uint32_t hash,
+                                         const uint8_t* data,
+                                         size_t size) {
+  return crc32(hash, reinterpret_cast<const Bytef*>(data), size);
+}
+
+std::unique_ptr<CompileCacheEntry> CompileCacheHandler::ReadWasm(
+    std::string_view name, uint32_t code_hash, uint32_t code_size) {
+  DCHECK(!compile_cache_dir_.empty());
+  auto entry = std::make_unique<CompileCacheEntry>();
+  entry->type = CachedCodeType::kWasm;
+  entry->cache_key = GetCacheKey(name, entry->type);
+  entry->code_hash = code_hash;
+  entry->code_size = code_size;
+  entry->cache_filename =
+      compile_cache_dir_ + kPathSeparator + Uint32ToHex(entry->cache_key);
+  entry->source_filename = std::string(name);
+  ReadCacheFile(entry.get());
+  return entry;
+}
+
 ScriptCompiler::CachedData* SerializeCodeCache(Local<Function> func) {
   return ScriptCompiler::CreateCodeCacheForFunction(func);
 }
@@ -274,6 +754,10 @@ ScriptCompiler::CachedData* SerializeCodeCache(Local<Module> mod) {
   return ScriptCompiler::CreateCodeCache(mod->GetUnboundModuleScript());
 }
 
+ScriptCompiler::CachedData* SerializeCodeCache(Local<UnboundScript> script) {
+  return ScriptCompiler::CreateCodeCache(script);
+}
+
 template <typename T>
 void CompileCacheHandler::MaybeSaveImpl(CompileCacheEntry* entry,
                                         Local<T> func_or_mod,
@@ -296,6 +780,7 @@ void CompileCacheHandler::MaybeSaveImpl(CompileCacheEntry* entry,
   DCHECK_EQ(data->buffer_policy, ScriptCompiler::CachedData::BufferOwned);
   entry->refreshed = true;
   entry->cache.reset(data);
+  ScheduleWrite(entry);
 }
 
 void CompileCacheHandler::MaybeSave(CompileCacheEntry* entry,
@@ -311,6 +796,13 @@ void CompileCacheHandler::MaybeSave(CompileCacheEntry* entry,
   MaybeSaveImpl(entry, func, rejected);
 }
 
+void CompileCacheHandler::MaybeSave(CompileCacheEntry* entry,
+                                    Local<UnboundScript> script,
+                                    bool rejected) {
+  DCHECK_EQ(entry->type, CachedCodeType::kVmScript);
+  MaybeSaveImpl(entry, script, rejected);
+}
+
 void CompileCacheHandler::MaybeSave(CompileCacheEntry* entry,
                                     std::string_view transpiled) {
   CHECK(entry->type == CachedCodeType::kStrippedTypeScript ||
@@ -328,10 +820,115 @@ void CompileCacheHandler::MaybeSave(CompileCacheEntry* entry,
   entry->cache.reset(new ScriptCompiler::CachedData(
       data, cache_size, ScriptCompiler::CachedData::BufferOwned));
   entry->refreshed = true;
+  ScheduleWrite(entry);
 }
 
+// A cache file that has yet to be written, with a copy of the cache, so
+// that the writer does not race with later refreshes of the entry.
+struct CompileCacheFileWrite {
+  std::string cache_filename;
+  std::string source_filename;
+  const char* type_name;
+  uint32_t code_size;
+  uint32_t code_hash;
+  std::unique_ptr<char[]> cache;
+  uint32_t cache_size;
+};
+
+// Writes cache files on a dedicated thread as soon as the entries are
+// produced, so that neither process shutdown nor module.flushCompileCache()
+// has to hash and write them all at once.
+class CompileCacheWriter {
+ public:
+  explicit CompileCacheWriter(bool is_debug) : is_debug_(is_debug) {}
+
+  ~CompileCacheWriter() {
+    {
+      Mutex::ScopedLock lock(mutex_);
+      // Whatever has not been started by now is dropped; the cache will be
+      // regenerated by a later run.
+      stopping_ = true;
+      pending_.clear();
+      work_cond_.Signal(lock);
+    }
+    if (thread_started_) CHECK_EQ(uv_thread_join(&thread_), 0);
+  }
+
+  void Schedule(std::unique_ptr<CompileCacheFileWrite> write) {
+    Mutex::ScopedLock lock(mutex_);
+    if (!thread_started_) {
+      thread_started_ =
+          uv_thread_create(&thread_, ThreadMain, this) == 0;
+      if (!thread_started_) {
+        // Fall back to writing on the calling thread.
+        Mutex::ScopedUnlock unlock(lock);
+        Write(*write);
+        return;
+      }
+    }
+    pending_.push_back(std::move(write));
+    work_cond_.Signal(lock);
+  }
+
+  // Waits for all scheduled writes to finish, but for no longer than
+  // |timeout_ms|. Returns false if the deadline was hit.
+  bool Flush(uint64_t timeout_ms) {
+    uint64_t deadline = uv_hrtime() + timeout_ms * 1000000;
+    Mutex::ScopedLock lock(mutex_);
+    while (!pending_.empty() || writing_) {
+      uint64_t now = uv_hrtime();
+      if (now >= deadline ||
+          done_cond_.TimedWait(lock, deadline - now) == UV_ETIMEDOUT) {
+        return pending_.empty() && !writing_;
+      }
+    }
+    return true;
+  }
+
+  void Write(const CompileCacheFileWrite& write) const;
+
+ private:
+  static void ThreadMain(void* arg) {
+    CompileCacheWriter* writer = static_cast<CompileCacheWriter*>(arg);
+    Mutex::ScopedLock lock(writer->mutex_);
+    while (!writer->stopping_) {
+      if (writer->pending_.empty()) {
+        writer->work_cond_.Wait(lock);
+        continue;
+      }
+      std::unique_ptr<CompileCacheFileWrite> write =
+          std::move(writer->pending_.front());
+      writer->pending_.pop_front();
+      writer->writing_ = true;
+      {
+        Mutex::ScopedUnlock unlock(lock);
+        writer->Write(*write);
+      }
+      writer->writing_ = false;
+      writer->done_cond_.Broadcast(lock);
+    }
+  }
+
+  template <typename... Args>
+  inline void Debug(const char* format, Args&&... args) const {
+    if (is_debug_) [[unlikely]] {
+      FPrintF(stderr, format, std::forward<Args>(args)...);
+    }
+  }
+
+  const bool is_debug_;
+  Mutex mutex_;  // Protects the fields below.
+  ConditionVariable work_cond_;
+  ConditionVariable done_cond_;
+  std::deque<std::unique_ptr<CompileCacheFileWrite>> pending_;
+  bool writing_ = false;
+  bool stopping_ = false;
+  bool thread_started_ = false;
+  uv_thread_t thread_;
+};
+
 /**
- * Persist the compile cache accumulated in memory to disk.
+ * Write a cache file to disk.
  *
  * To avoid race conditions, the cache file includes hashes of the original
  * source code and the cache content. It's first written to a temporary file
@@ -345,18 +942,170 @@ void CompileCacheHandler::MaybeSave(CompileCacheEntry* entry,
  *   [uint32_t] cache hash
  *   .... compile cache content ....
  */
+void CompileCacheWriter::Write(const CompileCacheFileWrite& write) const {
+  const char* type_name = write.type_name;
+  char* cache_ptr = write.cache.get();
+  uint32_t cache_size = write.cache_size;
+  uint32_t cache_hash = GetHash(cache_ptr, cache_size);
+
+  // Generating headers.
+  std::vector<uint32_t> headers(CompileCacheHandler::kHeaderCount);
+  headers[CompileCacheHandler::kMagicNumberOffset] = kCacheMagicNumber;
+  headers[CompileCacheHandler::kCodeSizeOffset] = write.code_size;
+  headers[CompileCacheHandler::kCacheSizeOffset] = cache_size;
+  headers[CompileCacheHandler::kCodeHashOffset] = write.code_hash;
+  headers[CompileCacheHandler::kCacheHashOffset] = cache_hash;
+
+  // Generate the temporary filename.
+  // The temporary file should be placed in a location like:
+  //
+  // $NODE_COMPILE_CACHE_DIR/v23.0.0-pre-arm64-5fad6d45-501/e7f8ef7f.cache.tcqrsK
+  //
+  // 1. $NODE_COMPILE_CACHE_DIR either comes from the $NODE_COMPILE_CACHE
+  // environment
+  //    variable or `module.enableCompileCache()`.
+  // 2. v23.0.0-pre-arm64-5fad6d45-501 is the sub cache directory and
+  //    e7f8ef7f is the hash for the cache (see
+  //    CompileCacheHandler::Enable()),
+  // 3. tcqrsK is generated by uv_fs_mkstemp() as a temporary identifier.
+  uv_fs_t mkstemp_req;
+  auto cleanup_mkstemp =
+      OnScopeLeave([&mkstemp_req]() { uv_fs_req_cleanup(&mkstemp_req); });
+  std::string cache_filename_tmp = write.cache_filename + ".XXXXXX";
+  Debug("[compile cache] Creating temporary file for cache of %s (%s)...",
+        write.source_filename,
+        type_name);
+  int err = uv_fs_mkstemp(
+      nullptr, &mkstemp_req, cache_filename_tmp.c_str(), nullptr);
+  if (err < 0) {
+    Debug("failed. %s\n", uv_strerror(err));
+    return;
+  }
+  Debug(" -> %s\n", mkstemp_req.path);
+  Debug("[compile cache] writing cache for %s %s to temporary file %s [%d "
+        "%d %d "
+        "%d %d]...",
+        type_name,
+        write.source_filename,
+        mkstemp_req.path,
+        headers[CompileCacheHandler::kMagicNumberOffset],
+        headers[CompileCacheHandler::kCodeSizeOffset],
+        headers[CompileCacheHandler::kCacheSizeOffset],
+        headers[CompileCacheHandler::kCodeHashOffset],
+        headers[CompileCacheHandler::kCacheHashOffset]);
+
+  // Write to the temporary file.
+  uv_buf_t headers_buf = uv_buf_init(reinterpret_cast<char*>(headers.data()),
+                                     headers.size() * sizeof(uint32_t));
+  uv_buf_t data_buf = uv_buf_init(cache_ptr, cache_size);
+  uv_buf_t bufs[] = {headers_buf, data_buf};
+
+  uv_fs_t write_req;
+  auto cleanup_write =
+      OnScopeLeave([&write_req]() { uv_fs_req_cleanup(&write_req); });
+  err = uv_fs_write(
+      nullptr, &write_req, mkstemp_req.result, bufs, 2, 0, nullptr);
+  if (err < 0) {
+    Debug("failed: %s\n", uv_strerror(err));
+    return;
+  }
+
+  uv_fs_t close_req;
+  auto cleanup_close =
+      OnScopeLeave([&close_req]() { uv_fs_req_cleanup(&close_req); });
+  err = uv_fs_close(nullptr, &close_req, mkstemp_req.result, nullptr);
+
+  if (err < 0) {
+    Debug("failed: %s\n", uv_strerror(err));
+    return;
+  }
+
+  Debug("success\n");
+
+  // Rename the temporary file to the actual cache file.
+  uv_fs_t rename_req;
+  auto cleanup_rename =
+      OnScopeLeave([&rename_req]() { uv_fs_req_cleanup(&rename_req); });
+  const std::string& cache_filename_final = write.cache_filename;
+  Debug("[compile cache] Renaming %s to %s...",
+        mkstemp_req.path,
+        cache_filename_final);
+  err = uv_fs_rename(nullptr,
+                     &rename_req,
+                     mkstemp_req.path,
+                     cache_filename_final.c_str(),
+                     nullptr);
+  if (err < 0) {
+    Debug("failed: %s\n", uv_strerror(err));
+    return;
+  }
+  Debug("success\n");
+}
+
+void CompileCacheHandler::WriteWasm(const CompileCacheEntry& entry,
+                                    bool is_debug,
+                                    const uint8_t* data,
+                                    size_t size) {
+  DCHECK_EQ(entry.type, CachedCodeType::kWasm);
+  if (size == 0 || size > UINT32_MAX) return;
+  CompileCacheFileWrite write;
+  write.cache_filename = entry.cache_filename;
+  write.source_filename = entry.source_filename;
+  write.type_name = entry.type_name();
+  write.code_size = entry.code_size;
+  write.code_hash = entry.code_hash;
+  write.cache_size = static_cast<uint32_t>(size);
+  write.cache.reset(new char[size]);
+  memcpy(write.cache.get(), data, size);
+  // Write on the calling thread, which is one of V8's workers.
+  CompileCacheWriter(is_debug).Write(write);
+}
+
+void CompileCacheHandler::ScheduleWrite(CompileCacheEntry* entry) {
+  if (!pack_filename_.empty()) return;  // Written as a whole by Persist().
+  DCHECK_NOT_NULL(entry->cache);
+
+  auto write = std::make_unique<CompileCacheFileWrite>();
+  write->cache_filename = entry->cache_filename;
+  write->source_filename = entry->source_filename;
+  write->type_name = entry->type_name();
+  write->code_size = entry->code_size;
+  write->code_hash = entry->code_hash;
+  write->cache_size = static_cast<uint32_t>(entry->cache->length);
+  write->cache.reset(new char[write->cache_size]);
+  memcpy(write->cache.get(), entry->cache->data, write->cache_size);
+
+  if (!writer_) writer_ = std::make_unique<CompileCacheWriter>(is_debug_);
+  Debug("[compile cache] scheduling write of cache for %s %s\n",
+        entry->type_name(),
+        entry->source_filename);
+  writer_->Schedule(std::move(write));
+  entry->persisted = true;
+}
+
+/**
+ * Persist the compile cache accumulated in memory to disk.
+ *
+ * Refreshed entries are normally handed to the background writer as soon
+ * as they are produced (see ScheduleWrite()), so this only schedules what
+ * is left and waits, for at most kPersistTimeoutMs, for the writes to
+ * finish.
+ */
 void CompileCacheHandler::Persist() {
   DCHECK(!compile_cache_dir_.empty());
 
-  // TODO(joyeecheung): do this using a separate event loop to utilize the
-  // libuv thread pool and do the file system operations concurrently.
-  // TODO(joyeecheung): Currently flushing is triggered by either process
-  // shutdown or user requests. In the future we should simply start the
-  // writes right after module loading on a separate thread, and this method
-  // only blocks until all the pending writes (if any) on the other thread are
-  // finished. In that case, the off-thread writes should finish long
-  // before any attempt of flushing is made so the method would then only
-  // incur a negligible overhead from thread synchronization.
+  if (!pack_filename_.empty()) {
+    PersistPack();
+    // The entries may point into the old pack, so drop them before
+    // mapping the new one.
+    Debug("[compile cache] Clear deserialized cache.\n");
+    compiler_cache_store_.clear();
+    warmup_.reset();
+    UnloadPack();
+    LoadPack();
+    return;
+  }
+
   for (auto& pair : compiler_cache_store_) {
     auto* entry = pair.second.get();
     const char* type_name = entry->type_name();
@@ -381,107 +1130,14 @@ void CompileCacheHandler::Persist() {
             entry->source_filename);
       continue;
     }
+    ScheduleWrite(entry);
+  }
 
-    DCHECK_EQ(entry->cache->buffer_policy,
-              ScriptCompiler::CachedData::BufferOwned);
-    char* cache_ptr =
-        reinterpret_cast<char*>(const_cast<uint8_t*>(entry->cache->data));
-    uint32_t cache_size = static_cast<uint32_t>(entry->cache->length);
-    uint32_t cache_hash = GetHash(cache_ptr, cache_size);
-
-    // Generating headers.
-    std::vector<uint32_t> headers(kHeaderCount);
-    headers[kMagicNumberOffset] = kCacheMagicNumber;
-    headers[kCodeSizeOffset] = entry->code_size;
-    headers[kCacheSizeOffset] = cache_size;
-    headers[kCodeHashOffset] = entry->code_hash;
-    headers[kCacheHashOffset] = cache_hash;
-
-    // Generate the temporary filename.
-    // The temporary file should be placed in a location like:
-    //
-    // $NODE_COMPILE_CACHE_DIR/v23.0.0-pre-arm64-5fad6d45-501/e7f8ef7f.cache.tcqrsK
-    //
-    // 1. $NODE_COMPILE_CACHE_DIR either comes from the $NODE_COMPILE_CACHE
-    // environment
-    //    variable or `module.enableCompileCache()`.
-    // 2. v23.0.0-pre-arm64-5fad6d45-501 is the sub cache directory and
-    //    e7f8ef7f is the hash for the cache (see
-    //    CompileCacheHandler::Enable()),
-    // 3. tcqrsK is generated by uv_fs_mkstemp() as a temporary identifier.
-    uv_fs_t mkstemp_req;
-    auto cleanup_mkstemp =
-        OnScopeLeave([&mkstemp_req]() { uv_fs_req_cleanup(&mkstemp_req); });
-    std::string cache_filename_tmp = entry->cache_filename + ".XXXXXX";
-    Debug("[compile cache] Creating temporary file for cache of %s (%s)...",
-          entry->source_filename,
-          type_name);
-    int err = uv_fs_mkstemp(
-        nullptr, &mkstemp_req, cache_filename_tmp.c_str(), nullptr);
-    if (err < 0) {
-      Debug("failed. %s\n", uv_strerror(err));
-      continue;
-    }
-    Debug(" -> %s\n", mkstemp_req.path);
-    Debug("[compile cache] writing cache for %s %s to temporary file %s [%d "
-          "%d %d "
-          "%d %d]...",
-          type_name,
-          entry->source_filename,
-          mkstemp_req.path,
-          headers[kMagicNumberOffset],
-          headers[kCodeSizeOffset],
-          headers[kCacheSizeOffset],
-          headers[kCodeHashOffset],
-          headers[kCacheHashOffset]);
-
-    // Write to the temporary file.
-    uv_buf_t headers_buf = uv_buf_init(reinterpret_cast<char*>(headers.data()),
-                                       headers.size() * sizeof(uint32_t));
-    uv_buf_t data_buf = uv_buf_init(cache_ptr, entry->cache->length);
-    uv_buf_t bufs[] = {headers_buf, data_buf};
-
-    uv_fs_t write_req;
-    auto cleanup_write =
-        OnScopeLeave([&write_req]() { uv_fs_req_cleanup(&write_req); });
-    err = uv_fs_write(
-        nullptr, &write_req, mkstemp_req.result, bufs, 2, 0, nullptr);
-    if (err < 0) {
-      Debug("failed: %s\n", uv_strerror(err));
-      continue;
-    }
-
-    uv_fs_t close_req;
-    auto cleanup_close =
-        OnScopeLeave([&close_req]() { uv_fs_req_cleanup(&close_req); });
-    err = uv_fs_close(nullptr, &close_req, mkstemp_req.result, nullptr);
-
-    if (err < 0) {
-      Debug("failed: %s\n", uv_strerror(err));
-      continue;
-    }
-
-    Debug("success\n");
-
-    // Rename the temporary file to the actual cache file.
-    uv_fs_t rename_req;
-    auto cleanup_rename =
-        OnScopeLeave([&rename_req]() { uv_fs_req_cleanup(&rename_req); });
-    std::string cache_filename_final = entry->cache_filename;
-    Debug("[compile cache] Renaming %s to %s...",
-          mkstemp_req.path,
-          cache_filename_final);
-    err = uv_fs_rename(nullptr,
-                       &rename_req,
-                       mkstemp_req.path,
-                       cache_filename_final.c_str(),
-                       nullptr);
-    if (err < 0) {
-      Debug("failed: %s\n", uv_strerror(err));
-      continue;
-    }
-    Debug("success\n");
-    entry->persisted = true;
+  if (writer_) {
+    Debug("[compile cache] waiting for pending writes...\n");
+    bool done = writer_->Flush(kPersistTimeoutMs);
+    Debug("[compile cache] %s\n",
+          done ? "all writes finished" : "timed out, skipping the rest");
   }
 
   // Clear the map at the end in one go instead of during the iteration to
@@ -492,6 +1148,7 @@ void CompileCacheHandler::Persist() {
 
 CompileCacheHandler::CompileCacheHandler(Environment* env)
     : isolate_(env->isolate()),
+      platform_(env->isolate_data()->platform()),
       is_debug_(
           env->enabled_debug_list()->enabled(DebugCategory::COMPILE_CACHE)) {}
 
@@ -499,6 +1156,7 @@ CompileCacheHandler::CompileCacheHandler(Environment* env)
 // - Compile cache directory (from NODE_COMPILE_CACHE)
 //   - $NODE_VERSION-$ARCH-$CACHE_DATA_VERSION_TAG-$UID
 //     - $FILENAME_AND_MODULE_TYPE_HASH.cache: a hash of filename + module type
+//     - pack: all entries in one file, with NODE_COMPILE_CACHE_PACKED=1
 CompileCacheEnableResult CompileCacheHandler::Enable(Environment* env,
                                                      const std::string& dir) {
   std::string cache_tag = GetCacheVersionTag();
@@ -548,6 +1206,22 @@ CompileCacheEnableResult CompileCacheHandler::Enable(Environment* env,
 
   result.cache_directory = absolute_cache_dir_base;
   compile_cache_dir_ = cache_dir_with_tag;
+
+  // With NODE_COMPILE_CACHE_PACKED=1, all entries are kept in a single
+  // file that is mapped into memory once, instead of one file per module.
+  std::string packed;
+  if (credentials::SafeGetenv("NODE_COMPILE_CACHE_PACKED", &packed, env) &&
+      packed == "1") {
+    pack_filename_ = compile_cache_dir_ + kPathSeparator + kPackFilename;
+    LoadPack();
+    // With NODE_COMPILE_CACHE_WARMUP=1, the entries that the last run used
+    // are prepared on worker threads before they are asked for.
+    std::string warmup;
+    if (credentials::SafeGetenv("NODE_COMPILE_CACHE_WARMUP", &warmup, env) &&
+        warmup == "1") {
+      StartWarmup();
+    }
+  }
   result.status = CompileCacheEnableStatus::ENABLED;
   return result;
 }
@@ -11,6 +11,8 @@
 #include "v8.h"
 
 namespace node {
+class CompileCacheWarmup;
+class CompileCacheWriter;
 class Environment;
 
 #define CACHED_CODE_TYPES(V)                                                   \
@@ -18,7 +20,9 @@ class Environment;
   V(kESM, 1)                                                                   \
   V(kStrippedTypeScript, 2)                                                    \
   V(kTransformedTypeScript, 3)                                                 \
-  V(kTransformedTypeScriptWithSourceMaps, 4)
+  V(kTransformedTypeScriptWithSourceMaps, 4)                                   \
+  V(kVmScript, 5)                                                              \
+  V(kWasm, 6)
 
 enum class CachedCodeType : uint8_t {
 #define V(type, value) type = value,
@@ -28,6 +32,9 @@ enum class CachedCodeType : uint8_t {
 
 struct CompileCacheEntry {
   std::unique_ptr<v8::ScriptCompiler::CachedData> cache{nullptr};
+  // Set when the cache was already deserialized off-thread by the warmup.
+  // Pass it along with the cache to V8 when compiling a script or module.
+  std::unique_ptr<v8::ScriptCompiler::ConsumeCodeCacheTask> consume_task;
   uint32_t cache_key;
   uint32_t code_hash;
   uint32_t code_size;
@@ -65,6 +72,7 @@ struct CompileCacheEnableResult {
 class CompileCacheHandler {
  public:
   explicit CompileCacheHandler(Environment* env);
+  ~CompileCacheHandler();
   CompileCacheEnableResult Enable(Environment* env, const std::string& dir);
 
   void Persist();
@@ -78,11 +86,52 @@ class CompileCacheHandler {
   void MaybeSave(CompileCacheEntry* entry,
                  v8::Local<v8::Module> mod,
                  bool rejected);
+  void MaybeSave(CompileCacheEntry* entry,
+                 v8::Local<v8::UnboundScript> script,
+                 bool rejected);
   void MaybeSave(CompileCacheEntry* entry, std::string_view transpiled);
   std::string_view cache_dir() { return compile_cache_dir_; }
 
+  // Hashes data that arrives in chunks, such as streamed WebAssembly bytes,
+  // the way the code of the entries is hashed. Start with a hash of 0.
+  static uint32_t ExtendHash(uint32_t hash, const uint8_t* data, size_t size);
+
+  // Reads the compiled code cached for the WebAssembly module with the given
+  // URL or file name and wire bytes. The cache of the returned entry is null
+  // on a miss. The handler does not keep WebAssembly entries; they are always
+  // stored in files of their own, even with the packed cache.
+  std::unique_ptr<CompileCacheEntry> ReadWasm(std::string_view name,
+                                              uint32_t code_hash,
+                                              uint32_t code_size);
+  // Writes a serialized WebAssembly module to the file of an entry returned
+  // by ReadWasm(). V8 hands out serializable modules on its worker threads,
+  // so this may be called on any thread, and after the handler is gone.
+  static void WriteWasm(const CompileCacheEntry& entry,
+                        bool is_debug,
+                        const uint8_t* data,
+                        size_t size);
+  bool is_debug() const { return is_debug_; }
+
  private:
+  // An entry in the index of the packed cache.
+  struct PackIndexEntry {
+    uint32_t cache_key;
+    uint32_t type;
+    uint32_t code_size;
+    uint32_t code_hash;
+    uint32_t cache_size;
+    uint32_t cache_hash;
+    uint64_t offset;
+  };
+
   void ReadCacheFile(CompileCacheEntry* entry);
+  void LoadPack();
+  void UnloadPack();
+  void ReadFromPack(CompileCacheEntry* entry);
+  void PersistPack();
+  void StartWarmup();
+  // Hands a copy of the entry to the background writer.
+  void ScheduleWrite(CompileCacheEntry* entry);
 
   template <typename T>
   void MaybeSaveImpl(CompileCacheEntry* entry,
@@ -92,6 +141,9 @@ class CompileCacheHandler {
   template <typename... Args>
   inline void Debug(const char* format, Args&&... args) const;
 
+  // How long Persist() waits for pending background writes.
+  static constexpr uint64_t kPersistTimeoutMs = 1000;
+
   static constexpr size_t kMagicNumberOffset = 0;
   static constexpr size_t kCodeSizeOffset = 1;
   static constexpr size_t kCacheSizeOffset = 2;
@@ -99,12 +151,36 @@ class CompileCacheHandler {
   static constexpr size_t kCacheHashOffset = 4;
   static constexpr size_t kHeaderCount = 5;
 
+  static constexpr size_t kPackEntryCountOffset = 1;
+  static constexpr size_t kPackIndexHashOffset = 2;
+  static constexpr size_t kPackHeaderCount = 4;
+  static constexpr size_t kPackHeaderSize = kPackHeaderCount * sizeof(uint32_t);
+  // Set in PackIndexEntry::type for entries used by the run that wrote the
+  // pack.
+  static constexpr uint32_t kPackEntryUsedFlag = 1u << 31;
+
   v8::Isolate* isolate_ = nullptr;
+  v8::Platform* platform_ = nullptr;
   bool is_debug_ = false;
 
   std::string compile_cache_dir_;
   std::unordered_map<uint32_t, std::unique_ptr<CompileCacheEntry>>
       compiler_cache_store_;
+
+  // Set when the packed cache is used instead of one file per entry.
+  std::string pack_filename_;
+  // The contents of the pack, mapped into memory (or, on Windows, read
+  // into pack_buffer_), and its index.
+  const uint8_t* pack_data_ = nullptr;
+  size_t pack_size_ = 0;
+  std::unique_ptr<uint8_t[]> pack_buffer_;
+  std::unordered_map<uint32_t, const PackIndexEntry*> pack_index_;
+
+  std::unique_ptr<CompileCacheWarmup> warmup_;
+  std::unique_ptr<CompileCacheWriter> writer_;
+
+  friend class CompileCacheWarmup;
+  friend class CompileCacheWriter;
 };
 }  // namespace node
 
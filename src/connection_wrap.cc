@@ -10,12 +10,16 @@
 
 namespace node {
 
+using v8::Array;
 using v8::Boolean;
 using v8::Context;
+using v8::FunctionCallbackInfo;
 using v8::HandleScope;
 using v8::Integer;
 using v8::Local;
+using v8::LocalVector;
 using v8::Object;
+using v8::Uint32;
 using v8::Value;
 
 
@@ -63,9 +67,16 @@ void ConnectionWrap<WrapType, UVType>::OnConnection(uv_stream_t* handle,
     if (uv_accept(handle, client))
       return;
 
+    if (wrap_data->accept_batch_size_ > 0) {
+      wrap_data->QueueAcceptedConnection(BaseObjectPtr<WrapType>(wrap));
+      return;
+    }
+
     // Successful accept. Call the onconnection callback in JavaScript land.
     client_handle = client_obj;
   } else {
+    // Connections accepted before the error are reported first.
+    wrap_data->FlushAcceptedConnections();
     client_handle = Undefined(env->isolate());
   }
 
@@ -74,6 +85,67 @@ void ConnectionWrap<WrapType, UVType>::OnConnection(uv_stream_t* handle,
 }
 
 
+template <typename WrapType, typename UVType>
+void ConnectionWrap<WrapType, UVType>::SetAcceptBatchSize(
+    const FunctionCallbackInfo<Value>& args) {
+  WrapType* wrap;
+  ASSIGN_OR_RETURN_UNWRAP(&wrap, args.This());
+  CHECK(args[0]->IsUint32());
+  wrap->accept_batch_size_ = args[0].As<Uint32>()->Value();
+  if (wrap->accept_batch_size_ == 0) wrap->FlushAcceptedConnections();
+}
+
+
+template <typename WrapType, typename UVType>
+void ConnectionWrap<WrapType, UVType>::QueueAcceptedConnection(
+    BaseObjectPtr<WrapType> client) {
+  accepted_connections_.push_back(std::move(client));
+  if (accepted_connections_.size() >= accept_batch_size_) {
+    FlushAcceptedConnections();
+    return;
+  }
+
+  // libuv keeps accepting until the listen queue is empty before it returns
+  // to the event loop, so an immediate runs once the queue has been drained.
+  if (accept_flush_scheduled_) return;
+  accept_flush_scheduled_ = true;
+  BaseObjectPtr<WrapType> strong_ref{static_cast<WrapType*>(this)};
+  env()->SetImmediate([strong_ref](Environment* env) {
+    strong_ref->accept_flush_scheduled_ = false;
+    strong_ref->FlushAcceptedConnections();
+  });
+}
+
+
+template <typename WrapType, typename UVType>
+void ConnectionWrap<WrapType, UVType>::FlushAcceptedConnections() {
+  if (accepted_connections_.empty()) return;
+
+  std::vector<BaseObjectPtr<WrapType>> clients;
+  clients.swap(accepted_connections_);
+
+  // The server may have been closed since the connections were accepted;
+  // nobody is listening for them anymore.
+  if (IsHandleClosing()) {
+    for (const auto& client : clients) client->Close();
+    return;
+  }
+
+  Environment* env = this->env();
+  HandleScope handle_scope(env->isolate());
+  Context::Scope context_scope(env->context());
+
+  LocalVector<Value> handles(env->isolate());
+  handles.reserve(clients.size());
+  for (const auto& client : clients) handles.push_back(client->object());
+
+  Local<Value> argv[] = {
+      Integer::New(env->isolate(), 0),
+      Array::New(env->isolate(), handles.data(), handles.size())};
+  MakeCallback(env->onconnectionbatch_string(), arraysize(argv), argv);
+}
+
+
 template <typename WrapType, typename UVType>
 void ConnectionWrap<WrapType, UVType>::AfterConnect(uv_connect_t* req,
                                                     int status) {
@@ -132,6 +204,12 @@ template void ConnectionWrap<PipeWrap, uv_pipe_t>::OnConnection(
 template void ConnectionWrap<TCPWrap, uv_tcp_t>::OnConnection(
     uv_stream_t* handle, int status);
 
+template void ConnectionWrap<PipeWrap, uv_pipe_t>::SetAcceptBatchSize(
+    const FunctionCallbackInfo<Value>& args);
+
+template void ConnectionWrap<TCPWrap, uv_tcp_t>::SetAcceptBatchSize(
+    const FunctionCallbackInfo<Value>& args);
+
 template void ConnectionWrap<PipeWrap, uv_pipe_t>::AfterConnect(
     uv_connect_t* handle, int status);
 
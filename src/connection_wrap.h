@@ -5,6 +5,8 @@
 
 #include "stream_wrap.h"
 
+#include <vector>
+
 namespace node {
 
 class Environment;
@@ -15,12 +17,27 @@ class ConnectionWrap : public LibuvStreamWrap {
   static void OnConnection(uv_stream_t* handle, int status);
   static void AfterConnect(uv_connect_t* req, int status);
 
+  // setAcceptBatchSize(n): with n > 0, connections accepted while libuv
+  // drains the listen queue are gathered and delivered to JS together, at
+  // the latest once n are pending, through onconnectionbatch(status, handles).
+  // n = 0 restores one onconnection() call per connection.
+  static void SetAcceptBatchSize(
+      const v8::FunctionCallbackInfo<v8::Value>& args);
+
  protected:
   ConnectionWrap(Environment* env,
                  v8::Local<v8::Object> object,
                  ProviderType provider);
 
   UVType handle_;
+
+ private:
+  void QueueAcceptedConnection(BaseObjectPtr<WrapType> client);
+  void FlushAcceptedConnections();
+
+  uint32_t accept_batch_size_ = 0;
+  bool accept_flush_scheduled_ = false;
+  std::vector<BaseObjectPtr<WrapType>> accepted_connections_;
 };
 
 }  // namespace node
@@ -0,0 +1,28 @@
+#ifndef SRC_CPPGC_ASYNC_WRAP_INL_H_
+#define SRC_CPPGC_ASYNC_WRAP_INL_H_
+
+#if defined(NODE_WANT_INTERNALS) && NODE_WANT_INTERNALS
+
+#include "cppgc_async_wrap.h"
+#include "cppgc_helpers-inl.h"
+
+namespace node {
+
+template <typename T>
+void CppgcAsyncWrap::Wrap(T* ptr,
+                          Environment* env,
+                          v8::Local<v8::Object> obj,
+                          ProviderType provider) {
+  // CppgcMixin::Wrap() stores the T*, which GetAsyncId() and
+  // GetProviderType() read back as a CppgcAsyncWrap*.
+  CHECK_EQ(static_cast<void*>(static_cast<CppgcAsyncWrap*>(ptr)),
+           static_cast<void*>(ptr));
+  CppgcMixin::Wrap(ptr, env, obj);
+  ptr->AsyncInit(env, obj, provider);
+}
+
+}  // namespace node
+
+#endif  // defined(NODE_WANT_INTERNALS) && NODE_WANT_INTERNALS
+
+#endif  // SRC_CPPGC_ASYNC_WRAP_INL_H_
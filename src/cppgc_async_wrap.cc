@@ -0,0 +1,140 @@
+#include "cppgc_async_wrap.h"  // NOLINT(build/include_inline)
+#include "async_context_frame.h"
+#include "async_wrap-inl.h"
+#include "cppgc_async_wrap-inl.h"
+#include "env-inl.h"
+#include "node_external_reference.h"
+#include "node_internals.h"
+#include "util-inl.h"
+
+namespace node {
+
+using v8::FunctionCallbackInfo;
+using v8::FunctionTemplate;
+using v8::Isolate;
+using v8::Local;
+using v8::MaybeLocal;
+using v8::Name;
+using v8::Object;
+using v8::Undefined;
+using v8::Value;
+
+void CppgcAsyncWrap::AsyncInit(Environment* env,
+                               Local<Object> obj,
+                               ProviderType provider) {
+  CHECK_NE(provider, AsyncWrap::PROVIDER_NONE);
+  provider_type_ = provider;
+  AsyncWrapCounters* counters = env->async_wrap_counters();
+  if (counters->enabled()) {
+    counters->Created(provider);
+    counted_ = true;
+  }
+
+  async_id_ = env->new_async_id();
+  trigger_async_id_ = env->get_default_trigger_async_id();
+  AsyncWrap::EmitTraceEventInit(env, provider, async_id_, trigger_async_id_);
+
+  Isolate* isolate = env->isolate();
+  Local<Value> frame = async_context_frame::current(isolate);
+  if (!frame.IsEmpty() && !frame->IsUndefined())
+    context_frame_.Reset(isolate, frame);
+
+  AsyncWrap::EmitAsyncInit(env,
+                           obj,
+                           env->async_hooks()->provider_string(provider),
+                           async_id_,
+                           trigger_async_id_);
+}
+
+MaybeLocal<Value> CppgcAsyncWrap::MakeCallback(const Local<v8::Function> cb,
+                                               int argc,
+                                               Local<Value>* argv) {
+  Environment* env = this->env();
+  ProviderType provider = provider_type_;
+  async_context context{async_id_, trigger_async_id_};
+  AsyncWrap::EmitTraceEventBefore(provider, context.async_id);
+  MaybeLocal<Value> ret =
+      InternalMakeCallback(env,
+                           object(),
+                           object(),
+                           cb,
+                           argc,
+                           argv,
+                           context,
+                           context_frame_.Get(env->isolate()));
+  // The callback may have run EmitDestroy().
+  AsyncWrap::EmitTraceEventAfter(provider, context.async_id);
+  return ret;
+}
+
+MaybeLocal<Value> CppgcAsyncWrap::MakeCallback(const Local<Name> symbol,
+                                               int argc,
+                                               Local<Value>* argv) {
+  Environment* env = this->env();
+  Local<Value> cb_v;
+  if (!object()->Get(env->context(), symbol).ToLocal(&cb_v))
+    return MaybeLocal<Value>();
+  if (!cb_v->IsFunction()) return Undefined(env->isolate());
+  return MakeCallback(cb_v.As<v8::Function>(), argc, argv);
+}
+
+void CppgcAsyncWrap::EmitDestroy() {
+  if (async_id_ == AsyncWrap::kInvalidAsyncId) return;
+  Environment* env = this->env();
+  AsyncWrap::EmitTraceEventDestroy(provider_type_, async_id_);
+  AsyncWrap::EmitDestroy(env, async_id_);
+  async_id_ = AsyncWrap::kInvalidAsyncId;
+  if (counted_) {
+    env->async_wrap_counters()->Destroyed(provider_type_);
+    counted_ = false;
+  }
+}
+
+void CppgcAsyncWrap::Trace(cppgc::Visitor* visitor) const {
+  CppgcMixin::Trace(visitor);
+  visitor->Trace(context_frame_);
+}
+
+void CppgcAsyncWrap::Clean(Realm* realm) {
+  EmitDestroy();
+}
+
+CppgcAsyncWrap::~CppgcAsyncWrap() {
+  this->Finalize();
+}
+
+void CppgcAsyncWrap::GetAsyncId(const FunctionCallbackInfo<Value>& args) {
+  CppgcAsyncWrap* wrap;
+  args.GetReturnValue().Set(AsyncWrap::kInvalidAsyncId);
+  ASSIGN_OR_RETURN_UNWRAP_CPPGC(&wrap, args.This());
+  args.GetReturnValue().Set(wrap->get_async_id());
+}
+
+void CppgcAsyncWrap::GetProviderType(const FunctionCallbackInfo<Value>& args) {
+  CppgcAsyncWrap* wrap;
+  args.GetReturnValue().Set(AsyncWrap::PROVIDER_NONE);
+  ASSIGN_OR_RETURN_UNWRAP_CPPGC(&wrap, args.This());
+  args.GetReturnValue().Set(wrap->provider_type());
+}
+
+Local<FunctionTemplate> CppgcAsyncWrap::GetConstructorTemplate(
+    IsolateData* isolate_data) {
+  Local<FunctionTemplate> tmpl = isolate_data->cppgc_async_wrap_ctor_template();
+  if (tmpl.IsEmpty()) {
+    Isolate* isolate = isolate_data->isolate();
+    tmpl = NewFunctionTemplate(isolate, nullptr);
+    tmpl->SetClassName(FIXED_ONE_BYTE_STRING(isolate, "AsyncWrap"));
+    SetProtoMethod(isolate, tmpl, "getAsyncId", GetAsyncId);
+    SetProtoMethod(isolate, tmpl, "getProviderType", GetProviderType);
+    isolate_data->set_cppgc_async_wrap_ctor_template(tmpl);
+  }
+  return tmpl;
+}
+
+void CppgcAsyncWrap::RegisterExternalReferences(
+    ExternalReferenceRegistry* registry) {
+  registry->Register(GetAsyncId);
+  registry->Register(GetProviderType);
+}
+
+}  // namespace node
@@ -0,0 +1,104 @@
+#ifndef SRC_CPPGC_ASYNC_WRAP_H_
+#define SRC_CPPGC_ASYNC_WRAP_H_
+
+#if defined(NODE_WANT_INTERNALS) && NODE_WANT_INTERNALS
+
+#include "async_wrap.h"
+#include "cppgc_helpers.h"
+#include "v8.h"
+
+namespace node {
+
+class Environment;
+class ExternalReferenceRegistry;
+class IsolateData;
+class Realm;
+
+/**
+ * The async_hooks part of AsyncWrap for wrappers managed by cppgc. Requests
+ * that are created for every operation, like QueryWrap, are traced together
+ * with their JS objects this way, instead of holding a weak BaseObject handle
+ * that V8 has to process in every scavenge.
+ *
+ * The cppgc::GarbageCollected base comes first, so a subclass has to extend
+ * CppgcAsyncWrap alone. This keeps CppgcAsyncWrap at the start of every
+ * wrapper, which lets the methods on GetConstructorTemplate() unwrap any of
+ * them.
+ *
+ * class MyReqWrap final : public CppgcAsyncWrap {
+ *  public:
+ *   SET_CPPGC_NAME(MyReqWrap)
+ *   MyReqWrap(Environment* env, v8::Local<v8::Object> object) {
+ *     CppgcAsyncWrap::Wrap(this, env, object, AsyncWrap::PROVIDER_...);
+ *   }
+ *   void Trace(cppgc::Visitor* visitor) const final {
+ *     CppgcAsyncWrap::Trace(visitor);
+ *   }
+ * };
+ *
+ * The destroy hook does not wait for the garbage collector, as it does for an
+ * AsyncWrap. The subclass calls EmitDestroy() once the request is done, and
+ * Clean() calls it if the Realm goes away first. A subclass that overrides
+ * Clean() has to call CppgcAsyncWrap::Clean() from there, and this->Finalize()
+ * from its destructor.
+ */
+class CppgcAsyncWrap : public cppgc::GarbageCollected<CppgcAsyncWrap>,
+                       public cppgc::NameProvider,
+                       public CppgcMixin {
+ public:
+  using ProviderType = AsyncWrap::ProviderType;
+
+  // Like CppgcMixin::Wrap(), and then runs the init hooks for |provider|.
+  template <typename T>
+  static inline void Wrap(T* ptr,
+                          Environment* env,
+                          v8::Local<v8::Object> obj,
+                          ProviderType provider);
+
+  // Provides getAsyncId() and getProviderType() like the AsyncWrap template.
+  // There is no asyncReset(), since these wrappers are not reused.
+  static v8::Local<v8::FunctionTemplate> GetConstructorTemplate(
+      IsolateData* isolate_data);
+  static void RegisterExternalReferences(ExternalReferenceRegistry* registry);
+
+  static void GetAsyncId(const v8::FunctionCallbackInfo<v8::Value>& args);
+  static void GetProviderType(const v8::FunctionCallbackInfo<v8::Value>& args);
+
+  ProviderType provider_type() const { return provider_type_; }
+  double get_async_id() const { return async_id_; }
+  double get_trigger_async_id() const { return trigger_async_id_; }
+
+  // Only call these within a valid HandleScope.
+  v8::MaybeLocal<v8::Value> MakeCallback(const v8::Local<v8::Function> cb,
+                                         int argc,
+                                         v8::Local<v8::Value>* argv);
+  v8::MaybeLocal<v8::Value> MakeCallback(const v8::Local<v8::Name> symbol,
+                                         int argc,
+                                         v8::Local<v8::Value>* argv);
+
+  // Runs the destroy hooks. Does nothing after the first call.
+  void EmitDestroy();
+
+  void Trace(cppgc::Visitor* visitor) const override;
+  void Clean(Realm* realm) override;
+
+  ~CppgcAsyncWrap() override;
+
+ private:
+  void AsyncInit(Environment* env,
+                 v8::Local<v8::Object> obj,
+                 ProviderType provider);
+
+  ProviderType provider_type_ = AsyncWrap::PROVIDER_NONE;
+  // Whether the creation was counted by the Environment's AsyncWrapCounters.
+  bool counted_ = false;
+  double async_id_ = AsyncWrap::kInvalidAsyncId;
+  double trigger_async_id_ = AsyncWrap::kInvalidAsyncId;
+  v8::TracedReference<v8::Value> context_frame_;
+};
+
+}  // namespace node
+
+#endif  // defined(NODE_WANT_INTERNALS) && NODE_WANT_INTERNALS
+
+#endif  // SRC_CPPGC_ASYNC_WRAP_H_
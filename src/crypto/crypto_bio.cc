@@ -29,6 +29,15 @@
 #include <climits>
 #include <cstring>
 
+#ifdef NODE_HAVE_KTLS
+#include <linux/tls.h>
+
+// The internal BIO controls of OpenSSL's include/internal/bio.h.
+#define BIO_CTRL_SET_KTLS 72
+#define BIO_CTRL_SET_KTLS_TX_SEND_CTRL_MSG 74
+#define BIO_CTRL_CLEAR_KTLS_TX_CTRL_MSG 75
+#endif  // NODE_HAVE_KTLS
+
 namespace node {
 
 using ncrypto::BIOPointer;
@@ -133,6 +142,10 @@ size_t NodeBIO::PeekMultiple(char** out, size_t* size, size_t* count) {
 int NodeBIO::Write(BIO* bio, const char* data, int len) {
   BIO_clear_retry_flags(bio);
 
+#ifdef NODE_HAVE_KTLS
+  if (FromBIO(bio)->ktls_record_type_ != 0)
+    return FromBIO(bio)->WriteKTLSRecord(bio, data, len);
+#endif  // NODE_HAVE_KTLS
   FromBIO(bio)->Write(data, len);
 
   return len;
@@ -209,9 +222,34 @@ long NodeBIO::Ctrl(BIO* bio, int cmd, long num,  // NOLINT(runtime/int)
       ret = nbio->Length();
       break;
     case BIO_CTRL_DUP:
+      ret = 1;
+      break;
     case BIO_CTRL_FLUSH:
       ret = 1;
+#ifdef NODE_HAVE_KTLS
+      // OpenSSL flushes before a record that is sent on its own, see
+      // WriteKTLSRecord().
+      BIO_clear_retry_flags(bio);
+      if (nbio->ktls_send_ && !nbio->ktls_socket_->FlushForKTLS(nbio)) {
+        BIO_set_retry_write(bio);
+        ret = 0;
+      }
+#endif  // NODE_HAVE_KTLS
+      break;
+#ifdef NODE_HAVE_KTLS
+    case BIO_CTRL_SET_KTLS:
+      ret = nbio->StartKTLS(num, ptr);
+      break;
+    case BIO_CTRL_GET_KTLS_SEND:
+      ret = nbio->ktls_send_;
       break;
+    case BIO_CTRL_SET_KTLS_TX_SEND_CTRL_MSG:
+      nbio->ktls_record_type_ = num;
+      break;
+    case BIO_CTRL_CLEAR_KTLS_TX_CTRL_MSG:
+      nbio->ktls_record_type_ = 0;
+      break;
+#endif  // NODE_HAVE_KTLS
     case BIO_CTRL_PUSH:
     case BIO_CTRL_POP:
     default:
@@ -222,6 +260,69 @@ long NodeBIO::Ctrl(BIO* bio, int cmd, long num,  // NOLINT(runtime/int)
 }
 
 
+#ifdef NODE_HAVE_KTLS
+namespace {
+
+size_t CryptoInfoSize(const tls_crypto_info* info) {
+  switch (info->cipher_type) {
+    case TLS_CIPHER_AES_GCM_128:
+      return sizeof(tls12_crypto_info_aes_gcm_128);
+#ifdef TLS_CIPHER_AES_GCM_256
+    case TLS_CIPHER_AES_GCM_256:
+      return sizeof(tls12_crypto_info_aes_gcm_256);
+#endif
+#ifdef TLS_CIPHER_AES_CCM_128
+    case TLS_CIPHER_AES_CCM_128:
+      return sizeof(tls12_crypto_info_aes_ccm_128);
+#endif
+#ifdef TLS_CIPHER_CHACHA20_POLY1305
+    case TLS_CIPHER_CHACHA20_POLY1305:
+      return sizeof(tls12_crypto_info_chacha20_poly1305);
+#endif
+    default:
+      return 0;
+  }
+}
+
+}  // anonymous namespace
+
+// OpenSSL asks for this once the keys for application data are in place,
+// after flushing the BIO. Returning 0 makes it keep encrypting itself. The
+// receive side is not offloaded, since TLSWrap reads through the stream.
+long NodeBIO::StartKTLS(long is_tx, void* crypto_info) {  // NOLINT
+  if (!is_tx || ktls_socket_ == nullptr || ktls_send_) return 0;
+  const size_t size =
+      CryptoInfoSize(static_cast<const tls_crypto_info*>(crypto_info));
+  if (size == 0) {
+    ktls_error_ = ENOTSUP;
+    return 0;
+  }
+  // What OpenSSL has encrypted so far must reach the socket first.
+  if (!ktls_socket_->FlushForKTLS(this)) {
+    ktls_error_ = EAGAIN;
+    return 0;
+  }
+  ktls_error_ = ktls_socket_->StartKTLS(crypto_info, size);
+  ktls_send_ = ktls_error_ == 0;
+  return ktls_send_;
+}
+
+// Alerts, and handshake messages such as session tickets, are sent right
+// away as records of their own. OpenSSL has flushed the BIO before.
+int NodeBIO::WriteKTLSRecord(BIO* bio, const char* data, int len) {
+  CHECK_EQ(Length(), 0);
+  const ssize_t written =
+      ktls_socket_->SendKTLSRecord(ktls_record_type_, data, len);
+  if (written < 0) {
+    if (written == -EAGAIN) BIO_set_retry_write(bio);
+    return -1;
+  }
+  if (written == len) ktls_record_type_ = 0;
+  return static_cast<int>(written);
+}
+#endif  // NODE_HAVE_KTLS
+
+
 const BIO_METHOD* NodeBIO::GetMethod() {
   // Static initialization ensures that this is safe to use concurrently.
   static const BIO_METHOD* method = [&]() {
@@ -26,9 +26,18 @@
 
 #include "node_crypto.h"
 #include "openssl/bio.h"
+#include "openssl/opensslv.h"
 #include "util.h"
 #include "v8.h"
 
+// OpenSSL hands the encryption of outgoing records to a Linux kTLS socket
+// through controls on the write BIO, which NodeBIO implements for the socket
+// under a TLSWrap. Builds with the bundled OpenSSL define OPENSSL_NO_KTLS.
+#if defined(__linux__) && OPENSSL_VERSION_MAJOR >= 3 && \
+    !defined(OPENSSL_NO_KTLS)
+#define NODE_HAVE_KTLS 1
+#endif
+
 namespace node {
 
 class Environment;
@@ -125,6 +134,31 @@ class NodeBIO : public MemoryRetainer {
 
   static NodeBIO* FromBIO(BIO* bio);
 
+#ifdef NODE_HAVE_KTLS
+  // The socket that the bytes of a write BIO end up on.
+  class KTLSSocket {
+   public:
+    virtual ~KTLSSocket() = default;
+    // Writes the bytes of |bio| to the socket without waiting, and returns
+    // false if some are left, or if earlier writes are still in flight.
+    virtual bool FlushForKTLS(NodeBIO* bio) = 0;
+    // Has the kernel encrypt all that is written from now on, with the
+    // struct tls12_crypto_info_* at |crypto_info|. Returns 0 or an errno.
+    virtual int StartKTLS(const void* crypto_info, size_t size) = 0;
+    // Sends a record of a type other than application data, which the kernel
+    // only frames as such when told so. Returns the bytes sent, or -errno.
+    virtual ssize_t SendKTLSRecord(uint8_t record_type,
+                                   const char* data,
+                                   size_t size) = 0;
+  };
+
+  // Lets OpenSSL offload to |socket| once SSL_OP_ENABLE_KTLS is set.
+  inline void set_ktls_socket(KTLSSocket* socket) { ktls_socket_ = socket; }
+  inline bool ktls_send() const { return ktls_send_; }
+  // Why the kernel does not encrypt, if OpenSSL asked it to.
+  inline int ktls_error() const { return ktls_error_; }
+#endif  // NODE_HAVE_KTLS
+
   void MemoryInfo(MemoryTracker* tracker) const override {
     tracker->TrackFieldWithSize("buffer", length_, "NodeBIO::Buffer");
   }
@@ -144,6 +178,11 @@ class NodeBIO : public MemoryRetainer {
 
   static const BIO_METHOD* GetMethod();
 
+#ifdef NODE_HAVE_KTLS
+  long StartKTLS(long is_tx, void* crypto_info);  // NOLINT(runtime/int)
+  int WriteKTLSRecord(BIO* bio, const char* data, int len);
+#endif  // NODE_HAVE_KTLS
+
   // Enough to handle the most of the client hellos
   static const size_t kInitialBufferLength = 1024;
   static const size_t kThroughputBufferLength = 16384;
@@ -183,6 +222,13 @@ class NodeBIO : public MemoryRetainer {
   int eof_return_ = -1;
   Buffer* read_head_ = nullptr;
   Buffer* write_head_ = nullptr;
+#ifdef NODE_HAVE_KTLS
+  KTLSSocket* ktls_socket_ = nullptr;
+  bool ktls_send_ = false;
+  int ktls_error_ = 0;
+  // The type of the record that the next write is, if it is not data.
+  int ktls_record_type_ = 0;
+#endif  // NODE_HAVE_KTLS
 };
 
 }  // namespace crypto
@@ -232,6 +232,7 @@ void CipherBase::Initialize(Environment* env, Local<Object> target) {
   t->InstanceTemplate()->SetInternalFieldCount(CipherBase::kInternalFieldCount);
 
   SetProtoMethod(isolate, t, "update", Update);
+  SetProtoMethod(isolate, t, "updateInto", UpdateInto);
   SetProtoMethod(isolate, t, "final", Final);
   SetProtoMethod(isolate, t, "setAutoPadding", SetAutoPadding);
   SetProtoMethodNoSideEffect(isolate, t, "getAuthTag", GetAuthTag);
@@ -274,6 +275,7 @@ void CipherBase::RegisterExternalReferences(
   registry->Register(New);
 
   registry->Register(Update);
+  registry->Register(UpdateInto);
   registry->Register(Final);
   registry->Register(SetAutoPadding);
   registry->Register(GetAuthTag);
@@ -681,6 +683,8 @@ CipherBase::UpdateResult CipherBase::Update(
       buffer, static_cast<unsigned char*>((*out)->Data()), &buf_len);
 
   CHECK_LE(static_cast<size_t>(buf_len), (*out)->ByteLength());
+  if (r && !ctx_.isWrapMode())
+    buffered_bytes_ = buffered_bytes_ + len - buf_len;
   if (buf_len == 0) {
     *out = ArrayBuffer::NewBackingStore(env()->isolate(), 0);
   } else if (static_cast<size_t>(buf_len) != (*out)->ByteLength()) {
@@ -732,6 +736,103 @@ void CipherBase::Update(const FunctionCallbackInfo<Value>& args) {
       });
 }
 
+// Like Update(), but writes into caller-provided memory, which may be the
+// input itself. OpenSSL supports exact in-place operation, but not partially
+// overlapping buffers. Key wrap ciphers are not supported because they
+// need to know the size of the whole output up front.
+// In-place operation only avoids copying the input while OpenSSL holds no
+// bytes back from earlier calls. That is always the case for stream-like
+// modes such as GCM or CTR, and for block modes as long as every chunk is a
+// multiple of the block size; decrypting with padding holds back the last
+// block of every chunk, so only the first chunk is decrypted without a copy.
+// Otherwise the output for this input starts with the held-back bytes and
+// would overwrite input that has not been read yet, so the input is copied
+// first.
+CipherBase::UpdateResult CipherBase::UpdateInto(const char* data,
+                                                size_t len,
+                                                unsigned char* out,
+                                                size_t out_len,
+                                                int* written) {
+  if (!ctx_ || len > INT_MAX || ctx_.isWrapMode()) return kErrorState;
+  MarkPopErrorOnReturn mark_pop_error_on_return;
+
+  if (ctx_.isCcmMode() && !CheckCCMMessageLength(len)) {
+    return kErrorMessageSize;
+  }
+
+  // EVP_CipherUpdate() may emit up to block_size - 1 bytes buffered from
+  // previous calls in addition to the input.
+  const int block_size = ctx_.getBlockSize();
+  CHECK_GT(block_size, 0);
+  if (len + block_size - 1 > out_len) return kErrorOutputSize;
+
+  ncrypto::Buffer<const unsigned char> buffer = {
+      .data = reinterpret_cast<const unsigned char*>(data),
+      .len = len,
+  };
+  MaybeStackBuffer<unsigned char, 1024> copy;
+  if (buffered_bytes_ != 0 && len > 0 && out == buffer.data) {
+    copy.AllocateSufficientStorage(len);
+    memcpy(copy.out(), data, len);
+    buffer.data = copy.out();
+  }
+  *written = 0;
+  bool r = ctx_.update(buffer, out, written);
+  CHECK_LE(static_cast<size_t>(*written), out_len);
+  if (r) {
+    buffered_bytes_ += len;
+    buffered_bytes_ -= static_cast<size_t>(*written);
+  }
+
+  if (!r && kind_ == kDecipher && ctx_.isCcmMode()) {
+    pending_auth_failed_ = true;
+    return kSuccess;
+  }
+  return r == 1 ? kSuccess : kErrorState;
+}
+
+// updateInto(input, output) returns the number of bytes written to output.
+void CipherBase::UpdateInto(const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+  CipherBase* cipher;
+  ASSIGN_OR_RETURN_UNWRAP(&cipher, args.This());
+  MarkPopErrorOnReturn mark_pop_error_on_return;
+
+  SPREAD_BUFFER_ARG(args[0], input);
+  SPREAD_BUFFER_ARG(args[1], output);
+
+  if (input_length > INT_MAX) [[unlikely]] {
+    return THROW_ERR_OUT_OF_RANGE(env, "data is too long");
+  }
+  if (output_data != input_data && input_length > 0 && output_length > 0 &&
+      output_data < input_data + input_length &&
+      input_data < output_data + output_length) [[unlikely]] {
+    return THROW_ERR_INVALID_ARG_VALUE(
+        env, "output must either be the input or not overlap with it");
+  }
+
+  int written;
+  UpdateResult r =
+      cipher->UpdateInto(input_data,
+                         input_length,
+                         reinterpret_cast<unsigned char*>(output_data),
+                         output_length,
+                         &written);
+
+  switch (r) {
+    case kSuccess:
+      return args.GetReturnValue().Set(written);
+    case kErrorOutputSize:
+      return THROW_ERR_OUT_OF_RANGE(env, "output buffer is too small");
+    case kErrorState:
+      return ThrowCryptoError(env,
+                              mark_pop_error_on_return.peekError(),
+                              "Trying to add data in unsupported state");
+    case kErrorMessageSize:
+      return;
+  }
+}
+
 bool CipherBase::SetAutoPadding(bool auto_padding) {
   if (!ctx_) return false;
   MarkPopErrorOnReturn mark_pop_error_on_return;
@@ -34,6 +34,7 @@ class CipherBase : public BaseObject {
   enum UpdateResult {
     kSuccess,
     kErrorMessageSize,
+    kErrorOutputSize,
     kErrorState
   };
   enum AuthTagState {
@@ -60,6 +61,11 @@ class CipherBase : public BaseObject {
   bool CheckCCMMessageLength(int message_len);
   UpdateResult Update(const char* data, size_t len,
                       std::unique_ptr<v8::BackingStore>* out);
+  UpdateResult UpdateInto(const char* data,
+                          size_t len,
+                          unsigned char* out,
+                          size_t out_len,
+                          int* written);
   bool Final(std::unique_ptr<v8::BackingStore>* out);
   bool SetAutoPadding(bool auto_padding);
 
@@ -69,6 +75,7 @@ class CipherBase : public BaseObject {
 
   static void New(const v8::FunctionCallbackInfo<v8::Value>& args);
   static void Update(const v8::FunctionCallbackInfo<v8::Value>& args);
+  static void UpdateInto(const v8::FunctionCallbackInfo<v8::Value>& args);
   static void Final(const v8::FunctionCallbackInfo<v8::Value>& args);
   static void SetAutoPadding(const v8::FunctionCallbackInfo<v8::Value>& args);
 
@@ -86,6 +93,9 @@ class CipherBase : public BaseObject {
   char auth_tag_[ncrypto::Cipher::MAX_AUTH_TAG_LENGTH];
   bool pending_auth_failed_;
   int max_message_size_;
+  // Input bytes that OpenSSL holds back until more input or final(): a
+  // partial block, or the last block when decrypting with padding.
+  size_t buffered_bytes_ = 0;
 };
 
 class PublicKeyCipher {
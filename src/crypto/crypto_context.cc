@@ -2,6 +2,7 @@
 #include "base_object-inl.h"
 #include "crypto/crypto_bio.h"
 #include "crypto/crypto_common.h"
+#include "crypto/crypto_tls.h"
 #include "crypto/crypto_util.h"
 #include "env-inl.h"
 #include "memory_tracker-inl.h"
@@ -15,6 +16,8 @@
 #include <openssl/x509.h>
 #include <openssl/pkcs12.h>
 #include <openssl/rand.h>
+
+#include <ctime>
 #ifndef OPENSSL_NO_ENGINE
 #include <openssl/engine.h>
 #endif  // !OPENSSL_NO_ENGINE
@@ -41,7 +44,9 @@ using ncrypto::EnginePointer;
 #endif  // !OPENSSL_NO_ENGINE
 using ncrypto::EVPKeyPointer;
 using ncrypto::MarkPopErrorOnReturn;
+using ncrypto::SSLCtxPointer;
 using ncrypto::SSLPointer;
+using ncrypto::SSLSessionPointer;
 using ncrypto::StackOfX509;
 using ncrypto::X509Pointer;
 using ncrypto::X509View;
@@ -994,6 +999,8 @@ Local<FunctionTemplate> SecureContext::GetConstructorTemplate(
     SetProtoMethod(isolate, tmpl, "setTicketKeys", SetTicketKeys);
     SetProtoMethod(
         isolate, tmpl, "enableTicketKeyCallback", EnableTicketKeyCallback);
+    SetProtoMethod(
+        isolate, tmpl, "enableSharedSessionCache", EnableSharedSessionCache);
 
     SetProtoMethodNoSideEffect(isolate, tmpl, "getTicketKeys", GetTicketKeys);
     SetProtoMethodNoSideEffect(
@@ -1074,6 +1081,7 @@ void SecureContext::RegisterExternalReferences(
   registry->Register(LoadPKCS12);
   registry->Register(SetTicketKeys);
   registry->Register(EnableTicketKeyCallback);
+  registry->Register(EnableSharedSessionCache);
   registry->Register(GetTicketKeys);
   registry->Register(GetCertificate<true>);
   registry->Register(GetCertificate<false>);
@@ -1101,6 +1109,56 @@ SecureContext* SecureContext::Create(Environment* env) {
   return new SecureContext(env, obj);
 }
 
+SecureContext* SecureContext::FromSSL(const SSL* ssl) {
+  return static_cast<TLSWrap*>(SSL_get_app_data(ssl))->secure_context();
+}
+
+SecureContext::SecureContextTransferData::SecureContextTransferData(
+    const SecureContext& sc)
+    : cert_(sc.cert_.view().clone()),
+      issuer_(sc.issuer_.view().clone()),
+      use_shared_session_cache_(sc.use_shared_session_cache_) {
+  CHECK_EQ(SSL_CTX_up_ref(sc.ctx_.get()), 1);
+  ctx_ = SSLCtxPointer(sc.ctx_.get());
+  memcpy(ticket_key_name_, sc.ticket_key_name_, sizeof(ticket_key_name_));
+  memcpy(ticket_key_aes_, sc.ticket_key_aes_, sizeof(ticket_key_aes_));
+  memcpy(ticket_key_hmac_, sc.ticket_key_hmac_, sizeof(ticket_key_hmac_));
+}
+
+BaseObjectPtr<BaseObject>
+SecureContext::SecureContextTransferData::Deserialize(
+    Environment* env,
+    Local<Context> context,
+    std::unique_ptr<worker::TransferData> self) {
+  if (context != env->context()) [[unlikely]] {
+    THROW_ERR_MESSAGE_TARGET_CONTEXT_UNAVAILABLE(env);
+    return {};
+  }
+
+  SecureContext* sc = Create(env);
+  if (sc == nullptr) return {};
+
+  sc->ctx_ = std::move(ctx_);
+  sc->cert_ = std::move(cert_);
+  sc->issuer_ = std::move(issuer_);
+  memcpy(sc->ticket_key_name_, ticket_key_name_, sizeof(ticket_key_name_));
+  memcpy(sc->ticket_key_aes_, ticket_key_aes_, sizeof(ticket_key_aes_));
+  memcpy(sc->ticket_key_hmac_, ticket_key_hmac_, sizeof(ticket_key_hmac_));
+  sc->use_shared_session_cache_ = use_shared_session_cache_;
+  return BaseObjectPtr<BaseObject>(sc);
+}
+
+BaseObject::TransferMode SecureContext::GetTransferMode() const {
+  // Only an initialized context has anything worth sharing.
+  return ctx_ ? BaseObject::TransferMode::kCloneable
+              : BaseObject::TransferMode::kDisallowCloneAndTransfer;
+}
+
+std::unique_ptr<worker::TransferData> SecureContext::CloneForMessaging()
+    const {
+  return std::make_unique<SecureContextTransferData>(*this);
+}
+
 SecureContext::SecureContext(Environment* env, Local<Object> wrap)
     : BaseObject(env, wrap) {
   MakeWeak();
@@ -1940,8 +1998,7 @@ int SecureContext::TicketKeyCallback(SSL* ssl,
                                      int enc) {
   static const int kTicketPartSize = 16;
 
-  SecureContext* sc = static_cast<SecureContext*>(
-      SSL_CTX_get_app_data(SSL_get_SSL_CTX(ssl)));
+  SecureContext* sc = FromSSL(ssl);
 
   Environment* env = sc->env();
   HandleScope handle_scope(env->isolate());
@@ -2028,8 +2085,7 @@ int SecureContext::TicketCompatibilityCallback(SSL* ssl,
                                                EVP_CIPHER_CTX* ectx,
                                                HMAC_CTX* hctx,
                                                int enc) {
-  SecureContext* sc = static_cast<SecureContext*>(
-      SSL_CTX_get_app_data(SSL_get_SSL_CTX(ssl)));
+  SecureContext* sc = FromSSL(ssl);
 
   if (enc) {
     memcpy(name, sc->ticket_key_name_, sizeof(sc->ticket_key_name_));
@@ -2063,6 +2119,164 @@ int SecureContext::TicketCompatibilityCallback(SSL* ssl,
   return 1;
 }
 
+// enableSharedSessionCache(ticketKeyLifetime)
+//
+// Takes over both session resumption mechanisms for this context: session
+// ids are looked up in (and stored to) the process-wide cache in addition to
+// the JS 'newSession'/'resumeSession' events, and tickets are sealed with the
+// shared, rotating key rather than the one set through setTicketKeys().
+void SecureContext::EnableSharedSessionCache(
+    const FunctionCallbackInfo<Value>& args) {
+  SecureContext* wrap;
+  ASSIGN_OR_RETURN_UNWRAP(&wrap, args.This());
+
+  CHECK(args[0]->IsUint32());  // Ticket key lifetime in seconds, 0 = default
+  SharedSessionCache::Get()->SetTicketKeyLifetime(
+      args[0].As<v8::Uint32>()->Value());
+
+  wrap->use_shared_session_cache_ = true;
+  SSL_CTX_set_tlsext_ticket_key_cb(wrap->ctx_.get(),
+                                   SharedSessionCache::TicketKeyCallback);
+  SSL_CTX_sess_set_remove_cb(wrap->ctx_.get(),
+                             SharedSessionCache::RemoveSessionCallback);
+}
+
+SharedSessionCache* SharedSessionCache::Get() {
+  // Intentionally leaked: TLS connections on worker threads may still be
+  // shutting down while static destructors run.
+  static SharedSessionCache* cache = new SharedSessionCache();
+  return cache;
+}
+
+void SharedSessionCache::EraseLocked(
+    std::unordered_map<std::string, Entry>::iterator it) {
+  order_.erase(it->second.order);
+  sessions_.erase(it);
+}
+
+void SharedSessionCache::Store(SSL_SESSION* sess) {
+  unsigned int id_length;
+  const unsigned char* id_data = SSL_SESSION_get_id(sess, &id_length);
+  if (id_length == 0) return;
+
+  int size = i2d_SSL_SESSION(sess, nullptr);
+  if (size <= 0 || size > SecureContext::kMaxSessionSize) return;
+  std::vector<unsigned char> der(size);
+  unsigned char* data = der.data();
+  CHECK_EQ(i2d_SSL_SESSION(sess, &data), size);
+
+  std::string key(reinterpret_cast<const char*>(id_data), id_length);
+  uint64_t expiry = static_cast<uint64_t>(SSL_SESSION_get_time(sess)) +
+                    SSL_SESSION_get_timeout(sess);
+
+  Mutex::ScopedLock lock(mutex_);
+  auto it = sessions_.find(key);
+  if (it != sessions_.end()) EraseLocked(it);
+  while (sessions_.size() >= kMaxEntries)
+    EraseLocked(sessions_.find(order_.front()));
+
+  order_.push_back(key);
+  sessions_.emplace(std::move(key),
+                    Entry{std::move(der), expiry, std::prev(order_.end())});
+}
+
+SSLSessionPointer SharedSessionCache::Lookup(const unsigned char* id,
+                                             size_t len) {
+  std::string key(reinterpret_cast<const char*>(id), len);
+  Mutex::ScopedLock lock(mutex_);
+  auto it = sessions_.find(key);
+  if (it == sessions_.end()) return {};
+  if (it->second.expiry <= static_cast<uint64_t>(time(nullptr))) {
+    EraseLocked(it);
+    return {};
+  }
+  return GetTLSSession(it->second.der.data(), it->second.der.size());
+}
+
+void SharedSessionCache::Remove(const unsigned char* id, size_t len) {
+  std::string key(reinterpret_cast<const char*>(id), len);
+  Mutex::ScopedLock lock(mutex_);
+  auto it = sessions_.find(key);
+  if (it != sessions_.end()) EraseLocked(it);
+}
+
+void SharedSessionCache::RemoveSessionCallback(SSL_CTX* ctx,
+                                               SSL_SESSION* sess) {
+  unsigned int id_length;
+  const unsigned char* id_data = SSL_SESSION_get_id(sess, &id_length);
+  if (id_length != 0) Get()->Remove(id_data, id_length);
+}
+
+void SharedSessionCache::SetTicketKeyLifetime(uint64_t seconds) {
+  if (seconds == 0) return;
+  Mutex::ScopedLock lock(mutex_);
+  key_lifetime_ = seconds;
+}
+
+bool SharedSessionCache::RotateTicketKeysLocked(uint64_t now) {
+  if (has_current_key_ && now - key_created_ < key_lifetime_) return true;
+
+  TicketKey key;
+  if (!ncrypto::CSPRNG(&key, sizeof(key))) return false;
+  previous_key_ = current_key_;
+  has_previous_key_ = has_current_key_;
+  current_key_ = key;
+  has_current_key_ = true;
+  key_created_ = now;
+  return true;
+}
+
+int SharedSessionCache::TicketKeyCallback(SSL* ssl,
+                                          unsigned char* name,
+                                          unsigned char* iv,
+                                          EVP_CIPHER_CTX* ectx,
+                                          HMAC_CTX* hctx,
+                                          int enc) {
+  SharedSessionCache* cache = Get();
+  TicketKey key;
+  int result = 1;
+  {
+    Mutex::ScopedLock lock(cache->mutex_);
+    if (!cache->RotateTicketKeysLocked(static_cast<uint64_t>(time(nullptr))))
+      return -1;
+
+    if (enc) {
+      key = cache->current_key_;
+    } else if (memcmp(name, cache->current_key_.name, sizeof(key.name)) == 0) {
+      key = cache->current_key_;
+    } else if (cache->has_previous_key_ &&
+               memcmp(name, cache->previous_key_.name, sizeof(key.name)) ==
+                   0) {
+      // Still valid, but ask OpenSSL to issue a ticket under the new key.
+      key = cache->previous_key_;
+      result = 2;
+    } else {
+      // Unknown or retired key. Discard the ticket.
+      return 0;
+    }
+  }
+
+  if (enc) {
+    memcpy(name, key.name, sizeof(key.name));
+    if (!ncrypto::CSPRNG(iv, 16) ||
+        EVP_EncryptInit_ex(
+            ectx, Cipher::AES_128_CBC, nullptr, key.aes, iv) <= 0 ||
+        HMAC_Init_ex(
+            hctx, key.hmac, sizeof(key.hmac), Digest::SHA256, nullptr) <= 0) {
+      return -1;
+    }
+    return 1;
+  }
+
+  if (EVP_DecryptInit_ex(ectx, Cipher::AES_128_CBC, nullptr, key.aes, iv) <=
+          0 ||
+      HMAC_Init_ex(
+          hctx, key.hmac, sizeof(key.hmac), Digest::SHA256, nullptr) <= 0) {
+    return -1;
+  }
+  return result;
+}
+
 void SecureContext::CtxGetter(const FunctionCallbackInfo<Value>& info) {
   SecureContext* sc;
   ASSIGN_OR_RETURN_UNWRAP(&sc, info.This());
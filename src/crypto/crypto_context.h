@@ -8,8 +8,14 @@
 #include "crypto/crypto_util.h"
 #include "env.h"
 #include "memory_tracker.h"
+#include "node_mutex.h"
+#include "node_worker.h"
 #include "v8.h"
 
+#include <list>
+#include <string>
+#include <unordered_map>
+
 namespace node {
 namespace crypto {
 // A maxVersion of 0 means "any", but OpenSSL may support TLS versions that
@@ -25,6 +31,65 @@ X509_STORE* GetOrCreateRootCertStore();
 
 ncrypto::BIOPointer LoadBIO(Environment* env, v8::Local<v8::Value> v);
 
+// Process-wide TLS session state shared by every SecureContext that opts in
+// with enableSharedSessionCache(), so that servers running on different
+// worker threads can resume each other's sessions. Stateful sessions are
+// kept DER-encoded until they expire or are evicted (oldest first). Session
+// tickets are protected by a shared key that rotates periodically; tickets
+// sealed with the previous key are still accepted and get renewed.
+class SharedSessionCache final {
+ public:
+  static constexpr size_t kMaxEntries = 20 * 1024;
+  static constexpr uint64_t kDefaultTicketKeyLifetime = 12 * 60 * 60;
+
+  static SharedSessionCache* Get();
+
+  void Store(SSL_SESSION* sess);
+  ncrypto::SSLSessionPointer Lookup(const unsigned char* id, size_t len);
+  void Remove(const unsigned char* id, size_t len);
+
+  // Lifetime of a ticket key, in seconds. 0 keeps the current setting.
+  void SetTicketKeyLifetime(uint64_t seconds);
+
+  // Called by OpenSSL when it invalidates a session, e.g. after a fatal
+  // alert or once it has timed out, so that no other thread resumes it.
+  static void RemoveSessionCallback(SSL_CTX* ctx, SSL_SESSION* sess);
+
+  static int TicketKeyCallback(SSL* ssl,
+                               unsigned char* name,
+                               unsigned char* iv,
+                               EVP_CIPHER_CTX* ectx,
+                               HMAC_CTX* hctx,
+                               int enc);
+
+ private:
+  struct Entry {
+    std::vector<unsigned char> der;
+    uint64_t expiry;
+    std::list<std::string>::iterator order;
+  };
+
+  struct TicketKey {
+    unsigned char name[16];
+    unsigned char aes[16];
+    unsigned char hmac[16];
+  };
+
+  // Both must be called with mutex_ held.
+  void EraseLocked(std::unordered_map<std::string, Entry>::iterator it);
+  bool RotateTicketKeysLocked(uint64_t now);
+
+  Mutex mutex_;
+  std::unordered_map<std::string, Entry> sessions_;
+  std::list<std::string> order_;
+  TicketKey current_key_;
+  TicketKey previous_key_;
+  bool has_current_key_ = false;
+  bool has_previous_key_ = false;
+  uint64_t key_created_ = 0;
+  uint64_t key_lifetime_ = kDefaultTicketKeyLifetime;
+};
+
 class SecureContext final : public BaseObject {
  public:
   using GetSessionCb = SSL_SESSION* (*)(SSL*, const unsigned char*, int, int*);
@@ -41,6 +106,11 @@ class SecureContext final : public BaseObject {
   static void RegisterExternalReferences(ExternalReferenceRegistry* registry);
   static SecureContext* Create(Environment* env);
 
+  // Returns the SecureContext on whose behalf `ssl` is currently running.
+  // This can't be taken from the SSL_CTX's app data, because a SSL_CTX that
+  // was cloned to another thread is shared by several SecureContexts.
+  static SecureContext* FromSSL(const SSL* ssl);
+
   const ncrypto::SSLCtxPointer& ctx() const { return ctx_; }
 
   // Non-const ctx() that allows for non-default initialization of
@@ -67,11 +137,44 @@ class SecureContext final : public BaseObject {
   void SetX509StoreFlag(unsigned long flags);  // NOLINT(runtime/int)
   X509_STORE* GetCertStoreOwnedByThisSecureContext();
 
+  bool use_shared_session_cache() const { return use_shared_session_cache_; }
+
   // TODO(joyeecheung): track the memory used by OpenSSL types
   SET_NO_MEMORY_INFO()
   SET_MEMORY_INFO_NAME(SecureContext)
   SET_SELF_SIZE(SecureContext)
 
+  // Cloning a SecureContext to another thread shares the underlying,
+  // reference-counted SSL_CTX, so the certificates, keys and CA store are
+  // not parsed again. The clone starts out with a copy of the ticket keys.
+  // Configuration applied to either side after cloning affects the shared
+  // SSL_CTX, so contexts should be fully set up before being posted.
+  class SecureContextTransferData : public worker::TransferData {
+   public:
+    explicit SecureContextTransferData(const SecureContext& sc);
+
+    BaseObjectPtr<BaseObject> Deserialize(
+        Environment* env,
+        v8::Local<v8::Context> context,
+        std::unique_ptr<worker::TransferData> self) override;
+
+    SET_MEMORY_INFO_NAME(SecureContextTransferData)
+    SET_SELF_SIZE(SecureContextTransferData)
+    SET_NO_MEMORY_INFO()
+
+   private:
+    ncrypto::SSLCtxPointer ctx_;
+    ncrypto::X509Pointer cert_;
+    ncrypto::X509Pointer issuer_;
+    unsigned char ticket_key_name_[16];
+    unsigned char ticket_key_aes_[16];
+    unsigned char ticket_key_hmac_[16];
+    bool use_shared_session_cache_;
+  };
+
+  BaseObject::TransferMode GetTransferMode() const override;
+  std::unique_ptr<worker::TransferData> CloneForMessaging() const override;
+
   static const int kMaxSessionSize = 10 * 1024;
 
   // See TicketKeyCallback
@@ -121,6 +224,8 @@ class SecureContext final : public BaseObject {
   static void SetTicketKeys(const v8::FunctionCallbackInfo<v8::Value>& args);
   static void EnableTicketKeyCallback(
       const v8::FunctionCallbackInfo<v8::Value>& args);
+  static void EnableSharedSessionCache(
+      const v8::FunctionCallbackInfo<v8::Value>& args);
   static void CtxGetter(const v8::FunctionCallbackInfo<v8::Value>& info);
 
   template <bool primary>
@@ -157,6 +262,8 @@ class SecureContext final : public BaseObject {
   unsigned char ticket_key_name_[16];
   unsigned char ticket_key_aes_[16];
   unsigned char ticket_key_hmac_[16];
+
+  bool use_shared_session_cache_ = false;
 };
 
 int SSL_CTX_use_certificate_chain(SSL_CTX* ctx,
@@ -3,17 +3,25 @@
 #include "base_object-inl.h"
 #include "env-inl.h"
 #include "memory_tracker-inl.h"
+#include "node_platform.h"
+#include "path.h"
+#include "permission/permission.h"
 #include "string_bytes.h"
 #include "threadpoolwork-inl.h"
 #include "v8.h"
 
+#include <algorithm>
+#include <atomic>
 #include <cstdio>
+#include <vector>
 
 namespace node {
 
 using ncrypto::DataPointer;
 using ncrypto::EVPMDCtxPointer;
 using ncrypto::MarkPopErrorOnReturn;
+using v8::Array;
+using v8::ArrayBuffer;
 using v8::Context;
 using v8::FunctionCallbackInfo;
 using v8::FunctionTemplate;
@@ -29,13 +37,54 @@ using v8::Name;
 using v8::Nothing;
 using v8::Object;
 using v8::Uint32;
+using v8::Uint8Array;
 using v8::Value;
 
 namespace crypto {
+namespace {
+// Allocating and freeing an EVP_MD_CTX shows up prominently when many small
+// inputs are hashed, so each thread keeps a few reset contexts around. The
+// pool is per thread because HashJob runs on the threadpool.
+constexpr size_t kMaxPooledMDCtx = 16;
+thread_local std::vector<EVPMDCtxPointer> md_ctx_pool;
+
+EVPMDCtxPointer AcquireMDCtx() {
+  if (md_ctx_pool.empty()) return EVPMDCtxPointer::New();
+  EVPMDCtxPointer ctx = std::move(md_ctx_pool.back());
+  md_ctx_pool.pop_back();
+  return ctx;
+}
+
+void ReleaseMDCtx(EVPMDCtxPointer ctx) {
+  if (!ctx || md_ctx_pool.size() >= kMaxPooledMDCtx) return;
+  // Drops the digest state and the reference to the EVP_MD.
+  EVP_MD_CTX_reset(ctx.get());
+  md_ctx_pool.push_back(std::move(ctx));
+}
+
+// Hashes buf into out, which must be at least EVP_MD_size(md) bytes long,
+// using a pooled context. Returns the number of bytes written, or 0.
+size_t PooledDigest(const EVP_MD* md,
+                    const ncrypto::Buffer<const void>& buf,
+                    unsigned char* out) {
+  EVPMDCtxPointer ctx = AcquireMDCtx();
+  size_t len = EVP_MD_size(md);
+  ncrypto::Buffer<void> output{.data = out, .len = len};
+  bool ok = ctx.digestInit(md) && ctx.digestUpdate(buf) &&
+            ctx.digestFinalInto(&output);
+  ReleaseMDCtx(std::move(ctx));
+  return ok ? len : 0;
+}
+}  // namespace
+
 Hash::Hash(Environment* env, Local<Object> wrap) : BaseObject(env, wrap) {
   MakeWeak();
 }
 
+Hash::~Hash() {
+  ReleaseMDCtx(std::move(mdctx_));
+}
+
 void Hash::MemoryInfo(MemoryTracker* tracker) const {
   tracker->TrackFieldWithSize("mdctx", mdctx_ ? kSizeOf_EVP_MD_CTX : 0);
   tracker->TrackFieldWithSize("md", digest_ ? md_len_ : 0);
@@ -207,6 +256,25 @@ const EVP_MD* GetDigestImplementation(Environment* env,
 #endif
 }
 
+// Like ncrypto::getDigestByName(), but on OpenSSL 3 returns the explicitly
+// fetched EVP_MD from the Environment's cache. Implicitly fetched digests
+// are looked up in the provider again by every EVP_DigestInit_ex().
+const EVP_MD* GetCachedDigestByName(Environment* env, const char* name) {
+#if OPENSSL_VERSION_MAJOR >= 3
+  auto it = env->alias_to_md_id_map.find(name);
+  if (it != env->alias_to_md_id_map.end()) {
+    return GetCachedMDByID(env, it->second);
+  }
+  auto result = FetchAndMaybeCacheMD(env, name);
+  if (result.cache_id != -1) {
+    env->alias_to_md_id_map.emplace(name, result.cache_id);
+  }
+  return result.explicit_md ? result.explicit_md : result.implicit_md;
+#else
+  return ncrypto::getDigestByName(name);
+#endif
+}
+
 // crypto.digest(algorithm, algorithmId, algorithmCache,
 //               input, outputEncoding, outputEncodingId)
 void Hash::OneShotDigest(const FunctionCallbackInfo<Value>& args) {
@@ -230,32 +298,33 @@ void Hash::OneShotDigest(const FunctionCallbackInfo<Value>& args) {
 
   enum encoding output_enc = ParseEncoding(isolate, args[4], args[5], HEX);
 
-  DataPointer output = ([&] {
+  unsigned char output[EVP_MAX_MD_SIZE];
+  size_t output_len = ([&] {
     if (args[3]->IsString()) {
       Utf8Value utf8(isolate, args[3]);
-      ncrypto::Buffer<const unsigned char> buf{
-          .data = reinterpret_cast<const unsigned char*>(utf8.out()),
+      ncrypto::Buffer<const void> buf{
+          .data = utf8.out(),
           .len = utf8.length(),
       };
-      return ncrypto::hashDigest(buf, md);
+      return PooledDigest(md, buf, output);
     }
 
     ArrayBufferViewContents<unsigned char> input(args[3]);
-    ncrypto::Buffer<const unsigned char> buf{
-        .data = reinterpret_cast<const unsigned char*>(input.data()),
+    ncrypto::Buffer<const void> buf{
+        .data = input.data(),
         .len = input.length(),
     };
-    return ncrypto::hashDigest(buf, md);
+    return PooledDigest(md, buf, output);
   })();
 
-  if (!output) [[unlikely]] {
+  if (output_len == 0) [[unlikely]] {
     return ThrowCryptoError(env, ERR_get_error());
   }
 
   Local<Value> ret;
   if (StringBytes::Encode(env->isolate(),
-                          static_cast<const char*>(output.get()),
-                          output.size(),
+                          reinterpret_cast<const char*>(output),
+                          output_len,
                           output_enc)
           .ToLocal(&ret)) {
     args.GetReturnValue().Set(ret);
@@ -279,6 +348,8 @@ void Hash::Initialize(Environment* env, Local<Object> target) {
   SetMethodNoSideEffect(context, target, "oneShotDigest", OneShotDigest);
 
   HashJob::Initialize(env, target);
+  BatchHashJob::Initialize(env, target);
+  FileHashJob::Initialize(env, target);
 }
 
 void Hash::RegisterExternalReferences(ExternalReferenceRegistry* registry) {
@@ -290,6 +361,8 @@ void Hash::RegisterExternalReferences(ExternalReferenceRegistry* registry) {
   registry->Register(OneShotDigest);
 
   HashJob::RegisterExternalReferences(registry);
+  BatchHashJob::RegisterExternalReferences(registry);
+  FileHashJob::RegisterExternalReferences(registry);
 }
 
 // new Hash(algorithm, algorithmId, xofLen, algorithmCache)
@@ -324,7 +397,7 @@ void Hash::New(const FunctionCallbackInfo<Value>& args) {
 }
 
 bool Hash::HashInit(const EVP_MD* md, Maybe<unsigned int> xof_md_len) {
-  mdctx_ = EVPMDCtxPointer::New();
+  mdctx_ = AcquireMDCtx();
   if (!mdctx_.digestInit(md)) [[unlikely]] {
     mdctx_.reset();
     return false;
@@ -398,6 +471,9 @@ void Hash::HashDigest(const FunctionCallbackInfo<Value>& args) {
     DCHECK(!data.isSecure());
 
     hash->digest_ = ByteSource::Allocated(data.release());
+    // The digest is cached and the context can no longer be updated or
+    // copied, so hand it back for reuse right away rather than on GC.
+    ReleaseMDCtx(std::move(hash->mdctx_));
   }
 
   Local<Value> ret;
@@ -443,7 +519,7 @@ Maybe<void> HashTraits::AdditionalConfig(
 
   CHECK(args[offset]->IsString());  // Hash algorithm
   Utf8Value digest(env->isolate(), args[offset]);
-  params->digest = ncrypto::getDigestByName(*digest);
+  params->digest = GetCachedDigestByName(env, *digest);
   if (params->digest == nullptr) [[unlikely]] {
     THROW_ERR_CRYPTO_INVALID_DIGEST(env, "Invalid digest: %s", *digest);
     return Nothing<void>();
@@ -480,7 +556,8 @@ bool HashTraits::DeriveBits(Environment* env,
                             const HashConfig& params,
                             ByteSource* out,
                             CryptoJobMode mode) {
-  auto ctx = EVPMDCtxPointer::New();
+  EVPMDCtxPointer ctx = AcquireMDCtx();
+  auto release = OnScopeLeave([&]() { ReleaseMDCtx(std::move(ctx)); });
 
   if (!ctx.digestInit(params.digest) || !ctx.digestUpdate(params.in))
       [[unlikely]] {
@@ -499,5 +576,348 @@ bool HashTraits::DeriveBits(Environment* env,
   return true;
 }
 
+void BatchHashConfig::MemoryInfo(MemoryTracker* tracker) const {
+  // If the Job is sync, then the BatchHashConfig does not own the data.
+  if (mode == kCryptoJobAsync)
+    tracker->TrackFieldWithSize("storage", storage.size());
+}
+
+// BatchHashJob(mode, algorithm, inputs)
+Maybe<void> BatchHashTraits::AdditionalConfig(
+    CryptoJobMode mode,
+    const FunctionCallbackInfo<Value>& args,
+    unsigned int offset,
+    BatchHashConfig* params) {
+  Environment* env = Environment::GetCurrent(args);
+  Local<Context> context = env->context();
+
+  params->mode = mode;
+
+  CHECK(args[offset]->IsString());     // Hash algorithm
+  CHECK(args[offset + 1]->IsArray());  // Inputs
+  Utf8Value digest(env->isolate(), args[offset]);
+  params->digest = GetCachedDigestByName(env, *digest);
+  if (params->digest == nullptr) [[unlikely]] {
+    THROW_ERR_CRYPTO_INVALID_DIGEST(env, "Invalid digest: %s", *digest);
+    return Nothing<void>();
+  }
+  params->length = EVP_MD_size(params->digest);
+
+  Local<Array> list = args[offset + 1].As<Array>();
+  const uint32_t count = list->Length();
+  params->inputs.reserve(count);
+
+  size_t total = 0;
+  for (uint32_t i = 0; i < count; i++) {
+    Local<Value> item;
+    if (!list->Get(context, i).ToLocal(&item)) return Nothing<void>();
+    if (!IsAnyBufferSource(item)) [[unlikely]] {
+      THROW_ERR_INVALID_ARG_TYPE(env, "inputs must be buffers");
+      return Nothing<void>();
+    }
+    ArrayBufferOrViewContents<char> data(item);
+    if (!data.CheckSizeInt32()) [[unlikely]] {
+      THROW_ERR_OUT_OF_RANGE(env, "data is too big");
+      return Nothing<void>();
+    }
+    params->inputs.push_back({.data = data.data(), .len = data.size()});
+    total += data.size();
+  }
+
+  if (mode == kCryptoJobAsync && total > 0) {
+    // One copy for the whole batch rather than one allocation per input.
+    auto storage = DataPointer::Alloc(total);
+    if (!storage) [[unlikely]] {
+      THROW_ERR_MEMORY_ALLOCATION_FAILED(env);
+      return Nothing<void>();
+    }
+    char* dest = static_cast<char*>(storage.get());
+    for (auto& input : params->inputs) {
+      if (input.len > 0) memcpy(dest, input.data, input.len);
+      input.data = dest;
+      dest += input.len;
+    }
+    params->storage = ByteSource::Allocated(storage.release());
+  }
+
+  return JustVoid();
+}
+
+// OpenSSL has no public multi-buffer digest API, so the inputs are hashed
+// one after another. Reinitializing a single context with the cached
+// EVP_MD is cheap, which leaves little per-input overhead beyond the
+// compression function itself.
+bool BatchHashTraits::DeriveBits(Environment* env,
+                                 const BatchHashConfig& params,
+                                 ByteSource* out,
+                                 CryptoJobMode mode) {
+  const size_t count = params.inputs.size();
+  if (count == 0 || params.length == 0) return true;
+
+  auto data = DataPointer::Alloc(count * params.length);
+  if (!data) [[unlikely]]
+    return false;
+
+  EVPMDCtxPointer ctx = AcquireMDCtx();
+  auto release = OnScopeLeave([&]() { ReleaseMDCtx(std::move(ctx)); });
+
+  unsigned char* dest = static_cast<unsigned char*>(data.get());
+  for (const auto& input : params.inputs) {
+    ncrypto::Buffer<void> output{.data = dest, .len = params.length};
+    if (!ctx.digestInit(params.digest) || !ctx.digestUpdate(input) ||
+        !ctx.digestFinalInto(&output)) [[unlikely]] {
+      return false;
+    }
+    dest += params.length;
+  }
+
+  *out = ByteSource::Allocated(data.release());
+  return true;
+}
+
+// Returns an array of Uint8Arrays, one per input, that all share a single
+// ArrayBuffer.
+MaybeLocal<Value> BatchHashTraits::EncodeOutput(Environment* env,
+                                                const BatchHashConfig& params,
+                                                ByteSource* out) {
+  Isolate* isolate = env->isolate();
+  const size_t count = params.inputs.size();
+  Local<ArrayBuffer> buffer = out->ToArrayBuffer(env);
+  LocalVector<Value> digests(isolate);
+  digests.reserve(count);
+  for (size_t i = 0; i < count; i++) {
+    digests.push_back(
+        Uint8Array::New(buffer, i * params.length, params.length));
+  }
+  return Array::New(isolate, digests.data(), digests.size());
+}
+
+namespace {
+// Reads exactly len bytes at offset, unless the file ends first. Returns the
+// number of bytes read, or a negative libuv error code.
+int64_t ReadFully(uv_file fd, char* data, size_t len, uint64_t offset) {
+  size_t total = 0;
+  while (total < len) {
+    uv_fs_t req;
+    uv_buf_t buf = uv_buf_init(data + total, len - total);
+    int r = uv_fs_read(nullptr, &req, fd, &buf, 1, offset + total, nullptr);
+    uv_fs_req_cleanup(&req);
+    if (r < 0) return r;
+    if (r == 0) break;
+    total += r;
+  }
+  return total;
+}
+
+// Hashes leaves in whatever order the participating threads claim them.
+// The thread that joins the job takes part as well, so at least one thread
+// always makes progress even if the platform workers are busy.
+class MerkleLeavesTask final : public v8::JobTask {
+ public:
+  MerkleLeavesTask(const FileHashConfig& params,
+                   size_t leaf_count,
+                   size_t md_len,
+                   unsigned char* out)
+      : params_(params), leaf_count_(leaf_count), md_len_(md_len), out_(out) {}
+
+  void Run(v8::JobDelegate* delegate) override {
+    std::unique_ptr<char[]> chunk(new char[params_.chunk_size]);
+    EVPMDCtxPointer ctx = AcquireMDCtx();
+    static const unsigned char kLeafPrefix = 0x00;
+
+    while (!delegate->ShouldYield()) {
+      size_t i = next_.fetch_add(1, std::memory_order_relaxed);
+      if (i >= leaf_count_) break;
+
+      int64_t n = ReadFully(params_.fd,
+                            chunk.get(),
+                            params_.chunk_size,
+                            static_cast<uint64_t>(i) * params_.chunk_size);
+      ncrypto::Buffer<void> output{.data = out_ + i * md_len_, .len = md_len_};
+      if (n < 0 || !ctx.digestInit(params_.digest) ||
+          !ctx.digestUpdate({.data = &kLeafPrefix, .len = 1}) ||
+          !ctx.digestUpdate({.data = chunk.get(), .len = size_t(n)}) ||
+          !ctx.digestFinalInto(&output)) [[unlikely]] {
+        failed_.store(true, std::memory_order_relaxed);
+      }
+      done_.fetch_add(1, std::memory_order_release);
+    }
+
+    ReleaseMDCtx(std::move(ctx));
+  }
+
+  size_t GetMaxConcurrency(size_t worker_count) const override {
+    size_t done = done_.load(std::memory_order_relaxed);
+    if (done >= leaf_count_) return 0;
+    return std::min<size_t>(leaf_count_ - done, uv_available_parallelism());
+  }
+
+  bool failed() const { return failed_.load(std::memory_order_relaxed); }
+
+ private:
+  const FileHashConfig& params_;
+  const size_t leaf_count_;
+  const size_t md_len_;
+  unsigned char* const out_;
+  std::atomic<size_t> next_{0};
+  std::atomic<size_t> done_{0};
+  std::atomic<bool> failed_{false};
+};
+}  // namespace
+
+FileHashConfig::~FileHashConfig() {
+  if (fd < 0) return;
+  uv_fs_t req;
+  uv_fs_close(nullptr, &req, fd, nullptr);
+  uv_fs_req_cleanup(&req);
+}
+
+FileHashConfig::FileHashConfig(FileHashConfig&& other) noexcept
+    : mode(other.mode),
+      digest(other.digest),
+      fd(other.fd),
+      size(other.size),
+      chunk_size(other.chunk_size) {
+  other.fd = -1;
+}
+
+FileHashConfig& FileHashConfig::operator=(FileHashConfig&& other) noexcept {
+  if (&other == this) return *this;
+  this->~FileHashConfig();
+  return *new (this) FileHashConfig(std::move(other));
+}
+
+// FileHashJob(mode, algorithm, path, chunkSize)
+Maybe<void> FileHashTraits::AdditionalConfig(
+    CryptoJobMode mode,
+    const FunctionCallbackInfo<Value>& args,
+    unsigned int offset,
+    FileHashConfig* params) {
+  Environment* env = Environment::GetCurrent(args);
+
+  params->mode = mode;
+
+  CHECK(args[offset]->IsString());      // Hash algorithm
+  CHECK(args[offset + 2]->IsUint32());  // Chunk size
+  Utf8Value digest(env->isolate(), args[offset]);
+  params->digest = GetCachedDigestByName(env, *digest);
+  if (params->digest == nullptr) [[unlikely]] {
+    THROW_ERR_CRYPTO_INVALID_DIGEST(env, "Invalid digest: %s", *digest);
+    return Nothing<void>();
+  }
+  if (EVP_MD_flags(params->digest) & EVP_MD_FLAG_XOF) [[unlikely]] {
+    THROW_ERR_CRYPTO_INVALID_DIGEST(env, "XOF digests are not supported");
+    return Nothing<void>();
+  }
+  params->chunk_size = args[offset + 2].As<Uint32>()->Value();
+
+  BufferValue path(env->isolate(), args[offset + 1]);
+  CHECK_NOT_NULL(*path);
+  ToNamespacedPath(env, &path);
+  THROW_IF_INSUFFICIENT_PERMISSIONS(
+      env,
+      permission::PermissionScope::kFileSystemRead,
+      path.ToStringView(),
+      Nothing<void>());
+
+  // Opening and stat'ing here, rather than on the threadpool, lets errors
+  // such as ENOENT surface as regular exceptions with the path attached.
+  uv_fs_t req;
+  auto cleanup = OnScopeLeave([&]() { uv_fs_req_cleanup(&req); });
+  int fd = uv_fs_open(nullptr, &req, *path, O_RDONLY, 0, nullptr);
+  if (fd < 0) {
+    env->ThrowUVException(fd, "open", nullptr, *path);
+    return Nothing<void>();
+  }
+  params->fd = fd;
+  uv_fs_req_cleanup(&req);
+
+  int err = uv_fs_fstat(nullptr, &req, fd, nullptr);
+  if (err < 0) {
+    env->ThrowUVException(err, "fstat", nullptr, *path);
+    return Nothing<void>();
+  }
+  params->size = req.statbuf.st_size;
+
+  return JustVoid();
+}
+
+bool FileHashTraits::DeriveBits(Environment* env,
+                                const FileHashConfig& params,
+                                ByteSource* out,
+                                CryptoJobMode mode) {
+  const size_t md_len = EVP_MD_size(params.digest);
+  auto data = DataPointer::Alloc(md_len);
+  if (!data) [[unlikely]]
+    return false;
+  ncrypto::Buffer<void> result = data;
+
+  EVPMDCtxPointer ctx = AcquireMDCtx();
+  auto release = OnScopeLeave([&]() { ReleaseMDCtx(std::move(ctx)); });
+
+  if (params.chunk_size == 0) {
+    constexpr size_t kReadSize = 1024 * 1024;
+    std::unique_ptr<char[]> buf(new char[kReadSize]);
+    if (!ctx.digestInit(params.digest)) return false;
+    for (uint64_t pos = 0;;) {
+      int64_t n = ReadFully(params.fd, buf.get(), kReadSize, pos);
+      if (n < 0) return false;
+      if (n == 0) break;
+      if (!ctx.digestUpdate({.data = buf.get(), .len = size_t(n)}))
+        return false;
+      pos += n;
+    }
+    if (!ctx.digestFinalInto(&result)) return false;
+    *out = ByteSource::Allocated(data.release());
+    return true;
+  }
+
+  // An empty file still has one (empty) leaf.
+  const size_t leaf_count = std::max<uint64_t>(
+      1, (params.size + params.chunk_size - 1) / params.chunk_size);
+  std::vector<unsigned char> level(leaf_count * md_len);
+
+  auto task = std::make_unique<MerkleLeavesTask>(
+      params, leaf_count, md_len, level.data());
+  MerkleLeavesTask* leaves = task.get();
+  std::unique_ptr<v8::JobHandle> job =
+      env->isolate_data()->platform()->CreateJob(
+          v8::TaskPriority::kUserVisible, std::move(task));
+  job->Join();
+  if (leaves->failed()) return false;
+
+  // Combine pairs bottom-up. An unpaired last node moves up unchanged,
+  // which yields the same tree shape as RFC 6962's recursive definition.
+  static const unsigned char kNodePrefix = 0x01;
+  for (size_t count = leaf_count; count > 1; count = (count + 1) / 2) {
+    for (size_t i = 0; i < count / 2; i++) {
+      ncrypto::Buffer<void> node{.data = &level[i * md_len], .len = md_len};
+      ncrypto::Buffer<const void> children{.data = &level[2 * i * md_len],
+                                           .len = 2 * md_len};
+      if (!ctx.digestInit(params.digest) ||
+          !ctx.digestUpdate({.data = &kNodePrefix, .len = 1}) ||
+          !ctx.digestUpdate(children) ||
+          !ctx.digestFinalInto(&node)) [[unlikely]] {
+        return false;
+      }
+    }
+    if (count % 2) {
+      memmove(&level[(count / 2) * md_len],
+              &level[(count - 1) * md_len],
+              md_len);
+    }
+  }
+
+  memcpy(result.data, level.data(), md_len);
+  *out = ByteSource::Allocated(data.release());
+  return true;
+}
+
+MaybeLocal<Value> FileHashTraits::EncodeOutput(Environment* env,
+                                               const FileHashConfig& params,
+                                               ByteSource* out) {
+  return out->ToArrayBuffer(env);
+}
+
 }  // namespace crypto
 }  // namespace node
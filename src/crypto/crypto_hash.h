@@ -34,6 +34,7 @@ class Hash final : public BaseObject {
   static void HashDigest(const v8::FunctionCallbackInfo<v8::Value>& args);
 
   Hash(Environment* env, v8::Local<v8::Object> wrap);
+  ~Hash() override;
 
  private:
   ncrypto::EVPMDCtxPointer mdctx_{};
@@ -82,6 +83,100 @@ struct HashTraits final {
 
 using HashJob = DeriveBitsJob<HashTraits>;
 
+// Hashes each of a list of inputs with the same algorithm. All digests are
+// written into one allocation, in input order.
+struct BatchHashConfig final : public MemoryRetainer {
+  CryptoJobMode mode;
+  const EVP_MD* digest;
+  unsigned int length;
+  // In async mode the inputs are copied into storage; in sync mode they
+  // point straight into the JS buffers.
+  ByteSource storage;
+  std::vector<ncrypto::Buffer<const void>> inputs;
+
+  BatchHashConfig() = default;
+
+  explicit BatchHashConfig(BatchHashConfig&& other) noexcept = default;
+
+  BatchHashConfig& operator=(BatchHashConfig&& other) noexcept = default;
+
+  void MemoryInfo(MemoryTracker* tracker) const override;
+  SET_MEMORY_INFO_NAME(BatchHashConfig)
+  SET_SELF_SIZE(BatchHashConfig)
+};
+
+struct BatchHashTraits final {
+  using AdditionalParameters = BatchHashConfig;
+  static constexpr const char* JobName = "BatchHashJob";
+  static constexpr AsyncWrap::ProviderType Provider =
+      AsyncWrap::PROVIDER_HASHREQUEST;
+
+  static v8::Maybe<void> AdditionalConfig(
+      CryptoJobMode mode,
+      const v8::FunctionCallbackInfo<v8::Value>& args,
+      unsigned int offset,
+      BatchHashConfig* params);
+
+  static bool DeriveBits(Environment* env,
+                         const BatchHashConfig& params,
+                         ByteSource* out,
+                         CryptoJobMode mode);
+
+  static v8::MaybeLocal<v8::Value> EncodeOutput(Environment* env,
+                                                const BatchHashConfig& params,
+                                                ByteSource* out);
+};
+
+using BatchHashJob = DeriveBitsJob<BatchHashTraits>;
+
+// Digests a file without passing its contents through JS. With a chunk size
+// of 0 the result is the plain digest of the file. Otherwise the file is
+// split into chunk_size leaves that are hashed in parallel on the platform
+// worker threads and combined into an RFC 6962 Merkle tree hash:
+//   leaf = H(0x00 || chunk), node = H(0x01 || left || right).
+struct FileHashConfig final : public MemoryRetainer {
+  CryptoJobMode mode;
+  const EVP_MD* digest;
+  uv_file fd = -1;
+  uint64_t size = 0;
+  uint32_t chunk_size = 0;
+
+  FileHashConfig() = default;
+  ~FileHashConfig() override;
+
+  explicit FileHashConfig(FileHashConfig&& other) noexcept;
+
+  FileHashConfig& operator=(FileHashConfig&& other) noexcept;
+
+  SET_NO_MEMORY_INFO()
+  SET_MEMORY_INFO_NAME(FileHashConfig)
+  SET_SELF_SIZE(FileHashConfig)
+};
+
+struct FileHashTraits final {
+  using AdditionalParameters = FileHashConfig;
+  static constexpr const char* JobName = "FileHashJob";
+  static constexpr AsyncWrap::ProviderType Provider =
+      AsyncWrap::PROVIDER_HASHREQUEST;
+
+  static v8::Maybe<void> AdditionalConfig(
+      CryptoJobMode mode,
+      const v8::FunctionCallbackInfo<v8::Value>& args,
+      unsigned int offset,
+      FileHashConfig* params);
+
+  static bool DeriveBits(Environment* env,
+                         const FileHashConfig& params,
+                         ByteSource* out,
+                         CryptoJobMode mode);
+
+  static v8::MaybeLocal<v8::Value> EncodeOutput(Environment* env,
+                                                const FileHashConfig& params,
+                                                ByteSource* out);
+};
+
+using FileHashJob = DeriveBitsJob<FileHashTraits>;
+
 }  // namespace crypto
 }  // namespace node
 
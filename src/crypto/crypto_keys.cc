@@ -251,6 +251,60 @@ KeyObjectData TryParsePrivateKey(
   return {};
 }
 
+KeyObjectData ParsePublicOrPrivateKey(
+    Environment* env,
+    const EVPKeyPointer::PrivateKeyEncodingConfig& config,
+    const ncrypto::Buffer<const unsigned char>& buffer) {
+  if (config.format == EVPKeyPointer::PKFormatType::PEM) {
+    // For PEM, we can easily determine whether it is a public or private key
+    // by looking for the respective PEM tags.
+    auto res = EVPKeyPointer::TryParsePublicKeyPEM(buffer);
+    if (res) {
+      return KeyObjectData::CreateAsymmetric(kKeyTypePublic,
+                                             std::move(res.value));
+    }
+
+    if (res.error.value() == EVPKeyPointer::PKParseError::NOT_RECOGNIZED) {
+      return TryParsePrivateKey(env, config, buffer);
+    }
+    ThrowCryptoError(
+        env, res.openssl_error.value_or(0), "Failed to read asymmetric key");
+    return {};
+  }
+
+  // For DER, the type determines how to parse it. SPKI, PKCS#8 and SEC1 are
+  // easy, but PKCS#1 can be a public key or a private key.
+  static const auto is_public = [](const auto& config,
+                                   const auto& buffer) -> bool {
+    switch (config.type) {
+      case EVPKeyPointer::PKEncodingType::PKCS1:
+        return !EVPKeyPointer::IsRSAPrivateKey(buffer);
+      case EVPKeyPointer::PKEncodingType::SPKI:
+        return true;
+      case EVPKeyPointer::PKEncodingType::PKCS8:
+        return false;
+      case EVPKeyPointer::PKEncodingType::SEC1:
+        return false;
+      default:
+        UNREACHABLE("Invalid key encoding type");
+    }
+  };
+
+  if (is_public(config, buffer)) {
+    auto res = EVPKeyPointer::TryParsePublicKey(config, buffer);
+    if (res) {
+      return KeyObjectData::CreateAsymmetric(KeyType::kKeyTypePublic,
+                                             std::move(res.value));
+    }
+
+    ThrowCryptoError(
+        env, res.openssl_error.value_or(0), "Failed to read asymmetric key");
+    return {};
+  }
+
+  return TryParsePrivateKey(env, config, buffer);
+}
+
 bool ExportJWKInner(Environment* env,
                     const KeyObjectData& key,
                     Local<Value> result,
@@ -387,12 +441,13 @@ KeyObjectData KeyObjectData::GetPrivateKeyFromJs(
       return {};
     }
 
-    return TryParsePrivateKey(
-        env,
-        config,
-        ncrypto::Buffer<const unsigned char>{
-            .data = reinterpret_cast<const unsigned char*>(key.data()),
-            .len = key.size(),
+    ncrypto::Buffer<const unsigned char> buffer{
+        .data = reinterpret_cast<const unsigned char*>(key.data()),
+        .len = key.size(),
+    };
+    return ParsedKeyCache::Get()->GetOrParse(
+        ParsedKeyCache::Mode::kPrivate, config, buffer, [&]() {
+          return TryParsePrivateKey(env, config, buffer);
         });
   }
 
@@ -426,52 +481,10 @@ KeyObjectData KeyObjectData::GetPublicOrPrivateKeyFromJs(
         .len = data.size(),
     };
 
-    if (config.format == EVPKeyPointer::PKFormatType::PEM) {
-      // For PEM, we can easily determine whether it is a public or private key
-      // by looking for the respective PEM tags.
-      auto res = EVPKeyPointer::TryParsePublicKeyPEM(buffer);
-      if (res) {
-        return CreateAsymmetric(kKeyTypePublic, std::move(res.value));
-      }
-
-      if (res.error.value() == EVPKeyPointer::PKParseError::NOT_RECOGNIZED) {
-        return TryParsePrivateKey(env, config, buffer);
-      }
-      ThrowCryptoError(
-          env, res.openssl_error.value_or(0), "Failed to read asymmetric key");
-      return {};
-    }
-
-    // For DER, the type determines how to parse it. SPKI, PKCS#8 and SEC1 are
-    // easy, but PKCS#1 can be a public key or a private key.
-    static const auto is_public = [](const auto& config,
-                                     const auto& buffer) -> bool {
-      switch (config.type) {
-        case EVPKeyPointer::PKEncodingType::PKCS1:
-          return !EVPKeyPointer::IsRSAPrivateKey(buffer);
-        case EVPKeyPointer::PKEncodingType::SPKI:
-          return true;
-        case EVPKeyPointer::PKEncodingType::PKCS8:
-          return false;
-        case EVPKeyPointer::PKEncodingType::SEC1:
-          return false;
-        default:
-          UNREACHABLE("Invalid key encoding type");
-      }
-    };
-
-    if (is_public(config, buffer)) {
-      auto res = EVPKeyPointer::TryParsePublicKey(config, buffer);
-      if (res) {
-        return CreateAsymmetric(KeyType::kKeyTypePublic, std::move(res.value));
-      }
-
-      ThrowCryptoError(
-          env, res.openssl_error.value_or(0), "Failed to read asymmetric key");
-      return {};
-    }
-
-    return TryParsePrivateKey(env, config, buffer);
+    return ParsedKeyCache::Get()->GetOrParse(
+        ParsedKeyCache::Mode::kPublicOrPrivate, config, buffer, [&]() {
+          return ParsePublicOrPrivateKey(env, config, buffer);
+        });
   }
 
   CHECK(args[*offset]->IsObject());
@@ -1148,12 +1161,79 @@ WebCryptoKeyExportStatus PKEY_PKCS8_Export(const KeyObjectData& key_data,
   return WebCryptoKeyExportStatus::OK;
 }
 
+ParsedKeyCache* ParsedKeyCache::Get() {
+  // Intentionally leaked, like other process-wide crypto state, since worker
+  // threads may still be parsing keys while static destructors run.
+  static ParsedKeyCache* cache = new ParsedKeyCache();
+  return cache;
+}
+
+std::string ParsedKeyCache::MakeKey(
+    Mode mode,
+    const EVPKeyPointer::PrivateKeyEncodingConfig& config,
+    const ncrypto::Buffer<const unsigned char>& buffer) {
+  // The same bytes can decode differently depending on the declared format
+  // and encoding and on the kind of key asked for, so all of them are part
+  // of the key.
+  std::string key;
+  key.push_back(static_cast<char>(mode));
+  key.push_back(static_cast<char>(config.format));
+  key.push_back(static_cast<char>(config.type));
+  auto digest = ncrypto::hashDigest(buffer, ncrypto::Digest::SHA256);
+  if (!digest) return {};
+  key.append(digest.get<char>(), digest.size());
+  return key;
+}
+
+KeyObjectData ParsedKeyCache::Lookup(const std::string& key) {
+  Mutex::ScopedLock lock(mutex_);
+  auto it = entries_.find(key);
+  if (it == entries_.end()) return {};
+  // Move to the most recently used end.
+  order_.splice(order_.end(), order_, it->second.order);
+  return it->second.data.addRef();
+}
+
+void ParsedKeyCache::Store(std::string&& key, const KeyObjectData& data) {
+  Mutex::ScopedLock lock(mutex_);
+  size_t capacity = capacity_.load(std::memory_order_relaxed);
+  if (capacity == 0 || entries_.contains(key)) return;
+  while (entries_.size() >= capacity) {
+    entries_.erase(order_.front());
+    order_.pop_front();
+  }
+  order_.push_back(key);
+  entries_.emplace(std::move(key),
+                   Entry{data.addRef(), std::prev(order_.end())});
+}
+
+void ParsedKeyCache::SetCapacity(size_t capacity) {
+  Mutex::ScopedLock lock(mutex_);
+  capacity_.store(capacity, std::memory_order_relaxed);
+  while (entries_.size() > capacity) {
+    entries_.erase(order_.front());
+    order_.pop_front();
+  }
+}
+
+// setParsedKeyCacheSize(maxEntries). 0, the default, disables the cache.
+void ParsedKeyCache::SetParsedKeyCacheSize(
+    const FunctionCallbackInfo<Value>& args) {
+  CHECK(args[0]->IsUint32());
+  Get()->SetCapacity(args[0].As<Uint32>()->Value());
+}
+
 namespace Keys {
 void Initialize(Environment* env, Local<Object> target) {
   target->Set(env->context(),
               FIXED_ONE_BYTE_STRING(env->isolate(), "KeyObjectHandle"),
               KeyObjectHandle::Initialize(env)).Check();
 
+  SetMethod(env->context(),
+            target,
+            "setParsedKeyCacheSize",
+            ParsedKeyCache::SetParsedKeyCacheSize);
+
   constexpr int kKeyEncodingPKCS1 =
       static_cast<int>(EVPKeyPointer::PKEncodingType::PKCS1);
   constexpr int kKeyEncodingPKCS8 =
@@ -1196,6 +1276,7 @@ void Initialize(Environment* env, Local<Object> target) {
 
 void RegisterExternalReferences(ExternalReferenceRegistry* registry) {
   KeyObjectHandle::RegisterExternalReferences(registry);
+  registry->Register(ParsedKeyCache::SetParsedKeyCacheSize);
 }
 }  // namespace Keys
 
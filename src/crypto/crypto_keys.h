@@ -13,6 +13,9 @@
 
 #include <openssl/evp.h>
 
+#include <atomic>
+#include <list>
+
 #include <memory>
 #include <string>
 
@@ -130,6 +133,60 @@ class KeyObjectData final : public MemoryRetainer {
       : key_type_(type), mutex_(mutex), data_(data) {}
 };
 
+// An opt-in, process-wide cache of keys parsed from PEM or DER input, keyed
+// by the SHA-256 of the input bytes along with the declared format and
+// encoding and the kind of key the caller asked for. Since KeyObjectData is
+// safe to share among threads, a hit hands out another reference to the
+// already decoded EVP_PKEY and skips the ASN.1 decode entirely. Encrypted
+// keys are never cached. Entries are evicted in least recently used order
+// once the configured capacity is reached.
+class ParsedKeyCache final {
+ public:
+  static ParsedKeyCache* Get();
+
+  // The same PEM input can yield a public key for one caller and be
+  // rejected by another that requires a private key.
+  enum class Mode : char { kPrivate, kPublicOrPrivate };
+
+  template <typename Parse>
+  KeyObjectData GetOrParse(
+      Mode mode,
+      const ncrypto::EVPKeyPointer::PrivateKeyEncodingConfig& config,
+      const ncrypto::Buffer<const unsigned char>& buffer,
+      Parse&& parse) {
+    if (capacity_.load(std::memory_order_relaxed) == 0 || config.passphrase)
+      return parse();
+    std::string key = MakeKey(mode, config, buffer);
+    if (key.empty()) return parse();
+    if (KeyObjectData data = Lookup(key)) return data;
+    KeyObjectData data = parse();
+    if (data) Store(std::move(key), data);
+    return data;
+  }
+
+  void SetCapacity(size_t capacity);
+  static void SetParsedKeyCacheSize(
+      const v8::FunctionCallbackInfo<v8::Value>& args);
+
+ private:
+  struct Entry {
+    KeyObjectData data;
+    std::list<std::string>::iterator order;
+  };
+
+  static std::string MakeKey(
+      Mode mode,
+      const ncrypto::EVPKeyPointer::PrivateKeyEncodingConfig& config,
+      const ncrypto::Buffer<const unsigned char>& buffer);
+  KeyObjectData Lookup(const std::string& key);
+  void Store(std::string&& key, const KeyObjectData& data);
+
+  Mutex mutex_;
+  std::atomic<size_t> capacity_{0};
+  std::unordered_map<std::string, Entry> entries_;
+  std::list<std::string> order_;
+};
+
 class KeyObjectHandle : public BaseObject {
  public:
   static bool HasInstance(Environment* env, v8::Local<v8::Value> value);
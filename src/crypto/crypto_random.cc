@@ -7,7 +7,11 @@
 #include "threadpoolwork-inl.h"
 #include "v8.h"
 
+#include <atomic>
 #include <compare>
+#ifndef _WIN32
+#include <pthread.h>
+#endif
 
 namespace node {
 
@@ -37,6 +41,112 @@ BignumPointer::PrimeCheckCallback getPrimeCheckCallback(Environment* env) {
   return [env](int a, int b) -> bool { return !env->is_stopping(); };
 }
 
+// Bumped in the child after fork(), so that a child never hands out bytes
+// that the parent may hand out, too.
+std::atomic<uint64_t> fork_generation{0};
+
+void RegisterForkHandler() {
+#ifndef _WIN32
+  static const int registered = pthread_atfork(nullptr, nullptr, []() {
+    fork_generation.fetch_add(1, std::memory_order_relaxed);
+  });
+  USE(registered);
+#endif
+}
+
+// CSPRNG output buffered per thread for small synchronous requests such as
+// randomFillSync() and randomUUID(). One buffer is drawn from while the other
+// is refilled on the threadpool, so those requests just copy from memory.
+// Bytes are wiped as soon as they have been handed out.
+class RandomPool final {
+ public:
+  static constexpr size_t kPoolSize = 64 * 1024;
+  static constexpr size_t kMaxRequestSize = 2 * 1024;
+
+  static RandomPool* ForCurrentThread() {
+    thread_local RandomPool pool;
+    return &pool;
+  }
+
+  // Returns false when the request cannot be served from the pool, in which
+  // case the caller should ask OpenSSL directly.
+  bool Take(Environment* env, unsigned char* out, size_t len) {
+    if (len > kMaxRequestSize) return false;
+
+    uint64_t generation = fork_generation.load(std::memory_order_relaxed);
+    if (generation != generation_) [[unlikely]] {
+      OPENSSL_cleanse(active_.get(), kPoolSize);
+      remaining_ = 0;
+      spare_ready_ = false;
+      generation_ = generation;
+    }
+
+    if (len > remaining_ && spare_ready_) {
+      OPENSSL_cleanse(active_.get(), kPoolSize - remaining_);
+      std::swap(active_, spare_);
+      remaining_ = kPoolSize;
+      spare_ready_ = false;
+    }
+    if (!spare_ready_ && !refilling_) ScheduleRefill(env);
+    if (len > remaining_) return false;
+
+    unsigned char* data = active_.get() + (kPoolSize - remaining_);
+    memcpy(out, data, len);
+    OPENSSL_cleanse(data, len);
+    remaining_ -= len;
+    return true;
+  }
+
+ private:
+  class Refill final : public ThreadPoolWork {
+   public:
+    Refill(Environment* env, RandomPool* pool)
+        : ThreadPoolWork(env, "crypto", ThreadPoolWorkClass::kCrypto),
+          pool_(pool),
+          generation_(fork_generation.load(std::memory_order_relaxed)) {}
+
+    void DoThreadPoolWork() override {
+      ok_ = ncrypto::CSPRNG(pool_->spare_.get(), kPoolSize);
+    }
+
+    void AfterThreadPoolWork(int status) override {
+      std::unique_ptr<Refill> self(this);
+      pool_->refilling_ = false;
+      pool_->spare_ready_ =
+          status == 0 && ok_ &&
+          generation_ == fork_generation.load(std::memory_order_relaxed);
+    }
+
+   private:
+    RandomPool* pool_;
+    uint64_t generation_;
+    bool ok_ = false;
+  };
+
+  RandomPool()
+      : active_(new unsigned char[kPoolSize]),
+        spare_(new unsigned char[kPoolSize]),
+        generation_(fork_generation.load(std::memory_order_relaxed)) {
+    RegisterForkHandler();
+  }
+
+  ~RandomPool() {
+    OPENSSL_cleanse(active_.get(), kPoolSize);
+    if (!refilling_) OPENSSL_cleanse(spare_.get(), kPoolSize);
+  }
+
+  void ScheduleRefill(Environment* env) {
+    refilling_ = true;
+    (new Refill(env, this))->ScheduleWork();
+  }
+
+  std::unique_ptr<unsigned char[]> active_;
+  std::unique_ptr<unsigned char[]> spare_;
+  size_t remaining_ = 0;
+  bool spare_ready_ = false;
+  bool refilling_ = false;
+  uint64_t generation_;
+};
 }  // namespace
 MaybeLocal<Value> RandomBytesTraits::EncodeOutput(
     Environment* env, const RandomBytesConfig& params, ByteSource* unused) {
@@ -69,6 +179,12 @@ bool RandomBytesTraits::DeriveBits(Environment* env,
                                    const RandomBytesConfig& params,
                                    ByteSource* unused,
                                    CryptoJobMode mode) {
+  // Async jobs already run on the threadpool, so only synchronous calls
+  // benefit from the pool.
+  if (mode == kCryptoJobSync &&
+      RandomPool::ForCurrentThread()->Take(env, params.buffer, params.size)) {
+    return true;
+  }
   return ncrypto::CSPRNG(params.buffer, params.size);
 }
 
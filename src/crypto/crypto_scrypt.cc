@@ -4,17 +4,23 @@
 #include "env-inl.h"
 #include "memory_tracker-inl.h"
 #include "node_buffer.h"
+#include "node_options.h"
 #include "threadpoolwork-inl.h"
 #include "v8.h"
 
+#include <algorithm>
+#include <utility>
+
 namespace node {
 
 using v8::FunctionCallbackInfo;
 using v8::Int32;
 using v8::JustVoid;
+using v8::Local;
 using v8::Maybe;
 using v8::MaybeLocal;
 using v8::Nothing;
+using v8::Object;
 using v8::Uint32;
 using v8::Value;
 
@@ -145,6 +151,171 @@ bool ScryptTraits::DeriveBits(Environment* env,
   return true;
 }
 
+ScryptMemoryBudget* ScryptMemoryBudget::Get() {
+  // Intentionally leaked: derivations may still release memory on threadpool
+  // threads while static destructors run.
+  static ScryptMemoryBudget* budget = [] {
+    uint64_t limit;
+    {
+      Mutex::ScopedLock lock(per_process::cli_options_mutex);
+      limit = per_process::cli_options->scrypt_memory_budget;
+    }
+    return new ScryptMemoryBudget(limit * 1024 * 1024);
+  }();
+  return budget;
+}
+
+ScryptMemoryBudget::ScryptMemoryBudget(uint64_t limit) : limit_(limit) {}
+
+uint64_t ScryptMemoryBudget::MemoryFor(const ScryptConfig& params) {
+  // B, which holds all p lanes, and V, which OpenSSL allocates once and
+  // reuses for every lane. The params have been checked, so this does not
+  // overflow.
+  const uint64_t r = params.r;
+  return 128 * r * params.p + 128 * r * (uint64_t{params.N} + 2);
+}
+
+void ScryptMemoryBudget::SetLimit(uint64_t limit) {
+  Mutex::ScopedLock lock(mutex_);
+  limit_ = limit;
+  // Raising the limit may admit queued derivations.
+  AdmitQueued();
+}
+
+uint64_t ScryptMemoryBudget::limit() const {
+  Mutex::ScopedLock lock(mutex_);
+  return limit_;
+}
+
+bool ScryptMemoryBudget::Fits(uint64_t memory) const {
+  return limit_ == 0 || reserved_ == 0 ||
+         (reserved_ <= limit_ && memory <= limit_ - reserved_);
+}
+
+bool ScryptMemoryBudget::Reserve(const std::shared_ptr<Waiter>& waiter) {
+  Mutex::ScopedLock lock(mutex_);
+  // Derivations that are already queued go first, so that small ones do not
+  // starve a large one.
+  if (queue_.empty() && Fits(waiter->memory)) {
+    reserved_ += waiter->memory;
+    return true;
+  }
+  queue_.push_back(waiter);
+  return false;
+}
+
+void ScryptMemoryBudget::ForceReserve(uint64_t memory) {
+  Mutex::ScopedLock lock(mutex_);
+  reserved_ += memory;
+}
+
+void ScryptMemoryBudget::Release(uint64_t memory) {
+  Mutex::ScopedLock lock(mutex_);
+  CHECK_GE(reserved_, memory);
+  reserved_ -= memory;
+  AdmitQueued();
+}
+
+bool ScryptMemoryBudget::Unqueue(const std::shared_ptr<Waiter>& waiter) {
+  Mutex::ScopedLock lock(mutex_);
+  auto it = std::find(queue_.begin(), queue_.end(), waiter);
+  if (it == queue_.end()) return false;
+  queue_.erase(it);
+  return true;
+}
+
+uint64_t ScryptMemoryBudget::reserved() const {
+  Mutex::ScopedLock lock(mutex_);
+  return reserved_;
+}
+
+size_t ScryptMemoryBudget::queued() const {
+  Mutex::ScopedLock lock(mutex_);
+  return queue_.size();
+}
+
+void ScryptMemoryBudget::AdmitQueued() {
+  while (!queue_.empty() && Fits(queue_.front()->memory)) {
+    std::shared_ptr<Waiter> waiter = std::move(queue_.front());
+    queue_.pop_front();
+    reserved_ += waiter->memory;
+    waiter->admit();
+  }
+}
+
+void ScryptJob::New(const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+
+  CryptoJobMode mode = GetCryptoJobMode(args[0]);
+
+  ScryptConfig params;
+  if (ScryptTraits::AdditionalConfig(mode, args, 1, &params).IsNothing()) {
+    // AdditionalConfig has thrown ERR_CRYPTO_INVALID_SCRYPT_PARAMS or
+    // ERR_OUT_OF_RANGE.
+    return;
+  }
+
+  new ScryptJob(env, args.This(), mode, std::move(params));
+}
+
+void ScryptJob::Initialize(Environment* env, Local<Object> target) {
+  CryptoJob<ScryptTraits>::Initialize(New, env, target);
+}
+
+void ScryptJob::RegisterExternalReferences(
+    ExternalReferenceRegistry* registry) {
+  CryptoJob<ScryptTraits>::RegisterExternalReferences(New, registry);
+}
+
+ScryptJob::~ScryptJob() {
+  ScryptMemoryBudget* budget = ScryptMemoryBudget::Get();
+  if (waiter_ && budget->Unqueue(waiter_)) AsyncWrap::env()->add_refs(-1);
+  // If the job has been admitted but not submitted yet, the pending
+  // callback releases its memory.
+  if (self_) *self_ = nullptr;
+  if (reserved_ != 0) budget->Release(reserved_);
+}
+
+void ScryptJob::ScheduleAsync() {
+  ScryptMemoryBudget* budget = ScryptMemoryBudget::Get();
+  const uint64_t memory = ScryptMemoryBudget::MemoryFor(*params());
+  self_ = std::make_shared<ScryptJob*>(this);
+  waiter_ = std::make_shared<ScryptMemoryBudget::Waiter>();
+  waiter_->memory = memory;
+  waiter_->admit = [env = AsyncWrap::env(), budget, memory, self = self_]() {
+    env->SetImmediateThreadsafe(
+        [budget, memory, self](Environment* env) {
+          env->add_refs(-1);
+          ScryptJob* job = *self;
+          if (job == nullptr) return budget->Release(memory);
+          job->waiter_.reset();
+          job->reserved_ = memory;
+          job->ScheduleWork();
+        },
+        CallbackFlags::kUnrefed);
+  };
+  if (budget->Reserve(waiter_)) {
+    waiter_.reset();
+    reserved_ = memory;
+    return ScheduleWork();
+  }
+  // The memory may be held by the derivations of other threads, so keep the
+  // event loop alive while the job waits for it.
+  AsyncWrap::env()->add_refs(1);
+}
+
+void ScryptJob::DoThreadPoolWork() {
+  ScryptMemoryBudget* budget = ScryptMemoryBudget::Get();
+  if (mode() == kCryptoJobSync) {
+    reserved_ = ScryptMemoryBudget::MemoryFor(*params());
+    budget->ForceReserve(reserved_);
+  }
+  DeriveBitsJob<ScryptTraits>::DoThreadPoolWork();
+  // OpenSSL has freed the memory by now, so queued derivations do not have
+  // to wait for the callback of this one.
+  budget->Release(std::exchange(reserved_, 0));
+}
+
 #endif  // !OPENSSL_NO_SCRYPT
 
 }  // namespace crypto
@@ -6,8 +6,13 @@
 #include "crypto/crypto_util.h"
 #include "env.h"
 #include "memory_tracker.h"
+#include "node_mutex.h"
 #include "v8.h"
 
+#include <deque>
+#include <functional>
+#include <memory>
+
 namespace node {
 namespace crypto {
 #ifndef OPENSSL_NO_SCRYPT
@@ -67,7 +72,82 @@ struct ScryptTraits final {
                                                 ByteSource* out);
 };
 
-using ScryptJob = DeriveBitsJob<ScryptTraits>;
+// Bounds the memory that the scrypt derivations of all threads in the
+// process hold at the same time. Async derivations that do not fit are
+// queued in order and admitted once enough memory has been released, so
+// that they never wait on a threadpool thread. A derivation that exceeds
+// the limit on its own is admitted once no other one holds memory.
+// Thread-safe.
+class ScryptMemoryBudget final {
+ public:
+  struct Waiter {
+    uint64_t memory = 0;
+    // Called on any thread, with the budget locked, once |memory| has been
+    // reserved for the waiter. Must not call into the budget.
+    std::function<void()> admit;
+  };
+
+  // The budget that all Environments of the process share, with the limit
+  // that --scrypt-memory-budget sets.
+  static ScryptMemoryBudget* Get();
+
+  // A limit of 0 means that memory is not limited.
+  explicit ScryptMemoryBudget(uint64_t limit = 0);
+  ScryptMemoryBudget(const ScryptMemoryBudget&) = delete;
+  ScryptMemoryBudget& operator=(const ScryptMemoryBudget&) = delete;
+
+  // The memory that OpenSSL allocates for a derivation, which is also what
+  // it checks against maxmem.
+  static uint64_t MemoryFor(const ScryptConfig& params);
+
+  void SetLimit(uint64_t limit);
+  uint64_t limit() const;
+
+  // Reserves the memory of |waiter| and returns true if it fits. Otherwise,
+  // queues |waiter| behind the others and returns false.
+  bool Reserve(const std::shared_ptr<Waiter>& waiter);
+  // Reserves |memory| regardless of the limit.
+  void ForceReserve(uint64_t memory);
+  void Release(uint64_t memory);
+  // Removes a waiter that has not been admitted. Returns false if it has.
+  bool Unqueue(const std::shared_ptr<Waiter>& waiter);
+
+  uint64_t reserved() const;
+  size_t queued() const;
+
+ private:
+  bool Fits(uint64_t memory) const;
+  void AdmitQueued();
+
+  mutable Mutex mutex_;
+  uint64_t limit_;
+  uint64_t reserved_ = 0;
+  std::deque<std::shared_ptr<Waiter>> queue_;
+};
+
+// A DeriveBitsJob that only submits itself to the threadpool once the
+// ScryptMemoryBudget has room for it. crypto.scryptSync() runs on the
+// event loop, which waiting would block, so sync jobs are counted against
+// the budget but never held back.
+class ScryptJob final : public DeriveBitsJob<ScryptTraits> {
+ public:
+  static void New(const v8::FunctionCallbackInfo<v8::Value>& args);
+  static void Initialize(Environment* env, v8::Local<v8::Object> target);
+  static void RegisterExternalReferences(ExternalReferenceRegistry* registry);
+
+  using DeriveBitsJob<ScryptTraits>::DeriveBitsJob;
+  ~ScryptJob() override;
+
+  void ScheduleAsync() override;
+  void DoThreadPoolWork() override;
+
+ private:
+  std::shared_ptr<ScryptMemoryBudget::Waiter> waiter_;
+  // Points back to the job until it is deleted. Shared with the callback
+  // that admits the job, which may still be pending by then.
+  std::shared_ptr<ScryptJob*> self_;
+  uint64_t reserved_ = 0;
+};
 
 #else
 // If there is no Scrypt support, ScryptJob becomes a non-op
@@ -6,10 +6,14 @@
 #include "crypto/crypto_util.h"
 #include "env-inl.h"
 #include "memory_tracker-inl.h"
+#include "node_platform.h"
 #include "openssl/ec.h"
 #include "threadpoolwork-inl.h"
 #include "v8.h"
 
+#include <algorithm>
+#include <atomic>
+
 namespace node {
 
 using ncrypto::BignumPointer;
@@ -20,6 +24,7 @@ using ncrypto::ECDSASigPointer;
 using ncrypto::EVPKeyCtxPointer;
 using ncrypto::EVPKeyPointer;
 using ncrypto::EVPMDCtxPointer;
+using v8::Array;
 using v8::ArrayBuffer;
 using v8::BackingStore;
 using v8::BackingStoreInitializationMode;
@@ -285,6 +290,7 @@ void Sign::Initialize(Environment* env, Local<Object> target) {
   SetConstructorFunction(env->context(), target, "Sign", t);
 
   SignJob::Initialize(env, target);
+  BatchVerifyJob::Initialize(env, target);
 
   constexpr int kSignJobModeSign =
       static_cast<int>(SignConfiguration::Mode::Sign);
@@ -307,6 +313,7 @@ void Sign::RegisterExternalReferences(ExternalReferenceRegistry* registry) {
   registry->Register(SignUpdate);
   registry->Register(SignFinal);
   SignJob::RegisterExternalReferences(registry);
+  BatchVerifyJob::RegisterExternalReferences(registry);
 }
 
 void Sign::New(const FunctionCallbackInfo<Value>& args) {
@@ -728,5 +735,229 @@ MaybeLocal<Value> SignTraits::EncodeOutput(Environment* env,
   UNREACHABLE();
 }
 
+namespace {
+bool VerifyOne(const BatchVerifyConfiguration& params, size_t i) {
+  const auto& key = params.keys[i].GetAsymmetricKey();
+  auto context = EVPMDCtxPointer::New();
+  if (!context) [[unlikely]]
+    return false;
+  auto ctx = context.verifyInit(key, params.digest);
+  if (!ctx.has_value()) [[unlikely]]
+    return false;
+
+  int padding = params.flags & SignConfiguration::kHasPadding
+                    ? params.padding
+                    : key.getDefaultSignPadding();
+  std::optional<int> salt_length =
+      params.flags & SignConfiguration::kHasSaltLength
+          ? std::optional<int>(params.salt_length)
+          : std::nullopt;
+  if (!ApplyRSAOptions(key, *ctx, padding, salt_length)) return false;
+
+  return context.verify(params.data[i], params.signatures[i]);
+}
+
+// Hands out signatures to the platform worker threads, and to the thread
+// that joins the job. Each item writes only its own result byte.
+class BatchVerifyTask final : public v8::JobTask {
+ public:
+  BatchVerifyTask(const BatchVerifyConfiguration& params, uint8_t* results)
+      : params_(params), results_(results) {}
+
+  void Run(v8::JobDelegate* delegate) override {
+    ClearErrorOnReturn clear_error_on_return;
+    const size_t count = params_.keys.size();
+    while (!delegate->ShouldYield()) {
+      size_t i = next_.fetch_add(1, std::memory_order_relaxed);
+      if (i >= count) break;
+      results_[i] = VerifyOne(params_, i) ? 1 : 0;
+      done_.fetch_add(1, std::memory_order_release);
+    }
+  }
+
+  size_t GetMaxConcurrency(size_t worker_count) const override {
+    size_t done = done_.load(std::memory_order_relaxed);
+    size_t count = params_.keys.size();
+    if (done >= count) return 0;
+    return std::min<size_t>(count - done, uv_available_parallelism());
+  }
+
+ private:
+  const BatchVerifyConfiguration& params_;
+  uint8_t* const results_;
+  std::atomic<size_t> next_{0};
+  std::atomic<size_t> done_{0};
+};
+}  // namespace
+
+BatchVerifyConfiguration::BatchVerifyConfiguration(
+    BatchVerifyConfiguration&& other) noexcept
+    : job_mode(other.job_mode),
+      keys(std::move(other.keys)),
+      data(std::move(other.data)),
+      signatures(std::move(other.signatures)),
+      digest(other.digest),
+      flags(other.flags),
+      padding(other.padding),
+      salt_length(other.salt_length),
+      dsa_encoding(other.dsa_encoding) {}
+
+BatchVerifyConfiguration& BatchVerifyConfiguration::operator=(
+    BatchVerifyConfiguration&& other) noexcept {
+  if (&other == this) return *this;
+  this->~BatchVerifyConfiguration();
+  return *new (this) BatchVerifyConfiguration(std::move(other));
+}
+
+void BatchVerifyConfiguration::MemoryInfo(MemoryTracker* tracker) const {
+  tracker->TrackField("keys", keys);
+  if (job_mode == kCryptoJobAsync) {
+    size_t size = 0;
+    for (const auto& d : data) size += d.size();
+    for (const auto& s : signatures) size += s.size();
+    tracker->TrackFieldWithSize("data", size);
+  }
+}
+
+// BatchVerifyJob(mode, keys, data, signatures, digest, saltLength, padding,
+//                dsaEncoding)
+Maybe<void> BatchVerifyTraits::AdditionalConfig(
+    CryptoJobMode mode,
+    const FunctionCallbackInfo<Value>& args,
+    unsigned int offset,
+    BatchVerifyConfiguration* params) {
+  ClearErrorOnReturn clear_error_on_return;
+  Environment* env = Environment::GetCurrent(args);
+
+  params->job_mode = mode;
+
+  CHECK(args[offset]->IsArray());      // Keys
+  CHECK(args[offset + 1]->IsArray());  // Data
+  CHECK(args[offset + 2]->IsArray());  // Signatures
+  Local<Array> keys = args[offset].As<Array>();
+  Local<Array> data = args[offset + 1].As<Array>();
+  Local<Array> signatures = args[offset + 2].As<Array>();
+  const uint32_t count = keys->Length();
+  CHECK_EQ(data->Length(), count);
+  CHECK_EQ(signatures->Length(), count);
+
+  if (args[offset + 3]->IsString()) {
+    Utf8Value digest(env->isolate(), args[offset + 3]);
+    params->digest = Digest::FromName(*digest);
+    if (!params->digest) [[unlikely]] {
+      THROW_ERR_CRYPTO_INVALID_DIGEST(env, "Invalid digest: %s", *digest);
+      return Nothing<void>();
+    }
+  }
+
+  if (args[offset + 4]->IsInt32()) {  // Salt length
+    params->flags |= SignConfiguration::kHasSaltLength;
+    params->salt_length = args[offset + 4].As<Int32>()->Value();
+  }
+  if (args[offset + 5]->IsInt32()) {  // Padding
+    params->flags |= SignConfiguration::kHasPadding;
+    params->padding = args[offset + 5].As<Int32>()->Value();
+  }
+  if (args[offset + 6]->IsUint32()) {  // DSA Encoding
+    params->dsa_encoding = GetDSASigEncFromJS(args[offset + 6]);
+    if (params->dsa_encoding == DSASigEnc::Invalid) [[unlikely]] {
+      THROW_ERR_OUT_OF_RANGE(env, "invalid signature encoding");
+      return Nothing<void>();
+    }
+  }
+
+  params->keys.reserve(count);
+  params->data.reserve(count);
+  params->signatures.reserve(count);
+  Local<v8::Context> context = env->context();
+  for (uint32_t i = 0; i < count; i++) {
+    Local<Value> key;
+    Local<Value> item;
+    Local<Value> signature;
+    if (!keys->Get(context, i).ToLocal(&key) ||
+        !data->Get(context, i).ToLocal(&item) ||
+        !signatures->Get(context, i).ToLocal(&signature)) {
+      return Nothing<void>();
+    }
+
+    CHECK(key->IsObject());
+    KeyObjectHandle* handle =
+        BaseObject::Unwrap<KeyObjectHandle>(key.As<Object>());
+    CHECK_NOT_NULL(handle);
+    const KeyObjectData& key_data = handle->Data();
+    CHECK_NE(key_data.GetKeyType(), kKeyTypeSecret);
+
+    CHECK(IsAnyBufferSource(item));
+    CHECK(IsAnyBufferSource(signature));
+    ArrayBufferOrViewContents<char> item_contents(item);
+    ArrayBufferOrViewContents<char> signature_contents(signature);
+    if (!item_contents.CheckSizeInt32()) [[unlikely]] {
+      THROW_ERR_OUT_OF_RANGE(env, "data is too big");
+      return Nothing<void>();
+    }
+    if (!signature_contents.CheckSizeInt32()) [[unlikely]] {
+      THROW_ERR_OUT_OF_RANGE(env, "signature is too big");
+      return Nothing<void>();
+    }
+
+    params->data.push_back(mode == kCryptoJobAsync
+                               ? item_contents.ToCopy()
+                               : item_contents.ToByteSource());
+
+    // As with SignJob, EC signatures in WebCrypto format are converted to
+    // DER up front so the workers only ever see what OpenSSL expects.
+    Mutex::ScopedLock lock(key_data.mutex());
+    const auto& akey = key_data.GetAsymmetricKey();
+    if (UseP1363Encoding(akey, params->dsa_encoding)) {
+      params->signatures.push_back(
+          ConvertSignatureToDER(akey, signature_contents.ToByteSource()));
+    } else {
+      params->signatures.push_back(mode == kCryptoJobAsync
+                                       ? signature_contents.ToCopy()
+                                       : signature_contents.ToByteSource());
+    }
+    params->keys.push_back(key_data.addRef());
+  }
+
+  return JustVoid();
+}
+
+bool BatchVerifyTraits::DeriveBits(Environment* env,
+                                   const BatchVerifyConfiguration& params,
+                                   ByteSource* out,
+                                   CryptoJobMode mode) {
+  const size_t count = params.keys.size();
+  auto bitmap = DataPointer::Alloc((count + 7) / 8);
+  if (!bitmap && count > 0) [[unlikely]]
+    return false;
+
+  // OpenSSL has no batch verification API, not even for Ed25519, so the
+  // signatures are verified individually but spread across threads.
+  std::vector<uint8_t> results(count);
+  if (count > 1) {
+    std::unique_ptr<v8::JobHandle> job =
+        env->isolate_data()->platform()->CreateJob(
+            v8::TaskPriority::kUserVisible,
+            std::make_unique<BatchVerifyTask>(params, results.data()));
+    job->Join();
+  } else if (count == 1) {
+    ClearErrorOnReturn clear_error_on_return;
+    results[0] = VerifyOne(params, 0) ? 1 : 0;
+  }
+
+  unsigned char* bits = static_cast<unsigned char*>(bitmap.get());
+  for (size_t i = 0; i < count; i++) {
+    if (results[i]) bits[i / 8] |= 1 << (i % 8);
+  }
+  *out = ByteSource::Allocated(bitmap.release());
+  return true;
+}
+
+MaybeLocal<Value> BatchVerifyTraits::EncodeOutput(
+    Environment* env, const BatchVerifyConfiguration& params, ByteSource* out) {
+  if (params.keys.empty()) return ArrayBuffer::New(env->isolate(), 0);
+  return out->ToArrayBuffer(env);
+}
+
 }  // namespace crypto
 }  // namespace node
@@ -149,6 +149,59 @@ struct SignTraits final {
 
 using SignJob = DeriveBitsJob<SignTraits>;
 
+// Verifies many (key, data, signature) triples in one job. The digest,
+// padding, salt length and signature encoding apply to all of them. The
+// result is a bitmap in which bit i (LSB first) is set when signature i is
+// valid.
+struct BatchVerifyConfiguration final : public MemoryRetainer {
+  CryptoJobMode job_mode;
+  std::vector<KeyObjectData> keys;
+  std::vector<ByteSource> data;
+  std::vector<ByteSource> signatures;
+  ncrypto::Digest digest;
+  int flags = SignConfiguration::kHasNone;
+  int padding = 0;
+  int salt_length = 0;
+  DSASigEnc dsa_encoding = DSASigEnc::DER;
+
+  BatchVerifyConfiguration() = default;
+
+  explicit BatchVerifyConfiguration(BatchVerifyConfiguration&& other) noexcept;
+
+  BatchVerifyConfiguration& operator=(
+      BatchVerifyConfiguration&& other) noexcept;
+
+  void MemoryInfo(MemoryTracker* tracker) const override;
+  SET_MEMORY_INFO_NAME(BatchVerifyConfiguration)
+  SET_SELF_SIZE(BatchVerifyConfiguration)
+};
+
+struct BatchVerifyTraits final {
+  using AdditionalParameters = BatchVerifyConfiguration;
+  static constexpr const char* JobName = "BatchVerifyJob";
+
+  static constexpr AsyncWrap::ProviderType Provider =
+      AsyncWrap::PROVIDER_SIGNREQUEST;
+
+  static v8::Maybe<void> AdditionalConfig(
+      CryptoJobMode mode,
+      const v8::FunctionCallbackInfo<v8::Value>& args,
+      unsigned int offset,
+      BatchVerifyConfiguration* params);
+
+  static bool DeriveBits(Environment* env,
+                         const BatchVerifyConfiguration& params,
+                         ByteSource* out,
+                         CryptoJobMode mode);
+
+  static v8::MaybeLocal<v8::Value> EncodeOutput(
+      Environment* env,
+      const BatchVerifyConfiguration& params,
+      ByteSource* out);
+};
+
+using BatchVerifyJob = DeriveBitsJob<BatchVerifyTraits>;
+
 }  // namespace crypto
 }  // namespace node
 
@@ -34,6 +34,20 @@
 #include "stream_base-inl.h"
 #include "util-inl.h"
 
+#ifdef NODE_HAVE_KTLS
+#include <linux/tls.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+
+#ifndef SOL_TLS
+#define SOL_TLS 282
+#endif
+#ifndef TCP_ULP
+#define TCP_ULP 31
+#endif
+#endif  // NODE_HAVE_KTLS
+
 namespace node {
 
 using ncrypto::BIOPointer;
@@ -100,7 +114,12 @@ SSL_SESSION* GetSessionCallback(
     int* copy) {
   TLSWrap* w = static_cast<TLSWrap*>(SSL_get_app_data(s));
   *copy = 0;
-  return w->ReleaseSession();
+  SSL_SESSION* sess = w->ReleaseSession();
+  if (sess != nullptr) return sess;
+
+  if (w->secure_context()->use_shared_session_cache())
+    return SharedSessionCache::Get()->Lookup(key, len).release();
+  return nullptr;
 }
 
 void OnClientHello(
@@ -163,6 +182,9 @@ int NewSessionCallback(SSL* s, SSL_SESSION* sess) {
   HandleScope handle_scope(env->isolate());
   Context::Scope context_scope(env->context());
 
+  if (w->is_server() && w->secure_context()->use_shared_session_cache())
+    SharedSessionCache::Get()->Store(sess);
+
   if (!w->has_session_callbacks()) [[unlikely]]
     return 0;
 
@@ -807,6 +829,27 @@ void TLSWrap::ClearOut() {
   char out[kClearOutChunkSize];
   int read;
   for (;;) {
+    // With encrypted input buffered, decrypt straight into the listener's
+    // buffer. Otherwise SSL_read() is only expected to drive the handshake
+    // or report WANT_READ, so don't make the listener allocate for it.
+    if (SSL_pending(ssl_.get()) > 0 || BIO_pending(enc_in_) > 0) {
+      uv_buf_t buf = EmitAlloc(kClearOutChunkSize);
+      int len =
+          static_cast<int>(std::min<size_t>(buf.len, kClearOutChunkSize));
+      read = SSL_read(ssl_.get(), buf.base, len);
+      Debug(this, "Read %d bytes of cleartext output", read);
+      // A zero-length EmitRead() only gives the buffer back; it does not
+      // call into JS or touch the OpenSSL error queue.
+      EmitRead(read > 0 ? read : 0, buf);
+      if (ssl_ == nullptr) {
+        Debug(this, "Returning from read loop, ssl_ == nullptr");
+        return;
+      }
+      if (read <= 0)
+        break;
+      continue;
+    }
+
     read = SSL_read(ssl_.get(), out, sizeof(out));
     Debug(this, "Read %d bytes of cleartext output", read);
 
@@ -2165,6 +2208,105 @@ void TLSWrap::SetMaxSendFragment(const FunctionCallbackInfo<Value>& args) {
 }
 #endif  // SSL_set_max_send_fragment
 
+#ifdef NODE_HAVE_KTLS
+// Must be called before start(). Once the keys for application data are in
+// place, OpenSSL hands the encryption of outgoing records to the kernel,
+// provided that the underlying stream is a TCP socket, the cipher is one that
+// the kernel has, and the kernel has the "tls" upper layer protocol. If not,
+// OpenSSL keeps encrypting, and getKTLSStatus() says why.
+void TLSWrap::EnableKTLS(const FunctionCallbackInfo<Value>& args) {
+  TLSWrap* w;
+  ASSIGN_OR_RETURN_UNWRAP(&w, args.This());
+  CHECK(w->ssl_);
+  CHECK(!w->started_);
+  SSL_set_options(w->ssl_.get(), SSL_OP_ENABLE_KTLS);
+  // OpenSSL writes from the buffer passed to SSL_write() with kTLS, and
+  // ClearIn() retries from a copy.
+  SSL_set_mode(w->ssl_.get(), SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER);
+  NodeBIO::FromBIO(w->enc_out_)->set_ktls_socket(&w->ktls_socket_);
+}
+
+// Returns [send, receive, error]. Only sending is offloaded, as the
+// encrypted input arrives through the underlying stream. |error| is the
+// reason why the kernel does not encrypt, if OpenSSL asked it to.
+void TLSWrap::GetKTLSStatus(const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+  TLSWrap* w;
+  ASSIGN_OR_RETURN_UNWRAP(&w, args.This());
+  bool send = false;
+  int error = 0;
+  if (w->ssl_) {
+    NodeBIO* bio = NodeBIO::FromBIO(w->enc_out_);
+    send = bio->ktls_send();
+    error = -bio->ktls_error();
+  }
+  Local<Value> status[] = {Boolean::New(env->isolate(), send),
+                           False(env->isolate()),
+                           Integer::New(env->isolate(), error)};
+  args.GetReturnValue().Set(
+      Array::New(env->isolate(), status, arraysize(status)));
+}
+
+bool TLSWrap::KTLSSocket::FlushForKTLS(NodeBIO* bio) {
+  // The bytes of a write in flight are still in the BIO.
+  if (wrap_->write_size_ != 0 ||
+      wrap_->has_active_write_issued_by_prev_listener_) {
+    return false;
+  }
+  StreamBase* stream = wrap_->underlying_stream();
+  if (bio->Length() > 0 && !stream->HasDoTryWrite()) return false;
+  while (bio->Length() > 0) {
+    char* data[kSimultaneousBufferCount];
+    size_t size[arraysize(data)];
+    size_t count = arraysize(data);
+    const size_t total = bio->PeekMultiple(data, size, &count);
+    uv_buf_t buf[arraysize(data)];
+    for (size_t i = 0; i < count; i++) buf[i] = uv_buf_init(data[i], size[i]);
+    uv_buf_t* bufs = buf;
+    if (stream->DoTryWrite(&bufs, &count) != 0) return false;
+    size_t left = 0;
+    for (size_t i = 0; i < count; i++) left += bufs[i].len;
+    bio->Read(nullptr, total - left);
+    if (left != 0) return false;
+  }
+  return true;
+}
+
+int TLSWrap::KTLSSocket::StartKTLS(const void* crypto_info, size_t size) {
+  const int fd = wrap_->GetFD();
+  if (fd < 0) return EBADF;
+  // Fails with ENOENT if the kernel has no "tls" module, or with
+  // EOPNOTSUPP if the socket is not TCP.
+  if (setsockopt(fd, SOL_TCP, TCP_ULP, "tls", sizeof("tls")) != 0 ||
+      setsockopt(fd, SOL_TLS, TLS_TX, crypto_info, size) != 0) {
+    return errno;
+  }
+  return 0;
+}
+
+ssize_t TLSWrap::KTLSSocket::SendKTLSRecord(uint8_t record_type,
+                                            const char* data,
+                                            size_t size) {
+  iovec iov = {const_cast<char*>(data), size};
+  char control[CMSG_SPACE(sizeof(record_type))] = {};
+  msghdr msg = {};
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = control;
+  msg.msg_controllen = sizeof(control);
+  cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+  cmsg->cmsg_level = SOL_TLS;
+  cmsg->cmsg_type = TLS_SET_RECORD_TYPE;
+  cmsg->cmsg_len = CMSG_LEN(sizeof(record_type));
+  memcpy(CMSG_DATA(cmsg), &record_type, sizeof(record_type));
+  ssize_t written;
+  do {
+    written = sendmsg(wrap_->GetFD(), &msg, MSG_NOSIGNAL);
+  } while (written == -1 && errno == EINTR);
+  return written < 0 ? -errno : written;
+}
+#endif  // NODE_HAVE_KTLS
+
 void TLSWrap::Initialize(
     Local<Object> target,
     Local<Value> unused,
@@ -2249,6 +2391,11 @@ void TLSWrap::Initialize(
   SetProtoMethod(isolate, t, "setMaxSendFragment", SetMaxSendFragment);
 #endif  // SSL_set_max_send_fragment
 
+#ifdef NODE_HAVE_KTLS
+  SetProtoMethod(isolate, t, "enableKTLS", EnableKTLS);
+  SetProtoMethodNoSideEffect(isolate, t, "getKTLSStatus", GetKTLSStatus);
+#endif  // NODE_HAVE_KTLS
+
 #ifndef OPENSSL_NO_PSK
   SetProtoMethod(isolate, t, "enablePskCallback", EnablePskCallback);
   SetProtoMethod(isolate, t, "setPskIdentityHint", SetPskIdentityHint);
@@ -2309,6 +2456,11 @@ void TLSWrap::RegisterExternalReferences(ExternalReferenceRegistry* registry) {
   registry->Register(SetMaxSendFragment);
 #endif  // SSL_set_max_send_fragment
 
+#ifdef NODE_HAVE_KTLS
+  registry->Register(EnableKTLS);
+  registry->Register(GetKTLSStatus);
+#endif  // NODE_HAVE_KTLS
+
 #ifndef OPENSSL_NO_PSK
   registry->Register(EnablePskCallback);
   registry->Register(SetPskIdentityHint);
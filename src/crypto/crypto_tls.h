@@ -24,8 +24,9 @@
 
 #if defined(NODE_WANT_INTERNALS) && NODE_WANT_INTERNALS
 
-#include "crypto/crypto_context.h"
+#include "crypto/crypto_bio.h"
 #include "crypto/crypto_clienthello.h"
+#include "crypto/crypto_context.h"
 
 #include "async_wrap.h"
 #include "stream_wrap.h"
@@ -97,6 +98,12 @@ class TLSWrap : public AsyncWrap,
   void ClearOcspResponse();
   SSL_SESSION* ReleaseSession();
 
+  // The context whose SSL_CTX is in use, i.e. the SNI context once one has
+  // been selected.
+  SecureContext* secure_context() const {
+    return sni_context_ ? sni_context_.get() : sc_.get();
+  }
+
   // Called by the done() callback of the 'newSession' event.
   void NewSessionDoneCb();
 
@@ -231,6 +238,26 @@ class TLSWrap : public AsyncWrap,
       const v8::FunctionCallbackInfo<v8::Value>& args);
 #endif  // SSL_set_max_send_fragment
 
+#ifdef NODE_HAVE_KTLS
+  static void EnableKTLS(const v8::FunctionCallbackInfo<v8::Value>& args);
+  static void GetKTLSStatus(const v8::FunctionCallbackInfo<v8::Value>& args);
+
+  // The underlying stream, as the socket that the kernel encrypts on.
+  class KTLSSocket final : public NodeBIO::KTLSSocket {
+   public:
+    explicit KTLSSocket(TLSWrap* wrap) : wrap_(wrap) {}
+
+    bool FlushForKTLS(NodeBIO* bio) override;
+    int StartKTLS(const void* crypto_info, size_t size) override;
+    ssize_t SendKTLSRecord(uint8_t record_type,
+                           const char* data,
+                           size_t size) override;
+
+   private:
+    TLSWrap* const wrap_;
+  };
+#endif  // NODE_HAVE_KTLS
+
 #ifndef OPENSSL_NO_PSK
   static void EnablePskCallback(
       const v8::FunctionCallbackInfo<v8::Value>& args);
@@ -294,6 +321,10 @@ class TLSWrap : public AsyncWrap,
 
   bool has_active_write_issued_by_prev_listener_ = false;
 
+#ifdef NODE_HAVE_KTLS
+  KTLSSocket ktls_socket_{this};
+#endif  // NODE_HAVE_KTLS
+
  public:
   std::vector<unsigned char> alpn_protos_;  // Accessed by SelectALPNCallback.
   bool alpn_callback_enabled_ = false;      // Accessed by SelectALPNCallback.
@@ -251,7 +251,7 @@ class CryptoJob : public AsyncWrap, public ThreadPoolWork {
                      CryptoJobMode mode,
                      AdditionalParams&& params)
       : AsyncWrap(env, object, type),
-        ThreadPoolWork(env, "crypto"),
+        ThreadPoolWork(env, "crypto", ThreadPoolWorkClass::kCrypto),
         mode_(mode),
         params_(std::move(params)) {
     // If the CryptoJob is async, then the instance will be
@@ -304,6 +304,11 @@ class CryptoJob : public AsyncWrap, public ThreadPoolWork {
   virtual v8::Maybe<void> ToResult(v8::Local<v8::Value>* err,
                                    v8::Local<v8::Value>* result) = 0;
 
+  // Submits an async job to the threadpool. Jobs that have to wait for
+  // something before they can run override this, and call ScheduleWork()
+  // themselves once they can.
+  virtual void ScheduleAsync() { ThreadPoolWork::ScheduleWork(); }
+
   CryptoJobMode mode() const { return mode_; }
 
   CryptoErrorStore* errors() { return &errors_; }
@@ -325,7 +330,7 @@ class CryptoJob : public AsyncWrap, public ThreadPoolWork {
     CryptoJob<CryptoJobTraits>* job;
     ASSIGN_OR_RETURN_UNWRAP(&job, args.This());
     if (job->mode() == kCryptoJobAsync)
-      return job->ScheduleWork();
+      return job->ScheduleAsync();
 
     v8::Local<v8::Value> ret[2];
     env->PrintSyncTrace();
@@ -366,7 +371,7 @@ class CryptoJob : public AsyncWrap, public ThreadPoolWork {
 };
 
 template <typename DeriveBitsTraits>
-class DeriveBitsJob final : public CryptoJob<DeriveBitsTraits> {
+class DeriveBitsJob : public CryptoJob<DeriveBitsTraits> {
  public:
   using AdditionalParams = typename DeriveBitsTraits::AdditionalParameters;
 
@@ -10,7 +10,9 @@
 #include "util-inl.h"
 #include "v8.h"
 
+#include <list>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 namespace node {
@@ -71,35 +73,89 @@ void ManagedX509::MemoryInfo(MemoryTracker* tracker) const {
 }
 
 namespace {
-MaybeLocal<Value> GetFingerprintDigest(Environment* env,
-                                       const Digest& method,
+// The fields of recently seen certificates, keyed by their SHA-256
+// fingerprints, so that peers presenting the same chain over and over again
+// do not get it decoded every time.
+struct X509FieldsCache {
+  struct Entry {
+    std::shared_ptr<X509Fields> fields;
+    std::list<std::string>::iterator order;
+  };
+
+  static X509FieldsCache* Get() {
+    // Intentionally leaked, like the shared TLS session cache.
+    static X509FieldsCache* cache = new X509FieldsCache();
+    return cache;
+  }
+
+  Mutex mutex;
+  std::unordered_map<std::string, Entry> entries;
+  // Least recently used first.
+  std::list<std::string> order;
+};
+
+std::optional<std::string> ToString(const BIOPointer& bio) {
+  if (!bio) return std::nullopt;
+  BUF_MEM* mem = bio;
+  return std::string(mem->data, mem->length);
+}
+
+std::optional<std::string> DecodeField(X509Fields::Field field,
                                        const X509View& cert) {
-  auto fingerprint = cert.getFingerprint(method);
-  // Returning an empty string indicates that the digest failed for
-  // some reason.
-  if (!fingerprint.has_value()) [[unlikely]] {
-    return Undefined(env->isolate());
+  switch (field) {
+    case X509Fields::kSubject:
+      return ToString(cert.getSubject());
+    case X509Fields::kIssuer:
+      return ToString(cert.getIssuer());
+    case X509Fields::kSubjectAltName:
+      return ToString(cert.getSubjectAltName());
+    case X509Fields::kInfoAccess:
+      return ToString(cert.getInfoAccess());
+    case X509Fields::kValidFrom:
+      return ToString(cert.getValidFrom());
+    case X509Fields::kValidTo:
+      return ToString(cert.getValidTo());
+    case X509Fields::kFingerprint:
+      return cert.getFingerprint(Digest::SHA1);
+    case X509Fields::kFingerprint256:
+      return cert.getFingerprint(Digest::SHA256);
+    case X509Fields::kFingerprint512:
+      return cert.getFingerprint(Digest::SHA512);
+    case X509Fields::kSerialNumber:
+      if (auto serial = cert.getSerialNumber())
+        return std::string(static_cast<const char*>(serial.get()));
+      return std::nullopt;
+    case X509Fields::kFieldCount:
+      break;
   }
-  auto& fp = fingerprint.value();
-  return OneByteString(env->isolate(), fp.data(), fp.length());
+  UNREACHABLE();
+}
+
+MaybeLocal<String> ToV8Value(Environment* env, std::string_view val) {
+  return String::NewFromUtf8(
+      env->isolate(), val.data(), NewStringType::kNormal, val.size());
 }
 
-template <const ncrypto::Digest& algo>
-void Fingerprint(const FunctionCallbackInfo<Value>& args) {
+MaybeLocal<Value> GetField(Environment* env,
+                           X509Fields* fields,
+                           X509Fields::Field field,
+                           const X509View& cert) {
+  const std::string* value = fields->Get(field, cert);
+  if (value == nullptr) return Undefined(env->isolate());
+  return ToV8Value(env, *value);
+}
+
+template <X509Fields::Field field>
+void CachedField(const FunctionCallbackInfo<Value>& args) {
   Environment* env = Environment::GetCurrent(args);
   X509Certificate* cert;
   ASSIGN_OR_RETURN_UNWRAP(&cert, args.This());
   Local<Value> ret;
-  if (GetFingerprintDigest(env, algo, cert->view()).ToLocal(&ret)) {
+  if (GetField(env, cert->fields(), field, cert->view()).ToLocal(&ret)) {
     args.GetReturnValue().Set(ret);
   }
 }
 
-MaybeLocal<String> ToV8Value(Environment* env, std::string_view val) {
-  return String::NewFromUtf8(
-      env->isolate(), val.data(), NewStringType::kNormal, val.size());
-}
-
 MaybeLocal<Value> ToV8Value(Local<Context> context, BIOPointer&& bio) {
   if (!bio) [[unlikely]]
     return {};
@@ -172,49 +228,6 @@ MaybeLocal<Value> GetDer(Environment* env, const X509View& view) {
   return ret;
 }
 
-MaybeLocal<Value> GetSubjectAltNameString(Environment* env,
-                                          const X509View& view) {
-  Local<Value> ret;
-  auto bio = view.getSubjectAltName();
-  if (!bio) [[unlikely]]
-    return Undefined(env->isolate());
-  if (!ToV8Value(env->context(), bio).ToLocal(&ret)) return {};
-  return ret;
-}
-
-MaybeLocal<Value> GetInfoAccessString(Environment* env, const X509View& view) {
-  Local<Value> ret;
-  auto bio = view.getInfoAccess();
-  if (!bio) [[unlikely]]
-    return Undefined(env->isolate());
-  if (!ToV8Value(env->context(), bio).ToLocal(&ret)) {
-    return {};
-  }
-  return ret;
-}
-
-MaybeLocal<Value> GetValidFrom(Environment* env, const X509View& view) {
-  Local<Value> ret;
-  auto bio = view.getValidFrom();
-  if (!bio) [[unlikely]]
-    return Undefined(env->isolate());
-  if (!ToV8Value(env->context(), bio).ToLocal(&ret)) {
-    return {};
-  }
-  return ret;
-}
-
-MaybeLocal<Value> GetValidTo(Environment* env, const X509View& view) {
-  Local<Value> ret;
-  auto bio = view.getValidTo();
-  if (!bio) [[unlikely]]
-    return Undefined(env->isolate());
-  if (!ToV8Value(env->context(), bio).ToLocal(&ret)) {
-    return {};
-  }
-  return ret;
-}
-
 MaybeLocal<Value> GetValidFromDate(Environment* env, const X509View& view) {
   int64_t validFromTime = view.getValidFromTime();
   return Date::New(env->context(), validFromTime * 1000.);
@@ -225,14 +238,6 @@ MaybeLocal<Value> GetValidToDate(Environment* env, const X509View& view) {
   return Date::New(env->context(), validToTime * 1000.);
 }
 
-MaybeLocal<Value> GetSerialNumber(Environment* env, const X509View& view) {
-  if (auto serial = view.getSerialNumber()) {
-    return OneByteString(env->isolate(),
-                         static_cast<unsigned char*>(serial.get()));
-  }
-  return Undefined(env->isolate());
-}
-
 MaybeLocal<Value> GetKeyUsage(Environment* env, const X509View& cert) {
   LocalVector<Value> vec(env->isolate());
   bool res = cert.enumUsages([&](std::string_view view) {
@@ -262,65 +267,16 @@ void Der(const FunctionCallbackInfo<Value>& args) {
   }
 }
 
-void Subject(const FunctionCallbackInfo<Value>& args) {
-  Environment* env = Environment::GetCurrent(args);
-  X509Certificate* cert;
-  ASSIGN_OR_RETURN_UNWRAP(&cert, args.This());
-  Local<Value> ret;
-  if (ToV8Value(env->context(), cert->view().getSubject()).ToLocal(&ret)) {
-    args.GetReturnValue().Set(ret);
-  }
-}
-
-void SubjectAltName(const FunctionCallbackInfo<Value>& args) {
-  Environment* env = Environment::GetCurrent(args);
-  X509Certificate* cert;
-  ASSIGN_OR_RETURN_UNWRAP(&cert, args.This());
-  Local<Value> ret;
-  if (GetSubjectAltNameString(env, cert->view()).ToLocal(&ret)) {
-    args.GetReturnValue().Set(ret);
-  }
-}
-
-void Issuer(const FunctionCallbackInfo<Value>& args) {
-  Environment* env = Environment::GetCurrent(args);
-  X509Certificate* cert;
-  ASSIGN_OR_RETURN_UNWRAP(&cert, args.This());
-  Local<Value> ret;
-  if (ToV8Value(env->context(), cert->view().getIssuer()).ToLocal(&ret)) {
-    args.GetReturnValue().Set(ret);
-  }
-}
-
-void InfoAccess(const FunctionCallbackInfo<Value>& args) {
-  Environment* env = Environment::GetCurrent(args);
-  X509Certificate* cert;
-  ASSIGN_OR_RETURN_UNWRAP(&cert, args.This());
-  Local<Value> ret;
-  if (GetInfoAccessString(env, cert->view()).ToLocal(&ret)) {
-    args.GetReturnValue().Set(ret);
-  }
-}
-
-void ValidFrom(const FunctionCallbackInfo<Value>& args) {
-  Environment* env = Environment::GetCurrent(args);
-  X509Certificate* cert;
-  ASSIGN_OR_RETURN_UNWRAP(&cert, args.This());
-  Local<Value> ret;
-  if (GetValidFrom(env, cert->view()).ToLocal(&ret)) {
-    args.GetReturnValue().Set(ret);
-  }
-}
-
-void ValidTo(const FunctionCallbackInfo<Value>& args) {
-  Environment* env = Environment::GetCurrent(args);
-  X509Certificate* cert;
-  ASSIGN_OR_RETURN_UNWRAP(&cert, args.This());
-  Local<Value> ret;
-  if (GetValidTo(env, cert->view()).ToLocal(&ret)) {
-    args.GetReturnValue().Set(ret);
-  }
-}
+constexpr auto Subject = CachedField<X509Fields::kSubject>;
+constexpr auto SubjectAltName = CachedField<X509Fields::kSubjectAltName>;
+constexpr auto Issuer = CachedField<X509Fields::kIssuer>;
+constexpr auto InfoAccess = CachedField<X509Fields::kInfoAccess>;
+constexpr auto ValidFrom = CachedField<X509Fields::kValidFrom>;
+constexpr auto ValidTo = CachedField<X509Fields::kValidTo>;
+constexpr auto Fingerprint = CachedField<X509Fields::kFingerprint>;
+constexpr auto Fingerprint256 = CachedField<X509Fields::kFingerprint256>;
+constexpr auto Fingerprint512 = CachedField<X509Fields::kFingerprint512>;
+constexpr auto SerialNumber = CachedField<X509Fields::kSerialNumber>;
 
 void ValidFromDate(const FunctionCallbackInfo<Value>& args) {
   Environment* env = Environment::GetCurrent(args);
@@ -342,16 +298,6 @@ void ValidToDate(const FunctionCallbackInfo<Value>& args) {
   }
 }
 
-void SerialNumber(const FunctionCallbackInfo<Value>& args) {
-  Environment* env = Environment::GetCurrent(args);
-  X509Certificate* cert;
-  ASSIGN_OR_RETURN_UNWRAP(&cert, args.This());
-  Local<Value> ret;
-  if (GetSerialNumber(env, cert->view()).ToLocal(&ret)) {
-    args.GetReturnValue().Set(ret);
-  }
-}
-
 void PublicKey(const FunctionCallbackInfo<Value>& args) {
   Environment* env = Environment::GetCurrent(args);
   X509Certificate* cert;
@@ -689,7 +635,9 @@ MaybeLocal<Value> GetCurveName(Environment* env, const int nid) {
                      : MaybeLocal<Value>(Undefined(env->isolate()));
 }
 
-MaybeLocal<Object> X509ToObject(Environment* env, const X509View& cert) {
+MaybeLocal<Object> X509ToObject(Environment* env,
+                                const X509View& cert,
+                                X509Fields* fields) {
   EscapableHandleScope scope(env->isolate());
   Local<Object> info = Object::New(env->isolate());
 
@@ -704,11 +652,11 @@ MaybeLocal<Object> X509ToObject(Environment* env, const X509View& cert) {
       !Set<Value>(env,
                   info,
                   env->subjectaltname_string(),
-                  GetSubjectAltNameString(env, cert)) ||
+                  GetField(env, fields, X509Fields::kSubjectAltName, cert)) ||
       !Set<Value>(env,
                   info,
                   env->infoaccess_string(),
-                  GetInfoAccessString(env, cert)) ||
+                  GetField(env, fields, X509Fields::kInfoAccess, cert)) ||
       !Set<Boolean>(env,
                     info,
                     env->ca_string(),
@@ -776,25 +724,32 @@ MaybeLocal<Object> X509ToObject(Environment* env, const X509View& cert) {
     return {};
   }
 
-  if (!Set<Value>(
-          env, info, env->valid_from_string(), GetValidFrom(env, cert)) ||
-      !Set<Value>(env, info, env->valid_to_string(), GetValidTo(env, cert)) ||
+  if (!Set<Value>(env,
+                  info,
+                  env->valid_from_string(),
+                  GetField(env, fields, X509Fields::kValidFrom, cert)) ||
+      !Set<Value>(env,
+                  info,
+                  env->valid_to_string(),
+                  GetField(env, fields, X509Fields::kValidTo, cert)) ||
       !Set<Value>(env,
                   info,
                   env->fingerprint_string(),
-                  GetFingerprintDigest(env, Digest::SHA1, cert)) ||
+                  GetField(env, fields, X509Fields::kFingerprint, cert)) ||
       !Set<Value>(env,
                   info,
                   env->fingerprint256_string(),
-                  GetFingerprintDigest(env, Digest::SHA256, cert)) ||
+                  GetField(env, fields, X509Fields::kFingerprint256, cert)) ||
       !Set<Value>(env,
                   info,
                   env->fingerprint512_string(),
-                  GetFingerprintDigest(env, Digest::SHA512, cert)) ||
+                  GetField(env, fields, X509Fields::kFingerprint512, cert)) ||
       !Set<Value>(
           env, info, env->ext_key_usage_string(), GetKeyUsage(env, cert)) ||
-      !Set<Value>(
-          env, info, env->serial_number_string(), GetSerialNumber(env, cert)) ||
+      !Set<Value>(env,
+                  info,
+                  env->serial_number_string(),
+                  GetField(env, fields, X509Fields::kSerialNumber, cert)) ||
       !Set<Value>(env, info, env->raw_string(), GetDer(env, cert)))
       [[unlikely]] {
     return {};
@@ -804,6 +759,54 @@ MaybeLocal<Object> X509ToObject(Environment* env, const X509View& cert) {
 }
 }  // namespace
 
+std::shared_ptr<X509Fields> X509Fields::For(const X509View& cert) {
+  ClearErrorOnReturn clear_error_on_return;
+  std::optional<std::string> fingerprint = cert.getFingerprint(Digest::SHA256);
+  // Certificates that cannot be encoded are not shared.
+  if (!fingerprint.has_value()) [[unlikely]]
+    return std::make_shared<X509Fields>();
+
+  X509FieldsCache* cache = X509FieldsCache::Get();
+  Mutex::ScopedLock lock(cache->mutex);
+  auto it = cache->entries.find(*fingerprint);
+  if (it != cache->entries.end()) {
+    cache->order.splice(cache->order.end(), cache->order, it->second.order);
+    return it->second.fields;
+  }
+
+  auto fields = std::make_shared<X509Fields>();
+  // The key is a field as well.
+  fields->values_[kFingerprint256] = *fingerprint;
+  fields->decoded_.set(kFingerprint256);
+  while (cache->entries.size() >= kMaxCachedCertificates) {
+    cache->entries.erase(cache->order.front());
+    cache->order.pop_front();
+  }
+  cache->order.push_back(*fingerprint);
+  cache->entries.emplace(
+      std::move(*fingerprint),
+      X509FieldsCache::Entry{fields, std::prev(cache->order.end())});
+  return fields;
+}
+
+const std::string* X509Fields::Get(Field field, const X509View& cert) {
+  {
+    Mutex::ScopedLock lock(mutex_);
+    if (decoded_.test(field))
+      return values_[field] ? &*values_[field] : nullptr;
+  }
+  // Decode without holding the lock. Should another thread get there first,
+  // its result is kept, as it is the same.
+  ClearErrorOnReturn clear_error_on_return;
+  std::optional<std::string> value = DecodeField(field, cert);
+  Mutex::ScopedLock lock(mutex_);
+  if (!decoded_.test(field)) {
+    values_[field] = std::move(value);
+    decoded_.set(field);
+  }
+  return values_[field] ? &*values_[field] : nullptr;
+}
+
 Local<FunctionTemplate> X509Certificate::GetConstructorTemplate(
     Environment* env) {
   Local<FunctionTemplate> tmpl = env->x509_constructor_template();
@@ -822,12 +825,11 @@ Local<FunctionTemplate> X509Certificate::GetConstructorTemplate(
     SetProtoMethodNoSideEffect(isolate, tmpl, "validFrom", ValidFrom);
     SetProtoMethodNoSideEffect(isolate, tmpl, "validToDate", ValidToDate);
     SetProtoMethodNoSideEffect(isolate, tmpl, "validFromDate", ValidFromDate);
+    SetProtoMethodNoSideEffect(isolate, tmpl, "fingerprint", Fingerprint);
     SetProtoMethodNoSideEffect(
-        isolate, tmpl, "fingerprint", Fingerprint<Digest::SHA1>);
-    SetProtoMethodNoSideEffect(
-        isolate, tmpl, "fingerprint256", Fingerprint<Digest::SHA256>);
+        isolate, tmpl, "fingerprint256", Fingerprint256);
     SetProtoMethodNoSideEffect(
-        isolate, tmpl, "fingerprint512", Fingerprint<Digest::SHA512>);
+        isolate, tmpl, "fingerprint512", Fingerprint512);
     SetProtoMethodNoSideEffect(isolate, tmpl, "keyUsage", KeyUsage);
     SetProtoMethodNoSideEffect(isolate, tmpl, "serialNumber", SerialNumber);
     SetProtoMethodNoSideEffect(isolate, tmpl, "pem", Pem);
@@ -920,15 +922,23 @@ MaybeLocal<Object> X509Certificate::GetPeerCert(Environment* env,
                                 : New(env, std::move(cert));
 }
 
+X509Fields* X509Certificate::fields() {
+  if (!fields_) fields_ = X509Fields::For(view());
+  return fields_.get();
+}
+
 v8::MaybeLocal<v8::Value> X509Certificate::toObject(Environment* env) {
-  return toObject(env, view());
+  if (!view()) [[unlikely]]
+    return {};
+  return X509ToObject(env, view(), fields()).FromMaybe(Local<Value>());
 }
 
 v8::MaybeLocal<v8::Value> X509Certificate::toObject(Environment* env,
                                                     const X509View& cert) {
   if (!cert) [[unlikely]]
     return {};
-  return X509ToObject(env, cert).FromMaybe(Local<Value>());
+  std::shared_ptr<X509Fields> fields = X509Fields::For(cert);
+  return X509ToObject(env, cert, fields.get()).FromMaybe(Local<Value>());
 }
 
 X509Certificate::X509Certificate(Environment* env,
@@ -996,9 +1006,9 @@ void X509Certificate::RegisterExternalReferences(
   registry->Register(ValidFrom);
   registry->Register(ValidToDate);
   registry->Register(ValidFromDate);
-  registry->Register(Fingerprint<Digest::SHA1>);
-  registry->Register(Fingerprint<Digest::SHA256>);
-  registry->Register(Fingerprint<Digest::SHA512>);
+  registry->Register(Fingerprint);
+  registry->Register(Fingerprint256);
+  registry->Register(Fingerprint512);
   registry->Register(KeyUsage);
   registry->Register(SerialNumber);
   registry->Register(Pem);
@@ -8,9 +8,16 @@
 #include "env.h"
 #include "memory_tracker.h"
 #include "ncrypto.h"
+#include "node_mutex.h"
 #include "node_worker.h"
 #include "v8.h"
 
+#include <array>
+#include <bitset>
+#include <memory>
+#include <optional>
+#include <string>
+
 namespace node {
 namespace crypto {
 
@@ -38,6 +45,45 @@ class ManagedX509 final : public MemoryRetainer {
   ncrypto::X509Pointer cert_;
 };
 
+// Text forms of the certificate fields that are costly to decode. Each one
+// is decoded the first time it is needed. They do not depend on any
+// Environment, so all X509Certificate instances of the same certificate
+// share them, on every thread.
+class X509Fields final {
+ public:
+  enum Field {
+    kSubject,
+    kIssuer,
+    kSubjectAltName,
+    kInfoAccess,
+    kValidFrom,
+    kValidTo,
+    kFingerprint,
+    kFingerprint256,
+    kFingerprint512,
+    kSerialNumber,
+    kFieldCount
+  };
+
+  // The number of certificates whose fields are kept by the process-wide
+  // cache. The least recently used ones are evicted first.
+  static constexpr size_t kMaxCachedCertificates = 1024;
+
+  // Returns the fields of the certificate, shared with every certificate of
+  // the same DER encoding that is still in the process-wide cache.
+  static std::shared_ptr<X509Fields> For(const ncrypto::X509View& cert);
+
+  // Returns the field, decoding it from cert on first use, or nullptr if
+  // the certificate does not have the field. cert must be the certificate
+  // that the fields belong to.
+  const std::string* Get(Field field, const ncrypto::X509View& cert);
+
+ private:
+  Mutex mutex_;
+  std::bitset<kFieldCount> decoded_;
+  std::array<std::optional<std::string>, kFieldCount> values_;
+};
+
 class X509Certificate final : public BaseObject {
  public:
   enum class GetPeerCertificateFlag {
@@ -79,6 +125,9 @@ class X509Certificate final : public BaseObject {
   inline ncrypto::X509View view() const { return *cert_; }
   inline X509* get() { return cert_->get(); }
 
+  // Looked up in the process-wide cache on first use.
+  X509Fields* fields();
+
   v8::MaybeLocal<v8::Value> toObject(Environment* env);
   static v8::MaybeLocal<v8::Value> toObject(Environment* env,
                                             const ncrypto::X509View& cert);
@@ -116,6 +165,7 @@ class X509Certificate final : public BaseObject {
                   v8::Local<v8::Object> issuer_chain = v8::Local<v8::Object>());
 
   std::shared_ptr<ManagedX509> cert_;
+  std::shared_ptr<X509Fields> fields_;
   BaseObjectPtr<X509Certificate> issuer_cert_;
 };
 
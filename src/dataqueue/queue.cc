@@ -34,6 +34,70 @@ class NonIdempotentDataQueueReader;
 class EntryImpl : public DataQueue::Entry {
  public:
   virtual std::shared_ptr<DataQueue::Reader> get_reader() = 0;
+
+  // Entries whose data is resident in memory return it here, so that
+  // readers can hand out the data of several of them at once without
+  // creating a reader for each.
+  virtual bool GetMemoryResidentData(DataQueue::Vec* vec,
+                                     std::shared_ptr<BackingStore>* store) {
+    return false;
+  }
+
+  // Appends the non-empty chunks of an entry whose data is all resident in
+  // memory. A DataQueueEntry, such as a Blob made of other Blobs, adds the
+  // chunks of every entry of its queue.
+  virtual bool AppendMemoryResidentData(
+      std::vector<DataQueue::Vec>* vecs,
+      std::vector<std::shared_ptr<BackingStore>>* stores) {
+    DataQueue::Vec vec;
+    std::shared_ptr<BackingStore> store;
+    if (!GetMemoryResidentData(&vec, &store)) return false;
+    if (vec.len > 0) {
+      vecs->push_back(vec);
+      stores->push_back(std::move(store));
+    }
+    return true;
+  }
+};
+
+// The data of consecutive memory resident entries, for pulls with
+// bob::OPTIONS_GATHER.
+struct GatheredEntries {
+  std::vector<DataQueue::Vec> vecs;
+  std::vector<std::shared_ptr<BackingStore>> stores;
+  size_t entry_count = 0;
+  uint64_t byte_length = 0;
+
+  // Collects entries from [begin, end) until one that is not memory resident
+  // or whose chunks would exceed max_count.
+  template <typename Iterator>
+  void Gather(Iterator begin, Iterator end, size_t max_count) {
+    for (Iterator it = begin; it != end; ++it) {
+      const size_t vec_count = vecs.size();
+      if (!static_cast<EntryImpl&>(**it).AppendMemoryResidentData(&vecs,
+                                                                  &stores))
+        break;
+      if (vecs.size() > max_count) {
+        vecs.resize(vec_count);
+        stores.resize(vec_count);
+        break;
+      }
+      for (size_t i = vec_count; i < vecs.size(); i++)
+        byte_length += vecs[i].len;
+      entry_count++;
+    }
+  }
+
+  // Delivers the gathered data. The backing stores are kept alive until the
+  // consumer is done with the data.
+  void Deliver(DataQueue::Reader::Next next) {
+    std::move(next)(bob::Status::STATUS_CONTINUE,
+                    vecs.empty() ? nullptr : vecs.data(),
+                    vecs.size(),
+                    [stores = std::move(stores)](uint64_t) mutable {
+                      stores.clear();
+                    });
+  }
 };
 
 class DataQueueImpl final : public DataQueue,
@@ -103,15 +167,40 @@ class DataQueueImpl final : public DataQueue,
     return std::make_shared<DataQueueImpl>(std::move(slices), len);
   }
 
-  std::optional<uint64_t> size() const override { return size_; }
+  std::optional<uint64_t> size() const override {
+    Mutex::ScopedLock lock(mutex_);
+    return size_;
+  }
 
   bool is_idempotent() const override { return idempotent_; }
 
-  bool is_capped() const override { return capped_size_.has_value(); }
+  // Appends the chunks of an idempotent queue whose entries are all resident
+  // in memory, for a DataQueueEntry that wraps it.
+  bool AppendMemoryResidentData(
+      std::vector<Vec>* vecs,
+      std::vector<std::shared_ptr<BackingStore>>* stores) {
+    if (!idempotent_) return false;
+    const size_t vec_count = vecs->size();
+    for (const auto& entry : entries_) {
+      if (!static_cast<EntryImpl&>(*entry).AppendMemoryResidentData(vecs,
+                                                                    stores)) {
+        vecs->resize(vec_count);
+        stores->resize(vec_count);
+        return false;
+      }
+    }
+    return true;
+  }
+
+  bool is_capped() const override {
+    Mutex::ScopedLock lock(mutex_);
+    return capped_size_.has_value();
+  }
 
   std::optional<bool> append(std::unique_ptr<Entry> entry) override {
     if (idempotent_) return std::nullopt;
     if (!entry) return false;
+    Mutex::ScopedLock lock(mutex_);
 
     // If this entry successfully provides a size, we can add it to our size_
     // if that has a value, otherwise, we keep uint64_t empty.
@@ -137,6 +226,7 @@ class DataQueueImpl final : public DataQueue,
 
   void cap(uint64_t limit = 0) override {
     if (is_idempotent()) return;
+    Mutex::ScopedLock lock(mutex_);
     // If the data queue is already capped, it is possible to call
     // cap again with a smaller size.
     if (capped_size_.has_value()) {
@@ -149,6 +239,7 @@ class DataQueueImpl final : public DataQueue,
   }
 
   std::optional<uint64_t> maybeCapRemaining() const override {
+    Mutex::ScopedLock lock(mutex_);
     if (capped_size_.has_value() && size_.has_value()) {
       uint64_t capped_size = capped_size_.value();
       uint64_t size = size_.value();
@@ -158,6 +249,7 @@ class DataQueueImpl final : public DataQueue,
   }
 
   void MemoryInfo(node::MemoryTracker* tracker) const override {
+    Mutex::ScopedLock lock(mutex_);
     tracker->TrackField(
         "entries", entries_, "std::vector<std::unique_ptr<Entry>>");
   }
@@ -165,15 +257,19 @@ class DataQueueImpl final : public DataQueue,
   void addBackpressureListener(BackpressureListener* listener) override {
     if (idempotent_) return;
     DCHECK_NOT_NULL(listener);
+    Mutex::ScopedLock lock(mutex_);
     backpressure_listeners_.insert(listener);
   }
 
   void removeBackpressureListener(BackpressureListener* listener) override {
     if (idempotent_) return;
     DCHECK_NOT_NULL(listener);
+    Mutex::ScopedLock lock(mutex_);
     backpressure_listeners_.erase(listener);
   }
 
+  // NotifyBackpressure() and HasBackpressureListeners() must be called with
+  // mutex_ held.
   void NotifyBackpressure(size_t amount) {
     if (idempotent_) return;
     for (auto& listener : backpressure_listeners_) listener->EntryRead(amount);
@@ -193,6 +289,9 @@ class DataQueueImpl final : public DataQueue,
   std::optional<uint64_t> size_ = std::nullopt;
   std::optional<uint64_t> capped_size_ = std::nullopt;
   bool locked_to_reader_ = false;
+  // Guards the state of non-idempotent queues, which can be appended to and
+  // read from different threads. Idempotent queues are immutable.
+  mutable Mutex mutex_;
 
   std::unordered_set<BackpressureListener*> backpressure_listeners_;
 
@@ -251,6 +350,20 @@ class IdempotentDataQueueReader final
       current_index_ = 0;
     }
 
+    if ((options & bob::OPTIONS_GATHER) && current_reader_ == nullptr) {
+      auto& entries = data_queue_->entries_;
+      GatheredEntries gathered;
+      gathered.Gather(entries.begin() + current_index_.value(),
+                      entries.end(),
+                      std::max<size_t>(max_count_hint, 1));
+      if (gathered.entry_count > 0) {
+        current_index_ = current_index_.value() + gathered.entry_count;
+        if (current_index_.value() == entries.size()) ended_ = true;
+        gathered.Deliver(std::move(next));
+        return bob::Status::STATUS_CONTINUE;
+      }
+    }
+
     // We have current_index_, awesome, we are going to keep reading from
     // it until we receive and end.
 
@@ -388,6 +501,16 @@ class NonIdempotentDataQueueReader final
       return bob::Status::STATUS_EOS;
     }
 
+    // The queue may be appended to from another thread. The lock is dropped
+    // whenever we call out, so that next() and the entry readers are free
+    // to use the DataQueue again.
+    Mutex::ScopedLock lock(data_queue_->mutex_);
+    auto respond = [&](int status) {
+      Mutex::ScopedUnlock unlock(lock);
+      std::move(next)(status, nullptr, 0, [](uint64_t) {});
+      return status;
+    };
+
     // If the collection of entries is empty, there's nothing currently left to
     // read. How we respond depends on whether the data queue has been capped
     // or not.
@@ -396,22 +519,19 @@ class NonIdempotentDataQueueReader final
       // expect more data to be provided later, but we don't know exactly when
       // that'll happe, so the proper response here is to return a blocked
       // status.
-      if (!data_queue_->is_capped()) {
-        std::move(next)(bob::Status::STATUS_BLOCK, nullptr, 0, [](uint64_t) {});
-        return bob::STATUS_BLOCK;
+      if (!data_queue_->capped_size_.has_value()) {
+        return respond(bob::STATUS_BLOCK);
       }
 
       // However, if we are capped, the status will depend on whether the size
       // of the data_queue_ is known or not.
 
-      if (data_queue_->size().has_value()) {
+      if (data_queue_->size_.has_value()) {
         // If the size is known, and it is still less than the cap, then we
         // still might get more data. We just don't know exactly when that'll
         // come, so let's return a blocked status.
-        if (data_queue_->size().value() < data_queue_->capped_size_.value()) {
-          std::move(next)(
-              bob::Status::STATUS_BLOCK, nullptr, 0, [](uint64_t) {});
-          return bob::STATUS_BLOCK;
+        if (data_queue_->size_.value() < data_queue_->capped_size_.value()) {
+          return respond(bob::STATUS_BLOCK);
         }
 
         // Otherwise, if size is equal to or greater than capped, we are done.
@@ -423,58 +543,87 @@ class NonIdempotentDataQueueReader final
       // entries, we're done. There's nothing left to read.
       current_reader_ = nullptr;
       ended_ = true;
-      std::move(next)(bob::Status::STATUS_EOS, nullptr, 0, [](uint64_t) {});
-      return bob::STATUS_EOS;
+      return respond(bob::STATUS_EOS);
+    }
+
+    if ((options & bob::OPTIONS_GATHER) && current_reader_ == nullptr) {
+      auto& entries = data_queue_->entries_;
+      GatheredEntries gathered;
+      gathered.Gather(
+          entries.begin(), entries.end(), std::max<size_t>(max_count_hint, 1));
+      if (gathered.entry_count > 0) {
+        // Destroying the entries does not call out, and the backing stores
+        // stay alive in gathered.
+        entries.erase(entries.begin(), entries.begin() + gathered.entry_count);
+        if (data_queue_->HasBackpressureListeners()) {
+          data_queue_->NotifyBackpressure(gathered.byte_length);
+        }
+        Mutex::ScopedUnlock unlock(lock);
+        gathered.Deliver(std::move(next));
+        return bob::Status::STATUS_CONTINUE;
+      }
     }
 
     auto current_reader = getCurrentReader();
     if (current_reader == nullptr) {
-      std::move(next)(UV_EINVAL, nullptr, 0, [](uint64_t) {});
-      return UV_EINVAL;
+      return respond(UV_EINVAL);
     }
 
-    // If we got here, we have an entry to read from.
+    // If we got here, we have an entry to read from. Only this reader removes
+    // entries, so the current one stays put while the lock is released.
     CHECK(!pull_pending_);
     pull_pending_ = true;
-    int status = current_reader->Pull(
-        [this, next = std::move(next)](
-            int status, const DataQueue::Vec* vecs, uint64_t count, Done done) {
-          pull_pending_ = false;
-
-          // In each of these cases, we do not expect that the source will
-          // actually have provided any actual data.
-          CHECK_IMPLIES(status == bob::Status::STATUS_BLOCK ||
-                            status == bob::Status::STATUS_WAIT ||
-                            status == bob::Status::STATUS_EOS,
-                        vecs == nullptr && count == 0);
-          if (status == bob::Status::STATUS_EOS) {
-            data_queue_->entries_.erase(data_queue_->entries_.begin());
-            ended_ = data_queue_->entries_.empty();
-            current_reader_ = nullptr;
-            if (!ended_) status = bob::Status::STATUS_CONTINUE;
-            std::move(next)(status, nullptr, 0, [](uint64_t) {});
-            return;
-          }
+    int status;
+    {
+      Mutex::ScopedUnlock unlock(lock);
+      status = current_reader->Pull(
+          [this, next = std::move(next)](int status,
+                                         const DataQueue::Vec* vecs,
+                                         uint64_t count,
+                                         Done done) {
+            pull_pending_ = false;
+
+            // In each of these cases, we do not expect that the source will
+            // actually have provided any actual data.
+            CHECK_IMPLIES(status == bob::Status::STATUS_BLOCK ||
+                              status == bob::Status::STATUS_WAIT ||
+                              status == bob::Status::STATUS_EOS,
+                          vecs == nullptr && count == 0);
+            if (status == bob::Status::STATUS_EOS) {
+              {
+                Mutex::ScopedLock lock(data_queue_->mutex_);
+                data_queue_->entries_.erase(data_queue_->entries_.begin());
+                ended_ = data_queue_->entries_.empty();
+              }
+              current_reader_ = nullptr;
+              if (!ended_) status = bob::Status::STATUS_CONTINUE;
+              std::move(next)(status, nullptr, 0, [](uint64_t) {});
+              return;
+            }
 
-          // If there is a backpressure listener, lets report on how much data
-          // was actually read.
-          if (data_queue_->HasBackpressureListeners()) {
-            // How much did we actually read?
-            size_t read = 0;
-            for (uint64_t n = 0; n < count; n++) {
-              read += vecs[n].len;
+            // If there is a backpressure listener, lets report on how much
+            // data was actually read.
+            {
+              Mutex::ScopedLock lock(data_queue_->mutex_);
+              if (data_queue_->HasBackpressureListeners()) {
+                // How much did we actually read?
+                size_t read = 0;
+                for (uint64_t n = 0; n < count; n++) {
+                  read += vecs[n].len;
+                }
+                data_queue_->NotifyBackpressure(read);
+              }
             }
-            data_queue_->NotifyBackpressure(read);
-          }
 
-          // Now that we have updated this readers state, we can forward
-          // everything on to the outer next.
-          std::move(next)(status, vecs, count, std::move(done));
-        },
-        options,
-        data,
-        count,
-        max_count_hint);
+            // Now that we have updated this readers state, we can forward
+            // everything on to the outer next.
+            std::move(next)(status, vecs, count, std::move(done));
+          },
+          options,
+          data,
+          count,
+          max_count_hint);
+    }
 
     if (!pull_pending_) {
       // The callback was resolved synchronously. Let's check our status.
@@ -500,6 +649,7 @@ class NonIdempotentDataQueueReader final
     return status;
   }
 
+  // Must be called with the mutex of the DataQueue held.
   DataQueue::Reader* getCurrentReader() {
     CHECK(!ended_);
     CHECK(!data_queue_->entries_.empty());
@@ -526,6 +676,7 @@ std::shared_ptr<DataQueue::Reader> DataQueueImpl::get_reader() {
     return std::make_shared<IdempotentDataQueueReader>(shared_from_this());
   }
 
+  Mutex::ScopedLock lock(mutex_);
   if (locked_to_reader_) return nullptr;
   locked_to_reader_ = true;
 
@@ -577,6 +728,12 @@ class EmptyEntry final : public EntryImpl {
     return std::make_shared<EmptyReader>();
   }
 
+  bool GetMemoryResidentData(DataQueue::Vec* vec,
+                             std::shared_ptr<BackingStore>* store) override {
+    *vec = {nullptr, 0};
+    return true;
+  }
+
   std::unique_ptr<Entry> slice(
       uint64_t start,
       std::optional<uint64_t> maybeEnd = std::nullopt) override {
@@ -665,6 +822,14 @@ class InMemoryEntry final : public EntryImpl {
     return std::make_shared<InMemoryReader>(*this);
   }
 
+  bool GetMemoryResidentData(DataQueue::Vec* vec,
+                             std::shared_ptr<BackingStore>* store) override {
+    *vec = {static_cast<uint8_t*>(backing_store_->Data()) + offset_,
+            byte_length_};
+    *store = backing_store_;
+    return true;
+  }
+
   std::unique_ptr<Entry> slice(
       uint64_t start,
       std::optional<uint64_t> maybeEnd = std::nullopt) override {
@@ -760,6 +925,13 @@ class DataQueueEntry : public EntryImpl {
   // must fail with an error when a variance is detected.
   bool is_idempotent() const override { return data_queue_->is_idempotent(); }
 
+  bool AppendMemoryResidentData(
+      std::vector<DataQueue::Vec>* vecs,
+      std::vector<std::shared_ptr<BackingStore>>* stores) override {
+    return static_cast<DataQueueImpl&>(*data_queue_)
+        .AppendMemoryResidentData(vecs, stores);
+  }
+
   void MemoryInfo(node::MemoryTracker* tracker) const override {
     tracker->TrackField(
         "data_queue", data_queue_, "std::shared_ptr<DataQueue>");
@@ -808,13 +980,14 @@ class DataQueueEntry : public EntryImpl {
 // a tolerable risk here. While FdEntry is considered idempotent, this race
 // means that it is indeed possible for multiple reads to return different
 // results if the file just happens to get modified.
+// Readers use the FileHandle and the event loop of the Environment the
+// entry was created in, so they must be created, pulled from and destroyed
+// on that Environment's thread, even when the queue is shared with another
+// thread.
 class FdEntry final : public EntryImpl {
   // TODO(@jasnell, @flakey5):
   // * This should only allow reading from regular files. No directories, no
   // pipes, etc.
-  // * The reader should support accepting the buffer(s) from the pull, if any.
-  // It should
-  //   only allocate a managed buffer if the pull doesn't provide any.
   // * We might want to consider making the stat on each read sync to eliminate
   // the race
   //   condition described in the comment above.
@@ -836,15 +1009,10 @@ class FdEntry final : public EntryImpl {
           uv_stat_t stat,
           uint64_t start,
           uint64_t end)
-      : env_(env),
-        path_(std::move(path_)),
-        stat_(stat),
-        start_(start),
-        end_(end) {
-    CHECK_LE(start, end);
-  }
+      : FdEntry(env, std::move(path_), stat, start, end, uv_thread_self()) {}
 
   std::shared_ptr<DataQueue::Reader> get_reader() override {
+    CheckThread(thread_);
     return ReaderImpl::Create(this);
   }
 
@@ -859,7 +1027,8 @@ class FdEntry final : public EntryImpl {
     CHECK(new_start >= start_);
     CHECK(new_end <= end_);
 
-    return std::make_unique<FdEntry>(env_, path_, stat_, new_start, new_end);
+    return std::unique_ptr<FdEntry>(
+        new FdEntry(env_, path_, stat_, new_start, new_end, thread_));
   }
 
   std::optional<uint64_t> size() const override { return end_ - start_; }
@@ -873,11 +1042,33 @@ class FdEntry final : public EntryImpl {
   SET_SELF_SIZE(FdEntry)
 
  private:
+  FdEntry(Environment* env,
+          std::shared_ptr<BufferValue> path_,
+          uv_stat_t stat,
+          uint64_t start,
+          uint64_t end,
+          uv_thread_t thread)
+      : env_(env),
+        path_(std::move(path_)),
+        stat_(stat),
+        start_(start),
+        end_(end),
+        thread_(thread) {
+    CHECK_LE(start, end);
+  }
+
+  static void CheckThread(const uv_thread_t& thread) {
+    uv_thread_t self = uv_thread_self();
+    CHECK(uv_thread_equal(&self, &thread));
+  }
+
   Environment* env_;
   std::shared_ptr<BufferValue> path_;
   uv_stat_t stat_;
   uint64_t start_ = 0;
   uint64_t end_ = 0;
+  // The thread of env_.
+  uv_thread_t thread_;
 
   bool is_modified(const uv_stat_t& other) {
     return other.st_size != stat_.st_size ||
@@ -922,24 +1113,44 @@ class FdEntry final : public EntryImpl {
     }
 
     explicit ReaderImpl(BaseObjectPtr<fs::FileHandle> handle, FdEntry* entry)
-        : env_(handle->env()), handle_(std::move(handle)), entry_(entry) {
+        : env_(handle->env()),
+          handle_(std::move(handle)),
+          entry_(entry),
+          thread_(entry->thread_) {
       handle_->PushStreamListener(this);
       handle_->env()->AddCleanupHook(cleanup, this);
+      handle_->set_read_chunk_size(read_size_);
     }
 
     ~ReaderImpl() override {
+      CheckThread(thread_);
       handle_->env()->RemoveCleanupHook(cleanup, this);
       DrainAndClose();
       handle_->RemoveStreamListener(this);
     }
 
     uv_buf_t OnStreamAlloc(size_t suggested_size) override {
+      // Read straight into the buffer of the pull the read is for, if it
+      // provided one, but not past the end of the entry's range.
+      if (!pending_pulls_.empty() &&
+          pending_pulls_.front().destination.base != nullptr) {
+        const DataQueue::Vec& destination = pending_pulls_.front().destination;
+        uint64_t len = std::min<uint64_t>(destination.len, kMaxDestinationSize);
+        if (handle_->read_length() >= 0) {
+          len = std::min<uint64_t>(len, handle_->read_length());
+        }
+        reading_into_destination_ = true;
+        return uv_buf_init(reinterpret_cast<char*>(destination.base),
+                           static_cast<unsigned int>(len));
+      }
       return env_->allocate_managed_buffer(suggested_size);
     }
 
     void OnStreamRead(ssize_t nread, const uv_buf_t& buf) override {
-      std::shared_ptr<v8::BackingStore> store =
-          env_->release_managed_buffer(buf);
+      bool into_destination = reading_into_destination_;
+      reading_into_destination_ = false;
+      std::shared_ptr<v8::BackingStore> store;
+      if (!into_destination) store = env_->release_managed_buffer(buf);
 
       if (ended_) {
         // If we got here and ended_ is true, it means we ended and drained
@@ -968,8 +1179,16 @@ class FdEntry final : public EntryImpl {
         return DrainAndClose();
       }
 
+      // Large files are read in growing chunks, so that they don't take a
+      // pull per 64 KiB.
+      if (!into_destination && static_cast<size_t>(nread) == buf.len &&
+          read_size_ < kMaxReadSize) {
+        read_size_ *= 2;
+        handle_->set_read_chunk_size(read_size_);
+      }
+
       DataQueue::Vec vec;
-      vec.base = static_cast<uint8_t*>(store->Data());
+      vec.base = reinterpret_cast<uint8_t*>(buf.base);
       vec.len = static_cast<uint64_t>(nread);
       std::move(pending.next)(
           bob::STATUS_CONTINUE, &vec, 1, [store](uint64_t) {});
@@ -985,6 +1204,7 @@ class FdEntry final : public EntryImpl {
              DataQueue::Vec* data,
              size_t count,
              size_t max_count_hint = bob::kMaxCountHint) override {
+      CheckThread(thread_);
       if (ended_ || !handle_->IsAlive()) {
         std::move(next)(bob::STATUS_EOS, nullptr, 0, [](uint64_t) {});
         return bob::STATUS_EOS;
@@ -997,6 +1217,9 @@ class FdEntry final : public EntryImpl {
       }
 
       pending_pulls_.emplace_back(std::move(next), shared_from_this());
+      if (data != nullptr && count > 0 && data[0].len > 0) {
+        pending_pulls_.back().destination = data[0];
+      }
       if (!reading_) {
         reading_ = true;
         handle_->ReadStart();
@@ -1012,15 +1235,26 @@ class FdEntry final : public EntryImpl {
     struct PendingPull {
       Next next;
       std::shared_ptr<ReaderImpl> self;
+      // The buffer provided by the caller of Pull() to read into, if any.
+      // The caller keeps it alive until next is called.
+      DataQueue::Vec destination{nullptr, 0};
       PendingPull(Next next, std::shared_ptr<ReaderImpl> self)
           : next(std::move(next)), self(std::move(self)) {}
     };
 
+    static constexpr size_t kInitialReadSize = 64 * 1024;
+    static constexpr size_t kMaxReadSize = 2 * 1024 * 1024;
+    // uv_buf_t::len is an unsigned int on Windows.
+    static constexpr uint64_t kMaxDestinationSize = 1u << 30;
+
     Environment* env_;
     BaseObjectPtr<fs::FileHandle> handle_;
     FdEntry* entry_;
+    const uv_thread_t thread_;
     std::deque<PendingPull> pending_pulls_;
+    size_t read_size_ = kInitialReadSize;
     bool reading_ = false;
+    bool reading_into_destination_ = false;
     bool ended_ = false;
 
     static void cleanup(void* self) {
@@ -1137,6 +1371,46 @@ std::unique_ptr<DataQueue::Entry> DataQueue::CreateFdEntry(Environment* env,
   return FdEntry::Create(env, path);
 }
 
+DataQueue::ThreadsafeBackpressureListener::ThreadsafeBackpressureListener(
+    Environment* env, BackpressureListener* listener)
+    : env_(env), thread_(uv_thread_self()), state_(std::make_shared<State>()) {
+  CHECK_NOT_NULL(listener);
+  state_->listener = listener;
+}
+
+DataQueue::ThreadsafeBackpressureListener::~ThreadsafeBackpressureListener() {
+  // An immediate that is still queued only holds on to the state.
+  Mutex::ScopedLock lock(state_->mutex);
+  state_->listener = nullptr;
+}
+
+void DataQueue::ThreadsafeBackpressureListener::EntryRead(size_t amount) {
+  uv_thread_t self = uv_thread_self();
+  if (uv_thread_equal(&self, &thread_)) {
+    state_->listener->EntryRead(amount);
+    return;
+  }
+
+  Mutex::ScopedLock lock(state_->mutex);
+  state_->pending += amount;
+  if (state_->scheduled) return;
+  state_->scheduled = true;
+  env_->SetImmediateThreadsafe(
+      [state = state_](Environment* env) {
+        BackpressureListener* listener;
+        size_t amount;
+        {
+          Mutex::ScopedLock lock(state->mutex);
+          listener = state->listener;
+          amount = state->pending;
+          state->pending = 0;
+          state->scheduled = false;
+        }
+        if (listener != nullptr && amount > 0) listener->EntryRead(amount);
+      },
+      CallbackFlags::kUnrefed);
+}
+
 void DataQueue::Initialize(Environment* env, v8::Local<v8::Object> target) {
   // Nothing to do here currently.
 }
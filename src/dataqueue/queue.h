@@ -7,6 +7,7 @@
 #include <node.h>
 #include <node_bob.h>
 #include <node_file.h>
+#include <node_mutex.h>
 #include <stream_base.h>
 #include <uv.h>
 #include <v8.h>
@@ -123,6 +124,15 @@ namespace node {
 //
 // For non-idempotent DataQueues, only a single reader is ever allowed for
 // the DataQueue, and the data can only ever be read once.
+//
+// A non-idempotent DataQueue may be appended to on one thread while it is
+// read on another, e.g. after the Blob wrapping it has been posted to a
+// Worker. Its state is guarded by a mutex for that purpose. The entries
+// of such a queue must be readable from any thread, which is the case for
+// in-memory entries but not for entries that are bound to an Environment,
+// such as fd entries. Backpressure listeners are notified on the thread
+// of the reader; listeners that need to run on a particular thread wrap
+// themselves in a ThreadsafeBackpressureListener.
 
 class DataQueue : public MemoryRetainer {
  public:
@@ -144,11 +154,46 @@ class DataQueue : public MemoryRetainer {
   // A BackpressureListener can be used to receive notifications
   // when a non-idempotent DataQueue releases entries as they
   // are consumed.
+  //
+  // Listeners are notified with the DataQueue locked, so they must not call
+  // back into the DataQueue. Once removeBackpressureListener() returns, the
+  // listener will not be notified anymore.
   class BackpressureListener {
    public:
     virtual void EntryRead(size_t amount) = 0;
   };
 
+  // Forwards the notifications of a DataQueue to a listener that lives on
+  // the thread of the given Environment. Notifications that come from a
+  // reader on another thread are summed up and delivered from a threadsafe
+  // immediate. The wrapper must be removed from the DataQueue before the
+  // Environment goes away.
+  class ThreadsafeBackpressureListener final : public BackpressureListener {
+   public:
+    ThreadsafeBackpressureListener(Environment* env,
+                                   BackpressureListener* listener);
+    ~ThreadsafeBackpressureListener();
+
+    ThreadsafeBackpressureListener(const ThreadsafeBackpressureListener&) =
+        delete;
+    ThreadsafeBackpressureListener& operator=(
+        const ThreadsafeBackpressureListener&) = delete;
+
+    void EntryRead(size_t amount) override;
+
+   private:
+    struct State {
+      Mutex mutex;
+      BackpressureListener* listener;
+      size_t pending = 0;
+      bool scheduled = false;
+    };
+
+    Environment* env_;
+    uv_thread_t thread_;
+    std::shared_ptr<State> state_;
+  };
+
   // A DataQueue::Entry represents a logical chunk of data in the queue.
   // The entry may or may not represent memory-resident data. It may
   // or may not be consumable more than once.
@@ -2,13 +2,16 @@
 #include "ada.h"
 #include "env-inl.h"
 #include "node_buffer.h"
+#include "node_debug.h"
 #include "node_errors.h"
 #include "node_external_reference.h"
 #include "simdutf.h"
 #include "string_bytes.h"
 #include "v8.h"
 
+#include <algorithm>
 #include <cstdint>
+#include <optional>
 
 namespace node {
 namespace encoding_binding {
@@ -16,15 +19,20 @@ namespace encoding_binding {
 using v8::ArrayBuffer;
 using v8::BackingStore;
 using v8::BackingStoreInitializationMode;
+using v8::CFunction;
 using v8::Context;
+using v8::FastApiCallbackOptions;
 using v8::FunctionCallbackInfo;
+using v8::FunctionTemplate;
 using v8::HandleScope;
 using v8::Isolate;
 using v8::Local;
+using v8::MaybeLocal;
 using v8::Object;
 using v8::ObjectTemplate;
 using v8::SnapshotCreator;
 using v8::String;
+using v8::Uint32;
 using v8::Uint8Array;
 using v8::Value;
 
@@ -85,33 +93,113 @@ void BindingData::Deserialize(Local<Context> context,
   CHECK_NOT_NULL(binding);
 }
 
-void BindingData::EncodeInto(const FunctionCallbackInfo<Value>& args) {
-  CHECK_GE(args.Length(), 2);
-  CHECK(args[0]->IsString());
-  CHECK(args[1]->IsUint8Array());
+namespace {
+// Returns the UTF-8 length of a flat string, or nothing if it contains lone
+// surrogates and therefore needs V8's replacing encoder.
+std::optional<size_t> FlatUtf8Length(const String::ValueView& view) {
+  if (view.is_one_byte()) {
+    return simdutf::utf8_length_from_latin1(
+        reinterpret_cast<const char*>(view.data8()), view.length());
+  }
+  const char16_t* data = reinterpret_cast<const char16_t*>(view.data16());
+  if (!simdutf::validate_utf16(data, view.length())) return std::nullopt;
+  return simdutf::utf8_length_from_utf16(data, view.length());
+}
+
+// Converts a flat, well-formed string to UTF-8, reading its one-byte or
+// two-byte representation directly. `dest` must be large enough.
+size_t WriteFlatUtf8(const String::ValueView& view, char* dest) {
+  if (view.is_one_byte()) {
+    return simdutf::convert_latin1_to_utf8(
+        reinterpret_cast<const char*>(view.data8()), view.length(), dest);
+  }
+  return simdutf::convert_valid_utf16_to_utf8(
+      reinterpret_cast<const char16_t*>(view.data16()), view.length(), dest);
+}
+
+// Writes all of `source` into `dest` if it fits, skipping the character-wise
+// walk in String::WriteUtf8V2(). Returns nothing if the caller has to fall
+// back to V8, i.e. when the string is only partially written or is not
+// well-formed UTF-16.
+std::optional<size_t> TryWriteUtf8(Isolate* isolate,
+                                   Local<String> source,
+                                   char* dest,
+                                   size_t dest_length) {
+  String::ValueView view(isolate, source);
+  const size_t length = view.length();
+  // Each Latin-1 character takes at most 2 bytes and each UTF-16 code unit
+  // at most 3, so the exact length is only needed for tight buffers.
+  if (view.is_one_byte()) {
+    if (length * 2 > dest_length &&
+        simdutf::utf8_length_from_latin1(
+            reinterpret_cast<const char*>(view.data8()), length) >
+            dest_length) {
+      return std::nullopt;
+    }
+  } else {
+    const char16_t* data = reinterpret_cast<const char16_t*>(view.data16());
+    if (!simdutf::validate_utf16(data, length) ||
+        (length * 3 > dest_length &&
+         simdutf::utf8_length_from_utf16(data, length) > dest_length)) {
+      return std::nullopt;
+    }
+  }
+  return WriteFlatUtf8(view, dest);
+}
+}  // anonymous namespace
+
+void BindingData::EncodeIntoImpl(Realm* realm,
+                                 Local<Value> source_value,
+                                 Local<Value> dest_value) {
+  CHECK(source_value->IsString());
+  CHECK(dest_value->IsUint8Array());
 
-  Realm* realm = Realm::GetCurrent(args);
   Isolate* isolate = realm->isolate();
   BindingData* binding_data = realm->GetBindingData<BindingData>();
 
-  Local<String> source = args[0].As<String>();
+  Local<String> source = source_value.As<String>();
 
-  Local<Uint8Array> dest = args[1].As<Uint8Array>();
+  Local<Uint8Array> dest = dest_value.As<Uint8Array>();
   Local<ArrayBuffer> buf = dest->Buffer();
   char* write_result = static_cast<char*>(buf->Data()) + dest->ByteOffset();
   size_t dest_length = dest->ByteLength();
 
   size_t nchars;
-  size_t written = source->WriteUtf8V2(isolate,
-                                       write_result,
-                                       dest_length,
-                                       String::WriteFlags::kReplaceInvalidUtf8,
-                                       &nchars);
+  size_t written;
+  std::optional<size_t> direct =
+      TryWriteUtf8(isolate, source, write_result, dest_length);
+  if (direct.has_value()) {
+    nchars = source->Length();
+    written = *direct;
+  } else {
+    written = source->WriteUtf8V2(isolate,
+                                  write_result,
+                                  dest_length,
+                                  String::WriteFlags::kReplaceInvalidUtf8,
+                                  &nchars);
+  }
 
   binding_data->encode_into_results_buffer_[0] = nchars;
   binding_data->encode_into_results_buffer_[1] = written;
 }
 
+void BindingData::EncodeInto(const FunctionCallbackInfo<Value>& args) {
+  CHECK_GE(args.Length(), 2);
+  EncodeIntoImpl(Realm::GetCurrent(args), args[0], args[1]);
+}
+
+void BindingData::FastEncodeInto(Local<Value> receiver,
+                                 Local<Value> source,
+                                 Local<Value> dest,
+                                 // NOLINTNEXTLINE(runtime/references)
+                                 FastApiCallbackOptions& options) {
+  TRACK_V8_FAST_API_CALL("encoding_binding.encodeInto");
+  HandleScope scope(options.isolate);
+  EncodeIntoImpl(Realm::GetCurrent(options.isolate), source, dest);
+}
+
+CFunction BindingData::fast_encode_into_(CFunction::Make(FastEncodeInto));
+
 // Encode a single string to a UTF-8 Uint8Array (not Buffer).
 // Used in TextEncoder.prototype.encode.
 void BindingData::EncodeUtf8String(const FunctionCallbackInfo<Value>& args) {
@@ -121,7 +209,13 @@ void BindingData::EncodeUtf8String(const FunctionCallbackInfo<Value>& args) {
   CHECK(args[0]->IsString());
 
   Local<String> str = args[0].As<String>();
-  size_t length = str->Utf8LengthV2(isolate);
+  std::optional<size_t> flat_length;
+  {
+    String::ValueView view(isolate, str);
+    flat_length = FlatUtf8Length(view);
+  }
+  size_t length = flat_length.value_or(0);
+  if (!flat_length.has_value()) length = str->Utf8LengthV2(isolate);
 
   Local<ArrayBuffer> ab;
   {
@@ -131,10 +225,16 @@ void BindingData::EncodeUtf8String(const FunctionCallbackInfo<Value>& args) {
     CHECK(bs);
 
     // We are certain that `data` is sufficiently large
-    str->WriteUtf8V2(isolate,
-                     static_cast<char*>(bs->Data()),
-                     bs->MaxByteLength(),
-                     String::WriteFlags::kReplaceInvalidUtf8);
+    if (flat_length.has_value()) {
+      // The string was flattened above, so this does not allocate.
+      String::ValueView view(isolate, str);
+      CHECK_EQ(WriteFlatUtf8(view, static_cast<char*>(bs->Data())), length);
+    } else {
+      str->WriteUtf8V2(isolate,
+                       static_cast<char*>(bs->Data()),
+                       bs->MaxByteLength(),
+                       String::WriteFlags::kReplaceInvalidUtf8);
+    }
 
     ab = ArrayBuffer::New(isolate, std::move(bs));
   }
@@ -188,6 +288,262 @@ void BindingData::DecodeUTF8(const FunctionCallbackInfo<Value>& args) {
   }
 }
 
+namespace {
+inline bool IsUTF8Continuation(char c) {
+  return (static_cast<uint8_t>(c) & 0xC0) == 0x80;
+}
+
+// Returns the number of bytes at the end of `data` that are a valid but
+// incomplete UTF-8 sequence, i.e. bytes that may still be completed by the
+// next chunk. Invalid sequences are left alone so that they are reported (or
+// replaced) right away, as the Encoding Standard requires.
+size_t IncompleteUTF8TailLength(const char* data, size_t length) {
+  const size_t limit = std::min<size_t>(length, 3);
+  for (size_t n = 1; n <= limit; n++) {
+    const uint8_t lead = static_cast<uint8_t>(data[length - n]);
+    if (IsUTF8Continuation(lead)) continue;
+
+    size_t needed = 0;
+    uint8_t lower = 0x80, upper = 0xBF;
+    if (lead >= 0xC2 && lead <= 0xDF) {
+      needed = 2;
+    } else if (lead >= 0xE0 && lead <= 0xEF) {
+      needed = 3;
+      if (lead == 0xE0) lower = 0xA0;
+      if (lead == 0xED) upper = 0x9F;
+    } else if (lead >= 0xF0 && lead <= 0xF4) {
+      needed = 4;
+      if (lead == 0xF0) lower = 0x90;
+      if (lead == 0xF4) upper = 0x8F;
+    }
+    if (needed <= n) return 0;
+    if (n >= 2) {
+      const uint8_t second = static_cast<uint8_t>(data[length - n + 1]);
+      if (second < lower || second > upper) return 0;
+    }
+    return n;
+  }
+  return 0;
+}
+}  // anonymous namespace
+
+UTF8Decoder::UTF8Decoder(Environment* env,
+                         Local<Object> wrap,
+                         uint32_t flags)
+    : BaseObject(env, wrap), flags_(flags) {
+  MakeWeak();
+}
+
+void UTF8Decoder::New(const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+  CHECK(args.IsConstructCall());
+  CHECK(args[0]->IsUint32());
+  new UTF8Decoder(env, args.This(), args[0].As<Uint32>()->Value());
+}
+
+void UTF8Decoder::Reset() {
+  bom_seen_ = false;
+  pending_length_ = 0;
+}
+
+MaybeLocal<String> UTF8Decoder::DecodeSegment(const char* data,
+                                              size_t length) {
+  Isolate* isolate = env()->isolate();
+  if (length == 0) return String::Empty(isolate);
+
+  MaybeLocal<String> ret;
+  if (simdutf::validate_utf8(data, length)) {
+    const size_t utf16_length = simdutf::utf16_length_from_utf8(data, length);
+    if (utf16_length == length) {
+      // Only ASCII input yields one UTF-16 unit per byte.
+      ret = String::NewFromOneByte(isolate,
+                                   reinterpret_cast<const uint8_t*>(data),
+                                   v8::NewStringType::kNormal,
+                                   length);
+    } else {
+      MaybeStackBuffer<uint16_t> buffer(utf16_length);
+      simdutf::convert_valid_utf8_to_utf16(
+          data, length, reinterpret_cast<char16_t*>(buffer.out()));
+      ret = String::NewFromTwoByte(
+          isolate, buffer.out(), v8::NewStringType::kNormal, utf16_length);
+    }
+  } else if (fatal()) {
+    node::THROW_ERR_ENCODING_INVALID_ENCODED_DATA(
+        isolate, "The encoded data was not valid for encoding utf-8");
+    return MaybeLocal<String>();
+  } else {
+    // V8 replaces invalid sequences with U+FFFD as the Encoding Standard
+    // requires.
+    ret = String::NewFromUtf8(
+        isolate, data, v8::NewStringType::kNormal, length);
+  }
+
+  if (ret.IsEmpty()) {
+    isolate->ThrowException(node::ERR_STRING_TOO_LONG(isolate));
+  }
+  return ret;
+}
+
+void UTF8Decoder::Decode(const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+  Isolate* isolate = env->isolate();
+
+  UTF8Decoder* decoder;
+  ASSIGN_OR_RETURN_UNWRAP(&decoder, args.This());
+
+  CHECK_GE(args.Length(), 2);
+  if (!(args[0]->IsArrayBuffer() || args[0]->IsSharedArrayBuffer() ||
+        args[0]->IsArrayBufferView())) {
+    return node::THROW_ERR_INVALID_ARG_TYPE(
+        isolate,
+        "The \"input\" argument must be an instance of SharedArrayBuffer, "
+        "ArrayBuffer or ArrayBufferView.");
+  }
+
+  ArrayBufferViewContents<char> input(args[0]);
+  uint32_t flags;
+  if (!args[1]->Uint32Value(env->context()).To(&flags)) {
+    return;
+  }
+  const bool flush = (flags & kFlagsFlush) == kFlagsFlush;
+
+  bool failed = true;
+  auto cleanup = OnScopeLeave([&]() {
+    if (flush || failed) decoder->Reset();
+  });
+
+  const char* data = input.data();
+  size_t length = input.length();
+
+  // Complete the code point left over from the previous chunk. Only the
+  // continuation bytes that belong to it are copied; since a sequence is at
+  // most 4 bytes long, whatever follows starts a new one.
+  char head[kMaxPending * 2];
+  size_t head_length = 0;
+  if (decoder->pending_length_ > 0) {
+    memcpy(head, decoder->pending_, decoder->pending_length_);
+    head_length = decoder->pending_length_;
+    decoder->pending_length_ = 0;
+    size_t taken = 0;
+    while (taken < kMaxPending && taken < length &&
+           IsUTF8Continuation(data[taken])) {
+      head[head_length++] = data[taken++];
+    }
+    data += taken;
+    length -= taken;
+    if (length == 0) {
+      // The chunk was consumed entirely, the head may still be incomplete.
+      data = head;
+      length = head_length;
+      head_length = 0;
+    }
+  }
+
+  if (!flush) {
+    const size_t tail = IncompleteUTF8TailLength(data, length);
+    length -= tail;
+    memcpy(decoder->pending_, data + length, tail);
+    decoder->pending_length_ = tail;
+  }
+
+  Local<String> result = String::Empty(isolate);
+  auto append = [&](const char* segment, size_t segment_length) {
+    if (segment_length == 0) return true;
+    if (!decoder->bom_seen_) {
+      decoder->bom_seen_ = true;
+      if (!decoder->ignore_bom() && segment_length >= 3 &&
+          memcmp(segment, "\xEF\xBB\xBF", 3) == 0) {
+        segment += 3;
+        segment_length -= 3;
+      }
+    }
+    Local<String> str;
+    if (!decoder->DecodeSegment(segment, segment_length).ToLocal(&str)) {
+      return false;
+    }
+    result = String::Concat(isolate, result, str);
+    return true;
+  };
+  if (!append(head, head_length) || !append(data, length)) return;
+
+  failed = false;
+  args.GetReturnValue().Set(result);
+}
+
+UTF8Validator::UTF8Validator(Environment* env,
+                             Local<Object> wrap,
+                             bool ascii)
+    : BaseObject(env, wrap), ascii_(ascii) {
+  MakeWeak();
+}
+
+void UTF8Validator::New(const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+  CHECK(args.IsConstructCall());
+  new UTF8Validator(env, args.This(), args[0]->IsTrue());
+}
+
+bool UTF8Validator::ValidateChunk(const char* data, size_t length) {
+  if (ascii_) return simdutf::validate_ascii(data, length);
+
+  // Complete the pending code point first, see UTF8Decoder::Decode().
+  if (pending_length_ > 0) {
+    char head[kMaxPending * 2];
+    size_t head_length = pending_length_;
+    memcpy(head, pending_, pending_length_);
+    pending_length_ = 0;
+    size_t taken = 0;
+    while (taken < kMaxPending && taken < length &&
+           IsUTF8Continuation(data[taken])) {
+      head[head_length++] = data[taken++];
+    }
+    data += taken;
+    length -= taken;
+    if (length == 0) return ValidateChunk(head, head_length);
+    if (!simdutf::validate_utf8(head, head_length)) return false;
+  }
+
+  const size_t tail = IncompleteUTF8TailLength(data, length);
+  length -= tail;
+  memcpy(pending_, data + length, tail);
+  pending_length_ = tail;
+  return simdutf::validate_utf8(data, length);
+}
+
+void UTF8Validator::Update(const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+  UTF8Validator* validator;
+  ASSIGN_OR_RETURN_UNWRAP(&validator, args.This());
+
+  if (!(args[0]->IsArrayBuffer() || args[0]->IsSharedArrayBuffer() ||
+        args[0]->IsArrayBufferView())) {
+    return node::THROW_ERR_INVALID_ARG_TYPE(
+        env->isolate(),
+        "The \"input\" argument must be an instance of SharedArrayBuffer, "
+        "ArrayBuffer or ArrayBufferView.");
+  }
+
+  ArrayBufferViewContents<char> input(args[0]);
+  if (input.WasDetached()) {
+    return node::THROW_ERR_INVALID_STATE(
+        env, "Cannot validate on a detached buffer");
+  }
+  if (validator->valid_) {
+    validator->valid_ =
+        validator->ValidateChunk(input.data(), input.length());
+  }
+  args.GetReturnValue().Set(validator->valid_);
+}
+
+void UTF8Validator::Finish(const FunctionCallbackInfo<Value>& args) {
+  UTF8Validator* validator;
+  ASSIGN_OR_RETURN_UNWRAP(&validator, args.This());
+  args.GetReturnValue().Set(validator->valid_ &&
+                            validator->pending_length_ == 0);
+  validator->valid_ = true;
+  validator->pending_length_ = 0;
+}
+
 void BindingData::ToASCII(const FunctionCallbackInfo<Value>& args) {
   Environment* env = Environment::GetCurrent(args);
   CHECK_GE(args.Length(), 1);
@@ -217,12 +573,27 @@ void BindingData::ToUnicode(const FunctionCallbackInfo<Value>& args) {
 void BindingData::CreatePerIsolateProperties(IsolateData* isolate_data,
                                              Local<ObjectTemplate> target) {
   Isolate* isolate = isolate_data->isolate();
-  SetMethod(isolate, target, "encodeInto", EncodeInto);
+  SetFastMethod(isolate, target, "encodeInto", EncodeInto, &fast_encode_into_);
   SetMethodNoSideEffect(isolate, target, "encodeUtf8String", EncodeUtf8String);
   SetMethodNoSideEffect(isolate, target, "decodeUTF8", DecodeUTF8);
   SetMethodNoSideEffect(isolate, target, "toASCII", ToASCII);
   SetMethodNoSideEffect(isolate, target, "toUnicode", ToUnicode);
   SetMethodNoSideEffect(isolate, target, "decodeLatin1", DecodeLatin1);
+
+  Local<FunctionTemplate> decoder =
+      NewFunctionTemplate(isolate, UTF8Decoder::New);
+  decoder->InstanceTemplate()->SetInternalFieldCount(
+      UTF8Decoder::kInternalFieldCount);
+  SetProtoMethod(isolate, decoder, "decode", UTF8Decoder::Decode);
+  SetConstructorFunction(isolate, target, "UTF8Decoder", decoder);
+
+  Local<FunctionTemplate> validator =
+      NewFunctionTemplate(isolate, UTF8Validator::New);
+  validator->InstanceTemplate()->SetInternalFieldCount(
+      UTF8Validator::kInternalFieldCount);
+  SetProtoMethod(isolate, validator, "update", UTF8Validator::Update);
+  SetProtoMethod(isolate, validator, "finish", UTF8Validator::Finish);
+  SetConstructorFunction(isolate, target, "UTF8Validator", validator);
 }
 
 void BindingData::CreatePerContextProperties(Local<Object> target,
@@ -236,11 +607,18 @@ void BindingData::CreatePerContextProperties(Local<Object> target,
 void BindingData::RegisterTimerExternalReferences(
     ExternalReferenceRegistry* registry) {
   registry->Register(EncodeInto);
+  registry->Register(FastEncodeInto);
+  registry->Register(fast_encode_into_.GetTypeInfo());
   registry->Register(EncodeUtf8String);
   registry->Register(DecodeUTF8);
   registry->Register(ToASCII);
   registry->Register(ToUnicode);
   registry->Register(DecodeLatin1);
+  registry->Register(UTF8Decoder::New);
+  registry->Register(UTF8Decoder::Decode);
+  registry->Register(UTF8Validator::New);
+  registry->Register(UTF8Validator::Update);
+  registry->Register(UTF8Validator::Finish);
 }
 
 void BindingData::DecodeLatin1(const FunctionCallbackInfo<Value>& args) {
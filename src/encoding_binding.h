@@ -5,6 +5,7 @@
 
 #include <cinttypes>
 #include "aliased_buffer.h"
+#include "base_object.h"
 #include "node_snapshotable.h"
 #include "v8-fast-api-calls.h"
 
@@ -29,6 +30,11 @@ class BindingData : public SnapshotableObject {
   SET_MEMORY_INFO_NAME(BindingData)
 
   static void EncodeInto(const v8::FunctionCallbackInfo<v8::Value>& args);
+  static void FastEncodeInto(v8::Local<v8::Value> receiver,
+                             v8::Local<v8::Value> source,
+                             v8::Local<v8::Value> dest,
+                             // NOLINTNEXTLINE(runtime/references)
+                             v8::FastApiCallbackOptions& options);
   static void EncodeUtf8String(const v8::FunctionCallbackInfo<v8::Value>& args);
   static void DecodeUTF8(const v8::FunctionCallbackInfo<v8::Value>& args);
   static void DecodeLatin1(const v8::FunctionCallbackInfo<v8::Value>& args);
@@ -46,11 +52,83 @@ class BindingData : public SnapshotableObject {
       ExternalReferenceRegistry* registry);
 
  private:
+  static void EncodeIntoImpl(Realm* realm,
+                             v8::Local<v8::Value> source,
+                             v8::Local<v8::Value> dest);
+
+  static v8::CFunction fast_encode_into_;
+
   static constexpr size_t kEncodeIntoResultsLength = 2;
   AliasedUint32Array encode_into_results_buffer_;
   InternalFieldInfo* internal_field_info_ = nullptr;
 };
 
+// A stateful UTF-8 decoder backing TextDecoder#decode() with
+// `{ stream: true }`. It keeps the bytes of an incomplete trailing code point
+// between calls, so that each chunk can be validated and converted with
+// simdutf without copying it.
+class UTF8Decoder : public BaseObject {
+ public:
+  enum Flags {
+    kFlagsFlush = 0x1,
+    kFlagsFatal = 0x2,
+    kFlagsIgnoreBOM = 0x4,
+  };
+
+  UTF8Decoder(Environment* env, v8::Local<v8::Object> wrap, uint32_t flags);
+
+  static void New(const v8::FunctionCallbackInfo<v8::Value>& args);
+  // decode(input, flags): decodes the next chunk. When kFlagsFlush is set,
+  // pending bytes are emitted (or rejected) and the decoder is reset.
+  static void Decode(const v8::FunctionCallbackInfo<v8::Value>& args);
+
+  SET_NO_MEMORY_INFO()
+  SET_MEMORY_INFO_NAME(UTF8Decoder)
+  SET_SELF_SIZE(UTF8Decoder)
+
+ private:
+  v8::MaybeLocal<v8::String> DecodeSegment(const char* data, size_t length);
+  void Reset();
+
+  bool fatal() const { return (flags_ & kFlagsFatal) != 0; }
+  bool ignore_bom() const { return (flags_ & kFlagsIgnoreBOM) != 0; }
+
+  // A UTF-8 sequence is at most 4 bytes long, so at most 3 can be pending.
+  static constexpr size_t kMaxPending = 3;
+  uint32_t flags_;
+  bool bom_seen_ = false;
+  uint8_t pending_length_ = 0;
+  char pending_[kMaxPending];
+};
+
+// Validates UTF-8 (or ASCII) input that arrives in chunks, carrying the bytes
+// of a code point that is split across chunks over to the next update(), so
+// that the chunks never have to be concatenated.
+class UTF8Validator : public BaseObject {
+ public:
+  UTF8Validator(Environment* env, v8::Local<v8::Object> wrap, bool ascii);
+
+  static void New(const v8::FunctionCallbackInfo<v8::Value>& args);
+  // update(chunk): returns false as soon as the input seen so far is invalid.
+  static void Update(const v8::FunctionCallbackInfo<v8::Value>& args);
+  // finish(): returns whether the whole input was valid, i.e. nothing is
+  // left pending, and resets the validator.
+  static void Finish(const v8::FunctionCallbackInfo<v8::Value>& args);
+
+  SET_NO_MEMORY_INFO()
+  SET_MEMORY_INFO_NAME(UTF8Validator)
+  SET_SELF_SIZE(UTF8Validator)
+
+ private:
+  bool ValidateChunk(const char* data, size_t length);
+
+  static constexpr size_t kMaxPending = 3;
+  const bool ascii_;
+  bool valid_ = true;
+  uint8_t pending_length_ = 0;
+  char pending_[kMaxPending];
+};
+
 }  // namespace encoding_binding
 
 }  // namespace node
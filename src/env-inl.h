@@ -266,6 +266,35 @@ void Environment::DecreaseWaitingRequestCounter() {
   CHECK_GE(request_waiting_, 0);
 }
 
+inline ThreadPoolWorkLimiter* Environment::threadpool_work_limiter() {
+  return &threadpool_work_limiter_;
+}
+
+inline EventLoopPhaseTimer* Environment::event_loop_phase_timer() {
+  return &event_loop_phase_timer_;
+}
+
+inline async_context_frame::CpuTimeTracker*
+Environment::async_context_frame_cpu_time_tracker() {
+  return &async_context_frame_cpu_time_tracker_;
+}
+
+inline AsyncWrapCounters* Environment::async_wrap_counters() {
+  return &async_wrap_counters_;
+}
+
+inline url_pattern::RegExpCache* Environment::url_pattern_regexp_cache() {
+  return &url_pattern_regexp_cache_;
+}
+
+inline BufferPool* Environment::buffer_pool() {
+  return buffer_pool_;
+}
+
+inline bool Environment::is_shared_read_buffer(const uv_buf_t& buf) const {
+  return buf.base != nullptr && buf.base == shared_read_buffer_.get();
+}
+
 inline uv_loop_t* Environment::event_loop() const {
   return isolate_data()->event_loop();
 }
@@ -304,6 +333,23 @@ inline uint64_t Environment::timer_base() const {
   return timer_base_;
 }
 
+inline uint64_t Environment::timer_slack() const {
+  return timer_slack_;
+}
+
+inline void Environment::set_timer_slack(uint64_t slack_ms) {
+  timer_slack_ = slack_ms;
+}
+
+inline uint64_t Environment::ApplyTimerSlack(uint64_t duration_ms) const {
+  if (timer_slack_ <= 1) return duration_ms;
+  uint64_t now = uv_now(event_loop());
+  uint64_t deadline = now + duration_ms;
+  uint64_t remainder = deadline % timer_slack_;
+  if (remainder != 0) deadline += timer_slack_ - remainder;
+  return deadline - now;
+}
+
 inline std::shared_ptr<KVStore> Environment::env_vars() {
   return env_vars_;
 }
@@ -458,6 +504,10 @@ inline const std::string& Environment::exec_path() const {
   return exec_path_;
 }
 
+inline loader::ModulePrefetcher* Environment::module_prefetcher() {
+  return module_prefetcher_.get();
+}
+
 inline CompileCacheHandler* Environment::compile_cache_handler() {
   auto* result = compile_cache_handler_.get();
   DCHECK_NOT_NULL(result);
@@ -592,6 +642,18 @@ void Environment::SetImmediateThreadsafe(Fn&& cb, CallbackFlags::Flags flags) {
   }
 }
 
+bool Environment::AddReleasedBufferCallback(std::unique_ptr<Cleanable> info) {
+  Mutex::ScopedLock lock(released_buffer_callbacks_mutex_);
+  released_buffer_callbacks_.push_back(std::move(info));
+  return released_buffer_callbacks_.size() == 1;
+}
+
+std::vector<std::unique_ptr<Cleanable>>
+Environment::TakeReleasedBufferCallbacks() {
+  Mutex::ScopedLock lock(released_buffer_callbacks_mutex_);
+  return std::exchange(released_buffer_callbacks_, {});
+}
+
 template <typename Fn>
 void Environment::RequestInterrupt(Fn&& cb) {
   auto callback = native_immediates_interrupts_.CreateCallback(
@@ -715,6 +777,16 @@ inline void Environment::remove_sub_worker_context(worker::Worker* context) {
   sub_worker_contexts_.erase(context);
 }
 
+inline std::shared_ptr<worker::WorkerIsolatePool>
+Environment::worker_isolate_pool() {
+  return worker_isolate_pool_;
+}
+
+inline void Environment::set_worker_isolate_pool(
+    std::shared_ptr<worker::WorkerIsolatePool> pool) {
+  worker_isolate_pool_ = std::move(pool);
+}
+
 template <typename Fn>
 inline void Environment::ForEachWorker(Fn&& iterator) {
   for (worker::Worker* w : sub_worker_contexts_) iterator(w);
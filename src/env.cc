@@ -740,6 +740,13 @@ uv_buf_t Environment::allocate_managed_buffer(const size_t suggested_size) {
   return buf;
 }
 
+uv_buf_t Environment::shared_read_buffer(size_t suggested_size) {
+  if (!shared_read_buffer_)
+    shared_read_buffer_ = std::make_unique<char[]>(kSharedReadBufferSize);
+  return uv_buf_init(shared_read_buffer_.get(),
+                     std::min(suggested_size, kSharedReadBufferSize));
+}
+
 std::unique_ptr<BackingStore> Environment::release_managed_buffer(
     const uv_buf_t& buf) {
   std::unique_ptr<BackingStore> bs;
@@ -811,7 +818,16 @@ Environment::Environment(IsolateData* isolate_data,
       flags_(flags),
       thread_id_(thread_id.id == static_cast<uint64_t>(-1)
                      ? AllocateEnvironmentThreadId().id
-                     : thread_id.id) {
+                     : thread_id.id),
+      // The limits apply to the whole process, so a slot may be released by
+      // another Environment's thread.
+      threadpool_work_limiter_(ThreadPoolWorkBudget::Get(), [this]() {
+        SetImmediateThreadsafe(
+            [](Environment* env) {
+              env->threadpool_work_limiter()->SubmitQueued();
+            },
+            CallbackFlags::kUnrefed);
+      }) {
   if (!is_main_thread()) {
     // If this is a Worker thread, we can always safely use the parent's
     // Isolate's code cache because of the shared read-only heap.
@@ -867,6 +883,13 @@ Environment::Environment(IsolateData* isolate_data,
   heap_snapshot_near_heap_limit_ =
       static_cast<uint32_t>(options_->heap_snapshot_near_heap_limit);
 
+  timer_slack_ = options_->timer_slack;
+
+  // Pooled blocks are handed out uninitialized.
+  if (!per_process::cli_options->zero_fill_all_buffers) {
+    buffer_pool_ = new BufferPool();
+  }
+
   if (!(flags_ & EnvironmentFlags::kOwnsProcessState)) {
     set_abort_on_uncaught_exception(false);
   }
@@ -992,6 +1015,8 @@ void Environment::InitializeMainContext(Local<Context> context,
     performance_state_->Mark(performance::NODE_PERFORMANCE_MILESTONE_V8_START,
                             performance::performance_v8_start);
   }
+
+  performance_state_->InstallGCMetrics(isolate_);
 }
 
 Environment::~Environment() {
@@ -1031,6 +1056,7 @@ Environment::~Environment() {
 
   isolate()->GetHeapProfiler()->RemoveBuildEmbedderGraphCallback(
       BuildEmbedderGraph, this);
+  performance_state_->RemoveGCMetrics(isolate());
 
 #if HAVE_INSPECTOR
   // Destroy inspector agent before erasing the context. The inspector
@@ -1064,6 +1090,8 @@ Environment::~Environment() {
     }
   }
 
+  if (buffer_pool_ != nullptr) buffer_pool_->Detach();
+
   delete external_memory_accounter_;
 }
 
@@ -1164,6 +1192,11 @@ CompileCacheEnableResult Environment::EnableCompileCache(
   return result;
 }
 
+void Environment::set_module_prefetcher(
+    std::unique_ptr<loader::ModulePrefetcher> prefetcher) {
+  module_prefetcher_ = std::move(prefetcher);
+}
+
 void Environment::FlushCompileCache() {
   if (!compile_cache_handler_ || compile_cache_handler_->cache_dir().empty()) {
     return;
@@ -1210,6 +1243,10 @@ void Environment::ClosePerEnvHandles() {
   close_and_finish(reinterpret_cast<uv_handle_t*>(&idle_prepare_handle_));
   close_and_finish(reinterpret_cast<uv_handle_t*>(&idle_check_handle_));
   close_and_finish(reinterpret_cast<uv_handle_t*>(&task_queues_async_));
+  if (event_loop_phase_timer_.enabled()) {
+    close_and_finish(event_loop_phase_timer_.prepare_handle());
+    close_and_finish(event_loop_phase_timer_.check_handle());
+  }
 }
 
 void Environment::CleanupHandles() {
@@ -1286,6 +1323,9 @@ void Environment::RunCleanup() {
   started_cleanup_ = true;
   TRACE_EVENT0(TRACING_CATEGORY_NODE1(environment), "RunCleanup");
   ClosePerEnvHandles();
+  // Queued threadpool requests may be waiting for a slot that another
+  // Environment holds, so do not wait for them.
+  threadpool_work_limiter_.CancelQueued();
   // Only BaseObject's cleanups are registered as per-realm cleanup hooks now.
   // Defer the BaseObject cleanup after handles are cleaned up.
   CleanupHandles();
@@ -1376,6 +1416,8 @@ void Environment::RunAndClearInterrupts() {
 void Environment::RunAndClearNativeImmediates(bool only_refed) {
   TRACE_EVENT0(TRACING_CATEGORY_NODE1(environment),
                "RunAndClearNativeImmediates");
+  EventLoopPhaseTimer::Scope phase_scope(&event_loop_phase_timer_,
+                                         EventLoopPhase::kImmediates);
   HandleScope handle_scope(isolate_);
   // In case the Isolate is no longer accessible just use an empty Local. This
   // is not an issue for InternalCallbackScope as this case is already handled
@@ -1470,6 +1512,7 @@ void Environment::RequestInterruptFromV8() {
 
 void Environment::ScheduleTimer(int64_t duration_ms) {
   if (started_cleanup_) return;
+  if (duration_ms > 0) duration_ms = ApplyTimerSlack(duration_ms);
   uv_timer_start(timer_handle(), RunTimers, duration_ms, 0);
 }
 
@@ -1490,6 +1533,9 @@ void Environment::RunTimers(uv_timer_t* handle) {
   if (!env->can_call_into_js())
     return;
 
+  EventLoopPhaseTimer::Scope phase_scope(env->event_loop_phase_timer(),
+                                         EventLoopPhase::kTimers);
+
   HandleScope handle_scope(env->isolate());
   Context::Scope context_scope(env->context());
 
@@ -1547,6 +1593,8 @@ void Environment::RunTimers(uv_timer_t* handle) {
 void Environment::CheckImmediate(uv_check_t* handle) {
   Environment* env = Environment::from_immediate_check_handle(handle);
   TRACE_EVENT0(TRACING_CATEGORY_NODE1(environment), "CheckImmediate");
+  auto end_check =
+      OnScopeLeave([env]() { env->event_loop_phase_timer()->EndCheck(); });
 
   HandleScope scope(env->isolate());
   Context::Scope context_scope(env->context());
@@ -1886,11 +1934,23 @@ void Environment::stop_sub_worker_contexts() {
   DCHECK_EQ(Isolate::GetCurrent(), isolate());
 
   while (!sub_worker_contexts_.empty()) {
-    Worker* w = *sub_worker_contexts_.begin();
-    remove_sub_worker_context(w);
-    w->Exit(ExitCode::kGenericUserError);
-    w->JoinThread();
+    // Stop all of the workers before joining any of them, so that they tear
+    // down their Environments in parallel on their own threads.
+    std::vector<Worker*> workers(sub_worker_contexts_.begin(),
+                                 sub_worker_contexts_.end());
+    for (Worker* w : workers) {
+      remove_sub_worker_context(w);
+      w->Exit(ExitCode::kGenericUserError);
+    }
+    // With the shared heap, a worker that is still running may start a
+    // shared garbage collection, which waits for this isolate as well.
+    if (per_process::cli_options->experimental_shared_heap) {
+      for (Worker* w : workers) w->WaitForIsolateDisposal(isolate());
+    }
+    for (Worker* w : workers) w->JoinThread();
   }
+  // Dispose of the isolates that were prepared for workers but not used.
+  worker_isolate_pool_.reset();
 }
 
 Environment* Environment::worker_parent_env() const {
@@ -2146,7 +2206,15 @@ size_t Environment::NearHeapLimitCallback(void* data,
   if (dir.empty()) {
     dir = Environment::GetCwd(env->exec_path_);
   }
-  DiagnosticFilename name(env, "Heap", "heapsnapshot");
+  heap::SnapshotCompression compression =
+      env->options()->heap_snapshot_compression == "zstd"
+          ? heap::SnapshotCompression::kZstd
+          : heap::SnapshotCompression::kNone;
+  DiagnosticFilename name(env,
+                          "Heap",
+                          compression == heap::SnapshotCompression::kZstd
+                              ? "heapsnapshot.zst"
+                              : "heapsnapshot");
   std::string filename = dir + kPathSeparator + (*name);
 
   Debug(env, DebugCategory::DIAGNOSTICS, "Start generating %s...\n", *name);
@@ -2154,7 +2222,7 @@ size_t Environment::NearHeapLimitCallback(void* data,
   HeapProfiler::HeapSnapshotOptions options;
   options.numerics_mode = HeapProfiler::NumericsMode::kExposeNumericValues;
   options.snapshot_mode = HeapProfiler::HeapSnapshotMode::kExposeInternals;
-  heap::WriteSnapshot(env, filename.c_str(), options);
+  heap::WriteSnapshot(env, filename.c_str(), options, compression);
   env->heap_limit_snapshot_taken_ += 1;
 
   Debug(env,
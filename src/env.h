@@ -25,6 +25,8 @@
 #if defined(NODE_WANT_INTERNALS) && NODE_WANT_INTERNALS
 
 #include "aliased_buffer.h"
+#include "async_context_frame.h"
+#include "buffer_pool.h"
 #if HAVE_INSPECTOR
 #include "inspector_agent.h"
 #include "inspector_profiler.h"
@@ -34,6 +36,7 @@
 #include "compile_cache.h"
 #include "debug_utils.h"
 #include "env_properties.h"
+#include "event_loop_phases.h"
 #include "handle_wrap.h"
 #include "node.h"
 #include "node_binding.h"
@@ -46,6 +49,8 @@
 #include "node_snapshotable.h"
 #include "permission/permission.h"
 #include "req_wrap.h"
+#include "threadpool_limiter.h"
+#include "url_pattern_regexp_cache.h"
 #include "util.h"
 #include "uv.h"
 #include "v8-external-memory-accounter.h"
@@ -100,9 +105,11 @@ class ParentInspectorHandle;
 
 namespace worker {
 class Worker;
+class WorkerIsolatePool;
 }
 
 namespace loader {
+class ModulePrefetcher;
 class ModuleWrap;
 }  // namespace loader
 
@@ -547,6 +554,8 @@ struct SnapshotData {
   static const SnapshotIndex kNodeVMContextIndex = 0;
   static const SnapshotIndex kNodeBaseContextIndex = kNodeVMContextIndex + 1;
   static const SnapshotIndex kNodeMainContextIndex = kNodeBaseContextIndex + 1;
+  static const SnapshotIndex kNodeVanillaVMContextIndex =
+      kNodeMainContextIndex + 1;
 
   DataOwnership data_ownership = DataOwnership::kOwned;
 
@@ -567,6 +576,10 @@ struct SnapshotData {
   // v8::ScriptCompiler::CachedData is not copyable.
   std::vector<builtins::CodeCacheInfo> code_cache;
 
+  // Whether v8_snapshot_blob_data points into a blob that outlives this
+  // SnapshotData (see FromBlobInPlace()) instead of being a copy of it.
+  bool v8_snapshot_blob_data_in_place = false;
+
   void ToFile(FILE* out) const;
   std::vector<char> ToBlob() const;
   // If returns false, the metadata doesn't match the current Node.js binary,
@@ -575,6 +588,11 @@ struct SnapshotData {
   static bool FromFile(SnapshotData* out, FILE* in);
   static bool FromBlob(SnapshotData* out, const std::vector<char>& in);
   static bool FromBlob(SnapshotData* out, std::string_view in);
+  // Like FromBlob(), but the V8 startup data and the built-in code cache
+  // reference |in| instead of being copied out of it, so |in| must outlive
+  // |out|. Used for blobs with static lifetime, e.g. the one embedded in a
+  // single executable application.
+  static bool FromBlobInPlace(SnapshotData* out, std::string_view in);
   static const SnapshotData* FromEmbedderWrapper(
       const EmbedderSnapshotData* data);
   EmbedderSnapshotData::Pointer AsEmbedderWrapper() const;
@@ -708,6 +726,14 @@ class Environment final : public MemoryRetainer {
 
   inline void IncreaseWaitingRequestCounter();
   inline void DecreaseWaitingRequestCounter();
+  inline ThreadPoolWorkLimiter* threadpool_work_limiter();
+  inline EventLoopPhaseTimer* event_loop_phase_timer();
+  inline async_context_frame::CpuTimeTracker*
+  async_context_frame_cpu_time_tracker();
+  inline AsyncWrapCounters* async_wrap_counters();
+  inline url_pattern::RegExpCache* url_pattern_regexp_cache();
+  // May be nullptr, e.g. with --zero-fill-buffers.
+  inline BufferPool* buffer_pool();
 
   inline AsyncHooks* async_hooks();
   inline ImmediateInfo* immediate_info();
@@ -812,6 +838,9 @@ class Environment final : public MemoryRetainer {
   inline void add_sub_worker_context(worker::Worker* context);
   inline void remove_sub_worker_context(worker::Worker* context);
   void stop_sub_worker_contexts();
+  inline std::shared_ptr<worker::WorkerIsolatePool> worker_isolate_pool();
+  inline void set_worker_isolate_pool(
+      std::shared_ptr<worker::WorkerIsolatePool> pool);
   template <typename Fn>
   inline void ForEachWorker(Fn&& iterator);
   // Determine if the environment is stopping. This getter is thread-safe.
@@ -905,6 +934,12 @@ class Environment final : public MemoryRetainer {
   inline CleanableQueue* cleanable_queue() {
     return &cleanable_queue_;
   }
+  // Queues the cleanup state of an external buffer whose backing store has
+  // been freed, so that its callback can run on this thread. Returns true if
+  // the queue was empty, i.e. if the caller needs to schedule a task that
+  // runs TakeReleasedBufferCallbacks(). Can be called from any thread.
+  inline bool AddReleasedBufferCallback(std::unique_ptr<Cleanable> info);
+  inline std::vector<std::unique_ptr<Cleanable>> TakeReleasedBufferCallbacks();
   inline ReqWrapQueue* req_wrap_queue() { return &req_wrap_queue_; }
 
   // https://w3c.github.io/hr-time/#dfn-time-origin
@@ -958,6 +993,13 @@ class Environment final : public MemoryRetainer {
 
   void ScheduleTimer(int64_t duration);
   void ToggleTimerRef(bool ref);
+  // With a timer slack of n ms, timers fire when the loop time is the next
+  // multiple of n at or after their deadline rather than at the deadline,
+  // so that timers with nearby deadlines expire in the same wakeup.
+  inline uint64_t timer_slack() const;
+  inline void set_timer_slack(uint64_t slack_ms);
+  // Extends a timer duration by the timer slack.
+  inline uint64_t ApplyTimerSlack(uint64_t duration_ms) const;
 
   inline void AddCleanupHook(CleanupQueue::Callback cb, void* arg);
   inline void RemoveCleanupHook(CleanupQueue::Callback cb, void* arg);
@@ -1022,6 +1064,9 @@ class Environment final : public MemoryRetainer {
 
   inline CompileCacheHandler* compile_cache_handler();
   inline bool use_compile_cache() const;
+  inline loader::ModulePrefetcher* module_prefetcher();
+  void set_module_prefetcher(
+      std::unique_ptr<loader::ModulePrefetcher> prefetcher);
   void InitializeCompileCache();
   // Enable built-in compile cache if it has not yet been enabled.
   // The cache will be persisted to disk on exit.
@@ -1034,6 +1079,13 @@ class Environment final : public MemoryRetainer {
   uv_buf_t allocate_managed_buffer(const size_t suggested_size);
   std::unique_ptr<v8::BackingStore> release_managed_buffer(const uv_buf_t& buf);
 
+  // A read buffer shared by all streams of this Environment. It may only be
+  // handed out by stream listeners that are done with the data by the time
+  // their OnStreamRead() returns, i.e. that copy or parse it synchronously.
+  static constexpr size_t kSharedReadBufferSize = 32 * 1024;
+  uv_buf_t shared_read_buffer(size_t suggested_size);
+  inline bool is_shared_read_buffer(const uv_buf_t& buf) const;
+
   void AddUnmanagedFd(int fd);
   void RemoveUnmanagedFd(int fd);
 
@@ -1101,6 +1153,7 @@ class Environment final : public MemoryRetainer {
   TickInfo tick_info_;
   permission::Permission permission_;
   const uint64_t timer_base_;
+  uint64_t timer_slack_ = 0;
   std::shared_ptr<KVStore> env_vars_;
   bool printed_error_ = false;
   bool trace_sync_io_ = false;
@@ -1127,6 +1180,7 @@ class Environment final : public MemoryRetainer {
 #endif  // HAVE_INSPECTOR
 
   std::unique_ptr<CompileCacheHandler> compile_cache_handler_;
+  std::unique_ptr<loader::ModulePrefetcher> module_prefetcher_;
   std::shared_ptr<EnvironmentOptions> options_;
   // options_ contains debug options parsed from CLI arguments,
   // while inspector_host_port_ stores the actual inspector host
@@ -1177,6 +1231,7 @@ class Environment final : public MemoryRetainer {
   uint64_t flags_;
   uint64_t thread_id_;
   std::unordered_set<worker::Worker*> sub_worker_contexts_;
+  std::shared_ptr<worker::WorkerIsolatePool> worker_isolate_pool_;
 
 #if HAVE_INSPECTOR
   std::unique_ptr<inspector::Agent> inspector_agent_;
@@ -1193,6 +1248,8 @@ class Environment final : public MemoryRetainer {
   // `doc/contributing/node-postmortem-support.md`
   friend int GenDebugSymbols();
   CleanableQueue cleanable_queue_;
+  Mutex released_buffer_callbacks_mutex_;
+  std::vector<std::unique_ptr<Cleanable>> released_buffer_callbacks_;
   HandleWrapQueue handle_wrap_queue_;
   ReqWrapQueue req_wrap_queue_;
   int handle_cleanup_waiting_ = 0;
@@ -1214,7 +1271,8 @@ class Environment final : public MemoryRetainer {
   std::list<ExitCallback> at_exit_functions_;
 
   typedef CallbackQueue<void, Environment*> NativeImmediateQueue;
-  NativeImmediateQueue native_immediates_;
+  NativeImmediateQueue native_immediates_{
+      NativeImmediateQueue::kSlabAllocated};
   Mutex native_immediates_threadsafe_mutex_;
   NativeImmediateQueue native_immediates_threadsafe_;
   NativeImmediateQueue native_immediates_interrupts_;
@@ -1231,6 +1289,14 @@ class Environment final : public MemoryRetainer {
   CleanupQueue cleanup_queue_;
   bool started_cleanup_ = false;
 
+  ThreadPoolWorkLimiter threadpool_work_limiter_;
+  EventLoopPhaseTimer event_loop_phase_timer_;
+  async_context_frame::CpuTimeTracker async_context_frame_cpu_time_tracker_;
+  AsyncWrapCounters async_wrap_counters_;
+  url_pattern::RegExpCache url_pattern_regexp_cache_;
+  // Detached rather than deleted, see BufferPool.
+  BufferPool* buffer_pool_ = nullptr;
+
   std::unordered_set<int> unmanaged_fds_;
 
   std::function<void(Environment*, ExitCode)> process_exit_handler_{
@@ -1245,6 +1311,7 @@ class Environment final : public MemoryRetainer {
   // track of the BackingStore for a given pointer.
   std::unordered_map<char*, std::unique_ptr<v8::BackingStore>>
       released_allocated_buffers_;
+  std::unique_ptr<char[]> shared_read_buffer_;
 };
 
 }  // namespace node
@@ -36,7 +36,8 @@
   V(untransferable_object_private_symbol, "node:untransferableObject")         \
   V(exit_info_private_symbol, "node:exit_info_private_symbol")                 \
   V(promise_trace_id, "node:promise_trace_id")                                 \
-  V(source_map_data_private_symbol, "node:source_map_data_private_symbol")
+  V(source_map_data_private_symbol, "node:source_map_data_private_symbol")    \
+  V(cpu_time_counter_private_symbol, "node:cpu_time_counter")
 
 // Symbols are per-isolate primitives but Environment proxies them
 // for the sake of convenience.
@@ -192,6 +193,7 @@
   V(handle_string, "handle")                                                   \
   V(hash_algorithm_string, "hashAlgorithm")                                    \
   V(help_text_string, "helpText")                                              \
+  V(hits_string, "hits")                                                       \
   V(homedir_string, "homedir")                                                 \
   V(host_string, "host")                                                       \
   V(hostmaster_string, "hostmaster")                                           \
@@ -202,6 +204,7 @@
   V(identity_string, "identity")                                               \
   V(ignore_case_string, "ignoreCase")                                          \
   V(ignore_string, "ignore")                                                   \
+  V(index_string, "index")                                                     \
   V(infoaccess_string, "infoAccess")                                           \
   V(inherit_string, "inherit")                                                 \
   V(input_string, "input")                                                     \
@@ -249,9 +252,11 @@
   V(message_port_constructor_string, "MessagePort")                            \
   V(message_port_string, "messagePort")                                        \
   V(message_string, "message")                                                 \
+  V(messagebatch_string, "messagebatch")                                       \
   V(messageerror_string, "messageerror")                                       \
   V(mgf1_hash_algorithm_string, "mgf1HashAlgorithm")                           \
   V(minttl_string, "minttl")                                                   \
+  V(misses_string, "misses")                                                   \
   V(module_string, "module")                                                   \
   V(modulus_string, "modulus")                                                 \
   V(modulus_length_string, "modulusLength")                                    \
@@ -265,12 +270,15 @@
   V(num_cols_string, "num_cols")                                               \
   V(object_string, "Object")                                                   \
   V(ocsp_request_string, "OCSPRequest")                                        \
+  V(onbatch_string, "onbatch")                                                 \
   V(oncertcb_string, "oncertcb")                                               \
   V(onchange_string, "onchange")                                               \
   V(onclienthello_string, "onclienthello")                                     \
   V(oncomplete_string, "oncomplete")                                           \
   V(onconflict_string, "onConflict")                                           \
   V(onconnection_string, "onconnection")                                       \
+  V(onconnectionbatch_string, "onconnectionbatch")                             \
+  V(ondata_string, "ondata")                                                   \
   V(ondone_string, "ondone")                                                   \
   V(onerror_string, "onerror")                                                 \
   V(onexit_string, "onexit")                                                   \
@@ -278,6 +286,7 @@
   V(onhandshakestart_string, "onhandshakestart")                               \
   V(onkeylog_string, "onkeylog")                                               \
   V(onmessage_string, "onmessage")                                             \
+  V(onmessagebatch_string, "onmessagebatch")                                   \
   V(onnewsession_string, "onnewsession")                                       \
   V(onocspresponse_string, "onocspresponse")                                   \
   V(onreadstart_string, "onreadstart")                                         \
@@ -298,6 +307,7 @@
   V(path_string, "path")                                                       \
   V(pathname_string, "pathname")                                               \
   V(pending_handle_string, "pendingHandle")                                    \
+  V(pending_handles_string, "pendingHandles")                                  \
   V(permission_string, "permission")                                           \
   V(phase_string, "phase")                                                     \
   V(pid_string, "pid")                                                         \
@@ -426,7 +436,9 @@
   V(blob_constructor_template, v8::FunctionTemplate)                           \
   V(blob_reader_constructor_template, v8::FunctionTemplate)                    \
   V(blocklist_constructor_template, v8::FunctionTemplate)                      \
+  V(compression_dictionary_constructor_template, v8::FunctionTemplate)         \
   V(contextify_global_template, v8::ObjectTemplate)                            \
+  V(cppgc_async_wrap_ctor_template, v8::FunctionTemplate)                      \
   V(contextify_wrapper_template, v8::ObjectTemplate)                           \
   V(crypto_key_object_handle_constructor, v8::FunctionTemplate)                \
   V(env_proxy_template, v8::ObjectTemplate)                                    \
@@ -442,6 +454,7 @@
   V(http2settings_constructor_template, v8::ObjectTemplate)                    \
   V(http2stream_constructor_template, v8::ObjectTemplate)                      \
   V(http2ping_constructor_template, v8::ObjectTemplate)                        \
+  V(http_header_slices_template, v8::ObjectTemplate)                           \
   V(i18n_converter_template, v8::ObjectTemplate)                               \
   V(intervalhistogram_constructor_template, v8::FunctionTemplate)              \
   V(js_transferable_constructor_template, v8::FunctionTemplate)                \
@@ -451,11 +464,14 @@
   V(microtask_queue_ctor_template, v8::FunctionTemplate)                       \
   V(pipe_constructor_template, v8::FunctionTemplate)                           \
   V(promise_wrap_template, v8::ObjectTemplate)                                 \
+  V(rolling_histogram_ctor_template, v8::FunctionTemplate)                     \
   V(sab_lifetimepartner_constructor_template, v8::FunctionTemplate)            \
   V(script_context_constructor_template, v8::FunctionTemplate)                 \
   V(secure_context_constructor_template, v8::FunctionTemplate)                 \
+  V(shared_ring_buffer_constructor_template, v8::FunctionTemplate)             \
   V(shutdown_wrap_template, v8::ObjectTemplate)                                \
   V(socketaddress_constructor_template, v8::FunctionTemplate)                  \
+  V(sqlite_statement_constructor_template, v8::FunctionTemplate)               \
   V(sqlite_statement_sync_constructor_template, v8::FunctionTemplate)          \
   V(sqlite_statement_sync_iterator_constructor_template, v8::FunctionTemplate) \
   V(sqlite_session_constructor_template, v8::FunctionTemplate)                 \
@@ -466,6 +482,7 @@
   V(qlogoutputstream_constructor_template, v8::ObjectTemplate)                 \
   V(tcp_constructor_template, v8::FunctionTemplate)                            \
   V(tty_constructor_template, v8::FunctionTemplate)                            \
+  V(url_pattern_constructor_template, v8::FunctionTemplate)                    \
   V(write_wrap_template, v8::ObjectTemplate)                                   \
   V(worker_heap_snapshot_taker_template, v8::ObjectTemplate)                   \
   V(worker_heap_statistics_taker_template, v8::ObjectTemplate)                 \
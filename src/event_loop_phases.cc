@@ -0,0 +1,94 @@
+#include "event_loop_phases.h"
+#include "histogram-inl.h"
+#include "util-inl.h"
+
+#include <algorithm>
+
+namespace node {
+
+const char* EventLoopPhaseName(EventLoopPhase phase) {
+  switch (phase) {
+    case EventLoopPhase::kTimers:
+      return "timers";
+    case EventLoopPhase::kPending:
+      return "pending";
+    case EventLoopPhase::kPoll:
+      return "poll";
+    case EventLoopPhase::kCheck:
+      return "check";
+    case EventLoopPhase::kMicrotasks:
+      return "microtasks";
+    case EventLoopPhase::kImmediates:
+      return "immediates";
+  }
+  UNREACHABLE();
+}
+
+void EventLoopPhaseTimer::Enable(uv_loop_t* loop) {
+  if (enabled_) return;
+  for (std::shared_ptr<Histogram>& histogram : histograms_) {
+    // Like the event loop delay histogram, record with a resolution of
+    // one microsecond.
+    histogram = std::make_shared<Histogram>(Histogram::Options{1000});
+  }
+
+  CHECK_EQ(0, uv_prepare_init(loop, &prepare_handle_));
+  CHECK_EQ(0, uv_check_init(loop, &check_handle_));
+  // Check handles run in reverse order of being started, so this one runs
+  // before Environment::CheckImmediate() and marks the start of the phase.
+  CHECK_EQ(0, uv_prepare_start(&prepare_handle_, OnPrepare));
+  CHECK_EQ(0, uv_check_start(&check_handle_, OnCheck));
+  uv_unref(prepare_handle());
+  uv_unref(check_handle());
+  enabled_ = true;
+}
+
+std::shared_ptr<Histogram> EventLoopPhaseTimer::histogram(
+    EventLoopPhase phase) {
+  return histograms_[static_cast<size_t>(phase)];
+}
+
+void EventLoopPhaseTimer::Record(EventLoopPhase phase, uint64_t duration) {
+  if (!enabled_) return;
+  if (phase == EventLoopPhase::kTimers) timers_since_check_ += duration;
+  // Phases shorter than the histogram's resolution are still counted.
+  histograms_[static_cast<size_t>(phase)]->Record(
+      static_cast<int64_t>(std::max<uint64_t>(duration, 1)));
+}
+
+void EventLoopPhaseTimer::OnPrepare(uv_prepare_t* handle) {
+  EventLoopPhaseTimer* timer =
+      ContainerOf(&EventLoopPhaseTimer::prepare_handle_, handle);
+  uint64_t now = uv_hrtime();
+  if (timer->check_end_ != 0) {
+    uint64_t elapsed = now - timer->check_end_;
+    if (elapsed > timer->timers_since_check_) {
+      timer->Record(EventLoopPhase::kPending,
+                    elapsed - timer->timers_since_check_);
+    }
+  }
+  timer->poll_start_ = now;
+  timer->poll_idle_time_ = uv_metrics_idle_time(handle->loop);
+}
+
+void EventLoopPhaseTimer::OnCheck(uv_check_t* handle) {
+  EventLoopPhaseTimer* timer =
+      ContainerOf(&EventLoopPhaseTimer::check_handle_, handle);
+  uint64_t now = uv_hrtime();
+  if (timer->poll_start_ != 0) {
+    uint64_t elapsed = now - timer->poll_start_;
+    uint64_t idle = uv_metrics_idle_time(handle->loop) - timer->poll_idle_time_;
+    timer->Record(EventLoopPhase::kPoll, elapsed > idle ? elapsed - idle : 0);
+  }
+  timer->check_start_ = now;
+}
+
+void EventLoopPhaseTimer::EndCheck() {
+  if (!enabled_ || check_start_ == 0) return;
+  check_end_ = uv_hrtime();
+  Record(EventLoopPhase::kCheck, check_end_ - check_start_);
+  check_start_ = 0;
+  timers_since_check_ = 0;
+}
+
+}  // namespace node
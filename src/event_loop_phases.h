@@ -0,0 +1,122 @@
+#ifndef SRC_EVENT_LOOP_PHASES_H_
+#define SRC_EVENT_LOOP_PHASES_H_
+
+#if defined(NODE_WANT_INTERNALS) && NODE_WANT_INTERNALS
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "util.h"
+#include "uv.h"
+
+namespace node {
+
+class Histogram;
+
+// The parts of an event loop iteration that EventLoopPhaseTimer records the
+// duration of, in nanoseconds:
+// - kTimers: running the JS timers from the Environment's timer handle.
+// - kPending: the time between the end of the check phase and the start of
+//   the next poll phase that is not spent in kTimers. libuv has no hook
+//   between its closing handles, pending and idle/prepare phases, so this
+//   covers the close callbacks of one iteration and the pending callbacks
+//   of the next one.
+// - kPoll: the poll phase, i.e. the I/O callbacks, without the time that
+//   the loop was blocked waiting for events (see uv_metrics_idle_time()).
+// - kCheck: the check phase, in which setImmediate() callbacks run.
+// - kMicrotasks: draining the nextTick and microtask queues after a
+//   callback into JS.
+// - kImmediates: running the native SetImmediate() callbacks.
+// kMicrotasks and kImmediates happen during the other phases and are also
+// included in their durations.
+enum class EventLoopPhase : uint8_t {
+  kTimers,
+  kPending,
+  kPoll,
+  kCheck,
+  kMicrotasks,
+  kImmediates,
+};
+
+constexpr size_t kEventLoopPhaseCount =
+    static_cast<size_t>(EventLoopPhase::kImmediates) + 1;
+
+const char* EventLoopPhaseName(EventLoopPhase phase);
+
+// Records per-phase duration histograms for an Environment's event loop
+// once it has been enabled. Until then, the only overhead in the hot paths
+// is checking enabled(). Only used on the Environment's thread.
+class EventLoopPhaseTimer {
+ public:
+  // Measures the duration of a kTimers, kMicrotasks or kImmediates phase.
+  class Scope {
+   public:
+    inline Scope(EventLoopPhaseTimer* timer, EventLoopPhase phase);
+    inline ~Scope();
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+
+   private:
+    EventLoopPhaseTimer* timer_;
+    EventLoopPhase phase_;
+    uint64_t start_;
+  };
+
+  EventLoopPhaseTimer() = default;
+  EventLoopPhaseTimer(const EventLoopPhaseTimer&) = delete;
+  EventLoopPhaseTimer& operator=(const EventLoopPhaseTimer&) = delete;
+
+  // Creates the histograms and starts the prepare and check handles that
+  // mark the boundaries of the poll phase. Does nothing if already enabled.
+  void Enable(uv_loop_t* loop);
+  bool enabled() const { return enabled_; }
+
+  // Returns the histogram of a phase, or nullptr if not enabled.
+  std::shared_ptr<Histogram> histogram(EventLoopPhase phase);
+
+  void Record(EventLoopPhase phase, uint64_t duration);
+  // Called by Environment::CheckImmediate() once all immediates have run.
+  void EndCheck();
+
+  // The handles to close with the Environment's other handles, if enabled.
+  uv_handle_t* prepare_handle() {
+    return reinterpret_cast<uv_handle_t*>(&prepare_handle_);
+  }
+  uv_handle_t* check_handle() {
+    return reinterpret_cast<uv_handle_t*>(&check_handle_);
+  }
+
+ private:
+  static void OnPrepare(uv_prepare_t* handle);
+  static void OnCheck(uv_check_t* handle);
+
+  bool enabled_ = false;
+  uv_prepare_t prepare_handle_;
+  uv_check_t check_handle_;
+  std::shared_ptr<Histogram> histograms_[kEventLoopPhaseCount];
+  // uv_hrtime() at the start of the current poll or check phase and at the
+  // end of the last check phase, and the idle time at the start of poll.
+  uint64_t poll_start_ = 0;
+  uint64_t poll_idle_time_ = 0;
+  uint64_t check_start_ = 0;
+  uint64_t check_end_ = 0;
+  // Time spent in kTimers since check_end_.
+  uint64_t timers_since_check_ = 0;
+};
+
+EventLoopPhaseTimer::Scope::Scope(EventLoopPhaseTimer* timer,
+                                  EventLoopPhase phase)
+    : timer_(timer),
+      phase_(phase),
+      start_(timer->enabled() ? uv_hrtime() : 0) {}
+
+EventLoopPhaseTimer::Scope::~Scope() {
+  if (start_ != 0) timer_->Record(phase_, uv_hrtime() - start_);
+}
+
+}  // namespace node
+
+#endif  // defined(NODE_WANT_INTERNALS) && NODE_WANT_INTERNALS
+
+#endif  // SRC_EVENT_LOOP_PHASES_H_
@@ -24,11 +24,15 @@
 #include "handle_wrap.h"
 #include "node.h"
 #include "node_external_reference.h"
+#include "node_fs_watcher.h"
 #include "permission/permission.h"
 #include "string_bytes.h"
 
+#include <vector>
+
 namespace node {
 
+using v8::Array;
 using v8::Context;
 using v8::DontDelete;
 using v8::DontEnum;
@@ -45,6 +49,7 @@ using v8::ReadOnly;
 using v8::Signature;
 using v8::String;
 using v8::TryCatch;
+using v8::Uint32;
 using v8::Value;
 
 namespace {
@@ -77,6 +82,46 @@ class FSEventWrap: public HandleWrap {
   enum encoding encoding_ = kDefaultEncoding;
 };
 
+// Watches a directory tree with a fs_watcher::RecursiveWatcher, without
+// emulating recursion with one FSEventWrap per directory in JS. Events are
+// coalesced by filename and delivered in batches, once per poll or, when a
+// delay is given, once per delay after the first event of a batch:
+//
+//   onchange(status, events, filenames)
+//
+// where events holds 'rename' or 'change' for each of the filenames.
+class RecursiveFSEventWrap : public HandleWrap {
+ public:
+  static void New(const FunctionCallbackInfo<Value>& args);
+  static void Start(const FunctionCallbackInfo<Value>& args);
+
+  void Close(Local<Value> close_callback) override;
+
+  SET_NO_MEMORY_INFO()
+  SET_MEMORY_INFO_NAME(RecursiveFSEventWrap)
+  SET_SELF_SIZE(RecursiveFSEventWrap)
+
+ private:
+  static const encoding kDefaultEncoding = UTF8;
+
+  RecursiveFSEventWrap(Environment* env, Local<Object> object);
+  ~RecursiveFSEventWrap() override = default;
+
+  static void OnPoll(uv_poll_t* handle, int status, int events);
+  static void OnTimer(uv_timer_t* timer);
+  void Flush(int status);
+
+  uv_poll_t handle_;
+  // Only allocated with a delay. It is closed and freed independently of
+  // this object, so that the closing order of the two handles does not
+  // matter.
+  uv_timer_t* timer_ = nullptr;
+  uint64_t delay_ = 0;
+  fs_watcher::RecursiveWatcher watcher_;
+  fs_watcher::EventBatch batch_;
+  enum encoding encoding_ = kDefaultEncoding;
+};
+
 
 FSEventWrap::FSEventWrap(Environment* env, Local<Object> object)
     : HandleWrap(env,
@@ -120,6 +165,14 @@ void FSEventWrap::Initialize(Local<Object> target,
       static_cast<PropertyAttribute>(ReadOnly | DontDelete | DontEnum));
 
   SetConstructorFunction(context, target, "FSEvent", t);
+
+  Local<FunctionTemplate> rt =
+      NewFunctionTemplate(isolate, RecursiveFSEventWrap::New);
+  rt->InstanceTemplate()->SetInternalFieldCount(
+      RecursiveFSEventWrap::kInternalFieldCount);
+  rt->Inherit(HandleWrap::GetConstructorTemplate(env));
+  SetProtoMethod(isolate, rt, "start", RecursiveFSEventWrap::Start);
+  SetConstructorFunction(context, target, "RecursiveFSEvent", rt);
 }
 
 void FSEventWrap::RegisterExternalReferences(
@@ -127,6 +180,8 @@ void FSEventWrap::RegisterExternalReferences(
   registry->Register(New);
   registry->Register(Start);
   registry->Register(GetInitialized);
+  registry->Register(RecursiveFSEventWrap::New);
+  registry->Register(RecursiveFSEventWrap::Start);
 }
 
 void FSEventWrap::New(const FunctionCallbackInfo<Value>& args) {
@@ -239,6 +294,141 @@ void FSEventWrap::OnEvent(uv_fs_event_t* handle, const char* filename,
   wrap->MakeCallback(env->onchange_string(), arraysize(argv), argv);
 }
 
+RecursiveFSEventWrap::RecursiveFSEventWrap(Environment* env,
+                                           Local<Object> object)
+    : HandleWrap(env,
+                 object,
+                 reinterpret_cast<uv_handle_t*>(&handle_),
+                 AsyncWrap::PROVIDER_FSEVENTWRAP) {
+  MarkAsUninitialized();
+}
+
+void RecursiveFSEventWrap::New(const FunctionCallbackInfo<Value>& args) {
+  CHECK(args.IsConstructCall());
+  Environment* env = Environment::GetCurrent(args);
+  new RecursiveFSEventWrap(env, args.This());
+}
+
+// wrap.start(filename, persistent, encoding, delay)
+void RecursiveFSEventWrap::Start(const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+
+  RecursiveFSEventWrap* wrap = Unwrap<RecursiveFSEventWrap>(args.This());
+  CHECK_NOT_NULL(wrap);
+  CHECK(wrap->IsHandleClosing());  // Check that Start() has not been called.
+
+  CHECK_GE(args.Length(), 4);
+  BufferValue path(env->isolate(), args[0]);
+  CHECK_NOT_NULL(*path);
+  THROW_IF_INSUFFICIENT_PERMISSIONS(
+      env, permission::PermissionScope::kFileSystemRead, *path);
+  wrap->encoding_ = ParseEncoding(env->isolate(), args[2], kDefaultEncoding);
+  CHECK(args[3]->IsUint32());
+  wrap->delay_ = args[3].As<Uint32>()->Value();
+
+  int err = wrap->watcher_.Start(*path);
+  if (err != 0) return args.GetReturnValue().Set(err);
+
+  err = uv_poll_init(env->event_loop(), &wrap->handle_, wrap->watcher_.fd());
+  if (err != 0) return args.GetReturnValue().Set(err);
+  wrap->MarkAsInitialized();
+
+  if (wrap->delay_ > 0) {
+    wrap->timer_ = new uv_timer_t();
+    CHECK_EQ(uv_timer_init(env->event_loop(), wrap->timer_), 0);
+    wrap->timer_->data = wrap;
+    uv_unref(reinterpret_cast<uv_handle_t*>(wrap->timer_));
+  }
+
+  err = uv_poll_start(&wrap->handle_, UV_READABLE, OnPoll);
+  if (err != 0) {
+    HandleWrap::Close(args);
+    return args.GetReturnValue().Set(err);
+  }
+
+  // Check for persistent argument
+  if (!args[1]->IsTrue()) {
+    uv_unref(reinterpret_cast<uv_handle_t*>(&wrap->handle_));
+  }
+
+  args.GetReturnValue().Set(err);
+}
+
+void RecursiveFSEventWrap::Close(Local<Value> close_callback) {
+  if (timer_ != nullptr) {
+    timer_->data = nullptr;
+    uv_close(reinterpret_cast<uv_handle_t*>(timer_), [](uv_handle_t* handle) {
+      delete reinterpret_cast<uv_timer_t*>(handle);
+    });
+    timer_ = nullptr;
+  }
+  HandleWrap::Close(close_callback);
+}
+
+void RecursiveFSEventWrap::OnPoll(uv_poll_t* handle, int status, int events) {
+  RecursiveFSEventWrap* wrap =
+      ContainerOf(&RecursiveFSEventWrap::handle_, handle);
+  if (status == 0) {
+    status = wrap->watcher_.ReadEvents([&](std::string_view name, int events) {
+      wrap->batch_.Add(name, events);
+    });
+  }
+  if (status != 0) {
+    uv_poll_stop(handle);
+    return wrap->Flush(status);
+  }
+  if (wrap->batch_.empty()) return;
+  if (wrap->timer_ == nullptr) return wrap->Flush(0);
+  // Events that arrive while the timer is pending join the batch.
+  if (!uv_is_active(reinterpret_cast<uv_handle_t*>(wrap->timer_)))
+    uv_timer_start(wrap->timer_, OnTimer, wrap->delay_, 0);
+}
+
+void RecursiveFSEventWrap::OnTimer(uv_timer_t* timer) {
+  RecursiveFSEventWrap* wrap = static_cast<RecursiveFSEventWrap*>(timer->data);
+  if (wrap != nullptr) wrap->Flush(0);
+}
+
+void RecursiveFSEventWrap::Flush(int status) {
+  Environment* env = this->env();
+  Isolate* isolate = env->isolate();
+  HandleScope handle_scope(isolate);
+  Context::Scope context_scope(env->context());
+
+  std::vector<fs_watcher::EventBatch::Event> batch = batch_.Take();
+  std::vector<Local<Value>> events;
+  std::vector<Local<Value>> filenames;
+  events.reserve(batch.size());
+  filenames.reserve(batch.size());
+  for (const fs_watcher::EventBatch::Event& event : batch) {
+    // As in FSEventWrap, a rename implies a change.
+    events.push_back(event.second & UV_RENAME ? env->rename_string()
+                                              : env->change_string());
+    // Like FSEventWrap, fall back to a Buffer when the filename cannot be
+    // encoded.
+    TryCatch try_catch(isolate);
+    Local<Value> filename;
+    if (!StringBytes::Encode(isolate,
+                             event.first.data(),
+                             event.first.size(),
+                             encoding_)
+             .ToLocal(&filename)) {
+      status = UV_EINVAL;
+      filename = StringBytes::Encode(
+                     isolate, event.first.data(), event.first.size(), BUFFER)
+                     .ToLocalChecked();
+    }
+    filenames.push_back(filename);
+  }
+
+  Local<Value> argv[] = {
+      Integer::New(isolate, status),
+      Array::New(isolate, events.data(), events.size()),
+      Array::New(isolate, filenames.data(), filenames.size()),
+  };
+  MakeCallback(env->onchange_string(), arraysize(argv), argv);
+}
+
 }  // anonymous namespace
 }  // namespace node
 
@@ -6,6 +6,9 @@
 #include "permission/permission.h"
 #include "stream_base-inl.h"
 #include "util-inl.h"
+#include "zstd.h"
+
+#include <vector>
 
 // Copied from https://github.com/nodejs/node/blob/b07dc4d19fdbc15b4f76557dc45b3ce3a43ad0c3/src/util.cc#L36-L41.
 #ifdef _WIN32
@@ -231,8 +234,15 @@ class FileOutputStream : public v8::OutputStream {
   void EndOfStream() override {}
 
   WriteResult WriteAsciiChunk(char* data, const int size) override {
+    return Write(data, size);
+  }
+
+  int status() const { return status_; }
+
+ protected:
+  WriteResult Write(char* data, const size_t size) {
     DCHECK_EQ(status_, 0);
-    int offset = 0;
+    size_t offset = 0;
     while (offset < size) {
       const uv_buf_t buf = uv_buf_init(data + offset, size - offset);
       const int num_bytes_written = uv_fs_write(nullptr,
@@ -254,7 +264,7 @@ class FileOutputStream : public v8::OutputStream {
     return kContinue;
   }
 
-  int status() const { return status_; }
+  void set_status(int status) { status_ = status; }
 
  private:
   const int fd_;
@@ -262,6 +272,60 @@ class FileOutputStream : public v8::OutputStream {
   int status_ = 0;
 };
 
+// Compresses the snapshot with zstd while it is being written, so that only
+// the compressor's window and one output buffer are held in addition to the
+// snapshot itself, and the file is a fraction of the size of the JSON.
+class ZstdFileOutputStream : public FileOutputStream {
+ public:
+  ZstdFileOutputStream(const int fd, uv_fs_t* req)
+      : FileOutputStream(fd, req),
+        cctx_(ZSTD_createCCtx()),
+        out_(ZSTD_CStreamOutSize()) {
+    if (cctx_ == nullptr ||
+        ZSTD_isError(ZSTD_CCtx_setParameter(
+            cctx_, ZSTD_c_compressionLevel, kCompressionLevel)) ||
+        ZSTD_isError(ZSTD_CCtx_setParameter(cctx_, ZSTD_c_checksumFlag, 1))) {
+      set_status(UV_ENOMEM);
+    }
+  }
+
+  ~ZstdFileOutputStream() override { ZSTD_freeCCtx(cctx_); }
+
+  void EndOfStream() override {
+    if (status() < 0) return;
+    ZSTD_inBuffer in = {nullptr, 0, 0};
+    Compress(&in, ZSTD_e_end);
+  }
+
+  WriteResult WriteAsciiChunk(char* data, const int size) override {
+    if (status() < 0) return kAbort;
+    ZSTD_inBuffer in = {data, static_cast<size_t>(size), 0};
+    return Compress(&in, ZSTD_e_continue);
+  }
+
+ private:
+  // Fast enough to keep up with the serializer, while JSON snapshots still
+  // compress by an order of magnitude.
+  static constexpr int kCompressionLevel = 3;
+
+  WriteResult Compress(ZSTD_inBuffer* in, ZSTD_EndDirective mode) {
+    size_t remaining;
+    do {
+      ZSTD_outBuffer out = {out_.data(), out_.size(), 0};
+      remaining = ZSTD_compressStream2(cctx_, &out, in, mode);
+      if (ZSTD_isError(remaining)) {
+        set_status(UV_EIO);
+        return kAbort;
+      }
+      if (out.pos > 0 && Write(out_.data(), out.pos) == kAbort) return kAbort;
+    } while (mode == ZSTD_e_end ? remaining != 0 : in->pos < in->size);
+    return kContinue;
+  }
+
+  ZSTD_CCtx* cctx_;
+  std::vector<char> out_;
+};
+
 class HeapSnapshotStream : public AsyncWrap,
                            public StreamBase,
                            public v8::OutputStream {
@@ -354,7 +418,8 @@ inline void TakeSnapshot(Environment* env,
 
 Maybe<void> WriteSnapshot(Environment* env,
                           const char* filename,
-                          HeapProfiler::HeapSnapshotOptions options) {
+                          HeapProfiler::HeapSnapshotOptions options,
+                          SnapshotCompression compression) {
   uv_fs_t req;
   int err;
 
@@ -370,9 +435,13 @@ Maybe<void> WriteSnapshot(Environment* env,
     return Nothing<void>();
   }
 
-  FileOutputStream stream(fd, &req);
-  TakeSnapshot(env, &stream, options);
-  if ((err = stream.status()) < 0) {
+  std::unique_ptr<FileOutputStream> stream;
+  if (compression == SnapshotCompression::kZstd)
+    stream = std::make_unique<ZstdFileOutputStream>(fd, &req);
+  else
+    stream = std::make_unique<FileOutputStream>(fd, &req);
+  if (stream->status() == 0) TakeSnapshot(env, stream.get(), options);
+  if ((err = stream->status()) < 0) {
     env->ThrowUVException(err, "write", nullptr, filename);
     return Nothing<void>();
   }
@@ -445,20 +514,30 @@ void CreateHeapSnapshotStream(const FunctionCallbackInfo<Value>& args) {
     args.GetReturnValue().Set(stream->object());
 }
 
+// triggerHeapSnapshot(filename, options[, compress])
+// With |compress|, the snapshot is written compressed with zstd, and the
+// default filename ends with .heapsnapshot.zst.
 void TriggerHeapSnapshot(const FunctionCallbackInfo<Value>& args) {
   Environment* env = Environment::GetCurrent(args);
   Isolate* isolate = args.GetIsolate();
-  CHECK_EQ(args.Length(), 2);
+  CHECK_GE(args.Length(), 2);
   Local<Value> filename_v = args[0];
   auto options = GetHeapSnapshotOptions(args[1]);
+  SnapshotCompression compression = args[2]->IsTrue()
+                                        ? SnapshotCompression::kZstd
+                                        : SnapshotCompression::kNone;
 
   if (filename_v->IsUndefined()) {
-    DiagnosticFilename name(env, "Heap", "heapsnapshot");
+    DiagnosticFilename name(env,
+                            "Heap",
+                            compression == SnapshotCompression::kZstd
+                                ? "heapsnapshot.zst"
+                                : "heapsnapshot");
     THROW_IF_INSUFFICIENT_PERMISSIONS(
         env,
         permission::PermissionScope::kFileSystemWrite,
         Environment::GetCwd(env->exec_path()));
-    if (WriteSnapshot(env, *name, options).IsNothing()) return;
+    if (WriteSnapshot(env, *name, options, compression).IsNothing()) return;
     if (String::NewFromUtf8(isolate, *name).ToLocal(&filename_v)) {
       args.GetReturnValue().Set(filename_v);
     }
@@ -470,7 +549,7 @@ void TriggerHeapSnapshot(const FunctionCallbackInfo<Value>& args) {
   ToNamespacedPath(env, &path);
   THROW_IF_INSUFFICIENT_PERMISSIONS(
       env, permission::PermissionScope::kFileSystemWrite, path.ToStringView());
-  if (WriteSnapshot(env, *path, options).IsNothing()) return;
+  if (WriteSnapshot(env, *path, options, compression).IsNothing()) return;
   return args.GetReturnValue().Set(filename_v);
 }
 
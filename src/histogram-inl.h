@@ -9,60 +9,116 @@
 
 namespace node {
 
+hdr_histogram* Histogram::RecordTarget() const {
+  if (shards_.empty()) return histogram_.get();
+  // Threads are spread over the shards in the order they first record.
+  static std::atomic<size_t> next_shard{0};
+  thread_local size_t shard =
+      next_shard.fetch_add(1, std::memory_order_relaxed);
+  return shards_[shard % shards_.size()].get();
+}
+
+hdr_histogram* Histogram::ReadTarget() const {
+  if (shards_.empty()) return histogram_.get();
+  // Values that are being recorded concurrently may or may not be seen.
+  hdr_reset(histogram_.get());
+  for (const HistogramPointer& shard : shards_)
+    hdr_add(histogram_.get(), shard.get());
+  return histogram_.get();
+}
+
+void Histogram::CountRecorded(bool recorded) {
+  if (lock_free()) {
+    if (!recorded) exceeds_.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  // mutex_ is held, there is no need for atomic increments.
+  if (recorded) {
+    count_++;
+  } else {
+    exceeds_.store(exceeds_.load(std::memory_order_relaxed) + 1,
+                   std::memory_order_relaxed);
+  }
+}
+
 void Histogram::Reset() {
   Mutex::ScopedLock lock(mutex_);
+  // In the lock-free modes, values recorded concurrently may be lost.
   hdr_reset(histogram_.get());
+  for (const HistogramPointer& shard : shards_) hdr_reset(shard.get());
   exceeds_ = 0;
   count_ = 0;
   prev_ = 0;
 }
 
 double Histogram::Add(const Histogram& other) {
+  if (!lock_free() && !other.lock_free()) {
+    Mutex::ScopedLock lock(mutex_);
+    count_ += other.count_;
+    exceeds_ += other.exceeds_;
+    if (other.prev_ > prev_)
+      prev_ = other.prev_.load();
+    return static_cast<double>(
+        hdr_add(histogram_.get(), other.histogram_.get()));
+  }
+
+  HistogramPointer values = other.Copy();
   Mutex::ScopedLock lock(mutex_);
-  count_ += other.count_;
+  if (!lock_free()) count_ += values->total_count;
   exceeds_ += other.exceeds_;
   if (other.prev_ > prev_)
-    prev_ = other.prev_;
-  return static_cast<double>(hdr_add(histogram_.get(), other.histogram_.get()));
+    prev_ = other.prev_.load();
+  hdr_histogram* target = lock_free() ? RecordTarget() : histogram_.get();
+  int64_t dropped = 0;
+  hdr_iter iter;
+  hdr_iter_recorded_init(&iter, values.get());
+  while (hdr_iter_next(&iter)) {
+    bool recorded =
+        lock_free() ? hdr_record_values_atomic(target, iter.value, iter.count)
+                    : hdr_record_values(target, iter.value, iter.count);
+    if (!recorded) dropped += iter.count;
+  }
+  return static_cast<double>(dropped);
 }
 
 size_t Histogram::Count() const {
   Mutex::ScopedLock lock(mutex_);
+  if (lock_free()) return ReadTarget()->total_count;
   return count_;
 }
 
 int64_t Histogram::Min() const {
   Mutex::ScopedLock lock(mutex_);
-  return hdr_min(histogram_.get());
+  return hdr_min(ReadTarget());
 }
 
 int64_t Histogram::Max() const {
   Mutex::ScopedLock lock(mutex_);
-  return hdr_max(histogram_.get());
+  return hdr_max(ReadTarget());
 }
 
 double Histogram::Mean() const {
   Mutex::ScopedLock lock(mutex_);
-  return hdr_mean(histogram_.get());
+  return hdr_mean(ReadTarget());
 }
 
 double Histogram::Stddev() const {
   Mutex::ScopedLock lock(mutex_);
-  return hdr_stddev(histogram_.get());
+  return hdr_stddev(ReadTarget());
 }
 
 int64_t Histogram::Percentile(double percentile) const {
   Mutex::ScopedLock lock(mutex_);
   CHECK_GT(percentile, 0);
   CHECK_LE(percentile, 100);
-  return hdr_value_at_percentile(histogram_.get(), percentile);
+  return hdr_value_at_percentile(ReadTarget(), percentile);
 }
 
 template <typename Iterator>
 void Histogram::Percentiles(Iterator&& fn) {
   Mutex::ScopedLock lock(mutex_);
   hdr_iter iter;
-  hdr_iter_percentile_init(&iter, histogram_.get(), 1);
+  hdr_iter_percentile_init(&iter, ReadTarget(), 1);
   while (hdr_iter_next(&iter)) {
     double key = iter.specifics.percentiles.percentile;
     fn(key, iter.value);
@@ -70,34 +126,46 @@ void Histogram::Percentiles(Iterator&& fn) {
 }
 
 bool Histogram::Record(int64_t value) {
+  if (lock_free()) {
+    bool recorded = hdr_record_value_atomic(RecordTarget(), value);
+    CountRecorded(recorded);
+    return recorded;
+  }
   Mutex::ScopedLock lock(mutex_);
   bool recorded = hdr_record_value(histogram_.get(), value);
-  if (!recorded)
-    exceeds_++;
-  else
-    count_++;
+  CountRecorded(recorded);
   return recorded;
 }
 
 uint64_t Histogram::RecordDelta() {
-  Mutex::ScopedLock lock(mutex_);
   uint64_t time = uv_hrtime();
+  if (lock_free()) {
+    uint64_t prev = prev_.exchange(time, std::memory_order_relaxed);
+    // Concurrent callers may swap their times in out of order.
+    if (prev == 0 || prev >= time) return 0;
+    int64_t delta = time - prev;
+    CountRecorded(hdr_record_value_atomic(RecordTarget(), delta));
+    return delta;
+  }
+
+  Mutex::ScopedLock lock(mutex_);
+  uint64_t prev = prev_.load(std::memory_order_relaxed);
   int64_t delta = 0;
-  if (prev_ > 0) {
-    CHECK_GE(time, prev_);
-    delta = time - prev_;
-    if (hdr_record_value(histogram_.get(), delta))
-      count_++;
-    else
-      exceeds_++;
+  if (prev > 0) {
+    CHECK_GE(time, prev);
+    delta = time - prev;
+    CountRecorded(hdr_record_value(histogram_.get(), delta));
   }
-  prev_ = time;
+  prev_.store(time, std::memory_order_relaxed);
   return delta;
 }
 
 size_t Histogram::GetMemorySize() const {
   Mutex::ScopedLock lock(mutex_);
-  return hdr_get_memory_size(histogram_.get());
+  size_t size = hdr_get_memory_size(histogram_.get());
+  for (const HistogramPointer& shard : shards_)
+    size += hdr_get_memory_size(shard.get());
+  return size;
 }
 
 }  // namespace node
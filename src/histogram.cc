@@ -6,6 +6,8 @@
 #include "node_external_reference.h"
 #include "util.h"
 
+#include <algorithm>
+
 namespace node {
 
 using v8::BigInt;
@@ -26,13 +28,33 @@ using v8::String;
 using v8::Uint32;
 using v8::Value;
 
-Histogram::Histogram(const Options& options) {
-  hdr_histogram* histogram;
-  CHECK_EQ(0, hdr_init(options.lowest,
-                       options.highest,
-                       options.figures,
-                       &histogram));
-  histogram_.reset(histogram);
+Histogram::Histogram(const Options& options) : mode_(options.mode) {
+  auto create = [&]() {
+    hdr_histogram* histogram;
+    CHECK_EQ(0, hdr_init(options.lowest,
+                         options.highest,
+                         options.figures,
+                         &histogram));
+    return HistogramPointer(histogram);
+  };
+  histogram_ = create();
+  if (mode_ == Mode::kSharded) {
+    size_t shards =
+        std::clamp<size_t>(uv_available_parallelism(), 1, kMaxShards);
+    for (size_t n = 0; n < shards; n++) shards_.push_back(create());
+  }
+}
+
+Histogram::HistogramPointer Histogram::Copy() const {
+  Mutex::ScopedLock lock(mutex_);
+  hdr_histogram* source = ReadTarget();
+  hdr_histogram* copy;
+  CHECK_EQ(0, hdr_init(source->lowest_discernible_value,
+                       source->highest_trackable_value,
+                       source->significant_figures,
+                       &copy));
+  hdr_add(copy, source);
+  return HistogramPointer(copy);
 }
 
 void Histogram::MemoryInfo(MemoryTracker* tracker) const {
@@ -177,15 +199,66 @@ void HistogramBase::FastRecordDelta(Local<Value> unused,
   (*histogram)->RecordDelta();
 }
 
+namespace {
+
+// Reads (lowest, highest, figures[, mode]) starting at args[offset].
+Histogram::Options GetHistogramOptions(const FunctionCallbackInfo<Value>& args,
+                                       int offset) {
+  Local<Value> lowest_arg = args[offset];
+  Local<Value> highest_arg = args[offset + 1];
+  Local<Value> figures_arg = args[offset + 2];
+  Local<Value> mode_arg = args[offset + 3];
+
+  CHECK_IMPLIES(!lowest_arg->IsNumber(), lowest_arg->IsBigInt());
+  CHECK_IMPLIES(!highest_arg->IsNumber(), highest_arg->IsBigInt());
+  CHECK(figures_arg->IsUint32());
+
+  Histogram::Options options;
+  bool lossless_ignored;
+
+  if (lowest_arg->IsNumber()) {
+    options.lowest = lowest_arg.As<Integer>()->Value();
+  } else if (lowest_arg->IsBigInt()) {
+    options.lowest = lowest_arg.As<BigInt>()->Int64Value(&lossless_ignored);
+  }
+
+  if (highest_arg->IsNumber()) {
+    options.highest = highest_arg.As<Integer>()->Value();
+  } else if (highest_arg->IsBigInt()) {
+    options.highest = highest_arg.As<BigInt>()->Int64Value(&lossless_ignored);
+  }
+
+  options.figures = figures_arg.As<Uint32>()->Value();
+
+  if (!mode_arg->IsUndefined()) {
+    CHECK(mode_arg->IsUint32());
+    uint32_t value = mode_arg.As<Uint32>()->Value();
+    CHECK_LE(value, static_cast<uint32_t>(Histogram::Mode::kAtomic));
+    options.mode = static_cast<Histogram::Mode>(value);
+  }
+  return options;
+}
+
+// Converts the value passed to record(), returns false with an exception
+// pending if it is out of range.
+bool GetRecordValue(Environment* env, Local<Value> arg, int64_t* value) {
+  CHECK_IMPLIES(!arg->IsNumber(), arg->IsBigInt());
+  bool lossless = true;
+  *value = arg->IsBigInt() ? arg.As<BigInt>()->Int64Value(&lossless)
+                           : static_cast<int64_t>(arg.As<Number>()->Value());
+  if (!lossless || *value < 1) {
+    THROW_ERR_OUT_OF_RANGE(env, "value is out of range");
+    return false;
+  }
+  return true;
+}
+
+}  // namespace
+
 void HistogramBase::Record(const FunctionCallbackInfo<Value>& args) {
   Environment* env = Environment::GetCurrent(args);
-  CHECK_IMPLIES(!args[0]->IsNumber(), args[0]->IsBigInt());
-  bool lossless = true;
-  int64_t value = args[0]->IsBigInt()
-      ? args[0].As<BigInt>()->Int64Value(&lossless)
-      : static_cast<int64_t>(args[0].As<Number>()->Value());
-  if (!lossless || value < 1)
-    return THROW_ERR_OUT_OF_RANGE(env, "value is out of range");
+  int64_t value;
+  if (!GetRecordValue(env, args[0], &value)) return;
   HistogramBase* histogram;
   ASSIGN_OR_RETURN_UNWRAP(&histogram, args.This());
   (*histogram)->Record(value);
@@ -248,32 +321,7 @@ BaseObjectPtr<HistogramBase> HistogramBase::Create(
 void HistogramBase::New(const FunctionCallbackInfo<Value>& args) {
   CHECK(args.IsConstructCall());
   Environment* env = Environment::GetCurrent(args);
-
-  CHECK_IMPLIES(!args[0]->IsNumber(), args[0]->IsBigInt());
-  CHECK_IMPLIES(!args[1]->IsNumber(), args[1]->IsBigInt());
-  CHECK(args[2]->IsUint32());
-
-  int64_t lowest = 1;
-  int64_t highest = std::numeric_limits<int64_t>::max();
-
-  bool lossless_ignored;
-
-  if (args[0]->IsNumber()) {
-    lowest = args[0].As<Integer>()->Value();
-  } else if (args[0]->IsBigInt()) {
-    lowest = args[0].As<BigInt>()->Int64Value(&lossless_ignored);
-  }
-
-  if (args[1]->IsNumber()) {
-    highest = args[1].As<Integer>()->Value();
-  } else if (args[1]->IsBigInt()) {
-    highest = args[1].As<BigInt>()->Int64Value(&lossless_ignored);
-  }
-
-  int32_t figures = args[2].As<Uint32>()->Value();
-  new HistogramBase(env, args.This(), Histogram::Options {
-    lowest, highest, figures
-  });
+  new HistogramBase(env, args.This(), GetHistogramOptions(args, 0));
 }
 
 Local<FunctionTemplate> HistogramBase::GetConstructorTemplate(
@@ -334,6 +382,177 @@ void HistogramBase::HistogramTransferData::MemoryInfo(
   tracker->TrackField("histogram", histogram_);
 }
 
+RollingHistogram::RollingHistogram(const Options& options)
+    : histogram_options_(options.histogram),
+      interval_(options.interval),
+      clock_(options.clock),
+      start_(clock_()) {
+  CHECK_GT(interval_, 0);
+  CHECK_GT(options.windows, 0);
+  for (size_t n = 0; n < options.windows; n++)
+    windows_.push_back(std::make_unique<Histogram>(histogram_options_));
+}
+
+Histogram* RollingHistogram::Current() {
+  uint64_t epoch = (clock_() - start_) / interval_;
+  uint64_t current = epoch_.load(std::memory_order_acquire);
+  if (epoch > current) {
+    Mutex::ScopedLock lock(mutex_);
+    current = epoch_.load(std::memory_order_relaxed);
+    if (epoch > current) {
+      // Every window skipped over since the last rotation starts out empty.
+      uint64_t expired = std::min<uint64_t>(epoch - current, windows_.size());
+      for (uint64_t n = 1; n <= expired; n++)
+        windows_[(current + n) % windows_.size()]->Reset();
+      epoch_.store(epoch, std::memory_order_release);
+      current = epoch;
+    }
+  }
+  return windows_[current % windows_.size()].get();
+}
+
+bool RollingHistogram::Record(int64_t value) {
+  return Current()->Record(value);
+}
+
+uint64_t RollingHistogram::RecordDelta() {
+  uint64_t time = clock_();
+  uint64_t prev = prev_.exchange(time, std::memory_order_relaxed);
+  if (prev == 0 || prev >= time) return 0;
+  uint64_t delta = time - prev;
+  Current()->Record(delta);
+  return delta;
+}
+
+void RollingHistogram::Reset() {
+  Mutex::ScopedLock lock(mutex_);
+  for (const std::unique_ptr<Histogram>& window : windows_) window->Reset();
+  prev_ = 0;
+}
+
+std::shared_ptr<Histogram> RollingHistogram::Merge(size_t count) {
+  count = std::clamp<size_t>(count, 1, windows_.size());
+  Current();
+  Histogram::Options options = histogram_options_;
+  options.mode = Histogram::Mode::kLocked;
+  auto merged = std::make_shared<Histogram>(options);
+  Mutex::ScopedLock lock(mutex_);
+  uint64_t epoch = epoch_.load(std::memory_order_relaxed);
+  for (uint64_t n = 0; n < count && n <= epoch; n++)
+    merged->Add(*windows_[(epoch - n) % windows_.size()]);
+  return merged;
+}
+
+void RollingHistogram::MemoryInfo(MemoryTracker* tracker) const {
+  size_t size = 0;
+  for (const std::unique_ptr<Histogram>& window : windows_)
+    size += window->GetMemorySize();
+  tracker->TrackFieldWithSize("windows", size);
+}
+
+RollingHistogramBase::RollingHistogramBase(
+    Environment* env,
+    Local<Object> wrap,
+    const RollingHistogram::Options& options)
+    : BaseObject(env, wrap), histogram_(options) {
+  MakeWeak();
+}
+
+void RollingHistogramBase::MemoryInfo(MemoryTracker* tracker) const {
+  tracker->TrackField("histogram", histogram_);
+}
+
+// new RollingHistogram(intervalMs, windows, lowest, highest, figures[, mode])
+void RollingHistogramBase::New(const FunctionCallbackInfo<Value>& args) {
+  CHECK(args.IsConstructCall());
+  Environment* env = Environment::GetCurrent(args);
+  CHECK(args[0]->IsNumber());
+  CHECK(args[1]->IsUint32());
+  RollingHistogram::Options options;
+  double interval_ms = args[0].As<Number>()->Value();
+  CHECK_GT(interval_ms, 0);
+  options.interval = static_cast<uint64_t>(interval_ms * 1e6);
+  options.windows = args[1].As<Uint32>()->Value();
+  CHECK_GT(options.windows, 0);
+  options.histogram = GetHistogramOptions(args, 2);
+  new RollingHistogramBase(env, args.This(), options);
+}
+
+void RollingHistogramBase::Record(const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+  int64_t value;
+  if (!GetRecordValue(env, args[0], &value)) return;
+  RollingHistogramBase* histogram;
+  ASSIGN_OR_RETURN_UNWRAP(&histogram, args.This());
+  histogram->histogram_.Record(value);
+}
+
+void RollingHistogramBase::RecordDelta(
+    const FunctionCallbackInfo<Value>& args) {
+  RollingHistogramBase* histogram;
+  ASSIGN_OR_RETURN_UNWRAP(&histogram, args.This());
+  histogram->histogram_.RecordDelta();
+}
+
+void RollingHistogramBase::DoReset(const FunctionCallbackInfo<Value>& args) {
+  RollingHistogramBase* histogram;
+  ASSIGN_OR_RETURN_UNWRAP(&histogram, args.This());
+  histogram->histogram_.Reset();
+}
+
+// snapshot(windows) returns a Histogram with the values of the last
+// |windows| windows, including the current one.
+void RollingHistogramBase::Snapshot(const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+  RollingHistogramBase* histogram;
+  ASSIGN_OR_RETURN_UNWRAP(&histogram, args.This());
+  size_t count = histogram->histogram_.windows();
+  if (!args[0]->IsUndefined()) {
+    CHECK(args[0]->IsUint32());
+    count = args[0].As<Uint32>()->Value();
+  }
+  BaseObjectPtr<HistogramBase> snapshot =
+      HistogramBase::Create(env, histogram->histogram_.Merge(count));
+  if (snapshot) args.GetReturnValue().Set(snapshot->object());
+}
+
+Local<FunctionTemplate> RollingHistogramBase::GetConstructorTemplate(
+    IsolateData* isolate_data) {
+  Local<FunctionTemplate> tmpl =
+      isolate_data->rolling_histogram_ctor_template();
+  if (tmpl.IsEmpty()) {
+    Isolate* isolate = isolate_data->isolate();
+    tmpl = NewFunctionTemplate(isolate, New);
+    tmpl->SetClassName(FIXED_ONE_BYTE_STRING(isolate, "RollingHistogram"));
+    tmpl->InstanceTemplate()->SetInternalFieldCount(
+        BaseObject::kInternalFieldCount);
+    SetProtoMethod(isolate, tmpl, "record", Record);
+    SetProtoMethod(isolate, tmpl, "recordDelta", RecordDelta);
+    SetProtoMethod(isolate, tmpl, "reset", DoReset);
+    SetProtoMethodNoSideEffect(isolate, tmpl, "snapshot", Snapshot);
+    isolate_data->set_rolling_histogram_ctor_template(tmpl);
+  }
+  return tmpl;
+}
+
+void RollingHistogramBase::RegisterExternalReferences(
+    ExternalReferenceRegistry* registry) {
+  registry->Register(New);
+  registry->Register(Record);
+  registry->Register(RecordDelta);
+  registry->Register(DoReset);
+  registry->Register(Snapshot);
+}
+
+void RollingHistogramBase::Initialize(IsolateData* isolate_data,
+                                      Local<ObjectTemplate> target) {
+  SetConstructorFunction(isolate_data->isolate(),
+                         target,
+                         "RollingHistogram",
+                         GetConstructorTemplate(isolate_data),
+                         SetConstructorFunctionFlag::NONE);
+}
+
 Local<FunctionTemplate> IntervalHistogram::GetConstructorTemplate(
     Environment* env) {
   Local<FunctionTemplate> tmpl = env->intervalhistogram_constructor_template();
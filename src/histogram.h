@@ -11,10 +11,12 @@
 #include "uv.h"
 #include "v8.h"
 
+#include <atomic>
 #include <functional>
 #include <limits>
 #include <map>
 #include <string>
+#include <vector>
 
 namespace node {
 
@@ -24,12 +26,30 @@ constexpr int kDefaultHistogramFigures = 3;
 
 class Histogram : public MemoryRetainer {
  public:
+  enum class Mode : uint32_t {
+    // Every operation takes mutex_.
+    kLocked,
+    // Values are recorded without locking into one of several histograms,
+    // picked by the recording thread, which are merged when read. This
+    // keeps threads that share a histogram from contending with each other,
+    // at the price of memory and slower reads.
+    kSharded,
+    // Values are recorded without locking into a single histogram, by
+    // incrementing the buckets atomically.
+    kAtomic,
+  };
+
   struct Options {
     int64_t lowest = 1;
     int64_t highest = std::numeric_limits<int64_t>::max();
     int figures = kDefaultHistogramFigures;
+    Mode mode = Mode::kLocked;
   };
 
+  // Upper bound on the number of shards of a kSharded histogram, each of
+  // which is a full hdr_histogram.
+  static constexpr size_t kMaxShards = 8;
+
   explicit Histogram(const Options& options);
   virtual ~Histogram() = default;
 
@@ -54,15 +74,33 @@ class Histogram : public MemoryRetainer {
 
   inline size_t GetMemorySize() const;
 
+  Mode mode() const { return mode_; }
+
   void MemoryInfo(MemoryTracker* tracker) const override;
   SET_MEMORY_INFO_NAME(Histogram)
   SET_SELF_SIZE(Histogram)
 
  private:
   using HistogramPointer = DeleteFnPtr<hdr_histogram, hdr_close>;
+
+  inline bool lock_free() const { return mode_ != Mode::kLocked; }
+  // The histogram that the current thread records into.
+  inline hdr_histogram* RecordTarget() const;
+  // Returns the histogram to read from, merging the shards into histogram_
+  // first. mutex_ has to be held.
+  inline hdr_histogram* ReadTarget() const;
+  inline void CountRecorded(bool recorded);
+  // Copies the data of this histogram into a new hdr_histogram.
+  HistogramPointer Copy() const;
+
+  const Mode mode_;
+  // With kSharded, this is only the result of the last merge.
   HistogramPointer histogram_;
-  uint64_t prev_ = 0;
-  size_t exceeds_ = 0;
+  std::vector<HistogramPointer> shards_;
+  std::atomic<uint64_t> prev_{0};
+  // In the lock-free modes, only exceeds_ is maintained on recording, and
+  // the count is taken from the histogram itself.
+  std::atomic<size_t> exceeds_{0};
   size_t count_ = 0;
   Mutex mutex_;
 };
@@ -214,6 +252,79 @@ class HistogramBase final : public BaseObject, public HistogramImpl {
   static v8::CFunction fast_record_delta_;
 };
 
+// Keeps the values of the last |windows| intervals of |interval| nanoseconds
+// each, so that percentiles can be taken over a sliding window rather than
+// since creation. Windows are rotated lazily, by whichever thread records
+// or reads first after an interval has passed, so no timer is involved and
+// the rotation cannot race with a reset from JS.
+class RollingHistogram : public MemoryRetainer {
+ public:
+  struct Options {
+    Histogram::Options histogram;
+    uint64_t interval = 1000 * 1000 * 1000;
+    size_t windows = 10;
+    // Returns the current time in nanoseconds.
+    uint64_t (*clock)() = uv_hrtime;
+  };
+
+  explicit RollingHistogram(const Options& options);
+
+  bool Record(int64_t value);
+  uint64_t RecordDelta();
+  void Reset();
+
+  // Returns a new histogram with the values of the current window and the
+  // |count| - 1 windows before it.
+  std::shared_ptr<Histogram> Merge(size_t count);
+
+  size_t windows() const { return windows_.size(); }
+
+  void MemoryInfo(MemoryTracker* tracker) const override;
+  SET_MEMORY_INFO_NAME(RollingHistogram)
+  SET_SELF_SIZE(RollingHistogram)
+
+ private:
+  // Returns the window for the current time, resetting the windows that
+  // expired since the last rotation.
+  Histogram* Current();
+
+  const Histogram::Options histogram_options_;
+  const uint64_t interval_;
+  uint64_t (*const clock_)();
+  const uint64_t start_;
+  std::vector<std::unique_ptr<Histogram>> windows_;
+  // Number of intervals between start_ and the current window.
+  std::atomic<uint64_t> epoch_{0};
+  std::atomic<uint64_t> prev_{0};
+  Mutex mutex_;
+};
+
+class RollingHistogramBase final : public BaseObject {
+ public:
+  static v8::Local<v8::FunctionTemplate> GetConstructorTemplate(
+      IsolateData* isolate_data);
+  static void Initialize(IsolateData* isolate_data,
+                         v8::Local<v8::ObjectTemplate> target);
+  static void RegisterExternalReferences(ExternalReferenceRegistry* registry);
+
+  static void New(const v8::FunctionCallbackInfo<v8::Value>& args);
+  static void Record(const v8::FunctionCallbackInfo<v8::Value>& args);
+  static void RecordDelta(const v8::FunctionCallbackInfo<v8::Value>& args);
+  static void DoReset(const v8::FunctionCallbackInfo<v8::Value>& args);
+  static void Snapshot(const v8::FunctionCallbackInfo<v8::Value>& args);
+
+  RollingHistogramBase(Environment* env,
+                       v8::Local<v8::Object> wrap,
+                       const RollingHistogram::Options& options);
+
+  void MemoryInfo(MemoryTracker* tracker) const override;
+  SET_MEMORY_INFO_NAME(RollingHistogramBase)
+  SET_SELF_SIZE(RollingHistogramBase)
+
+ private:
+  RollingHistogram histogram_;
+};
+
 class IntervalHistogram final : public HandleWrap, public HistogramImpl {
  public:
   enum class StartFlags {
@@ -7,13 +7,18 @@
 #include "node_external_reference.h"
 #include "node_file.h"
 #include "node_internals.h"
+#include "proto_writer.h"
 #include "util-inl.h"
 #include "v8-inspector.h"
 
+#include <algorithm>
 #include <cinttypes>
 #include <limits>
 #include <sstream>
+#include <unordered_map>
+#include <unordered_set>
 #include "simdutf.h"
+#include "zlib.h"
 
 namespace node {
 namespace profiler {
@@ -26,6 +31,7 @@ using v8::HandleScope;
 using v8::Isolate;
 using v8::Local;
 using v8::NewStringType;
+using v8::Number;
 using v8::Object;
 using v8::String;
 using v8::Value;
@@ -389,6 +395,243 @@ void V8CoverageConnection::End() {
   TakeCoverage();
 }
 
+namespace {
+
+// Field numbers from pprof's profile.proto.
+namespace pprof {
+constexpr uint32_t kSampleType = 1;
+constexpr uint32_t kSample = 2;
+constexpr uint32_t kLocation = 4;
+constexpr uint32_t kFunction = 5;
+constexpr uint32_t kStringTable = 6;
+constexpr uint32_t kTimeNanos = 9;
+constexpr uint32_t kDurationNanos = 10;
+constexpr uint32_t kPeriodType = 11;
+constexpr uint32_t kPeriod = 12;
+
+constexpr uint32_t kValueTypeType = 1;
+constexpr uint32_t kValueTypeUnit = 2;
+
+constexpr uint32_t kSampleLocationId = 1;
+constexpr uint32_t kSampleValue = 2;
+
+constexpr uint32_t kLocationId = 1;
+constexpr uint32_t kLocationLine = 4;
+constexpr uint32_t kLineFunctionId = 1;
+constexpr uint32_t kLineLine = 2;
+
+constexpr uint32_t kFunctionId = 1;
+constexpr uint32_t kFunctionName = 2;
+constexpr uint32_t kFunctionSystemName = 3;
+constexpr uint32_t kFunctionFilename = 4;
+constexpr uint32_t kFunctionStartLine = 5;
+}  // namespace pprof
+
+// Builds a pprof Profile message. Strings are interned into the string
+// table and functions are deduplicated by name and position.
+class PprofBuilder {
+ public:
+  int64_t Intern(std::string_view str) {
+    auto [it, inserted] = string_ids_.emplace(str, strings_.size());
+    if (inserted) strings_.emplace_back(str);
+    return it->second;
+  }
+
+  void ValueType(uint32_t field, const char* type, const char* unit) {
+    ProtoWriter message;
+    message.Int(pprof::kValueTypeType, Intern(type));
+    message.Int(pprof::kValueTypeUnit, Intern(unit));
+    out_.Message(field, message);
+  }
+
+  // Adds a location with the given id, unless it was already added.
+  void Location(uint64_t id,
+                std::string_view name,
+                std::string_view url,
+                int line) {
+    if (!location_ids_.insert(id).second) return;
+    if (name.empty()) name = "(anonymous)";
+    line = std::max(line, 0);
+    std::string key = SPrintF("%s:%s:%d", name, url, line);
+    auto [function, inserted] =
+        function_ids_.emplace(std::move(key), function_ids_.size() + 1);
+    if (inserted) {
+      ProtoWriter message;
+      message.Varint(pprof::kFunctionId, function->second);
+      message.Int(pprof::kFunctionName, Intern(name));
+      message.Int(pprof::kFunctionSystemName, Intern(name));
+      message.Int(pprof::kFunctionFilename, Intern(url));
+      message.Int(pprof::kFunctionStartLine, line);
+      out_.Message(pprof::kFunction, message);
+    }
+
+    ProtoWriter line_message;
+    line_message.Varint(pprof::kLineFunctionId, function->second);
+    line_message.Int(pprof::kLineLine, line);
+    ProtoWriter location;
+    location.Varint(pprof::kLocationId, id);
+    location.Message(pprof::kLocationLine, line_message);
+    out_.Message(pprof::kLocation, location);
+  }
+
+  // |stack| lists location ids from the leaf to the root.
+  void Sample(const std::vector<uint64_t>& stack,
+              const std::vector<int64_t>& values) {
+    ProtoWriter sample;
+    sample.PackedVarints(pprof::kSampleLocationId, stack);
+    sample.PackedVarints(pprof::kSampleValue, values);
+    out_.Message(pprof::kSample, sample);
+  }
+
+  void Int(uint32_t field, int64_t value) { out_.Int(field, value); }
+
+  std::string Finish() {
+    for (const std::string& str : strings_) {
+      out_.Bytes(pprof::kStringTable, str);
+    }
+    return out_.data();
+  }
+
+ private:
+  ProtoWriter out_;
+  std::vector<std::string> strings_ = {""};
+  std::unordered_map<std::string, int64_t> string_ids_ = {{"", 0}};
+  std::unordered_map<std::string, uint64_t> function_ids_;
+  std::unordered_set<uint64_t> location_ids_;
+};
+
+// Encodes |profile| as a pprof Profile message with "samples" and "cpu"
+// values. Samples with the same leaf node have the same stack, so they are
+// merged, which makes a window of a mostly idle process very small.
+std::string SerializePprof(const v8::CpuProfile* profile,
+                           uint64_t interval_us) {
+  PprofBuilder out;
+  out.ValueType(pprof::kSampleType, "samples", "count");
+  out.ValueType(pprof::kSampleType, "cpu", "nanoseconds");
+
+  struct Totals {
+    int64_t count = 0;
+    int64_t nanos = 0;
+  };
+  std::vector<const v8::CpuProfileNode*> leaves;
+  std::unordered_map<const v8::CpuProfileNode*, Totals> totals;
+  int64_t previous = profile->GetStartTime();
+  for (int i = 0; i < profile->GetSamplesCount(); i++) {
+    const v8::CpuProfileNode* node = profile->GetSample(i);
+    int64_t timestamp = profile->GetSampleTimestamp(i);
+    auto [it, inserted] = totals.emplace(node, Totals());
+    if (inserted) leaves.push_back(node);
+    it->second.count++;
+    it->second.nanos += std::max<int64_t>(timestamp - previous, 0) * 1000;
+    previous = timestamp;
+  }
+
+  // Locations are identified by the profile node, which is what the
+  // samples refer to.
+  std::vector<uint64_t> stack;
+  for (const v8::CpuProfileNode* leaf : leaves) {
+    stack.clear();
+    for (const v8::CpuProfileNode* node = leaf;
+         node != nullptr && node->GetParent() != nullptr;
+         node = node->GetParent()) {
+      stack.push_back(node->GetNodeId());
+      out.Location(node->GetNodeId(),
+                   node->GetFunctionNameStr(),
+                   node->GetScriptResourceNameStr(),
+                   node->GetLineNumber());
+    }
+    const Totals& leaf_totals = totals[leaf];
+    out.Sample(stack, {leaf_totals.count, leaf_totals.nanos});
+  }
+
+  // The profile times are monotonic, pprof wants the wall clock.
+  int64_t duration_us = profile->GetEndTime() - profile->GetStartTime();
+  int64_t now_us = static_cast<int64_t>(GetCurrentTimeInMicroseconds());
+  out.Int(pprof::kTimeNanos, (now_us - duration_us) * 1000);
+  out.Int(pprof::kDurationNanos, duration_us * 1000);
+  out.ValueType(pprof::kPeriodType, "cpu", "nanoseconds");
+  out.Int(pprof::kPeriod, static_cast<int64_t>(interval_us * 1000));
+  return out.Finish();
+}
+
+// Encodes |profile| as a pprof Profile message with the "inuse_objects" and
+// "inuse_space" values of every allocation site, like Go's heap profiles.
+// V8 already scales the sampled allocations to estimates of the totals.
+std::string SerializeHeapPprof(Isolate* isolate,
+                               v8::AllocationProfile* profile,
+                               uint64_t interval_bytes,
+                               uint64_t start_time_us) {
+  PprofBuilder out;
+  out.ValueType(pprof::kSampleType, "inuse_objects", "count");
+  out.ValueType(pprof::kSampleType, "inuse_space", "bytes");
+
+  // Walks the allocation tree depth first, keeping the stack of the current
+  // node in |stack| in root to leaf order.
+  std::vector<uint64_t> stack;
+  std::vector<uint64_t> sample_stack;
+  auto visit = [&](auto& self, const v8::AllocationProfile::Node* node)
+      -> void {
+    bool is_root = node == profile->GetRootNode();
+    if (!is_root) {
+      Utf8Value name(isolate, node->name);
+      Utf8Value url(isolate, node->script_name);
+      out.Location(node->node_id,
+                   name.ToStringView(),
+                   url.ToStringView(),
+                   node->line_number);
+      stack.push_back(node->node_id);
+    }
+    int64_t count = 0;
+    int64_t bytes = 0;
+    for (const v8::AllocationProfile::Allocation& allocation :
+         node->allocations) {
+      count += allocation.count;
+      bytes += static_cast<int64_t>(allocation.size) * allocation.count;
+    }
+    if (count > 0) {
+      sample_stack.assign(stack.rbegin(), stack.rend());
+      out.Sample(sample_stack, {count, bytes});
+    }
+    for (const v8::AllocationProfile::Node* child : node->children)
+      self(self, child);
+    if (!is_root) stack.pop_back();
+  };
+  visit(visit, profile->GetRootNode());
+
+  int64_t now_us = static_cast<int64_t>(GetCurrentTimeInMicroseconds());
+  out.Int(pprof::kTimeNanos, static_cast<int64_t>(start_time_us) * 1000);
+  out.Int(pprof::kDurationNanos,
+          (now_us - static_cast<int64_t>(start_time_us)) * 1000);
+  out.ValueType(pprof::kPeriodType, "space", "bytes");
+  out.Int(pprof::kPeriod, static_cast<int64_t>(interval_bytes));
+  return out.Finish();
+}
+
+bool GzipCompress(std::string_view input, std::string* output) {
+  z_stream stream{};
+  // 16 + 15 window bits selects the gzip format.
+  if (deflateInit2(&stream,
+                   Z_DEFAULT_COMPRESSION,
+                   Z_DEFLATED,
+                   16 + 15,
+                   8,
+                   Z_DEFAULT_STRATEGY) != Z_OK) {
+    return false;
+  }
+  output->resize(deflateBound(&stream, input.size()));
+  stream.next_in =
+      reinterpret_cast<Bytef*>(const_cast<char*>(input.data()));
+  stream.avail_in = input.size();
+  stream.next_out = reinterpret_cast<Bytef*>(output->data());
+  stream.avail_out = output->size();
+  int ret = deflate(&stream, Z_FINISH);
+  output->resize(stream.total_out);
+  deflateEnd(&stream);
+  return ret == Z_STREAM_END;
+}
+
+}  // namespace
+
 std::string V8CpuProfilerConnection::GetDirectory() const {
   return env()->cpu_prof_dir();
 }
@@ -397,7 +640,24 @@ std::string V8CpuProfilerConnection::GetFilename() const {
   return env()->cpu_prof_name();
 }
 
+V8CpuProfilerConnection::~V8CpuProfilerConnection() {
+  if (cpu_profiler_ != nullptr) cpu_profiler_->Dispose();
+}
+
 void V8CpuProfilerConnection::Start() {
+  const EnvironmentOptions* options = env()->options().get();
+  if (!options->cpu_prof_signal.empty())
+    StartToggleSignal(options->cpu_prof_signal);
+  if (options->cpu_prof_continuous) {
+    StartContinuous(options->cpu_prof_window);
+    return;
+  }
+  if (!options->cpu_prof) {
+    // Only armed through --cpu-prof-signal.
+    return;
+  }
+
+  inspector_profiling_ = true;
   DispatchMessage("Profiler.enable");
   std::string params = R"({ "interval": )";
   params += std::to_string(env()->cpu_prof_interval());
@@ -414,7 +674,146 @@ void V8CpuProfilerConnection::End() {
     return;
   }
   ending_ = true;
-  DispatchMessage("Profiler.stop", nullptr, true);
+  // Write out whatever the last window collected.
+  StopContinuous();
+  CloseHandles();
+  if (inspector_profiling_) {
+    DispatchMessage("Profiler.stop", nullptr, true);
+  }
+}
+
+bool V8CpuProfilerConnection::StartContinuous(uint64_t window_ms) {
+  if (inspector_profiling_ || ending_) return false;
+  if (!continuous()) {
+    Debug(env_,
+          DebugCategory::INSPECTOR_PROFILER,
+          "Starting continuous CPU profiling, window = %" PRIu64 "ms\n",
+          window_ms);
+    cpu_profiler_ = v8::CpuProfiler::New(env()->isolate());
+    RotateWindow(true);
+  }
+  if (window_timer_ == nullptr) {
+    window_timer_ = new uv_timer_t();
+    CHECK_EQ(uv_timer_init(env()->event_loop(), window_timer_), 0);
+    window_timer_->data = this;
+    uv_unref(reinterpret_cast<uv_handle_t*>(window_timer_));
+  }
+  CHECK_EQ(uv_timer_start(
+               window_timer_,
+               [](uv_timer_t* timer) {
+                 static_cast<V8CpuProfilerConnection*>(timer->data)
+                     ->RotateWindow(true);
+               },
+               window_ms,
+               window_ms),
+           0);
+  return true;
+}
+
+void V8CpuProfilerConnection::StopContinuous() {
+  if (!continuous()) return;
+  Debug(env_,
+        DebugCategory::INSPECTOR_PROFILER,
+        "Stopping continuous CPU profiling\n");
+  if (window_timer_ != nullptr) uv_timer_stop(window_timer_);
+  RotateWindow(false);
+  cpu_profiler_->Dispose();
+  cpu_profiler_ = nullptr;
+}
+
+void V8CpuProfilerConnection::RotateWindow(bool restart) {
+  HandleScope handle_scope(env()->isolate());
+  bool had_window = window_active_;
+  v8::ProfilerId previous = window_id_;
+  window_active_ = false;
+  if (restart) {
+    v8::CpuProfilingResult result = cpu_profiler_->Start(
+        v8::CpuProfilingOptions(
+            v8::kLeafNodeLineNumbers,
+            v8::CpuProfilingOptions::kNoSampleLimit,
+            static_cast<int>(env()->cpu_prof_interval())));
+    if (result.status == v8::CpuProfilingStatus::kErrorTooManyProfilers) {
+      fprintf(stderr, "Failed to start the next CPU profile window\n");
+    } else {
+      window_id_ = result.id;
+      window_active_ = true;
+    }
+  }
+  if (had_window) {
+    v8::CpuProfile* profile = cpu_profiler_->Stop(previous);
+    if (profile != nullptr) {
+      WriteWindow(profile);
+      profile->Delete();
+    }
+    window_count_++;
+  }
+}
+
+void V8CpuProfilerConnection::WriteWindow(const v8::CpuProfile* profile) {
+  std::string directory = GetDirectory();
+  DCHECK(!directory.empty());
+  if (!EnsureDirectory(directory, type())) {
+    return;
+  }
+
+  std::string filename;
+  if (env()->cpu_prof_name().empty()) {
+    filename = *DiagnosticFilename(env(), "CPU", "pb.gz");
+  } else {
+    filename = SPrintF("%s.%d.pb.gz", env()->cpu_prof_name(), window_count_);
+  }
+  std::string path = directory + kPathSeparator + filename;
+
+  std::string compressed;
+  if (!GzipCompress(SerializePprof(profile, env()->cpu_prof_interval()),
+                    &compressed)) {
+    fprintf(stderr, "Failed to compress CPU profile %s\n", path.c_str());
+    return;
+  }
+  WriteResult(env_, path.c_str(), compressed);
+}
+
+void V8CpuProfilerConnection::StartToggleSignal(const std::string& signal) {
+  int signo = 0;
+  for (int i = 1; i < 64 && signo == 0; i++) {
+    if (signal == signo_string(i)) signo = i;
+  }
+  if (signo == 0) {
+    fprintf(stderr, "Unknown signal %s for --cpu-prof-signal\n",
+            signal.c_str());
+    return;
+  }
+
+  toggle_signal_ = new uv_signal_t();
+  CHECK_EQ(uv_signal_init(env()->event_loop(), toggle_signal_), 0);
+  toggle_signal_->data = this;
+  uv_unref(reinterpret_cast<uv_handle_t*>(toggle_signal_));
+  CHECK_EQ(uv_signal_start(
+               toggle_signal_,
+               [](uv_signal_t* handle, int signum) {
+                 auto* connection =
+                     static_cast<V8CpuProfilerConnection*>(handle->data);
+                 if (connection->continuous()) {
+                   connection->StopContinuous();
+                 } else {
+                   connection->StartContinuous(
+                       connection->env()->options()->cpu_prof_window);
+                 }
+               },
+               signo),
+           0);
+}
+
+void V8CpuProfilerConnection::CloseHandles() {
+  if (window_timer_ != nullptr) {
+    env()->CloseHandle(window_timer_, [](uv_timer_t* timer) { delete timer; });
+    window_timer_ = nullptr;
+  }
+  if (toggle_signal_ != nullptr) {
+    env()->CloseHandle(toggle_signal_,
+                       [](uv_signal_t* signal) { delete signal; });
+    toggle_signal_ = nullptr;
+  }
 }
 
 std::string V8HeapProfilerConnection::GetDirectory() const {
@@ -426,6 +825,12 @@ std::string V8HeapProfilerConnection::GetFilename() const {
 }
 
 void V8HeapProfilerConnection::Start() {
+  if (env()->options()->heap_prof_continuous) {
+    StartContinuous(env()->options()->heap_prof_window);
+    return;
+  }
+
+  inspector_profiling_ = true;
   DispatchMessage("HeapProfiler.enable");
   std::string params = R"({ "samplingInterval": )";
   params += std::to_string(env()->heap_prof_interval());
@@ -441,11 +846,142 @@ void V8HeapProfilerConnection::End() {
     return;
   }
   ending_ = true;
-  DispatchMessage("HeapProfiler.stopSampling", nullptr, true);
+  // Write out the allocations that are live at exit.
+  StopContinuous();
+  CloseHandles();
+  if (inspector_profiling_) {
+    DispatchMessage("HeapProfiler.stopSampling", nullptr, true);
+  }
+}
+
+bool V8HeapProfilerConnection::StartContinuous(uint64_t window_ms) {
+  if (inspector_profiling_ || ending_) return false;
+  if (!continuous_) {
+    Debug(env_,
+          DebugCategory::INSPECTOR_PROFILER,
+          "Starting continuous heap profiling, window = %" PRIu64 "ms\n",
+          window_ms);
+    if (!env()->isolate()->GetHeapProfiler()->StartSamplingHeapProfiler(
+            env()->heap_prof_interval())) {
+      // Someone else, e.g. an inspector client, is sampling already.
+      return false;
+    }
+    continuous_ = true;
+    continuous_start_ =
+        static_cast<uint64_t>(GetCurrentTimeInMicroseconds());
+  }
+  if (window_timer_ == nullptr) {
+    window_timer_ = new uv_timer_t();
+    CHECK_EQ(uv_timer_init(env()->event_loop(), window_timer_), 0);
+    window_timer_->data = this;
+    uv_unref(reinterpret_cast<uv_handle_t*>(window_timer_));
+  }
+  CHECK_EQ(uv_timer_start(
+               window_timer_,
+               [](uv_timer_t* timer) {
+                 static_cast<V8HeapProfilerConnection*>(timer->data)
+                     ->WriteWindow();
+               },
+               window_ms,
+               window_ms),
+           0);
+  return true;
+}
+
+void V8HeapProfilerConnection::StopContinuous() {
+  if (!continuous_) return;
+  Debug(env_,
+        DebugCategory::INSPECTOR_PROFILER,
+        "Stopping continuous heap profiling\n");
+  if (window_timer_ != nullptr) uv_timer_stop(window_timer_);
+  WriteWindow();
+  env()->isolate()->GetHeapProfiler()->StopSamplingHeapProfiler();
+  continuous_ = false;
+}
+
+// Unlike CPU profiles, allocation profiles are not split into windows:
+// every profile has the sampled allocations since sampling started that
+// have not been collected yet.
+void V8HeapProfilerConnection::WriteWindow() {
+  HandleScope handle_scope(env()->isolate());
+  std::unique_ptr<v8::AllocationProfile> profile(
+      env()->isolate()->GetHeapProfiler()->GetAllocationProfile());
+  if (!profile) return;
+
+  std::string directory = GetDirectory();
+  DCHECK(!directory.empty());
+  if (!EnsureDirectory(directory, type())) {
+    return;
+  }
+
+  std::string filename;
+  if (env()->heap_prof_name().empty()) {
+    filename = *DiagnosticFilename(env(), "Heap", "pb.gz");
+  } else {
+    filename =
+        SPrintF("%s.%d.pb.gz", env()->heap_prof_name(), window_count_);
+  }
+  std::string path = directory + kPathSeparator + filename;
+  window_count_++;
+
+  std::string compressed;
+  if (!GzipCompress(SerializeHeapPprof(env()->isolate(),
+                                       profile.get(),
+                                       env()->heap_prof_interval(),
+                                       continuous_start_),
+                    &compressed)) {
+    fprintf(stderr, "Failed to compress heap profile %s\n", path.c_str());
+    return;
+  }
+  WriteResult(env_, path.c_str(), compressed);
+}
+
+void V8HeapProfilerConnection::CloseHandles() {
+  if (window_timer_ != nullptr) {
+    env()->CloseHandle(window_timer_, [](uv_timer_t* timer) { delete timer; });
+    window_timer_ = nullptr;
+  }
 }
 
 // For now, we only support coverage profiling, but we may add more
 // in the future.
+static V8CpuProfilerConnection* CreateCpuProfilerConnection(Environment* env) {
+  const std::string& dir = env->options()->cpu_prof_dir;
+  env->set_cpu_prof_interval(env->options()->cpu_prof_interval);
+  env->set_cpu_prof_dir(dir.empty() ? Environment::GetCwd(env->exec_path())
+                                    : dir);
+  if (!env->options()->cpu_prof_name.empty()) {
+    env->set_cpu_prof_name(env->options()->cpu_prof_name);
+  } else if (env->options()->cpu_prof) {
+    DiagnosticFilename filename(env, "CPU", "cpuprofile");
+    env->set_cpu_prof_name(*filename);
+  }
+  // Otherwise every window of the continuous mode gets its own name.
+  CHECK_NULL(env->cpu_profiler_connection());
+  env->set_cpu_profiler_connection(
+      std::make_unique<V8CpuProfilerConnection>(env));
+  return env->cpu_profiler_connection();
+}
+
+static V8HeapProfilerConnection* CreateHeapProfilerConnection(
+    Environment* env) {
+  const std::string& dir = env->options()->heap_prof_dir;
+  env->set_heap_prof_interval(env->options()->heap_prof_interval);
+  env->set_heap_prof_dir(dir.empty() ? Environment::GetCwd(env->exec_path())
+                                     : dir);
+  if (!env->options()->heap_prof_name.empty()) {
+    env->set_heap_prof_name(env->options()->heap_prof_name);
+  } else if (env->options()->heap_prof) {
+    DiagnosticFilename filename(env, "Heap", "heapprofile");
+    env->set_heap_prof_name(*filename);
+  }
+  // Otherwise every window of the continuous mode gets its own name.
+  CHECK_NULL(env->heap_profiler_connection());
+  env->set_heap_profiler_connection(
+      std::make_unique<V8HeapProfilerConnection>(env));
+  return env->heap_profiler_connection();
+}
+
 static void EndStartedProfilers(Environment* env) {
   // TODO(joyeechueng): merge these connections and use one session per env.
   Debug(env, DebugCategory::INSPECTOR_PROFILER, "EndStartedProfilers\n");
@@ -477,36 +1013,12 @@ void StartProfilers(Environment* env) {
     env->set_coverage_connection(std::make_unique<V8CoverageConnection>(env));
     env->coverage_connection()->Start();
   }
-  if (env->options()->cpu_prof) {
-    const std::string& dir = env->options()->cpu_prof_dir;
-    env->set_cpu_prof_interval(env->options()->cpu_prof_interval);
-    env->set_cpu_prof_dir(dir.empty() ? Environment::GetCwd(env->exec_path())
-                                      : dir);
-    if (env->options()->cpu_prof_name.empty()) {
-      DiagnosticFilename filename(env, "CPU", "cpuprofile");
-      env->set_cpu_prof_name(*filename);
-    } else {
-      env->set_cpu_prof_name(env->options()->cpu_prof_name);
-    }
-    CHECK_NULL(env->cpu_profiler_connection());
-    env->set_cpu_profiler_connection(
-        std::make_unique<V8CpuProfilerConnection>(env));
-    env->cpu_profiler_connection()->Start();
-  }
-  if (env->options()->heap_prof) {
-    const std::string& dir = env->options()->heap_prof_dir;
-    env->set_heap_prof_interval(env->options()->heap_prof_interval);
-    env->set_heap_prof_dir(dir.empty() ? Environment::GetCwd(env->exec_path())
-                                       : dir);
-    if (env->options()->heap_prof_name.empty()) {
-      DiagnosticFilename filename(env, "Heap", "heapprofile");
-      env->set_heap_prof_name(*filename);
-    } else {
-      env->set_heap_prof_name(env->options()->heap_prof_name);
-    }
-    env->set_heap_profiler_connection(
-        std::make_unique<profiler::V8HeapProfilerConnection>(env));
-    env->heap_profiler_connection()->Start();
+  if (env->options()->cpu_prof || env->options()->cpu_prof_continuous ||
+      !env->options()->cpu_prof_signal.empty()) {
+    CreateCpuProfilerConnection(env)->Start();
+  }
+  if (env->options()->heap_prof || env->options()->heap_prof_continuous) {
+    CreateHeapProfilerConnection(env)->Start();
   }
 }
 
@@ -570,6 +1082,44 @@ static void EndCoverage(const FunctionCallbackInfo<Value>& args) {
   }
 }
 
+// startContinuousCpuProfile(windowMs)
+static void StartContinuousCpuProfile(const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+  CHECK(args[0]->IsNumber());
+  double window_ms = args[0].As<Number>()->Value();
+  CHECK_GE(window_ms, 1);
+  V8CpuProfilerConnection* connection = env->cpu_profiler_connection();
+  if (connection == nullptr) connection = CreateCpuProfilerConnection(env);
+  args.GetReturnValue().Set(
+      connection->StartContinuous(static_cast<uint64_t>(window_ms)));
+}
+
+static void StopContinuousCpuProfile(const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+  V8CpuProfilerConnection* connection = env->cpu_profiler_connection();
+  if (connection != nullptr) connection->StopContinuous();
+}
+
+// startContinuousHeapProfile(windowMs)
+static void StartContinuousHeapProfile(
+    const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+  CHECK(args[0]->IsNumber());
+  double window_ms = args[0].As<Number>()->Value();
+  CHECK_GE(window_ms, 1);
+  V8HeapProfilerConnection* connection = env->heap_profiler_connection();
+  if (connection == nullptr) connection = CreateHeapProfilerConnection(env);
+  args.GetReturnValue().Set(
+      connection->StartContinuous(static_cast<uint64_t>(window_ms)));
+}
+
+static void StopContinuousHeapProfile(
+    const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+  V8HeapProfilerConnection* connection = env->heap_profiler_connection();
+  if (connection != nullptr) connection->StopContinuous();
+}
+
 static void Initialize(Local<Object> target,
                        Local<Value> unused,
                        Local<Context> context,
@@ -580,6 +1130,18 @@ static void Initialize(Local<Object> target,
   SetMethod(context, target, "takeCoverage", TakeCoverage);
   SetMethod(context, target, "stopCoverage", StopCoverage);
   SetMethod(context, target, "endCoverage", EndCoverage);
+  SetMethod(context,
+            target,
+            "startContinuousCpuProfile",
+            StartContinuousCpuProfile);
+  SetMethod(
+      context, target, "stopContinuousCpuProfile", StopContinuousCpuProfile);
+  SetMethod(context,
+            target,
+            "startContinuousHeapProfile",
+            StartContinuousHeapProfile);
+  SetMethod(
+      context, target, "stopContinuousHeapProfile", StopContinuousHeapProfile);
 }
 
 void RegisterExternalReferences(ExternalReferenceRegistry* registry) {
@@ -588,6 +1150,10 @@ void RegisterExternalReferences(ExternalReferenceRegistry* registry) {
   registry->Register(TakeCoverage);
   registry->Register(StopCoverage);
   registry->Register(EndCoverage);
+  registry->Register(StartContinuousCpuProfile);
+  registry->Register(StopContinuousCpuProfile);
+  registry->Register(StartContinuousHeapProfile);
+  registry->Register(StopContinuousHeapProfile);
 }
 
 }  // namespace profiler
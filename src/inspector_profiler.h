@@ -11,6 +11,8 @@
 #include <unordered_set>
 #include "inspector_agent.h"
 #include "simdjson.h"
+#include "uv.h"
+#include "v8-profiler.h"
 
 namespace node {
 // Forward declaration to break recursive dependency chain with src/env.h.
@@ -110,6 +112,7 @@ class V8CpuProfilerConnection : public V8ProfilerConnection {
  public:
   explicit V8CpuProfilerConnection(Environment* env)
       : V8ProfilerConnection(env) {}
+  ~V8CpuProfilerConnection() override;
 
   void Start() override;
   void End() override;
@@ -120,9 +123,32 @@ class V8CpuProfilerConnection : public V8ProfilerConnection {
   std::string GetDirectory() const override;
   std::string GetFilename() const override;
 
+  // In continuous mode the profile is collected through v8::CpuProfiler
+  // directly instead of the inspector protocol, and every window of
+  // |window_ms| is written to the profile directory as a gzipped pprof
+  // profile. Returns false if the --cpu-prof profile is being collected.
+  bool StartContinuous(uint64_t window_ms);
+  void StopContinuous();
+  bool continuous() const { return cpu_profiler_ != nullptr; }
+
  private:
+  // Starts the next window before ending the current one, so that no
+  // samples are lost in between.
+  void RotateWindow(bool restart);
+  void WriteWindow(const v8::CpuProfile* profile);
+  void StartToggleSignal(const std::string& signal);
+  void CloseHandles();
+
   std::unique_ptr<inspector::InspectorSession> session_;
   bool ending_ = false;
+  bool inspector_profiling_ = false;
+  v8::CpuProfiler* cpu_profiler_ = nullptr;
+  bool window_active_ = false;
+  v8::ProfilerId window_id_ = 0;
+  // Number of windows written so far.
+  uint64_t window_count_ = 0;
+  uv_timer_t* window_timer_ = nullptr;
+  uv_signal_t* toggle_signal_ = nullptr;
 };
 
 class V8HeapProfilerConnection : public V8ProfilerConnection {
@@ -139,9 +165,28 @@ class V8HeapProfilerConnection : public V8ProfilerConnection {
   std::string GetDirectory() const override;
   std::string GetFilename() const override;
 
+  // In continuous mode V8's sampling heap profiler is driven through
+  // v8::HeapProfiler directly instead of the inspector protocol, and every
+  // |window_ms| the allocations that are still live are written to the
+  // profile directory as a gzipped pprof profile. Returns false if the
+  // --heap-prof profile is being collected.
+  bool StartContinuous(uint64_t window_ms);
+  void StopContinuous();
+  bool continuous() const { return continuous_; }
+
  private:
+  void WriteWindow();
+  void CloseHandles();
+
   std::unique_ptr<inspector::InspectorSession> session_;
   bool ending_ = false;
+  bool inspector_profiling_ = false;
+  bool continuous_ = false;
+  // Wall clock time at which continuous sampling started, in microseconds.
+  uint64_t continuous_start_ = 0;
+  // Number of windows written so far.
+  uint64_t window_count_ = 0;
+  uv_timer_t* window_timer_ = nullptr;
 };
 
 }  // namespace profiler
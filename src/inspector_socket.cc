@@ -6,6 +6,7 @@
 #include "util-inl.h"
 
 #include "openssl/sha.h"  // Sha-1 hash
+#include "zlib.h"
 
 #include <algorithm>
 #include <cstring>
@@ -257,10 +258,19 @@ const size_t kTwoBytePayloadLengthField = 126;
 const size_t kEightBytePayloadLengthField = 127;
 const size_t kMaskingKeyWidthInBytes = 4;
 
-static std::vector<char> encode_frame_hybi17(const std::vector<char>& message) {
+// Messages shorter than this are not worth compressing.
+const size_t kMinDeflatedMessageLength = 1024;
+// Inflating a message from the client that is larger than this fails.
+const size_t kMaxInflatedMessageLength = 64 * 1024 * 1024;
+// Every message compressed with permessage-deflate ends like this, which is
+// left out on the wire.
+const char kDeflateTrailer[] = {'\x00', '\x00', '\xFF', '\xFF'};
+
+static std::vector<char> encode_frame_hybi17(const std::vector<char>& message,
+                                             bool compressed = false) {
   std::vector<char> frame;
   OpCode op_code = kOpCodeText;
-  frame.push_back(kFinalBit | op_code);
+  frame.push_back(kFinalBit | (compressed ? kReserved1Bit : 0) | op_code);
   const size_t data_length = message.size();
   if (data_length <= kMaxSingleBytePayloadLength) {
     frame.push_back(static_cast<char>(data_length));
@@ -285,6 +295,42 @@ static std::vector<char> encode_frame_hybi17(const std::vector<char>& message) {
   return frame;
 }
 
+// Returns whether the offers made in a Sec-WebSocket-Extensions header
+// include permessage-deflate (RFC 7692) with parameters that the server can
+// accept. The server always answers with server_no_context_takeover and
+// client_no_context_takeover, so the only other parameter it takes is
+// client_max_window_bits, which it doesn't need to answer.
+static bool OffersPermessageDeflate(const std::string& extensions) {
+  auto trim = [](const std::string& s) {
+    size_t start = s.find_first_not_of(" \t");
+    if (start == std::string::npos) return std::string();
+    return s.substr(start, s.find_last_not_of(" \t") - start + 1);
+  };
+  size_t start = 0;
+  while (start < extensions.size()) {
+    size_t end = std::min(extensions.find(',', start), extensions.size());
+    std::string offer = extensions.substr(start, end - start);
+    start = end + 1;
+
+    size_t params = std::min(offer.find(';'), offer.size());
+    if (trim(offer.substr(0, params)) != "permessage-deflate") continue;
+    bool acceptable = true;
+    while (params < offer.size()) {
+      size_t next = std::min(offer.find(';', params + 1), offer.size());
+      std::string param = offer.substr(params + 1, next - params - 1);
+      std::string name = trim(param.substr(0, param.find('=')));
+      if (name != "client_max_window_bits" &&
+          name != "server_no_context_takeover" &&
+          name != "client_no_context_takeover") {
+        acceptable = false;
+      }
+      params = next;
+    }
+    if (acceptable) return true;
+  }
+  return false;
+}
+
 static ws_decode_result decode_frame_hybi17(const std::vector<char>& buffer,
                                             bool client_frame,
                                             int* bytes_consumed,
@@ -374,11 +420,17 @@ static ws_decode_result decode_frame_hybi17(const std::vector<char>& buffer,
 // WS protocol
 class WsHandler : public ProtocolHandler {
  public:
-  WsHandler(InspectorSocket* inspector, TcpHolder::Pointer tcp)
+  WsHandler(InspectorSocket* inspector, TcpHolder::Pointer tcp, bool deflate)
             : ProtocolHandler(inspector, std::move(tcp)),
               OnCloseSent(&WsHandler::WaitForCloseReply),
               OnCloseReceived(&WsHandler::CloseFrameReceived),
-              dispose_(false) { }
+              dispose_(false),
+              deflate_(deflate) { }
+
+  ~WsHandler() override {
+    if (deflate_stream_ready_) deflateEnd(&deflate_stream_);
+    if (inflate_stream_ready_) inflateEnd(&inflate_stream_);
+  }
 
   void AcceptUpgrade(const std::string& accept_key) override { }
   void CancelHandshake() override {}
@@ -402,7 +454,13 @@ class WsHandler : public ProtocolHandler {
   }
 
   void Write(const std::vector<char> data) override {
-    std::vector<char> output = encode_frame_hybi17(data);
+    // This runs on the inspector's IO thread, so that compressing large
+    // messages, such as profiles, costs the main thread nothing.
+    std::vector<char> deflated;
+    bool compressed = deflate_ && data.size() >= kMinDeflatedMessageLength &&
+                      Deflate(data, &deflated) && deflated.size() < data.size();
+    std::vector<char> output =
+        encode_frame_hybi17(compressed ? deflated : data, compressed);
     WriteRaw(output, WriteRequest::Cleanup);
   }
 
@@ -450,38 +508,115 @@ class WsHandler : public ProtocolHandler {
                                               true /* client_frame */,
                                               &bytes_consumed, &output,
                                               &compressed);
-    // Compressed frame means client is ignoring the headers and misbehaves
-    if (compressed || r == FRAME_ERROR) {
+    // A compressed frame without permessage-deflate having been negotiated
+    // means that the client is ignoring the headers and misbehaves.
+    if (r == FRAME_ERROR || (compressed && (!deflate_ || r != FRAME_OK))) {
       OnEof();
       bytes_consumed = 0;
     } else if (r == FRAME_CLOSE) {
       (this->*OnCloseReceived)();
       bytes_consumed = 0;
+    } else if (r == FRAME_OK && compressed) {
+      std::vector<char> inflated;
+      if (!Inflate(output, &inflated)) {
+        OnEof();
+        return 0;
+      }
+      delegate()->OnWsFrame(inflated);
     } else if (r == FRAME_OK) {
       delegate()->OnWsFrame(output);
     }
     return bytes_consumed;
   }
 
+  // Compresses a message for permessage-deflate. Without context takeover,
+  // every message starts from a reset stream.
+  bool Deflate(const std::vector<char>& data, std::vector<char>* output) {
+    if (!deflate_stream_ready_) {
+      deflate_stream_ = z_stream();
+      if (deflateInit2(&deflate_stream_, Z_DEFAULT_COMPRESSION, Z_DEFLATED,
+                       -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        return false;
+      }
+      deflate_stream_ready_ = true;
+    } else if (deflateReset(&deflate_stream_) != Z_OK) {
+      return false;
+    }
+    // Leave room for the empty block that Z_SYNC_FLUSH adds.
+    output->resize(deflateBound(&deflate_stream_, data.size()) + 16);
+    deflate_stream_.next_in =
+        reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+    deflate_stream_.avail_in = data.size();
+    deflate_stream_.next_out = reinterpret_cast<Bytef*>(output->data());
+    deflate_stream_.avail_out = output->size();
+    if (deflate(&deflate_stream_, Z_SYNC_FLUSH) != Z_OK ||
+        deflate_stream_.avail_in != 0 || deflate_stream_.avail_out == 0) {
+      return false;
+    }
+    output->resize(output->size() - deflate_stream_.avail_out);
+    if (output->size() < sizeof(kDeflateTrailer) ||
+        !std::equal(output->end() - sizeof(kDeflateTrailer), output->end(),
+                    kDeflateTrailer)) {
+      return false;
+    }
+    output->resize(output->size() - sizeof(kDeflateTrailer));
+    return true;
+  }
+
+  bool Inflate(std::vector<char> data, std::vector<char>* output) {
+    if (!inflate_stream_ready_) {
+      inflate_stream_ = z_stream();
+      if (inflateInit2(&inflate_stream_, -MAX_WBITS) != Z_OK) return false;
+      inflate_stream_ready_ = true;
+    } else if (inflateReset(&inflate_stream_) != Z_OK) {
+      return false;
+    }
+    data.insert(data.end(), kDeflateTrailer,
+                kDeflateTrailer + sizeof(kDeflateTrailer));
+    inflate_stream_.next_in = reinterpret_cast<Bytef*>(data.data());
+    inflate_stream_.avail_in = data.size();
+    char chunk[16 * 1024];
+    do {
+      inflate_stream_.next_out = reinterpret_cast<Bytef*>(chunk);
+      inflate_stream_.avail_out = sizeof(chunk);
+      int err = inflate(&inflate_stream_, Z_SYNC_FLUSH);
+      if (err != Z_OK && err != Z_STREAM_END && err != Z_BUF_ERROR)
+        return false;
+      size_t produced = sizeof(chunk) - inflate_stream_.avail_out;
+      if (output->size() + produced > kMaxInflatedMessageLength) return false;
+      output->insert(output->end(), chunk, chunk + produced);
+      if (err != Z_OK) break;
+    } while (inflate_stream_.avail_in > 0 || inflate_stream_.avail_out == 0);
+    return true;
+  }
+
 
   Callback OnCloseSent;
   Callback OnCloseReceived;
   bool dispose_;
+  // Whether permessage-deflate was negotiated.
+  const bool deflate_;
+  bool deflate_stream_ready_ = false;
+  bool inflate_stream_ready_ = false;
+  z_stream deflate_stream_;
+  z_stream inflate_stream_;
 };
 
 // HTTP protocol
 class HttpEvent {
  public:
   HttpEvent(const std::string& path, bool upgrade, bool isGET,
-            const std::string& ws_key, const std::string& host)
+            const std::string& ws_key, const std::string& host,
+            const std::string& ws_extensions)
             : path(path), upgrade(upgrade), isGET(isGET), ws_key(ws_key),
-              host(host) { }
+              host(host), ws_extensions(ws_extensions) { }
 
   std::string path;
   bool upgrade;
   bool isGET;
   std::string ws_key;
   std::string host;
+  std::string ws_extensions;
 };
 
 class HttpHandler : public ProtocolHandler {
@@ -509,10 +644,18 @@ class HttpHandler : public ProtocolHandler {
                             accept_ws_prefix + sizeof(accept_ws_prefix) - 1);
     reply.insert(reply.end(), accept_string,
                  accept_string + sizeof(accept_string));
+    if (permessage_deflate_) {
+      const char deflate_extension[] =
+          "\r\nSec-WebSocket-Extensions: permessage-deflate; "
+          "server_no_context_takeover; client_no_context_takeover";
+      reply.insert(reply.end(), deflate_extension,
+                   deflate_extension + sizeof(deflate_extension) - 1);
+    }
     reply.insert(reply.end(), accept_ws_suffix,
                  accept_ws_suffix + sizeof(accept_ws_suffix) - 1);
     if (WriteRaw(reply, WriteRequest::Cleanup) >= 0) {
-      inspector_->SwitchProtocol(new WsHandler(inspector_, std::move(tcp_)));
+      inspector_->SwitchProtocol(
+          new WsHandler(inspector_, std::move(tcp_), permessage_deflate_));
     } else {
       tcp_.reset();
     }
@@ -558,6 +701,7 @@ class HttpHandler : public ProtocolHandler {
         CancelHandshake();
         return;
       } else {
+        permessage_deflate_ = OffersPermessageDeflate(event.ws_extensions);
         delegate()->OnSocketUpgrade(event.host, event.path, event.ws_key);
       }
     }
@@ -613,7 +757,9 @@ class HttpHandler : public ProtocolHandler {
                                   parser->upgrade,
                                   parser->method == HTTP_GET,
                                   handler->HeaderValue("Sec-WebSocket-Key"),
-                                  handler->HeaderValue("Host"));
+                                  handler->HeaderValue("Host"),
+                                  handler->HeaderValue(
+                                      "Sec-WebSocket-Extensions"));
     handler->path_ = "";
     handler->parsing_value_ = false;
     handler->headers_.clear();
@@ -643,6 +789,8 @@ class HttpHandler : public ProtocolHandler {
   }
 
   bool parsing_value_;
+  // Whether the client offered permessage-deflate in its upgrade request.
+  bool permessage_deflate_ = false;
   llhttp_t parser_;
   llhttp_settings_t parser_settings;
   std::vector<HttpEvent> events_;
@@ -548,6 +548,39 @@ node_api_post_finalizer(node_api_basic_env env,
                         void* finalize_data,
                         void* finalize_hint);
 
+#define NODE_API_EXPERIMENTAL_HAS_PROPERTY_KEY_HANDLES
+
+// A property key handle keeps a string or symbol key alive until it is
+// deleted or the env is torn down, so that code accessing the same property
+// many times does not have to create the key, or a reference to it, on every
+// call.
+NAPI_EXTERN napi_status NAPI_CDECL
+node_api_create_property_key_handle(napi_env env,
+                                    napi_value key,
+                                    node_api_property_key* result);
+NAPI_EXTERN napi_status NAPI_CDECL node_api_delete_property_key_handle(
+    node_api_basic_env env, node_api_property_key key);
+NAPI_EXTERN napi_status NAPI_CDECL
+node_api_get_property_by_key(napi_env env,
+                             napi_value object,
+                             node_api_property_key key,
+                             napi_value* result);
+NAPI_EXTERN napi_status NAPI_CDECL
+node_api_set_property_by_key(napi_env env,
+                             napi_value object,
+                             node_api_property_key key,
+                             napi_value value);
+// Looks up the method named by key on recv and calls it with recv as the
+// receiver, equivalent to napi_get_property() followed by
+// napi_call_function().
+NAPI_EXTERN napi_status NAPI_CDECL
+node_api_call_method_by_key(napi_env env,
+                            napi_value recv,
+                            node_api_property_key key,
+                            size_t argc,
+                            const napi_value* argv,
+                            napi_value* result);
+
 #endif  // NAPI_EXPERIMENTAL
 
 #if NAPI_VERSION >= 6
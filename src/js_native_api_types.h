@@ -59,6 +59,9 @@ typedef struct napi_handle_scope__* napi_handle_scope;
 typedef struct napi_escapable_handle_scope__* napi_escapable_handle_scope;
 typedef struct napi_callback_info__* napi_callback_info;
 typedef struct napi_deferred__* napi_deferred;
+#ifdef NAPI_EXPERIMENTAL
+typedef struct node_api_property_key__* node_api_property_key;
+#endif  // NAPI_EXPERIMENTAL
 
 typedef enum {
   napi_default = 0,
@@ -651,6 +651,23 @@ void TrackedFinalizer::Finalize() {
   delete this;
 }
 
+PropertyKey::PropertyKey(v8::Isolate* isolate, v8::Local<v8::Name> key)
+    : RefTracker(), key_(isolate, key) {}
+
+PropertyKey* PropertyKey::New(napi_env env, v8::Local<v8::Name> key) {
+  PropertyKey* property_key = new PropertyKey(env->isolate, key);
+  property_key->Link(&env->reflist);
+  return property_key;
+}
+
+PropertyKey::~PropertyKey() {
+  Unlink();
+}
+
+void PropertyKey::Finalize() {
+  delete this;
+}
+
 Reference::Reference(napi_env env,
                      v8::Local<v8::Value> value,
                      uint32_t initial_refcount,
@@ -3483,6 +3500,116 @@ napi_status NAPI_CDECL node_api_post_finalizer(node_api_basic_env basic_env,
   return napi_clear_last_error(env);
 }
 
+napi_status NAPI_CDECL
+node_api_create_property_key_handle(napi_env env,
+                                    napi_value key,
+                                    node_api_property_key* result) {
+  CHECK_ENV_NOT_IN_GC(env);
+  CHECK_ARG(env, key);
+  CHECK_ARG(env, result);
+
+  v8::Local<v8::Value> k = v8impl::V8LocalValueFromJsValue(key);
+  RETURN_STATUS_IF_FALSE(env, k->IsName(), napi_name_expected);
+
+  *result = reinterpret_cast<node_api_property_key>(
+      v8impl::PropertyKey::New(env, k.As<v8::Name>()));
+  return napi_clear_last_error(env);
+}
+
+napi_status NAPI_CDECL node_api_delete_property_key_handle(
+    node_api_basic_env basic_env, node_api_property_key key) {
+  napi_env env = const_cast<napi_env>(basic_env);
+  CHECK_ENV(env);
+  CHECK_ARG(env, key);
+
+  delete reinterpret_cast<v8impl::PropertyKey*>(key);
+  return napi_clear_last_error(env);
+}
+
+napi_status NAPI_CDECL node_api_get_property_by_key(napi_env env,
+                                                    napi_value object,
+                                                    node_api_property_key key,
+                                                    napi_value* result) {
+  NAPI_PREAMBLE(env);
+  CHECK_ARG(env, key);
+  CHECK_ARG(env, result);
+
+  v8::Local<v8::Context> context = env->context();
+  v8::Local<v8::Object> obj;
+
+  CHECK_TO_OBJECT(env, context, obj, object);
+
+  v8::Local<v8::Name> k =
+      reinterpret_cast<v8impl::PropertyKey*>(key)->Get(env->isolate);
+  auto get_maybe = obj->Get(context, k);
+
+  CHECK_MAYBE_EMPTY_WITH_PREAMBLE(env, get_maybe, napi_generic_failure);
+
+  *result = v8impl::JsValueFromV8LocalValue(get_maybe.ToLocalChecked());
+  return GET_RETURN_STATUS(env);
+}
+
+napi_status NAPI_CDECL node_api_set_property_by_key(napi_env env,
+                                                    napi_value object,
+                                                    node_api_property_key key,
+                                                    napi_value value) {
+  NAPI_PREAMBLE(env);
+  CHECK_ARG(env, key);
+  CHECK_ARG(env, value);
+
+  v8::Local<v8::Context> context = env->context();
+  v8::Local<v8::Object> obj;
+
+  CHECK_TO_OBJECT(env, context, obj, object);
+
+  v8::Local<v8::Name> k =
+      reinterpret_cast<v8impl::PropertyKey*>(key)->Get(env->isolate);
+  v8::Local<v8::Value> val = v8impl::V8LocalValueFromJsValue(value);
+  v8::Maybe<bool> set_maybe = obj->Set(context, k, val);
+
+  RETURN_STATUS_IF_FALSE_WITH_PREAMBLE(
+      env, set_maybe.FromMaybe(false), napi_generic_failure);
+  return GET_RETURN_STATUS(env);
+}
+
+napi_status NAPI_CDECL node_api_call_method_by_key(napi_env env,
+                                                   napi_value recv,
+                                                   node_api_property_key key,
+                                                   size_t argc,
+                                                   const napi_value* argv,
+                                                   napi_value* result) {
+  NAPI_PREAMBLE(env);
+  CHECK_ARG(env, key);
+  if (argc > 0) {
+    CHECK_ARG(env, argv);
+  }
+
+  v8::Local<v8::Context> context = env->context();
+  v8::Local<v8::Object> obj;
+
+  CHECK_TO_OBJECT(env, context, obj, recv);
+
+  v8::Local<v8::Name> k =
+      reinterpret_cast<v8impl::PropertyKey*>(key)->Get(env->isolate);
+  auto get_maybe = obj->Get(context, k);
+  CHECK_MAYBE_EMPTY_WITH_PREAMBLE(env, get_maybe, napi_generic_failure);
+
+  v8::Local<v8::Value> method = get_maybe.ToLocalChecked();
+  RETURN_STATUS_IF_FALSE(env, method->IsFunction(), napi_function_expected);
+
+  auto maybe = method.As<v8::Function>()->Call(
+      context,
+      v8impl::V8LocalValueFromJsValue(recv),
+      argc,
+      reinterpret_cast<v8::Local<v8::Value>*>(const_cast<napi_value*>(argv)));
+
+  CHECK_MAYBE_EMPTY_WITH_PREAMBLE(env, maybe, napi_generic_failure);
+  if (result != nullptr) {
+    *result = v8impl::JsValueFromV8LocalValue(maybe.ToLocalChecked());
+  }
+  return napi_clear_last_error(env);
+}
+
 #endif
 
 napi_status NAPI_CDECL napi_adjust_external_memory(node_api_basic_env env,
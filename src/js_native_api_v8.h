@@ -379,6 +379,24 @@ class TrackedFinalizer final : public RefTracker {
   Finalizer finalizer_;
 };
 
+// A property key held on behalf of a node_api_property_key. It is deleted by
+// node_api_delete_property_key_handle(), or when the env is torn down.
+class PropertyKey final : public RefTracker {
+ public:
+  static PropertyKey* New(napi_env env, v8::Local<v8::Name> key);
+  ~PropertyKey() override;
+
+  v8::Local<v8::Name> Get(v8::Isolate* isolate) const {
+    return key_.Get(isolate);
+  }
+
+ private:
+  PropertyKey(v8::Isolate* isolate, v8::Local<v8::Name> key);
+  void Finalize() override;
+
+  v8::Global<v8::Name> key_;
+};
+
 // Ownership of a reference.
 enum class ReferenceOwnership : uint8_t {
   // The reference is owned by the runtime. No userland call is needed to
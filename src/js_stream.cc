@@ -7,11 +7,15 @@
 #include "util-inl.h"
 #include "v8.h"
 
+#include <algorithm>
+
 namespace node {
 
 using errors::TryCatchScope;
 
 using v8::Array;
+using v8::ArrayBuffer;
+using v8::BackingStoreInitializationMode;
 using v8::Context;
 using v8::FunctionCallbackInfo;
 using v8::FunctionTemplate;
@@ -21,6 +25,7 @@ using v8::Isolate;
 using v8::Local;
 using v8::Object;
 using v8::TryCatch;
+using v8::Uint8Array;
 using v8::Value;
 
 
@@ -114,16 +119,30 @@ int JSStream::DoWrite(WriteWrap* w,
                       uv_stream_t* send_handle) {
   CHECK_NULL(send_handle);
 
-  HandleScope scope(env()->isolate());
+  Isolate* isolate = env()->isolate();
+  HandleScope scope(isolate);
   Context::Scope context_scope(env()->context());
 
   int value_int = UV_EPROTO;
 
+  // Copy all of the buffers into one store, and pass JS a Buffer for each of
+  // them that views its part of it. TLSWrap, for one, hands over many small
+  // buffers per write, which then do not need an allocation each.
+  size_t total = 0;
+  for (size_t i = 0; i < count; i++) total += bufs[i].len;
+  Local<ArrayBuffer> ab = ArrayBuffer::New(
+      isolate, total, BackingStoreInitializationMode::kUninitialized);
+  char* data = static_cast<char*>(ab->Data());
+  size_t offset = 0;
+
   MaybeStackBuffer<Local<Value>, 16> bufs_arr(count);
   for (size_t i = 0; i < count; i++) {
-    if (!Buffer::Copy(env(), bufs[i].base, bufs[i].len).ToLocal(&bufs_arr[i])) {
+    if (bufs[i].len > 0) memcpy(data + offset, bufs[i].base, bufs[i].len);
+    Local<Uint8Array> buffer;
+    if (!Buffer::New(env(), ab, offset, bufs[i].len).ToLocal(&buffer))
       return value_int;
-    }
+    bufs_arr[i] = buffer;
+    offset += bufs[i].len;
   }
 
   Local<Value> argv[] = {
@@ -164,28 +183,56 @@ void JSStream::Finish(const FunctionCallbackInfo<Value>& args) {
 }
 
 
+void JSStream::EmitData(const char* data, size_t len) {
+  // Repeatedly ask the stream's owner for memory, copy the data that we
+  // just read from JS into those buffers and emit them as reads.
+  while (len != 0) {
+    uv_buf_t buf = EmitAlloc(len);
+    size_t avail = std::min(len, buf.len);
+
+    memcpy(buf.base, data, avail);
+    data += avail;
+    len -= avail;
+    EmitRead(avail, buf);
+  }
+}
+
+
 void JSStream::ReadBuffer(const FunctionCallbackInfo<Value>& args) {
   JSStream* wrap;
   ASSIGN_OR_RETURN_UNWRAP(&wrap, args.This());
 
   ArrayBufferViewContents<char> buffer(args[0]);
-  const char* data = buffer.data();
-  int len = buffer.length();
 
   TryCatch try_catch(args.GetIsolate());
 
-  // Repeatedly ask the stream's owner for memory, copy the data that we
-  // just read from JS into those buffers and emit them as reads.
-  while (len != 0) {
-    uv_buf_t buf = wrap->EmitAlloc(len);
-    ssize_t avail = len;
-    if (static_cast<ssize_t>(buf.len) < avail)
-      avail = buf.len;
+  wrap->EmitData(buffer.data(), buffer.length());
 
-    memcpy(buf.base, data, avail);
-    data += avail;
-    len -= static_cast<int>(avail);
-    wrap->EmitRead(avail, buf);
+  if (try_catch.HasCaught()) {
+    try_catch.ReThrow();
+  }
+}
+
+
+// Like readBuffer(), for an array of chunks that JS has gathered, so that
+// they all need only one call into C++.
+void JSStream::ReadBuffers(const FunctionCallbackInfo<Value>& args) {
+  JSStream* wrap;
+  ASSIGN_OR_RETURN_UNWRAP(&wrap, args.This());
+  Environment* env = wrap->env();
+
+  CHECK(args[0]->IsArray());
+  Local<Array> chunks = args[0].As<Array>();
+  const uint32_t length = chunks->Length();
+
+  TryCatch try_catch(args.GetIsolate());
+
+  for (uint32_t i = 0; i < length && !try_catch.HasCaught(); i++) {
+    Local<Value> chunk;
+    if (!chunks->Get(env->context(), i).ToLocal(&chunk)) break;
+    CHECK(chunk->IsArrayBufferView());
+    ArrayBufferViewContents<char> buffer(chunk);
+    wrap->EmitData(buffer.data(), buffer.length());
   }
 
   if (try_catch.HasCaught()) {
@@ -217,6 +264,7 @@ void JSStream::Initialize(Local<Object> target,
   SetProtoMethod(isolate, t, "finishWrite", Finish<WriteWrap>);
   SetProtoMethod(isolate, t, "finishShutdown", Finish<ShutdownWrap>);
   SetProtoMethod(isolate, t, "readBuffer", ReadBuffer);
+  SetProtoMethod(isolate, t, "readBuffers", ReadBuffers);
   SetProtoMethod(isolate, t, "emitEOF", EmitEOF);
 
   StreamBase::AddMethods(env, t);
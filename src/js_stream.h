@@ -39,10 +39,16 @@ class JSStream : public AsyncWrap, public StreamBase {
 
   static void New(const v8::FunctionCallbackInfo<v8::Value>& args);
   static void ReadBuffer(const v8::FunctionCallbackInfo<v8::Value>& args);
+  static void ReadBuffers(const v8::FunctionCallbackInfo<v8::Value>& args);
   static void EmitEOF(const v8::FunctionCallbackInfo<v8::Value>& args);
 
   template <class Wrap>
   static void Finish(const v8::FunctionCallbackInfo<v8::Value>& args);
+
+ private:
+  // Emits data that was read in JS, in as many reads as the current
+  // listener needs to take it.
+  void EmitData(const char* data, size_t len);
 };
 
 }  // namespace node
@@ -105,6 +105,12 @@ extern char __start_lpstub;
 #endif  // defined(__linux__) || defined(__FreeBSD__)
 
 #endif  // defined(NODE_ENABLE_LARGE_CODE_PAGES) && NODE_ENABLE_LARGE_CODE_PAGES
+
+#if defined(__linux__)
+#include <sys/mman.h>  // NOLINT(build/include)
+#include <cstdio>
+#endif  // defined(__linux__)
+
 namespace node {
 #if defined(NODE_ENABLE_LARGE_CODE_PAGES) && NODE_ENABLE_LARGE_CODE_PAGES
 
@@ -438,6 +444,45 @@ int MapStaticCodeToLargePages() {
 #endif
 }
 
+size_t AdviseTransparentHugePages(void* data, size_t size) {
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+  static constexpr uintptr_t kHugePageSize = 2 * 1024 * 1024;
+  uintptr_t start = reinterpret_cast<uintptr_t>(data);
+  uintptr_t from = (start + kHugePageSize - 1) & ~(kHugePageSize - 1);
+  uintptr_t to = (start + size) & ~(kHugePageSize - 1);
+  if (to <= from) return 0;
+  if (madvise(reinterpret_cast<void*>(from), to - from, MADV_HUGEPAGE) != 0)
+    return 0;
+  return to - from;
+#else
+  return 0;
+#endif
+}
+
+bool GetHugePageCoverage(HugePageCoverage* coverage) {
+#if defined(__linux__)
+  FILE* smaps = fopen("/proc/self/smaps_rollup", "r");
+  if (smaps == nullptr) return false;
+  bool found_anonymous = false;
+  bool found_anon_huge_pages = false;
+  char line[256];
+  unsigned long long kb;  // NOLINT(runtime/int)
+  while (fgets(line, sizeof(line), smaps) != nullptr) {
+    if (sscanf(line, "Anonymous: %llu kB", &kb) == 1) {
+      coverage->anonymous = kb * 1024;
+      found_anonymous = true;
+    } else if (sscanf(line, "AnonHugePages: %llu kB", &kb) == 1) {
+      coverage->anon_huge_pages = kb * 1024;
+      found_anon_huge_pages = true;
+    }
+  }
+  fclose(smaps);
+  return found_anonymous && found_anon_huge_pages;
+#else
+  return false;
+#endif
+}
+
 const char* LargePagesError(int status) {
   switch (status) {
     case ENOTSUP:
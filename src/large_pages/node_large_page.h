@@ -25,9 +25,26 @@
 
 #if defined(NODE_WANT_INTERNALS) && NODE_WANT_INTERNALS
 
+#include <cstddef>
+#include <cstdint>
+
 namespace node {
 int MapStaticCodeToLargePages();
 const char* LargePagesError(int status);
+
+// Asks the kernel to back the 2 MiB-aligned part of [data, data + size) with
+// transparent huge pages. Returns the number of bytes that were advised,
+// which is 0 where this is not supported.
+size_t AdviseTransparentHugePages(void* data, size_t size);
+
+struct HugePageCoverage {
+  uint64_t anonymous = 0;
+  uint64_t anon_huge_pages = 0;
+};
+
+// Reads how much of the anonymous memory of the process is backed by
+// transparent huge pages. Returns false where this is not available.
+bool GetHugePageCoverage(HugePageCoverage* coverage);
 }  // namespace node
 
 #endif  // NODE_WANT_INTERNALS
@@ -8,6 +8,8 @@
 #include "node_internals.h"
 #include "node_process-inl.h"
 #include "node_watchdog.h"
+#include "path.h"
+#include "permission/permission.h"
 #include "util-inl.h"
 
 #include <sys/stat.h>  // S_IFDIR
@@ -358,6 +360,181 @@ void ModuleWrap::New(const FunctionCallbackInfo<Value>& args) {
   args.GetReturnValue().Set(that);
 }
 
+struct ModulePrefetcher::Item {
+  enum State { kPending, kRunning, kDone };
+
+  std::string filename;
+  // Written by the stream on a background thread. Only read on the main
+  // thread once the item is done.
+  std::string source;
+  bool read_failed = false;
+  std::unique_ptr<ScriptCompiler::StreamedSource> streamed_source;
+  // Must be destroyed before streamed_source.
+  std::unique_ptr<ScriptCompiler::ScriptStreamingTask> task;
+  // Guarded by ModulePrefetcher::mutex_.
+  State state = kPending;
+};
+
+namespace {
+
+// Reads the whole file at once on the background thread that runs the
+// streaming task, so that the reads of sibling modules also happen in
+// parallel.
+class FileSourceStream final : public ScriptCompiler::ExternalSourceStream {
+ public:
+  explicit FileSourceStream(ModulePrefetcher::Item* item) : item_(item) {}
+
+  size_t GetMoreData(const uint8_t** src) override {
+    if (done_) return 0;
+    done_ = true;
+    if (ReadFileSync(&item_->source, item_->filename.c_str()) != 0) {
+      item_->read_failed = true;
+      return 0;
+    }
+    size_t size = item_->source.size();
+    if (size == 0) return 0;
+    // V8 takes ownership of the chunk.
+    uint8_t* chunk = new uint8_t[size];
+    memcpy(chunk, item_->source.data(), size);
+    *src = chunk;
+    return size;
+  }
+
+ private:
+  ModulePrefetcher::Item* item_;
+  bool done_ = false;
+};
+
+}  // anonymous namespace
+
+class ModulePrefetcher::PrefetchTask final : public v8::JobTask {
+ public:
+  explicit PrefetchTask(ModulePrefetcher* prefetcher)
+      : prefetcher_(prefetcher) {}
+
+  void Run(v8::JobDelegate* delegate) override {
+    while (!delegate->ShouldYield()) {
+      Item* item;
+      {
+        Mutex::ScopedLock lock(prefetcher_->mutex_);
+        if (prefetcher_->queue_.empty()) break;
+        item = prefetcher_->queue_.front();
+        prefetcher_->queue_.pop_front();
+        prefetcher_->pending_--;
+        item->state = Item::kRunning;
+      }
+      item->task->Run();
+      Mutex::ScopedLock lock(prefetcher_->mutex_);
+      item->state = Item::kDone;
+      prefetcher_->done_cond_.Broadcast(lock);
+    }
+  }
+
+  size_t GetMaxConcurrency(size_t worker_count) const override {
+    return std::min<size_t>(prefetcher_->pending_.load() + worker_count, 4);
+  }
+
+ private:
+  ModulePrefetcher* prefetcher_;
+};
+
+ModulePrefetcher::ModulePrefetcher(Isolate* isolate) : isolate_(isolate) {}
+
+ModulePrefetcher::~ModulePrefetcher() {
+  // Waits for the background threads to return.
+  if (job_) job_->Cancel();
+}
+
+void ModulePrefetcher::Add(const std::string& url,
+                           const std::string& filename) {
+  if (items_.find(url) != items_.end()) return;
+  auto item = std::make_unique<Item>();
+  item->filename = filename;
+  item->streamed_source = std::make_unique<ScriptCompiler::StreamedSource>(
+      std::make_unique<FileSourceStream>(item.get()),
+      ScriptCompiler::StreamedSource::UTF8);
+  item->task.reset(ScriptCompiler::StartStreaming(
+      isolate_, item->streamed_source.get(), v8::ScriptType::kModule));
+  if (!item->task) return;
+
+  Mutex::ScopedLock lock(mutex_);
+  queue_.push_back(item.get());
+  pending_++;
+  items_.emplace(url, std::move(item));
+}
+
+void ModulePrefetcher::Start(v8::Platform* platform) {
+  if (pending_.load() == 0) return;
+  if (job_) {
+    if (job_->IsActive()) {
+      job_->NotifyConcurrencyIncrease();
+      return;
+    }
+    // Returns right away, the job has no work left.
+    job_->Join();
+  }
+  job_ = platform->PostJob(v8::TaskPriority::kUserBlocking,
+                           std::make_unique<PrefetchTask>(this));
+}
+
+std::unique_ptr<ModulePrefetcher::Item> ModulePrefetcher::Claim(
+    const std::string& url) {
+  auto it = items_.find(url);
+  if (it == items_.end()) return nullptr;
+  std::unique_ptr<Item> item = std::move(it->second);
+  items_.erase(it);
+
+  Mutex::ScopedLock lock(mutex_);
+  if (item->state == Item::kPending) {
+    // Compiling it on the main thread right away is faster than waiting
+    // for a background thread to pick it up.
+    queue_.erase(std::find(queue_.begin(), queue_.end(), item.get()));
+    pending_--;
+    return nullptr;
+  }
+  while (item->state != Item::kDone) done_cond_.Wait(lock);
+  if (item->read_failed) return nullptr;
+  return item;
+}
+
+// prefetchModules(urls, filenames)
+void ModulePrefetcher::PrefetchModules(
+    const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+  Isolate* isolate = env->isolate();
+  Local<Context> context = env->context();
+  CHECK(args[0]->IsArray());
+  CHECK(args[1]->IsArray());
+  Local<Array> urls = args[0].As<Array>();
+  Local<Array> filenames = args[1].As<Array>();
+  CHECK_EQ(urls->Length(), filenames->Length());
+
+  if (env->module_prefetcher() == nullptr) {
+    env->set_module_prefetcher(std::make_unique<ModulePrefetcher>(isolate));
+  }
+  ModulePrefetcher* prefetcher = env->module_prefetcher();
+  for (uint32_t i = 0; i < urls->Length(); i++) {
+    Local<Value> url;
+    Local<Value> filename;
+    if (!urls->Get(context, i).ToLocal(&url) ||
+        !filenames->Get(context, i).ToLocal(&filename)) {
+      return;
+    }
+    CHECK(url->IsString());
+    CHECK(filename->IsString());
+    Utf8Value url_value(isolate, url);
+    BufferValue filename_value(isolate, filename);
+    CHECK_NOT_NULL(*filename_value);
+    THROW_IF_INSUFFICIENT_PERMISSIONS(
+        env,
+        permission::PermissionScope::kFileSystemRead,
+        filename_value.ToStringView());
+    ToNamespacedPath(env, &filename_value);
+    prefetcher->Add(url_value.ToString(), filename_value.ToString());
+  }
+  prefetcher->Start(env->isolate_data()->platform());
+}
+
 MaybeLocal<Module> ModuleWrap::CompileSourceTextModule(
     Realm* realm,
     Local<String> source_text,
@@ -391,12 +568,50 @@ MaybeLocal<Module> ModuleWrap::CompileSourceTextModule(
         source_text, url, CachedCodeType::kESM);
   }
 
+  ScriptCompiler::ConsumeCodeCacheTask* consume_task = nullptr;
   if (cache_entry != nullptr && cache_entry->cache != nullptr) {
-    // source will take ownership of cached_data.
+    // source will take ownership of cached_data and consume_task.
     cached_data = cache_entry->CopyCache();
+    consume_task = cache_entry->consume_task.release();
+  }
+
+  std::unique_ptr<ModulePrefetcher::Item> prefetched;
+  if (!user_cached_data.has_value() &&
+      realm->env()->module_prefetcher() != nullptr) {
+    Utf8Value url_value(isolate, url);
+    prefetched = realm->env()->module_prefetcher()->Claim(url_value.ToString());
+    // A code cache is still cheaper than a streamed parse, and the loader
+    // may have transformed the source it read.
+    Local<String> prefetched_source;
+    if (prefetched &&
+        (cached_data != nullptr ||
+         !String::NewFromUtf8(isolate,
+                              prefetched->source.data(),
+                              v8::NewStringType::kNormal,
+                              prefetched->source.size())
+              .ToLocal(&prefetched_source) ||
+         !prefetched_source->StringEquals(source_text))) {
+      prefetched.reset();
+    }
+  }
+
+  if (prefetched) {
+    Local<Module> module;
+    if (!ScriptCompiler::CompileModule(isolate->GetCurrentContext(),
+                                       prefetched->streamed_source.get(),
+                                       source_text,
+                                       origin)
+             .ToLocal(&module)) {
+      return scope.EscapeMaybe(MaybeLocal<Module>());
+    }
+    if (cache_entry != nullptr) {
+      realm->env()->compile_cache_handler()->MaybeSave(
+          cache_entry, module, false);
+    }
+    return scope.Escape(module);
   }
 
-  ScriptCompiler::Source source(source_text, origin, cached_data);
+  ScriptCompiler::Source source(source_text, origin, cached_data, consume_task);
   ScriptCompiler::CompileOptions options;
   if (cached_data == nullptr) {
     options = ScriptCompiler::kNoCompileOptions;
@@ -1321,6 +1536,8 @@ void ModuleWrap::CreatePerIsolateProperties(IsolateData* isolate_data,
             "createRequiredModuleFacade",
             CreateRequiredModuleFacade);
   SetMethod(isolate, target, "throwIfPromiseRejected", ThrowIfPromiseRejected);
+  SetMethod(
+      isolate, target, "prefetchModules", ModulePrefetcher::PrefetchModules);
 }
 
 void ModuleWrap::CreatePerContextProperties(Local<Object> target,
@@ -1372,6 +1589,7 @@ void ModuleWrap::RegisterExternalReferences(
   registry->Register(SetImportModuleDynamicallyCallback);
   registry->Register(SetInitializeImportMetaObjectCallback);
   registry->Register(ThrowIfPromiseRejected);
+  registry->Register(ModulePrefetcher::PrefetchModules);
 }
 }  // namespace loader
 }  // namespace node
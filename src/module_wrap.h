@@ -3,11 +3,16 @@
 
 #if defined(NODE_WANT_INTERNALS) && NODE_WANT_INTERNALS
 
+#include <atomic>
+#include <deque>
+#include <memory>
 #include <optional>
 #include <string>
 #include <unordered_map>
 #include <vector>
 #include "base_object.h"
+#include "node_mutex.h"
+#include "v8-platform.h"
 #include "v8-script.h"
 
 namespace node {
@@ -38,6 +43,50 @@ enum ModulePhase : int {
   kEvaluationPhase = 2,
 };
 
+// Reads and parses source text modules on background threads before the
+// loader gets to them, using V8's streaming compilation. The loader queues
+// the modules it is about to fetch with prefetchModules(), e.g. all the
+// requests of a module it has just compiled, and
+// ModuleWrap::CompileSourceTextModule() then finishes the compilation of a
+// queued module on the main thread, as long as the loader passes in the same
+// source text that was read from disk. Linking still happens in order on the
+// main thread.
+class ModulePrefetcher {
+ public:
+  struct Item;
+
+  explicit ModulePrefetcher(v8::Isolate* isolate);
+  ~ModulePrefetcher();
+  ModulePrefetcher(const ModulePrefetcher&) = delete;
+  ModulePrefetcher& operator=(const ModulePrefetcher&) = delete;
+
+  // Queues |filename| to be read and parsed as a module on a background
+  // thread, for a later compilation of |url|. Does nothing if |url| is
+  // already queued.
+  void Add(const std::string& url, const std::string& filename);
+  // Makes sure that enough background threads work on the queue.
+  void Start(v8::Platform* platform);
+  // Removes |url| from the queue and returns its streamed parse, waiting for
+  // a background thread that is working on it. Returns nullptr if |url| is
+  // not queued, has not been picked up yet, or could not be read.
+  std::unique_ptr<Item> Claim(const std::string& url);
+
+  static void PrefetchModules(const v8::FunctionCallbackInfo<v8::Value>& args);
+
+ private:
+  class PrefetchTask;
+
+  v8::Isolate* isolate_;
+  // Only used on the main thread.
+  std::unordered_map<std::string, std::unique_ptr<Item>> items_;
+  Mutex mutex_;
+  ConditionVariable done_cond_;
+  // Items not picked up by a background thread yet. Guarded by mutex_.
+  std::deque<Item*> queue_;
+  std::atomic<size_t> pending_{0};
+  std::unique_ptr<v8::JobHandle> job_;
+};
+
 class ModuleWrap : public BaseObject {
  public:
   enum InternalFields {
@@ -46,6 +46,7 @@
 #include "node_snapshot_builder.h"
 #include "node_v8_platform-inl.h"
 #include "node_version.h"
+#include "node_wasm_web_api.h"
 
 #if HAVE_OPENSSL
 #include "ncrypto.h"
@@ -328,7 +329,7 @@ MaybeLocal<Value> StartExecution(Environment* env, StartExecutionCallback cb) {
 #ifndef DISABLE_SINGLE_EXECUTABLE_APPLICATION
   // Snapshot in SEA is only loaded for the main thread.
   if (sea::IsSingleExecutable() && env->is_main_thread()) {
-    sea::SeaResource sea = sea::FindSingleExecutableResource();
+    const sea::SeaResource& sea = sea::FindSingleExecutableResource();
     // The SEA preparation blob building process should already enforce this,
     // this check is just here to guard against the unlikely case where
     // the SEA preparation blob has been manually modified by someone.
@@ -778,6 +779,11 @@ static ExitCode ProcessGlobalArgsInternal(std::vector<std::string>* args,
     v8_args.emplace_back("--js-source-phase-imports");
   }
 
+  // Shared structs imply V8's shared string table and shared space.
+  if (per_process::cli_options->experimental_shared_heap) {
+    v8_args.emplace_back("--harmony-struct");
+  }
+
 #ifdef __POSIX__
   // Block SIGPROF signals when sleeping in epoll_wait/kevent/etc.  Avoids the
   // performance penalty of frequent EINTR wakeups when the profiler is running.
@@ -1210,7 +1216,10 @@ InitializeOncePerProcessInternal(const std::vector<std::string>& args,
   if (!(flags & ProcessInitializationFlags::kNoInitializeNodeV8Platform)) {
     uv_thread_setname("MainThread");
     per_process::v8_platform.Initialize(
-        static_cast<int>(per_process::cli_options->v8_thread_pool_size));
+        static_cast<int>(per_process::cli_options->v8_thread_pool_size),
+        static_cast<int>(
+            per_process::cli_options->v8_user_blocking_thread_pool_size),
+        per_process::cli_options->v8_pool_numa_affinity);
     result->platform_ = per_process::v8_platform.Platform();
   }
 
@@ -1285,6 +1294,9 @@ void TearDownOncePerProcess() {
     cppgc::ShutdownProcess();
   }
 
+  // The native modules of the shared cache belong to V8's wasm engine.
+  wasm_web_api::SharedModuleCache::Clear();
+
   per_process::v8_initialized = false;
   if (!(flags & ProcessInitializationFlags::kNoInitializeV8)) {
     V8::Dispose();
@@ -1424,12 +1436,14 @@ bool LoadSnapshotData(const SnapshotData** snapshot_data_ptr) {
 #ifndef DISABLE_SINGLE_EXECUTABLE_APPLICATION
   if (sea::IsSingleExecutable()) {
     is_sea = true;
-    sea::SeaResource sea = sea::FindSingleExecutableResource();
+    const sea::SeaResource& sea = sea::FindSingleExecutableResource();
     if (sea.use_snapshot()) {
       std::unique_ptr<SnapshotData> read_data =
           std::make_unique<SnapshotData>();
+      // The SEA blob lives in the executable for the lifetime of the
+      // process, so the V8 snapshot and code cache need not be copied out.
       std::string_view snapshot = sea.main_code_or_snapshot;
-      if (SnapshotData::FromBlob(read_data.get(), snapshot)) {
+      if (SnapshotData::FromBlobInPlace(read_data.get(), snapshot)) {
         *snapshot_data_ptr = read_data.release();
         return true;
       } else {
@@ -797,6 +797,11 @@ NODE_EXTERN void GetNodeReport(Environment* env,
                                const char* trigger,
                                v8::Local<v8::Value> error,
                                std::ostream& out);
+// Writes a compact JSON object with the heap statistics, the handle and
+// request counts, the threadpool queue depth and the event loop metrics of
+// env. Unlike GetNodeReport(), this is cheap enough to be called every
+// second, e.g. from a health check. env must not be nullptr.
+NODE_EXTERN void GetNodeReportVitals(Environment* env, std::ostream& out);
 
 // This returns the MultiIsolatePlatform used for an Environment or IsolateData
 // instance, if one exists.
@@ -892,6 +897,22 @@ class NODE_EXTERN CommonEnvironmentSetup {
       const SnapshotConfig& snapshot_config = {});
   EmbedderSnapshotData::Pointer CreateSnapshot();
 
+  // Frees the Environment of this setup and creates a new one in its place,
+  // in a new Context, while keeping the event loop, the Isolate and the
+  // IsolateData. That skips most of the cost of a new setup, so embedders
+  // that run many short-lived Environments can keep a pool of setups and
+  // recycle them. Setups created from a snapshot deserialize the new
+  // Environment from the same snapshot. Anything that the embedder attached
+  // to the Isolate itself is kept.
+  // If any error occurs, `*errors` will be populated and the returned
+  // pointer will be null, like env() then.
+  // env_args will be passed through as arguments to CreateEnvironment(),
+  // after `isolate_data` and `context`.
+  // This cannot be used with setups that were created for snapshotting.
+  template <typename... EnvironmentArgs>
+  Environment* ResetEnvironment(std::vector<std::string>* errors,
+                                EnvironmentArgs&&... env_args);
+
   struct uv_loop_s* event_loop() const;
   v8::SnapshotCreator* snapshot_creator();
   // Empty for snapshotting environments.
@@ -926,6 +947,17 @@ class NODE_EXTERN CommonEnvironmentSetup {
       uint32_t flags,
       std::function<Environment*(const CommonEnvironmentSetup*)>,
       const SnapshotConfig* config = nullptr);
+
+  // Creates the Context, unless the Environment is deserialized from a
+  // snapshot, and the Environment. Called with the Isolate locked.
+  void InitializeEnvironment(
+      std::vector<std::string>* errors,
+      const std::function<Environment*(const CommonEnvironmentSetup*)>&
+          make_env);
+  Environment* ResetEnvironmentImpl(
+      std::vector<std::string>* errors,
+      const std::function<Environment*(const CommonEnvironmentSetup*)>&
+          make_env);
 };
 
 // Implementation for CommonEnvironmentSetup::Create
@@ -968,6 +1000,19 @@ CommonEnvironmentSetup::CreateFromSnapshot(
   return ret;
 }
 
+// Implementation for CommonEnvironmentSetup::ResetEnvironment
+template <typename... EnvironmentArgs>
+Environment* CommonEnvironmentSetup::ResetEnvironment(
+    std::vector<std::string>* errors,
+    EnvironmentArgs&&... env_args) {
+  return ResetEnvironmentImpl(
+      errors, [&](const CommonEnvironmentSetup* setup) -> Environment* {
+        return CreateEnvironment(setup->isolate_data(),
+                                 setup->context(),
+                                 std::forward<EnvironmentArgs>(env_args)...);
+      });
+}
+
 /* Converts a unixtime to V8 Date */
 NODE_DEPRECATED("Use v8::Date::New() directly",
                 inline v8::Local<v8::Value> NODE_UNIXTIME_V8(double time) {
@@ -1,5 +1,6 @@
 #include "async_context_frame.h"
 #include "async_wrap-inl.h"
+#include "cppgc_helpers-inl.h"
 #include "env-inl.h"
 #define NAPI_EXPERIMENTAL
 #include "js_native_api_v8.h"
@@ -16,9 +17,12 @@
 #include "tracing/traced_value.h"
 #include "util-inl.h"
 
+#include "cppgc/allocation.h"
+
 #include <atomic>
 #include <cstring>
 #include <memory>
+#include <vector>
 
 namespace v8impl {
 static void ThrowNodeApiVersionError(node::Environment* node_env,
@@ -295,8 +299,18 @@ class ThreadSafeFunction : public node::AsyncResource {
   }
 
   void EmptyQueueAndDelete() {
-    for (; !queue.empty(); queue.pop()) {
-      call_js_cb(nullptr, nullptr, context, queue.front());
+    if (call_js_batch_cb != nullptr) {
+      batch.clear();
+      for (; !queue.empty(); queue.pop()) {
+        batch.push_back(queue.front());
+      }
+      if (!batch.empty()) {
+        call_js_batch_cb(nullptr, nullptr, context, batch.data(), batch.size());
+      }
+    } else {
+      for (; !queue.empty(); queue.pop()) {
+        call_js_cb(nullptr, nullptr, context, queue.front());
+      }
     }
     delete this;
   }
@@ -348,6 +362,12 @@ class ThreadSafeFunction : public node::AsyncResource {
 
   inline void* Context() { return context; }
 
+  void SetBatchCallback(node_api_threadsafe_function_call_js_batch cb,
+                        size_t max_size) {
+    call_js_batch_cb = cb;
+    max_batch_size = max_size;
+  }
+
  protected:
   void Dispatch() {
     bool has_more = true;
@@ -357,7 +377,7 @@ class ThreadSafeFunction : public node::AsyncResource {
     unsigned int iterations_left = kMaxIterationCount;
     while (has_more && --iterations_left != 0) {
       dispatch_state = kDispatchRunning;
-      has_more = DispatchOne();
+      has_more = call_js_batch_cb != nullptr ? DispatchBatch() : DispatchOne();
 
       // Send() was called while we were executing the JS function
       if (dispatch_state.exchange(kDispatchIdle) != kDispatchRunning) {
@@ -421,6 +441,64 @@ class ThreadSafeFunction : public node::AsyncResource {
     return has_more;
   }
 
+  // Like DispatchOne(), but takes up to max_batch_size items off the queue
+  // with a single lock acquisition and passes them to one call of
+  // call_js_batch_cb.
+  bool DispatchBatch() {
+    bool has_more = false;
+    batch.clear();
+
+    {
+      node::Mutex::ScopedLock lock(this->mutex);
+      if (is_closing) {
+        CloseHandlesAndMaybeDelete();
+      } else {
+        size_t size = queue.size();
+        size_t count = size;
+        if (max_batch_size > 0 && count > max_batch_size) {
+          count = max_batch_size;
+        }
+        for (size_t i = 0; i < count; i++) {
+          batch.push_back(queue.front());
+          queue.pop();
+        }
+        if (count > 0 && size == max_queue_size && max_queue_size > 0) {
+          // More than one slot may have been freed.
+          cond->Broadcast(lock);
+        }
+        size -= count;
+
+        if (size == 0) {
+          if (thread_count == 0) {
+            is_closing = true;
+            if (max_queue_size > 0) {
+              cond->Signal(lock);
+            }
+            CloseHandlesAndMaybeDelete();
+          }
+        } else {
+          has_more = true;
+        }
+      }
+    }
+
+    if (!batch.empty()) {
+      v8::HandleScope scope(env->isolate);
+      CallbackScope cb_scope(this);
+      napi_value js_callback = nullptr;
+      if (!ref.IsEmpty()) {
+        v8::Local<v8::Function> js_cb =
+            v8::Local<v8::Function>::New(env->isolate, ref);
+        js_callback = v8impl::JsValueFromV8LocalValue(js_cb);
+      }
+      env->CallbackIntoModule<false>([&](napi_env env) {
+        call_js_batch_cb(env, js_callback, context, batch.data(), batch.size());
+      });
+    }
+
+    return has_more;
+  }
+
   void Finalize() {
     v8::HandleScope scope(env->isolate);
     if (finalize_cb) {
@@ -525,6 +603,11 @@ class ThreadSafeFunction : public node::AsyncResource {
   void* finalize_data;
   napi_finalize finalize_cb;
   napi_threadsafe_function_call_js call_js_cb;
+  node_api_threadsafe_function_call_js_batch call_js_batch_cb = nullptr;
+  size_t max_batch_size = 0;
+  // The items taken off the queue by DispatchBatch(), kept to reuse its
+  // storage.
+  std::vector<void*> batch;
   bool handles_closing;
 };
 
@@ -545,7 +628,8 @@ class AsyncContext {
     trigger_async_id_ = node_env()->get_default_trigger_async_id();
     v8::Isolate* isolate = node_env()->isolate();
     resource_.Reset(isolate, resource_object);
-    context_frame_.Reset(isolate, node::async_context_frame::current(isolate));
+    node::async_context_frame::retain(
+        isolate, &context_frame_, node::async_context_frame::current(isolate));
     lost_reference_ = false;
     if (externally_managed_resource) {
       resource_.SetWeak(
@@ -638,6 +722,79 @@ class AsyncContext {
   v8::Global<v8::Value> context_frame_;
 };
 
+using node::CppgcMixin;
+
+// The object behind node_api_create_cppgc_object(). The native data of the
+// addon is allocated right after it, and both are freed by the C++ garbage
+// collector together with the JavaScript object, without a weak handle to
+// process.
+class CppgcObject final : CPPGC_MIXIN(CppgcObject) {
+ public:
+  SET_CPPGC_NAME(CppgcObject)
+  SET_NO_MEMORY_INFO()
+  DEFAULT_CPPGC_TRACE()
+
+  static CppgcObject* New(node_napi_env env,
+                          v8::Local<v8::Object> object,
+                          size_t data_size,
+                          node_api_basic_finalize finalize_cb,
+                          void* finalize_hint) {
+    return cppgc::MakeGarbageCollected<CppgcObject>(
+        env->node_env()->cppgc_allocation_handle(),
+        cppgc::AdditionalBytes(data_size),
+        env,
+        object,
+        finalize_cb,
+        finalize_hint);
+  }
+
+  CppgcObject(node_napi_env env,
+              v8::Local<v8::Object> object,
+              node_api_basic_finalize finalize_cb,
+              void* finalize_hint)
+      : env_(env), finalize_cb_(finalize_cb), finalize_hint_(finalize_hint) {
+    env_->Ref();
+    CppgcMixin::Wrap(this, env->node_env(), object);
+  }
+
+  // Called while sweeping, on the thread of the isolate, for the objects
+  // that die before the realm.
+  ~CppgcObject() override {
+    if (realm() != nullptr) {
+      // Like the finalizers of the experimental module API version, this
+      // runs from the GC and must not affect its state.
+      bool saved = env_->in_gc_finalizer;
+      env_->in_gc_finalizer = true;
+      CallFinalizer();
+      env_->in_gc_finalizer = saved;
+    }
+    this->Finalize();
+  }
+
+  // Called when the realm shuts down, or from the destructor. The env
+  // outlives the objects, as the realm cleans up its wrappers before the
+  // cleanup hook that releases the env runs.
+  void Clean(node::Realm* realm) override {
+    CallFinalizer();
+    env_->Unref();
+  }
+
+  // Aligned like the object, which cppgc aligns to pointers.
+  void* data() { return this + 1; }
+
+ private:
+  void CallFinalizer() {
+    if (finalize_cb_ == nullptr) return;
+    node_api_basic_finalize finalize_cb = finalize_cb_;
+    finalize_cb_ = nullptr;
+    finalize_cb(env_, data(), finalize_hint_);
+  }
+
+  node_napi_env env_;
+  node_api_basic_finalize finalize_cb_;
+  void* finalize_hint_;
+};
+
 }  // end of anonymous namespace
 
 }  // end of namespace v8impl
@@ -1177,7 +1334,8 @@ class Work : public node::AsyncResource, public node::ThreadPoolWork {
             env->isolate,
             async_resource,
             *v8::String::Utf8Value(env->isolate, async_resource_name)),
-        ThreadPoolWork(env->node_env(), "node_api"),
+        ThreadPoolWork(
+            env->node_env(), "node_api", node::ThreadPoolWorkClass::kUser),
         _env(env),
         _data(data),
         _execute(execute),
@@ -1423,6 +1581,20 @@ napi_status NAPI_CDECL napi_ref_threadsafe_function(
   return reinterpret_cast<v8impl::ThreadSafeFunction*>(func)->Ref();
 }
 
+napi_status NAPI_CDECL node_api_set_threadsafe_function_batch_cb(
+    napi_env env,
+    napi_threadsafe_function func,
+    node_api_threadsafe_function_call_js_batch call_js_batch_cb,
+    size_t max_batch_size) {
+  CHECK_ENV_NOT_IN_GC(env);
+  CHECK_ARG(env, func);
+  CHECK_ARG(env, call_js_batch_cb);
+
+  reinterpret_cast<v8impl::ThreadSafeFunction*>(func)->SetBatchCallback(
+      call_js_batch_cb, max_batch_size);
+  return napi_clear_last_error(env);
+}
+
 napi_status NAPI_CDECL node_api_get_module_file_name(
     node_api_basic_env basic_env, const char** result) {
   napi_env env = const_cast<napi_env>(basic_env);
@@ -1433,6 +1605,62 @@ napi_status NAPI_CDECL node_api_get_module_file_name(
   return napi_clear_last_error(env);
 }
 
+napi_status NAPI_CDECL
+node_api_create_cppgc_object(napi_env env,
+                             size_t data_size,
+                             node_api_basic_finalize finalize_cb,
+                             void* finalize_hint,
+                             void** data,
+                             napi_value* result) {
+  CHECK_ENV_NOT_IN_GC(env);
+  CHECK_ARG(env, result);
+
+  node_napi_env node_env = static_cast<node_napi_env>(env);
+  v8::Local<v8::Context> context = env->context();
+  v8::Local<v8::FunctionTemplate> tmpl;
+  if (node_env->cppgc_object_template.IsEmpty()) {
+    tmpl = node::BaseObject::MakeLazilyInitializedJSTemplate(
+        node_env->node_env());
+    node_env->cppgc_object_template.Reset(env->isolate, tmpl);
+  } else {
+    tmpl = node_env->cppgc_object_template.Get(env->isolate);
+  }
+  v8::Local<v8::Function> constructor;
+  v8::Local<v8::Object> object;
+  if (!tmpl->GetFunction(context).ToLocal(&constructor) ||
+      !constructor->NewInstance(context).ToLocal(&object)) {
+    return napi_set_last_error(env, napi_generic_failure);
+  }
+
+  v8impl::CppgcObject* wrap = v8impl::CppgcObject::New(
+      node_env, object, data_size, finalize_cb, finalize_hint);
+  if (data != nullptr) *data = wrap->data();
+  *result = v8impl::JsValueFromV8LocalValue(object);
+  return napi_clear_last_error(env);
+}
+
+napi_status NAPI_CDECL node_api_get_cppgc_object_data(napi_env env,
+                                                      napi_value object,
+                                                      void** data) {
+  CHECK_ENV_NOT_IN_GC(env);
+  CHECK_ARG(env, object);
+  CHECK_ARG(env, data);
+
+  node_napi_env node_env = static_cast<node_napi_env>(env);
+  v8::Local<v8::Value> value = v8impl::V8LocalValueFromJsValue(object);
+  // Only the objects created through the same env are accepted, so that
+  // the internal fields of other objects are never read.
+  if (!value->IsObject() || node_env->cppgc_object_template.IsEmpty() ||
+      !node_env->cppgc_object_template.Get(env->isolate)->HasInstance(value)) {
+    return napi_set_last_error(env, napi_invalid_arg);
+  }
+  v8impl::CppgcObject* wrap =
+      node::CppgcMixin::Unwrap<v8impl::CppgcObject>(value.As<v8::Object>());
+  if (wrap == nullptr) return napi_set_last_error(env, napi_invalid_arg);
+  *data = wrap->data();
+  return napi_clear_last_error(env);
+}
+
 #ifdef NAPI_EXPERIMENTAL
 
 napi_status NAPI_CDECL
@@ -242,6 +242,20 @@ NAPI_EXTERN napi_status NAPI_CDECL napi_unref_threadsafe_function(
 NAPI_EXTERN napi_status NAPI_CDECL napi_ref_threadsafe_function(
     node_api_basic_env env, napi_threadsafe_function func);
 
+#ifdef NAPI_EXPERIMENTAL
+#define NODE_API_EXPERIMENTAL_HAS_THREADSAFE_FUNCTION_BATCH
+
+// Switches the thread-safe function to batched delivery: instead of calling
+// call_js_cb once per queued item, call_js_batch_cb is called with up to
+// max_batch_size items at once (or all queued items if max_batch_size is 0).
+// Must be called on the loop thread.
+NAPI_EXTERN napi_status NAPI_CDECL node_api_set_threadsafe_function_batch_cb(
+    napi_env env,
+    napi_threadsafe_function func,
+    node_api_threadsafe_function_call_js_batch call_js_batch_cb,
+    size_t max_batch_size);
+#endif  // NAPI_EXPERIMENTAL
+
 #endif  // NAPI_VERSION >= 4
 
 #if NAPI_VERSION >= 8
@@ -264,6 +278,29 @@ node_api_get_module_file_name(node_api_basic_env env, const char** result);
 
 #endif  // NAPI_VERSION >= 9
 
+#ifdef NAPI_EXPERIMENTAL
+#define NODE_API_EXPERIMENTAL_HAS_CPPGC_OBJECT
+
+// Creates an object that owns data_size bytes of native memory, returned in
+// data. The memory is allocated with the object by V8's C++ garbage
+// collector and freed together with it, which takes no weak reference like
+// napi_wrap() does. finalize_cb, if set, is called right before, from the
+// garbage collector, or when the environment is torn down. The memory is
+// aligned to pointers.
+NAPI_EXTERN napi_status NAPI_CDECL
+node_api_create_cppgc_object(napi_env env,
+                             size_t data_size,
+                             node_api_basic_finalize finalize_cb,
+                             void* finalize_hint,
+                             void** data,
+                             napi_value* result);
+
+// Returns the native memory of an object created by
+// node_api_create_cppgc_object() with the same env, or napi_invalid_arg.
+NAPI_EXTERN napi_status NAPI_CDECL
+node_api_get_cppgc_object_data(napi_env env, napi_value object, void** data);
+#endif  // NAPI_EXPERIMENTAL
+
 EXTERN_C_END
 
 #endif  // SRC_NODE_API_H_
@@ -37,6 +37,8 @@ struct node_napi_env__ : public napi_env__ {
   inline const char* GetFilename() const { return filename.c_str(); }
 
   std::string filename;
+  // Created by the first node_api_create_cppgc_object() call.
+  v8::Global<v8::FunctionTemplate> cppgc_object_template;
   bool destructing = false;
   bool finalization_scheduled = false;
 };
@@ -32,6 +32,7 @@ using v8::Int32;
 using v8::Isolate;
 using v8::Local;
 using v8::NewStringType;
+using v8::Number;
 using v8::Object;
 using v8::ObjectTemplate;
 using v8::SnapshotCreator;
@@ -347,10 +348,28 @@ void Blob::Reader::Pull(const FunctionCallbackInfo<Value>& args) {
     return args.GetReturnValue().Set(bob::STATUS_EOS);
   }
 
+  // An optional ArrayBufferView to read into. When it is large enough for a
+  // chunk, the chunk is written into it and the callback gets the number of
+  // bytes written instead of a new ArrayBuffer. Entries that are read from
+  // files read into it directly. This lets arrayBuffer() fill a buffer of
+  // the known size of the Blob without copying every chunk twice.
+  DataQueue::Vec destination{nullptr, 0};
+  std::shared_ptr<BackingStore> destination_store;
+  if (args.Length() > 1 && args[1]->IsArrayBufferView()) {
+    Local<ArrayBufferView> view = args[1].As<ArrayBufferView>();
+    destination_store = view->Buffer()->GetBackingStore();
+    destination.base =
+        static_cast<uint8_t*>(destination_store->Data()) + view->ByteOffset();
+    destination.len = view->ByteLength();
+  }
+
   struct Impl {
     BaseObjectPtr<Blob::Reader> reader;
     Global<Function> callback;
     Environment* env;
+    DataQueue::Vec destination;
+    // Keeps the destination alive while the pull is pending.
+    std::shared_ptr<BackingStore> destination_store;
   };
   // TODO(@jasnell): A unique_ptr is likely better here but making this a unique
   // pointer that is passed into the lambda causes the std::move(next) below to
@@ -359,6 +378,8 @@ void Blob::Reader::Pull(const FunctionCallbackInfo<Value>& args) {
   impl->reader = BaseObjectPtr<Blob::Reader>(reader);
   impl->callback.Reset(env->isolate(), fn);
   impl->env = env;
+  impl->destination = destination;
+  impl->destination_store = std::move(destination_store);
 
   auto next = [impl](int status,
                      const DataQueue::Vec* vecs,
@@ -372,10 +393,26 @@ void Blob::Reader::Pull(const FunctionCallbackInfo<Value>& args) {
     if (status == bob::STATUS_EOS) impl->reader->eos_ = true;
 
     if (count > 0) {
-      // Copy the returns vectors into a single ArrayBuffer.
       size_t total = 0;
       for (size_t n = 0; n < count; n++) total += vecs[n].len;
 
+      const DataQueue::Vec& destination = impl->destination;
+      if (destination.base != nullptr && total <= destination.len) {
+        if (count > 1 || vecs[0].base != destination.base) {
+          uint8_t* ptr = destination.base;
+          for (size_t n = 0; n < count; n++) {
+            ptr = std::copy(vecs[n].base, vecs[n].base + vecs[n].len, ptr);
+          }
+        }
+        std::move(doneCb)(0);
+        Local<Value> argv[2] = {
+            Uint32::New(env->isolate(), status),
+            Number::New(env->isolate(), static_cast<double>(total))};
+        impl->reader->MakeCallback(fn, arraysize(argv), argv);
+        return;
+      }
+
+      // Copy the returns vectors into a single ArrayBuffer.
       std::shared_ptr<BackingStore> store = ArrayBuffer::NewBackingStore(
           env->isolate(),
           total,
@@ -400,8 +437,15 @@ void Blob::Reader::Pull(const FunctionCallbackInfo<Value>& args) {
     impl->reader->MakeCallback(fn, arraysize(argv), argv);
   };
 
-  args.GetReturnValue().Set(reader->inner_->Pull(
-      std::move(next), node::bob::OPTIONS_END, nullptr, 0));
+  // The chunks end up in a single buffer either way, so take as many of
+  // them at once as are available.
+  int options = node::bob::OPTIONS_END | node::bob::OPTIONS_GATHER;
+  if (destination.base != nullptr) {
+    return args.GetReturnValue().Set(
+        reader->inner_->Pull(std::move(next), options, &destination, 1));
+  }
+  args.GetReturnValue().Set(
+      reader->inner_->Pull(std::move(next), options, nullptr, 0));
 }
 
 BaseObjectPtr<BaseObject>
@@ -421,6 +465,9 @@ BaseObject::TransferMode Blob::GetTransferMode() const {
 }
 
 std::unique_ptr<worker::TransferData> Blob::CloneForMessaging() const {
+  // The DataQueue is shared, not copied. That includes non-idempotent
+  // queues that are still being appended to, such as the inbound data of
+  // a QUIC stream, which can then be read on the receiving thread.
   return std::make_unique<BlobTransferData>(data_queue_);
 }
 
@@ -43,7 +43,14 @@ enum Options : int {
   // stream has not yet ended, it should call Next
   // using STATUS_BLOCK. When not set, the source
   // may call Next asynchronously.
-  OPTIONS_SYNC = 2
+  OPTIONS_SYNC = 2,
+
+  // Indicates that the consumer can handle the data of
+  // several chunks at once. Sources that have more than
+  // one chunk readily available may then deliver up to
+  // max_count_hint of them in a single call to Next
+  // instead of one per pull.
+  OPTIONS_GATHER = 4
 };
 
 // There are Sources and there are Consumers.
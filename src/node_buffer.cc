@@ -39,8 +39,17 @@
 #include <stdint.h>
 #include <climits>
 #include <cstring>
+#include <vector>
 #include "nbytes.h"
 
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define NODE_BUFFER_X86_SIMD 1
+#include <immintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#define NODE_BUFFER_NEON 1
+#include <arm_neon.h>
+#endif
+
 #define THROW_AND_RETURN_UNLESS_BUFFER(env, obj)                            \
   THROW_AND_RETURN_IF_NOT_BUFFER(env, obj, "argument")                      \
 
@@ -55,6 +64,7 @@
 namespace node {
 namespace Buffer {
 
+using v8::Array;
 using v8::ArrayBuffer;
 using v8::ArrayBufferView;
 using v8::BackingStore;
@@ -72,6 +82,7 @@ using v8::Integer;
 using v8::Isolate;
 using v8::Just;
 using v8::Local;
+using v8::LocalVector;
 using v8::Maybe;
 using v8::MaybeLocal;
 using v8::Nothing;
@@ -102,6 +113,7 @@ class CallbackInfo : public Cleanable {
   void Clean();
   inline void OnBackingStoreFree();
   inline void CallAndResetCallback();
+  static void RunReleasedCallbacks(Environment* env);
   inline CallbackInfo(Environment* env,
                       FreeCallback callback,
                       char* data,
@@ -198,11 +210,24 @@ void CallbackInfo::OnBackingStoreFree() {
   // be gone at this point, so don’t attempt to call SetImmediateThreadsafe().
   if (callback_ == nullptr) return;
 
-  env_->SetImmediateThreadsafe([self = std::move(self)](Environment* env) {
+  // Freeing many external buffers at once, e.g. in one GC, would otherwise
+  // schedule one threadsafe immediate per buffer, so their callbacks are
+  // batched and run by a single one instead.
+  Environment* env = env_;
+  if (env->AddReleasedBufferCallback(std::move(self)))
+    env->SetImmediateThreadsafe(RunReleasedCallbacks);
+}
+
+void CallbackInfo::RunReleasedCallbacks(Environment* env) {
+  // Callbacks that are released while these run are queued for the next
+  // batch.
+  for (std::unique_ptr<Cleanable>& released :
+       env->TakeReleasedBufferCallbacks()) {
+    CallbackInfo* self = static_cast<CallbackInfo*>(released.get());
     CHECK_EQ(self->env_, env);  // Consistency check.
 
     self->CallAndResetCallback();
-  });
+  }
 }
 
 
@@ -360,6 +385,21 @@ MaybeLocal<Object> New(Isolate* isolate, size_t length) {
 }
 
 
+namespace {
+// Small buffers come from the Environment's BufferPool when possible.
+std::unique_ptr<BackingStore> NewUninitializedBackingStore(Environment* env,
+                                                           size_t length) {
+  if (BufferPool::IsPooledLength(length)) {
+    if (BufferPool* pool = env->buffer_pool()) {
+      std::unique_ptr<BackingStore> bs = pool->NewBackingStore(length);
+      if (bs) return bs;
+    }
+  }
+  return ArrayBuffer::NewBackingStore(
+      env->isolate(), length, BackingStoreInitializationMode::kUninitialized);
+}
+}  // anonymous namespace
+
 MaybeLocal<Object> New(Environment* env, size_t length) {
   Isolate* isolate(env->isolate());
   EscapableHandleScope scope(isolate);
@@ -372,8 +412,8 @@ MaybeLocal<Object> New(Environment* env, size_t length) {
 
   Local<ArrayBuffer> ab;
   {
-    std::unique_ptr<BackingStore> bs = ArrayBuffer::NewBackingStore(
-        isolate, length, BackingStoreInitializationMode::kUninitialized);
+    std::unique_ptr<BackingStore> bs =
+        NewUninitializedBackingStore(env, length);
 
     CHECK(bs);
 
@@ -412,8 +452,7 @@ MaybeLocal<Object> Copy(Environment* env, const char* data, size_t length) {
     return Local<Object>();
   }
 
-  std::unique_ptr<BackingStore> bs = ArrayBuffer::NewBackingStore(
-      isolate, length, BackingStoreInitializationMode::kUninitialized);
+  std::unique_ptr<BackingStore> bs = NewUninitializedBackingStore(env, length);
 
   CHECK(bs);
 
@@ -563,6 +602,72 @@ void StringSlice(const FunctionCallbackInfo<Value>& args) {
   }
 }
 
+// A one-byte string that points into a Buffer's memory instead of owning a
+// copy. The reference to the BackingStore keeps the memory alive for as long
+// as V8 holds on to the string, even if the Buffer is collected or detached.
+class BackingStoreOneByteString final
+    : public String::ExternalOneByteStringResource {
+ public:
+  BackingStoreOneByteString(std::shared_ptr<BackingStore> store,
+                            const char* data,
+                            size_t length)
+      : store_(std::move(store)), data_(data), length_(length) {}
+
+  const char* data() const override { return data_; }
+  size_t length() const override { return length_; }
+
+ private:
+  std::shared_ptr<BackingStore> store_;
+  const char* data_;
+  size_t length_;
+};
+
+// Below this, copying is cheaper than tracking an external string.
+constexpr size_t kMinExternalSliceLength = 64 * 1024;
+
+// Like latin1Slice() and asciiSlice(), but large slices become external
+// strings that share the Buffer's memory, so read-only payloads such as
+// templates are not duplicated. The Buffer must not be modified afterwards
+// since the string would change along with it. Input that is not pure ASCII
+// is copied by asciiSlice() as usual, since the high bits must be cleared.
+template <encoding encoding>
+void ExternalStringSlice(const FunctionCallbackInfo<Value>& args) {
+  static_assert(encoding == ASCII || encoding == LATIN1);
+  Environment* env = Environment::GetCurrent(args);
+  Isolate* isolate = env->isolate();
+
+  THROW_AND_RETURN_UNLESS_BUFFER(env, args.This());
+  Local<ArrayBufferView> view = args.This().As<ArrayBufferView>();
+  const size_t byte_length = view->ByteLength();
+
+  size_t start = 0;
+  size_t end = 0;
+  THROW_AND_RETURN_IF_OOB(ParseArrayIndex(env, args[0], 0, &start));
+  THROW_AND_RETURN_IF_OOB(ParseArrayIndex(env, args[1], byte_length, &end));
+  if (end < start) end = start;
+  THROW_AND_RETURN_IF_OOB(Just(end <= byte_length));
+  const size_t length = end - start;
+
+  if (length < kMinExternalSliceLength) return StringSlice<encoding>(args);
+
+  std::shared_ptr<BackingStore> store = view->Buffer()->GetBackingStore();
+  const char* data =
+      static_cast<const char*>(store->Data()) + view->ByteOffset() + start;
+  if (encoding == ASCII && !simdutf::validate_ascii(data, length)) {
+    return StringSlice<encoding>(args);
+  }
+
+  auto* resource =
+      new BackingStoreOneByteString(std::move(store), data, length);
+  Local<String> str;
+  if (!String::NewExternalOneByte(isolate, resource).ToLocal(&str)) {
+    delete resource;
+    isolate->ThrowException(ERR_STRING_TOO_LONG(isolate));
+    return;
+  }
+  args.GetReturnValue().Set(str);
+}
+
 void CopyImpl(Local<Value> source_obj,
               Local<Value> target_obj,
               const uint32_t target_start,
@@ -605,6 +710,81 @@ uint32_t FastCopy(Local<Value> receiver,
 
 static CFunction fast_copy(CFunction::Make(FastCopy));
 
+// concat(list, totalLength, asRope)
+// Concatenates the ArrayBufferViews in `list` with a single allocation and
+// one native call. Unless `totalLength` is undefined, the result is cut off
+// or zero-filled to that length like Buffer.concat() does. With `asRope`,
+// nothing is copied: the result is a Blob whose DataQueue references each
+// chunk's backing store, so that it can be written out with writev() later.
+// The chunks must not be modified afterwards in that case.
+void Concat(const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+  Isolate* isolate = env->isolate();
+  CHECK(args[0]->IsArray());
+  Local<Array> list = args[0].As<Array>();
+  const bool as_rope = args[2]->IsTrue();
+
+  const uint32_t count = list->Length();
+  LocalVector<ArrayBufferView> chunks(isolate);
+  chunks.reserve(count);
+  size_t total_length = 0;
+  for (uint32_t i = 0; i < count; i++) {
+    Local<Value> chunk;
+    if (!list->Get(env->context(), i).ToLocal(&chunk)) return;
+    if (!chunk->IsArrayBufferView()) {
+      return THROW_ERR_INVALID_ARG_TYPE(
+          env, "The \"list[%d]\" argument must be an ArrayBufferView", i);
+    }
+    chunks.push_back(chunk.As<ArrayBufferView>());
+    total_length += chunks.back()->ByteLength();
+  }
+
+  if (!args[1]->IsUndefined()) {
+    THROW_AND_RETURN_IF_OOB(ParseArrayIndex(env, args[1], 0, &total_length));
+  }
+  if (total_length > kMaxLength) {
+    isolate->ThrowException(ERR_BUFFER_TOO_LARGE(isolate));
+    return;
+  }
+
+  if (as_rope) {
+    std::vector<std::unique_ptr<DataQueue::Entry>> entries;
+    entries.reserve(count);
+    size_t remaining = total_length;
+    for (Local<ArrayBufferView> chunk : chunks) {
+      if (remaining == 0) break;
+      size_t length = std::min(chunk->ByteLength(), remaining);
+      if (length == 0) continue;
+      entries.push_back(DataQueue::CreateInMemoryEntryFromBackingStore(
+          chunk->Buffer()->GetBackingStore(), chunk->ByteOffset(), length));
+      remaining -= length;
+    }
+    if (remaining > 0) {
+      std::shared_ptr<BackingStore> zeros = ArrayBuffer::NewBackingStore(
+          isolate, remaining, BackingStoreInitializationMode::kZeroInitialized);
+      entries.push_back(DataQueue::CreateInMemoryEntryFromBackingStore(
+          std::move(zeros), 0, remaining));
+    }
+    BaseObjectPtr<Blob> blob =
+        Blob::Create(env, DataQueue::CreateIdempotent(std::move(entries)));
+    if (blob) args.GetReturnValue().Set(blob->object());
+    return;
+  }
+
+  Local<Object> result;
+  if (!New(env, total_length).ToLocal(&result)) return;
+  char* dest = Data(result);
+  size_t offset = 0;
+  for (Local<ArrayBufferView> chunk : chunks) {
+    if (offset == total_length) break;
+    offset += chunk->CopyContents(dest + offset,
+                                  std::min(chunk->ByteLength(),
+                                           total_length - offset));
+  }
+  if (offset < total_length) memset(dest + offset, 0, total_length - offset);
+  args.GetReturnValue().Set(result);
+}
+
 void Fill(const FunctionCallbackInfo<Value>& args) {
   Environment* env = Environment::GetCurrent(args);
   Local<Context> ctx = env->context();
@@ -862,6 +1042,97 @@ void CompareOffset(const FunctionCallbackInfo<Value> &args) {
   args.GetReturnValue().Set(val);
 }
 
+// Returns the index of the first byte that differs between `a` and `b`, or
+// `length` if the ranges are equal.
+size_t FindMismatch(const char* a, const char* b, size_t length) {
+  size_t i = 0;
+#if NODE_BUFFER_X86_SIMD
+  // SSE2 is part of the x86-64 baseline, so no runtime check is needed.
+  for (; i + 16 <= length; i += 16) {
+    __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+    __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+    unsigned mask = _mm_movemask_epi8(_mm_cmpeq_epi8(va, vb)) ^ 0xffff;
+    if (mask != 0) return i + __builtin_ctz(mask);
+  }
+#elif NODE_BUFFER_NEON
+  for (; i + 16 <= length; i += 16) {
+    uint8x16_t eq = vceqq_u8(vld1q_u8(reinterpret_cast<const uint8_t*>(a + i)),
+                             vld1q_u8(reinterpret_cast<const uint8_t*>(b + i)));
+    if (vminvq_u8(eq) != 0xff) break;
+  }
+#endif
+  for (; i + sizeof(uint64_t) <= length; i += sizeof(uint64_t)) {
+    uint64_t wa, wb;
+    memcpy(&wa, a + i, sizeof(wa));
+    memcpy(&wb, b + i, sizeof(wb));
+    if (wa != wb) break;
+  }
+  for (; i < length; i++) {
+    if (a[i] != b[i]) return i;
+  }
+  return length;
+}
+
+// Parses the (a, aStart, b, bStart, length) arguments shared by equalsRange()
+// and mismatch(). Returns false if an exception has been scheduled.
+bool ParseRangePair(const FunctionCallbackInfo<Value>& args,
+                    const ArrayBufferViewContents<char>& a,
+                    const ArrayBufferViewContents<char>& b,
+                    size_t* a_start,
+                    size_t* b_start,
+                    size_t* length) {
+  Environment* env = Environment::GetCurrent(args);
+  size_t a_offset = 0;
+  size_t b_offset = 0;
+  size_t count = 0;
+  Maybe<bool> in_range = ParseArrayIndex(env, args[1], 0, &a_offset);
+  if (in_range.FromMaybe(false))
+    in_range = ParseArrayIndex(env, args[3], 0, &b_offset);
+  if (in_range.FromMaybe(false))
+    in_range = ParseArrayIndex(env, args[4], 0, &count);
+  if (in_range.IsNothing()) return false;
+  if (!in_range.FromJust() || a_offset > a.length() ||
+      count > a.length() - a_offset || b_offset > b.length() ||
+      count > b.length() - b_offset) {
+    THROW_ERR_OUT_OF_RANGE(env, "Index out of range");
+    return false;
+  }
+  *a_start = a_offset;
+  *b_start = b_offset;
+  *length = count;
+  return true;
+}
+
+// equalsRange(a, aStart, b, bStart, length)
+void EqualsRange(const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+  THROW_AND_RETURN_UNLESS_BUFFER(env, args[0]);
+  THROW_AND_RETURN_UNLESS_BUFFER(env, args[2]);
+  ArrayBufferViewContents<char> a(args[0]);
+  ArrayBufferViewContents<char> b(args[2]);
+  size_t a_start, b_start, length;
+  if (!ParseRangePair(args, a, b, &a_start, &b_start, &length)) return;
+  args.GetReturnValue().Set(
+      length == 0 ||
+      memcmp(a.data() + a_start, b.data() + b_start, length) == 0);
+}
+
+// mismatch(a, aStart, b, bStart, length)
+// Returns the offset, relative to the starts, of the first differing byte
+// in the two ranges, or -1 if they are equal.
+void Mismatch(const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+  THROW_AND_RETURN_UNLESS_BUFFER(env, args[0]);
+  THROW_AND_RETURN_UNLESS_BUFFER(env, args[2]);
+  ArrayBufferViewContents<char> a(args[0]);
+  ArrayBufferViewContents<char> b(args[2]);
+  size_t a_start, b_start, length;
+  if (!ParseRangePair(args, a, b, &a_start, &b_start, &length)) return;
+  size_t offset = FindMismatch(a.data() + a_start, b.data() + b_start, length);
+  args.GetReturnValue().Set(offset == length ? -1.0
+                                             : static_cast<double>(offset));
+}
+
 int32_t CompareImpl(Local<Value> a_obj, Local<Value> b_obj) {
   ArrayBufferViewContents<char> a(a_obj);
   ArrayBufferViewContents<char> b(b_obj);
@@ -1124,6 +1395,147 @@ void IndexOfBuffer(const FunctionCallbackInfo<Value>& args) {
       result == haystack_length ? -1 : static_cast<int>(result));
 }
 
+namespace {
+struct SearchNeedle {
+  const uint8_t* data;
+  size_t length;
+};
+
+// Returns true if any needle starts at `pos`, storing the index of the first
+// such needle (in argument order) in `*which`.
+inline bool MatchAnyAt(const uint8_t* haystack,
+                       size_t haystack_length,
+                       const std::vector<SearchNeedle>& needles,
+                       size_t pos,
+                       size_t* which) {
+  for (size_t i = 0; i < needles.size(); i++) {
+    const SearchNeedle& needle = needles[i];
+    if (needle.length > haystack_length - pos) continue;
+    if (needle.length == 0 ||
+        (haystack[pos] == needle.data[0] &&
+         memcmp(haystack + pos, needle.data, needle.length) == 0)) {
+      *which = i;
+      return true;
+    }
+  }
+  return false;
+}
+
+// Finds the first offset >= `offset` at which any of `needles` occurs.
+// Candidate positions are found by the first byte of each needle: when only a
+// few distinct first bytes exist, they are located with memchr(), which libc
+// already vectorizes; otherwise a 256-entry lookup table is scanned. Returns
+// -1 if nothing matches.
+int64_t SearchAnyString(const uint8_t* haystack,
+                       size_t haystack_length,
+                       const std::vector<SearchNeedle>& needles,
+                       size_t offset,
+                       size_t* which) {
+  static constexpr size_t kMaxMemchrBytes = 3;
+  uint8_t first_bytes[kMaxMemchrBytes];
+  size_t first_byte_count = 0;
+  bool table[256] = {};
+
+  for (const SearchNeedle& needle : needles) {
+    // An empty needle matches immediately, but an earlier needle takes
+    // precedence if it matches at the same offset.
+    if (needle.length == 0) {
+      return MatchAnyAt(haystack, haystack_length, needles, offset, which)
+                 ? static_cast<int64_t>(offset)
+                 : -1;
+    }
+    uint8_t c = needle.data[0];
+    if (table[c]) continue;
+    table[c] = true;
+    if (first_byte_count < kMaxMemchrBytes) first_bytes[first_byte_count] = c;
+    first_byte_count++;
+  }
+
+  if (first_byte_count <= kMaxMemchrBytes) {
+    // Track the next occurrence of each first byte and always advance the
+    // one that is furthest behind.
+    const uint8_t* next[kMaxMemchrBytes];
+    const uint8_t* end = haystack + haystack_length;
+    for (size_t i = 0; i < first_byte_count; i++) {
+      next[i] = static_cast<const uint8_t*>(
+          memchr(haystack + offset, first_bytes[i], haystack_length - offset));
+    }
+    for (;;) {
+      size_t best = first_byte_count;
+      for (size_t i = 0; i < first_byte_count; i++) {
+        if (next[i] != nullptr && (best == first_byte_count ||
+                                   next[i] < next[best])) {
+          best = i;
+        }
+      }
+      if (best == first_byte_count) return -1;
+      size_t pos = next[best] - haystack;
+      if (MatchAnyAt(haystack, haystack_length, needles, pos, which)) {
+        return static_cast<int64_t>(pos);
+      }
+      const uint8_t* from = next[best] + 1;
+      next[best] = static_cast<const uint8_t*>(
+          memchr(from, first_bytes[best], end - from));
+    }
+  }
+
+  for (size_t pos = offset; pos < haystack_length; pos++) {
+    if (table[haystack[pos]] &&
+        MatchAnyAt(haystack, haystack_length, needles, pos, which)) {
+      return static_cast<int64_t>(pos);
+    }
+  }
+  return -1;
+}
+}  // anonymous namespace
+
+// Searches a buffer for the first occurrence of any of several needles.
+// args: haystack, needles (Array of Buffers), byteOffset.
+// Returns [offset, needleIndex], or -1 if none of the needles occur.
+void IndexOfAnyBuffer(const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+  CHECK(args[1]->IsArray());
+  CHECK(args[2]->IsNumber());
+
+  THROW_AND_RETURN_UNLESS_BUFFER(env, args[0]);
+  ArrayBufferViewContents<uint8_t> haystack_contents(args[0]);
+  const uint8_t* haystack = haystack_contents.data();
+  const size_t haystack_length = haystack_contents.length();
+
+  Local<Array> needles_array = args[1].As<Array>();
+  const uint32_t count = needles_array->Length();
+  std::vector<SearchNeedle> needles;
+  needles.reserve(count);
+  for (uint32_t i = 0; i < count; i++) {
+    Local<Value> needle;
+    if (!needles_array->Get(env->context(), i).ToLocal(&needle)) return;
+    THROW_AND_RETURN_UNLESS_BUFFER(env, needle);
+    needles.push_back({reinterpret_cast<const uint8_t*>(Data(needle)),
+                       Length(needle)});
+  }
+
+  int64_t opt_offset = IndexOfOffset(
+      haystack_length, args[2].As<Integer>()->Value(), 0, true);
+  if (needles.empty() || opt_offset <= -1 ||
+      static_cast<size_t>(opt_offset) > haystack_length) {
+    return args.GetReturnValue().Set(-1);
+  }
+
+  size_t which = 0;
+  int64_t result = SearchAnyString(haystack,
+                                   haystack_length,
+                                   needles,
+                                   static_cast<size_t>(opt_offset),
+                                   &which);
+  if (result == -1) return args.GetReturnValue().Set(-1);
+
+  Local<Value> values[] = {
+      Number::New(env->isolate(), static_cast<double>(result)),
+      Integer::NewFromUnsigned(env->isolate(), static_cast<uint32_t>(which)),
+  };
+  args.GetReturnValue().Set(Array::New(env->isolate(), values, 2));
+}
+
 int32_t IndexOfNumberImpl(Local<Value> buffer_obj,
                           const uint32_t needle,
                           const int64_t offset_i64,
@@ -1177,11 +1589,92 @@ int32_t FastIndexOfNumber(Local<Value>,
 
 static CFunction fast_index_of_number(CFunction::Make(FastIndexOfNumber));
 
+// Copies `length` bytes from `src` to `dst` while reversing the byte order of
+// every `width`-byte element, 16 bytes at a time. Returns the number of bytes
+// handled; the caller swaps the rest. `src` and `dst` may be the same.
+#if NODE_BUFFER_X86_SIMD
+__attribute__((target("ssse3"))) size_t CopySwapSSSE3(const char* src,
+                                                      char* dst,
+                                                      size_t length,
+                                                      size_t width) {
+  __m128i shuffle;
+  if (width == 2) {
+    shuffle = _mm_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6,
+                            9, 8, 11, 10, 13, 12, 15, 14);
+  } else if (width == 4) {
+    shuffle = _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4,
+                            11, 10, 9, 8, 15, 14, 13, 12);
+  } else {
+    shuffle = _mm_setr_epi8(7, 6, 5, 4, 3, 2, 1, 0,
+                            15, 14, 13, 12, 11, 10, 9, 8);
+  }
+  size_t i = 0;
+  for (; i + 16 <= length; i += 16) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i),
+                     _mm_shuffle_epi8(v, shuffle));
+  }
+  return i;
+}
+
+size_t CopySwapSimd(const char* src, char* dst, size_t length, size_t width) {
+  static const bool has_ssse3 = []() {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("ssse3");
+  }();
+  return has_ssse3 ? CopySwapSSSE3(src, dst, length, width) : 0;
+}
+#elif NODE_BUFFER_NEON
+size_t CopySwapSimd(const char* src, char* dst, size_t length, size_t width) {
+  const uint8_t* in = reinterpret_cast<const uint8_t*>(src);
+  uint8_t* out = reinterpret_cast<uint8_t*>(dst);
+  size_t i = 0;
+  for (; i + 16 <= length; i += 16) {
+    uint8x16_t v = vld1q_u8(in + i);
+    if (width == 2) {
+      v = vrev16q_u8(v);
+    } else if (width == 4) {
+      v = vrev32q_u8(v);
+    } else {
+      v = vrev64q_u8(v);
+    }
+    vst1q_u8(out + i, v);
+  }
+  return i;
+}
+#else
+size_t CopySwapSimd(const char* src, char* dst, size_t length, size_t width) {
+  return 0;
+}
+#endif
+
+// `length` must be a multiple of `width`, which is 2, 4 or 8.
+void CopySwap(const char* src, char* dst, size_t length, size_t width) {
+  if (src != dst && src < dst + length && dst < src + length) {
+    // Partially overlapping ranges are copied first and swapped in place.
+    memmove(dst, src, length);
+    src = dst;
+  }
+  size_t done = CopySwapSimd(src, dst, length, width);
+  if (done == length) return;
+  if (src != dst) memcpy(dst + done, src + done, length - done);
+  bool ok;
+  if (width == 2) {
+    ok = nbytes::SwapBytes16(dst + done, length - done);
+  } else if (width == 4) {
+    ok = nbytes::SwapBytes32(dst + done, length - done);
+  } else {
+    ok = nbytes::SwapBytes64(dst + done, length - done);
+  }
+  CHECK(ok);
+}
+
 void Swap16(const FunctionCallbackInfo<Value>& args) {
   Environment* env = Environment::GetCurrent(args);
   THROW_AND_RETURN_UNLESS_BUFFER(env, args[0]);
   SPREAD_BUFFER_ARG(args[0], ts_obj);
-  CHECK(nbytes::SwapBytes16(ts_obj_data, ts_obj_length));
+  CHECK_EQ(ts_obj_length % 2, 0);
+  CopySwap(ts_obj_data, ts_obj_data, ts_obj_length, 2);
   args.GetReturnValue().Set(args[0]);
 }
 
@@ -1190,7 +1683,8 @@ void Swap32(const FunctionCallbackInfo<Value>& args) {
   Environment* env = Environment::GetCurrent(args);
   THROW_AND_RETURN_UNLESS_BUFFER(env, args[0]);
   SPREAD_BUFFER_ARG(args[0], ts_obj);
-  CHECK(nbytes::SwapBytes32(ts_obj_data, ts_obj_length));
+  CHECK_EQ(ts_obj_length % 4, 0);
+  CopySwap(ts_obj_data, ts_obj_data, ts_obj_length, 4);
   args.GetReturnValue().Set(args[0]);
 }
 
@@ -1199,10 +1693,96 @@ void Swap64(const FunctionCallbackInfo<Value>& args) {
   Environment* env = Environment::GetCurrent(args);
   THROW_AND_RETURN_UNLESS_BUFFER(env, args[0]);
   SPREAD_BUFFER_ARG(args[0], ts_obj);
-  CHECK(nbytes::SwapBytes64(ts_obj_data, ts_obj_length));
+  CHECK_EQ(ts_obj_length % 8, 0);
+  CopySwap(ts_obj_data, ts_obj_data, ts_obj_length, 8);
   args.GetReturnValue().Set(args[0]);
 }
 
+// copySwap(source, target, targetStart, sourceStart, byteLength, width)
+// Copies `byteLength` bytes like buffer.copy() does, but reverses the byte
+// order of each `width`-byte element. Returns the number of bytes copied.
+void CopySwapBuffer(const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+  THROW_AND_RETURN_UNLESS_BUFFER(env, args[0]);
+  THROW_AND_RETURN_UNLESS_BUFFER(env, args[1]);
+  CHECK(args[5]->IsUint32());
+  ArrayBufferViewContents<char> source(args[0]);
+  SPREAD_BUFFER_ARG(args[1], target);
+
+  size_t target_start = 0;
+  size_t source_start = 0;
+  size_t length = 0;
+  THROW_AND_RETURN_IF_OOB(ParseArrayIndex(env, args[2], 0, &target_start));
+  THROW_AND_RETURN_IF_OOB(ParseArrayIndex(env, args[3], 0, &source_start));
+  THROW_AND_RETURN_IF_OOB(ParseArrayIndex(env, args[4], 0, &length));
+  THROW_AND_RETURN_IF_OOB(Just(source_start <= source.length() &&
+                               length <= source.length() - source_start &&
+                               target_start <= target_length &&
+                               length <= target_length - target_start));
+
+  const uint32_t width = args[5].As<Uint32>()->Value();
+  CHECK(width == 2 || width == 4 || width == 8);
+  if (length % width != 0) {
+    return THROW_ERR_INVALID_BUFFER_SIZE(
+        env, "Buffer size must be a multiple of %d-bits", width * 8);
+  }
+
+  CopySwap(source.data() + source_start,
+           target_data + target_start,
+           length,
+           width);
+  args.GetReturnValue().Set(static_cast<double>(length));
+}
+
+// convertInt16ToFloat32(source, sourceStart, target, targetStart, count,
+//                       bigEndian, scale)
+// Reads `count` 16-bit signed integers and writes them as little-endian
+// 32-bit floats, each multiplied by `scale` (e.g. 1 / 32768 for PCM audio).
+// Returns the number of bytes written.
+void ConvertInt16ToFloat32(const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+  THROW_AND_RETURN_UNLESS_BUFFER(env, args[0]);
+  THROW_AND_RETURN_UNLESS_BUFFER(env, args[2]);
+  CHECK(args[6]->IsNumber());
+  ArrayBufferViewContents<char> source(args[0]);
+  SPREAD_BUFFER_ARG(args[2], target);
+
+  size_t source_start = 0;
+  size_t target_start = 0;
+  size_t count = 0;
+  THROW_AND_RETURN_IF_OOB(ParseArrayIndex(env, args[1], 0, &source_start));
+  THROW_AND_RETURN_IF_OOB(ParseArrayIndex(env, args[3], 0, &target_start));
+  THROW_AND_RETURN_IF_OOB(ParseArrayIndex(env, args[4], 0, &count));
+  THROW_AND_RETURN_IF_OOB(
+      Just(count <= kMaxLength / sizeof(float) &&
+           source_start <= source.length() &&
+           count * sizeof(int16_t) <= source.length() - source_start &&
+           target_start <= target_length &&
+           count * sizeof(float) <= target_length - target_start));
+
+  const bool swap_input = args[5]->IsTrue() != IsBigEndian();
+  const float scale = static_cast<float>(args[6].As<Number>()->Value());
+  const char* in = source.data() + source_start;
+  char* out = target_data + target_start;
+
+  // Kept simple so that compilers vectorize it.
+  for (size_t i = 0; i < count; i++) {
+    uint16_t raw;
+    memcpy(&raw, in + i * sizeof(raw), sizeof(raw));
+    if (swap_input) raw = static_cast<uint16_t>((raw << 8) | (raw >> 8));
+    float value = static_cast<int16_t>(raw) * scale;
+    if constexpr (IsBigEndian()) {
+      uint32_t bits;
+      memcpy(&bits, &value, sizeof(bits));
+      bits = (bits >> 24) | ((bits >> 8) & 0xff00) | ((bits << 8) & 0xff0000) |
+             (bits << 24);
+      memcpy(&value, &bits, sizeof(bits));
+    }
+    memcpy(out + i * sizeof(value), &value, sizeof(value));
+  }
+  args.GetReturnValue().Set(static_cast<double>(count * sizeof(float)));
+}
+
 static void IsUtf8(const FunctionCallbackInfo<Value>& args) {
   Environment* env = Environment::GetCurrent(args);
   CHECK_EQ(args.Length(), 1);
@@ -1563,10 +2143,14 @@ void Initialize(Local<Object> target,
                             SlowByteLengthUtf8,
                             &fast_byte_length_utf8);
   SetFastMethod(context, target, "copy", SlowCopy, &fast_copy);
+  SetMethod(context, target, "concat", Concat);
   SetFastMethodNoSideEffect(context, target, "compare", Compare, &fast_compare);
   SetMethodNoSideEffect(context, target, "compareOffset", CompareOffset);
+  SetMethodNoSideEffect(context, target, "equalsRange", EqualsRange);
+  SetMethodNoSideEffect(context, target, "mismatch", Mismatch);
   SetMethod(context, target, "fill", Fill);
   SetMethodNoSideEffect(context, target, "indexOfBuffer", IndexOfBuffer);
+  SetMethodNoSideEffect(context, target, "indexOfAnyBuffer", IndexOfAnyBuffer);
   SetFastMethodNoSideEffect(context,
                             target,
                             "indexOfNumber",
@@ -1579,6 +2163,8 @@ void Initialize(Local<Object> target,
   SetMethod(context, target, "swap16", Swap16);
   SetMethod(context, target, "swap32", Swap32);
   SetMethod(context, target, "swap64", Swap64);
+  SetMethod(context, target, "copySwap", CopySwapBuffer);
+  SetMethod(context, target, "convertInt16ToFloat32", ConvertInt16ToFloat32);
 
   SetMethodNoSideEffect(context, target, "isUtf8", IsUtf8);
   SetMethodNoSideEffect(context, target, "isAscii", IsAscii);
@@ -1600,6 +2186,14 @@ void Initialize(Local<Object> target,
   SetMethodNoSideEffect(
       context, target, "base64urlSlice", StringSlice<BASE64URL>);
   SetMethodNoSideEffect(context, target, "latin1Slice", StringSlice<LATIN1>);
+  SetMethodNoSideEffect(context,
+                        target,
+                        "asciiExternalSlice",
+                        ExternalStringSlice<ASCII>);
+  SetMethodNoSideEffect(context,
+                        target,
+                        "latin1ExternalSlice",
+                        ExternalStringSlice<LATIN1>);
   SetMethodNoSideEffect(context, target, "hexSlice", StringSlice<HEX>);
   SetMethodNoSideEffect(context, target, "ucs2Slice", StringSlice<UCS2>);
   SetMethodNoSideEffect(context, target, "utf8Slice", StringSlice<UTF8>);
@@ -1639,12 +2233,16 @@ void RegisterExternalReferences(ExternalReferenceRegistry* registry) {
   registry->Register(SlowCopy);
   registry->Register(fast_copy.GetTypeInfo());
   registry->Register(FastCopy);
+  registry->Register(Concat);
   registry->Register(Compare);
   registry->Register(FastCompare);
   registry->Register(fast_compare.GetTypeInfo());
   registry->Register(CompareOffset);
+  registry->Register(EqualsRange);
+  registry->Register(Mismatch);
   registry->Register(Fill);
   registry->Register(IndexOfBuffer);
+  registry->Register(IndexOfAnyBuffer);
   registry->Register(SlowIndexOfNumber);
   registry->Register(FastIndexOfNumber);
   registry->Register(fast_index_of_number.GetTypeInfo());
@@ -1653,6 +2251,8 @@ void RegisterExternalReferences(ExternalReferenceRegistry* registry) {
   registry->Register(Swap16);
   registry->Register(Swap32);
   registry->Register(Swap64);
+  registry->Register(CopySwapBuffer);
+  registry->Register(ConvertInt16ToFloat32);
 
   registry->Register(IsUtf8);
   registry->Register(IsAscii);
@@ -1664,6 +2264,8 @@ void RegisterExternalReferences(ExternalReferenceRegistry* registry) {
   registry->Register(StringSlice<HEX>);
   registry->Register(StringSlice<UCS2>);
   registry->Register(StringSlice<UTF8>);
+  registry->Register(ExternalStringSlice<ASCII>);
+  registry->Register(ExternalStringSlice<LATIN1>);
 
   registry->Register(SlowWriteString<ASCII>);
   registry->Register(SlowWriteString<LATIN1>);
@@ -292,7 +292,10 @@ MaybeLocal<Function> BuiltinLoader::LookupAndCompileInternal(
     // `CompileFunction()` call below, because this function may recurse if
     // there is a syntax error during bootstrap (because the fatal exception
     // handler is invoked, which may load built-in modules).
-    RwLock::ScopedLock lock(code_cache_->mutex);
+    // Entries are immutable and shared between all isolates using this
+    // loader, so a read lock is enough and Workers bootstrapping concurrently
+    // do not serialize on each other here.
+    RwLock::ScopedReadLock lock(code_cache_->mutex);
     auto cache_it = code_cache_->map.find(id);
     if (cache_it != code_cache_->map.end()) {
       // Transfer ownership to ScriptCompiler::Source later.
@@ -375,7 +378,17 @@ MaybeLocal<Function> BuiltinLoader::LookupAndCompileInternal(
     // This is only done when the isolate is not being serialized because
     // V8 does not support serializing code cache with an unfinalized read-only
     // space (which is what isolates pending to be serialized have).
-    SaveCodeCache(id, fun);
+    // If another isolate sharing this cache (e.g. a sibling Worker) has
+    // already replaced the entry we looked up, reuse that instead of
+    // serializing the function again.
+    bool replaced = false;
+    {
+      RwLock::ScopedReadLock lock(code_cache_->mutex);
+      auto cache_it = code_cache_->map.find(id);
+      replaced = cache_it != code_cache_->map.end() &&
+                 cache_it->second.data != cached_data.data;
+    }
+    if (!replaced) SaveCodeCache(id, fun);
   }
 
   return scope.Escape(fun);
@@ -150,23 +150,19 @@ ParseResult ConfigReader::ParseOptions(
     std::unordered_set<std::string>* unique_options,
     const std::string& namespace_name) {
   // Determine which options map to use and output vector
-  std::unordered_map<std::string, options_parser::OptionType> options_map;
+  const std::unordered_map<std::string, options_parser::OptionType>*
+      options_map;
   std::vector<std::string>* output_vector;
 
   if (namespace_name == "nodeOptions") {
     // Special case for backward compatibility: handle nodeOptions with env
     // options map
-    options_map = options_parser::MapEnvOptionsFlagInputType();
+    options_map = &options_parser::MapEnvOptionsFlagInputType();
     output_vector = &node_options_;
   } else {
     // Handle other namespaces
-    options_map = options_parser::MapOptionsByNamespace(namespace_name);
+    options_map = &options_parser::MapOptionsByNamespace(namespace_name);
     output_vector = &namespace_options_;
-
-    if (!env_options_initialized_) {
-      env_options_map_ = options_parser::MapEnvOptionsFlagInputType();
-      env_options_initialized_ = true;
-    }
   }
 
   simdjson::ondemand::value option_value;
@@ -180,8 +176,8 @@ ParseResult ConfigReader::ParseOptions(
 
     // The key needs to match the CLI option
     std::string prefix = "--";
-    auto option = options_map.find(prefix.append(option_key));
-    if (option != options_map.end()) {
+    auto option = options_map->find(prefix.append(option_key));
+    if (option != options_map->end()) {
       // If the option has already been set, return an error
       if (unique_options->contains(option->first)) {
         FPrintF(
@@ -52,10 +52,6 @@ class ConfigReader {
 
   std::vector<std::string> node_options_;
   std::vector<std::string> namespace_options_;
-
-  // Cache for fast lookup of environment options
-  std::unordered_map<std::string, options_parser::OptionType> env_options_map_;
-  bool env_options_initialized_ = false;
 };
 
 }  // namespace node
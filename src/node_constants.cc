@@ -28,6 +28,7 @@
 #include "zlib.h"
 
 #if !defined(_MSC_VER)
+#include <sys/uio.h>
 #include <unistd.h>
 #endif
 
@@ -1134,6 +1135,26 @@ NODE_DEFINE_CONSTANT(target, UV_FS_O_FILEMAP);
   NODE_DEFINE_CONSTANT(target, O_DIRECT);
 #endif
 
+#ifdef RWF_HIPRI
+  NODE_DEFINE_CONSTANT(target, RWF_HIPRI);
+#endif
+
+#ifdef RWF_DSYNC
+  NODE_DEFINE_CONSTANT(target, RWF_DSYNC);
+#endif
+
+#ifdef RWF_SYNC
+  NODE_DEFINE_CONSTANT(target, RWF_SYNC);
+#endif
+
+#ifdef RWF_NOWAIT
+  NODE_DEFINE_CONSTANT(target, RWF_NOWAIT);
+#endif
+
+#ifdef RWF_APPEND
+  NODE_DEFINE_CONSTANT(target, RWF_APPEND);
+#endif
+
 #ifdef O_NONBLOCK
   NODE_DEFINE_CONSTANT(target, O_NONBLOCK);
 #endif
@@ -79,7 +79,9 @@ namespace node {
  *    The corresponding data structure is node::ContextifyContext and
  *    the initialization code is in node::ContextifyContext::New().
  *    Its context snapshot in the built-in V8 startup snapshot is stored at
- *    node::SnapshotData::kNodeVMContextIndex.
+ *    node::SnapshotData::kNodeVMContextIndex. Vanilla vm contexts, created
+ *    with vm.constants.DONT_CONTEXTIFY, have no interceptors on the global
+ *    object and are stored at node::SnapshotData::kNodeVanillaVMContextIndex.
  * 5. ShadowRealm context: When a JS ShadowRealm is created via new ShadowRealm,
  *    it gets its own v8::Context. It also shares the thread, the v8::Isolate
  *    and the node::Environment with the context where the ShadowRealm
@@ -58,6 +58,7 @@ using v8::Intercepted;
 using v8::Isolate;
 using v8::JustVoid;
 using v8::KeyCollectionMode;
+using v8::KeyConversionMode;
 using v8::Local;
 using v8::LocalVector;
 using v8::Maybe;
@@ -216,7 +217,7 @@ MaybeLocal<Context> ContextifyContext::CreateV8Context(
   EscapableHandleScope scope(isolate);
 
   Local<Context> ctx;
-  if (object_template.IsEmpty() || snapshot_data == nullptr) {
+  if (snapshot_data == nullptr) {
     ctx = Context::New(
         isolate,
         nullptr,  // extensions
@@ -229,7 +230,9 @@ MaybeLocal<Context> ContextifyContext::CreateV8Context(
     }
   } else if (!Context::FromSnapshot(
                   isolate,
-                  SnapshotData::kNodeVMContextIndex,
+                  object_template.IsEmpty()
+                      ? SnapshotData::kNodeVanillaVMContextIndex
+                      : SnapshotData::kNodeVMContextIndex,
                   v8::DeserializeInternalFieldsCallback(),  // deserialization
                                                             // callback
                   nullptr,                                  // extensions
@@ -382,14 +385,25 @@ void ContextifyContext::RegisterExternalReferences(
   registry->Register(IndexedPropertyEnumeratorCallback);
 }
 
-// makeContext(sandbox, name, origin, strings, wasm);
+// makeContext(sandbox, name, origin, strings, wasm, microtaskQueue,
+//             hostDefinedOptionsId[, copyGlobals]);
+//
+// With copyGlobals, the new context does not use the interceptors. The own
+// properties of the sandbox are copied onto its global object instead, and
+// the global object is returned. Global accesses then run at the speed of
+// a normal context, at the cost of the sandbox and the context no longer
+// observing each other's changes.
 void ContextifyContext::MakeContext(const FunctionCallbackInfo<Value>& args) {
   Environment* env = Environment::GetCurrent(args);
   ContextOptions options;
 
-  CHECK_EQ(args.Length(), 7);
+  CHECK(args.Length() == 7 || args.Length() == 8);
   Local<Object> sandbox;
-  if (args[0]->IsObject()) {
+  Local<Object> copied_globals;
+  if (args[0]->IsObject() && args[7]->IsTrue()) {
+    copied_globals = args[0].As<Object>();
+    options.vanilla = true;
+  } else if (args[0]->IsObject()) {
     sandbox = args[0].As<Object>();
     // Don't allow contextifying a sandbox multiple times.
     CHECK(!sandbox
@@ -426,6 +440,9 @@ void ContextifyContext::MakeContext(const FunctionCallbackInfo<Value>& args) {
   TryCatchScope try_catch(env);
   ContextifyContext* context_ptr =
       ContextifyContext::New(env, sandbox, &options);
+  if (context_ptr != nullptr && !copied_globals.IsEmpty()) {
+    USE(CopyGlobals(env, copied_globals, context_ptr->context()));
+  }
 
   if (try_catch.HasCaught()) {
     if (!try_catch.HasTerminated())
@@ -440,6 +457,40 @@ void ContextifyContext::MakeContext(const FunctionCallbackInfo<Value>& args) {
   }
 }
 
+// static
+Maybe<void> ContextifyContext::CopyGlobals(Environment* env,
+                                           Local<Object> source,
+                                           Local<Context> v8_context) {
+  Local<Context> context = env->context();
+  Local<Array> keys;
+  if (!source
+           ->GetPropertyNames(context,
+                              KeyCollectionMode::kOwnOnly,
+                              PropertyFilter::ALL_PROPERTIES,
+                              IndexFilter::kIncludeIndices,
+                              KeyConversionMode::kConvertToString)
+           .ToLocal(&keys)) {
+    return Nothing<void>();
+  }
+
+  Local<Object> global = v8_context->Global();
+  for (uint32_t i = 0; i < keys->Length(); i++) {
+    Local<Value> key;
+    Local<Value> value;
+    if (!keys->Get(context, i).ToLocal(&key) ||
+        !source->Get(context, key).ToLocal(&value)) {
+      return Nothing<void>();
+    }
+    // Like assignments to them from inside the context, copies of the
+    // non-configurable globals (e.g. `undefined`) are silently dropped.
+    if (global->CreateDataProperty(v8_context, key.As<Name>(), value)
+            .IsNothing()) {
+      return Nothing<void>();
+    }
+  }
+  return JustVoid();
+}
+
 // static
 ContextifyContext* ContextifyContext::ContextFromContextifiedSandbox(
     Environment* env, const Local<Object>& wrapper_holder) {
@@ -1042,6 +1093,24 @@ void ContextifyScript::New(const FunctionCallbackInfo<Value>& args) {
         data + cached_data_buf->ByteOffset(), cached_data_buf->ByteLength());
   }
 
+  // Scripts that don't manage their own code cache share the one of the
+  // compile cache, when it is enabled, so that the same script compiled in
+  // other workers or processes only needs to be deserialized. Recompiling
+  // the same script in the same isolate is already served by V8's
+  // compilation cache.
+  CompileCacheEntry* cache_entry = nullptr;
+  ScriptCompiler::ConsumeCodeCacheTask* consume_task = nullptr;
+  if (cached_data == nullptr && !produce_cached_data &&
+      env->use_compile_cache()) {
+    cache_entry = env->compile_cache_handler()->GetOrInsert(
+        code, filename, CachedCodeType::kVmScript);
+  }
+  if (cache_entry != nullptr && cache_entry->cache != nullptr) {
+    // source will take ownership of cached_data and consume_task.
+    cached_data = cache_entry->CopyCache();
+    consume_task = cache_entry->consume_task.release();
+  }
+
   Local<PrimitiveArray> host_defined_options =
       PrimitiveArray::New(isolate, loader::HostDefinedOptions::kLength);
   host_defined_options->Set(
@@ -1057,7 +1126,7 @@ void ContextifyScript::New(const FunctionCallbackInfo<Value>& args) {
                       false,           // is WASM
                       false,           // is ES Module
                       host_defined_options);
-  ScriptCompiler::Source source(code, origin, cached_data);
+  ScriptCompiler::Source source(code, origin, cached_data, consume_task);
   ScriptCompiler::CompileOptions compile_options =
       ScriptCompiler::kNoCompileOptions;
 
@@ -1084,6 +1153,14 @@ void ContextifyScript::New(const FunctionCallbackInfo<Value>& args) {
 
   contextify_script->set_unbound_script(v8_script);
 
+  if (cache_entry != nullptr) {
+    bool rejected = compile_options == ScriptCompiler::kConsumeCodeCache &&
+                    source.GetCachedData()->rejected;
+    env->compile_cache_handler()->MaybeSave(cache_entry, v8_script, rejected);
+    // cachedDataRejected is only reported for cachedData passed by the user.
+    compile_options = ScriptCompiler::kNoCompileOptions;
+  }
+
   std::unique_ptr<ScriptCompiler::CachedData> new_cached_data;
   if (produce_cached_data) {
     new_cached_data.reset(ScriptCompiler::CreateCodeCache(v8_script));
@@ -1764,7 +1841,7 @@ static void CompileFunctionForCJSLoader(
   ScriptCompiler::CachedData* cached_data = nullptr;
 #ifndef DISABLE_SINGLE_EXECUTABLE_APPLICATION
   if (is_sea_main) {
-    sea::SeaResource sea = sea::FindSingleExecutableResource();
+    const sea::SeaResource& sea = sea::FindSingleExecutableResource();
     // Use the "main" field in SEA config for the filename.
     Local<Value> filename_from_sea;
     if (!ToV8Value(context, sea.code_path).ToLocal(&filename_from_sea)) {
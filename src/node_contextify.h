@@ -143,6 +143,11 @@ class ContextifyContext final : CPPGC_MIXIN(ContextifyContext) {
 
   static bool IsStillInitializing(const ContextifyContext* ctx);
   static void MakeContext(const v8::FunctionCallbackInfo<v8::Value>& args);
+  // Copies the own properties of source onto the global object of the
+  // context, for contexts created with copyGlobals.
+  static v8::Maybe<void> CopyGlobals(Environment* env,
+                                     v8::Local<v8::Object> source,
+                                     v8::Local<v8::Context> v8_context);
   static void IsContext(const v8::FunctionCallbackInfo<v8::Value>& args);
   static v8::Intercepted PropertyQueryCallback(
       v8::Local<v8::Name> property,
@@ -10,6 +10,7 @@
 #include "tracing/trace_event.h"
 
 #include "string_bytes.h"
+#include "threadpoolwork-inl.h"
 
 #include <fcntl.h>
 #include <sys/types.h>
@@ -43,6 +44,8 @@ using v8::Number;
 using v8::Object;
 using v8::ObjectTemplate;
 using v8::TryCatch;
+using v8::Uint32;
+using v8::Undefined;
 using v8::Value;
 
 static const char* get_dir_func_name_by_type(uv_fs_type req_type) {
@@ -420,6 +423,311 @@ static void OpenDirSync(const FunctionCallbackInfo<Value>& args) {
   args.GetReturnValue().Set(handle->object().As<Value>());
 }
 
+#ifdef _WIN32
+constexpr char kPathSeparator = '\\';
+#else
+constexpr char kPathSeparator = '/';
+#endif
+
+static std::string JoinPath(const std::string& dir, const std::string& name) {
+  std::string path;
+  path.reserve(dir.size() + 1 + name.size());
+  path += dir;
+  if (path.empty() || path.back() != kPathSeparator) path += kPathSeparator;
+  path += name;
+  return path;
+}
+
+static uv_dirent_type_t DirentTypeFromMode(uint64_t mode) {
+  switch (mode & S_IFMT) {
+    case S_IFREG:
+      return UV_DIRENT_FILE;
+    case S_IFDIR:
+      return UV_DIRENT_DIR;
+    case S_IFLNK:
+      return UV_DIRENT_LINK;
+    case S_IFCHR:
+      return UV_DIRENT_CHAR;
+#ifdef S_IFBLK
+    case S_IFBLK:
+      return UV_DIRENT_BLOCK;
+#endif
+#ifdef S_IFIFO
+    case S_IFIFO:
+      return UV_DIRENT_FIFO;
+#endif
+#ifdef S_IFSOCK
+    case S_IFSOCK:
+      return UV_DIRENT_SOCKET;
+#endif
+    default:
+      return UV_DIRENT_UNKNOWN;
+  }
+}
+
+int ReadDirEntries(const char* path,
+                   std::vector<DirEntry>* entries,
+                   const char** syscall) {
+  uv_fs_t req;
+  int err = uv_fs_opendir(nullptr, &req, path, nullptr);
+  if (err < 0) {
+    uv_fs_req_cleanup(&req);
+    *syscall = "opendir";
+    return err;
+  }
+  uv_dir_t* dir = static_cast<uv_dir_t*>(req.ptr);
+  uv_fs_req_cleanup(&req);
+
+  uv_dirent_t dirents[kDirEntriesPerRead];
+  dir->dirents = dirents;
+  dir->nentries = arraysize(dirents);
+  for (;;) {
+    err = uv_fs_readdir(nullptr, &req, dir, nullptr);
+    if (err <= 0) {
+      uv_fs_req_cleanup(&req);
+      break;
+    }
+    for (int i = 0; i < err; i++)
+      entries->push_back(DirEntry{dirents[i].name, dirents[i].type, {}});
+    // This frees the names of the entries that have just been read.
+    uv_fs_req_cleanup(&req);
+  }
+  if (err < 0) *syscall = "readdir";
+
+  CHECK_EQ(uv_fs_closedir(nullptr, &req, dir, nullptr), 0);
+  uv_fs_req_cleanup(&req);
+  return err;
+}
+
+// Reads all entries of one directory on a threadpool thread. Entries whose
+// type the file system does not report, and all entries if stats were
+// requested, are lstat()ed on the same thread.
+class DirWalker::ScanJob final : public ThreadPoolWork {
+ public:
+  ScanJob(DirWalker* walker, std::string path)
+      : ThreadPoolWork(
+            walker->env(), "fs_dir.DirWalker", ThreadPoolWorkClass::kFs),
+        walker_(walker),
+        path_(std::move(path)),
+        with_stats_(walker->with_stats_) {}
+
+  void DoThreadPoolWork() override {
+    result_ = ReadDirEntries(path_.c_str(), &entries_, &syscall_);
+    if (result_ < 0) {
+      failed_path_ = path_;
+      return;
+    }
+
+    uv_fs_t req;
+    for (auto it = entries_.begin(); it != entries_.end();) {
+      if (!with_stats_ && it->type != UV_DIRENT_UNKNOWN) {
+        ++it;
+        continue;
+      }
+      std::string path = JoinPath(path_, it->name);
+      int err = uv_fs_lstat(nullptr, &req, path.c_str(), nullptr);
+      if (err == 0) it->stat = req.statbuf;
+      uv_fs_req_cleanup(&req);
+      if (err == UV_ENOENT) {
+        // The entry was removed after the directory was read.
+        it = entries_.erase(it);
+        continue;
+      }
+      if (err < 0) {
+        result_ = err;
+        syscall_ = "lstat";
+        failed_path_ = std::move(path);
+        return;
+      }
+      if (it->type == UV_DIRENT_UNKNOWN)
+        it->type = DirentTypeFromMode(it->stat.st_mode);
+      ++it;
+    }
+  }
+
+  void AfterThreadPoolWork(int status) override {
+    std::unique_ptr<ScanJob> self(this);
+    walker_->AfterScan(this, status);
+  }
+
+  const std::string& path() const { return path_; }
+  const std::string& failed_path() const { return failed_path_; }
+  const char* syscall() const { return syscall_; }
+  const std::vector<DirEntry>& entries() const { return entries_; }
+  int result() const { return result_; }
+
+ private:
+  BaseObjectPtr<DirWalker> walker_;
+  std::string path_;
+  bool with_stats_;
+  std::vector<DirEntry> entries_;
+  int result_ = 0;
+  const char* syscall_ = "opendir";
+  std::string failed_path_;
+};
+
+DirWalker::DirWalker(Environment* env,
+                     Local<Object> obj,
+                     std::string root,
+                     enum encoding encoding,
+                     bool with_stats,
+                     size_t concurrency)
+    : AsyncWrap(env, obj, AsyncWrap::PROVIDER_DIRWALKER),
+      encoding_(encoding),
+      with_stats_(with_stats),
+      concurrency_(concurrency) {
+  MakeWeak();
+  pending_.push_back(std::move(root));
+}
+
+/*
+ * new DirWalker(path, encoding, withStats, concurrency)
+ * 0 path         the directory to walk
+ * 1 encoding     encoding of the paths and names passed to onbatch
+ * 2 withStats    whether to lstat() every entry
+ * 3 concurrency  uint32. how many directories may be scanned at once
+ *
+ * walker.onbatch(dir, entries, stats) is called once for every directory,
+ * with `entries` being a list of name and UV_DIRENT_* type pairs, and `stats`
+ * a Float64Array with the stats of every entry if requested.
+ * walker.oncomplete(err) is called once the walk has finished, failed, or
+ * has been stopped.
+ */
+void DirWalker::New(const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+  Isolate* isolate = env->isolate();
+  CHECK(args.IsConstructCall());
+  CHECK_GE(args.Length(), 4);
+
+  BufferValue path(isolate, args[0]);
+  CHECK_NOT_NULL(*path);
+  ToNamespacedPath(env, &path);
+  THROW_IF_INSUFFICIENT_PERMISSIONS(
+      env, permission::PermissionScope::kFileSystemRead, path.ToStringView());
+
+  const enum encoding encoding = ParseEncoding(isolate, args[1], UTF8);
+  const bool with_stats = args[2]->IsTrue();
+  CHECK(args[3]->IsUint32());
+  const uint32_t concurrency = args[3].As<Uint32>()->Value();
+  CHECK_GT(concurrency, 0);
+
+  new DirWalker(
+      env, args.This(), path.ToString(), encoding, with_stats, concurrency);
+}
+
+void DirWalker::Start(const FunctionCallbackInfo<Value>& args) {
+  DirWalker* walker;
+  ASSIGN_OR_RETURN_UNWRAP(&walker, args.This());
+  CHECK(!walker->started_);
+  walker->started_ = true;
+  walker->ScheduleScans();
+}
+
+// Directories that are being scanned are still reported, but no further
+// directories are scanned.
+void DirWalker::Stop(const FunctionCallbackInfo<Value>& args) {
+  DirWalker* walker;
+  ASSIGN_OR_RETURN_UNWRAP(&walker, args.This());
+  walker->stopped_ = true;
+  walker->pending_.clear();
+}
+
+void DirWalker::Fail(Local<Value> error) {
+  if (error_.IsEmpty()) error_.Reset(env()->isolate(), error);
+  stopped_ = true;
+  pending_.clear();
+}
+
+void DirWalker::ScheduleScans() {
+  while (!stopped_ && running_ < concurrency_ && !pending_.empty()) {
+    std::string path = std::move(pending_.front());
+    pending_.pop_front();
+    if (!env()->permission()->is_granted(
+            env(), permission::PermissionScope::kFileSystemRead, path))
+        [[unlikely]] {
+      Local<Value> error;
+      if (permission::CreateAccessDeniedError(
+              env(), permission::PermissionScope::kFileSystemRead, path)
+              .ToLocal(&error)) {
+        Fail(error);
+      } else {
+        stopped_ = true;
+        pending_.clear();
+      }
+      break;
+    }
+    running_++;
+    auto job = std::make_unique<ScanJob>(this, std::move(path));
+    job.release()->ScheduleWork();
+  }
+}
+
+void DirWalker::AfterScan(ScanJob* job, int status) {
+  Environment* env = this->env();
+  Isolate* isolate = env->isolate();
+  HandleScope handle_scope(isolate);
+  Context::Scope context_scope(env->context());
+  CHECK_GT(running_, 0);
+  running_--;
+
+  int err = status != 0 ? status : job->result();
+  if (err < 0) {
+    Fail(UVException(isolate,
+                     err,
+                     job->syscall(),
+                     nullptr,
+                     job->failed_path().c_str()));
+  } else if (!stopped_) {
+    const std::vector<DirEntry>& entries = job->entries();
+    constexpr size_t kFields =
+        static_cast<size_t>(fs::FsStatsOffset::kFsStatsFieldsNumber);
+    MaybeStackBuffer<Local<Value>, 64> values(entries.size() * 2);
+    AliasedFloat64Array stats(isolate, with_stats_ ? entries.size() * kFields
+                                                   : 0);
+    bool ok = true;
+    for (size_t i = 0; i < entries.size() && ok; i++) {
+      const DirEntry& entry = entries[i];
+      ok = StringBytes::Encode(
+               isolate, entry.name.data(), entry.name.size(), encoding_)
+               .ToLocal(&values[i * 2]);
+      values[i * 2 + 1] = Integer::New(isolate, entry.type);
+      if (with_stats_) fs::FillStatsArray(&stats, &entry.stat, i * kFields);
+      if (entry.type == UV_DIRENT_DIR)
+        pending_.push_back(JoinPath(job->path(), entry.name));
+    }
+
+    Local<Value> dir;
+    if (ok && StringBytes::Encode(isolate,
+                                  job->path().data(),
+                                  job->path().size(),
+                                  encoding_)
+                  .ToLocal(&dir)) {
+      Local<Value> argv[] = {
+          dir,
+          Array::New(isolate, values.out(), entries.size() * 2),
+          with_stats_ ? stats.GetJSArray().As<Value>()
+                      : Undefined(isolate).As<Value>(),
+      };
+      ok = !MakeCallback(env->onbatch_string(), arraysize(argv), argv)
+                .IsEmpty();
+    } else {
+      ok = false;
+    }
+    if (!ok) {
+      stopped_ = true;
+      pending_.clear();
+    }
+  }
+
+  ScheduleScans();
+  if (running_ > 0) return;
+
+  Local<Value> error = error_.IsEmpty() ? Null(isolate).As<Value>()
+                                        : error_.Get(isolate);
+  error_.Reset();
+  MakeCallback(env->oncomplete_string(), 1, &error);
+}
+
 void CreatePerIsolateProperties(IsolateData* isolate_data,
                                 Local<ObjectTemplate> target) {
   Isolate* isolate = isolate_data->isolate();
@@ -436,6 +744,16 @@ void CreatePerIsolateProperties(IsolateData* isolate_data,
   dirt->SetInternalFieldCount(DirHandle::kInternalFieldCount);
   SetConstructorFunction(isolate, target, "DirHandle", dir);
   isolate_data->set_dir_instance_template(dirt);
+
+  // Create FunctionTemplate for DirWalker
+  Local<FunctionTemplate> walker =
+      NewFunctionTemplate(isolate, DirWalker::New);
+  walker->Inherit(AsyncWrap::GetConstructorTemplate(isolate_data));
+  SetProtoMethod(isolate, walker, "start", DirWalker::Start);
+  SetProtoMethod(isolate, walker, "stop", DirWalker::Stop);
+  walker->InstanceTemplate()->SetInternalFieldCount(
+      DirWalker::kInternalFieldCount);
+  SetConstructorFunction(isolate, target, "DirWalker", walker);
 }
 
 void CreatePerContextProperties(Local<Object> target,
@@ -449,6 +767,9 @@ void RegisterExternalReferences(ExternalReferenceRegistry* registry) {
   registry->Register(DirHandle::New);
   registry->Register(DirHandle::Read);
   registry->Register(DirHandle::Close);
+  registry->Register(DirWalker::New);
+  registry->Register(DirWalker::Start);
+  registry->Register(DirWalker::Stop);
 }
 
 }  // namespace fs_dir
@@ -5,6 +5,10 @@
 
 #include "node_file.h"
 
+#include <deque>
+#include <string>
+#include <vector>
+
 namespace node {
 
 namespace fs_dir {
@@ -43,6 +47,68 @@ class DirHandle : public AsyncWrap {
   bool closed_ = false;
 };
 
+// An entry of a directory, as found by ReadDirEntries().
+struct DirEntry {
+  std::string name;
+  uv_dirent_type_t type;
+  // Only filled in by DirWalker, for entries that it lstat()s.
+  uv_stat_t stat;
+};
+
+// The number of entries that ReadDirEntries() reads with one
+// uv_fs_readdir() call.
+constexpr size_t kDirEntriesPerRead = 32;
+
+// Synchronously appends the entries of the directory at |path|, except for
+// "." and "..", to |entries|. Unlike uv_fs_scandir(), this does not hold a
+// second copy of every entry or sort them. Returns 0 or a libuv error code,
+// and sets |syscall| to the name of the call that failed.
+int ReadDirEntries(const char* path,
+                   std::vector<DirEntry>* entries,
+                   const char** syscall);
+
+// Walks a directory tree on the threadpool. Up to `concurrency` directories
+// are scanned at the same time, and the entries of each directory are passed
+// to the `onbatch` callback as soon as it has been read. Symbolic links are
+// not followed.
+class DirWalker final : public AsyncWrap {
+ public:
+  static void New(const v8::FunctionCallbackInfo<v8::Value>& args);
+  static void Start(const v8::FunctionCallbackInfo<v8::Value>& args);
+  static void Stop(const v8::FunctionCallbackInfo<v8::Value>& args);
+
+  SET_NO_MEMORY_INFO()
+  SET_MEMORY_INFO_NAME(DirWalker)
+  SET_SELF_SIZE(DirWalker)
+
+  DirWalker(const DirWalker&) = delete;
+  DirWalker& operator=(const DirWalker&) = delete;
+
+ private:
+  class ScanJob;
+
+  DirWalker(Environment* env,
+            v8::Local<v8::Object> obj,
+            std::string root,
+            enum encoding encoding,
+            bool with_stats,
+            size_t concurrency);
+
+  void ScheduleScans();
+  void AfterScan(ScanJob* job, int status);
+  void Fail(v8::Local<v8::Value> error);
+
+  // Directories that have been found but not scanned yet.
+  std::deque<std::string> pending_;
+  enum encoding encoding_;
+  bool with_stats_;
+  size_t concurrency_;
+  size_t running_ = 0;
+  bool started_ = false;
+  bool stopped_ = false;
+  v8::Global<v8::Value> error_;
+};
+
 }  // namespace fs_dir
 
 }  // namespace node
@@ -54,6 +54,7 @@ void FSReqBase::Init(const char* syscall,
                      enum encoding encoding) {
   syscall_ = syscall;
   encoding_ = encoding;
+  MarkScheduled();
 
   if (data != nullptr) {
     CHECK(!has_data_);
@@ -64,10 +65,16 @@ void FSReqBase::Init(const char* syscall,
   }
 }
 
+void FSReqBase::MarkScheduled() {
+  schedule_time_ =
+      env()->threadpool_work_limiter()->metrics_enabled() ? uv_hrtime() : 0;
+}
+
 FSReqBase::FSReqBuffer&
 FSReqBase::Init(const char* syscall, size_t len, enum encoding encoding) {
   syscall_ = syscall;
   encoding_ = encoding;
+  MarkScheduled();
 
   buffer_.AllocateSufficientStorage(len + 1);
   has_data_ = false;  // so that the data does not show up in error messages
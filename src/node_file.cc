@@ -40,10 +40,13 @@
 #include "req_wrap-inl.h"
 #include "stream_base-inl.h"
 #include "string_bytes.h"
+#include "threadpoolwork-inl.h"
 #include "uv.h"
 #include "v8-fast-api-calls.h"
 
 #include <errno.h>
+#include <algorithm>
+#include <atomic>
 #include <cerrno>
 #include <cstdio>
 #include <filesystem>
@@ -55,6 +58,8 @@
 #ifdef _WIN32
 #include <windows.h>
 #else
+#include <sys/mman.h>
+#include <sys/uio.h>
 #include <unistd.h>
 #endif
 
@@ -63,15 +68,20 @@ namespace node {
 namespace fs {
 
 using v8::Array;
+using v8::ArrayBuffer;
+using v8::BackingStore;
 using v8::BigInt;
+using v8::CFunction;
 using v8::Context;
 using v8::EscapableHandleScope;
+using v8::FastApiCallbackOptions;
 using v8::FunctionCallbackInfo;
 using v8::FunctionTemplate;
 using v8::HandleScope;
 using v8::Int32;
 using v8::Integer;
 using v8::Isolate;
+using v8::Just;
 using v8::JustVoid;
 using v8::Local;
 using v8::LocalVector;
@@ -82,8 +92,10 @@ using v8::Number;
 using v8::Object;
 using v8::ObjectTemplate;
 using v8::Promise;
+using v8::SharedArrayBuffer;
 using v8::String;
 using v8::TryCatch;
+using v8::Uint32;
 using v8::Undefined;
 using v8::Value;
 
@@ -518,6 +530,125 @@ void FileHandle::ReleaseFD(const FunctionCallbackInfo<Value>& args) {
   fd->Release();
 }
 
+// The access patterns that FileHandle::Mmap() can pass on to madvise(2).
+// Exposed to JS as kMmapAdvice* constants.
+enum MmapAdvice : int32_t {
+  kMmapAdviceNormal,
+  kMmapAdviceSequential,
+  kMmapAdviceRandom,
+  kMmapAdviceWillNeed,
+};
+
+/*
+ * FileHandle.prototype.mmap(offset, length, advice, shared)
+ * 0 offset  int64. position in the file at which the mapping starts
+ * 1 length  int64. number of bytes to map, or -1 to map until the end of
+ *           the file. Mappings never extend past the end of the file, as
+ *           touching those pages would raise SIGBUS, so the length is
+ *           clamped to what the file holds after offset.
+ * 2 advice  int32. one of the kMmapAdvice* constants
+ * 3 shared  whether to return a SharedArrayBuffer
+ *
+ * The pages are mapped copy-on-write: they are read from the file lazily and
+ * shared with every other mapping of the same file, and writes through the
+ * returned buffer never reach the file.
+ */
+void FileHandle::Mmap(const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+  Isolate* isolate = env->isolate();
+  FileHandle* fd;
+  ASSIGN_OR_RETURN_UNWRAP(&fd, args.This());
+
+  CHECK(IsSafeJsInt(args[0]));
+  const int64_t offset = args[0].As<Integer>()->Value();
+  CHECK_GE(offset, 0);
+  CHECK(IsSafeJsInt(args[1]));
+  int64_t length = args[1].As<Integer>()->Value();
+  CHECK(args[2]->IsInt32());
+  const int32_t advice = args[2].As<Int32>()->Value();
+  const bool shared = args[3]->IsTrue();
+
+  if (!fd->IsAlive() || fd->IsClosing())
+    return env->ThrowUVException(UV_EBADF, "mmap");
+
+#if defined(_WIN32) || defined(V8_ENABLE_SANDBOX)
+  // On Windows this would need CreateFileMapping(), and with the V8 sandbox
+  // enabled, ArrayBuffers cannot point to memory outside of the sandbox.
+  return env->ThrowUVException(UV_ENOTSUP, "mmap");
+#else
+  uv_fs_t req;
+  int err = uv_fs_fstat(nullptr, &req, fd->fd_, nullptr);
+  int64_t size = static_cast<int64_t>(req.statbuf.st_size);
+  uv_fs_req_cleanup(&req);
+  if (err < 0) return env->ThrowUVException(err, "fstat");
+  const int64_t available = std::max<int64_t>(size - offset, 0);
+  if (length < 0 || length > available) length = available;
+
+  if (length == 0) {
+    if (shared) {
+      args.GetReturnValue().Set(SharedArrayBuffer::New(isolate, 0));
+    } else {
+      args.GetReturnValue().Set(ArrayBuffer::New(isolate, 0));
+    }
+    return;
+  }
+
+  // mmap() requires the offset to be page-aligned, so map from the start of
+  // the page that contains it.
+  struct Mapping {
+    void* base;
+    size_t length;
+  };
+  const int64_t page_size = sysconf(_SC_PAGESIZE);
+  const int64_t aligned_offset = offset - offset % page_size;
+  const size_t delta = static_cast<size_t>(offset - aligned_offset);
+  Mapping* mapping = new Mapping{nullptr, static_cast<size_t>(length) + delta};
+  mapping->base = mmap(nullptr,
+                       mapping->length,
+                       PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE,
+                       fd->fd_,
+                       aligned_offset);
+  if (mapping->base == MAP_FAILED) {
+    int err = uv_translate_sys_error(errno);
+    delete mapping;
+    return env->ThrowUVException(err, "mmap");
+  }
+
+  int madv = MADV_NORMAL;
+  switch (advice) {
+    case kMmapAdviceSequential:
+      madv = MADV_SEQUENTIAL;
+      break;
+    case kMmapAdviceRandom:
+      madv = MADV_RANDOM;
+      break;
+    case kMmapAdviceWillNeed:
+      madv = MADV_WILLNEED;
+      break;
+  }
+  // The advice is only a hint, so failing to apply it is not an error.
+  if (madv != MADV_NORMAL) USE(madvise(mapping->base, mapping->length, madv));
+
+  char* data = static_cast<char*>(mapping->base) + delta;
+  auto unmap = [](void* data, size_t length, void* deleter_data) {
+    Mapping* mapping = static_cast<Mapping*>(deleter_data);
+    CHECK_EQ(munmap(mapping->base, mapping->length), 0);
+    delete mapping;
+  };
+  if (shared) {
+    std::unique_ptr<BackingStore> store = SharedArrayBuffer::NewBackingStore(
+        data, static_cast<size_t>(length), unmap, mapping);
+    args.GetReturnValue().Set(
+        SharedArrayBuffer::New(isolate, std::move(store)));
+  } else {
+    std::unique_ptr<BackingStore> store = ArrayBuffer::NewBackingStore(
+        data, static_cast<size_t>(length), unmap, mapping);
+    args.GetReturnValue().Set(ArrayBuffer::New(isolate, std::move(store)));
+  }
+#endif  // defined(_WIN32) || defined(V8_ENABLE_SANDBOX)
+}
+
 int FileHandle::Release() {
   int fd = GetFD();
   // Just pretend that Close was called and we're all done.
@@ -528,6 +659,7 @@ int FileHandle::Release() {
 void FileHandle::AfterClose() {
   closing_ = false;
   closed_ = true;
+  binding_data_->nowait_unsupported_fds.erase(fd_);
   fd_ = -1;
   if (reading_ && !persistent().IsEmpty())
     EmitRead(UV_EOF);
@@ -587,7 +719,7 @@ int FileHandle::ReadStart() {
       read_wrap = MakeDetachedBaseObject<FileHandleReadWrap>(this, wrap_obj);
     }
   }
-  int64_t recommended_read = 65536;
+  int64_t recommended_read = read_chunk_size_;
   if (read_length_ >= 0 && read_length_ <= recommended_read)
     recommended_read = read_length_;
 
@@ -660,6 +792,15 @@ int FileHandle::ReadStart() {
   return 0;
 }
 
+void FileHandle::AdvanceRead(int64_t bytes) {
+  CHECK_GE(bytes, 0);
+  if (read_offset_ >= 0) read_offset_ += bytes;
+  if (read_length_ >= 0) {
+    CHECK_LE(bytes, read_length_);
+    read_length_ -= bytes;
+  }
+}
+
 int FileHandle::ReadStop() {
   reading_ = false;
   return 0;
@@ -735,6 +876,8 @@ FSReqAfterScope::FSReqAfterScope(FSReqBase* wrap, uv_fs_t* req)
       handle_scope_(wrap->env()->isolate()),
       context_scope_(wrap->env()->context()) {
   CHECK_EQ(wrap_->req(), req);
+  wrap->env()->threadpool_work_limiter()->RecordLatency(
+      ThreadPoolWorkClass::kFs, wrap->schedule_time());
 }
 
 FSReqAfterScope::~FSReqAfterScope() {
@@ -1003,6 +1146,7 @@ void Close(const FunctionCallbackInfo<Value>& args) {
     return;
   }
   env->RemoveUnmanagedFd(fd);
+  Realm::GetBindingData<BindingData>(args)->nowait_unsupported_fds.erase(fd);
 
   if (argc > 1) {  // close(fd, req)
     FSReqBase* req_wrap_async = GetReqWrap(args, 1);
@@ -1018,16 +1162,17 @@ void Close(const FunctionCallbackInfo<Value>& args) {
   }
 }
 
-static void ExistsSync(const FunctionCallbackInfo<Value>& args) {
-  Environment* env = Environment::GetCurrent(args);
-  Isolate* isolate = env->isolate();
-  CHECK_GE(args.Length(), 1);
-
-  BufferValue path(isolate, args[0]);
+// Shared by the slow and the fast path of existsSync(). Returns nothing
+// when the permission model denies access.
+static Maybe<bool> PathExists(Environment* env, Local<Value> path_value) {
+  BufferValue path(env->isolate(), path_value);
   CHECK_NOT_NULL(*path);
   ToNamespacedPath(env, &path);
   THROW_IF_INSUFFICIENT_PERMISSIONS(
-      env, permission::PermissionScope::kFileSystemRead, path.ToStringView());
+      env,
+      permission::PermissionScope::kFileSystemRead,
+      path.ToStringView(),
+      Nothing<bool>());
 
   uv_fs_t req;
   auto make = OnScopeLeave([&req]() { uv_fs_req_cleanup(&req); });
@@ -1046,20 +1191,37 @@ static void ExistsSync(const FunctionCallbackInfo<Value>& args) {
   }
 #endif  // _WIN32
 
-  args.GetReturnValue().Set(err == 0);
+  return Just(err == 0);
 }
 
+static void ExistsSync(const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+  CHECK_GE(args.Length(), 1);
+  bool exists;
+  if (PathExists(env, args[0]).To(&exists)) args.GetReturnValue().Set(exists);
+}
+
+static bool FastExistsSync(Local<Value> receiver,
+                           Local<Value> path,
+                           // NOLINTNEXTLINE(runtime/references) This is V8 api.
+                           FastApiCallbackOptions& options) {
+  TRACK_V8_FAST_API_CALL("fs.existsSync");
+  HandleScope scope(options.isolate);
+  return PathExists(Environment::GetCurrent(options.isolate), path)
+      .FromMaybe(false);
+}
+
+static CFunction fast_exists_sync(CFunction::Make(FastExistsSync));
+
 // Used to speed up module loading.  Returns 0 if the path refers to
 // a file, 1 when it's a directory or < 0 on error (usually -ENOENT.)
 // The speedup comes from not creating thousands of Stat and Error objects.
 // Do not expose this function through public API as it doesn't hold
 // Permission Model checks.
-static void InternalModuleStat(const FunctionCallbackInfo<Value>& args) {
-  Environment* env = Environment::GetCurrent(args);
-
-  CHECK_EQ(args.Length(), 1);
-  CHECK(args[0]->IsString());
-  BufferValue path(env->isolate(), args[0]);
+static int32_t InternalModuleStatImpl(Environment* env,
+                                      Local<Value> path_value) {
+  CHECK(path_value->IsString());
+  BufferValue path(env->isolate(), path_value);
   CHECK_NOT_NULL(*path);
   ToNamespacedPath(env, &path);
 
@@ -1070,10 +1232,29 @@ static void InternalModuleStat(const FunctionCallbackInfo<Value>& args) {
     rc = S_ISDIR(s->st_mode);
   }
   uv_fs_req_cleanup(&req);
+  return rc;
+}
+
+static void InternalModuleStat(const FunctionCallbackInfo<Value>& args) {
+  CHECK_EQ(args.Length(), 1);
+  args.GetReturnValue().Set(
+      InternalModuleStatImpl(Environment::GetCurrent(args), args[0]));
+}
 
-  args.GetReturnValue().Set(rc);
+static int32_t FastInternalModuleStat(
+    Local<Value> receiver,
+    Local<Value> path,
+    // NOLINTNEXTLINE(runtime/references) This is V8 api.
+    FastApiCallbackOptions& options) {
+  TRACK_V8_FAST_API_CALL("fs.internalModuleStat");
+  HandleScope scope(options.isolate);
+  return InternalModuleStatImpl(Environment::GetCurrent(options.isolate),
+                                path);
 }
 
+static CFunction fast_internal_module_stat(
+    CFunction::Make(FastInternalModuleStat));
+
 constexpr bool is_uv_error_except_no_entry(int result) {
   return result < 0 && result != UV_ENOENT;
 }
@@ -2732,6 +2913,202 @@ static void ReadFileUtf8(const FunctionCallbackInfo<Value>& args) {
   args.GetReturnValue().Set(val);
 }
 
+// Reads the whole contents of the file at `path` with blocking uv_fs_* calls.
+// Returns 0 or a libuv error code, in which case `syscall` is set to the name
+// of the call that failed.
+static int ReadWholeFile(const char* path,
+                         int flags,
+                         std::string* contents,
+                         const char** syscall) {
+  uv_fs_t req;
+  *syscall = "open";
+  uv_file file = uv_fs_open(nullptr, &req, path, flags, 0666, nullptr);
+  uv_fs_req_cleanup(&req);
+  if (file < 0) return file;
+
+  char buffer[8192];
+  uv_buf_t buf = uv_buf_init(buffer, sizeof(buffer));
+  int err = 0;
+  while (true) {
+    int r = uv_fs_read(nullptr, &req, file, &buf, 1, -1, nullptr);
+    uv_fs_req_cleanup(&req);
+    if (r < 0) {
+      *syscall = "read";
+      err = r;
+      break;
+    }
+    if (r == 0) break;
+    contents->append(buf.base, r);
+  }
+
+  CHECK_EQ(0, uv_fs_close(nullptr, &req, file, nullptr));
+  uv_fs_req_cleanup(&req);
+  return err;
+}
+
+// State shared by the ReadFilesJobs of one fs.readFiles() call. The last job
+// to finish resolves the request.
+struct ReadFilesBatch {
+  struct File {
+    std::string path;
+    std::string contents;
+    int result = 0;
+    const char* syscall = nullptr;
+  };
+
+  BaseObjectPtr<FSReqBase> req_wrap;
+  std::vector<File> files;
+  int flags;
+  bool as_buffer;
+  size_t pending_jobs = 0;
+
+  void Resolve(Environment* env) {
+    Isolate* isolate = env->isolate();
+    HandleScope handle_scope(isolate);
+    Context::Scope context_scope(env->context());
+    auto detach = OnScopeLeave([&]() { req_wrap->Detach(); });
+
+    LocalVector<Value> results(isolate);
+    results.reserve(files.size());
+    for (const File& file : files) {
+      if (file.result < 0) {
+        results.push_back(UVException(
+            isolate, file.result, file.syscall, nullptr, file.path.c_str()));
+        continue;
+      }
+      Local<Value> value;
+      TryCatch try_catch(isolate);
+      if (as_buffer) {
+        Local<Object> buffer;
+        if (Buffer::Copy(isolate, file.contents.data(), file.contents.size())
+                .ToLocal(&buffer)) {
+          value = buffer;
+        }
+      } else {
+        USE(ToV8Value(env->context(), file.contents, isolate).ToLocal(&value));
+      }
+      if (value.IsEmpty()) {
+        // E.g. the file is larger than the largest possible string.
+        CHECK(try_catch.CanContinue());
+        return req_wrap->Reject(try_catch.Exception());
+      }
+      results.push_back(value);
+    }
+    req_wrap->Resolve(Array::New(isolate, results.data(), results.size()));
+  }
+};
+
+// Reads the files [begin, end) of a ReadFilesBatch on a threadpool thread.
+class ReadFilesJob final : public ThreadPoolWork {
+ public:
+  ReadFilesJob(Environment* env,
+               std::shared_ptr<ReadFilesBatch> batch,
+               size_t begin,
+               size_t end)
+      : ThreadPoolWork(env, "fs.readFiles", ThreadPoolWorkClass::kFs),
+        batch_(std::move(batch)),
+        begin_(begin),
+        end_(end) {}
+
+  void DoThreadPoolWork() override {
+    for (size_t i = begin_; i < end_; i++) {
+      ReadFilesBatch::File& file = batch_->files[i];
+      file.result = ReadWholeFile(
+          file.path.c_str(), batch_->flags, &file.contents, &file.syscall);
+      if (file.result < 0) file.contents.clear();
+    }
+  }
+
+  void AfterThreadPoolWork(int status) override {
+    std::unique_ptr<ReadFilesJob> self(this);
+    if (status != 0) {
+      for (size_t i = begin_; i < end_; i++) {
+        batch_->files[i].result = status;
+        batch_->files[i].syscall = "read";
+      }
+    }
+    CHECK_GT(batch_->pending_jobs, 0);
+    if (--batch_->pending_jobs == 0) batch_->Resolve(env());
+  }
+
+ private:
+  std::shared_ptr<ReadFilesBatch> batch_;
+  size_t begin_;
+  size_t end_;
+};
+
+// The number of threadpool requests that fs.readFiles() splits its files
+// into, matching the size of libuv's threadpool. Splitting further would
+// only add handoffs, since the requests would wait for a free thread anyway.
+static size_t ReadFilesMaxJobs() {
+  // Computed the way libuv does when it starts the threadpool.
+  static const size_t max_jobs = [] {
+    const char* value = getenv("UV_THREADPOOL_SIZE");
+    if (value == nullptr) return size_t{4};
+    return std::clamp<size_t>(static_cast<unsigned>(atoi(value)), 1, 1024);
+  }();
+  return max_jobs;
+}
+
+/*
+ * Reads several whole files in parallel on the threadpool.
+ *
+ * fs.readFiles(paths, flags, asBuffer, req)
+ * 0 paths     array of paths
+ * 1 flags     int32. flags used to open each file
+ * 2 asBuffer  whether contents are returned as Buffers instead of UTF-8
+ *             strings
+ * 3 req       FSReqCallback or kUsePromises
+ *
+ * The request is resolved with an array that has the contents of each
+ * file, or an error object for each file that could not be read.
+ */
+static void ReadFiles(const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+  Isolate* isolate = env->isolate();
+  Local<Context> context = env->context();
+
+  CHECK_GE(args.Length(), 4);
+  CHECK(args[0]->IsArray());
+  Local<Array> paths = args[0].As<Array>();
+  CHECK(args[1]->IsInt32());
+  const int flags = args[1].As<Int32>()->Value();
+  FSReqBase* req_wrap_async = GetReqWrap(args, 3);
+  CHECK_NOT_NULL(req_wrap_async);
+
+  auto batch = std::make_shared<ReadFilesBatch>();
+  batch->flags = flags;
+  batch->as_buffer = args[2]->IsTrue();
+  batch->files.resize(paths->Length());
+  for (uint32_t i = 0; i < batch->files.size(); i++) {
+    Local<Value> value;
+    if (!paths->Get(context, i).ToLocal(&value)) return;
+    BufferValue path(isolate, value);
+    CHECK_NOT_NULL(*path);
+    ToNamespacedPath(env, &path);
+    if (AsyncCheckOpenPermissions(env, req_wrap_async, path, flags)
+            .IsNothing()) {
+      return;
+    }
+    batch->files[i].path = path.ToString();
+  }
+
+  req_wrap_async->Init("readFiles", nullptr, 0, UTF8);
+  batch->req_wrap.reset(req_wrap_async);
+  req_wrap_async->SetReturnValue(args);
+
+  // An empty list still goes through the threadpool so that the callback is
+  // always called asynchronously.
+  size_t count = batch->files.size();
+  size_t jobs = std::clamp<size_t>(count, 1, ReadFilesMaxJobs());
+  batch->pending_jobs = jobs;
+  for (size_t i = 0; i < jobs; i++) {
+    auto job = std::make_unique<ReadFilesJob>(
+        env, batch, count * i / jobs, count * (i + 1) / jobs);
+    job.release()->ScheduleWork();
+  }
+}
+
 // Wrapper for readv(2).
 //
 // bytesRead = fs.readv(fd, buffers[, position], callback)
@@ -2781,6 +3158,510 @@ static void ReadBuffers(const FunctionCallbackInfo<Value>& args) {
   }
 }
 
+// Runs preadv2(2) or pwritev2(2), which take RWF_* flags per call. Where
+// those are not available, only flags of 0 are supported; the call then
+// falls back to libuv.
+static int PositionalIO(bool write,
+                        int fd,
+                        const uv_buf_t* bufs,
+                        size_t count,
+                        int64_t position,
+                        int flags) {
+#if defined(__linux__) && defined(RWF_NOWAIT)
+  static_assert(sizeof(uv_buf_t) == sizeof(struct iovec) &&
+                offsetof(uv_buf_t, base) == offsetof(struct iovec, iov_base) &&
+                offsetof(uv_buf_t, len) == offsetof(struct iovec, iov_len));
+  const struct iovec* iov = reinterpret_cast<const struct iovec*>(bufs);
+  ssize_t result;
+  do {
+    result = write ? pwritev2(fd, iov, count, position, flags)
+                   : preadv2(fd, iov, count, position, flags);
+  } while (result == -1 && errno == EINTR);
+  return result == -1 ? uv_translate_sys_error(errno)
+                      : static_cast<int>(result);
+#else
+  if (flags != 0) return UV_ENOSYS;
+  uv_fs_t req;
+  int result = write ? uv_fs_write(nullptr, &req, fd, bufs, count, position,
+                                   nullptr)
+                     : uv_fs_read(nullptr, &req, fd, bufs, count, position,
+                                  nullptr);
+  uv_fs_req_cleanup(&req);
+  return result;
+#endif
+}
+
+// The threadpool side of readBuffersWithFlags() and writeBuffersWithFlags().
+class FSPositionalIOJob final : public ThreadPoolWork {
+ public:
+  FSPositionalIOJob(Environment* env,
+                    FSReqBase* req_wrap,
+                    bool write,
+                    int fd,
+                    std::vector<uv_buf_t>&& bufs,
+                    std::vector<std::shared_ptr<BackingStore>>&& stores,
+                    int64_t position,
+                    int flags)
+      : ThreadPoolWork(env, write ? "fs.pwritev2" : "fs.preadv2",
+                       ThreadPoolWorkClass::kFs),
+        req_wrap_(req_wrap),
+        write_(write),
+        fd_(fd),
+        bufs_(std::move(bufs)),
+        stores_(std::move(stores)),
+        position_(position),
+        flags_(flags) {}
+
+  // With RWF_NOWAIT, the I/O is first tried on the calling thread, which
+  // succeeds when it can be served without blocking, e.g. from the page
+  // cache. Only otherwise is the threadpool used, without the flag. Either
+  // way, the request completes asynchronously. File systems and kernels
+  // that do not support the flag reject it; such a descriptor goes straight
+  // to the threadpool from then on, until it is closed.
+  void Start(BindingData* binding_data) {
+#if defined(RWF_NOWAIT)
+    if ((flags_ & RWF_NOWAIT) &&
+        binding_data->nowait_unsupported_fds.count(fd_) != 0) {
+      flags_ &= ~RWF_NOWAIT;
+    }
+    if (flags_ & RWF_NOWAIT) {
+      flags_ &= ~RWF_NOWAIT;
+      result_ = PositionalIO(write_,
+                             fd_,
+                             bufs_.data(),
+                             bufs_.size(),
+                             position_,
+                             flags_ | RWF_NOWAIT);
+      if (result_ == UV_ENOTSUP || result_ == UV_EINVAL ||
+          result_ == UV_ENOSYS) {
+        binding_data->nowait_unsupported_fds.insert(fd_);
+      } else if (result_ != UV_EAGAIN) {
+        // The I/O is done, so only the request has to outlive this job.
+        std::unique_ptr<FSPositionalIOJob> self(this);
+        env()->SetImmediate([req_wrap = req_wrap_,
+                             result = result_,
+                             write = write_](Environment* env) {
+          Settle(env, req_wrap.get(), result, write);
+        });
+        return;
+      }
+    }
+#endif
+    ScheduleWork();
+  }
+
+  void DoThreadPoolWork() override {
+    result_ = PositionalIO(
+        write_, fd_, bufs_.data(), bufs_.size(), position_, flags_);
+  }
+
+  void AfterThreadPoolWork(int status) override {
+    if (status != 0) result_ = status;
+    Finish();
+  }
+
+ private:
+  void Finish() {
+    std::unique_ptr<FSPositionalIOJob> self(this);
+    Settle(env(), req_wrap_.get(), result_, write_);
+  }
+
+  static void Settle(Environment* env,
+                     FSReqBase* req_wrap,
+                     int result,
+                     bool write) {
+    Isolate* isolate = env->isolate();
+    HandleScope handle_scope(isolate);
+    Context::Scope context_scope(env->context());
+    auto detach = OnScopeLeave([&]() { req_wrap->Detach(); });
+    if (result < 0) {
+      req_wrap->Reject(UVException(isolate, result, write ? "write" : "read"));
+    } else {
+      req_wrap->Resolve(Integer::New(isolate, result));
+    }
+  }
+
+  BaseObjectPtr<FSReqBase> req_wrap_;
+  const bool write_;
+  const int fd_;
+  std::vector<uv_buf_t> bufs_;
+  // Keep the buffers alive while the I/O is in flight.
+  std::vector<std::shared_ptr<BackingStore>> stores_;
+  const int64_t position_;
+  int flags_;
+  int result_ = 0;
+};
+
+// Like readBuffers() and writeBuffers(), with RWF_* flags:
+//
+// bytes = readBuffersWithFlags(fd, buffers, position, flags, req)
+// bytes = writeBuffersWithFlags(fd, buffers, position, flags, req)
+// 0 fd        integer. file descriptor
+// 1 buffers   array of buffers to read into or write from
+// 2 position  if integer, position to read or write at in the file.
+//             if null, use the current position
+// 3 flags     RWF_* flags, see preadv2(2)
+// 4 req       FSReqCallback or kUsePromises. if absent, the call is
+//             synchronous
+template <bool write>
+static void BuffersWithFlags(const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+  Isolate* isolate = env->isolate();
+
+  const int argc = args.Length();
+  CHECK_GE(argc, 4);
+
+  CHECK(args[0]->IsInt32());
+  const int fd = args[0].As<Int32>()->Value();
+
+  CHECK(args[1]->IsArray());
+  Local<Array> buffers = args[1].As<Array>();
+
+  int64_t pos = GetOffset(args[2]);
+
+  CHECK(args[3]->IsInt32());
+  const int flags = args[3].As<Int32>()->Value();
+
+  std::vector<uv_buf_t> bufs(buffers->Length());
+  std::vector<std::shared_ptr<BackingStore>> stores;
+  const bool async = argc > 4;
+  if (async) stores.reserve(bufs.size());
+  for (uint32_t i = 0; i < bufs.size(); i++) {
+    Local<Value> buffer;
+    if (!buffers->Get(env->context(), i).ToLocal(&buffer)) return;
+    CHECK(Buffer::HasInstance(buffer));
+    bufs[i] = uv_buf_init(Buffer::Data(buffer), Buffer::Length(buffer));
+    if (async) {
+      stores.push_back(
+          buffer.As<v8::ArrayBufferView>()->Buffer()->GetBackingStore());
+    }
+  }
+
+  const char* syscall = write ? "write" : "read";
+  if (async) {
+    FSReqBase* req_wrap_async = GetReqWrap(args, 4);
+    CHECK_NOT_NULL(req_wrap_async);
+    req_wrap_async->Init(syscall, nullptr, 0, UTF8);
+    auto job = std::make_unique<FSPositionalIOJob>(env,
+                                                   req_wrap_async,
+                                                   write,
+                                                   fd,
+                                                   std::move(bufs),
+                                                   std::move(stores),
+                                                   pos,
+                                                   flags);
+    job.release()->Start(Realm::GetBindingData<BindingData>(args));
+    req_wrap_async->SetReturnValue(args);
+    return;
+  }
+
+  int result = PositionalIO(write, fd, bufs.data(), bufs.size(), pos, flags);
+  if (result < 0) {
+    isolate->ThrowException(UVException(isolate, result, syscall));
+    return;
+  }
+  args.GetReturnValue().Set(result);
+}
+
+// Allocates a Buffer of the given size whose memory starts at a multiple of
+// the given alignment, as O_DIRECT I/O requires. The memory comes from a
+// larger ArrayBuffer, so it is managed like that of any other Buffer.
+//
+// buffer = allocateAligned(size, alignment)
+static void AllocateAligned(const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+  Isolate* isolate = env->isolate();
+
+  CHECK(IsSafeJsInt(args[0]));
+  CHECK(args[1]->IsUint32());
+  const int64_t size = args[0].As<Integer>()->Value();
+  const uint32_t alignment = args[1].As<Uint32>()->Value();
+  if (size < 0 || static_cast<uint64_t>(size) > Buffer::kMaxLength ||
+      alignment == 0 || (alignment & (alignment - 1)) != 0) {
+    return THROW_ERR_OUT_OF_RANGE(env, "Invalid size or alignment");
+  }
+
+  Local<ArrayBuffer> ab;
+  if (!ArrayBuffer::MaybeNew(isolate, static_cast<size_t>(size) + alignment - 1)
+           .ToLocal(&ab)) {
+    return THROW_ERR_MEMORY_ALLOCATION_FAILED(env);
+  }
+  uintptr_t data = reinterpret_cast<uintptr_t>(ab->Data());
+  size_t offset = (alignment - data % alignment) % alignment;
+  Local<Object> buffer;
+  if (Buffer::New(env, ab, offset, static_cast<size_t>(size))
+          .ToLocal(&buffer)) {
+    args.GetReturnValue().Set(buffer);
+  }
+}
+
+// The operations supported by fs.batch(). Exposed to JS as kBatch* constants.
+enum FSBatchOpType : int32_t {
+  kBatchStat,
+  kBatchLStat,
+  kBatchOpen,
+  kBatchClose,
+  kBatchRead,
+};
+
+// Runs a list of fs operations on a single threadpool thread and reports all
+// of the results to JS at once. Compared to issuing one FSReqCallback per
+// operation, this costs one JS -> C++ call, one threadpool handoff and one
+// completion callback for the whole batch.
+class FSBatchJob final : public ThreadPoolWork {
+ public:
+  struct Op {
+    FSBatchOpType type;
+    std::string path;
+    int fd = -1;
+    int flags = 0;
+    int mode = 0;
+    // For kBatchRead. The backing store keeps the target buffer alive.
+    std::shared_ptr<v8::BackingStore> store;
+    uv_buf_t buf;
+    int64_t position = -1;
+
+    int result = 0;
+    uv_stat_t stat;
+  };
+
+  FSBatchJob(Environment* env, FSReqBase* req_wrap, std::vector<Op>&& ops)
+      : ThreadPoolWork(env, "fs.batch", ThreadPoolWorkClass::kFs),
+        req_wrap_(req_wrap),
+        ops_(std::move(ops)) {}
+
+  void DoThreadPoolWork() override {
+    for (Op& op : ops_) {
+      uv_fs_t req;
+      switch (op.type) {
+        case kBatchStat:
+          op.result = uv_fs_stat(nullptr, &req, op.path.c_str(), nullptr);
+          if (op.result == 0) op.stat = req.statbuf;
+          break;
+        case kBatchLStat:
+          op.result = uv_fs_lstat(nullptr, &req, op.path.c_str(), nullptr);
+          if (op.result == 0) op.stat = req.statbuf;
+          break;
+        case kBatchOpen:
+          op.result = uv_fs_open(
+              nullptr, &req, op.path.c_str(), op.flags, op.mode, nullptr);
+          break;
+        case kBatchClose:
+          op.result = uv_fs_close(nullptr, &req, op.fd, nullptr);
+          break;
+        case kBatchRead:
+          op.result = uv_fs_read(
+              nullptr, &req, op.fd, &op.buf, 1, op.position, nullptr);
+          break;
+      }
+      uv_fs_req_cleanup(&req);
+    }
+  }
+
+  void AfterThreadPoolWork(int status) override {
+    std::unique_ptr<FSBatchJob> self(this);
+    Environment* env = this->env();
+    Isolate* isolate = env->isolate();
+    HandleScope handle_scope(isolate);
+    Context::Scope context_scope(env->context());
+    auto detach = OnScopeLeave([&]() { req_wrap_->Detach(); });
+
+    if (status != 0) {
+      req_wrap_->Reject(UVException(isolate, status, "batch"));
+      return;
+    }
+
+    Local<Value> results;
+    if (req_wrap_->use_bigint()) {
+      results = CreateResults<int64_t, v8::BigInt64Array>(env);
+    } else {
+      results = CreateResults<double, v8::Float64Array>(env);
+    }
+    if (!results.IsEmpty()) req_wrap_->Resolve(results);
+  }
+
+ private:
+  static const char* SyscallName(FSBatchOpType type) {
+    switch (type) {
+      case kBatchStat:
+        return "stat";
+      case kBatchLStat:
+        return "lstat";
+      case kBatchOpen:
+        return "open";
+      case kBatchClose:
+        return "close";
+      case kBatchRead:
+        return "read";
+    }
+    UNREACHABLE();
+  }
+
+  // Each element of the result is either an error, the stats array of a
+  // stat or lstat, the fd returned by an open, the number of bytes read by a
+  // read, or undefined for a close. The stats arrays share one ArrayBuffer.
+  template <typename NativeT, typename V8T>
+  Local<Value> CreateResults(Environment* env) {
+    Isolate* isolate = env->isolate();
+    constexpr size_t kFields =
+        static_cast<size_t>(FsStatsOffset::kFsStatsFieldsNumber);
+    size_t stat_count = 0;
+    for (const Op& op : ops_) {
+      if ((op.type == kBatchStat || op.type == kBatchLStat) && op.result == 0)
+        stat_count++;
+    }
+    AliasedBufferBase<NativeT, V8T> stats(isolate, stat_count * kFields);
+
+    LocalVector<Value> results(isolate);
+    results.reserve(ops_.size());
+    size_t stat_index = 0;
+    for (const Op& op : ops_) {
+      if (op.result < 0) {
+        results.push_back(UVException(isolate,
+                                      op.result,
+                                      SyscallName(op.type),
+                                      nullptr,
+                                      op.path.empty() ? nullptr
+                                                      : op.path.c_str()));
+        continue;
+      }
+      switch (op.type) {
+        case kBatchStat:
+        case kBatchLStat: {
+          size_t offset = stat_index++ * kFields;
+          FillStatsArray(&stats, &op.stat, offset);
+          results.push_back(V8T::New(
+              stats.GetArrayBuffer(), offset * sizeof(NativeT), kFields));
+          break;
+        }
+        case kBatchOpen:
+          env->AddUnmanagedFd(op.result);
+          results.push_back(Integer::New(isolate, op.result));
+          break;
+        case kBatchClose:
+          results.push_back(Undefined(isolate));
+          break;
+        case kBatchRead:
+          results.push_back(Integer::New(isolate, op.result));
+          break;
+      }
+    }
+    return Array::New(isolate, results.data(), results.size());
+  }
+
+  BaseObjectPtr<FSReqBase> req_wrap_;
+  std::vector<Op> ops_;
+};
+
+/*
+ * Runs several fs operations as one threadpool request.
+ *
+ * fs.batch(ops, useBigint, req)
+ * 0 ops        array of operations, each an array starting with its type:
+ *              [kBatchStat, path]
+ *              [kBatchLStat, path]
+ *              [kBatchOpen, path, flags, mode]
+ *              [kBatchClose, fd]
+ *              [kBatchRead, fd, buffer, offset, length, position]
+ * 1 useBigint  whether stats are returned as BigInt64Arrays
+ * 2 req        FSReqCallback or kUsePromises
+ *
+ * The request is resolved with an array that has one result per operation,
+ * or an error object for each operation that failed. The operations run one
+ * after another, in the order in which they are given.
+ */
+static void Batch(const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+  Isolate* isolate = env->isolate();
+  Local<Context> context = env->context();
+
+  CHECK_GE(args.Length(), 3);
+  CHECK(args[0]->IsArray());
+  Local<Array> list = args[0].As<Array>();
+  bool use_bigint = args[1]->IsTrue();
+  FSReqBase* req_wrap_async = GetReqWrap(args, 2, use_bigint);
+  CHECK_NOT_NULL(req_wrap_async);
+
+  std::vector<FSBatchJob::Op> ops(list->Length());
+  for (uint32_t i = 0; i < ops.size(); i++) {
+    FSBatchJob::Op& op = ops[i];
+    Local<Value> value;
+    if (!list->Get(context, i).ToLocal(&value)) return;
+    CHECK(value->IsArray());
+    Local<Array> entry = value.As<Array>();
+    Local<Value> fields[6];
+    std::fill(std::begin(fields), std::end(fields), Undefined(isolate));
+    for (uint32_t j = 0; j < arraysize(fields) && j < entry->Length(); j++) {
+      if (!entry->Get(context, j).ToLocal(&fields[j])) return;
+    }
+    CHECK(fields[0]->IsInt32());
+    op.type = static_cast<FSBatchOpType>(fields[0].As<Int32>()->Value());
+    switch (op.type) {
+      case kBatchStat:
+      case kBatchLStat:
+      case kBatchOpen: {
+        BufferValue path(isolate, fields[1]);
+        CHECK_NOT_NULL(*path);
+        ToNamespacedPath(env, &path);
+        if (op.type == kBatchOpen) {
+          CHECK(fields[2]->IsInt32());
+          CHECK(fields[3]->IsInt32());
+          op.flags = fields[2].As<Int32>()->Value();
+          op.mode = fields[3].As<Int32>()->Value();
+          if (AsyncCheckOpenPermissions(env, req_wrap_async, path, op.flags)
+                  .IsNothing()) {
+            return;
+          }
+        } else {
+          ASYNC_THROW_IF_INSUFFICIENT_PERMISSIONS(
+              env,
+              req_wrap_async,
+              permission::PermissionScope::kFileSystemRead,
+              path.ToStringView());
+        }
+        op.path = path.ToString();
+        break;
+      }
+      case kBatchClose:
+        CHECK(fields[1]->IsInt32());
+        op.fd = fields[1].As<Int32>()->Value();
+        break;
+      case kBatchRead: {
+        CHECK(fields[1]->IsInt32());
+        op.fd = fields[1].As<Int32>()->Value();
+        CHECK(Buffer::HasInstance(fields[2]));
+        Local<v8::ArrayBufferView> view = fields[2].As<v8::ArrayBufferView>();
+        size_t buffer_length = view->ByteLength();
+        CHECK(IsSafeJsInt(fields[3]));
+        const int64_t off = fields[3].As<Integer>()->Value();
+        CHECK_GE(off, 0);
+        CHECK_LE(static_cast<uint64_t>(off), buffer_length);
+        CHECK(fields[4]->IsInt32());
+        const size_t len = static_cast<size_t>(fields[4].As<Int32>()->Value());
+        CHECK(Buffer::IsWithinBounds(
+            static_cast<size_t>(off), len, buffer_length));
+        op.position = GetOffset(fields[5]);
+        op.store = view->Buffer()->GetBackingStore();
+        char* data = static_cast<char*>(op.store->Data()) + view->ByteOffset();
+        op.buf = uv_buf_init(data + off, len);
+        break;
+      }
+      default:
+        UNREACHABLE();
+    }
+  }
+
+  for (const FSBatchJob::Op& op : ops) {
+    if (op.type == kBatchClose) env->RemoveUnmanagedFd(op.fd);
+  }
+
+  req_wrap_async->Init("batch", nullptr, 0, UTF8);
+  auto job =
+      std::make_unique<FSBatchJob>(env, req_wrap_async, std::move(ops));
+  job.release()->ScheduleWork();
+  req_wrap_async->SetReturnValue(args);
+}
+
 
 /* fs.chmod(path, mode);
  * Wrapper for chmod(1) / EIO_CHMOD
@@ -3428,6 +4309,111 @@ bool isInsideDir(const std::filesystem::path& src,
   return std::equal(srcArr.begin(), srcArr.end(), destArr.begin());
 }
 
+// A regular file that CpSyncCopyDir() copies after walking the tree.
+struct CpFileJob {
+  std::string src;
+  std::string dest;
+  int result = 0;
+  // The syscall and path of the failure, if result is an error.
+  const char* syscall = nullptr;
+  const std::string* path = nullptr;
+};
+
+struct CpFileBatch {
+  std::vector<CpFileJob> jobs;
+  std::atomic<size_t> next{0};
+  // Set by the first job that fails. No job is started after that, as with
+  // the sequential copy, but the copies that are in flight still finish.
+  std::atomic<bool> stopped{false};
+  int copy_flags = 0;
+  bool skip_existing = false;
+  bool preserve_timestamps = false;
+
+  // Runs jobs until there are none left, or one of them has failed. This is
+  // called from several threads at once.
+  void Run() {
+    for (size_t i; !stopped.load(std::memory_order_relaxed) &&
+                   (i = next.fetch_add(1)) < jobs.size();) {
+      CpFileJob& job = jobs[i];
+      RunJob(&job);
+      if (job.result < 0) stopped.store(true, std::memory_order_relaxed);
+    }
+  }
+
+  void RunJob(CpFileJob* job) {
+    uv_fs_t req;
+    // With UV_FS_COPYFILE_FICLONE, libuv tries a reflink first and falls
+    // back to copy_file_range() or sendfile().
+    job->result = uv_fs_copyfile(nullptr,
+                                 &req,
+                                 job->src.c_str(),
+                                 job->dest.c_str(),
+                                 copy_flags,
+                                 nullptr);
+    uv_fs_req_cleanup(&req);
+    if (job->result == UV_EEXIST && skip_existing) {
+      job->result = 0;
+      return;
+    }
+    if (job->result < 0) {
+      job->syscall = "cp";
+      job->path = &job->dest;
+      return;
+    }
+    if (preserve_timestamps) CopyTimestamps(job);
+  }
+
+  static void CopyTimestamps(CpFileJob* job) {
+    uv_fs_t req;
+    job->result = uv_fs_stat(nullptr, &req, job->src.c_str(), nullptr);
+    uv_fs_req_cleanup(&req);
+    if (job->result < 0) {
+      job->syscall = "stat";
+      job->path = &job->src;
+      return;
+    }
+    const double atime =
+        req.statbuf.st_atim.tv_sec + req.statbuf.st_atim.tv_nsec / 1e9;
+    const double mtime =
+        req.statbuf.st_mtim.tv_sec + req.statbuf.st_mtim.tv_nsec / 1e9;
+    job->result =
+        uv_fs_utime(nullptr, &req, job->dest.c_str(), atime, mtime, nullptr);
+    uv_fs_req_cleanup(&req);
+    if (job->result < 0) {
+      job->syscall = "utime";
+      job->path = &job->dest;
+    }
+  }
+};
+
+// At most this many threads copy files for one CpSyncCopyDir() call,
+// including the calling thread.
+constexpr size_t kCpMaxThreads = 8;
+
+// The copies run on threads of their own rather than on the threadpool, so
+// that cpSync() neither waits behind queued threadpool work nor holds back
+// the asynchronous fs requests of other code while it blocks the event loop.
+// The ThreadPoolWorkLimiter does not limit fs work, so there is no budget to
+// take these threads from. The permission checks run while the tree is
+// walked, before any of the files is copied.
+static void RunCpFileBatch(CpFileBatch* batch) {
+  size_t thread_count = std::min<size_t>(
+      {batch->jobs.size(), uv_available_parallelism(), kCpMaxThreads});
+  std::vector<uv_thread_t> threads;
+  for (size_t i = 1; i < thread_count; i++) {
+    uv_thread_t thread;
+    if (uv_thread_create(
+            &thread,
+            [](void* data) { static_cast<CpFileBatch*>(data)->Run(); },
+            batch) != 0) {
+      break;
+    }
+    threads.push_back(thread);
+  }
+  batch->Run();
+  for (uv_thread_t& thread : threads) CHECK_EQ(uv_thread_join(&thread), 0);
+}
+
 static void CpSyncCopyDir(const FunctionCallbackInfo<Value>& args) {
   CHECK_EQ(args.Length(), 7);  // src, dest, force, dereference, errorOnExist,
                                // verbatimSymlinks, preserveTimestamps
@@ -3455,27 +4441,24 @@ static void CpSyncCopyDir(const FunctionCallbackInfo<Value>& args) {
     return env->ThrowStdErrException(error, "cp", *dest);
   }
 
-  auto file_copy_opts = std::filesystem::copy_options::recursive;
-  if (force) {
-    file_copy_opts |= std::filesystem::copy_options::overwrite_existing;
-  } else if (error_on_exist) {
-    file_copy_opts |= std::filesystem::copy_options::none;
-  } else {
-    file_copy_opts |= std::filesystem::copy_options::skip_existing;
-  }
+  // The directories and symlinks are created while walking the tree. The
+  // regular files are collected and copied in parallel afterwards.
+  CpFileBatch batch;
+  batch.copy_flags = UV_FS_COPYFILE_FICLONE;
+  if (!force) batch.copy_flags |= UV_FS_COPYFILE_EXCL;
+  batch.skip_existing = !force && !error_on_exist;
+  batch.preserve_timestamps = preserve_timestamps;
 
   std::function<bool(std::filesystem::path, std::filesystem::path)>
       copy_dir_contents;
   copy_dir_contents = [verbatim_symlinks,
                        &copy_dir_contents,
                        &env,
-                       file_copy_opts,
-                       preserve_timestamps,
+                       &batch,
                        force,
                        error_on_exist,
-                       dereference,
-                       &isolate](std::filesystem::path src,
-                                 std::filesystem::path dest) {
+                       dereference](std::filesystem::path src,
+                                    std::filesystem::path dest) {
     std::error_code error;
     for (auto dir_entry : std::filesystem::directory_iterator(src)) {
       auto dest_file_path = dest / dir_entry.path().filename();
@@ -3573,30 +4556,47 @@ static void CpSyncCopyDir(const FunctionCallbackInfo<Value>& args) {
           return false;
         }
       } else if (dir_entry.is_regular_file()) {
-        std::filesystem::copy_file(
-            dir_entry.path(), dest_file_path, file_copy_opts, error);
-        if (error) {
-          if (error.value() == EEXIST) {
-            THROW_ERR_FS_CP_EEXIST(isolate,
-                                   "[ERR_FS_CP_EEXIST]: Target already exists: "
-                                   "cp returned EEXIST (%s already exists)",
-                                   dest_file_path.c_str());
-            return false;
-          }
-          env->ThrowStdErrException(error, "cp", dest_str.c_str());
-          return false;
-        }
-
-        if (preserve_timestamps &&
-            !CopyUtimes(dir_entry.path(), dest_file_path, env)) {
-          return false;
-        }
+        auto src_file_path_str = PathToString(dir_entry.path());
+        auto dest_file_path_str = PathToString(dest_file_path);
+        THROW_IF_INSUFFICIENT_PERMISSIONS(
+            env,
+            permission::PermissionScope::kFileSystemRead,
+            src_file_path_str,
+            false);
+        THROW_IF_INSUFFICIENT_PERMISSIONS(
+            env,
+            permission::PermissionScope::kFileSystemWrite,
+            dest_file_path_str,
+            false);
+        batch.jobs.push_back({std::move(src_file_path_str),
+                              std::move(dest_file_path_str)});
       }
     }
     return true;
   };
 
-  copy_dir_contents(std::filesystem::path(*src), std::filesystem::path(*dest));
+  if (!copy_dir_contents(std::filesystem::path(*src),
+                         std::filesystem::path(*dest))) {
+    return;
+  }
+
+  RunCpFileBatch(&batch);
+
+  // Report the first failure in the order in which the tree was walked. The
+  // jobs that were not started because of an earlier failure have a result
+  // of 0.
+  for (const CpFileJob& job : batch.jobs) {
+    if (job.result == 0) continue;
+    if (job.result == UV_EEXIST) {
+      THROW_ERR_FS_CP_EEXIST(isolate,
+                             "[ERR_FS_CP_EEXIST]: Target already exists: "
+                             "cp returned EEXIST (%s already exists)",
+                             job.dest.c_str());
+      return;
+    }
+    return env->ThrowUVException(
+        job.result, job.syscall, nullptr, job.path->c_str());
+  }
 }
 
 BindingData::FilePathIsFileReturnType BindingData::FilePathIsFile(
@@ -3890,12 +4890,24 @@ static void CreatePerIsolateProperties(IsolateData* isolate_data,
             GetFormatOfExtensionlessFile);
   SetMethod(isolate, target, "access", Access);
   SetMethod(isolate, target, "close", Close);
-  SetMethod(isolate, target, "existsSync", ExistsSync);
+  SetFastMethod(
+      isolate, target, "existsSync", ExistsSync, &fast_exists_sync);
   SetMethod(isolate, target, "open", Open);
   SetMethod(isolate, target, "openFileHandle", OpenFileHandle);
   SetMethod(isolate, target, "read", Read);
   SetMethod(isolate, target, "readFileUtf8", ReadFileUtf8);
+  SetMethod(isolate, target, "readFiles", ReadFiles);
   SetMethod(isolate, target, "readBuffers", ReadBuffers);
+  SetMethod(isolate,
+            target,
+            "readBuffersWithFlags",
+            BuffersWithFlags<false>);
+  SetMethod(isolate,
+            target,
+            "writeBuffersWithFlags",
+            BuffersWithFlags<true>);
+  SetMethod(isolate, target, "allocateAligned", AllocateAligned);
+  SetMethod(isolate, target, "batch", Batch);
   SetMethod(isolate, target, "fdatasync", Fdatasync);
   SetMethod(isolate, target, "fsync", Fsync);
   SetMethod(isolate, target, "rename", Rename);
@@ -3904,7 +4916,11 @@ static void CreatePerIsolateProperties(IsolateData* isolate_data,
   SetMethod(isolate, target, "rmSync", RmSync);
   SetMethod(isolate, target, "mkdir", MKDir);
   SetMethod(isolate, target, "readdir", ReadDir);
-  SetMethod(isolate, target, "internalModuleStat", InternalModuleStat);
+  SetFastMethodNoSideEffect(isolate,
+                            target,
+                            "internalModuleStat",
+                            InternalModuleStat,
+                            &fast_internal_module_stat);
   SetMethod(isolate, target, "stat", Stat);
   SetMethod(isolate, target, "lstat", LStat);
   SetMethod(isolate, target, "fstat", FStat);
@@ -3944,6 +4960,19 @@ static void CreatePerIsolateProperties(IsolateData* isolate_data,
       FIXED_ONE_BYTE_STRING(isolate, "kFsStatsFieldsNumber"),
       Integer::New(isolate,
                    static_cast<int32_t>(FsStatsOffset::kFsStatsFieldsNumber)));
+#define V(name)                                                                \
+  target->Set(FIXED_ONE_BYTE_STRING(isolate, #name),                           \
+              Integer::New(isolate, name));
+  V(kBatchStat)
+  V(kBatchLStat)
+  V(kBatchOpen)
+  V(kBatchClose)
+  V(kBatchRead)
+  V(kMmapAdviceNormal)
+  V(kMmapAdviceSequential)
+  V(kMmapAdviceRandom)
+  V(kMmapAdviceWillNeed)
+#undef V
 
   // Create FunctionTemplate for FSReqCallback
   Local<FunctionTemplate> fst = NewFunctionTemplate(isolate, NewFSReqCallback);
@@ -3978,6 +5007,7 @@ static void CreatePerIsolateProperties(IsolateData* isolate_data,
   fd->Inherit(AsyncWrap::GetConstructorTemplate(isolate_data));
   SetProtoMethod(isolate, fd, "close", FileHandle::Close);
   SetProtoMethod(isolate, fd, "releaseFD", FileHandle::ReleaseFD);
+  SetProtoMethod(isolate, fd, "mmap", FileHandle::Mmap);
   Local<ObjectTemplate> fdt = fd->InstanceTemplate();
   fdt->SetInternalFieldCount(FileHandle::kInternalFieldCount);
   StreamBase::AddMethods(isolate_data, fd);
@@ -4016,11 +5046,18 @@ void RegisterExternalReferences(ExternalReferenceRegistry* registry) {
   registry->Register(GetFormatOfExtensionlessFile);
   registry->Register(Close);
   registry->Register(ExistsSync);
+  registry->Register(FastExistsSync);
+  registry->Register(fast_exists_sync.GetTypeInfo());
   registry->Register(Open);
   registry->Register(OpenFileHandle);
   registry->Register(Read);
   registry->Register(ReadFileUtf8);
+  registry->Register(ReadFiles);
   registry->Register(ReadBuffers);
+  registry->Register(BuffersWithFlags<false>);
+  registry->Register(BuffersWithFlags<true>);
+  registry->Register(AllocateAligned);
+  registry->Register(Batch);
   registry->Register(Fdatasync);
   registry->Register(Fsync);
   registry->Register(Rename);
@@ -4030,6 +5067,8 @@ void RegisterExternalReferences(ExternalReferenceRegistry* registry) {
   registry->Register(MKDir);
   registry->Register(ReadDir);
   registry->Register(InternalModuleStat);
+  registry->Register(FastInternalModuleStat);
+  registry->Register(fast_internal_module_stat.GetTypeInfo());
   registry->Register(Stat);
   registry->Register(LStat);
   registry->Register(FStat);
@@ -4066,6 +5105,7 @@ void RegisterExternalReferences(ExternalReferenceRegistry* registry) {
   registry->Register(FileHandle::New);
   registry->Register(FileHandle::Close);
   registry->Register(FileHandle::ReleaseFD);
+  registry->Register(FileHandle::Mmap);
   StreamBase::RegisterExternalReferences(registry);
 }
 
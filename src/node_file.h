@@ -3,13 +3,18 @@
 
 #if defined(NODE_WANT_INTERNALS) && NODE_WANT_INTERNALS
 
+#include <memory>
 #include <optional>
+#include <unordered_map>
+#include <unordered_set>
 #include "aliased_buffer.h"
 #include "node_messaging.h"
 #include "node_snapshotable.h"
 #include "stream_base.h"
 
 namespace node {
+class StatPoller;
+
 namespace fs {
 
 class FileHandleReadWrap;
@@ -83,6 +88,15 @@ class BindingData : public SnapshotableObject {
   std::vector<BaseObjectPtr<FileHandleReadWrap>>
       file_handle_read_wrap_freelist;
 
+  // The pollers that StatWatchers share under --shared-stat-polling, by
+  // interval.
+  std::unordered_map<uint32_t, std::weak_ptr<StatPoller>> stat_pollers;
+
+  // Descriptors whose file system rejected RWF_NOWAIT, so that async
+  // readBuffersWithFlags() and writeBuffersWithFlags() calls on them go
+  // straight to the threadpool. Entries are removed when the fd is closed.
+  std::unordered_set<int> nowait_unsupported_fds;
+
   SERIALIZABLE_OBJECT_METHODS()
   SET_BINDING_ID(fs_binding_data)
 
@@ -162,6 +176,9 @@ class FSReqBase : public ReqWrap<uv_fs_t> {
   bool use_bigint() const { return use_bigint_; }
   bool is_plain_open() const { return is_plain_open_; }
   bool with_file_types() const { return with_file_types_; }
+  // The uv_hrtime() at which the request was initialized, or 0 if threadpool
+  // metrics were not enabled at that point.
+  uint64_t schedule_time() const { return schedule_time_; }
 
   void set_is_plain_open(bool value) { is_plain_open_ = value; }
   void set_with_file_types(bool value) { with_file_types_ = value; }
@@ -185,6 +202,8 @@ class FSReqBase : public ReqWrap<uv_fs_t> {
   BindingData* binding_data();
 
  private:
+  inline void MarkScheduled();
+
   std::unique_ptr<FSContinuationData> continuation_data_;
   enum encoding encoding_ = UTF8;
   bool has_data_ = false;
@@ -192,6 +211,7 @@ class FSReqBase : public ReqWrap<uv_fs_t> {
   bool is_plain_open_ = false;
   bool with_file_types_ = false;
   const char* syscall_ = nullptr;
+  uint64_t schedule_time_ = 0;
 
   BaseObjectPtr<BindingData> binding_data_;
 
@@ -346,10 +366,26 @@ class FileHandle final : public AsyncWrap, public StreamBase {
   // Releases ownership of the FD.
   static void ReleaseFD(const v8::FunctionCallbackInfo<v8::Value>& args);
 
+  // Maps a range of the file into memory and returns it as an ArrayBuffer,
+  // or a SharedArrayBuffer that can be shared with other threads. The mapping
+  // stays valid after the FileHandle is closed.
+  static void Mmap(const v8::FunctionCallbackInfo<v8::Value>& args);
+
   // StreamBase interface:
   int ReadStart() override;
   int ReadStop() override;
 
+  // The position and the number of bytes left of the range that ReadStart()
+  // reads from. -1 stands for the current file position and for reading
+  // until EOF, respectively.
+  int64_t read_offset() const { return read_offset_; }
+  int64_t read_length() const { return read_length_; }
+  // Skips over `bytes` of that range after they were consumed without going
+  // through ReadStart(), e.g. by a StreamPipe that uses sendfile().
+  void AdvanceRead(int64_t bytes);
+  // The size of the buffers ReadStart() asks its listener for.
+  void set_read_chunk_size(size_t size) { read_chunk_size_ = size; }
+
   bool IsAlive() override { return !closed_; }
   bool IsClosing() override { return closing_; }
   AsyncWrap* GetAsyncWrap() override { return this; }
@@ -443,6 +479,7 @@ class FileHandle final : public AsyncWrap, public StreamBase {
   bool reading_ = false;
   int64_t read_offset_ = -1;
   int64_t read_length_ = -1;
+  size_t read_chunk_size_ = 65536;
 
   BaseObjectPtr<FileHandleReadWrap> current_read_;
 
@@ -0,0 +1,301 @@
+#include "node_fs_watcher.h"
+#include "uv.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__linux__)
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/fanotify.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace node {
+namespace fs_watcher {
+
+void EventBatch::Add(std::string_view filename, int events) {
+  auto [it, inserted] = index_.try_emplace(std::string(filename),
+                                           events_.size());
+  if (inserted) {
+    events_.emplace_back(it->first, events);
+  } else {
+    events_[it->second].second |= events;
+  }
+}
+
+std::vector<EventBatch::Event> EventBatch::Take() {
+  std::vector<Event> events = std::move(events_);
+  events_.clear();
+  index_.clear();
+  return events;
+}
+
+RecursiveWatcher::~RecursiveWatcher() {
+#if defined(__linux__)
+  if (fd_ != -1) close(fd_);
+  if (mount_fd_ != -1) close(mount_fd_);
+#endif
+}
+
+#if defined(__linux__)
+
+namespace {
+
+// The same events that libuv watches for.
+constexpr uint32_t kInotifyMask = IN_ATTRIB | IN_CREATE | IN_MODIFY |
+                                  IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO;
+
+int InotifyEvents(uint32_t mask) {
+  int events = 0;
+  if (mask & (IN_ATTRIB | IN_MODIFY)) events |= UV_CHANGE;
+  if (mask & ~(IN_ATTRIB | IN_MODIFY)) events |= UV_RENAME;
+  return events;
+}
+
+std::string JoinPath(const std::string& dir, std::string_view name) {
+  if (dir.empty()) return std::string(name);
+  std::string path = dir;
+  path += '/';
+  path += name;
+  return path;
+}
+
+bool IsSameOrBelow(const std::string& path, const std::string& dir) {
+  return path.size() >= dir.size() &&
+         path.compare(0, dir.size(), dir) == 0 &&
+         (path.size() == dir.size() || path[dir.size()] == '/');
+}
+
+}  // namespace
+
+int RecursiveWatcher::Start(const char* root) {
+  if (fd_ != -1) return UV_EBUSY;
+  char resolved[PATH_MAX];
+  if (realpath(root, resolved) == nullptr)
+    return uv_translate_sys_error(errno);
+  struct stat st;
+  if (stat(resolved, &st) != 0) return uv_translate_sys_error(errno);
+  if (!S_ISDIR(st.st_mode)) return UV_ENOTDIR;
+  root_ = resolved;
+
+  int err = StartFanotify();
+  if (err == 0) return 0;
+  // fanotify needs CAP_SYS_ADMIN to watch a file system, which most
+  // processes lack.
+  return StartInotify();
+}
+
+int RecursiveWatcher::StartFanotify() {
+#if defined(FAN_REPORT_DFID_NAME)
+  int fd = fanotify_init(FAN_CLASS_NOTIF | FAN_REPORT_DFID_NAME |
+                             FAN_NONBLOCK | FAN_CLOEXEC,
+                         O_RDONLY | O_CLOEXEC);
+  if (fd == -1) return uv_translate_sys_error(errno);
+  constexpr uint64_t kMask = FAN_ATTRIB | FAN_CREATE | FAN_MODIFY |
+                             FAN_DELETE | FAN_MOVED_FROM | FAN_MOVED_TO |
+                             FAN_ONDIR;
+  int mount_fd = open(root_.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  if (mount_fd == -1 ||
+      fanotify_mark(fd,
+                    FAN_MARK_ADD | FAN_MARK_FILESYSTEM,
+                    kMask,
+                    AT_FDCWD,
+                    root_.c_str()) != 0) {
+    int err = uv_translate_sys_error(errno);
+    if (mount_fd != -1) close(mount_fd);
+    close(fd);
+    return err;
+  }
+  fd_ = fd;
+  mount_fd_ = mount_fd;
+  fanotify_ = true;
+  return 0;
+#else
+  return UV_ENOSYS;
+#endif
+}
+
+int RecursiveWatcher::StartInotify() {
+  int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if (fd == -1) return uv_translate_sys_error(errno);
+  fd_ = fd;
+  int err = AddWatches(std::string(), nullptr);
+  if (err != 0) {
+    close(fd_);
+    fd_ = -1;
+    watches_.clear();
+  }
+  return err;
+}
+
+int RecursiveWatcher::AddWatches(const std::string& dir, const Callback* cb) {
+  std::vector<std::string> pending = {dir};
+  while (!pending.empty()) {
+    std::string current = std::move(pending.back());
+    pending.pop_back();
+    std::string path = JoinPath(root_, current);
+    int wd = inotify_add_watch(
+        fd_, path.c_str(), kInotifyMask | IN_ONLYDIR | IN_DONT_FOLLOW);
+    if (wd == -1) {
+      // The directory was removed or replaced before we got to it, which
+      // the events of its parent tell about.
+      if (errno == ENOENT || errno == ENOTDIR) continue;
+      return uv_translate_sys_error(errno);
+    }
+    watches_[wd] = current;
+
+    DIR* entries = opendir(path.c_str());
+    if (entries == nullptr) continue;
+    while (struct dirent* entry = readdir(entries)) {
+      if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0)
+        continue;
+      std::string name = JoinPath(current, entry->d_name);
+      // Files in directories that appeared after the root was watched may
+      // have been created before their directory was, so report them.
+      if (cb != nullptr) (*cb)(name, UV_RENAME);
+      bool is_dir = entry->d_type == DT_DIR;
+      if (entry->d_type == DT_UNKNOWN) {
+        struct stat st;
+        is_dir = lstat(JoinPath(root_, name).c_str(), &st) == 0 &&
+                 S_ISDIR(st.st_mode);
+      }
+      if (is_dir) pending.push_back(std::move(name));
+    }
+    closedir(entries);
+  }
+  return 0;
+}
+
+void RecursiveWatcher::RemoveWatches(const std::string& dir) {
+  for (auto it = watches_.begin(); it != watches_.end();) {
+    if (IsSameOrBelow(it->second, dir)) {
+      inotify_rm_watch(fd_, it->first);
+      it = watches_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
+int RecursiveWatcher::ReadEvents(const Callback& cb) {
+  if (fd_ == -1) return UV_EBADF;
+  return fanotify_ ? ReadFanotifyEvents(cb) : ReadInotifyEvents(cb);
+}
+
+int RecursiveWatcher::ReadInotifyEvents(const Callback& cb) {
+  alignas(struct inotify_event) char buf[16 * 1024];
+  for (;;) {
+    ssize_t size = read(fd_, buf, sizeof(buf));
+    if (size == -1) {
+      if (errno == EINTR) continue;
+      if (errno == EAGAIN || errno == EWOULDBLOCK) return 0;
+      return uv_translate_sys_error(errno);
+    }
+
+    for (char* p = buf; p < buf + size;) {
+      const struct inotify_event* event =
+          reinterpret_cast<const struct inotify_event*>(p);
+      p += sizeof(*event) + event->len;
+
+      if (event->mask & IN_Q_OVERFLOW) {
+        cb("", UV_RENAME);
+        continue;
+      }
+      auto it = watches_.find(event->wd);
+      if (it == watches_.end()) continue;
+      if (event->mask & IN_IGNORED) {
+        watches_.erase(it);
+        continue;
+      }
+      if (event->len == 0) continue;
+
+      std::string name = JoinPath(it->second, event->name);
+      cb(name, InotifyEvents(event->mask));
+      if (!(event->mask & IN_ISDIR)) continue;
+      if (event->mask & (IN_MOVED_FROM | IN_DELETE)) {
+        RemoveWatches(name);
+      } else if (event->mask & (IN_CREATE | IN_MOVED_TO)) {
+        int err = AddWatches(name, &cb);
+        if (err != 0) return err;
+      }
+    }
+  }
+}
+
+int RecursiveWatcher::ReadFanotifyEvents(const Callback& cb) {
+#if defined(FAN_REPORT_DFID_NAME)
+  alignas(struct fanotify_event_metadata) char buf[16 * 1024];
+  for (;;) {
+    ssize_t size = read(fd_, buf, sizeof(buf));
+    if (size == -1) {
+      if (errno == EINTR) continue;
+      if (errno == EAGAIN || errno == EWOULDBLOCK) return 0;
+      return uv_translate_sys_error(errno);
+    }
+
+    const struct fanotify_event_metadata* event =
+        reinterpret_cast<const struct fanotify_event_metadata*>(buf);
+    for (; FAN_EVENT_OK(event, size); event = FAN_EVENT_NEXT(event, size)) {
+      if (event->mask & FAN_Q_OVERFLOW) {
+        cb("", UV_RENAME);
+        continue;
+      }
+      if (event->event_len <= event->metadata_len) continue;
+      const struct fanotify_event_info_fid* info =
+          reinterpret_cast<const struct fanotify_event_info_fid*>(
+              reinterpret_cast<const char*>(event) + event->metadata_len);
+      if (info->hdr.info_type != FAN_EVENT_INFO_TYPE_DFID_NAME) continue;
+      struct file_handle* handle = reinterpret_cast<struct file_handle*>(
+          const_cast<unsigned char*>(info->handle));
+      const char* name =
+          reinterpret_cast<const char*>(handle->f_handle) +
+          handle->handle_bytes;
+
+      // The event names a directory through its file handle. Find out where
+      // that directory is, and drop the events from outside of the tree.
+      int dir_fd = open_by_handle_at(mount_fd_, handle, O_PATH | O_CLOEXEC);
+      if (dir_fd == -1) continue;
+      char link[64];
+      snprintf(link, sizeof(link), "/proc/self/fd/%d", dir_fd);
+      char dir[PATH_MAX];
+      ssize_t dir_len = readlink(link, dir, sizeof(dir));
+      close(dir_fd);
+      if (dir_len <= 0 || static_cast<size_t>(dir_len) >= sizeof(dir))
+        continue;
+      std::string path(dir, dir_len);
+      if (!IsSameOrBelow(path, root_)) continue;
+      path.erase(0, std::min(path.size(), root_.size() + 1));
+      if (strcmp(name, ".") != 0) path = JoinPath(path, name);
+
+      int events = 0;
+      if (event->mask & (FAN_ATTRIB | FAN_MODIFY)) events |= UV_CHANGE;
+      if (event->mask & ~(FAN_ATTRIB | FAN_MODIFY | FAN_ONDIR))
+        events |= UV_RENAME;
+      cb(path, events);
+    }
+  }
+#else
+  return UV_ENOSYS;
+#endif
+}
+
+#else  // !defined(__linux__)
+
+int RecursiveWatcher::Start(const char* root) {
+  return UV_ENOSYS;
+}
+
+int RecursiveWatcher::ReadEvents(const Callback& cb) {
+  return UV_ENOSYS;
+}
+
+#endif  // defined(__linux__)
+
+}  // namespace fs_watcher
+}  // namespace node
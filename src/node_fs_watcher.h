@@ -0,0 +1,90 @@
+#ifndef SRC_NODE_FS_WATCHER_H_
+#define SRC_NODE_FS_WATCHER_H_
+
+#if defined(NODE_WANT_INTERNALS) && NODE_WANT_INTERNALS
+
+#include <functional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace node {
+namespace fs_watcher {
+
+// Collects file system events, merging the events for the same filename
+// into one entry. Entries keep the order in which their filenames were
+// first seen. Events are UV_RENAME and UV_CHANGE flags.
+class EventBatch {
+ public:
+  using Event = std::pair<std::string, int>;
+
+  void Add(std::string_view filename, int events);
+  std::vector<Event> Take();
+
+  bool empty() const { return events_.empty(); }
+  size_t size() const { return events_.size(); }
+
+ private:
+  std::vector<Event> events_;
+  std::unordered_map<std::string, size_t> index_;
+};
+
+// Watches a directory tree through a single file descriptor, which becomes
+// readable when there are events. On Linux, the whole file system holding
+// the tree is watched through fanotify when the process is allowed to do
+// so, which needs no per-directory state. Otherwise, an inotify watch is
+// added for every directory, and for directories as they get created or
+// moved into the tree. Other platforms are not supported, as libuv already
+// watches trees natively there.
+//
+// Filenames are reported relative to the root, with an empty filename for
+// the root itself. When the kernel dropped events, the root is reported as
+// renamed, meaning that the tree has to be rescanned.
+class RecursiveWatcher {
+ public:
+  using Callback = std::function<void(std::string_view filename, int events)>;
+
+  RecursiveWatcher() = default;
+  ~RecursiveWatcher();
+  RecursiveWatcher(const RecursiveWatcher&) = delete;
+  RecursiveWatcher& operator=(const RecursiveWatcher&) = delete;
+
+  // Returns 0 or a libuv error code, UV_ENOSYS outside of Linux.
+  int Start(const char* root);
+
+  // Reads the pending events without blocking, calling cb for each of them.
+  // Returns 0 or a libuv error code.
+  int ReadEvents(const Callback& cb);
+
+  int fd() const { return fd_; }
+  bool uses_fanotify() const { return fanotify_; }
+  // The number of inotify watches in use.
+  size_t watch_count() const { return watches_.size(); }
+
+ private:
+  int StartFanotify();
+  int StartInotify();
+  // Watches the directory at the given path relative to the root, and the
+  // directories below it. The files found are passed to cb, if set.
+  int AddWatches(const std::string& dir, const Callback* cb);
+  void RemoveWatches(const std::string& dir);
+  int ReadFanotifyEvents(const Callback& cb);
+  int ReadInotifyEvents(const Callback& cb);
+
+  std::string root_;
+  int fd_ = -1;
+  // The root directory, which fanotify file handles are opened against.
+  int mount_fd_ = -1;
+  bool fanotify_ = false;
+  // Maps inotify watch descriptors to directories relative to the root.
+  std::unordered_map<int, std::string> watches_;
+};
+
+}  // namespace fs_watcher
+}  // namespace node
+
+#endif  // defined(NODE_WANT_INTERNALS) && NODE_WANT_INTERNALS
+
+#endif  // SRC_NODE_FS_WATCHER_H_
@@ -45,6 +45,7 @@ using v8::Number;
 using v8::Object;
 using v8::ObjectTemplate;
 using v8::String;
+using v8::Uint32;
 using v8::Uint8Array;
 using v8::Undefined;
 using v8::Value;
@@ -977,13 +978,16 @@ void Http2Session::ConsumeHTTP2Data() {
   // We are done processing the current input chunk.
   DecrementCurrentSessionMemory(stream_buf_.len);
   stream_buf_offset_ = 0;
-  stream_buf_ab_.Reset();
   stream_buf_allocation_.reset();
   stream_buf_ = uv_buf_init(nullptr, 0);
 
   // Send any data that was queued up while processing the received data.
   if (ret >= 0 && !is_destroyed()) {
-    SendPendingData();
+    if (batch_output_) {
+      if (!is_write_scheduled()) MaybeScheduleWrite();
+    } else {
+      SendPendingData();
+    }
   }
 
 done:
@@ -1342,6 +1346,7 @@ int Http2Session::OnDataChunkReceived(nghttp2_session* handle,
   // so that it can send a WINDOW_UPDATE frame. This is a critical part of
   // the flow control process in http2
   CHECK_EQ(nghttp2_session_consume_connection(handle, len), 0);
+  session->MaybeAutotuneLocalWindow(len);
   BaseObjectPtr<Http2Stream> stream = session->FindStream(id);
 
   // If the stream has been destroyed, ignore this chunk
@@ -1467,18 +1472,6 @@ void Http2StreamListener::OnStreamRead(ssize_t nread, const uv_buf_t& buf) {
     return;
   }
 
-  Local<ArrayBuffer> ab;
-  if (session->stream_buf_ab_.IsEmpty()) {
-    ab = ArrayBuffer::New(env->isolate(),
-                          std::move(session->stream_buf_allocation_));
-    session->stream_buf_ab_.Reset(env->isolate(), ab);
-  } else {
-    ab = PersistentToLocal::Strong(session->stream_buf_ab_);
-  }
-
-  // There is a single large array buffer for the entire data read from the
-  // network; create a slice of that array buffer and emit it as the
-  // received data buffer.
   size_t offset = buf.base - session->stream_buf_.base;
 
   // Verify that the data offset is inside the current read buffer.
@@ -1486,7 +1479,33 @@ void Http2StreamListener::OnStreamRead(ssize_t nread, const uv_buf_t& buf) {
   CHECK_LE(offset, session->stream_buf_.len);
   CHECK_LE(offset + buf.len, session->stream_buf_.len);
 
-  stream->CallJSOnreadMethod(nread, ab, offset);
+  std::unique_ptr<BackingStore> bs;
+  if (static_cast<size_t>(nread) < kMinSharedDataChunkSize) {
+    // Not worth keeping the whole socket read buffer alive for.
+    bs = ArrayBuffer::NewBackingStore(
+        env->isolate(),
+        nread,
+        BackingStoreInitializationMode::kUninitialized);
+    if (nread > 0) memcpy(bs->Data(), buf.base, nread);
+  } else {
+    // Each chunk gets an ArrayBuffer of its own that shares ownership of the
+    // socket read buffer. The read buffer is released once every chunk
+    // carved out of it has been collected, and each chunk only accounts for
+    // its own length rather than that of the whole read buffer.
+    CHECK(session->stream_buf_allocation_);
+    auto* owner =
+        new std::shared_ptr<BackingStore>(session->stream_buf_allocation_);
+    bs = ArrayBuffer::NewBackingStore(
+        buf.base,
+        nread,
+        [](void* data, size_t length, void* deleter_data) {
+          delete static_cast<std::shared_ptr<BackingStore>*>(deleter_data);
+        },
+        owner);
+  }
+
+  stream->CallJSOnreadMethod(
+      nread, ArrayBuffer::New(env->isolate(), std::move(bs)), 0);
 }
 
 
@@ -1818,23 +1837,39 @@ void Http2Session::MaybeScheduleWrite() {
     HandleScope handle_scope(env()->isolate());
     Debug(this, "scheduling write");
     set_write_scheduled();
-    BaseObjectPtr<Http2Session> strong_ref{this};
-    env()->SetImmediate([this, strong_ref](Environment* env) {
-      if (!session_ || !is_write_scheduled()) {
-        // This can happen e.g. when a stream was reset before this turn
-        // of the event loop, in which case SendPendingData() is called early,
-        // or the session was destroyed in the meantime.
-        return;
-      }
+    // All sessions of the realm that schedule a write in this turn of the
+    // event loop share a single immediate.
+    Http2State* state = http2_state();
+    state->sessions_pending_write.emplace_back(this);
+    if (state->sessions_pending_write.size() == 1) {
+      BaseObjectPtr<Http2State> state_ref{state};
+      env()->SetImmediate([state_ref](Environment* env) {
+        SendScheduledWrites(state_ref.get());
+      });
+    }
+  }
+}
 
-      // Sending data may call arbitrary JS code, so keep track of
-      // async context.
-      if (env->can_call_into_js()) {
-        HandleScope handle_scope(env->isolate());
-        InternalCallbackScope callback_scope(this);
-        SendPendingData();
-      }
-    });
+void Http2Session::SendScheduledWrites(Http2State* state) {
+  std::vector<BaseObjectPtr<BaseObject>> sessions;
+  sessions.swap(state->sessions_pending_write);
+  for (const BaseObjectPtr<BaseObject>& obj : sessions) {
+    Http2Session* session = static_cast<Http2Session*>(obj.get());
+    if (!session->session_ || !session->is_write_scheduled()) {
+      // This can happen e.g. when a stream was reset before this turn
+      // of the event loop, in which case SendPendingData() is called early,
+      // or the session was destroyed in the meantime.
+      continue;
+    }
+
+    // Sending data may call arbitrary JS code, so keep track of
+    // async context.
+    Environment* env = session->env();
+    if (env->can_call_into_js()) {
+      HandleScope handle_scope(env->isolate());
+      InternalCallbackScope callback_scope(session);
+      session->SendPendingData();
+    }
   }
 }
 
@@ -2135,7 +2170,6 @@ void Http2Session::OnStreamRead(ssize_t nread, const uv_buf_t& buf_) {
     bs = std::move(new_bs);
     nread = bs->ByteLength();
     stream_buf_offset_ = 0;
-    stream_buf_ab_.Reset();
 
     // We have now fully processed the stream_buf_ input chunk (by moving the
     // remaining part into buf, which will be accounted for below).
@@ -2149,9 +2183,8 @@ void Http2Session::OnStreamRead(ssize_t nread, const uv_buf_t& buf_) {
   stream_buf_ = uv_buf_init(static_cast<char*>(bs->Data()),
                             static_cast<unsigned int>(nread));
 
-  // Store this so we can create an ArrayBuffer for read data from it.
-  // DATA frames will be emitted as slices of that ArrayBuffer to avoid having
-  // to copy memory.
+  // Store this so that DATA frames can be emitted as slices of it, to avoid
+  // having to copy memory.
   stream_buf_allocation_ = std::move(bs);
 
   ConsumeHTTP2Data();
@@ -3096,6 +3129,31 @@ void Http2Stream::PushPromise(const FunctionCallbackInfo<Value>& args) {
   args.GetReturnValue().Set(stream->object());
 }
 
+int Http2Stream::SetExtPriority(const nghttp2_extpri& extpri,
+                                bool ignore_client_signal) {
+  CHECK(!this->is_destroyed());
+  Http2Scope h2scope(this);
+  Debug(this, "setting extensible priority u=%d i=%d",
+        extpri.urgency, extpri.inc);
+  int ret;
+  if (session_->type() == NGHTTP2_SESSION_SERVER) {
+    ret = nghttp2_session_change_extpri_stream_priority(
+        session_->session(), id_, &extpri, ignore_client_signal);
+  } else {
+    char field_value[16];
+    int len = snprintf(field_value, sizeof(field_value), "u=%d%s",
+                       extpri.urgency, extpri.inc ? ", i" : "");
+    ret = nghttp2_submit_priority_update(
+        session_->session(),
+        NGHTTP2_FLAG_NONE,
+        id_,
+        reinterpret_cast<const uint8_t*>(field_value),
+        len);
+  }
+  CHECK_NE(ret, NGHTTP2_ERR_NOMEM);
+  return ret;
+}
+
 // Send a PRIORITY frame
 void Http2Stream::Priority(const FunctionCallbackInfo<Value>& args) {
   Environment* env = Environment::GetCurrent(args);
@@ -3108,6 +3166,41 @@ void Http2Stream::Priority(const FunctionCallbackInfo<Value>& args) {
   Debug(stream, "priority submitted");
 }
 
+// setExtPriority(urgency, incremental, ignoreClientSignal) uses the RFC 9218
+// scheme, under which nghttp2 serves streams of lower urgency first and
+// round-robins between incremental streams of the same urgency. It only
+// takes effect once SETTINGS_NO_RFC7540_PRIORITIES=1 has been exchanged.
+// Returns 0 or an nghttp2 error code.
+void Http2Stream::SetExtPriority(const FunctionCallbackInfo<Value>& args) {
+  Http2Stream* stream;
+  ASSIGN_OR_RETURN_UNWRAP(&stream, args.This());
+  CHECK(args[0]->IsUint32());
+  nghttp2_extpri extpri;
+  extpri.urgency =
+      std::min<uint32_t>(args[0].As<Uint32>()->Value(),
+                         NGHTTP2_EXTPRI_URGENCY_LOW);
+  extpri.inc = args[1]->IsTrue() ? 1 : 0;
+  args.GetReturnValue().Set(
+      stream->SetExtPriority(extpri, args[2]->IsTrue()));
+}
+
+// getExtPriority() returns [urgency, incremental] on server sessions, or an
+// nghttp2 error code.
+void Http2Stream::GetExtPriority(const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+  Http2Stream* stream;
+  ASSIGN_OR_RETURN_UNWRAP(&stream, args.This());
+  nghttp2_extpri extpri{NGHTTP2_EXTPRI_DEFAULT_URGENCY, 0};
+  int ret = nghttp2_session_get_extpri_stream_priority(
+      stream->session()->session(), &extpri, stream->id());
+  if (ret != 0) return args.GetReturnValue().Set(ret);
+  Local<Value> result[] = {
+      Integer::New(env->isolate(), extpri.urgency),
+      Boolean::New(env->isolate(), extpri.inc != 0)};
+  args.GetReturnValue().Set(
+      Array::New(env->isolate(), result, arraysize(result)));
+}
+
 // A TypedArray shared by C++ and JS land is used to communicate state
 // information about the Http2Stream. This updates the values in that
 // TypedArray so that the state can be read by JS.
@@ -3481,6 +3574,10 @@ void Initialize(Local<Object> target,
   SetProtoMethod(isolate, stream, "id", Http2Stream::GetID);
   SetProtoMethod(isolate, stream, "destroy", Http2Stream::Destroy);
   SetProtoMethod(isolate, stream, "priority", Http2Stream::Priority);
+  SetProtoMethod(
+      isolate, stream, "setExtPriority", Http2Stream::SetExtPriority);
+  SetProtoMethod(
+      isolate, stream, "getExtPriority", Http2Stream::GetExtPriority);
   SetProtoMethod(isolate, stream, "pushPromise", Http2Stream::PushPromise);
   SetProtoMethod(isolate, stream, "info", Http2Stream::Info);
   SetProtoMethod(isolate, stream, "trailers", Http2Stream::Trailers);
@@ -3530,6 +3627,12 @@ void Initialize(Local<Object> target,
                                     false>);
   SetProtoMethod(
       isolate, session, "setGracefulClose", Http2Session::SetGracefulClose);
+  SetProtoMethod(
+      isolate, session, "setOutputBatching", Http2Session::SetOutputBatching);
+  SetProtoMethod(isolate,
+                 session,
+                 "setLocalWindowAutotune",
+                 Http2Session::SetLocalWindowAutotune);
   SetConstructorFunction(context, target, "Http2Session", session);
 
   Local<Object> constants = Object::New(isolate);
@@ -3595,6 +3698,68 @@ void Http2Session::SetGracefulClose(const FunctionCallbackInfo<Value>& args) {
   Debug(session, "Setting graceful close initiated flag");
 }
 
+// setOutputBatching(bool): defer the output generated while processing input
+// to the end of the event loop turn, so that responses to several reads go
+// out in a single write.
+void Http2Session::SetOutputBatching(const FunctionCallbackInfo<Value>& args) {
+  Http2Session* session;
+  ASSIGN_OR_RETURN_UNWRAP(&session, args.This());
+  session->batch_output_ = args[0]->IsTrue();
+}
+
+// setLocalWindowAutotune(maxWindowSize): let the connection-level receive
+// window grow up to maxWindowSize as the measured throughput requires.
+// Passing 0 turns autotuning off and leaves the current window in place.
+void Http2Session::SetLocalWindowAutotune(
+    const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+  Http2Session* session;
+  ASSIGN_OR_RETURN_UNWRAP(&session, args.This());
+
+  int32_t max_window_size;
+  if (!args[0]->Int32Value(env->context()).To(&max_window_size)) {
+    return;
+  }
+
+  session->max_local_window_size_ = std::max(max_window_size, 0);
+  session->window_epoch_start_ = uv_hrtime();
+  session->window_epoch_bytes_ = 0;
+  Debug(session, "local window autotune limit %d", max_window_size);
+}
+
+// Follows the approach ngtcp2 uses for QUIC: if the peer sends a whole
+// window's worth of data in less than a few round trips, the window rather
+// than the link is the bottleneck, so double it. Growth is capped by the
+// configured maximum and by what is left of the session memory budget,
+// since a larger window lets the peer put that much more data in flight.
+void Http2Session::MaybeAutotuneLocalWindow(size_t consumed) {
+  if (max_local_window_size_ == 0) return;
+
+  window_epoch_bytes_ += consumed;
+  nghttp2_session* s = session_.get();
+  int32_t window = nghttp2_session_get_effective_local_window_size(s);
+  if (window_epoch_bytes_ < static_cast<uint64_t>(window)) return;
+
+  uint64_t now = uv_hrtime();
+  uint64_t elapsed = now - window_epoch_start_;
+  uint64_t rtt = statistics_.ping_rtt > 0 ? statistics_.ping_rtt
+                                          : kDefaultAutotuneRtt;
+  window_epoch_start_ = now;
+  window_epoch_bytes_ = 0;
+
+  if (window >= max_local_window_size_ || elapsed >= 4 * rtt) return;
+
+  int32_t target = window > max_local_window_size_ / 2
+                       ? max_local_window_size_
+                       : window * 2;
+  if (!has_available_session_memory(target - window)) return;
+
+  if (nghttp2_session_set_local_window_size(
+          s, NGHTTP2_FLAG_NONE, 0, target) == 0) {
+    Debug(this, "autotuned local window from %d to %d", window, target);
+  }
+}
+
 void Http2Session::MaybeNotifyGracefulCloseComplete() {
   nghttp2_session* session = session_.get();
 
@@ -39,6 +39,10 @@ constexpr size_t kDefaultMaxSettings = 10;
 // Default maximum total memory cap for Http2Session.
 constexpr uint64_t kDefaultMaxSessionMemory = 10000000;
 
+// Round-trip time assumed by connection window autotuning until a PING has
+// measured the real one. Matches the initial RTT used by QUIC (RFC 9002).
+constexpr uint64_t kDefaultAutotuneRtt = 333 * 1000 * 1000;  // ns
+
 // These are the standard HTTP/2 defaults as specified by the RFC
 constexpr uint32_t DEFAULT_SETTINGS_HEADER_TABLE_SIZE = 4096;
 constexpr uint32_t DEFAULT_SETTINGS_ENABLE_PUSH = 1;
@@ -254,6 +258,11 @@ class Http2StreamListener : public StreamListener {
  public:
   uv_buf_t OnStreamAlloc(size_t suggested_size) override;
   void OnStreamRead(ssize_t nread, const uv_buf_t& buf) override;
+
+ private:
+  // DATA chunks smaller than this are copied out of the socket read buffer
+  // instead of sharing it.
+  static constexpr size_t kMinSharedDataChunkSize = 1024;
 };
 
 struct Http2HeaderTraits {
@@ -263,6 +272,14 @@ struct Http2HeaderTraits {
   // HTTP/2 does not support identifying header names by token id.
   // HTTP/3 will, however, so we prepare for that now.
   static const char* ToHttpHeaderName(int32_t token) { return nullptr; }
+
+  // Short values such as ":status: 200" or "content-type: application/grpc"
+  // repeat across messages, so they are internalized like names rather than
+  // each getting a new external string. Values the peer asked never to be
+  // indexed are likely secrets and are kept out of the string table.
+  static bool IsInternalizableValue(uint8_t flags) {
+    return !(flags & NGHTTP2_NV_FLAG_NO_INDEX);
+  }
 };
 
 using Http2Header = NgHeader<Http2HeaderTraits>;
@@ -309,6 +326,10 @@ class Http2Stream : public AsyncWrap,
   // Submit a PRIORITY frame for this stream
   int SubmitPriority(const Http2Priority& priority, bool silent = false);
 
+  // Set the RFC 9218 priority of the stream. Servers reprioritize locally,
+  // clients send a PRIORITY_UPDATE frame.
+  int SetExtPriority(const nghttp2_extpri& extpri, bool ignore_client_signal);
+
   // Submits an RST_STREAM frame using the given code
   void SubmitRstStream(const uint32_t code);
 
@@ -444,6 +465,8 @@ class Http2Stream : public AsyncWrap,
   static void GetID(const v8::FunctionCallbackInfo<v8::Value>& args);
   static void Destroy(const v8::FunctionCallbackInfo<v8::Value>& args);
   static void Priority(const v8::FunctionCallbackInfo<v8::Value>& args);
+  static void SetExtPriority(const v8::FunctionCallbackInfo<v8::Value>& args);
+  static void GetExtPriority(const v8::FunctionCallbackInfo<v8::Value>& args);
   static void PushPromise(const v8::FunctionCallbackInfo<v8::Value>& args);
   static void RefreshState(const v8::FunctionCallbackInfo<v8::Value>& args);
   static void Info(const v8::FunctionCallbackInfo<v8::Value>& args);
@@ -657,10 +680,15 @@ class Http2Session : public AsyncWrap,
 
   // Schedule a write if nghttp2 indicates it wants to write to the socket.
   void MaybeScheduleWrite();
+  static void SendScheduledWrites(Http2State* state);
 
   // Stop reading if nghttp2 doesn't want to anymore.
   void MaybeStopReading();
 
+  // Grows the connection-level receive window when the peer manages to fill
+  // it within a few round trips, up to max_local_window_size_.
+  void MaybeAutotuneLocalWindow(size_t consumed);
+
   // Returns pointer to the stream, or nullptr if stream does not exist
   BaseObjectPtr<Http2Stream> FindStream(int32_t id);
 
@@ -725,6 +753,10 @@ class Http2Session : public AsyncWrap,
   static void AltSvc(const v8::FunctionCallbackInfo<v8::Value>& args);
   static void Origin(const v8::FunctionCallbackInfo<v8::Value>& args);
   static void SetGracefulClose(const v8::FunctionCallbackInfo<v8::Value>& args);
+  static void SetOutputBatching(
+      const v8::FunctionCallbackInfo<v8::Value>& args);
+  static void SetLocalWindowAutotune(
+      const v8::FunctionCallbackInfo<v8::Value>& args);
 
   template <get_setting fn, bool local>
   static void RefreshSettings(const v8::FunctionCallbackInfo<v8::Value>& args);
@@ -924,10 +956,10 @@ class Http2Session : public AsyncWrap,
   uint32_t chunks_sent_since_last_write_ = 0;
 
   uv_buf_t stream_buf_ = uv_buf_init(nullptr, 0);
-  // When processing input data, either stream_buf_ab_ or stream_buf_allocation_
-  // will be set. stream_buf_ab_ is lazily created from stream_buf_allocation_.
-  v8::Global<v8::ArrayBuffer> stream_buf_ab_;
-  std::unique_ptr<v8::BackingStore> stream_buf_allocation_;
+  // Owns the memory behind stream_buf_ while input is being processed. DATA
+  // chunks handed to JS each share ownership of it, see
+  // Http2StreamListener::OnStreamRead().
+  std::shared_ptr<v8::BackingStore> stream_buf_allocation_;
   size_t stream_buf_offset_ = 0;
   // Custom error code for errors that originated inside one of the callbacks
   // called by nghttp2_session_mem_recv.
@@ -968,6 +1000,16 @@ class Http2Session : public AsyncWrap,
 
   // Flag to indicate that JavaScript has initiated a graceful closure
   bool graceful_close_initiated_ = false;
+
+  // When set, output produced while processing received data is not sent
+  // right away but together with everything else queued in this turn of the
+  // event loop.
+  bool batch_output_ = false;
+
+  // Receive window autotuning. Disabled while max_local_window_size_ is 0.
+  int32_t max_local_window_size_ = 0;
+  uint64_t window_epoch_start_ = 0;
+  uint64_t window_epoch_bytes_ = 0;
 };
 
 struct Http2SessionPerformanceEntryTraits {
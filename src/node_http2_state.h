@@ -4,6 +4,9 @@
 #if defined(NODE_WANT_INTERNALS) && NODE_WANT_INTERNALS
 
 #include "aliased_buffer.h"
+#include "base_object.h"
+
+#include <vector>
 
 struct nghttp2_rcbuf;
 
@@ -128,6 +131,11 @@ class Http2State : public BaseObject {
   AliasedUint32Array options_buffer;
   AliasedUint32Array settings_buffer;
 
+  // Http2Sessions with a write scheduled for this turn of the event loop.
+  // They are all flushed from a single immediate, see
+  // Http2Session::MaybeScheduleWrite().
+  std::vector<BaseObjectPtr<BaseObject>> sessions_pending_write;
+
   void MemoryInfo(MemoryTracker* tracker) const override;
   SET_SELF_SIZE(Http2State)
   SET_MEMORY_INFO_NAME(Http2State)
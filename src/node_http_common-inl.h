@@ -123,7 +123,7 @@ NgHeader<T>::NgHeader(
   }
   CHECK_NOT_NULL(value);
   name_.reset(name, true);  // Internalizable
-  value_.reset(value);
+  value_.reset(value, T::IsInternalizableValue(flags));
 }
 
 template <typename T>
@@ -156,7 +156,7 @@ v8::MaybeLocal<v8::String> NgHeader<T>::GetName(
   // a statically defined name. We can safely internalize it here.
   if (header_name != nullptr) {
     auto& static_str_map = env_->isolate_data()->static_str_map;
-    v8::Eternal<v8::String> eternal = static_str_map[header_name];
+    v8::Eternal<v8::String>& eternal = static_str_map[header_name];
     if (eternal.IsEmpty()) {
       v8::Local<v8::String> str = OneByteString(env_->isolate(), header_name);
       eternal.Set(env_->isolate(), str);
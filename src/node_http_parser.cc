@@ -19,6 +19,7 @@
 // OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE
 // USE OR OTHER DEALINGS IN THE SOFTWARE.
 
+#include "node_http_parser.h"
 #include "node.h"
 #include "node_buffer.h"
 #include "util.h"
@@ -31,8 +32,12 @@
 #include "stream_base-inl.h"
 #include "v8.h"
 
+#include <array>
+#include <cstdint>
 #include <cstdlib>  // free()
 #include <cstring>  // strdup(), strchr()
+#include <string>
+#include <vector>
 
 
 // This is a binding to llhttp (https://github.com/nodejs/llhttp)
@@ -51,6 +56,9 @@ namespace node {
 namespace http_parser {  // NOLINT(build/namespaces)
 
 using v8::Array;
+using v8::ArrayBuffer;
+using v8::BackingStore;
+using v8::BackingStoreInitializationMode;
 using v8::Boolean;
 using v8::Context;
 using v8::EscapableHandleScope;
@@ -70,6 +78,7 @@ using v8::Object;
 using v8::ObjectTemplate;
 using v8::String;
 using v8::Uint32;
+using v8::Uint32Array;
 using v8::Undefined;
 using v8::Value;
 
@@ -80,6 +89,21 @@ const uint32_t kOnBody = 3;
 const uint32_t kOnMessageComplete = 4;
 const uint32_t kOnExecute = 5;
 const uint32_t kOnTimeout = 6;
+const uint32_t kOnMessages = 7;
+// Layout of the entry for one message in batch mode, followed by the
+// offsets and lengths of each header name and value. See SetBatchMode().
+const uint32_t kBatchFlags = 0;
+const uint32_t kBatchMethod = 1;
+const uint32_t kBatchVersionMajor = 2;
+const uint32_t kBatchVersionMinor = 3;
+const uint32_t kBatchUrlOffset = 4;
+const uint32_t kBatchUrlLength = 5;
+const uint32_t kBatchBodyOffset = 6;
+const uint32_t kBatchBodyLength = 7;
+const uint32_t kBatchHeaderCount = 8;
+const uint32_t kBatchHeaders = 9;
+const uint32_t kBatchFlagKeepAlive = 1 << 0;
+const uint32_t kBatchFlagComplete = 1 << 1;
 // Any more fields than this will be flushed into JS
 const size_t kMaxHeaderFieldsCount = 32;
 // Maximum size of chunk extensions
@@ -106,21 +130,45 @@ inline bool IsOWS(char c) {
   return c == ' ' || c == '\t';
 }
 
-class BindingData : public BaseObject {
- public:
-  BindingData(Realm* realm, Local<Object> obj) : BaseObject(realm, obj) {}
+BindingData::BindingData(Realm* realm, Local<Object> obj)
+    : SnapshotableObject(realm, obj, type_int) {}
+
+bool BindingData::PrepareForSerialization(Local<Context> context,
+                                          v8::SnapshotCreator* creator) {
+  // The cached strings are held through global handles, which can't be
+  // serialized. They are created again on first use.
+  header_names.Clear();
+  header_values.Clear();
+  // Return true because we need to maintain the reference to the binding from
+  // JS land.
+  return true;
+}
 
-  SET_BINDING_ID(http_parser_binding_data)
+InternalFieldInfoBase* BindingData::Serialize(int index) {
+  DCHECK_IS_SNAPSHOT_SLOT(index);
+  InternalFieldInfo* info =
+      InternalFieldInfoBase::New<InternalFieldInfo>(type());
+  return info;
+}
 
-  std::vector<char> parser_buffer;
-  bool parser_buffer_in_use = false;
+void BindingData::Deserialize(Local<Context> context,
+                              Local<Object> holder,
+                              int index,
+                              InternalFieldInfoBase* info) {
+  DCHECK_IS_SNAPSHOT_SLOT(index);
+  HandleScope scope(context->GetIsolate());
+  Realm* realm = Realm::GetCurrent(context);
+  BindingData* binding = realm->AddBindingData<BindingData>(holder);
+  CHECK_NOT_NULL(binding);
+}
 
-  void MemoryInfo(MemoryTracker* tracker) const override {
-    tracker->TrackField("parser_buffer", parser_buffer);
-  }
-  SET_SELF_SIZE(BindingData)
-  SET_MEMORY_INFO_NAME(BindingData)
-};
+void BindingData::MemoryInfo(MemoryTracker* tracker) const {
+  tracker->TrackField("parser_buffer", parser_buffer);
+  tracker->TrackFieldWithSize(
+      "header_names", header_names.SelfSize(), "HeaderStringCache");
+  tracker->TrackFieldWithSize(
+      "header_values", header_values.SelfSize(), "HeaderStringCache");
+}
 
 // helper class for the Parser
 struct StringPtr {
@@ -188,12 +236,17 @@ struct StringPtr {
   }
 
 
+  template <typename Cache>
+  Local<String> ToString(Environment* env, Cache* cache) const {
+    return cache->Get(env->isolate(), str_, size_);
+  }
+
+
   // Strip trailing OWS (SPC or HTAB) from string.
-  Local<String> ToTrimmedString(Environment* env) {
+  void Trim() {
     while (size_ > 0 && IsOWS(str_[size_ - 1])) {
       size_--;
     }
-    return ToString(env);
   }
 
 
@@ -202,6 +255,170 @@ struct StringPtr {
   size_t size_;
 };
 
+// Header block of one message, kept as raw bytes and only turned into
+// strings on access. The bytes are laid out as "name: value\r\n" lines, so
+// raw() can be written to another connection as-is.
+class HeaderSlices : public BaseObject {
+ public:
+  HeaderSlices(Environment* env,
+               Local<Object> wrap,
+               std::shared_ptr<BackingStore> store,
+               std::vector<uint32_t> offsets)
+      : BaseObject(env, wrap),
+        store_(std::move(store)),
+        offsets_(std::move(offsets)) {
+    MakeWeak();
+  }
+
+  static Local<ObjectTemplate> GetTemplate(IsolateData* isolate_data) {
+    Local<ObjectTemplate> tmpl = isolate_data->http_header_slices_template();
+    if (tmpl.IsEmpty()) {
+      Isolate* isolate = isolate_data->isolate();
+      Local<FunctionTemplate> t = NewFunctionTemplate(isolate, nullptr);
+      t->InstanceTemplate()->SetInternalFieldCount(
+          BaseObject::kInternalFieldCount);
+      SetProtoMethodNoSideEffect(isolate, t, "count", Count);
+      SetProtoMethodNoSideEffect(isolate, t, "name", Name);
+      SetProtoMethodNoSideEffect(isolate, t, "value", GetValue);
+      SetProtoMethodNoSideEffect(isolate, t, "get", Get);
+      SetProtoMethodNoSideEffect(isolate, t, "raw", Raw);
+      tmpl = t->InstanceTemplate();
+      isolate_data->set_http_header_slices_template(tmpl);
+    }
+    return tmpl;
+  }
+
+  static void RegisterExternalReferences(ExternalReferenceRegistry* registry) {
+    registry->Register(Count);
+    registry->Register(Name);
+    registry->Register(GetValue);
+    registry->Register(Get);
+    registry->Register(Raw);
+  }
+
+  static MaybeLocal<Object> Create(Environment* env,
+                                   const StringPtr* fields,
+                                   const StringPtr* values,
+                                   size_t count) {
+    size_t length = 0;
+    for (size_t i = 0; i < count; i++)
+      length += fields[i].size_ + values[i].size_ + 4;  // ": " and CRLF
+
+    std::shared_ptr<BackingStore> store = ArrayBuffer::NewBackingStore(
+        env->isolate(), length, BackingStoreInitializationMode::kUninitialized);
+    std::vector<uint32_t> offsets(count * kSlotsPerHeader);
+    char* data = static_cast<char*>(store->Data());
+    uint32_t pos = 0;
+    for (size_t i = 0; i < count; i++) {
+      uint32_t* slot = &offsets[i * kSlotsPerHeader];
+      auto append = [&](const char* bytes, size_t size) {
+        if (size > 0) memcpy(data + pos, bytes, size);
+        pos += size;
+      };
+      slot[0] = pos;
+      slot[1] = fields[i].size_;
+      append(fields[i].str_, fields[i].size_);
+      append(": ", 2);
+      slot[2] = pos;
+      slot[3] = values[i].size_;
+      append(values[i].str_, values[i].size_);
+      append("\r\n", 2);
+    }
+    CHECK_EQ(pos, length);
+
+    Local<Object> obj;
+    if (!GetTemplate(env->isolate_data())
+             ->NewInstance(env->context())
+             .ToLocal(&obj)) {
+      return MaybeLocal<Object>();
+    }
+    new HeaderSlices(env, obj, std::move(store), std::move(offsets));
+    return obj;
+  }
+
+  void MemoryInfo(MemoryTracker* tracker) const override {
+    tracker->TrackFieldWithSize("store", store_->ByteLength());
+    tracker->TrackField("offsets", offsets_);
+  }
+  SET_MEMORY_INFO_NAME(HeaderSlices)
+  SET_SELF_SIZE(HeaderSlices)
+
+ private:
+  static constexpr size_t kSlotsPerHeader = 4;
+
+  size_t count() const { return offsets_.size() / kSlotsPerHeader; }
+
+  Local<String> Slice(size_t index, size_t which) const {
+    const uint32_t* slot = &offsets_[index * kSlotsPerHeader + which * 2];
+    return OneByteString(env()->isolate(),
+                         static_cast<const char*>(store_->Data()) + slot[0],
+                         slot[1]);
+  }
+
+  static HeaderSlices* FromArgs(const FunctionCallbackInfo<Value>& args,
+                                bool indexed) {
+    HeaderSlices* slices;
+    ASSIGN_OR_RETURN_UNWRAP(&slices, args.This(), nullptr);
+    if (indexed) {
+      CHECK(args[0]->IsUint32());
+      if (args[0].As<Uint32>()->Value() >= slices->count()) return nullptr;
+    }
+    return slices;
+  }
+
+  static void Count(const FunctionCallbackInfo<Value>& args) {
+    HeaderSlices* slices = FromArgs(args, false);
+    if (slices == nullptr) return;
+    args.GetReturnValue().Set(static_cast<uint32_t>(slices->count()));
+  }
+
+  static void Name(const FunctionCallbackInfo<Value>& args) {
+    HeaderSlices* slices = FromArgs(args, true);
+    if (slices == nullptr) return;
+    args.GetReturnValue().Set(
+        slices->Slice(args[0].As<Uint32>()->Value(), 0));
+  }
+
+  static void GetValue(const FunctionCallbackInfo<Value>& args) {
+    HeaderSlices* slices = FromArgs(args, true);
+    if (slices == nullptr) return;
+    args.GetReturnValue().Set(
+        slices->Slice(args[0].As<Uint32>()->Value(), 1));
+  }
+
+  // get(name) returns the value of the first header whose name matches
+  // `name` case-insensitively, or undefined.
+  static void Get(const FunctionCallbackInfo<Value>& args) {
+    HeaderSlices* slices = FromArgs(args, false);
+    if (slices == nullptr) return;
+    CHECK(args[0]->IsString());
+    Utf8Value name(args.GetIsolate(), args[0]);
+    const char* data = static_cast<const char*>(slices->store_->Data());
+    for (size_t i = 0; i < slices->count(); i++) {
+      const uint32_t* slot = &slices->offsets_[i * kSlotsPerHeader];
+      if (slot[1] == name.length() &&
+          StringEqualNoCaseN(data + slot[0], *name, name.length())) {
+        return args.GetReturnValue().Set(slices->Slice(i, 1));
+      }
+    }
+  }
+
+  // raw() returns a Buffer sharing the header bytes, without copying them.
+  static void Raw(const FunctionCallbackInfo<Value>& args) {
+    HeaderSlices* slices = FromArgs(args, false);
+    if (slices == nullptr) return;
+    Environment* env = slices->env();
+    Local<ArrayBuffer> ab = ArrayBuffer::New(env->isolate(), slices->store_);
+    Local<Object> buffer;
+    if (Buffer::New(env, ab, 0, ab->ByteLength()).ToLocal(&buffer))
+      args.GetReturnValue().Set(buffer);
+  }
+
+  std::shared_ptr<BackingStore> store_;
+  // Per header: name offset, name length, value offset, value length.
+  std::vector<uint32_t> offsets_;
+};
+
 class Parser;
 
 struct ParserComparator {
@@ -228,12 +445,20 @@ class ConnectionsList : public BaseObject {
       all_connections_.erase(parser);
     }
 
+    // A connection becomes active at the start of a message, before its
+    // headers have been received.
     void PushActive(Parser* parser) {
       active_connections_.insert(parser);
+      headers_pending_connections_.insert(parser);
     }
 
     void PopActive(Parser* parser) {
       active_connections_.erase(parser);
+      headers_pending_connections_.erase(parser);
+    }
+
+    void HeadersCompleted(Parser* parser) {
+      headers_pending_connections_.erase(parser);
     }
 
     SET_NO_MEMORY_INFO()
@@ -248,6 +473,8 @@ class ConnectionsList : public BaseObject {
 
     std::set<Parser*, ParserComparator> all_connections_;
     std::set<Parser*, ParserComparator> active_connections_;
+    // The subset of active_connections_ still waiting for their headers.
+    std::set<Parser*, ParserComparator> headers_pending_connections_;
 };
 
 class Parser : public AsyncWrap, public StreamListener {
@@ -289,6 +516,8 @@ class Parser : public AsyncWrap, public StreamListener {
     Local<Value> cb = object()->Get(env()->context(), kOnMessageBegin)
                               .ToLocalChecked();
     if (cb->IsFunction()) {
+      if (!DeliverBatch()) return -1;
+
       InternalCallbackScope callback_scope(
         this, InternalCallbackScope::kSkipTaskQueues);
 
@@ -376,6 +605,14 @@ class Parser : public AsyncWrap, public StreamListener {
     headers_completed_ = true;
     header_nread_ = 0;
 
+    if (connectionsList_ != nullptr) {
+      connectionsList_->HeadersCompleted(this);
+    }
+
+    if (BatchHeaders()) return 0;
+    // Batched messages that came before this one go to JS first.
+    if (!DeliverBatch()) return -1;
+
     // Arguments for the on-headers-complete javascript callback. This
     // list needs to be kept in sync with the actual argument list for
     // `parserOnHeadersComplete` in lib/_http_common.js.
@@ -409,7 +646,18 @@ class Parser : public AsyncWrap, public StreamListener {
       Flush();
     } else {
       // Fast case, pass headers and URL to JS land.
-      argv[A_HEADERS] = CreateHeaders();
+      if (lazy_headers_) {
+        for (size_t i = 0; i < num_values_; ++i) values_[i].Trim();
+        Local<Object> headers;
+        if (!HeaderSlices::Create(env(), fields_, values_, num_values_)
+                 .ToLocal(&headers)) {
+          got_exception_ = true;
+          return -1;
+        }
+        argv[A_HEADERS] = headers;
+      } else {
+        argv[A_HEADERS] = CreateHeaders();
+      }
       if (parser_.type == HTTP_REQUEST)
         argv[A_URL] = url_.ToString(env());
     }
@@ -468,6 +716,21 @@ class Parser : public AsyncWrap, public StreamListener {
     if (length == 0)
       return 0;
 
+    if (batching_message_) {
+      uint32_t* entry = &batch_[batch_message_start_];
+      if (entry[kBatchBodyLength] == 0 && InCurrentBuffer(at, length)) {
+        entry[kBatchBodyOffset] = BufferOffset(at);
+        entry[kBatchBodyLength] = length;
+        return 0;
+      }
+      // Further body data, as with chunked encoding, is passed to JS on its
+      // own once the batch has been delivered.
+      if (!DeliverBatch()) {
+        llhttp_set_error_reason(&parser_, "HPE_JS_EXCEPTION:JS Exception");
+        return HPE_USER;
+      }
+    }
+
     Environment* env = this->env();
     HandleScope handle_scope(env->isolate());
 
@@ -506,6 +769,13 @@ class Parser : public AsyncWrap, public StreamListener {
       connectionsList_->Push(this);
     }
 
+    if (batching_message_ && num_fields_ == 0) {
+      batch_[batch_message_start_ + kBatchFlags] |= kBatchFlagComplete;
+      batching_message_ = false;
+      return 0;
+    }
+    if (!DeliverBatch()) return -1;
+
     if (num_fields_)
       Flush();  // Flush trailing HTTP headers.
 
@@ -734,6 +1004,40 @@ class Parser : public AsyncWrap, public StreamListener {
   }
 
 
+  // setLazyHeaders(bool): deliver the headers of messages that fit in a
+  // single kOnHeadersComplete call as a HeaderSlices object rather than an
+  // array of strings. Headers flushed early through kOnHeaders are still
+  // delivered as arrays.
+  static void SetLazyHeaders(const FunctionCallbackInfo<Value>& args) {
+    Parser* parser;
+    ASSIGN_OR_RETURN_UNWRAP(&parser, args.This());
+    parser->lazy_headers_ = args[0]->IsTrue();
+  }
+
+  // setBatchMode(bool): for request parsers, describe the messages whose
+  // head is complete within one buffer in a single kOnMessages call per
+  // buffer instead of calling kOnHeadersComplete, kOnBody and
+  // kOnMessageComplete for each of them. The callback receives a copy of
+  // the buffer, made once per execute() call and shared by all of its
+  // kOnMessages calls, and a Uint32Array of entries laid out as kBatch*,
+  // with offsets into the buffer. A message that is not kBatchFlagComplete
+  // continues with regular kOnBody and kOnMessageComplete calls. In batch
+  // mode the parser proceeds as if JS had returned 0 from
+  // kOnHeadersComplete. Upgrade and CONNECT requests, and messages whose
+  // headers had to be flushed early or span buffers, use the regular
+  // callbacks; batched messages before them are delivered first.
+  // The messages of a batch have all been parsed by the time it is
+  // delivered, so pausing the parser from kOnMessages does not hold any of
+  // them back. It only takes effect for the data that follows the batch,
+  // just as pausing the socket only takes effect for the next read. A
+  // consumer that applies backpressure per request has to queue the
+  // messages of a batch itself.
+  static void SetBatchMode(const FunctionCallbackInfo<Value>& args) {
+    Parser* parser;
+    ASSIGN_OR_RETURN_UNWRAP(&parser, args.This());
+    parser->batch_mode_ = args[0]->IsTrue();
+  }
+
   static void GetCurrentBuffer(const FunctionCallbackInfo<Value>& args) {
     Parser* parser;
     ASSIGN_OR_RETURN_UNWRAP(&parser, args.This());
@@ -822,6 +1126,8 @@ class Parser : public AsyncWrap, public StreamListener {
       err = llhttp_finish(&parser_);
     } else {
       err = llhttp_execute(&parser_, data, len);
+      // Deliver while the batch entries still refer to the current buffer.
+      DeliverBatch();
       Save();
     }
 
@@ -845,6 +1151,7 @@ class Parser : public AsyncWrap, public StreamListener {
 
     current_buffer_len_ = 0;
     current_buffer_data_ = nullptr;
+    batch_buffer_.Reset();
 
     // If there was an exception in one of the callbacks
     if (got_exception_)
@@ -894,16 +1201,128 @@ class Parser : public AsyncWrap, public StreamListener {
     Local<Value> headers_v[kMaxHeaderFieldsCount * 2];
 
     for (size_t i = 0; i < num_values_; ++i) {
-      headers_v[i * 2] = fields_[i].ToString(env());
-      headers_v[i * 2 + 1] = values_[i].ToTrimmedString(env());
+      headers_v[i * 2] =
+          fields_[i].ToString(env(), &binding_data_->header_names);
+      values_[i].Trim();
+      headers_v[i * 2 + 1] =
+          values_[i].ToString(env(), &binding_data_->header_values);
     }
 
     return Array::New(env()->isolate(), headers_v, num_values_ * 2);
   }
 
 
+  bool InCurrentBuffer(const char* at, size_t length) const {
+    if (current_buffer_data_ == nullptr || at < current_buffer_data_)
+      return false;
+    const size_t offset = at - current_buffer_data_;
+    return offset <= current_buffer_len_ &&
+           length <= current_buffer_len_ - offset;
+  }
+
+  bool InCurrentBuffer(const StringPtr& str) const {
+    return str.size_ == 0 ||
+           (!str.on_heap_ && InCurrentBuffer(str.str_, str.size_));
+  }
+
+  uint32_t BufferOffset(const char* at) const {
+    if (at == nullptr) return 0;
+    return static_cast<uint32_t>(at - current_buffer_data_);
+  }
+
+  // Adds an entry for the current message to the batch instead of passing
+  // its head to JS, if batch mode allows it.
+  bool BatchHeaders() {
+    if (!batch_mode_ || parser_.type != HTTP_REQUEST || parser_.upgrade ||
+        have_flushed_ || current_buffer_len_ > UINT32_MAX ||
+        !InCurrentBuffer(url_)) {
+      return false;
+    }
+    for (size_t i = 0; i < num_values_; ++i) {
+      if (!InCurrentBuffer(fields_[i]) || !InCurrentBuffer(values_[i]))
+        return false;
+    }
+
+    batching_message_ = true;
+    batch_message_start_ = batch_.size();
+    batch_.resize(batch_message_start_ + kBatchHeaders + num_values_ * 4);
+    uint32_t* entry = &batch_[batch_message_start_];
+    entry[kBatchFlags] =
+        llhttp_should_keep_alive(&parser_) ? kBatchFlagKeepAlive : 0;
+    entry[kBatchMethod] = parser_.method;
+    entry[kBatchVersionMajor] = parser_.http_major;
+    entry[kBatchVersionMinor] = parser_.http_minor;
+    entry[kBatchUrlOffset] = BufferOffset(url_.str_);
+    entry[kBatchUrlLength] = url_.size_;
+    entry[kBatchBodyOffset] = 0;
+    entry[kBatchBodyLength] = 0;
+    entry[kBatchHeaderCount] = num_values_;
+    uint32_t* header = entry + kBatchHeaders;
+    for (size_t i = 0; i < num_values_; ++i, header += 4) {
+      values_[i].Trim();
+      header[0] = BufferOffset(fields_[i].str_);
+      header[1] = fields_[i].size_;
+      header[2] = BufferOffset(values_[i].str_);
+      header[3] = values_[i].size_;
+    }
+
+    num_fields_ = 0;
+    num_values_ = 0;
+    return true;
+  }
+
+  // Passes the batched messages to JS. Returns false if the callback threw.
+  bool DeliverBatch() {
+    batching_message_ = false;
+    if (batch_.empty()) return true;
+    std::vector<uint32_t> batch = std::move(batch_);
+    batch_.clear();
+
+    Environment* env = this->env();
+    HandleScope scope(env->isolate());
+    Local<Value> cb =
+        object()->Get(env->context(), kOnMessages).ToLocalChecked();
+    if (!cb->IsFunction()) return true;
+
+    const size_t byte_length = batch.size() * sizeof(batch[0]);
+    std::shared_ptr<BackingStore> store = ArrayBuffer::NewBackingStore(
+        env->isolate(),
+        byte_length,
+        BackingStoreInitializationMode::kUninitialized);
+    memcpy(store->Data(), batch.data(), byte_length);
+    Local<ArrayBuffer> ab = ArrayBuffer::New(env->isolate(), std::move(store));
+
+    // The entries of every batch of this execute() call refer to the same
+    // buffer, so it only needs to be copied once.
+    Local<Object> buffer;
+    if (batch_buffer_.IsEmpty()) {
+      if (!Buffer::Copy(env, current_buffer_data_, current_buffer_len_)
+               .ToLocal(&buffer)) {
+        got_exception_ = true;
+        return false;
+      }
+      batch_buffer_.Reset(env->isolate(), buffer);
+    } else {
+      buffer = batch_buffer_.Get(env->isolate());
+    }
+    Local<Value> argv[] = {buffer, Uint32Array::New(ab, 0, batch.size())};
+
+    InternalCallbackScope callback_scope(
+        this, InternalCallbackScope::kSkipTaskQueues);
+    MaybeLocal<Value> r = cb.As<Function>()->Call(
+        env->context(), object(), arraysize(argv), argv);
+    if (r.IsEmpty()) {
+      callback_scope.MarkAsFailed();
+      got_exception_ = true;
+      return false;
+    }
+    return true;
+  }
+
   // spill headers and request path to JS land
   void Flush() {
+    if (!DeliverBatch()) return;
+
     HandleScope scope(env()->isolate());
 
     Local<Object> obj = object();
@@ -972,6 +1391,8 @@ class Parser : public AsyncWrap, public StreamListener {
     have_flushed_ = false;
     got_exception_ = false;
     headers_completed_ = false;
+    batching_message_ = false;
+    batch_.clear();
     max_http_header_size_ = max_http_header_size;
   }
 
@@ -1018,6 +1439,15 @@ class Parser : public AsyncWrap, public StreamListener {
   const char* current_buffer_data_;
   bool headers_completed_ = false;
   bool pending_pause_ = false;
+  bool lazy_headers_ = false;
+  bool batch_mode_ = false;
+  // Whether the current message has an entry in batch_, starting at
+  // batch_message_start_, instead of having been passed to JS.
+  bool batching_message_ = false;
+  size_t batch_message_start_ = 0;
+  std::vector<uint32_t> batch_;
+  // The copy of the current buffer that batches are delivered with.
+  v8::Global<v8::Object> batch_buffer_;
   uint64_t header_nread_ = 0;
   uint64_t chunk_extensions_nread_ = 0;
   uint64_t max_http_header_size_;
@@ -1157,27 +1587,24 @@ void ConnectionsList::Expired(const FunctionCallbackInfo<Value>& args) {
     return args.GetReturnValue().Set(Array::New(isolate, 0));
   }
 
-  auto iter = list->active_connections_.begin();
-  auto end = list->active_connections_.end();
-
+  // Both sets are ordered by message start, so expired connections are
+  // always at the front and the sweep stops at the first one that is not.
   LocalVector<Value> result(isolate);
-  result.reserve(list->active_connections_.size());
-  while (iter != end) {
-    Parser* parser = *iter;
-    iter++;
-
-    // Check for expiration.
-    if (
-      (!parser->headers_completed_ && headers_deadline > 0 &&
-        parser->last_message_start_ < headers_deadline) ||
-      (
-        request_deadline > 0 &&
-        parser->last_message_start_ < request_deadline)
-    ) {
+  auto expire = [&](std::set<Parser*, ParserComparator>* connections,
+                    uint64_t deadline) {
+    while (!connections->empty()) {
+      Parser* parser = *connections->begin();
+      if (parser->last_message_start_ >= deadline) break;
       result.emplace_back(parser->object());
-
-      list->active_connections_.erase(parser);
+      list->PopActive(parser);
     }
+  };
+
+  if (request_deadline > 0) {
+    expire(&list->active_connections_, request_deadline);
+  }
+  if (headers_deadline > 0) {
+    expire(&list->headers_pending_connections_, headers_deadline);
   }
 
   return args.GetReturnValue().Set(
@@ -1235,6 +1662,85 @@ const llhttp_settings_t Parser::settings = {
     nullptr,
 };
 
+// serializeResponseHead(target, offset, statusCode, statusMessage, headers,
+// extra) writes an HTTP/1.1 status line, the [name, value, ...] pairs in
+// `headers`, the optional pre-encoded header lines in `extra` and the
+// terminating CRLF into `target` at `offset`, all latin1-encoded. Returns the
+// number of bytes written or, if `target` is too small, the negated number of
+// bytes needed. Callers are expected to have validated the header strings.
+// Writing into a caller-provided (typically pooled) buffer lets the head go
+// out in the same writev as the body without any string concatenation.
+static void SerializeResponseHead(const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+  Isolate* isolate = env->isolate();
+  Local<Context> context = env->context();
+
+  CHECK(args[0]->IsArrayBufferView());
+  CHECK(args[1]->IsUint32());
+  CHECK(args[2]->IsUint32());
+  CHECK(args[3]->IsString());
+  CHECK(args[4]->IsArray());
+
+  SPREAD_BUFFER_ARG(args[0], target);
+  size_t offset = args[1].As<Uint32>()->Value();
+  uint32_t status_code = args[2].As<Uint32>()->Value();
+  Local<String> status_message = args[3].As<String>();
+  Local<Array> headers = args[4].As<Array>();
+  CHECK_GE(status_code, 100);
+  CHECK_LE(status_code, 999);
+  CHECK_EQ(headers->Length() % 2, 0);
+  CHECK_LE(offset, target_length);
+
+  ArrayBufferViewContents<char> extra;
+  if (args[5]->IsArrayBufferView()) extra.ReadValue(args[5]);
+
+  uint32_t count = headers->Length();
+  LocalVector<String> strings(isolate);
+  strings.reserve(count);
+  // "HTTP/1.1 200 " + message + CRLF, the extra lines, and the final CRLF.
+  size_t needed = 13 + status_message->Length() + 2 + extra.length() + 2;
+  for (uint32_t i = 0; i < count; i++) {
+    Local<Value> value;
+    if (!headers->Get(context, i).ToLocal(&value)) return;
+    CHECK(value->IsString());
+    strings.push_back(value.As<String>());
+    needed += strings.back()->Length() + 2;  // ": " or CRLF
+  }
+
+  if (needed > target_length - offset) {
+    return args.GetReturnValue().Set(-static_cast<double>(needed));
+  }
+
+  uint8_t* out = reinterpret_cast<uint8_t*>(target_data + offset);
+  size_t pos = 0;
+  auto append = [&](const char* data, size_t size) {
+    memcpy(out + pos, data, size);
+    pos += size;
+  };
+  auto append_string = [&](Local<String> string) {
+    size_t length = string->Length();
+    string->WriteOneByteV2(isolate, 0, length, out + pos);
+    pos += length;
+  };
+
+  char status_line[14];
+  snprintf(status_line, sizeof(status_line), "HTTP/1.1 %03u ", status_code);
+  append(status_line, 13);
+  append_string(status_message);
+  append("\r\n", 2);
+  for (uint32_t i = 0; i < count; i += 2) {
+    append_string(strings[i]);
+    append(": ", 2);
+    append_string(strings[i + 1]);
+    append("\r\n", 2);
+  }
+  if (extra.length() > 0) append(extra.data(), extra.length());
+  append("\r\n", 2);
+  CHECK_EQ(pos, needed);
+
+  args.GetReturnValue().Set(static_cast<double>(pos));
+}
+
 void CreatePerIsolateProperties(IsolateData* isolate_data,
                                 Local<ObjectTemplate> target) {
   Isolate* isolate = isolate_data->isolate();
@@ -1260,6 +1766,25 @@ void CreatePerIsolateProperties(IsolateData* isolate_data,
          Integer::NewFromUnsigned(isolate, kOnExecute));
   t->Set(FIXED_ONE_BYTE_STRING(isolate, "kOnTimeout"),
          Integer::NewFromUnsigned(isolate, kOnTimeout));
+  t->Set(FIXED_ONE_BYTE_STRING(isolate, "kOnMessages"),
+         Integer::NewFromUnsigned(isolate, kOnMessages));
+
+#define V(name)                                                                \
+  t->Set(FIXED_ONE_BYTE_STRING(isolate, #name),                                \
+         Integer::NewFromUnsigned(isolate, name));
+  V(kBatchFlags)
+  V(kBatchMethod)
+  V(kBatchVersionMajor)
+  V(kBatchVersionMinor)
+  V(kBatchUrlOffset)
+  V(kBatchUrlLength)
+  V(kBatchBodyOffset)
+  V(kBatchBodyLength)
+  V(kBatchHeaderCount)
+  V(kBatchHeaders)
+  V(kBatchFlagKeepAlive)
+  V(kBatchFlagComplete)
+#undef V
 
   t->Set(FIXED_ONE_BYTE_STRING(isolate, "kLenientNone"),
          Integer::NewFromUnsigned(isolate, kLenientNone));
@@ -1299,6 +1824,8 @@ void CreatePerIsolateProperties(IsolateData* isolate_data,
   SetProtoMethod(isolate, t, "consume", Parser::Consume);
   SetProtoMethod(isolate, t, "unconsume", Parser::Unconsume);
   SetProtoMethod(isolate, t, "getCurrentBuffer", Parser::GetCurrentBuffer);
+  SetProtoMethod(isolate, t, "setLazyHeaders", Parser::SetLazyHeaders);
+  SetProtoMethod(isolate, t, "setBatchMode", Parser::SetBatchMode);
 
   SetConstructorFunction(isolate, target, "HTTPParser", t);
 
@@ -1311,6 +1838,8 @@ void CreatePerIsolateProperties(IsolateData* isolate_data,
   SetProtoMethod(isolate, c, "active", ConnectionsList::Active);
   SetProtoMethod(isolate, c, "expired", ConnectionsList::Expired);
   SetConstructorFunction(isolate, target, "ConnectionsList", c);
+
+  SetMethod(isolate, target, "serializeResponseHead", SerializeResponseHead);
 }
 
 void CreatePerContextProperties(Local<Object> target,
@@ -1368,6 +1897,10 @@ void RegisterExternalReferences(ExternalReferenceRegistry* registry) {
   registry->Register(Parser::Consume);
   registry->Register(Parser::Unconsume);
   registry->Register(Parser::GetCurrentBuffer);
+  registry->Register(Parser::SetLazyHeaders);
+  registry->Register(Parser::SetBatchMode);
+  HeaderSlices::RegisterExternalReferences(registry);
+  registry->Register(SerializeResponseHead);
   registry->Register(ConnectionsList::New);
   registry->Register(ConnectionsList::All);
   registry->Register(ConnectionsList::Idle);
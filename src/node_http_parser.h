@@ -0,0 +1,101 @@
+#ifndef SRC_NODE_HTTP_PARSER_H_
+#define SRC_NODE_HTTP_PARSER_H_
+
+#if defined(NODE_WANT_INTERNALS) && NODE_WANT_INTERNALS
+
+#include <array>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "node_snapshotable.h"
+#include "util.h"
+#include "v8.h"
+
+namespace node {
+namespace http_parser {  // NOLINT(build/namespaces)
+
+// Direct-mapped cache of short one-byte strings, keyed on their exact bytes.
+// Header names, and many header values, repeat from one message to the next;
+// handing out the string created the first time saves an allocation and a
+// copy per header. A collision simply replaces the older entry.
+template <size_t kSlots, size_t kMaxLength>
+class HeaderStringCache {
+ public:
+  static_assert((kSlots & (kSlots - 1)) == 0, "kSlots must be a power of 2");
+
+  v8::Local<v8::String> Get(v8::Isolate* isolate,
+                            const char* str,
+                            size_t size) {
+    if (size == 0) return v8::String::Empty(isolate);
+    if (size > kMaxLength) return OneByteString(isolate, str, size);
+
+    Entry& entry = entries_[Hash(str, size) & (kSlots - 1)];
+    if (!entry.string.IsEmpty() && entry.key.size() == size &&
+        memcmp(entry.key.data(), str, size) == 0) {
+      return entry.string.Get(isolate);
+    }
+
+    v8::Local<v8::String> string = OneByteString(isolate, str, size);
+    entry.key.assign(str, size);
+    entry.string.Reset(isolate, string);
+    return string;
+  }
+
+  void Clear() {
+    for (Entry& entry : entries_) {
+      entry.key.clear();
+      entry.string.Reset();
+    }
+  }
+
+  size_t SelfSize() const {
+    size_t size = sizeof(*this);
+    for (const Entry& entry : entries_) size += entry.key.capacity();
+    return size;
+  }
+
+ private:
+  static uint32_t Hash(const char* str, size_t size) {
+    // FNV-1a
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < size; i++) {
+      hash ^= static_cast<uint8_t>(str[i]);
+      hash *= 16777619u;
+    }
+    return hash;
+  }
+
+  struct Entry {
+    std::string key;
+    v8::Global<v8::String> string;
+  };
+  std::array<Entry, kSlots> entries_;
+};
+
+class BindingData : public SnapshotableObject {
+ public:
+  BindingData(Realm* realm, v8::Local<v8::Object> obj);
+
+  using InternalFieldInfo = InternalFieldInfoBase;
+
+  SET_BINDING_ID(http_parser_binding_data)
+  SERIALIZABLE_OBJECT_METHODS()
+
+  std::vector<char> parser_buffer;
+  bool parser_buffer_in_use = false;
+
+  // Shared by all parsers of the realm.
+  HeaderStringCache<256, 64> header_names;
+  HeaderStringCache<256, 128> header_values;
+
+  void MemoryInfo(MemoryTracker* tracker) const override;
+  SET_SELF_SIZE(BindingData)
+  SET_MEMORY_INFO_NAME(BindingData)
+};
+
+}  // namespace http_parser
+}  // namespace node
+
+#endif  // defined(NODE_WANT_INTERNALS) && NODE_WANT_INTERNALS
+
+#endif  // SRC_NODE_HTTP_PARSER_H_
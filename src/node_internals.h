@@ -36,6 +36,7 @@
 #include <cstdint>
 #include <cstdlib>
 
+#include <optional>
 #include <string>
 #include <vector>
 
@@ -120,6 +121,8 @@ v8::MaybeLocal<v8::Object> InitializePrivateSymbols(
 
 class NodeArrayBufferAllocator : public ArrayBufferAllocator {
  public:
+  NodeArrayBufferAllocator();
+
   inline uint32_t* zero_fill_field() { return &zero_fill_field_; }
 
   void* Allocate(size_t size) override;  // Defined in src/node.cc
@@ -138,8 +141,12 @@ class NodeArrayBufferAllocator : public ArrayBufferAllocator {
   }
 
  private:
+  inline void MaybeAdviseHugePages(void* data, size_t size);
+
   uint32_t zero_fill_field_ = 1;  // Boolean but exposed as uint32 to JS land.
   std::atomic<size_t> total_mem_usage_ {0};
+  // Allocations at least this large are backed by huge pages if possible.
+  size_t huge_page_threshold_;
 
   // Delegate to V8's allocator for compatibility with the V8 memory cage.
   std::unique_ptr<v8::ArrayBuffer::Allocator> allocator_{
@@ -272,6 +279,26 @@ class InternalCallbackScope {
   v8::Global<v8::Value> prior_context_frame_;
 };
 
+// Processes the nextTick and microtask queues once when it is destroyed,
+// rather than once for each of the callbacks that run while it is active, if
+// --coalesce-task-queues is set. Otherwise, this does nothing. Meant for code
+// that delivers a batch of callbacks from a single event loop callback.
+//
+// When coalescing, the ticks and microtasks queued by a callback of the
+// batch run after the remaining callbacks of the batch, but before the event
+// loop runs any other callback. They still run in the order in which they
+// were queued, and nextTick callbacks still run before promise callbacks.
+// Callbacks that are already inside another callback scope are unaffected.
+class CallbackBatchScope {
+ public:
+  CallbackBatchScope(Environment* env, v8::Local<v8::Object> object);
+  CallbackBatchScope(const CallbackBatchScope&) = delete;
+  CallbackBatchScope& operator=(const CallbackBatchScope&) = delete;
+
+ private:
+  std::optional<InternalCallbackScope> scope_;
+};
+
 class DebugSealHandleScope {
  public:
   explicit inline DebugSealHandleScope(v8::Isolate* isolate = nullptr)
@@ -286,14 +313,19 @@ class DebugSealHandleScope {
 #endif
 };
 
-class ThreadPoolWork {
+class ThreadPoolWork : public ThreadPoolWorkLimiter::Work {
  public:
-  explicit inline ThreadPoolWork(Environment* env, const char* type)
-      : env_(env), type_(type) {
+  inline ThreadPoolWork(
+      Environment* env,
+      const char* type,
+      ThreadPoolWorkClass work_class = ThreadPoolWorkClass::kUser)
+      : env_(env), type_(type), work_class_(work_class) {
     CHECK_NOT_NULL(env);
   }
   inline virtual ~ThreadPoolWork() = default;
 
+  // The work may be held back by the Environment's ThreadPoolWorkLimiter
+  // before it is submitted to libuv.
   inline void ScheduleWork();
   inline int CancelWork();
 
@@ -301,11 +333,20 @@ class ThreadPoolWork {
   virtual void AfterThreadPoolWork(int status) = 0;
 
   Environment* env() const { return env_; }
+  ThreadPoolWorkClass work_class() const { return work_class_; }
 
  private:
+  int SubmitWork() override;
+  void OnSubmitError(int status) override;
+
   Environment* env_;
   uv_work_t work_req_;
   const char* type_;
+  ThreadPoolWorkClass work_class_;
+  // Set on the threadpool thread when metrics are enabled, and read in the
+  // after-work callback.
+  uint64_t start_time_ = 0;
+  uint64_t end_time_ = 0;
 };
 
 #define TRACING_CATEGORY_NODE "node"
@@ -419,9 +460,13 @@ class DiagnosticFilename {
 };
 
 namespace heap {
-v8::Maybe<void> WriteSnapshot(Environment* env,
-                              const char* filename,
-                              v8::HeapProfiler::HeapSnapshotOptions options);
+enum class SnapshotCompression { kNone, kZstd };
+
+v8::Maybe<void> WriteSnapshot(
+    Environment* env,
+    const char* filename,
+    v8::HeapProfiler::HeapSnapshotOptions options,
+    SnapshotCompression compression = SnapshotCompression::kNone);
 }
 
 namespace heap {
@@ -0,0 +1,360 @@
+#include "node_json.h"
+#include "env-inl.h"
+#include "node_errors.h"
+#include "node_external_reference.h"
+#include "simdjson.h"
+#include "simdutf.h"
+#include "util-inl.h"
+
+#include <cstdlib>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace node {
+namespace json {
+
+using v8::Array;
+using v8::Boolean;
+using v8::Context;
+using v8::Exception;
+using v8::FunctionCallbackInfo;
+using v8::Isolate;
+using v8::Local;
+using v8::LocalVector;
+using v8::MaybeLocal;
+using v8::NewStringType;
+using v8::Null;
+using v8::Number;
+using v8::Object;
+using v8::String;
+using v8::Undefined;
+using v8::Value;
+
+namespace {
+
+// Builds the V8 values of a simdjson on-demand document while iterating
+// over it, so that only the values and none of the intermediate tokens are
+// materialized.
+class ValueBuilder {
+ public:
+  explicit ValueBuilder(Local<Context> context)
+      : isolate_(Isolate::GetCurrent()), context_(context) {}
+
+  // T is simdjson::ondemand::document or simdjson::ondemand::value, which
+  // have the same accessors.
+  template <typename T>
+  MaybeLocal<Value> Build(T* value) {
+    simdjson::ondemand::json_type type;
+    if (value->type().get(type)) return Fail();
+    switch (type) {
+      case simdjson::ondemand::json_type::object:
+        return BuildObject(value);
+      case simdjson::ondemand::json_type::array:
+        return BuildArray(value);
+      case simdjson::ondemand::json_type::string: {
+        // Lone surrogates, which JSON.parse() keeps, become U+FFFD because
+        // they can't be represented in UTF-8.
+        std::string_view string;
+        if (value->get_string(true).get(string)) return Fail();
+        return NewString(string, NewStringType::kNormal);
+      }
+      case simdjson::ondemand::json_type::number: {
+        double number;
+        if (value->get_double().get(number)) {
+          // Integers that do not fit into 64 bits, which JSON.parse()
+          // rounds like any other number.
+          std::string_view token;
+          if (!GetRawToken(value->raw_json_token(), &token)) return Fail();
+          number = std::strtod(std::string(token).c_str(), nullptr);
+        }
+        return Number::New(isolate_, number);
+      }
+      case simdjson::ondemand::json_type::boolean: {
+        bool boolean;
+        if (value->get_bool().get(boolean)) return Fail();
+        return Boolean::New(isolate_, boolean);
+      }
+      case simdjson::ondemand::json_type::null: {
+        bool is_null;
+        if (value->is_null().get(is_null) || !is_null) return Fail();
+        return Null(isolate_);
+      }
+      default:
+        return Fail();
+    }
+  }
+
+  MaybeLocal<Value> Fail(
+      simdjson::error_code error = simdjson::error_code::TAPE_ERROR) {
+    if (error_ == simdjson::error_code::SUCCESS) error_ = error;
+    return {};
+  }
+
+  simdjson::error_code error() const { return error_; }
+
+ private:
+  template <typename T>
+  MaybeLocal<Value> BuildObject(T* value) {
+    simdjson::ondemand::object object;
+    if (value->get_object().get(object)) return Fail();
+    Local<Object> result = Object::New(isolate_);
+    for (auto field : object) {
+      std::string_view key;
+      simdjson::ondemand::value field_value;
+      if (field.unescaped_key(true).get(key) ||
+          field.value().get(field_value)) {
+        return Fail();
+      }
+      // Like JSON.parse(), keys are internalized, which makes the lookups
+      // of the properties faster, and a key that appears more than once
+      // holds the last value. CreateDataProperty() also defines "__proto__"
+      // as an own property, like JSON.parse().
+      Local<String> name;
+      Local<Value> element;
+      if (!NewString(key, NewStringType::kInternalized).ToLocal(&name) ||
+          !Build(&field_value).ToLocal(&element) ||
+          result->CreateDataProperty(context_, name, element).IsNothing()) {
+        return Fail();
+      }
+    }
+    return result;
+  }
+
+  template <typename T>
+  MaybeLocal<Value> BuildArray(T* value) {
+    simdjson::ondemand::array array;
+    if (value->get_array().get(array)) return Fail();
+    LocalVector<Value> elements(isolate_);
+    for (auto element_result : array) {
+      simdjson::ondemand::value element_value;
+      Local<Value> element;
+      if (element_result.get(element_value) ||
+          !Build(&element_value).ToLocal(&element)) {
+        return Fail();
+      }
+      elements.push_back(element);
+    }
+    return Array::New(isolate_, elements.data(), elements.size());
+  }
+
+  // value::raw_json_token() can't fail, document::raw_json_token() can.
+  static bool GetRawToken(std::string_view token, std::string_view* out) {
+    *out = token;
+    return true;
+  }
+  static bool GetRawToken(simdjson::simdjson_result<std::string_view> token,
+                          std::string_view* out) {
+    return !std::move(token).get(*out);
+  }
+
+  MaybeLocal<String> NewString(std::string_view string, NewStringType type) {
+    // ASCII is by far the most common, and creating a one-byte string
+    // from it needs no decoding.
+    if (simdutf::validate_ascii(string.data(), string.size())) {
+      return String::NewFromOneByte(
+          isolate_,
+          reinterpret_cast<const uint8_t*>(string.data()),
+          type,
+          static_cast<int>(string.size()));
+    }
+    return String::NewFromUtf8(
+        isolate_, string.data(), type, static_cast<int>(string.size()));
+  }
+
+  Isolate* isolate_;
+  Local<Context> context_;
+  simdjson::error_code error_ = simdjson::error_code::SUCCESS;
+};
+
+void ThrowSyntaxError(Isolate* isolate, simdjson::error_code error) {
+  std::string message = "Invalid JSON: ";
+  message += simdjson::error_message(error);
+  isolate->ThrowException(
+      Exception::SyntaxError(OneByteString(isolate, message)));
+}
+
+// Parses a copy of the input with the padding that simdjson needs, as it
+// reads up to SIMDJSON_PADDING bytes past the end of the input.
+class PaddedDocument {
+ public:
+  simdjson::error_code Iterate(std::string_view json) {
+    padded_.reserve(json.size() + simdjson::SIMDJSON_PADDING);
+    padded_.append(json);
+    padded_.append(simdjson::SIMDJSON_PADDING, ' ');
+    simdjson::padded_string_view json_view(
+        padded_.data(), json.size(), padded_.size());
+    return parser_.iterate(json_view).get(document_);
+  }
+
+  simdjson::ondemand::document* document() { return &document_; }
+
+ private:
+  std::string padded_;
+  simdjson::ondemand::parser parser_;
+  simdjson::ondemand::document document_;
+};
+
+// Throws the SyntaxError for a failed build, unless creating a V8 value
+// failed and an exception is already pending.
+void ThrowBuildError(Isolate* isolate,
+                     const ValueBuilder& builder,
+                     simdjson::error_code fallback) {
+  if (isolate->HasPendingException()) return;
+  ThrowSyntaxError(isolate,
+                   builder.error() != simdjson::error_code::SUCCESS
+                       ? builder.error()
+                       : fallback);
+}
+
+}  // namespace
+
+MaybeLocal<Value> Parse(Local<Context> context, std::string_view json) {
+  Isolate* isolate = Isolate::GetCurrent();
+  PaddedDocument padded;
+  simdjson::error_code error = padded.Iterate(json);
+  if (error) {
+    ThrowSyntaxError(isolate, error);
+    return {};
+  }
+
+  simdjson::ondemand::document* document = padded.document();
+  ValueBuilder builder(context);
+  Local<Value> result;
+  if (!builder.Build(document).ToLocal(&result) || !document->at_end()) {
+    ThrowBuildError(isolate, builder, simdjson::error_code::TRAILING_CONTENT);
+    return {};
+  }
+  return result;
+}
+
+MaybeLocal<Array> Query(Local<Context> context,
+                        std::string_view json,
+                        const std::vector<std::string>& pointers) {
+  Isolate* isolate = Isolate::GetCurrent();
+  PaddedDocument padded;
+  simdjson::error_code error = padded.Iterate(json);
+  if (error) {
+    ThrowSyntaxError(isolate, error);
+    return {};
+  }
+
+  simdjson::ondemand::document* document = padded.document();
+  ValueBuilder builder(context);
+  LocalVector<Value> results(isolate);
+  results.reserve(pointers.size());
+  for (const std::string& pointer : pointers) {
+    Local<Value> result;
+    if (pointer.empty()) {
+      // The whole document, which may also be a scalar.
+      document->rewind();
+      if (!builder.Build(document).ToLocal(&result)) {
+        ThrowBuildError(isolate, builder, simdjson::error_code::TAPE_ERROR);
+        return {};
+      }
+      results.push_back(result);
+      continue;
+    }
+
+    // at_pointer() rewinds the document, so the pointers can be in any
+    // order, but each of them only parses the input up to its value.
+    simdjson::ondemand::value value;
+    error = document->at_pointer(pointer).get(value);
+    switch (error) {
+      case simdjson::error_code::SUCCESS:
+        if (!builder.Build(&value).ToLocal(&result)) {
+          ThrowBuildError(isolate, builder, simdjson::error_code::TAPE_ERROR);
+          return {};
+        }
+        results.push_back(result);
+        break;
+      case simdjson::error_code::NO_SUCH_FIELD:
+      case simdjson::error_code::INDEX_OUT_OF_BOUNDS:
+      case simdjson::error_code::INCORRECT_TYPE:
+        results.push_back(Undefined(isolate));
+        break;
+      case simdjson::error_code::INVALID_JSON_POINTER:
+        THROW_ERR_INVALID_ARG_VALUE(
+            isolate, "Invalid JSON pointer: %s", pointer);
+        return {};
+      default:
+        ThrowSyntaxError(isolate, error);
+        return {};
+    }
+  }
+  return Array::New(isolate, results.data(), results.size());
+}
+
+// parse(buffer) returns JSON.parse() of the UTF-8 contents of a Buffer or
+// any other ArrayBufferView, without creating a string for them first.
+static void ParseBuffer(const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+  if (!args[0]->IsArrayBufferView()) {
+    THROW_ERR_INVALID_ARG_TYPE(env, "The \"buffer\" argument must be a view");
+    return;
+  }
+  ArrayBufferViewContents<char> contents(args[0]);
+  Local<Value> result;
+  if (Parse(env->context(), {contents.data(), contents.length()})
+          .ToLocal(&result)) {
+    args.GetReturnValue().Set(result);
+  }
+}
+
+// query(buffer, pointers) returns an array with the value at each of the
+// JSON pointers (RFC 6901) in the UTF-8 contents of a Buffer, or undefined
+// where there is no value. Only the parts of the input that lead to the
+// values are parsed, so the rest of it is neither materialized nor fully
+// validated.
+static void QueryBuffer(const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+  Isolate* isolate = env->isolate();
+  if (!args[0]->IsArrayBufferView()) {
+    THROW_ERR_INVALID_ARG_TYPE(env, "The \"buffer\" argument must be a view");
+    return;
+  }
+  if (!args[1]->IsArray()) {
+    THROW_ERR_INVALID_ARG_TYPE(env,
+                               "The \"pointers\" argument must be an array");
+    return;
+  }
+
+  Local<Array> pointer_array = args[1].As<Array>();
+  std::vector<std::string> pointers;
+  pointers.reserve(pointer_array->Length());
+  for (uint32_t i = 0; i < pointer_array->Length(); i++) {
+    Local<Value> pointer;
+    if (!pointer_array->Get(env->context(), i).ToLocal(&pointer)) return;
+    if (!pointer->IsString()) {
+      THROW_ERR_INVALID_ARG_TYPE(env, "pointers[%u] must be a string", i);
+      return;
+    }
+    pointers.emplace_back(Utf8Value(isolate, pointer).ToString());
+  }
+
+  ArrayBufferViewContents<char> contents(args[0]);
+  Local<Array> result;
+  if (Query(env->context(), {contents.data(), contents.length()}, pointers)
+          .ToLocal(&result)) {
+    args.GetReturnValue().Set(result);
+  }
+}
+
+static void Initialize(Local<Object> target,
+                       Local<Value> unused,
+                       Local<Context> context,
+                       void* priv) {
+  SetMethodNoSideEffect(context, target, "parse", ParseBuffer);
+  SetMethodNoSideEffect(context, target, "query", QueryBuffer);
+}
+
+static void RegisterExternalReferences(ExternalReferenceRegistry* registry) {
+  registry->Register(ParseBuffer);
+  registry->Register(QueryBuffer);
+}
+
+}  // namespace json
+}  // namespace node
+
+NODE_BINDING_CONTEXT_AWARE_INTERNAL(json, node::json::Initialize)
+NODE_BINDING_EXTERNAL_REFERENCE(json, node::json::RegisterExternalReferences)
@@ -0,0 +1,34 @@
+#ifndef SRC_NODE_JSON_H_
+#define SRC_NODE_JSON_H_
+
+#if defined(NODE_WANT_INTERNALS) && NODE_WANT_INTERNALS
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "v8.h"
+
+namespace node {
+namespace json {
+
+// Parses |json|, which is UTF-8, into the same value that JSON.parse()
+// returns for it, using simdjson instead of converting the whole input to
+// a JS string first. Throws a SyntaxError if the input is not valid JSON.
+v8::MaybeLocal<v8::Value> Parse(v8::Local<v8::Context> context,
+                                std::string_view json);
+
+// Returns the values at |pointers|, which are JSON pointers (RFC 6901), in
+// |json|, with undefined for the pointers that don't point to a value.
+// Only the parts of the input leading to the values are parsed, so that
+// reading a few fields of a large document is cheap.
+v8::MaybeLocal<v8::Array> Query(v8::Local<v8::Context> context,
+                                std::string_view json,
+                                const std::vector<std::string>& pointers);
+
+}  // namespace json
+}  // namespace node
+
+#endif  // defined(NODE_WANT_INTERNALS) && NODE_WANT_INTERNALS
+
+#endif  // SRC_NODE_JSON_H_
@@ -8,6 +8,7 @@
 #include "node_external_reference.h"
 #include "node_internals.h"
 #include "node_options-inl.h"
+#include "node_prestart.h"
 #include "node_realm.h"
 #include "node_sea.h"
 #include "node_snapshot_builder.h"
@@ -91,12 +92,33 @@ ExitCode NodeMainInstance::Run() {
   HandleScope handle_scope(isolate_);
 
   ExitCode exit_code = ExitCode::kNoFailure;
+#ifndef _WIN32
+  // Everything up to here is the same for every job.
+  if (per_process::cli_options->prestart_fd != -1) {
+    if (!prestart::WaitForJob(per_process::cli_options->prestart_fd,
+                              &args_,
+                              &exec_args_,
+                              &exit_code)) {
+      return exit_code;
+    }
+  }
+#endif  // _WIN32
   DeleteFnPtr<Environment, FreeEnvironment> env =
       CreateMainEnvironment(&exit_code);
   CHECK_NOT_NULL(env);
 
   Context::Scope context_scope(env->context());
   Run(&exit_code, env.get());
+
+#if !defined(LEAK_SANITIZER)
+  // Everything that FreeEnvironment() would free is reclaimed by the
+  // operating system anyway. Skipping that makes exiting with many open
+  // handles or objects immediate, with the same guarantees as process.exit().
+  if (per_process::cli_options->fast_exit) {
+    RunAtExit(env.get());
+    DefaultProcessExitHandlerInternal(env.get(), exit_code);
+  }
+#endif
   return exit_code;
 }
 
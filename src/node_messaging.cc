@@ -14,6 +14,7 @@ using node::contextify::ContextifyContext;
 using node::errors::TryCatchScope;
 using v8::Array;
 using v8::ArrayBuffer;
+using v8::ArrayBufferView;
 using v8::BackingStore;
 using v8::CompiledWasmModule;
 using v8::Context;
@@ -23,6 +24,7 @@ using v8::FunctionCallbackInfo;
 using v8::FunctionTemplate;
 using v8::Global;
 using v8::HandleScope;
+using v8::Integer;
 using v8::Isolate;
 using v8::Just;
 using v8::JustVoid;
@@ -30,6 +32,7 @@ using v8::Local;
 using v8::LocalVector;
 using v8::Maybe;
 using v8::MaybeLocal;
+using v8::NewStringType;
 using v8::Nothing;
 using v8::Object;
 using v8::ObjectTemplate;
@@ -67,6 +70,242 @@ bool Message::IsCloseMessage() const {
 
 namespace {
 
+// Messages that consist only of a string, an ArrayBuffer or a view on one,
+// or a short array of those, are by far the most common ones, and do not
+// need the generality of the V8 ValueSerializer. They are encoded in a
+// simpler format that is written and read with a single pass over the
+// payload. V8-serialized payloads always start with a version tag (0xFF),
+// so the first byte tells the two formats apart.
+constexpr uint8_t kFastMessageTag = 0x00;
+constexpr uint32_t kMaxFastMessageArrayLength = 16;
+
+#define FAST_MESSAGE_VIEW_TYPES(V)                                            \
+  V(Uint8Array)                                                               \
+  V(Int8Array)                                                                \
+  V(Uint8ClampedArray)                                                        \
+  V(Uint16Array)                                                              \
+  V(Int16Array)                                                               \
+  V(Uint32Array)                                                              \
+  V(Int32Array)                                                               \
+  V(Float32Array)                                                             \
+  V(Float64Array)                                                             \
+  V(BigInt64Array)                                                            \
+  V(BigUint64Array)                                                           \
+  V(DataView)
+
+enum class FastMessageViewType : uint8_t {
+#define V(Type) k##Type,
+  FAST_MESSAGE_VIEW_TYPES(V)
+#undef V
+  kUnsupported
+};
+
+enum class FastMessageValueType : uint8_t {
+  kOneByteString,
+  kTwoByteString,
+  kArrayBuffer,
+  kArrayBufferView,
+};
+
+// Writes the fast message format. Without a target buffer, it only
+// computes the size of the payload.
+class FastMessageWriter {
+ public:
+  explicit FastMessageWriter(char* data = nullptr) : data_(data) {}
+
+  void WriteBytes(const void* source, size_t length) {
+    if (data_ != nullptr && length > 0)
+      memcpy(data_ + offset_, source, length);
+    offset_ += length;
+  }
+
+  template <typename T>
+  void WriteValue(T value) {
+    WriteBytes(&value, sizeof(value));
+  }
+
+  // Reserves |length| bytes, aligned to |alignment|, and returns a pointer
+  // to them (or nullptr when only computing the size).
+  char* Reserve(size_t length, size_t alignment) {
+    offset_ = (offset_ + alignment - 1) & ~(alignment - 1);
+    char* result = data_ != nullptr ? data_ + offset_ : nullptr;
+    offset_ += length;
+    return result;
+  }
+
+  size_t size() const { return offset_; }
+
+ private:
+  char* data_;
+  size_t offset_ = 0;
+};
+
+class FastMessageReader {
+ public:
+  explicit FastMessageReader(const MallocedBuffer<char>& buffer)
+      : data_(buffer.data), size_(buffer.size) {}
+
+  template <typename T>
+  T ReadValue() {
+    T value;
+    memcpy(&value, Consume(sizeof(value), 1), sizeof(value));
+    return value;
+  }
+
+  const char* Consume(size_t length, size_t alignment) {
+    offset_ = (offset_ + alignment - 1) & ~(alignment - 1);
+    CHECK_LE(offset_, size_);
+    CHECK_LE(length, size_ - offset_);
+    const char* result = data_ + offset_;
+    offset_ += length;
+    return result;
+  }
+
+ private:
+  const char* data_;
+  size_t size_;
+  size_t offset_ = 0;
+};
+
+FastMessageViewType GetFastMessageViewType(Local<ArrayBufferView> view) {
+#define V(Type)                                                               \
+  if (view->Is##Type()) return FastMessageViewType::k##Type;
+  FAST_MESSAGE_VIEW_TYPES(V)
+#undef V
+  return FastMessageViewType::kUnsupported;
+}
+
+// Collects the values of a message that qualifies for the fast path, and
+// the ArrayBuffers that back them. As with the V8 serializer, each
+// ArrayBuffer appears once, no matter how many views refer to it, and it
+// is transferred if it is in the transfer list and copied otherwise.
+class FastMessageBuilder {
+ public:
+  FastMessageBuilder(Isolate* isolate,
+                     const LocalVector<ArrayBuffer>& transferred)
+      : isolate_(isolate),
+        transferred_(transferred),
+        buffers_(isolate),
+        values_(isolate) {}
+
+  // Returns false if |value| cannot be encoded in the fast format.
+  bool AddValue(Local<Value> value) {
+    uint32_t slot = 0;
+    FastMessageViewType view_type = FastMessageViewType::kUnsupported;
+    if (value->IsObject()) {
+      // Repeated objects would have to keep their identity.
+      if (std::find(values_.begin(), values_.end(), value) != values_.end())
+        return false;
+      Local<ArrayBuffer> buffer;
+      if (value->IsArrayBuffer()) {
+        buffer = value.As<ArrayBuffer>();
+      } else if (value->IsArrayBufferView()) {
+        Local<ArrayBufferView> view = value.As<ArrayBufferView>();
+        view_type = GetFastMessageViewType(view);
+        if (view_type == FastMessageViewType::kUnsupported) return false;
+        buffer = view->Buffer();
+        if (Local<Value>(buffer)->IsSharedArrayBuffer()) return false;
+      } else {
+        return false;
+      }
+      if (!AddBuffer(buffer).To(&slot)) return false;
+    } else if (!value->IsString()) {
+      return false;
+    }
+    values_.push_back(value);
+    slots_.push_back(slot);
+    view_types_.push_back(view_type);
+    return true;
+  }
+
+  void Encode(FastMessageWriter* writer, bool is_array) const {
+    writer->WriteValue(kFastMessageTag);
+    writer->WriteValue(static_cast<uint8_t>(is_array));
+
+    writer->WriteValue(static_cast<uint32_t>(buffers_.size()));
+    for (size_t i = 0; i < buffers_.size(); ++i) {
+      Local<ArrayBuffer> buffer = buffers_[i];
+      writer->WriteValue(transfer_ids_[i]);
+      if (transfer_ids_[i] != kCopied) continue;
+      writer->WriteValue(buffer->ByteLength());
+      writer->WriteBytes(buffer->Data(), buffer->ByteLength());
+    }
+
+    writer->WriteValue(static_cast<uint32_t>(values_.size()));
+    for (size_t i = 0; i < values_.size(); ++i) {
+      Local<Value> value = values_[i];
+      if (value->IsString()) {
+        Local<String> string = value.As<String>();
+        uint32_t length = string->Length();
+        if (string->IsOneByte()) {
+          writer->WriteValue(FastMessageValueType::kOneByteString);
+          writer->WriteValue(length);
+          char* chars = writer->Reserve(length, 1);
+          if (chars != nullptr) {
+            string->WriteOneByteV2(
+                isolate_, 0, length, reinterpret_cast<uint8_t*>(chars));
+          }
+        } else {
+          writer->WriteValue(FastMessageValueType::kTwoByteString);
+          writer->WriteValue(length);
+          char* chars = writer->Reserve(length * sizeof(uint16_t),
+                                        alignof(uint16_t));
+          if (chars != nullptr) {
+            string->WriteV2(
+                isolate_, 0, length, reinterpret_cast<uint16_t*>(chars));
+          }
+        }
+      } else if (value->IsArrayBuffer()) {
+        writer->WriteValue(FastMessageValueType::kArrayBuffer);
+        writer->WriteValue(slots_[i]);
+      } else {
+        Local<ArrayBufferView> view = value.As<ArrayBufferView>();
+        size_t length = value->IsTypedArray()
+                            ? value.As<v8::TypedArray>()->Length()
+                            : view->ByteLength();
+        writer->WriteValue(FastMessageValueType::kArrayBufferView);
+        writer->WriteValue(view_types_[i]);
+        writer->WriteValue(slots_[i]);
+        writer->WriteValue(view->ByteOffset());
+        writer->WriteValue(length);
+      }
+    }
+  }
+
+  static constexpr uint32_t kCopied = static_cast<uint32_t>(-1);
+
+ private:
+  Maybe<uint32_t> AddBuffer(Local<ArrayBuffer> buffer) {
+    // Detached and resizable buffers are left to the V8 serializer, which
+    // knows how to report or reproduce them.
+    if (buffer->WasDetached() || buffer->IsResizableByUserJavaScript())
+      return Nothing<uint32_t>();
+    auto it = std::find(buffers_.begin(), buffers_.end(), buffer);
+    if (it != buffers_.end())
+      return Just(static_cast<uint32_t>(it - buffers_.begin()));
+
+    auto transferred =
+        std::find(transferred_.begin(), transferred_.end(), buffer);
+    uint32_t transfer_id = kCopied;
+    if (transferred != transferred_.end()) {
+      transfer_id = static_cast<uint32_t>(transferred - transferred_.begin());
+    } else if (!buffer->IsDetachable()) {
+      return Nothing<uint32_t>();
+    }
+    buffers_.push_back(buffer);
+    transfer_ids_.push_back(transfer_id);
+    return Just(static_cast<uint32_t>(buffers_.size() - 1));
+  }
+
+  Isolate* isolate_;
+  const LocalVector<ArrayBuffer>& transferred_;
+  LocalVector<ArrayBuffer> buffers_;
+  std::vector<uint32_t> transfer_ids_;
+  LocalVector<Value> values_;
+  std::vector<uint32_t> slots_;
+  std::vector<FastMessageViewType> view_types_;
+};
+
 // This is used to tell V8 how to read transferred host objects, like other
 // `MessagePort`s and `SharedArrayBuffer`s, and make new JS objects out of them.
 class DeserializerDelegate : public ValueDeserializer::Delegate {
@@ -143,6 +382,10 @@ MaybeLocal<Value> Message::Deserialize(Environment* env,
   Context::Scope context_scope(context);
 
   CHECK(!IsCloseMessage());
+  if (main_message_buf_.size > 0 &&
+      static_cast<uint8_t>(main_message_buf_.data[0]) == kFastMessageTag) {
+    return DeserializeFast(env, context);
+  }
   if (port_list != nullptr && !transferables_.empty()) {
     // Need to create this outside of the EscapableHandleScope, but inside
     // the Context::Scope.
@@ -476,6 +719,13 @@ Maybe<bool> Message::Serialize(Environment* env,
   // Verify that we're not silently overwriting an existing message.
   CHECK(main_message_buf_.is_empty());
 
+  bool serialized_fast;
+  if (!SerializeFast(env, context, input, transfer_list_v)
+           .To(&serialized_fast)) {
+    return Nothing<bool>();
+  }
+  if (serialized_fast) return Just(true);
+
   SerializerDelegate delegate(env, context, this);
   ValueSerializer serializer(env->isolate(), &delegate);
   delegate.serializer = &serializer;
@@ -613,6 +863,173 @@ Maybe<bool> Message::Serialize(Environment* env,
   return Just(true);
 }
 
+Maybe<bool> Message::SerializeFast(Environment* env,
+                                   Local<Context> context,
+                                   Local<Value> input,
+                                   const TransferList& transfer_list_v) {
+  Isolate* isolate = env->isolate();
+  if (!input->IsString() && !input->IsArrayBuffer() &&
+      !input->IsArrayBufferView() && !input->IsArray()) {
+    return Just(false);
+  }
+
+  // Only plain ArrayBuffers may be transferred; anything else, including
+  // invalid transfer lists, is validated and reported by the slow path.
+  LocalVector<ArrayBuffer> transferred(isolate);
+  for (uint32_t i = 0; i < transfer_list_v.length(); ++i) {
+    Local<Value> entry = transfer_list_v[i];
+    if (!entry->IsArrayBuffer()) return Just(false);
+    Local<ArrayBuffer> ab = entry.As<ArrayBuffer>();
+    if (!ab->IsDetachable() || ab->WasDetached() ||
+        std::find(transferred.begin(), transferred.end(), ab) !=
+            transferred.end()) {
+      return Just(false);
+    }
+    bool untransferable;
+    if (!ab->HasPrivate(context, env->untransferable_object_private_symbol())
+             .To(&untransferable)) {
+      return Nothing<bool>();
+    }
+    if (untransferable) return Just(false);
+    transferred.push_back(ab);
+  }
+
+  FastMessageBuilder builder(isolate, transferred);
+  bool is_array = input->IsArray();
+  if (is_array) {
+    Local<Array> array = input.As<Array>();
+    uint32_t length = array->Length();
+    if (length > kMaxFastMessageArrayLength) return Just(false);
+    // Holes and extra properties need the V8 serializer.
+    Local<Array> names;
+    if (!array->GetOwnPropertyNames(context).ToLocal(&names))
+      return Nothing<bool>();
+    if (names->Length() != length) return Just(false);
+    for (uint32_t i = 0; i < length; ++i) {
+      bool has_element;
+      if (!array->HasRealIndexedProperty(context, i).To(&has_element))
+        return Nothing<bool>();
+      if (!has_element) return Just(false);
+      Local<Value> element;
+      if (!array->Get(context, i).ToLocal(&element)) return Nothing<bool>();
+      if (!builder.AddValue(element)) return Just(false);
+    }
+  } else if (!builder.AddValue(input)) {
+    return Just(false);
+  }
+
+  FastMessageWriter size_counter;
+  builder.Encode(&size_counter, is_array);
+  MallocedBuffer<char> buffer(size_counter.size());
+  FastMessageWriter writer(buffer.data);
+  builder.Encode(&writer, is_array);
+  CHECK_EQ(writer.size(), buffer.size);
+
+  for (Local<ArrayBuffer> ab : transferred) {
+    std::shared_ptr<BackingStore> backing_store = ab->GetBackingStore();
+    if (ab->Detach(Local<Value>()).IsNothing()) {
+      array_buffers_.clear();
+      return Nothing<bool>();
+    }
+    array_buffers_.emplace_back(std::move(backing_store));
+  }
+  main_message_buf_ = std::move(buffer);
+  return Just(true);
+}
+
+MaybeLocal<Value> Message::DeserializeFast(Environment* env,
+                                           Local<Context> context) {
+  Isolate* isolate = env->isolate();
+  EscapableHandleScope handle_scope(isolate);
+  FastMessageReader reader(main_message_buf_);
+  CHECK_EQ(reader.ReadValue<uint8_t>(), kFastMessageTag);
+  bool is_array = reader.ReadValue<uint8_t>() != 0;
+
+  LocalVector<ArrayBuffer> buffers(isolate);
+  uint32_t buffer_count = reader.ReadValue<uint32_t>();
+  for (uint32_t i = 0; i < buffer_count; ++i) {
+    uint32_t transfer_id = reader.ReadValue<uint32_t>();
+    if (transfer_id != FastMessageBuilder::kCopied) {
+      CHECK_LT(transfer_id, array_buffers_.size());
+      CHECK(array_buffers_[transfer_id]);
+      buffers.push_back(
+          ArrayBuffer::New(isolate, std::move(array_buffers_[transfer_id])));
+      continue;
+    }
+    size_t length = reader.ReadValue<size_t>();
+    const char* data = reader.Consume(length, 1);
+    Local<ArrayBuffer> ab = ArrayBuffer::New(isolate, length);
+    if (length > 0) memcpy(ab->Data(), data, length);
+    buffers.push_back(ab);
+  }
+
+  LocalVector<Value> values(isolate);
+  uint32_t value_count = reader.ReadValue<uint32_t>();
+  for (uint32_t i = 0; i < value_count; ++i) {
+    Local<Value> value;
+    switch (reader.ReadValue<FastMessageValueType>()) {
+      case FastMessageValueType::kOneByteString: {
+        uint32_t length = reader.ReadValue<uint32_t>();
+        const char* chars = reader.Consume(length, 1);
+        if (!String::NewFromOneByte(isolate,
+                                    reinterpret_cast<const uint8_t*>(chars),
+                                    NewStringType::kNormal,
+                                    length)
+                 .ToLocal(&value)) {
+          return {};
+        }
+        break;
+      }
+      case FastMessageValueType::kTwoByteString: {
+        uint32_t length = reader.ReadValue<uint32_t>();
+        const char* chars =
+            reader.Consume(length * sizeof(uint16_t), alignof(uint16_t));
+        if (!String::NewFromTwoByte(isolate,
+                                    reinterpret_cast<const uint16_t*>(chars),
+                                    NewStringType::kNormal,
+                                    length)
+                 .ToLocal(&value)) {
+          return {};
+        }
+        break;
+      }
+      case FastMessageValueType::kArrayBuffer: {
+        uint32_t slot = reader.ReadValue<uint32_t>();
+        CHECK_LT(slot, buffers.size());
+        value = buffers[slot];
+        break;
+      }
+      case FastMessageValueType::kArrayBufferView: {
+        FastMessageViewType type = reader.ReadValue<FastMessageViewType>();
+        uint32_t slot = reader.ReadValue<uint32_t>();
+        size_t byte_offset = reader.ReadValue<size_t>();
+        size_t length = reader.ReadValue<size_t>();
+        CHECK_LT(slot, buffers.size());
+        switch (type) {
+#define V(Type)                                                               \
+  case FastMessageViewType::k##Type:                                          \
+    value = v8::Type::New(buffers[slot], byte_offset, length);                \
+    break;
+          FAST_MESSAGE_VIEW_TYPES(V)
+#undef V
+          default:
+            UNREACHABLE();
+        }
+        break;
+      }
+      default:
+        UNREACHABLE();
+    }
+    values.push_back(value);
+  }
+
+  if (!is_array) {
+    CHECK_EQ(values.size(), 1);
+    return handle_scope.Escape(values[0]);
+  }
+  return handle_scope.Escape(Array::New(isolate, values.data(), values.size()));
+}
+
 void Message::MemoryInfo(MemoryTracker* tracker) const {
   tracker->TrackField("array_buffers_", array_buffers_);
   tracker->TrackField("shared_array_buffers", shared_array_buffers_);
@@ -636,9 +1053,15 @@ void MessagePortData::MemoryInfo(MemoryTracker* tracker) const {
 void MessagePortData::AddToIncomingQueue(std::shared_ptr<Message> message) {
   // This function will be called by other threads.
   Mutex::ScopedLock lock(mutex_);
+  bool was_empty = incoming_messages_.empty();
   incoming_messages_.emplace_back(std::move(message));
 
-  if (owner_ != nullptr) {
+  // The owner drains the queue until it is empty once it has been notified,
+  // and re-triggers itself whenever it stops early, so only a message that
+  // arrives in an empty queue needs to wake it up. That keeps high-rate
+  // senders from paying for a uv_async_send() (and a write to the loop's
+  // wakeup fd) per message while the receiver is busy.
+  if (owner_ != nullptr && was_empty) {
     Debug(owner_, "Adding message to incoming queue");
     owner_->TriggerAsync();
   }
@@ -829,6 +1252,12 @@ void MessagePort::OnMessage(MessageProcessingMode mode) {
     processing_limit = std::numeric_limits<size_t>::max();
   }
 
+  Context::Scope context_scope(context);
+  CallbackBatchScope batch_scope(env(), object());
+
+  if (batch_size_ > 1 && mode == MessageProcessingMode::kNormalOperation)
+    return OnMessageBatch(context, processing_limit);
+
   // data_ can only ever be modified by the owner thread, so no need to lock.
   // However, the message port may be transferred while it is processing
   // messages, so we need to check that this handle still owns its `data_` field
@@ -894,6 +1323,77 @@ void MessagePort::OnMessage(MessageProcessingMode mode) {
   }
 }
 
+void MessagePort::OnMessageBatch(Local<Context> context,
+                                 size_t processing_limit) {
+  Isolate* isolate = env()->isolate();
+  // Like OnMessage(), but hands up to batch_size_ messages at a time to a
+  // single 'messagebatch' callback, as arrays of payloads and port lists.
+  while (data_) {
+    if (processing_limit == 0) {
+      TriggerAsync();
+      return;
+    }
+
+    HandleScope handle_scope(isolate);
+    Context::Scope context_scope(context);
+    Local<Function> emit_message = PersistentToLocal::Strong(emit_message_fn_);
+
+    LocalVector<Value> payloads(isolate);
+    LocalVector<Value> port_lists(isolate);
+    Local<Value> message_error;
+    bool failed = false;
+    bool drained = false;
+    while (data_ && payloads.size() < batch_size_ && processing_limit > 0) {
+      processing_limit--;
+      Local<Value> payload;
+      Local<Value> port_list = Undefined(isolate);
+      {
+        TryCatchScope try_catch(env());
+        if (!ReceiveMessage(context,
+                            MessageProcessingMode::kNormalOperation,
+                            &port_list)
+                 .ToLocal(&payload)) {
+          if (try_catch.HasCaught() && !try_catch.HasTerminated())
+            message_error = try_catch.Exception();
+          failed = true;
+          break;
+        }
+      }
+      if (payload == env()->no_message_symbol()) {
+        drained = true;
+        break;
+      }
+      // Without JS access, there is nothing to do but drain the queue.
+      if (!env()->can_call_into_js()) continue;
+      payloads.push_back(payload);
+      port_lists.push_back(port_list);
+    }
+
+    // Messages received before a failing one are still delivered first.
+    if (!payloads.empty()) {
+      Local<Value> argv[] = {
+          Array::New(isolate, payloads.data(), payloads.size()),
+          Array::New(isolate, port_lists.data(), port_lists.size()),
+          env()->messagebatch_string()};
+      if (MakeCallback(emit_message, arraysize(argv), argv).IsEmpty())
+        failed = true;
+    }
+
+    if (failed) {
+      if (!message_error.IsEmpty()) {
+        Local<Value> argv[] = {message_error,
+                               Undefined(isolate),
+                               env()->messageerror_string()};
+        USE(MakeCallback(emit_message, arraysize(argv), argv));
+      }
+      // Re-schedule OnMessage() execution in case of failure.
+      if (data_) TriggerAsync();
+      return;
+    }
+    if (drained) return;
+  }
+}
+
 void MessagePort::OnClose() {
   Debug(this, "MessagePort::OnClose()");
   if (data_) {
@@ -1141,6 +1641,16 @@ void MessagePort::Stop(const FunctionCallbackInfo<Value>& args) {
   port->Stop();
 }
 
+void MessagePort::SetBatchSize(const FunctionCallbackInfo<Value>& args) {
+  MessagePort* port;
+  CHECK(args[0]->IsObject());
+  ASSIGN_OR_RETURN_UNWRAP(&port, args[0].As<Object>());
+  CHECK(args[1]->IsUint32());
+  uint32_t batch_size = args[1].As<v8::Uint32>()->Value();
+  CHECK_GE(batch_size, 1);
+  port->batch_size_ = batch_size;
+}
+
 void MessagePort::Drain(const FunctionCallbackInfo<Value>& args) {
   MessagePort* port;
   ASSIGN_OR_RETURN_UNWRAP(&port, args[0].As<Object>());
@@ -1575,6 +2085,415 @@ Mutex SiblingGroup::groups_mutex_;
 
 namespace {
 
+class SharedRingBuffer;
+
+// The state of a SharedRingBuffer that is shared by all threads that have
+// a handle to it. It is a bounded queue of byte records that any number of
+// threads may write to and read from. The records are stored in a
+// SharedArrayBuffer backing store, each prefixed with its uint32_t length,
+// while the read offset and fill level live here, so that code with access
+// to the memory cannot make reads or writes go out of bounds.
+class SharedRingBufferData final : public MemoryRetainer {
+ public:
+  explicit SharedRingBufferData(std::shared_ptr<BackingStore> store)
+      : store_(std::move(store)), capacity_(store_->ByteLength()) {}
+
+  size_t capacity() const { return capacity_; }
+
+  // Appends a record. Returns false if there is not enough space for it.
+  bool Write(const char* data, size_t length);
+  enum class ReadResult { kRecord, kEmpty, kCorrupt };
+  // Removes the oldest record and returns it in a new backing store. The
+  // length prefix lives in memory that JS can write to, so a prefix that
+  // does not fit the fill level is reported as kCorrupt, and the unread
+  // records, whose boundaries can no longer be trusted, are discarded.
+  ReadResult Read(Isolate* isolate, std::unique_ptr<BackingStore>* record);
+  // Asks for |waiter| to be signalled once, as soon as a record can be read
+  // and/or a record of |length| bytes can be written.
+  void Wait(SharedRingBuffer* waiter, int signals, size_t length);
+  void RemoveWaiters(SharedRingBuffer* waiter);
+
+  static size_t RecordSize(size_t length) { return sizeof(uint32_t) + length; }
+
+  void MemoryInfo(MemoryTracker* tracker) const override {
+    tracker->TrackFieldWithSize("store", capacity_);
+  }
+  SET_MEMORY_INFO_NAME(SharedRingBufferData)
+  SET_SELF_SIZE(SharedRingBufferData)
+
+ private:
+  struct Waiter {
+    SharedRingBuffer* handle;
+    int signal;
+    size_t record_size;
+  };
+
+  void CopyIn(size_t offset, const void* source, size_t length);
+  void CopyOut(size_t offset, void* target, size_t length) const;
+  bool IsSatisfied(int signal, size_t record_size) const;
+  void NotifyWaiters();
+
+  Mutex mutex_;  // Protects all fields below.
+  const std::shared_ptr<BackingStore> store_;
+  const size_t capacity_;
+  size_t read_offset_ = 0;
+  size_t used_ = 0;
+  std::vector<Waiter> waiters_;
+};
+
+// A handle to a SharedRingBuffer on one thread. It can be cloned to other
+// threads through postMessage(), with all clones sharing the same ring.
+// Waiting for the ring to become readable or writable does not block: the
+// handle's uv_async_t is signalled by the thread that makes it so, and
+// then calls `this.onsignal(signals)`. The handle only keeps the event
+// loop alive while such a wait is pending.
+class SharedRingBuffer final : public HandleWrap {
+ public:
+  enum Signal : int { kReadable = 1, kWritable = 2 };
+
+  SharedRingBuffer(Environment* env,
+                   Local<Object> wrap,
+                   std::shared_ptr<SharedRingBufferData> data);
+
+  static Local<FunctionTemplate> GetConstructorTemplate(
+      IsolateData* isolate_data);
+  static BaseObjectPtr<SharedRingBuffer> Create(
+      Environment* env, std::shared_ptr<SharedRingBufferData> data);
+
+  // new SharedRingBuffer(capacity | sharedArrayBuffer)
+  static void New(const FunctionCallbackInfo<Value>& args);
+  // write(view): Returns false if the ring is full.
+  static void Write(const FunctionCallbackInfo<Value>& args);
+  // read(): Returns a Buffer, or undefined if the ring is empty.
+  static void Read(const FunctionCallbackInfo<Value>& args);
+  // waitReadable()
+  static void WaitReadable(const FunctionCallbackInfo<Value>& args);
+  // waitWritable(length)
+  static void WaitWritable(const FunctionCallbackInfo<Value>& args);
+
+  // Called with the ring's mutex held, from any thread.
+  void Notify(int signals) {
+    pending_signals_.fetch_or(signals);
+    CHECK_EQ(uv_async_send(&async_), 0);
+  }
+
+  void Close(Local<Value> close_callback = Local<Value>()) override {
+    // Once this returns, no other thread will signal this handle anymore.
+    data_->RemoveWaiters(this);
+    HandleWrap::Close(close_callback);
+  }
+
+  class SharedRingBufferTransferData : public TransferData {
+   public:
+    explicit SharedRingBufferTransferData(
+        std::shared_ptr<SharedRingBufferData> data)
+        : data_(std::move(data)) {}
+
+    BaseObjectPtr<BaseObject> Deserialize(
+        Environment* env,
+        Local<Context> context,
+        std::unique_ptr<TransferData> self) override {
+      if (context != env->context()) [[unlikely]] {
+        THROW_ERR_MESSAGE_TARGET_CONTEXT_UNAVAILABLE(env);
+        return {};
+      }
+      return Create(env, data_);
+    }
+
+    void MemoryInfo(MemoryTracker* tracker) const override {
+      tracker->TrackField("data", data_);
+    }
+    SET_MEMORY_INFO_NAME(SharedRingBufferTransferData)
+    SET_SELF_SIZE(SharedRingBufferTransferData)
+
+   private:
+    std::shared_ptr<SharedRingBufferData> data_;
+  };
+
+  TransferMode GetTransferMode() const override {
+    if (IsHandleClosing()) return TransferMode::kDisallowCloneAndTransfer;
+    return TransferMode::kCloneable;
+  }
+  std::unique_ptr<TransferData> CloneForMessaging() const override {
+    return std::make_unique<SharedRingBufferTransferData>(data_);
+  }
+
+  void MemoryInfo(MemoryTracker* tracker) const override {
+    tracker->TrackField("data", data_);
+  }
+  SET_MEMORY_INFO_NAME(SharedRingBuffer)
+  SET_SELF_SIZE(SharedRingBuffer)
+
+ private:
+  void Wait(int signals, size_t length);
+  void OnSignal();
+
+  uv_async_t async_;
+  std::atomic<int> pending_signals_{0};
+  // The signals this handle is waiting for. Only used on the owning thread.
+  int waiting_for_ = 0;
+  const std::shared_ptr<SharedRingBufferData> data_;
+};
+
+void SharedRingBufferData::CopyIn(size_t offset,
+                                  const void* source,
+                                  size_t length) {
+  char* base = static_cast<char*>(store_->Data());
+  const char* from = static_cast<const char*>(source);
+  size_t first = std::min(length, capacity_ - offset);
+  memcpy(base + offset, from, first);
+  if (first < length) memcpy(base, from + first, length - first);
+}
+
+void SharedRingBufferData::CopyOut(size_t offset,
+                                   void* target,
+                                   size_t length) const {
+  const char* base = static_cast<const char*>(store_->Data());
+  char* to = static_cast<char*>(target);
+  size_t first = std::min(length, capacity_ - offset);
+  memcpy(to, base + offset, first);
+  if (first < length) memcpy(to + first, base, length - first);
+}
+
+bool SharedRingBufferData::IsSatisfied(int signal, size_t record_size) const {
+  if (signal == SharedRingBuffer::kReadable) return used_ > 0;
+  return capacity_ - used_ >= record_size;
+}
+
+void SharedRingBufferData::NotifyWaiters() {
+  auto it = waiters_.begin();
+  while (it != waiters_.end()) {
+    if (IsSatisfied(it->signal, it->record_size)) {
+      it->handle->Notify(it->signal);
+      it = waiters_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
+bool SharedRingBufferData::Write(const char* data, size_t length) {
+  CHECK_LE(length, std::numeric_limits<uint32_t>::max());
+  Mutex::ScopedLock lock(mutex_);
+  if (capacity_ - used_ < RecordSize(length)) return false;
+  size_t write_offset = (read_offset_ + used_) % capacity_;
+  uint32_t header = static_cast<uint32_t>(length);
+  CopyIn(write_offset, &header, sizeof(header));
+  if (length > 0)
+    CopyIn((write_offset + sizeof(header)) % capacity_, data, length);
+  used_ += RecordSize(length);
+  NotifyWaiters();
+  return true;
+}
+
+SharedRingBufferData::ReadResult SharedRingBufferData::Read(
+    Isolate* isolate, std::unique_ptr<BackingStore>* record) {
+  Mutex::ScopedLock lock(mutex_);
+  if (used_ == 0) return ReadResult::kEmpty;
+  uint32_t length;
+  CopyOut(read_offset_, &length, sizeof(length));
+  // used_ never exceeds capacity_, so this also bounds the copy below.
+  if (used_ < sizeof(length) || length > used_ - sizeof(length)) {
+    read_offset_ = 0;
+    used_ = 0;
+    NotifyWaiters();
+    return ReadResult::kCorrupt;
+  }
+  *record = ArrayBuffer::NewBackingStore(
+      isolate, length, v8::BackingStoreInitializationMode::kUninitialized);
+  if (length > 0) {
+    CopyOut((read_offset_ + sizeof(length)) % capacity_,
+            (*record)->Data(),
+            length);
+  }
+  read_offset_ = (read_offset_ + RecordSize(length)) % capacity_;
+  used_ -= RecordSize(length);
+  NotifyWaiters();
+  return ReadResult::kRecord;
+}
+
+void SharedRingBufferData::Wait(SharedRingBuffer* waiter,
+                                int signals,
+                                size_t length) {
+  Mutex::ScopedLock lock(mutex_);
+  int ready = 0;
+  for (int signal :
+       {SharedRingBuffer::kReadable, SharedRingBuffer::kWritable}) {
+    if (!(signals & signal)) continue;
+    if (IsSatisfied(signal, RecordSize(length))) {
+      ready |= signal;
+    } else {
+      waiters_.push_back({waiter, signal, RecordSize(length)});
+    }
+  }
+  if (ready != 0) waiter->Notify(ready);
+}
+
+void SharedRingBufferData::RemoveWaiters(SharedRingBuffer* waiter) {
+  Mutex::ScopedLock lock(mutex_);
+  waiters_.erase(std::remove_if(waiters_.begin(),
+                                waiters_.end(),
+                                [&](const Waiter& entry) {
+                                  return entry.handle == waiter;
+                                }),
+                 waiters_.end());
+}
+
+SharedRingBuffer::SharedRingBuffer(Environment* env,
+                                   Local<Object> wrap,
+                                   std::shared_ptr<SharedRingBufferData> data)
+    : HandleWrap(env,
+                 wrap,
+                 reinterpret_cast<uv_handle_t*>(&async_),
+                 AsyncWrap::PROVIDER_SHAREDRINGBUFFER),
+      data_(std::move(data)) {
+  CHECK_EQ(uv_async_init(env->event_loop(),
+                         &async_,
+                         [](uv_async_t* handle) {
+                           SharedRingBuffer* ring =
+                               ContainerOf(&SharedRingBuffer::async_, handle);
+                           ring->OnSignal();
+                         }),
+           0);
+  uv_unref(reinterpret_cast<uv_handle_t*>(&async_));
+}
+
+Local<FunctionTemplate> SharedRingBuffer::GetConstructorTemplate(
+    IsolateData* isolate_data) {
+  Local<FunctionTemplate> tmpl =
+      isolate_data->shared_ring_buffer_constructor_template();
+  if (tmpl.IsEmpty()) {
+    Isolate* isolate = isolate_data->isolate();
+    tmpl = NewFunctionTemplate(isolate, New);
+    tmpl->InstanceTemplate()->SetInternalFieldCount(
+        SharedRingBuffer::kInternalFieldCount);
+    tmpl->Inherit(HandleWrap::GetConstructorTemplate(isolate_data));
+    SetProtoMethod(isolate, tmpl, "write", Write);
+    SetProtoMethod(isolate, tmpl, "read", Read);
+    SetProtoMethod(isolate, tmpl, "waitReadable", WaitReadable);
+    SetProtoMethod(isolate, tmpl, "waitWritable", WaitWritable);
+    isolate_data->set_shared_ring_buffer_constructor_template(tmpl);
+  }
+  return tmpl;
+}
+
+BaseObjectPtr<SharedRingBuffer> SharedRingBuffer::Create(
+    Environment* env, std::shared_ptr<SharedRingBufferData> data) {
+  Local<Object> obj;
+  if (!GetConstructorTemplate(env->isolate_data())
+           ->InstanceTemplate()
+           ->NewInstance(env->context())
+           .ToLocal(&obj)) {
+    return {};
+  }
+  return BaseObjectPtr<SharedRingBuffer>(
+      new SharedRingBuffer(env, obj, std::move(data)));
+}
+
+void SharedRingBuffer::New(const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+  CHECK(args.IsConstructCall());
+
+  std::shared_ptr<BackingStore> store;
+  if (args[0]->IsSharedArrayBuffer()) {
+    Local<SharedArrayBuffer> sab = args[0].As<SharedArrayBuffer>();
+    if (sab->GetBackingStore()->IsResizableByUserJavaScript()) {
+      return THROW_ERR_INVALID_ARG_VALUE(
+          env, "The SharedArrayBuffer must not be growable");
+    }
+    store = sab->GetBackingStore();
+  } else {
+    CHECK(args[0]->IsUint32());
+    store = SharedArrayBuffer::NewBackingStore(
+        env->isolate(),
+        args[0].As<v8::Uint32>()->Value(),
+        v8::BackingStoreInitializationMode::kZeroInitialized,
+        v8::BackingStoreOnFailureMode::kReturnNull);
+    if (!store) return THROW_ERR_MEMORY_ALLOCATION_FAILED(env);
+  }
+  if (store->ByteLength() <= SharedRingBufferData::RecordSize(0)) {
+    return THROW_ERR_OUT_OF_RANGE(
+        env, "The capacity of a SharedRingBuffer must exceed 4 bytes");
+  }
+
+  new SharedRingBuffer(env,
+                       args.This(),
+                       std::make_shared<SharedRingBufferData>(store));
+}
+
+void SharedRingBuffer::Write(const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+  SharedRingBuffer* ring;
+  ASSIGN_OR_RETURN_UNWRAP(&ring, args.This());
+  CHECK(args[0]->IsArrayBufferView());
+  ArrayBufferViewContents<char> record(args[0]);
+  if (SharedRingBufferData::RecordSize(record.length()) >
+      ring->data_->capacity()) {
+    return THROW_ERR_OUT_OF_RANGE(
+        env, "The record is too large for this SharedRingBuffer");
+  }
+  args.GetReturnValue().Set(ring->data_->Write(record.data(), record.length()));
+}
+
+void SharedRingBuffer::Read(const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+  SharedRingBuffer* ring;
+  ASSIGN_OR_RETURN_UNWRAP(&ring, args.This());
+  std::unique_ptr<BackingStore> record;
+  switch (ring->data_->Read(env->isolate(), &record)) {
+    case SharedRingBufferData::ReadResult::kRecord:
+      break;
+    case SharedRingBufferData::ReadResult::kEmpty:
+      return;
+    case SharedRingBufferData::ReadResult::kCorrupt:
+      return THROW_ERR_INVALID_STATE(
+          env, "The SharedRingBuffer holds a corrupt record header");
+  }
+  size_t length = record->ByteLength();
+  Local<ArrayBuffer> ab = ArrayBuffer::New(env->isolate(), std::move(record));
+  Local<Object> buffer;
+  if (Buffer::New(env, ab, 0, length).ToLocal(&buffer))
+    args.GetReturnValue().Set(buffer);
+}
+
+void SharedRingBuffer::WaitReadable(const FunctionCallbackInfo<Value>& args) {
+  SharedRingBuffer* ring;
+  ASSIGN_OR_RETURN_UNWRAP(&ring, args.This());
+  ring->Wait(kReadable, 0);
+}
+
+void SharedRingBuffer::WaitWritable(const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+  SharedRingBuffer* ring;
+  ASSIGN_OR_RETURN_UNWRAP(&ring, args.This());
+  CHECK(args[0]->IsUint32());
+  uint32_t length = args[0].As<v8::Uint32>()->Value();
+  if (SharedRingBufferData::RecordSize(length) > ring->data_->capacity()) {
+    return THROW_ERR_OUT_OF_RANGE(
+        env, "The record is too large for this SharedRingBuffer");
+  }
+  ring->Wait(kWritable, length);
+}
+
+void SharedRingBuffer::Wait(int signals, size_t length) {
+  if (IsHandleClosing()) return;
+  if (waiting_for_ == 0) uv_ref(reinterpret_cast<uv_handle_t*>(&async_));
+  waiting_for_ |= signals;
+  data_->Wait(this, signals, length);
+}
+
+void SharedRingBuffer::OnSignal() {
+  int signals = pending_signals_.exchange(0);
+  if (signals == 0) return;
+  waiting_for_ &= ~signals;
+  if (waiting_for_ == 0) uv_unref(reinterpret_cast<uv_handle_t*>(&async_));
+
+  HandleScope handle_scope(env()->isolate());
+  Context::Scope context_scope(env()->context());
+  Local<Value> argv[] = {Integer::New(env()->isolate(), signals)};
+  MakeCallback(env()->onsignal_string(), arraysize(argv), argv);
+}
+
 static void SetDeserializerCreateObjectFunction(
     const FunctionCallbackInfo<Value>& args) {
   Environment* env = Environment::GetCurrent(args);
@@ -1725,6 +2644,8 @@ static void CreatePerIsolateProperties(IsolateData* isolate_data,
   // the browser equivalents do not provide them.
   SetMethod(isolate, target, "stopMessagePort", MessagePort::Stop);
   SetMethod(isolate, target, "drainMessagePort", MessagePort::Drain);
+  SetMethod(
+      isolate, target, "setMessagePortBatchSize", MessagePort::SetBatchSize);
   SetMethod(
       isolate, target, "receiveMessageOnPort", MessagePort::ReceiveMessage);
   SetMethod(
@@ -1734,6 +2655,11 @@ static void CreatePerIsolateProperties(IsolateData* isolate_data,
             "setDeserializerCreateObjectFunction",
             SetDeserializerCreateObjectFunction);
   SetMethod(isolate, target, "broadcastChannel", BroadcastChannel);
+  SetConstructorFunction(
+      isolate,
+      target,
+      "SharedRingBuffer",
+      SharedRingBuffer::GetConstructorTemplate(isolate_data));
   SetMethod(isolate, target, "structuredClone", StructuredClone);
 }
 
@@ -1760,10 +2686,16 @@ static void RegisterExternalReferences(ExternalReferenceRegistry* registry) {
   registry->Register(MessagePort::Start);
   registry->Register(MessagePort::Stop);
   registry->Register(MessagePort::Drain);
+  registry->Register(MessagePort::SetBatchSize);
   registry->Register(MessagePort::ReceiveMessage);
   registry->Register(MessagePort::MoveToContext);
   registry->Register(SetDeserializerCreateObjectFunction);
   registry->Register(StructuredClone);
+  registry->Register(SharedRingBuffer::New);
+  registry->Register(SharedRingBuffer::Write);
+  registry->Register(SharedRingBuffer::Read);
+  registry->Register(SharedRingBuffer::WaitReadable);
+  registry->Register(SharedRingBuffer::WaitWritable);
   registry->Register(ExposeLazyDOMExceptionProperty);
   registry->Register(ExposeLazyDOMExceptionPropertyGetter);
 }
@@ -109,6 +109,16 @@ class Message : public MemoryRetainer {
   SET_SELF_SIZE(Message)
 
  private:
+  // Serializes messages that are only made up of strings and buffers without
+  // going through the V8 ValueSerializer. Returns Just(false) if `input` or
+  // `transfer_list` need the general serializer.
+  v8::Maybe<bool> SerializeFast(Environment* env,
+                                v8::Local<v8::Context> context,
+                                v8::Local<v8::Value> input,
+                                const TransferList& transfer_list);
+  v8::MaybeLocal<v8::Value> DeserializeFast(Environment* env,
+                                            v8::Local<v8::Context> context);
+
   MallocedBuffer<char> main_message_buf_;
   // TODO(addaleax): Make this a std::variant to save storage size in the common
   // case (which is that all of these vectors are empty) once that is available
@@ -262,6 +272,9 @@ class MessagePort : public HandleWrap {
   static void Start(const v8::FunctionCallbackInfo<v8::Value>& args);
   static void Stop(const v8::FunctionCallbackInfo<v8::Value>& args);
   static void Drain(const v8::FunctionCallbackInfo<v8::Value>& args);
+  // setMessagePortBatchSize(port, n): with n > 1, incoming messages are
+  // emitted as 'messagebatch' events of up to n messages each.
+  static void SetBatchSize(const v8::FunctionCallbackInfo<v8::Value>& args);
   static void ReceiveMessage(const v8::FunctionCallbackInfo<v8::Value>& args);
 
   /* static */
@@ -304,6 +317,7 @@ class MessagePort : public HandleWrap {
 
   void OnClose() override;
   void OnMessage(MessageProcessingMode mode);
+  void OnMessageBatch(v8::Local<v8::Context> context, size_t processing_limit);
   void TriggerAsync();
   v8::MaybeLocal<v8::Value> ReceiveMessage(
       v8::Local<v8::Context> context,
@@ -312,6 +326,7 @@ class MessagePort : public HandleWrap {
 
   std::unique_ptr<MessagePortData> data_ = nullptr;
   bool receiving_messages_ = false;
+  size_t batch_size_ = 1;
   uv_async_t async_;
   v8::Global<v8::Function> emit_message_fn_;
 
@@ -2,8 +2,10 @@
 #include <cstdio>
 #include "base_object-inl.h"
 #include "compile_cache.h"
+#include "debug_utils-inl.h"
 #include "node_errors.h"
 #include "node_external_reference.h"
+#include "node_internals.h"
 #include "node_url.h"
 #include "path.h"
 #include "permission/permission.h"
@@ -16,6 +18,10 @@
 #include "v8.h"
 
 #include "simdjson.h"
+#include "zlib.h"
+
+#include <limits>
+#include <vector>
 
 namespace node {
 namespace modules {
@@ -49,6 +55,12 @@ BindingData::BindingData(Realm* realm,
                          InternalFieldInfo* info)
     : SnapshotableObject(realm, object, type_int) {}
 
+BindingData::~BindingData() {
+  // When the environment is torn down, the binding data is gone before the
+  // AtExit hook from MaybeEnablePackageJSONCache() runs.
+  PersistPackageJSONCache();
+}
+
 bool BindingData::PrepareForSerialization(v8::Local<v8::Context> context,
                                           v8::SnapshotCreator* creator) {
   // Return true because we need to maintain the reference to the binding from
@@ -92,6 +104,256 @@ Local<Array> BindingData::PackageConfig::Serialize(Realm* realm) const {
   return Array::New(isolate, values, 6);
 }
 
+namespace {
+
+// The persisted package.json cache is a header followed by one record per
+// file:
+//
+// [uint32_t] magic number
+// [uint32_t] number of records
+// [uint32_t] hash of the records
+// then for each record
+//   the path
+//   [uint64_t] size, inode, mtime seconds, mtime nanoseconds
+//   name, main, type, exports, imports, scripts
+//
+// Strings are stored as a uint32_t length followed by the bytes; absent
+// optional strings have length kNoString. Integers use the host's byte
+// order, which is fine because the cache directory is tagged with the
+// Node.js version and architecture.
+constexpr uint32_t kPackageJSONCacheMagicNumber = 0x5a1b8d17;
+constexpr uint32_t kNoString = std::numeric_limits<uint32_t>::max();
+constexpr size_t kPackageJSONCacheHeaderSize = 3 * sizeof(uint32_t);
+constexpr const char* kPackageJSONCacheFilename = "package-json-cache";
+
+class PackageJSONCacheWriter {
+ public:
+  template <typename T>
+  void WriteInt(T value) {
+    const char* bytes = reinterpret_cast<const char*>(&value);
+    buffer_.insert(buffer_.end(), bytes, bytes + sizeof(value));
+  }
+
+  void WriteString(std::string_view value) {
+    WriteInt(static_cast<uint32_t>(value.size()));
+    buffer_.insert(buffer_.end(), value.begin(), value.end());
+  }
+
+  void WriteString(const std::optional<std::string>& value) {
+    if (value.has_value()) {
+      WriteString(std::string_view(*value));
+    } else {
+      WriteInt(kNoString);
+    }
+  }
+
+  std::vector<char>* buffer() { return &buffer_; }
+
+ private:
+  std::vector<char> buffer_;
+};
+
+class PackageJSONCacheReader {
+ public:
+  PackageJSONCacheReader(const char* data, size_t size)
+      : data_(data), size_(size) {}
+
+  template <typename T>
+  bool ReadInt(T* value) {
+    if (size_ - offset_ < sizeof(T)) return false;
+    memcpy(value, data_ + offset_, sizeof(T));
+    offset_ += sizeof(T);
+    return true;
+  }
+
+  bool ReadString(std::string* value) {
+    uint32_t length;
+    if (!ReadInt(&length) || length == kNoString ||
+        size_ - offset_ < length) {
+      return false;
+    }
+    value->assign(data_ + offset_, length);
+    offset_ += length;
+    return true;
+  }
+
+  bool ReadString(std::optional<std::string>* value) {
+    uint32_t length;
+    if (!ReadInt(&length)) return false;
+    if (length == kNoString) {
+      value->reset();
+      return true;
+    }
+    if (size_ - offset_ < length) return false;
+    value->emplace(data_ + offset_, length);
+    offset_ += length;
+    return true;
+  }
+
+  bool done() const { return offset_ == size_; }
+
+ private:
+  const char* data_;
+  size_t size_;
+  size_t offset_ = 0;
+};
+
+uint32_t GetPackageJSONCacheHash(const char* data, size_t size) {
+  uLong crc = crc32(0L, Z_NULL, 0);
+  return crc32(crc, reinterpret_cast<const Bytef*>(data), size);
+}
+
+bool StatPackageJSON(const char* path, BindingData::FileStamp* stamp) {
+  uv_fs_t req;
+  int rc = uv_fs_stat(nullptr, &req, path, nullptr);
+  if (rc == 0) {
+    const uv_stat_t& s = req.statbuf;
+    *stamp = {s.st_size,
+              s.st_ino,
+              static_cast<int64_t>(s.st_mtim.tv_sec),
+              static_cast<int64_t>(s.st_mtim.tv_nsec)};
+  }
+  uv_fs_req_cleanup(&req);
+  return rc == 0;
+}
+
+}  // anonymous namespace
+
+void BindingData::MaybeEnablePackageJSONCache(Realm* realm) {
+  if (package_json_cache_checked_) return;
+  Environment* env = realm->env();
+  // The compile cache can also be enabled at run time, so keep checking
+  // until it is.
+  CompileCacheHandler* handler = env->compile_cache_handler();
+  if (handler == nullptr || handler->cache_dir().empty()) return;
+  package_json_cache_checked_ = true;
+
+  std::string enabled;
+  if (realm != env->principal_realm() ||
+      !credentials::SafeGetenv("NODE_PACKAGE_JSON_CACHE", &enabled, env) ||
+      enabled != "1") {
+    return;
+  }
+  package_json_cache_path_ = std::string(handler->cache_dir()) +
+                             kPathSeparator + kPackageJSONCacheFilename;
+  LoadPackageJSONCache();
+  Debug(env,
+        DebugCategory::COMPILE_CACHE,
+        "[compile cache] loaded %d package.json entries from %s\n",
+        persisted_package_configs_.size(),
+        package_json_cache_path_);
+  AtExit(
+      env,
+      [](void* data) {
+        Environment* env = static_cast<Environment*>(data);
+        BindingData* binding_data =
+            env->principal_realm()->GetBindingData<BindingData>();
+        if (binding_data != nullptr) binding_data->PersistPackageJSONCache();
+      },
+      env);
+}
+
+void BindingData::LoadPackageJSONCache() {
+  std::string contents;
+  if (ReadFileSync(&contents, package_json_cache_path_.c_str()) < 0 ||
+      contents.size() < kPackageJSONCacheHeaderSize) {
+    return;
+  }
+  PackageJSONCacheReader header(contents.data(), kPackageJSONCacheHeaderSize);
+  uint32_t magic_number;
+  uint32_t count;
+  uint32_t hash;
+  CHECK(header.ReadInt(&magic_number) && header.ReadInt(&count) &&
+        header.ReadInt(&hash));
+  const char* records = contents.data() + kPackageJSONCacheHeaderSize;
+  size_t records_size = contents.size() - kPackageJSONCacheHeaderSize;
+  if (magic_number != kPackageJSONCacheMagicNumber ||
+      hash != GetPackageJSONCacheHash(records, records_size)) {
+    return;
+  }
+
+  PackageJSONCacheReader reader(records, records_size);
+  std::unordered_map<std::string, PersistedPackageConfig> configs;
+  configs.reserve(count);
+  for (uint32_t i = 0; i < count; ++i) {
+    std::string path;
+    PersistedPackageConfig persisted;
+    FileStamp& stamp = persisted.stamp;
+    PackageConfig& config = persisted.config;
+    if (!reader.ReadString(&path) || !reader.ReadInt(&stamp.size) ||
+        !reader.ReadInt(&stamp.ino) || !reader.ReadInt(&stamp.mtime_sec) ||
+        !reader.ReadInt(&stamp.mtime_nsec) ||
+        !reader.ReadString(&config.name) ||
+        !reader.ReadString(&config.main) || !reader.ReadString(&config.type) ||
+        !reader.ReadString(&config.exports) ||
+        !reader.ReadString(&config.imports) ||
+        !reader.ReadString(&config.scripts)) {
+      return;
+    }
+    config.file_path = path;
+    configs.emplace(std::move(path), std::move(persisted));
+  }
+  if (!reader.done()) return;
+  persisted_package_configs_ = std::move(configs);
+}
+
+void BindingData::PersistPackageJSONCache() {
+  if (package_json_cache_path_.empty() || !package_json_cache_dirty_) return;
+  package_json_cache_dirty_ = false;
+
+  PackageJSONCacheWriter writer;
+  writer.WriteInt(kPackageJSONCacheMagicNumber);
+  writer.WriteInt(static_cast<uint32_t>(persisted_package_configs_.size()));
+  writer.WriteInt(uint32_t{0});  // Filled in below.
+  for (const auto& [path, persisted] : persisted_package_configs_) {
+    const FileStamp& stamp = persisted.stamp;
+    const PackageConfig& config = persisted.config;
+    writer.WriteString(std::string_view(path));
+    writer.WriteInt(stamp.size);
+    writer.WriteInt(stamp.ino);
+    writer.WriteInt(stamp.mtime_sec);
+    writer.WriteInt(stamp.mtime_nsec);
+    writer.WriteString(config.name);
+    writer.WriteString(config.main);
+    writer.WriteString(std::string_view(config.type));
+    writer.WriteString(config.exports);
+    writer.WriteString(config.imports);
+    writer.WriteString(config.scripts);
+  }
+  std::vector<char>* buffer = writer.buffer();
+  uint32_t hash =
+      GetPackageJSONCacheHash(buffer->data() + kPackageJSONCacheHeaderSize,
+                              buffer->size() - kPackageJSONCacheHeaderSize);
+  memcpy(buffer->data() + 2 * sizeof(uint32_t), &hash, sizeof(hash));
+
+  // Write to a temporary file first so that concurrent processes never see
+  // a partially written cache.
+  std::string tmp_path =
+      package_json_cache_path_ + "." + std::to_string(uv_os_getpid());
+  uv_buf_t buf = uv_buf_init(buffer->data(), buffer->size());
+  int err = WriteFileSync(tmp_path.c_str(), buf);
+  if (err == 0) {
+    uv_fs_t req;
+    err = uv_fs_rename(nullptr,
+                       &req,
+                       tmp_path.c_str(),
+                       package_json_cache_path_.c_str(),
+                       nullptr);
+    uv_fs_req_cleanup(&req);
+  }
+  if (err < 0) {
+    uv_fs_t req;
+    uv_fs_unlink(nullptr, &req, tmp_path.c_str(), nullptr);
+    uv_fs_req_cleanup(&req);
+  }
+  Debug(env(),
+        DebugCategory::COMPILE_CACHE,
+        "[compile cache] persisting %d package.json entries to %s: %s\n",
+        persisted_package_configs_.size(),
+        package_json_cache_path_,
+        err < 0 ? uv_strerror(err) : "success");
+}
+
 const BindingData::PackageConfig* BindingData::GetPackageJSON(
     Realm* realm, std::string_view path, ErrorContext* error_context) {
   auto binding_data = realm->GetBindingData<BindingData>();
@@ -101,6 +363,28 @@ const BindingData::PackageConfig* BindingData::GetPackageJSON(
     return &cache_entry->second;
   }
 
+  binding_data->MaybeEnablePackageJSONCache(realm);
+  FileStamp stamp{};
+  const bool persist = !binding_data->package_json_cache_path_.empty();
+  if (persist) {
+    // Take the stamp before reading the file, so that a change racing with
+    // the read leaves a stamp that no longer matches.
+    if (!StatPackageJSON(path.data(), &stamp)) {
+      return nullptr;
+    }
+    auto persisted =
+        binding_data->persisted_package_configs_.find(std::string(path));
+    if (persisted != binding_data->persisted_package_configs_.end()) {
+      if (persisted->second.stamp == stamp) {
+        auto cached = binding_data->package_configs_.emplace(
+            std::string(path), persisted->second.config);
+        return &cached.first->second;
+      }
+      binding_data->persisted_package_configs_.erase(persisted);
+      binding_data->package_json_cache_dirty_ = true;
+    }
+  }
+
   PackageConfig package_config{};
   package_config.file_path = path;
   // No need to exclude BOM since simdjson will skip it.
@@ -246,6 +530,16 @@ const BindingData::PackageConfig* BindingData::GetPackageJSON(
       }
     }
   }
+  if (persist) {
+    // The raw JSON is only needed for parsing, so leave it out of the copy.
+    std::string raw_json = std::move(package_config.raw_json);
+    package_config.raw_json.clear();
+    binding_data->persisted_package_configs_[std::string(path)] = {
+        stamp, package_config};
+    binding_data->package_json_cache_dirty_ = true;
+    package_config.raw_json = std::move(raw_json);
+  }
+
   // package_config could be quite large, so we should move it instead of
   // copying it.
   auto cached = binding_data->package_configs_.insert(
@@ -332,6 +626,253 @@ const BindingData::PackageConfig* BindingData::TraverseParent(
   return nullptr;
 }
 
+namespace {
+
+// Returns the package name that Module._findPath() would look up the
+// "exports" of, i.e. the first group of EXPORTS_PATTERN in
+// lib/internal/modules/cjs/loader.js, or an empty view if there is none.
+std::string_view ExportsPackageName(std::string_view request) {
+  const auto is_special = [](char c) {
+    return c == '/' || c == '\\' || c == '%';
+  };
+  size_t start = 0;
+  if (request.starts_with('@')) {
+    size_t slash = 1;
+    while (slash < request.size() && !is_special(request[slash])) ++slash;
+    if (slash > 1 && slash < request.size() && request[slash] == '/') {
+      start = slash + 1;
+    }
+  }
+  if (start >= request.size() || request[start] == '.' ||
+      is_special(request[start])) {
+    return {};
+  }
+  size_t end = start + 1;
+  while (end < request.size() && !is_special(request[end])) ++end;
+  if (end < request.size() && request[end] != '/') return {};
+  return request.substr(0, end);
+}
+
+// Whether the request ends in a way that only matches directories, as
+// computed by Module._findPath().
+bool HasTrailingSlash(std::string_view request) {
+  if (request.empty()) return false;
+  if (request.ends_with('/')) return true;
+  if (!request.ends_with('.')) return false;
+  size_t length = request.size();
+  if (length == 1 || request[length - 2] == '/') return true;
+  return request[length - 2] == '.' &&
+         (length == 2 || request[length - 3] == '/');
+}
+
+bool ToStringVector(Isolate* isolate,
+                    Local<Context> context,
+                    Local<Array> array,
+                    std::vector<std::string>* out) {
+  uint32_t length = array->Length();
+  out->reserve(length);
+  for (uint32_t i = 0; i < length; ++i) {
+    Local<Value> value;
+    if (!array->Get(context, i).ToLocal(&value)) return false;
+    CHECK(value->IsString());
+    out->push_back(Utf8Value(isolate, value).ToString());
+  }
+  return true;
+}
+
+}  // anonymous namespace
+
+bool BindingData::MaybeInDirectoryListing(const std::string& path) {
+#if defined(_WIN32) || defined(__APPLE__)
+  // The file systems there are usually case-insensitive, so the names in a
+  // listing can't be compared byte by byte.
+  return true;
+#else
+  size_t slash = path.find_last_of('/');
+  if (slash == std::string::npos || slash == 0) return true;
+  std::string_view name = std::string_view(path).substr(slash + 1);
+  if (name.empty() || name == "." || name == "..") return true;
+
+  std::string directory = path.substr(0, slash);
+  auto it = directory_listings_.find(directory);
+  if (it == directory_listings_.end()) {
+    std::optional<std::unordered_set<std::string>> entries;
+    uv_fs_t req;
+    int rc = uv_fs_scandir(nullptr, &req, directory.c_str(), 0, nullptr);
+    if (rc >= 0) {
+      entries.emplace();
+      uv_dirent_t ent;
+      while (uv_fs_scandir_next(&req, &ent) != UV_EOF) {
+        entries->emplace(ent.name);
+      }
+    } else if (rc == UV_ENOENT || rc == UV_ENOTDIR) {
+      // Nothing can exist below it.
+      entries.emplace();
+    }
+    // On other errors, e.g. a directory that can be searched but not
+    // read, the listing stays unknown and every probe falls back to stat.
+    uv_fs_req_cleanup(&req);
+    it = directory_listings_.emplace(std::move(directory), std::move(entries))
+             .first;
+  }
+  return !it->second.has_value() || it->second->contains(std::string(name));
+#endif
+}
+
+int BindingData::CachedModuleStat(const std::string& path) {
+  auto cached = module_stat_cache_.find(path);
+  if (cached != module_stat_cache_.end()) return cached->second;
+
+  int rc = UV_ENOENT;
+  if (MaybeInDirectoryListing(path)) {
+    uv_fs_t req;
+    rc = uv_fs_stat(nullptr, &req, path.c_str(), nullptr);
+    if (rc == 0) rc = S_ISDIR(req.statbuf.st_mode);
+    uv_fs_req_cleanup(&req);
+  }
+  module_stat_cache_.emplace(path, rc);
+  return rc;
+}
+
+BindingData::FindPathResult BindingData::FindPathImpl(
+    Realm* realm,
+    const std::string& request,
+    const std::vector<std::string>& paths,
+    const std::vector<std::string>& extensions,
+    std::string* filename) {
+  Environment* env = realm->env();
+
+  const auto try_file = [&](const std::string& path) {
+    if (CachedModuleStat(path) != 0) return false;
+    *filename = path;
+    return true;
+  };
+  const auto try_extensions = [&](const std::string& path) {
+    for (const std::string& extension : extensions) {
+      if (try_file(path + extension)) return true;
+    }
+    return false;
+  };
+  // Reads |path| if it exists. Returns false if it exists but can't be
+  // used here, with an exception pending if it is invalid.
+  const auto read_package_json = [&](const std::string& path,
+                                     const PackageConfig** config) {
+    *config = nullptr;
+    if (CachedModuleStat(path) != 0) return true;
+    *config = GetPackageJSON(realm, path);
+    return *config != nullptr;
+  };
+
+  const bool absolute = std::filesystem::path(request).is_absolute();
+  const bool trailing_slash = HasTrailingSlash(request);
+  const std::string_view exports_name =
+      absolute ? std::string_view() : ExportsPackageName(request);
+  static const std::vector<std::string> kAbsolutePaths = {""};
+
+  for (const std::string& path : absolute ? kAbsolutePaths : paths) {
+    if (!path.empty() && CachedModuleStat(path) < 1) continue;
+
+    if (!exports_name.empty()) {
+      const PackageConfig* package_json;
+      std::string package_json_path =
+          PathResolve(env, {path, exports_name, "package.json"});
+      if (!read_package_json(package_json_path, &package_json))
+        return FindPathResult::kUnsupported;
+      // "exports" are resolved in JavaScript.
+      if (package_json != nullptr && package_json->exports.has_value())
+        return FindPathResult::kUnsupported;
+    }
+
+    std::string base_path = PathResolve(env, {path, request});
+    int rc = CachedModuleStat(base_path);
+    if (!trailing_slash) {
+      if (rc == 0) {
+        *filename = base_path;
+        return FindPathResult::kFound;
+      }
+      if (try_extensions(base_path)) return FindPathResult::kFound;
+    }
+    if (rc != 1) continue;
+
+    // The equivalent of tryPackage().
+    const PackageConfig* package_json;
+    if (!read_package_json(base_path + kPathSeparator + "package.json",
+                           &package_json)) {
+      return FindPathResult::kUnsupported;
+    }
+    if (package_json == nullptr || !package_json->main.has_value() ||
+        package_json->main->empty()) {
+      if (try_extensions(PathResolve(env, {base_path, "index"})))
+        return FindPathResult::kFound;
+      continue;
+    }
+    std::string main = PathResolve(env, {base_path, *package_json->main});
+    if (try_file(main) || try_extensions(main) ||
+        try_extensions(PathResolve(env, {main, "index"}))) {
+      return FindPathResult::kFound;
+    }
+    // A missing "main" either falls back to index with a deprecation
+    // warning or throws; both are left to JavaScript.
+    return FindPathResult::kUnsupported;
+  }
+  return FindPathResult::kNotFound;
+}
+
+// findPath(request, paths, extensions)
+//
+// Runs the file system search of Module._findPath() for |request| in
+// |paths|, trying |extensions| in order. Returns the matching filename,
+// before symlinks are resolved, or false if nothing matches. Returns
+// undefined when the search needs something that is only implemented in
+// JavaScript (package "exports", a missing "main"), in which case the
+// caller should fall back to its own search. Stat results and directory
+// listings are cached until clearFindPathCache() is called.
+// Like internalModuleStat(), this does not hold Permission Model checks,
+// so it does nothing when the Permission Model is enabled.
+void BindingData::FindPath(const FunctionCallbackInfo<Value>& args) {
+  CHECK_GE(args.Length(), 3);
+  CHECK(args[0]->IsString());  // request
+  CHECK(args[1]->IsArray());   // paths
+  CHECK(args[2]->IsArray());   // extensions
+
+  Realm* realm = Realm::GetCurrent(args);
+  if (realm->env()->permission()->enabled()) return;
+  Isolate* isolate = realm->isolate();
+  Local<Context> context = realm->context();
+  BindingData* binding_data = realm->GetBindingData<BindingData>();
+
+  std::string request = Utf8Value(isolate, args[0]).ToString();
+  std::vector<std::string> paths;
+  std::vector<std::string> extensions;
+  if (!ToStringVector(isolate, context, args[1].As<Array>(), &paths) ||
+      !ToStringVector(isolate, context, args[2].As<Array>(), &extensions)) {
+    return;
+  }
+
+  std::string filename;
+  switch (binding_data->FindPathImpl(
+      realm, request, paths, extensions, &filename)) {
+    case FindPathResult::kFound: {
+      Local<Value> result;
+      if (ToV8Value(context, filename, isolate).ToLocal(&result)) {
+        args.GetReturnValue().Set(result);
+      }
+      break;
+    }
+    case FindPathResult::kNotFound:
+      args.GetReturnValue().Set(false);
+      break;
+    case FindPathResult::kUnsupported:
+      break;
+  }
+}
+
+void BindingData::ClearFindPathCache(const FunctionCallbackInfo<Value>& args) {
+  BindingData* binding_data = Realm::GetBindingData<BindingData>(args);
+  binding_data->module_stat_cache_.clear();
+  binding_data->directory_listings_.clear();
+}
+
 void BindingData::GetNearestParentPackageJSON(
     const v8::FunctionCallbackInfo<v8::Value>& args) {
   CHECK_GE(args.Length(), 1);
@@ -500,6 +1041,8 @@ void FlushCompileCache(const FunctionCallbackInfo<Value>& args) {
         DebugCategory::COMPILE_CACHE,
         "[compile cache] module.flushCompileCache() requested.\n");
   env->FlushCompileCache();
+  BindingData* binding_data = Realm::GetBindingData<BindingData>(context);
+  if (binding_data != nullptr) binding_data->PersistPackageJSONCache();
   Debug(env,
         DebugCategory::COMPILE_CACHE,
         "[compile cache] module.flushCompileCache() finished.\n");
@@ -693,6 +1236,8 @@ void BindingData::CreatePerIsolateProperties(IsolateData* isolate_data,
   SetMethod(
       isolate, target, "getPackageScopeConfig", GetPackageScopeConfig<false>);
   SetMethod(isolate, target, "getPackageType", GetPackageScopeConfig<true>);
+  SetMethod(isolate, target, "findPath", FindPath);
+  SetMethod(isolate, target, "clearFindPathCache", ClearFindPathCache);
   SetMethod(isolate, target, "enableCompileCache", EnableCompileCache);
   SetMethod(isolate, target, "getCompileCacheDir", GetCompileCacheDir);
   SetMethod(isolate, target, "flushCompileCache", FlushCompileCache);
@@ -749,6 +1294,8 @@ void BindingData::RegisterExternalReferences(
   registry->Register(GetNearestParentPackageJSON);
   registry->Register(GetPackageScopeConfig<false>);
   registry->Register(GetPackageScopeConfig<true>);
+  registry->Register(FindPath);
+  registry->Register(ClearFindPathCache);
   registry->Register(EnableCompileCache);
   registry->Register(GetCompileCacheDir);
   registry->Register(FlushCompileCache);
@@ -15,6 +15,8 @@
 #include <string>
 #include <string_view>
 #include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 namespace node {
 class ExternalReferenceRegistry;
@@ -38,6 +40,17 @@ class BindingData : public SnapshotableObject {
     v8::Local<v8::Array> Serialize(Realm* realm) const;
   };
 
+  // Identifies the version of a file that a persisted PackageConfig was
+  // parsed from.
+  struct FileStamp {
+    uint64_t size;
+    uint64_t ino;
+    int64_t mtime_sec;
+    int64_t mtime_nsec;
+
+    bool operator==(const FileStamp& other) const = default;
+  };
+
   struct ErrorContext {
     std::optional<std::string> base;
     std::string specifier;
@@ -47,6 +60,7 @@ class BindingData : public SnapshotableObject {
   BindingData(Realm* realm,
               v8::Local<v8::Object> obj,
               InternalFieldInfo* info = nullptr);
+  ~BindingData() override;
   SERIALIZABLE_OBJECT_METHODS()
   SET_BINDING_ID(modules_binding_data)
 
@@ -64,6 +78,9 @@ class BindingData : public SnapshotableObject {
       const v8::FunctionCallbackInfo<v8::Value>& args);
   static void GetPackageJSONScripts(
       const v8::FunctionCallbackInfo<v8::Value>& args);
+  static void FindPath(const v8::FunctionCallbackInfo<v8::Value>& args);
+  static void ClearFindPathCache(
+      const v8::FunctionCallbackInfo<v8::Value>& args);
 
   static void CreatePerIsolateProperties(IsolateData* isolate_data,
                                          v8::Local<v8::ObjectTemplate> ctor);
@@ -73,9 +90,47 @@ class BindingData : public SnapshotableObject {
                                          void* priv);
   static void RegisterExternalReferences(ExternalReferenceRegistry* registry);
 
+  // Writes the persisted package.json cache if it has changed.
+  void PersistPackageJSONCache();
+
  private:
+  enum class FindPathResult { kFound, kNotFound, kUnsupported };
+
+  struct PersistedPackageConfig {
+    FileStamp stamp;
+    PackageConfig config;
+  };
+
+  void MaybeEnablePackageJSONCache(Realm* realm);
+  void LoadPackageJSONCache();
+
+  FindPathResult FindPathImpl(Realm* realm,
+                              const std::string& request,
+                              const std::vector<std::string>& paths,
+                              const std::vector<std::string>& extensions,
+                              std::string* filename);
+  // Like internalModuleStat(): 0 for files, 1 for directories and < 0 on
+  // errors, cached in module_stat_cache_.
+  int CachedModuleStat(const std::string& path);
+  // Returns false if the directory listing of the parent of |path| shows
+  // that it does not exist.
+  bool MaybeInDirectoryListing(const std::string& path);
+
   std::unordered_map<std::string, PackageConfig> package_configs_;
   simdjson::ondemand::parser json_parser;
+  // Parsed package.json files from this and earlier runs, kept next to the
+  // compile cache with NODE_PACKAGE_JSON_CACHE=1. An entry is only used
+  // while the stat() of its file still matches the stamp.
+  std::unordered_map<std::string, PersistedPackageConfig>
+      persisted_package_configs_;
+  std::string package_json_cache_path_;
+  bool package_json_cache_checked_ = false;
+  bool package_json_cache_dirty_ = false;
+  // Used by FindPath(). The listings are std::nullopt for directories that
+  // could not be read.
+  std::unordered_map<std::string, int> module_stat_cache_;
+  using DirectoryListing = std::optional<std::unordered_set<std::string>>;
+  std::unordered_map<std::string, DirectoryListing> directory_listings_;
   // returns null on error
   static const PackageConfig* GetPackageJSON(
       Realm* realm,
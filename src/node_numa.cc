@@ -0,0 +1,133 @@
+#include "node_numa.h"
+#include "uv.h"
+
+#include <cerrno>
+#include <climits>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+
+#if defined(__linux__)
+#include <linux/mempolicy.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace node {
+namespace numa {
+
+bool ParseCpuList(std::string_view list, std::vector<int>* cpus) {
+  while (!list.empty() && (list.back() == '\n' || list.back() == ' '))
+    list.remove_suffix(1);
+  if (list.empty()) return true;
+
+  auto parse_number = [&](int* out) {
+    size_t digits = 0;
+    int64_t value = 0;
+    while (digits < list.size() && list[digits] >= '0' &&
+           list[digits] <= '9') {
+      value = value * 10 + (list[digits] - '0');
+      if (value > INT_MAX) return false;
+      digits++;
+    }
+    if (digits == 0) return false;
+    list.remove_prefix(digits);
+    *out = static_cast<int>(value);
+    return true;
+  };
+
+  for (;;) {
+    int first;
+    if (!parse_number(&first)) return false;
+    int last = first;
+    if (!list.empty() && list[0] == '-') {
+      list.remove_prefix(1);
+      if (!parse_number(&last) || last < first) return false;
+    }
+    for (int cpu = first; cpu <= last; cpu++) cpus->push_back(cpu);
+    if (list.empty()) return true;
+    if (list[0] != ',') return false;
+    list.remove_prefix(1);
+  }
+}
+
+#if defined(__linux__)
+static bool ReadCpuListFile(const std::string& path, std::vector<int>* out) {
+  std::ifstream file(path);
+  std::string line;
+  if (!file || !std::getline(file, line)) return false;
+  return ParseCpuList(line, out);
+}
+#endif
+
+const std::vector<std::vector<int>>& GetNodeCpus() {
+  static const std::vector<std::vector<int>> node_cpus = [] {
+    std::vector<std::vector<int>> result;
+#if defined(__linux__)
+    static const char kNodeDir[] = "/sys/devices/system/node/";
+    // The list uses the same format as the CPU lists of the nodes.
+    std::vector<int> nodes;
+    if (!ReadCpuListFile(std::string(kNodeDir) + "possible", &nodes) ||
+        nodes.empty()) {
+      return result;
+    }
+    result.resize(nodes.back() + 1);
+    for (int node : nodes) {
+      std::string path =
+          std::string(kNodeDir) + "node" + std::to_string(node) + "/cpulist";
+      // Possible nodes that are not online have no directory.
+      std::vector<int> cpus;
+      if (ReadCpuListFile(path, &cpus)) result[node] = std::move(cpus);
+    }
+#endif
+    return result;
+  }();
+  return node_cpus;
+}
+
+int SetCurrentThreadAffinity(const std::vector<int>& cpus) {
+  int mask_size = uv_cpumask_size();
+  if (mask_size < 0) return mask_size;
+  std::vector<char> mask(mask_size);
+  for (int cpu : cpus) {
+    if (cpu < 0 || cpu >= mask_size) return UV_EINVAL;
+    mask[cpu] = 1;
+  }
+  uv_thread_t self = uv_thread_self();
+  return uv_thread_setaffinity(&self, mask.data(), nullptr, mask.size());
+}
+
+int SetCurrentThreadPreferredNode(int node) {
+  if (node < 0) return UV_EINVAL;
+#if defined(__linux__)
+  constexpr size_t kBitsPerWord = sizeof(unsigned long) * CHAR_BIT;  // NOLINT
+  std::vector<unsigned long> nodemask(node / kBitsPerWord + 1);  // NOLINT
+  nodemask[node / kBitsPerWord] |= 1UL << (node % kBitsPerWord);
+  // Like libnuma, pass one more than the number of bits in the mask, as the
+  // kernel discards the last one.
+  if (syscall(SYS_set_mempolicy,
+              MPOL_PREFERRED,
+              nodemask.data(),
+              nodemask.size() * kBitsPerWord + 1) != 0) {
+    return uv_translate_sys_error(errno);
+  }
+  return 0;
+#else
+  return UV_ENOTSUP;
+#endif
+}
+
+int BindCurrentThreadToNode(int node) {
+  const std::vector<std::vector<int>>& node_cpus = GetNodeCpus();
+  if (node < 0 || static_cast<size_t>(node) >= node_cpus.size() ||
+      node_cpus[node].empty()) {
+    return UV_EINVAL;
+  }
+  int err = SetCurrentThreadAffinity(node_cpus[node]);
+  if (err != 0) return err;
+  return SetCurrentThreadPreferredNode(node);
+}
+
+}  // namespace numa
+}  // namespace node
@@ -0,0 +1,39 @@
+#ifndef SRC_NODE_NUMA_H_
+#define SRC_NODE_NUMA_H_
+
+#if defined(NODE_WANT_INTERNALS) && NODE_WANT_INTERNALS
+
+#include <string_view>
+#include <vector>
+
+namespace node {
+namespace numa {
+
+// Parses a Linux CPU list such as "0-3,8,10-11", as found in
+// /sys/devices/system/node/node*/cpulist, into the CPU numbers it contains.
+// Returns false if the list is malformed.
+bool ParseCpuList(std::string_view list, std::vector<int>* cpus);
+
+// Returns the CPUs of each NUMA node, indexed by node id. The result is
+// empty when the topology cannot be determined, which includes all
+// platforms other than Linux. Nodes without CPUs have an empty list.
+const std::vector<std::vector<int>>& GetNodeCpus();
+
+// Restricts the calling thread to the given CPUs. Returns 0 or a libuv
+// error code; CPUs that are out of range are reported as UV_EINVAL.
+int SetCurrentThreadAffinity(const std::vector<int>& cpus);
+
+// Makes the kernel prefer the given node for memory allocated by the
+// calling thread from now on, falling back to other nodes when it is full.
+// Returns 0 or a libuv error code, UV_ENOTSUP outside of Linux.
+int SetCurrentThreadPreferredNode(int node);
+
+// Binds the calling thread to the CPUs and the memory of the given node.
+int BindCurrentThreadToNode(int node);
+
+}  // namespace numa
+}  // namespace node
+
+#endif  // defined(NODE_WANT_INTERNALS) && NODE_WANT_INTERNALS
+
+#endif  // SRC_NODE_NUMA_H_
@@ -253,6 +253,7 @@ void OptionsParser<Options>::Insert(
   aliases_.insert(std::begin(child_options_parser.aliases_),
                   std::end(child_options_parser.aliases_));
 
+  options_.reserve(options_.size() + child_options_parser.options_.size());
   for (const auto& pair : child_options_parser.options_)
     options_.emplace(pair.first, Convert(pair.second, get_child));
 
@@ -104,6 +104,22 @@ void PerProcessOptions::CheckOptions(std::vector<std::string>* errors,
       use_largepages != "silent") {
     errors->push_back("invalid value for --use-largepages");
   }
+
+  if (trace_event_format != "json" && trace_event_format != "proto") {
+    errors->push_back("--trace-event-format must be \"json\" or \"proto\"");
+  }
+
+  if (prestart_fd != -1) {
+#ifdef _WIN32
+    errors->push_back("--prestart-fd is not supported on Windows");
+#else
+    if (prestart_fd < 0 || prestart_fd > std::numeric_limits<int>::max())
+      errors->push_back("--prestart-fd must be a file descriptor");
+    // The script and its arguments come with the job.
+    if (argv->size() > 1)
+      errors->push_back("--prestart-fd cannot be used with a script");
+#endif  // _WIN32
+  }
   per_isolate->CheckOptions(errors, argv);
 }
 
@@ -146,6 +162,12 @@ void EnvironmentOptions::CheckOptions(std::vector<std::string>* errors,
     errors->push_back("--heapsnapshot-near-heap-limit must not be negative");
   }
 
+  if (!heap_snapshot_compression.empty() &&
+      heap_snapshot_compression != "none" &&
+      heap_snapshot_compression != "zstd") {
+    errors->push_back("invalid value for --heapsnapshot-compression");
+  }
+
   if (!trace_require_module.empty() && trace_require_module != "all" &&
       trace_require_module != "no-node-modules") {
     errors->push_back("invalid value for --trace-require-module");
@@ -203,7 +225,22 @@ void EnvironmentOptions::CheckOptions(std::vector<std::string>* errors,
   }
 
 #if HAVE_INSPECTOR
-  if (!cpu_prof) {
+  // --cpu-prof-signal arms the continuous mode without starting it.
+  bool cpu_prof_continuous_mode =
+      cpu_prof_continuous || !cpu_prof_signal.empty();
+  if (cpu_prof && cpu_prof_continuous_mode) {
+    errors->push_back("--cpu-prof cannot be used with --cpu-prof-continuous "
+                      "or --cpu-prof-signal");
+  }
+  if (!cpu_prof_continuous_mode && cpu_prof_window != kDefaultCpuProfWindow) {
+    errors->push_back("--cpu-prof-window must be used with "
+                      "--cpu-prof-continuous or --cpu-prof-signal");
+  }
+  if (cpu_prof_window == 0) {
+    errors->push_back("--cpu-prof-window must be greater than 0");
+  }
+
+  if (!cpu_prof && !cpu_prof_continuous_mode) {
     if (!cpu_prof_name.empty()) {
       errors->push_back("--cpu-prof-name must be used with --cpu-prof");
     }
@@ -217,11 +254,24 @@ void EnvironmentOptions::CheckOptions(std::vector<std::string>* errors,
     }
   }
 
-  if (cpu_prof && cpu_prof_dir.empty() && !diagnostic_dir.empty()) {
+  if ((cpu_prof || cpu_prof_continuous_mode) && cpu_prof_dir.empty() &&
+      !diagnostic_dir.empty()) {
       cpu_prof_dir = diagnostic_dir;
     }
 
-  if (!heap_prof) {
+  if (heap_prof && heap_prof_continuous) {
+    errors->push_back(
+        "--heap-prof cannot be used with --heap-prof-continuous");
+  }
+  if (!heap_prof_continuous && heap_prof_window != kDefaultHeapProfWindow) {
+    errors->push_back(
+        "--heap-prof-window must be used with --heap-prof-continuous");
+  }
+  if (heap_prof_window == 0) {
+    errors->push_back("--heap-prof-window must be greater than 0");
+  }
+
+  if (!heap_prof && !heap_prof_continuous) {
     if (!heap_prof_name.empty()) {
       errors->push_back("--heap-prof-name must be used with --heap-prof");
     }
@@ -235,7 +285,8 @@ void EnvironmentOptions::CheckOptions(std::vector<std::string>* errors,
     }
   }
 
-  if (heap_prof && heap_prof_dir.empty() && !diagnostic_dir.empty()) {
+  if ((heap_prof || heap_prof_continuous) && heap_prof_dir.empty() &&
+      !diagnostic_dir.empty()) {
     heap_prof_dir = diagnostic_dir;
   }
 
@@ -422,6 +473,12 @@ DebugOptionsParser::DebugOptionsParser() {
 }
 
 EnvironmentOptionsParser::EnvironmentOptionsParser() {
+  AddOption("--coalesce-task-queues",
+            "process the nextTick and microtask queues once after a batch "
+            "of native callbacks, such as MessagePort messages, rather than "
+            "after each callback",
+            &EnvironmentOptions::coalesce_task_queues,
+            kAllowedInEnvvar);
   AddOption("--conditions",
             "additional user conditions for conditional exports and imports",
             &EnvironmentOptions::conditions,
@@ -611,6 +668,11 @@ EnvironmentOptionsParser::EnvironmentOptionsParser() {
             "heap snapshots will be generated.",
             &EnvironmentOptions::heap_snapshot_near_heap_limit,
             kAllowedInEnvvar);
+  AddOption("--heapsnapshot-compression",
+            "compress the heap snapshots that --heapsnapshot-near-heap-limit "
+            "generates while writing them (none, zstd)",
+            &EnvironmentOptions::heap_snapshot_compression,
+            kAllowedInEnvvar);
   AddOption("--http-parser", "", NoOp{}, kAllowedInEnvvar);
   AddOption("--insecure-http-parser",
             "use an insecure HTTP parser that accepts invalid HTTP headers",
@@ -705,6 +767,20 @@ EnvironmentOptionsParser::EnvironmentOptionsParser() {
             "placed. Does not affect --prof.",
             &EnvironmentOptions::cpu_prof_dir,
             kAllowedInEnvvar);
+  AddOption("--cpu-prof-continuous",
+            "Keep the V8 CPU profiler running, and write a pprof profile of "
+            "every --cpu-prof-window milliseconds to --cpu-prof-dir.",
+            &EnvironmentOptions::cpu_prof_continuous,
+            kAllowedInEnvvar);
+  AddOption("--cpu-prof-window",
+            "length in milliseconds of the profiles written by "
+            "--cpu-prof-continuous. (default: 60000)",
+            &EnvironmentOptions::cpu_prof_window,
+            kAllowedInEnvvar);
+  AddOption("--cpu-prof-signal",
+            "signal that toggles continuous CPU profiling on and off",
+            &EnvironmentOptions::cpu_prof_signal,
+            kAllowedInEnvvar);
   AddOption("--experimental-network-inspection",
             "experimental network inspection support",
             &EnvironmentOptions::experimental_network_inspection);
@@ -733,6 +809,17 @@ EnvironmentOptionsParser::EnvironmentOptionsParser() {
             "profile generated with --heap-prof. (default: 512 * 1024)",
             &EnvironmentOptions::heap_prof_interval,
             kAllowedInEnvvar);
+  AddOption("--heap-prof-continuous",
+            "Keep V8's sampling heap profiler running, and write a pprof "
+            "profile of the live sampled allocations every "
+            "--heap-prof-window milliseconds to --heap-prof-dir.",
+            &EnvironmentOptions::heap_prof_continuous,
+            kAllowedInEnvvar);
+  AddOption("--heap-prof-window",
+            "interval in milliseconds between the profiles written by "
+            "--heap-prof-continuous. (default: 60000)",
+            &EnvironmentOptions::heap_prof_window,
+            kAllowedInEnvvar);
 #endif  // HAVE_INSPECTOR
   AddOption("--max-http-header-size",
             "set the maximum size of HTTP headers (default: 16384 (16KB))",
@@ -758,6 +845,18 @@ EnvironmentOptionsParser::EnvironmentOptionsParser() {
   AddOption("--experimental-default-config-file",
             "set config file from default config file",
             &EnvironmentOptions::experimental_default_config_file);
+  AddOption("--shared-stat-polling",
+            "poll the files watched with fs.watchFile() with the same "
+            "interval in one threadpool job per interval, rather than in "
+            "one job per file",
+            &EnvironmentOptions::shared_stat_polling,
+            kAllowedInEnvvar);
+  AddOption("--tcp-reuseport",
+            "bind TCP servers with SO_REUSEPORT, so that the main thread and "
+            "worker threads can each listen on the same port and the kernel "
+            "spreads connections between them",
+            &EnvironmentOptions::tcp_reuseport,
+            kAllowedInEnvvar);
   AddOption("--test",
             "launch test runner on startup",
             &EnvironmentOptions::test_runner,
@@ -877,6 +976,12 @@ EnvironmentOptionsParser::EnvironmentOptionsParser() {
             "throw an exception on deprecations",
             &EnvironmentOptions::throw_deprecation,
             kAllowedInEnvvar);
+  AddOption("--timer-slack",
+            "delay timer expirations to the next multiple of this many "
+            "milliseconds, so that they are handled in fewer wakeups "
+            "(0 means no slack)",
+            &EnvironmentOptions::timer_slack,
+            kAllowedInEnvvar);
   AddOption("--trace-deprecation",
             "show stack traces on deprecations",
             &EnvironmentOptions::trace_deprecation,
@@ -1151,12 +1256,73 @@ PerProcessOptionsParser::PerProcessOptionsParser(
             "data, it supports ${rotation} and ${pid}.",
             &PerProcessOptions::trace_event_file_pattern,
             kAllowedInEnvvar);
+  AddOption("--trace-event-format",
+            "format of the trace-events data, either json (the default) "
+            "or proto (Perfetto's protobuf trace format)",
+            &PerProcessOptions::trace_event_format,
+            kAllowedInEnvvar);
   AddAlias("--trace-events-enabled", {
     "--trace-event-categories", "v8,node,node.async_hooks" });
+  AddOption("--threadpool-crypto-limit",
+            "maximum number of crypto jobs that run on the libuv threadpool "
+            "at the same time in the whole process (0 means no limit)",
+            &PerProcessOptions::threadpool_crypto_limit,
+            kAllowedInEnvvar);
+  AddOption("--threadpool-dns-limit",
+            "maximum number of dns.lookup() and dns.lookupService() requests "
+            "that run on the libuv threadpool at the same time in the whole "
+            "process (0 means no limit)",
+            &PerProcessOptions::threadpool_dns_limit,
+            kAllowedInEnvvar);
+  AddOption("--threadpool-user-limit",
+            "maximum number of Node-API async work items that run on the "
+            "libuv threadpool at the same time in the whole process "
+            "(0 means no limit)",
+            &PerProcessOptions::threadpool_user_limit,
+            kAllowedInEnvvar);
+  AddOption("--threadpool-zlib-limit",
+            "maximum number of zlib, brotli and zstd operations that run on "
+            "the libuv threadpool at the same time in the whole process "
+            "(0 means no limit)",
+            &PerProcessOptions::threadpool_zlib_limit,
+            kAllowedInEnvvar);
   AddOption("--v8-pool-size",
             "set V8's thread pool size",
             &PerProcessOptions::v8_thread_pool_size,
             kAllowedInEnvvar);
+  AddOption("--v8-user-blocking-pool-size",
+            "set the number of additional V8 worker threads reserved for "
+            "user-blocking tasks such as garbage collection",
+            &PerProcessOptions::v8_user_blocking_thread_pool_size,
+            kAllowedInEnvvar);
+  AddOption("--wasm-shared-module-cache-size",
+            "keep up to this many MiB of compiled WebAssembly modules alive "
+            "for the whole process, so that worker threads compiling the "
+            "same bytes reuse their native code (default: 0, disabled)",
+            &PerProcessOptions::wasm_shared_module_cache_size,
+            kAllowedInEnvvar);
+  AddOption("--v8-pool-numa-affinity",
+            "spread V8's worker threads over the NUMA nodes of the host and "
+            "bind each of them to the CPUs and memory of its node",
+            &PerProcessOptions::v8_pool_numa_affinity,
+            kAllowedInEnvvar);
+  AddOption("--fast-exit",
+            "once the event loop of the main thread is done, exit the way "
+            "process.exit() does, leaving handles and objects to the "
+            "operating system instead of freeing them one by one",
+            &PerProcessOptions::fast_exit,
+            kAllowedInEnvvar);
+  AddOption("--experimental-shared-heap",
+            "experimental V8 shared heap for the main thread and all worker "
+            "threads: one string table for all of them, and shared structs "
+            "and arrays that postMessage() passes without copying",
+            &PerProcessOptions::experimental_shared_heap,
+            kAllowedInEnvvar);
+  AddOption("--prestart-fd",
+            "initialize, then wait for the working directory, arguments and "
+            "environment of the script to run to be written to this file "
+            "descriptor",
+            &PerProcessOptions::prestart_fd);
   AddOption("--zero-fill-buffers",
             "automatically zero-fill all newly allocated Buffer instances",
             &PerProcessOptions::zero_fill_all_buffers,
@@ -1285,6 +1451,12 @@ PerProcessOptionsParser::PerProcessOptionsParser(
             &PerProcessOptions::secure_heap_min,
             kAllowedInEnvvar);
 #endif  // V8_ENABLE_SANDBOX
+  AddOption("--scrypt-memory-budget",
+            "limit the memory that scrypt derivations use at the same time "
+            "in the whole process to this many MiB, making the others wait "
+            "(default: 0, unlimited)",
+            &PerProcessOptions::scrypt_memory_budget,
+            kAllowedInEnvvar);
 #endif  // HAVE_OPENSSL
 #if OPENSSL_VERSION_MAJOR >= 3
   AddOption("--openssl-legacy-provider",
@@ -1304,6 +1476,11 @@ PerProcessOptionsParser::PerProcessOptionsParser(
             "or 'silent' (map and silently ignore failure)",
             &PerProcessOptions::use_largepages,
             kAllowedInEnvvar);
+  AddOption("--huge-page-threshold",
+            "ask for ArrayBuffer allocations of at least this many bytes to "
+            "be backed by transparent huge pages (0 means never)",
+            &PerProcessOptions::huge_page_threshold,
+            kAllowedInEnvvar);
 
   AddOption("--trace-sigint",
             "enable printing JavaScript stacktrace on SIGINT",
@@ -1418,17 +1595,20 @@ std::string GetBashCompletion() {
   return out.str();
 }
 
-std::unordered_map<std::string, options_parser::OptionType>
+const std::unordered_map<std::string, options_parser::OptionType>&
 MapEnvOptionsFlagInputType() {
-  std::unordered_map<std::string, options_parser::OptionType> type_map;
-  const auto& parser = _ppop_instance;
-  for (const auto& item : parser.options_) {
-    if (!item.first.empty() && !item.first.starts_with('[') &&
-        item.second.env_setting == kAllowedInEnvvar) {
-      type_map[item.first] = item.second.type;
+  static const auto* const type_map = [] {
+    auto* type_map =
+        new std::unordered_map<std::string, options_parser::OptionType>();
+    for (const auto& item : _ppop_instance.options_) {
+      if (!item.first.empty() && !item.first.starts_with('[') &&
+          item.second.env_setting == kAllowedInEnvvar) {
+        (*type_map)[item.first] = item.second.type;
+      }
     }
-  }
-  return type_map;
+    return type_map;
+  }();
+  return *type_map;
 }
 
 std::vector<std::string> MapAvailableNamespaces() {
@@ -1445,17 +1625,22 @@ std::vector<std::string> MapAvailableNamespaces() {
   return namespaceNames;
 }
 
-std::unordered_map<std::string, options_parser::OptionType>
-MapOptionsByNamespace(std::string namespace_name) {
-  std::unordered_map<std::string, options_parser::OptionType> type_map;
-  const auto& parser = _ppop_instance;
-  for (const auto& item : parser.options_) {
-    if (!item.first.empty() && !item.first.starts_with('[') &&
-        item.second.namespace_id == namespace_name) {
-      type_map[item.first] = item.second.type;
+const std::unordered_map<std::string, options_parser::OptionType>&
+MapOptionsByNamespace(const std::string& namespace_name) {
+  using TypeMap = std::unordered_map<std::string, options_parser::OptionType>;
+  // Sort all options into their namespaces in one pass.
+  static const auto* const namespaces = [] {
+    auto* namespaces = new std::unordered_map<std::string, TypeMap>();
+    for (const auto& item : _ppop_instance.options_) {
+      if (!item.first.empty() && !item.first.starts_with('[')) {
+        (*namespaces)[item.second.namespace_id][item.first] = item.second.type;
+      }
     }
-  }
-  return type_map;
+    return namespaces;
+  }();
+  static const TypeMap* const empty = new TypeMap();
+  auto it = namespaces->find(namespace_name);
+  return it == namespaces->end() ? *empty : it->second;
 }
 
 std::unordered_map<std::string,
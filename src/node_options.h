@@ -114,11 +114,14 @@ class DebugOptions : public Options {
 class EnvironmentOptions : public Options {
  public:
   bool abort_on_uncaught_exception = false;
+  bool coalesce_task_queues = false;
   std::vector<std::string> conditions;
   bool detect_module = true;
   bool disable_sigusr1 = false;
   bool print_required_tla = false;
   bool require_module = true;
+  bool shared_stat_polling = false;
+  bool tcp_reuseport = false;
   std::string dns_result_order;
   bool enable_source_maps = false;
   bool experimental_addon_modules = false;
@@ -153,6 +156,7 @@ class EnvironmentOptions : public Options {
   bool frozen_intrinsics = false;
   int64_t heap_snapshot_near_heap_limit = 0;
   std::string heap_snapshot_signal;
+  std::string heap_snapshot_compression;
   bool network_family_autoselection = true;
   uint64_t network_family_autoselection_attempt_timeout = 250;
   uint64_t max_http_header_size = 16 * 1024;
@@ -173,6 +177,10 @@ class EnvironmentOptions : public Options {
   uint64_t cpu_prof_interval = kDefaultCpuProfInterval;
   std::string cpu_prof_name;
   bool cpu_prof = false;
+  bool cpu_prof_continuous = false;
+  static const uint64_t kDefaultCpuProfWindow = 60 * 1000;
+  uint64_t cpu_prof_window = kDefaultCpuProfWindow;
+  std::string cpu_prof_signal;
   bool experimental_network_inspection = false;
   bool experimental_worker_inspection = false;
   std::string heap_prof_dir;
@@ -180,6 +188,9 @@ class EnvironmentOptions : public Options {
   static const uint64_t kDefaultHeapProfInterval = 512 * 1024;
   uint64_t heap_prof_interval = kDefaultHeapProfInterval;
   bool heap_prof = false;
+  bool heap_prof_continuous = false;
+  static const uint64_t kDefaultHeapProfWindow = 60 * 1000;
+  uint64_t heap_prof_window = kDefaultHeapProfWindow;
 #endif  // HAVE_INSPECTOR
   std::string redirect_warnings;
   std::string diagnostic_dir;
@@ -208,6 +219,7 @@ class EnvironmentOptions : public Options {
   std::vector<std::string> coverage_include_pattern;
   std::vector<std::string> coverage_exclude_pattern;
   bool throw_deprecation = false;
+  uint64_t timer_slack = 0;
   bool trace_deprecation = false;
   bool trace_exit = false;
   bool trace_sync_io = false;
@@ -313,7 +325,14 @@ class PerProcessOptions : public Options {
   std::string title;
   std::string trace_event_categories;
   std::string trace_event_file_pattern = "node_trace.${rotation}.log";
+  std::string trace_event_format = "json";
   int64_t v8_thread_pool_size = 4;
+  int64_t v8_user_blocking_thread_pool_size = 0;
+  int64_t wasm_shared_module_cache_size = 0;
+  bool v8_pool_numa_affinity = false;
+  bool fast_exit = false;
+  bool experimental_shared_heap = false;
+  int64_t prestart_fd = -1;
   bool zero_fill_all_buffers = false;
   bool debug_arraybuffer_allocations = false;
   std::string disable_proto;
@@ -342,6 +361,7 @@ class PerProcessOptions : public Options {
   std::string tls_cipher_list = DEFAULT_CIPHER_LIST_CORE;
   int64_t secure_heap = 0;
   int64_t secure_heap_min = 2;
+  uint64_t scrypt_memory_budget = 0;
 #ifdef NODE_OPENSSL_CERT_STORE
   bool ssl_openssl_cert_store = true;
 #else
@@ -368,7 +388,12 @@ class PerProcessOptions : public Options {
 
   // TODO(addaleax): Some of these could probably be per-Environment.
   std::string use_largepages = "off";
+  uint64_t huge_page_threshold = 0;
   bool trace_sigint = false;
+  uint64_t threadpool_crypto_limit = 0;
+  uint64_t threadpool_dns_limit = 0;
+  uint64_t threadpool_user_limit = 0;
+  uint64_t threadpool_zlib_limit = 0;
   std::vector<std::string> cmdline;
 
   inline PerIsolateOptions* get_per_isolate_options();
@@ -395,9 +420,11 @@ enum OptionType {
   kHostPort,
   kStringList,
 };
-std::unordered_map<std::string, OptionType> MapEnvOptionsFlagInputType();
-std::unordered_map<std::string, OptionType> MapOptionsByNamespace(
-    std::string namespace_name);
+// These tables are built once, on first use, as the options do not change
+// after static initialization.
+const std::unordered_map<std::string, OptionType>& MapEnvOptionsFlagInputType();
+const std::unordered_map<std::string, OptionType>& MapOptionsByNamespace(
+    const std::string& namespace_name);
 std::unordered_map<std::string,
                    std::unordered_map<std::string, options_parser::OptionType>>
 MapNamespaceOptionsAssociations();
@@ -636,10 +663,10 @@ class OptionsParser {
   friend void GetCLIOptionsInfo(
       const v8::FunctionCallbackInfo<v8::Value>& args);
   friend std::string GetBashCompletion();
-  friend std::unordered_map<std::string, OptionType>
+  friend const std::unordered_map<std::string, OptionType>&
   MapEnvOptionsFlagInputType();
-  friend std::unordered_map<std::string, OptionType> MapOptionsByNamespace(
-      std::string namespace_name);
+  friend const std::unordered_map<std::string, OptionType>&
+  MapOptionsByNamespace(const std::string& namespace_name);
   friend std::vector<std::string> MapAvailableNamespaces();
   friend void GetEnvOptionsInputType(
       const v8::FunctionCallbackInfo<v8::Value>& args);
@@ -24,6 +24,7 @@ using v8::GCType;
 using v8::Integer;
 using v8::Isolate;
 using v8::Local;
+using v8::LocalVector;
 using v8::MaybeLocal;
 using v8::Object;
 using v8::ObjectTemplate;
@@ -57,7 +58,19 @@ PerformanceState::PerformanceState(Isolate* isolate,
                 offsetof(performance_state_internal, observers),
                 NODE_PERFORMANCE_ENTRY_TYPE_INVALID,
                 root,
-                MAYBE_FIELD_PTR(info, observers)) {
+                MAYBE_FIELD_PTR(info, observers)),
+      gc_pauses(isolate,
+                offsetof(performance_state_internal, gc_pauses),
+                NODE_PERFORMANCE_GC_PAUSE_INVALID *
+                    size_t{NODE_PERFORMANCE_GC_PAUSE_FIELD_INVALID},
+                root,
+                MAYBE_FIELD_PTR(info, gc_pauses)),
+      heap_spaces(isolate,
+                  offsetof(performance_state_internal, heap_spaces),
+                  kPerformanceMaxHeapSpaces *
+                      NODE_PERFORMANCE_HEAP_SPACE_FIELD_INVALID,
+                  root,
+                  MAYBE_FIELD_PTR(info, heap_spaces)) {
   if (info == nullptr) {
     // For performance states initialized from scratch, reset
     // all the milestones and initialize the time origin.
@@ -83,7 +96,9 @@ PerformanceState::SerializeInfo PerformanceState::Serialize(
 
   SerializeInfo info{root.Serialize(context, creator),
                      milestones.Serialize(context, creator),
-                     observers.Serialize(context, creator)};
+                     observers.Serialize(context, creator),
+                     gc_pauses.Serialize(context, creator),
+                     heap_spaces.Serialize(context, creator)};
   return info;
 }
 
@@ -105,6 +120,8 @@ void PerformanceState::Deserialize(v8::Local<v8::Context> context,
   root.Deserialize(context);
   milestones.Deserialize(context);
   observers.Deserialize(context);
+  gc_pauses.Deserialize(context);
+  heap_spaces.Deserialize(context);
 
   // Re-initialize the time origin and timestamp i.e. the process start time.
   Initialize(time_origin, time_origin_timestamp);
@@ -116,6 +133,8 @@ std::ostream& operator<<(std::ostream& o,
     << "  " << i.root << ",  // root\n"
     << "  " << i.milestones << ",  // milestones\n"
     << "  " << i.observers << ",  // observers\n"
+    << "  " << i.gc_pauses << ",  // gc_pauses\n"
+    << "  " << i.heap_spaces << ",  // heap_spaces\n"
     << "}";
   return o;
 }
@@ -128,6 +147,154 @@ void PerformanceState::Mark(PerformanceMilestone milestone, uint64_t ts) {
       TRACE_EVENT_SCOPE_THREAD, ts / 1000);
 }
 
+namespace {
+
+// Pauses are recorded with a 1us resolution, which is plenty for GC, and
+// two significant figures, which keeps the four histograms small enough
+// to always allocate them.
+const Histogram::Options kGCPauseHistogramOptions{
+    1000, 60 * 1000 * 1000 * 1000LL, 2};
+
+PerformanceGCPauseKind ToGCPauseKind(GCType type) {
+  switch (type) {
+    case GCType::kGCTypeScavenge:
+    case GCType::kGCTypeMinorMarkSweep:
+      return NODE_PERFORMANCE_GC_PAUSE_MINOR;
+    case GCType::kGCTypeIncrementalMarking:
+      return NODE_PERFORMANCE_GC_PAUSE_INCREMENTAL;
+    case GCType::kGCTypeProcessWeakCallbacks:
+      return NODE_PERFORMANCE_GC_PAUSE_WEAKCB;
+    default:
+      return NODE_PERFORMANCE_GC_PAUSE_MAJOR;
+  }
+}
+
+size_t HeapSpaceCount(Isolate* isolate) {
+  return std::min(isolate->NumberOfHeapSpaces(), kPerformanceMaxHeapSpaces);
+}
+
+}  // namespace
+
+void PerformanceState::InstallGCMetrics(Isolate* isolate) {
+  CHECK(!gc_metrics_installed_);
+  for (size_t i = 0; i < NODE_PERFORMANCE_GC_PAUSE_INVALID; ++i)
+    gc_pause_histograms_[i] =
+        std::make_shared<Histogram>(kGCPauseHistogramOptions);
+  gc_metrics_type_ = 0;
+  gc_metrics_installed_ = true;
+  isolate->AddGCPrologueCallback(RecordGCStart, this);
+  isolate->AddGCEpilogueCallback(RecordGCEnd, this);
+}
+
+void PerformanceState::RemoveGCMetrics(Isolate* isolate) {
+  if (!gc_metrics_installed_) return;
+  gc_metrics_installed_ = false;
+  isolate->RemoveGCPrologueCallback(RecordGCStart, this);
+  isolate->RemoveGCEpilogueCallback(RecordGCEnd, this);
+}
+
+std::shared_ptr<Histogram> PerformanceState::gc_pause_histogram(
+    PerformanceGCPauseKind kind) {
+  CHECK_LT(kind, NODE_PERFORMANCE_GC_PAUSE_INVALID);
+  return gc_pause_histograms_[kind];
+}
+
+void PerformanceState::RecordGCStart(Isolate* isolate,
+                                     GCType type,
+                                     GCCallbackFlags flags,
+                                     void* data) {
+  PerformanceState* state = static_cast<PerformanceState*>(data);
+  // Only the outermost GC of nested callbacks is recorded, like for the
+  // gc performance entries.
+  if (state->gc_metrics_type_ != 0) return;
+  state->gc_metrics_type_ = type;
+  state->SampleHeapSpaces(isolate, false);
+  state->gc_metrics_start_mark_ = PERFORMANCE_NOW();
+}
+
+void PerformanceState::RecordGCEnd(Isolate* isolate,
+                                   GCType type,
+                                   GCCallbackFlags flags,
+                                   void* data) {
+  PerformanceState* state = static_cast<PerformanceState*>(data);
+  if (type != state->gc_metrics_type_) return;
+  state->gc_metrics_type_ = 0;
+  uint64_t duration = PERFORMANCE_NOW() - state->gc_metrics_start_mark_;
+  PerformanceGCPauseKind kind = ToGCPauseKind(type);
+  state->gc_pause_totals_[kind] += duration;
+  state->gc_pause_histograms_[kind]->Record(std::min<int64_t>(
+      static_cast<int64_t>(duration), kGCPauseHistogramOptions.highest));
+  state->SampleHeapSpaces(isolate, true);
+}
+
+// Allocations are measured as the growth of each space between the end
+// of one GC and the start of the next one, so that objects a GC moves from
+// one space to another are not counted as allocated in the second one.
+void PerformanceState::SampleHeapSpaces(Isolate* isolate, bool gc_end) {
+  size_t count = HeapSpaceCount(isolate);
+  for (size_t i = 0; i < count; ++i) {
+    v8::HeapSpaceStatistics stats;
+    if (!isolate->GetHeapSpaceStatistics(&stats, i)) continue;
+    size_t used = stats.space_used_size();
+    if (gc_end) {
+      heap_space_used_after_gc_[i] = used;
+    } else if (used > heap_space_used_after_gc_[i]) {
+      heap_space_allocated_[i] += used - heap_space_used_after_gc_[i];
+    }
+  }
+}
+
+void PerformanceState::UpdateGCMetrics(Isolate* isolate) {
+  CHECK(gc_metrics_installed_);
+  for (size_t i = 0; i < NODE_PERFORMANCE_GC_PAUSE_INVALID; ++i) {
+    const Histogram& histogram = *gc_pause_histograms_[i];
+    size_t pauses = histogram.Count();
+    double min = 0;
+    double max = 0;
+    double p50 = 0;
+    double p99 = 0;
+    if (pauses > 0) {
+      min = histogram.Min() / NANOS_PER_MILLIS;
+      max = histogram.Max() / NANOS_PER_MILLIS;
+      p50 = histogram.Percentile(50) / NANOS_PER_MILLIS;
+      p99 = histogram.Percentile(99) / NANOS_PER_MILLIS;
+    }
+    size_t base = i * NODE_PERFORMANCE_GC_PAUSE_FIELD_INVALID;
+    gc_pauses[base + NODE_PERFORMANCE_GC_PAUSE_FIELD_PAUSES] = pauses;
+    gc_pauses[base + NODE_PERFORMANCE_GC_PAUSE_FIELD_TOTAL] =
+        gc_pause_totals_[i] / NANOS_PER_MILLIS;
+    gc_pauses[base + NODE_PERFORMANCE_GC_PAUSE_FIELD_MIN] = min;
+    gc_pauses[base + NODE_PERFORMANCE_GC_PAUSE_FIELD_MAX] = max;
+    gc_pauses[base + NODE_PERFORMANCE_GC_PAUSE_FIELD_P50] = p50;
+    gc_pauses[base + NODE_PERFORMANCE_GC_PAUSE_FIELD_P99] = p99;
+  }
+
+  uint64_t now = PERFORMANCE_NOW();
+  double elapsed = heap_space_sample_mark_ == 0
+                       ? 0
+                       : (now - heap_space_sample_mark_) / 1e9;
+  heap_space_sample_mark_ = now;
+  size_t count = HeapSpaceCount(isolate);
+  for (size_t i = 0; i < count; ++i) {
+    v8::HeapSpaceStatistics stats;
+    if (!isolate->GetHeapSpaceStatistics(&stats, i)) continue;
+    size_t used = stats.space_used_size();
+    double allocated = heap_space_allocated_[i];
+    if (used > heap_space_used_after_gc_[i])
+      allocated += used - heap_space_used_after_gc_[i];
+    size_t base = i * NODE_PERFORMANCE_HEAP_SPACE_FIELD_INVALID;
+    heap_spaces[base + NODE_PERFORMANCE_HEAP_SPACE_FIELD_SIZE] =
+        stats.space_size();
+    heap_spaces[base + NODE_PERFORMANCE_HEAP_SPACE_FIELD_USED] = used;
+    heap_spaces[base + NODE_PERFORMANCE_HEAP_SPACE_FIELD_AVAILABLE] =
+        stats.space_available_size();
+    heap_spaces[base + NODE_PERFORMANCE_HEAP_SPACE_FIELD_ALLOCATED] = allocated;
+    heap_spaces[base + NODE_PERFORMANCE_HEAP_SPACE_FIELD_ALLOCATION_RATE] =
+        elapsed > 0 ? (allocated - heap_space_sampled_[i]) / elapsed : 0;
+    heap_space_sampled_[i] = allocated;
+  }
+}
+
 void SetupPerformanceObservers(const FunctionCallbackInfo<Value>& args) {
   Realm* realm = Realm::GetCurrent(args);
   // TODO(legendecas): Remove this check once the sub-realms are supported.
@@ -278,6 +445,83 @@ void UvMetricsInfo(const FunctionCallbackInfo<Value>& args) {
   args.GetReturnValue().Set(arr);
 }
 
+// Returns an object with the duration histogram of every event loop phase,
+// e.g. `result.poll`. The first call starts recording; the histograms are
+// shared with the Environment's EventLoopPhaseTimer.
+void GetEventLoopPhaseHistograms(const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+  Isolate* isolate = env->isolate();
+  Local<Context> context = env->context();
+  EventLoopPhaseTimer* timer = env->event_loop_phase_timer();
+  timer->Enable(env->event_loop());
+  Local<Object> result = Object::New(isolate);
+  for (size_t i = 0; i < kEventLoopPhaseCount; i++) {
+    EventLoopPhase phase = static_cast<EventLoopPhase>(i);
+    BaseObjectPtr<HistogramBase> histogram =
+        HistogramBase::Create(env, timer->histogram(phase));
+    if (!histogram) return;
+    if (result
+            ->Set(context,
+                  OneByteString(isolate, EventLoopPhaseName(phase)),
+                  histogram->object())
+            .IsNothing()) {
+      return;
+    }
+  }
+  args.GetReturnValue().Set(result);
+}
+
+// Copies the current GC pause and heap space metrics into the gcPauses
+// and heapSpaces arrays of the binding.
+static void UpdateGCMetrics(const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+  env->performance_state()->UpdateGCMetrics(env->isolate());
+}
+
+// Returns an object with the pause histogram of every GC kind, e.g.
+// `result.major`. The histograms are shared with the PerformanceState,
+// which keeps recording into them.
+static void GetGCPauseHistograms(const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+  Isolate* isolate = env->isolate();
+  Local<Context> context = env->context();
+  Local<Object> result = Object::New(isolate);
+#define V(name, label)                                                        \
+  {                                                                           \
+    BaseObjectPtr<HistogramBase> histogram = HistogramBase::Create(           \
+        env,                                                                  \
+        env->performance_state()->gc_pause_histogram(                         \
+            NODE_PERFORMANCE_GC_PAUSE_##name));                               \
+    if (!histogram) return;                                                   \
+    if (result                                                                \
+            ->Set(context,                                                    \
+                  FIXED_ONE_BYTE_STRING(isolate, label),                      \
+                  histogram->object())                                        \
+            .IsNothing()) {                                                   \
+      return;                                                                 \
+    }                                                                         \
+  }
+  NODE_PERFORMANCE_GC_PAUSE_KINDS(V)
+#undef V
+  args.GetReturnValue().Set(result);
+}
+
+// Returns the names of the heap spaces in the order of their fields in
+// the heapSpaces array.
+static void GetHeapSpaceNames(const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+  Isolate* isolate = env->isolate();
+  size_t count = HeapSpaceCount(isolate);
+  LocalVector<Value> names(isolate);
+  names.reserve(count);
+  for (size_t i = 0; i < count; ++i) {
+    v8::HeapSpaceStatistics stats;
+    isolate->GetHeapSpaceStatistics(&stats, i);
+    names.push_back(OneByteString(isolate, stats.space_name()));
+  }
+  args.GetReturnValue().Set(Array::New(isolate, names.data(), names.size()));
+}
+
 void CreateELDHistogram(const FunctionCallbackInfo<Value>& args) {
   Environment* env = Environment::GetCurrent(args);
   int64_t interval = args[0].As<Integer>()->Value();
@@ -299,6 +543,43 @@ void CreateELDHistogram(const FunctionCallbackInfo<Value>& args) {
   args.GetReturnValue().Set(histogram->object());
 }
 
+// Returns an object with a { wait, run, latency } object of histograms for
+// every class of threadpool work, e.g. `result.crypto.wait`. The histograms
+// are shared with the Environment's ThreadPoolWorkLimiter, which starts
+// recording into them on the first call.
+void GetThreadPoolWorkHistograms(const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+  Isolate* isolate = env->isolate();
+  Local<Context> context = env->context();
+  ThreadPoolWorkLimiter* limiter = env->threadpool_work_limiter();
+  Local<Object> result = Object::New(isolate);
+  for (size_t i = 0; i < kThreadPoolWorkClassCount; i++) {
+    ThreadPoolWorkClass work_class = static_cast<ThreadPoolWorkClass>(i);
+    Local<Object> histograms = Object::New(isolate);
+    for (size_t j = 0; j < kThreadPoolWorkHistogramCount; j++) {
+      ThreadPoolWorkHistogram kind = static_cast<ThreadPoolWorkHistogram>(j);
+      BaseObjectPtr<HistogramBase> histogram =
+          HistogramBase::Create(env, limiter->histogram(work_class, kind));
+      if (!histogram) return;
+      if (histograms
+              ->Set(context,
+                    OneByteString(isolate, ThreadPoolWorkHistogramName(kind)),
+                    histogram->object())
+              .IsNothing()) {
+        return;
+      }
+    }
+    if (result
+            ->Set(context,
+                  OneByteString(isolate, ThreadPoolWorkClassName(work_class)),
+                  histograms)
+            .IsNothing()) {
+      return;
+    }
+  }
+  args.GetReturnValue().Set(result);
+}
+
 void MarkBootstrapComplete(const FunctionCallbackInfo<Value>& args) {
   Realm* realm = Realm::GetCurrent(args);
   CHECK_EQ(realm->kind(), Realm::Kind::kPrincipal);
@@ -327,6 +608,7 @@ static void CreatePerIsolateProperties(IsolateData* isolate_data,
   Isolate* isolate = isolate_data->isolate();
 
   HistogramBase::Initialize(isolate_data, target);
+  RollingHistogramBase::Initialize(isolate_data, target);
 
   SetMethod(isolate, target, "setupObservers", SetupPerformanceObservers);
   SetMethod(isolate,
@@ -340,7 +622,18 @@ static void CreatePerIsolateProperties(IsolateData* isolate_data,
   SetMethod(isolate, target, "notify", Notify);
   SetMethod(isolate, target, "loopIdleTime", LoopIdleTime);
   SetMethod(isolate, target, "createELDHistogram", CreateELDHistogram);
+  SetMethod(isolate,
+            target,
+            "getThreadPoolWorkHistograms",
+            GetThreadPoolWorkHistograms);
+  SetMethod(isolate,
+            target,
+            "getEventLoopPhaseHistograms",
+            GetEventLoopPhaseHistograms);
   SetMethod(isolate, target, "markBootstrapComplete", MarkBootstrapComplete);
+  SetMethod(isolate, target, "updateGCMetrics", UpdateGCMetrics);
+  SetMethod(isolate, target, "getGCPauseHistograms", GetGCPauseHistograms);
+  SetMethod(isolate, target, "getHeapSpaceNames", GetHeapSpaceNames);
   SetMethod(isolate, target, "uvMetricsInfo", UvMetricsInfo);
   SetFastMethodNoSideEffect(
       isolate, target, "now", SlowPerformanceNow, &fast_performance_now);
@@ -360,6 +653,12 @@ void CreatePerContextProperties(Local<Object> target,
   target->Set(context,
               FIXED_ONE_BYTE_STRING(isolate, "milestones"),
               state->milestones.GetJSArray()).Check();
+  target->Set(context,
+              FIXED_ONE_BYTE_STRING(isolate, "gcPauses"),
+              state->gc_pauses.GetJSArray()).Check();
+  target->Set(context,
+              FIXED_ONE_BYTE_STRING(isolate, "heapSpaces"),
+              state->heap_spaces.GetJSArray()).Check();
 
   Local<Object> constants = Object::New(isolate);
 
@@ -393,6 +692,35 @@ void CreatePerContextProperties(Local<Object> target,
   NODE_PERFORMANCE_MILESTONES(V)
 #undef V
 
+#define V(name, _)                                                            \
+  NODE_DEFINE_HIDDEN_CONSTANT(constants, NODE_PERFORMANCE_GC_PAUSE_##name);
+  NODE_PERFORMANCE_GC_PAUSE_KINDS(V)
+#undef V
+  NODE_DEFINE_HIDDEN_CONSTANT(constants, NODE_PERFORMANCE_GC_PAUSE_INVALID);
+
+  NODE_DEFINE_HIDDEN_CONSTANT(constants,
+                              NODE_PERFORMANCE_GC_PAUSE_FIELD_PAUSES);
+  NODE_DEFINE_HIDDEN_CONSTANT(constants, NODE_PERFORMANCE_GC_PAUSE_FIELD_TOTAL);
+  NODE_DEFINE_HIDDEN_CONSTANT(constants, NODE_PERFORMANCE_GC_PAUSE_FIELD_MIN);
+  NODE_DEFINE_HIDDEN_CONSTANT(constants, NODE_PERFORMANCE_GC_PAUSE_FIELD_MAX);
+  NODE_DEFINE_HIDDEN_CONSTANT(constants, NODE_PERFORMANCE_GC_PAUSE_FIELD_P50);
+  NODE_DEFINE_HIDDEN_CONSTANT(constants, NODE_PERFORMANCE_GC_PAUSE_FIELD_P99);
+  NODE_DEFINE_HIDDEN_CONSTANT(constants,
+                              NODE_PERFORMANCE_GC_PAUSE_FIELD_INVALID);
+
+  NODE_DEFINE_HIDDEN_CONSTANT(constants,
+                              NODE_PERFORMANCE_HEAP_SPACE_FIELD_SIZE);
+  NODE_DEFINE_HIDDEN_CONSTANT(constants,
+                              NODE_PERFORMANCE_HEAP_SPACE_FIELD_USED);
+  NODE_DEFINE_HIDDEN_CONSTANT(constants,
+                              NODE_PERFORMANCE_HEAP_SPACE_FIELD_AVAILABLE);
+  NODE_DEFINE_HIDDEN_CONSTANT(constants,
+                              NODE_PERFORMANCE_HEAP_SPACE_FIELD_ALLOCATED);
+  NODE_DEFINE_HIDDEN_CONSTANT(
+      constants, NODE_PERFORMANCE_HEAP_SPACE_FIELD_ALLOCATION_RATE);
+  NODE_DEFINE_HIDDEN_CONSTANT(constants,
+                              NODE_PERFORMANCE_HEAP_SPACE_FIELD_INVALID);
+
   PropertyAttribute attr =
       static_cast<PropertyAttribute>(ReadOnly | DontDelete);
 
@@ -407,12 +735,18 @@ void RegisterExternalReferences(ExternalReferenceRegistry* registry) {
   registry->Register(Notify);
   registry->Register(LoopIdleTime);
   registry->Register(CreateELDHistogram);
+  registry->Register(GetThreadPoolWorkHistograms);
+  registry->Register(GetEventLoopPhaseHistograms);
   registry->Register(MarkBootstrapComplete);
+  registry->Register(UpdateGCMetrics);
+  registry->Register(GetGCPauseHistograms);
+  registry->Register(GetHeapSpaceNames);
   registry->Register(UvMetricsInfo);
   registry->Register(SlowPerformanceNow);
   registry->Register(FastPerformanceNow);
   registry->Register(fast_performance_now.GetTypeInfo());
   HistogramBase::RegisterExternalReferences(registry);
+  RollingHistogramBase::RegisterExternalReferences(registry);
   IntervalHistogram::RegisterExternalReferences(registry);
 }
 }  // namespace performance
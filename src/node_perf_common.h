@@ -9,11 +9,16 @@
 #include "v8.h"
 
 #include <algorithm>
+#include <array>
 #include <iostream>
 #include <map>
+#include <memory>
 #include <string>
 
 namespace node {
+
+class Histogram;
+
 namespace performance {
 
 #define PERFORMANCE_NOW() uv_hrtime()
@@ -55,12 +60,56 @@ enum PerformanceEntryType {
   NODE_PERFORMANCE_ENTRY_TYPE_INVALID
 };
 
+// The kinds of GC that pause durations are recorded for. Scavenges and
+// minor mark-sweeps are both recorded as minor GCs.
+#define NODE_PERFORMANCE_GC_PAUSE_KINDS(V)                                    \
+  V(MAJOR, "major")                                                           \
+  V(MINOR, "minor")                                                           \
+  V(INCREMENTAL, "incremental")                                               \
+  V(WEAKCB, "weakcb")
+
+enum PerformanceGCPauseKind {
+#define V(name, _) NODE_PERFORMANCE_GC_PAUSE_##name,
+  NODE_PERFORMANCE_GC_PAUSE_KINDS(V)
+#undef V
+  NODE_PERFORMANCE_GC_PAUSE_INVALID
+};
+
+// Per GC kind fields of PerformanceState::gc_pauses. Durations are in
+// milliseconds.
+enum PerformanceGCPauseField {
+  NODE_PERFORMANCE_GC_PAUSE_FIELD_PAUSES,
+  NODE_PERFORMANCE_GC_PAUSE_FIELD_TOTAL,
+  NODE_PERFORMANCE_GC_PAUSE_FIELD_MIN,
+  NODE_PERFORMANCE_GC_PAUSE_FIELD_MAX,
+  NODE_PERFORMANCE_GC_PAUSE_FIELD_P50,
+  NODE_PERFORMANCE_GC_PAUSE_FIELD_P99,
+  NODE_PERFORMANCE_GC_PAUSE_FIELD_INVALID
+};
+
+// Per heap space fields of PerformanceState::heap_spaces. Sizes are in
+// bytes, the allocation rate is in bytes per second.
+enum PerformanceHeapSpaceField {
+  NODE_PERFORMANCE_HEAP_SPACE_FIELD_SIZE,
+  NODE_PERFORMANCE_HEAP_SPACE_FIELD_USED,
+  NODE_PERFORMANCE_HEAP_SPACE_FIELD_AVAILABLE,
+  NODE_PERFORMANCE_HEAP_SPACE_FIELD_ALLOCATED,
+  NODE_PERFORMANCE_HEAP_SPACE_FIELD_ALLOCATION_RATE,
+  NODE_PERFORMANCE_HEAP_SPACE_FIELD_INVALID
+};
+
+// V8 currently has fewer heap spaces than this, any extra ones are not
+// reported.
+constexpr size_t kPerformanceMaxHeapSpaces = 16;
+
 class PerformanceState {
  public:
   struct SerializeInfo {
     AliasedBufferIndex root;
     AliasedBufferIndex milestones;
     AliasedBufferIndex observers;
+    AliasedBufferIndex gc_pauses;
+    AliasedBufferIndex heap_spaces;
   };
 
   explicit PerformanceState(v8::Isolate* isolate,
@@ -77,6 +126,8 @@ class PerformanceState {
   AliasedUint8Array root;
   AliasedFloat64Array milestones;
   AliasedUint32Array observers;
+  AliasedFloat64Array gc_pauses;
+  AliasedFloat64Array heap_spaces;
 
   uint64_t performance_last_gc_start_mark = 0;
   uint16_t current_gc_type = 0;
@@ -84,14 +135,51 @@ class PerformanceState {
   void Mark(enum PerformanceMilestone milestone,
             uint64_t ts = PERFORMANCE_NOW());
 
+  // The GC metrics are recorded from GC callbacks that are installed for
+  // the lifetime of the Environment, independently of any gc performance
+  // observers. UpdateGCMetrics() copies them into gc_pauses and
+  // heap_spaces, so that reading them from JS does not allocate.
+  void InstallGCMetrics(v8::Isolate* isolate);
+  void RemoveGCMetrics(v8::Isolate* isolate);
+  void UpdateGCMetrics(v8::Isolate* isolate);
+  std::shared_ptr<Histogram> gc_pause_histogram(PerformanceGCPauseKind kind);
+
  private:
   void Initialize(uint64_t time_origin, double time_origin_timestamp);
   void ResetMilestones();
+  static void RecordGCStart(v8::Isolate* isolate,
+                            v8::GCType type,
+                            v8::GCCallbackFlags flags,
+                            void* data);
+  static void RecordGCEnd(v8::Isolate* isolate,
+                          v8::GCType type,
+                          v8::GCCallbackFlags flags,
+                          void* data);
+  void SampleHeapSpaces(v8::Isolate* isolate, bool gc_end);
+
   struct performance_state_internal {
     // doubles first so that they are always sizeof(double)-aligned
     double milestones[NODE_PERFORMANCE_MILESTONE_INVALID];
+    double gc_pauses[NODE_PERFORMANCE_GC_PAUSE_INVALID *
+                     size_t{NODE_PERFORMANCE_GC_PAUSE_FIELD_INVALID}];
+    double heap_spaces[kPerformanceMaxHeapSpaces *
+                       NODE_PERFORMANCE_HEAP_SPACE_FIELD_INVALID];
     uint32_t observers[NODE_PERFORMANCE_ENTRY_TYPE_INVALID];
   };
+
+  bool gc_metrics_installed_ = false;
+  uint64_t gc_metrics_start_mark_ = 0;
+  uint16_t gc_metrics_type_ = 0;
+  std::shared_ptr<Histogram>
+      gc_pause_histograms_[NODE_PERFORMANCE_GC_PAUSE_INVALID];
+  // Total pause time per kind, in nanoseconds.
+  std::array<uint64_t, NODE_PERFORMANCE_GC_PAUSE_INVALID> gc_pause_totals_{};
+  // Bytes used by each heap space when the last GC ended, and the bytes
+  // allocated in it up to the last GC and up to the last UpdateGCMetrics().
+  std::array<size_t, kPerformanceMaxHeapSpaces> heap_space_used_after_gc_{};
+  std::array<double, kPerformanceMaxHeapSpaces> heap_space_allocated_{};
+  std::array<double, kPerformanceMaxHeapSpaces> heap_space_sampled_{};
+  uint64_t heap_space_sample_mark_ = 0;
 };
 
 }  // namespace performance
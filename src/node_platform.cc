@@ -3,6 +3,8 @@
 
 #include "env-inl.h"
 #include "debug_utils-inl.h"
+#include "node_numa.h"
+#include "node_thread_stats.h"
 #include <algorithm>  // find_if(), find(), move()
 #include <cmath>  // llround()
 #include <memory>  // unique_ptr(), shared_ptr(), make_shared()
@@ -18,14 +20,22 @@ using v8::TaskPriority;
 namespace {
 
 struct PlatformWorkerData {
-  TaskQueue<TaskQueueEntry>* task_queue;
+  WorkerThreadsTaskRunner* runner;
   Mutex* platform_workers_mutex;
   ConditionVariable* platform_workers_ready;
   int* pending_platform_workers;
   int id;
   PlatformDebugLogLevel debug_log_level;
+  // The NUMA node to bind the thread to, or -1.
+  int numa_node;
 };
 
+// The runner and worker id of the current thread if it is a platform worker
+// thread, so that tasks posted from inside a worker task can be pushed to
+// that worker's own deque.
+thread_local WorkerThreadsTaskRunner* current_runner = nullptr;
+thread_local int current_worker_id = -1;
+
 const char* GetTaskPriorityName(TaskPriority priority) {
   switch (priority) {
     case TaskPriority::kUserBlocking:
@@ -50,10 +60,17 @@ static void PrintSourceLocation(const v8::SourceLocation& location) {
 
 static void PlatformWorkerThread(void* data) {
   uv_thread_setname("V8Worker");
+  thread_stats::SetCurrentThreadKind(thread_stats::kPlatformThread);
   std::unique_ptr<PlatformWorkerData>
       worker_data(static_cast<PlatformWorkerData*>(data));
 
-  TaskQueue<TaskQueueEntry>* pending_worker_tasks = worker_data->task_queue;
+  WorkerThreadsTaskRunner* runner = worker_data->runner;
+  current_runner = runner;
+  current_worker_id = worker_data->id;
+  if (worker_data->numa_node >= 0) {
+    // Binding is best effort, e.g. a cpuset may exclude some of the CPUs.
+    numa::BindCurrentThreadToNode(worker_data->numa_node);
+  }
   TRACE_EVENT_METADATA1("__metadata", "thread_name", "name",
                         "PlatformWorkerThread");
 
@@ -67,8 +84,7 @@ static void PlatformWorkerThread(void* data) {
   bool debug_log_enabled =
       worker_data->debug_log_level != PlatformDebugLogLevel::kNone;
   int id = worker_data->id;
-  while (std::unique_ptr<TaskQueueEntry> entry =
-             pending_worker_tasks->Lock().BlockingPop()) {
+  while (std::unique_ptr<TaskQueueEntry> entry = runner->BlockingPop(id)) {
     if (debug_log_enabled) {
       fprintf(stderr,
               "\nPlatformWorkerThread %d running task %p %s\n",
@@ -79,10 +95,9 @@ static void PlatformWorkerThread(void* data) {
     }
     entry->task->Run();
     // See NodePlatform::DrainTasks().
-    if (entry->is_outstanding()) {
-      pending_worker_tasks->Lock().NotifyOfOutstandingCompletion();
-    }
+    runner->NotifyOfCompletion(*entry);
   }
+  thread_stats::ClearCurrentThreadKind();
 }
 
 static int GetActualThreadPoolSize(int thread_pool_size) {
@@ -96,8 +111,8 @@ static int GetActualThreadPoolSize(int thread_pool_size) {
 
 class WorkerThreadsTaskRunner::DelayedTaskScheduler {
  public:
-  explicit DelayedTaskScheduler(TaskQueue<TaskQueueEntry>* tasks)
-      : pending_worker_tasks_(tasks) {}
+  explicit DelayedTaskScheduler(WorkerThreadsTaskRunner* runner)
+      : runner_(runner) {}
 
   std::unique_ptr<uv_thread_t> Start() {
     auto start_thread = [](void* data) {
@@ -212,10 +227,7 @@ class WorkerThreadsTaskRunner::DelayedTaskScheduler {
   static void RunTask(uv_timer_t* timer) {
     DelayedTaskScheduler* scheduler =
         ContainerOf(&DelayedTaskScheduler::loop_, timer->loop);
-    auto entry = scheduler->TakeTimerTask(timer);
-    bool is_outstanding = entry->is_outstanding();
-    scheduler->pending_worker_tasks_->Lock().Push(std::move(entry),
-                                                  is_outstanding);
+    scheduler->runner_->Enqueue(scheduler->TakeTimerTask(timer));
   }
 
   std::unique_ptr<TaskQueueEntry> TakeTimerTask(uv_timer_t* timer) {
@@ -230,9 +242,9 @@ class WorkerThreadsTaskRunner::DelayedTaskScheduler {
   }
 
   uv_sem_t ready_;
-  // Task queue in the worker thread task runner, we push the delayed task back
-  // to it when the timer expires.
-  TaskQueue<TaskQueueEntry>* pending_worker_tasks_;
+  // The worker thread task runner, we push the delayed task back to it when
+  // the timer expires.
+  WorkerThreadsTaskRunner* runner_;
 
   // Locally scheduled tasks to be poped into the worker task runner queue.
   // It is flushed whenever the next closest timer expires.
@@ -243,26 +255,48 @@ class WorkerThreadsTaskRunner::DelayedTaskScheduler {
 };
 
 WorkerThreadsTaskRunner::WorkerThreadsTaskRunner(
-    int thread_pool_size, PlatformDebugLogLevel debug_log_level)
-    : debug_log_level_(debug_log_level) {
+    int thread_pool_size,
+    PlatformDebugLogLevel debug_log_level,
+    int user_blocking_thread_pool_size,
+    bool numa_affinity)
+    : general_worker_count_(thread_pool_size),
+      debug_log_level_(debug_log_level) {
   Mutex platform_workers_mutex;
   ConditionVariable platform_workers_ready;
 
+  // Reserved workers get the ids following the general purpose ones.
+  int total_workers =
+      thread_pool_size + std::max(user_blocking_thread_pool_size, 0);
   Mutex::ScopedLock lock(platform_workers_mutex);
-  int pending_platform_workers = thread_pool_size;
+  int pending_platform_workers = total_workers;
 
-  delayed_task_scheduler_ = std::make_unique<DelayedTaskScheduler>(
-      &pending_worker_tasks_);
+  // The queues have to exist before any thread can post to them.
+  for (int i = 0; i < total_workers; i++) {
+    worker_queues_.push_back(std::make_unique<WorkerQueues>());
+  }
+
+  delayed_task_scheduler_ = std::make_unique<DelayedTaskScheduler>(this);
   threads_.push_back(delayed_task_scheduler_->Start());
 
-  for (int i = 0; i < thread_pool_size; i++) {
-    PlatformWorkerData* worker_data =
-        new PlatformWorkerData{&pending_worker_tasks_,
-                               &platform_workers_mutex,
-                               &platform_workers_ready,
-                               &pending_platform_workers,
-                               i,
-                               debug_log_level_};
+  std::vector<int> numa_nodes;
+  if (numa_affinity) {
+    const std::vector<std::vector<int>>& node_cpus = numa::GetNodeCpus();
+    for (size_t node = 0; node < node_cpus.size(); node++) {
+      if (!node_cpus[node].empty()) numa_nodes.push_back(node);
+    }
+    // There is nothing to gain from binding on single node hosts.
+    if (numa_nodes.size() < 2) numa_nodes.clear();
+  }
+
+  for (int i = 0; i < total_workers; i++) {
+    PlatformWorkerData* worker_data = new PlatformWorkerData{
+        this,
+        &platform_workers_mutex,
+        &platform_workers_ready,
+        &pending_platform_workers,
+        i,
+        debug_log_level_,
+        numa_nodes.empty() ? -1 : numa_nodes[i % numa_nodes.size()]};
     std::unique_ptr<uv_thread_t> t { new uv_thread_t() };
     if (uv_thread_create(t.get(), PlatformWorkerThread,
                          worker_data) != 0) {
@@ -278,12 +312,122 @@ WorkerThreadsTaskRunner::WorkerThreadsTaskRunner(
   }
 }
 
+WorkerThreadsTaskRunner::~WorkerThreadsTaskRunner() = default;
+
 void WorkerThreadsTaskRunner::PostTask(v8::TaskPriority priority,
                                        std::unique_ptr<v8::Task> task,
                                        const v8::SourceLocation& location) {
-  auto entry = std::make_unique<TaskQueueEntry>(std::move(task), priority);
-  bool is_outstanding = entry->is_outstanding();
-  pending_worker_tasks_.Lock().Push(std::move(entry), is_outstanding);
+  Enqueue(std::make_unique<TaskQueueEntry>(std::move(task), priority));
+}
+
+void WorkerThreadsTaskRunner::Enqueue(std::unique_ptr<TaskQueueEntry> entry) {
+  if (entry->is_outstanding()) {
+    outstanding_tasks_++;
+  }
+  size_t priority = static_cast<size_t>(entry->priority);
+  if (current_runner == this) {
+    worker_queues_[current_worker_id]->deques[priority].Push(std::move(entry));
+  } else {
+    pending_worker_tasks_.Lock().Push(std::move(entry));
+    injected_tasks_[priority]++;
+  }
+  // Pairs with the check of pending_tasks_ in BlockingPop(): either the
+  // sleeping worker sees the new task, or we see the sleeping worker.
+  pending_tasks_[priority]++;
+  if (priority == static_cast<size_t>(v8::TaskPriority::kUserBlocking) &&
+      idle_reserved_workers_ > 0) {
+    Mutex::ScopedLock lock(idle_mutex_);
+    user_blocking_tasks_available_.Signal(lock);
+  } else if (idle_workers_ > 0) {
+    Mutex::ScopedLock lock(idle_mutex_);
+    tasks_available_.Signal(lock);
+  }
+}
+
+size_t WorkerThreadsTaskRunner::LowestPriorityFor(int worker_id) const {
+  return IsReservedWorker(worker_id)
+             ? static_cast<size_t>(v8::TaskPriority::kUserBlocking)
+             : 0;
+}
+
+bool WorkerThreadsTaskRunner::HasPendingTasksFor(int worker_id) const {
+  for (size_t priority = LowestPriorityFor(worker_id);
+       priority < kNumPriorities;
+       priority++) {
+    if (pending_tasks_[priority] > 0) return true;
+  }
+  return false;
+}
+
+std::unique_ptr<TaskQueueEntry> WorkerThreadsTaskRunner::FindTask(
+    int worker_id) {
+  size_t num_workers = worker_queues_.size();
+  size_t lowest_priority = LowestPriorityFor(worker_id);
+  for (size_t priority = kNumPriorities; priority-- > lowest_priority;) {
+    if (worker_id >= 0) {
+      auto entry = worker_queues_[worker_id]->deques[priority].Pop();
+      if (entry) return entry;
+    }
+    if (injected_tasks_[priority] > 0) {
+      // The injection queue is ordered by priority, so this usually returns
+      // a task of at least this priority. It can return a task of lower
+      // priority if another worker took the one that was counted, in which
+      // case reserved workers have to put it back.
+      auto locked = pending_worker_tasks_.Lock();
+      auto entry = locked.Pop();
+      if (entry && static_cast<size_t>(entry->priority) < lowest_priority) {
+        locked.Push(std::move(entry));
+      }
+      if (entry) {
+        injected_tasks_[static_cast<size_t>(entry->priority)]--;
+        return entry;
+      }
+    }
+    for (size_t i = 1; i <= num_workers; i++) {
+      size_t victim = (worker_id + i) % num_workers;
+      if (static_cast<int>(victim) == worker_id) continue;
+      auto entry = worker_queues_[victim]->deques[priority].Steal();
+      if (entry) return entry;
+    }
+  }
+  return nullptr;
+}
+
+std::unique_ptr<TaskQueueEntry> WorkerThreadsTaskRunner::BlockingPop(
+    int worker_id) {
+  while (!stopped_) {
+    if (HasPendingTasksFor(worker_id)) {
+      std::unique_ptr<TaskQueueEntry> entry = FindTask(worker_id);
+      if (entry) {
+        pending_tasks_[static_cast<size_t>(entry->priority)]--;
+        return entry;
+      }
+      // The task that was counted has either just been taken by another
+      // worker, or lost a race in Steal(). Try again.
+      continue;
+    }
+
+    Mutex::ScopedLock lock(idle_mutex_);
+    bool reserved = IsReservedWorker(worker_id);
+    std::atomic<int>& idle_workers =
+        reserved ? idle_reserved_workers_ : idle_workers_;
+    ConditionVariable& tasks_available =
+        reserved ? user_blocking_tasks_available_ : tasks_available_;
+    idle_workers++;
+    while (!HasPendingTasksFor(worker_id) && !stopped_) {
+      tasks_available.Wait(lock);
+    }
+    idle_workers--;
+  }
+  return nullptr;
+}
+
+void WorkerThreadsTaskRunner::NotifyOfCompletion(const TaskQueueEntry& entry) {
+  if (!entry.is_outstanding()) return;
+  if (--outstanding_tasks_ == 0) {
+    Mutex::ScopedLock lock(outstanding_tasks_mutex_);
+    outstanding_tasks_drained_.Broadcast(lock);
+  }
 }
 
 void WorkerThreadsTaskRunner::PostDelayedTask(
@@ -296,11 +440,19 @@ void WorkerThreadsTaskRunner::PostDelayedTask(
 }
 
 void WorkerThreadsTaskRunner::BlockingDrain() {
-  pending_worker_tasks_.Lock().BlockingDrain();
+  Mutex::ScopedLock lock(outstanding_tasks_mutex_);
+  while (outstanding_tasks_ > 0) {
+    outstanding_tasks_drained_.Wait(lock);
+  }
 }
 
 void WorkerThreadsTaskRunner::Shutdown() {
-  pending_worker_tasks_.Lock().Stop();
+  {
+    Mutex::ScopedLock lock(idle_mutex_);
+    stopped_ = true;
+    tasks_available_.Broadcast(lock);
+    user_blocking_tasks_available_.Broadcast(lock);
+  }
   delayed_task_scheduler_->Stop();
   for (size_t i = 0; i < threads_.size(); i++) {
     CHECK_EQ(0, uv_thread_join(threads_[i].get()));
@@ -339,8 +491,8 @@ void PerIsolatePlatformData::PostTaskImpl(std::unique_ptr<Task> task,
                                           const v8::SourceLocation& location) {
   // The task can be posted from any V8 background worker thread, even when
   // the foreground task runner is being cleaned up by Shutdown(). In that
-  // case, make sure we wait until the shutdown is completed (which leads
-  // to flush_tasks_ == nullptr, and the task will be discarded).
+  // case the task is discarded. A task that races with Shutdown() may still
+  // end up in the queue, it is then destroyed together with this object.
   if (debug_log_level_ != PlatformDebugLogLevel::kNone) {
     fprintf(stderr, "\nPerIsolatePlatformData::PostTaskImpl %p", task.get());
     PrintSourceLocation(location);
@@ -350,12 +502,20 @@ void PerIsolatePlatformData::PostTaskImpl(std::unique_ptr<Task> task,
     fflush(stderr);
   }
 
-  auto locked = foreground_tasks_.Lock();
-  if (flush_tasks_ == nullptr) return;
-  // All foreground tasks are treated as user blocking tasks.
-  locked.Push(std::make_unique<TaskQueueEntry>(
-      std::move(task), v8::TaskPriority::kUserBlocking));
-  uv_async_send(flush_tasks_);
+  if (is_shut_down_) return;
+  foreground_tasks_.Push(std::move(task));
+  ScheduleFlush();
+}
+
+void PerIsolatePlatformData::ScheduleFlush() {
+  // Pairs with the reset in FlushForegroundTasksInternal(): tasks pushed
+  // before the flush resets the flag are picked up by that flush, tasks
+  // pushed after it schedule a new one.
+  if (flush_scheduled_.exchange(true)) return;
+  Mutex::ScopedLock lock(flush_tasks_mutex_);
+  if (flush_tasks_ != nullptr) {
+    uv_async_send(flush_tasks_);
+  }
 }
 
 void PerIsolatePlatformData::PostDelayedTaskImpl(
@@ -383,7 +543,7 @@ void PerIsolatePlatformData::PostDelayedTaskImpl(
   // All foreground tasks are treated as user blocking tasks.
   delayed->priority = v8::TaskPriority::kUserBlocking;
   locked.Push(std::move(delayed));
-  uv_async_send(flush_tasks_);
+  ScheduleFlush();
 }
 
 void PerIsolatePlatformData::PostNonNestableTaskImpl(
@@ -408,11 +568,12 @@ void PerIsolatePlatformData::AddShutdownCallback(void (*callback)(void*),
 }
 
 void PerIsolatePlatformData::Shutdown() {
-  auto foreground_tasks_locked = foreground_tasks_.Lock();
+  is_shut_down_ = true;
   auto foreground_delayed_tasks_locked = foreground_delayed_tasks_.Lock();
+  Mutex::ScopedLock flush_tasks_lock(flush_tasks_mutex_);
 
   foreground_delayed_tasks_locked.PopAll();
-  foreground_tasks_locked.PopAll();
+  foreground_tasks_.PopAll();
   scheduled_delayed_tasks_.clear();
 
   if (flush_tasks_ != nullptr) {
@@ -444,7 +605,9 @@ void PerIsolatePlatformData::DecreaseHandleCount() {
 
 NodePlatform::NodePlatform(int thread_pool_size,
                            v8::TracingController* tracing_controller,
-                           v8::PageAllocator* page_allocator) {
+                           v8::PageAllocator* page_allocator,
+                           int user_blocking_thread_pool_size,
+                           bool numa_affinity) {
   if (per_process::enabled_debug_list.enabled(
           DebugCategory::PLATFORM_VERBOSE)) {
     debug_log_level_ = PlatformDebugLogLevel::kVerbose;
@@ -472,7 +635,10 @@ NodePlatform::NodePlatform(int thread_pool_size,
 
   thread_pool_size = GetActualThreadPoolSize(thread_pool_size);
   worker_thread_task_runner_ = std::make_shared<WorkerThreadsTaskRunner>(
-      thread_pool_size, debug_log_level_);
+      thread_pool_size,
+      debug_log_level_,
+      user_blocking_thread_pool_size,
+      numa_affinity);
 }
 
 NodePlatform::~NodePlatform() {
@@ -605,6 +771,7 @@ void NodePlatform::DrainTasks(Isolate* isolate) {
 
 bool PerIsolatePlatformData::FlushForegroundTasksInternal() {
   bool did_work = false;
+  flush_scheduled_ = false;
 
   auto delayed_tasks_to_schedule = foreground_delayed_tasks_.Lock().PopAll();
   while (!delayed_tasks_to_schedule.empty()) {
@@ -637,20 +804,10 @@ bool PerIsolatePlatformData::FlushForegroundTasksInternal() {
         });
   }
 
-  TaskQueue<TaskQueueEntry>::PriorityQueue tasks;
-  {
-    auto locked = foreground_tasks_.Lock();
-    tasks = locked.PopAll();
-  }
-
-  while (!tasks.empty()) {
-    // We have to use const_cast because std::priority_queue::top() does not
-    // return a movable item.
-    std::unique_ptr<TaskQueueEntry> entry =
-        std::move(const_cast<std::unique_ptr<TaskQueueEntry>&>(tasks.top()));
-    tasks.pop();
+  std::vector<std::unique_ptr<Task>> tasks = foreground_tasks_.PopAll();
+  for (std::unique_ptr<Task>& task : tasks) {
     did_work = true;
-    RunForegroundTask(std::move(entry->task));
+    RunForegroundTask(std::move(task));
   }
 
   return did_work;
@@ -844,6 +1001,147 @@ TaskQueue<T>::PriorityQueue TaskQueue<T>::Locked::PopAll() {
   return result;
 }
 
+template <class T>
+WorkStealingDeque<T>::Buffer::Buffer(int64_t capacity)
+    : capacity_(capacity), items_(new std::atomic<T*>[capacity]) {
+  // The capacity has to be a power of two for the index masking to work.
+  DCHECK_EQ(capacity & (capacity - 1), 0);
+}
+
+template <class T>
+T* WorkStealingDeque<T>::Buffer::Get(int64_t index) const {
+  return items_[index & (capacity_ - 1)].load(std::memory_order_relaxed);
+}
+
+template <class T>
+void WorkStealingDeque<T>::Buffer::Put(int64_t index, T* item) {
+  items_[index & (capacity_ - 1)].store(item, std::memory_order_relaxed);
+}
+
+template <class T>
+std::unique_ptr<typename WorkStealingDeque<T>::Buffer>
+WorkStealingDeque<T>::Buffer::Grow(int64_t top, int64_t bottom) const {
+  auto grown = std::make_unique<Buffer>(capacity_ * 2);
+  for (int64_t i = top; i < bottom; i++) {
+    grown->Put(i, Get(i));
+  }
+  return grown;
+}
+
+template <class T>
+WorkStealingDeque<T>::WorkStealingDeque() : top_(0), bottom_(0) {
+  buffers_.push_back(std::make_unique<Buffer>(kInitialCapacity));
+  buffer_.store(buffers_.back().get(), std::memory_order_relaxed);
+}
+
+template <class T>
+WorkStealingDeque<T>::~WorkStealingDeque() {
+  while (Pop()) {
+  }
+}
+
+// The memory orderings follow "Correct and Efficient Work-Stealing for Weak
+// Memory Models" by Lê, Pop, Cohen and Zappa Nardelli (PPoPP 2013).
+template <class T>
+void WorkStealingDeque<T>::Push(std::unique_ptr<T> item) {
+  int64_t bottom = bottom_.load(std::memory_order_relaxed);
+  int64_t top = top_.load(std::memory_order_acquire);
+  Buffer* buffer = buffer_.load(std::memory_order_relaxed);
+  if (bottom - top > buffer->capacity() - 1) {
+    buffers_.push_back(buffer->Grow(top, bottom));
+    buffer = buffers_.back().get();
+    buffer_.store(buffer, std::memory_order_release);
+  }
+  buffer->Put(bottom, item.release());
+  std::atomic_thread_fence(std::memory_order_release);
+  bottom_.store(bottom + 1, std::memory_order_relaxed);
+}
+
+template <class T>
+std::unique_ptr<T> WorkStealingDeque<T>::Pop() {
+  int64_t bottom = bottom_.load(std::memory_order_relaxed) - 1;
+  Buffer* buffer = buffer_.load(std::memory_order_relaxed);
+  bottom_.store(bottom, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  int64_t top = top_.load(std::memory_order_relaxed);
+
+  if (top > bottom) {
+    // The deque was empty.
+    bottom_.store(bottom + 1, std::memory_order_relaxed);
+    return nullptr;
+  }
+
+  T* item = buffer->Get(bottom);
+  if (top == bottom) {
+    // This is the last item, race against concurrent Steal() calls for it.
+    if (!top_.compare_exchange_strong(top,
+                                      top + 1,
+                                      std::memory_order_seq_cst,
+                                      std::memory_order_relaxed)) {
+      item = nullptr;
+    }
+    bottom_.store(bottom + 1, std::memory_order_relaxed);
+  }
+  return std::unique_ptr<T>(item);
+}
+
+template <class T>
+std::unique_ptr<T> WorkStealingDeque<T>::Steal() {
+  int64_t top = top_.load(std::memory_order_acquire);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  int64_t bottom = bottom_.load(std::memory_order_acquire);
+  if (top >= bottom) return nullptr;
+
+  Buffer* buffer = buffer_.load(std::memory_order_acquire);
+  T* item = buffer->Get(top);
+  if (!top_.compare_exchange_strong(top,
+                                    top + 1,
+                                    std::memory_order_seq_cst,
+                                    std::memory_order_relaxed)) {
+    return nullptr;
+  }
+  return std::unique_ptr<T>(item);
+}
+
+template <class T>
+bool WorkStealingDeque<T>::IsEmpty() const {
+  int64_t top = top_.load(std::memory_order_acquire);
+  int64_t bottom = bottom_.load(std::memory_order_acquire);
+  return top >= bottom;
+}
+
+template class WorkStealingDeque<TaskQueueEntry>;
+
+template <class T>
+MPSCQueue<T>::~MPSCQueue() {
+  PopAll();
+}
+
+template <class T>
+void MPSCQueue<T>::Push(std::unique_ptr<T> item) {
+  Node* node = new Node{std::move(item), head_.load(std::memory_order_relaxed)};
+  while (!head_.compare_exchange_weak(node->next,
+                                      node,
+                                      std::memory_order_release,
+                                      std::memory_order_relaxed)) {
+  }
+}
+
+template <class T>
+std::vector<std::unique_ptr<T>> MPSCQueue<T>::PopAll() {
+  std::vector<std::unique_ptr<T>> result;
+  Node* node = head_.exchange(nullptr, std::memory_order_acquire);
+  while (node != nullptr) {
+    std::unique_ptr<Node> current(node);
+    result.push_back(std::move(current->item));
+    node = current->next;
+  }
+  std::reverse(result.begin(), result.end());
+  return result;
+}
+
+template class MPSCQueue<Task>;
+
 void MultiIsolatePlatform::DisposeIsolate(Isolate* isolate) {
   // The order of these calls is important. When the Isolate is disposed,
   // it may still post tasks to the platform, so it must still be registered
@@ -3,7 +3,9 @@
 
 #if defined(NODE_WANT_INTERNALS) && NODE_WANT_INTERNALS
 
+#include <atomic>
 #include <functional>
+#include <memory>
 #include <queue>
 #include <type_traits>
 #include <unordered_map>
@@ -78,6 +80,77 @@ class TaskQueue {
   PriorityQueue task_queue_;
 };
 
+// A Chase-Lev work-stealing deque. Push() and Pop() may only be called by the
+// thread that owns the deque and operate on its bottom end in LIFO order.
+// Steal() may be called from any thread and takes from the top end in FIFO
+// order. Steal() can spuriously return nullptr when it races with another
+// thread for the last item; callers are expected to retry if needed.
+template <class T>
+class WorkStealingDeque {
+ public:
+  WorkStealingDeque();
+  ~WorkStealingDeque();
+
+  WorkStealingDeque(const WorkStealingDeque&) = delete;
+  WorkStealingDeque& operator=(const WorkStealingDeque&) = delete;
+
+  void Push(std::unique_ptr<T> item);
+  std::unique_ptr<T> Pop();
+  std::unique_ptr<T> Steal();
+  bool IsEmpty() const;
+
+ private:
+  class Buffer {
+   public:
+    explicit Buffer(int64_t capacity);
+
+    int64_t capacity() const { return capacity_; }
+    T* Get(int64_t index) const;
+    void Put(int64_t index, T* item);
+    std::unique_ptr<Buffer> Grow(int64_t top, int64_t bottom) const;
+
+   private:
+    int64_t capacity_;
+    std::unique_ptr<std::atomic<T*>[]> items_;
+  };
+
+  static constexpr int64_t kInitialCapacity = 64;
+
+  std::atomic<int64_t> top_;
+  std::atomic<int64_t> bottom_;
+  std::atomic<Buffer*> buffer_;
+  // Every buffer ever used by this deque, including the current one. Replaced
+  // buffers are kept alive until the deque is destroyed because a concurrent
+  // Steal() may still be reading from them.
+  std::vector<std::unique_ptr<Buffer>> buffers_;
+};
+
+// A lock-free multi-producer single-consumer queue. Push() may be called from
+// any thread; PopAll() may only be called from the single consumer thread and
+// returns every item pushed so far in the order they were pushed.
+template <class T>
+class MPSCQueue {
+ public:
+  MPSCQueue() = default;
+  ~MPSCQueue();
+
+  MPSCQueue(const MPSCQueue&) = delete;
+  MPSCQueue& operator=(const MPSCQueue&) = delete;
+
+  void Push(std::unique_ptr<T> item);
+  std::vector<std::unique_ptr<T>> PopAll();
+
+ private:
+  struct Node {
+    std::unique_ptr<T> item;
+    Node* next;
+  };
+
+  // Producers push onto this stack, the consumer takes the whole stack at
+  // once and reverses it.
+  std::atomic<Node*> head_{nullptr};
+};
+
 struct TaskQueueEntry {
   std::unique_ptr<v8::Task> task;
   v8::TaskPriority priority;
@@ -151,10 +224,18 @@ class PerIsolatePlatformData
   void DecreaseHandleCount();
 
   static void FlushTasks(uv_async_t* handle);
+  void ScheduleFlush();
   void RunForegroundTask(std::unique_ptr<v8::Task> task);
   static void RunForegroundTask(uv_timer_t* timer);
 
+  // Protected by flush_tasks_mutex_, and additionally by the
+  // foreground_delayed_tasks_ lock when it is reset during Shutdown().
   uv_async_t* flush_tasks_ = nullptr;
+  Mutex flush_tasks_mutex_;
+  // Set when flush_tasks_ has been signalled and the flush has not yet
+  // started, so that a burst of posts only wakes up the event loop once.
+  std::atomic<bool> flush_scheduled_{false};
+  std::atomic<bool> is_shut_down_{false};
 
   struct ShutdownCallback {
     void (*cb)(void*);
@@ -169,9 +250,12 @@ class PerIsolatePlatformData
   v8::Isolate* const isolate_;
   uv_loop_t* const loop_;
 
-  // When acquiring locks for both task queues, lock foreground_tasks_
-  // first then foreground_delayed_tasks_ to avoid deadlocks.
-  TaskQueue<TaskQueueEntry> foreground_tasks_;
+  // All foreground tasks are treated as user blocking tasks and run in the
+  // order they were posted, so they do not need a priority queue. Tasks are
+  // consumed on the thread that runs loop_.
+  MPSCQueue<v8::Task> foreground_tasks_;
+  // When acquiring both locks, lock foreground_delayed_tasks_ first then
+  // flush_tasks_mutex_ to avoid deadlocks.
   TaskQueue<DelayedTask> foreground_delayed_tasks_;
 
   // Use a custom deleter because libuv needs to close the handle first.
@@ -182,10 +266,22 @@ class PerIsolatePlatformData
 };
 
 // This acts as the single worker thread task runner for all Isolates.
+// In addition to the thread_pool_size general purpose workers, up to
+// user_blocking_thread_pool_size workers can be reserved for running
+// kUserBlocking tasks only, so that a flood of lower priority tasks (e.g.
+// background compilation) cannot delay tasks that the main thread is
+// waiting for (e.g. garbage collection).
+//
+// With numa_affinity, worker i is bound to the CPUs and memory of NUMA node
+// i % number of nodes on hosts with more than one node, so that the pages a
+// worker allocates stay local to the CPUs it runs on.
 class WorkerThreadsTaskRunner {
  public:
-  explicit WorkerThreadsTaskRunner(int thread_pool_size,
-                                   PlatformDebugLogLevel debug_log_level);
+  WorkerThreadsTaskRunner(int thread_pool_size,
+                          PlatformDebugLogLevel debug_log_level,
+                          int user_blocking_thread_pool_size = 0,
+                          bool numa_affinity = false);
+  ~WorkerThreadsTaskRunner();
 
   void PostTask(v8::TaskPriority priority,
                 std::unique_ptr<v8::Task> task,
@@ -200,16 +296,68 @@ class WorkerThreadsTaskRunner {
 
   int NumberOfWorkerThreads() const;
 
+  // Called by the platform worker threads. BlockingPop() returns the next
+  // task the worker with the given id should run, blocking until one is
+  // available, or nullptr once the runner has been shut down. Tasks are
+  // looked up in priority order: for each priority, the worker's own deque
+  // is tried first, then the shared injection queue, then the deques of the
+  // other workers.
+  std::unique_ptr<TaskQueueEntry> BlockingPop(int worker_id);
+  void NotifyOfCompletion(const TaskQueueEntry& entry);
+
  private:
-  // A queue shared by all threads. The consumers are the worker threads which
-  // take tasks from it to run in PlatformWorkerThread(). The producers can be
-  // any thread. Both the foreground thread and the worker threads can push
-  // tasks into the queue via v8::Platform::PostTaskOnWorkerThread() which
-  // eventually calls PostTask() on this class. When any thread calls
-  // v8::Platform::PostDelayedTaskOnWorkerThread(), the DelayedTaskScheduler
-  // thread will schedule a timer that pushes the delayed tasks back into this
-  // queue when the timer expires.
+  static constexpr size_t kNumPriorities =
+      static_cast<size_t>(v8::TaskPriority::kMaxPriority) + 1;
+
+  // The per-priority deques owned by a single worker thread.
+  struct WorkerQueues {
+    WorkStealingDeque<TaskQueueEntry> deques[kNumPriorities];
+  };
+
+  void Enqueue(std::unique_ptr<TaskQueueEntry> entry);
+  std::unique_ptr<TaskQueueEntry> FindTask(int worker_id);
+  bool IsReservedWorker(int worker_id) const {
+    return worker_id >= general_worker_count_;
+  }
+  // The lowest priority of the tasks that the given worker may run.
+  size_t LowestPriorityFor(int worker_id) const;
+  bool HasPendingTasksFor(int worker_id) const;
+
+  // The injection queue shared by all threads. Tasks posted from threads that
+  // are not platform workers of this runner (e.g. the foreground thread and
+  // the DelayedTaskScheduler thread, which pushes delayed tasks back here when
+  // their timers expire) go into this queue. Tasks posted from inside a
+  // worker task go into that worker's own deque instead, so that the common
+  // case of V8 background jobs spawning more work does not contend on this
+  // queue's mutex.
   TaskQueue<TaskQueueEntry> pending_worker_tasks_;
+  // Number of tasks in pending_worker_tasks_ for each priority. Lets workers
+  // skip taking its lock when there is nothing of interest in it.
+  std::atomic<int> injected_tasks_[kNumPriorities] = {};
+
+  std::vector<std::unique_ptr<WorkerQueues>> worker_queues_;
+
+  // Workers with an id below this run tasks of any priority, the rest only
+  // run kUserBlocking tasks.
+  int general_worker_count_ = 0;
+
+  // Number of tasks sitting in any of the queues above for each priority.
+  // Idle workers sleep on a condition variable until there are pending
+  // tasks that they are allowed to run. General purpose workers use
+  // tasks_available_, reserved workers use user_blocking_tasks_available_.
+  std::atomic<int> pending_tasks_[kNumPriorities] = {};
+  std::atomic<int> idle_workers_{0};
+  std::atomic<int> idle_reserved_workers_{0};
+  std::atomic<bool> stopped_{false};
+  Mutex idle_mutex_;
+  ConditionVariable tasks_available_;
+  ConditionVariable user_blocking_tasks_available_;
+
+  // Number of posted but not yet completed user-blocking tasks, see
+  // BlockingDrain().
+  std::atomic<int> outstanding_tasks_{0};
+  Mutex outstanding_tasks_mutex_;
+  ConditionVariable outstanding_tasks_drained_;
 
   class DelayedTaskScheduler;
   std::unique_ptr<DelayedTaskScheduler> delayed_task_scheduler_;
@@ -220,9 +368,14 @@ class WorkerThreadsTaskRunner {
 
 class NodePlatform : public MultiIsolatePlatform {
  public:
+  // user_blocking_thread_pool_size is the number of additional worker threads
+  // that are reserved for kUserBlocking tasks, see WorkerThreadsTaskRunner,
+  // which also describes numa_affinity.
   NodePlatform(int thread_pool_size,
                v8::TracingController* tracing_controller,
-               v8::PageAllocator* page_allocator = nullptr);
+               v8::PageAllocator* page_allocator = nullptr,
+               int user_blocking_thread_pool_size = 0,
+               bool numa_affinity = false);
   ~NodePlatform() override;
 
   void DrainTasks(v8::Isolate* isolate) override;
@@ -0,0 +1,204 @@
+#include "node_prestart.h"
+#include "debug_utils-inl.h"
+#include "util-inl.h"
+
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+
+#ifndef _WIN32
+extern char** environ;
+#endif
+
+namespace node::prestart {
+
+ParseResult ParseJob(std::string_view message, Job* job, std::string* error) {
+  *job = Job();
+  while (true) {
+    const size_t end = message.find('\0');
+    if (end == std::string_view::npos) return ParseResult::kIncomplete;
+    const std::string_view field = message.substr(0, end);
+    message.remove_prefix(end + 1);
+    if (field.empty()) break;
+
+    const size_t equals = field.find('=');
+    const std::string_view name = field.substr(0, equals);
+    const std::string_view value = equals == std::string_view::npos
+                                       ? std::string_view()
+                                       : field.substr(equals + 1);
+    if (name == "cwd" && equals != std::string_view::npos) {
+      job->cwd = value;
+    } else if (name == "arg" && equals != std::string_view::npos) {
+      job->args.emplace_back(value);
+    } else if (name == "env" && value.find('=', 1) != std::string_view::npos) {
+      job->env.emplace_back(value);
+    } else {
+      *error = "invalid field \"" + std::string(field) + "\"";
+      return ParseResult::kInvalid;
+    }
+  }
+  if (!message.empty()) {
+    *error = "data after the end of the job";
+    return ParseResult::kInvalid;
+  }
+  return ParseResult::kComplete;
+}
+
+void RemovePrestartOption(std::vector<std::string>* exec_args) {
+  for (auto it = exec_args->begin(); it != exec_args->end();) {
+    if (*it == "--prestart-fd") {
+      it = exec_args->erase(it, std::min(it + 2, exec_args->end()));
+    } else if (it->starts_with("--prestart-fd=")) {
+      it = exec_args->erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
+#ifndef _WIN32
+#ifdef MSG_CMSG_CLOEXEC
+constexpr int kRecvFlags = MSG_CMSG_CLOEXEC;
+#else
+constexpr int kRecvFlags = 0;
+#endif
+
+bool ReadJob(int fd, Job* job, std::vector<int>* fds, std::string* error) {
+  std::string message;
+  bool is_socket = true;
+  fds->clear();
+  error->clear();
+  while (true) {
+    char data[4096];
+    ssize_t nread;
+    if (is_socket) {
+      iovec iov = {data, sizeof(data)};
+      alignas(cmsghdr) char control[CMSG_SPACE(3 * sizeof(int))];
+      msghdr msg = {};
+      msg.msg_iov = &iov;
+      msg.msg_iovlen = 1;
+      msg.msg_control = control;
+      msg.msg_controllen = sizeof(control);
+      do {
+        nread = recvmsg(fd, &msg, kRecvFlags);
+      } while (nread == -1 && errno == EINTR);
+      if (nread == -1 && errno == ENOTSOCK) {
+        is_socket = false;
+        continue;
+      }
+      if (nread >= 0) {
+        for (cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr;
+             cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+          if (cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS)
+            continue;
+          const size_t count = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+          for (size_t i = 0; i < count; i++) {
+            int received;
+            memcpy(&received,
+                   CMSG_DATA(cmsg) + i * sizeof(int),
+                   sizeof(received));
+            fds->push_back(received);
+          }
+        }
+        if ((msg.msg_flags & MSG_CTRUNC) != 0 || fds->size() > 3) {
+          *error = "a job takes at most 3 file descriptors";
+          return false;
+        }
+      }
+    } else {
+      do {
+        nread = read(fd, data, sizeof(data));
+      } while (nread == -1 && errno == EINTR);
+    }
+
+    if (nread == -1) {
+      *error = std::string("cannot read the job: ") + strerror(errno);
+      return false;
+    }
+    if (nread == 0) {
+      if (!message.empty() || !fds->empty())
+        *error = "the job is incomplete";
+      return false;
+    }
+    message.append(data, nread);
+    switch (ParseJob(message, job, error)) {
+      case ParseResult::kComplete:
+        return true;
+      case ParseResult::kInvalid:
+        return false;
+      case ParseResult::kIncomplete:
+        break;
+    }
+  }
+}
+
+bool WaitForJob(int fd,
+                std::vector<std::string>* args,
+                std::vector<std::string>* exec_args,
+                ExitCode* exit_code) {
+  Job job;
+  std::vector<int> fds;
+  std::string error;
+  const bool ok = ReadJob(fd, &job, &fds, &error);
+  close(fd);
+  auto close_fds = OnScopeLeave([&]() {
+    for (int received : fds) {
+      if (received > STDERR_FILENO) close(received);
+    }
+  });
+  if (!ok) {
+    *exit_code = ExitCode::kNoFailure;
+    if (error.empty()) return false;
+    FPrintF(stderr, "%s: --prestart-fd: %s\n", args->at(0), error);
+    *exit_code = ExitCode::kGenericUserError;
+    return false;
+  }
+  for (size_t i = 0; i < fds.size(); i++) {
+    if (fds[i] == static_cast<int>(i)) continue;
+    if (dup2(fds[i], i) == -1) {
+      FPrintF(stderr,
+              "%s: --prestart-fd: cannot set up fd %d: %s\n",
+              args->at(0),
+              i,
+              strerror(errno));
+      *exit_code = ExitCode::kGenericUserError;
+      return false;
+    }
+  }
+  if (!job.cwd.empty() && chdir(job.cwd.c_str()) != 0) {
+    FPrintF(stderr,
+            "%s: --prestart-fd: cannot change to %s: %s\n",
+            args->at(0),
+            job.cwd,
+            strerror(errno));
+    *exit_code = ExitCode::kGenericUserError;
+    return false;
+  }
+  if (!job.env.empty()) {
+    // clearenv() is not on every platform.
+    std::vector<std::string> names;
+    for (char** entry = environ; *entry != nullptr; entry++)
+      names.emplace_back(*entry, strcspn(*entry, "="));
+    for (const std::string& name : names) unsetenv(name.c_str());
+    for (const std::string& entry : job.env) {
+      const size_t equals = entry.find('=');
+      setenv(entry.substr(0, equals).c_str(),
+             entry.c_str() + equals + 1,
+             1);
+    }
+  }
+
+  args->resize(1);
+  args->insert(args->end(), job.args.begin(), job.args.end());
+  RemovePrestartOption(exec_args);
+  return true;
+}
+#endif  // _WIN32
+
+}  // namespace node::prestart
@@ -0,0 +1,67 @@
+#ifndef SRC_NODE_PRESTART_H_
+#define SRC_NODE_PRESTART_H_
+
+#if defined(NODE_WANT_INTERNALS) && NODE_WANT_INTERNALS
+
+#include "node_exit_code.h"
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+// With --prestart-fd=<fd>, the process initializes V8, the platform and the
+// isolate from the snapshot, and then waits for a job on <fd> before it
+// creates the main Environment. A job runner that keeps a few such processes
+// ready pays only for the context and the user code on each task, instead of
+// the whole start-up of Node.js.
+//
+// Forking a process that has already bootstrapped is not an option, because
+// fork() keeps only the calling thread, and V8 and the platform cannot run
+// without theirs.
+//
+// A job is a sequence of fields of the form "<name>=<value>", each of them
+// followed by a NUL byte, and ends with an empty field:
+//
+//   cwd=<directory>   the working directory of the job
+//   arg=<argument>    process.argv[1], process.argv[2] and so on
+//   env=<NAME=value>  the environment of the job, which replaces the one the
+//                     process was started with if there is any env field
+//
+// If <fd> is a Unix domain socket, the file descriptors sent with the job as
+// SCM_RIGHTS become its stdin, stdout and stderr, in that order. Options for
+// Node.js itself are the ones the process was started with. Closing <fd>
+// without a job makes the process exit with 0.
+namespace node::prestart {
+
+struct Job {
+  std::string cwd;
+  std::vector<std::string> args;
+  std::vector<std::string> env;
+};
+
+enum class ParseResult { kComplete, kIncomplete, kInvalid };
+
+ParseResult ParseJob(std::string_view message, Job* job, std::string* error);
+
+// Reads a job from |fd|, along with any file descriptors that come with it.
+// Returns false, with |error| empty, if |fd| is closed before anything is
+// written to it.
+bool ReadJob(int fd, Job* job, std::vector<int>* fds, std::string* error);
+
+// Removes --prestart-fd from |exec_args|, so that process.execArgv can be
+// passed on to children.
+void RemovePrestartOption(std::vector<std::string>* exec_args);
+
+// Waits for a job on |fd| and sets up the process for it. |args| becomes
+// the executable followed by the arguments of the job. Returns false if the
+// process has to exit with |exit_code| instead.
+bool WaitForJob(int fd,
+                std::vector<std::string>* args,
+                std::vector<std::string>* exec_args,
+                ExitCode* exit_code);
+
+}  // namespace node::prestart
+
+#endif  // defined(NODE_WANT_INTERNALS) && NODE_WANT_INTERNALS
+
+#endif  // SRC_NODE_PRESTART_H_
@@ -9,6 +9,7 @@
 #include "node_external_reference.h"
 #include "node_internals.h"
 #include "node_process-inl.h"
+#include "node_thread_stats.h"
 #include "path.h"
 #include "util-inl.h"
 #include "uv.h"
@@ -156,6 +157,31 @@ static void ThreadCPUUsage(const FunctionCallbackInfo<Value>& args) {
   fields[1] = MICROS_PER_SEC * rusage.ru_stime.tv_sec + rusage.ru_stime.tv_usec;
 }
 
+// ThreadUsageByKind adds up the CPU time in microseconds and the context
+// switches of the threads of the process by kind: the main thread, Worker
+// threads, V8 platform threads, libuv threadpool threads and the others.
+// Each kind takes thread_stats::kThreadUsageFieldCount elements of the
+// array passed to the function, starting with the number of threads.
+static void ThreadUsageByKind(const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+  std::array<thread_stats::ThreadUsage, thread_stats::kThreadKindCount> usage;
+  int err = thread_stats::GetUsageByKind(&usage);
+  if (err) return env->ThrowUVException(err, "thread_stats");
+
+  Local<ArrayBuffer> ab = get_fields_array_buffer(
+      args,
+      0,
+      thread_stats::kThreadKindCount * thread_stats::kThreadUsageFieldCount);
+  double* fields = static_cast<double*>(ab->Data());
+  for (const thread_stats::ThreadUsage& kind : usage) {
+    *fields++ = kind.threads;
+    *fields++ = kind.user;
+    *fields++ = kind.system;
+    *fields++ = kind.voluntary_switches;
+    *fields++ = kind.involuntary_switches;
+  }
+}
+
 static void Cwd(const FunctionCallbackInfo<Value>& args) {
   Environment* env = Environment::GetCurrent(args);
   CHECK(env->has_run_bootstrapping_code());
@@ -240,6 +266,20 @@ static void MemoryUsage(const FunctionCallbackInfo<Value>& args) {
           : static_cast<double>(array_buffer_allocator->total_mem_usage());
 }
 
+// Fills the Float64Array argument with the committed and peak committed
+// memory of the malloc implementation, for process.memoryUsage(). Returns
+// false, leaving the array untouched, when node uses the system malloc.
+static void GetMallocUsage(const FunctionCallbackInfo<Value>& args) {
+  Local<ArrayBuffer> ab = get_fields_array_buffer(args, 0, 2);
+  double* fields = static_cast<double*>(ab->Data());
+
+  MallocStats stats;
+  if (!GetMallocStats(&stats)) return args.GetReturnValue().Set(false);
+  fields[0] = static_cast<double>(stats.committed);
+  fields[1] = static_cast<double>(stats.peak_committed);
+  args.GetReturnValue().Set(true);
+}
+
 static void GetConstrainedMemory(const FunctionCallbackInfo<Value>& args) {
   uint64_t value = uv_get_constrained_memory();
   args.GetReturnValue().Set(static_cast<double>(value));
@@ -765,11 +805,13 @@ static void CreatePerIsolateProperties(IsolateData* isolate_data,
 
   SetMethod(isolate, target, "umask", Umask);
   SetMethod(isolate, target, "memoryUsage", MemoryUsage);
+  SetMethod(isolate, target, "mallocStats", GetMallocUsage);
   SetMethod(isolate, target, "constrainedMemory", GetConstrainedMemory);
   SetMethod(isolate, target, "availableMemory", GetAvailableMemory);
   SetMethod(isolate, target, "rss", Rss);
   SetMethod(isolate, target, "cpuUsage", CPUUsage);
   SetMethod(isolate, target, "threadCpuUsage", ThreadCPUUsage);
+  SetMethod(isolate, target, "threadUsageByKind", ThreadUsageByKind);
   SetMethod(isolate, target, "resourceUsage", ResourceUsage);
 
   SetMethod(isolate, target, "_debugEnd", DebugEnd);
@@ -814,11 +856,13 @@ void RegisterExternalReferences(ExternalReferenceRegistry* registry) {
   registry->Register(Umask);
   registry->Register(RawDebug);
   registry->Register(MemoryUsage);
+  registry->Register(GetMallocUsage);
   registry->Register(GetConstrainedMemory);
   registry->Register(GetAvailableMemory);
   registry->Register(Rss);
   registry->Register(CPUUsage);
   registry->Register(ThreadCPUUsage);
+  registry->Register(ThreadUsageByKind);
   registry->Register(ResourceUsage);
 
   registry->Register(GetActiveRequests);
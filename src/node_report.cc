@@ -1,13 +1,16 @@
 #include "node_report.h"
+#include "async_wrap-inl.h"
 #include "debug_utils-inl.h"
 #include "diagnosticfilename-inl.h"
 #include "env-inl.h"
 #include "json_utils.h"
+#include "large_pages/node_large_page.h"
 #include "node_internals.h"
 #include "node_metadata.h"
 #include "node_mutex.h"
 #include "node_worker.h"
 #include "permission/permission.h"
+#include "req_wrap.h"
 #include "util.h"
 
 #ifdef _WIN32
@@ -24,6 +27,7 @@
 #include <fstream>
 
 constexpr int NODE_REPORT_VERSION = 5;
+constexpr int NODE_REPORT_VITALS_VERSION = 1;
 constexpr int NANOS_PER_SEC = 1000 * 1000 * 1000;
 constexpr double SEC_PER_MICROS = 1e-6;
 constexpr int MAX_FRAME_COUNT = node::kMaxFrameCountForLogging;
@@ -655,6 +659,19 @@ static void PrintResourceUsage(JSONWriter* writer) {
   uint64_t available_memory = uv_get_available_memory();
   writer->json_keyvalue("available_memory", available_memory);
 
+  HugePageCoverage huge_pages;
+  if (GetHugePageCoverage(&huge_pages)) {
+    writer->json_keyvalue("anonymous_memory", huge_pages.anonymous);
+    writer->json_keyvalue("anon_huge_pages", huge_pages.anon_huge_pages);
+  }
+
+  MallocStats malloc_stats;
+  if (GetMallocStats(&malloc_stats)) {
+    writer->json_keyvalue("malloc_committed", malloc_stats.committed);
+    writer->json_keyvalue("malloc_peak_committed",
+                          malloc_stats.peak_committed);
+  }
+
   if (uv_getrusage(&rusage) == 0) {
     double user_cpu =
         rusage.ru_utime.tv_sec + SEC_PER_MICROS * rusage.ru_utime.tv_usec;
@@ -983,6 +1000,122 @@ std::string TriggerNodeReport(Environment* env,
                            error);
 }
 
+namespace report {
+static const char* const kProviderNames[] = {
+#define V(PROVIDER) #PROVIDER,
+    NODE_ASYNC_PROVIDER_TYPES(V)
+#undef V
+};
+
+struct HandleCounts {
+  size_t total = 0;
+  size_t active = 0;
+  size_t refed = 0;
+  size_t by_type[UV_HANDLE_TYPE_MAX] = {};
+};
+
+static void CountHandle(uv_handle_t* handle, void* arg) {
+  HandleCounts* counts = static_cast<HandleCounts*>(arg);
+  counts->total++;
+  if (uv_is_active(handle)) counts->active++;
+  if (uv_has_ref(handle)) counts->refed++;
+  counts->by_type[handle->type]++;
+}
+}  // namespace report
+
+// Unlike the report, the vitals only read counters that Node.js, libuv and
+// V8 already keep: there is no stack walk, no system information and no
+// string is built for a handle or request, so this takes microseconds and
+// allocates only the output of the writer.
+void GetNodeReportVitals(Environment* env, std::ostream& out) {
+  CHECK_NOT_NULL(env);
+  Isolate* isolate = env->isolate();
+  uv_loop_t* loop = env->event_loop();
+  JSONWriter writer(out, true);
+
+  writer.json_start();
+  writer.json_keyvalue("vitalsVersion", NODE_REPORT_VITALS_VERSION);
+  writer.json_keyvalue(
+      "timestamp", static_cast<uint64_t>(GetCurrentTimeInMicroseconds()));
+  writer.json_keyvalue("threadId", env->thread_id());
+
+  HeapStatistics heap_stats;
+  isolate->GetHeapStatistics(&heap_stats);
+  writer.json_objectstart("javascriptHeap");
+  writer.json_keyvalue("totalMemory", heap_stats.total_heap_size());
+  writer.json_keyvalue("usedMemory", heap_stats.used_heap_size());
+  writer.json_keyvalue("memoryLimit", heap_stats.heap_size_limit());
+  writer.json_keyvalue("mallocedMemory", heap_stats.malloced_memory());
+  writer.json_keyvalue("externalMemory", heap_stats.external_memory());
+  writer.json_objectend();
+
+  size_t rss;
+  if (uv_resident_set_memory(&rss) == 0) {
+    writer.json_keyvalue("rss", rss);
+  }
+
+  report::HandleCounts handles;
+  uv_walk(loop, report::CountHandle, &handles);
+  writer.json_objectstart("handles");
+  writer.json_keyvalue("total", handles.total);
+  writer.json_keyvalue("active", handles.active);
+  writer.json_keyvalue("refed", handles.refed);
+  writer.json_objectstart("byType");
+  for (int type = 0; type < UV_HANDLE_TYPE_MAX; type++) {
+    if (handles.by_type[type] == 0) continue;
+    const char* name = uv_handle_type_name(static_cast<uv_handle_type>(type));
+    writer.json_keyvalue(name != nullptr ? name : "unknown",
+                         handles.by_type[type]);
+  }
+  writer.json_objectend();
+  writer.json_objectend();
+
+  // libuv counts the requests of the loop, the ReqWraps are the ones that
+  // were made from JS.
+  size_t requests_by_provider[AsyncWrap::PROVIDERS_LENGTH] = {};
+  size_t wrapped_requests = 0;
+  for (ReqWrapBase* req_wrap : *env->req_wrap_queue()) {
+    requests_by_provider[req_wrap->GetAsyncWrap()->provider_type()]++;
+    wrapped_requests++;
+  }
+  writer.json_objectstart("requests");
+  writer.json_keyvalue("active", loop->active_reqs.count);
+  writer.json_keyvalue("wrapped", wrapped_requests);
+  writer.json_objectstart("byProvider");
+  for (int provider = 0; provider < AsyncWrap::PROVIDERS_LENGTH; provider++) {
+    if (requests_by_provider[provider] == 0) continue;
+    writer.json_keyvalue(report::kProviderNames[provider],
+                         requests_by_provider[provider]);
+  }
+  writer.json_objectend();
+  writer.json_objectend();
+
+  ThreadPoolWorkLimiter* limiter = env->threadpool_work_limiter();
+  size_t queue_depth = 0;
+  writer.json_objectstart("threadpool");
+  for (size_t i = 0; i < kThreadPoolWorkClassCount; i++) {
+    ThreadPoolWorkClass work_class = static_cast<ThreadPoolWorkClass>(i);
+    queue_depth += limiter->queued(work_class);
+    writer.json_objectstart(ThreadPoolWorkClassName(work_class));
+    writer.json_keyvalue("running", limiter->running(work_class));
+    writer.json_keyvalue("queued", limiter->queued(work_class));
+    writer.json_objectend();
+  }
+  writer.json_keyvalue("queueDepth", queue_depth);
+  writer.json_objectend();
+
+  uv_metrics_t metrics;
+  if (uv_metrics_info(loop, &metrics) == 0) {
+    writer.json_objectstart("eventLoop");
+    writer.json_keyvalue("iterations", metrics.loop_count);
+    writer.json_keyvalue("events", metrics.events);
+    writer.json_keyvalue("eventsWaiting", metrics.events_waiting);
+    writer.json_keyvalue("idleTime", uv_metrics_idle_time(loop));
+    writer.json_objectend();
+  }
+  writer.json_end();
+}
+
 // External function to trigger a report, writing to a supplied stream.
 void GetNodeReport(Isolate* isolate,
                    const char* message,
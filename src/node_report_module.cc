@@ -75,6 +75,17 @@ void GetReport(const FunctionCallbackInfo<Value>& info) {
   }
 }
 
+// getVitals() returns the vitals as a JSON string.
+static void GetVitals(const FunctionCallbackInfo<Value>& info) {
+  Environment* env = Environment::GetCurrent(info);
+  std::ostringstream out;
+  GetNodeReportVitals(env, out);
+  Local<Value> ret;
+  if (ToV8Value(env->context(), out.str(), env->isolate()).ToLocal(&ret)) {
+    info.GetReturnValue().Set(ret);
+  }
+}
+
 static void GetCompact(const FunctionCallbackInfo<Value>& info) {
   Mutex::ScopedLock lock(per_process::cli_options_mutex);
   info.GetReturnValue().Set(per_process::cli_options->report_compact);
@@ -204,6 +215,7 @@ static void Initialize(Local<Object> exports,
                        void* priv) {
   SetMethod(context, exports, "writeReport", WriteReport);
   SetMethod(context, exports, "getReport", GetReport);
+  SetMethod(context, exports, "getVitals", GetVitals);
   SetMethod(context, exports, "getCompact", GetCompact);
   SetMethod(context, exports, "setCompact", SetCompact);
   SetMethod(context, exports, "getExcludeNetwork", GetExcludeNetwork);
@@ -234,6 +246,7 @@ static void Initialize(Local<Object> exports,
 void RegisterExternalReferences(ExternalReferenceRegistry* registry) {
   registry->Register(WriteReport);
   registry->Register(GetReport);
+  registry->Register(GetVitals);
   registry->Register(GetCompact);
   registry->Register(SetCompact);
   registry->Register(GetExcludeNetwork);
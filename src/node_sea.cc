@@ -22,6 +22,8 @@
 #include "postject-api.h"
 #undef POSTJECT_SENTINEL_FUSE
 
+#include "simdutf.h"
+
 #include <memory>
 #include <string_view>
 #include <tuple>
@@ -175,6 +177,7 @@ SeaResource SeaDeserializer::Read() {
   if (static_cast<bool>(flags & SeaFlags::kIncludeAssets)) {
     size_t assets_size = ReadArithmetic<size_t>();
     Debug("Read SEA resource assets size %zu\n", assets_size);
+    assets.reserve(assets_size);
     for (size_t i = 0; i < assets_size; ++i) {
       std::string_view key = ReadStringView(StringLogMode::kAddressAndContent);
       std::string_view content = ReadStringView(StringLogMode::kAddressOnly);
@@ -225,7 +228,7 @@ bool SeaResource::use_code_cache() const {
   return static_cast<bool>(flags & SeaFlags::kUseCodeCache);
 }
 
-SeaResource FindSingleExecutableResource() {
+const SeaResource& FindSingleExecutableResource() {
   static const SeaResource sea_resource = []() -> SeaResource {
     std::string_view blob = FindSingleExecutableBlob();
     per_process::Debug(DebugCategory::SEA,
@@ -259,7 +262,7 @@ void IsExperimentalSeaWarningNeeded(const FunctionCallbackInfo<Value>& args) {
     return;
   }
 
-  SeaResource sea_resource = FindSingleExecutableResource();
+  const SeaResource& sea_resource = FindSingleExecutableResource();
   args.GetReturnValue().Set(!static_cast<bool>(
       sea_resource.flags & SeaFlags::kDisableExperimentalSeaWarning));
 }
@@ -593,11 +596,11 @@ void GetAsset(const FunctionCallbackInfo<Value>& args) {
   CHECK_EQ(args.Length(), 1);
   CHECK(args[0]->IsString());
   Utf8Value key(args.GetIsolate(), args[0]);
-  SeaResource sea_resource = FindSingleExecutableResource();
+  const SeaResource& sea_resource = FindSingleExecutableResource();
   if (sea_resource.assets.empty()) {
     return;
   }
-  auto it = sea_resource.assets.find(*key);
+  auto it = sea_resource.assets.find(key.ToStringView());
   if (it == sea_resource.assets.end()) {
     return;
   }
@@ -612,19 +615,33 @@ void GetAsset(const FunctionCallbackInfo<Value>& args) {
   args.GetReturnValue().Set(ab);
 }
 
+// The main script is UTF-8. When it is pure ASCII, which is the common case
+// for bundled code, it is also valid Latin-1 and can be used by V8 as an
+// external string pointing into the executable, without copying it.
+MaybeLocal<Value> MainScriptToV8(Isolate* isolate, std::string_view code) {
+  if (!code.empty() && simdutf::validate_ascii(code.data(), code.size())) {
+    static StaticExternalOneByteResource resource(
+        reinterpret_cast<const uint8_t*>(code.data()), code.size(), nullptr);
+    CHECK_EQ(resource.data(), code.data());
+    return String::NewExternalOneByte(isolate, &resource);
+  }
+  return ToV8Value(isolate->GetCurrentContext(), code);
+}
+
 MaybeLocal<Value> LoadSingleExecutableApplication(
     const StartExecutionCallbackInfo& info) {
   // Here we are currently relying on the fact that in NodeMainInstance::Run(),
   // env->context() is entered.
   Local<Context> context = Isolate::GetCurrent()->GetCurrentContext();
   Environment* env = Environment::GetCurrent(context);
-  SeaResource sea = FindSingleExecutableResource();
+  const SeaResource& sea = FindSingleExecutableResource();
 
   CHECK(!sea.use_snapshot());
-  // TODO(joyeecheung): this should be an external string. Refactor UnionBytes
-  // and make it easy to create one based on static content on the fly.
-  Local<Value> main_script =
-      ToV8Value(env->context(), sea.main_code_or_snapshot).ToLocalChecked();
+  Local<Value> main_script;
+  if (!MainScriptToV8(env->isolate(), sea.main_code_or_snapshot)
+           .ToLocal(&main_script)) {
+    return MaybeLocal<Value>();
+  }
   return info.run_cjs->Call(
       env->context(), Null(env->isolate()), 1, &main_script);
 }
@@ -635,7 +652,7 @@ bool MaybeLoadSingleExecutableApplication(Environment* env) {
     return false;
   }
 
-  SeaResource sea = FindSingleExecutableResource();
+  const SeaResource& sea = FindSingleExecutableResource();
 
   if (sea.use_snapshot()) {
     // The SEA preparation blob building process should already enforce this,
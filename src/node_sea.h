@@ -44,7 +44,9 @@ struct SeaResource {
 };
 
 bool IsSingleExecutable();
-SeaResource FindSingleExecutableResource();
+// Returns the resource deserialized from the injected blob. All of its views
+// point into the executable and remain valid for the lifetime of the process.
+const SeaResource& FindSingleExecutableResource();
 std::tuple<int, char**> FixupArgsForSEA(int argc, char** argv);
 node::ExitCode BuildSingleExecutableBlob(
     const std::string& config_path,
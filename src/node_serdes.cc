@@ -5,14 +5,29 @@
 #include "node_internals.h"
 #include "util-inl.h"
 
+#include <algorithm>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
 namespace node {
 
 using v8::Array;
 using v8::ArrayBuffer;
+using v8::ArrayBufferView;
+using v8::BigInt64Array;
+using v8::BigUint64Array;
 using v8::Context;
+using v8::DataView;
+using v8::Float32Array;
+using v8::Float64Array;
 using v8::Function;
 using v8::FunctionCallbackInfo;
 using v8::FunctionTemplate;
+using v8::Global;
+using v8::Int16Array;
+using v8::Int32Array;
+using v8::Int8Array;
 using v8::Integer;
 using v8::Isolate;
 using v8::Just;
@@ -23,12 +38,111 @@ using v8::Nothing;
 using v8::Object;
 using v8::SharedArrayBuffer;
 using v8::String;
+using v8::Uint16Array;
+using v8::Uint32Array;
+using v8::Uint8Array;
+using v8::Uint8ClampedArray;
 using v8::Value;
 using v8::ValueDeserializer;
 using v8::ValueSerializer;
 
 namespace serdes {
 
+// With native host objects enabled, ArrayBufferViews are written the way
+// the DefaultSerializer of lib/v8.js writes them: the index of their type
+// in its arrayBufferViewTypes, followed by the byte length and the bytes,
+// without calling into JavaScript. The indices must be kept in sync.
+// Views into an ArrayBuffer passed to transferArrayBuffer() are instead
+// written by reference, as kTransferredView | index, followed by the
+// transfer id, the byte offset and the byte length, and the receiver
+// creates them over the buffer it was given for that id.
+enum ViewType : uint32_t {
+  kInt8Array,
+  kUint8Array,
+  kUint8ClampedArray,
+  kInt16Array,
+  kUint16Array,
+  kInt32Array,
+  kUint32Array,
+  kFloat32Array,
+  kFloat64Array,
+  kDataView,
+  kBigInt64Array,
+  kBigUint64Array,
+  kBuffer,
+  kViewTypeCount
+};
+constexpr uint32_t kTransferredView = 1u << 31;
+constexpr size_t kViewElementSize[] = {1, 1, 1, 2, 2, 4, 4, 4, 8, 1, 8, 8, 1};
+static_assert(arraysize(kViewElementSize) == kViewTypeCount);
+
+// Returns kViewTypeCount for the views that are left to JavaScript.
+static ViewType GetViewType(Environment* env, Local<ArrayBufferView> view) {
+  if (view->IsUint8Array()) {
+    return view->GetPrototypeV2() == env->buffer_prototype_object()
+               ? kBuffer
+               : kUint8Array;
+  }
+  if (view->IsInt8Array()) return kInt8Array;
+  if (view->IsUint8ClampedArray()) return kUint8ClampedArray;
+  if (view->IsInt16Array()) return kInt16Array;
+  if (view->IsUint16Array()) return kUint16Array;
+  if (view->IsInt32Array()) return kInt32Array;
+  if (view->IsUint32Array()) return kUint32Array;
+  if (view->IsFloat32Array()) return kFloat32Array;
+  if (view->IsFloat64Array()) return kFloat64Array;
+  if (view->IsDataView()) return kDataView;
+  if (view->IsBigInt64Array()) return kBigInt64Array;
+  if (view->IsBigUint64Array()) return kBigUint64Array;
+  return kViewTypeCount;
+}
+
+// byte_offset must be aligned to the element size of the type.
+template <typename B>
+static MaybeLocal<Object> NewView(Environment* env,
+                                  ViewType type,
+                                  Local<B> buffer,
+                                  size_t byte_offset,
+                                  size_t byte_length) {
+  size_t length = byte_length / kViewElementSize[type];
+  switch (type) {
+#define V(Type)                                                                \
+  case k##Type:                                                                \
+    return Type::New(buffer, byte_offset, length);
+    V(Int8Array)
+    V(Uint8Array)
+    V(Uint8ClampedArray)
+    V(Int16Array)
+    V(Uint16Array)
+    V(Int32Array)
+    V(Uint32Array)
+    V(Float32Array)
+    V(Float64Array)
+    V(DataView)
+    V(BigInt64Array)
+    V(BigUint64Array)
+#undef V
+    case kBuffer: {
+      Local<Uint8Array> ui = Uint8Array::New(buffer, byte_offset, length);
+      if (ui->SetPrototypeV2(env->context(), env->buffer_prototype_object())
+              .IsNothing()) {
+        return {};
+      }
+      return ui;
+    }
+    case kViewTypeCount:
+      break;
+  }
+  UNREACHABLE();
+}
+
+// The size of the last serialized output of each thread. New outputs start
+// at that size, up to a limit, so that the cache of a program that
+// serializes many similar values does not reallocate while writing each of
+// them.
+constexpr size_t kMaxOutputSizeHint = 1024 * 1024;
+static thread_local size_t output_size_hint = 0;
+
 class SerializerContext : public BaseObject,
                           public ValueSerializer::Delegate {
  public:
@@ -41,9 +155,15 @@ class SerializerContext : public BaseObject,
   Maybe<bool> WriteHostObject(Isolate* isolate, Local<Object> object) override;
   Maybe<uint32_t> GetSharedArrayBufferId(
       Isolate* isolate, Local<SharedArrayBuffer> shared_array_buffer) override;
+  void* ReallocateBufferMemory(void* old_buffer,
+                               size_t size,
+                               size_t* actual_size) override;
 
   static void SetTreatArrayBufferViewsAsHostObjects(
       const FunctionCallbackInfo<Value>& args);
+  // _setNativeHostObjects(bool): whether ArrayBufferViews are written
+  // natively instead of through _writeHostObject().
+  static void SetNativeHostObjects(const FunctionCallbackInfo<Value>& args);
 
   static void New(const FunctionCallbackInfo<Value>& args);
   static void WriteHeader(const FunctionCallbackInfo<Value>& args);
@@ -60,7 +180,15 @@ class SerializerContext : public BaseObject,
   SET_SELF_SIZE(SerializerContext)
 
  private:
+  // Returns Just(false) for the views that are left to JavaScript.
+  Maybe<bool> WriteNativeHostObject(Local<ArrayBufferView> view);
+
   ValueSerializer serializer_;
+  bool native_host_objects_ = false;
+  // The ArrayBuffers passed to transferArrayBuffer(), with their ids.
+  std::vector<std::pair<Global<ArrayBuffer>, uint32_t>> transferred_;
+  // The size of the output buffer.
+  size_t capacity_ = 0;
 };
 
 class DeserializerContext : public BaseObject,
@@ -74,6 +202,7 @@ class DeserializerContext : public BaseObject,
 
   MaybeLocal<Object> ReadHostObject(Isolate* isolate) override;
 
+  static void SetNativeHostObjects(const FunctionCallbackInfo<Value>& args);
   static void New(const FunctionCallbackInfo<Value>& args);
   static void ReadHeader(const FunctionCallbackInfo<Value>& args);
   static void ReadValue(const FunctionCallbackInfo<Value>& args);
@@ -89,10 +218,18 @@ class DeserializerContext : public BaseObject,
   SET_SELF_SIZE(DeserializerContext)
 
  private:
+  MaybeLocal<Object> ReadNativeHostObject();
+
   const uint8_t* data_;
   const size_t length_;
+  // The view that data_ points into.
+  Global<ArrayBufferView> buffer_;
 
   ValueDeserializer deserializer_;
+  bool native_host_objects_ = false;
+  // The ArrayBuffers and SharedArrayBuffers passed to transferArrayBuffer(),
+  // by id.
+  std::unordered_map<uint32_t, Global<Object>> transferred_;
 };
 
 SerializerContext::SerializerContext(Environment* env, Local<Object> wrap)
@@ -145,8 +282,52 @@ Maybe<uint32_t> SerializerContext::GetSharedArrayBufferId(
   return id->Uint32Value(env()->context());
 }
 
+void* SerializerContext::ReallocateBufferMemory(void* old_buffer,
+                                                size_t size,
+                                                size_t* actual_size) {
+  if (old_buffer == nullptr) size = std::max(size, output_size_hint);
+  void* buffer = realloc(old_buffer, size);
+  capacity_ = buffer == nullptr ? 0 : size;
+  *actual_size = capacity_;
+  return buffer;
+}
+
+Maybe<bool> SerializerContext::WriteNativeHostObject(
+    Local<ArrayBufferView> view) {
+  ViewType type = GetViewType(env(), view);
+  if (type == kViewTypeCount) return Just(false);
+  size_t byte_offset = view->ByteOffset();
+  size_t byte_length = view->ByteLength();
+
+  if (!transferred_.empty()) {
+    Local<ArrayBuffer> buffer = view->Buffer();
+    for (const auto& [transferred, id] : transferred_) {
+      if (transferred != buffer) continue;
+      serializer_.WriteUint32(kTransferredView | type);
+      serializer_.WriteUint32(id);
+      serializer_.WriteUint64(byte_offset);
+      serializer_.WriteUint64(byte_length);
+      return Just(true);
+    }
+  }
+
+  if (byte_length > UINT32_MAX) return Just(false);
+  ArrayBufferViewContents<char> contents(view);
+  serializer_.WriteUint32(type);
+  serializer_.WriteUint32(static_cast<uint32_t>(byte_length));
+  serializer_.WriteRawBytes(contents.data(), contents.length());
+  return Just(true);
+}
+
 Maybe<bool> SerializerContext::WriteHostObject(Isolate* isolate,
                                                Local<Object> input) {
+  if (native_host_objects_ && input->IsArrayBufferView()) {
+    bool written;
+    if (!WriteNativeHostObject(input.As<ArrayBufferView>()).To(&written))
+      return Nothing<bool>();
+    if (written) return Just(true);
+  }
+
   Local<Value> args[1] = { input };
 
   Local<Value> write_host_object;
@@ -204,6 +385,16 @@ void SerializerContext::SetTreatArrayBufferViewsAsHostObjects(
   ctx->serializer_.SetTreatArrayBufferViewsAsHostObjects(value);
 }
 
+void SerializerContext::SetNativeHostObjects(
+    const FunctionCallbackInfo<Value>& args) {
+  SerializerContext* ctx;
+  ASSIGN_OR_RETURN_UNWRAP(&ctx, args.This());
+
+  ctx->native_host_objects_ = args[0]->BooleanValue(ctx->env()->isolate());
+  if (ctx->native_host_objects_)
+    ctx->serializer_.SetTreatArrayBufferViewsAsHostObjects(true);
+}
+
 void SerializerContext::ReleaseBuffer(const FunctionCallbackInfo<Value>& args) {
   SerializerContext* ctx;
   ASSIGN_OR_RETURN_UNWRAP(&ctx, args.This());
@@ -211,6 +402,14 @@ void SerializerContext::ReleaseBuffer(const FunctionCallbackInfo<Value>& args) {
   // Note: Both ValueSerializer and this Buffer::New() variant use malloc()
   // as the underlying allocator.
   std::pair<uint8_t*, size_t> ret = ctx->serializer_.Release();
+  output_size_hint = std::min(ret.second, kMaxOutputSizeHint);
+  // Give back what the size hint allocated in excess.
+  if (ret.first != nullptr && ret.second > 0 &&
+      ctx->capacity_ / 2 > ret.second) {
+    void* shrunk = realloc(ret.first, ret.second);
+    if (shrunk != nullptr) ret.first = static_cast<uint8_t*>(shrunk);
+  }
+  ctx->capacity_ = 0;
   Local<Object> buf;
   if (Buffer::New(ctx->env(), reinterpret_cast<char*>(ret.first), ret.second)
           .ToLocal(&buf)) {
@@ -235,6 +434,8 @@ void SerializerContext::TransferArrayBuffer(
 
   Local<ArrayBuffer> ab = args[1].As<ArrayBuffer>();
   ctx->serializer_.TransferArrayBuffer(id, ab);
+  ctx->transferred_.emplace_back(Global<ArrayBuffer>(ctx->env()->isolate(), ab),
+                                 id);
 }
 
 void SerializerContext::WriteUint32(const FunctionCallbackInfo<Value>& args) {
@@ -293,13 +494,84 @@ DeserializerContext::DeserializerContext(Environment* env,
   : BaseObject(env, wrap),
     data_(reinterpret_cast<const uint8_t*>(Buffer::Data(buffer))),
     length_(Buffer::Length(buffer)),
+    buffer_(env->isolate(), buffer.As<ArrayBufferView>()),
     deserializer_(env->isolate(), data_, length_, this) {
   object()->Set(env->context(), env->buffer_string(), buffer).Check();
 
   MakeWeak();
 }
 
+MaybeLocal<Object> DeserializerContext::ReadNativeHostObject() {
+  Isolate* isolate = env()->isolate();
+  uint32_t tag;
+  if (!deserializer_.ReadUint32(&tag)) {
+    env()->ThrowError("Unable to deserialize cloned data.");
+    return {};
+  }
+  ViewType type = static_cast<ViewType>(tag & ~kTransferredView);
+  if (type >= kViewTypeCount) {
+    env()->ThrowError("Unable to deserialize cloned data.");
+    return {};
+  }
+  size_t element_size = kViewElementSize[type];
+
+  if (tag & kTransferredView) {
+    uint32_t id;
+    uint64_t byte_offset;
+    uint64_t byte_length;
+    if (!deserializer_.ReadUint32(&id) ||
+        !deserializer_.ReadUint64(&byte_offset) ||
+        !deserializer_.ReadUint64(&byte_length)) {
+      env()->ThrowError("Unable to deserialize cloned data.");
+      return {};
+    }
+    auto it = transferred_.find(id);
+    if (it == transferred_.end()) {
+      env()->ThrowError("Unable to deserialize cloned data.");
+      return {};
+    }
+    Local<Object> buffer = it->second.Get(isolate);
+    size_t buffer_length = buffer->IsArrayBuffer()
+                               ? buffer.As<ArrayBuffer>()->ByteLength()
+                               : buffer.As<SharedArrayBuffer>()->ByteLength();
+    if (byte_offset > buffer_length ||
+        byte_length > buffer_length - byte_offset ||
+        byte_offset % element_size != 0 || byte_length % element_size != 0) {
+      env()->ThrowError("Unable to deserialize cloned data.");
+      return {};
+    }
+    if (buffer->IsArrayBuffer()) {
+      return NewView(
+          env(), type, buffer.As<ArrayBuffer>(), byte_offset, byte_length);
+    }
+    return NewView(
+        env(), type, buffer.As<SharedArrayBuffer>(), byte_offset, byte_length);
+  }
+
+  uint32_t byte_length;
+  const void* data;
+  if (!deserializer_.ReadUint32(&byte_length) ||
+      byte_length % element_size != 0 ||
+      !deserializer_.ReadRawBytes(byte_length, &data)) {
+    env()->ThrowError("Unable to deserialize cloned data.");
+    return {};
+  }
+
+  // Like lib/v8.js, point into the input when the alignment allows it.
+  Local<ArrayBufferView> input = buffer_.Get(isolate);
+  size_t byte_offset = input->ByteOffset() +
+                       (static_cast<const uint8_t*>(data) - data_);
+  if (byte_offset % element_size == 0) {
+    return NewView(env(), type, input->Buffer(), byte_offset, byte_length);
+  }
+  Local<ArrayBuffer> copy = ArrayBuffer::New(isolate, byte_length);
+  memcpy(copy->Data(), data, byte_length);
+  return NewView(env(), type, copy, 0, byte_length);
+}
+
 MaybeLocal<Object> DeserializerContext::ReadHostObject(Isolate* isolate) {
+  if (native_host_objects_) return ReadNativeHostObject();
+
   Local<Value> read_host_object;
   if (!object()
            ->Get(env()->context(), env()->read_host_object_string())
@@ -327,6 +599,14 @@ MaybeLocal<Object> DeserializerContext::ReadHostObject(Isolate* isolate) {
   return ret.As<Object>();
 }
 
+void DeserializerContext::SetNativeHostObjects(
+    const FunctionCallbackInfo<Value>& args) {
+  DeserializerContext* ctx;
+  ASSIGN_OR_RETURN_UNWRAP(&ctx, args.This());
+
+  ctx->native_host_objects_ = args[0]->BooleanValue(ctx->env()->isolate());
+}
+
 void DeserializerContext::New(const FunctionCallbackInfo<Value>& args) {
   Environment* env = Environment::GetCurrent(args);
   if (!args.IsConstructCall()) {
@@ -375,12 +655,14 @@ void DeserializerContext::TransferArrayBuffer(
   if (args[1]->IsArrayBuffer()) {
     Local<ArrayBuffer> ab = args[1].As<ArrayBuffer>();
     ctx->deserializer_.TransferArrayBuffer(id, ab);
+    ctx->transferred_[id].Reset(ctx->env()->isolate(), ab);
     return;
   }
 
   if (args[1]->IsSharedArrayBuffer()) {
     Local<SharedArrayBuffer> sab = args[1].As<SharedArrayBuffer>();
     ctx->deserializer_.TransferSharedArrayBuffer(id, sab);
+    ctx->transferred_[id].Reset(ctx->env()->isolate(), sab);
     return;
   }
 
@@ -491,6 +773,10 @@ void Initialize(Local<Object> target,
                  ser,
                  "_setTreatArrayBufferViewsAsHostObjects",
                  SerializerContext::SetTreatArrayBufferViewsAsHostObjects);
+  SetProtoMethod(isolate,
+                 ser,
+                 "_setNativeHostObjects",
+                 SerializerContext::SetNativeHostObjects);
 
   ser->ReadOnlyPrototype();
   SetConstructorFunction(context, target, "Serializer", ser);
@@ -516,6 +802,10 @@ void Initialize(Local<Object> target,
   SetProtoMethod(isolate, des, "readDouble", DeserializerContext::ReadDouble);
   SetProtoMethod(
       isolate, des, "_readRawBytes", DeserializerContext::ReadRawBytes);
+  SetProtoMethod(isolate,
+                 des,
+                 "_setNativeHostObjects",
+                 DeserializerContext::SetNativeHostObjects);
 
   des->SetLength(1);
   des->ReadOnlyPrototype();
@@ -534,6 +824,7 @@ void RegisterExternalReferences(ExternalReferenceRegistry* registry) {
   registry->Register(SerializerContext::WriteDouble);
   registry->Register(SerializerContext::WriteRawBytes);
   registry->Register(SerializerContext::SetTreatArrayBufferViewsAsHostObjects);
+  registry->Register(SerializerContext::SetNativeHostObjects);
 
   registry->Register(DeserializerContext::New);
   registry->Register(DeserializerContext::ReadHeader);
@@ -544,6 +835,7 @@ void RegisterExternalReferences(ExternalReferenceRegistry* registry) {
   registry->Register(DeserializerContext::ReadUint64);
   registry->Register(DeserializerContext::ReadDouble);
   registry->Register(DeserializerContext::ReadRawBytes);
+  registry->Register(DeserializerContext::SetNativeHostObjects);
 }
 
 }  // namespace serdes
@@ -18,6 +18,7 @@
 #include "node_errors.h"
 #include "node_external_reference.h"
 #include "node_file.h"
+#include "node_http_parser.h"
 #include "node_internals.h"
 #include "node_main_instance.h"
 #include "node_metadata.h"
@@ -27,6 +28,7 @@
 #include "node_url.h"
 #include "node_v8.h"
 #include "node_v8_platform-inl.h"
+#include "node_zlib.h"
 #include "timers.h"
 
 #if HAVE_INSPECTOR
@@ -158,6 +160,10 @@ class SnapshotDeserializer : public BlobDeserializer<SnapshotDeserializer> {
             std::enable_if_t<!std::is_same<T, std::string>::value>* = nullptr,
             std::enable_if_t<!std::is_arithmetic<T>::value>* = nullptr>
   T Read();
+
+  // If true, the V8 startup data and code cache returned by Read() point
+  // into the sink, which must then outlive them.
+  bool in_place = false;
 };
 
 class SnapshotSerializer : public BlobSerializer<SnapshotSerializer> {
@@ -188,6 +194,12 @@ v8::StartupData SnapshotDeserializer::Read() {
   Debug("size=%d\n", raw_size);
 
   CHECK_GT(raw_size, 0);  // There should be no startup data of size 0.
+  if (in_place) {
+    CHECK_LE(read_total + raw_size, sink.size());
+    const char* data = sink.data() + read_total;
+    read_total += raw_size;
+    return v8::StartupData{data, raw_size};
+  }
   // The data pointer of v8::StartupData would be deleted so it must be new'ed.
   std::unique_ptr<char> buf = std::unique_ptr<char>(new char[raw_size]);
   ReadArithmetic<char>(buf.get(), raw_size);
@@ -218,9 +230,18 @@ builtins::CodeCacheInfo SnapshotDeserializer::Read() {
   Debug("Read<builtins::CodeCacheInfo>()\n");
 
   std::string id = ReadString();
-  auto owning_ptr =
-      std::make_shared<std::vector<uint8_t>>(ReadVector<uint8_t>());
-  builtins::BuiltinCodeCacheData code_cache_data{std::move(owning_ptr)};
+  builtins::BuiltinCodeCacheData code_cache_data;
+  if (in_place) {
+    // The cache is laid out as a vector of uint8_t, which is the same as a
+    // string view.
+    std::string_view view = ReadStringView(StringLogMode::kAddressOnly);
+    code_cache_data = builtins::BuiltinCodeCacheData(
+        reinterpret_cast<const uint8_t*>(view.data()), view.size());
+  } else {
+    auto owning_ptr =
+        std::make_shared<std::vector<uint8_t>>(ReadVector<uint8_t>());
+    code_cache_data = builtins::BuiltinCodeCacheData(std::move(owning_ptr));
+  }
   builtins::CodeCacheInfo result{id, code_cache_data};
 
   if (is_debug) {
@@ -393,6 +414,8 @@ size_t SnapshotSerializer::Write(const ImmediateInfo::SerializeInfo& data) {
 // [ 4/8 bytes ]  snapshot index of root
 // [ 4/8 bytes ]  snapshot index of milestones
 // [ 4/8 bytes ]  snapshot index of observers
+// [ 4/8 bytes ]  snapshot index of gc_pauses
+// [ 4/8 bytes ]  snapshot index of heap_spaces
 template <>
 performance::PerformanceState::SerializeInfo SnapshotDeserializer::Read() {
   Debug("Read<PerformanceState::SerializeInfo>()\n");
@@ -401,6 +424,8 @@ performance::PerformanceState::SerializeInfo SnapshotDeserializer::Read() {
   result.root = ReadArithmetic<AliasedBufferIndex>();
   result.milestones = ReadArithmetic<AliasedBufferIndex>();
   result.observers = ReadArithmetic<AliasedBufferIndex>();
+  result.gc_pauses = ReadArithmetic<AliasedBufferIndex>();
+  result.heap_spaces = ReadArithmetic<AliasedBufferIndex>();
   if (is_debug) {
     std::string str = ToStr(result);
     Debug("Read<PerformanceState::SerializeInfo>() %s\n", str.c_str());
@@ -419,6 +444,8 @@ size_t SnapshotSerializer::Write(
   size_t written_total = WriteArithmetic<AliasedBufferIndex>(data.root);
   written_total += WriteArithmetic<AliasedBufferIndex>(data.milestones);
   written_total += WriteArithmetic<AliasedBufferIndex>(data.observers);
+  written_total += WriteArithmetic<AliasedBufferIndex>(data.gc_pauses);
+  written_total += WriteArithmetic<AliasedBufferIndex>(data.heap_spaces);
 
   Debug("Write<PerformanceState::SerializeInfo>() wrote %d bytes\n",
         written_total);
@@ -633,24 +660,20 @@ EmbedderSnapshotData::Pointer SnapshotData::AsEmbedderWrapper() const {
   return EmbedderSnapshotData::Pointer{new EmbedderSnapshotData(this, false)};
 }
 
-bool SnapshotData::FromFile(SnapshotData* out, FILE* in) {
-  return FromBlob(out, ReadFileSync(in));
-}
-
-bool SnapshotData::FromBlob(SnapshotData* out, const std::vector<char>& in) {
-  return FromBlob(out, std::string_view(in.data(), in.size()));
-}
-
-bool SnapshotData::FromBlob(SnapshotData* out, std::string_view in) {
+static bool ReadSnapshotBlob(SnapshotData* out,
+                             std::string_view in,
+                             bool in_place) {
   SnapshotDeserializer r(in);
-  r.Debug("SnapshotData::FromBlob()\n");
+  r.in_place = in_place;
+  r.Debug("SnapshotData::FromBlob() in_place=%s\n",
+          in_place ? "true" : "false");
 
   DCHECK_EQ(out->data_ownership, SnapshotData::DataOwnership::kOwned);
 
   // Metadata
   uint32_t magic = r.ReadArithmetic<uint32_t>();
   r.Debug("Read magic %" PRIx32 "\n", magic);
-  CHECK_EQ(magic, kMagic);
+  CHECK_EQ(magic, SnapshotData::kMagic);
   out->metadata = r.Read<SnapshotMetadata>();
   r.Debug("Read metadata\n");
   if (!out->Check()) {
@@ -658,6 +681,7 @@ bool SnapshotData::FromBlob(SnapshotData* out, std::string_view in) {
   }
 
   out->v8_snapshot_blob_data = r.Read<v8::StartupData>();
+  out->v8_snapshot_blob_data_in_place = in_place;
   r.Debug("Read isolate_data_info\n");
   out->isolate_data_info = r.Read<IsolateDataSerializeInfo>();
   out->env_info = r.Read<EnvSerializeInfo>();
@@ -668,6 +692,22 @@ bool SnapshotData::FromBlob(SnapshotData* out, std::string_view in) {
   return true;
 }
 
+bool SnapshotData::FromFile(SnapshotData* out, FILE* in) {
+  return FromBlob(out, ReadFileSync(in));
+}
+
+bool SnapshotData::FromBlob(SnapshotData* out, const std::vector<char>& in) {
+  return FromBlob(out, std::string_view(in.data(), in.size()));
+}
+
+bool SnapshotData::FromBlob(SnapshotData* out, std::string_view in) {
+  return ReadSnapshotBlob(out, in, false);
+}
+
+bool SnapshotData::FromBlobInPlace(SnapshotData* out, std::string_view in) {
+  return ReadSnapshotBlob(out, in, true);
+}
+
 bool SnapshotData::Check() const {
   if (metadata.node_version != per_process::metadata.versions.node) {
     fprintf(stderr,
@@ -702,6 +742,7 @@ bool SnapshotData::Check() const {
 
 SnapshotData::~SnapshotData() {
   if (data_ownership == DataOwnership::kOwned &&
+      !v8_snapshot_blob_data_in_place &&
       v8_snapshot_blob_data.data != nullptr) {
     delete[] v8_snapshot_blob_data.data;
   }
@@ -1105,6 +1146,15 @@ ExitCode SnapshotBuilder::CreateSnapshot(SnapshotData* out,
       }
     }
 
+    // The context used by the vm module for vanilla contexts, which do not
+    // have the interceptors.
+    Local<Context> vanilla_vm_context;
+    if (!contextify::ContextifyContext::CreateV8Context(
+             isolate, Local<ObjectTemplate>(), nullptr, nullptr)
+             .ToLocal(&vanilla_vm_context)) {
+      return ExitCode::kStartupSnapshotFailure;
+    }
+
     // The Node.js-specific context with primodials, can be used by workers
     // TODO(joyeecheung): investigate if this can be used by vm contexts
     // without breaking compatibility.
@@ -1151,6 +1201,8 @@ ExitCode SnapshotBuilder::CreateSnapshot(SnapshotData* out,
                                             env),
         v8::SerializeContextDataCallback(SerializeNodeContextData, env));
     CHECK_EQ(index, SnapshotData::kNodeMainContextIndex);
+    index = creator->AddContext(vanilla_vm_context);
+    CHECK_EQ(index, SnapshotData::kNodeVanillaVMContextIndex);
   }
 
   // Must be out of HandleScope
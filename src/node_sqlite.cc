@@ -19,13 +19,16 @@ namespace sqlite {
 
 using v8::Array;
 using v8::ArrayBuffer;
+using v8::BackingStore;
 using v8::BackingStoreInitializationMode;
 using v8::BigInt;
+using v8::BigInt64Array;
 using v8::Boolean;
 using v8::ConstructorBehavior;
 using v8::Context;
 using v8::DontDelete;
 using v8::Exception;
+using v8::Float64Array;
 using v8::Function;
 using v8::FunctionCallback;
 using v8::FunctionCallbackInfo;
@@ -47,6 +50,7 @@ using v8::Promise;
 using v8::SideEffectType;
 using v8::String;
 using v8::TryCatch;
+using v8::TypedArray;
 using v8::Uint8Array;
 using v8::Value;
 
@@ -151,10 +155,10 @@ inline MaybeLocal<Object> CreateSQLiteError(Isolate* isolate, int errcode) {
   return e;
 }
 
-inline MaybeLocal<Object> CreateSQLiteError(Isolate* isolate, sqlite3* db) {
-  int errcode = sqlite3_extended_errcode(db);
+inline MaybeLocal<Object> CreateSQLiteError(Isolate* isolate,
+                                            int errcode,
+                                            const char* errmsg) {
   const char* errstr = sqlite3_errstr(errcode);
-  const char* errmsg = sqlite3_errmsg(db);
   Local<String> js_errmsg;
   Local<Object> e;
   Environment* env = Environment::GetCurrent(isolate);
@@ -171,6 +175,11 @@ inline MaybeLocal<Object> CreateSQLiteError(Isolate* isolate, sqlite3* db) {
   return e;
 }
 
+inline MaybeLocal<Object> CreateSQLiteError(Isolate* isolate, sqlite3* db) {
+  return CreateSQLiteError(
+      isolate, sqlite3_extended_errcode(db), sqlite3_errmsg(db));
+}
+
 void JSValueToSQLiteResult(Isolate* isolate,
                            sqlite3_context* ctx,
                            Local<Value> value) {
@@ -434,7 +443,8 @@ class BackupJob : public ThreadPoolWork {
                      std::string dest_db,
                      int pages,
                      Local<Function> progressFunc)
-      : ThreadPoolWork(env, "node_sqlite3.BackupJob"),
+      : ThreadPoolWork(
+            env, "node_sqlite3.BackupJob", ThreadPoolWorkClass::kFs),
         env_(env),
         source_(source),
         pages_(pages),
@@ -769,6 +779,10 @@ void DatabaseSync::FinalizeStatements() {
   }
 
   statements_.clear();
+  for (const StatementCacheEntry& entry : statement_cache_)
+    sqlite3_finalize(entry.second);
+  statement_cache_index_.clear();
+  statement_cache_.clear();
 }
 
 void DatabaseSync::UntrackStatement(StatementSync* statement) {
@@ -966,6 +980,26 @@ void DatabaseSync::New(const FunctionCallbackInfo<Value>& args) {
 
       open_config.set_timeout(timeout_v.As<Int32>()->Value());
     }
+
+    Local<Value> cache_size_v;
+    if (!options
+             ->Get(env->context(),
+                   FIXED_ONE_BYTE_STRING(env->isolate(), "statementCacheSize"))
+             .ToLocal(&cache_size_v)) {
+      return;
+    }
+
+    if (!cache_size_v->IsUndefined()) {
+      if (!cache_size_v->IsInt32() || cache_size_v.As<Int32>()->Value() < 0) {
+        THROW_ERR_INVALID_ARG_TYPE(
+            env->isolate(),
+            "The \"options.statementCacheSize\" argument must be a "
+            "non-negative integer.");
+        return;
+      }
+
+      open_config.set_statement_cache_size(cache_size_v.As<Int32>()->Value());
+    }
   }
 
   new DatabaseSync(
@@ -1026,15 +1060,78 @@ void DatabaseSync::Prepare(const FunctionCallbackInfo<Value>& args) {
   }
 
   Utf8Value sql(env->isolate(), args[0].As<String>());
+  size_t cache_size = db->open_config_.get_statement_cache_size();
   sqlite3_stmt* s = nullptr;
-  int r = sqlite3_prepare_v2(db->connection_, *sql, -1, &s, 0);
-  CHECK_ERROR_OR_THROW(env->isolate(), db, r, SQLITE_OK, void());
+  if (cache_size > 0) {
+    auto it = db->statement_cache_index_.find(sql.ToStringView());
+    if (it != db->statement_cache_index_.end()) {
+      db->statement_cache_hits_++;
+      auto entry = it->second;
+      s = entry->second;
+      db->statement_cache_index_.erase(it);
+      db->statement_cache_.erase(entry);
+    } else {
+      db->statement_cache_misses_++;
+    }
+  }
+
+  if (s == nullptr) {
+    int r = sqlite3_prepare_v2(db->connection_, *sql, -1, &s, 0);
+    CHECK_ERROR_OR_THROW(env->isolate(), db, r, SQLITE_OK, void());
+  }
   BaseObjectPtr<StatementSync> stmt =
       StatementSync::Create(env, BaseObjectPtr<DatabaseSync>(db), s);
   db->statements_.insert(stmt.get());
+  // Statements without any SQL in them have no handle to reuse.
+  if (cache_size > 0 && s != nullptr) stmt->set_cache_key(sql.ToString());
   args.GetReturnValue().Set(stmt->object());
 }
 
+bool DatabaseSync::CacheStatement(std::string sql, sqlite3_stmt* stmt) {
+  size_t cache_size = open_config_.get_statement_cache_size();
+  if (cache_size == 0 || !IsOpen()) return false;
+  // One idle statement per SQL text is enough.
+  if (statement_cache_index_.find(sql) != statement_cache_index_.end())
+    return false;
+  sqlite3_reset(stmt);
+  sqlite3_clear_bindings(stmt);
+  if (statement_cache_.size() >= cache_size) {
+    // Evict the statement that was used least recently.
+    statement_cache_index_.erase(statement_cache_.back().first);
+    sqlite3_finalize(statement_cache_.back().second);
+    statement_cache_.pop_back();
+  }
+  statement_cache_.emplace_front(std::move(sql), stmt);
+  statement_cache_index_.emplace(statement_cache_.front().first,
+                                 statement_cache_.begin());
+  return true;
+}
+
+// Returns { size, capacity, hits, misses } for the statement cache.
+void DatabaseSync::StatementCacheStats(
+    const FunctionCallbackInfo<Value>& args) {
+  DatabaseSync* db;
+  ASSIGN_OR_RETURN_UNWRAP(&db, args.This());
+  Isolate* isolate = args.GetIsolate();
+  Local<Name> names[] = {
+      FIXED_ONE_BYTE_STRING(isolate, "size"),
+      FIXED_ONE_BYTE_STRING(isolate, "capacity"),
+      FIXED_ONE_BYTE_STRING(isolate, "hits"),
+      FIXED_ONE_BYTE_STRING(isolate, "misses"),
+  };
+  Local<Value> values[] = {
+      Number::New(isolate, static_cast<double>(db->statement_cache_.size())),
+      Number::New(isolate,
+                  static_cast<double>(
+                      db->open_config_.get_statement_cache_size())),
+      Number::New(isolate, static_cast<double>(db->statement_cache_hits_)),
+      Number::New(isolate, static_cast<double>(db->statement_cache_misses_)),
+  };
+  static_assert(arraysize(names) == arraysize(values));
+  args.GetReturnValue().Set(Object::New(
+      isolate, Null(isolate), names, values, arraysize(names)));
+}
+
 void DatabaseSync::Exec(const FunctionCallbackInfo<Value>& args) {
   DatabaseSync* db;
   ASSIGN_OR_RETURN_UNWRAP(&db, args.This());
@@ -1784,7 +1881,12 @@ StatementSync::StatementSync(Environment* env,
 StatementSync::~StatementSync() {
   if (!IsFinalized()) {
     db_->UntrackStatement(this);
-    Finalize();
+    if (!cache_key_.empty() &&
+        db_->CacheStatement(std::move(cache_key_), statement_)) {
+      statement_ = nullptr;
+    } else {
+      Finalize();
+    }
   }
 }
 
@@ -1797,15 +1899,17 @@ inline bool StatementSync::IsFinalized() {
   return statement_ == nullptr;
 }
 
-bool StatementSync::BindParams(const FunctionCallbackInfo<Value>& args) {
+template <typename Args>
+bool StatementSync::BindParams(const Args& args) {
   int r = sqlite3_clear_bindings(statement_);
   CHECK_ERROR_OR_THROW(env()->isolate(), db_.get(), r, SQLITE_OK, false);
 
   int anon_idx = 1;
   int anon_start = 0;
 
-  if (args[0]->IsObject() && !args[0]->IsArrayBufferView()) {
-    Local<Object> obj = args[0].As<Object>();
+  Local<Value> first = args[0];
+  if (first->IsObject() && !first->IsArrayBufferView()) {
+    Local<Object> obj = first.As<Object>();
     Local<Context> context = obj->GetIsolate()->GetCurrentContext();
     Local<Array> keys;
     if (!obj->GetOwnPropertyNames(context).ToLocal(&keys)) {
@@ -1955,6 +2059,79 @@ MaybeLocal<Name> StatementSync::ColumnNameToName(const int column) {
   return String::NewFromUtf8(env()->isolate(), col_name).As<Name>();
 }
 
+MaybeLocal<Object> StatementSync::RowTemplate(int num_cols) {
+  bool valid = !row_template_.IsEmpty() &&
+               column_name_strings_.size() == static_cast<size_t>(num_cols);
+  for (int i = 0; valid && i < num_cols; ++i) {
+    // The names change if SQLite recompiles the statement after a schema
+    // change.
+    const char* name = sqlite3_column_name(statement_, i);
+    valid = name != nullptr && column_name_strings_[i] == name;
+  }
+  Isolate* isolate = env()->isolate();
+  if (valid) return row_template_.Get(isolate);
+
+  row_template_.Reset();
+  column_names_.clear();
+  column_name_strings_.clear();
+  Local<Context> context = env()->context();
+  // An object that already has every column as a property. Rows are clones
+  // of it, so that they share its map and have fast properties, rather
+  // than being built as dictionaries.
+  Local<Object> row_template = Object::New(isolate);
+  if (row_template->SetPrototype(context, Null(isolate)).IsNothing()) {
+    return MaybeLocal<Object>();
+  }
+  for (int i = 0; i < num_cols; ++i) {
+    const char* col_name = sqlite3_column_name(statement_, i);
+    if (col_name == nullptr) {
+      THROW_ERR_INVALID_STATE(env(), "Cannot get name of column %d", i);
+      return MaybeLocal<Object>();
+    }
+    Local<String> key;
+    if (!String::NewFromUtf8(isolate, col_name, NewStringType::kInternalized)
+             .ToLocal(&key) ||
+        row_template->CreateDataProperty(context, key, Null(isolate))
+            .IsNothing()) {
+      return MaybeLocal<Object>();
+    }
+    column_names_.emplace_back(isolate, key);
+    column_name_strings_.emplace_back(col_name);
+  }
+  row_template_.Reset(isolate, row_template);
+  return row_template;
+}
+
+MaybeLocal<Value> StatementSync::RowToValue(int num_cols) {
+  Isolate* isolate = env()->isolate();
+  if (return_arrays_) {
+    LocalVector<Value> array_values(isolate);
+    array_values.reserve(num_cols);
+    for (int i = 0; i < num_cols; ++i) {
+      Local<Value> val;
+      if (!ColumnToValue(i).ToLocal(&val)) return MaybeLocal<Value>();
+      array_values.emplace_back(val);
+    }
+    return Array::New(isolate, array_values.data(), array_values.size());
+  }
+
+  Local<Object> row_template;
+  if (!RowTemplate(num_cols).ToLocal(&row_template)) {
+    return MaybeLocal<Value>();
+  }
+  Local<Context> context = env()->context();
+  Local<Object> row = row_template->Clone();
+  for (int i = 0; i < num_cols; ++i) {
+    Local<Value> val;
+    if (!ColumnToValue(i).ToLocal(&val) ||
+        row->CreateDataProperty(context, column_names_[i].Get(isolate), val)
+            .IsNothing()) {
+      return MaybeLocal<Value>();
+    }
+  }
+  return row;
+}
+
 void StatementSync::MemoryInfo(MemoryTracker* tracker) const {}
 
 void StatementSync::All(const FunctionCallbackInfo<Value>& args) {
@@ -1975,49 +2152,149 @@ void StatementSync::All(const FunctionCallbackInfo<Value>& args) {
   int num_cols = sqlite3_column_count(stmt->statement_);
   LocalVector<Value> rows(isolate);
 
-  if (stmt->return_arrays_) {
-    while ((r = sqlite3_step(stmt->statement_)) == SQLITE_ROW) {
-      LocalVector<Value> array_values(isolate);
-      array_values.reserve(num_cols);
-      for (int i = 0; i < num_cols; ++i) {
-        Local<Value> val;
-        if (!stmt->ColumnToValue(i).ToLocal(&val)) return;
-        array_values.emplace_back(val);
-      }
-      Local<Array> row_array =
-          Array::New(isolate, array_values.data(), array_values.size());
-      rows.emplace_back(row_array);
+  while ((r = sqlite3_step(stmt->statement_)) == SQLITE_ROW) {
+    Local<Value> row;
+    if (!stmt->RowToValue(num_cols).ToLocal(&row)) return;
+    rows.emplace_back(row);
+  }
+
+  CHECK_ERROR_OR_THROW(isolate, stmt->db_.get(), r, SQLITE_DONE, void());
+  args.GetReturnValue().Set(Array::New(isolate, rows.data(), rows.size()));
+}
+
+// Like All(), but returns the result column by column. Numeric columns are
+// returned as a Float64Array, or a BigInt64Array for integers when
+// readBigInts is set, which saves creating a JavaScript value per cell.
+// Other columns, and columns that mix types or contain NULLs, are returned
+// as arrays of values.
+void StatementSync::AllColumnar(const FunctionCallbackInfo<Value>& args) {
+  StatementSync* stmt;
+  ASSIGN_OR_RETURN_UNWRAP(&stmt, args.This());
+  Environment* env = Environment::GetCurrent(args);
+  THROW_AND_RETURN_ON_BAD_STATE(
+      env, stmt->IsFinalized(), "statement has been finalized");
+  Isolate* isolate = env->isolate();
+  int r = sqlite3_reset(stmt->statement_);
+  CHECK_ERROR_OR_THROW(isolate, stmt->db_.get(), r, SQLITE_OK, void());
+
+  if (!stmt->BindParams(args)) {
+    return;
+  }
+
+  auto reset = OnScopeLeave([&]() { sqlite3_reset(stmt->statement_); });
+  int num_cols = sqlite3_column_count(stmt->statement_);
+
+  struct Column {
+    enum { kEmpty, kNumber, kBigInt, kValues } kind = kEmpty;
+    std::vector<double> numbers;
+    std::vector<int64_t> big_ints;
+    LocalVector<Value> values;
+    explicit Column(Isolate* isolate) : values(isolate) {}
+  };
+  std::vector<Column> columns;
+  columns.reserve(num_cols);
+  for (int i = 0; i < num_cols; ++i) columns.emplace_back(isolate);
+
+  // Moves the cells collected so far into |column|.values.
+  auto to_values = [&](Column* column) {
+    if (column->kind == Column::kNumber) {
+      column->values.reserve(column->numbers.size());
+      for (double number : column->numbers)
+        column->values.emplace_back(Number::New(isolate, number));
+      column->numbers = {};
+    } else if (column->kind == Column::kBigInt) {
+      column->values.reserve(column->big_ints.size());
+      for (int64_t big_int : column->big_ints)
+        column->values.emplace_back(BigInt::New(isolate, big_int));
+      column->big_ints = {};
     }
-  } else {
-    LocalVector<Name> row_keys(isolate);
-
-    while ((r = sqlite3_step(stmt->statement_)) == SQLITE_ROW) {
-      if (row_keys.size() == 0) {
-        row_keys.reserve(num_cols);
-        for (int i = 0; i < num_cols; ++i) {
-          Local<Name> key;
-          if (!stmt->ColumnNameToName(i).ToLocal(&key)) return;
-          row_keys.emplace_back(key);
+    column->kind = Column::kValues;
+  };
+
+  while ((r = sqlite3_step(stmt->statement_)) == SQLITE_ROW) {
+    for (int i = 0; i < num_cols; ++i) {
+      Column* column = &columns[i];
+      int type = sqlite3_column_type(stmt->statement_, i);
+      if (type == SQLITE_INTEGER && !stmt->use_big_ints_) {
+        sqlite3_int64 val = sqlite3_column_int64(stmt->statement_, i);
+        if (std::abs(val) > kMaxSafeJsInteger) {
+          THROW_ERR_OUT_OF_RANGE(isolate,
+                                 "Value is too large to be represented as a "
+                                 "JavaScript number: %" PRId64,
+                                 val);
+          return;
         }
+        type = SQLITE_FLOAT;
       }
 
-      LocalVector<Value> row_values(isolate);
-      row_values.reserve(num_cols);
-      for (int i = 0; i < num_cols; ++i) {
-        Local<Value> val;
-        if (!stmt->ColumnToValue(i).ToLocal(&val)) return;
-        row_values.emplace_back(val);
+      if (column->kind == Column::kEmpty) {
+        if (type == SQLITE_FLOAT)
+          column->kind = Column::kNumber;
+        else if (type == SQLITE_INTEGER)
+          column->kind = Column::kBigInt;
+        else
+          column->kind = Column::kValues;
       }
-
-      DCHECK_EQ(row_keys.size(), row_values.size());
-      Local<Object> row_obj = Object::New(
-          isolate, Null(isolate), row_keys.data(), row_values.data(), num_cols);
-      rows.emplace_back(row_obj);
+      if (column->kind == Column::kNumber && type == SQLITE_FLOAT) {
+        column->numbers.push_back(
+            sqlite3_column_double(stmt->statement_, i));
+        continue;
+      }
+      if (column->kind == Column::kBigInt && type == SQLITE_INTEGER) {
+        column->big_ints.push_back(sqlite3_column_int64(stmt->statement_, i));
+        continue;
+      }
+      if (column->kind != Column::kValues) to_values(column);
+      Local<Value> val;
+      if (!stmt->ColumnToValue(i).ToLocal(&val)) return;
+      column->values.emplace_back(val);
     }
   }
 
   CHECK_ERROR_OR_THROW(isolate, stmt->db_.get(), r, SQLITE_DONE, void());
-  args.GetReturnValue().Set(Array::New(isolate, rows.data(), rows.size()));
+
+  LocalVector<Value> results(isolate);
+  results.reserve(num_cols);
+  for (Column& column : columns) {
+    if (column.kind == Column::kNumber || column.kind == Column::kBigInt) {
+      bool is_number = column.kind == Column::kNumber;
+      size_t length =
+          is_number ? column.numbers.size() : column.big_ints.size();
+      auto store = ArrayBuffer::NewBackingStore(
+          isolate,
+          length * sizeof(double),
+          BackingStoreInitializationMode::kUninitialized);
+      memcpy(store->Data(),
+             is_number ? static_cast<const void*>(column.numbers.data())
+                       : static_cast<const void*>(column.big_ints.data()),
+             length * sizeof(double));
+      Local<ArrayBuffer> ab = ArrayBuffer::New(isolate, std::move(store));
+      if (is_number) {
+        results.emplace_back(Float64Array::New(ab, 0, length));
+      } else {
+        results.emplace_back(BigInt64Array::New(ab, 0, length));
+      }
+    } else {
+      results.emplace_back(
+          Array::New(isolate, column.values.data(), column.values.size()));
+    }
+  }
+
+  if (stmt->return_arrays_) {
+    args.GetReturnValue().Set(
+        Array::New(isolate, results.data(), results.size()));
+    return;
+  }
+
+  LocalVector<Name> keys(isolate);
+  keys.reserve(num_cols);
+  for (int i = 0; i < num_cols; ++i) {
+    Local<Name> key;
+    if (!stmt->ColumnNameToName(i).ToLocal(&key)) return;
+    keys.emplace_back(key);
+  }
+  args.GetReturnValue().Set(Object::New(
+      isolate, Null(isolate), keys.data(), results.data(), num_cols));
 }
 
 void StatementSync::Iterate(const FunctionCallbackInfo<Value>& args) {
@@ -2088,36 +2365,8 @@ void StatementSync::Get(const FunctionCallbackInfo<Value>& args) {
     return;
   }
 
-  if (stmt->return_arrays_) {
-    LocalVector<Value> array_values(isolate);
-    array_values.reserve(num_cols);
-    for (int i = 0; i < num_cols; ++i) {
-      Local<Value> val;
-      if (!stmt->ColumnToValue(i).ToLocal(&val)) return;
-      array_values.emplace_back(val);
-    }
-    Local<Array> result =
-        Array::New(isolate, array_values.data(), array_values.size());
-    args.GetReturnValue().Set(result);
-  } else {
-    LocalVector<Name> keys(isolate);
-    keys.reserve(num_cols);
-    LocalVector<Value> values(isolate);
-    values.reserve(num_cols);
-
-    for (int i = 0; i < num_cols; ++i) {
-      Local<Name> key;
-      if (!stmt->ColumnNameToName(i).ToLocal(&key)) return;
-      Local<Value> val;
-      if (!stmt->ColumnToValue(i).ToLocal(&val)) return;
-      keys.emplace_back(key);
-      values.emplace_back(val);
-    }
-
-    DCHECK_EQ(keys.size(), values.size());
-    Local<Object> result = Object::New(
-        isolate, Null(isolate), keys.data(), values.data(), num_cols);
-
+  Local<Value> result;
+  if (stmt->RowToValue(num_cols).ToLocal(&result)) {
     args.GetReturnValue().Set(result);
   }
 }
@@ -2166,6 +2415,256 @@ void StatementSync::Run(const FunctionCallbackInfo<Value>& args) {
   args.GetReturnValue().Set(result);
 }
 
+namespace {
+
+// Parameters for one row of runMany(), in the shape BindParams() expects
+// from a FunctionCallbackInfo.
+class ParamsView {
+ public:
+  ParamsView(Isolate* isolate, const LocalVector<Value>& values)
+      : isolate_(isolate), values_(values) {}
+
+  int Length() const { return static_cast<int>(values_.size()); }
+
+  Local<Value> operator[](int i) const {
+    if (i < 0 || i >= Length()) return Undefined(isolate_);
+    return values_[i];
+  }
+
+ private:
+  Isolate* isolate_;
+  const LocalVector<Value>& values_;
+};
+
+// A column of a columnar runMany() batch. Typed arrays are bound without
+// creating a JavaScript value per cell.
+struct BatchColumn {
+  Local<Array> array;
+  Local<TypedArray> typed_array;
+  std::shared_ptr<BackingStore> store;
+  const uint8_t* data = nullptr;
+  size_t length = 0;
+};
+
+int BindTypedArrayElement(sqlite3_stmt* stmt,
+                          int index,
+                          const BatchColumn& column,
+                          size_t row) {
+  const uint8_t* data = column.data;
+  Local<TypedArray> ta = column.typed_array;
+#define V(Type, ctype, bind, cast)                                             \
+  if (ta->Is##Type()) {                                                        \
+    ctype value;                                                               \
+    memcpy(&value, data + row * sizeof(ctype), sizeof(ctype));                 \
+    return bind(stmt, index, static_cast<cast>(value));                        \
+  }
+  V(Float64Array, double, sqlite3_bind_double, double)
+  V(Float32Array, float, sqlite3_bind_double, double)
+  V(Int8Array, int8_t, sqlite3_bind_int64, sqlite3_int64)
+  V(Uint8Array, uint8_t, sqlite3_bind_int64, sqlite3_int64)
+  V(Uint8ClampedArray, uint8_t, sqlite3_bind_int64, sqlite3_int64)
+  V(Int16Array, int16_t, sqlite3_bind_int64, sqlite3_int64)
+  V(Uint16Array, uint16_t, sqlite3_bind_int64, sqlite3_int64)
+  V(Int32Array, int32_t, sqlite3_bind_int64, sqlite3_int64)
+  V(Uint32Array, uint32_t, sqlite3_bind_int64, sqlite3_int64)
+  V(BigInt64Array, int64_t, sqlite3_bind_int64, sqlite3_int64)
+#undef V
+  UNREACHABLE("Unsupported typed array");
+}
+
+}  // anonymous namespace
+
+// runMany(rows[, options])
+//
+// Runs the statement once per element of |rows|, which is either an array
+// of parameters, spread like the arguments of run(), or a single value.
+// With options.columns, |rows| is instead an array of columns, each an
+// array or a numeric typed array, that bind the positional parameters.
+// With options.transaction, all rows are inserted inside a savepoint that
+// is rolled back if any of them fails.
+void StatementSync::RunMany(const FunctionCallbackInfo<Value>& args) {
+  StatementSync* stmt;
+  ASSIGN_OR_RETURN_UNWRAP(&stmt, args.This());
+  Environment* env = Environment::GetCurrent(args);
+  THROW_AND_RETURN_ON_BAD_STATE(
+      env, stmt->IsFinalized(), "statement has been finalized");
+  Isolate* isolate = env->isolate();
+  Local<Context> context = env->context();
+
+  if (!args[0]->IsArray()) {
+    THROW_ERR_INVALID_ARG_TYPE(isolate,
+                               "The \"rows\" argument must be an array.");
+    return;
+  }
+  Local<Array> rows = args[0].As<Array>();
+
+  bool columnar = false;
+  bool transaction = false;
+  if (!args[1]->IsUndefined()) {
+    if (!args[1]->IsObject()) {
+      THROW_ERR_INVALID_ARG_TYPE(isolate,
+                                 "The \"options\" argument must be an object.");
+      return;
+    }
+    Local<Object> options = args[1].As<Object>();
+    Local<Value> columns_v;
+    Local<Value> transaction_v;
+    if (!options->Get(context, FIXED_ONE_BYTE_STRING(isolate, "columns"))
+             .ToLocal(&columns_v) ||
+        !options->Get(context, FIXED_ONE_BYTE_STRING(isolate, "transaction"))
+             .ToLocal(&transaction_v)) {
+      return;
+    }
+    if (!columns_v->IsUndefined()) {
+      if (!columns_v->IsBoolean()) {
+        THROW_ERR_INVALID_ARG_TYPE(
+            isolate, "The \"options.columns\" argument must be a boolean.");
+        return;
+      }
+      columnar = columns_v->IsTrue();
+    }
+    if (!transaction_v->IsUndefined()) {
+      if (!transaction_v->IsBoolean()) {
+        THROW_ERR_INVALID_ARG_TYPE(
+            isolate, "The \"options.transaction\" argument must be a boolean.");
+        return;
+      }
+      transaction = transaction_v->IsTrue();
+    }
+  }
+
+  std::vector<BatchColumn> columns;
+  size_t num_rows = rows->Length();
+  if (columnar) {
+    columns.resize(rows->Length());
+    for (uint32_t i = 0; i < rows->Length(); i++) {
+      Local<Value> column_v;
+      if (!rows->Get(context, i).ToLocal(&column_v)) return;
+      BatchColumn& column = columns[i];
+      if (column_v->IsArray()) {
+        column.array = column_v.As<Array>();
+        column.length = column.array->Length();
+      } else if (column_v->IsTypedArray() && !column_v->IsBigUint64Array() &&
+                 !column_v->IsFloat16Array()) {
+        column.typed_array = column_v.As<TypedArray>();
+        column.length = column.typed_array->Length();
+        column.store = column.typed_array->Buffer()->GetBackingStore();
+        column.data = static_cast<const uint8_t*>(column.store->Data()) +
+                      column.typed_array->ByteOffset();
+      } else {
+        THROW_ERR_INVALID_ARG_TYPE(
+            isolate,
+            "Column %u must be an array or a numeric typed array.",
+            i);
+        return;
+      }
+      if (i > 0 && column.length != columns[0].length) {
+        THROW_ERR_INVALID_ARG_VALUE(isolate,
+                                    "All columns must have the same length.");
+        return;
+      }
+    }
+    num_rows = columns.empty() ? 0 : columns[0].length;
+  }
+
+  sqlite3* connection = stmt->db_->Connection();
+  bool committed = true;
+  if (transaction) {
+    int r = sqlite3_exec(
+        connection, "SAVEPOINT node_run_many", nullptr, nullptr, nullptr);
+    CHECK_ERROR_OR_THROW(isolate, stmt->db_.get(), r, SQLITE_OK, void());
+    committed = false;
+  }
+  auto rollback = OnScopeLeave([&]() {
+    sqlite3_reset(stmt->statement_);
+    if (committed) return;
+    sqlite3_exec(connection,
+                 "ROLLBACK TO node_run_many; RELEASE node_run_many",
+                 nullptr,
+                 nullptr,
+                 nullptr);
+  });
+
+  sqlite3_int64 changes = 0;
+  LocalVector<Value> row_values(isolate);
+  for (size_t row = 0; row < num_rows; row++) {
+    int r = sqlite3_reset(stmt->statement_);
+    CHECK_ERROR_OR_THROW(isolate, stmt->db_.get(), r, SQLITE_OK, void());
+
+    if (columnar) {
+      r = sqlite3_clear_bindings(stmt->statement_);
+      CHECK_ERROR_OR_THROW(isolate, stmt->db_.get(), r, SQLITE_OK, void());
+      int index = 1;
+      for (const BatchColumn& column : columns) {
+        while (sqlite3_bind_parameter_name(stmt->statement_, index) !=
+               nullptr) {
+          index++;
+        }
+        if (!column.typed_array.IsEmpty()) {
+          r = BindTypedArrayElement(stmt->statement_, index, column, row);
+          CHECK_ERROR_OR_THROW(isolate, stmt->db_.get(), r, SQLITE_OK, void());
+        } else {
+          Local<Value> value;
+          if (!column.array->Get(context, row).ToLocal(&value) ||
+              !stmt->BindValue(value, index)) {
+            return;
+          }
+        }
+        index++;
+      }
+    } else {
+      Local<Value> params;
+      if (!rows->Get(context, row).ToLocal(&params)) return;
+      row_values.clear();
+      if (params->IsArray()) {
+        Local<Array> array = params.As<Array>();
+        for (uint32_t i = 0; i < array->Length(); i++) {
+          Local<Value> value;
+          if (!array->Get(context, i).ToLocal(&value)) return;
+          row_values.emplace_back(value);
+        }
+      } else {
+        row_values.emplace_back(params);
+      }
+      if (!stmt->BindParams(ParamsView(isolate, row_values))) return;
+    }
+
+    sqlite3_step(stmt->statement_);
+    r = sqlite3_reset(stmt->statement_);
+    CHECK_ERROR_OR_THROW(isolate, stmt->db_.get(), r, SQLITE_OK, void());
+    changes += sqlite3_changes64(connection);
+  }
+
+  if (transaction) {
+    int r = sqlite3_exec(
+        connection, "RELEASE node_run_many", nullptr, nullptr, nullptr);
+    CHECK_ERROR_OR_THROW(isolate, stmt->db_.get(), r, SQLITE_OK, void());
+    committed = true;
+  }
+
+  Local<Object> result = Object::New(isolate);
+  sqlite3_int64 last_insert_rowid = sqlite3_last_insert_rowid(connection);
+  Local<Value> last_insert_rowid_val;
+  Local<Value> changes_val;
+
+  if (stmt->use_big_ints_) {
+    last_insert_rowid_val = BigInt::New(isolate, last_insert_rowid);
+    changes_val = BigInt::New(isolate, changes);
+  } else {
+    last_insert_rowid_val = Number::New(isolate, last_insert_rowid);
+    changes_val = Number::New(isolate, changes);
+  }
+
+  if (result
+          ->Set(context, env->last_insert_rowid_string(), last_insert_rowid_val)
+          .IsNothing() ||
+      result->Set(context, env->changes_string(), changes_val).IsNothing()) {
+    return;
+  }
+
+  args.GetReturnValue().Set(result);
+}
+
 void StatementSync::Columns(const FunctionCallbackInfo<Value>& args) {
   StatementSync* stmt;
   ASSIGN_OR_RETURN_UNWRAP(&stmt, args.This());
@@ -2368,8 +2867,10 @@ Local<FunctionTemplate> StatementSync::GetConstructorTemplate(
         StatementSync::kInternalFieldCount);
     SetProtoMethod(isolate, tmpl, "iterate", StatementSync::Iterate);
     SetProtoMethod(isolate, tmpl, "all", StatementSync::All);
+    SetProtoMethod(isolate, tmpl, "allColumnar", StatementSync::AllColumnar);
     SetProtoMethod(isolate, tmpl, "get", StatementSync::Get);
     SetProtoMethod(isolate, tmpl, "run", StatementSync::Run);
+    SetProtoMethod(isolate, tmpl, "runMany", StatementSync::RunMany);
     SetProtoMethodNoSideEffect(
         isolate, tmpl, "columns", StatementSync::Columns);
     SetSideEffectFreeGetter(isolate,
@@ -2486,34 +2987,7 @@ void StatementSyncIterator::Next(const FunctionCallbackInfo<Value>& args) {
 
   int num_cols = sqlite3_column_count(iter->stmt_->statement_);
   Local<Value> row_value;
-
-  if (iter->stmt_->return_arrays_) {
-    LocalVector<Value> array_values(isolate);
-    array_values.reserve(num_cols);
-    for (int i = 0; i < num_cols; ++i) {
-      Local<Value> val;
-      if (!iter->stmt_->ColumnToValue(i).ToLocal(&val)) return;
-      array_values.emplace_back(val);
-    }
-    row_value = Array::New(isolate, array_values.data(), array_values.size());
-  } else {
-    LocalVector<Name> row_keys(isolate);
-    LocalVector<Value> row_values(isolate);
-    row_keys.reserve(num_cols);
-    row_values.reserve(num_cols);
-    for (int i = 0; i < num_cols; ++i) {
-      Local<Name> key;
-      if (!iter->stmt_->ColumnNameToName(i).ToLocal(&key)) return;
-      Local<Value> val;
-      if (!iter->stmt_->ColumnToValue(i).ToLocal(&val)) return;
-      row_keys.emplace_back(key);
-      row_values.emplace_back(val);
-    }
-
-    DCHECK_EQ(row_keys.size(), row_values.size());
-    row_value = Object::New(
-        isolate, Null(isolate), row_keys.data(), row_values.data(), num_cols);
-  }
+  if (!iter->stmt_->RowToValue(num_cols).ToLocal(&row_value)) return;
 
   LocalVector<Value> values(isolate, {Boolean::New(isolate, false), row_value});
   DCHECK_EQ(keys.size(), values.size());
@@ -2645,34 +3119,957 @@ void Session::Delete() {
   session_ = nullptr;
 }
 
-void DefineConstants(Local<Object> target) {
-  NODE_DEFINE_CONSTANT(target, SQLITE_CHANGESET_OMIT);
-  NODE_DEFINE_CONSTANT(target, SQLITE_CHANGESET_REPLACE);
-  NODE_DEFINE_CONSTANT(target, SQLITE_CHANGESET_ABORT);
-
-  NODE_DEFINE_CONSTANT(target, SQLITE_CHANGESET_DATA);
-  NODE_DEFINE_CONSTANT(target, SQLITE_CHANGESET_NOTFOUND);
-  NODE_DEFINE_CONSTANT(target, SQLITE_CHANGESET_CONFLICT);
-  NODE_DEFINE_CONSTANT(target, SQLITE_CHANGESET_CONSTRAINT);
-  NODE_DEFINE_CONSTANT(target, SQLITE_CHANGESET_FOREIGN_KEY);
-}
-
-static void Initialize(Local<Object> target,
-                       Local<Value> unused,
-                       Local<Context> context,
-                       void* priv) {
-  Environment* env = Environment::GetCurrent(context);
-  Isolate* isolate = env->isolate();
-  Local<FunctionTemplate> db_tmpl =
-      NewFunctionTemplate(isolate, DatabaseSync::New);
-  db_tmpl->InstanceTemplate()->SetInternalFieldCount(
-      DatabaseSync::kInternalFieldCount);
-  Local<Object> constants = Object::New(isolate);
+namespace {
 
-  DefineConstants(constants);
+constexpr size_t kMaxCachedStatements = 64;
 
-  SetProtoMethod(isolate, db_tmpl, "open", DatabaseSync::Open);
-  SetProtoMethod(isolate, db_tmpl, "close", DatabaseSync::Close);
+bool JSValueToSQLiteValue(Environment* env,
+                          Local<Value> value,
+                          int index,
+                          SQLiteValue* out) {
+  if (value->IsNumber()) {
+    *out = value.As<Number>()->Value();
+  } else if (value->IsString()) {
+    Utf8Value val(env->isolate(), value.As<String>());
+    *out = val.ToString();
+  } else if (value->IsNull()) {
+    *out = std::monostate();
+  } else if (value->IsArrayBufferView()) {
+    ArrayBufferViewContents<uint8_t> buf(value);
+    *out = std::vector<uint8_t>(buf.data(), buf.data() + buf.length());
+  } else if (value->IsBigInt()) {
+    bool lossless;
+    int64_t as_int = value.As<BigInt>()->Int64Value(&lossless);
+    if (!lossless) {
+      THROW_ERR_INVALID_ARG_VALUE(env, "BigInt value is too large to bind.");
+      return false;
+    }
+    *out = static_cast<sqlite3_int64>(as_int);
+  } else {
+    THROW_ERR_INVALID_ARG_TYPE(
+        env->isolate(),
+        "Provided value cannot be bound to SQLite parameter %d.",
+        index);
+    return false;
+  }
+  return true;
+}
+
+int BindSQLiteValue(sqlite3_stmt* stmt, int index, const SQLiteValue& value) {
+  if (std::holds_alternative<sqlite3_int64>(value)) {
+    return sqlite3_bind_int64(stmt, index, std::get<sqlite3_int64>(value));
+  } else if (std::holds_alternative<double>(value)) {
+    return sqlite3_bind_double(stmt, index, std::get<double>(value));
+  } else if (std::holds_alternative<std::string>(value)) {
+    const std::string& text = std::get<std::string>(value);
+    return sqlite3_bind_text64(
+        stmt, index, text.data(), text.size(), SQLITE_STATIC, SQLITE_UTF8);
+  } else if (std::holds_alternative<std::vector<uint8_t>>(value)) {
+    const std::vector<uint8_t>& blob = std::get<std::vector<uint8_t>>(value);
+    return sqlite3_bind_blob64(
+        stmt, index, blob.data(), blob.size(), SQLITE_STATIC);
+  }
+  return sqlite3_bind_null(stmt, index);
+}
+
+SQLiteValue ColumnToSQLiteValue(sqlite3_stmt* stmt, int column) {
+  switch (sqlite3_column_type(stmt, column)) {
+    case SQLITE_INTEGER:
+      return sqlite3_column_int64(stmt, column);
+    case SQLITE_FLOAT:
+      return sqlite3_column_double(stmt, column);
+    case SQLITE_TEXT: {
+      const char* text =
+          reinterpret_cast<const char*>(sqlite3_column_text(stmt, column));
+      return std::string(text, sqlite3_column_bytes(stmt, column));
+    }
+    case SQLITE_BLOB: {
+      const uint8_t* data =
+          static_cast<const uint8_t*>(sqlite3_column_blob(stmt, column));
+      return std::vector<uint8_t>(data,
+                                  data + sqlite3_column_bytes(stmt, column));
+    }
+    case SQLITE_NULL:
+      return std::monostate();
+    default:
+      UNREACHABLE("Bad SQLite value");
+  }
+}
+
+MaybeLocal<Value> SQLiteValueToJS(Isolate* isolate,
+                                  const SQLiteValue& value,
+                                  bool use_big_ints) {
+  if (std::holds_alternative<sqlite3_int64>(value)) {
+    sqlite3_int64 val = std::get<sqlite3_int64>(value);
+    if (use_big_ints) return BigInt::New(isolate, val);
+    if (std::abs(val) > kMaxSafeJsInteger) {
+      THROW_ERR_OUT_OF_RANGE(isolate,
+                             "Value is too large to be represented as a "
+                             "JavaScript number: %" PRId64,
+                             val);
+      return MaybeLocal<Value>();
+    }
+    return Number::New(isolate, val);
+  } else if (std::holds_alternative<double>(value)) {
+    return Number::New(isolate, std::get<double>(value));
+  } else if (std::holds_alternative<std::string>(value)) {
+    const std::string& text = std::get<std::string>(value);
+    return String::NewFromUtf8(
+               isolate, text.data(), NewStringType::kNormal, text.size())
+        .As<Value>();
+  } else if (std::holds_alternative<std::vector<uint8_t>>(value)) {
+    const std::vector<uint8_t>& blob = std::get<std::vector<uint8_t>>(value);
+    auto store = ArrayBuffer::NewBackingStore(
+        isolate, blob.size(), BackingStoreInitializationMode::kUninitialized);
+    if (!blob.empty()) memcpy(store->Data(), blob.data(), blob.size());
+    auto ab = ArrayBuffer::New(isolate, std::move(store));
+    return Uint8Array::New(ab, 0, blob.size()).As<Value>();
+  }
+  return Null(isolate).As<Value>();
+}
+
+int OpenConnection(DatabaseOpenConfiguration* config,
+                   bool read_only,
+                   sqlite3** out) {
+  int flags = SQLITE_OPEN_URI;
+  flags |= read_only ? SQLITE_OPEN_READONLY
+                     : SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE;
+  int r = sqlite3_open_v2(config->location().c_str(), out, flags, nullptr);
+  if (r != SQLITE_OK) return r;
+  int dqs = static_cast<int>(config->get_enable_dqs());
+  r = sqlite3_db_config(*out, SQLITE_DBCONFIG_DQS_DML, dqs, nullptr);
+  if (r != SQLITE_OK) return r;
+  r = sqlite3_db_config(*out, SQLITE_DBCONFIG_DQS_DDL, dqs, nullptr);
+  if (r != SQLITE_OK) return r;
+  r = sqlite3_db_config(
+      *out,
+      SQLITE_DBCONFIG_ENABLE_FKEY,
+      static_cast<int>(config->get_enable_foreign_keys()),
+      nullptr);
+  if (r != SQLITE_OK) return r;
+  return sqlite3_busy_timeout(*out, config->get_timeout());
+}
+
+// Whether the first statement in |sql| begins or ends a transaction.
+// sqlite3_stmt_readonly() is true for those, but they have to run on the
+// writer connection.
+bool IsTransactionControl(std::string_view sql) {
+  size_t i = 0;
+  while (i < sql.size()) {
+    if (std::string_view(" \t\n\f\r").find(sql[i]) != std::string_view::npos) {
+      i++;
+    } else if (sql.substr(i, 2) == "--") {
+      i = sql.find('\n', i);
+      if (i == std::string_view::npos) return false;
+    } else if (sql.substr(i, 2) == "/*") {
+      i = sql.find("*/", i + 2);
+      if (i == std::string_view::npos) return false;
+      i += 2;
+    } else {
+      break;
+    }
+  }
+  size_t end = i;
+  while (end < sql.size() && ToLower(sql[end]) >= 'a' &&
+         ToLower(sql[end]) <= 'z') {
+    end++;
+  }
+  for (const char* keyword :
+       {"BEGIN", "COMMIT", "END", "ROLLBACK", "SAVEPOINT", "RELEASE"}) {
+    if (end - i == strlen(keyword) &&
+        StringEqualNoCaseN(sql.data() + i, keyword, end - i)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+}  // anonymous namespace
+
+// A query run on the threadpool, on the connection that the Database hands
+// to it. Parameters are converted before the query is queued, and results
+// are converted to JavaScript once it is done.
+class AsyncQuery : public ThreadPoolWork {
+ public:
+  enum Kind { kExec, kAll, kGet, kRun };
+
+  AsyncQuery(Environment* env,
+             Kind kind,
+             BaseObjectPtr<Database> db,
+             BaseObjectPtr<Statement> stmt,
+             std::string&& sql,
+             Local<Promise::Resolver> resolver)
+      : ThreadPoolWork(
+            env, "node_sqlite3.AsyncQuery", ThreadPoolWorkClass::kFs),
+        kind_(kind),
+        db_(std::move(db)),
+        stmt_(std::move(stmt)),
+        sql_(std::move(sql)),
+        resolver_(env->isolate(), resolver) {
+    if (stmt_) {
+      use_big_ints_ = stmt_->use_big_ints_;
+      return_arrays_ = stmt_->return_arrays_;
+    }
+    may_change_transaction_ = !stmt_ || stmt_->transaction_control_;
+  }
+
+  // Converts the parameters in |args| the way StatementSync::BindParams()
+  // reads them.
+  bool SetParams(const FunctionCallbackInfo<Value>& args) {
+    Environment* env = this->env();
+    Local<Context> context = env->context();
+    int start = 0;
+    if (args.Length() > 0 && args[0]->IsObject() &&
+        !args[0]->IsArrayBufferView()) {
+      Local<Object> obj = args[0].As<Object>();
+      Local<Array> keys;
+      if (!obj->GetOwnPropertyNames(context).ToLocal(&keys)) return false;
+      for (uint32_t i = 0; i < keys->Length(); i++) {
+        Local<Value> key;
+        Local<Value> value;
+        if (!keys->Get(context, i).ToLocal(&key) ||
+            !obj->Get(context, key).ToLocal(&value)) {
+          return false;
+        }
+        Utf8Value name(env->isolate(), key);
+        SQLiteValue converted;
+        if (!JSValueToSQLiteValue(env, value, i + 1, &converted)) return false;
+        named_params_.emplace_back(name.ToString(), std::move(converted));
+      }
+      start = 1;
+    }
+    for (int i = start; i < args.Length(); i++) {
+      SQLiteValue converted;
+      if (!JSValueToSQLiteValue(env, args[i], i - start + 1, &converted))
+        return false;
+      anonymous_params_.push_back(std::move(converted));
+    }
+    return true;
+  }
+
+  void Start(Database::Connection* connection) {
+    connection_ = connection;
+    db_->running_++;
+    ScheduleWork();
+  }
+
+  Database::Connection* connection() const { return connection_; }
+
+  void DoThreadPoolWork() override {
+    sqlite3* handle = connection_->handle;
+    auto fail = [&]() {
+      status_ = sqlite3_extended_errcode(handle);
+      error_message_ = sqlite3_errmsg(handle);
+    };
+    auto done = OnScopeLeave(
+        [&]() { autocommit_ = sqlite3_get_autocommit(handle) != 0; });
+
+    if (kind_ == kExec) {
+      if (sqlite3_exec(handle, sql_.c_str(), nullptr, nullptr, nullptr) !=
+          SQLITE_OK) {
+        fail();
+      }
+      return;
+    }
+
+    sqlite3_stmt* stmt;
+    int r = connection_->Prepare(sql_, &stmt);
+    if (r != SQLITE_OK) return fail();
+    // Nothing to run, e.g. only comments.
+    if (stmt == nullptr) return;
+    transaction_control_ = IsTransactionControl(sql_);
+    read_only_ = !transaction_control_ && sqlite3_stmt_readonly(stmt) != 0;
+    auto reset = OnScopeLeave([&]() {
+      sqlite3_reset(stmt);
+      sqlite3_clear_bindings(stmt);
+    });
+    if (!Bind(stmt)) return;
+
+    if (kind_ == kRun) {
+      sqlite3_step(stmt);
+      if (sqlite3_reset(stmt) != SQLITE_OK) return fail();
+      changes_ = sqlite3_changes64(handle);
+      last_insert_rowid_ = sqlite3_last_insert_rowid(handle);
+      return;
+    }
+
+    num_cols_ = sqlite3_column_count(stmt);
+    while ((r = sqlite3_step(stmt)) == SQLITE_ROW) {
+      if (column_names_.empty() && !return_arrays_) {
+        for (int i = 0; i < num_cols_; i++) {
+          const char* name = sqlite3_column_name(stmt, i);
+          if (name == nullptr) {
+            status_ = SQLITE_NOMEM;
+            error_message_ = "Cannot get name of column " + std::to_string(i);
+            custom_error_ = true;
+            return;
+          }
+          column_names_.emplace_back(name);
+        }
+      }
+      for (int i = 0; i < num_cols_; i++)
+        values_.push_back(ColumnToSQLiteValue(stmt, i));
+      num_rows_++;
+      if (kind_ == kGet) return;
+    }
+    if (r != SQLITE_DONE) fail();
+  }
+
+  void AfterThreadPoolWork(int status) override {
+    std::unique_ptr<AsyncQuery> self(this);
+    Environment* env = this->env();
+    Isolate* isolate = env->isolate();
+    HandleScope handle_scope(isolate);
+    Local<Context> context = env->context();
+    Context::Scope context_scope(context);
+    Local<Promise::Resolver> resolver = resolver_.Get(isolate);
+
+    if (stmt_ && status_ == SQLITE_OK) {
+      stmt_->read_only_ = read_only_;
+      stmt_->transaction_control_ = transaction_control_;
+    }
+    db_->Release(this);
+
+    if (status == UV_ECANCELED) {
+      status_ = SQLITE_INTERRUPT;
+      error_message_ = sqlite3_errstr(SQLITE_INTERRUPT);
+    }
+    if (status_ != SQLITE_OK) {
+      Local<Object> e;
+      MaybeLocal<Object> maybe_error =
+          custom_error_
+              ? CreateSQLiteError(isolate, error_message_.c_str())
+              : CreateSQLiteError(isolate, status_, error_message_.c_str());
+      if (maybe_error.ToLocal(&e)) resolver->Reject(context, e).Check();
+      return;
+    }
+
+    TryCatch try_catch(isolate);
+    Local<Value> result;
+    if (!ToResult().ToLocal(&result)) {
+      if (try_catch.HasCaught() && try_catch.CanContinue()) {
+        resolver->Reject(context, try_catch.Exception()).Check();
+      }
+      return;
+    }
+    resolver->Resolve(context, result).Check();
+  }
+
+ private:
+  bool Bind(sqlite3_stmt* stmt) {
+    for (const auto& [name, value] : named_params_) {
+      int index = sqlite3_bind_parameter_index(stmt, name.c_str());
+      // Bare names, as allowed by StatementSync by default.
+      for (const char* prefix : {":", "@", "$"}) {
+        if (index != 0) break;
+        index = sqlite3_bind_parameter_index(stmt, (prefix + name).c_str());
+      }
+      if (index == 0) {
+        status_ = SQLITE_RANGE;
+        error_message_ = "Unknown named parameter '" + name + "'";
+        custom_error_ = true;
+        return false;
+      }
+      if (BindSQLiteValue(stmt, index, value) != SQLITE_OK) {
+        status_ = sqlite3_extended_errcode(sqlite3_db_handle(stmt));
+        error_message_ = sqlite3_errmsg(sqlite3_db_handle(stmt));
+        return false;
+      }
+    }
+    int index = 1;
+    for (const SQLiteValue& value : anonymous_params_) {
+      while (sqlite3_bind_parameter_name(stmt, index) != nullptr) index++;
+      if (BindSQLiteValue(stmt, index, value) != SQLITE_OK) {
+        status_ = sqlite3_extended_errcode(sqlite3_db_handle(stmt));
+        error_message_ = sqlite3_errmsg(sqlite3_db_handle(stmt));
+        return false;
+      }
+      index++;
+    }
+    return true;
+  }
+
+  MaybeLocal<Value> ToResult() {
+    Environment* env = this->env();
+    Isolate* isolate = env->isolate();
+    if (kind_ == kExec) return Undefined(isolate);
+    if (kind_ == kRun) {
+      Local<Object> result = Object::New(isolate);
+      Local<Value> last_insert_rowid;
+      Local<Value> changes;
+      if (use_big_ints_) {
+        last_insert_rowid = BigInt::New(isolate, last_insert_rowid_);
+        changes = BigInt::New(isolate, changes_);
+      } else {
+        last_insert_rowid = Number::New(isolate, last_insert_rowid_);
+        changes = Number::New(isolate, changes_);
+      }
+      if (result
+              ->Set(env->context(),
+                    env->last_insert_rowid_string(),
+                    last_insert_rowid)
+              .IsNothing() ||
+          result->Set(env->context(), env->changes_string(), changes)
+              .IsNothing()) {
+        return MaybeLocal<Value>();
+      }
+      return result;
+    }
+
+    LocalVector<Name> keys(isolate);
+    if (!return_arrays_) {
+      keys.reserve(column_names_.size());
+      for (const std::string& name : column_names_) {
+        Local<String> key;
+        if (!String::NewFromUtf8(
+                 isolate, name.data(), NewStringType::kNormal, name.size())
+                 .ToLocal(&key)) {
+          return MaybeLocal<Value>();
+        }
+        keys.emplace_back(key);
+      }
+    }
+    LocalVector<Value> rows(isolate);
+    rows.reserve(num_rows_);
+    LocalVector<Value> row_values(isolate);
+    for (size_t row = 0; row < num_rows_; row++) {
+      row_values.clear();
+      for (int i = 0; i < num_cols_; i++) {
+        Local<Value> val;
+        if (!SQLiteValueToJS(
+                 isolate, values_[row * num_cols_ + i], use_big_ints_)
+                 .ToLocal(&val)) {
+          return MaybeLocal<Value>();
+        }
+        row_values.emplace_back(val);
+      }
+      if (return_arrays_) {
+        rows.emplace_back(
+            Array::New(isolate, row_values.data(), row_values.size()));
+      } else {
+        rows.emplace_back(Object::New(isolate,
+                                      Null(isolate),
+                                      keys.data(),
+                                      row_values.data(),
+                                      num_cols_));
+      }
+    }
+
+    if (kind_ == kGet) {
+      if (rows.empty() || num_cols_ == 0) return Undefined(isolate);
+      return rows[0];
+    }
+    return Array::New(isolate, rows.data(), rows.size());
+  }
+
+  Kind kind_;
+  BaseObjectPtr<Database> db_;
+  BaseObjectPtr<Statement> stmt_;
+  std::string sql_;
+  Global<Promise::Resolver> resolver_;
+  bool use_big_ints_ = false;
+  bool return_arrays_ = false;
+  std::vector<std::pair<std::string, SQLiteValue>> named_params_;
+  std::vector<SQLiteValue> anonymous_params_;
+  Database::Connection* connection_ = nullptr;
+  // Whether running the query might begin or end a transaction.
+  bool may_change_transaction_ = true;
+
+  // Results, written on the threadpool.
+  int status_ = SQLITE_OK;
+  std::string error_message_;
+  bool custom_error_ = false;
+  bool read_only_ = false;
+  bool transaction_control_ = false;
+  bool autocommit_ = true;
+  int num_cols_ = 0;
+  size_t num_rows_ = 0;
+  std::vector<std::string> column_names_;
+  std::vector<SQLiteValue> values_;
+  sqlite3_int64 changes_ = 0;
+  sqlite3_int64 last_insert_rowid_ = 0;
+
+  friend class Database;
+};
+
+int Database::Connection::Prepare(const std::string& sql,
+                                  sqlite3_stmt** stmt) {
+  auto it = statements.find(sql);
+  if (it != statements.end()) {
+    *stmt = it->second;
+    return SQLITE_OK;
+  }
+  int r = sqlite3_prepare_v3(
+      handle, sql.c_str(), -1, SQLITE_PREPARE_PERSISTENT, stmt, nullptr);
+  if (r != SQLITE_OK || *stmt == nullptr) return r;
+  if (statements.size() >= kMaxCachedStatements) {
+    sqlite3_finalize(statements.begin()->second);
+    statements.erase(statements.begin());
+  }
+  statements.emplace(sql, *stmt);
+  return SQLITE_OK;
+}
+
+void Database::Connection::Close() {
+  for (auto& [sql, stmt] : statements) sqlite3_finalize(stmt);
+  statements.clear();
+  sqlite3_close_v2(handle);
+  handle = nullptr;
+}
+
+Database::Database(Environment* env,
+                   Local<Object> object,
+                   DatabaseOpenConfiguration&& open_config,
+                   int readers)
+    : BaseObject(env, object), open_config_(std::move(open_config)) {
+  MakeWeak();
+  env->AddCleanupHook(CleanupHook, this);
+  Open(readers);
+}
+
+Database::~Database() {
+  CHECK_EQ(running_, 0);
+  env()->RemoveCleanupHook(CleanupHook, this);
+  if (writer_) writer_->Close();
+  for (auto& reader : readers_) reader->Close();
+}
+
+void Database::MemoryInfo(MemoryTracker* tracker) const {
+  tracker->TrackFieldWithSize(
+      "open_config", sizeof(open_config_), "DatabaseOpenConfiguration");
+}
+
+bool Database::Open(int readers) {
+  std::vector<std::unique_ptr<Connection>> connections;
+  for (int i = 0; i <= readers; i++) {
+    auto connection = std::make_unique<Connection>();
+    // The first connection is the writer, unless the whole database is
+    // read-only.
+    connection->read_only = i > 0 || open_config_.get_read_only();
+    int r = OpenConnection(
+        &open_config_, connection->read_only, &connection->handle);
+    if (r != SQLITE_OK) {
+      Local<Object> e;
+      if (connection->handle != nullptr &&
+          CreateSQLiteError(env()->isolate(), connection->handle)
+              .ToLocal(&e)) {
+        env()->isolate()->ThrowException(e);
+      } else {
+        THROW_ERR_SQLITE_ERROR(env()->isolate(), r);
+      }
+      connection->Close();
+      for (auto& opened : connections) opened->Close();
+      return false;
+    }
+    connections.push_back(std::move(connection));
+  }
+  writer_ = std::move(connections[0]);
+  for (size_t i = 1; i < connections.size(); i++) {
+    idle_readers_.push_back(connections[i].get());
+    readers_.push_back(std::move(connections[i]));
+  }
+  return true;
+}
+
+bool Database::IsOpen() const {
+  return writer_ != nullptr && !closing_;
+}
+
+void Database::Enqueue(AsyncQuery* query, bool read_only) {
+  if (query->may_change_transaction_) pending_transaction_changes_++;
+  if (read_only && !readers_.empty() && !in_transaction_ &&
+      pending_transaction_changes_ == 0) {
+    read_queue_.push_back(query);
+  } else {
+    write_queue_.push_back(query);
+  }
+  Dispatch();
+}
+
+void Database::Dispatch() {
+  // Queries that are still queued when the Environment is torn down are
+  // dropped by CleanupHook().
+  if (!env()->can_call_into_js()) return;
+  if (!writer_busy_ && !write_queue_.empty()) {
+    AsyncQuery* query = write_queue_.front();
+    write_queue_.pop_front();
+    writer_busy_ = true;
+    query->Start(writer_.get());
+  }
+  while (!read_queue_.empty() && !idle_readers_.empty()) {
+    AsyncQuery* query = read_queue_.front();
+    read_queue_.pop_front();
+    Connection* reader = idle_readers_.back();
+    idle_readers_.pop_back();
+    query->Start(reader);
+  }
+}
+
+void Database::Release(AsyncQuery* query) {
+  CHECK_GT(running_, 0);
+  running_--;
+  if (query->connection() == writer_.get()) {
+    writer_busy_ = false;
+    in_transaction_ = !query->autocommit_;
+    if (query->may_change_transaction_) pending_transaction_changes_--;
+  } else {
+    idle_readers_.push_back(query->connection());
+  }
+  Dispatch();
+  MaybeFinishClose();
+}
+
+void Database::CleanupHook(void* arg) {
+  Database* db = static_cast<Database*>(arg);
+  // The queries can neither run nor settle their promises anymore. Deleting
+  // them can release the last references to |db|, so it is not used again.
+  std::deque<AsyncQuery*> queued = std::move(db->write_queue_);
+  queued.insert(queued.end(), db->read_queue_.begin(), db->read_queue_.end());
+  db->write_queue_.clear();
+  db->read_queue_.clear();
+  for (AsyncQuery* query : queued) delete query;
+}
+
+void Database::MaybeFinishClose() {
+  if (!closing_ || running_ != 0 || !write_queue_.empty() ||
+      !read_queue_.empty() || writer_ == nullptr) {
+    return;
+  }
+  writer_->Close();
+  writer_.reset();
+  for (auto& reader : readers_) reader->Close();
+  readers_.clear();
+  idle_readers_.clear();
+
+  Isolate* isolate = env()->isolate();
+  HandleScope handle_scope(isolate);
+  Local<Promise::Resolver> resolver = close_resolver_.Get(isolate);
+  close_resolver_.Reset();
+  resolver->Resolve(env()->context(), Undefined(isolate)).Check();
+}
+
+static bool GetBooleanOption(Environment* env,
+                             Local<Object> options,
+                             const char* name,
+                             std::optional<bool>* out) {
+  Local<Value> value;
+  if (!options->Get(env->context(), OneByteString(env->isolate(), name))
+           .ToLocal(&value)) {
+    return false;
+  }
+  if (value->IsUndefined()) return true;
+  if (!value->IsBoolean()) {
+    THROW_ERR_INVALID_ARG_TYPE(
+        env->isolate(),
+        "The \"options.%s\" argument must be a boolean.",
+        name);
+    return false;
+  }
+  *out = value.As<Boolean>()->Value();
+  return true;
+}
+
+static bool GetIntegerOption(Environment* env,
+                             Local<Object> options,
+                             const char* name,
+                             std::optional<int>* out) {
+  Local<Value> value;
+  if (!options->Get(env->context(), OneByteString(env->isolate(), name))
+           .ToLocal(&value)) {
+    return false;
+  }
+  if (value->IsUndefined()) return true;
+  if (!value->IsInt32()) {
+    THROW_ERR_INVALID_ARG_TYPE(
+        env->isolate(),
+        "The \"options.%s\" argument must be an integer.",
+        name);
+    return false;
+  }
+  *out = value.As<Int32>()->Value();
+  return true;
+}
+
+// new Database(path[, options])
+void Database::New(const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+  if (!args.IsConstructCall()) {
+    THROW_ERR_CONSTRUCT_CALL_REQUIRED(env);
+    return;
+  }
+
+  std::optional<std::string> location =
+      ValidateDatabasePath(env, args[0], "path");
+  if (!location.has_value()) {
+    return;
+  }
+
+  DatabaseOpenConfiguration open_config(std::move(location.value()));
+  int readers = 0;
+  if (args.Length() > 1) {
+    if (!args[1]->IsObject()) {
+      THROW_ERR_INVALID_ARG_TYPE(env->isolate(),
+                                 "The \"options\" argument must be an object.");
+      return;
+    }
+    Local<Object> options = args[1].As<Object>();
+    std::optional<bool> read_only;
+    std::optional<bool> enable_foreign_keys;
+    std::optional<bool> enable_dqs;
+    std::optional<int> timeout;
+    std::optional<int> readers_option;
+    if (!GetBooleanOption(env, options, "readOnly", &read_only) ||
+        !GetBooleanOption(env,
+                          options,
+                          "enableForeignKeyConstraints",
+                          &enable_foreign_keys) ||
+        !GetBooleanOption(env,
+                          options,
+                          "enableDoubleQuotedStringLiterals",
+                          &enable_dqs) ||
+        !GetIntegerOption(env, options, "timeout", &timeout) ||
+        !GetIntegerOption(env, options, "readers", &readers_option)) {
+      return;
+    }
+    if (read_only.has_value()) open_config.set_read_only(*read_only);
+    if (enable_foreign_keys.has_value())
+      open_config.set_enable_foreign_keys(*enable_foreign_keys);
+    if (enable_dqs.has_value()) open_config.set_enable_dqs(*enable_dqs);
+    if (timeout.has_value()) open_config.set_timeout(*timeout);
+    if (readers_option.has_value()) {
+      readers = *readers_option;
+      if (readers < 0 || readers > 64) {
+        THROW_ERR_OUT_OF_RANGE(
+            env, "The \"options.readers\" argument must be >= 0 and <= 64.");
+        return;
+      }
+    }
+  }
+
+  // Each connection to an in-memory database has its own database.
+  const std::string& path = open_config.location();
+  if (readers > 0 && (path.empty() || path == ":memory:" ||
+                      path.starts_with("file::memory:"))) {
+    THROW_ERR_INVALID_ARG_VALUE(
+        env, "Reader connections are not supported for in-memory databases.");
+    return;
+  }
+
+  new Database(env, args.This(), std::move(open_config), readers);
+}
+
+void Database::IsOpenGetter(const FunctionCallbackInfo<Value>& args) {
+  Database* db;
+  ASSIGN_OR_RETURN_UNWRAP(&db, args.This());
+  args.GetReturnValue().Set(db->IsOpen());
+}
+
+// Resolves once the queries issued so far are done and the connections are
+// closed.
+void Database::Close(const FunctionCallbackInfo<Value>& args) {
+  Database* db;
+  ASSIGN_OR_RETURN_UNWRAP(&db, args.This());
+  Environment* env = Environment::GetCurrent(args);
+  THROW_AND_RETURN_ON_BAD_STATE(env, !db->IsOpen(), "database is not open");
+  Local<Promise::Resolver> resolver;
+  if (!Promise::Resolver::New(env->context()).ToLocal(&resolver)) return;
+  db->closing_ = true;
+  db->close_resolver_.Reset(env->isolate(), resolver);
+  args.GetReturnValue().Set(resolver->GetPromise());
+  db->MaybeFinishClose();
+}
+
+void Database::Prepare(const FunctionCallbackInfo<Value>& args) {
+  Database* db;
+  ASSIGN_OR_RETURN_UNWRAP(&db, args.This());
+  Environment* env = Environment::GetCurrent(args);
+  THROW_AND_RETURN_ON_BAD_STATE(env, !db->IsOpen(), "database is not open");
+
+  if (!args[0]->IsString()) {
+    THROW_ERR_INVALID_ARG_TYPE(env->isolate(),
+                               "The \"sql\" argument must be a string.");
+    return;
+  }
+
+  // The statement is compiled on the connection it first runs on, so that
+  // preparing it does not wait for the queries in flight.
+  Utf8Value sql(env->isolate(), args[0].As<String>());
+  BaseObjectPtr<Statement> stmt =
+      Statement::Create(env, BaseObjectPtr<Database>(db), sql.ToString());
+  if (stmt) args.GetReturnValue().Set(stmt->object());
+}
+
+void Database::Exec(const FunctionCallbackInfo<Value>& args) {
+  Database* db;
+  ASSIGN_OR_RETURN_UNWRAP(&db, args.This());
+  Environment* env = Environment::GetCurrent(args);
+  THROW_AND_RETURN_ON_BAD_STATE(env, !db->IsOpen(), "database is not open");
+
+  if (!args[0]->IsString()) {
+    THROW_ERR_INVALID_ARG_TYPE(env->isolate(),
+                               "The \"sql\" argument must be a string.");
+    return;
+  }
+
+  Local<Promise::Resolver> resolver;
+  if (!Promise::Resolver::New(env->context()).ToLocal(&resolver)) return;
+  Utf8Value sql(env->isolate(), args[0].As<String>());
+  auto query = std::make_unique<AsyncQuery>(env,
+                                            AsyncQuery::kExec,
+                                            BaseObjectPtr<Database>(db),
+                                            BaseObjectPtr<Statement>(),
+                                            sql.ToString(),
+                                            resolver);
+  db->Enqueue(query.release(), false);
+  args.GetReturnValue().Set(resolver->GetPromise());
+}
+
+Statement::Statement(Environment* env,
+                     Local<Object> object,
+                     BaseObjectPtr<Database> db,
+                     std::string&& sql)
+    : BaseObject(env, object), db_(std::move(db)), sql_(std::move(sql)) {
+  MakeWeak();
+}
+
+void Statement::MemoryInfo(MemoryTracker* tracker) const {
+  tracker->TrackField("sql", sql_);
+}
+
+void Statement::RunQuery(const FunctionCallbackInfo<Value>& args, int kind) {
+  Statement* stmt;
+  ASSIGN_OR_RETURN_UNWRAP(&stmt, args.This());
+  Environment* env = Environment::GetCurrent(args);
+  THROW_AND_RETURN_ON_BAD_STATE(
+      env, !stmt->db_->IsOpen(), "database is not open");
+
+  Local<Promise::Resolver> resolver;
+  if (!Promise::Resolver::New(env->context()).ToLocal(&resolver)) return;
+  auto query = std::make_unique<AsyncQuery>(env,
+                                            static_cast<AsyncQuery::Kind>(kind),
+                                            stmt->db_,
+                                            BaseObjectPtr<Statement>(stmt),
+                                            std::string(stmt->sql_),
+                                            resolver);
+  if (!query->SetParams(args)) return;
+  stmt->db_->Enqueue(query.release(), stmt->read_only_);
+  args.GetReturnValue().Set(resolver->GetPromise());
+}
+
+void Statement::All(const FunctionCallbackInfo<Value>& args) {
+  RunQuery(args, AsyncQuery::kAll);
+}
+
+void Statement::Get(const FunctionCallbackInfo<Value>& args) {
+  RunQuery(args, AsyncQuery::kGet);
+}
+
+void Statement::Run(const FunctionCallbackInfo<Value>& args) {
+  RunQuery(args, AsyncQuery::kRun);
+}
+
+void Statement::SourceSQLGetter(const FunctionCallbackInfo<Value>& args) {
+  Statement* stmt;
+  ASSIGN_OR_RETURN_UNWRAP(&stmt, args.This());
+  Local<String> sql;
+  if (String::NewFromUtf8(args.GetIsolate(),
+                          stmt->sql_.data(),
+                          NewStringType::kNormal,
+                          stmt->sql_.size())
+          .ToLocal(&sql)) {
+    args.GetReturnValue().Set(sql);
+  }
+}
+
+void Statement::SetReadBigInts(const FunctionCallbackInfo<Value>& args) {
+  Statement* stmt;
+  ASSIGN_OR_RETURN_UNWRAP(&stmt, args.This());
+  Environment* env = Environment::GetCurrent(args);
+  if (!args[0]->IsBoolean()) {
+    THROW_ERR_INVALID_ARG_TYPE(
+        env->isolate(), "The \"readBigInts\" argument must be a boolean.");
+    return;
+  }
+  stmt->use_big_ints_ = args[0]->IsTrue();
+}
+
+void Statement::SetReturnArrays(const FunctionCallbackInfo<Value>& args) {
+  Statement* stmt;
+  ASSIGN_OR_RETURN_UNWRAP(&stmt, args.This());
+  Environment* env = Environment::GetCurrent(args);
+  if (!args[0]->IsBoolean()) {
+    THROW_ERR_INVALID_ARG_TYPE(
+        env->isolate(), "The \"returnArrays\" argument must be a boolean.");
+    return;
+  }
+  stmt->return_arrays_ = args[0]->IsTrue();
+}
+
+Local<FunctionTemplate> Statement::GetConstructorTemplate(Environment* env) {
+  Local<FunctionTemplate> tmpl = env->sqlite_statement_constructor_template();
+  if (tmpl.IsEmpty()) {
+    Isolate* isolate = env->isolate();
+    tmpl = NewFunctionTemplate(isolate, IllegalConstructor);
+    tmpl->SetClassName(FIXED_ONE_BYTE_STRING(isolate, "Statement"));
+    tmpl->InstanceTemplate()->SetInternalFieldCount(
+        Statement::kInternalFieldCount);
+    SetProtoMethod(isolate, tmpl, "all", Statement::All);
+    SetProtoMethod(isolate, tmpl, "get", Statement::Get);
+    SetProtoMethod(isolate, tmpl, "run", Statement::Run);
+    SetSideEffectFreeGetter(isolate,
+                            tmpl,
+                            FIXED_ONE_BYTE_STRING(isolate, "sourceSQL"),
+                            Statement::SourceSQLGetter);
+    SetProtoMethod(isolate, tmpl, "setReadBigInts", Statement::SetReadBigInts);
+    SetProtoMethod(
+        isolate, tmpl, "setReturnArrays", Statement::SetReturnArrays);
+    env->set_sqlite_statement_constructor_template(tmpl);
+  }
+  return tmpl;
+}
+
+BaseObjectPtr<Statement> Statement::Create(Environment* env,
+                                           BaseObjectPtr<Database> db,
+                                           std::string&& sql) {
+  Local<Object> obj;
+  if (!GetConstructorTemplate(env)
+           ->InstanceTemplate()
+           ->NewInstance(env->context())
+           .ToLocal(&obj)) {
+    return nullptr;
+  }
+
+  return MakeBaseObject<Statement>(env, obj, std::move(db), std::move(sql));
+}
+
+void DefineConstants(Local<Object> target) {
+  NODE_DEFINE_CONSTANT(target, SQLITE_CHANGESET_OMIT);
+  NODE_DEFINE_CONSTANT(target, SQLITE_CHANGESET_REPLACE);
+  NODE_DEFINE_CONSTANT(target, SQLITE_CHANGESET_ABORT);
+
+  NODE_DEFINE_CONSTANT(target, SQLITE_CHANGESET_DATA);
+  NODE_DEFINE_CONSTANT(target, SQLITE_CHANGESET_NOTFOUND);
+  NODE_DEFINE_CONSTANT(target, SQLITE_CHANGESET_CONFLICT);
+  NODE_DEFINE_CONSTANT(target, SQLITE_CHANGESET_CONSTRAINT);
+  NODE_DEFINE_CONSTANT(target, SQLITE_CHANGESET_FOREIGN_KEY);
+}
+
+static void Initialize(Local<Object> target,
+                       Local<Value> unused,
+                       Local<Context> context,
+                       void* priv) {
+  Environment* env = Environment::GetCurrent(context);
+  Isolate* isolate = env->isolate();
+  Local<FunctionTemplate> db_tmpl =
+      NewFunctionTemplate(isolate, DatabaseSync::New);
+  db_tmpl->InstanceTemplate()->SetInternalFieldCount(
+      DatabaseSync::kInternalFieldCount);
+  Local<Object> constants = Object::New(isolate);
+
+  DefineConstants(constants);
+
+  SetProtoMethod(isolate, db_tmpl, "open", DatabaseSync::Open);
+  SetProtoMethod(isolate, db_tmpl, "close", DatabaseSync::Close);
   SetProtoDispose(isolate, db_tmpl, DatabaseSync::Dispose);
   SetProtoMethod(isolate, db_tmpl, "prepare", DatabaseSync::Prepare);
   SetProtoMethod(isolate, db_tmpl, "exec", DatabaseSync::Exec);
@@ -2691,6 +4088,10 @@ static void Initialize(Local<Object> target,
                  DatabaseSync::EnableLoadExtension);
   SetProtoMethod(
       isolate, db_tmpl, "loadExtension", DatabaseSync::LoadExtension);
+  SetProtoMethodNoSideEffect(isolate,
+                             db_tmpl,
+                             "statementCacheStats",
+                             DatabaseSync::StatementCacheStats);
   SetSideEffectFreeGetter(isolate,
                           db_tmpl,
                           FIXED_ONE_BYTE_STRING(isolate, "isOpen"),
@@ -2707,6 +4108,21 @@ static void Initialize(Local<Object> target,
   SetConstructorFunction(
       context, target, "Session", Session::GetConstructorTemplate(env));
 
+  Local<FunctionTemplate> async_db_tmpl =
+      NewFunctionTemplate(isolate, Database::New);
+  async_db_tmpl->InstanceTemplate()->SetInternalFieldCount(
+      Database::kInternalFieldCount);
+  SetProtoMethod(isolate, async_db_tmpl, "close", Database::Close);
+  SetProtoMethod(isolate, async_db_tmpl, "prepare", Database::Prepare);
+  SetProtoMethod(isolate, async_db_tmpl, "exec", Database::Exec);
+  SetSideEffectFreeGetter(isolate,
+                          async_db_tmpl,
+                          FIXED_ONE_BYTE_STRING(isolate, "isOpen"),
+                          Database::IsOpenGetter);
+  SetConstructorFunction(context, target, "Database", async_db_tmpl);
+  SetConstructorFunction(
+      context, target, "Statement", Statement::GetConstructorTemplate(env));
+
   target->Set(context, env->constants_string(), constants).Check();
 
   Local<Function> backup_function;
@@ -8,8 +8,16 @@
 #include "sqlite3.h"
 #include "util.h"
 
+#include <deque>
+#include <list>
 #include <map>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
 #include <unordered_set>
+#include <variant>
+#include <vector>
 
 namespace node {
 namespace sqlite {
@@ -39,12 +47,21 @@ class DatabaseOpenConfiguration {
 
   inline int get_timeout() { return timeout_; }
 
+  inline void set_statement_cache_size(size_t size) {
+    statement_cache_size_ = size;
+  }
+
+  inline size_t get_statement_cache_size() const {
+    return statement_cache_size_;
+  }
+
  private:
   std::string location_;
   bool read_only_ = false;
   bool enable_foreign_keys_ = true;
   bool enable_dqs_ = false;
   int timeout_ = 0;
+  size_t statement_cache_size_ = 0;
 };
 
 class StatementSync;
@@ -76,11 +93,17 @@ class DatabaseSync : public BaseObject {
   static void EnableLoadExtension(
       const v8::FunctionCallbackInfo<v8::Value>& args);
   static void LoadExtension(const v8::FunctionCallbackInfo<v8::Value>& args);
+  static void StatementCacheStats(
+      const v8::FunctionCallbackInfo<v8::Value>& args);
   void FinalizeStatements();
   void RemoveBackup(BackupJob* backup);
   void AddBackup(BackupJob* backup);
   void FinalizeBackups();
   void UntrackStatement(StatementSync* statement);
+  // Keeps |stmt|, which prepare() compiled from |sql| and no StatementSync
+  // uses anymore, for a later prepare() of the same SQL. Returns false if
+  // the caller should finalize it instead.
+  bool CacheStatement(std::string sql, sqlite3_stmt* stmt);
   bool IsOpen();
   sqlite3* Connection();
 
@@ -109,6 +132,17 @@ class DatabaseSync : public BaseObject {
   std::set<sqlite3_session*> sessions_;
   std::unordered_set<StatementSync*> statements_;
 
+  // Compiled statements that prepare() can wrap in a new StatementSync,
+  // most recently used first, when options.statementCacheSize is not zero.
+  // A statement is only cached while no StatementSync uses it, so that
+  // every StatementSync has a statement and options of its own.
+  using StatementCacheEntry = std::pair<std::string, sqlite3_stmt*>;
+  std::list<StatementCacheEntry> statement_cache_;
+  std::unordered_map<std::string_view, std::list<StatementCacheEntry>::iterator>
+      statement_cache_index_;
+  uint64_t statement_cache_hits_ = 0;
+  uint64_t statement_cache_misses_ = 0;
+
   friend class Session;
 };
 
@@ -125,9 +159,11 @@ class StatementSync : public BaseObject {
                                              BaseObjectPtr<DatabaseSync> db,
                                              sqlite3_stmt* stmt);
   static void All(const v8::FunctionCallbackInfo<v8::Value>& args);
+  static void AllColumnar(const v8::FunctionCallbackInfo<v8::Value>& args);
   static void Iterate(const v8::FunctionCallbackInfo<v8::Value>& args);
   static void Get(const v8::FunctionCallbackInfo<v8::Value>& args);
   static void Run(const v8::FunctionCallbackInfo<v8::Value>& args);
+  static void RunMany(const v8::FunctionCallbackInfo<v8::Value>& args);
   static void Columns(const v8::FunctionCallbackInfo<v8::Value>& args);
   static void SourceSQLGetter(const v8::FunctionCallbackInfo<v8::Value>& args);
   static void ExpandedSQLGetter(
@@ -140,6 +176,9 @@ class StatementSync : public BaseObject {
   static void SetReturnArrays(const v8::FunctionCallbackInfo<v8::Value>& args);
   void Finalize();
   bool IsFinalized();
+  // Makes the destructor hand the statement back to the statement cache of
+  // the database, under |sql|, instead of finalizing it.
+  void set_cache_key(std::string sql) { cache_key_ = std::move(sql); }
 
   SET_MEMORY_INFO_NAME(StatementSync)
   SET_SELF_SIZE(StatementSync)
@@ -153,10 +192,25 @@ class StatementSync : public BaseObject {
   bool allow_bare_named_params_;
   bool allow_unknown_named_params_;
   std::optional<std::map<std::string, std::string>> bare_named_params_;
-  bool BindParams(const v8::FunctionCallbackInfo<v8::Value>& args);
+  // Empty unless the statement came from, or goes to, the statement cache.
+  std::string cache_key_;
+  // |args| is a FunctionCallbackInfo, or anything else with Length() and
+  // operator[] that behave the same way.
+  template <typename Args>
+  bool BindParams(const Args& args);
   bool BindValue(const v8::Local<v8::Value>& value, const int index);
   v8::MaybeLocal<v8::Value> ColumnToValue(const int column);
   v8::MaybeLocal<v8::Name> ColumnNameToName(const int column);
+  // Returns the current row as an array or as an object, depending on
+  // return_arrays_.
+  v8::MaybeLocal<v8::Value> RowToValue(int num_cols);
+  v8::MaybeLocal<v8::Object> RowTemplate(int num_cols);
+
+  // Interned column names, and an object with these properties that row
+  // objects are cloned from.
+  std::vector<v8::Global<v8::Name>> column_names_;
+  std::vector<std::string> column_name_strings_;
+  v8::Global<v8::Object> row_template_;
 
   friend class StatementSyncIterator;
 };
@@ -212,6 +266,123 @@ class Session : public BaseObject {
   BaseObjectWeakPtr<DatabaseSync> database_;  // The Parent Database
 };
 
+// A value bound to, or read from, a statement run on the threadpool. Values
+// are converted from and to JavaScript on the main thread.
+using SQLiteValue = std::variant<std::monostate,  // NULL
+                                 sqlite3_int64,
+                                 double,
+                                 std::string,
+                                 std::vector<uint8_t>>;
+
+class AsyncQuery;
+class Statement;
+
+// The asynchronous counterpart of DatabaseSync. Queries run on the threadpool
+// and resolve promises. Each connection runs one query at a time; queries on
+// the same connection run in the order in which they were issued. Read-only
+// statements can additionally be spread over a pool of read-only connections,
+// which only makes sense for databases in WAL mode.
+class Database : public BaseObject {
+ public:
+  // A connection, and the statements prepared on it. Only accessed by the
+  // query that currently owns the connection.
+  struct Connection {
+    sqlite3* handle = nullptr;
+    bool read_only = false;
+    std::unordered_map<std::string, sqlite3_stmt*> statements;
+
+    // Returns the cached statement for |sql|, preparing it if needed.
+    int Prepare(const std::string& sql, sqlite3_stmt** stmt);
+    void Close();
+  };
+
+  Database(Environment* env,
+           v8::Local<v8::Object> object,
+           DatabaseOpenConfiguration&& open_config,
+           int readers);
+  void MemoryInfo(MemoryTracker* tracker) const override;
+  static void New(const v8::FunctionCallbackInfo<v8::Value>& args);
+  static void Close(const v8::FunctionCallbackInfo<v8::Value>& args);
+  static void Prepare(const v8::FunctionCallbackInfo<v8::Value>& args);
+  static void Exec(const v8::FunctionCallbackInfo<v8::Value>& args);
+  static void IsOpenGetter(const v8::FunctionCallbackInfo<v8::Value>& args);
+
+  bool IsOpen() const;
+  // Queues |query|, which is run on a reader connection if |read_only| is
+  // true and there are any.
+  void Enqueue(AsyncQuery* query, bool read_only);
+  // Called on the main thread when |query| is done with its connection.
+  void Release(AsyncQuery* query);
+
+  SET_MEMORY_INFO_NAME(Database)
+  SET_SELF_SIZE(Database)
+
+ private:
+  ~Database() override;
+  bool Open(int readers);
+  void Dispatch();
+  void MaybeFinishClose();
+  static void CleanupHook(void* arg);
+
+  DatabaseOpenConfiguration open_config_;
+  std::unique_ptr<Connection> writer_;
+  std::vector<std::unique_ptr<Connection>> readers_;
+  std::vector<Connection*> idle_readers_;
+  bool writer_busy_ = false;
+  // Whether the writer is inside an explicit transaction, in which case
+  // reads go to the writer so that they see the uncommitted changes. Reads
+  // also go to the writer while a query that might begin a transaction is
+  // queued or running on it.
+  bool in_transaction_ = false;
+  size_t pending_transaction_changes_ = 0;
+  std::deque<AsyncQuery*> write_queue_;
+  std::deque<AsyncQuery*> read_queue_;
+  size_t running_ = 0;
+  bool closing_ = false;
+  v8::Global<v8::Promise::Resolver> close_resolver_;
+
+  friend class AsyncQuery;
+};
+
+class Statement : public BaseObject {
+ public:
+  Statement(Environment* env,
+            v8::Local<v8::Object> object,
+            BaseObjectPtr<Database> db,
+            std::string&& sql);
+  void MemoryInfo(MemoryTracker* tracker) const override;
+  static v8::Local<v8::FunctionTemplate> GetConstructorTemplate(
+      Environment* env);
+  static BaseObjectPtr<Statement> Create(Environment* env,
+                                         BaseObjectPtr<Database> db,
+                                         std::string&& sql);
+  static void All(const v8::FunctionCallbackInfo<v8::Value>& args);
+  static void Get(const v8::FunctionCallbackInfo<v8::Value>& args);
+  static void Run(const v8::FunctionCallbackInfo<v8::Value>& args);
+  static void SourceSQLGetter(const v8::FunctionCallbackInfo<v8::Value>& args);
+  static void SetReadBigInts(const v8::FunctionCallbackInfo<v8::Value>& args);
+  static void SetReturnArrays(const v8::FunctionCallbackInfo<v8::Value>& args);
+
+  SET_MEMORY_INFO_NAME(Statement)
+  SET_SELF_SIZE(Statement)
+
+ private:
+  ~Statement() override = default;
+  static void RunQuery(const v8::FunctionCallbackInfo<v8::Value>& args,
+                       int kind);
+
+  BaseObjectPtr<Database> db_;
+  std::string sql_;
+  bool use_big_ints_ = false;
+  bool return_arrays_ = false;
+  // Learned the first time the statement is prepared. Until then, it runs
+  // on the writer connection, and might begin or end a transaction.
+  bool read_only_ = false;
+  bool transaction_control_ = true;
+
+  friend class AsyncQuery;
+};
+
 class UserDefinedFunction {
  public:
   UserDefinedFunction(Environment* env,
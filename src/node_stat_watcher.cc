@@ -26,6 +26,7 @@
 #include "node_external_reference.h"
 #include "node_file-inl.h"
 #include "permission/permission.h"
+#include "threadpoolwork-inl.h"
 #include "util-inl.h"
 
 #include <cstring>
@@ -64,18 +65,35 @@ void StatWatcher::RegisterExternalReferences(
   registry->Register(StatWatcher::Start);
 }
 
+static bool UseSharedPolling(fs::BindingData* binding_data) {
+  return binding_data->env()->options()->shared_stat_polling;
+}
+
 StatWatcher::StatWatcher(fs::BindingData* binding_data,
                          Local<Object> wrap,
                          bool use_bigint)
     : HandleWrap(binding_data->env(),
                  wrap,
-                 reinterpret_cast<uv_handle_t*>(&watcher_),
+                 UseSharedPolling(binding_data)
+                     ? reinterpret_cast<uv_handle_t*>(&keep_alive_)
+                     : reinterpret_cast<uv_handle_t*>(&watcher_),
                  AsyncWrap::PROVIDER_STATWATCHER),
       use_bigint_(use_bigint),
       binding_data_(binding_data) {
-  CHECK_EQ(0, uv_fs_poll_init(env()->event_loop(), &watcher_));
+  if (UseSharedPolling(binding_data)) {
+    CHECK_EQ(0, uv_timer_init(env()->event_loop(), &keep_alive_));
+  } else {
+    CHECK_EQ(0, uv_fs_poll_init(env()->event_loop(), &watcher_));
+  }
 }
 
+void StatWatcher::Close(Local<Value> close_callback) {
+  if (poller_) {
+    poller_->Remove(poll_id_);
+    poller_.reset();
+  }
+  HandleWrap::Close(close_callback);
+}
 
 void StatWatcher::Callback(uv_fs_poll_t* handle,
                            int status,
@@ -85,14 +103,18 @@ void StatWatcher::Callback(uv_fs_poll_t* handle,
   Environment* env = wrap->env();
   HandleScope handle_scope(env->isolate());
   Context::Scope context_scope(env->context());
+  wrap->OnChange(status, prev, curr);
+}
 
-  Local<Value> arr = fs::FillGlobalStatsArray(
-      wrap->binding_data_.get(), wrap->use_bigint_, curr);
-  USE(fs::FillGlobalStatsArray(
-      wrap->binding_data_.get(), wrap->use_bigint_, prev, true));
+void StatWatcher::OnChange(int status,
+                           const uv_stat_t* prev,
+                           const uv_stat_t* curr) {
+  Local<Value> arr =
+      fs::FillGlobalStatsArray(binding_data_.get(), use_bigint_, curr);
+  USE(fs::FillGlobalStatsArray(binding_data_.get(), use_bigint_, prev, true));
 
-  Local<Value> argv[2] = { Integer::New(env->isolate(), status), arr };
-  wrap->MakeCallback(env->onchange_string(), arraysize(argv), argv);
+  Local<Value> argv[2] = { Integer::New(env()->isolate(), status), arr };
+  MakeCallback(env()->onchange_string(), arraysize(argv), argv);
 }
 
 
@@ -120,6 +142,16 @@ void StatWatcher::Start(const FunctionCallbackInfo<Value>& args) {
   CHECK(args[1]->IsUint32());
   const uint32_t interval = args[1].As<Uint32>()->Value();
 
+  if (UseSharedPolling(wrap->binding_data_.get())) {
+    wrap->poller_ = StatPoller::Get(wrap->binding_data_.get(), interval);
+    wrap->poll_id_ = wrap->poller_->Add(wrap, *path);
+    // The timeout is clamped to the largest time libuv can represent.
+    CHECK_EQ(0,
+             uv_timer_start(
+                 &wrap->keep_alive_, [](uv_timer_t*) {}, UINT64_MAX, 0));
+    return;
+  }
+
   // Note that uv_fs_poll_start does not return ENOENT, we are handling
   // mostly memory errors here.
   const int err = uv_fs_poll_start(&wrap->watcher_, Callback, *path, interval);
@@ -128,4 +160,130 @@ void StatWatcher::Start(const FunctionCallbackInfo<Value>& args) {
   }
 }
 
+std::shared_ptr<StatPoller> StatPoller::Get(fs::BindingData* binding_data,
+                                            uint32_t interval) {
+  std::weak_ptr<StatPoller>& slot = binding_data->stat_pollers[interval];
+  std::shared_ptr<StatPoller> poller = slot.lock();
+  if (!poller) {
+    poller = std::make_shared<StatPoller>(binding_data->env(), interval);
+    slot = poller;
+  }
+  return poller;
+}
+
+StatPoller::StatPoller(Environment* env, uint32_t interval)
+    : ThreadPoolWork(env, "statpoller", ThreadPoolWorkClass::kFs),
+      interval_(interval),
+      timer_(new uv_timer_t()) {
+  CHECK_EQ(0, uv_timer_init(env->event_loop(), timer_));
+  timer_->data = this;
+  // The watchers keep the event loop alive, if they are ref()ed.
+  uv_unref(reinterpret_cast<uv_handle_t*>(timer_));
+}
+
+StatPoller::~StatPoller() {
+  env()->CloseHandle(timer_, [](uv_timer_t* timer) { delete timer; });
+}
+
+uint64_t StatPoller::Add(StatWatcher* watcher, std::string path) {
+  uint64_t id = next_id_++;
+  entries_.emplace(id, Entry{watcher, std::move(path)});
+  // Like uv_fs_poll_start(), take the first stat right away. Watchers that
+  // are added while a job runs are picked up by the next one.
+  if (!uv_is_active(reinterpret_cast<uv_handle_t*>(timer_))) {
+    CHECK_EQ(0, uv_timer_start(timer_, OnTimer, 0, interval_));
+  }
+  return id;
+}
+
+void StatPoller::Remove(uint64_t id) {
+  entries_.erase(id);
+  if (entries_.empty()) uv_timer_stop(timer_);
+}
+
+void StatPoller::OnTimer(uv_timer_t* timer) {
+  static_cast<StatPoller*>(timer->data)->Poll();
+}
+
+void StatPoller::Poll() {
+  // Skip a round rather than queueing up jobs when stat()ing all the files
+  // takes longer than the interval.
+  if (self_) return;
+  jobs_.clear();
+  jobs_.reserve(entries_.size());
+  for (const auto& [id, entry] : entries_) jobs_.push_back({id, entry.path});
+  self_ = shared_from_this();
+  ScheduleWork();
+}
+
+void StatPoller::DoThreadPoolWork() {
+  for (Job& job : jobs_) {
+    uv_fs_t req;
+    job.status = uv_fs_stat(nullptr, &req, job.path.c_str(), nullptr);
+    if (job.status == 0) job.stat = req.statbuf;
+    uv_fs_req_cleanup(&req);
+  }
+}
+
+// Same as the comparison that uv_fs_poll_t makes.
+static bool StatsAreEqual(const uv_stat_t& a, const uv_stat_t& b) {
+  return a.st_ctim.tv_nsec == b.st_ctim.tv_nsec &&
+         a.st_mtim.tv_nsec == b.st_mtim.tv_nsec &&
+         a.st_birthtim.tv_nsec == b.st_birthtim.tv_nsec &&
+         a.st_ctim.tv_sec == b.st_ctim.tv_sec &&
+         a.st_mtim.tv_sec == b.st_mtim.tv_sec &&
+         a.st_birthtim.tv_sec == b.st_birthtim.tv_sec &&
+         a.st_size == b.st_size && a.st_mode == b.st_mode &&
+         a.st_uid == b.st_uid && a.st_gid == b.st_gid &&
+         a.st_ino == b.st_ino && a.st_dev == b.st_dev &&
+         a.st_flags == b.st_flags && a.st_gen == b.st_gen;
+}
+
+void StatPoller::AfterThreadPoolWork(int status) {
+  // This may be the last reference, once the callbacks closed the watchers.
+  std::shared_ptr<StatPoller> self = std::move(self_);
+  if (status != 0) return;
+
+  struct Change {
+    uint64_t id;
+    int status;
+    uv_stat_t prev;
+    uv_stat_t curr;
+  };
+  std::vector<Change> changes;
+  static const uv_stat_t kZeroStat{};
+  for (const Job& job : jobs_) {
+    auto it = entries_.find(job.id);
+    if (it == entries_.end()) continue;
+    Entry& entry = it->second;
+    if (job.status != 0) {
+      if (entry.state != job.status) {
+        changes.push_back({job.id, job.status, entry.stat, kZeroStat});
+        entry.state = job.status;
+      }
+      continue;
+    }
+    if (entry.state < 0 ||
+        (entry.state != 0 && !StatsAreEqual(entry.stat, job.stat))) {
+      changes.push_back({job.id, 0, entry.stat, job.stat});
+    }
+    entry.stat = job.stat;
+    entry.state = 1;
+  }
+  jobs_.clear();
+  if (changes.empty()) return;
+
+  Environment* env = this->env();
+  HandleScope handle_scope(env->isolate());
+  Context::Scope context_scope(env->context());
+  CallbackBatchScope batch_scope(
+      env, entries_.at(changes.front().id).watcher->object());
+  for (const Change& change : changes) {
+    // A previous callback may have closed the watcher.
+    auto it = entries_.find(change.id);
+    if (it == entries_.end()) continue;
+    it->second.watcher->OnChange(change.status, &change.prev, &change.curr);
+  }
+}
+
 }  // namespace node
@@ -26,9 +26,15 @@
 
 #include "node.h"
 #include "handle_wrap.h"
+#include "node_internals.h"
 #include "uv.h"
 #include "v8.h"
 
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
 namespace node {
 namespace fs {
 class BindingData;
@@ -36,6 +42,7 @@ class BindingData;
 
 class Environment;
 class ExternalReferenceRegistry;
+class StatPoller;
 
 class StatWatcher : public HandleWrap {
  public:
@@ -43,6 +50,9 @@ class StatWatcher : public HandleWrap {
                                          v8::Local<v8::ObjectTemplate> ctor);
   static void RegisterExternalReferences(ExternalReferenceRegistry* registry);
 
+  void Close(
+      v8::Local<v8::Value> close_callback = v8::Local<v8::Value>()) override;
+
  protected:
   StatWatcher(fs::BindingData* binding_data,
               v8::Local<v8::Object> wrap,
@@ -56,16 +66,80 @@ class StatWatcher : public HandleWrap {
   SET_SELF_SIZE(StatWatcher)
 
  private:
+  friend class StatPoller;
+
   static void Callback(uv_fs_poll_t* handle,
                        int status,
                        const uv_stat_t* prev,
                        const uv_stat_t* curr);
+  void OnChange(int status, const uv_stat_t* prev, const uv_stat_t* curr);
 
+  // Each watcher polls with its own watcher_, unless --shared-stat-polling
+  // is set. Then a StatPoller does the polling, and the handle of the
+  // watcher is keep_alive_, a timer that never fires, so that ref(), unref()
+  // and close() keep working as before.
   uv_fs_poll_t watcher_;
+  uv_timer_t keep_alive_;
+  std::shared_ptr<StatPoller> poller_;
+  uint64_t poll_id_ = 0;
   const bool use_bigint_;
   BaseObjectPtr<fs::BindingData> binding_data_;
 };
 
+// Polls the files of all StatWatchers of a realm that use the same interval,
+// stat()ing them in a single threadpool job per interval. Changes are
+// reported the same way as uv_fs_poll_t does, and the callbacks for the
+// changes found by a job are delivered together.
+class StatPoller final : public ThreadPoolWork,
+                         public std::enable_shared_from_this<StatPoller> {
+ public:
+  static std::shared_ptr<StatPoller> Get(fs::BindingData* binding_data,
+                                         uint32_t interval);
+
+  StatPoller(Environment* env, uint32_t interval);
+  ~StatPoller() override;
+  StatPoller(const StatPoller&) = delete;
+  StatPoller& operator=(const StatPoller&) = delete;
+
+  // Returns an id to remove the watcher with.
+  uint64_t Add(StatWatcher* watcher, std::string path);
+  void Remove(uint64_t id);
+
+  void DoThreadPoolWork() override;
+  void AfterThreadPoolWork(int status) override;
+
+  size_t size() const { return entries_.size(); }
+
+ private:
+  struct Entry {
+    StatWatcher* watcher;
+    std::string path;
+    uv_stat_t stat{};
+    // Like uv_fs_poll_t: 0 before the first poll, 1 after a successful one,
+    // and the error code after a failed one.
+    int state = 0;
+  };
+  struct Job {
+    uint64_t id;
+    std::string path;
+    uv_stat_t stat{};
+    int status = 0;
+  };
+
+  static void OnTimer(uv_timer_t* timer);
+  void Poll();
+
+  const uint32_t interval_;
+  uv_timer_t* timer_;
+  uint64_t next_id_ = 1;
+  std::unordered_map<uint64_t, Entry> entries_;
+  // The stats of the current job. Only the threadpool touches it while the
+  // job runs.
+  std::vector<Job> jobs_;
+  // Keeps this alive while a job runs.
+  std::shared_ptr<StatPoller> self_;
+};
+
 }  // namespace node
 
 #endif  // defined(NODE_WANT_INTERNALS) && NODE_WANT_INTERNALS
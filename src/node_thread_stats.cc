@@ -0,0 +1,212 @@
+#include "node_thread_stats.h"
+#include "node_mutex.h"
+#include "uv.h"
+
+#include <cerrno>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+
+#if defined(__linux__)
+#include <dirent.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace node {
+namespace thread_stats {
+
+namespace {
+Mutex thread_kinds_mutex;
+// Guarded by thread_kinds_mutex.
+std::unordered_map<int, ThreadKind> thread_kinds;
+
+bool ParseNumber(std::string_view* text, double* out) {
+  while (!text->empty() && (text->front() == ' ' || text->front() == '\t'))
+    text->remove_prefix(1);
+  size_t digits = 0;
+  double value = 0;
+  while (digits < text->size() && (*text)[digits] >= '0' &&
+         (*text)[digits] <= '9') {
+    value = value * 10 + ((*text)[digits] - '0');
+    digits++;
+  }
+  if (digits == 0) return false;
+  text->remove_prefix(digits);
+  *out = value;
+  return true;
+}
+}  // namespace
+
+void SetCurrentThreadKind(ThreadKind kind) {
+  int tid = GetCurrentThreadId();
+  if (tid == -1) return;
+  Mutex::ScopedLock lock(thread_kinds_mutex);
+  thread_kinds[tid] = kind;
+}
+
+void ClearCurrentThreadKind() {
+  int tid = GetCurrentThreadId();
+  if (tid == -1) return;
+  Mutex::ScopedLock lock(thread_kinds_mutex);
+  thread_kinds.erase(tid);
+}
+
+int GetCurrentThreadId() {
+#if defined(__linux__)
+  return static_cast<int>(syscall(SYS_gettid));
+#else
+  return -1;
+#endif
+}
+
+bool ParseStat(std::string_view stat,
+               double ticks_per_second,
+               ThreadUsage* usage) {
+  // The name, which comes second, is in parentheses and may contain any
+  // character, so skip to the last closing one. The state follows it, then
+  // ten other fields before utime and stime.
+  size_t end = stat.rfind(')');
+  if (end == std::string_view::npos || end + 2 > stat.size()) return false;
+  stat.remove_prefix(end + 2);
+  size_t state_end = stat.find(' ');
+  if (state_end == std::string_view::npos) return false;
+  stat.remove_prefix(state_end);
+  double value;
+  for (int i = 0; i < 10; i++) {
+    if (!ParseNumber(&stat, &value)) {
+      // ppid, pgrp, session and tty_nr may be negative.
+      if (stat.empty() || stat.front() != '-') return false;
+      stat.remove_prefix(1);
+      if (!ParseNumber(&stat, &value)) return false;
+    }
+  }
+  double utime;
+  double stime;
+  if (!ParseNumber(&stat, &utime) || !ParseNumber(&stat, &stime))
+    return false;
+  usage->user += utime * 1e6 / ticks_per_second;
+  usage->system += stime * 1e6 / ticks_per_second;
+  return true;
+}
+
+bool ParseStatus(std::string_view status, ThreadUsage* usage) {
+  static constexpr std::string_view kVoluntary = "voluntary_ctxt_switches:";
+  static constexpr std::string_view kInvoluntary =
+      "nonvoluntary_ctxt_switches:";
+  bool found_voluntary = false;
+  bool found_involuntary = false;
+  while (!status.empty()) {
+    size_t line_end = status.find('\n');
+    std::string_view line = status.substr(0, line_end);
+    status.remove_prefix(line_end == std::string_view::npos ? status.size()
+                                                             : line_end + 1);
+    double value;
+    if (line.substr(0, kVoluntary.size()) == kVoluntary) {
+      line.remove_prefix(kVoluntary.size());
+      if (!ParseNumber(&line, &value)) return false;
+      usage->voluntary_switches += value;
+      found_voluntary = true;
+    } else if (line.substr(0, kInvoluntary.size()) == kInvoluntary) {
+      line.remove_prefix(kInvoluntary.size());
+      if (!ParseNumber(&line, &value)) return false;
+      usage->involuntary_switches += value;
+      found_involuntary = true;
+    }
+  }
+  return found_voluntary && found_involuntary;
+}
+
+#if defined(__linux__)
+static bool ReadFile(const std::string& path, std::string* contents) {
+  std::ifstream file(path);
+  if (!file) return false;
+  std::ostringstream stream;
+  stream << file.rdbuf();
+  *contents = stream.str();
+  return true;
+}
+
+static int ReadThreadUsage(const std::string& dir,
+                           std::string* name,
+                           ThreadUsage* usage) {
+  static const double ticks_per_second = sysconf(_SC_CLK_TCK);
+  std::string stat;
+  std::string status;
+  // The thread may exit while this is reading its files.
+  if (!ReadFile(dir + "/stat", &stat) || !ReadFile(dir + "/status", &status))
+    return UV_ESRCH;
+  ThreadUsage thread;
+  if (!ParseStat(stat, ticks_per_second, &thread) ||
+      !ParseStatus(status, &thread)) {
+    return UV_EINVAL;
+  }
+  if (name != nullptr) {
+    size_t start = stat.find('(');
+    size_t end = stat.rfind(')');
+    if (start != std::string::npos && end > start)
+      *name = stat.substr(start + 1, end - start - 1);
+  }
+  usage->threads++;
+  usage->user += thread.user;
+  usage->system += thread.system;
+  usage->voluntary_switches += thread.voluntary_switches;
+  usage->involuntary_switches += thread.involuntary_switches;
+  return 0;
+}
+#endif
+
+int GetUsageByKind(std::array<ThreadUsage, kThreadKindCount>* usage) {
+#if defined(__linux__)
+  DIR* tasks = opendir("/proc/self/task");
+  if (tasks == nullptr) return uv_translate_sys_error(errno);
+  std::unordered_map<int, ThreadKind> kinds;
+  {
+    Mutex::ScopedLock lock(thread_kinds_mutex);
+    kinds = thread_kinds;
+  }
+  const int pid = getpid();
+  while (struct dirent* entry = readdir(tasks)) {
+    if (entry->d_name[0] < '0' || entry->d_name[0] > '9') continue;
+    int tid = atoi(entry->d_name);
+    ThreadUsage thread;
+    std::string name;
+    std::string dir = std::string("/proc/self/task/") + entry->d_name;
+    if (ReadThreadUsage(dir, &name, &thread) != 0) continue;
+    ThreadKind kind = kOtherThread;
+    auto it = kinds.find(tid);
+    if (it != kinds.end()) {
+      kind = it->second;
+    } else if (tid == pid) {
+      kind = kMainThread;
+    } else if (name == "libuv-worker") {
+      kind = kThreadpoolThread;
+    }
+    ThreadUsage& total = (*usage)[kind];
+    total.threads += thread.threads;
+    total.user += thread.user;
+    total.system += thread.system;
+    total.voluntary_switches += thread.voluntary_switches;
+    total.involuntary_switches += thread.involuntary_switches;
+  }
+  closedir(tasks);
+  return 0;
+#else
+  return UV_ENOSYS;
+#endif
+}
+
+int GetThreadUsage(int thread_id, ThreadUsage* usage) {
+#if defined(__linux__)
+  if (thread_id < 0) return UV_EINVAL;
+  return ReadThreadUsage(
+      "/proc/self/task/" + std::to_string(thread_id), nullptr, usage);
+#else
+  return UV_ENOSYS;
+#endif
+}
+
+}  // namespace thread_stats
+}  // namespace node
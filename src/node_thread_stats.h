@@ -0,0 +1,60 @@
+#ifndef SRC_NODE_THREAD_STATS_H_
+#define SRC_NODE_THREAD_STATS_H_
+
+#if defined(NODE_WANT_INTERNALS) && NODE_WANT_INTERNALS
+
+#include <array>
+#include <string_view>
+
+namespace node {
+namespace thread_stats {
+
+enum ThreadKind {
+  kMainThread,
+  kWorkerThread,
+  kPlatformThread,
+  kThreadpoolThread,
+  kOtherThread,
+  kThreadKindCount
+};
+
+// The CPU time in microseconds and the context switches of threads.
+struct ThreadUsage {
+  double threads = 0;
+  double user = 0;
+  double system = 0;
+  double voluntary_switches = 0;
+  double involuntary_switches = 0;
+};
+constexpr size_t kThreadUsageFieldCount = 5;
+
+// Marks the calling thread as being of the given kind, until it calls
+// ClearCurrentThreadKind(). Threads that are not marked are told apart by
+// their names: "libuv-worker" for the threadpool, and otherwise kOtherThread
+// except for the main thread.
+void SetCurrentThreadKind(ThreadKind kind);
+void ClearCurrentThreadKind();
+
+// The id of the calling thread in the kernel, or -1 outside of Linux.
+int GetCurrentThreadId();
+
+// Parses the contents of /proc/<pid>/task/<tid>/stat, adding the CPU times
+// to usage. Returns false if they are malformed.
+bool ParseStat(std::string_view stat, double ticks_per_second,
+               ThreadUsage* usage);
+// Parses the contents of /proc/<pid>/task/<tid>/status, adding the context
+// switches to usage.
+bool ParseStatus(std::string_view status, ThreadUsage* usage);
+
+// Adds up the usage of the threads of the process by kind. Returns 0 or a
+// libuv error code, UV_ENOSYS outside of Linux.
+int GetUsageByKind(std::array<ThreadUsage, kThreadKindCount>* usage);
+// Returns 0 or a libuv error code, e.g. UV_ESRCH once the thread has exited.
+int GetThreadUsage(int thread_id, ThreadUsage* usage);
+
+}  // namespace thread_stats
+}  // namespace node
+
+#endif  // defined(NODE_WANT_INTERNALS) && NODE_WANT_INTERNALS
+
+#endif  // SRC_NODE_THREAD_STATS_H_
@@ -24,6 +24,7 @@ using v8::FunctionCallbackInfo;
 using v8::FunctionTemplate;
 using v8::Isolate;
 using v8::Local;
+using v8::Number;
 using v8::Object;
 using v8::String;
 using v8::Uint8Array;
@@ -120,6 +121,47 @@ static void SetTraceCategoryStateUpdateHandler(
   env->set_trace_category_state_function(args[0].As<Function>());
 }
 
+// setCategorySampling(category, probability, maxEventsPerSecond)
+static void SetCategorySampling(const FunctionCallbackInfo<Value>& args) {
+  CHECK(args[0]->IsString());
+  CHECK(args[1]->IsNumber());
+  CHECK(args[2]->IsNumber());
+  Utf8Value category(args.GetIsolate(), args[0]);
+  tracing::TracingController::SamplingConfig config;
+  config.probability = args[1].As<Number>()->Value();
+  config.max_events_per_second = args[2].As<Number>()->Value();
+  CHECK(config.probability >= 0 && config.probability <= 1);
+  CHECK_GE(config.max_events_per_second, 0);
+  GetTracingAgentWriter()->agent()->GetTracingController()->SetSamplingConfig(
+      category.ToString(), config);
+}
+
+static void ClearCategorySampling(const FunctionCallbackInfo<Value>& args) {
+  CHECK(args[0]->IsString());
+  Utf8Value category(args.GetIsolate(), args[0]);
+  GetTracingAgentWriter()
+      ->agent()
+      ->GetTracingController()
+      ->ClearSamplingConfig(category.ToString());
+}
+
+// Returns [recorded, dropped] for a sampled category.
+static void GetCategorySamplingStats(const FunctionCallbackInfo<Value>& args) {
+  CHECK(args[0]->IsString());
+  Isolate* isolate = args.GetIsolate();
+  Utf8Value category(isolate, args[0]);
+  tracing::TracingController::SamplingStats stats =
+      GetTracingAgentWriter()
+          ->agent()
+          ->GetTracingController()
+          ->GetSamplingStats(category.ToString());
+  Local<Value> values[] = {
+      Number::New(isolate, static_cast<double>(stats.recorded)),
+      Number::New(isolate, static_cast<double>(stats.dropped)),
+  };
+  args.GetReturnValue().Set(Array::New(isolate, values, arraysize(values)));
+}
+
 static void GetCategoryEnabledBuffer(const FunctionCallbackInfo<Value>& args) {
   CHECK(args[0]->IsString());
 
@@ -155,6 +197,10 @@ void NodeCategorySet::Initialize(Local<Object> target,
             SetTraceCategoryStateUpdateHandler);
   SetMethod(
       context, target, "getCategoryEnabledBuffer", GetCategoryEnabledBuffer);
+  SetMethod(context, target, "setCategorySampling", SetCategorySampling);
+  SetMethod(context, target, "clearCategorySampling", ClearCategorySampling);
+  SetMethod(
+      context, target, "getCategorySamplingStats", GetCategorySamplingStats);
 
   Local<FunctionTemplate> category_set =
       NewFunctionTemplate(isolate, NodeCategorySet::New);
@@ -184,6 +230,9 @@ void NodeCategorySet::RegisterExternalReferences(
   registry->Register(GetEnabledCategories);
   registry->Register(SetTraceCategoryStateUpdateHandler);
   registry->Register(GetCategoryEnabledBuffer);
+  registry->Register(SetCategorySampling);
+  registry->Register(ClearCategorySampling);
+  registry->Register(GetCategorySamplingStats);
   registry->Register(NodeCategorySet::New);
   registry->Register(NodeCategorySet::Enable);
   registry->Register(NodeCategorySet::Disable);
@@ -13,6 +13,7 @@
 #include "v8-local-handle.h"
 #include "v8.h"
 
+#include <algorithm>
 #include <cstdint>
 #include <cstdio>
 #include <numeric>
@@ -20,6 +21,7 @@
 namespace node {
 namespace url {
 
+using v8::Array;
 using v8::CFunction;
 using v8::Context;
 using v8::FastApiCallbackOptions;
@@ -27,14 +29,19 @@ using v8::FunctionCallbackInfo;
 using v8::HandleScope;
 using v8::Isolate;
 using v8::Local;
+using v8::LocalVector;
 using v8::Object;
 using v8::ObjectTemplate;
 using v8::SnapshotCreator;
 using v8::String;
+using v8::Uint32;
+using v8::Uint32Array;
+using v8::Undefined;
 using v8::Value;
 
 void BindingData::MemoryInfo(MemoryTracker* tracker) const {
   tracker->TrackField("url_components_buffer", url_components_buffer_);
+  tracker->TrackFieldWithSize("last_href", last_href_.capacity());
 }
 
 BindingData::BindingData(Realm* realm, Local<Object> object)
@@ -416,6 +423,130 @@ void BindingData::Parse(const FunctionCallbackInfo<Value>& args) {
   }
 }
 
+// Like parse(), but only writes the components to urlComponents and does
+// not create the href string, for callers that only need some of the
+// components. Returns undefined if the input is invalid, true if the href
+// is the same as the input, so that the components can be sliced from the
+// input, and false otherwise, in which case getHrefSlice() returns them.
+void BindingData::ParseComponents(const FunctionCallbackInfo<Value>& args) {
+  CHECK_GE(args.Length(), 1);
+  CHECK(args[0]->IsString());  // input
+  // args[1] // base url
+
+  Realm* realm = Realm::GetCurrent(args);
+  BindingData* binding_data = realm->GetBindingData<BindingData>();
+  Isolate* isolate = realm->isolate();
+
+  Utf8Value input(isolate, args[0]);
+  ada::result<ada::url_aggregator> base;
+  ada::url_aggregator* base_pointer = nullptr;
+  if (args[1]->IsString()) {
+    base = ada::parse<ada::url_aggregator>(
+        Utf8Value(isolate, args[1]).ToStringView());
+    if (!base) return;
+    base_pointer = &base.value();
+  }
+  auto out =
+      ada::parse<ada::url_aggregator>(input.ToStringView(), base_pointer);
+  if (!out) return;
+
+  binding_data->UpdateComponents(out->get_components(), out->type);
+  std::string_view href = out->get_href();
+  if (href == input.ToStringView()) {
+    binding_data->last_href_.clear();
+    return args.GetReturnValue().Set(true);
+  }
+  binding_data->last_href_.assign(href);
+  args.GetReturnValue().Set(false);
+}
+
+// getHrefSlice(start, end) returns a substring of the href of the last
+// parseComponents() call that returned false.
+void BindingData::GetHrefSlice(const FunctionCallbackInfo<Value>& args) {
+  CHECK(args[0]->IsUint32());  // start
+  CHECK(args[1]->IsUint32());  // end
+
+  Realm* realm = Realm::GetCurrent(args);
+  BindingData* binding_data = realm->GetBindingData<BindingData>();
+  std::string_view href = binding_data->last_href_;
+  size_t end = std::min<size_t>(args[1].As<Uint32>()->Value(),
+                                href.size());
+  size_t start = std::min<size_t>(args[0].As<Uint32>()->Value(), end);
+
+  Local<Value> ret;
+  if (ToV8Value(realm->context(), href.substr(start, end - start))
+          .ToLocal(&ret)) [[likely]] {
+    args.GetReturnValue().Set(ret);
+  }
+}
+
+// parseBatch(inputs, components[, base]) parses an array of URL strings in
+// one call. The components of inputs[i] are written to
+// components[i * 9, i * 9 + 9) in the layout of urlComponents, or all set
+// to 0xffffffff if the input is invalid. Returns an array that holds the
+// href of every valid input that differs from its href, and undefined for
+// the other inputs.
+void BindingData::ParseBatch(const FunctionCallbackInfo<Value>& args) {
+  CHECK(args[0]->IsArray());        // inputs
+  CHECK(args[1]->IsUint32Array());  // components
+  // args[2] // base url
+
+  Realm* realm = Realm::GetCurrent(args);
+  Isolate* isolate = realm->isolate();
+  Local<Context> context = realm->context();
+  Local<Array> inputs = args[0].As<Array>();
+  Local<Uint32Array> components = args[1].As<Uint32Array>();
+  uint32_t length = inputs->Length();
+  CHECK_GE(components->Length(), size_t{length} * kURLComponentsLength);
+  uint32_t* out = reinterpret_cast<uint32_t*>(
+      static_cast<char*>(components->Buffer()->Data()) +
+      components->ByteOffset());
+
+  ada::result<ada::url_aggregator> base;
+  ada::url_aggregator* base_pointer = nullptr;
+  bool valid_base = true;
+  if (args[2]->IsString()) {
+    base = ada::parse<ada::url_aggregator>(
+        Utf8Value(isolate, args[2]).ToStringView());
+    valid_base = base.has_value();
+    if (valid_base) base_pointer = &base.value();
+  }
+
+  LocalVector<Value> hrefs(isolate, length);
+  std::fill(hrefs.begin(), hrefs.end(), Undefined(isolate));
+  for (uint32_t i = 0; i < length; i++) {
+    uint32_t* url_components = out + size_t{i} * kURLComponentsLength;
+    Local<Value> input_value;
+    if (!inputs->Get(context, i).ToLocal(&input_value)) return;
+    ada::result<ada::url_aggregator> url;
+    std::string_view href;
+    // An invalid base makes every input invalid, like in parse().
+    if (input_value->IsString() && valid_base) {
+      Utf8Value input(isolate, input_value);
+      url = ada::parse<ada::url_aggregator>(input.ToStringView(),
+                                            base_pointer);
+      if (url) {
+        href = url->get_href();
+        if (href == input.ToStringView()) href = {};
+      }
+    } else {
+      url = tl::unexpected(ada::errors::type_error);
+    }
+    if (!url) {
+      std::fill_n(url_components,
+                  kURLComponentsLength,
+                  ada::url_components::omitted);
+      continue;
+    }
+    WriteComponents(url_components, url->get_components(), url->type);
+    if (!href.empty() &&
+        !ToV8Value(context, href, isolate).ToLocal(&hrefs[i])) {
+      return;
+    }
+  }
+  args.GetReturnValue().Set(Array::New(isolate, hrefs.data(), hrefs.size()));
+}
+
 void BindingData::Update(const FunctionCallbackInfo<Value>& args) {
   CHECK(args[0]->IsString());    // href
   CHECK(args[1]->IsNumber());    // action type
@@ -512,6 +643,22 @@ void BindingData::UpdateComponents(const ada::url_components& components,
                 "kURLComponentsLength should be up-to-date");
 }
 
+void BindingData::WriteComponents(uint32_t* out,
+                                  const ada::url_components& components,
+                                  const ada::scheme::type type) {
+  out[0] = components.protocol_end;
+  out[1] = components.username_end;
+  out[2] = components.host_start;
+  out[3] = components.host_end;
+  out[4] = components.port;
+  out[5] = components.pathname_start;
+  out[6] = components.search_start;
+  out[7] = components.hash_start;
+  out[8] = type;
+  static_assert(kURLComponentsLength == 9,
+                "kURLComponentsLength should be up-to-date");
+}
+
 void BindingData::CreatePerIsolateProperties(IsolateData* isolate_data,
                                              Local<ObjectTemplate> target) {
   Isolate* isolate = isolate_data->isolate();
@@ -520,6 +667,9 @@ void BindingData::CreatePerIsolateProperties(IsolateData* isolate_data,
   SetMethodNoSideEffect(isolate, target, "format", Format);
   SetMethodNoSideEffect(isolate, target, "getOrigin", GetOrigin);
   SetMethod(isolate, target, "parse", Parse);
+  SetMethod(isolate, target, "parseComponents", ParseComponents);
+  SetMethodNoSideEffect(isolate, target, "getHrefSlice", GetHrefSlice);
+  SetMethod(isolate, target, "parseBatch", ParseBatch);
   SetMethod(isolate, target, "pathToFileURL", PathToFileURL);
   SetMethod(isolate, target, "update", Update);
   SetFastMethodNoSideEffect(
@@ -541,6 +691,9 @@ void BindingData::RegisterExternalReferences(
   registry->Register(Format);
   registry->Register(GetOrigin);
   registry->Register(Parse);
+  registry->Register(ParseComponents);
+  registry->Register(GetHrefSlice);
+  registry->Register(ParseBatch);
   registry->Register(PathToFileURL);
   registry->Register(Update);
   registry->Register(CanParse);
@@ -64,6 +64,9 @@ class BindingData : public SnapshotableObject {
   static void Format(const v8::FunctionCallbackInfo<v8::Value>& args);
   static void GetOrigin(const v8::FunctionCallbackInfo<v8::Value>& args);
   static void Parse(const v8::FunctionCallbackInfo<v8::Value>& args);
+  static void ParseComponents(const v8::FunctionCallbackInfo<v8::Value>& args);
+  static void GetHrefSlice(const v8::FunctionCallbackInfo<v8::Value>& args);
+  static void ParseBatch(const v8::FunctionCallbackInfo<v8::Value>& args);
   static void PathToFileURL(const v8::FunctionCallbackInfo<v8::Value>& args);
   static void Update(const v8::FunctionCallbackInfo<v8::Value>& args);
 
@@ -78,9 +81,16 @@ class BindingData : public SnapshotableObject {
  private:
   static constexpr size_t kURLComponentsLength = 9;
   AliasedUint32Array url_components_buffer_;
+  // The href of the last URL parsed by ParseComponents() that differs from
+  // its input, for GetHrefSlice(). Reused, so that parsing does not
+  // allocate once it is large enough.
+  std::string last_href_;
 
   void UpdateComponents(const ada::url_components& components,
                         const ada::scheme::type type);
+  static void WriteComponents(uint32_t* out,
+                              const ada::url_components& components,
+                              const ada::scheme::type type);
 
   static v8::CFunction fast_can_parse_methods_[];
 };
@@ -6,8 +6,11 @@
 #include "node_errors.h"
 #include "node_mem-inl.h"
 #include "path.h"
+#include "url_pattern_regexp_cache.h"
 #include "util-inl.h"
 
+#include <algorithm>
+
 namespace node {
 using node::url_pattern::URLPatternRegexProvider;
 
@@ -58,12 +61,14 @@ using v8::DontDelete;
 using v8::FunctionCallbackInfo;
 using v8::FunctionTemplate;
 using v8::Global;
+using v8::Integer;
 using v8::Isolate;
 using v8::Local;
 using v8::LocalVector;
 using v8::MaybeLocal;
 using v8::Name;
 using v8::NewStringType;
+using v8::Number;
 using v8::Object;
 using v8::PropertyAttribute;
 using v8::ReadOnly;
@@ -82,19 +87,42 @@ URLPatternRegexProvider::create_instance(std::string_view pattern,
     flags |= static_cast<int>(RegExp::Flags::kIgnoreCase);
   }
 
+  Local<RegExp> regexp;
+  if (!env->url_pattern_regexp_cache()
+           ->Get(env->context(), pattern, static_cast<RegExp::Flags>(flags))
+           .ToLocal(&regexp)) {
+    return std::nullopt;
+  }
+  return Global<RegExp>(isolate, regexp);
+}
+
+MaybeLocal<RegExp> RegExpCache::Get(Local<Context> context,
+                                    std::string_view pattern,
+                                    RegExp::Flags flags) {
+  Isolate* isolate = Isolate::GetCurrent();
+  std::string key = std::to_string(flags) + ":";
+  key += pattern;
+  auto it = regexps_.find(key);
+  if (it != regexps_.end()) {
+    hits_++;
+    return it->second.Get(isolate);
+  }
+  misses_++;
+
   Local<String> local_pattern;
   if (!String::NewFromUtf8(
            isolate, pattern.data(), NewStringType::kNormal, pattern.size())
            .ToLocal(&local_pattern)) {
-    return std::nullopt;
+    return {};
   }
   Local<RegExp> regexp;
-  if (!RegExp::New(
-           env->context(), local_pattern, static_cast<RegExp::Flags>(flags))
-           .ToLocal(&regexp)) {
-    return std::nullopt;
+  if (!RegExp::New(context, local_pattern, flags).ToLocal(&regexp)) {
+    return {};
   }
-  return Global<RegExp>(isolate, regexp);
+  if (regexps_.size() < kMaxSize) {
+    regexps_.emplace(std::move(key), Global<RegExp>(isolate, regexp));
+  }
+  return regexp;
 }
 
 bool URLPatternRegexProvider::regex_match(std::string_view input,
@@ -617,7 +645,394 @@ void URLPattern::HasRegexpGroups(const FunctionCallbackInfo<Value>& info) {
   info.GetReturnValue().Set(url_pattern->HasRegExpGroups());
 }
 
+namespace {
+
+using Pattern = ada::url_pattern<URLPatternRegexProvider>;
+using PatternComponent = ada::url_pattern_component<URLPatternRegexProvider>;
+
+// In the order in which ada::url_pattern::match() matches them.
+constexpr PatternComponent Pattern::*kComponents[] = {
+    &Pattern::protocol_component,
+    &Pattern::username_component,
+    &Pattern::password_component,
+    &Pattern::hostname_component,
+    &Pattern::port_component,
+    &Pattern::pathname_component,
+    &Pattern::search_component,
+    &Pattern::hash_component,
+};
+static_assert(arraysize(kComponents) == URLPatternList::kComponentCount);
+constexpr size_t kPathname = 5;
+
+// Returns the literal text that every pathname matching |pattern| starts
+// with. This is conservative: the character before the first token with a
+// special meaning is dropped too, because it may be a prefix that belongs
+// to an optional part, like the "/" in "/books/:id?", or be followed by a
+// modifier.
+std::string_view LiteralPrefix(std::string_view pattern) {
+  size_t end = pattern.find_first_of(":*(){}\\?+");
+  if (end == std::string_view::npos) return pattern;
+  return pattern.substr(0, end == 0 ? 0 : end - 1);
+}
+
+char ToLower(char c) {
+  return c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+// Parses the arguments of test(), exec() and execAll() like URLPattern
+// does. Returns false if an exception was thrown.
+bool GetMatchInput(Environment* env,
+                   const FunctionCallbackInfo<Value>& args,
+                   ada::url_pattern_input* input,
+                   std::string* input_string,
+                   std::optional<std::string>* base_url) {
+  if (args.Length() == 0) {
+    *input = ada::url_pattern_init{};
+  } else if (args[0]->IsString()) {
+    Utf8Value input_value(env->isolate(), args[0].As<String>());
+    *input_string = input_value.ToString();
+    *input = std::string_view(*input_string);
+  } else if (args[0]->IsObject()) {
+    auto init =
+        URLPattern::URLPatternInit::FromJsObject(env, args[0].As<Object>());
+    if (!init.has_value()) return false;
+    *input = std::move(*init);
+  } else {
+    THROW_ERR_INVALID_ARG_TYPE(
+        env, "URLPattern input needs to be a string or an object");
+    return false;
+  }
+
+  if (args.Length() > 1 && !args[1]->IsUndefined()) {
+    if (!args[1]->IsString()) {
+      THROW_ERR_INVALID_ARG_TYPE(env, "baseURL must be a string");
+      return false;
+    }
+    Utf8Value base_url_value(env->isolate(), args[1].As<String>());
+    *base_url = base_url_value.ToString();
+  }
+  return true;
+}
+
+}  // namespace
+
+URLPatternList::URLPatternList(
+    Environment* env,
+    Local<Object> object,
+    std::vector<BaseObjectPtr<URLPattern>>&& patterns)
+    : BaseObject(env, object), patterns_(std::move(patterns)) {
+  MakeWeak();
+
+  std::array<std::unordered_map<std::string, uint32_t>, kComponentCount>
+      unique_ids;
+  for (std::vector<TrieNode>& trie : tries_) trie.emplace_back();
+  component_ids_.resize(patterns_.size());
+  for (uint32_t i = 0; i < patterns_.size(); i++) {
+    Pattern& pattern = patterns_[i]->url_pattern();
+    for (size_t c = 0; c < kComponentCount; c++) {
+      const PatternComponent& component = pattern.*kComponents[c];
+      std::string key = (pattern.ignore_case() ? "i" : "s") + component.pattern;
+      auto [it, inserted] =
+          unique_ids[c].emplace(std::move(key), components_[c].size());
+      if (inserted) {
+        components_[c].push_back(
+            {patterns_[i].get(), c, component.pattern == "*"});
+      }
+      component_ids_[i][c] = it->second;
+    }
+    AddToTrie(i,
+              LiteralPrefix(pattern.pathname_component.pattern),
+              pattern.ignore_case());
+  }
+}
+
+void URLPatternList::AddToTrie(uint32_t index,
+                               std::string_view prefix,
+                               bool ignore_case) {
+  std::vector<TrieNode>& trie = tries_[ignore_case ? 1 : 0];
+  uint32_t node = 0;
+  for (char c : prefix) {
+    if (ignore_case) c = ToLower(c);
+    auto it = trie[node].children.find(c);
+    if (it != trie[node].children.end()) {
+      node = it->second;
+      continue;
+    }
+    uint32_t child = trie.size();
+    trie[node].children.emplace(c, child);
+    trie.emplace_back();
+    node = child;
+  }
+  trie[node].patterns.push_back(index);
+}
+
+void URLPatternList::CollectCandidates(
+    size_t trie_index,
+    std::string_view pathname,
+    std::vector<uint32_t>* candidates) const {
+  const std::vector<TrieNode>& trie = tries_[trie_index];
+  uint32_t node = 0;
+  size_t i = 0;
+  while (true) {
+    candidates->insert(candidates->end(),
+                       trie[node].patterns.begin(),
+                       trie[node].patterns.end());
+    if (i == pathname.size()) break;
+    char c = trie_index == 1 ? ToLower(pathname[i]) : pathname[i];
+    auto it = trie[node].children.find(c);
+    if (it == trie[node].children.end()) break;
+    node = it->second;
+    i++;
+  }
+}
+
+// Mirrors the processing of the input in ada::url_pattern::match().
+ada::result<std::optional<URLPatternList::Inputs>>
+URLPatternList::ProcessInput(const ada::url_pattern_input& input,
+                             const std::string_view* base_url) {
+  Inputs inputs;
+  auto& [protocol, username, password, hostname, port, pathname, search, hash] =
+      inputs;
+  if (std::holds_alternative<ada::url_pattern_init>(input)) {
+    if (base_url != nullptr) return tl::unexpected(ada::errors::type_error);
+    auto result = ada::url_pattern_init::process(
+        std::get<ada::url_pattern_init>(input),
+        ada::url_pattern_init::process_type::url,
+        protocol,
+        username,
+        password,
+        hostname,
+        port,
+        pathname,
+        search,
+        hash);
+    if (!result.has_value()) return std::nullopt;
+    protocol = std::move(*result->protocol);
+    username = std::move(*result->username);
+    password = std::move(*result->password);
+    hostname = std::move(*result->hostname);
+    port = std::move(*result->port);
+    pathname = std::move(*result->pathname);
+    search = result->search->starts_with("?") ? result->search->substr(1)
+                                              : std::move(*result->search);
+    hash = std::move(*result->hash);
+    return inputs;
+  }
+
+  ada::result<ada::url_aggregator> base;
+  if (base_url != nullptr) {
+    base = ada::parse<ada::url_aggregator>(*base_url, nullptr);
+    if (!base) return std::nullopt;
+  }
+  auto url = ada::parse<ada::url_aggregator>(
+      std::get<std::string_view>(input), base ? &*base : nullptr);
+  if (!url) return std::nullopt;
+  std::string_view url_protocol = url->get_protocol();
+  protocol = url_protocol.substr(0, url_protocol.size() - 1);
+  username = url->get_username();
+  password = url->get_password();
+  hostname = url->get_hostname();
+  port = url->get_port();
+  pathname = url->get_pathname();
+  if (url->has_search()) {
+    std::string_view view = url->get_search();
+    search = view.starts_with("?") ? view.substr(1) : view;
+  }
+  if (url->has_hash()) {
+    std::string_view view = url->get_hash();
+    hash = view.starts_with("#") ? view.substr(1) : view;
+  }
+  return inputs;
+}
+
+template <typename Fn>
+ada::result<bool> URLPatternList::Match(const ada::url_pattern_input& input,
+                                        const std::string_view* base_url,
+                                        Fn&& match) {
+  auto maybe_inputs = ProcessInput(input, base_url);
+  if (!maybe_inputs) return tl::unexpected(maybe_inputs.error());
+  if (!maybe_inputs->has_value()) return false;
+  const Inputs& inputs = **maybe_inputs;
+
+  std::vector<uint32_t> candidates;
+  CollectCandidates(0, inputs[kPathname], &candidates);
+  CollectCandidates(1, inputs[kPathname], &candidates);
+  std::sort(candidates.begin(), candidates.end());
+
+  // 0 = not matched yet, 1 = matches, 2 = does not match.
+  std::array<std::vector<uint8_t>, kComponentCount> results;
+  for (size_t c = 0; c < kComponentCount; c++) {
+    results[c].resize(components_[c].size());
+  }
+  const auto matches = [&](size_t c, uint32_t id) {
+    uint8_t& result = results[c][id];
+    if (result == 0) {
+      const Component& component = components_[c][id];
+      bool matched =
+          component.matches_all ||
+          URLPatternRegexProvider::regex_match(
+              inputs[c],
+              (component.pattern->url_pattern().*kComponents[c]).regexp);
+      result = matched ? 1 : 2;
+    }
+    return result == 1;
+  };
+
+  for (uint32_t index : candidates) {
+    const std::array<uint32_t, kComponentCount>& ids = component_ids_[index];
+    // The pathname is the most selective component, so match it first.
+    if (!matches(kPathname, ids[kPathname])) continue;
+    bool matched = true;
+    for (size_t c = 0; c < kComponentCount && matched; c++) {
+      matched = c == kPathname || matches(c, ids[c]);
+    }
+    if (matched && !match(index)) break;
+  }
+  return true;
+}
+
+void URLPatternList::MemoryInfo(MemoryTracker* tracker) const {
+  tracker->TrackField("patterns", patterns_);
+  size_t trie_nodes = 0;
+  for (const std::vector<TrieNode>& trie : tries_) trie_nodes += trie.size();
+  tracker->TrackFieldWithSize("tries", trie_nodes * sizeof(TrieNode));
+  tracker->TrackFieldWithSize(
+      "component_ids",
+      component_ids_.size() * sizeof(component_ids_[0]));
+}
+
+void URLPatternList::New(const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+  if (!args.IsConstructCall()) {
+    THROW_ERR_CONSTRUCT_CALL_REQUIRED(env);
+    return;
+  }
+  if (!args[0]->IsArray()) {
+    THROW_ERR_INVALID_ARG_TYPE(env, "patterns must be an array");
+    return;
+  }
+
+  Local<Array> array = args[0].As<Array>();
+  Local<FunctionTemplate> url_pattern_template =
+      env->url_pattern_constructor_template();
+  std::vector<BaseObjectPtr<URLPattern>> patterns;
+  patterns.reserve(array->Length());
+  for (uint32_t i = 0; i < array->Length(); i++) {
+    Local<Value> value;
+    if (!array->Get(env->context(), i).ToLocal(&value)) return;
+    if (!url_pattern_template->HasInstance(value)) {
+      THROW_ERR_INVALID_ARG_TYPE(env, "patterns must be URLPattern objects");
+      return;
+    }
+    patterns.emplace_back(Unwrap<URLPattern>(value.As<Object>()));
+  }
+  new URLPatternList(env, args.This(), std::move(patterns));
+}
+
+void URLPatternList::Test(const FunctionCallbackInfo<Value>& args) {
+  URLPatternList* list;
+  ASSIGN_OR_RETURN_UNWRAP(&list, args.This());
+  Environment* env = Environment::GetCurrent(args);
+
+  ada::url_pattern_input input;
+  std::string input_string;
+  std::optional<std::string> base_url;
+  if (!GetMatchInput(env, args, &input, &input_string, &base_url)) return;
+  std::string_view base_url_view;
+  if (base_url) base_url_view = *base_url;
+
+  int64_t first = -1;
+  auto result = list->Match(
+      input, base_url ? &base_url_view : nullptr, [&](uint32_t index) {
+        first = index;
+        return false;
+      });
+  if (!result) {
+    THROW_ERR_OPERATION_FAILED(env, "Failed to test URLPatternList");
+    return;
+  }
+  args.GetReturnValue().Set(static_cast<double>(first));
+}
+
+static void ExecImpl(const FunctionCallbackInfo<Value>& args, bool all) {
+  URLPatternList* list;
+  ASSIGN_OR_RETURN_UNWRAP(&list, args.This());
+  Environment* env = Environment::GetCurrent(args);
+  Isolate* isolate = env->isolate();
+
+  ada::url_pattern_input input;
+  std::string input_string;
+  std::optional<std::string> base_url;
+  if (!GetMatchInput(env, args, &input, &input_string, &base_url)) return;
+  std::string_view base_url_view;
+  const std::string_view* base_url_ptr = nullptr;
+  if (base_url) {
+    base_url_view = *base_url;
+    base_url_ptr = &base_url_view;
+  }
+
+  LocalVector<Value> matches(isolate);
+  bool failed = false;
+  // Only the matching patterns build their full result, through
+  // ada::url_pattern::exec(), so the groups are exactly those of
+  // URLPattern.prototype.exec().
+  auto result = list->Match(input, base_url_ptr, [&](uint32_t index) {
+    URLPattern* pattern = list->pattern(index);
+    auto exec_result = pattern->url_pattern().exec(input, base_url_ptr);
+    Local<Value> value;
+    if (!exec_result || !exec_result->has_value() ||
+        !URLPattern::URLPatternResult::ToJSValue(env, **exec_result)
+             .ToLocal(&value)) {
+      failed = true;
+      return false;
+    }
+    Local<Name> names[] = {env->index_string(), env->result_string()};
+    Local<Value> values[] = {Integer::NewFromUnsigned(isolate, index), value};
+    matches.push_back(Object::New(
+        isolate, Object::New(isolate), names, values, arraysize(names)));
+    return all;
+  });
+  if (!result || failed) {
+    THROW_ERR_OPERATION_FAILED(env, "Failed to exec URLPatternList");
+    return;
+  }
+
+  if (all) {
+    args.GetReturnValue().Set(
+        Array::New(isolate, matches.data(), matches.size()));
+  } else if (matches.empty()) {
+    args.GetReturnValue().SetNull();
+  } else {
+    args.GetReturnValue().Set(matches[0]);
+  }
+}
+
+void URLPatternList::Exec(const FunctionCallbackInfo<Value>& args) {
+  ExecImpl(args, false);
+}
+
+void URLPatternList::ExecAll(const FunctionCallbackInfo<Value>& args) {
+  ExecImpl(args, true);
+}
+
+// Returns { hits, misses, size } of the Environment's RegExpCache.
+static void GetRegExpCacheStats(const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+  Isolate* isolate = env->isolate();
+  RegExpCache* cache = env->url_pattern_regexp_cache();
+  Local<Name> names[] = {
+      env->hits_string(), env->misses_string(), env->size_string()};
+  Local<Value> values[] = {
+      Number::New(isolate, static_cast<double>(cache->hits())),
+      Number::New(isolate, static_cast<double>(cache->misses())),
+      Number::New(isolate, static_cast<double>(cache->size())),
+  };
+  args.GetReturnValue().Set(Object::New(
+      isolate, Object::New(isolate), names, values, arraysize(names)));
+}
+
 static void RegisterExternalReferences(ExternalReferenceRegistry* registry) {
+  registry->Register(GetRegExpCacheStats);
   registry->Register(URLPattern::New);
 #define URL_PATTERN_COMPONENT_GETTERS(uppercase_name, _)                       \
   registry->Register(URLPattern::uppercase_name);
@@ -626,6 +1041,10 @@ static void RegisterExternalReferences(ExternalReferenceRegistry* registry) {
   registry->Register(URLPattern::HasRegexpGroups);
   registry->Register(URLPattern::Exec);
   registry->Register(URLPattern::Test);
+  registry->Register(URLPatternList::New);
+  registry->Register(URLPatternList::Test);
+  registry->Register(URLPatternList::Exec);
+  registry->Register(URLPatternList::ExecAll);
 }
 
 static void Initialize(Local<Object> target,
@@ -668,6 +1087,19 @@ static void Initialize(Local<Object> target,
   SetProtoMethodNoSideEffect(isolate, ctor_tmpl, "exec", URLPattern::Exec);
   SetProtoMethodNoSideEffect(isolate, ctor_tmpl, "test", URLPattern::Test);
   SetConstructorFunction(context, target, "URLPattern", ctor_tmpl);
+  env->set_url_pattern_constructor_template(ctor_tmpl);
+
+  auto list_tmpl = NewFunctionTemplate(isolate, URLPatternList::New);
+  list_tmpl->InstanceTemplate()->SetInternalFieldCount(
+      URLPatternList::kInternalFieldCount);
+  SetProtoMethodNoSideEffect(isolate, list_tmpl, "test", URLPatternList::Test);
+  SetProtoMethodNoSideEffect(isolate, list_tmpl, "exec", URLPatternList::Exec);
+  SetProtoMethodNoSideEffect(
+      isolate, list_tmpl, "execAll", URLPatternList::ExecAll);
+  SetConstructorFunction(context, target, "URLPatternList", list_tmpl);
+
+  SetMethodNoSideEffect(
+      context, target, "getRegExpCacheStats", GetRegExpCacheStats);
 }
 
 }  // namespace node::url_pattern
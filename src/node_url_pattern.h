@@ -9,8 +9,12 @@
 
 #include <v8.h>
 
+#include <array>
 #include <optional>
+#include <string>
 #include <string_view>
+#include <unordered_map>
+#include <vector>
 
 namespace node::url_pattern {
 
@@ -64,6 +68,10 @@ class URLPattern : public BaseObject {
   SET_MEMORY_INFO_NAME(URLPattern)
   SET_SELF_SIZE(URLPattern)
 
+  ada::url_pattern<URLPatternRegexProvider>& url_pattern() {
+    return url_pattern_;
+  }
+
   class URLPatternInit {
    public:
     static std::optional<ada::url_pattern_init> FromJsObject(
@@ -112,6 +120,83 @@ class URLPattern : public BaseObject {
 #undef URL_PATTERN_CACHED_VALUES
 };
 
+// Matches an input against an ordered list of URLPatterns in one call, for
+// routers. Instead of running every component of every pattern:
+// - The input is parsed into its components once.
+// - The literal prefixes of the pathname patterns are kept in a trie, and
+//   only the patterns whose prefix the input's pathname starts with are
+//   candidates.
+// - Identical component patterns, like the "*" that most routes have for
+//   every component but the pathname, are only matched once per call, and
+//   "*" is not matched at all.
+class URLPatternList : public BaseObject {
+ public:
+  static constexpr size_t kComponentCount = 8;
+
+  URLPatternList(Environment* env,
+                 v8::Local<v8::Object> object,
+                 std::vector<BaseObjectPtr<URLPattern>>&& patterns);
+
+  // new URLPatternList(patterns)
+  static void New(const v8::FunctionCallbackInfo<v8::Value>& args);
+  // test(input[, baseURL]) returns the index of the first matching pattern,
+  // or -1.
+  static void Test(const v8::FunctionCallbackInfo<v8::Value>& args);
+  // exec(input[, baseURL]) returns { index, result } for the first
+  // matching pattern, or null. execAll() returns an array with one entry
+  // per matching pattern.
+  static void Exec(const v8::FunctionCallbackInfo<v8::Value>& args);
+  static void ExecAll(const v8::FunctionCallbackInfo<v8::Value>& args);
+
+  void MemoryInfo(MemoryTracker* tracker) const override;
+  SET_MEMORY_INFO_NAME(URLPatternList)
+  SET_SELF_SIZE(URLPatternList)
+
+  size_t size() const { return patterns_.size(); }
+  URLPattern* pattern(size_t index) const { return patterns_[index].get(); }
+
+  // Calls |match| with the index of every pattern that matches |input|, in
+  // order, until it returns false. Returns false if the input could not be
+  // processed, in which case nothing matches, and an error if the input is
+  // invalid, like ada::url_pattern::exec().
+  template <typename Fn>
+  ada::result<bool> Match(const ada::url_pattern_input& input,
+                          const std::string_view* base_url,
+                          Fn&& match);
+
+ private:
+  struct TrieNode {
+    std::unordered_map<char, uint32_t> children;
+    // The patterns whose literal pathname prefix ends at this node.
+    std::vector<uint32_t> patterns;
+  };
+
+  struct Component {
+    // The pattern that the regular expression is borrowed from.
+    URLPattern* pattern;
+    size_t component;
+    // Whether the component pattern is "*", which matches any input.
+    bool matches_all;
+  };
+
+  using Inputs = std::array<std::string, kComponentCount>;
+
+  static ada::result<std::optional<Inputs>> ProcessInput(
+      const ada::url_pattern_input& input, const std::string_view* base_url);
+  void AddToTrie(uint32_t index, std::string_view pathname, bool ignore_case);
+  void CollectCandidates(size_t trie,
+                         std::string_view pathname,
+                         std::vector<uint32_t>* candidates) const;
+
+  std::vector<BaseObjectPtr<URLPattern>> patterns_;
+  // The unique patterns of every component, and for every pattern the index
+  // into them of each of its components.
+  std::array<std::vector<Component>, kComponentCount> components_;
+  std::vector<std::array<uint32_t, kComponentCount>> component_ids_;
+  // Case-sensitive and case-insensitive (lower-cased) tries.
+  std::array<std::vector<TrieNode>, 2> tries_;
+};
+
 }  // namespace node::url_pattern
 
 #endif  // defined(NODE_WANT_INTERNALS) && NODE_WANT_INTERNALS
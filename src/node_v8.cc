@@ -37,6 +37,8 @@ using v8::CFunction;
 using v8::Context;
 using v8::FunctionCallbackInfo;
 using v8::FunctionTemplate;
+using v8::GCCallbackFlags;
+using v8::GCType;
 using v8::HandleScope;
 using v8::HeapCodeStatistics;
 using v8::HeapSpaceStatistics;
@@ -98,6 +100,18 @@ static const size_t kHeapCodeStatisticsPropertiesCount =
     HEAP_CODE_STATISTICS_PROPERTIES(V);
 #undef V
 
+// The layout of heap_sample_buffer.
+static constexpr size_t kHeapSampleCountIndex = 0;
+static constexpr size_t kHeapSampleTimeIndex = 1;
+static constexpr size_t kHeapSampleStatisticsIndex = 2;
+static constexpr size_t kHeapSampleSpaceStatisticsIndex =
+    kHeapSampleStatisticsIndex + kHeapStatisticsPropertiesCount;
+
+static size_t HeapSampleBufferLength(Isolate* isolate) {
+  return kHeapSampleSpaceStatisticsIndex +
+         isolate->NumberOfHeapSpaces() * kHeapSpaceStatisticsPropertiesCount;
+}
+
 BindingData::BindingData(Realm* realm,
                          Local<Object> obj,
                          InternalFieldInfo* info)
@@ -112,7 +126,10 @@ BindingData::BindingData(Realm* realm,
       heap_code_statistics_buffer(
           realm->isolate(),
           kHeapCodeStatisticsPropertiesCount,
-          MAYBE_FIELD_PTR(info, heap_code_statistics_buffer)) {
+          MAYBE_FIELD_PTR(info, heap_code_statistics_buffer)),
+      heap_sample_buffer(realm->isolate(),
+                         HeapSampleBufferLength(realm->isolate()),
+                         MAYBE_FIELD_PTR(info, heap_sample_buffer)) {
   Local<Context> context = realm->context();
   if (info == nullptr) {
     obj->Set(context,
@@ -129,19 +146,90 @@ BindingData::BindingData(Realm* realm,
            FIXED_ONE_BYTE_STRING(realm->isolate(), "heapSpaceStatisticsBuffer"),
            heap_space_statistics_buffer.GetJSArray())
         .Check();
+    obj->Set(context,
+             FIXED_ONE_BYTE_STRING(realm->isolate(), "heapSampleBuffer"),
+             heap_sample_buffer.GetJSArray())
+        .Check();
   } else {
     heap_statistics_buffer.Deserialize(realm->context());
     heap_code_statistics_buffer.Deserialize(realm->context());
     heap_space_statistics_buffer.Deserialize(realm->context());
+    heap_sample_buffer.Deserialize(realm->context());
   }
   heap_statistics_buffer.MakeWeak();
   heap_space_statistics_buffer.MakeWeak();
   heap_code_statistics_buffer.MakeWeak();
+  heap_sample_buffer.MakeWeak();
+}
+
+BindingData::~BindingData() {
+  StopHeapSampling();
+}
+
+void BindingData::StartHeapSampling(uint64_t interval_ms) {
+  heap_sample_interval_ = interval_ms * 1000 * 1000;
+  if (!sampling_heap_) {
+    realm()->isolate()->AddGCEpilogueCallback(AfterGCCallback, this);
+    sampling_heap_ = true;
+  }
+  SampleHeap();
+}
+
+void BindingData::StopHeapSampling() {
+  if (!sampling_heap_) return;
+  realm()->isolate()->RemoveGCEpilogueCallback(AfterGCCallback, this);
+  sampling_heap_ = false;
+}
+
+void BindingData::AfterGCCallback(Isolate* isolate,
+                                  GCType type,
+                                  GCCallbackFlags flags,
+                                  void* data) {
+  BindingData* binding = static_cast<BindingData*>(data);
+  if (uv_hrtime() - binding->last_heap_sample_ <
+      binding->heap_sample_interval_) {
+    return;
+  }
+  binding->SampleHeap();
+}
+
+void BindingData::SampleHeap() {
+  // The statistics that V8 keeps up to date anyway, unlike the code
+  // statistics, which walk the heap.
+  Isolate* isolate = realm()->isolate();
+  AliasedFloat64Array& buffer = heap_sample_buffer;
+  last_heap_sample_ = uv_hrtime();
+
+  HeapStatistics s;
+  isolate->GetHeapStatistics(&s);
+#define V(index, name, _)                                                      \
+  buffer[kHeapSampleStatisticsIndex + index] = static_cast<double>(s.name());
+  HEAP_STATISTICS_PROPERTIES(V)
+#undef V
+
+  size_t space_count = isolate->NumberOfHeapSpaces();
+  for (size_t i = 0; i < space_count; i++) {
+    HeapSpaceStatistics ss;
+    isolate->GetHeapSpaceStatistics(&ss, i);
+    size_t offset = kHeapSampleSpaceStatisticsIndex +
+                    i * kHeapSpaceStatisticsPropertiesCount;
+#define V(index, name, _)                                                      \
+  buffer[offset + index] = static_cast<double>(ss.name());
+    HEAP_SPACE_STATISTICS_PROPERTIES(V)
+#undef V
+  }
+
+  buffer[kHeapSampleTimeIndex] = static_cast<double>(last_heap_sample_) / 1e6;
+  // Written last, so that a reader that was interrupted by a garbage
+  // collection can tell by reading it before and after the others.
+  buffer[kHeapSampleCountIndex] = buffer[kHeapSampleCountIndex] + 1;
 }
 
 bool BindingData::PrepareForSerialization(Local<Context> context,
                                           v8::SnapshotCreator* creator) {
   DCHECK_NULL(internal_field_info_);
+  // The callbacks of the isolate are not part of the snapshot.
+  StopHeapSampling();
   internal_field_info_ = InternalFieldInfoBase::New<InternalFieldInfo>(type());
   internal_field_info_->heap_statistics_buffer =
       heap_statistics_buffer.Serialize(context, creator);
@@ -149,6 +237,8 @@ bool BindingData::PrepareForSerialization(Local<Context> context,
       heap_space_statistics_buffer.Serialize(context, creator);
   internal_field_info_->heap_code_statistics_buffer =
       heap_code_statistics_buffer.Serialize(context, creator);
+  internal_field_info_->heap_sample_buffer =
+      heap_sample_buffer.Serialize(context, creator);
   // Return true because we need to maintain the reference to the binding from
   // JS land.
   return true;
@@ -181,6 +271,7 @@ void BindingData::MemoryInfo(MemoryTracker* tracker) const {
                       heap_space_statistics_buffer);
   tracker->TrackField("heap_code_statistics_buffer",
                       heap_code_statistics_buffer);
+  tracker->TrackField("heap_sample_buffer", heap_sample_buffer);
 }
 
 void CachedDataVersionTag(const FunctionCallbackInfo<Value>& args) {
@@ -237,6 +328,18 @@ void UpdateHeapCodeStatisticsBuffer(const FunctionCallbackInfo<Value>& args) {
 #undef V
 }
 
+// startHeapSampling(intervalMs): keeps heapSampleBuffer up to date after
+// garbage collections, so that it can be read without calling into C++.
+void StartHeapSampling(const FunctionCallbackInfo<Value>& args) {
+  BindingData* data = Realm::GetBindingData<BindingData>(args);
+  CHECK(args[0]->IsUint32());
+  data->StartHeapSampling(args[0].As<Uint32>()->Value());
+}
+
+void StopHeapSampling(const FunctionCallbackInfo<Value>& args) {
+  BindingData* data = Realm::GetBindingData<BindingData>(args);
+  data->StopHeapSampling();
+}
 
 void SetFlagsFromString(const FunctionCallbackInfo<Value>& args) {
   CHECK(args[0]->IsString());
@@ -645,6 +748,8 @@ void Initialize(Local<Object> target,
             UpdateHeapCodeStatisticsBuffer);
   SetMethodNoSideEffect(
       context, target, "getCppHeapStatistics", GetCppHeapStatistics);
+  SetMethod(context, target, "startHeapSampling", StartHeapSampling);
+  SetMethod(context, target, "stopHeapSampling", StopHeapSampling);
 
   size_t number_of_heap_spaces = env->isolate()->NumberOfHeapSpaces();
 
@@ -679,6 +784,10 @@ void Initialize(Local<Object> target,
   HEAP_STATISTICS_PROPERTIES(V)
   HEAP_CODE_STATISTICS_PROPERTIES(V)
   HEAP_SPACE_STATISTICS_PROPERTIES(V)
+  V(kHeapSampleCountIndex, _, kHeapSampleCountIndex)
+  V(kHeapSampleTimeIndex, _, kHeapSampleTimeIndex)
+  V(kHeapSampleStatisticsIndex, _, kHeapSampleStatisticsIndex)
+  V(kHeapSampleSpaceStatisticsIndex, _, kHeapSampleSpaceStatisticsIndex)
 #undef V
 
   // Export symbols used by v8.setFlagsFromString()
@@ -719,6 +828,8 @@ void RegisterExternalReferences(ExternalReferenceRegistry* registry) {
   registry->Register(UpdateHeapStatisticsBuffer);
   registry->Register(UpdateHeapCodeStatisticsBuffer);
   registry->Register(UpdateHeapSpaceStatisticsBuffer);
+  registry->Register(StartHeapSampling);
+  registry->Register(StopHeapSampling);
   registry->Register(SetFlagsFromString);
   registry->Register(GetHashSeed);
   registry->Register(SetHeapSnapshotNearHeapLimit);
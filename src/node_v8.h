@@ -22,10 +22,12 @@ class BindingData : public SnapshotableObject {
     AliasedBufferIndex heap_statistics_buffer;
     AliasedBufferIndex heap_space_statistics_buffer;
     AliasedBufferIndex heap_code_statistics_buffer;
+    AliasedBufferIndex heap_sample_buffer;
   };
   BindingData(Realm* realm,
               v8::Local<v8::Object> obj,
               InternalFieldInfo* info = nullptr);
+  ~BindingData() override;
 
   SERIALIZABLE_OBJECT_METHODS()
   SET_BINDING_ID(v8_binding_data)
@@ -33,13 +35,30 @@ class BindingData : public SnapshotableObject {
   AliasedFloat64Array heap_statistics_buffer;
   AliasedFloat64Array heap_space_statistics_buffer;
   AliasedFloat64Array heap_code_statistics_buffer;
+  // While sampling, refreshed after garbage collections with the number of
+  // samples taken, the time of the last one, the heap statistics and then
+  // the statistics of each heap space.
+  AliasedFloat64Array heap_sample_buffer;
+
+  // Samples at most once per interval, and right away.
+  void StartHeapSampling(uint64_t interval_ms);
+  void StopHeapSampling();
+  void SampleHeap();
 
   void MemoryInfo(MemoryTracker* tracker) const override;
   SET_SELF_SIZE(BindingData)
   SET_MEMORY_INFO_NAME(BindingData)
 
  private:
+  static void AfterGCCallback(v8::Isolate* isolate,
+                              v8::GCType type,
+                              v8::GCCallbackFlags flags,
+                              void* data);
+
   InternalFieldInfo* internal_field_info_ = nullptr;
+  bool sampling_heap_ = false;
+  uint64_t heap_sample_interval_ = 0;
+  uint64_t last_heap_sample_ = 0;
 };
 
 class GCProfiler : public BaseObject {
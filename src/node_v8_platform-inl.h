@@ -85,7 +85,9 @@ struct V8Platform {
   bool initialized_ = false;
 
 #if NODE_USE_V8_PLATFORM
-  inline void Initialize(int thread_pool_size) {
+  inline void Initialize(int thread_pool_size,
+                         int user_blocking_thread_pool_size = 0,
+                         bool numa_affinity = false) {
     CHECK(!initialized_);
     initialized_ = true;
     tracing_agent_ = std::make_unique<tracing::Agent>();
@@ -101,7 +103,11 @@ struct V8Platform {
       StartTracingAgent();
     }
     // Tracing must be initialized before platform threads are created.
-    platform_ = new NodePlatform(thread_pool_size, controller);
+    platform_ = new NodePlatform(thread_pool_size,
+                                 controller,
+                                 nullptr,
+                                 user_blocking_thread_pool_size,
+                                 numa_affinity);
     v8::V8::InitializePlatform(platform_);
   }
   // Make sure V8Platform don not call into Libuv threadpool,
@@ -146,7 +152,10 @@ struct V8Platform {
           convert_to_set(categories),
           std::unique_ptr<tracing::AsyncTraceWriter>(
               new tracing::NodeTraceWriter(
-                  per_process::cli_options->trace_event_file_pattern)),
+                  per_process::cli_options->trace_event_file_pattern,
+                  per_process::cli_options->trace_event_format == "proto"
+                      ? tracing::NodeTraceWriter::Format::kProto
+                      : tracing::NodeTraceWriter::Format::kJSON)),
           tracing::Agent::kUseDefaultCategories);
     }
   }
@@ -164,7 +173,9 @@ struct V8Platform {
   tracing::AgentWriterHandle tracing_file_writer_;
   NodePlatform* platform_;
 #else   // !NODE_USE_V8_PLATFORM
-  inline void Initialize(int thread_pool_size) {}
+  inline void Initialize(int thread_pool_size,
+                         int user_blocking_thread_pool_size = 0,
+                         bool numa_affinity = false) {}
   inline void Dispose() {}
   inline void DrainVMTasks(v8::Isolate* isolate) {}
   inline void StartTracingAgent() {
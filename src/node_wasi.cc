@@ -7,6 +7,7 @@
 #include "node_errors.h"
 #include "node_mem-inl.h"
 #include "permission/permission.h"
+#include "threadpoolwork-inl.h"
 #include "util-inl.h"
 #include "uv.h"
 #include "uvwasi.h"
@@ -28,6 +29,7 @@ inline void Debug(const WASI& wasi, Args&&... args) {
 
 using v8::Array;
 using v8::ArrayBuffer;
+using v8::BackingStore;
 using v8::BigInt;
 using v8::CFunction;
 using v8::Context;
@@ -35,12 +37,14 @@ using v8::Exception;
 using v8::FastApiCallbackOptions;
 using v8::FunctionCallbackInfo;
 using v8::FunctionTemplate;
+using v8::Global;
 using v8::HandleScope;
 using v8::Integer;
 using v8::Isolate;
 using v8::Local;
 using v8::MaybeLocal;
 using v8::Object;
+using v8::Promise;
 using v8::Signature;
 using v8::String;
 using v8::Uint32;
@@ -78,10 +82,12 @@ static MaybeLocal<Value> WASIException(Local<Context> context,
 
 WASI::WASI(Environment* env,
            Local<Object> object,
-           uvwasi_options_t* options) : BaseObject(env, object) {
+           uvwasi_options_t* options,
+           bool async_io)
+    : BaseObject(env, object), async_io_(async_io) {
   MakeWeak();
   alloc_info_ = MakeAllocator();
-  options->allocator = &alloc_info_;
+  if (!async_io) options->allocator = &alloc_info_;
   int err = uvwasi_init(&uvw_, options);
   if (err != UVWASI_ESUCCESS) {
     Local<Value> exception;
@@ -117,7 +123,7 @@ void WASI::DecreaseAllocatedSize(size_t size) {
 
 void WASI::New(const FunctionCallbackInfo<Value>& args) {
   CHECK(args.IsConstructCall());
-  CHECK_EQ(args.Length(), 4);
+  CHECK_GE(args.Length(), 4);
   CHECK(args[0]->IsArray());
   CHECK(args[1]->IsArray());
   CHECK(args[2]->IsArray());
@@ -209,7 +215,7 @@ void WASI::New(const FunctionCallbackInfo<Value>& args) {
     index++;
   }
 
-  new WASI(env, args.This(), &options);
+  new WASI(env, args.This(), &options, args[4]->IsTrue());
 
   if (options.argv != nullptr) {
     for (uint32_t i = 0; i < argc; i++)
@@ -651,6 +657,48 @@ uint32_t WASI::FdFilestatSetTimes(WASI& wasi,
       &wasi.uvw_, fd, st_atim, st_mtim, fst_flags);
 }
 
+namespace {
+// Most reads and writes pass a handful of iovecs, which then live on the
+// stack.
+constexpr size_t kStackIovecs = 16;
+
+template <typename T>
+using IovecBuffer = MaybeStackBuffer<T, kStackIovecs>;
+
+// Decodes the iovec array at iovs_ptr into pointers into the linear
+// memory, which uvwasi passes on to readv() and writev() as they are.
+// The array bounds are checked without an overflowing multiplication.
+template <typename T>
+uvwasi_errno_t ReadIovecs(WasmMemory memory,
+                          uint32_t iovs_ptr,
+                          uint32_t iovs_len,
+                          IovecBuffer<T>* iovs) {
+  static_assert(UVWASI_SERDES_SIZE_iovec_t == UVWASI_SERDES_SIZE_ciovec_t);
+  if (!uvwasi_serdes_check_array_bounds(
+          iovs_ptr, memory.size, UVWASI_SERDES_SIZE_iovec_t, iovs_len)) {
+    return UVWASI_EOVERFLOW;
+  }
+  iovs->AllocateSufficientStorage(iovs_len);
+  for (uint32_t i = 0; i < iovs_len; i++) {
+    uvwasi_errno_t err;
+    if constexpr (std::is_same_v<T, uvwasi_iovec_t>) {
+      err = uvwasi_serdes_read_iovec_t(memory.data,
+                                       memory.size,
+                                       iovs_ptr,
+                                       iovs->out() + i);
+    } else {
+      err = uvwasi_serdes_read_ciovec_t(memory.data,
+                                        memory.size,
+                                        iovs_ptr,
+                                        iovs->out() + i);
+    }
+    if (err != UVWASI_ESUCCESS) return err;
+    iovs_ptr += UVWASI_SERDES_SIZE_iovec_t;
+  }
+  return UVWASI_ESUCCESS;
+}
+}  // namespace
+
 uint32_t WASI::FdPread(WASI& wasi,
                        WasmMemory memory,
                        uint32_t fd,
@@ -665,20 +713,15 @@ uint32_t WASI::FdPread(WASI& wasi,
         iovs_len,
         offset,
         nread_ptr);
-  CHECK_BOUNDS_OR_RETURN(
-      memory.size, iovs_ptr, iovs_len * UVWASI_SERDES_SIZE_iovec_t);
   CHECK_BOUNDS_OR_RETURN(memory.size, nread_ptr, UVWASI_SERDES_SIZE_size_t);
-  std::vector<uvwasi_iovec_t> iovs(iovs_len);
-  uvwasi_errno_t err;
-
-  err = uvwasi_serdes_readv_iovec_t(
-      memory.data, memory.size, iovs_ptr, iovs.data(), iovs_len);
+  IovecBuffer<uvwasi_iovec_t> iovs;
+  uvwasi_errno_t err = ReadIovecs(memory, iovs_ptr, iovs_len, &iovs);
   if (err != UVWASI_ESUCCESS) {
     return err;
   }
 
   uvwasi_size_t nread;
-  err = uvwasi_fd_pread(&wasi.uvw_, fd, iovs.data(), iovs_len, offset, &nread);
+  err = uvwasi_fd_pread(&wasi.uvw_, fd, *iovs, iovs_len, offset, &nread);
   if (err == UVWASI_ESUCCESS)
     uvwasi_serdes_write_size_t(memory.data, nread_ptr, nread);
 
@@ -725,21 +768,16 @@ uint32_t WASI::FdPwrite(WASI& wasi,
         iovs_len,
         offset,
         nwritten_ptr);
-  CHECK_BOUNDS_OR_RETURN(
-      memory.size, iovs_ptr, iovs_len * UVWASI_SERDES_SIZE_ciovec_t);
   CHECK_BOUNDS_OR_RETURN(memory.size, nwritten_ptr, UVWASI_SERDES_SIZE_size_t);
-  std::vector<uvwasi_ciovec_t> iovs(iovs_len);
-  uvwasi_errno_t err;
-
-  err = uvwasi_serdes_readv_ciovec_t(
-      memory.data, memory.size, iovs_ptr, iovs.data(), iovs_len);
+  IovecBuffer<uvwasi_ciovec_t> iovs;
+  uvwasi_errno_t err = ReadIovecs(memory, iovs_ptr, iovs_len, &iovs);
   if (err != UVWASI_ESUCCESS) {
     return err;
   }
 
   uvwasi_size_t nwritten;
   err = uvwasi_fd_pwrite(
-      &wasi.uvw_, fd, iovs.data(), iovs_len, offset, &nwritten);
+      &wasi.uvw_, fd, *iovs, iovs_len, offset, &nwritten);
   if (err == UVWASI_ESUCCESS)
     uvwasi_serdes_write_size_t(memory.data, nwritten_ptr, nwritten);
 
@@ -753,20 +791,15 @@ uint32_t WASI::FdRead(WASI& wasi,
                       uint32_t iovs_len,
                       uint32_t nread_ptr) {
   Debug(wasi, "fd_read(%d, %d, %d, %d)\n", fd, iovs_ptr, iovs_len, nread_ptr);
-  CHECK_BOUNDS_OR_RETURN(
-      memory.size, iovs_ptr, iovs_len * UVWASI_SERDES_SIZE_iovec_t);
   CHECK_BOUNDS_OR_RETURN(memory.size, nread_ptr, UVWASI_SERDES_SIZE_size_t);
-  std::vector<uvwasi_iovec_t> iovs(iovs_len);
-  uvwasi_errno_t err;
-
-  err = uvwasi_serdes_readv_iovec_t(
-      memory.data, memory.size, iovs_ptr, iovs.data(), iovs_len);
+  IovecBuffer<uvwasi_iovec_t> iovs;
+  uvwasi_errno_t err = ReadIovecs(memory, iovs_ptr, iovs_len, &iovs);
   if (err != UVWASI_ESUCCESS) {
     return err;
   }
 
   uvwasi_size_t nread;
-  err = uvwasi_fd_read(&wasi.uvw_, fd, iovs.data(), iovs_len, &nread);
+  err = uvwasi_fd_read(&wasi.uvw_, fd, *iovs, iovs_len, &nread);
   if (err == UVWASI_ESUCCESS)
     uvwasi_serdes_write_size_t(memory.data, nread_ptr, nread);
 
@@ -854,26 +887,155 @@ uint32_t WASI::FdWrite(WASI& wasi,
         iovs_ptr,
         iovs_len,
         nwritten_ptr);
-  CHECK_BOUNDS_OR_RETURN(
-      memory.size, iovs_ptr, iovs_len * UVWASI_SERDES_SIZE_ciovec_t);
   CHECK_BOUNDS_OR_RETURN(memory.size, nwritten_ptr, UVWASI_SERDES_SIZE_size_t);
-  std::vector<uvwasi_ciovec_t> iovs(iovs_len);
-  uvwasi_errno_t err;
-
-  err = uvwasi_serdes_readv_ciovec_t(
-      memory.data, memory.size, iovs_ptr, iovs.data(), iovs_len);
+  IovecBuffer<uvwasi_ciovec_t> iovs;
+  uvwasi_errno_t err = ReadIovecs(memory, iovs_ptr, iovs_len, &iovs);
   if (err != UVWASI_ESUCCESS) {
     return err;
   }
 
   uvwasi_size_t nwritten;
-  err = uvwasi_fd_write(&wasi.uvw_, fd, iovs.data(), iovs_len, &nwritten);
+  err = uvwasi_fd_write(&wasi.uvw_, fd, *iovs, iovs_len, &nwritten);
   if (err == UVWASI_ESUCCESS)
     uvwasi_serdes_write_size_t(memory.data, nwritten_ptr, nwritten);
 
   return err;
 }
 
+template <bool kWrite, bool kPositional>
+class WASI::AsyncIoWork final : public ThreadPoolWork {
+ public:
+  using Iovec = std::conditional_t<kWrite, uvwasi_ciovec_t, uvwasi_iovec_t>;
+
+  AsyncIoWork(WASI* wasi,
+              Local<Promise::Resolver> resolver,
+              std::shared_ptr<BackingStore> store,
+              uint32_t fd,
+              std::vector<Iovec>&& iovs,
+              uint64_t offset,
+              uint32_t result_ptr)
+      : ThreadPoolWork(wasi->env(), "wasi", ThreadPoolWorkClass::kFs),
+        wasi_(wasi),
+        resolver_(wasi->env()->isolate(), resolver),
+        store_(std::move(store)),
+        fd_(fd),
+        iovs_(std::move(iovs)),
+        offset_(offset),
+        result_ptr_(result_ptr) {}
+
+  void DoThreadPoolWork() override {
+    uvwasi_t* uvw = &wasi_->uvw_;
+    if constexpr (kWrite && kPositional) {
+      err_ = uvwasi_fd_pwrite(
+          uvw, fd_, iovs_.data(), iovs_.size(), offset_, &nbytes_);
+    } else if constexpr (kWrite) {
+      err_ = uvwasi_fd_write(uvw, fd_, iovs_.data(), iovs_.size(), &nbytes_);
+    } else if constexpr (kPositional) {
+      err_ = uvwasi_fd_pread(
+          uvw, fd_, iovs_.data(), iovs_.size(), offset_, &nbytes_);
+    } else {
+      err_ = uvwasi_fd_read(uvw, fd_, iovs_.data(), iovs_.size(), &nbytes_);
+    }
+  }
+
+  void AfterThreadPoolWork(int status) override {
+    std::unique_ptr<AsyncIoWork> self(this);
+    Environment* env = this->env();
+    Isolate* isolate = env->isolate();
+    HandleScope handle_scope(isolate);
+    Context::Scope context_scope(env->context());
+
+    if (status == UV_ECANCELED) {
+      err_ = UVWASI_ECANCELED;
+    } else if (err_ == UVWASI_ESUCCESS) {
+      // The memory may have grown while the wasm stack was suspended, which
+      // replaces its buffer, so write the result through the current one.
+      Local<ArrayBuffer> ab = wasi_->memory_.Get(isolate)->Buffer();
+      if (uvwasi_serdes_check_bounds(
+              result_ptr_, ab->ByteLength(), UVWASI_SERDES_SIZE_size_t)) {
+        uvwasi_serdes_write_size_t(ab->Data(), result_ptr_, nbytes_);
+      } else {
+        err_ = UVWASI_EOVERFLOW;
+      }
+    }
+    USE(resolver_.Get(isolate)->Resolve(
+        env->context(), Integer::NewFromUnsigned(isolate, err_)));
+  }
+
+ private:
+  BaseObjectPtr<WASI> wasi_;
+  Global<Promise::Resolver> resolver_;
+  // Keeps the memory that the iovecs point into alive.
+  std::shared_ptr<BackingStore> store_;
+  uint32_t fd_;
+  std::vector<Iovec> iovs_;
+  uint64_t offset_;
+  uint32_t result_ptr_;
+  uvwasi_errno_t err_ = UVWASI_ESUCCESS;
+  uvwasi_size_t nbytes_ = 0;
+};
+
+template <bool kWrite, bool kPositional>
+void WASI::AsyncIo(const FunctionCallbackInfo<Value>& args) {
+  // (fd, iovs_ptr, iovs_len, [offset,] result_ptr)
+  constexpr int kArgc = kPositional ? 5 : 4;
+  WASI* wasi;
+  ASSIGN_OR_RETURN_UNWRAP(&wasi, args.This());
+  if (!wasi->async_io_) return args.GetReturnValue().Set(UVWASI_ENOTSUP);
+  if (args.Length() != kArgc || !args[0]->IsUint32() ||
+      !args[1]->IsUint32() || !args[2]->IsUint32() ||
+      !args[kArgc - 1]->IsUint32() || (kPositional && !args[3]->IsBigInt())) {
+    return args.GetReturnValue().Set(UVWASI_EINVAL);
+  }
+  if (wasi->memory_.IsEmpty()) {
+    THROW_ERR_WASI_NOT_STARTED(wasi->env());
+    return;
+  }
+
+  Environment* env = wasi->env();
+  uint32_t fd = args[0].As<Uint32>()->Value();
+  uint32_t iovs_ptr = args[1].As<Uint32>()->Value();
+  uint32_t iovs_len = args[2].As<Uint32>()->Value();
+  uint64_t offset = 0;
+  if constexpr (kPositional) {
+    bool lossless;
+    offset = args[3].As<BigInt>()->Uint64Value(&lossless);
+  }
+  uint32_t result_ptr = args[kArgc - 1].As<Uint32>()->Value();
+  Debug(*wasi,
+        "async %s(%d, %d, %d, %d)\n",
+        kWrite ? (kPositional ? "fd_pwrite" : "fd_write")
+               : (kPositional ? "fd_pread" : "fd_read"),
+        fd,
+        iovs_ptr,
+        iovs_len,
+        result_ptr);
+
+  Local<ArrayBuffer> ab = wasi->memory_.Get(env->isolate())->Buffer();
+  WasmMemory memory{static_cast<char*>(ab->Data()), ab->ByteLength()};
+  if (!uvwasi_serdes_check_bounds(
+          result_ptr, memory.size, UVWASI_SERDES_SIZE_size_t)) {
+    return args.GetReturnValue().Set(UVWASI_EOVERFLOW);
+  }
+  using Iovec = typename AsyncIoWork<kWrite, kPositional>::Iovec;
+  IovecBuffer<Iovec> iovs;
+  uvwasi_errno_t err = ReadIovecs(memory, iovs_ptr, iovs_len, &iovs);
+  if (err != UVWASI_ESUCCESS) return args.GetReturnValue().Set(err);
+
+  Local<Promise::Resolver> resolver;
+  if (!Promise::Resolver::New(env->context()).ToLocal(&resolver)) return;
+  auto* work = new AsyncIoWork<kWrite, kPositional>(
+      wasi,
+      resolver,
+      ab->GetBackingStore(),
+      fd,
+      std::vector<Iovec>(*iovs, *iovs + iovs_len),
+      offset,
+      result_ptr);
+  work->ScheduleWork();
+  args.GetReturnValue().Set(resolver->GetPromise());
+}
+
 uint32_t WASI::PathCreateDirectory(WASI& wasi,
                                    WasmMemory memory,
                                    uint32_t fd,
@@ -1355,6 +1517,10 @@ static void InitializePreview1(Local<Object> target,
 #undef V
 
   SetInstanceMethod(isolate, tmpl, "_setMemory", WASI::_SetMemory);
+  SetProtoMethod(isolate, tmpl, "fd_read_async", WASI::AsyncIo<false, false>);
+  SetProtoMethod(isolate, tmpl, "fd_write_async", WASI::AsyncIo<true, false>);
+  SetProtoMethod(isolate, tmpl, "fd_pread_async", WASI::AsyncIo<false, true>);
+  SetProtoMethod(isolate, tmpl, "fd_pwrite_async", WASI::AsyncIo<true, true>);
 
   SetConstructorFunction(context, target, "WASI", tmpl);
 }
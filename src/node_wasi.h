@@ -21,7 +21,8 @@ class WASI : public BaseObject,
  public:
   WASI(Environment* env,
        v8::Local<v8::Object> object,
-       uvwasi_options_t* options);
+       uvwasi_options_t* options,
+       bool async_io);
   static void New(const v8::FunctionCallbackInfo<v8::Value>& args);
 
   void MemoryInfo(MemoryTracker* tracker) const override;
@@ -146,6 +147,15 @@ class WASI : public BaseObject,
 
   static void _SetMemory(const v8::FunctionCallbackInfo<v8::Value>& args);
 
+  // Variants of fd_read, fd_write, fd_pread and fd_pwrite that run on the
+  // threadpool and return a promise for the errno. They are meant to be
+  // wrapped in WebAssembly.Suspending, so that JSPI suspends the wasm stack
+  // while the I/O runs, and are only available when the WASI instance was
+  // created with async I/O enabled. Errors found before the I/O starts are
+  // returned synchronously.
+  template <bool kWrite, bool kPositional>
+  static void AsyncIo(const v8::FunctionCallbackInfo<v8::Value>& args);
+
   // Implementation for mem::NgLibMemoryManager
   void CheckAllocatedSize(size_t previous_size) const;
   void IncreaseAllocatedSize(size_t size);
@@ -169,8 +179,15 @@ class WASI : public BaseObject,
   };
 
  private:
+  template <bool kWrite, bool kPositional>
+  class AsyncIoWork;
+
   ~WASI() override;
   uvwasi_t uvw_;
+  // With async I/O, uvwasi is called from the threadpool too, so it uses
+  // its default allocator rather than the tracking one, which is tied to
+  // the main thread.
+  const bool async_io_;
   v8::Global<v8::WasmMemoryObject> memory_;
   uvwasi_mem_t alloc_info_;
   size_t current_uvwasi_memory_ = 0;
@@ -1,23 +1,36 @@
 #include "node_wasm_web_api.h"
 
+#include "compile_cache.h"
+#include "env-inl.h"
 #include "memory_tracker-inl.h"
 #include "node_errors.h"
 #include "node_external_reference.h"
+#include "node_options-inl.h"
+#include "threadpoolwork-inl.h"
 
 namespace node {
 namespace wasm_web_api {
 
 using v8::ArrayBuffer;
 using v8::ArrayBufferView;
+using v8::CompiledWasmModule;
 using v8::Context;
 using v8::Function;
 using v8::FunctionCallbackInfo;
 using v8::FunctionTemplate;
+using v8::HandleScope;
+using v8::Int32;
 using v8::Isolate;
 using v8::Local;
+using v8::Maybe;
 using v8::MaybeLocal;
+using v8::MicrotasksScope;
 using v8::Object;
+using v8::OwnedBuffer;
+using v8::Promise;
 using v8::Value;
+using v8::WasmAsyncSuccess;
+using v8::WasmModuleObject;
 using v8::WasmStreaming;
 
 Local<Function> WasmStreamingObject::Initialize(Environment* env) {
@@ -35,6 +48,7 @@ Local<Function> WasmStreamingObject::Initialize(Environment* env) {
   SetProtoMethod(isolate, t, "push", Push);
   SetProtoMethod(isolate, t, "finish", Finish);
   SetProtoMethod(isolate, t, "abort", Abort);
+  SetProtoMethod(isolate, t, "pushFile", PushFile);
 
   auto function = t->GetFunction(env->context()).ToLocalChecked();
   env->set_wasm_streaming_object_constructor(function);
@@ -47,6 +61,7 @@ void WasmStreamingObject::RegisterExternalReferences(
   registry->Register(Push);
   registry->Register(Finish);
   registry->Register(Abort);
+  registry->Register(PushFile);
 }
 
 void WasmStreamingObject::MemoryInfo(MemoryTracker* tracker) const {
@@ -70,6 +85,28 @@ MaybeLocal<Object> WasmStreamingObject::Create(
   CHECK_NOT_NULL(ptr);
   ptr->streaming_ = streaming;
   ptr->wasm_size_ = 0;
+
+  // Unlike V8's own code cache, a compiled module can only be serialized
+  // once its functions have been tiered up, which V8 reports later on.
+  if (env->use_compile_cache()) {
+    auto target = std::make_shared<CacheTarget>();
+    target->is_debug = env->compile_cache_handler()->is_debug();
+    ptr->cache_target_ = target;
+    streaming->SetMoreFunctionsCanBeSerializedCallback(
+        [target](CompiledWasmModule module) {
+          std::shared_ptr<const CompileCacheEntry> entry;
+          {
+            Mutex::ScopedLock lock(target->mutex);
+            entry = target->entry;
+          }
+          if (!entry) return;
+          OwnedBuffer serialized = module.Serialize();
+          CompileCacheHandler::WriteWasm(*entry,
+                                         target->is_debug,
+                                         serialized.buffer.get(),
+                                         serialized.size);
+        });
+  }
   return obj;
 }
 
@@ -88,6 +125,38 @@ void WasmStreamingObject::SetURL(const FunctionCallbackInfo<Value>& args) {
   CHECK(args[0]->IsString());
   Utf8Value url(Environment::GetCurrent(args)->isolate(), args[0]);
   obj->streaming_->SetUrl(url.out(), url.length());
+  if (obj->cache_target_) obj->url_ = url.ToString();
+}
+
+void WasmStreamingObject::OnBytesReceived(const uint8_t* data, size_t size) {
+  // Internally, V8 will make a copy.
+  streaming_->OnBytesReceived(data, size);
+  wasm_size_ += size;
+  if (cache_target_) {
+    wasm_hash_ = CompileCacheHandler::ExtendHash(wasm_hash_, data, size);
+  }
+}
+
+void WasmStreamingObject::FinishStreaming() {
+  // Modules without a URL are not cached, as they cannot be told apart.
+  std::unique_ptr<v8::ScriptCompiler::CachedData> compiled;
+  if (cache_target_ && !url_.empty() && wasm_size_ <= UINT32_MAX) {
+    std::shared_ptr<CompileCacheEntry> entry =
+        env()->compile_cache_handler()->ReadWasm(
+            url_, wasm_hash_, static_cast<uint32_t>(wasm_size_));
+    // V8 falls back to compiling the wire bytes if the compiled module
+    // does not deserialize, e.g. because it was produced by another V8.
+    if (entry->cache != nullptr &&
+        streaming_->SetCompiledModuleBytes(entry->cache->data,
+                                           entry->cache->length)) {
+      compiled = std::move(entry->cache);
+    }
+    entry->cache.reset();
+    Mutex::ScopedLock lock(cache_target_->mutex);
+    cache_target_->entry = std::move(entry);
+  }
+  // The compiled module bytes must stay alive until Finish() returns.
+  streaming_->Finish();
 }
 
 void WasmStreamingObject::Push(const FunctionCallbackInfo<Value>& args) {
@@ -95,6 +164,7 @@ void WasmStreamingObject::Push(const FunctionCallbackInfo<Value>& args) {
   ASSIGN_OR_RETURN_UNWRAP(&obj, args.This());
   CHECK(obj->streaming_);
 
+  CHECK(!obj->reading_file_);
   CHECK_EQ(args.Length(), 1);
   Local<Value> chunk = args[0];
 
@@ -120,10 +190,7 @@ void WasmStreamingObject::Push(const FunctionCallbackInfo<Value>& args) {
         "chunk must be an ArrayBufferView or an ArrayBuffer");
   }
 
-  // Forward the data to V8. Internally, V8 will make a copy.
-  obj->streaming_->OnBytesReceived(static_cast<const uint8_t*>(bytes) + offset,
-                                   size);
-  obj->wasm_size_ += size;
+  obj->OnBytesReceived(static_cast<const uint8_t*>(bytes) + offset, size);
 }
 
 void WasmStreamingObject::Finish(const FunctionCallbackInfo<Value>& args) {
@@ -131,8 +198,9 @@ void WasmStreamingObject::Finish(const FunctionCallbackInfo<Value>& args) {
   ASSIGN_OR_RETURN_UNWRAP(&obj, args.This());
   CHECK(obj->streaming_);
 
+  CHECK(!obj->reading_file_);
   CHECK_EQ(args.Length(), 0);
-  obj->streaming_->Finish();
+  obj->FinishStreaming();
 }
 
 void WasmStreamingObject::Abort(const FunctionCallbackInfo<Value>& args) {
@@ -140,10 +208,75 @@ void WasmStreamingObject::Abort(const FunctionCallbackInfo<Value>& args) {
   ASSIGN_OR_RETURN_UNWRAP(&obj, args.This());
   CHECK(obj->streaming_);
 
+  CHECK(!obj->reading_file_);
   CHECK_EQ(args.Length(), 1);
   obj->streaming_->Abort(args[0]);
 }
 
+// Reads a file in chunks on the threadpool. While V8 compiles one chunk,
+// the next one is already being read.
+class WasmStreamingObject::FileReader final : public ThreadPoolWork {
+ public:
+  FileReader(WasmStreamingObject* streaming, uv_file fd)
+      : ThreadPoolWork(streaming->env(), "wasm", ThreadPoolWorkClass::kFs),
+        streaming_(streaming),
+        fd_(fd),
+        buffer_(new uint8_t[kChunkSize]),
+        spare_(new uint8_t[kChunkSize]) {}
+
+  void DoThreadPoolWork() override {
+    uv_fs_t req;
+    uv_buf_t buf = uv_buf_init(reinterpret_cast<char*>(buffer_.get()),
+                               kChunkSize);
+    result_ = uv_fs_read(nullptr, &req, fd_, &buf, 1, -1, nullptr);
+    uv_fs_req_cleanup(&req);
+  }
+
+  void AfterThreadPoolWork(int status) override {
+    Environment* env = this->env();
+    HandleScope handle_scope(env->isolate());
+    Context::Scope context_scope(env->context());
+    if (status == 0) status = result_;
+
+    if (status > 0) {
+      std::swap(buffer_, spare_);
+      ScheduleWork();
+      streaming_->OnBytesReceived(spare_.get(), status);
+      return;
+    }
+
+    std::unique_ptr<FileReader> self(this);
+    streaming_->reading_file_ = false;
+    if (status == 0) {
+      streaming_->FinishStreaming();
+    } else {
+      streaming_->streaming_->Abort(
+          UVException(env->isolate(), status, "read"));
+    }
+  }
+
+ private:
+  static constexpr size_t kChunkSize = 1024 * 1024;
+
+  BaseObjectPtr<WasmStreamingObject> streaming_;
+  uv_file fd_;
+  std::unique_ptr<uint8_t[]> buffer_;
+  std::unique_ptr<uint8_t[]> spare_;
+  int result_ = 0;
+};
+
+void WasmStreamingObject::PushFile(const FunctionCallbackInfo<Value>& args) {
+  WasmStreamingObject* obj;
+  ASSIGN_OR_RETURN_UNWRAP(&obj, args.This());
+  CHECK(obj->streaming_);
+  CHECK(!obj->reading_file_);
+
+  CHECK_EQ(args.Length(), 1);
+  CHECK(args[0]->IsInt32());
+  obj->reading_file_ = true;
+  (new FileReader(obj, args[0].As<Int32>()->Value()))->ScheduleWork();
+}
+
 void StartStreamingCompilation(const FunctionCallbackInfo<Value>& info) {
   // V8 passes an instance of v8::WasmStreaming to this callback, which we can
   // use to pass the WebAssembly module bytes to V8 as we receive them.
@@ -185,6 +318,102 @@ void StartStreamingCompilation(const FunctionCallbackInfo<Value>& info) {
   CHECK_IMPLIES(maybe_ret.ToLocal(&ret), ret->IsUndefined());
 }
 
+namespace {
+// Never deleted, as threads may still be exiting while the process does.
+SharedModuleCache* shared_module_cache = nullptr;
+bool shared_module_cache_initialized = false;
+}  // namespace
+
+SharedModuleCache* SharedModuleCache::Get() {
+  // Guarded by per_process::cli_options_mutex, which the callers hold.
+  if (!shared_module_cache_initialized) {
+    shared_module_cache_initialized = true;
+    int64_t mib = per_process::cli_options->wasm_shared_module_cache_size;
+    if (mib > 0) {
+      shared_module_cache =
+          new SharedModuleCache(static_cast<size_t>(mib) * 1024 * 1024);
+    }
+  }
+  return shared_module_cache;
+}
+
+void SharedModuleCache::Clear() {
+  if (shared_module_cache == nullptr) return;
+  Mutex::ScopedLock lock(shared_module_cache->mutex_);
+  shared_module_cache->entries_.clear();
+  shared_module_cache->size_ = 0;
+}
+
+void SharedModuleCache::Retain(CompiledWasmModule&& module) {
+  // Modules compiled from the same bytes share their native module, and
+  // with it the wire bytes, so the pointer identifies the compilation.
+  v8::MemorySpan<const uint8_t> wire_bytes = module.GetWireBytesRef();
+  if (wire_bytes.size() > capacity_) return;
+  Mutex::ScopedLock lock(mutex_);
+  for (auto it = entries_.begin(); it != entries_.end(); ++it) {
+    if (it->wire_bytes == wire_bytes.data()) {
+      entries_.splice(entries_.begin(), entries_, it);
+      return;
+    }
+  }
+  entries_.push_front(Entry{wire_bytes.data(), std::move(module)});
+  size_ += wire_bytes.size();
+  while (size_ > capacity_) {
+    size_ -= entries_.back().module.GetWireBytesRef().size();
+    entries_.pop_back();
+  }
+}
+
+static void RetainModule(Local<Value> value) {
+  if (!value->IsWasmModuleObject()) return;
+  SharedModuleCache* cache;
+  {
+    Mutex::ScopedLock lock(per_process::cli_options_mutex);
+    cache = SharedModuleCache::Get();
+  }
+  if (cache == nullptr) return;
+  cache->Retain(value.As<WasmModuleObject>()->GetCompiledModule());
+}
+
+bool RetainInstantiatedModule(const FunctionCallbackInfo<Value>& info) {
+  // `new WebAssembly.Module()` compiles synchronously without telling the
+  // embedder, so its result is retained once it gets instantiated.
+  if (info.IsConstructCall() && info.Length() > 0)
+    RetainModule(info[0]);
+  // Let V8 create the instance.
+  return false;
+}
+
+void ResolveWasmPromise(Isolate* isolate,
+                        Local<Context> context,
+                        Local<Promise::Resolver> resolver,
+                        Local<Value> result,
+                        WasmAsyncSuccess success) {
+  if (success == WasmAsyncSuccess::kSuccess) {
+    // WebAssembly.compile() resolves with the module, and
+    // WebAssembly.instantiate() of bytes with { module, instance }.
+    if (result->IsWasmModuleObject()) {
+      RetainModule(result);
+    } else if (result->IsObject()) {
+      Local<Value> module;
+      if (result.As<Object>()
+              ->GetRealNamedProperty(
+                  context, FIXED_ONE_BYTE_STRING(isolate, "module"))
+              .ToLocal(&module)) {
+        RetainModule(module);
+      }
+    }
+  }
+
+  // The same as what V8 does without a callback.
+  MicrotasksScope microtasks_scope(context,
+                                   MicrotasksScope::kDoNotRunMicrotasks);
+  Maybe<bool> ret = success == WasmAsyncSuccess::kSuccess
+                        ? resolver->Resolve(context, result)
+                        : resolver->Reject(context, result);
+  CHECK(ret.IsJust() ? ret.FromJust() : isolate->IsExecutionTerminating());
+}
+
 // Called once by JavaScript during initialization.
 void SetImplementation(const FunctionCallbackInfo<Value>& info) {
   Environment* env = Environment::GetCurrent(info);
@@ -4,9 +4,16 @@
 #if defined(NODE_WANT_INTERNALS) && NODE_WANT_INTERNALS
 
 #include "base_object-inl.h"
+#include "node_mutex.h"
 #include "v8.h"
 
+#include <list>
+#include <memory>
+#include <string>
+
 namespace node {
+struct CompileCacheEntry;
+
 namespace wasm_web_api {
 
 // Wrapper for interacting with a v8::WasmStreaming instance from JavaScript.
@@ -31,17 +38,88 @@ class WasmStreamingObject final : public BaseObject {
 
   ~WasmStreamingObject() override {}
 
+  // Where the serialized module is written once V8 has compiled enough of
+  // it with the top tier. Shared with the callback that V8 calls on its
+  // worker threads.
+  struct CacheTarget {
+    Mutex mutex;
+    // Set by Finish(), when the wire bytes are known.
+    std::shared_ptr<const CompileCacheEntry> entry;
+    bool is_debug = false;
+  };
+
+  class FileReader;
+
  private:
   static void New(const v8::FunctionCallbackInfo<v8::Value>& args);
   static void SetURL(const v8::FunctionCallbackInfo<v8::Value>& args);
   static void Push(const v8::FunctionCallbackInfo<v8::Value>& args);
   static void Finish(const v8::FunctionCallbackInfo<v8::Value>& args);
   static void Abort(const v8::FunctionCallbackInfo<v8::Value>& args);
+  // pushFile(fd): reads the rest of the file on the threadpool, passing it
+  // to V8 as it is read, and then finishes the compilation. A read error
+  // aborts it.
+  static void PushFile(const v8::FunctionCallbackInfo<v8::Value>& args);
+
+  void OnBytesReceived(const uint8_t* data, size_t size);
+  void FinishStreaming();
 
   std::shared_ptr<v8::WasmStreaming> streaming_;
   size_t wasm_size_ = 0;
+  // Set while pushFile() is in progress.
+  bool reading_file_ = false;
+  // With the compile cache enabled, the URL or file name that identifies
+  // the module and the hash of the bytes received so far.
+  std::string url_;
+  uint32_t wasm_hash_ = 0;
+  std::shared_ptr<CacheTarget> cache_target_;
 };
 
+// Keeps compiled modules alive for the whole process, so that the other
+// threads that compile the same bytes get the native code of the first one.
+// V8 already shares native modules between isolates by their wire bytes,
+// but only while some isolate still holds on to them, and a worker usually
+// starts after the previous one dropped its modules, or exits before the
+// next one compiled. The least recently retained modules are dropped once
+// their wire bytes exceed the capacity.
+class SharedModuleCache {
+ public:
+  // Returns nullptr when --wasm-shared-module-cache-size is 0. Must be called
+  // with per_process::cli_options_mutex held.
+  static SharedModuleCache* Get();
+  // Drops all the modules. Must be called before V8 is disposed.
+  static void Clear();
+
+  explicit SharedModuleCache(size_t capacity) : capacity_(capacity) {}
+
+  void Retain(v8::CompiledWasmModule&& module);
+
+  size_t size() const { return size_; }
+
+ private:
+  struct Entry {
+    const uint8_t* wire_bytes;
+    v8::CompiledWasmModule module;
+  };
+
+  Mutex mutex_;
+  // Most recently retained first.
+  std::list<Entry> entries_;
+  const size_t capacity_;
+  size_t size_ = 0;
+};
+
+// Installed as v8::Isolate::SetWasmInstanceCallback and
+// v8::Isolate::SetWasmAsyncResolvePromiseCallback when the shared module
+// cache is enabled, to retain the modules that get instantiated or
+// compiled asynchronously.
+bool RetainInstantiatedModule(const v8::FunctionCallbackInfo<v8::Value>& info);
+void ResolveWasmPromise(v8::Isolate* isolate,
+                        v8::Local<v8::Context> context,
+                        v8::Local<v8::Promise::Resolver> resolver,
+                        v8::Local<v8::Value> result,
+                        v8::WasmAsyncSuccess success);
+
 // This is a v8::WasmStreamingCallback implementation that must be passed to
 // v8::Isolate::SetWasmStreamingCallback when setting up the isolate in order to
 // enable the WebAssembly.(compile|instantiate)Streaming APIs.
@@ -10,6 +10,8 @@
 #include "sqlite3.h"
 #include "util-inl.h"
 
+#include <algorithm>
+
 namespace node {
 namespace webstorage {
 
@@ -56,6 +58,11 @@ using v8::Value;
     }                                                                          \
   } while (0)
 
+// The same as the busy_timeout that Open() sets.
+static constexpr int kBusyTimeoutMs = 3000;
+static constexpr uint64_t kMinRetryDelayMs = 10;
+static constexpr uint64_t kMaxRetryDelayMs = 1000;
+
 static void ThrowQuotaExceededException(Local<Context> context) {
   Isolate* isolate = context->GetIsolate();
   auto dom_exception_str = FIXED_ONE_BYTE_STRING(isolate, "DOMException");
@@ -93,6 +100,13 @@ Storage::Storage(Environment* env,
 }
 
 Storage::~Storage() {
+  // Writes that have not been flushed yet are lost if this fails.
+  Flush(true);
+  if (flush_timer_ != nullptr) {
+    env()->CloseHandle(flush_timer_, [](uv_timer_t* timer) { delete timer; });
+  }
+  // The connection cannot be closed while it has a statement.
+  data_version_stmt_ = nullptr;
   db_ = nullptr;
 }
 
@@ -166,7 +180,7 @@ Maybe<void> Storage::Open() {
 
   sqlite3* db = db_.get();
   if (db != nullptr) {
-    return JustVoid();
+    return Refresh();
   }
 
   int r = sqlite3_open(location_.c_str(), &db);
@@ -202,10 +216,184 @@ Maybe<void> Storage::Open() {
     CHECK_ERROR_OR_THROW(env(), r, SQLITE_OK, Nothing<void>());
   }
 
+  // Tells whether another connection has committed changes since the
+  // contents of the storage were loaded.
+  static constexpr std::string_view get_data_version_sql =
+      "PRAGMA data_version";
+  r = sqlite3_prepare_v2(db,
+                         get_data_version_sql.data(),
+                         get_data_version_sql.size(),
+                         &s,
+                         nullptr);
+  CHECK_ERROR_OR_THROW(env(), r, SQLITE_OK, Nothing<void>());
   db_ = conn_unique_ptr(db);
+  data_version_stmt_ = stmt_unique_ptr(s);
+  // All reads are served from memory, loaded by Refresh().
+  data_version_ = -1;
+  return Refresh();
+}
+
+Maybe<void> Storage::Refresh() {
+  sqlite3_stmt* stmt = data_version_stmt_.get();
+  CHECK_ERROR_OR_THROW(env(), sqlite3_step(stmt), SQLITE_ROW, Nothing<void>());
+  int64_t data_version = sqlite3_column_int64(stmt, 0);
+  sqlite3_reset(stmt);
+  if (data_version == data_version_) {
+    return JustVoid();
+  }
+  CHECK_ERROR_OR_THROW(env(), LoadItems(), SQLITE_OK, Nothing<void>());
+  data_version_ = data_version;
   return JustVoid();
 }
 
+int Storage::LoadItems() {
+  static constexpr std::string_view get_max_size_sql =
+      "SELECT max_size FROM nodejs_webstorage_state";
+  static constexpr std::string_view get_items_sql =
+      "SELECT key, value FROM nodejs_webstorage";
+
+  sqlite3* db = db_.get();
+  sqlite3_stmt* s = nullptr;
+  int r = sqlite3_prepare_v2(
+      db, get_max_size_sql.data(), get_max_size_sql.size(), &s, nullptr);
+  if (r != SQLITE_OK) return r;
+  auto stmt = stmt_unique_ptr(s);
+  if ((r = sqlite3_step(stmt.get())) != SQLITE_ROW) return r;
+  max_size_ = sqlite3_column_int64(stmt.get(), 0);
+
+  r = sqlite3_prepare_v2(
+      db, get_items_sql.data(), get_items_sql.size(), &s, nullptr);
+  if (r != SQLITE_OK) return r;
+  stmt = stmt_unique_ptr(s);
+  std::map<std::string, std::string> items;
+  while ((r = sqlite3_step(stmt.get())) == SQLITE_ROW) {
+    CHECK(sqlite3_column_type(stmt.get(), 0) == SQLITE_BLOB);
+    CHECK(sqlite3_column_type(stmt.get(), 1) == SQLITE_BLOB);
+    items.emplace(
+        std::string(
+            static_cast<const char*>(sqlite3_column_blob(stmt.get(), 0)),
+            sqlite3_column_bytes(stmt.get(), 0)),
+        std::string(
+            static_cast<const char*>(sqlite3_column_blob(stmt.get(), 1)),
+            sqlite3_column_bytes(stmt.get(), 1)));
+  }
+  if (r != SQLITE_DONE) return r;
+
+  // The changes made here that have not been written yet win over those of
+  // other connections.
+  if (pending_clear_) items.clear();
+  for (const auto& [key, value] : pending_) {
+    if (value.has_value()) {
+      items.insert_or_assign(key, *value);
+    } else {
+      items.erase(key);
+    }
+  }
+  // Counted the way the triggers in the database count.
+  total_size_ = 0;
+  for (const auto& [key, value] : items) {
+    total_size_ += key.size() + value.size();
+  }
+  items_ = std::move(items);
+  return SQLITE_OK;
+}
+
+void Storage::ScheduleFlush(uint64_t delay_ms) {
+  if (flush_timer_ == nullptr) {
+    flush_timer_ = new uv_timer_t();
+    CHECK_EQ(uv_timer_init(env()->event_loop(), flush_timer_), 0);
+    flush_timer_->data = this;
+    uv_unref(reinterpret_cast<uv_handle_t*>(flush_timer_));
+    // The timer does not keep the process alive, and does not run after
+    // process.exit(), so the changes are also flushed at exit. The callback
+    // owns the weak reference, as at-exit callbacks cannot be removed again.
+    env()->AtExit(FlushAtExit, new BaseObjectWeakPtr<Storage>(this));
+  }
+  // A flush that is due already writes the new changes, too, in the same
+  // transaction.
+  if (uv_is_active(reinterpret_cast<uv_handle_t*>(flush_timer_))) return;
+  uv_timer_start(flush_timer_, OnFlushTimer, delay_ms, 0);
+}
+
+void Storage::OnFlushTimer(uv_timer_t* timer) {
+  Storage* storage = static_cast<Storage*>(timer->data);
+  // Waiting for the lock would block the event loop.
+  int r = storage->Flush(false);
+  if ((r & 0xff) == SQLITE_BUSY || (r & 0xff) == SQLITE_LOCKED) {
+    storage->retry_delay_ms_ = std::clamp(
+        storage->retry_delay_ms_ * 2, kMinRetryDelayMs, kMaxRetryDelayMs);
+    storage->ScheduleFlush(storage->retry_delay_ms_);
+    return;
+  }
+  // After other errors, the changes stay pending, and are retried with the
+  // next change, or at exit.
+  storage->retry_delay_ms_ = 0;
+}
+
+void Storage::FlushAtExit(void* arg) {
+  std::unique_ptr<BaseObjectWeakPtr<Storage>> storage_ptr(
+      static_cast<BaseObjectWeakPtr<Storage>*>(arg));
+  Storage* storage = storage_ptr->get();
+  if (storage == nullptr) return;
+  // Nothing runs the event loop any more, so a retry would never happen.
+  storage->Flush(true);
+}
+
+int Storage::Flush(bool wait) {
+  if (db_ == nullptr || (!pending_clear_ && pending_.empty())) {
+    return SQLITE_OK;
+  }
+
+  static constexpr std::string_view upsert_sql =
+      "INSERT INTO nodejs_webstorage (key, value) VALUES (?, ?)"
+      "  ON CONFLICT (key) DO UPDATE SET value = EXCLUDED.value"
+      "  WHERE EXCLUDED.key = key";
+  static constexpr std::string_view delete_sql =
+      "DELETE FROM nodejs_webstorage WHERE key = ?";
+
+  sqlite3* db = db_.get();
+  sqlite3_busy_timeout(db, wait ? kBusyTimeoutMs : 0);
+  auto restore_busy_timeout = OnScopeLeave(
+      [&]() { sqlite3_busy_timeout(db_.get(), kBusyTimeoutMs); });
+  int r = sqlite3_exec(db, "BEGIN IMMEDIATE", nullptr, nullptr, nullptr);
+  if (r != SQLITE_OK) return r;
+  auto rollback = OnScopeLeave([&]() {
+    if (db != nullptr)
+      sqlite3_exec(db, "ROLLBACK", nullptr, nullptr, nullptr);
+  });
+
+  if (pending_clear_) {
+    r = sqlite3_exec(
+        db, "DELETE FROM nodejs_webstorage", nullptr, nullptr, nullptr);
+    if (r != SQLITE_OK) return r;
+  }
+
+  sqlite3_stmt* s = nullptr;
+  r = sqlite3_prepare_v2(db, upsert_sql.data(), upsert_sql.size(), &s, 0);
+  if (r != SQLITE_OK) return r;
+  auto upsert = stmt_unique_ptr(s);
+  r = sqlite3_prepare_v2(db, delete_sql.data(), delete_sql.size(), &s, 0);
+  if (r != SQLITE_OK) return r;
+  auto remove = stmt_unique_ptr(s);
+
+  for (const auto& [key, value] : pending_) {
+    sqlite3_stmt* stmt = value.has_value() ? upsert.get() : remove.get();
+    sqlite3_reset(stmt);
+    sqlite3_bind_blob(stmt, 1, key.data(), key.size(), SQLITE_STATIC);
+    if (value.has_value()) {
+      sqlite3_bind_blob(stmt, 2, value->data(), value->size(), SQLITE_STATIC);
+    }
+    if ((r = sqlite3_step(stmt)) != SQLITE_DONE) return r;
+  }
+
+  r = sqlite3_exec(db, "COMMIT", nullptr, nullptr, nullptr);
+  if (r != SQLITE_OK) return r;
+  db = nullptr;
+  pending_.clear();
+  pending_clear_ = false;
+  return SQLITE_OK;
+}
+
 void Storage::New(const FunctionCallbackInfo<Value>& args) {
   Environment* env = Environment::GetCurrent(args);
   Realm* realm = Realm::GetCurrent(args);
@@ -228,21 +416,31 @@ void Storage::New(const FunctionCallbackInfo<Value>& args) {
   new Storage(env, args.This(), location.ToStringView());
 }
 
+static std::string ToUTF16Bytes(Isolate* isolate, Local<Value> value) {
+  TwoByteValue utf16(isolate, value);
+  return std::string(reinterpret_cast<const char*>(utf16.out()),
+                     utf16.length() * sizeof(uint16_t));
+}
+
+static MaybeLocal<String> FromUTF16Bytes(Isolate* isolate,
+                                         const std::string& bytes) {
+  return String::NewFromTwoByte(
+      isolate,
+      reinterpret_cast<const uint16_t*>(bytes.data()),
+      NewStringType::kNormal,
+      bytes.size() / sizeof(uint16_t));
+}
+
 Maybe<void> Storage::Clear() {
   if (!Open().IsJust()) {
     return Nothing<void>();
   }
 
-  static constexpr std::string_view sql = "DELETE FROM nodejs_webstorage";
-  sqlite3_stmt* s = nullptr;
-  CHECK_ERROR_OR_THROW(
-      env(),
-      sqlite3_prepare_v2(db_.get(), sql.data(), sql.size(), &s, 0),
-      SQLITE_OK,
-      Nothing<void>());
-  auto stmt = stmt_unique_ptr(s);
-  CHECK_ERROR_OR_THROW(
-      env(), sqlite3_step(stmt.get()), SQLITE_DONE, Nothing<void>());
+  items_.clear();
+  pending_.clear();
+  pending_clear_ = true;
+  total_size_ = 0;
+  ScheduleFlush();
   return JustVoid();
 }
 
@@ -251,27 +449,15 @@ MaybeLocal<Array> Storage::Enumerate() {
     return Local<Array>();
   }
 
-  static constexpr std::string_view sql = "SELECT key FROM nodejs_webstorage";
-  sqlite3_stmt* s = nullptr;
-  int r = sqlite3_prepare_v2(db_.get(), sql.data(), sql.size(), &s, 0);
-  CHECK_ERROR_OR_THROW(env(), r, SQLITE_OK, Local<Array>());
-  auto stmt = stmt_unique_ptr(s);
   LocalVector<Value> values(env()->isolate());
-  Local<Value> value;
-  while ((r = sqlite3_step(stmt.get())) == SQLITE_ROW) {
-    CHECK(sqlite3_column_type(stmt.get(), 0) == SQLITE_BLOB);
-    auto size = sqlite3_column_bytes(stmt.get(), 0) / sizeof(uint16_t);
-    if (!String::NewFromTwoByte(env()->isolate(),
-                                reinterpret_cast<const uint16_t*>(
-                                    sqlite3_column_blob(stmt.get(), 0)),
-                                NewStringType::kNormal,
-                                size)
-             .ToLocal(&value)) {
+  values.reserve(items_.size());
+  for (const auto& item : items_) {
+    Local<String> value;
+    if (!FromUTF16Bytes(env()->isolate(), item.first).ToLocal(&value)) {
       return Local<Array>();
     }
     values.emplace_back(value);
   }
-  CHECK_ERROR_OR_THROW(env(), r, SQLITE_DONE, Local<Array>());
   return Array::New(env()->isolate(), values.data(), values.size());
 }
 
@@ -280,17 +466,7 @@ MaybeLocal<Value> Storage::Length() {
     return {};
   }
 
-  static constexpr std::string_view sql =
-      "SELECT count(*) FROM nodejs_webstorage";
-  sqlite3_stmt* s = nullptr;
-  int r = sqlite3_prepare_v2(db_.get(), sql.data(), sql.size(), &s, 0);
-  CHECK_ERROR_OR_THROW(env(), r, SQLITE_OK, Local<Value>());
-  auto stmt = stmt_unique_ptr(s);
-  CHECK_ERROR_OR_THROW(
-      env(), sqlite3_step(stmt.get()), SQLITE_ROW, Local<Value>());
-  CHECK(sqlite3_column_type(stmt.get(), 0) == SQLITE_INTEGER);
-  int result = sqlite3_column_int(stmt.get(), 0);
-  return Integer::New(env()->isolate(), result);
+  return Integer::NewFromUnsigned(env()->isolate(), items_.size());
 }
 
 MaybeLocal<Value> Storage::Load(Local<Name> key) {
@@ -303,32 +479,11 @@ MaybeLocal<Value> Storage::Load(Local<Name> key) {
     return {};
   }
 
-  static constexpr std::string_view sql =
-      "SELECT value FROM nodejs_webstorage WHERE key = ? LIMIT 1";
-  sqlite3_stmt* s = nullptr;
-  int r = sqlite3_prepare_v2(db_.get(), sql.data(), sql.size(), &s, 0);
-  CHECK_ERROR_OR_THROW(env(), r, SQLITE_OK, Local<Value>());
-  auto stmt = stmt_unique_ptr(s);
-  TwoByteValue utf16key(env()->isolate(), key);
-  auto key_size = utf16key.length() * sizeof(uint16_t);
-  r = sqlite3_bind_blob(stmt.get(), 1, utf16key.out(), key_size, SQLITE_STATIC);
-  CHECK_ERROR_OR_THROW(env(), r, SQLITE_OK, Local<Value>());
-  r = sqlite3_step(stmt.get());
-  if (r == SQLITE_ROW) {
-    CHECK(sqlite3_column_type(stmt.get(), 0) == SQLITE_BLOB);
-    auto size = sqlite3_column_bytes(stmt.get(), 0) / sizeof(uint16_t);
-    return String::NewFromTwoByte(env()->isolate(),
-                                  reinterpret_cast<const uint16_t*>(
-                                      sqlite3_column_blob(stmt.get(), 0)),
-                                  NewStringType::kNormal,
-                                  size)
-        .As<Value>();
-  } else if (r != SQLITE_DONE) {
-    THROW_SQLITE_ERROR(env(), r);
-    return {};
-  } else {
+  auto it = items_.find(ToUTF16Bytes(env()->isolate(), key));
+  if (it == items_.end()) {
     return Null(env()->isolate());
   }
+  return FromUTF16Bytes(env()->isolate(), it->second).As<Value>();
 }
 
 MaybeLocal<Value> Storage::LoadKey(const int index) {
@@ -336,31 +491,12 @@ MaybeLocal<Value> Storage::LoadKey(const int index) {
     return {};
   }
 
-  static constexpr std::string_view sql =
-      "SELECT key FROM nodejs_webstorage LIMIT 1 OFFSET ?";
-  sqlite3_stmt* s = nullptr;
-  int r = sqlite3_prepare_v2(db_.get(), sql.data(), sql.size(), &s, 0);
-  CHECK_ERROR_OR_THROW(env(), r, SQLITE_OK, Local<Value>());
-  auto stmt = stmt_unique_ptr(s);
-  r = sqlite3_bind_int(stmt.get(), 1, index);
-  CHECK_ERROR_OR_THROW(env(), r, SQLITE_OK, Local<Value>());
-
-  r = sqlite3_step(stmt.get());
-  if (r == SQLITE_ROW) {
-    CHECK(sqlite3_column_type(stmt.get(), 0) == SQLITE_BLOB);
-    auto size = sqlite3_column_bytes(stmt.get(), 0) / sizeof(uint16_t);
-    return String::NewFromTwoByte(env()->isolate(),
-                                  reinterpret_cast<const uint16_t*>(
-                                      sqlite3_column_blob(stmt.get(), 0)),
-                                  NewStringType::kNormal,
-                                  size)
-        .As<Value>();
-  } else if (r != SQLITE_DONE) {
-    THROW_SQLITE_ERROR(env(), r);
-    return {};
-  } else {
+  if (static_cast<size_t>(index) >= items_.size()) {
     return Null(env()->isolate());
   }
+  auto it = items_.begin();
+  std::advance(it, index);
+  return FromUTF16Bytes(env()->isolate(), it->first).As<Value>();
 }
 
 Maybe<void> Storage::Remove(Local<Name> key) {
@@ -374,18 +510,14 @@ Maybe<void> Storage::Remove(Local<Name> key) {
     return Nothing<void>();
   }
 
-  static constexpr std::string_view sql =
-      "DELETE FROM nodejs_webstorage WHERE key = ?";
-  sqlite3_stmt* s = nullptr;
-  int r = sqlite3_prepare_v2(db_.get(), sql.data(), sql.size(), &s, 0);
-  CHECK_ERROR_OR_THROW(env(), r, SQLITE_OK, Nothing<void>());
-  auto stmt = stmt_unique_ptr(s);
-  TwoByteValue utf16key(env()->isolate(), key);
-  auto key_size = utf16key.length() * sizeof(uint16_t);
-  r = sqlite3_bind_blob(stmt.get(), 1, utf16key.out(), key_size, SQLITE_STATIC);
-  CHECK_ERROR_OR_THROW(env(), r, SQLITE_OK, Nothing<void>());
-  CHECK_ERROR_OR_THROW(
-      env(), sqlite3_step(stmt.get()), SQLITE_DONE, Nothing<void>());
+  auto it = items_.find(ToUTF16Bytes(env()->isolate(), key));
+  if (it == items_.end()) {
+    return JustVoid();
+  }
+  total_size_ -= it->first.size() + it->second.size();
+  pending_.insert_or_assign(it->first, std::nullopt);
+  items_.erase(it);
+  ScheduleFlush();
   return JustVoid();
 }
 
@@ -405,30 +537,25 @@ Maybe<void> Storage::Store(Local<Name> key, Local<Value> value) {
     return Nothing<void>();
   }
 
-  static constexpr std::string_view sql =
-      "INSERT INTO nodejs_webstorage (key, value) VALUES (?, ?)"
-      "  ON CONFLICT (key) DO UPDATE SET value = EXCLUDED.value"
-      "  WHERE EXCLUDED.key = key";
-  sqlite3_stmt* s = nullptr;
-  TwoByteValue utf16key(env()->isolate(), key);
-  TwoByteValue utf16val(env()->isolate(), val);
-  int r = sqlite3_prepare_v2(db_.get(), sql.data(), sql.size(), &s, 0);
-  CHECK_ERROR_OR_THROW(env(), r, SQLITE_OK, Nothing<void>());
-  auto stmt = stmt_unique_ptr(s);
-  auto key_size = utf16key.length() * sizeof(uint16_t);
-  r = sqlite3_bind_blob(stmt.get(), 1, utf16key.out(), key_size, SQLITE_STATIC);
-  CHECK_ERROR_OR_THROW(env(), r, SQLITE_OK, Nothing<void>());
-  auto val_size = utf16val.length() * sizeof(uint16_t);
-  r = sqlite3_bind_blob(stmt.get(), 2, utf16val.out(), val_size, SQLITE_STATIC);
-  CHECK_ERROR_OR_THROW(env(), r, SQLITE_OK, Nothing<void>());
+  std::string utf16key = ToUTF16Bytes(env()->isolate(), key);
+  std::string utf16val = ToUTF16Bytes(env()->isolate(), val);
 
-  r = sqlite3_step(stmt.get());
-  if (r == SQLITE_CONSTRAINT) {
+  // Enforce the quota here, the way the triggers in the database do, as the
+  // write only reaches the database later.
+  auto it = items_.find(utf16key);
+  int64_t total_size = total_size_ + utf16key.size() + utf16val.size();
+  if (it != items_.end()) {
+    total_size -= it->first.size() + it->second.size();
+  }
+  if (total_size > max_size_) {
     ThrowQuotaExceededException(env()->context());
     return Nothing<void>();
   }
 
-  CHECK_ERROR_OR_THROW(env(), r, SQLITE_DONE, Nothing<void>());
+  total_size_ = total_size;
+  pending_.insert_or_assign(utf16key, utf16val);
+  items_.insert_or_assign(std::move(utf16key), std::move(utf16val));
+  ScheduleFlush();
   return JustVoid();
 }
 
@@ -8,6 +8,10 @@
 #include "sqlite3.h"
 #include "util.h"
 
+#include <map>
+#include <optional>
+#include <string>
+
 namespace node {
 namespace webstorage {
 
@@ -46,11 +50,40 @@ class Storage : public BaseObject {
 
  private:
   v8::Maybe<void> Open();
+  // Reloads the contents of the storage if another connection, such as one
+  // in another process, has changed the database since they were loaded.
+  v8::Maybe<void> Refresh();
+  // Loads the contents of the storage, with the pending changes applied.
+  int LoadItems();
+  // Writes the pending changes to the database in one transaction, and
+  // returns the SQLite result code. Unless |wait| is set, it fails with
+  // SQLITE_BUSY right away if another connection holds the write lock.
+  int Flush(bool wait);
+  void ScheduleFlush(uint64_t delay_ms = 0);
+  static void OnFlushTimer(uv_timer_t* timer);
+  static void FlushAtExit(void* arg);
 
   ~Storage() override;
   std::string location_;
   conn_unique_ptr db_;
+  stmt_unique_ptr data_version_stmt_;
+  int64_t data_version_ = 0;
   v8::Global<v8::Map> symbols_;
+
+  // The contents of the storage, keys and values as UTF-16 bytes, in the
+  // order in which SQLite sorts them.
+  std::map<std::string, std::string> items_;
+  // Changes not written to the database yet. A missing value is a removal,
+  // and pending_clear_ empties the table first.
+  std::map<std::string, std::optional<std::string>> pending_;
+  bool pending_clear_ = false;
+  // Unref'd, and created with the first change. It flushes the changes made
+  // in the meantime, and retries a flush that found the database locked,
+  // with a delay that doubles up to kMaxRetryDelayMs.
+  uv_timer_t* flush_timer_ = nullptr;
+  uint64_t retry_delay_ms_ = 0;
+  int64_t max_size_ = 0;
+  int64_t total_size_ = 0;
 };
 
 }  // namespace webstorage
@@ -6,9 +6,11 @@
 #include "node_buffer.h"
 #include "node_errors.h"
 #include "node_external_reference.h"
+#include "node_numa.h"
 #include "node_options-inl.h"
 #include "node_perf.h"
 #include "node_snapshot_builder.h"
+#include "node_thread_stats.h"
 #include "permission/permission.h"
 #include "util-inl.h"
 #include "v8-cppgc.h"
@@ -40,6 +42,7 @@ using v8::ResourceConstraints;
 using v8::SealHandleScope;
 using v8::String;
 using v8::TryCatch;
+using v8::Uint32;
 using v8::Value;
 
 namespace node {
@@ -138,6 +141,128 @@ void Worker::UpdateResourceConstraints(ResourceConstraints* constraints) {
   }
 }
 
+WorkerIsolatePool::WorkerIsolatePool(MultiIsolatePlatform* platform,
+                                     const SnapshotData* snapshot_data,
+                                     size_t size)
+    : platform_(platform), snapshot_data_(snapshot_data), size_(size) {
+  // Isolate creation doesn't need much stack, but match the default stack
+  // size of worker threads to be safe.
+  uv_thread_options_t thread_options;
+  thread_options.flags = UV_THREAD_HAS_STACK_SIZE;
+  thread_options.stack_size = 4 * 1024 * 1024;
+  CHECK_EQ(uv_thread_create_ex(
+               &thread_,
+               &thread_options,
+               [](void* data) {
+                 uv_thread_setname("WorkerIsolatePool");
+                 static_cast<WorkerIsolatePool*>(data)->Run();
+               },
+               this),
+           0);
+}
+
+WorkerIsolatePool::~WorkerIsolatePool() {
+  {
+    Mutex::ScopedLock lock(mutex_);
+    stopping_ = true;
+    cond_.Signal(lock);
+  }
+  CHECK_EQ(uv_thread_join(&thread_), 0);
+}
+
+std::unique_ptr<WorkerIsolatePool::Entry> WorkerIsolatePool::Take(
+    const SnapshotData* snapshot_data) {
+  if (snapshot_data != snapshot_data_) return nullptr;
+  Mutex::ScopedLock lock(mutex_);
+  if (ready_.empty()) return nullptr;
+  std::unique_ptr<Entry> entry = std::move(ready_.front());
+  ready_.pop_front();
+  // Have the pool thread prepare a replacement.
+  cond_.Signal(lock);
+  return entry;
+}
+
+void WorkerIsolatePool::SetSize(size_t size) {
+  Mutex::ScopedLock lock(mutex_);
+  size_ = size;
+  cond_.Signal(lock);
+}
+
+std::unique_ptr<WorkerIsolatePool::Entry> WorkerIsolatePool::CreateEntry() {
+  auto entry = std::make_unique<Entry>();
+  entry->loop = std::make_unique<uv_loop_t>();
+  if (uv_loop_init(entry->loop.get()) != 0) return nullptr;
+  uv_loop_configure(entry->loop.get(), UV_METRICS_IDLE_TIME);
+
+  entry->allocator = ArrayBufferAllocator::Create();
+  Isolate::CreateParams params;
+  SetIsolateCreateParamsForNode(&params);
+  params.array_buffer_allocator_shared = entry->allocator;
+  entry->max_young_generation_size =
+      params.constraints.max_young_generation_size_in_bytes();
+  entry->max_old_generation_size =
+      params.constraints.max_old_generation_size_in_bytes();
+  entry->code_range_size = params.constraints.code_range_size_in_bytes();
+  entry->isolate =
+      NewIsolate(&params, entry->loop.get(), platform_, snapshot_data_);
+  if (entry->isolate == nullptr) {
+    CheckedUvLoopClose(entry->loop.get());
+    return nullptr;
+  }
+  SetIsolateUpForNode(entry->isolate);
+  return entry;
+}
+
+void WorkerIsolatePool::Dispose(MultiIsolatePlatform* platform,
+                                Entry* entry) {
+  bool platform_finished = false;
+  platform->AddIsolateFinishedCallback(entry->isolate, [](void* data) {
+    *static_cast<bool*>(data) = true;
+  }, &platform_finished);
+  platform->DisposeIsolate(entry->isolate);
+  while (!platform_finished) {
+    uv_run(entry->loop.get(), UV_RUN_ONCE);
+  }
+  CheckedUvLoopClose(entry->loop.get());
+}
+
+void WorkerIsolatePool::Run() {
+  std::deque<std::unique_ptr<Entry>> unused;
+  {
+    Mutex::ScopedLock lock(mutex_);
+    while (!stopping_) {
+      if (ready_.size() > size_) {
+        while (ready_.size() > size_) {
+          unused.push_back(std::move(ready_.back()));
+          ready_.pop_back();
+        }
+        // Free the isolates as soon as the pool shrinks, rather than
+        // holding on to them until the next one is created.
+        Mutex::ScopedUnlock unlock(lock);
+        for (auto& idle : unused) Dispose(platform_, idle.get());
+        unused.clear();
+        continue;
+      }
+      if (ready_.size() == size_) {
+        cond_.Wait(lock);
+        continue;
+      }
+      std::unique_ptr<Entry> entry;
+      {
+        Mutex::ScopedUnlock unlock(lock);
+        entry = CreateEntry();
+      }
+      // Stop refilling if isolates can't be created; workers then create
+      // their own.
+      if (!entry) break;
+      ready_.push_back(std::move(entry));
+    }
+    for (auto& entry : ready_) unused.push_back(std::move(entry));
+    ready_.clear();
+  }
+  for (auto& entry : unused) Dispose(platform_, entry.get());
+}
+
 // This class contains data that is only relevant to the child thread itself,
 // and only while it is running.
 // (Eventually, the Environment instance should probably also be moved here.)
@@ -145,34 +270,63 @@ class WorkerThreadData {
  public:
   explicit WorkerThreadData(Worker* w)
     : w_(w) {
-    int ret = uv_loop_init(&loop_);
-    if (ret != 0) {
-      char err_buf[128];
-      uv_err_name_r(ret, err_buf, sizeof(err_buf));
-      // TODO(joyeecheung): maybe this should be kBootstrapFailure instead?
-      w->Exit(ExitCode::kGenericUserError, "ERR_WORKER_INIT_FAILED", err_buf);
-      return;
-    }
-    loop_init_failed_ = false;
-    uv_loop_configure(&loop_, UV_METRICS_IDLE_TIME);
-
-    std::shared_ptr<ArrayBufferAllocator> allocator =
-        ArrayBufferAllocator::Create();
-    Isolate::CreateParams params;
-    SetIsolateCreateParamsForNode(&params);
-    w->UpdateResourceConstraints(&params.constraints);
-    params.array_buffer_allocator_shared = allocator;
-    Isolate* isolate =
-        NewIsolate(&params, &loop_, w->platform_, w->snapshot_data());
-    if (isolate == nullptr) {
-      // TODO(joyeecheung): maybe this should be kBootstrapFailure instead?
-      w->Exit(ExitCode::kGenericUserError,
-              "ERR_WORKER_INIT_FAILED",
-              "Failed to create new Isolate");
-      return;
+    std::shared_ptr<ArrayBufferAllocator> allocator;
+    Isolate* isolate = nullptr;
+    size_t max_young_gen_size = 0;
+
+    std::unique_ptr<WorkerIsolatePool::Entry> pooled;
+    {
+      std::shared_ptr<WorkerIsolatePool> pool = std::move(w->isolate_pool_);
+      if (pool && w->resource_limits_[kMaxYoungGenerationSizeMb] <= 0 &&
+          w->resource_limits_[kMaxOldGenerationSizeMb] <= 0 &&
+          w->resource_limits_[kCodeRangeSizeMb] <= 0) {
+        pooled = pool->Take(w->snapshot_data());
+      }
     }
+    if (pooled) {
+      Debug(w_, "Worker %llu uses an isolate from the pool", w_->thread_id_.id);
+      loop_ = std::move(pooled->loop);
+      loop_init_failed_ = false;
+      allocator = std::move(pooled->allocator);
+      isolate = pooled->isolate;
+      max_young_gen_size = pooled->max_young_generation_size;
+      w->resource_limits_[kMaxYoungGenerationSizeMb] =
+          pooled->max_young_generation_size / kMB;
+      w->resource_limits_[kMaxOldGenerationSizeMb] =
+          pooled->max_old_generation_size / kMB;
+      w->resource_limits_[kCodeRangeSizeMb] = pooled->code_range_size / kMB;
+    } else {
+      int ret = uv_loop_init(loop_.get());
+      if (ret != 0) {
+        char err_buf[128];
+        uv_err_name_r(ret, err_buf, sizeof(err_buf));
+        // TODO(joyeecheung): maybe this should be kBootstrapFailure instead?
+        w->Exit(
+            ExitCode::kGenericUserError, "ERR_WORKER_INIT_FAILED", err_buf);
+        return;
+      }
+      loop_init_failed_ = false;
+      uv_loop_configure(loop_.get(), UV_METRICS_IDLE_TIME);
+
+      allocator = ArrayBufferAllocator::Create();
+      Isolate::CreateParams params;
+      SetIsolateCreateParamsForNode(&params);
+      w->UpdateResourceConstraints(&params.constraints);
+      params.array_buffer_allocator_shared = allocator;
+      isolate =
+          NewIsolate(&params, loop_.get(), w->platform_, w->snapshot_data());
+      if (isolate == nullptr) {
+        // TODO(joyeecheung): maybe this should be kBootstrapFailure instead?
+        w->Exit(ExitCode::kGenericUserError,
+                "ERR_WORKER_INIT_FAILED",
+                "Failed to create new Isolate");
+        return;
+      }
 
-    SetIsolateUpForNode(isolate);
+      SetIsolateUpForNode(isolate);
+      max_young_gen_size =
+          params.constraints.max_young_generation_size_in_bytes();
+    }
 
     // Be sure it's called before Environment::InitializeDiagnostics()
     // so that this callback stays when the callback of
@@ -189,7 +343,7 @@ class WorkerThreadData {
       HandleScope handle_scope(isolate);
       isolate_data_.reset(IsolateData::CreateIsolateData(
           isolate,
-          &loop_,
+          loop_.get(),
           w_->platform_,
           allocator.get(),
           w->snapshot_data()->AsEmbedderWrapper().get(),
@@ -197,8 +351,7 @@ class WorkerThreadData {
       CHECK(isolate_data_);
       CHECK(!isolate_data_->is_building_snapshot());
       isolate_data_->set_worker_context(w_);
-      isolate_data_->max_young_gen_size =
-          params.constraints.max_young_generation_size_in_bytes();
+      isolate_data_->max_young_gen_size = max_young_gen_size;
     }
 
     Mutex::ScopedLock lock(w_->mutex_);
@@ -234,11 +387,11 @@ class WorkerThreadData {
 
       // Wait until the platform has cleaned up all relevant resources.
       while (!platform_finished) {
-        uv_run(&loop_, UV_RUN_ONCE);
+        uv_run(loop_.get(), UV_RUN_ONCE);
       }
     }
     if (!loop_init_failed_) {
-      CheckedUvLoopClose(&loop_);
+      CheckedUvLoopClose(loop_.get());
     }
   }
 
@@ -246,7 +399,7 @@ class WorkerThreadData {
 
  private:
   Worker* const w_;
-  uv_loop_t loop_;
+  std::unique_ptr<uv_loop_t> loop_ = std::make_unique<uv_loop_t>();
   bool loop_init_failed_ = true;
   DeleteFnPtr<IsolateData, FreeIsolateData> isolate_data_;
   const SnapshotData* snapshot_data_ = nullptr;
@@ -437,6 +590,20 @@ bool Worker::CreateEnvMessagePort(Environment* env) {
   return child_port;
 }
 
+void Worker::WaitForIsolateDisposal(Isolate* isolate) {
+  if (!tid_.has_value()) return;
+  Mutex::ScopedLock lock(mutex_);
+  while (!isolate_disposed_) {
+    {
+      Mutex::ScopedUnlock unlock(lock);
+      platform_->FlushForegroundTasks(isolate);
+    }
+    // A GlobalSafepointInterruptTask does not wake this thread up, so check
+    // for new tasks every millisecond.
+    isolate_disposed_cond_.TimedWait(lock, 1000 * 1000);
+  }
+}
+
 void Worker::JoinThread() {
   if (!tid_.has_value())
     return;
@@ -676,6 +843,34 @@ void Worker::New(const FunctionCallbackInfo<Value>& args) {
         ->DisableWaitOrBreakFirstLine();
   }
 
+  // The CPUs to run the worker thread on, and the NUMA node to allocate its
+  // memory from. Without a CPU list, the thread runs on the CPUs of the node.
+  std::vector<int> cpu_affinity;
+  if (args[7]->IsArray()) {
+    Local<Array> cpus = args[7].As<Array>();
+    int mask_size = uv_cpumask_size();
+    for (uint32_t i = 0; i < cpus->Length(); i++) {
+      Local<Value> cpu;
+      if (!cpus->Get(env->context(), i).ToLocal(&cpu)) return;
+      if (!cpu->IsUint32() ||
+          cpu.As<Uint32>()->Value() >= static_cast<uint32_t>(mask_size)) {
+        THROW_ERR_OUT_OF_RANGE(env, "CPU affinity index %u is out of range", i);
+        return;
+      }
+      cpu_affinity.push_back(cpu.As<Uint32>()->Value());
+    }
+  }
+  int numa_node = -1;
+  if (args[8]->IsUint32()) {
+    uint32_t node = args[8].As<Uint32>()->Value();
+    const std::vector<std::vector<int>>& node_cpus = numa::GetNodeCpus();
+    if (node >= node_cpus.size() || node_cpus[node].empty()) {
+      THROW_ERR_OUT_OF_RANGE(env, "NUMA node %u does not exist", node);
+      return;
+    }
+    numa_node = node;
+  }
+
   const SnapshotData* snapshot_data = env->isolate_data()->snapshot_data();
 
   Worker* worker = new Worker(env,
@@ -693,6 +888,8 @@ void Worker::New(const FunctionCallbackInfo<Value>& args) {
   CHECK_EQ(limit_info->Length(), kTotalResourceLimitCount);
   limit_info->CopyContents(worker->resource_limits_,
                            sizeof(worker->resource_limits_));
+  worker->cpu_affinity_ = std::move(cpu_affinity);
+  worker->numa_node_ = numa_node;
 
   CHECK(args[4]->IsBoolean());
   if (args[4]->IsTrue() || env->tracks_unmanaged_fds())
@@ -707,12 +904,32 @@ void Worker::New(const FunctionCallbackInfo<Value>& args) {
     worker->environment_flags_ |= EnvironmentFlags::kNoBrowserGlobals;
 }
 
+void Worker::ApplyThreadPlacement() {
+  // Placement is a performance hint, so failures (e.g. CPUs outside of the
+  // process's cpuset) are not fatal.
+  if (!cpu_affinity_.empty()) {
+    int err = numa::SetCurrentThreadAffinity(cpu_affinity_);
+    Debug(this, "Set CPU affinity of worker %llu: %d", thread_id_.id, err);
+  }
+  if (numa_node_ >= 0) {
+    int err = cpu_affinity_.empty()
+                  ? numa::BindCurrentThreadToNode(numa_node_)
+                  : numa::SetCurrentThreadPreferredNode(numa_node_);
+    Debug(this,
+          "Bound worker %llu to NUMA node %d: %d",
+          thread_id_.id,
+          numa_node_,
+          err);
+  }
+}
+
 void Worker::StartThread(const FunctionCallbackInfo<Value>& args) {
   Worker* w;
   ASSIGN_OR_RETURN_UNWRAP(&w, args.This());
   Mutex::ScopedLock lock(w->mutex_);
 
   w->stopped_ = false;
+  w->isolate_pool_ = w->env()->worker_isolate_pool();
 
   if (w->resource_limits_[kStackSizeMb] > 0) {
     if (w->resource_limits_[kStackSizeMb] * kMB < kStackBufferSize) {
@@ -739,13 +956,23 @@ void Worker::StartThread(const FunctionCallbackInfo<Value>& args) {
     const uintptr_t stack_top = reinterpret_cast<uintptr_t>(&arg);
 
     uv_thread_setname(w->name_.c_str());
+    thread_stats::SetCurrentThreadKind(thread_stats::kWorkerThread);
+    {
+      Mutex::ScopedLock lock(w->mutex_);
+      w->system_thread_id_ = thread_stats::GetCurrentThreadId();
+    }
+    w->ApplyThreadPlacement();
     // Leave a few kilobytes just to make sure we're within limits and have
     // some space to do work in C++ land.
     w->stack_base_ = stack_top - (w->stack_size_ - kStackBufferSize);
 
     w->Run();
 
+    thread_stats::ClearCurrentThreadKind();
     Mutex::ScopedLock lock(w->mutex_);
+    w->system_thread_id_ = -1;
+    w->isolate_disposed_ = true;
+    w->isolate_disposed_cond_.Broadcast(lock);
     w->env()->SetImmediateThreadsafe(
         [w = std::unique_ptr<Worker>(w)](Environment* env) {
           if (w->has_ref_)
@@ -1048,6 +1275,36 @@ void Worker::LoopIdleTime(const FunctionCallbackInfo<Value>& args) {
   args.GetReturnValue().Set(1.0 * idle_time / 1e6);
 }
 
+// cpuUsage(fields): fills fields with the CPU time in microseconds and the
+// context switches of the thread, as laid out by thread_stats::ThreadUsage.
+// Returns 0 or a libuv error code.
+void Worker::CpuUsage(const FunctionCallbackInfo<Value>& args) {
+  Worker* w;
+  ASSIGN_OR_RETURN_UNWRAP(&w, args.This());
+  CHECK(args[0]->IsFloat64Array());
+  Local<Float64Array> array = args[0].As<Float64Array>();
+  CHECK_EQ(array->Length(), thread_stats::kThreadUsageFieldCount);
+
+  thread_stats::ThreadUsage usage;
+  int err;
+  {
+    Mutex::ScopedLock lock(w->mutex_);
+    err = w->system_thread_id_ == -1
+              ? UV_ESRCH
+              : thread_stats::GetThreadUsage(w->system_thread_id_, &usage);
+  }
+  if (err == 0) {
+    double* fields = static_cast<double*>(array->Buffer()->Data()) +
+                     array->ByteOffset() / sizeof(double);
+    fields[0] = usage.threads;
+    fields[1] = usage.user;
+    fields[2] = usage.system;
+    fields[3] = usage.voluntary_switches;
+    fields[4] = usage.involuntary_switches;
+  }
+  args.GetReturnValue().Set(err);
+}
+
 void Worker::LoopStartTime(const FunctionCallbackInfo<Value>& args) {
   Worker* w;
   ASSIGN_OR_RETURN_UNWRAP(&w, args.This());
@@ -1067,6 +1324,32 @@ void Worker::LoopStartTime(const FunctionCallbackInfo<Value>& args) {
 
 namespace {
 
+// setWorkerIsolatePoolSize(size)
+//
+// Keeps |size| isolates ready for new Worker threads of this Environment,
+// or stops doing so when |size| is 0.
+void SetWorkerIsolatePoolSize(const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+  CHECK(args[0]->IsUint32());
+  uint32_t size = args[0].As<Uint32>()->Value();
+
+  // Idle isolates in the pool would never reach the safepoints of a shared
+  // garbage collection.
+  if (per_process::cli_options->experimental_shared_heap) return;
+
+  std::shared_ptr<WorkerIsolatePool> pool = env->worker_isolate_pool();
+  if (size == 0) {
+    env->set_worker_isolate_pool(nullptr);
+  } else if (pool) {
+    pool->SetSize(size);
+  } else {
+    env->set_worker_isolate_pool(std::make_shared<WorkerIsolatePool>(
+        env->isolate_data()->platform(),
+        env->isolate_data()->snapshot_data(),
+        size));
+  }
+}
+
 // Return the MessagePort that is global for this Environment and communicates
 // with the internal [kPort] port of the JS Worker class in the parent thread.
 void GetEnvMessagePort(const FunctionCallbackInfo<Value>& args) {
@@ -1100,6 +1383,7 @@ void CreateWorkerPerIsolateProperties(IsolateData* isolate_data,
     SetProtoMethod(isolate, w, "takeHeapSnapshot", Worker::TakeHeapSnapshot);
     SetProtoMethod(isolate, w, "loopIdleTime", Worker::LoopIdleTime);
     SetProtoMethod(isolate, w, "loopStartTime", Worker::LoopStartTime);
+    SetProtoMethod(isolate, w, "cpuUsage", Worker::CpuUsage);
     SetProtoMethod(isolate, w, "getHeapStatistics", Worker::GetHeapStatistics);
 
     SetConstructorFunction(isolate, target, "Worker", w);
@@ -1134,6 +1418,8 @@ void CreateWorkerPerIsolateProperties(IsolateData* isolate_data,
   }
 
   SetMethod(isolate, target, "getEnvMessagePort", GetEnvMessagePort);
+  SetMethod(
+      isolate, target, "setWorkerIsolatePoolSize", SetWorkerIsolatePoolSize);
 }
 
 void CreateWorkerPerContextProperties(Local<Object> target,
@@ -1188,6 +1474,7 @@ void CreateWorkerPerContextProperties(Local<Object> target,
 
 void RegisterExternalReferences(ExternalReferenceRegistry* registry) {
   registry->Register(GetEnvMessagePort);
+  registry->Register(SetWorkerIsolatePoolSize);
   registry->Register(Worker::New);
   registry->Register(Worker::StartThread);
   registry->Register(Worker::StopThread);
@@ -1198,6 +1485,7 @@ void RegisterExternalReferences(ExternalReferenceRegistry* registry) {
   registry->Register(Worker::TakeHeapSnapshot);
   registry->Register(Worker::LoopIdleTime);
   registry->Register(Worker::LoopStartTime);
+  registry->Register(Worker::CpuUsage);
   registry->Register(Worker::GetHeapStatistics);
 }
 
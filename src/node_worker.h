@@ -3,10 +3,14 @@
 
 #if defined(NODE_WANT_INTERNALS) && NODE_WANT_INTERNALS
 
+#include <deque>
+#include <memory>
 #include <optional>
 #include <unordered_map>
+#include <vector>
 #include "node_exit_code.h"
 #include "node_messaging.h"
+#include "node_mutex.h"
 #include "uv.h"
 
 namespace node {
@@ -24,6 +28,54 @@ enum ResourceLimits {
   kTotalResourceLimitCount
 };
 
+// Isolates for Worker threads that are created, and deserialized from the
+// snapshot, ahead of time on a background thread. Workers that use the
+// default resource limits take one of them instead of creating their own.
+// The pool is owned by the parent Environment and shared with the workers
+// that are being started, see setWorkerIsolatePoolSize().
+class WorkerIsolatePool {
+ public:
+  struct Entry {
+    std::unique_ptr<uv_loop_t> loop;
+    std::shared_ptr<ArrayBufferAllocator> allocator;
+    v8::Isolate* isolate = nullptr;
+    size_t max_young_generation_size = 0;
+    size_t max_old_generation_size = 0;
+    size_t code_range_size = 0;
+  };
+
+  WorkerIsolatePool(MultiIsolatePlatform* platform,
+                    const SnapshotData* snapshot_data,
+                    size_t size);
+  ~WorkerIsolatePool();
+
+  WorkerIsolatePool(const WorkerIsolatePool&) = delete;
+  WorkerIsolatePool& operator=(const WorkerIsolatePool&) = delete;
+
+  // Returns nullptr if no isolate for |snapshot_data| is ready. May be
+  // called from any thread.
+  std::unique_ptr<Entry> Take(const SnapshotData* snapshot_data);
+  void SetSize(size_t size);
+
+  // Disposes of an isolate that was never handed out.
+  static void Dispose(MultiIsolatePlatform* platform, Entry* entry);
+
+ private:
+  std::unique_ptr<Entry> CreateEntry();
+  void Run();
+
+  MultiIsolatePlatform* const platform_;
+  const SnapshotData* const snapshot_data_;
+  uv_thread_t thread_;
+
+  // This mutex protects access to all variables listed below it.
+  Mutex mutex_;
+  ConditionVariable cond_;
+  bool stopping_ = false;
+  size_t size_;
+  std::deque<std::unique_ptr<Entry>> ready_;
+};
+
 // A worker thread, as represented in its parent thread.
 class Worker : public AsyncWrap {
  public:
@@ -50,6 +102,10 @@ class Worker : public AsyncWrap {
 
   // Wait for the worker thread to stop (in a blocking manner).
   void JoinThread();
+  // Wait for the worker thread to dispose of its isolate, while running the
+  // foreground tasks of |isolate|. With the shared heap, another isolate may
+  // need |isolate| to reach a safepoint before this thread can finish.
+  void WaitForIsolateDisposal(v8::Isolate* isolate);
 
   template <typename Fn>
   inline bool RequestInterrupt(Fn&& cb);
@@ -78,6 +134,7 @@ class Worker : public AsyncWrap {
   static void TakeHeapSnapshot(const v8::FunctionCallbackInfo<v8::Value>& args);
   static void LoopIdleTime(const v8::FunctionCallbackInfo<v8::Value>& args);
   static void LoopStartTime(const v8::FunctionCallbackInfo<v8::Value>& args);
+  static void CpuUsage(const v8::FunctionCallbackInfo<v8::Value>& args);
   static void GetHeapStatistics(
       const v8::FunctionCallbackInfo<v8::Value>& args);
 
@@ -93,8 +150,14 @@ class Worker : public AsyncWrap {
   MultiIsolatePlatform* platform_;
   v8::Isolate* isolate_ = nullptr;
   std::optional<uv_thread_t> tid_;  // Set while the thread is running
+  // The kernel's id of the thread while it is running, or -1. Guarded by
+  // mutex_.
+  int system_thread_id_ = -1;
 
   std::unique_ptr<InspectorParentHandle> inspector_parent_handle_;
+  // Set by StartThread() and released by the worker thread once it has its
+  // isolate.
+  std::shared_ptr<WorkerIsolatePool> isolate_pool_;
 
   // This mutex protects access to all variables listed below it.
   mutable Mutex mutex_;
@@ -106,11 +169,20 @@ class Worker : public AsyncWrap {
   uintptr_t stack_base_ = 0;
   // Optional name used for debugging in inspector and trace events.
   std::string name_;
+  // Set by the worker thread once Run() has disposed of its isolate.
+  bool isolate_disposed_ = false;
+  ConditionVariable isolate_disposed_cond_;
 
   // Custom resource constraints:
   double resource_limits_[kTotalResourceLimitCount];
   void UpdateResourceConstraints(v8::ResourceConstraints* constraints);
 
+  // Placement of the worker thread, see Worker::New().
+  std::vector<int> cpu_affinity_;
+  int numa_node_ = -1;
+  // Called on the worker thread before it starts running.
+  void ApplyThreadPlacement();
+
   // Full size of the thread's stack.
   size_t stack_size_ = 4 * 1024 * 1024;
   // Stack buffer size that is not available to the JS engine.
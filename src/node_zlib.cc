@@ -19,6 +19,7 @@
 // OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE
 // USE OR OTHER DEALINGS IN THE SOFTWARE.
 
+#include "node_zlib.h"
 #include "memory_tracker-inl.h"
 #include "node.h"
 #include "node_buffer.h"
@@ -27,6 +28,8 @@
 #include "env-inl.h"
 #include "node_errors.h"
 #include "node_external_reference.h"
+#include "node_messaging.h"
+#include "node_realm-inl.h"
 #include "threadpoolwork-inl.h"
 #include "util-inl.h"
 
@@ -40,10 +43,14 @@
 
 #include <sys/types.h>
 
+#include <algorithm>
 #include <cerrno>
 #include <cstdlib>
 #include <cstring>
+#include <limits>
 #include <atomic>
+#include <type_traits>
+#include <unordered_map>
 
 namespace node {
 
@@ -57,6 +64,7 @@ using v8::Int32;
 using v8::Integer;
 using v8::Isolate;
 using v8::Local;
+using v8::Number;
 using v8::Object;
 using v8::Uint32Array;
 using v8::Value;
@@ -170,6 +178,55 @@ struct CompressionError {
   inline bool IsError() const { return code != nullptr; }
 };
 
+// The immutable part of a CompressionDictionary, shared by every stream that
+// uses it, on any thread. zstd dictionaries are digested once up front.
+struct CompressionDictionaryData final {
+  CompressionDictionaryData(std::vector<unsigned char>&& bytes, int zstd_level);
+
+  size_t SelfSize() const {
+    return bytes.size() + ZSTD_sizeof_CDict(cdict.get()) +
+           ZSTD_sizeof_DDict(ddict.get());
+  }
+
+  // Wrap ZSTD_freeCDict/ZSTD_freeDDict to remove the return type.
+  static void FreeCDict(ZSTD_CDict* cdict) { ZSTD_freeCDict(cdict); }
+  static void FreeDDict(ZSTD_DDict* ddict) { ZSTD_freeDDict(ddict); }
+
+  const std::vector<unsigned char> bytes;
+  const DeleteFnPtr<ZSTD_CDict, FreeCDict> cdict;
+  const DeleteFnPtr<ZSTD_DDict, FreeDDict> ddict;
+};
+
+using SharedDictionaryBytes = std::shared_ptr<const std::vector<unsigned char>>;
+
+}  // anonymous namespace
+
+// A deflate z_stream that can outlive the stream it was created for, so that
+// after the stream is done its state can be reset and handed to the next one
+// instead of being freed and allocated again. It lives on the heap because
+// zlib's internal state points back at the z_stream.
+struct PooledZStream final {
+  PooledZStream();
+  ~PooledZStream();
+
+  PooledZStream(const PooledZStream&) = delete;
+  PooledZStream& operator=(const PooledZStream&) = delete;
+
+  // Like CompressionStream::AllocForZlib()/FreeForZlib(), but the memory is
+  // accounted to whichever stream currently owns this object, if any.
+  static void* Alloc(void* data, uInt items, uInt size);
+  static void Free(void* data, void* pointer);
+
+  z_stream strm;
+  bool initialized = false;
+  // The allocation counter of the owning stream, or nullptr while pooled.
+  std::atomic<ssize_t>* account = nullptr;
+  // Bytes currently allocated by zlib for this stream.
+  size_t held = 0;
+};
+
+namespace {
+
 class ZlibContext final : public MemoryRetainer {
  public:
   ZlibContext() = default;
@@ -185,16 +242,29 @@ class ZlibContext final : public MemoryRetainer {
   CompressionError ResetStream();
 
   // Zlib-specific:
-  void Init(int level, int window_bits, int mem_level, int strategy,
-            std::vector<unsigned char>&& dictionary);
+  void Init(int level,
+            int window_bits,
+            int mem_level,
+            int strategy,
+            SharedDictionaryBytes&& dictionary);
   void SetAllocationFunctions(alloc_func alloc, free_func free, void* opaque);
+  // Lets deflate streams reuse state from the realm's pool. Allocations made
+  // for pooled state are added to *account.
+  void SetPool(BaseObjectPtr<ZlibBindingData> binding_data,
+               std::atomic<ssize_t>* account);
   CompressionError SetParams(int level, int strategy);
+  // Initializes a deflate stream and returns an upper bound for the
+  // compressed size of |length| bytes, or 0 for other modes or on error.
+  size_t CompressBound(size_t length);
 
   SET_MEMORY_INFO_NAME(ZlibContext)
   SET_SELF_SIZE(ZlibContext)
 
   void MemoryInfo(MemoryTracker* tracker) const override {
-    tracker->TrackField("dictionary", dictionary_);
+    // Dictionaries shared through a CompressionDictionary are accounted
+    // for there.
+    if (dictionary_ && dictionary_.use_count() == 1)
+      tracker->TrackFieldWithSize("dictionary", dictionary_->size());
   }
 
   ZlibContext(const ZlibContext&) = delete;
@@ -204,6 +274,8 @@ class ZlibContext final : public MemoryRetainer {
   CompressionError ErrorForMessage(const char* message) const;
   CompressionError SetDictionary();
   bool InitZlib();
+  uint32_t PoolKey() const;
+  void ReleasePooledStream();
 
   Mutex mutex_;  // Protects zlib_init_done_.
   bool zlib_init_done_ = false;
@@ -215,9 +287,15 @@ class ZlibContext final : public MemoryRetainer {
   int strategy_ = 0;
   int window_bits_ = 0;
   unsigned int gzip_id_bytes_read_ = 0;
-  std::vector<unsigned char> dictionary_;
+  SharedDictionaryBytes dictionary_;
+
+  BaseObjectPtr<ZlibBindingData> binding_data_;
+  std::atomic<ssize_t>* account_ = nullptr;
+  std::unique_ptr<PooledZStream> pooled_;
 
-  z_stream strm_;
+  z_stream own_strm_;
+  // Either &own_strm_ or &pooled_->strm.
+  z_stream* strm_ = &own_strm_;
 };
 
 // Brotli has different data types for compression and decompression streams,
@@ -306,6 +384,9 @@ class ZstdContext : public MemoryRetainer {
   ZstdContext& operator=(const ZstdContext&) = delete;
 
  protected:
+  // Keeps the digested dictionary referenced by the zstd context alive.
+  std::shared_ptr<const CompressionDictionaryData> dictionary_;
+
   ZSTD_EndDirective flush_ = ZSTD_e_continue;
 
   ZSTD_inBuffer input_ = {nullptr, 0, 0};
@@ -321,22 +402,25 @@ class ZstdCompressContext final : public ZstdContext {
   ZstdCompressContext() = default;
 
   // Streaming-related, should be available for all compression libraries:
+  void Close();
   void DoThreadPoolWork();
   CompressionError ResetStream();
 
   // Zstd specific:
   CompressionError Init(uint64_t pledged_src_size);
   CompressionError SetParameter(int key, int value);
-
-  // Wrap ZSTD_freeCCtx to remove the return type.
-  static void FreeZstd(ZSTD_CCtx* cctx) { ZSTD_freeCCtx(cctx); }
+  CompressionError SetDictionary(
+      std::shared_ptr<const CompressionDictionaryData> dictionary);
+  // Lets Init() take a context from the realm's pool, and Close() return it.
+  void SetPool(BaseObjectPtr<ZlibBindingData> binding_data);
 
   SET_MEMORY_INFO_NAME(ZstdCompressContext)
   SET_SELF_SIZE(ZstdCompressContext)
   SET_NO_MEMORY_INFO()
 
  private:
-  DeleteFnPtr<ZSTD_CCtx, ZstdCompressContext::FreeZstd> cctx_;
+  BaseObjectPtr<ZlibBindingData> binding_data_;
+  ZstdCCtxPointer cctx_;
 
   uint64_t pledged_src_size_ = ZSTD_CONTENTSIZE_UNKNOWN;
 };
@@ -352,6 +436,8 @@ class ZstdDecompressContext final : public ZstdContext {
   // Zstd specific:
   CompressionError Init(uint64_t pledged_src_size);
   CompressionError SetParameter(int key, int value);
+  CompressionError SetDictionary(
+      std::shared_ptr<const CompressionDictionaryData> dictionary);
 
   // Wrap ZSTD_freeDCtx to remove the return type.
   static void FreeZstd(ZSTD_DCtx* dctx) { ZSTD_freeDCtx(dctx); }
@@ -364,6 +450,185 @@ class ZstdDecompressContext final : public ZstdContext {
   DeleteFnPtr<ZSTD_DCtx, ZstdDecompressContext::FreeZstd> dctx_;
 };
 
+// Produces a single gzip member the way pigz does: the input is cut into
+// blocks that are deflated independently on the platform's worker threads,
+// each primed with the 32 KiB of input preceding it so that the ratio stays
+// close to that of a single deflate stream. The raw deflate outputs are
+// concatenated in order and framed with one header and a trailer carrying
+// the combined CRC, so any gzip decoder can read the result.
+class ParallelGzipContext final : public MemoryRetainer {
+ public:
+  static constexpr size_t kDictionarySize = 32 * 1024;
+  static constexpr size_t kDefaultBlockSize = 128 * 1024;
+
+  ParallelGzipContext() = default;
+
+  // Streaming-related, should be available for all compression libraries:
+  void Close();
+  void DoThreadPoolWork();
+  void SetBuffers(const char* in, uint32_t in_len, char* out, uint32_t out_len);
+  void SetFlush(int flush);
+  void GetAfterWriteOffsets(uint32_t* avail_in, uint32_t* avail_out) const;
+  CompressionError GetErrorInfo() const;
+  CompressionError ResetStream();
+
+  // Parallel gzip specific:
+  void Init(v8::Platform* platform,
+            int level,
+            int mem_level,
+            int strategy,
+            size_t block_size);
+  // Applies to the blocks that later writes compress. Like deflateParams(),
+  // it does not affect output that has already been produced, and the JS
+  // side flushes before calling it.
+  CompressionError SetParams(int level, int strategy);
+
+  SET_MEMORY_INFO_NAME(ParallelGzipContext)
+  SET_SELF_SIZE(ParallelGzipContext)
+
+  void MemoryInfo(MemoryTracker* tracker) const override {
+    tracker->TrackField("input", input_);
+    tracker->TrackField("output", output_);
+    tracker->TrackField("dictionary", dictionary_);
+  }
+
+  ParallelGzipContext(const ParallelGzipContext&) = delete;
+  ParallelGzipContext& operator=(const ParallelGzipContext&) = delete;
+
+ private:
+  // Deflates the buffered input: as many whole blocks as there are,
+  // or everything when |flush| is set, in which case |finish| also ends
+  // the gzip member.
+  void CompressBlocks(bool flush, bool finish);
+  // Copies as much pending output as fits into the output buffer.
+  void Drain();
+
+  v8::Platform* platform_ = nullptr;
+  int level_ = Z_DEFAULT_COMPRESSION;
+  int mem_level_ = 8;
+  int strategy_ = Z_DEFAULT_STRATEGY;
+  size_t block_size_ = kDefaultBlockSize;
+
+  int flush_ = Z_NO_FLUSH;
+  int err_ = Z_OK;
+  const char* next_in_ = nullptr;
+  uint32_t avail_in_ = 0;
+  char* next_out_ = nullptr;
+  uint32_t avail_out_ = 0;
+
+  std::vector<char> input_;
+  // The last kDictionarySize bytes of input that have been compressed.
+  std::vector<char> dictionary_;
+  std::vector<char> output_;
+  size_t output_offset_ = 0;
+
+  bool header_written_ = false;
+  bool finished_ = false;
+  uLong crc_ = 0;
+  uint64_t total_in_ = 0;
+};
+
+// A dictionary that is prepared once and then shared by any number of
+// streams, including ones on other threads when transferred through a
+// MessagePort, instead of being copied into (and, for zstd, digested by)
+// every stream that uses it.
+class CompressionDictionary final : public BaseObject {
+ public:
+  static Local<FunctionTemplate> GetConstructorTemplate(Environment* env);
+  static bool HasInstance(Environment* env, Local<Value> value);
+  static void Initialize(Environment* env, Local<Object> target);
+  static void RegisterExternalReferences(ExternalReferenceRegistry* registry);
+
+  CompressionDictionary(Environment* env,
+                        Local<Object> wrap,
+                        std::shared_ptr<const CompressionDictionaryData> data)
+      : BaseObject(env, wrap), data_(std::move(data)) {
+    MakeWeak();
+  }
+
+  static BaseObjectPtr<CompressionDictionary> Create(
+      Environment* env, std::shared_ptr<const CompressionDictionaryData> data);
+
+  // new CompressionDictionary(buffer[, zstdLevel])
+  static void New(const FunctionCallbackInfo<Value>& args);
+
+  const std::shared_ptr<const CompressionDictionaryData>& data() const {
+    return data_;
+  }
+
+  // The raw dictionary bytes, in the form used by ZlibContext.
+  SharedDictionaryBytes bytes() const {
+    return SharedDictionaryBytes(data_, &data_->bytes);
+  }
+
+  void MemoryInfo(MemoryTracker* tracker) const override {
+    tracker->TrackFieldWithSize("data", data_->SelfSize());
+  }
+
+  SET_MEMORY_INFO_NAME(CompressionDictionary)
+  SET_SELF_SIZE(CompressionDictionary)
+
+  class CompressionDictionaryTransferData : public worker::TransferData {
+   public:
+    explicit CompressionDictionaryTransferData(
+        const std::shared_ptr<const CompressionDictionaryData>& data)
+        : data_(data) {}
+
+    BaseObjectPtr<BaseObject> Deserialize(
+        Environment* env,
+        Local<Context> context,
+        std::unique_ptr<worker::TransferData> self) override;
+
+    SET_MEMORY_INFO_NAME(CompressionDictionaryTransferData)
+    SET_SELF_SIZE(CompressionDictionaryTransferData)
+    SET_NO_MEMORY_INFO()
+
+   private:
+    std::shared_ptr<const CompressionDictionaryData> data_;
+  };
+
+  BaseObject::TransferMode GetTransferMode() const override {
+    return BaseObject::TransferMode::kCloneable;
+  }
+  std::unique_ptr<worker::TransferData> CloneForMessaging() const override {
+    return std::make_unique<CompressionDictionaryTransferData>(data_);
+  }
+
+ private:
+  const std::shared_ptr<const CompressionDictionaryData> data_;
+};
+
+// Accepts either a Buffer, which is copied, or a CompressionDictionary,
+// whose bytes are shared.
+SharedDictionaryBytes GetZlibDictionary(Environment* env, Local<Value> value) {
+  if (Buffer::HasInstance(value)) {
+    const unsigned char* data =
+        reinterpret_cast<const unsigned char*>(Buffer::Data(value));
+    return std::make_shared<const std::vector<unsigned char>>(
+        data, data + Buffer::Length(value));
+  }
+  if (CompressionDictionary::HasInstance(env, value))
+    return BaseObject::Unwrap<CompressionDictionary>(value)->bytes();
+  return {};
+}
+
+// Applies the parameters in |params|, a Uint32Array indexed by zstd
+// parameter, skipping entries that are -1.
+template <typename Context>
+CompressionError SetZstdParameters(Context* ctx, Local<Value> params) {
+  CHECK(params->IsUint32Array());
+  const uint32_t* data = reinterpret_cast<uint32_t*>(Buffer::Data(params));
+  size_t len = params.As<Uint32Array>()->Length();
+
+  for (int i = 0; static_cast<size_t>(i) < len; i++) {
+    if (data[i] == static_cast<uint32_t>(-1)) continue;
+
+    CompressionError err = ctx->SetParameter(i, data[i]);
+    if (err.IsError()) return err;
+  }
+  return {};
+}
+
 template <typename CompressionContext>
 class CompressionStream : public AsyncWrap, public ThreadPoolWork {
  public:
@@ -375,7 +640,7 @@ class CompressionStream : public AsyncWrap, public ThreadPoolWork {
 
   CompressionStream(Environment* env, Local<Object> wrap)
       : AsyncWrap(env, wrap, AsyncWrap::PROVIDER_ZLIB),
-        ThreadPoolWork(env, "zlib"),
+        ThreadPoolWork(env, "zlib", ThreadPoolWorkClass::kZlib),
         write_result_(nullptr) {
     MakeWeak();
   }
@@ -652,6 +917,12 @@ class CompressionStream : public AsyncWrap, public ThreadPoolWork {
     CompressionStream* stream;
   };
 
+  // The counter that AllocForZlib() and FreeForZlib() update, for memory
+  // allocated on this stream's behalf by other means.
+  std::atomic<ssize_t>* unreported_allocations() {
+    return &unreported_allocations_;
+  }
+
  private:
   void Ref() {
     if (++refs_ == 1) {
@@ -737,20 +1008,17 @@ class ZlibStream final : public CompressionStream<ZlibContext> {
     CHECK(args[5]->IsFunction());
     Local<Function> write_js_callback = args[5].As<Function>();
 
-    std::vector<unsigned char> dictionary;
-    if (Buffer::HasInstance(args[6])) {
-      unsigned char* data =
-          reinterpret_cast<unsigned char*>(Buffer::Data(args[6]));
-      dictionary = std::vector<unsigned char>(
-          data,
-          data + Buffer::Length(args[6]));
-    }
+    SharedDictionaryBytes dictionary = GetZlibDictionary(wrap->env(), args[6]);
 
     wrap->InitStream(write_result, write_js_callback);
 
     AllocScope alloc_scope(wrap);
     wrap->context()->SetAllocationFunctions(
         AllocForZlib, FreeForZlib, static_cast<CompressionStream*>(wrap));
+    wrap->context()->SetPool(
+        BaseObjectPtr<ZlibBindingData>(
+            Realm::GetBindingData<ZlibBindingData>(args)),
+        wrap->unreported_allocations());
     wrap->context()->Init(level, window_bits, mem_level, strategy,
                           std::move(dictionary));
   }
@@ -878,8 +1146,9 @@ class ZstdStream final : public CompressionStream<CompressionContext> {
     Environment* env = Environment::GetCurrent(args);
     Local<Context> context = env->context();
 
-    CHECK(args.Length() == 4 &&
-          "init(params, pledgedSrcSize, writeResult, writeCallback)");
+    CHECK((args.Length() == 4 || args.Length() == 5) &&
+          "init(params, pledgedSrcSize, writeResult, writeCallback"
+          "[, dictionary])");
     ZstdStream* wrap;
     ASSIGN_OR_RETURN_UNWRAP(&wrap, args.This());
 
@@ -906,6 +1175,11 @@ class ZstdStream final : public CompressionStream<CompressionContext> {
       pledged_src_size = signed_pledged_src_size;
     }
 
+    if constexpr (std::is_same_v<CompressionContext, ZstdCompressContext>) {
+      wrap->context()->SetPool(BaseObjectPtr<ZlibBindingData>(
+          Realm::GetBindingData<ZlibBindingData>(args)));
+    }
+
     AllocScope alloc_scope(wrap);
     CompressionError err = wrap->context()->Init(pledged_src_size);
     if (err.IsError()) {
@@ -914,14 +1188,18 @@ class ZstdStream final : public CompressionStream<CompressionContext> {
       return;
     }
 
-    CHECK(args[0]->IsUint32Array());
-    const uint32_t* data = reinterpret_cast<uint32_t*>(Buffer::Data(args[0]));
-    size_t len = args[0].As<Uint32Array>()->Length();
-
-    for (int i = 0; static_cast<size_t>(i) < len; i++) {
-      if (data[i] == static_cast<uint32_t>(-1)) continue;
+    err = SetZstdParameters(wrap->context(), args[0]);
+    if (err.IsError()) {
+      wrap->EmitError(err);
+      THROW_ERR_ZLIB_INITIALIZATION_FAILED(wrap->env(), err.message);
+      return;
+    }
 
-      CompressionError err = wrap->context()->SetParameter(i, data[i]);
+    if (args.Length() > 4 && !args[4]->IsUndefined()) {
+      CHECK(CompressionDictionary::HasInstance(env, args[4]));
+      CompressionDictionary* dictionary =
+          BaseObject::Unwrap<CompressionDictionary>(args[4]);
+      err = wrap->context()->SetDictionary(dictionary->data());
       if (err.IsError()) {
         wrap->EmitError(err);
         THROW_ERR_ZLIB_INITIALIZATION_FAILED(wrap->env(), err.message);
@@ -944,11 +1222,78 @@ class ZstdStream final : public CompressionStream<CompressionContext> {
 using ZstdCompressStream = ZstdStream<ZstdCompressContext>;
 using ZstdDecompressStream = ZstdStream<ZstdDecompressContext>;
 
+class ParallelGzipStream final
+    : public CompressionStream<ParallelGzipContext> {
+ public:
+  ParallelGzipStream(Environment* env, Local<Object> wrap)
+      : CompressionStream(env, wrap) {}
+
+  static void New(const FunctionCallbackInfo<Value>& args) {
+    Environment* env = Environment::GetCurrent(args);
+    new ParallelGzipStream(env, args.This());
+  }
+
+  // init(level, memLevel, strategy, blockSize, writeResult, writeCallback)
+  static void Init(const FunctionCallbackInfo<Value>& args) {
+    CHECK(args.Length() == 6 &&
+          "init(level, memLevel, strategy, blockSize, writeResult, "
+          "writeCallback)");
+    ParallelGzipStream* wrap;
+    ASSIGN_OR_RETURN_UNWRAP(&wrap, args.This());
+    Local<Context> context = wrap->env()->context();
+
+    int32_t level;
+    if (!args[0]->Int32Value(context).To(&level)) return;
+    uint32_t mem_level;
+    if (!args[1]->Uint32Value(context).To(&mem_level)) return;
+    uint32_t strategy;
+    if (!args[2]->Uint32Value(context).To(&strategy)) return;
+    size_t block_size = ParallelGzipContext::kDefaultBlockSize;
+    if (args[3]->IsUint32()) block_size = args[3].As<v8::Uint32>()->Value();
+
+    CHECK((level >= Z_MIN_LEVEL && level <= Z_MAX_LEVEL) &&
+          "invalid compression level");
+    CHECK((mem_level >= Z_MIN_MEMLEVEL && mem_level <= Z_MAX_MEMLEVEL) &&
+          "invalid memlevel");
+    CHECK(block_size >= ParallelGzipContext::kDictionarySize &&
+          "invalid block size");
+
+    CHECK(args[4]->IsUint32Array());
+    uint32_t* write_result = reinterpret_cast<uint32_t*>(Buffer::Data(args[4]));
+    CHECK(args[5]->IsFunction());
+    wrap->InitStream(write_result, args[5].As<Function>());
+
+    wrap->context()->Init(wrap->env()->isolate_data()->platform(),
+                          level,
+                          mem_level,
+                          strategy,
+                          block_size);
+  }
+
+  static void Params(const FunctionCallbackInfo<Value>& args) {
+    CHECK(args.Length() == 2 && "params(level, strategy)");
+    ParallelGzipStream* wrap;
+    ASSIGN_OR_RETURN_UNWRAP(&wrap, args.This());
+    Local<Context> context = args.GetIsolate()->GetCurrentContext();
+    int level;
+    if (!args[0]->Int32Value(context).To(&level)) return;
+    int strategy;
+    if (!args[1]->Int32Value(context).To(&strategy)) return;
+
+    const CompressionError err = wrap->context()->SetParams(level, strategy);
+    if (err.IsError()) wrap->EmitError(err);
+  }
+
+  SET_MEMORY_INFO_NAME(ParallelGzipStream)
+  SET_SELF_SIZE(ParallelGzipStream)
+};
+
 void ZlibContext::Close() {
   {
     Mutex::ScopedLock lock(mutex_);
     if (!zlib_init_done_) {
-      dictionary_.clear();
+      ReleasePooledStream();
+      dictionary_.reset();
       mode_ = NONE;
       return;
     }
@@ -957,17 +1302,19 @@ void ZlibContext::Close() {
   CHECK_LE(mode_, UNZIP);
 
   int status = Z_OK;
-  if (mode_ == DEFLATE || mode_ == GZIP || mode_ == DEFLATERAW) {
-    status = deflateEnd(&strm_);
+  if (pooled_) {
+    ReleasePooledStream();
+  } else if (mode_ == DEFLATE || mode_ == GZIP || mode_ == DEFLATERAW) {
+    status = deflateEnd(strm_);
   } else if (mode_ == INFLATE || mode_ == GUNZIP || mode_ == INFLATERAW ||
              mode_ == UNZIP) {
-    status = inflateEnd(&strm_);
+    status = inflateEnd(strm_);
   }
 
   CHECK(status == Z_OK || status == Z_DATA_ERROR);
   mode_ = NONE;
 
-  dictionary_.clear();
+  dictionary_.reset();
 }
 
 
@@ -986,11 +1333,11 @@ void ZlibContext::DoThreadPoolWork() {
     case DEFLATE:
     case GZIP:
     case DEFLATERAW:
-      err_ = deflate(&strm_, flush_);
+      err_ = deflate(strm_, flush_);
       break;
     case UNZIP:
-      if (strm_.avail_in > 0) {
-        next_expected_header_byte = strm_.next_in;
+      if (strm_->avail_in > 0) {
+        next_expected_header_byte = strm_->next_in;
       }
 
       switch (gzip_id_bytes_read_) {
@@ -1003,7 +1350,7 @@ void ZlibContext::DoThreadPoolWork() {
             gzip_id_bytes_read_ = 1;
             next_expected_header_byte++;
 
-            if (strm_.avail_in == 1) {
+            if (strm_->avail_in == 1) {
               // The only available byte was already read.
               break;
             }
@@ -1036,20 +1383,20 @@ void ZlibContext::DoThreadPoolWork() {
     case INFLATE:
     case GUNZIP:
     case INFLATERAW:
-      err_ = inflate(&strm_, flush_);
+      err_ = inflate(strm_, flush_);
 
       // If data was encoded with dictionary (INFLATERAW will have it set in
       // SetDictionary, don't repeat that here)
       if (mode_ != INFLATERAW &&
           err_ == Z_NEED_DICT &&
-          !dictionary_.empty()) {
+          dictionary_ && !dictionary_->empty()) {
         // Load it
-        err_ = inflateSetDictionary(&strm_,
-                                    dictionary_.data(),
-                                    dictionary_.size());
+        err_ = inflateSetDictionary(strm_,
+                                    dictionary_->data(),
+                                    dictionary_->size());
         if (err_ == Z_OK) {
           // And try to decode again
-          err_ = inflate(&strm_, flush_);
+          err_ = inflate(strm_, flush_);
         } else if (err_ == Z_DATA_ERROR) {
           // Both inflateSetDictionary() and inflate() return Z_DATA_ERROR.
           // Make it possible for After() to tell a bad dictionary from bad
@@ -1058,17 +1405,17 @@ void ZlibContext::DoThreadPoolWork() {
         }
       }
 
-      while (strm_.avail_in > 0 &&
+      while (strm_->avail_in > 0 &&
              mode_ == GUNZIP &&
              err_ == Z_STREAM_END &&
-             strm_.next_in[0] != 0x00) {
+             strm_->next_in[0] != 0x00) {
         // Bytes remain in input buffer. Perhaps this is another compressed
         // member in the same archive, or just trailing garbage.
         // Trailing zero bytes are okay, though, since they are frequently
         // used for padding.
 
         ResetStream();
-        err_ = inflate(&strm_, flush_);
+        err_ = inflate(strm_, flush_);
       }
       break;
     default:
@@ -1079,10 +1426,10 @@ void ZlibContext::DoThreadPoolWork() {
 
 void ZlibContext::SetBuffers(const char* in, uint32_t in_len,
                              char* out, uint32_t out_len) {
-  strm_.avail_in = in_len;
-  strm_.next_in = const_cast<Bytef*>(reinterpret_cast<const Bytef*>(in));
-  strm_.avail_out = out_len;
-  strm_.next_out = reinterpret_cast<Bytef*>(out);
+  strm_->avail_in = in_len;
+  strm_->next_in = const_cast<Bytef*>(reinterpret_cast<const Bytef*>(in));
+  strm_->avail_out = out_len;
+  strm_->next_out = reinterpret_cast<Bytef*>(out);
 }
 
 
@@ -1093,14 +1440,14 @@ void ZlibContext::SetFlush(int flush) {
 
 void ZlibContext::GetAfterWriteOffsets(uint32_t* avail_in,
                                        uint32_t* avail_out) const {
-  *avail_in = strm_.avail_in;
-  *avail_out = strm_.avail_out;
+  *avail_in = strm_->avail_in;
+  *avail_out = strm_->avail_out;
 }
 
 
 CompressionError ZlibContext::ErrorForMessage(const char* message) const {
-  if (strm_.msg != nullptr)
-    message = strm_.msg;
+  if (strm_->msg != nullptr)
+    message = strm_->msg;
 
   return CompressionError { message, ZlibStrerror(err_), err_ };
 }
@@ -1111,14 +1458,14 @@ CompressionError ZlibContext::GetErrorInfo() const {
   switch (err_) {
   case Z_OK:
   case Z_BUF_ERROR:
-    if (strm_.avail_out != 0 && flush_ == Z_FINISH) {
+    if (strm_->avail_out != 0 && flush_ == Z_FINISH) {
       return ErrorForMessage("unexpected end of file");
     }
   case Z_STREAM_END:
     // normal statuses, not fatal
     break;
   case Z_NEED_DICT:
-    if (dictionary_.empty())
+    if (!dictionary_ || dictionary_->empty())
       return ErrorForMessage("Missing dictionary");
     else
       return ErrorForMessage("Bad dictionary");
@@ -1143,12 +1490,12 @@ CompressionError ZlibContext::ResetStream() {
     case DEFLATE:
     case DEFLATERAW:
     case GZIP:
-      err_ = deflateReset(&strm_);
+      err_ = deflateReset(strm_);
       break;
     case INFLATE:
     case INFLATERAW:
     case GUNZIP:
-      err_ = inflateReset(&strm_);
+      err_ = inflateReset(strm_);
       break;
     default:
       break;
@@ -1164,15 +1511,47 @@ CompressionError ZlibContext::ResetStream() {
 void ZlibContext::SetAllocationFunctions(alloc_func alloc,
                                          free_func free,
                                          void* opaque) {
-  strm_.zalloc = alloc;
-  strm_.zfree = free;
-  strm_.opaque = opaque;
+  strm_->zalloc = alloc;
+  strm_->zfree = free;
+  strm_->opaque = opaque;
+}
+
+
+void ZlibContext::ReleasePooledStream() {
+  if (!pooled_) return;
+  // Reset the state and hand it to the next stream with the same
+  // parameters. If that does not work out, freeing it ends it.
+  if (pooled_->initialized && deflateReset(strm_) == Z_OK) {
+    account_->fetch_sub(pooled_->held, std::memory_order_relaxed);
+    pooled_->account = nullptr;
+    binding_data_->ReleaseDeflateStream(PoolKey(), std::move(pooled_));
+  }
+  pooled_.reset();
+  strm_ = &own_strm_;
 }
 
 
-void ZlibContext::Init(
-    int level, int window_bits, int mem_level, int strategy,
-    std::vector<unsigned char>&& dictionary) {
+void ZlibContext::SetPool(BaseObjectPtr<ZlibBindingData> binding_data,
+                          std::atomic<ssize_t>* account) {
+  binding_data_ = std::move(binding_data);
+  account_ = account;
+}
+
+
+uint32_t ZlibContext::PoolKey() const {
+  // window_bits_ also encodes the deflate flavor (raw, zlib or gzip).
+  return (static_cast<uint32_t>(window_bits_ + 64) << 16) |
+         (static_cast<uint32_t>(level_ + 1) << 8) |
+         (static_cast<uint32_t>(mem_level_) << 4) |
+         static_cast<uint32_t>(strategy_);
+}
+
+
+void ZlibContext::Init(int level,
+                       int window_bits,
+                       int mem_level,
+                       int strategy,
+                       SharedDictionaryBytes&& dictionary) {
   if (!((window_bits == 0) &&
         (mode_ == INFLATE ||
          mode_ == GUNZIP ||
@@ -1215,6 +1594,15 @@ void ZlibContext::Init(
   }
 
   dictionary_ = std::move(dictionary);
+
+  if (binding_data_ &&
+      (mode_ == DEFLATE || mode_ == GZIP || mode_ == DEFLATERAW)) {
+    pooled_ = binding_data_->TakeDeflateStream(PoolKey());
+    if (!pooled_) pooled_ = std::make_unique<PooledZStream>();
+    pooled_->account = account_;
+    account_->fetch_add(pooled_->held, std::memory_order_relaxed);
+    strm_ = &pooled_->strm;
+  }
 }
 
 bool ZlibContext::InitZlib() {
@@ -1227,25 +1615,31 @@ bool ZlibContext::InitZlib() {
     case DEFLATE:
     case GZIP:
     case DEFLATERAW:
-      err_ = deflateInit2(&strm_,
+      if (pooled_ && pooled_->initialized) {
+        // Reset with the same parameters when it was released to the pool.
+        err_ = Z_OK;
+        break;
+      }
+      err_ = deflateInit2(strm_,
                           level_,
                           Z_DEFLATED,
                           window_bits_,
                           mem_level_,
                           strategy_);
+      if (pooled_) pooled_->initialized = err_ == Z_OK;
       break;
     case INFLATE:
     case GUNZIP:
     case INFLATERAW:
     case UNZIP:
-      err_ = inflateInit2(&strm_, window_bits_);
+      err_ = inflateInit2(strm_, window_bits_);
       break;
     default:
       UNREACHABLE();
   }
 
   if (err_ != Z_OK) {
-    dictionary_.clear();
+    dictionary_.reset();
     mode_ = NONE;
     return true;
   }
@@ -1257,7 +1651,7 @@ bool ZlibContext::InitZlib() {
 
 
 CompressionError ZlibContext::SetDictionary() {
-  if (dictionary_.empty())
+  if (!dictionary_ || dictionary_->empty())
     return CompressionError {};
 
   err_ = Z_OK;
@@ -1265,16 +1659,16 @@ CompressionError ZlibContext::SetDictionary() {
   switch (mode_) {
     case DEFLATE:
     case DEFLATERAW:
-      err_ = deflateSetDictionary(&strm_,
-                                  dictionary_.data(),
-                                  dictionary_.size());
+      err_ = deflateSetDictionary(strm_,
+                                  dictionary_->data(),
+                                  dictionary_->size());
       break;
     case INFLATERAW:
       // The other inflate cases will have the dictionary set when inflate()
       // returns Z_NEED_DICT in Process()
-      err_ = inflateSetDictionary(&strm_,
-                                  dictionary_.data(),
-                                  dictionary_.size());
+      err_ = inflateSetDictionary(strm_,
+                                  dictionary_->data(),
+                                  dictionary_->size());
       break;
     default:
       break;
@@ -1288,6 +1682,14 @@ CompressionError ZlibContext::SetDictionary() {
 }
 
 
+size_t ZlibContext::CompressBound(size_t length) {
+  if (mode_ != DEFLATE && mode_ != GZIP && mode_ != DEFLATERAW) return 0;
+  bool first_init_call = InitZlib();
+  if (first_init_call && err_ != Z_OK) return 0;
+  return deflateBound(strm_, length);
+}
+
+
 CompressionError ZlibContext::SetParams(int level, int strategy) {
   bool first_init_call = InitZlib();
   if (first_init_call && err_ != Z_OK) {
@@ -1299,7 +1701,7 @@ CompressionError ZlibContext::SetParams(int level, int strategy) {
   switch (mode_) {
     case DEFLATE:
     case DEFLATERAW:
-      err_ = deflateParams(&strm_, level, strategy);
+      err_ = deflateParams(strm_, level, strategy);
       break;
     default:
       break;
@@ -1309,6 +1711,10 @@ CompressionError ZlibContext::SetParams(int level, int strategy) {
     return ErrorForMessage("Failed to set parameters");
   }
 
+  // Pooled state is keyed by the parameters it was left with.
+  level_ = level;
+  strategy_ = strategy;
+
   return CompressionError {};
 }
 
@@ -1503,6 +1909,14 @@ CompressionError ZstdContext::GetErrorInfo() const {
 }
 
 CompressionError ZstdCompressContext::SetParameter(int key, int value) {
+  if (key == ZSTD_c_nbWorkers) {
+    // Builds of zstd without ZSTD_MULTITHREAD only accept 0. Fall back to
+    // single-threaded compression there instead of failing, and cap the
+    // worker count otherwise, since it is only a performance hint.
+    ZSTD_bounds bounds = ZSTD_cParam_getBounds(ZSTD_c_nbWorkers);
+    if (!ZSTD_isError(bounds.error))
+      value = std::clamp(value, bounds.lowerBound, bounds.upperBound);
+  }
   size_t result = ZSTD_CCtx_setParameter(
       cctx_.get(), static_cast<ZSTD_cParameter>(key), value);
   if (ZSTD_isError(result)) {
@@ -1512,9 +1926,24 @@ CompressionError ZstdCompressContext::SetParameter(int key, int value) {
   return {};
 }
 
+void ZstdCompressContext::SetPool(BaseObjectPtr<ZlibBindingData> binding_data) {
+  binding_data_ = std::move(binding_data);
+}
+
+void ZstdCompressContext::Close() {
+  if (binding_data_ && cctx_ &&
+      !ZSTD_isError(ZSTD_CCtx_reset(cctx_.get(),
+                                    ZSTD_reset_session_and_parameters))) {
+    binding_data_->ReleaseZstdCompressContext(std::move(cctx_));
+  }
+  cctx_.reset();
+  dictionary_.reset();
+}
+
 CompressionError ZstdCompressContext::Init(uint64_t pledged_src_size) {
   pledged_src_size_ = pledged_src_size;
-  cctx_.reset(ZSTD_createCCtx());
+  if (binding_data_) cctx_ = binding_data_->TakeZstdCompressContext();
+  if (!cctx_) cctx_.reset(ZSTD_createCCtx());
   if (!cctx_) {
     return CompressionError("Could not initialize zstd instance",
                             "ERR_ZLIB_INITIALIZATION_FAILED",
@@ -1529,7 +1958,30 @@ CompressionError ZstdCompressContext::Init(uint64_t pledged_src_size) {
 }
 
 CompressionError ZstdCompressContext::ResetStream() {
-  return Init(pledged_src_size_);
+  if (!cctx_) return Init(pledged_src_size_);
+  // Only reset the session, so that the parameters set in init(), such as
+  // the level and nbWorkers, survive and zstd can keep its worker pool.
+  size_t result = ZSTD_CCtx_reset(cctx_.get(), ZSTD_reset_session_only);
+  if (!ZSTD_isError(result))
+    result = ZSTD_CCtx_setPledgedSrcSize(cctx_.get(), pledged_src_size_);
+  if (ZSTD_isError(result)) {
+    return CompressionError(
+        "Could not reset zstd instance", "ERR_ZLIB_INITIALIZATION_FAILED", -1);
+  }
+  return {};
+}
+
+CompressionError ZstdCompressContext::SetDictionary(
+    std::shared_ptr<const CompressionDictionaryData> dictionary) {
+  // The reference is sticky: it survives session resets, so the digested
+  // dictionary is reused by every frame this stream produces.
+  size_t result = ZSTD_CCtx_refCDict(cctx_.get(), dictionary->cdict.get());
+  if (ZSTD_isError(result)) {
+    return CompressionError(
+        "Could not load dictionary", "ERR_ZLIB_INITIALIZATION_FAILED", -1);
+  }
+  dictionary_ = std::move(dictionary);
+  return {};
 }
 
 void ZstdCompressContext::DoThreadPoolWork() {
@@ -1565,7 +2017,25 @@ CompressionError ZstdDecompressContext::Init(uint64_t pledged_src_size) {
 CompressionError ZstdDecompressContext::ResetStream() {
   // We pass ZSTD_CONTENTSIZE_UNKNOWN because the argument is ignored for
   // decompression.
-  return Init(ZSTD_CONTENTSIZE_UNKNOWN);
+  if (!dctx_) return Init(ZSTD_CONTENTSIZE_UNKNOWN);
+  // Keep the parameters and any referenced dictionary across resets.
+  size_t result = ZSTD_DCtx_reset(dctx_.get(), ZSTD_reset_session_only);
+  if (ZSTD_isError(result)) {
+    return CompressionError(
+        "Could not reset zstd instance", "ERR_ZLIB_INITIALIZATION_FAILED", -1);
+  }
+  return {};
+}
+
+CompressionError ZstdDecompressContext::SetDictionary(
+    std::shared_ptr<const CompressionDictionaryData> dictionary) {
+  size_t result = ZSTD_DCtx_refDDict(dctx_.get(), dictionary->ddict.get());
+  if (ZSTD_isError(result)) {
+    return CompressionError(
+        "Could not load dictionary", "ERR_ZLIB_INITIALIZATION_FAILED", -1);
+  }
+  dictionary_ = std::move(dictionary);
+  return {};
 }
 
 void ZstdDecompressContext::DoThreadPoolWork() {
@@ -1577,6 +2047,521 @@ void ZstdDecompressContext::DoThreadPoolWork() {
   }
 }
 
+// One block of a ParallelGzipContext batch.
+struct DeflateBlock {
+  const char* data;
+  size_t length;
+  const char* dictionary;
+  size_t dictionary_length;
+  bool last;
+  std::vector<char> output;
+  uLong crc = 0;
+  int err = Z_OK;
+};
+
+// The blocks of one batch, which the threadpool thread that runs the write
+// and any number of worker threads claim one at a time. Helpers that start
+// after every block has been claimed return right away, which also makes
+// it safe for them to outlive the write, as they only keep the batch.
+class DeflateBatch final {
+ public:
+  DeflateBatch(std::vector<DeflateBlock> blocks,
+               int level,
+               int mem_level,
+               int strategy)
+      : blocks_(std::move(blocks)),
+        level_(level),
+        mem_level_(mem_level),
+        strategy_(strategy) {}
+
+  std::vector<DeflateBlock>& blocks() { return blocks_; }
+
+  // Deflates blocks until there are none left to claim.
+  void Run() {
+    z_stream strm{};
+    bool initialized = false;
+
+    for (size_t i; (i = next_.fetch_add(1, std::memory_order_relaxed)) <
+                   blocks_.size();) {
+      DeflateBlock& block = blocks_[i];
+
+      int err = initialized ? deflateReset(&strm)
+                            : deflateInit2(&strm,
+                                           level_,
+                                           Z_DEFLATED,
+                                           -Z_MAX_WINDOWBITS,
+                                           mem_level_,
+                                           strategy_);
+      initialized = initialized || err == Z_OK;
+      if (err == Z_OK) err = Deflate(&strm, &block);
+      block.err = err;
+
+      Mutex::ScopedLock lock(mutex_);
+      if (++done_ == blocks_.size()) cond_.Signal(lock);
+    }
+
+    if (initialized) deflateEnd(&strm);
+  }
+
+  // Waits for the blocks that other threads have claimed. It never waits
+  // for a helper that has not started yet, since by the time it is called,
+  // every block has been claimed by a thread that is running it, so a busy
+  // or small threadpool cannot make it wait forever.
+  void WaitForClaimedBlocks() {
+    Mutex::ScopedLock lock(mutex_);
+    while (done_ < blocks_.size()) cond_.Wait(lock);
+  }
+
+ private:
+  static int Deflate(z_stream* strm, DeflateBlock* block) {
+    int err = Z_OK;
+    if (block->dictionary_length > 0) {
+      err = deflateSetDictionary(
+          strm,
+          reinterpret_cast<const Bytef*>(block->dictionary),
+          block->dictionary_length);
+      if (err != Z_OK) return err;
+    }
+
+    // Non-final blocks end with a sync flush, which leaves the output
+    // byte-aligned and without BFINAL, so the next block can follow it.
+    // The extra bytes cover the empty stored block that it adds.
+    block->output.resize(deflateBound(strm, block->length) + 16);
+    strm->next_in =
+        reinterpret_cast<Bytef*>(const_cast<char*>(block->data));
+    strm->avail_in = block->length;
+    strm->next_out = reinterpret_cast<Bytef*>(block->output.data());
+    strm->avail_out = block->output.size();
+    err = deflate(strm, block->last ? Z_FINISH : Z_SYNC_FLUSH);
+    if (err != (block->last ? Z_STREAM_END : Z_OK) || strm->avail_in != 0)
+      return err == Z_OK || err == Z_STREAM_END ? Z_BUF_ERROR : err;
+    block->output.resize(block->output.size() - strm->avail_out);
+
+    block->crc = crc32(0,
+                       reinterpret_cast<const Bytef*>(block->data),
+                       block->length);
+    return Z_OK;
+  }
+
+  std::vector<DeflateBlock> blocks_;
+  const int level_;
+  const int mem_level_;
+  const int strategy_;
+  std::atomic<size_t> next_{0};
+  Mutex mutex_;
+  ConditionVariable cond_;
+  size_t done_ = 0;
+};
+
+class DeflateBlocksTask final : public v8::Task {
+ public:
+  explicit DeflateBlocksTask(std::shared_ptr<DeflateBatch> batch)
+      : batch_(std::move(batch)) {}
+
+  void Run() override { batch_->Run(); }
+
+ private:
+  std::shared_ptr<DeflateBatch> batch_;
+};
+
+void ParallelGzipContext::Init(v8::Platform* platform,
+                               int level,
+                               int mem_level,
+                               int strategy,
+                               size_t block_size) {
+  platform_ = platform;
+  level_ = level;
+  mem_level_ = mem_level;
+  strategy_ = strategy;
+  block_size_ = block_size;
+  ResetStream();
+}
+
+CompressionError ParallelGzipContext::SetParams(int level, int strategy) {
+  if (level < Z_MIN_LEVEL || level > Z_MAX_LEVEL || strategy < 0 ||
+      strategy > Z_FIXED) {
+    return CompressionError("Failed to set parameters",
+                            ZlibStrerror(Z_STREAM_ERROR),
+                            Z_STREAM_ERROR);
+  }
+  level_ = level;
+  strategy_ = strategy;
+  return {};
+}
+
+void ParallelGzipContext::Close() {
+  input_ = {};
+  dictionary_ = {};
+  output_ = {};
+  output_offset_ = 0;
+}
+
+CompressionError ParallelGzipContext::ResetStream() {
+  Close();
+  err_ = Z_OK;
+  header_written_ = false;
+  finished_ = false;
+  crc_ = crc32(0, nullptr, 0);
+  total_in_ = 0;
+  return {};
+}
+
+void ParallelGzipContext::SetBuffers(const char* in,
+                                     uint32_t in_len,
+                                     char* out,
+                                     uint32_t out_len) {
+  next_in_ = in;
+  avail_in_ = in_len;
+  next_out_ = out;
+  avail_out_ = out_len;
+}
+
+void ParallelGzipContext::SetFlush(int flush) {
+  flush_ = flush;
+}
+
+void ParallelGzipContext::GetAfterWriteOffsets(uint32_t* avail_in,
+                                               uint32_t* avail_out) const {
+  *avail_in = avail_in_;
+  *avail_out = avail_out_;
+}
+
+CompressionError ParallelGzipContext::GetErrorInfo() const {
+  if (err_ == Z_OK) return {};
+  return CompressionError("Zlib error", ZlibStrerror(err_), err_);
+}
+
+void ParallelGzipContext::Drain() {
+  size_t n = std::min<size_t>(output_.size() - output_offset_, avail_out_);
+  if (n == 0) return;
+  memcpy(next_out_, output_.data() + output_offset_, n);
+  next_out_ += n;
+  avail_out_ -= n;
+  output_offset_ += n;
+  if (output_offset_ == output_.size()) {
+    output_.clear();
+    output_offset_ = 0;
+  }
+}
+
+void ParallelGzipContext::DoThreadPoolWork() {
+  // Hand out what is left from the previous batch before taking more input,
+  // which keeps the amount of buffered data bounded.
+  Drain();
+  if (!output_.empty() || err_ != Z_OK || finished_) return;
+
+  input_.insert(input_.end(), next_in_, next_in_ + avail_in_);
+  next_in_ += avail_in_;
+  avail_in_ = 0;
+
+  const bool finish = flush_ == Z_FINISH;
+  const bool flush = finish || flush_ == Z_SYNC_FLUSH || flush_ == Z_FULL_FLUSH;
+  const size_t batch_size =
+      block_size_ * (platform_->NumberOfWorkerThreads() + 1);
+  if (finish || (flush && !input_.empty()) || input_.size() >= batch_size)
+    CompressBlocks(flush, finish);
+  Drain();
+}
+
+void ParallelGzipContext::CompressBlocks(bool flush, bool finish) {
+  const size_t length =
+      flush ? input_.size() : input_.size() - input_.size() % block_size_;
+
+  std::vector<DeflateBlock> blocks_in;
+  for (size_t offset = 0; offset < length || (finish && blocks_in.empty());
+       offset += block_size_) {
+    DeflateBlock block;
+    block.data = input_.data() + offset;
+    block.length = std::min(block_size_, length - offset);
+    if (offset == 0) {
+      block.dictionary = dictionary_.data();
+      block.dictionary_length = dictionary_.size();
+    } else {
+      block.dictionary = block.data - kDictionarySize;
+      block.dictionary_length = kDictionarySize;
+    }
+    block.last = finish && offset + block.length == length;
+    blocks_in.push_back(std::move(block));
+  }
+
+  // This thread deflates blocks, too, so a single block stays on it, and the
+  // batch completes even if none of the helpers gets to run.
+  auto batch = std::make_shared<DeflateBatch>(
+      std::move(blocks_in), level_, mem_level_, strategy_);
+  const std::vector<DeflateBlock>& blocks = batch->blocks();
+  const size_t helpers = std::min<size_t>(
+      blocks.size() - 1, platform_->NumberOfWorkerThreads());
+  for (size_t i = 0; i < helpers; i++) {
+    platform_->CallOnWorkerThread(std::make_unique<DeflateBlocksTask>(batch));
+  }
+  batch->Run();
+  batch->WaitForClaimedBlocks();
+
+  if (!header_written_) {
+    // A minimal gzip header: no name, no mtime, OS "unknown".
+    static const char kHeader[] = {
+        '\x1f', '\x8b', '\x08', '\x00', '\x00', '\x00',
+        '\x00', '\x00', '\x00', '\xff'};
+    output_.insert(output_.end(), kHeader, kHeader + sizeof(kHeader));
+    header_written_ = true;
+  }
+  for (const DeflateBlock& block : blocks) {
+    if (block.err != Z_OK) {
+      err_ = block.err;
+      return;
+    }
+    output_.insert(output_.end(), block.output.begin(), block.output.end());
+    crc_ = crc32_combine(crc_, block.crc, block.length);
+    total_in_ += block.length;
+  }
+
+  if (finish) {
+    const uint32_t trailer[] = {static_cast<uint32_t>(crc_),
+                                static_cast<uint32_t>(total_in_)};
+    for (uint32_t value : trailer) {
+      for (int i = 0; i < 4; i++)
+        output_.push_back(static_cast<char>((value >> (8 * i)) & 0xff));
+    }
+    finished_ = true;
+  }
+
+  // Keep the tail of the consumed input to prime the next batch. A full
+  // flush does not reference earlier input, like in zlib.
+  if (flush_ == Z_FULL_FLUSH) {
+    dictionary_.clear();
+  } else if (length >= kDictionarySize) {
+    dictionary_.assign(input_.begin() + length - kDictionarySize,
+                       input_.begin() + length);
+  } else {
+    dictionary_.insert(
+        dictionary_.end(), input_.begin(), input_.begin() + length);
+    if (dictionary_.size() > kDictionarySize) {
+      dictionary_.erase(dictionary_.begin(),
+                        dictionary_.end() - kDictionarySize);
+    }
+  }
+  input_.erase(input_.begin(), input_.begin() + length);
+}
+
+}  // anonymous namespace
+
+PooledZStream::PooledZStream() {
+  strm.zalloc = Alloc;
+  strm.zfree = Free;
+  strm.opaque = this;
+}
+
+PooledZStream::~PooledZStream() {
+  if (initialized) deflateEnd(&strm);
+}
+
+void* PooledZStream::Alloc(void* data, uInt items, uInt size) {
+  constexpr size_t offset = std::max(sizeof(size_t), alignof(max_align_t));
+  PooledZStream* self = static_cast<PooledZStream*>(data);
+  size_t real_size =
+      MultiplyWithOverflowCheck(static_cast<size_t>(items),
+                                static_cast<size_t>(size)) + offset;
+  char* memory = UncheckedMalloc(real_size);
+  if (memory == nullptr) [[unlikely]] {
+    return nullptr;
+  }
+  *reinterpret_cast<size_t*>(memory) = real_size;
+  self->held += real_size;
+  if (self->account != nullptr)
+    self->account->fetch_add(real_size, std::memory_order_relaxed);
+  return memory + offset;
+}
+
+void PooledZStream::Free(void* data, void* pointer) {
+  if (pointer == nullptr) [[unlikely]] {
+    return;
+  }
+  constexpr size_t offset = std::max(sizeof(size_t), alignof(max_align_t));
+  PooledZStream* self = static_cast<PooledZStream*>(data);
+  char* real_pointer = static_cast<char*>(pointer) - offset;
+  size_t real_size = *reinterpret_cast<size_t*>(real_pointer);
+  self->held -= real_size;
+  if (self->account != nullptr)
+    self->account->fetch_sub(real_size, std::memory_order_relaxed);
+  free(real_pointer);
+}
+
+ZlibBindingData::ZlibBindingData(Realm* realm, Local<Object> wrap)
+    : SnapshotableObject(realm, wrap, type_int) {}
+
+ZlibBindingData::~ZlibBindingData() = default;
+
+bool ZlibBindingData::PrepareForSerialization(Local<Context> context,
+                                              v8::SnapshotCreator* creator) {
+  // The pooled contexts are plain native memory and are simply left behind;
+  // the deserialized binding starts with empty pools.
+  // Return true because we need to maintain the reference to the binding from
+  // JS land.
+  return true;
+}
+
+InternalFieldInfoBase* ZlibBindingData::Serialize(int index) {
+  DCHECK_IS_SNAPSHOT_SLOT(index);
+  InternalFieldInfo* info =
+      InternalFieldInfoBase::New<InternalFieldInfo>(type());
+  return info;
+}
+
+void ZlibBindingData::Deserialize(Local<Context> context,
+                                  Local<Object> holder,
+                                  int index,
+                                  InternalFieldInfoBase* info) {
+  DCHECK_IS_SNAPSHOT_SLOT(index);
+  HandleScope scope(context->GetIsolate());
+  Realm* realm = Realm::GetCurrent(context);
+  ZlibBindingData* binding = realm->AddBindingData<ZlibBindingData>(holder);
+  CHECK_NOT_NULL(binding);
+}
+
+std::unique_ptr<PooledZStream> ZlibBindingData::TakeDeflateStream(
+    uint32_t key) {
+  auto it = deflate_streams_.find(key);
+  if (it == deflate_streams_.end()) return nullptr;
+  std::unique_ptr<PooledZStream> strm = std::move(it->second);
+  deflate_streams_.erase(it);
+  return strm;
+}
+
+void ZlibBindingData::ReleaseDeflateStream(
+    uint32_t key, std::unique_ptr<PooledZStream> strm) {
+  CHECK_NULL(strm->account);
+  if (deflate_streams_.size() < kMaxIdleDeflateStreams)
+    deflate_streams_.emplace(key, std::move(strm));
+}
+
+ZstdCCtxPointer ZlibBindingData::TakeZstdCompressContext() {
+  if (zstd_compress_contexts_.empty()) return nullptr;
+  ZstdCCtxPointer cctx = std::move(zstd_compress_contexts_.back());
+  zstd_compress_contexts_.pop_back();
+  return cctx;
+}
+
+void ZlibBindingData::ReleaseZstdCompressContext(ZstdCCtxPointer cctx) {
+  if (zstd_compress_contexts_.size() < kMaxIdleZstdCompressContexts)
+    zstd_compress_contexts_.push_back(std::move(cctx));
+}
+
+#if NODE_USE_LIBDEFLATE
+libdeflate_compressor* ZlibBindingData::GetLibdeflateCompressor(int level) {
+  CHECK(level >= 0 && level < static_cast<int>(
+                                  arraysize(libdeflate_compressors_)));
+  if (!libdeflate_compressors_[level])
+    libdeflate_compressors_[level].reset(libdeflate_alloc_compressor(level));
+  return libdeflate_compressors_[level].get();
+}
+
+libdeflate_decompressor* ZlibBindingData::GetLibdeflateDecompressor() {
+  if (!libdeflate_decompressor_)
+    libdeflate_decompressor_.reset(libdeflate_alloc_decompressor());
+  return libdeflate_decompressor_.get();
+}
+#endif
+
+void ZlibBindingData::MemoryInfo(MemoryTracker* tracker) const {
+  size_t deflate_size = 0;
+  for (const auto& entry : deflate_streams_)
+    deflate_size += sizeof(PooledZStream) + entry.second->held;
+  tracker->TrackFieldWithSize("deflate_streams", deflate_size);
+
+  size_t zstd_size = 0;
+  for (const auto& cctx : zstd_compress_contexts_)
+    zstd_size += ZSTD_sizeof_CCtx(cctx.get());
+  tracker->TrackFieldWithSize("zstd_compress_contexts", zstd_size);
+}
+
+namespace {
+
+CompressionDictionaryData::CompressionDictionaryData(
+    std::vector<unsigned char>&& bytes, int zstd_level)
+    : bytes(std::move(bytes)),
+      cdict(ZSTD_createCDict(
+          this->bytes.data(), this->bytes.size(), zstd_level)),
+      ddict(ZSTD_createDDict(this->bytes.data(), this->bytes.size())) {}
+
+Local<FunctionTemplate> CompressionDictionary::GetConstructorTemplate(
+    Environment* env) {
+  Local<FunctionTemplate> tmpl =
+      env->compression_dictionary_constructor_template();
+  if (tmpl.IsEmpty()) {
+    Isolate* isolate = env->isolate();
+    tmpl = NewFunctionTemplate(isolate, New);
+    tmpl->InstanceTemplate()->SetInternalFieldCount(
+        BaseObject::kInternalFieldCount);
+    tmpl->SetClassName(
+        FIXED_ONE_BYTE_STRING(isolate, "CompressionDictionary"));
+    env->set_compression_dictionary_constructor_template(tmpl);
+  }
+  return tmpl;
+}
+
+bool CompressionDictionary::HasInstance(Environment* env,
+                                        Local<Value> value) {
+  return GetConstructorTemplate(env)->HasInstance(value);
+}
+
+void CompressionDictionary::Initialize(Environment* env,
+                                       Local<Object> target) {
+  SetConstructorFunction(env->context(),
+                         target,
+                         "CompressionDictionary",
+                         GetConstructorTemplate(env));
+}
+
+void CompressionDictionary::RegisterExternalReferences(
+    ExternalReferenceRegistry* registry) {
+  registry->Register(New);
+}
+
+BaseObjectPtr<CompressionDictionary> CompressionDictionary::Create(
+    Environment* env, std::shared_ptr<const CompressionDictionaryData> data) {
+  Local<Object> obj;
+  if (!GetConstructorTemplate(env)
+           ->InstanceTemplate()
+           ->NewInstance(env->context())
+           .ToLocal(&obj)) {
+    return {};
+  }
+  return MakeBaseObject<CompressionDictionary>(env, obj, std::move(data));
+}
+
+void CompressionDictionary::New(const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+  CHECK(args.IsConstructCall());
+  CHECK(Buffer::HasInstance(args[0]));
+
+  int zstd_level = ZSTD_CLEVEL_DEFAULT;
+  if (args[1]->IsInt32()) zstd_level = args[1].As<Int32>()->Value();
+
+  const unsigned char* data =
+      reinterpret_cast<const unsigned char*>(Buffer::Data(args[0]));
+  std::vector<unsigned char> bytes(data, data + Buffer::Length(args[0]));
+  auto dictionary =
+      std::make_shared<CompressionDictionaryData>(std::move(bytes), zstd_level);
+  if (!dictionary->cdict || !dictionary->ddict) {
+    return THROW_ERR_ZLIB_INITIALIZATION_FAILED(
+        env, "Could not load dictionary");
+  }
+
+  new CompressionDictionary(env, args.This(), std::move(dictionary));
+}
+
+BaseObjectPtr<BaseObject>
+CompressionDictionary::CompressionDictionaryTransferData::Deserialize(
+    Environment* env,
+    Local<Context> context,
+    std::unique_ptr<worker::TransferData> self) {
+  if (context != env->context()) [[unlikely]] {
+    THROW_ERR_MESSAGE_TARGET_CONTEXT_UNAVAILABLE(env);
+    return {};
+  }
+  return Create(env, data_);
+}
+
 template <typename Stream>
 struct MakeClass {
   static void Make(Environment* env, Local<Object> target, const char* name) {
@@ -1636,19 +2621,441 @@ static void CRC32(const FunctionCallbackInfo<Value>& args) {
   args.GetReturnValue().Set(result);
 }
 
+// Throws |err| with the same errno and code properties that stream errors
+// are reported with.
+void ThrowCompressionError(Environment* env, const CompressionError& err) {
+  Isolate* isolate = env->isolate();
+  Local<Context> context = env->context();
+  Local<Object> error =
+      v8::Exception::Error(OneByteString(isolate, err.message)).As<Object>();
+  if (error->Set(context, env->errno_string(), Integer::New(isolate, err.err))
+          .IsNothing() ||
+      error->Set(context, env->code_string(), OneByteString(isolate, err.code))
+          .IsNothing()) {
+    return;
+  }
+  isolate->ThrowException(error);
+}
+
+constexpr size_t kMinSyncOutputSize = 16 * 1024;
+
+// Runs |ctx| over all of |input| on the current thread, the way the JS
+// stream loop does for the sync convenience methods, but without going
+// back and forth between JS and C++ per chunk. |out| grows as needed, up to
+// |max_output_length| bytes. Returns false with an exception pending on
+// failure.
+template <typename Context>
+bool ProcessSync(Environment* env,
+                 Context* ctx,
+                 const ArrayBufferViewContents<char>& input,
+                 int finish_flush,
+                 int no_flush,
+                 size_t max_output_length,
+                 MallocedBuffer<char>* out,
+                 size_t* written) {
+  size_t in_offset = 0;
+  size_t out_offset = 0;
+  for (;;) {
+    size_t in_remaining = input.length() - in_offset;
+    uint32_t in_len = static_cast<uint32_t>(
+        std::min<size_t>(in_remaining, std::numeric_limits<uint32_t>::max()));
+    uint32_t out_len = static_cast<uint32_t>(std::min<size_t>(
+        out->size - out_offset, std::numeric_limits<uint32_t>::max()));
+    ctx->SetFlush(in_len == in_remaining ? finish_flush : no_flush);
+    ctx->SetBuffers(
+        input.data() + in_offset, in_len, out->data + out_offset, out_len);
+    ctx->DoThreadPoolWork();
+
+    const CompressionError err = ctx->GetErrorInfo();
+    if (err.IsError()) {
+      ThrowCompressionError(env, err);
+      return false;
+    }
+
+    uint32_t avail_in;
+    uint32_t avail_out;
+    ctx->GetAfterWriteOffsets(&avail_in, &avail_out);
+    in_offset += in_len - avail_in;
+    out_offset += out_len - avail_out;
+
+    if (avail_out != 0) {
+      // Either all input of this round was consumed, or the stream ended.
+      if (avail_in != 0 || in_len == in_remaining) {
+        *written = out_offset;
+        return true;
+      }
+      continue;
+    }
+    if (out_offset < out->size) continue;
+
+    if (out->size >= max_output_length) {
+      char message[128];
+      snprintf(message,
+               sizeof(message),
+               "Cannot create a Buffer larger than %zu bytes",
+               max_output_length);
+      THROW_ERR_BUFFER_TOO_LARGE(env, message);
+      return false;
+    }
+    size_t size = std::min(std::max(out->size * 2, kMinSyncOutputSize),
+                           max_output_length);
+    char* data = UncheckedRealloc(out->data, size);
+    if (data == nullptr) {
+      THROW_ERR_MEMORY_ALLOCATION_FAILED(env);
+      return false;
+    }
+    out->data = data;
+    out->size = size;
+  }
+}
+
+// Hands the first |written| bytes of |out| to a new Buffer.
+void ReturnSyncOutput(const FunctionCallbackInfo<Value>& args,
+                      MallocedBuffer<char>* out,
+                      size_t written) {
+  Environment* env = Environment::GetCurrent(args);
+  Local<Object> buffer;
+  if (written == 0) {
+    if (!Buffer::New(env, 0).ToLocal(&buffer)) return;
+  } else {
+    if (written < out->size) out->Realloc(written);
+    if (!Buffer::New(
+             env,
+             out->release(),
+             written,
+             [](char* data, void* hint) { free(data); },
+             nullptr)
+             .ToLocal(&buffer)) {
+      return;
+    }
+  }
+  args.GetReturnValue().Set(buffer);
+}
+
+size_t InitialSyncOutputSize(size_t input_length, size_t max_output_length) {
+  // Inflated data is usually a few times larger than its input.
+  size_t size = std::max(MultiplyWithOverflowCheck<size_t>(input_length, 4),
+                         kMinSyncOutputSize);
+  return std::max<size_t>(std::min(size, max_output_length), 1);
+}
+
+// Stream headers (the gzip trailer, the zstd frame header) can claim any
+// output size, so the size they record is only trusted up to this much;
+// the output buffer grows past it as data actually arrives.
+constexpr size_t kMaxSyncOutputSizeHint = 16 * 1024 * 1024;
+
+size_t SyncOutputSizeFromHeader(uint64_t recorded_size,
+                                size_t max_output_length) {
+  uint64_t size = std::min<uint64_t>(
+      {recorded_size, max_output_length, kMaxSyncOutputSizeHint});
+  return std::max<size_t>(static_cast<size_t>(size), 1);
+}
+
+// Like the MallocedBuffer constructor, but throws instead of aborting when
+// |size| cannot be allocated.
+bool AllocateSyncOutput(Environment* env,
+                        size_t size,
+                        MallocedBuffer<char>* out) {
+  size = std::max<size_t>(size, 1);
+  *out = MallocedBuffer<char>(UncheckedMalloc(size), size);
+  if (out->is_empty()) {
+    THROW_ERR_MEMORY_ALLOCATION_FAILED(env);
+    return false;
+  }
+  return true;
+}
+
+#if NODE_USE_LIBDEFLATE
+// Serves the common cases of zlibSync() with libdeflate, which is
+// considerably faster than zlib for complete buffers. Returns false when
+// zlib has to handle the input instead: unsupported options, but also any
+// failure, so that errors are reported exactly the way zlib reports them.
+bool LibdeflateSync(ZlibBindingData* binding_data,
+                    node_zlib_mode mode,
+                    const ArrayBufferViewContents<char>& input,
+                    uint32_t window_bits,
+                    int level,
+                    uint32_t strategy,
+                    size_t max_output_length,
+                    MallocedBuffer<char>* out,
+                    size_t* written) {
+  if (mode == DEFLATE || mode == GZIP || mode == DEFLATERAW) {
+    // libdeflate always uses a 32 KiB window and its own strategy.
+    if (window_bits != 15 || strategy != Z_DEFAULT_STRATEGY) return false;
+    libdeflate_compressor* compressor = binding_data->GetLibdeflateCompressor(
+        level == Z_DEFAULT_COMPRESSION ? 6 : level);
+    if (compressor == nullptr) return false;
+
+    size_t bound;
+    if (mode == DEFLATE)
+      bound = libdeflate_zlib_compress_bound(compressor, input.length());
+    else if (mode == GZIP)
+      bound = libdeflate_gzip_compress_bound(compressor, input.length());
+    else
+      bound = libdeflate_deflate_compress_bound(compressor, input.length());
+    if (bound > max_output_length) return false;
+
+    MallocedBuffer<char> buffer(UncheckedMalloc(bound), bound);
+    if (buffer.is_empty()) return false;
+    size_t size;
+    if (mode == DEFLATE) {
+      size = libdeflate_zlib_compress(
+          compressor, input.data(), input.length(), buffer.data, bound);
+    } else if (mode == GZIP) {
+      size = libdeflate_gzip_compress(
+          compressor, input.data(), input.length(), buffer.data, bound);
+    } else {
+      size = libdeflate_deflate_compress(
+          compressor, input.data(), input.length(), buffer.data, bound);
+    }
+    if (size == 0) return false;
+    *out = std::move(buffer);
+    *written = size;
+    return true;
+  }
+
+  // zlib rejects streams whose window exceeds windowBits, and UNZIP needs
+  // header detection; leave both to zlib.
+  if (mode == UNZIP || (window_bits != 0 && window_bits != 15)) return false;
+  libdeflate_decompressor* decompressor =
+      binding_data->GetLibdeflateDecompressor();
+  if (decompressor == nullptr) return false;
+
+  size_t size = InitialSyncOutputSize(input.length(), max_output_length);
+  if (mode == GUNZIP && input.length() >= 18) {
+    // The gzip trailer records the uncompressed size (mod 2^32) of the
+    // last member, which is usually the only one.
+    const uint8_t* trailer =
+        reinterpret_cast<const uint8_t*>(input.data()) + input.length() - 4;
+    size_t isize = trailer[0] | (trailer[1] << 8) | (trailer[2] << 16) |
+                   (static_cast<size_t>(trailer[3]) << 24);
+    size = SyncOutputSizeFromHeader(isize, max_output_length);
+  }
+  MallocedBuffer<char> buffer(UncheckedMalloc(size), size);
+  if (buffer.is_empty()) return false;
+
+  size_t in_offset = 0;
+  size_t out_offset = 0;
+  for (;;) {
+    size_t in_used;
+    size_t out_used;
+    libdeflate_result result;
+    for (;;) {
+      const char* in = input.data() + in_offset;
+      size_t in_len = input.length() - in_offset;
+      char* dest = buffer.data + out_offset;
+      size_t dest_len = buffer.size - out_offset;
+      if (mode == GUNZIP) {
+        result = libdeflate_gzip_decompress_ex(
+            decompressor, in, in_len, dest, dest_len, &in_used, &out_used);
+      } else if (mode == INFLATE) {
+        result = libdeflate_zlib_decompress_ex(
+            decompressor, in, in_len, dest, dest_len, &in_used, &out_used);
+      } else {
+        result = libdeflate_deflate_decompress_ex(
+            decompressor, in, in_len, dest, dest_len, &in_used, &out_used);
+      }
+      if (result != LIBDEFLATE_INSUFFICIENT_SPACE ||
+          buffer.size >= max_output_length) {
+        break;
+      }
+      size = std::min(std::max(buffer.size * 2, kMinSyncOutputSize),
+                      max_output_length);
+      char* data = UncheckedRealloc(buffer.data, size);
+      if (data == nullptr) return false;
+      buffer.data = data;
+      buffer.size = size;
+    }
+    if (result != LIBDEFLATE_SUCCESS) return false;
+
+    in_offset += in_used;
+    out_offset += out_used;
+    // Like ZlibContext, continue with the next gzip member unless the rest
+    // of the input is zero padding.
+    if (mode != GUNZIP || in_offset == input.length() ||
+        input.data()[in_offset] == 0) {
+      break;
+    }
+  }
+
+  *out = std::move(buffer);
+  *written = out_offset;
+  return true;
+}
+#endif
+
+// zlibSync(mode, input, windowBits, level, memLevel, strategy, dictionary,
+//          maxOutputLength)
+//
+// Compresses or decompresses a complete input in one call. Deflate output
+// is sized with deflateBound() up front, so it takes a single pass.
+static void ZlibSync(const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+  Local<Context> context = env->context();
+  CHECK_EQ(args.Length(), 8);
+
+  CHECK(args[0]->IsUint32());
+  uint32_t mode = args[0].As<v8::Uint32>()->Value();
+  CHECK(mode >= DEFLATE && mode <= UNZIP);
+
+  CHECK(args[1]->IsArrayBufferView());
+  ArrayBufferViewContents<char> input(args[1]);
+
+  uint32_t window_bits;
+  if (!args[2]->Uint32Value(context).To(&window_bits)) return;
+  int32_t level;
+  if (!args[3]->Int32Value(context).To(&level)) return;
+  uint32_t mem_level;
+  if (!args[4]->Uint32Value(context).To(&mem_level)) return;
+  uint32_t strategy;
+  if (!args[5]->Uint32Value(context).To(&strategy)) return;
+  SharedDictionaryBytes dictionary = GetZlibDictionary(env, args[6]);
+  CHECK(args[7]->IsNumber());
+  size_t max_output_length =
+      static_cast<size_t>(args[7].As<Number>()->Value());
+
+#if NODE_USE_LIBDEFLATE
+  if (!dictionary) {
+    MallocedBuffer<char> out;
+    size_t written;
+    if (LibdeflateSync(Realm::GetBindingData<ZlibBindingData>(args),
+                       static_cast<node_zlib_mode>(mode),
+                       input,
+                       window_bits,
+                       level,
+                       strategy,
+                       max_output_length,
+                       &out,
+                       &written)) {
+      return ReturnSyncOutput(args, &out, written);
+    }
+  }
+#endif
+
+  // Pooled deflate state is accounted to |allocations|, everything else
+  // uses zlib's default allocator. Both are released before returning.
+  std::atomic<ssize_t> allocations{0};
+  ZlibContext ctx;
+  auto close = OnScopeLeave([&]() { ctx.Close(); });
+  ctx.SetMode(static_cast<node_zlib_mode>(mode));
+  ctx.SetAllocationFunctions(Z_NULL, Z_NULL, Z_NULL);
+  ctx.SetPool(BaseObjectPtr<ZlibBindingData>(
+                  Realm::GetBindingData<ZlibBindingData>(args)),
+              &allocations);
+  ctx.Init(level, window_bits, mem_level, strategy, std::move(dictionary));
+
+  size_t size = ctx.CompressBound(input.length());
+  const CompressionError err = ctx.GetErrorInfo();
+  if (err.IsError()) return ThrowCompressionError(env, err);
+  if (size == 0)
+    size = InitialSyncOutputSize(input.length(), max_output_length);
+
+  MallocedBuffer<char> out;
+  if (!AllocateSyncOutput(env, std::min(size, max_output_length), &out))
+    return;
+  size_t written;
+  if (!ProcessSync(env,
+                   &ctx,
+                   input,
+                   Z_FINISH,
+                   Z_NO_FLUSH,
+                   max_output_length,
+                   &out,
+                   &written)) {
+    return;
+  }
+  ReturnSyncOutput(args, &out, written);
+}
+
+// zstdSync(compress, input, params, pledgedSrcSize, dictionary,
+//          maxOutputLength)
+//
+// The zstd counterpart of zlibSync(). Compression output is sized with
+// ZSTD_compressBound(), and decompression output with the content size
+// recorded in the frame headers, when present, up to kMaxSyncOutputSizeHint.
+static void ZstdSync(const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+  CHECK_EQ(args.Length(), 6);
+
+  CHECK(args[0]->IsBoolean());
+  bool compress = args[0]->IsTrue();
+  CHECK(args[1]->IsArrayBufferView());
+  ArrayBufferViewContents<char> input(args[1]);
+  uint64_t pledged_src_size = ZSTD_CONTENTSIZE_UNKNOWN;
+  if (args[3]->IsNumber())
+    pledged_src_size = static_cast<uint64_t>(args[3].As<Number>()->Value());
+  CompressionDictionary* dictionary = nullptr;
+  if (!args[4]->IsUndefined()) {
+    CHECK(CompressionDictionary::HasInstance(env, args[4]));
+    dictionary = BaseObject::Unwrap<CompressionDictionary>(args[4]);
+  }
+  CHECK(args[5]->IsNumber());
+  size_t max_output_length =
+      static_cast<size_t>(args[5].As<Number>()->Value());
+
+  auto run = [&](auto* ctx, size_t size) {
+    CompressionError err = ctx->Init(pledged_src_size);
+    if (!err.IsError()) err = SetZstdParameters(ctx, args[2]);
+    if (!err.IsError() && dictionary != nullptr)
+      err = ctx->SetDictionary(dictionary->data());
+    if (err.IsError())
+      return THROW_ERR_ZLIB_INITIALIZATION_FAILED(env, err.message);
+
+    MallocedBuffer<char> out;
+    if (!AllocateSyncOutput(env, std::min(size, max_output_length), &out))
+      return;
+    size_t written;
+    if (!ProcessSync(env,
+                     ctx,
+                     input,
+                     ZSTD_e_end,
+                     ZSTD_e_continue,
+                     max_output_length,
+                     &out,
+                     &written)) {
+      return;
+    }
+    ReturnSyncOutput(args, &out, written);
+  };
+
+  if (compress) {
+    ZstdCompressContext ctx;
+    ctx.SetPool(BaseObjectPtr<ZlibBindingData>(
+        Realm::GetBindingData<ZlibBindingData>(args)));
+    auto close = OnScopeLeave([&]() { ctx.Close(); });
+    run(&ctx, ZSTD_compressBound(input.length()));
+  } else {
+    ZstdDecompressContext ctx;
+    // Only the first frame is looked at; the output grows if there are more.
+    uint64_t content_size =
+        ZSTD_getFrameContentSize(input.data(), input.length());
+    bool known = content_size != ZSTD_CONTENTSIZE_UNKNOWN &&
+                 content_size != ZSTD_CONTENTSIZE_ERROR;
+    run(&ctx,
+        known ? SyncOutputSizeFromHeader(content_size, max_output_length)
+              : InitialSyncOutputSize(input.length(), max_output_length));
+  }
+}
+
 void Initialize(Local<Object> target,
                 Local<Value> unused,
                 Local<Context> context,
                 void* priv) {
-  Environment* env = Environment::GetCurrent(context);
+  Realm* realm = Realm::GetCurrent(context);
+  Environment* env = realm->env();
+  if (realm->AddBindingData<ZlibBindingData>(target) == nullptr) return;
 
   MakeClass<ZlibStream>::Make(env, target, "Zlib");
   MakeClass<BrotliEncoderStream>::Make(env, target, "BrotliEncoder");
   MakeClass<BrotliDecoderStream>::Make(env, target, "BrotliDecoder");
   MakeClass<ZstdCompressStream>::Make(env, target, "ZstdCompress");
   MakeClass<ZstdDecompressStream>::Make(env, target, "ZstdDecompress");
+  MakeClass<ParallelGzipStream>::Make(env, target, "ParallelGzip");
+  CompressionDictionary::Initialize(env, target);
 
   SetMethod(context, target, "crc32", CRC32);
+  SetMethod(context, target, "zlibSync", ZlibSync);
+  SetMethod(context, target, "zstdSync", ZstdSync);
   target->Set(env->context(),
               FIXED_ONE_BYTE_STRING(env->isolate(), "ZLIB_VERSION"),
               FIXED_ONE_BYTE_STRING(env->isolate(), ZLIB_VERSION)).Check();
@@ -1660,7 +3067,11 @@ void RegisterExternalReferences(ExternalReferenceRegistry* registry) {
   MakeClass<BrotliDecoderStream>::Make(registry);
   MakeClass<ZstdCompressStream>::Make(registry);
   MakeClass<ZstdDecompressStream>::Make(registry);
+  MakeClass<ParallelGzipStream>::Make(registry);
+  CompressionDictionary::RegisterExternalReferences(registry);
   registry->Register(CRC32);
+  registry->Register(ZlibSync);
+  registry->Register(ZstdSync);
 }
 
 }  // anonymous namespace
@@ -1818,6 +3229,14 @@ void DefineZlibConstants(Local<Object> target) {
   NODE_DEFINE_CONSTANT(target, ZSTD_c_nbWorkers);
   NODE_DEFINE_CONSTANT(target, ZSTD_c_jobSize);
   NODE_DEFINE_CONSTANT(target, ZSTD_c_overlapLog);
+  {
+    // The largest accepted ZSTD_c_nbWorkers, which is 0 unless zstd was
+    // built with multithreading support.
+    ZSTD_bounds bounds = ZSTD_cParam_getBounds(ZSTD_c_nbWorkers);
+    const int ZSTD_NB_WORKERS_MAX =
+        ZSTD_isError(bounds.error) ? 0 : bounds.upperBound;
+    NODE_DEFINE_CONSTANT(target, ZSTD_NB_WORKERS_MAX);
+  }
   NODE_DEFINE_CONSTANT(target, ZSTD_d_windowLogMax);
   NODE_DEFINE_CONSTANT(target, ZSTD_CLEVEL_DEFAULT);
   // Error codes
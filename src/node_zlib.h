@@ -0,0 +1,85 @@
+#ifndef SRC_NODE_ZLIB_H_
+#define SRC_NODE_ZLIB_H_
+
+#if defined(NODE_WANT_INTERNALS) && NODE_WANT_INTERNALS
+
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include "node_snapshotable.h"
+#include "util.h"
+#include "v8.h"
+#include "zstd.h"
+
+#if NODE_USE_LIBDEFLATE
+#include "libdeflate.h"
+#endif
+
+namespace node {
+
+struct PooledZStream;
+
+// Wraps ZSTD_freeCCtx to remove the return type.
+inline void FreeZstdCompressContext(ZSTD_CCtx* cctx) {
+  ZSTD_freeCCtx(cctx);
+}
+using ZstdCCtxPointer = DeleteFnPtr<ZSTD_CCtx, FreeZstdCompressContext>;
+
+// Per-realm state of the zlib binding. It keeps a bounded number of reset
+// compression contexts around, so that short-lived streams (e.g. one per
+// HTTP response) don't allocate and initialize their state from scratch.
+// Brotli is not pooled because its encoder cannot be reset.
+// Idle contexts are not reported as external memory: the pool is bounded
+// and garbage collection could not reclaim them anyway.
+class ZlibBindingData final : public SnapshotableObject {
+ public:
+  ZlibBindingData(Realm* realm, v8::Local<v8::Object> wrap);
+  ~ZlibBindingData() override;
+
+  using InternalFieldInfo = InternalFieldInfoBase;
+
+  SET_BINDING_ID(zlib_binding_data)
+  SERIALIZABLE_OBJECT_METHODS()
+
+  static constexpr size_t kMaxIdleDeflateStreams = 16;
+  static constexpr size_t kMaxIdleZstdCompressContexts = 4;
+
+  // Returns nullptr if there is no idle deflate stream for |key|.
+  std::unique_ptr<PooledZStream> TakeDeflateStream(uint32_t key);
+  // |strm| must have been reset and have no owner.
+  void ReleaseDeflateStream(uint32_t key, std::unique_ptr<PooledZStream> strm);
+
+  ZstdCCtxPointer TakeZstdCompressContext();
+  // |cctx| must have been reset, including its parameters.
+  void ReleaseZstdCompressContext(ZstdCCtxPointer cctx);
+
+#if NODE_USE_LIBDEFLATE
+  // Lazily allocated and then kept for the lifetime of the realm. Return
+  // nullptr if allocation fails.
+  libdeflate_compressor* GetLibdeflateCompressor(int level);
+  libdeflate_decompressor* GetLibdeflateDecompressor();
+#endif
+
+  void MemoryInfo(MemoryTracker* tracker) const override;
+  SET_SELF_SIZE(ZlibBindingData)
+  SET_MEMORY_INFO_NAME(ZlibBindingData)
+
+ private:
+  std::unordered_multimap<uint32_t, std::unique_ptr<PooledZStream>>
+      deflate_streams_;
+  std::vector<ZstdCCtxPointer> zstd_compress_contexts_;
+
+#if NODE_USE_LIBDEFLATE
+  // Indexed by compression level, 0 to 12.
+  DeleteFnPtr<libdeflate_compressor, libdeflate_free_compressor>
+      libdeflate_compressors_[13];
+  DeleteFnPtr<libdeflate_decompressor, libdeflate_free_decompressor>
+      libdeflate_decompressor_;
+#endif
+};
+
+}  // namespace node
+
+#endif  // defined(NODE_WANT_INTERNALS) && NODE_WANT_INTERNALS
+
+#endif  // SRC_NODE_ZLIB_H_
@@ -1,11 +1,24 @@
 #include "path.h"
+#include <cstring>
 #include <string>
 #include <vector>
 #include "env-inl.h"
+#include "node_errors.h"
+#include "node_external_reference.h"
 #include "node_internals.h"
 
 namespace node {
 
+using v8::Array;
+using v8::Context;
+using v8::FunctionCallbackInfo;
+using v8::Isolate;
+using v8::Local;
+using v8::LocalVector;
+using v8::Object;
+using v8::String;
+using v8::Value;
+
 #ifdef _WIN32
 constexpr bool IsPathSeparator(const char c) noexcept {
   return c == '\\' || c == '/';
@@ -16,10 +29,27 @@ constexpr bool IsPathSeparator(const char c) noexcept {
 }
 #endif  // _WIN32
 
+// Returns the index of the first path separator in |path| at or after
+// |start|, or path.size(). memchr() is vectorized by the C library, which
+// makes scanning long segments much faster than a loop over the characters.
+static size_t FindPathSeparator(std::string_view path, size_t start) {
+#ifdef _WIN32
+  size_t pos = path.find_first_of("\\/", start);
+  return pos == std::string_view::npos ? path.size() : pos;
+#else
+  if (start >= path.size()) return path.size();
+  const void* pos =
+      memchr(path.data() + start, '/', path.size() - start);
+  return pos == nullptr ? path.size()
+                        : static_cast<const char*>(pos) - path.data();
+#endif  // _WIN32
+}
+
 std::string NormalizeString(const std::string_view path,
                             bool allowAboveRoot,
                             const std::string_view separator) {
   std::string res;
+  res.reserve(path.size());
   int lastSegmentLength = 0;
   int lastSlash = -1;
   int dots = 0;
@@ -46,7 +76,7 @@ std::string NormalizeString(const std::string_view path,
               res = "";
               lastSegmentLength = 0;
             } else {
-              res = res.substr(0, lastSlashIndex);
+              res.resize(lastSlashIndex);
               len = res.length();
               lastSegmentLength = len - 1 - res.find_last_of(separator);
             }
@@ -63,16 +93,13 @@ std::string NormalizeString(const std::string_view path,
         }
 
         if (allowAboveRoot) {
-          res += res.length() > 0 ? std::string(separator) + ".." : "..";
+          if (!res.empty()) res += separator;
+          res += "..";
           lastSegmentLength = 2;
         }
       } else {
-        if (!res.empty()) {
-          res += std::string(separator) +
-                 std::string(path.substr(lastSlash + 1, i - (lastSlash + 1)));
-        } else {
-          res = path.substr(lastSlash + 1, i - (lastSlash + 1));
-        }
+        if (!res.empty()) res += separator;
+        res += path.substr(lastSlash + 1, i - (lastSlash + 1));
         lastSegmentLength = i - lastSlash - 1;
       }
       lastSlash = i;
@@ -80,7 +107,10 @@ std::string NormalizeString(const std::string_view path,
     } else if (code == '.' && dots != -1) {
       ++dots;
     } else {
+      // The rest of the segment can't change anything, skip to its end.
       dots = -1;
+      i = FindPathSeparator(path, i + 1) - 1;
+      code = path[i];
     }
   }
 
@@ -242,14 +272,16 @@ std::string PathResolve(Environment* env,
                         const std::vector<std::string_view>& paths) {
   std::string resolvedPath;
   bool resolvedAbsolute = false;
-  auto cwd = env->GetCwd(env->exec_path());
   const size_t numArgs = paths.size();
 
   for (int i = numArgs - 1; i >= -1 && !resolvedAbsolute; i--) {
-    const std::string& path = (i >= 0) ? std::string(paths[i]) : cwd;
+    // The current working directory is only needed, and only looked up,
+    // if none of the paths is absolute.
+    const std::string path =
+        (i >= 0) ? std::string(paths[i]) : env->GetCwd(env->exec_path());
 
     if (!path.empty()) {
-      resolvedPath = std::string(path) + "/" + resolvedPath;
+      resolvedPath = path + "/" + resolvedPath;
 
       if (path.front() == '/') {
         resolvedAbsolute = true;
@@ -333,4 +365,87 @@ void FromNamespacedPath(std::string* path) {
 #endif
 }
 
+std::string NormalizePosixPath(std::string_view path) {
+  if (path.empty()) return ".";
+  const bool is_absolute = path.front() == '/';
+  const bool trailing_separator = path.back() == '/';
+  std::string normalized = NormalizeString(path, !is_absolute, "/");
+  if (normalized.empty()) {
+    if (is_absolute) return "/";
+    return trailing_separator ? "./" : ".";
+  }
+  if (trailing_separator) normalized += '/';
+  return is_absolute ? "/" + normalized : normalized;
+}
+
+namespace path {
+
+// Calls |fn| with each string of the array args[0] and returns the array
+// of the strings that it returns, for bundlers and file system walkers that
+// process many paths at once.
+template <typename Fn>
+static void MapPaths(const FunctionCallbackInfo<Value>& args, Fn&& fn) {
+  CHECK(args[0]->IsArray());
+  Environment* env = Environment::GetCurrent(args);
+  Isolate* isolate = env->isolate();
+  Local<Context> context = env->context();
+  Local<Array> paths = args[0].As<Array>();
+  const uint32_t length = paths->Length();
+
+  LocalVector<Value> results(isolate, length);
+  for (uint32_t i = 0; i < length; i++) {
+    Local<Value> value;
+    if (!paths->Get(context, i).ToLocal(&value)) return;
+    if (!value->IsString()) {
+      THROW_ERR_INVALID_ARG_TYPE(env, "paths[%u] must be a string", i);
+      return;
+    }
+    Utf8Value path(isolate, value);
+    if (!ToV8Value(context, fn(path.ToStringView()), isolate)
+             .ToLocal(&results[i])) {
+      return;
+    }
+  }
+  args.GetReturnValue().Set(Array::New(isolate, results.data(), length));
+}
+
+// resolveBatch(paths[, base]) returns path.resolve(base, paths[i]) for
+// every path. base is resolved only once.
+static void ResolveBatch(const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+  std::string base;
+  if (args[1]->IsString()) {
+    Utf8Value base_value(env->isolate(), args[1]);
+    base = PathResolve(env, {base_value.ToStringView()});
+  } else {
+    base = PathResolve(env, {});
+  }
+  MapPaths(args, [&](std::string_view path) {
+    return PathResolve(env, {base, path});
+  });
+}
+
+// normalizeBatch(paths) returns path.posix.normalize(paths[i]) for every
+// path.
+static void NormalizeBatch(const FunctionCallbackInfo<Value>& args) {
+  MapPaths(args, NormalizePosixPath);
+}
+
+static void Initialize(Local<Object> target,
+                       Local<Value> unused,
+                       Local<Context> context,
+                       void* priv) {
+  SetMethodNoSideEffect(context, target, "resolveBatch", ResolveBatch);
+  SetMethodNoSideEffect(context, target, "normalizeBatch", NormalizeBatch);
+}
+
+static void RegisterExternalReferences(ExternalReferenceRegistry* registry) {
+  registry->Register(ResolveBatch);
+  registry->Register(NormalizeBatch);
+}
+
+}  // namespace path
 }  // namespace node
+
+NODE_BINDING_CONTEXT_AWARE_INTERNAL(path, node::path::Initialize)
+NODE_BINDING_EXTERNAL_REFERENCE(path, node::path::RegisterExternalReferences)
@@ -19,6 +19,10 @@ std::string NormalizeString(const std::string_view path,
 std::string PathResolve(Environment* env,
                         const std::vector<std::string_view>& paths);
 
+// Like path.posix.normalize(), except that on Windows backslashes are
+// separators too.
+std::string NormalizePosixPath(std::string_view path);
+
 #ifdef _WIN32
 constexpr bool IsWindowsDeviceRoot(const char c) noexcept;
 #endif  // _WIN32
@@ -49,10 +49,8 @@ void FreeRecursivelyNode(
   delete node;
 }
 
-bool is_tree_granted(
-    node::Environment* env,
-    const node::permission::FSPermission::RadixTree* granted_tree,
-    const std::string_view& param) {
+std::string ResolvePermissionPath(node::Environment* env,
+                                  std::string_view param) {
   std::string resolved_param = node::PathResolve(env, {param});
 #ifdef _WIN32
   // Remove leading "\\?\" from UNC path
@@ -69,7 +67,7 @@ bool is_tree_granted(
     resolved_param.erase(0, 2);
   }
 #endif
-  return granted_tree->Lookup(resolved_param, true);
+  return resolved_param;
 }
 
 void PrintTree(const node::permission::FSPermission::RadixTree::Node* node,
@@ -141,6 +139,8 @@ void FSPermission::Apply(Environment* env,
 
 void FSPermission::GrantAccess(PermissionScope perm, const std::string& res) {
   const std::string path = WildcardIfDir(res);
+  granted_in_cache_.Clear();
+  granted_out_cache_.Clear();
   if (perm == PermissionScope::kFileSystemRead &&
       !granted_in_fs_.Lookup(path)) {
     granted_in_fs_.Insert(path);
@@ -161,16 +161,50 @@ bool FSPermission::is_granted(Environment* env,
     case PermissionScope::kFileSystemRead:
       return !deny_all_in_ &&
              ((param.empty() && allow_all_in_) || allow_all_in_ ||
-              is_tree_granted(env, &granted_in_fs_, param));
+              IsTreeGranted(env, &granted_in_fs_, &granted_in_cache_, param));
     case PermissionScope::kFileSystemWrite:
       return !deny_all_out_ &&
              ((param.empty() && allow_all_out_) || allow_all_out_ ||
-              is_tree_granted(env, &granted_out_fs_, param));
+              IsTreeGranted(
+                  env, &granted_out_fs_, &granted_out_cache_, param));
     default:
       return false;
   }
 }
 
+bool FSPermission::IsTreeGranted(Environment* env,
+                                 const RadixTree* granted_tree,
+                                 CheckCache* cache,
+                                 std::string_view param) const {
+  // The cache is keyed by the resolved path, because the same relative
+  // path refers to a different file after process.chdir().
+  std::string resolved_param = ResolvePermissionPath(env, param);
+  std::optional<bool> cached = cache->Get(resolved_param);
+  if (cached.has_value()) return *cached;
+  bool granted = granted_tree->Lookup(resolved_param, true);
+  cache->Set(resolved_param, granted);
+  return granted;
+}
+
+std::optional<bool> FSPermission::CheckCache::Get(
+    std::string_view path) const {
+  const Entry& entry = entries_[std::hash<std::string_view>()(path) % kSize];
+  if (!entry.used || entry.path != path) return std::nullopt;
+  return entry.granted;
+}
+
+void FSPermission::CheckCache::Set(std::string_view path, bool granted) {
+  Entry& entry = entries_[std::hash<std::string_view>()(path) % kSize];
+  // Reuses the buffer of the entry's previous path.
+  entry.path.assign(path);
+  entry.granted = granted;
+  entry.used = true;
+}
+
+void FSPermission::CheckCache::Clear() {
+  for (Entry& entry : entries_) entry.used = false;
+}
+
 FSPermission::RadixTree::RadixTree() : root_node_(new Node("")) {}
 
 FSPermission::RadixTree::~RadixTree() {
@@ -184,7 +218,7 @@ bool FSPermission::RadixTree::Lookup(const std::string_view& s,
     return when_empty_return;
   }
   size_t parent_node_prefix_len = current_node->prefix.length();
-  const std::string path(s);
+  std::string_view path = s;
   auto path_len = path.length();
 
   while (true) {
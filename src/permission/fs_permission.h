@@ -5,7 +5,12 @@
 
 #include "v8.h"
 
-#include <unordered_map>
+#include <array>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
 #include "permission/permission_base.h"
 #include "util.h"
 
@@ -25,7 +30,10 @@ class FSPermission final : public PermissionBase {
   struct RadixTree {
     struct Node {
       std::string prefix;
-      std::unordered_map<char, Node*> children;
+      // Nodes rarely have more than a few children, so they are kept in a
+      // contiguous array and found with a linear scan, which is more cache
+      // friendly than a hash map.
+      std::vector<std::pair<char, Node*>> children;
       Node* wildcard_child;
       bool is_leaf;
 
@@ -34,6 +42,23 @@ class FSPermission final : public PermissionBase {
 
       Node() : wildcard_child(nullptr), is_leaf(false) {}
 
+      Node* FindChild(char label) const {
+        for (const auto& [child_label, child] : children) {
+          if (child_label == label) return child;
+        }
+        return nullptr;
+      }
+
+      void SetChild(char label, Node* child) {
+        for (auto& [child_label, existing_child] : children) {
+          if (child_label == label) {
+            existing_child = child;
+            return;
+          }
+        }
+        children.emplace_back(label, child);
+      }
+
       Node* CreateChild(const std::string& path_prefix) {
         if (path_prefix.empty() && !is_leaf) {
           is_leaf = true;
@@ -43,10 +68,11 @@ class FSPermission final : public PermissionBase {
         CHECK(!path_prefix.empty());
         char label = path_prefix[0];
 
-        Node* child = children[label];
+        Node* child = FindChild(label);
         if (child == nullptr) {
-          children[label] = new Node(path_prefix);
-          return children[label];
+          child = new Node(path_prefix);
+          SetChild(label, child);
+          return child;
         }
 
         // swap prefix
@@ -59,8 +85,8 @@ class FSPermission final : public PermissionBase {
 
             child->prefix = child_prefix;
             Node* split_child = new Node(parent_prefix);
-            split_child->children[child_prefix[0]] = child;
-            children[parent_prefix[0]] = split_child;
+            split_child->SetChild(child_prefix[0], child);
+            SetChild(parent_prefix[0], split_child);
 
             return split_child->CreateChild(path_prefix.substr(i));
           }
@@ -77,24 +103,23 @@ class FSPermission final : public PermissionBase {
         return wildcard_child;
       }
 
-      Node* NextNode(const std::string& path, size_t idx) const {
+      Node* NextNode(std::string_view path, size_t idx) const {
         if (idx >= path.length()) {
           return nullptr;
         }
 
         // wildcard node takes precedence
         if (children.size() > 1) {
-          auto it = children.find('*');
-          if (it != children.end()) {
-            return it->second;
+          Node* wildcard = FindChild('*');
+          if (wildcard != nullptr) {
+            return wildcard;
           }
         }
 
-        auto it = children.find(path[idx]);
-        if (it == children.end()) {
+        Node* child = FindChild(path[idx]);
+        if (child == nullptr) {
           return nullptr;
         }
-        auto child = it->second;
         // match prefix
         size_t prefix_len = child->prefix.length();
         for (size_t i = 0; i < path.length(); ++i) {
@@ -146,11 +171,40 @@ class FSPermission final : public PermissionBase {
     Node* root_node_;
   };
 
+  // Remembers the results of the last lookups of resolved paths in a
+  // RadixTree, so that repeated checks of the same hot paths don't walk
+  // the tree again. It is direct-mapped: a path replaces the entry of any
+  // other path with the same hash. FSPermission belongs to one
+  // Environment, so this is only used on its thread.
+  class CheckCache {
+   public:
+    static constexpr size_t kSize = 64;
+
+    std::optional<bool> Get(std::string_view path) const;
+    void Set(std::string_view path, bool granted);
+    void Clear();
+
+   private:
+    struct Entry {
+      std::string path;
+      bool granted = false;
+      bool used = false;
+    };
+    std::array<Entry, kSize> entries_;
+  };
+
  private:
   void GrantAccess(PermissionScope scope, const std::string& param);
+  bool IsTreeGranted(Environment* env,
+                     const RadixTree* granted_tree,
+                     CheckCache* cache,
+                     std::string_view param) const;
   // fs granted on startup
   RadixTree granted_in_fs_;
   RadixTree granted_out_fs_;
+  // Invalidated whenever the grants change.
+  mutable CheckCache granted_in_cache_;
+  mutable CheckCache granted_out_cache_;
 
   bool deny_all_in_ = true;
   bool deny_all_out_ = true;
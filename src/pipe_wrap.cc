@@ -78,6 +78,7 @@ void PipeWrap::Initialize(Local<Object> target,
 
   SetProtoMethod(isolate, t, "bind", Bind);
   SetProtoMethod(isolate, t, "listen", Listen);
+  SetProtoMethod(isolate, t, "setAcceptBatchSize", SetAcceptBatchSize);
   SetProtoMethod(isolate, t, "connect", Connect);
   SetProtoMethod(isolate, t, "open", Open);
 
@@ -109,6 +110,7 @@ void PipeWrap::RegisterExternalReferences(ExternalReferenceRegistry* registry) {
   registry->Register(New);
   registry->Register(Bind);
   registry->Register(Listen);
+  registry->Register(SetAcceptBatchSize);
   registry->Register(Connect);
   registry->Register(Open);
 #ifdef _WIN32
@@ -0,0 +1,395 @@
+#include "process_handle.h"
+#include "util-inl.h"
+
+#include <type_traits>
+
+#ifdef __linux__
+#include <dlfcn.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <spawn.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+
+extern char** environ;
+
+#ifndef __NR_pidfd_open
+#define __NR_pidfd_open 434
+#endif
+#ifndef __NR_pidfd_send_signal
+#define __NR_pidfd_send_signal 424
+#endif
+#endif  // __linux__
+
+namespace node {
+
+// Owners hand handle() to code that expects a pointer to the object itself.
+static_assert(std::is_standard_layout_v<ProcessHandle>);
+
+#ifdef __linux__
+namespace {
+
+int PidfdOpen(pid_t pid) {
+  return static_cast<int>(syscall(__NR_pidfd_open, pid, 0));
+}
+
+// pidfds are in Linux 5.3 and later.
+bool HavePidfds() {
+  static const bool have_pidfds = [] {
+    int fd = PidfdOpen(getpid());
+    if (fd == -1) return false;
+    close(fd);
+    return true;
+  }();
+  return have_pidfds;
+}
+
+using AddChdirFunction = int (*)(posix_spawn_file_actions_t*, const char*);
+
+// posix_spawn_file_actions_addchdir_np() is in glibc 2.29 and musl 1.1.24
+// and later, so it is looked up at runtime.
+AddChdirFunction GetAddChdir() {
+  static const AddChdirFunction add_chdir = reinterpret_cast<AddChdirFunction>(
+      dlsym(RTLD_DEFAULT, "posix_spawn_file_actions_addchdir_np"));
+  return add_chdir;
+}
+
+bool IsExecutableFile(const std::string& path, const char* cwd) {
+  const std::string full =
+      cwd != nullptr && path[0] != '/' ? std::string(cwd) + "/" + path : path;
+  struct stat st;
+  return stat(full.c_str(), &st) == 0 && S_ISREG(st.st_mode) &&
+         access(full.c_str(), X_OK) == 0;
+}
+
+// Finds |file| the way the execvp() in the child of uv_spawn() does: in the
+// PATH of the environment of the child, and relative to its working
+// directory. Returns an empty string when it is not found, or when there is
+// no PATH, whose default differs between libcs.
+std::string FindExecutable(const char* file, char** env, const char* cwd) {
+  if (*file == '\0') return "";
+  if (strchr(file, '/') != nullptr) return file;
+  const char* path = nullptr;
+  for (char** var = env; *var != nullptr; var++) {
+    if (strncmp(*var, "PATH=", 5) == 0) {
+      path = *var + 5;
+      break;
+    }
+  }
+  if (path == nullptr) return "";
+
+  std::string_view dirs = path;
+  while (true) {
+    const size_t end = dirs.find(':');
+    const std::string_view dir = dirs.substr(0, end);
+    // An empty entry is the working directory.
+    std::string candidate =
+        dir.empty() ? std::string("./") + file
+                    : std::string(dir) + "/" + file;
+    if (IsExecutableFile(candidate, cwd)) return candidate;
+    if (end == std::string_view::npos) return "";
+    dirs.remove_prefix(end + 1);
+  }
+}
+
+// Puts the fds of the child in place the way the child of uv_spawn() does.
+// |fds| holds the fd that becomes each fd of the child, or -1.
+int AddStdioActions(posix_spawn_file_actions_t* actions, std::vector<int> fds) {
+  const int count = fds.size();
+  std::vector<int> moved;
+  int err;
+
+  // First, move the fds that an earlier dup2() would replace, e.g. when
+  // swapping stdout and stderr, out of the way. So are those that are in
+  // place but close-on-exec, as dup2() onto the same fd leaves the flag.
+  for (int fd = 0; fd < count; fd++) {
+    const int use_fd = fds[fd];
+    if (use_fd < 0 || use_fd > fd) continue;
+    if (use_fd == fd && (fcntl(fd, F_GETFD) & FD_CLOEXEC) == 0) continue;
+    int tmp = count;
+    while (std::find(fds.begin(), fds.end(), tmp) != fds.end()) tmp++;
+    err = posix_spawn_file_actions_adddup2(actions, use_fd, tmp);
+    if (err != 0) return err;
+    fds[fd] = tmp;
+    moved.push_back(tmp);
+  }
+
+  for (int fd = 0; fd < count; fd++) {
+    const int use_fd = fds[fd];
+    if (use_fd < 0) {
+      if (fd >= 3) continue;
+      // Like uv_spawn(), give the child /dev/null rather than a closed fd.
+      err = posix_spawn_file_actions_addopen(
+          actions, fd, "/dev/null", fd == 0 ? O_RDONLY : O_RDWR, 0);
+      if (err != 0) return err;
+      continue;
+    }
+    if (use_fd != fd) {
+      err = posix_spawn_file_actions_adddup2(actions, use_fd, fd);
+      if (err != 0) return err;
+    }
+    // uv_spawn() makes the stdio of the child blocking. The flag is on the
+    // file description, which the parent shares.
+    if (fd <= 2) {
+      const int flags = fcntl(use_fd, F_GETFL);
+      if (flags != -1 && (flags & O_NONBLOCK) != 0)
+        fcntl(use_fd, F_SETFL, flags & ~O_NONBLOCK);
+    }
+  }
+
+  for (int fd : moved) {
+    err = posix_spawn_file_actions_addclose(actions, fd);
+    if (err != 0) return err;
+  }
+  return 0;
+}
+
+int SetSpawnAttributes(posix_spawnattr_t* attr, unsigned int flags) {
+  // Like uv_spawn(), reset the signals below 32 to their default action, and
+  // leave the real-time signals that libc uses internally alone.
+  sigset_t defaults;
+  sigemptyset(&defaults);
+  for (int signal = 1; signal < 32; signal++) {
+    if (signal != SIGKILL && signal != SIGSTOP) sigaddset(&defaults, signal);
+  }
+  sigset_t mask;
+  sigemptyset(&mask);
+  short spawn_flags =  // NOLINT(runtime/int)
+      POSIX_SPAWN_SETSIGDEF | POSIX_SPAWN_SETSIGMASK;
+#ifdef POSIX_SPAWN_SETSID
+  if (flags & UV_PROCESS_DETACHED) spawn_flags |= POSIX_SPAWN_SETSID;
+#endif
+  int err = posix_spawnattr_setsigdefault(attr, &defaults);
+  if (err == 0) err = posix_spawnattr_setsigmask(attr, &mask);
+  if (err == 0) err = posix_spawnattr_setflags(attr, spawn_flags);
+  return err;
+}
+
+void ClosePipes(const std::vector<int>& parent_fds,
+                const std::vector<int>& pipe_fds) {
+  for (size_t i = 0; i < parent_fds.size(); i++) {
+    if (parent_fds[i] != -1) close(parent_fds[i]);
+    if (pipe_fds[i] != -1) close(pipe_fds[i]);
+  }
+}
+
+void KillAndReap(pid_t pid) {
+  kill(pid, SIGKILL);
+  while (waitpid(pid, nullptr, 0) == -1 && errno == EINTR) {
+  }
+}
+
+}  // anonymous namespace
+
+bool ProcessHandle::SpawnWithPosixSpawn(uv_loop_t* loop,
+                                        const uv_process_options_t* options,
+                                        int* err) {
+  if ((options->flags & (UV_PROCESS_SETUID | UV_PROCESS_SETGID)) != 0 ||
+      options->args == nullptr || !HavePidfds()) {
+    return false;
+  }
+  if (options->cwd != nullptr && GetAddChdir() == nullptr) return false;
+#ifndef POSIX_SPAWN_SETSID
+  if (options->flags & UV_PROCESS_DETACHED) return false;
+#endif
+
+  char** env = options->env != nullptr ? options->env : environ;
+  const std::string file = FindExecutable(options->file, env, options->cwd);
+  if (file.empty()) return false;
+
+  const int stdio_count = std::max(options->stdio_count, 3);
+  // The fd that becomes each fd of the child, and for pipes, the end that
+  // stays in the parent and the one that goes to the child.
+  std::vector<int> child_fds(stdio_count, -1);
+  std::vector<int> parent_fds(stdio_count, -1);
+  std::vector<int> pipe_fds(stdio_count, -1);
+  for (int i = 0; i < options->stdio_count; i++) {
+    const uv_stdio_container_t& stdio = options->stdio[i];
+    switch (stdio.flags & (UV_IGNORE | UV_CREATE_PIPE | UV_INHERIT_FD |
+                           UV_INHERIT_STREAM)) {
+      case UV_IGNORE:
+        break;
+      case UV_CREATE_PIPE: {
+        uv_os_sock_t fds[2];
+        if (stdio.data.stream->type != UV_NAMED_PIPE ||
+            uv_socketpair(SOCK_STREAM, 0, fds, 0, 0) != 0) {
+          ClosePipes(parent_fds, pipe_fds);
+          return false;
+        }
+        // The buffer sizes of the socketpair() in uv_spawn().
+        for (int fd : fds) {
+          const int size = 64 * 1024;
+          setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+          setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &size, sizeof(size));
+        }
+        parent_fds[i] = fds[0];
+        pipe_fds[i] = child_fds[i] = fds[1];
+        break;
+      }
+      case UV_INHERIT_FD:
+        child_fds[i] = stdio.data.fd;
+        break;
+      case UV_INHERIT_STREAM: {
+        uv_os_fd_t fd;
+        if (uv_fileno(reinterpret_cast<uv_handle_t*>(stdio.data.stream),
+                      &fd) != 0) {
+          ClosePipes(parent_fds, pipe_fds);
+          return false;
+        }
+        child_fds[i] = fd;
+        break;
+      }
+      default:
+        ClosePipes(parent_fds, pipe_fds);
+        return false;
+    }
+  }
+
+  // Keep an fd free for the pidfd, so that running out of fds is found
+  // before the child runs, and uv_spawn() reports it.
+  const int reserved_fd = open("/dev/null", O_RDONLY | O_CLOEXEC);
+  if (reserved_fd == -1) {
+    ClosePipes(parent_fds, pipe_fds);
+    return false;
+  }
+
+  posix_spawn_file_actions_t actions;
+  posix_spawnattr_t attr;
+  int r = posix_spawn_file_actions_init(&actions);
+  if (r == 0) {
+    r = posix_spawnattr_init(&attr);
+    if (r != 0) posix_spawn_file_actions_destroy(&actions);
+  }
+  pid_t pid = 0;
+  if (r == 0) {
+    r = AddStdioActions(&actions, child_fds);
+    if (r == 0) r = SetSpawnAttributes(&attr, options->flags);
+    if (r == 0 && options->cwd != nullptr)
+      r = GetAddChdir()(&actions, options->cwd);
+    if (r == 0) {
+      r = posix_spawn(
+          &pid, file.c_str(), &actions, &attr, options->args, env);
+    }
+    posix_spawnattr_destroy(&attr);
+    posix_spawn_file_actions_destroy(&actions);
+  }
+  close(reserved_fd);
+  if (r != 0) {
+    ClosePipes(parent_fds, pipe_fds);
+    return false;
+  }
+
+  const int pidfd = PidfdOpen(pid);
+  if (pidfd == -1) {
+    // Only if another thread took the fd that was kept free. Without a
+    // pidfd, the exit of the child cannot be watched.
+    KillAndReap(pid);
+    ClosePipes(parent_fds, pipe_fds);
+    return false;
+  }
+
+  CHECK_EQ(uv_poll_init(loop, &poll_, pidfd), 0);
+  CHECK_EQ(uv_poll_start(&poll_, UV_READABLE, OnPidfdReadable), 0);
+  pid_ = pid;
+  pidfd_ = pidfd;
+  posix_spawn_ = true;
+
+  *err = 0;
+  for (int i = 0; i < options->stdio_count; i++) {
+    if (pipe_fds[i] == -1) continue;
+    close(pipe_fds[i]);
+    if (*err == 0) {
+      *err = uv_pipe_open(
+          reinterpret_cast<uv_pipe_t*>(options->stdio[i].data.stream),
+          parent_fds[i]);
+      if (*err == 0) continue;
+    }
+    close(parent_fds[i]);
+  }
+  return true;
+}
+
+void ProcessHandle::OnPidfdReadable(uv_poll_t* handle,
+                                    int status,
+                                    int events) {
+  ProcessHandle* process = ContainerOf(&ProcessHandle::poll_, handle);
+  int wstatus;
+  pid_t pid;
+  do {
+    pid = waitpid(process->pid_, &wstatus, WNOHANG);
+  } while (pid == -1 && errno == EINTR);
+  if (pid == 0) return;
+
+  uv_poll_stop(handle);
+  process->exited_ = true;
+  // Like uv_spawn(), say nothing if someone else has reaped the child.
+  if (pid == -1) return;
+  const int64_t exit_status = WIFEXITED(wstatus) ? WEXITSTATUS(wstatus) : 0;
+  const int term_signal = WIFSIGNALED(wstatus) ? WTERMSIG(wstatus) : 0;
+  process->exit_cb_(process, exit_status, term_signal);
+}
+#endif  // __linux__
+
+int ProcessHandle::Spawn(uv_loop_t* loop,
+                         const uv_process_options_t* options,
+                         ExitCallback exit_cb) {
+  exit_cb_ = exit_cb;
+  pid_ = 0;
+  posix_spawn_ = false;
+  exited_ = false;
+#ifdef __linux__
+  int err;
+  if (SpawnWithPosixSpawn(loop, options, &err)) return err;
+#endif
+  uv_process_options_t uv_options = *options;
+  uv_options.exit_cb = OnProcessExit;
+  const int r = uv_spawn(loop, &process_, &uv_options);
+  if (r == 0) pid_ = process_.pid;
+  return r;
+}
+
+int ProcessHandle::Kill(int signal) {
+#ifdef __linux__
+  if (posix_spawn_) {
+    if (exited_ || pidfd_ == -1) return UV_ESRCH;
+    if (syscall(__NR_pidfd_send_signal, pidfd_, signal, nullptr, 0) == 0)
+      return 0;
+    return -errno;
+  }
+#endif
+  return uv_process_kill(&process_, signal);
+}
+
+void ProcessHandle::Close(uv_close_cb close_cb) {
+  uv_close(&handle_, close_cb);
+  OnClose();
+}
+
+void ProcessHandle::OnClose() {
+#ifdef __linux__
+  // uv_close() has stopped watching the pidfd.
+  if (pidfd_ != -1) {
+    close(pidfd_);
+    pidfd_ = -1;
+  }
+#endif
+}
+
+void ProcessHandle::OnProcessExit(uv_process_t* handle,
+                                  int64_t exit_status,
+                                  int term_signal) {
+  ProcessHandle* process = ContainerOf(&ProcessHandle::process_, handle);
+  process->exit_cb_(process, exit_status, term_signal);
+}
+
+}  // namespace node
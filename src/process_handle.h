@@ -0,0 +1,82 @@
+#ifndef SRC_PROCESS_HANDLE_H_
+#define SRC_PROCESS_HANDLE_H_
+
+#if defined(NODE_WANT_INTERNALS) && NODE_WANT_INTERNALS
+
+#include <cstdint>
+
+#include "uv.h"
+
+namespace node {
+
+// A child process, started either with uv_spawn() or, on Linux, with
+// posix_spawn(). glibc and musl implement posix_spawn() with
+// clone(CLONE_VM | CLONE_VFORK), so unlike the fork() in uv_spawn() it does
+// not copy the page tables of the parent, which takes milliseconds in a
+// process with a large resident set. The exit of such a child is watched
+// through a pidfd.
+//
+// Spawns that posix_spawn() cannot do the way uv_spawn() does, such as those
+// that change the uid or gid, and kernels without pidfds, go through
+// uv_spawn(). So does any spawn for which posix_spawn() fails, so that the
+// error, and the state of the stdio streams, are the ones of uv_spawn().
+class ProcessHandle {
+ public:
+  using ExitCallback = void (*)(ProcessHandle* process,
+                                int64_t exit_status,
+                                int term_signal);
+
+  ProcessHandle() = default;
+  ProcessHandle(const ProcessHandle&) = delete;
+  ProcessHandle& operator=(const ProcessHandle&) = delete;
+
+  // Like uv_spawn(), but calls |exit_cb| instead of options->exit_cb.
+  int Spawn(uv_loop_t* loop,
+            const uv_process_options_t* options,
+            ExitCallback exit_cb);
+  // Like uv_process_kill().
+  int Kill(int signal);
+
+  // Closes the handle like uv_close().
+  void Close(uv_close_cb close_cb);
+  // Owners that close handle() with uv_close() themselves, e.g. through
+  // HandleWrap, must call this once they have.
+  void OnClose();
+
+  // A uv_process_t, or a uv_poll_t for the pidfd. uv_close(), uv_ref() and
+  // friends work on either, and its data is free for the owner to use. The
+  // handle is at the start of the object.
+  uv_handle_t* handle() { return &handle_; }
+  const uv_handle_t* handle() const { return &handle_; }
+  int pid() const { return pid_; }
+  bool uses_posix_spawn() const { return posix_spawn_; }
+
+ private:
+#ifdef __linux__
+  // Returns false if the spawn has to go through uv_spawn() instead.
+  bool SpawnWithPosixSpawn(uv_loop_t* loop,
+                           const uv_process_options_t* options,
+                           int* err);
+  static void OnPidfdReadable(uv_poll_t* handle, int status, int events);
+#endif
+  static void OnProcessExit(uv_process_t* handle,
+                            int64_t exit_status,
+                            int term_signal);
+
+  union {
+    uv_handle_t handle_{};
+    uv_process_t process_;
+    uv_poll_t poll_;
+  };
+  ExitCallback exit_cb_ = nullptr;
+  int pid_ = 0;
+  int pidfd_ = -1;
+  bool posix_spawn_ = false;
+  bool exited_ = false;
+};
+
+}  // namespace node
+
+#endif  // defined(NODE_WANT_INTERNALS) && NODE_WANT_INTERNALS
+
+#endif  // SRC_PROCESS_HANDLE_H_
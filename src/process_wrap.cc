@@ -23,6 +23,7 @@
 #include "node_errors.h"
 #include "node_external_reference.h"
 #include "permission/permission.h"
+#include "process_handle.h"
 #include "stream_base-inl.h"
 #include "stream_wrap.h"
 #include "util-inl.h"
@@ -96,7 +97,7 @@ class ProcessWrap : public HandleWrap {
   ProcessWrap(Environment* env, Local<Object> object)
       : HandleWrap(env,
                    object,
-                   reinterpret_cast<uv_handle_t*>(&process_),
+                   process_.handle(),
                    AsyncWrap::PROVIDER_PROCESSWRAP) {
     MarkAsUninitialized();
   }
@@ -199,7 +200,6 @@ class ProcessWrap : public HandleWrap {
     uv_process_options_t options;
     memset(&options, 0, sizeof(uv_process_options_t));
 
-    options.exit_cb = OnExit;
 
     // options.uid
     Local<Value> uid_v;
@@ -345,16 +345,16 @@ class ProcessWrap : public HandleWrap {
     }
 
     if (err == 0) {
-      err = uv_spawn(env->event_loop(), &wrap->process_, &options);
+      err = wrap->process_.Spawn(env->event_loop(), &options, OnExit);
       wrap->MarkAsInitialized();
     }
 
     if (err == 0) {
-      CHECK_EQ(wrap->process_.data, wrap);
+      CHECK_EQ(wrap->process_.handle()->data, wrap);
       if (wrap->object()
               ->Set(context,
                     env->pid_string(),
-                    Integer::New(env->isolate(), wrap->process_.pid))
+                    Integer::New(env->isolate(), wrap->process_.pid()))
               .IsNothing()) {
         return;
       }
@@ -389,15 +389,17 @@ class ProcessWrap : public HandleWrap {
       signal = SIGKILL;
     }
 #endif
-    int err = uv_process_kill(&wrap->process_, signal);
+    int err = wrap->process_.Kill(signal);
     args.GetReturnValue().Set(err);
   }
 
-  static void OnExit(uv_process_t* handle,
+  void OnClose() override { process_.OnClose(); }
+
+  static void OnExit(ProcessHandle* process,
                      int64_t exit_status,
                      int term_signal) {
-    ProcessWrap* wrap = ContainerOf(&ProcessWrap::process_, handle);
-    CHECK_EQ(&wrap->process_, handle);
+    ProcessWrap* wrap = ContainerOf(&ProcessWrap::process_, process);
+    CHECK_EQ(&wrap->process_, process);
 
     Environment* env = wrap->env();
     HandleScope handle_scope(env->isolate());
@@ -411,7 +413,7 @@ class ProcessWrap : public HandleWrap {
     wrap->MakeCallback(env->onexit_string(), arraysize(argv), argv);
   }
 
-  uv_process_t process_;
+  ProcessHandle process_;
 };
 
 
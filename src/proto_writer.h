@@ -0,0 +1,83 @@
+#ifndef SRC_PROTO_WRITER_H_
+#define SRC_PROTO_WRITER_H_
+
+#if defined(NODE_WANT_INTERNALS) && NODE_WANT_INTERNALS
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+namespace node {
+
+// Appends protobuf encoded fields to a string. This covers only what the
+// hand-written serializers (Perfetto traces, pprof profiles) need, nested
+// messages are encoded separately and then appended with Message().
+class ProtoWriter {
+ public:
+  void Varint(uint32_t field, uint64_t value) {
+    Tag(field, kVarint);
+    RawVarint(value);
+  }
+
+  void Int(uint32_t field, int64_t value) {
+    Varint(field, static_cast<uint64_t>(value));
+  }
+
+  void Double(uint32_t field, double value) {
+    Tag(field, kFixed64);
+    char bytes[sizeof(value)];
+    memcpy(bytes, &value, sizeof(value));
+    data_.append(bytes, sizeof(bytes));
+  }
+
+  void Bytes(uint32_t field, std::string_view value) {
+    Tag(field, kLengthDelimited);
+    RawVarint(value.size());
+    data_.append(value);
+  }
+
+  void Message(uint32_t field, const ProtoWriter& message) {
+    Bytes(field, message.data_);
+  }
+
+  // Writes a packed repeated field of varints.
+  template <typename Container>
+  void PackedVarints(uint32_t field, const Container& values) {
+    if (values.empty()) return;
+    ProtoWriter packed;
+    for (auto value : values) packed.RawVarint(static_cast<uint64_t>(value));
+    Bytes(field, packed.data_);
+  }
+
+  bool empty() const { return data_.empty(); }
+  const std::string& data() const { return data_; }
+  void clear() { data_.clear(); }
+
+ private:
+  enum WireType : uint32_t {
+    kVarint = 0,
+    kFixed64 = 1,
+    kLengthDelimited = 2,
+  };
+
+  void Tag(uint32_t field, WireType wire_type) {
+    RawVarint((static_cast<uint64_t>(field) << 3) | wire_type);
+  }
+
+  void RawVarint(uint64_t value) {
+    while (value >= 0x80) {
+      data_.push_back(static_cast<char>((value & 0x7f) | 0x80));
+      value >>= 7;
+    }
+    data_.push_back(static_cast<char>(value));
+  }
+
+  std::string data_;
+};
+
+}  // namespace node
+
+#endif  // defined(NODE_WANT_INTERNALS) && NODE_WANT_INTERNALS
+
+#endif  // SRC_PROTO_WRITER_H_
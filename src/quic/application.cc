@@ -236,6 +236,12 @@ void Session::Application::SendPendingData() {
   PathStorage path;
   StreamData stream_data;
 
+  // The packets prepared below are held by the endpoint and written out
+  // together, in as few syscalls as possible, once we are done.
+  BaseObjectPtr<Endpoint> endpoint(&session_->endpoint());
+  endpoint->Cork();
+  auto uncork = OnScopeLeave([&] { endpoint->Uncork(); });
+
   auto update_stats = OnScopeLeave([&] {
     auto& s = session();
     if (!s.is_destroyed()) [[likely]] {
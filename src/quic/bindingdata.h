@@ -116,7 +116,9 @@ class Packet;
   V(reno, "reno")                                                              \
   V(retry_token_expiration, "retryTokenExpiration")                            \
   V(reset_token_secret, "resetTokenSecret")                                    \
+  V(reuse_port, "reusePort")                                                   \
   V(rx_loss, "rxDiagnosticLoss")                                               \
+  V(server_id, "serverId")                                                     \
   V(servername, "servername")                                                  \
   V(session, "Session")                                                        \
   V(stream, "Stream")                                                          \
@@ -83,12 +83,27 @@ CID CID::kInvalid{};
 // CID::Hash
 
 size_t CID::Hash::operator()(const CID& cid) const {
-  size_t hash = 0;
-  for (size_t n = 0; n < cid.length(); n++) {
-    hash ^= std::hash<uint8_t>{}(cid.ptr_->data[n] + 0x9e3779b9 + (hash << 6) +
-                                 (hash >> 2));
+  // Peers pick some of the CIDs that end up in CID::Map, so the hash is
+  // seeded to keep them from choosing CIDs that collide. CID::Map also
+  // relies on all of the bits of the hash being mixed, as it uses the low
+  // bits and the high bits separately.
+  static const uint64_t seed = [] {
+    uint64_t seed;
+    CHECK(ncrypto::CSPRNG(&seed, sizeof(seed)));
+    return seed;
+  }();
+  constexpr uint64_t kMultiplier = 0x9fb21c651e98df25;
+  const uint8_t* data = cid.ptr_->data;
+  size_t length = cid.length();
+  uint64_t hash = seed ^ (length * kMultiplier);
+  for (size_t n = 0; n < length; n += sizeof(uint64_t)) {
+    uint64_t word = 0;
+    memcpy(&word, data + n, std::min(sizeof(word), length - n));
+    hash = (hash ^ word) * kMultiplier;
+    hash ^= hash >> 32;
   }
-  return hash;
+  hash *= kMultiplier;
+  return static_cast<size_t>(hash ^ (hash >> 29));
 }
 
 // ============================================================================
@@ -147,5 +162,34 @@ const CID::Factory& CID::Factory::random() {
   return instance;
 }
 
+namespace {
+class ServerIdCIDFactory final : public CID::Factory {
+ public:
+  explicit ServerIdCIDFactory(uint8_t server_id) : server_id_(server_id) {}
+  DISALLOW_COPY_AND_MOVE(ServerIdCIDFactory)
+
+  CID Generate(size_t length_hint) const override {
+    ngtcp2_cid cid;
+    GenerateInto(&cid, length_hint);
+    return CID(cid);
+  }
+
+  CID GenerateInto(ngtcp2_cid* cid,
+                   size_t length_hint = CID::kMaxLength) const override {
+    length_hint = std::max(length_hint, kServerIdOffset + 1);
+    random().GenerateInto(cid, length_hint);
+    cid->data[kServerIdOffset] = server_id_;
+    return CID(cid);
+  }
+
+ private:
+  uint8_t server_id_;
+};
+}  // namespace
+
+std::unique_ptr<CID::Factory> CID::Factory::WithServerId(uint8_t server_id) {
+  return std::make_unique<ServerIdCIDFactory>(server_id);
+}
+
 }  // namespace node::quic
 #endif  // HAVE_OPENSSL && NODE_OPENSSL_HAS_QUIC
@@ -4,9 +4,20 @@
 #if HAVE_OPENSSL && NODE_OPENSSL_HAS_QUIC
 #include <memory_tracker.h>
 #include <ngtcp2/ngtcp2.h>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <memory>
 #include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
 #include "defs.h"
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 namespace node::quic {
 
 // CIDS are used to identify endpoints participating in a QUIC session.
@@ -74,8 +85,11 @@ class CID final : public MemoryRetainer {
   SET_MEMORY_INFO_NAME(CID)
   SET_SELF_SIZE(CID)
 
+  // A hash table keyed by CID. The Endpoint looks up the session for every
+  // packet it receives, so this is a flat, open-addressing table rather than
+  // a node-based one. See the definition below.
   template <typename T>
-  using Map = std::unordered_map<CID, T, CID::Hash>;
+  class Map;
 
   // A CID::Factory, as the name suggests, is used to create new CIDs.
   // Per https://datatracker.ietf.org/doc/draft-ietf-quic-load-balancers/, QUIC
@@ -117,10 +131,387 @@ class CID::Factory {
   // The default random CID generator instance.
   static const Factory& random();
 
+  // Returns a generator of CIDs that carry the given server id at
+  // kServerIdOffset and are random otherwise, so that the packets of a
+  // session can be routed to the server that owns it by their dcid alone.
+  // The first byte is left random, as the QUIC Load Balancers spec keeps it
+  // for its config rotation bits.
+  static constexpr size_t kServerIdOffset = 1;
+  static std::unique_ptr<Factory> WithServerId(uint8_t server_id);
+
   // TODO(@jasnell): This will soon also include additional implementations
   // of CID::Factory that implement the QUIC Load Balancers spec.
 };
 
+// The layout of the table follows the "Swiss table" design: next to the
+// slots there is an array of control bytes, one per slot, telling whether
+// the slot is empty, deleted, or holding an entry, in which case the byte
+// has the low 7 bits of the hash of its key. Lookups compare the control
+// bytes of a group of 16 slots at a time, with SSE2 where available, and
+// only touch the slots whose control byte matches. The first kGroupWidth
+// control bytes are mirrored past the end so that groups can be loaded
+// from any position without wrapping around.
+//
+// As with std::unordered_map, inserting may invalidate iterators, while
+// erasing only invalidates the iterators to the erased entry.
+template <typename T>
+class CID::Map final {
+ public:
+  using key_type = CID;
+  using mapped_type = T;
+  using value_type = std::pair<const CID, T>;
+
+  template <bool kConst>
+  class Iterator final {
+   public:
+    using Value = std::conditional_t<kConst, const value_type, value_type>;
+
+    Iterator() = default;
+    // Allows converting an iterator to a const_iterator.
+    Iterator(const Iterator<false>& other)  // NOLINT(runtime/explicit)
+        : ctrl_(other.ctrl_), end_(other.end_), slot_(other.slot_) {}
+
+    Value& operator*() const { return *slot_; }
+    Value* operator->() const { return slot_; }
+
+    Iterator& operator++() {
+      ++ctrl_;
+      ++slot_;
+      SkipFree();
+      return *this;
+    }
+
+    bool operator==(const Iterator& other) const {
+      return slot_ == other.slot_;
+    }
+    bool operator!=(const Iterator& other) const { return !(*this == other); }
+
+   private:
+    Iterator(const int8_t* ctrl, const int8_t* end, Value* slot)
+        : ctrl_(ctrl), end_(end), slot_(slot) {
+      SkipFree();
+    }
+
+    void SkipFree() {
+      while (ctrl_ != end_ && *ctrl_ < 0) {
+        ++ctrl_;
+        ++slot_;
+      }
+    }
+
+    const int8_t* ctrl_ = nullptr;
+    const int8_t* end_ = nullptr;
+    Value* slot_ = nullptr;
+
+    friend class Map;
+    friend class Iterator<!kConst>;
+  };
+
+  using iterator = Iterator<false>;
+  using const_iterator = Iterator<true>;
+
+  Map() = default;
+  ~Map() { Destroy(); }
+
+  Map(const Map& other) {
+    if (other.size_ == 0) return;
+    Allocate(other.capacity_);
+    for (const value_type& entry : other) {
+      size_t hash = Hash()(entry.first);
+      Construct(FindFreeSlot(hash), hash, entry.first, entry.second);
+      growth_left_--;
+    }
+  }
+
+  Map& operator=(const Map& other) {
+    if (this != &other) {
+      Map copy(other);
+      Swap(copy);
+    }
+    return *this;
+  }
+
+  Map(Map&& other) noexcept { Swap(other); }
+
+  Map& operator=(Map&& other) noexcept {
+    if (this != &other) {
+      Map empty;
+      Swap(other);
+      other.Swap(empty);
+    }
+    return *this;
+  }
+
+  iterator begin() { return iterator(ctrl_, ctrl_ + capacity_, slots_); }
+  iterator end() {
+    return iterator(ctrl_ + capacity_, ctrl_ + capacity_, slots_ + capacity_);
+  }
+  const_iterator begin() const {
+    return const_iterator(ctrl_, ctrl_ + capacity_, slots_);
+  }
+  const_iterator end() const {
+    return const_iterator(
+        ctrl_ + capacity_, ctrl_ + capacity_, slots_ + capacity_);
+  }
+
+  bool empty() const { return size_ == 0; }
+  size_t size() const { return size_; }
+
+  iterator find(const CID& key) {
+    size_t index = Find(key, Hash()(key));
+    if (index == kNotFound) return end();
+    return iterator(ctrl_ + index, ctrl_ + capacity_, slots_ + index);
+  }
+
+  const_iterator find(const CID& key) const {
+    return const_cast<Map*>(this)->find(key);
+  }
+
+  // Inserts an entry for the key unless there is one already. Returns the
+  // entry for the key, and whether it was inserted.
+  template <typename... Args>
+  std::pair<iterator, bool> emplace(const CID& key, Args&&... args) {
+    size_t hash = Hash()(key);
+    size_t index = Find(key, hash);
+    bool inserted = index == kNotFound;
+    if (inserted) {
+      index = PrepareInsert(hash);
+      Construct(index, hash, key, std::forward<Args>(args)...);
+    }
+    return {iterator(ctrl_ + index, ctrl_ + capacity_, slots_ + index),
+            inserted};
+  }
+
+  T& operator[](const CID& key) { return emplace(key).first->second; }
+
+  size_t erase(const CID& key) {
+    size_t index = Find(key, Hash()(key));
+    if (index == kNotFound) return 0;
+    // Destroying the value may end up using the table again, so that only
+    // happens once the table is consistent.
+    value_type entry(std::move(slots_[index]));
+    slots_[index].~value_type();
+    size_--;
+    // The slot can only be marked empty again if no probe sequence can have
+    // gone past it, that is, if no group of kGroupWidth slots covering it is
+    // completely full. Otherwise lookups that hit it have to keep going.
+    size_t before = (index - kGroupWidth) & (capacity_ - 1);
+    int empty_before = Group(ctrl_ + before).MatchEmpty();
+    int empty_after = Group(ctrl_ + index).MatchEmpty();
+    bool no_full_group = empty_before != 0 && empty_after != 0 &&
+                         CountLeadingZeros(empty_before) +
+                                 CountTrailingZeros(empty_after) <
+                             kGroupWidth;
+    if (no_full_group) {
+      SetCtrl(index, kEmpty);
+      growth_left_++;
+    } else {
+      SetCtrl(index, kDeleted);
+    }
+    return 1;
+  }
+
+  void clear() {
+    Map old;
+    Swap(old);
+  }
+
+ private:
+  static constexpr int kGroupWidth = 16;
+  static constexpr int8_t kEmpty = -128;
+  static constexpr int8_t kDeleted = -2;
+  static constexpr size_t kNotFound = SIZE_MAX;
+
+  // The control bytes of kGroupWidth consecutive slots, as bit masks with
+  // one bit per slot.
+  class Group final {
+   public:
+    explicit Group(const int8_t* ctrl) {
+#if defined(__SSE2__)
+      ctrl_ = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ctrl));
+#else
+      memcpy(ctrl_, ctrl, kGroupWidth);
+#endif
+    }
+
+    int Match(int8_t h2) const { return MatchByte(h2); }
+    int MatchEmpty() const { return MatchByte(kEmpty); }
+    // Both empty and deleted slots have the sign bit set.
+    int MatchFree() const {
+#if defined(__SSE2__)
+      return _mm_movemask_epi8(ctrl_);
+#else
+      int mask = 0;
+      for (int n = 0; n < kGroupWidth; n++) mask |= (ctrl_[n] < 0) << n;
+      return mask;
+#endif
+    }
+
+   private:
+    int MatchByte(int8_t byte) const {
+#if defined(__SSE2__)
+      return _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(byte), ctrl_));
+#else
+      int mask = 0;
+      for (int n = 0; n < kGroupWidth; n++) mask |= (ctrl_[n] == byte) << n;
+      return mask;
+#endif
+    }
+
+#if defined(__SSE2__)
+    __m128i ctrl_;
+#else
+    int8_t ctrl_[kGroupWidth];
+#endif
+  };
+
+  static int CountTrailingZeros(int mask) { return __builtin_ctz(mask); }
+  static int CountLeadingZeros(int mask) {
+    return __builtin_clz(static_cast<unsigned>(mask) << kGroupWidth);
+  }
+
+  // The high bits of the hash select where the probing starts, the low 7
+  // bits are kept in the control byte.
+  static size_t H1(size_t hash) { return hash >> 7; }
+  static int8_t H2(size_t hash) { return hash & 0x7f; }
+
+  // Up to 7/8 of the slots are used before the table grows.
+  static size_t MaxSize(size_t capacity) { return capacity - capacity / 8; }
+
+  // Probes groups of slots in triangular order, which visits every group
+  // once when the number of groups is a power of two.
+  class ProbeSequence final {
+   public:
+    ProbeSequence(size_t hash, size_t mask)
+        : offset_(H1(hash) & mask), mask_(mask) {}
+    size_t offset() const { return offset_; }
+    size_t offset(int n) const { return (offset_ + n) & mask_; }
+    void Next() {
+      step_ += kGroupWidth;
+      offset_ = (offset_ + step_) & mask_;
+    }
+
+   private:
+    size_t offset_;
+    size_t step_ = 0;
+    size_t mask_;
+  };
+
+  size_t Find(const CID& key, size_t hash) const {
+    if (capacity_ == 0) return kNotFound;
+    ProbeSequence seq(hash, capacity_ - 1);
+    for (;;) {
+      Group group(ctrl_ + seq.offset());
+      for (int mask = group.Match(H2(hash)); mask != 0; mask &= mask - 1) {
+        size_t index = seq.offset(CountTrailingZeros(mask));
+        if (slots_[index].first == key) [[likely]]
+          return index;
+      }
+      if (group.MatchEmpty() != 0) [[likely]]
+        return kNotFound;
+      seq.Next();
+    }
+  }
+
+  // Returns the first empty or deleted slot on the probe sequence.
+  size_t FindFreeSlot(size_t hash) const {
+    ProbeSequence seq(hash, capacity_ - 1);
+    for (;;) {
+      int mask = Group(ctrl_ + seq.offset()).MatchFree();
+      if (mask != 0) return seq.offset(CountTrailingZeros(mask));
+      seq.Next();
+    }
+  }
+
+  size_t PrepareInsert(size_t hash) {
+    size_t index = capacity_ != 0 ? FindFreeSlot(hash) : 0;
+    // Reusing a deleted slot does not bring the table closer to being full.
+    if (growth_left_ == 0 && (capacity_ == 0 || ctrl_[index] != kDeleted)) {
+      Rehash();
+      index = FindFreeSlot(hash);
+    }
+    if (ctrl_[index] == kEmpty) growth_left_--;
+    return index;
+  }
+
+  template <typename... Args>
+  void Construct(size_t index, size_t hash, const CID& key, Args&&... args) {
+    new (slots_ + index)
+        value_type(std::piecewise_construct,
+                   std::forward_as_tuple(key),
+                   std::forward_as_tuple(std::forward<Args>(args)...));
+    SetCtrl(index, H2(hash));
+    size_++;
+  }
+
+  void SetCtrl(size_t index, int8_t ctrl) {
+    ctrl_[index] = ctrl;
+    if (index < kGroupWidth) ctrl_[capacity_ + index] = ctrl;
+  }
+
+  // Grows the table, or only drops the deleted slots if those are what
+  // filled it up.
+  void Rehash() {
+    size_t capacity = kGroupWidth;
+    if (capacity_ != 0)
+      capacity = size_ <= MaxSize(capacity_) / 2 ? capacity_ : capacity_ * 2;
+    Map old;
+    Swap(old);
+    Allocate(capacity);
+    for (size_t index = 0; index < old.capacity_; index++) {
+      if (old.ctrl_[index] < 0) continue;
+      value_type& entry = old.slots_[index];
+      size_t hash = Hash()(entry.first);
+      size_t new_index = FindFreeSlot(hash);
+      // CID values can only be copied.
+      using Moved = std::conditional_t<std::is_move_constructible_v<T>,
+                                       T&&,
+                                       const T&>;
+      Construct(new_index, hash, entry.first, static_cast<Moved>(entry.second));
+      growth_left_--;
+    }
+  }
+
+  void Allocate(size_t capacity) {
+    DCHECK_EQ(capacity_, 0);
+    ctrl_ = new int8_t[capacity + kGroupWidth];
+    std::fill_n(ctrl_, capacity + kGroupWidth, kEmpty);
+    slots_ = std::allocator<value_type>().allocate(capacity);
+    capacity_ = capacity;
+    growth_left_ = MaxSize(capacity);
+  }
+
+  void Destroy() {
+    if (capacity_ == 0) return;
+    for (size_t index = 0; index < capacity_; index++) {
+      if (ctrl_[index] >= 0) slots_[index].~value_type();
+    }
+    std::allocator<value_type>().deallocate(slots_, capacity_);
+    delete[] ctrl_;
+    ctrl_ = nullptr;
+    slots_ = nullptr;
+    capacity_ = 0;
+    size_ = 0;
+    growth_left_ = 0;
+  }
+
+  void Swap(Map& other) noexcept {
+    std::swap(ctrl_, other.ctrl_);
+    std::swap(slots_, other.slots_);
+    std::swap(capacity_, other.capacity_);
+    std::swap(size_, other.size_);
+    std::swap(growth_left_, other.growth_left_);
+  }
+
+  int8_t* ctrl_ = nullptr;
+  value_type* slots_ = nullptr;
+  // Zero or a power of two that is at least kGroupWidth.
+  size_t capacity_ = 0;
+  size_t size_ = 0;
+  // The number of empty slots that can still be used before rehashing.
+  size_t growth_left_ = 0;
+};
+
 }  // namespace node::quic
 
 #endif  // HAVE_OPENSSL && NODE_OPENSSL_HAS_QUIC
@@ -228,6 +228,20 @@ constexpr uint64_t kMaxSafeJsInteger = 9007199254740991;
 constexpr auto kSocketAddressInfoTimeout = 60 * NGTCP2_SECONDS;
 constexpr size_t kMaxVectorCount = 16;
 
+// Upper bounds for ngtcp2's receive window autotuning. The windows start at
+// the initial_max_data/initial_max_stream_data transport parameters and
+// are doubled whenever the peer fills them within a few round trips.
+constexpr uint64_t kDefaultMaxWindow = 24 * 1024 * 1024;
+constexpr uint64_t kDefaultMaxStreamWindow = 16 * 1024 * 1024;
+
+// QPACK dynamic table defaults. A 4 KiB table in each direction is what
+// most HTTP/3 stacks advertise and is enough to hold the handful of
+// repeated header lines (authority, user-agent, cookies) that make up the
+// bulk of a request's header block.
+constexpr uint64_t kDefaultQpackMaxDTableCapacity = 4096;
+constexpr uint64_t kDefaultQpackEncoderMaxDTableCapacity = 4096;
+constexpr uint64_t kDefaultQpackBlockedStreams = 100;
+
 using error_code = uint64_t;
 
 class DebugIndentScope {
@@ -12,6 +12,7 @@
 #include <node_process-inl.h>
 #include <node_sockaddr-inl.h>
 #include <req_wrap-inl.h>
+#include <udp_wrap.h>
 #include <util-inl.h>
 #include <uv.h>
 #include <v8.h>
@@ -22,6 +23,11 @@
 #include "http3.h"
 #include "ncrypto.h"
 
+#if defined(__linux__)
+#include <linux/filter.h>
+#include <sys/socket.h>
+#endif
+
 namespace node {
 
 using v8::ArrayBufferView;
@@ -199,7 +205,8 @@ Maybe<Endpoint::Options> Endpoint::Options::From(Environment* env,
       !SET(rx_loss) || !SET(tx_loss) ||
 #endif
       !SET(udp_receive_buffer_size) || !SET(udp_send_buffer_size) ||
-      !SET(udp_ttl) || !SET(reset_token_secret) || !SET(token_secret)) {
+      !SET(udp_ttl) || !SET(reset_token_secret) || !SET(token_secret) ||
+      !SET(reuse_port) || !SET(server_id)) {
     return Nothing<Options>();
   }
 
@@ -270,6 +277,8 @@ std::string Endpoint::Options::ToString() const {
   res +=
       prefix + "udp send buffer size: " + std::to_string(udp_send_buffer_size);
   res += prefix + "udp ttl: " + std::to_string(udp_ttl);
+  res += prefix + "reuse port: " + boolToString(reuse_port);
+  if (reuse_port) res += prefix + "server id: " + std::to_string(server_id);
 
   res += indent.Close();
   return res;
@@ -318,7 +327,10 @@ class Endpoint::UDP::Impl final : public HandleWrap {
                    reinterpret_cast<uv_handle_t*>(&handle_),
                    PROVIDER_QUIC_UDP),
         endpoint_(endpoint) {
-    CHECK_EQ(uv_udp_init(endpoint->env()->event_loop(), &handle_), 0);
+    CHECK_EQ(uv_udp_init_ex(endpoint->env()->event_loop(),
+                            &handle_,
+                            AF_UNSPEC | UV_UDP_RECVMMSG),
+             0);
     handle_.data = this;
   }
 
@@ -327,10 +339,17 @@ class Endpoint::UDP::Impl final : public HandleWrap {
   SET_SELF_SIZE(Impl)
 
  private:
+  // Number of maximum-sized datagrams read with each recvmmsg() call.
+  static constexpr size_t kRecvMmsgDatagrams = 8;
+
   static void OnAlloc(uv_handle_t* handle,
                       size_t suggested_size,
                       uv_buf_t* buf) {
-    *buf = From(handle)->env()->allocate_managed_buffer(suggested_size);
+    auto impl = From(handle);
+    if (uv_udp_using_recvmmsg(&impl->handle_))
+      suggested_size *= kRecvMmsgDatagrams;
+    *buf = impl->env()->allocate_managed_buffer(suggested_size);
+    impl->recv_buf_ = *buf;
   }
 
   static void OnReceive(uv_udp_t* handle,
@@ -338,27 +357,68 @@ class Endpoint::UDP::Impl final : public HandleWrap {
                         const uv_buf_t* buf,
                         const sockaddr* addr,
                         unsigned int flags) {
-    // Nothing to do in these cases. Specifically, if the nread
-    // is zero or we've received a partial packet, we're just
-    // going to ignore it.
-    if (nread == 0 || flags & UV_UDP_PARTIAL) return;
-
     auto impl = From(handle);
     DCHECK_NOT_NULL(impl);
     DCHECK_NOT_NULL(impl->endpoint_);
+    Environment* env = impl->env();
+
+    // With recvmmsg(), each datagram arrives as a chunk of the buffer that
+    // was allocated in OnAlloc, and the whole buffer is handed back once
+    // every chunk has been delivered. The chunks share the buffer's backing
+    // store rather than being copied out.
+    if (flags & UV_UDP_MMSG_FREE) {
+      if (impl->recv_store_)
+        impl->recv_store_.reset();
+      else
+        env->release_managed_buffer(*buf);
+      return;
+    }
+
+    const bool is_chunk = flags & UV_UDP_MMSG_CHUNK;
+    if (is_chunk && !impl->recv_store_) {
+      impl->recv_store_ = env->release_managed_buffer(impl->recv_buf_);
+    }
+
+    // Nothing to do in these cases. Specifically, if the nread
+    // is zero or we've received a partial packet, we're just
+    // going to ignore it.
+    if (nread == 0 || flags & UV_UDP_PARTIAL) {
+      if (!is_chunk) env->release_managed_buffer(*buf);
+      return;
+    }
 
     if (nread < 0) {
+      env->release_managed_buffer(*buf);
       impl->endpoint_->Destroy(CloseContext::RECEIVE_FAILURE,
                                static_cast<int>(nread));
       return;
     }
 
-    impl->endpoint_->Receive(uv_buf_init(buf->base, static_cast<size_t>(nread)),
-                             SocketAddress(addr));
+    std::shared_ptr<BackingStore> backing;
+    size_t offset = 0;
+    if (is_chunk) {
+      backing = impl->recv_store_;
+      offset = buf->base - static_cast<char*>(backing->Data());
+    } else {
+      backing = env->release_managed_buffer(*buf);
+    }
+    if (!backing) [[unlikely]] {
+      // At this point something bad happened and we need to treat this as a
+      // fatal case. There's likely no way to test this specific condition
+      // reliably.
+      return impl->endpoint_->Destroy(CloseContext::RECEIVE_FAILURE,
+                                      UV_ENOMEM);
+    }
+
+    impl->endpoint_->Receive(
+        Store(std::move(backing), static_cast<size_t>(nread), offset),
+        SocketAddress(addr));
   }
 
   uv_udp_t handle_;
   Endpoint* endpoint_;
+  uv_buf_t recv_buf_ = uv_buf_init(nullptr, 0);
+  std::shared_ptr<BackingStore> recv_store_;
 
   friend class UDP;
 };
@@ -382,11 +442,16 @@ int Endpoint::UDP::Bind(const Options& options) {
   int flags = 0;
   if (options.local_address->family() == AF_INET6 && options.ipv6_only)
     flags |= UV_UDP_IPV6ONLY;
+  if (options.reuse_port) flags |= UV_UDP_REUSEPORT;
   int err = uv_udp_bind(&impl_->handle_, options.local_address->data(), flags);
   int size;
 
   if (!err) {
     is_bound_ = true;
+    if (options.reuse_port) {
+      err = AttachSteeringProgram();
+      if (err) return err;
+    }
     size = static_cast<int>(options.udp_receive_buffer_size);
     if (size > 0) {
       err = uv_recv_buffer_size(reinterpret_cast<uv_handle_t*>(&impl_->handle_),
@@ -411,6 +476,39 @@ int Endpoint::UDP::Bind(const Options& options) {
   return err;
 }
 
+int Endpoint::UDP::AttachSteeringProgram() {
+#if defined(__linux__) && defined(SO_ATTACH_REUSEPORT_CBPF)
+  // Packets with short headers go to the socket numbered by the server id
+  // in their dcid, which follows the first byte of the packet. For other
+  // packets, and for server ids that are out of range, the program returns
+  // a number past the end of the group and the kernel falls back to hashing
+  // the addresses.
+  constexpr uint32_t kLongHeaderBit = 0x80;
+  constexpr uint32_t kServerIdByte = 1 + CID::Factory::kServerIdOffset;
+  sock_filter code[] = {
+      BPF_STMT(BPF_LD | BPF_B | BPF_ABS, 0),
+      BPF_JUMP(BPF_JMP | BPF_JSET | BPF_K, kLongHeaderBit, 2, 0),
+      BPF_STMT(BPF_LD | BPF_B | BPF_ABS, kServerIdByte),
+      BPF_STMT(BPF_RET | BPF_A, 0),
+      BPF_STMT(BPF_RET | BPF_K, UINT32_MAX),
+  };
+  sock_fprog program = {arraysize(code), code};
+  uv_os_fd_t fd;
+  int err = uv_fileno(reinterpret_cast<uv_handle_t*>(&impl_->handle_), &fd);
+  if (err) return err;
+  // The program applies to the whole group, so attaching it again from
+  // each endpoint only replaces it with the same one.
+  if (setsockopt(fd,
+                 SOL_SOCKET,
+                 SO_ATTACH_REUSEPORT_CBPF,
+                 &program,
+                 sizeof(program)) != 0) {
+    return uv_translate_sys_error(errno);
+  }
+#endif
+  return 0;
+}
+
 void Endpoint::UDP::Ref() {
   if (!is_closed_or_closing()) {
     uv_ref(reinterpret_cast<uv_handle_t*>(&impl_->handle_));
@@ -441,6 +539,12 @@ void Endpoint::UDP::Close() {
   if (is_closed_or_closing()) return;
   DCHECK(impl_);
   Stop();
+  std::vector<BaseObjectPtr<Packet>> packets;
+  packets.swap(pending_);
+  for (const auto& packet : packets) {
+    packet->Dispatched();
+    packet->Done(UV_ECANCELED);
+  }
   is_bound_ = false;
   is_closed_ = true;
   impl_->Close();
@@ -473,6 +577,103 @@ int Endpoint::UDP::Send(const BaseObjectPtr<Packet>& packet) {
   DCHECK(packet);
   DCHECK(!packet->IsDispatched());
   if (is_closed_or_closing()) return UV_EBADF;
+  if (cork_count_ > 0) {
+    pending_.push_back(packet);
+    return 0;
+  }
+  return SendQueued(packet);
+}
+
+void Endpoint::UDP::Cork() {
+  cork_count_++;
+}
+
+int Endpoint::UDP::Uncork() {
+  DCHECK_GT(cork_count_, 0);
+  if (--cork_count_ > 0) return 0;
+  return Flush();
+}
+
+int Endpoint::UDP::Flush() {
+  // The packets are flushed in groups matching the largest batch the kernel
+  // will segment in one go.
+  static constexpr size_t kMaxBatch = 64;
+
+  std::vector<BaseObjectPtr<Packet>> packets;
+  packets.swap(pending_);
+
+  int err = 0;
+  size_t pos = 0;
+  while (pos < packets.size() && err == 0) {
+    if (is_closed_or_closing()) {
+      err = UV_EBADF;
+      break;
+    }
+
+    const unsigned int count =
+        static_cast<unsigned int>(std::min(kMaxBatch, packets.size() - pos));
+    uv_buf_t bufs[kMaxBatch];
+    uv_buf_t* buf_ptrs[kMaxBatch];
+    unsigned int nbufs[kMaxBatch];
+    sockaddr* addrs[kMaxBatch];
+    for (unsigned int i = 0; i < count; i++) {
+      const BaseObjectPtr<Packet>& packet = packets[pos + i];
+      bufs[i] = *packet;
+      buf_ptrs[i] = &bufs[i];
+      nbufs[i] = 1;
+      addrs[i] = const_cast<sockaddr*>(packet->destination().data());
+    }
+
+    int sent = UV_ENOTSUP;
+    if (count > 1 && !gso_unsupported_) {
+      sent = TrySendSegmented(&impl_->handle_, buf_ptrs, nbufs, addrs, count);
+      if (sent == UV_ENOSYS) gso_unsupported_ = true;
+    }
+    if (sent < 0 && sent != UV_EAGAIN) {
+      sent = uv_udp_try_send2(
+          &impl_->handle_, count, buf_ptrs, nbufs, addrs, 0);
+    }
+
+    if (sent == UV_EAGAIN || sent == UV_ENOSYS) {
+      // The socket is full or batching is unavailable: queue this group on
+      // the handle and let libuv finish it asynchronously.
+      sent = 0;
+    } else if (sent < 0) {
+      err = sent;
+      break;
+    }
+
+    // Packets written synchronously are complete right away. Whatever the
+    // socket did not take is queued on the handle, after which libuv keeps
+    // later groups behind it as well.
+    const size_t end = pos + count;
+    for (int i = 0; i < sent; i++, pos++) {
+      packets[pos]->Dispatched();
+      packets[pos]->Done(0);
+    }
+    for (; pos < end; pos++) {
+      if (is_closed_or_closing()) {
+        err = UV_EBADF;
+        break;
+      }
+      err = SendQueued(packets[pos]);
+      if (err != 0) {
+        // SendQueued() has already completed the failed packet.
+        pos++;
+        break;
+      }
+    }
+  }
+
+  // Anything left could not be handed to the socket.
+  for (; pos < packets.size(); pos++) {
+    packets[pos]->Dispatched();
+    packets[pos]->Done(err);
+  }
+  return err;
+}
+
+int Endpoint::UDP::SendQueued(const BaseObjectPtr<Packet>& packet) {
   uv_buf_t buf = *packet;
 
   // We don't use the default implementation of Dispatch because the packet
@@ -615,6 +816,9 @@ Endpoint::Endpoint(Environment* env,
       stats_(env->isolate()),
       state_(env->isolate()),
       options_(options),
+      cid_factory_(options.reuse_port
+                       ? CID::Factory::WithServerId(options.server_id)
+                       : nullptr),
       udp_(this),
       addrLRU_(options_.address_lru_size) {
   MakeWeak();
@@ -716,10 +920,13 @@ BaseObjectPtr<Session> Endpoint::FindSession(const CID& cid) {
 }
 
 void Endpoint::AssociateCID(const CID& cid, const CID& scid) {
-  if (!is_closed() && !is_closing() && cid && scid && cid != scid &&
-      dcid_to_scid_[cid] != scid) {
+  if (!is_closed() && !is_closing() && cid && scid && cid != scid) {
+    auto [it, inserted] = dcid_to_scid_.emplace(cid, scid);
+    if (!inserted) {
+      if (it->second == scid) return;
+      it->second = scid;
+    }
     Debug(this, "Associating CID %s with SCID %s", cid, scid);
-    dcid_to_scid_.emplace(cid, scid);
   }
 }
 
@@ -773,6 +980,18 @@ void Endpoint::Send(const BaseObjectPtr<Packet>& packet) {
   STAT_INCREMENT(Stats, packets_sent);
 }
 
+void Endpoint::Cork() {
+  udp_.Cork();
+}
+
+void Endpoint::Uncork() {
+  int err = udp_.Uncork();
+  if (err != 0) {
+    Debug(this, "Sending packets failed with error %d", err);
+    Destroy(CloseContext::SEND_FAILURE, err);
+  }
+}
+
 void Endpoint::SendRetry(const PathDescriptor& options) {
   // Generating and sending retry packets does consume some system resources,
   // and it is possible for a malicious peer to trigger sending a large number
@@ -932,6 +1151,7 @@ void Endpoint::Listen(const Session::Options& options) {
       options,
       std::move(context),
   };
+  if (cid_factory_) server_state_->options.cid_factory = cid_factory_.get();
   if (Start()) {
     Debug(this, "Listening with options %s", server_state_->options);
     state_->listening = 1;
@@ -945,7 +1165,10 @@ BaseObjectPtr<Session> Endpoint::Connect(
   // If starting fails, the endpoint will be destroyed.
   if (!Start()) return {};
 
-  Session::Config config(env(), options, local_address(), remote_address);
+  Session::Options session_options = options;
+  if (cid_factory_) session_options.cid_factory = cid_factory_.get();
+  Session::Config config(
+      env(), session_options, local_address(), remote_address);
 
   Debug(this,
         "Connecting to %s with options %s and config %s [has 0rtt ticket? %s]",
@@ -1059,8 +1282,7 @@ void Endpoint::CloseGracefully() {
   MaybeDestroy();
 }
 
-void Endpoint::Receive(const uv_buf_t& buf,
-                       const SocketAddress& remote_address) {
+void Endpoint::Receive(Store&& store, const SocketAddress& remote_address) {
   const auto receive = [&](Session* session,
                            Store&& store,
                            const SocketAddress& local_address,
@@ -1104,6 +1326,12 @@ void Endpoint::Receive(const uv_buf_t& buf,
     // early.
     if (session->is_destroyed()) [[unlikely]]
       return;
+    // The peer keeps sending its initial packets to the dcid it picked, or
+    // to the one from our retry, until our first packet reaches it. That
+    // only differs from our scid when the scid carries the server_id.
+    const CID& initial_dcid =
+        config.retry_scid ? config.retry_scid : config.ocid;
+    if (config.scid != initial_dcid) AssociateCID(initial_dcid, config.scid);
 
     receive(session.get(),
             std::move(store),
@@ -1188,24 +1416,28 @@ void Endpoint::Receive(const uv_buf_t& buf,
     // At this point, we start to set up the configuration for our local
     // session. We pass the received scid here as the dcid argument value
     // because that is the value *this* session will use as the outbound dcid.
-    Session::Config config(env(),
-                           Side::SERVER,
-                           server_state_->options,
-                           version,
-                           local_address,
-                           remote_address,
-                           scid,
-                           dcid,
-                           dcid);
+    //
+    // With reuse_port, the dcid picked by the peer does not carry our
+    // server_id, so we pick a new scid that does.
+    Session::Config config(
+        env(),
+        Side::SERVER,
+        server_state_->options,
+        version,
+        local_address,
+        remote_address,
+        scid,
+        cid_factory_ ? cid_factory_->Generate() : CID(dcid),
+        dcid);
 
     Debug(this, "Using session config %s", config);
 
     // The this point, the config.scid and config.dcid represent *our* views of
     // the CIDs. Specifically, config.dcid identifies the peer and config.scid
     // identifies us. config.dcid should equal scid, and config.scid should
-    // equal dcid.
+    // equal dcid unless it was picked to carry the server_id.
     DCHECK(config.dcid == scid);
-    DCHECK(config.scid == dcid);
+    DCHECK(cid_factory_ || config.scid == dcid);
 
     const auto is_remote_address_validated = ([&] {
       auto info = addrLRU_.Peek(remote_address);
@@ -1471,20 +1703,15 @@ void Endpoint::Receive(const uv_buf_t& buf,
   //   return;
   // }
 
-  Debug(this, "Received %zu-byte packet from %s", buf.len, remote_address);
+  Debug(this,
+        "Received %zu-byte packet from %s",
+        store.length(),
+        remote_address);
 
-  // The managed buffer here contains the received packet. We do not yet know
+  // The store here contains the received packet. We do not yet know
   // at this point if it is a valid QUIC packet. We need to do some basic
   // checks. It is critical at this point that we do as little work as possible
   // to avoid a DOS vector.
-  std::shared_ptr<BackingStore> backing = env()->release_managed_buffer(buf);
-  if (!backing) [[unlikely]] {
-    // At this point something bad happened and we need to treat this as a fatal
-    // case. There's likely no way to test this specific condition reliably.
-    return Destroy(CloseContext::RECEIVE_FAILURE, UV_ENOMEM);
-  }
-
-  Store store(std::move(backing), buf.len, 0);
 
   ngtcp2_vec vec = store;
   ngtcp2_version_cid pversion_cid;
@@ -1558,6 +1785,18 @@ void Endpoint::Receive(const uv_buf_t& buf,
       return;  // Stateless reset! Don't do any further processing.
     }
 
+    // With reuse_port, a packet with a short header for the server_id of
+    // another endpoint of the group was misrouted, as happens when the
+    // group changes. Answering it with a stateless reset would close a
+    // session that is still alive, so it is dropped instead.
+    constexpr size_t kServerIdOffset = CID::Factory::kServerIdOffset;
+    if (cid_factory_ && !scid && dcid.length() > kServerIdOffset &&
+        static_cast<const uint8_t*>(dcid)[kServerIdOffset] !=
+            options_.server_id) {
+      Debug(this, "Packet for dcid %s was misrouted, ignoring", dcid);
+      return;
+    }
+
     // Process the packet as an initial packet...
     return acceptInitialPacket(pversion_cid.version,
                                dcid,
@@ -11,6 +11,7 @@
 #include <v8.h>
 #include <algorithm>
 #include <optional>
+#include <vector>
 #include "bindingdata.h"
 #include "packet.h"
 #include "session.h"
@@ -134,6 +135,20 @@ class Endpoint final : public AsyncWrap, public Packet::Listener {
     // Setting to 0 uses the default.
     uint8_t udp_ttl = 0;
 
+    // When reuse_port is set, several endpoints, typically one per worker
+    // thread, can be bound to the same local address, and the kernel spreads
+    // the incoming packets among them. The CIDs of the sessions of each
+    // endpoint then carry its server_id, which is what the packets with
+    // short headers are routed by on Linux, so that a session keeps reaching
+    // the endpoint that owns it when the address of the peer changes. The
+    // kernel numbers the endpoints of the group in the order in which they
+    // were bound, so each server_id must be that number and the endpoints
+    // have to outlive all of the sessions of the group. Packets with long
+    // headers, which are only exchanged during the handshake, are routed by
+    // the addresses of the peers.
+    bool reuse_port = false;
+    uint8_t server_id = 0;
+
     void MemoryInfo(MemoryTracker* tracker) const override;
     SET_MEMORY_INFO_NAME(Endpoint::Config)
     SET_SELF_SIZE(Options)
@@ -263,6 +278,13 @@ class Endpoint final : public AsyncWrap, public Packet::Listener {
     void Close();
     int Send(const BaseObjectPtr<Packet>& packet);
 
+    // While corked, Send() holds packets back instead of writing them to the
+    // socket. The final Uncork() flushes the held packets together so that a
+    // burst goes out with a single sendmmsg() or segmentation offload
+    // syscall. Returns 0 or the first send error.
+    void Cork();
+    int Uncork();
+
     // Returns the local UDP socket address to which we are bound,
     // or fail with an assert if we are not bound.
     SocketAddress local_address() const;
@@ -282,7 +304,18 @@ class Endpoint final : public AsyncWrap, public Packet::Listener {
    private:
     class Impl;
 
+    // Makes the kernel route the packets received by the sockets bound with
+    // reuse_port by the server id in their dcid.
+    int AttachSteeringProgram();
+
+    // Passes the packet to uv_udp_send(), which completes asynchronously.
+    int SendQueued(const BaseObjectPtr<Packet>& packet);
+    int Flush();
+
     BaseObjectWeakPtr<Impl> impl_;
+    std::vector<BaseObjectPtr<Packet>> pending_;
+    size_t cork_count_ = 0;
+    bool gso_unsupported_ = false;
     bool is_bound_ = false;
     bool is_started_ = false;
     bool is_closed_ = false;
@@ -300,6 +333,11 @@ class Endpoint final : public AsyncWrap, public Packet::Listener {
   // * We're not listening for new initial packets.
   void MaybeDestroy();
 
+  // Batch the packets sent between Cork() and the matching Uncork() into as
+  // few syscalls as possible. Calls may nest.
+  void Cork();
+  void Uncork();
+
   // Specifies the general reason the endpoint is being destroyed.
   enum class CloseContext {
     CLOSE,
@@ -369,11 +407,13 @@ class Endpoint final : public AsyncWrap, public Packet::Listener {
   static void Ref(const v8::FunctionCallbackInfo<v8::Value>& args);
   static void FastRef(v8::Local<v8::Object> receiver, bool on);
 
-  void Receive(const uv_buf_t& buf, const SocketAddress& from);
+  void Receive(Store&& store, const SocketAddress& from);
 
   AliasedStruct<Stats> stats_;
   AliasedStruct<State> state_;
   const Options options_;
+  // Set when reuse_port is, to generate CIDs carrying the server_id.
+  std::unique_ptr<CID::Factory> cid_factory_;
   UDP udp_;
 
   struct ServerState {
@@ -161,6 +161,12 @@ struct Http3HeaderTraits {
     }
     return nullptr;
   }
+
+  // As with HTTP/2, short values are internalized so that repeated values
+  // share one string, unless the peer marked them as never-indexed.
+  static bool IsInternalizableValue(uint8_t flags) {
+    return !(flags & NGHTTP3_NV_FLAG_NEVER_INDEX);
+  }
 };
 
 using Http3Header = NgHeader<Http3HeaderTraits>;
@@ -29,6 +29,7 @@ namespace {
 static constexpr size_t kRandlen = NGTCP2_MIN_STATELESS_RESET_RANDLEN * 5;
 static constexpr size_t kMinStatelessResetLen = 41;
 static constexpr size_t kMaxFreeList = 100;
+static constexpr size_t kMaxPooledPayloadLength = kDefaultMaxPacketLength * 2;
 }  // namespace
 
 std::string PathDescriptor::ToString() const {
@@ -50,7 +51,7 @@ struct Packet::Data final : public MemoryRetainer {
   // The diagnostic_label_ is used only as a debugging tool when
   // logging debug information about the packet. It identifies
   // the purpose of the packet.
-  const std::string diagnostic_label_;
+  std::string diagnostic_label_;
 
   void MemoryInfo(MemoryTracker* tracker) const override {
     tracker->TrackFieldWithSize("data", data_.length());
@@ -63,6 +64,14 @@ struct Packet::Data final : public MemoryRetainer {
     data_.AllocateSufficientStorage(length);
   }
 
+  // Prepares a pooled payload for reuse. Storage is only reallocated when
+  // length exceeds what the buffer already holds; the previous contents are
+  // left in place since they are always overwritten before sending.
+  void Reset(size_t length, std::string_view diagnostic_label) {
+    data_.AllocateSufficientStorage(length);
+    diagnostic_label_ = diagnostic_label;
+  }
+
   size_t length() const { return data_.length(); }
   operator uv_buf_t() {
     return uv_buf_init(reinterpret_cast<char*>(data_.out()), data_.length());
@@ -127,10 +136,15 @@ BaseObjectPtr<Packet> Packet::Create(Environment* env,
         env, listener, obj, destination, length, diagnostic_label);
   }
 
-  return FromFreeList(env,
-                      std::make_shared<Data>(length, diagnostic_label),
-                      listener,
-                      destination);
+  // Packets on the freelist usually still own the payload they were last
+  // sent with, which we reuse rather than allocating a new one.
+  auto packet = FromFreeList(env, {}, listener, destination);
+  if (packet->data_) {
+    packet->data_->Reset(length, diagnostic_label);
+  } else {
+    packet->data_ = std::make_shared<Data>(length, diagnostic_label);
+  }
+  return packet;
 }
 
 BaseObjectPtr<Packet> Packet::Clone() const {
@@ -162,7 +176,7 @@ BaseObjectPtr<Packet> Packet::FromFreeList(Environment* env,
   CHECK_EQ(env, obj->env());
   auto packet = BaseObjectPtr<Packet>(static_cast<Packet*>(obj.get()));
   Debug(packet.get(), "Reusing packet from freelist");
-  packet->data_ = std::move(data);
+  if (data) packet->data_ = std::move(data);
   packet->destination_ = destination;
   packet->listener_ = listener;
   return packet;
@@ -211,7 +225,13 @@ void Packet::Done(int status) {
 
   Debug(this, "Returning packet to freelist");
   listener_ = nullptr;
-  data_.reset();
+  // Keep the payload with the packet so the next Create() can reuse it,
+  // unless it is shared with a clone that is still in flight or has grown
+  // well beyond the default packet size.
+  if (data_ && (data_.use_count() > 1 ||
+                data_->data_.capacity() > kMaxPooledPayloadLength)) {
+    data_.reset();
+  }
   Reset();
   binding.packet_freelist.push_back(std::move(self));
 }
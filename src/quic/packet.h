@@ -40,7 +40,9 @@ struct PathDescriptor {
 // a Packet, we'll check to see if there is a free
 // packet in the freelist and use it instead of starting
 // fresh with a new packet. The freelist can store at
-// most kMaxFreeList packets
+// most kMaxFreeList packets. A packet on the freelist
+// keeps its payload buffer so that reusing it does not
+// allocate either.
 //
 // Packets are always encrypted so their content should
 // be considered opaque to us. We leave it entirely up
@@ -608,6 +608,12 @@ struct Session::Impl final : public MemoryRetainer {
 
     endpoint->DisassociateCID(config_.dcid);
     endpoint->DisassociateCID(config_.preferred_address_cid);
+    // The endpoint associates the dcid of the peer's initial packets with
+    // an accepted session; see Endpoint::Receive().
+    if (session_->is_server()) {
+      endpoint->DisassociateCID(config_.ocid);
+      endpoint->DisassociateCID(config_.retry_scid);
+    }
 
     for (size_t n = 0; n < cids.length(); n++) {
       endpoint->DisassociateCID(CID(cids[n]));
@@ -2811,6 +2817,12 @@ void Session::InitPerContext(Realm* realm, Local<Object> target) {
       static_cast<uint32_t>(Direction::UNIDIRECTIONAL);
   static constexpr auto QUIC_PROTO_MAX = NGTCP2_PROTO_VER_MAX;
   static constexpr auto QUIC_PROTO_MIN = NGTCP2_PROTO_VER_MIN;
+  static constexpr auto DEFAULT_QPACK_MAX_DTABLE_CAPACITY =
+      kDefaultQpackMaxDTableCapacity;
+  static constexpr auto DEFAULT_QPACK_ENCODER_MAX_DTABLE_CAPACITY =
+      kDefaultQpackEncoderMaxDTableCapacity;
+  static constexpr auto DEFAULT_QPACK_BLOCKED_STREAMS =
+      kDefaultQpackBlockedStreams;
 
   NODE_DEFINE_CONSTANT(target, STREAM_DIRECTION_BIDIRECTIONAL);
   NODE_DEFINE_CONSTANT(target, STREAM_DIRECTION_UNIDIRECTIONAL);
@@ -2818,6 +2830,9 @@ void Session::InitPerContext(Realm* realm, Local<Object> target) {
   NODE_DEFINE_CONSTANT(target, DEFAULT_MAX_HEADER_LENGTH);
   NODE_DEFINE_CONSTANT(target, QUIC_PROTO_MAX);
   NODE_DEFINE_CONSTANT(target, QUIC_PROTO_MIN);
+  NODE_DEFINE_CONSTANT(target, DEFAULT_QPACK_MAX_DTABLE_CAPACITY);
+  NODE_DEFINE_CONSTANT(target, DEFAULT_QPACK_ENCODER_MAX_DTABLE_CAPACITY);
+  NODE_DEFINE_CONSTANT(target, DEFAULT_QPACK_BLOCKED_STREAMS);
 
   NODE_DEFINE_STRING_CONSTANT(
       target, "DEFAULT_CIPHERS", TLSContext::DEFAULT_CIPHERS);
@@ -74,9 +74,17 @@ class Session final : public AsyncWrap, private SessionTicket::AppData::Source {
 
     // HTTP/3 specific options.
     uint64_t max_field_section_size = 0;
-    uint64_t qpack_max_dtable_capacity = 0;
-    uint64_t qpack_encoder_max_dtable_capacity = 0;
-    uint64_t qpack_blocked_streams = 0;
+    // The capacity of the QPACK dynamic table the peer's encoder may use
+    // when sending to us, advertised in SETTINGS.
+    uint64_t qpack_max_dtable_capacity = kDefaultQpackMaxDTableCapacity;
+    // Upper bound on the dynamic table our own encoder will use. The
+    // effective capacity is the smaller of this and what the peer allows.
+    uint64_t qpack_encoder_max_dtable_capacity =
+        kDefaultQpackEncoderMaxDTableCapacity;
+    // The number of streams that may be blocked waiting on QPACK encoder
+    // stream updates. Zero forbids the peer from referencing entries that
+    // have not yet been acknowledged.
+    uint64_t qpack_blocked_streams = kDefaultQpackBlockedStreams;
 
     bool enable_connect_protocol = true;
     bool enable_datagrams = true;
@@ -148,11 +156,13 @@ class Session final : public AsyncWrap, private SessionTicket::AppData::Source {
     // completion of the tls handshake.
     uint64_t handshake_timeout = UINT64_MAX;
 
-    // Maximum initial flow control window size for a stream.
-    uint64_t max_stream_window = 0;
+    // Maximum size the flow control window of a stream may be autotuned to.
+    // Setting this to 0 disables stream-level autotuning.
+    uint64_t max_stream_window = kDefaultMaxStreamWindow;
 
-    // Maximum initial flow control window size for the connection.
-    uint64_t max_window = 0;
+    // Maximum size the connection-level flow control window may be autotuned
+    // to. Setting this to 0 disables connection-level autotuning.
+    uint64_t max_window = kDefaultMaxWindow;
 
     // The max_payload_size is the maximum size of a serialized QUIC packet. It
     // should always be set small enough to fit within a single MTU without
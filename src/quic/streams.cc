@@ -8,6 +8,8 @@
 #include <node_blob.h>
 #include <node_bob-inl.h>
 #include <node_sockaddr-inl.h>
+#include <deque>
+#include <vector>
 #include "application.h"
 #include "bindingdata.h"
 #include "defs.h"
@@ -19,7 +21,10 @@ using v8::Array;
 using v8::ArrayBuffer;
 using v8::ArrayBufferView;
 using v8::BackingStoreInitializationMode;
+using v8::BackingStore;
 using v8::BigInt;
+using v8::Boolean;
+using v8::Function;
 using v8::FunctionCallbackInfo;
 using v8::FunctionTemplate;
 using v8::Global;
@@ -28,6 +33,7 @@ using v8::Just;
 using v8::Local;
 using v8::Maybe;
 using v8::Nothing;
+using v8::Number;
 using v8::Object;
 using v8::ObjectTemplate;
 using v8::PropertyAttribute;
@@ -86,7 +92,8 @@ namespace quic {
   V(ResetStream, resetStream, false)                                           \
   V(SetPriority, setPriority, false)                                           \
   V(GetPriority, getPriority, true)                                            \
-  V(GetReader, getReader, false)
+  V(GetReader, getReader, false)                                               \
+  V(ReadInto, readInto, false)
 
 // ============================================================================
 
@@ -179,6 +186,34 @@ Maybe<std::shared_ptr<DataQueue>> Stream::GetDataQueueFromSource(
   return Nothing<std::shared_ptr<DataQueue>>();
 }
 
+struct Stream::ByobRead final {
+  // The data that was received while no buffer was waiting for it.
+  std::deque<std::vector<uint8_t>> pending;
+  size_t pending_offset = 0;
+
+  // The buffer waiting for data, if any.
+  std::shared_ptr<BackingStore> store;
+  uint8_t* data = nullptr;
+  size_t length = 0;
+  Global<Function> callback;
+
+  size_t TakePending(uint8_t* dest, size_t len) {
+    size_t taken = 0;
+    while (taken < len && !pending.empty()) {
+      std::vector<uint8_t>& chunk = pending.front();
+      size_t amount = std::min(len - taken, chunk.size() - pending_offset);
+      memcpy(dest + taken, chunk.data() + pending_offset, amount);
+      taken += amount;
+      pending_offset += amount;
+      if (pending_offset == chunk.size()) {
+        pending.pop_front();
+        pending_offset = 0;
+      }
+    }
+    return taken;
+  }
+};
+
 // Provides the implementation of the various JavaScript APIs for the
 // Stream object.
 struct Stream::Impl {
@@ -329,6 +364,56 @@ struct Stream::Impl {
     THROW_ERR_INVALID_STATE(Environment::GetCurrent(args),
                             "Unable to get a reader for the stream");
   }
+
+  // Reads the received data into the given ArrayBufferView, as the
+  // alternative to getReader() that copies the data only once. Returns the
+  // number of bytes read when data is available, or -1 once the readable
+  // side has ended. Otherwise, returns 0 and calls the callback with the
+  // number of bytes read and whether the readable side ended, once that
+  // happens. The view must not be used until then.
+  static void ReadInto(const FunctionCallbackInfo<Value>& args) {
+    Environment* env = Environment::GetCurrent(args);
+    Stream* stream;
+    ASSIGN_OR_RETURN_UNWRAP(&stream, args.This());
+    CHECK(args[0]->IsArrayBufferView());
+    CHECK(args[1]->IsFunction());
+
+    if (!stream->byob_) {
+      if (!stream->is_readable() || stream->state_->has_reader) {
+        return THROW_ERR_INVALID_STATE(
+            env, "Unable to read into a buffer from the stream");
+      }
+      stream->state_->has_reader = 1;
+      stream->byob_ = std::make_unique<ByobRead>();
+    }
+    ByobRead* read = stream->byob_.get();
+    if (read->data != nullptr)
+      return THROW_ERR_INVALID_STATE(env, "A read is already pending");
+
+    Local<ArrayBufferView> view = args[0].As<ArrayBufferView>();
+    std::shared_ptr<BackingStore> store = view->Buffer()->GetBackingStore();
+    if (store->IsResizableByUserJavaScript() || view->ByteLength() == 0) {
+      return THROW_ERR_INVALID_ARG_VALUE(
+          env, "The buffer must be non-empty and not resizable");
+    }
+    uint8_t* data = static_cast<uint8_t*>(store->Data()) + view->ByteOffset();
+    size_t length = view->ByteLength();
+
+    size_t taken = read->TakePending(data, length);
+    if (taken > 0) {
+      stream->session().ExtendStreamOffset(stream->id(), taken);
+      return args.GetReturnValue().Set(static_cast<double>(taken));
+    }
+    if (stream->state_->read_ended) return args.GetReturnValue().Set(-1);
+
+    // The backing store keeps the memory alive even if the buffer gets
+    // detached in the meantime.
+    read->store = std::move(store);
+    read->data = data;
+    read->length = length;
+    read->callback.Reset(env->isolate(), args[1].As<Function>());
+    args.GetReturnValue().Set(0);
+  }
 };
 
 // ============================================================================
@@ -511,7 +596,7 @@ class Stream::Outbound final : public MemoryRetainer {
             stream_->session().ResumeStream(stream_->id());
           }
         },
-        bob::OPTIONS_SYNC,
+        bob::OPTIONS_SYNC | bob::OPTIONS_GATHER,
         nullptr,
         0,
         kMaxVectorCount);
@@ -818,13 +903,16 @@ Stream::Stream(BaseObjectWeakPtr<Session> session,
       stats_(env()->isolate()),
       state_(env()->isolate()),
       session_(std::move(session)),
-      inbound_(DataQueue::Create()) {
+      inbound_(DataQueue::Create()),
+      inbound_listener_(env(), this) {
   MakeWeak();
   state_->id = id;
   state_->pending = 0;
   // Allows us to be notified when data is actually read from the
-  // inbound queue so that we can update the stream flow control.
-  inbound_->addBackpressureListener(this);
+  // inbound queue so that we can update the stream flow control. The
+  // inbound queue may be read from another thread once the reader's Blob
+  // has been posted to a Worker.
+  inbound_->addBackpressureListener(&inbound_listener_);
 
   const auto defineProperty = [&](auto name, auto value) {
     object
@@ -852,6 +940,7 @@ Stream::Stream(BaseObjectWeakPtr<Session> session,
       state_(env()->isolate()),
       session_(std::move(session)),
       inbound_(DataQueue::Create()),
+      inbound_listener_(env(), this),
       maybe_pending_stream_(
           std::make_unique<PendingStream>(direction, this, session_)) {
   MakeWeak();
@@ -859,8 +948,10 @@ Stream::Stream(BaseObjectWeakPtr<Session> session,
   state_->pending = 1;
 
   // Allows us to be notified when data is actually read from the
-  // inbound queue so that we can update the stream flow control.
-  inbound_->addBackpressureListener(this);
+  // inbound queue so that we can update the stream flow control. The
+  // inbound queue may be read from another thread once the reader's Blob
+  // has been posted to a Worker.
+  inbound_->addBackpressureListener(&inbound_listener_);
 
   const auto defineProperty = [&](auto name, auto value) {
     object
@@ -1130,6 +1221,8 @@ void Stream::EndReadable(std::optional<uint64_t> maybe_final_size) {
   state_->read_ended = 1;
   set_final_size(maybe_final_size.value_or(STAT_GET(Stats, bytes_received)));
   inbound_->cap(STAT_GET(Stats, final_size));
+  // A buffer only waits while no data is kept, so there is none to come.
+  if (byob_ && byob_->data != nullptr) FinishByobRead(0);
 }
 
 void Stream::Destroy(QuicError error) {
@@ -1162,7 +1255,7 @@ void Stream::Destroy(QuicError error) {
   // We reset the inbound here also. However, it's important to note that
   // the JavaScript side could still have a reader on the inbound DataQueue,
   // which may keep that data alive a bit longer.
-  inbound_->removeBackpressureListener(this);
+  inbound_->removeBackpressureListener(&inbound_listener_);
   inbound_.reset();
 
   // Notify the JavaScript side that our handle is being destroyed. The
@@ -1199,6 +1292,11 @@ void Stream::ReceiveData(const uint8_t* data,
 
   STAT_INCREMENT_N(Stats, bytes_received, len);
   STAT_RECORD_TIMESTAMP(Stats, received_at);
+  if (byob_) {
+    ReceiveDataInto(data, len);
+    if (flags.fin) EndReadable();
+    return;
+  }
   auto backing = ArrayBuffer::NewBackingStore(
       env()->isolate(), len, BackingStoreInitializationMode::kUninitialized);
   memcpy(backing->Data(), data, len);
@@ -1208,6 +1306,36 @@ void Stream::ReceiveData(const uint8_t* data,
   if (flags.fin) EndReadable();
 }
 
+void Stream::ReceiveDataInto(const uint8_t* data, size_t len) {
+  size_t read = 0;
+  // Data kept from earlier has been handed out before a buffer waits.
+  if (byob_->data != nullptr) {
+    DCHECK(byob_->pending.empty());
+    read = std::min(len, byob_->length);
+    memcpy(byob_->data, data, read);
+    // Only the data that the JavaScript side got counts against the flow
+    // control window, so what is kept here stays within it.
+    session().ExtendStreamOffset(id(), read);
+  }
+  if (read < len) byob_->pending.emplace_back(data + read, data + len);
+  if (read > 0) FinishByobRead(read);
+}
+
+void Stream::FinishByobRead(size_t read) {
+  Local<Function> callback = byob_->callback.Get(env()->isolate());
+  byob_->callback.Reset();
+  byob_->store.reset();
+  byob_->data = nullptr;
+  byob_->length = 0;
+  if (!env()->can_call_into_js()) return;
+  CallbackScope<Stream> cb_scope(this);
+  Local<Value> argv[] = {
+      Number::New(env()->isolate(), static_cast<double>(read)),
+      Boolean::New(env()->isolate(), state_->read_ended == 1),
+  };
+  MakeCallback(callback, arraysize(argv), argv);
+}
+
 void Stream::ReceiveStopSending(QuicError error) {
   // Note that this comes from *this* endpoint, not the other side. We handle it
   // if we haven't already shutdown our *receiving* side of the stream.
@@ -269,10 +269,18 @@ class Stream final : public AsyncWrap,
   struct PendingHeaders;
 
   class Outbound;
+  struct ByobRead;
 
   // Gets a reader for the data received for this stream from the peer,
   BaseObjectPtr<Blob::Reader> get_reader();
 
+  // Copies received data into the buffer that the JavaScript side passed
+  // to readInto(), keeping what does not fit for the next call.
+  void ReceiveDataInto(const uint8_t* data, size_t len);
+  // Hands the buffer passed to readInto() back once it got data or the
+  // readable side ended.
+  void FinishByobRead(size_t read);
+
   void set_final_size(uint64_t amount);
   void set_outbound(std::shared_ptr<DataQueue> source);
 
@@ -313,6 +321,10 @@ class Stream final : public AsyncWrap,
   BaseObjectWeakPtr<Session> session_;
   std::unique_ptr<Outbound> outbound_;
   std::shared_ptr<DataQueue> inbound_;
+  DataQueue::ThreadsafeBackpressureListener inbound_listener_;
+  // Set once the inbound data is read with readInto() rather than through
+  // get_reader(), in which case inbound_ stays empty.
+  std::unique_ptr<ByobRead> byob_;
 
   // If the stream cannot be opened yet, it will be created in a pending state.
   // Once the owning session is able to, it will complete opening of the stream
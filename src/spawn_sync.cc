@@ -28,7 +28,9 @@
 #include "string_bytes.h"
 #include "util-inl.h"
 
+#include <algorithm>
 #include <cstring>
+#include <limits>
 #include "nbytes.h"
 
 namespace node {
@@ -36,6 +38,7 @@ namespace node {
 using v8::Array;
 using v8::Context;
 using v8::EscapableHandleScope;
+using v8::Function;
 using v8::FunctionCallbackInfo;
 using v8::HandleScope;
 using v8::Int32;
@@ -51,50 +54,56 @@ using v8::Null;
 using v8::Number;
 using v8::Object;
 using v8::String;
+using v8::Undefined;
 using v8::Value;
 
-void SyncProcessOutputBuffer::OnAlloc(size_t suggested_size,
-                                      uv_buf_t* buf) const {
-  if (used() == kBufferSize)
-    *buf = uv_buf_init(nullptr, 0);
-  else
-    *buf = uv_buf_init(data_ + used(), available());
+void SyncProcessOutputBuffer::OnAlloc(size_t suggested_size, uv_buf_t* buf) {
+  if (used_ == data_.size) {
+    size_t size = std::max(kInitialSize, data_.size * 2);
+    char* data = UncheckedRealloc(data_.data, size);
+    if (data == nullptr) {
+      // libuv reports this to the read callback as UV_ENOBUFS.
+      *buf = uv_buf_init(nullptr, 0);
+      return;
+    }
+    data_.data = data;
+    data_.size = size;
+  }
+  // Use unsigned int because that's what `uv_buf_init` takes.
+  size_t available = std::min<size_t>(data_.size - used_,
+                                      std::numeric_limits<unsigned int>::max());
+  *buf = uv_buf_init(data_.data + used_, static_cast<unsigned int>(available));
 }
 
 
 void SyncProcessOutputBuffer::OnRead(const uv_buf_t* buf, size_t nread) {
   // If we hand out the same chunk twice, this should catch it.
-  CHECK_EQ(buf->base, data_ + used());
-  used_ += static_cast<unsigned int>(nread);
+  CHECK_EQ(buf->base, data_.data + used_);
+  used_ += nread;
 }
 
 
-size_t SyncProcessOutputBuffer::Copy(char* dest) const {
-  if (dest != nullptr) memcpy(dest, data_, used());
-  return used();
-}
-
+MaybeLocal<Object> SyncProcessOutputBuffer::Release(Environment* env) {
+  if (used_ == 0) return Buffer::New(env, 0);
 
-unsigned int SyncProcessOutputBuffer::available() const {
-  return sizeof data_ - used();
+  size_t length = used_;
+  if (length < data_.size) data_.Realloc(length);
+  used_ = 0;
+  data_.size = 0;
+  return Buffer::New(
+      env,
+      data_.release(),
+      length,
+      [](char* data, void* hint) { free(data); },
+      nullptr);
 }
 
 
-unsigned int SyncProcessOutputBuffer::used() const {
+size_t SyncProcessOutputBuffer::used() const {
   return used_;
 }
 
 
-SyncProcessOutputBuffer* SyncProcessOutputBuffer::next() const {
-  return next_;
-}
-
-
-void SyncProcessOutputBuffer::set_next(SyncProcessOutputBuffer* next) {
-  next_ = next;
-}
-
-
 SyncProcessStdioPipe::SyncProcessStdioPipe(SyncProcessRunner* process_handler,
                                            bool readable,
                                            bool writable,
@@ -104,9 +113,6 @@ SyncProcessStdioPipe::SyncProcessStdioPipe(SyncProcessRunner* process_handler,
       writable_(writable),
       input_buffer_(input_buffer),
 
-      first_output_buffer_(nullptr),
-      last_output_buffer_(nullptr),
-
       uv_pipe_(),
       write_req_(),
       shutdown_req_(),
@@ -118,14 +124,6 @@ SyncProcessStdioPipe::SyncProcessStdioPipe(SyncProcessRunner* process_handler,
 
 SyncProcessStdioPipe::~SyncProcessStdioPipe() {
   CHECK(lifecycle_ == kUninitialized || lifecycle_ == kClosed);
-
-  SyncProcessOutputBuffer* buf;
-  SyncProcessOutputBuffer* next;
-
-  for (buf = first_output_buffer_; buf != nullptr; buf = next) {
-    next = buf->next();
-    delete buf;
-  }
 }
 
 
@@ -186,15 +184,18 @@ void SyncProcessStdioPipe::Close() {
   lifecycle_ = kClosing;
 }
 
-MaybeLocal<Object> SyncProcessStdioPipe::GetOutputAsBuffer(
-    Environment* env) const {
-  size_t length = OutputLength();
-  Local<Object> js_buffer;
-  if (!Buffer::New(env, length).ToLocal(&js_buffer)) {
-    return MaybeLocal<Object>();
-  }
-  CopyOutput(Buffer::Data(js_buffer));
-  return js_buffer;
+MaybeLocal<Object> SyncProcessStdioPipe::GetOutputAsBuffer(Environment* env) {
+  return output_buffer_.Release(env);
+}
+
+
+void SyncProcessStdioPipe::set_data_callback(Local<Function> callback) {
+  data_callback_.Reset(process_handler_->env()->isolate(), callback);
+}
+
+
+bool SyncProcessStdioPipe::has_data_callback() const {
+  return !data_callback_.IsEmpty();
 }
 
 bool SyncProcessStdioPipe::readable() const {
@@ -236,23 +237,17 @@ uv_handle_t* SyncProcessStdioPipe::uv_handle() const {
 }
 
 
-size_t SyncProcessStdioPipe::OutputLength() const {
-  SyncProcessOutputBuffer* buf;
-  size_t size = 0;
-
-  for (buf = first_output_buffer_; buf != nullptr; buf = buf->next())
-    size += buf->used();
-
-  return size;
-}
-
-
-void SyncProcessStdioPipe::CopyOutput(char* dest) const {
-  SyncProcessOutputBuffer* buf;
-  size_t offset = 0;
-
-  for (buf = first_output_buffer_; buf != nullptr; buf = buf->next())
-    offset += buf->Copy(dest + offset);
+void SyncProcessStdioPipe::EmitData() {
+  Environment* env = process_handler_->env();
+  Isolate* isolate = env->isolate();
+  HandleScope handle_scope(isolate);
+  Local<Function> callback = data_callback_.Get(isolate);
+  Local<Value> chunk;
+  if (!output_buffer_.Release(env).ToLocal(&chunk) ||
+      callback->Call(env->context(), Undefined(isolate), 1, &chunk)
+          .IsEmpty()) {
+    process_handler_->OnDataCallbackFailed();
+  }
 }
 
 
@@ -261,20 +256,7 @@ void SyncProcessStdioPipe::OnAlloc(size_t suggested_size, uv_buf_t* buf) {
   // same stream at the same time. There's an assert in
   // SyncProcessOutputBuffer::OnRead that would fail if this assumption was
   // ever violated.
-
-  if (last_output_buffer_ == nullptr) {
-    // Allocate the first capture buffer.
-    first_output_buffer_ = new SyncProcessOutputBuffer();
-    last_output_buffer_ = first_output_buffer_;
-
-  } else if (last_output_buffer_->available() == 0) {
-    // The current capture buffer is full so get us a new one.
-    SyncProcessOutputBuffer* buf = new SyncProcessOutputBuffer();
-    last_output_buffer_->set_next(buf);
-    last_output_buffer_ = buf;
-  }
-
-  last_output_buffer_->OnAlloc(suggested_size, buf);
+  output_buffer_.OnAlloc(suggested_size, buf);
 }
 
 
@@ -287,8 +269,12 @@ void SyncProcessStdioPipe::OnRead(const uv_buf_t* buf, ssize_t nread) {
     // At some point libuv should really implicitly stop reading on error.
     uv_read_stop(uv_stream());
 
+  } else if (has_data_callback()) {
+    output_buffer_.OnRead(buf, nread);
+    EmitData();
+
   } else {
-    last_output_buffer_->OnRead(buf, nread);
+    output_buffer_.OnRead(buf, nread);
     process_handler_->IncrementBufferSizeAndCheckOverflow(nread);
   }
 }
@@ -407,6 +393,7 @@ SyncProcessRunner::SyncProcessRunner(Environment* env)
 
       uv_process_(),
       killed_(false),
+      data_callback_failed_(false),
 
       buffered_output_size_(0),
       exit_status_(-1),
@@ -447,7 +434,7 @@ MaybeLocal<Object> SyncProcessRunner::Run(Local<Value> options) {
 
   Maybe<void> r = TryInitializeAndRunLoop(options);
   CloseHandlesAndDeleteLoop();
-  if (r.IsNothing()) return MaybeLocal<Object>();
+  if (r.IsNothing() || data_callback_failed_) return MaybeLocal<Object>();
 
   Local<Object> result;
   if (!BuildResultObject().ToLocal(&result)) {
@@ -509,13 +496,12 @@ Maybe<void> SyncProcessRunner::TryInitializeAndRunLoop(Local<Value> options) {
     }
   }
 
-  uv_process_options_.exit_cb = ExitCallback;
-  r = uv_spawn(uv_loop_, &uv_process_, &uv_process_options_);
+  r = uv_process_.Spawn(uv_loop_, &uv_process_options_, ExitCallback);
   if (r < 0) {
     SetError(r);
     return JustVoid();
   }
-  uv_process_.data = this;
+  uv_process_.handle()->data = this;
 
   for (const auto& pipe : stdio_pipes_) {
     if (pipe != nullptr) {
@@ -544,15 +530,14 @@ void SyncProcessRunner::CloseHandlesAndDeleteLoop() {
     CloseStdioPipes();
     CloseKillTimer();
     // Close the process handle when ExitCallback was not called.
-    uv_handle_t* uv_process_handle =
-        reinterpret_cast<uv_handle_t*>(&uv_process_);
+    uv_handle_t* uv_process_handle = uv_process_.handle();
 
     // Close the process handle if it is still open. The handle type also
     // needs to be checked because TryInitializeAndRunLoop() won't spawn a
     // process if input validation fails.
-    if (uv_process_handle->type == UV_PROCESS &&
+    if (uv_process_handle->type != UV_UNKNOWN_HANDLE &&
         !uv_is_closing(uv_process_handle))
-      uv_close(uv_process_handle, nullptr);
+      uv_process_.Close(nullptr);
 
     // Give closing watchers a chance to finish closing and get their close
     // callbacks called.
@@ -619,7 +604,7 @@ void SyncProcessRunner::Kill() {
   // a signal to the process, however we will still close our end of the stdio
   // pipes so this situation won't make us hang.
   if (exit_status_ < 0) {
-    int r = uv_process_kill(&uv_process_, kill_signal_);
+    int r = uv_process_.Kill(kill_signal_);
 
     // If uv_kill failed with an error that isn't ESRCH, the user probably
     // specified an invalid or unsupported signal. Signal this to the user as
@@ -629,7 +614,7 @@ void SyncProcessRunner::Kill() {
 
       // Deliberately ignore the return value, we might not have
       // sufficient privileges to signal the child process.
-      USE(uv_process_kill(&uv_process_, SIGKILL));
+      USE(uv_process_.Kill(SIGKILL));
     }
   }
 
@@ -651,6 +636,14 @@ void SyncProcessRunner::IncrementBufferSizeAndCheckOverflow(ssize_t length) {
 }
 
 
+void SyncProcessRunner::OnDataCallbackFailed() {
+  // Leave the exception pending so that it is thrown from spawnSync() once
+  // the child has been killed and the loop has finished.
+  data_callback_failed_ = true;
+  Kill();
+}
+
+
 void SyncProcessRunner::OnExit(int64_t exit_status, int term_signal) {
   if (exit_status < 0)
     return SetError(static_cast<int>(exit_status));
@@ -750,7 +743,7 @@ MaybeLocal<Object> SyncProcessRunner::BuildResultObject() {
   if (js_result
           ->Set(context,
                 env()->pid_string(),
-                Number::New(env()->isolate(), uv_process_.pid))
+                Number::New(env()->isolate(), uv_process_.pid()))
           .IsNothing()) {
     return MaybeLocal<Object>();
   }
@@ -767,7 +760,8 @@ MaybeLocal<Array> SyncProcessRunner::BuildOutputArray() {
 
   for (uint32_t i = 0; i < stdio_pipes_.size(); i++) {
     SyncProcessStdioPipe* h = stdio_pipes_[i].get();
-    if (h == nullptr || !h->writable()) {
+    // The output of pipes with a data callback has already been delivered.
+    if (h == nullptr || !h->writable() || h->has_data_callback()) {
       js_output[i] = Null(env()->isolate());
       continue;
     }
@@ -1042,7 +1036,19 @@ Maybe<int> SyncProcessRunner::ParseStdioOption(int child_fd,
       }
     }
 
-    return Just(AddStdioPipe(child_fd, readable, writable, buf));
+    int r = AddStdioPipe(child_fd, readable, writable, buf);
+    if (r < 0 || !writable) return Just(r);
+
+    // Output is passed to an `ondata` function as it arrives, rather than
+    // collected for the result, if there is one.
+    Local<Value> ondata;
+    if (!js_stdio_option->Get(context, env()->ondata_string())
+             .ToLocal(&ondata)) {
+      return Nothing<int>();
+    }
+    if (ondata->IsFunction())
+      stdio_pipes_[child_fd]->set_data_callback(ondata.As<Function>());
+    return Just(r);
 
   } else if (js_type->StrictEquals(env()->inherit_string()) ||
              js_type->StrictEquals(env()->fd_string())) {
@@ -1207,11 +1213,12 @@ Maybe<int> SyncProcessRunner::CopyJsStringArray(Local<Value> js_value,
 }
 
 
-void SyncProcessRunner::ExitCallback(uv_process_t* handle,
+void SyncProcessRunner::ExitCallback(ProcessHandle* process,
                                      int64_t exit_status,
                                      int term_signal) {
-  SyncProcessRunner* self = reinterpret_cast<SyncProcessRunner*>(handle->data);
-  uv_close(reinterpret_cast<uv_handle_t*>(handle), nullptr);
+  SyncProcessRunner* self =
+      static_cast<SyncProcessRunner*>(process->handle()->data);
+  process->Close(nullptr);
   self->OnExit(exit_status, term_signal);
 }
 
@@ -25,6 +25,8 @@
 #if defined(NODE_WANT_INTERNALS) && NODE_WANT_INTERNALS
 
 #include "node_buffer.h"
+#include "process_handle.h"
+#include "util.h"
 #include "uv.h"
 #include "v8.h"
 
@@ -36,29 +38,26 @@ class SyncProcessStdioPipe;
 class SyncProcessRunner;
 
 
+// Collects the output of a pipe in a single allocation that grows as needed,
+// so that it can be handed to JS as a Buffer without copying it. realloc()
+// usually remaps the pages of large allocations rather than copying them.
 class SyncProcessOutputBuffer {
-  static const unsigned int kBufferSize = 65536;
+  static const size_t kInitialSize = 65536;
 
  public:
   inline SyncProcessOutputBuffer() = default;
 
-  inline void OnAlloc(size_t suggested_size, uv_buf_t* buf) const;
+  inline void OnAlloc(size_t suggested_size, uv_buf_t* buf);
   inline void OnRead(const uv_buf_t* buf, size_t nread);
 
-  inline size_t Copy(char* dest) const;
-
-  inline unsigned int available() const;
-  inline unsigned int used() const;
+  // Creates a Buffer that takes over the output, and leaves this empty.
+  inline v8::MaybeLocal<v8::Object> Release(Environment* env);
 
-  inline SyncProcessOutputBuffer* next() const;
-  inline void set_next(SyncProcessOutputBuffer* next);
+  inline size_t used() const;
 
  private:
-  // Use unsigned int because that's what `uv_buf_init` takes.
-  mutable char data_[kBufferSize];
-  unsigned int used_ = 0;
-
-  SyncProcessOutputBuffer* next_ = nullptr;
+  MallocedBuffer<char> data_;
+  size_t used_ = 0;
 };
 
 
@@ -82,7 +81,12 @@ class SyncProcessStdioPipe {
   int Start();
   void Close();
 
-  v8::MaybeLocal<v8::Object> GetOutputAsBuffer(Environment* env) const;
+  v8::MaybeLocal<v8::Object> GetOutputAsBuffer(Environment* env);
+
+  // Passes each chunk of output to |callback| as a Buffer, instead of
+  // collecting the output.
+  inline void set_data_callback(v8::Local<v8::Function> callback);
+  inline bool has_data_callback() const;
 
   inline bool readable() const;
   inline bool writable() const;
@@ -93,8 +97,7 @@ class SyncProcessStdioPipe {
   inline uv_handle_t* uv_handle() const;
 
  private:
-  inline size_t OutputLength() const;
-  inline void CopyOutput(char* dest) const;
+  inline void EmitData();
 
   inline void OnAlloc(size_t suggested_size, uv_buf_t* buf);
   inline void OnRead(const uv_buf_t* buf, ssize_t nread);
@@ -120,8 +123,8 @@ class SyncProcessStdioPipe {
   bool writable_;
   uv_buf_t input_buffer_;
 
-  SyncProcessOutputBuffer* first_output_buffer_;
-  SyncProcessOutputBuffer* last_output_buffer_;
+  SyncProcessOutputBuffer output_buffer_;
+  v8::Global<v8::Function> data_callback_;
 
   mutable uv_pipe_t uv_pipe_;
   uv_write_t write_req_;
@@ -163,6 +166,7 @@ class SyncProcessRunner {
 
   void Kill();
   void IncrementBufferSizeAndCheckOverflow(ssize_t length);
+  void OnDataCallbackFailed();
 
   void OnExit(int64_t exit_status, int term_signal);
   void OnKillTimerTimeout();
@@ -192,7 +196,7 @@ class SyncProcessRunner {
   v8::Maybe<int> CopyJsStringArray(v8::Local<v8::Value> js_value,
                                    char** target);
 
-  static void ExitCallback(uv_process_t* handle,
+  static void ExitCallback(ProcessHandle* process,
                            int64_t exit_status,
                            int term_signal);
   static void KillTimerCallback(uv_timer_t* handle);
@@ -215,8 +219,10 @@ class SyncProcessRunner {
   char* env_buffer_;
   const char* cwd_buffer_;
 
-  uv_process_t uv_process_;
+  ProcessHandle uv_process_;
   bool killed_;
+  // Set when a stdio data callback threw, with the exception still pending.
+  bool data_callback_failed_;
 
   size_t buffered_output_size_;
   int64_t exit_status_;
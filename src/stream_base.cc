@@ -12,6 +12,7 @@
 #include "util-inl.h"
 #include "v8.h"
 
+#include <algorithm>
 #include <climits>  // INT_MAX
 
 namespace node {
@@ -20,6 +21,7 @@ using v8::Array;
 using v8::ArrayBuffer;
 using v8::BackingStore;
 using v8::BackingStoreInitializationMode;
+using v8::BackingStoreOnFailureMode;
 using v8::ConstructorBehavior;
 using v8::Context;
 using v8::DontDelete;
@@ -32,6 +34,7 @@ using v8::HandleScope;
 using v8::Integer;
 using v8::Isolate;
 using v8::Local;
+using v8::LocalVector;
 using v8::MaybeLocal;
 using v8::Object;
 using v8::PropertyAttribute;
@@ -39,11 +42,16 @@ using v8::ReadOnly;
 using v8::SideEffectType;
 using v8::Signature;
 using v8::String;
+using v8::Uint32;
+using v8::Uint8Array;
 using v8::Value;
 
 int StreamBase::Shutdown(v8::Local<v8::Object> req_wrap_obj) {
   Environment* env = stream_env();
 
+  // Pending coalesced writes must reach the stream before the shutdown.
+  FlushCoalescedWrites();
+
   v8::HandleScope handle_scope(env->isolate());
 
   if (req_wrap_obj.IsEmpty()) {
@@ -92,7 +100,14 @@ StreamWriteResult StreamBase::Write(uv_buf_t* bufs,
   for (size_t i = 0; i < count; ++i) total_bytes += bufs[i].len;
   bytes_written_ += total_bytes;
 
-  if (send_handle == nullptr && HasDoTryWrite() && !skip_try_write) {
+  const bool coalesce = coalesce_writes_ && send_handle == nullptr &&
+                        HasDoTryWrite() && !skip_try_write &&
+                        total_bytes <= kMaxCoalescedWriteSize;
+  // Anything that is not coalesced must not overtake the writes that were.
+  if (!coalesce) FlushCoalescedWrites();
+
+  if (!coalesce && send_handle == nullptr && HasDoTryWrite() &&
+      !skip_try_write) {
     err = DoTryWrite(&bufs, &count);
     if (err != 0 || count == 0) {
       return StreamWriteResult{false, err, nullptr, total_bytes, {}};
@@ -114,6 +129,12 @@ StreamWriteResult StreamBase::Write(uv_buf_t* bufs,
   WriteWrap* req_wrap = CreateWriteWrap(req_wrap_obj);
   BaseObjectPtr<AsyncWrap> req_wrap_ptr(req_wrap->GetAsyncWrap());
 
+  if (coalesce) {
+    QueueCoalescedWrite(req_wrap, req_wrap_ptr, bufs, count, total_bytes);
+    return StreamWriteResult{
+        true, 0, req_wrap, total_bytes, std::move(req_wrap_ptr)};
+  }
+
   err = DoWrite(req_wrap, bufs, count, send_handle);
   bool async = err == 0;
 
@@ -138,6 +159,89 @@ StreamWriteResult StreamBase::Write(uv_buf_t* bufs,
       async, err, req_wrap, total_bytes, std::move(req_wrap_ptr)};
 }
 
+void StreamBase::QueueCoalescedWrite(WriteWrap* req_wrap,
+                                     BaseObjectPtr<AsyncWrap> req_wrap_ptr,
+                                     uv_buf_t* bufs,
+                                     size_t count,
+                                     size_t total_bytes) {
+  coalesced_writes_.push_back(CoalescedWrite{
+      req_wrap, std::move(req_wrap_ptr), coalesced_bufs_.size(), count});
+  coalesced_bufs_.insert(coalesced_bufs_.end(), bufs, bufs + count);
+  coalesced_bytes_ += total_bytes;
+
+  if (coalesced_bytes_ >= kCoalescedFlushBytes ||
+      coalesced_bufs_.size() >= kCoalescedFlushBuffers) {
+    FlushCoalescedWrites();
+    return;
+  }
+
+  if (coalesced_flush_scheduled_) return;
+  coalesced_flush_scheduled_ = true;
+  BaseObjectPtr<AsyncWrap> strong_ref{GetAsyncWrap()};
+  stream_env()->SetImmediate([this, strong_ref](Environment* env) {
+    coalesced_flush_scheduled_ = false;
+    FlushCoalescedWrites();
+  });
+}
+
+void StreamBase::FlushCoalescedWrites() {
+  if (coalesced_writes_.empty()) return;
+
+  std::vector<CoalescedWrite> writes;
+  std::vector<uv_buf_t> bufs;
+  writes.swap(coalesced_writes_);
+  bufs.swap(coalesced_bufs_);
+  coalesced_bytes_ = 0;
+
+  Environment* env = stream_env();
+  HandleScope handle_scope(env->isolate());
+  Context::Scope context_scope(env->context());
+
+  // Writes that are finished here are reported as asynchronous to JS, so
+  // they must not complete before the write() call that flushed them has
+  // returned.
+  struct Completion {
+    CoalescedWrite write;
+    int status;
+  };
+  std::vector<Completion> completions;
+
+  if (!IsAlive() || IsClosing()) {
+    for (CoalescedWrite& write : writes)
+      completions.push_back(Completion{std::move(write), UV_ECANCELED});
+  } else {
+    // A single DoTryWrite() covering every gathered write. It advances
+    // `rest` past the buffers it wrote completely and slices the one it
+    // wrote in part.
+    uv_buf_t* rest = bufs.data();
+    size_t rest_count = bufs.size();
+    int err = DoTryWrite(&rest, &rest_count);
+    const size_t written_bufs = rest - bufs.data();
+
+    for (CoalescedWrite& write : writes) {
+      const size_t end = write.first + write.count;
+      if (err != 0 || end <= written_bufs) {
+        completions.push_back(Completion{std::move(write), err});
+        continue;
+      }
+      const size_t first = std::max(write.first, written_bufs);
+      int write_err = DoWrite(write.wrap, &bufs[first], end - first, nullptr);
+      if (write_err != 0)
+        completions.push_back(Completion{std::move(write), write_err});
+    }
+  }
+
+  if (completions.empty()) return;
+  BaseObjectPtr<AsyncWrap> strong_ref{GetAsyncWrap()};
+  env->SetImmediate(
+      [strong_ref, completions = std::move(completions)](Environment* env) {
+        HandleScope handle_scope(env->isolate());
+        Context::Scope context_scope(env->context());
+        for (const Completion& completion : completions)
+          completion.write.wrap->Done(completion.status);
+      });
+}
+
 template int StreamBase::WriteString<ASCII>(
     const FunctionCallbackInfo<Value>& args);
 template int StreamBase::WriteString<UTF8>(
@@ -165,6 +269,44 @@ int StreamBase::UseUserBuffer(const FunctionCallbackInfo<Value>& args) {
   return 0;
 }
 
+// useMessageFraming(callback[, maxMessageSize])
+int StreamBase::UseMessageFraming(const FunctionCallbackInfo<Value>& args) {
+  CHECK(args[0]->IsFunction());
+  size_t max_message_size = MessageFramingJSListener::kDefaultMaxMessageSize;
+  if (!args[1]->IsUndefined()) {
+    CHECK(args[1]->IsUint32());
+    max_message_size = args[1].As<Uint32>()->Value();
+  }
+
+  PushStreamListener(new MessageFramingJSListener(
+      stream_env(), args[0].As<Function>(), max_message_size));
+  return 0;
+}
+
+int StreamBase::SetWriteCoalescing(const FunctionCallbackInfo<Value>& args) {
+  set_write_coalescing(args[0]->IsTrue());
+  return 0;
+}
+
+void StreamBase::set_write_coalescing(bool enable) {
+  coalesce_writes_ = enable;
+  if (!coalesce_writes_) FlushCoalescedWrites();
+}
+
+int StreamBase::WriteCoalescedDataForExit() {
+  uv_buf_t* rest = coalesced_bufs_.data();
+  size_t rest_count = coalesced_bufs_.size();
+  while (rest_count > 0) {
+    const uv_buf_t* before = rest;
+    const size_t before_len = rest->len;
+    int err = DoTryWrite(&rest, &rest_count);
+    if (err != 0) return err;
+    if (rest_count > 0 && rest == before && rest->len == before_len)
+      return UV_EAGAIN;
+  }
+  return 0;
+}
+
 int StreamBase::Shutdown(const FunctionCallbackInfo<Value>& args) {
   CHECK(args[0]->IsObject());
   Local<Object> req_wrap_obj = args[0].As<Object>();
@@ -333,6 +475,92 @@ int StreamBase::WriteBuffer(const FunctionCallbackInfo<Value>& args) {
 }
 
 
+// Sends a buffer together with an array of handles in a single write, after a
+// header that tells the receiver how many of the handles that arrive with it
+// belong to the message. Like writeBuffer(), the caller keeps the buffer
+// alive until the write completes. Returns UV_EAGAIN without writing
+// anything when the handles cannot be passed right away, in which case they
+// can still be sent one per write.
+int StreamBase::WriteHandles(const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+  Isolate* isolate = env->isolate();
+
+  CHECK(args[0]->IsObject());
+  CHECK(args[2]->IsArray());
+
+  if (!args[1]->IsUint8Array()) {
+    node::THROW_ERR_INVALID_ARG_TYPE(env, "Second argument must be a buffer");
+    return 0;
+  }
+
+  Local<Object> req_wrap_obj = args[0].As<Object>();
+  Local<Array> handles = args[2].As<Array>();
+  const uint32_t handle_count = handles->Length();
+  const size_t payload_size = Buffer::Length(args[1]);
+  if (!IsIPCPipe() || handle_count == 0 ||
+      handle_count > kMaxHandlesPerWrite || payload_size > UINT32_MAX) {
+    return UV_EINVAL;
+  }
+
+  std::vector<uv_os_fd_t> fds(handle_count);
+  for (uint32_t i = 0; i < handle_count; i++) {
+    Local<Value> handle;
+    if (!handles->Get(env->context(), i).ToLocal(&handle)) return -1;
+    if (!handle->IsObject()) return UV_EINVAL;
+    HandleWrap* wrap;
+    ASSIGN_OR_RETURN_UNWRAP(&wrap, handle.As<Object>(), UV_EINVAL);
+    const int err = uv_fileno(wrap->GetHandle(), &fds[i]);
+    if (err != 0) return err;
+  }
+
+  char header[kHandlesFrameHeaderSize];
+  header[0] = kHandlesFrameMarker;
+  header[1] = 0;
+  for (size_t i = 0; i < 2; i++)
+    header[2 + i] = static_cast<char>(handle_count >> (8 * i));
+  for (size_t i = 0; i < 4; i++)
+    header[4 + i] = static_cast<char>(payload_size >> (8 * i));
+
+  uv_buf_t storage[] = {
+      uv_buf_init(header, sizeof(header)),
+      uv_buf_init(Buffer::Data(args[1]), payload_size),
+  };
+  uv_buf_t* bufs = storage;
+  size_t count = payload_size > 0 ? 2 : 1;
+  const size_t data_size = sizeof(header) + payload_size;
+
+  // The handles must not overtake anything that is still being gathered.
+  FlushCoalescedWrites();
+
+  int err = DoTrySendHandles(&bufs, &count, fds);
+  if (err != 0 || count == 0) {
+    if (err == 0) bytes_written_ += data_size;
+    SetWriteResult(StreamWriteResult{false, err, nullptr, data_size, {}});
+    return err;
+  }
+
+  // The handles went out with the first byte; the rest is an ordinary write.
+  size_t synchronously_written = data_size;
+  for (size_t i = 0; i < count; i++) synchronously_written -= bufs[i].len;
+  bytes_written_ += synchronously_written;
+
+  std::unique_ptr<BackingStore> bs;
+  if (bufs == storage) {
+    bs = ArrayBuffer::NewBackingStore(
+        isolate, bufs[0].len, BackingStoreInitializationMode::kUninitialized);
+    memcpy(bs->Data(), bufs[0].base, bufs[0].len);
+    bufs[0].base = static_cast<char*>(bs->Data());
+  }
+
+  StreamWriteResult res = Write(bufs, count, nullptr, req_wrap_obj, true);
+  res.bytes += synchronously_written;
+
+  SetWriteResult(res);
+  if (res.wrap != nullptr && bs) res.wrap->SetBackingStore(std::move(bs));
+  return res.err;
+}
+
+
 template <enum encoding enc>
 int StreamBase::WriteString(const FunctionCallbackInfo<Value>& args) {
   Environment* env = Environment::GetCurrent(args);
@@ -366,8 +594,11 @@ int StreamBase::WriteString(const FunctionCallbackInfo<Value>& args) {
   size_t synchronously_written = 0;
   uv_buf_t buf;
 
+  // With write coalescing, the string is copied to the heap and handed to
+  // Write() so that it does not overtake the writes that are still gathered.
   bool try_write = HasDoTryWrite() && storage_size <= sizeof(stack_storage) &&
-                   (!IsIPCPipe() || send_handle_obj.IsEmpty());
+                   (!IsIPCPipe() || send_handle_obj.IsEmpty()) &&
+                   !coalesce_writes_;
   if (try_write) {
     data_size = StringBytes::Write(isolate,
                                    stack_storage,
@@ -484,6 +715,13 @@ bool StreamBase::IsIPCPipe() {
 }
 
 
+int StreamBase::DoTrySendHandles(uv_buf_t** bufs,
+                                 size_t* count,
+                                 const std::vector<uv_os_fd_t>& fds) {
+  return UV_ENOSYS;
+}
+
+
 int StreamBase::GetFD() {
   return -1;
 }
@@ -569,8 +807,18 @@ void StreamBase::AddMethods(IsolateData* isolate_data,
   SetProtoMethod(isolate, t, "shutdown", JSMethod<&StreamBase::Shutdown>);
   SetProtoMethod(
       isolate, t, "useUserBuffer", JSMethod<&StreamBase::UseUserBuffer>);
+  SetProtoMethod(isolate,
+                 t,
+                 "useMessageFraming",
+                 JSMethod<&StreamBase::UseMessageFraming>);
+  SetProtoMethod(isolate,
+                 t,
+                 "setWriteCoalescing",
+                 JSMethod<&StreamBase::SetWriteCoalescing>);
   SetProtoMethod(isolate, t, "writev", JSMethod<&StreamBase::Writev>);
   SetProtoMethod(isolate, t, "writeBuffer", JSMethod<&StreamBase::WriteBuffer>);
+  SetProtoMethod(
+      isolate, t, "writeHandles", JSMethod<&StreamBase::WriteHandles>);
   SetProtoMethod(isolate,
                  t,
                  "writeAsciiString",
@@ -609,8 +857,11 @@ void StreamBase::RegisterExternalReferences(
   registry->Register(JSMethod<&StreamBase::ReadStopJS>);
   registry->Register(JSMethod<&StreamBase::Shutdown>);
   registry->Register(JSMethod<&StreamBase::UseUserBuffer>);
+  registry->Register(JSMethod<&StreamBase::UseMessageFraming>);
+  registry->Register(JSMethod<&StreamBase::SetWriteCoalescing>);
   registry->Register(JSMethod<&StreamBase::Writev>);
   registry->Register(JSMethod<&StreamBase::WriteBuffer>);
+  registry->Register(JSMethod<&StreamBase::WriteHandles>);
   registry->Register(JSMethod<&StreamBase::WriteString<ASCII>>);
   registry->Register(JSMethod<&StreamBase::WriteString<UTF8>>);
   registry->Register(JSMethod<&StreamBase::WriteString<UCS2>>);
@@ -687,6 +938,15 @@ void StreamResource::ClearError() {
 uv_buf_t EmitToJSStreamListener::OnStreamAlloc(size_t suggested_size) {
   CHECK_NOT_NULL(stream_);
   Environment* env = static_cast<StreamBase*>(stream_)->stream_env();
+#ifndef _WIN32
+  // Small reads, which is what LibuvStreamWrap asks for once a stream turns
+  // out to be chatty, go through the shared read buffer and are copied into
+  // an exactly sized store in OnStreamRead(). On Windows, libuv may hold on
+  // to a read buffer across loop iterations (e.g. for TTYs), so it can't be
+  // shared there.
+  if (suggested_size <= Environment::kSharedReadBufferSize)
+    return env->shared_read_buffer(suggested_size);
+#endif
   return env->allocate_managed_buffer(suggested_size);
 }
 
@@ -697,7 +957,9 @@ void EmitToJSStreamListener::OnStreamRead(ssize_t nread, const uv_buf_t& buf_) {
   Isolate* isolate = env->isolate();
   HandleScope handle_scope(isolate);
   Context::Scope context_scope(env->context());
-  std::unique_ptr<BackingStore> bs = env->release_managed_buffer(buf_);
+  const bool is_shared = env->is_shared_read_buffer(buf_);
+  std::unique_ptr<BackingStore> bs;
+  if (!is_shared) bs = env->release_managed_buffer(buf_);
 
   if (nread <= 0)  {
     if (nread < 0)
@@ -705,8 +967,13 @@ void EmitToJSStreamListener::OnStreamRead(ssize_t nread, const uv_buf_t& buf_) {
     return;
   }
 
-  CHECK_LE(static_cast<size_t>(nread), bs->ByteLength());
-  if (static_cast<size_t>(nread) != bs->ByteLength()) {
+  if (is_shared) {
+    CHECK_LE(static_cast<size_t>(nread), buf_.len);
+    bs = ArrayBuffer::NewBackingStore(
+        isolate, nread, BackingStoreInitializationMode::kUninitialized);
+    memcpy(bs->Data(), buf_.base, nread);
+  } else if (static_cast<size_t>(nread) != bs->ByteLength()) {
+    CHECK_LE(static_cast<size_t>(nread), bs->ByteLength());
     std::unique_ptr<BackingStore> old_bs = std::move(bs);
     bs = ArrayBuffer::NewBackingStore(
         isolate, nread, BackingStoreInitializationMode::kUninitialized);
@@ -752,6 +1019,152 @@ void CustomBufferJSListener::OnStreamRead(ssize_t nread, const uv_buf_t& buf) {
 }
 
 
+MessageFramingJSListener::MessageFramingJSListener(Environment* env,
+                                                   Local<Function> callback,
+                                                   size_t max_message_size)
+    : callback_(env->isolate(), callback),
+      max_message_size_(max_message_size) {}
+
+
+uv_buf_t MessageFramingJSListener::OnStreamAlloc(size_t suggested_size) {
+  CHECK_NOT_NULL(stream_);
+  Environment* env = static_cast<StreamBase*>(stream_)->stream_env();
+  // Read the rest of a large message into its own store, which saves copying
+  // it, and keeps the read from covering any of the next message.
+  if (message_ && message_length_ - message_filled_ >= suggested_size &&
+      ReserveMessage(message_filled_ + suggested_size)) {
+    return uv_buf_init(static_cast<char*>(message_->Data()) + message_filled_,
+                       message_->ByteLength() - message_filled_);
+  }
+#ifndef _WIN32
+  if (suggested_size <= Environment::kSharedReadBufferSize)
+    return env->shared_read_buffer(suggested_size);
+#endif
+  return env->allocate_managed_buffer(suggested_size);
+}
+
+
+bool MessageFramingJSListener::ReserveMessage(size_t size) {
+  // The first allocation for a message, and what it at least grows by.
+  constexpr size_t kMinCapacity = 64 * 1024;
+  CHECK_LE(size, message_length_);
+  const size_t capacity = message_ ? message_->ByteLength() : 0;
+  if (message_ && size <= capacity) return true;
+
+  Environment* env = static_cast<StreamBase*>(stream_)->stream_env();
+  const size_t new_capacity =
+      std::min(message_length_, std::max({size, capacity * 2, kMinCapacity}));
+  std::unique_ptr<BackingStore> store = ArrayBuffer::NewBackingStore(
+      env->isolate(),
+      new_capacity,
+      BackingStoreInitializationMode::kUninitialized,
+      BackingStoreOnFailureMode::kReturnNull);
+  if (!store) return false;
+  if (message_filled_ > 0)
+    memcpy(store->Data(), message_->Data(), message_filled_);
+  message_ = std::move(store);
+  return true;
+}
+
+
+MaybeLocal<Value> MessageFramingJSListener::TakeMessage() {
+  Environment* env = static_cast<StreamBase*>(stream_)->stream_env();
+  const size_t size = message_length_;
+  CHECK_EQ(message_->ByteLength(), size);
+  Local<ArrayBuffer> ab = ArrayBuffer::New(env->isolate(), std::move(message_));
+  message_length_ = 0;
+  message_filled_ = 0;
+  header_filled_ = 0;
+  Local<Uint8Array> buffer;
+  if (!Buffer::New(env, ab, 0, size).ToLocal(&buffer)) return {};
+  return buffer;
+}
+
+
+int MessageFramingJSListener::Parse(const char* data,
+                                    size_t size,
+                                    LocalVector<Value>* messages) {
+  while (size > 0 || (header_filled_ == kHeaderSize && !message_)) {
+    if (header_filled_ < kHeaderSize) {
+      const size_t n = std::min(size, kHeaderSize - header_filled_);
+      memcpy(header_ + header_filled_, data, n);
+      header_filled_ += n;
+      data += n;
+      size -= n;
+      continue;
+    }
+    if (!message_) {
+      uint32_t length = 0;
+      for (size_t i = 0; i < kHeaderSize; i++)
+        length |= static_cast<uint32_t>(static_cast<uint8_t>(header_[i]))
+                  << (8 * i);
+      if (length > max_message_size_) return UV_EMSGSIZE;
+      message_length_ = length;
+    }
+    const size_t n = std::min(size, message_length_ - message_filled_);
+    if (!ReserveMessage(message_filled_ + n)) return UV_ENOMEM;
+    memcpy(static_cast<char*>(message_->Data()) + message_filled_, data, n);
+    message_filled_ += n;
+    data += n;
+    size -= n;
+    if (message_filled_ == message_length_) {
+      Local<Value> message;
+      if (!TakeMessage().ToLocal(&message)) return 0;
+      messages->push_back(message);
+    }
+  }
+  return 0;
+}
+
+
+void MessageFramingJSListener::OnStreamRead(ssize_t nread,
+                                            const uv_buf_t& buf) {
+  CHECK_NOT_NULL(stream_);
+  StreamBase* stream = static_cast<StreamBase*>(stream_);
+  Environment* env = stream->stream_env();
+  Isolate* isolate = env->isolate();
+  HandleScope handle_scope(isolate);
+  Context::Scope context_scope(env->context());
+
+  const bool is_direct =
+      message_ && buf.base == static_cast<char*>(message_->Data()) +
+                                  message_filled_;
+  std::unique_ptr<BackingStore> bs;
+  if (!is_direct && buf.base != nullptr && !env->is_shared_read_buffer(buf))
+    bs = env->release_managed_buffer(buf);
+
+  if (nread <= 0) {
+    if (nread < 0) PassReadErrorToPreviousListener(nread);
+    return;
+  }
+
+  LocalVector<Value> messages(isolate);
+  if (is_direct) {
+    CHECK_LE(static_cast<size_t>(nread),
+             message_->ByteLength() - message_filled_);
+    message_filled_ += nread;
+    Local<Value> message;
+    if (message_filled_ == message_length_ &&
+        TakeMessage().ToLocal(&message)) {
+      messages.push_back(message);
+    }
+  } else {
+    const int err = Parse(buf.base, nread, &messages);
+    if (err != 0) {
+      PassReadErrorToPreviousListener(err);
+      return;
+    }
+  }
+  if (messages.empty()) return;
+
+  Local<Value> argv[] = {
+      Array::New(isolate, messages.data(), messages.size()),
+  };
+  stream->GetAsyncWrap()->MakeCallback(
+      callback_.Get(isolate), arraysize(argv), argv);
+}
+
+
 void ReportWritesToJSStreamListener::OnStreamAfterReqFinished(
     StreamReq* req_wrap, int status) {
   StreamBase* stream = static_cast<StreamBase*>(stream_);
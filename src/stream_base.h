@@ -10,6 +10,8 @@
 
 #include "v8.h"
 
+#include <vector>
+
 namespace node {
 
 // Forward declarations
@@ -216,6 +218,49 @@ class CustomBufferJSListener : public ReportWritesToJSStreamListener {
 };
 
 
+// A listener that splits the data read into messages, each of which is
+// preceded by its length as a little-endian uint32. All messages completed
+// by a read are passed to the callback at once, as an array of Buffers; a
+// message that is split across reads is gathered in C++. Large messages are
+// read straight into the memory that ends up backing their Buffer. That
+// memory grows as the message arrives, so a length from the peer does not
+// make it allocate more than it has sent. Read errors, including messages
+// above the maximum size (UV_EMSGSIZE) and failed allocations (UV_ENOMEM),
+// are passed on to the previous listener.
+class MessageFramingJSListener : public ReportWritesToJSStreamListener {
+ public:
+  static constexpr size_t kHeaderSize = 4;
+  static constexpr size_t kDefaultMaxMessageSize = 16 * 1024 * 1024;
+
+  MessageFramingJSListener(Environment* env,
+                           v8::Local<v8::Function> callback,
+                           size_t max_message_size);
+
+  uv_buf_t OnStreamAlloc(size_t suggested_size) override;
+  void OnStreamRead(ssize_t nread, const uv_buf_t& buf) override;
+  void OnStreamDestroy() override { delete this; }
+
+ private:
+  // Consumes `data`, appending the messages it completes to `messages`.
+  // Returns 0, UV_EMSGSIZE or UV_ENOMEM.
+  int Parse(const char* data,
+            size_t size,
+            v8::LocalVector<v8::Value>* messages);
+  // Makes room for the first `size` bytes of the message being gathered.
+  bool ReserveMessage(size_t size);
+  v8::MaybeLocal<v8::Value> TakeMessage();
+
+  v8::Global<v8::Function> callback_;
+  const size_t max_message_size_;
+  char header_[kHeaderSize];
+  size_t header_filled_ = 0;
+  // The message being gathered, if its header has been read.
+  std::unique_ptr<v8::BackingStore> message_;
+  size_t message_length_ = 0;
+  size_t message_filled_ = 0;
+};
+
+
 // A generic stream, comparable to JS land’s `Duplex` streams.
 // A stream is always controlled through one `StreamListener` instance.
 class StreamResource {
@@ -280,6 +325,11 @@ class StreamResource {
   // transfer ownership back to the previous listener.
   void RemoveStreamListener(StreamListener* listener);
 
+  // Count bytes that were moved from or to the underlying resource without
+  // going through EmitRead() or a write, e.g. by sendfile() or splice().
+  void AddBytesRead(uint64_t count) { bytes_read_ += count; }
+  void AddBytesWritten(uint64_t count) { bytes_written_ += count; }
+
  protected:
   // Call the current listener's OnStreamAlloc() method.
   inline uv_buf_t EmitAlloc(size_t suggested_size);
@@ -325,6 +375,32 @@ class StreamBase : public StreamResource {
   virtual bool IsIPCPipe();
   virtual int GetFD();
 
+  // Writes made with writeHandles() start with a header of this many bytes:
+  // kHandlesFrameMarker, a reserved zero byte, the number of handles as a
+  // little-endian uint16 and the payload length as a little-endian uint32.
+  static constexpr size_t kHandlesFrameHeaderSize = 8;
+  static constexpr uint8_t kHandlesFrameMarker = 0x01;
+#ifndef _WIN32
+  // The most file descriptors the receiving end accepts from one message.
+  // libuv reads control messages into a 256-byte buffer (union uv__cmsg in
+  // deps/uv/src/unix/stream.c) and silently drops descriptors that do not
+  // fit. That is well below Linux's own limit of 253 (SCM_MAX_FD).
+  static constexpr size_t kMaxHandlesPerWrite =
+      (256 - CMSG_SPACE(0)) / sizeof(int);
+#else
+  // Windows cannot pass handles this way; see DoTrySendHandles().
+  static constexpr size_t kMaxHandlesPerWrite = 0;
+#endif
+
+  // Synchronously writes the start of `*bufs`, passing `fds` along with its
+  // first byte, and advances `*bufs` and `*count` past what was written like
+  // DoTryWrite() does. Returns UV_EAGAIN if nothing could be written right
+  // away, or not without overtaking queued writes, and UV_ENOSYS if the
+  // stream cannot pass more than one handle per write.
+  virtual int DoTrySendHandles(uv_buf_t** bufs,
+                               size_t* count,
+                               const std::vector<uv_os_fd_t>& fds);
+
   enum StreamBaseJSChecks { DONT_SKIP_NREAD_CHECKS, SKIP_NREAD_CHECKS };
 
   v8::MaybeLocal<v8::Value> CallJSOnreadMethod(
@@ -356,6 +432,10 @@ class StreamBase : public StreamResource {
   // write is too large to finish synchronously.
   // If the return value indicates a synchronous completion, no callback will
   // be invoked.
+  // When write coalescing is enabled, small writes are not attempted right
+  // away. They are reported as asynchronous and gathered until the end of the
+  // current loop iteration, or until enough data has accumulated, and are then
+  // written together; each one still completes through its own WriteWrap.
   StreamWriteResult Write(
       uv_buf_t* bufs,
       size_t count,
@@ -385,9 +465,12 @@ class StreamBase : public StreamResource {
   int Shutdown(const v8::FunctionCallbackInfo<v8::Value>& args);
   int Writev(const v8::FunctionCallbackInfo<v8::Value>& args);
   int WriteBuffer(const v8::FunctionCallbackInfo<v8::Value>& args);
+  int WriteHandles(const v8::FunctionCallbackInfo<v8::Value>& args);
   template <enum encoding enc>
   int WriteString(const v8::FunctionCallbackInfo<v8::Value>& args);
   int UseUserBuffer(const v8::FunctionCallbackInfo<v8::Value>& args);
+  int UseMessageFraming(const v8::FunctionCallbackInfo<v8::Value>& args);
+  int SetWriteCoalescing(const v8::FunctionCallbackInfo<v8::Value>& args);
 
   static void GetFD(const v8::FunctionCallbackInfo<v8::Value>& args);
   static void GetExternal(const v8::FunctionCallbackInfo<v8::Value>& args);
@@ -399,6 +482,17 @@ class StreamBase : public StreamResource {
       const v8::FunctionCallbackInfo<v8::Value>& args)>
   static void JSMethod(const v8::FunctionCallbackInfo<v8::Value>& args);
 
+  // Writes out everything gathered by write coalescing. Called automatically;
+  // exposed so that subclasses can flush before operations that must not be
+  // reordered with pending writes.
+  void FlushCoalescedWrites();
+  void set_write_coalescing(bool enable);
+  // Writes out the data of the writes gathered by write coalescing through
+  // DoTryWrite(), without completing them, for when the process is about to
+  // exit and their callbacks would never run. Returns 0, the first write
+  // error, or UV_EAGAIN if the stream stopped accepting data.
+  int WriteCoalescedDataForExit();
+
   // Internal, used only in StreamBase methods + env.cc.
   enum StreamBaseStateFields {
     kReadBytesOrError,
@@ -409,9 +503,36 @@ class StreamBase : public StreamResource {
   };
 
  private:
+  // Writes of at most this many bytes are coalesced.
+  static constexpr size_t kMaxCoalescedWriteSize = 16 * 1024;
+  // Coalesced writes are flushed early once this much data or this many
+  // buffers have been gathered.
+  static constexpr size_t kCoalescedFlushBytes = 64 * 1024;
+  static constexpr size_t kCoalescedFlushBuffers = 1024;
+
+  struct CoalescedWrite {
+    WriteWrap* wrap;
+    BaseObjectPtr<AsyncWrap> wrap_ptr;
+    // Index of the first buffer in coalesced_bufs_ and number of buffers.
+    size_t first;
+    size_t count;
+  };
+
   Environment* env_;
   EmitToJSStreamListener default_listener_;
 
+  bool coalesce_writes_ = false;
+  bool coalesced_flush_scheduled_ = false;
+  size_t coalesced_bytes_ = 0;
+  std::vector<CoalescedWrite> coalesced_writes_;
+  std::vector<uv_buf_t> coalesced_bufs_;
+
+  void QueueCoalescedWrite(WriteWrap* req_wrap,
+                           BaseObjectPtr<AsyncWrap> req_wrap_ptr,
+                           uv_buf_t* bufs,
+                           size_t count,
+                           size_t total_bytes);
+
   void SetWriteResult(const StreamWriteResult& res);
   static void AddAccessor(v8::Isolate* isolate,
                           v8::Local<v8::Signature> sig,
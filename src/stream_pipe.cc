@@ -1,11 +1,22 @@
 #include "stream_pipe.h"
 #include "stream_base-inl.h"
 #include "node_buffer.h"
+#include "node_file.h"
+#include "stream_wrap.h"
+#include "threadpoolwork-inl.h"
 #include "util-inl.h"
 
+#ifdef __linux__
+#include <fcntl.h>
+#include <sys/sendfile.h>
+#include <unistd.h>
+#endif
+
 namespace node {
 
+using v8::ArrayBuffer;
 using v8::BackingStore;
+using v8::BackingStoreInitializationMode;
 using v8::Context;
 using v8::Function;
 using v8::FunctionCallbackInfo;
@@ -32,10 +43,24 @@ StreamPipe::StreamPipe(StreamBase* source,
   sink->PushStreamListener(&writable_listener_);
 
   uses_wants_write_ = sink->HasWantsWrite();
+#ifdef __linux__
+  uses_sendfile_ =
+      source->GetAsyncWrap()->provider_type() ==
+          AsyncWrap::PROVIDER_FILEHANDLE &&
+      sink->GetAsyncWrap()->provider_type() == AsyncWrap::PROVIDER_TCPWRAP;
+  auto is_splicable = [](StreamBase* stream) {
+    AsyncWrap::ProviderType type = stream->GetAsyncWrap()->provider_type();
+    return type == AsyncWrap::PROVIDER_TCPWRAP ||
+           (type == AsyncWrap::PROVIDER_PIPEWRAP && !stream->IsIPCPipe());
+  };
+  uses_splice_ = is_splicable(source) && is_splicable(sink);
+#endif
 }
 
 StreamPipe::~StreamPipe() {
   Unpipe(true);
+  CloseSendfileFds();
+  CloseSpliceFds();
 }
 
 StreamBase* StreamPipe::source() {
@@ -61,6 +86,8 @@ void StreamPipe::Unpipe(bool is_in_deletion) {
   source()->RemoveStreamListener(&readable_listener_);
   if (pending_writes_ == 0)
     sink()->RemoveStreamListener(&writable_listener_);
+  if (!sendfile_in_flight_)
+    CloseSendfileFds();
 
   if (is_in_deletion) return;
 
@@ -109,6 +136,11 @@ uv_buf_t StreamPipe::ReadableListener::OnStreamAlloc(size_t suggested_size) {
   StreamPipe* pipe = ContainerOf(&StreamPipe::readable_listener_, this);
   size_t size = std::min(suggested_size, pipe->wanted_data_);
   CHECK_GT(size, 0);
+  if (pipe->uses_splice_ && pipe->SpliceChunk(size)) {
+    // An empty buffer makes libuv skip the read and report UV_ENOBUFS.
+    pipe->splice_pending_ = true;
+    return uv_buf_init(nullptr, 0);
+  }
   return pipe->env()->allocate_managed_buffer(size);
 }
 
@@ -116,6 +148,12 @@ void StreamPipe::ReadableListener::OnStreamRead(ssize_t nread,
                                                 const uv_buf_t& buf_) {
   StreamPipe* pipe = ContainerOf(&StreamPipe::readable_listener_, this);
   std::unique_ptr<BackingStore> bs = pipe->env()->release_managed_buffer(buf_);
+  if (nread == UV_ENOBUFS && pipe->splice_pending_) {
+    pipe->splice_pending_ = false;
+    nread = pipe->splice_result_;
+    if (nread == 0) return;
+    bs = std::move(pipe->splice_rest_);
+  }
   if (nread < 0) {
     // EOF or error; stop reading and pass the error to the previous listener
     // (which might end up in JS).
@@ -141,6 +179,13 @@ void StreamPipe::ReadableListener::OnStreamRead(ssize_t nread,
 void StreamPipe::ProcessData(size_t nread,
                              std::unique_ptr<BackingStore> bs) {
   CHECK(uses_wants_write_ || pending_writes_ == 0);
+  if (sendfile_blocked_) {
+    // Only write this one chunk, and go back to sendfile() once the write
+    // has completed.
+    sendfile_blocked_ = false;
+    is_reading_ = false;
+    source()->ReadStop();
+  }
   uv_buf_t buffer = uv_buf_init(static_cast<char*>(bs->Data()), nread);
   StreamWriteResult res = sink()->Write(&buffer, 1);
   pending_writes_++;
@@ -225,10 +270,239 @@ void StreamPipe::WritableListener::OnStreamWantsWrite(size_t suggested_size) {
   HandleScope handle_scope(pipe->env()->isolate());
   InternalCallbackScope callback_scope(pipe,
       InternalCallbackScope::kSkipTaskQueues);
+  if (pipe->uses_sendfile_ && !pipe->sendfile_blocked_) {
+    if (pipe->sendfile_in_flight_ || pipe->StartSendfile()) return;
+  }
   pipe->is_reading_ = true;
   pipe->source()->ReadStart();
 }
 
+#ifdef __linux__
+class StreamPipe::SendfileJob final : public ThreadPoolWork {
+ public:
+  SendfileJob(StreamPipe* pipe,
+              fs::FileHandle* file,
+              int64_t offset,
+              size_t length)
+      : ThreadPoolWork(
+            pipe->env(), "StreamPipe.sendfile", ThreadPoolWorkClass::kFs),
+        pipe_(pipe),
+        file_(file),
+        in_fd_(pipe->sendfile_in_fd_),
+        out_fd_(pipe->sendfile_out_fd_),
+        offset_(offset),
+        length_(length) {}
+
+  void DoThreadPoolWork() override {
+    // An offset of -1 means that the file is sent from its current position.
+    off_t offset = offset_;
+    ssize_t r;
+    do {
+      r = sendfile(out_fd_, in_fd_, offset_ >= 0 ? &offset : nullptr, length_);
+    } while (r == -1 && errno == EINTR);
+    result_ = r >= 0 ? r : uv_translate_sys_error(errno);
+  }
+
+  void AfterThreadPoolWork(int status) override {
+    HandleScope handle_scope(pipe_->env()->isolate());
+    std::unique_ptr<SendfileJob> self(this);
+    pipe_->AfterSendfile(file_.get(), status == 0 ? result_ : status);
+  }
+
+ private:
+  BaseObjectPtr<StreamPipe> pipe_;
+  BaseObjectPtr<fs::FileHandle> file_;
+  int in_fd_;
+  int out_fd_;
+  int64_t offset_;
+  size_t length_;
+  ssize_t result_ = 0;
+};
+
+// The most that a single sendfile() call is asked to send. The socket is
+// non-blocking, so the call returns early once its send buffer is full.
+constexpr int64_t kMaxSendfileChunk = 4 * 1024 * 1024;
+#endif  // __linux__
+
+bool StreamPipe::StartSendfile() {
+#ifdef __linux__
+  fs::FileHandle* file = static_cast<fs::FileHandle*>(source());
+  LibuvStreamWrap* socket = static_cast<LibuvStreamWrap*>(sink());
+  if (!file->IsAlive() || file->IsClosing()) return false;
+  if (socket->stream()->write_queue_size > 0) {
+    // Let writes that are already queued on the socket go out first.
+    sendfile_blocked_ = true;
+    return false;
+  }
+
+  if (sendfile_in_fd_ < 0) {
+    // Send between duplicates of the fds, so that closing the FileHandle or
+    // the socket while sendfile() runs cannot make it use another file that
+    // was opened with the same fd in the meantime.
+    sendfile_in_fd_ = dup(file->GetFD());
+    sendfile_out_fd_ = dup(socket->GetFD());
+    if (sendfile_in_fd_ < 0 || sendfile_out_fd_ < 0) {
+      CloseSendfileFds();
+      uses_sendfile_ = false;
+      return false;
+    }
+  }
+
+  int64_t length = file->read_length();
+  if (length == 0) {
+    readable_listener_.OnStreamRead(UV_EOF, uv_buf_init(nullptr, 0));
+    return true;
+  }
+  if (length < 0 || length > kMaxSendfileChunk) length = kMaxSendfileChunk;
+
+  pending_writes_++;
+  sendfile_in_flight_ = true;
+  auto job = std::make_unique<SendfileJob>(
+      this, file, file->read_offset(), static_cast<size_t>(length));
+  job.release()->ScheduleWork();
+  return true;
+#else
+  return false;
+#endif  // __linux__
+}
+
+void StreamPipe::AfterSendfile(fs::FileHandle* file, ssize_t result) {
+  sendfile_in_flight_ = false;
+  if (result > 0) {
+    file->AdvanceRead(result);
+    file->AddBytesRead(result);
+    if (!sink_destroyed_) sink()->AddBytesWritten(result);
+  }
+
+  if (sink_destroyed_) {
+    // OnStreamDestroy() has already reset pending_writes_.
+    CloseSendfileFds();
+    return;
+  }
+
+  InternalCallbackScope callback_scope(this,
+      InternalCallbackScope::kSkipTaskQueues);
+  if (is_closed_) {
+    CloseSendfileFds();
+  } else if (is_eof_) {
+    // The source was destroyed in the meantime. OnStreamAfterWrite() shuts
+    // down the sink.
+  } else if (result == UV_EAGAIN) {
+    sendfile_blocked_ = true;
+  } else if (result == UV_EINVAL || result == UV_ENOSYS) {
+    // The file cannot be sent with sendfile(), e.g. because it is a pipe.
+    uses_sendfile_ = false;
+    CloseSendfileFds();
+  } else if (result <= 0) {
+    // Handle EOF and errors like a read from the source that failed.
+    pending_writes_--;
+    readable_listener_.OnStreamRead(
+        result == 0 ? static_cast<int>(UV_EOF) : result,
+        uv_buf_init(nullptr, 0));
+    return;
+  }
+  writable_listener_.OnStreamAfterWrite(nullptr, 0);
+}
+
+void StreamPipe::CloseSendfileFds() {
+#ifdef __linux__
+  if (sendfile_in_fd_ >= 0) close(sendfile_in_fd_);
+  if (sendfile_out_fd_ >= 0) close(sendfile_out_fd_);
+#endif  // __linux__
+  sendfile_in_fd_ = -1;
+  sendfile_out_fd_ = -1;
+}
+
+#ifdef __linux__
+// The most rounds of splicing done for one readiness notification, like the
+// reads libuv makes for one.
+constexpr int kMaxSpliceRounds = 32;
+#endif  // __linux__
+
+bool StreamPipe::SpliceChunk(size_t size) {
+#ifdef __linux__
+  LibuvStreamWrap* from = static_cast<LibuvStreamWrap*>(source());
+  LibuvStreamWrap* to = static_cast<LibuvStreamWrap*>(sink());
+  // Let writes that are already queued on the sink go out first.
+  if (to->stream()->write_queue_size > 0) return false;
+  if (splice_fds_[0] < 0 && pipe2(splice_fds_, O_NONBLOCK | O_CLOEXEC) != 0) {
+    uses_splice_ = false;
+    return false;
+  }
+
+  const int in_fd = from->GetFD();
+  const int out_fd = to->GetFD();
+  constexpr unsigned int kFlags = SPLICE_F_MOVE | SPLICE_F_NONBLOCK;
+  for (int round = 0; round < kMaxSpliceRounds; round++) {
+    ssize_t nread;
+    do {
+      nread = splice(in_fd, nullptr, splice_fds_[1], nullptr, size, kFlags);
+    } while (nread == -1 && errno == EINTR);
+    if (nread == -1 && errno == EINVAL && round == 0) {
+      // The source cannot be spliced from, e.g. because of a socket type
+      // that does not support it.
+      uses_splice_ = false;
+      CloseSpliceFds();
+      return false;
+    }
+    if (nread == -1) {
+      splice_result_ =
+          errno == EAGAIN ? 0 : uv_translate_sys_error(errno);
+      return true;
+    }
+    if (nread == 0) {
+      splice_result_ = UV_EOF;
+      return true;
+    }
+    from->AddBytesRead(nread);
+
+    size_t rest = nread;
+    while (rest > 0) {
+      ssize_t nwritten;
+      do {
+        nwritten =
+            splice(splice_fds_[0], nullptr, out_fd, nullptr, rest, kFlags);
+      } while (nwritten == -1 && errno == EINTR);
+      if (nwritten == -1 && errno == EINVAL) uses_splice_ = false;
+      if (nwritten <= 0) break;
+      to->AddBytesWritten(nwritten);
+      rest -= nwritten;
+    }
+    if (rest > 0) {
+      // The sink is full, or failed. Move what is left in the pipe into a
+      // Buffer and write it the regular way, which waits for the sink to
+      // drain or reports the error.
+      splice_rest_ = ArrayBuffer::NewBackingStore(
+          env()->isolate(),
+          rest,
+          BackingStoreInitializationMode::kUninitialized);
+      ssize_t r;
+      do {
+        r = read(splice_fds_[0], splice_rest_->Data(), rest);
+      } while (r == -1 && errno == EINTR);
+      CHECK_EQ(r, static_cast<ssize_t>(rest));
+      splice_result_ = rest;
+      return true;
+    }
+    // The source has been drained.
+    if (static_cast<size_t>(nread) < size) break;
+  }
+  splice_result_ = 0;
+  return true;
+#else
+  return false;
+#endif  // __linux__
+}
+
+void StreamPipe::CloseSpliceFds() {
+#ifdef __linux__
+  if (splice_fds_[0] >= 0) close(splice_fds_[0]);
+  if (splice_fds_[1] >= 0) close(splice_fds_[1]);
+#endif  // __linux__
+  splice_fds_[0] = -1;
+  splice_fds_[1] = -1;
+}
+
 uv_buf_t StreamPipe::WritableListener::OnStreamAlloc(size_t suggested_size) {
   CHECK_NOT_NULL(previous_listener_);
   return previous_listener_->OnStreamAlloc(suggested_size);
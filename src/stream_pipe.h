@@ -7,6 +7,10 @@
 
 namespace node {
 
+namespace fs {
+class FileHandle;
+}  // namespace fs
+
 class StreamPipe : public AsyncWrap {
  public:
   ~StreamPipe() override;
@@ -40,6 +44,33 @@ class StreamPipe : public AsyncWrap {
   bool source_destroyed_ = false;
   bool uses_wants_write_ = false;
 
+  // Set when the source is a FileHandle and the sink is a TCP socket. Data is
+  // then moved by sendfile(2) calls on the threadpool instead of being read
+  // into and written from Buffers. Only used on Linux.
+  bool uses_sendfile_ = false;
+  bool sendfile_in_flight_ = false;
+  // Set when sendfile() could not write because the socket was full. The
+  // next chunk is then read and written the regular way, and sendfile() is
+  // resumed once that write has completed.
+  bool sendfile_blocked_ = false;
+  int sendfile_in_fd_ = -1;
+  int sendfile_out_fd_ = -1;
+
+  // Set when both ends are TCP sockets or non-IPC pipes. Data is then moved
+  // with splice(2) through a pipe, without being copied to user space. The
+  // source's alloc callback serves as the signal that it is readable; it
+  // does the splicing and tells libuv to skip the read. Whatever the sink
+  // cannot take right away is written the regular way, which also provides
+  // the backpressure. Only used on Linux.
+  bool uses_splice_ = false;
+  // Set when OnStreamAlloc() has spliced, for OnStreamRead() to handle its
+  // outcome in splice_result_: 0 if everything was forwarded, the number of
+  // bytes in splice_rest_ that the sink did not take, or a libuv error code.
+  bool splice_pending_ = false;
+  ssize_t splice_result_ = 0;
+  std::unique_ptr<v8::BackingStore> splice_rest_;
+  int splice_fds_[2] = {-1, -1};
+
   // Set a default value so that when we’re coming from Start(), we know
   // that we don’t want to read just yet.
   // This will likely need to be changed when supporting streams without
@@ -48,6 +79,16 @@ class StreamPipe : public AsyncWrap {
 
   void ProcessData(size_t nread, std::unique_ptr<v8::BackingStore> bs);
 
+  class SendfileJob;
+  // Returns false if the next chunk has to be read from the source instead.
+  bool StartSendfile();
+  void AfterSendfile(fs::FileHandle* file, ssize_t result);
+  void CloseSendfileFds();
+
+  // Returns false if the next chunk has to be read from the source instead.
+  bool SpliceChunk(size_t size);
+  void CloseSpliceFds();
+
   class ReadableListener : public StreamListener {
    public:
     uv_buf_t OnStreamAlloc(size_t suggested_size) override;
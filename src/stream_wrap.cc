@@ -33,13 +33,20 @@
 #include "udp_wrap.h"
 #include "util-inl.h"
 
+#include <algorithm>
+#include <cerrno>
 #include <cstring>  // memcpy()
 #include <climits>  // INT_MAX
 
+#ifndef _WIN32
+#include <sys/socket.h>
+#endif
+
 
 namespace node {
 
 using errors::TryCatchScope;
+using v8::Array;
 using v8::Context;
 using v8::DontDelete;
 using v8::EscapableHandleScope;
@@ -49,6 +56,7 @@ using v8::HandleScope;
 using v8::Isolate;
 using v8::JustVoid;
 using v8::Local;
+using v8::LocalVector;
 using v8::Maybe;
 using v8::MaybeLocal;
 using v8::Nothing;
@@ -104,6 +112,8 @@ void LibuvStreamWrap::Initialize(Local<Object> target,
   NODE_DEFINE_CONSTANT(target, kArrayBufferOffset);
   NODE_DEFINE_CONSTANT(target, kBytesWritten);
   NODE_DEFINE_CONSTANT(target, kLastWriteWasAsync);
+  NODE_DEFINE_CONSTANT(target, kHandlesFrameHeaderSize);
+  NODE_DEFINE_CONSTANT(target, kMaxHandlesPerWrite);
   target
       ->Set(context,
             FIXED_ONE_BYTE_STRING(isolate, "streamBaseState"),
@@ -224,7 +234,29 @@ void LibuvStreamWrap::OnUvAlloc(size_t suggested_size, uv_buf_t* buf) {
   HandleScope scope(env()->isolate());
   Context::Scope context_scope(env()->context());
 
-  *buf = EmitAlloc(suggested_size);
+  // libuv always suggests the same size; use the one learned from earlier
+  // reads on this stream instead.
+  *buf = EmitAlloc(read_buffer_size_);
+}
+
+void LibuvStreamWrap::AdaptReadBufferSize(size_t nread, size_t buflen) {
+  // Only adapt for reads into buffers of the size we asked for; listeners
+  // are free to hand out buffers of any other size.
+  if (buflen != read_buffer_size_) return;
+
+  if (nread == buflen) {
+    small_reads_ = 0;
+    read_buffer_size_ = std::min(read_buffer_size_ * 2, kMaxReadBufferSize);
+  } else if (nread <= buflen / 4) {
+    // Require a couple of small reads in a row so that a single short read
+    // at the end of a bulk transfer does not shrink the buffer.
+    if (++small_reads_ >= 2) {
+      small_reads_ = 0;
+      read_buffer_size_ = std::max(read_buffer_size_ / 2, kMinReadBufferSize);
+    }
+  } else {
+    small_reads_ = 0;
+  }
 }
 
 template <class WrapType>
@@ -251,14 +283,25 @@ static MaybeLocal<Object> AcceptHandle(Environment* env,
   return scope.Escape(wrap_obj);
 }
 
+static MaybeLocal<Object> AcceptPendingHandle(Environment* env,
+                                              LibuvStreamWrap* parent) {
+  uv_pipe_t* pipe = reinterpret_cast<uv_pipe_t*>(parent->stream());
+  uv_handle_type type = uv_pipe_pending_type(pipe);
+  if (type == UV_TCP) return AcceptHandle<TCPWrap>(env, parent);
+  if (type == UV_NAMED_PIPE) return AcceptHandle<PipeWrap>(env, parent);
+  if (type == UV_UDP) return AcceptHandle<UDPWrap>(env, parent);
+  CHECK_EQ(type, UV_UNKNOWN_HANDLE);
+  return MaybeLocal<Object>();
+}
+
 Maybe<void> LibuvStreamWrap::OnUvRead(ssize_t nread, const uv_buf_t* buf) {
   HandleScope scope(env()->isolate());
   Context::Scope context_scope(env()->context());
-  uv_handle_type type = UV_UNKNOWN_HANDLE;
+  int pending_count = 0;
 
-  if (is_named_pipe_ipc() &&
-      uv_pipe_pending_count(reinterpret_cast<uv_pipe_t*>(stream())) > 0) {
-    type = uv_pipe_pending_type(reinterpret_cast<uv_pipe_t*>(stream()));
+  if (is_named_pipe_ipc()) {
+    pending_count =
+        uv_pipe_pending_count(reinterpret_cast<uv_pipe_t*>(stream()));
   }
 
   // We should not be getting this callback if someone has already called
@@ -266,26 +309,43 @@ Maybe<void> LibuvStreamWrap::OnUvRead(ssize_t nread, const uv_buf_t* buf) {
   CHECK_EQ(persistent().IsEmpty(), false);
 
   if (nread > 0) {
-    MaybeLocal<Object> pending_obj;
-
-    if (type == UV_TCP) {
-      pending_obj = AcceptHandle<TCPWrap>(env(), this);
-    } else if (type == UV_NAMED_PIPE) {
-      pending_obj = AcceptHandle<PipeWrap>(env(), this);
-    } else if (type == UV_UDP) {
-      pending_obj = AcceptHandle<UDPWrap>(env(), this);
-    } else {
-      CHECK_EQ(type, UV_UNKNOWN_HANDLE);
-    }
+    AdaptReadBufferSize(static_cast<size_t>(nread), buf->len);
+  }
 
-    Local<Object> local_pending_obj;
-    if (type != UV_UNKNOWN_HANDLE &&
-        (!pending_obj.ToLocal(&local_pending_obj) ||
-         object()
-             ->Set(env()->context(),
-                   env()->pending_handle_string(),
-                   local_pending_obj)
-             .IsNothing())) {
+  if (nread > 0 && pending_count == 1) {
+    Local<Object> pending_obj;
+    if (!AcceptPendingHandle(env(), this).ToLocal(&pending_obj) ||
+        object()
+            ->Set(env()->context(),
+                  env()->pending_handle_string(),
+                  pending_obj)
+            .IsNothing()) {
+      return Nothing<void>();
+    }
+  } else if (nread > 0 && pending_count > 1) {
+    // Handles sent with writeHandles() all arrive with the first byte of
+    // their message. Besides the first one as `pendingHandle`, hand all of
+    // them over as `pendingHandles`, in the order in which they were sent.
+    LocalVector<Value> pending(env()->isolate());
+    pending.reserve(pending_count);
+    for (int i = 0; i < pending_count; i++) {
+      Local<Object> pending_obj;
+      if (!AcceptPendingHandle(env(), this).ToLocal(&pending_obj))
+        return Nothing<void>();
+      pending.push_back(pending_obj);
+    }
+    Local<Array> pending_array =
+        Array::New(env()->isolate(), pending.data(), pending.size());
+    if (object()
+            ->Set(env()->context(),
+                  env()->pending_handle_string(),
+                  pending[0])
+            .IsNothing() ||
+        object()
+            ->Set(env()->context(),
+                  env()->pending_handles_string(),
+                  pending_array)
+            .IsNothing()) {
       return Nothing<void>();
     }
   }
@@ -389,6 +449,76 @@ int LibuvStreamWrap::DoTryWrite(uv_buf_t** bufs, size_t* count) {
 }
 
 
+int LibuvStreamWrap::DoTrySendHandles(uv_buf_t** bufs,
+                                      size_t* count,
+                                      const std::vector<uv_os_fd_t>& fds) {
+#ifdef _WIN32
+  return UV_ENOSYS;
+#else
+  // libuv writes queued data before anything else, so the handles cannot be
+  // sent by hand while some of it is left.
+  if (!is_named_pipe_ipc() || stream()->write_queue_size != 0)
+    return UV_EAGAIN;
+  if (fds.empty() || fds.size() > kMaxHandlesPerWrite) return UV_EINVAL;
+
+  uv_os_fd_t fd;
+  int err = uv_fileno(reinterpret_cast<uv_handle_t*>(stream()), &fd);
+  if (err != 0) return err;
+
+  MaybeStackBuffer<struct iovec, 16> iov(*count);
+  for (size_t i = 0; i < *count; i++) {
+    iov[i].iov_base = (*bufs)[i].base;
+    iov[i].iov_len = (*bufs)[i].len;
+  }
+  const size_t fds_size = fds.size() * sizeof(int);
+  MaybeStackBuffer<char, CMSG_SPACE(16 * sizeof(int))> control(
+      CMSG_SPACE(fds_size));
+  memset(*control, 0, control.length());
+
+  struct msghdr msg;
+  memset(&msg, 0, sizeof(msg));
+  msg.msg_iov = *iov;
+  msg.msg_iovlen = *count;
+  msg.msg_control = *control;
+  msg.msg_controllen = CMSG_SPACE(fds_size);
+  struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+  cmsg->cmsg_level = SOL_SOCKET;
+  cmsg->cmsg_type = SCM_RIGHTS;
+  cmsg->cmsg_len = CMSG_LEN(fds_size);
+  memcpy(CMSG_DATA(cmsg), fds.data(), fds_size);
+
+  int flags = 0;
+#ifdef MSG_NOSIGNAL
+  flags |= MSG_NOSIGNAL;
+#endif
+  ssize_t written;
+  do {
+    written = sendmsg(fd, &msg, flags);
+  } while (written == -1 && errno == EINTR);
+  if (written == -1) {
+    if (errno == EAGAIN || errno == EWOULDBLOCK) return UV_EAGAIN;
+    return uv_translate_sys_error(errno);
+  }
+
+  // Slice off the buffers, as DoTryWrite() does.
+  uv_buf_t* vbufs = *bufs;
+  size_t vcount = *count;
+  size_t rest = static_cast<size_t>(written);
+  for (; vcount > 0; vbufs++, vcount--) {
+    if (vbufs[0].len > rest) {
+      vbufs[0].base += rest;
+      vbufs[0].len -= rest;
+      break;
+    }
+    rest -= vbufs[0].len;
+  }
+  *bufs = vbufs;
+  *count = vcount;
+  return 0;
+#endif  // _WIN32
+}
+
+
 int LibuvStreamWrap::DoWrite(WriteWrap* req_wrap,
                              uv_buf_t* bufs,
                              size_t count,
@@ -53,6 +53,9 @@ class LibuvStreamWrap : public HandleWrap, public StreamBase {
   int DoShutdown(ShutdownWrap* req_wrap) override;
   int DoTryWrite(uv_buf_t** bufs, size_t* count) override;
   inline bool HasDoTryWrite() const override { return true; }
+  int DoTrySendHandles(uv_buf_t** bufs,
+                       size_t* count,
+                       const std::vector<uv_os_fd_t>& fds) override;
   int DoWrite(WriteWrap* w,
               uv_buf_t* bufs,
               size_t count,
@@ -108,11 +111,22 @@ class LibuvStreamWrap : public HandleWrap, public StreamBase {
   void OnUvAlloc(size_t suggested_size, uv_buf_t* buf);
   v8::Maybe<void> OnUvRead(ssize_t nread, const uv_buf_t* buf);
 
+  // Adjusts read_buffer_size_ after a read of nread bytes into a buffer of
+  // buflen bytes: streams that keep filling their buffer get larger ones,
+  // streams that keep reading only a little get smaller ones.
+  void AdaptReadBufferSize(size_t nread, size_t buflen);
+
   static void AfterUvWrite(uv_write_t* req, int status);
   static void AfterUvShutdown(uv_shutdown_t* req, int status);
 
   uv_stream_t* const stream_;
 
+  static constexpr size_t kMinReadBufferSize = 4 * 1024;
+  static constexpr size_t kInitialReadBufferSize = 64 * 1024;
+  static constexpr size_t kMaxReadBufferSize = 256 * 1024;
+  size_t read_buffer_size_ = kInitialReadBufferSize;
+  uint8_t small_reads_ = 0;
+
 #ifdef _WIN32
   // We don't always have an FD that we could look up on the stream_
   // object itself on Windows. However, for some cases, we open handles
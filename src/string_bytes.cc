@@ -34,6 +34,12 @@
 
 #include <algorithm>
 
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
 // When creating strings >= this length v8's gc spins up and consumes
 // most of the execution time. For these cases it's more performant to
 // use external string resources.
@@ -194,8 +200,207 @@ MaybeLocal<Value> ExternTwoByteString::NewSimpleFromCopy(Isolate* isolate,
   return str;
 }
 
+// Hex kernels. Each returns the number of input bytes (encode) or output
+// bytes (decode) it handled; the caller finishes the remainder with the
+// scalar nbytes implementation, which also takes care of invalid input.
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define NODE_HEX_X86_SIMD 1
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#define NODE_HEX_NEON 1
+#endif
+
+#if NODE_HEX_X86_SIMD
+__attribute__((target("ssse3"))) size_t HexEncodeSSSE3(const uint8_t* src,
+                                                       size_t slen,
+                                                       char* dst) {
+  const __m128i table = _mm_setr_epi8('0', '1', '2', '3', '4', '5', '6', '7',
+                                      '8', '9', 'a', 'b', 'c', 'd', 'e', 'f');
+  const __m128i mask = _mm_set1_epi8(0x0f);
+  size_t i = 0;
+  for (; i + 16 <= slen; i += 16) {
+    __m128i in = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+    __m128i hi = _mm_shuffle_epi8(
+        table, _mm_and_si128(_mm_srli_epi16(in, 4), mask));
+    __m128i lo = _mm_shuffle_epi8(table, _mm_and_si128(in, mask));
+    __m128i* out = reinterpret_cast<__m128i*>(dst + i * 2);
+    _mm_storeu_si128(out, _mm_unpacklo_epi8(hi, lo));
+    _mm_storeu_si128(out + 1, _mm_unpackhi_epi8(hi, lo));
+  }
+  return i;
+}
+
+__attribute__((target("avx2"))) size_t HexEncodeAVX2(const uint8_t* src,
+                                                     size_t slen,
+                                                     char* dst) {
+  const __m256i table =
+      _mm256_setr_epi8('0', '1', '2', '3', '4', '5', '6', '7',
+                       '8', '9', 'a', 'b', 'c', 'd', 'e', 'f',
+                       '0', '1', '2', '3', '4', '5', '6', '7',
+                       '8', '9', 'a', 'b', 'c', 'd', 'e', 'f');
+  const __m256i mask = _mm256_set1_epi8(0x0f);
+  size_t i = 0;
+  for (; i + 32 <= slen; i += 32) {
+    __m256i in =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+    __m256i hi = _mm256_shuffle_epi8(
+        table, _mm256_and_si256(_mm256_srli_epi16(in, 4), mask));
+    __m256i lo = _mm256_shuffle_epi8(table, _mm256_and_si256(in, mask));
+    // unpack works per 128-bit lane, so the halves need to be reordered.
+    __m256i a = _mm256_unpacklo_epi8(hi, lo);
+    __m256i b = _mm256_unpackhi_epi8(hi, lo);
+    __m256i* out = reinterpret_cast<__m256i*>(dst + i * 2);
+    _mm256_storeu_si256(out, _mm256_permute2x128_si256(a, b, 0x20));
+    _mm256_storeu_si256(out + 1, _mm256_permute2x128_si256(a, b, 0x31));
+  }
+  return i + HexEncodeSSSE3(src + i, slen - i, dst + i * 2);
+}
+
+// Converts 16 hex digits into their nibble values. Returns false if any of
+// them is not a hex digit.
+__attribute__((target("ssse3"))) inline bool HexNibblesSSSE3(__m128i in,
+                                                             __m128i* out) {
+  __m128i digit = _mm_sub_epi8(in, _mm_set1_epi8('0'));
+  __m128i alpha = _mm_sub_epi8(_mm_or_si128(in, _mm_set1_epi8(0x20)),
+                               _mm_set1_epi8('a'));
+  __m128i is_digit =
+      _mm_cmpeq_epi8(_mm_min_epu8(digit, _mm_set1_epi8(9)), digit);
+  __m128i is_alpha =
+      _mm_cmpeq_epi8(_mm_min_epu8(alpha, _mm_set1_epi8(5)), alpha);
+  if (_mm_movemask_epi8(_mm_or_si128(is_digit, is_alpha)) != 0xffff) {
+    return false;
+  }
+  alpha = _mm_add_epi8(alpha, _mm_set1_epi8(10));
+  *out = _mm_or_si128(_mm_and_si128(is_digit, digit),
+                      _mm_andnot_si128(is_digit, alpha));
+  return true;
+}
+
+__attribute__((target("ssse3"))) size_t HexDecodeSSSE3(uint8_t* buf,
+                                                       size_t len,
+                                                       const char* src) {
+  // Each pair of nibbles becomes (hi << 4) | lo.
+  const __m128i weights = _mm_set1_epi16(0x0110);
+  size_t i = 0;
+  for (; i + 16 <= len; i += 16) {
+    const __m128i* in = reinterpret_cast<const __m128i*>(src + i * 2);
+    __m128i a, b;
+    if (!HexNibblesSSSE3(_mm_loadu_si128(in), &a) ||
+        !HexNibblesSSSE3(_mm_loadu_si128(in + 1), &b)) {
+      break;
+    }
+    __m128i out = _mm_packus_epi16(_mm_maddubs_epi16(a, weights),
+                                   _mm_maddubs_epi16(b, weights));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(buf + i), out);
+  }
+  return i;
+}
+
+enum class HexSimdLevel { kNone, kSSSE3, kAVX2 };
+
+HexSimdLevel GetHexSimdLevel() {
+  static const HexSimdLevel level = []() {
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return HexSimdLevel::kAVX2;
+    if (__builtin_cpu_supports("ssse3")) return HexSimdLevel::kSSSE3;
+    return HexSimdLevel::kNone;
+  }();
+  return level;
+}
+
+size_t HexEncodeSimd(const uint8_t* src, size_t slen, char* dst) {
+  switch (GetHexSimdLevel()) {
+    case HexSimdLevel::kAVX2:
+      return HexEncodeAVX2(src, slen, dst);
+    case HexSimdLevel::kSSSE3:
+      return HexEncodeSSSE3(src, slen, dst);
+    default:
+      return 0;
+  }
+}
+
+size_t HexDecodeSimd(uint8_t* buf, size_t len, const char* src) {
+  // Decoding is bound by validation rather than shuffling, so the 128-bit
+  // kernel is used for AVX2 machines as well.
+  if (GetHexSimdLevel() == HexSimdLevel::kNone) return 0;
+  return HexDecodeSSSE3(buf, len, src);
+}
+#elif NODE_HEX_NEON
+size_t HexEncodeSimd(const uint8_t* src, size_t slen, char* dst) {
+  static const uint8_t kTable[16] = {'0', '1', '2', '3', '4', '5', '6', '7',
+                                     '8', '9', 'a', 'b', 'c', 'd', 'e', 'f'};
+  const uint8x16_t table = vld1q_u8(kTable);
+  const uint8x16_t mask = vdupq_n_u8(0x0f);
+  size_t i = 0;
+  for (; i + 16 <= slen; i += 16) {
+    uint8x16_t in = vld1q_u8(src + i);
+    uint8x16x2_t out;
+    out.val[0] = vqtbl1q_u8(table, vshrq_n_u8(in, 4));
+    out.val[1] = vqtbl1q_u8(table, vandq_u8(in, mask));
+    vst2q_u8(reinterpret_cast<uint8_t*>(dst + i * 2), out);
+  }
+  return i;
+}
+
+// Converts 16 hex digits into their nibble values. Returns false if any of
+// them is not a hex digit.
+inline bool HexNibblesNeon(uint8x16_t in, uint8x16_t* out) {
+  uint8x16_t digit = vsubq_u8(in, vdupq_n_u8('0'));
+  uint8x16_t alpha =
+      vsubq_u8(vorrq_u8(in, vdupq_n_u8(0x20)), vdupq_n_u8('a'));
+  uint8x16_t is_digit = vcleq_u8(digit, vdupq_n_u8(9));
+  uint8x16_t is_alpha = vcleq_u8(alpha, vdupq_n_u8(5));
+  if (vminvq_u8(vorrq_u8(is_digit, is_alpha)) != 0xff) return false;
+  *out = vbslq_u8(is_digit, digit, vaddq_u8(alpha, vdupq_n_u8(10)));
+  return true;
+}
+
+size_t HexDecodeSimd(uint8_t* buf, size_t len, const char* src) {
+  size_t i = 0;
+  for (; i + 16 <= len; i += 16) {
+    uint8x16x2_t in = vld2q_u8(reinterpret_cast<const uint8_t*>(src + i * 2));
+    uint8x16_t hi, lo;
+    if (!HexNibblesNeon(in.val[0], &hi) || !HexNibblesNeon(in.val[1], &lo)) {
+      break;
+    }
+    vst1q_u8(buf + i, vorrq_u8(vshlq_n_u8(hi, 4), lo));
+  }
+  return i;
+}
+#else
+size_t HexEncodeSimd(const uint8_t* src, size_t slen, char* dst) {
+  return 0;
+}
+
+size_t HexDecodeSimd(uint8_t* buf, size_t len, const char* src) {
+  return 0;
+}
+#endif
+
 }  // anonymous namespace
 
+size_t StringBytes::HexEncode(const char* src,
+                              size_t slen,
+                              char* dst,
+                              size_t dlen) {
+  CHECK_GE(dlen, slen * 2);
+  size_t done =
+      HexEncodeSimd(reinterpret_cast<const uint8_t*>(src), slen, dst);
+  nbytes::HexEncode(src + done, slen - done, dst + done * 2, dlen - done * 2);
+  return slen * 2;
+}
+
+size_t StringBytes::HexDecode(char* buf,
+                              size_t buflen,
+                              const char* src,
+                              size_t srclen) {
+  size_t len = std::min(buflen, srclen / 2);
+  size_t done = HexDecodeSimd(reinterpret_cast<uint8_t*>(buf), len, src);
+  return done + nbytes::HexDecode(buf + done,
+                                  buflen - done,
+                                  src + done * 2,
+                                  srclen - done * 2);
+}
+
 static size_t keep_buflen_in_range(size_t len) {
   if (len > static_cast<size_t>(std::numeric_limits<int>::max())) {
     return static_cast<size_t>(std::numeric_limits<int>::max());
@@ -360,11 +565,10 @@ size_t StringBytes::Write(Isolate* isolate,
     }
     case HEX:
       if (input_view.is_one_byte()) {
-        nbytes =
-            nbytes::HexDecode(buf,
-                              buflen,
-                              reinterpret_cast<const char*>(input_view.data8()),
-                              input_view.length());
+        nbytes = HexDecode(buf,
+                           buflen,
+                           reinterpret_cast<const char*>(input_view.data8()),
+                           input_view.length());
       } else {
         String::Value value(isolate, str);
         nbytes = nbytes::HexDecode(buf, buflen, *value, value.length());
@@ -582,7 +786,7 @@ MaybeLocal<Value> StringBytes::Encode(Isolate* isolate,
         isolate->ThrowException(node::ERR_MEMORY_ALLOCATION_FAILED(isolate));
         return MaybeLocal<Value>();
       }
-      size_t written = nbytes::HexEncode(buf, buflen, dst, dlen);
+      size_t written = HexEncode(buf, buflen, dst, dlen);
       CHECK_EQ(written, dlen);
 
       return ExternOneByteString::New(isolate, dst, dlen);
@@ -95,6 +95,18 @@ class StringBytes {
                                           const char* buf,
                                           enum encoding encoding);
 
+  // Hex codecs used by Encode() and Write(). They use SIMD kernels where the
+  // CPU supports them and otherwise behave exactly like the nbytes versions:
+  // decoding stops at the first pair that is not valid hex.
+  static size_t HexEncode(const char* src,
+                          size_t slen,
+                          char* dst,
+                          size_t dlen);
+  static size_t HexDecode(char* buf,
+                          size_t buflen,
+                          const char* src,
+                          size_t srclen);
+
  private:
   static size_t WriteUCS2(v8::Isolate* isolate,
                           char* buf,
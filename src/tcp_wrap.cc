@@ -25,6 +25,7 @@
 #include "connection_wrap.h"
 #include "env-inl.h"
 #include "handle_wrap.h"
+#include "histogram-inl.h"
 #include "node_buffer.h"
 #include "node_external_reference.h"
 #include "node_internals.h"
@@ -35,6 +36,12 @@
 
 #include <cstdlib>
 
+#ifdef __linux__
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#endif
+
 
 namespace node {
 
@@ -93,6 +100,7 @@ void TCPWrap::Initialize(Local<Object> target,
   SetProtoMethod(isolate, t, "open", Open);
   SetProtoMethod(isolate, t, "bind", Bind);
   SetProtoMethod(isolate, t, "listen", Listen);
+  SetProtoMethod(isolate, t, "setAcceptBatchSize", SetAcceptBatchSize);
   SetProtoMethod(isolate, t, "connect", Connect);
   SetProtoMethod(isolate, t, "bind6", Bind6);
   SetProtoMethod(isolate, t, "connect6", Connect6);
@@ -106,6 +114,8 @@ void TCPWrap::Initialize(Local<Object> target,
                  GetSockOrPeerName<TCPWrap, uv_tcp_getpeername>);
   SetProtoMethod(isolate, t, "setNoDelay", SetNoDelay);
   SetProtoMethod(isolate, t, "setKeepAlive", SetKeepAlive);
+  SetProtoMethod(isolate, t, "getTCPInfo", GetTCPInfo);
+  SetProtoMethod(isolate, t, "createRTTHistogram", CreateRTTHistogram);
   SetProtoMethod(isolate, t, "reset", Reset);
 
 #ifdef _WIN32
@@ -127,6 +137,19 @@ void TCPWrap::Initialize(Local<Object> target,
   NODE_DEFINE_CONSTANT(constants, SERVER);
   NODE_DEFINE_CONSTANT(constants, UV_TCP_IPV6ONLY);
   NODE_DEFINE_CONSTANT(constants, UV_TCP_REUSEPORT);
+  NODE_DEFINE_CONSTANT(constants, kTCPInfoState);
+  NODE_DEFINE_CONSTANT(constants, kTCPInfoRetransmits);
+  NODE_DEFINE_CONSTANT(constants, kTCPInfoRtt);
+  NODE_DEFINE_CONSTANT(constants, kTCPInfoRttVar);
+  NODE_DEFINE_CONSTANT(constants, kTCPInfoSndCwnd);
+  NODE_DEFINE_CONSTANT(constants, kTCPInfoSndSsthresh);
+  NODE_DEFINE_CONSTANT(constants, kTCPInfoSndMss);
+  NODE_DEFINE_CONSTANT(constants, kTCPInfoRcvMss);
+  NODE_DEFINE_CONSTANT(constants, kTCPInfoUnacked);
+  NODE_DEFINE_CONSTANT(constants, kTCPInfoLost);
+  NODE_DEFINE_CONSTANT(constants, kTCPInfoTotalRetrans);
+  NODE_DEFINE_CONSTANT(constants, kTCPInfoPmtu);
+  NODE_DEFINE_CONSTANT(constants, kTCPInfoFieldsCount);
   target->Set(context,
               env->constants_string(),
               constants).Check();
@@ -137,6 +160,7 @@ void TCPWrap::RegisterExternalReferences(ExternalReferenceRegistry* registry) {
   registry->Register(Open);
   registry->Register(Bind);
   registry->Register(Listen);
+  registry->Register(SetAcceptBatchSize);
   registry->Register(Connect);
   registry->Register(Bind6);
   registry->Register(Connect6);
@@ -145,6 +169,8 @@ void TCPWrap::RegisterExternalReferences(ExternalReferenceRegistry* registry) {
   registry->Register(GetSockOrPeerName<TCPWrap, uv_tcp_getpeername>);
   registry->Register(SetNoDelay);
   registry->Register(SetKeepAlive);
+  registry->Register(GetTCPInfo);
+  registry->Register(CreateRTTHistogram);
   registry->Register(Reset);
 #ifdef _WIN32
   registry->Register(SetSimultaneousAccepts);
@@ -209,6 +235,89 @@ void TCPWrap::SetKeepAlive(const FunctionCallbackInfo<Value>& args) {
 }
 
 
+void TCPWrap::MemoryInfo(MemoryTracker* tracker) const {
+  if (tcp_info_) tracker->TrackField("tcp_info", *tcp_info_);
+}
+
+
+int TCPWrap::ReadTCPInfo(double* fields) const {
+#ifdef __linux__
+  uv_os_fd_t fd;
+  int err = uv_fileno(reinterpret_cast<const uv_handle_t*>(&handle_), &fd);
+  if (err != 0) return err;
+
+  struct tcp_info info;
+  socklen_t len = sizeof(info);
+  if (getsockopt(fd, IPPROTO_TCP, TCP_INFO, &info, &len) != 0)
+    return uv_translate_sys_error(errno);
+
+  fields[kTCPInfoState] = info.tcpi_state;
+  fields[kTCPInfoRetransmits] = info.tcpi_retransmits;
+  fields[kTCPInfoRtt] = info.tcpi_rtt;
+  fields[kTCPInfoRttVar] = info.tcpi_rttvar;
+  fields[kTCPInfoSndCwnd] = info.tcpi_snd_cwnd;
+  fields[kTCPInfoSndSsthresh] = info.tcpi_snd_ssthresh;
+  fields[kTCPInfoSndMss] = info.tcpi_snd_mss;
+  fields[kTCPInfoRcvMss] = info.tcpi_rcv_mss;
+  fields[kTCPInfoUnacked] = info.tcpi_unacked;
+  fields[kTCPInfoLost] = info.tcpi_lost;
+  fields[kTCPInfoTotalRetrans] = info.tcpi_total_retrans;
+  fields[kTCPInfoPmtu] = info.tcpi_pmtu;
+  return 0;
+#else
+  return UV_ENOTSUP;
+#endif
+}
+
+
+// getTCPInfo() returns a Float64Array laid out as TCPInfoFields, or a
+// negative error code. The same array is reused across calls.
+void TCPWrap::GetTCPInfo(const FunctionCallbackInfo<Value>& args) {
+  TCPWrap* wrap;
+  ASSIGN_OR_RETURN_UNWRAP(
+      &wrap, args.This(), args.GetReturnValue().Set(UV_EBADF));
+  if (!wrap->tcp_info_) {
+    wrap->tcp_info_ = std::make_unique<AliasedFloat64Array>(
+        wrap->env()->isolate(), kTCPInfoFieldsCount);
+  }
+  AliasedFloat64Array& fields = *wrap->tcp_info_;
+  double values[kTCPInfoFieldsCount];
+  int err = wrap->ReadTCPInfo(values);
+  if (err != 0) return args.GetReturnValue().Set(err);
+  for (size_t i = 0; i < kTCPInfoFieldsCount; i++)
+    fields.SetValue(i, values[i]);
+  args.GetReturnValue().Set(fields.GetJSArray());
+}
+
+
+// createRTTHistogram(interval) returns an interval histogram that, once
+// started, samples the smoothed RTT of this socket (in microseconds) every
+// `interval` milliseconds. Samples stop once the socket is gone.
+void TCPWrap::CreateRTTHistogram(const FunctionCallbackInfo<Value>& args) {
+  TCPWrap* wrap;
+  ASSIGN_OR_RETURN_UNWRAP(&wrap, args.This());
+  Environment* env = wrap->env();
+  CHECK(args[0]->IsInt32());
+  int32_t interval = args[0].As<Int32>()->Value();
+  CHECK_GT(interval, 0);
+
+  BaseObjectWeakPtr<TCPWrap> weak_wrap(wrap);
+  BaseObjectPtr<IntervalHistogram> histogram = IntervalHistogram::Create(
+      env,
+      interval,
+      [weak_wrap](Histogram& histogram) {
+        if (!weak_wrap || weak_wrap->IsHandleClosing()) return;
+        double fields[kTCPInfoFieldsCount];
+        if (weak_wrap->ReadTCPInfo(fields) != 0) return;
+        if (fields[kTCPInfoRtt] > 0)
+          histogram.Record(static_cast<int64_t>(fields[kTCPInfoRtt]));
+      },
+      Histogram::Options{});
+  if (!histogram) return;
+  args.GetReturnValue().Set(histogram->object());
+}
+
+
 #ifdef _WIN32
 void TCPWrap::SetSimultaneousAccepts(const FunctionCallbackInfo<Value>& args) {
   TCPWrap* wrap;
@@ -260,6 +369,14 @@ void TCPWrap::Bind(
       flags &= ~UV_TCP_IPV6ONLY;
     }
   }
+  // UV_TCP_REUSEPORT lets every Worker bind its own listening socket to the
+  // same port; the kernel then spreads incoming connections across them.
+  // libuv fails the bind with UV_ENOTSUP on platforms where SO_REUSEPORT
+  // does not balance the load.
+  if (wrap->provider_type() == PROVIDER_TCPSERVERWRAP &&
+      env->options()->tcp_reuseport) {
+    flags |= UV_TCP_REUSEPORT;
+  }
 
   T addr;
   int err = uv_ip_addr(*ip_address, port, &addr);
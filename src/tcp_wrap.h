@@ -24,9 +24,12 @@
 
 #if defined(NODE_WANT_INTERNALS) && NODE_WANT_INTERNALS
 
+#include "aliased_buffer.h"
 #include "async_wrap.h"
 #include "connection_wrap.h"
 
+#include <memory>
+
 namespace node {
 
 class ExternalReferenceRegistry;
@@ -39,6 +42,24 @@ class TCPWrap : public ConnectionWrap<TCPWrap, uv_tcp_t> {
     SERVER
   };
 
+  // Layout of the Float64Array returned by getTCPInfo(). Times are in
+  // microseconds, as reported by the kernel.
+  enum TCPInfoFields {
+    kTCPInfoState,
+    kTCPInfoRetransmits,
+    kTCPInfoRtt,
+    kTCPInfoRttVar,
+    kTCPInfoSndCwnd,
+    kTCPInfoSndSsthresh,
+    kTCPInfoSndMss,
+    kTCPInfoRcvMss,
+    kTCPInfoUnacked,
+    kTCPInfoLost,
+    kTCPInfoTotalRetrans,
+    kTCPInfoPmtu,
+    kTCPInfoFieldsCount
+  };
+
   static v8::MaybeLocal<v8::Object> Instantiate(Environment* env,
                                                 AsyncWrap* parent,
                                                 SocketType type);
@@ -48,7 +69,7 @@ class TCPWrap : public ConnectionWrap<TCPWrap, uv_tcp_t> {
                          void* priv);
   static void RegisterExternalReferences(ExternalReferenceRegistry* registry);
 
-  SET_NO_MEMORY_INFO()
+  void MemoryInfo(MemoryTracker* tracker) const override;
   SET_SELF_SIZE(TCPWrap)
   const char* MemoryInfoName() const override {
     switch (provider_type()) {
@@ -74,6 +95,9 @@ class TCPWrap : public ConnectionWrap<TCPWrap, uv_tcp_t> {
   static void New(const v8::FunctionCallbackInfo<v8::Value>& args);
   static void SetNoDelay(const v8::FunctionCallbackInfo<v8::Value>& args);
   static void SetKeepAlive(const v8::FunctionCallbackInfo<v8::Value>& args);
+  static void GetTCPInfo(const v8::FunctionCallbackInfo<v8::Value>& args);
+  static void CreateRTTHistogram(
+      const v8::FunctionCallbackInfo<v8::Value>& args);
   static void Bind(const v8::FunctionCallbackInfo<v8::Value>& args);
   static void Bind6(const v8::FunctionCallbackInfo<v8::Value>& args);
   static void Listen(const v8::FunctionCallbackInfo<v8::Value>& args);
@@ -90,6 +114,11 @@ class TCPWrap : public ConnectionWrap<TCPWrap, uv_tcp_t> {
       std::function<int(const char* ip_address, int port, T* addr)> uv_ip_addr);
   static void Reset(const v8::FunctionCallbackInfo<v8::Value>& args);
   int Reset(v8::Local<v8::Value> close_callback = v8::Local<v8::Value>());
+  int ReadTCPInfo(double* fields) const;
+
+  // Created on the first getTCPInfo() call and refilled by later ones, so
+  // polling does not allocate.
+  std::unique_ptr<AliasedFloat64Array> tcp_info_;
 
 #ifdef _WIN32
   static void SetSimultaneousAccepts(
@@ -0,0 +1,327 @@
+#include "threadpool_limiter.h"
+#include "env-inl.h"
+#include "histogram-inl.h"
+#include "node_internals.h"
+#include "node_options.h"
+#include "tracing/trace_event.h"
+#include "util-inl.h"
+#include "uv.h"
+
+#include <algorithm>
+
+namespace node {
+
+const char* ThreadPoolWorkClassName(ThreadPoolWorkClass work_class) {
+  switch (work_class) {
+    case ThreadPoolWorkClass::kFs:
+      return "fs";
+    case ThreadPoolWorkClass::kDns:
+      return "dns";
+    case ThreadPoolWorkClass::kCrypto:
+      return "crypto";
+    case ThreadPoolWorkClass::kZlib:
+      return "zlib";
+    case ThreadPoolWorkClass::kUser:
+      return "user";
+  }
+  UNREACHABLE();
+}
+
+const char* ThreadPoolWorkHistogramName(ThreadPoolWorkHistogram kind) {
+  switch (kind) {
+    case ThreadPoolWorkHistogram::kWait:
+      return "wait";
+    case ThreadPoolWorkHistogram::kRun:
+      return "run";
+    case ThreadPoolWorkHistogram::kLatency:
+      return "latency";
+  }
+  UNREACHABLE();
+}
+
+ThreadPoolWorkBudget* ThreadPoolWorkBudget::Get() {
+  // Intentionally leaked: Worker threads may still release slots while
+  // static destructors run.
+  static ThreadPoolWorkBudget* budget = [] {
+    ThreadPoolWorkBudget* budget = new ThreadPoolWorkBudget();
+    Mutex::ScopedLock lock(per_process::cli_options_mutex);
+    const PerProcessOptions* options = per_process::cli_options.get();
+    budget->SetLimit(ThreadPoolWorkClass::kCrypto,
+                     options->threadpool_crypto_limit);
+    budget->SetLimit(ThreadPoolWorkClass::kDns, options->threadpool_dns_limit);
+    budget->SetLimit(ThreadPoolWorkClass::kUser,
+                     options->threadpool_user_limit);
+    budget->SetLimit(ThreadPoolWorkClass::kZlib,
+                     options->threadpool_zlib_limit);
+    return budget;
+  }();
+  return budget;
+}
+
+void ThreadPoolWorkBudget::SetLimit(ThreadPoolWorkClass work_class,
+                                    size_t limit) {
+  if (work_class == ThreadPoolWorkClass::kFs) return;
+  Mutex::ScopedLock lock(mutex_);
+  ClassState& s = classes_[static_cast<size_t>(work_class)];
+  s.limit = limit;
+  // Raising the limit may allow queued requests to run.
+  for (ThreadPoolWorkLimiter* waiter : s.waiters) waiter->wake_();
+  s.waiters.clear();
+}
+
+size_t ThreadPoolWorkBudget::limit(ThreadPoolWorkClass work_class) const {
+  Mutex::ScopedLock lock(mutex_);
+  return classes_[static_cast<size_t>(work_class)].limit;
+}
+
+bool ThreadPoolWorkBudget::Acquire(ThreadPoolWorkClass work_class,
+                                   ThreadPoolWorkLimiter* waiter,
+                                   bool force) {
+  Mutex::ScopedLock lock(mutex_);
+  ClassState& s = classes_[static_cast<size_t>(work_class)];
+  if (force || s.limit == 0 || s.running < s.limit) {
+    s.running++;
+    return true;
+  }
+  if (std::find(s.waiters.begin(), s.waiters.end(), waiter) ==
+      s.waiters.end()) {
+    s.waiters.push_back(waiter);
+  }
+  return false;
+}
+
+void ThreadPoolWorkBudget::Release(ThreadPoolWorkClass work_class) {
+  Mutex::ScopedLock lock(mutex_);
+  ClassState& s = classes_[static_cast<size_t>(work_class)];
+  CHECK_GT(s.running, 0);
+  s.running--;
+  // Every waiter gets to try, since the one that is woken up first may have
+  // had its queued requests cancelled in the meantime. Those that do not get
+  // a slot wait again.
+  for (ThreadPoolWorkLimiter* waiter : s.waiters) waiter->wake_();
+  s.waiters.clear();
+}
+
+void ThreadPoolWorkBudget::RemoveWaiter(ThreadPoolWorkLimiter* waiter) {
+  Mutex::ScopedLock lock(mutex_);
+  for (ClassState& s : classes_) {
+    s.waiters.erase(std::remove(s.waiters.begin(), s.waiters.end(), waiter),
+                    s.waiters.end());
+  }
+}
+
+ThreadPoolWorkLimiter::ThreadPoolWorkLimiter(ThreadPoolWorkBudget* budget,
+                                             std::function<void()> wake)
+    : own_budget_(budget == nullptr ? new ThreadPoolWorkBudget() : nullptr),
+      budget_(budget == nullptr ? own_budget_.get() : budget),
+      wake_(std::move(wake)) {
+  if (!wake_) {
+    // Without a budget that is shared with other threads, slots can only be
+    // released from Finish(), which submits queued requests itself.
+    CHECK_NOT_NULL(own_budget_);
+    wake_ = []() {};
+  }
+}
+
+ThreadPoolWorkLimiter::~ThreadPoolWorkLimiter() {
+  budget_->RemoveWaiter(this);
+}
+
+void ThreadPoolWorkLimiter::SetLimit(ThreadPoolWorkClass work_class,
+                                     size_t limit) {
+  budget_->SetLimit(work_class, limit);
+  SubmitQueued(work_class);
+}
+
+size_t ThreadPoolWorkLimiter::limit(ThreadPoolWorkClass work_class) const {
+  return budget_->limit(work_class);
+}
+
+int ThreadPoolWorkLimiter::Schedule(ThreadPoolWorkClass work_class,
+                                    Work* work) {
+  ClassState& s = state(work_class);
+  work->schedule_time_ = metrics_enabled_ ? uv_hrtime() : 0;
+  // Requests that are already queued go first.
+  if (!s.queue.IsEmpty() ||
+      !budget_->Acquire(work_class, this, cancelled_queued_)) {
+    s.queue.PushBack(work);
+    s.queued++;
+    return 0;
+  }
+  s.running++;
+  int status = work->SubmitWork();
+  if (status != 0) {
+    s.running--;
+    budget_->Release(work_class);
+  }
+  return status;
+}
+
+void ThreadPoolWorkLimiter::Finish(ThreadPoolWorkClass work_class,
+                                   const Work* work) {
+  ClassState& s = state(work_class);
+  CHECK_GT(s.running, 0);
+  s.running--;
+  budget_->Release(work_class);
+  RecordLatency(work_class, work->schedule_time_);
+  SubmitQueued(work_class);
+}
+
+void ThreadPoolWorkLimiter::SubmitQueued() {
+  for (size_t i = 0; i < kThreadPoolWorkClassCount; i++)
+    SubmitQueued(static_cast<ThreadPoolWorkClass>(i));
+}
+
+void ThreadPoolWorkLimiter::SubmitQueued(ThreadPoolWorkClass work_class) {
+  ClassState& s = state(work_class);
+  while (!s.queue.IsEmpty() &&
+         budget_->Acquire(work_class, this, cancelled_queued_)) {
+    Work* work = s.queue.PopFront();
+    s.queued--;
+    s.running++;
+    int status = work->SubmitWork();
+    if (status != 0) {
+      s.running--;
+      budget_->Release(work_class);
+      // This may delete the work.
+      work->OnSubmitError(status);
+    }
+  }
+}
+
+bool ThreadPoolWorkLimiter::Unqueue(ThreadPoolWorkClass work_class,
+                                    Work* work) {
+  if (work->limiter_queue_.IsEmpty()) return false;
+  work->limiter_queue_.Remove();
+  state(work_class).queued--;
+  return true;
+}
+
+bool ThreadPoolWorkLimiter::Cancel(ThreadPoolWorkClass work_class,
+                                   Work* work) {
+  if (!Unqueue(work_class, work)) return false;
+  cancelled_.PushBack(work);
+  return true;
+}
+
+void ThreadPoolWorkLimiter::CompleteCancelled() {
+  while (!cancelled_.IsEmpty()) {
+    // This may delete the work.
+    cancelled_.PopFront()->OnSubmitError(UV_ECANCELED);
+  }
+}
+
+void ThreadPoolWorkLimiter::CancelQueued() {
+  cancelled_queued_ = true;
+  budget_->RemoveWaiter(this);
+  for (ClassState& s : classes_) {
+    while (!s.queue.IsEmpty()) {
+      cancelled_.PushBack(s.queue.PopFront());
+      s.queued--;
+    }
+  }
+  CompleteCancelled();
+}
+
+size_t ThreadPoolWorkLimiter::running(ThreadPoolWorkClass work_class) const {
+  return state(work_class).running;
+}
+
+size_t ThreadPoolWorkLimiter::queued(ThreadPoolWorkClass work_class) const {
+  return state(work_class).queued;
+}
+
+std::shared_ptr<Histogram> ThreadPoolWorkLimiter::histogram(
+    ThreadPoolWorkClass work_class, ThreadPoolWorkHistogram kind) {
+  EnableMetrics();
+  return state(work_class).histograms[static_cast<size_t>(kind)];
+}
+
+void ThreadPoolWorkLimiter::EnableMetrics() {
+  if (metrics_enabled_) return;
+  for (ClassState& s : classes_) {
+    for (std::shared_ptr<Histogram>& histogram : s.histograms) {
+      // Like the event loop delay histogram, record with a resolution of
+      // one microsecond.
+      histogram = std::make_shared<Histogram>(Histogram::Options{1000});
+    }
+  }
+  metrics_enabled_ = true;
+}
+
+void ThreadPoolWorkLimiter::Record(ClassState* s,
+                                   ThreadPoolWorkHistogram kind,
+                                   uint64_t delta) {
+  s->histograms[static_cast<size_t>(kind)]->Record(
+      static_cast<int64_t>(delta));
+}
+
+void ThreadPoolWorkLimiter::RecordRunTimes(ThreadPoolWorkClass work_class,
+                                           uint64_t schedule_time,
+                                           uint64_t start_time,
+                                           uint64_t end_time) {
+  if (!metrics_enabled_ || schedule_time == 0 || start_time == 0) return;
+  ClassState& s = state(work_class);
+  Record(&s, ThreadPoolWorkHistogram::kWait, start_time - schedule_time);
+  Record(&s, ThreadPoolWorkHistogram::kRun, end_time - start_time);
+}
+
+void ThreadPoolWorkLimiter::RecordLatency(ThreadPoolWorkClass work_class,
+                                          uint64_t schedule_time) {
+  if (!metrics_enabled_ || schedule_time == 0) return;
+  Record(&state(work_class),
+         ThreadPoolWorkHistogram::kLatency,
+         uv_hrtime() - schedule_time);
+}
+
+int ThreadPoolWork::SubmitWork() {
+  int status = uv_queue_work(
+      env_->event_loop(),
+      &work_req_,
+      [](uv_work_t* req) {
+        ThreadPoolWork* self = ContainerOf(&ThreadPoolWork::work_req_, req);
+        // The schedule time is only set if metrics are enabled.
+        bool timed = self->schedule_time() != 0;
+        if (timed) self->start_time_ = uv_hrtime();
+        TRACE_EVENT_BEGIN0(TRACING_CATEGORY_NODE2(threadpoolwork, sync),
+                           self->type_);
+        self->DoThreadPoolWork();
+        TRACE_EVENT_END0(TRACING_CATEGORY_NODE2(threadpoolwork, sync),
+                         self->type_);
+        if (timed) self->end_time_ = uv_hrtime();
+      },
+      [](uv_work_t* req, int status) {
+        ThreadPoolWork* self = ContainerOf(&ThreadPoolWork::work_req_, req);
+        self->env_->DecreaseWaitingRequestCounter();
+        ThreadPoolWorkLimiter* limiter = self->env_->threadpool_work_limiter();
+        limiter->RecordRunTimes(self->work_class_,
+                                self->schedule_time(),
+                                self->start_time_,
+                                self->end_time_);
+        // This may submit the next queued work of the same class.
+        limiter->Finish(self->work_class_, self);
+        TRACE_EVENT_NESTABLE_ASYNC_END1(
+            TRACING_CATEGORY_NODE2(threadpoolwork, async),
+            self->type_,
+            self,
+            "result",
+            status);
+        self->AfterThreadPoolWork(status);
+      });
+  CHECK_EQ(status, 0);
+  return status;
+}
+
+void ThreadPoolWork::OnSubmitError(int status) {
+  // The work was queued by the limiter and never ran, either because it was
+  // cancelled or because the Environment is going away.
+  env_->DecreaseWaitingRequestCounter();
+  TRACE_EVENT_NESTABLE_ASYNC_END1(TRACING_CATEGORY_NODE2(threadpoolwork, async),
+                                  type_,
+                                  this,
+                                  "result",
+                                  status);
+  AfterThreadPoolWork(status);
+}
+
+}  // namespace node
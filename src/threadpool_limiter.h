@@ -0,0 +1,217 @@
+#ifndef SRC_THREADPOOL_LIMITER_H_
+#define SRC_THREADPOOL_LIMITER_H_
+
+#if defined(NODE_WANT_INTERNALS) && NODE_WANT_INTERNALS
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+
+#include "node_mutex.h"
+#include "util.h"
+
+namespace node {
+
+// The kinds of work that Node.js submits to the libuv threadpool. They all
+// share libuv's single pool of UV_THREADPOOL_SIZE threads, but every class
+// other than kFs can be limited to a number of requests that run at the same
+// time in the process, so that e.g. a burst of crypto.pbkdf2() calls cannot
+// occupy every thread and starve the file system and dns requests queued
+// behind them.
+enum class ThreadPoolWorkClass : uint8_t {
+  kFs,
+  kDns,
+  kCrypto,
+  kZlib,
+  kUser,
+};
+
+constexpr size_t kThreadPoolWorkClassCount =
+    static_cast<size_t>(ThreadPoolWorkClass::kUser) + 1;
+
+const char* ThreadPoolWorkClassName(ThreadPoolWorkClass work_class);
+
+class Histogram;
+
+// Per-class timings that the ThreadPoolWorkLimiter records once metrics have
+// been enabled, all in nanoseconds:
+// - kWait: from scheduling the request until a threadpool thread starts it,
+//   including any time spent queued behind the limit of its class.
+// - kRun: from the start until the end of the work on the threadpool thread.
+// - kLatency: from scheduling the request until its completion is handled on
+//   the Environment's thread.
+// kWait and kRun are only known for requests that run through
+// ThreadPoolWork. libuv runs fs and dns requests itself and does not report
+// when they start, so only their kLatency is recorded.
+enum class ThreadPoolWorkHistogram : uint8_t {
+  kWait,
+  kRun,
+  kLatency,
+};
+
+constexpr size_t kThreadPoolWorkHistogramCount =
+    static_cast<size_t>(ThreadPoolWorkHistogram::kLatency) + 1;
+
+const char* ThreadPoolWorkHistogramName(ThreadPoolWorkHistogram kind);
+
+class ThreadPoolWorkLimiter;
+
+// The limit of each ThreadPoolWorkClass, and how many requests of the class
+// are running, across all of the limiters that share the budget. Since the
+// libuv threadpool belongs to the process, so does the budget of the
+// Environments; see Get(). Thread-safe.
+class ThreadPoolWorkBudget {
+ public:
+  // The budget that all Environments of the process share, with the limits
+  // that the --threadpool-*-limit options set.
+  static ThreadPoolWorkBudget* Get();
+
+  ThreadPoolWorkBudget() = default;
+  ThreadPoolWorkBudget(const ThreadPoolWorkBudget&) = delete;
+  ThreadPoolWorkBudget& operator=(const ThreadPoolWorkBudget&) = delete;
+
+  // A limit of 0 means that the class is not limited. kFs is never limited.
+  void SetLimit(ThreadPoolWorkClass work_class, size_t limit);
+  size_t limit(ThreadPoolWorkClass work_class) const;
+
+  // Takes a slot for a request of |work_class|. Fails if the class is at its
+  // limit and |force| is false, in which case |waiter| is woken up once a
+  // slot of the class has been released.
+  bool Acquire(ThreadPoolWorkClass work_class,
+               ThreadPoolWorkLimiter* waiter,
+               bool force = false);
+  void Release(ThreadPoolWorkClass work_class);
+  void RemoveWaiter(ThreadPoolWorkLimiter* waiter);
+
+ private:
+  struct ClassState {
+    size_t limit = 0;
+    size_t running = 0;
+    std::deque<ThreadPoolWorkLimiter*> waiters;
+  };
+
+  mutable Mutex mutex_;
+  ClassState classes_[kThreadPoolWorkClassCount];
+};
+
+// Tracks how many threadpool requests of each ThreadPoolWorkClass an
+// Environment has submitted to libuv, and holds back requests that would
+// exceed the limit of their class in the budget until a slot becomes free.
+// Only used on the Environment's thread.
+class ThreadPoolWorkLimiter {
+ public:
+  class Work {
+   public:
+    virtual ~Work() = default;
+
+    // Submits the request to the libuv threadpool and returns the libuv
+    // status code. Called either directly from Schedule(), or later from
+    // Finish() for an earlier request of the same class if the request had
+    // to be queued. Implementations must call Finish() once a successfully
+    // submitted request has completed.
+    virtual int SubmitWork() = 0;
+    // Called instead of returning the error from Schedule() when submitting
+    // a queued request failed, and with UV_ECANCELED for queued requests
+    // that are cancelled. This may delete the request.
+    virtual void OnSubmitError(int status) { UNREACHABLE(); }
+
+    // The uv_hrtime() at which the request was passed to Schedule(), or 0
+    // if metrics were not enabled at that point.
+    uint64_t schedule_time() const { return schedule_time_; }
+
+   private:
+    friend class ThreadPoolWorkLimiter;
+    ListNode<Work> limiter_queue_;
+    uint64_t schedule_time_ = 0;
+  };
+
+  // Without a |budget|, the limiter uses one of its own. |wake| is called,
+  // on any thread and with the budget locked, once the budget has room for
+  // requests that this limiter queued. It must arrange for SubmitQueued() to
+  // be called on the limiter's thread, and must not call into the budget.
+  explicit ThreadPoolWorkLimiter(ThreadPoolWorkBudget* budget = nullptr,
+                                 std::function<void()> wake = {});
+  ~ThreadPoolWorkLimiter();
+  ThreadPoolWorkLimiter(const ThreadPoolWorkLimiter&) = delete;
+  ThreadPoolWorkLimiter& operator=(const ThreadPoolWorkLimiter&) = delete;
+
+  // Sets the limit in the budget, which may be shared with other limiters.
+  void SetLimit(ThreadPoolWorkClass work_class, size_t limit);
+  size_t limit(ThreadPoolWorkClass work_class) const;
+
+  // Submits the request right away if its class has not reached its limit,
+  // and returns the result of Work::SubmitWork(). Otherwise, queues the
+  // request and returns 0.
+  int Schedule(ThreadPoolWorkClass work_class, Work* work);
+  // Also records the latency of the request if metrics are enabled.
+  void Finish(ThreadPoolWorkClass work_class, const Work* work);
+  // Removes a request that is still queued. Returns false if the request was
+  // already submitted to libuv.
+  bool Unqueue(ThreadPoolWorkClass work_class, Work* work);
+  // Like Unqueue(), but the request's OnSubmitError(UV_ECANCELED) is called
+  // from the next CompleteCancelled(). A request that is deleted before then
+  // is simply forgotten.
+  bool Cancel(ThreadPoolWorkClass work_class, Work* work);
+  void CompleteCancelled();
+  // Submits queued requests of every class for which the budget has room.
+  void SubmitQueued();
+  // Cancels every queued request, and from then on submits new requests
+  // regardless of the limits. Called when the Environment is torn down, so
+  // that it does not wait for requests that may never get a slot.
+  void CancelQueued();
+
+  size_t running(ThreadPoolWorkClass work_class) const;
+  size_t queued(ThreadPoolWorkClass work_class) const;
+
+  // Returns the histogram of the given kind for a class. The first call
+  // enables metrics for all classes; nothing is recorded before that.
+  std::shared_ptr<Histogram> histogram(ThreadPoolWorkClass work_class,
+                                       ThreadPoolWorkHistogram kind);
+  bool metrics_enabled() const { return metrics_enabled_; }
+
+  // The times are uv_hrtime() values. Requests that were scheduled before
+  // metrics were enabled, i.e. that have a schedule_time of 0, are ignored.
+  void RecordRunTimes(ThreadPoolWorkClass work_class,
+                      uint64_t schedule_time,
+                      uint64_t start_time,
+                      uint64_t end_time);
+  void RecordLatency(ThreadPoolWorkClass work_class, uint64_t schedule_time);
+
+ private:
+  friend class ThreadPoolWorkBudget;
+
+  struct ClassState {
+    size_t running = 0;
+    size_t queued = 0;
+    ListHead<Work, &Work::limiter_queue_> queue;
+    std::shared_ptr<Histogram> histograms[kThreadPoolWorkHistogramCount];
+  };
+
+  void SubmitQueued(ThreadPoolWorkClass work_class);
+  void EnableMetrics();
+  void Record(ClassState* s, ThreadPoolWorkHistogram kind, uint64_t delta);
+
+  ClassState& state(ThreadPoolWorkClass work_class) {
+    return classes_[static_cast<size_t>(work_class)];
+  }
+  const ClassState& state(ThreadPoolWorkClass work_class) const {
+    return classes_[static_cast<size_t>(work_class)];
+  }
+
+  std::unique_ptr<ThreadPoolWorkBudget> own_budget_;
+  ThreadPoolWorkBudget* budget_;
+  std::function<void()> wake_;
+  ClassState classes_[kThreadPoolWorkClassCount];
+  // Requests passed to Cancel(), using the same list node as the queues.
+  ListHead<Work, &Work::limiter_queue_> cancelled_;
+  bool cancelled_queued_ = false;
+  bool metrics_enabled_ = false;
+};
+
+}  // namespace node
+
+#endif  // defined(NODE_WANT_INTERNALS) && NODE_WANT_INTERNALS
+
+#endif  // SRC_THREADPOOL_LIMITER_H_
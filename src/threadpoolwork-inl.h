@@ -24,6 +24,7 @@
 
 #if defined(NODE_WANT_INTERNALS) && NODE_WANT_INTERNALS
 
+#include "env-inl.h"
 #include "node_internals.h"
 #include "tracing/trace_event.h"
 #include "util-inl.h"
@@ -34,32 +35,19 @@ void ThreadPoolWork::ScheduleWork() {
   env_->IncreaseWaitingRequestCounter();
   TRACE_EVENT_NESTABLE_ASYNC_BEGIN0(
       TRACING_CATEGORY_NODE2(threadpoolwork, async), type_, this);
-  int status = uv_queue_work(
-      env_->event_loop(),
-      &work_req_,
-      [](uv_work_t* req) {
-        ThreadPoolWork* self = ContainerOf(&ThreadPoolWork::work_req_, req);
-        TRACE_EVENT_BEGIN0(TRACING_CATEGORY_NODE2(threadpoolwork, sync),
-                           self->type_);
-        self->DoThreadPoolWork();
-        TRACE_EVENT_END0(TRACING_CATEGORY_NODE2(threadpoolwork, sync),
-                         self->type_);
-      },
-      [](uv_work_t* req, int status) {
-        ThreadPoolWork* self = ContainerOf(&ThreadPoolWork::work_req_, req);
-        self->env_->DecreaseWaitingRequestCounter();
-        TRACE_EVENT_NESTABLE_ASYNC_END1(
-            TRACING_CATEGORY_NODE2(threadpoolwork, async),
-            self->type_,
-            self,
-            "result",
-            status);
-        self->AfterThreadPoolWork(status);
-      });
-  CHECK_EQ(status, 0);
+  env_->threadpool_work_limiter()->Schedule(work_class_, this);
 }
 
 int ThreadPoolWork::CancelWork() {
+  if (env_->threadpool_work_limiter()->Cancel(work_class_, this)) {
+    // The work was never submitted to libuv. Report the cancellation
+    // asynchronously, like libuv does for cancelled requests. The limiter
+    // forgets the work if it is deleted before then.
+    env_->SetImmediate([](Environment* env) {
+      env->threadpool_work_limiter()->CompleteCancelled();
+    });
+    return 0;
+  }
   return uv_cancel(reinterpret_cast<uv_req_t*>(&work_req_));
 }
 
@@ -0,0 +1,122 @@
+#include "timer_wheel.h"
+#include "util-inl.h"
+
+#include <algorithm>
+#include <bit>
+#include <limits>
+
+namespace node {
+namespace timers {
+
+namespace {
+
+constexpr uint64_t SlotBit(size_t index) {
+  return uint64_t{1} << index;
+}
+
+}  // anonymous namespace
+
+TimerWheel::TimerWheel(uint64_t now) : now_(now) {}
+
+void TimerWheel::Schedule(Entry* entry, uint64_t expiry) {
+  Cancel(entry);
+  entry->expiry_ = std::min(expiry, now_ + kMaxDelay);
+  Insert(entry);
+  size_++;
+}
+
+void TimerWheel::Cancel(Entry* entry) {
+  if (!entry->scheduled()) return;
+  entry->node_.Remove();
+  size_--;
+  if (entry->slot_ == kDueSlot) return;
+  size_t level = entry->slot_ / kSlots;
+  size_t index = entry->slot_ % kSlots;
+  if (slots_[level][index].IsEmpty()) occupied_[level] &= ~SlotBit(index);
+}
+
+void TimerWheel::Insert(Entry* entry) {
+  if (entry->expiry_ <= now_) {
+    entry->slot_ = kDueSlot;
+    due_.PushBack(entry);
+    return;
+  }
+
+  uint64_t delta = entry->expiry_ - now_;
+  size_t level = 0;
+  while (level + 1 < kLevels &&
+         delta >= (uint64_t{1} << (kLevelBits * (level + 1)))) {
+    level++;
+  }
+  size_t index = (entry->expiry_ >> (kLevelBits * level)) & (kSlots - 1);
+  entry->slot_ = static_cast<uint16_t>(level * kSlots + index);
+  slots_[level][index].PushBack(entry);
+  occupied_[level] |= SlotBit(index);
+}
+
+void TimerWheel::Advance(uint64_t now, std::vector<Entry*>* expired) {
+  FireDue(expired);
+  // Jump from one non-empty slot to the next instead of ticking through
+  // every millisecond, which matters after the loop has been blocked.
+  while (size_ > 0) {
+    uint64_t next = NextWakeup();
+    if (next > now) break;
+    now_ = next;
+    Tick(expired);
+  }
+  now_ = std::max(now_, now);
+}
+
+uint64_t TimerWheel::NextWakeup() const {
+  if (size_ == 0) return 0;
+  if (!due_.IsEmpty()) return now_;
+
+  uint64_t next = std::numeric_limits<uint64_t>::max();
+  for (size_t level = 0; level < kLevels; level++) {
+    if (occupied_[level] == 0) continue;
+    size_t shift = kLevelBits * level;
+    uint64_t current = now_ >> shift;
+    // The first occupied slot after the current one, wrapping around to the
+    // current one, which is then processed a full rotation from now.
+    int start = static_cast<int>((current + 1) & (kSlots - 1));
+    uint64_t distance =
+        std::countr_zero(std::rotr(occupied_[level], start)) + 1;
+    next = std::min(next, (current + distance) << shift);
+  }
+  return next;
+}
+
+void TimerWheel::Tick(std::vector<Entry*>* expired) {
+  // Cascade the higher levels first, as their entries can land in the lower
+  // level slots that are due at the same time.
+  for (size_t level = kLevels - 1; level > 0; level--) {
+    size_t shift = kLevelBits * level;
+    if ((now_ & ((uint64_t{1} << shift) - 1)) != 0) continue;
+    size_t index = (now_ >> shift) & (kSlots - 1);
+    if ((occupied_[level] & SlotBit(index)) == 0) continue;
+    occupied_[level] &= ~SlotBit(index);
+    Slot& slot = slots_[level][index];
+    while (Entry* entry = slot.PopFront()) Insert(entry);
+  }
+
+  size_t index = now_ & (kSlots - 1);
+  if ((occupied_[0] & SlotBit(index)) != 0) {
+    occupied_[0] &= ~SlotBit(index);
+    Slot& slot = slots_[0][index];
+    while (Entry* entry = slot.PopFront()) {
+      expired->push_back(entry);
+      size_--;
+    }
+  }
+  FireDue(expired);
+}
+
+void TimerWheel::FireDue(std::vector<Entry*>* expired) {
+  while (Entry* entry = due_.PopFront()) {
+    expired->push_back(entry);
+    size_--;
+  }
+}
+
+}  // namespace timers
+}  // namespace node
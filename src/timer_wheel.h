@@ -0,0 +1,102 @@
+#ifndef SRC_TIMER_WHEEL_H_
+#define SRC_TIMER_WHEEL_H_
+
+#if defined(NODE_WANT_INTERNALS) && NODE_WANT_INTERNALS
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "util.h"
+
+namespace node {
+namespace timers {
+
+// A hierarchical hashed timing wheel with a resolution of one millisecond.
+// Scheduling, rescheduling and cancelling a timer are O(1), which makes it
+// suitable for large numbers of timeouts that are refreshed much more often
+// than they expire, such as socket idle timeouts.
+//
+// Level k has kSlots slots of kSlots^k ms each, and holds the timers that
+// expire between kSlots^k and kSlots^(k+1) ms from now. Slots are indexed by
+// the absolute expiry time, so a timer only moves when the lower levels wrap
+// around and its slot is cascaded into them. Timers further out than
+// kMaxDelay are clamped to it.
+class TimerWheel {
+ public:
+  // Embedded in the objects that are scheduled on the wheel.
+  class Entry {
+   public:
+    Entry() = default;
+    Entry(const Entry&) = delete;
+    Entry& operator=(const Entry&) = delete;
+
+    bool scheduled() const { return !node_.IsEmpty(); }
+    uint64_t expiry() const { return expiry_; }
+
+   private:
+    friend class TimerWheel;
+    ListNode<Entry> node_;
+    uint64_t expiry_ = 0;
+    uint16_t slot_ = 0;
+  };
+
+  static constexpr size_t kLevelBits = 6;
+  static constexpr size_t kSlots = 1 << kLevelBits;
+  static constexpr size_t kLevels = 6;
+  static constexpr uint64_t kMaxDelay =
+      (uint64_t{1} << (kLevelBits * kLevels)) - 1;
+
+  explicit TimerWheel(uint64_t now);
+  TimerWheel(const TimerWheel&) = delete;
+  TimerWheel& operator=(const TimerWheel&) = delete;
+
+  // Schedules the entry to expire at the given absolute time, which fires
+  // it in the next Advance() if it is not later than now(). If the entry is
+  // already scheduled, it is moved.
+  void Schedule(Entry* entry, uint64_t expiry);
+  // Does nothing if the entry is not scheduled. Entries must be cancelled
+  // before they are destroyed.
+  void Cancel(Entry* entry);
+
+  // Moves the wheel forward to now, appending the entries that have expired
+  // to *expired in order of expiry. Expired entries are no longer scheduled
+  // by the time this returns.
+  void Advance(uint64_t now, std::vector<Entry*>* expired);
+
+  // The earliest time at which Advance() has something to do, i.e. at which
+  // a timer expires or is cascaded into a lower level, or 0 if the wheel is
+  // empty. This is never later than the earliest expiry.
+  uint64_t NextWakeup() const;
+
+  uint64_t now() const { return now_; }
+  size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+
+ private:
+  using Slot = ListHead<Entry, &Entry::node_>;
+  // The Entry::slot_ of entries in due_.
+  static constexpr uint16_t kDueSlot = kLevels * kSlots;
+
+  void Insert(Entry* entry);
+  // Processes the slots of the wheel that are due at now_.
+  void Tick(std::vector<Entry*>* expired);
+  void FireDue(std::vector<Entry*>* expired);
+
+  uint64_t now_;
+  size_t size_ = 0;
+  // Bit i of occupied_[level] is set when slots_[level][i] is not empty.
+  uint64_t occupied_[kLevels] = {};
+  Slot slots_[kLevels][kSlots];
+  // Entries that are due at the next Advance(), because they were scheduled
+  // to expire no later than now_.
+  Slot due_;
+  static_assert(kSlots == 64, "occupied_ bitmaps hold one bit per slot");
+};
+
+}  // namespace timers
+}  // namespace node
+
+#endif  // defined(NODE_WANT_INTERNALS) && NODE_WANT_INTERNALS
+
+#endif  // SRC_TIMER_WHEEL_H_
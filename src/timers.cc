@@ -1,24 +1,35 @@
 #include "timers.h"
 
 #include "env-inl.h"
+#include "memory_tracker-inl.h"
 #include "node_debug.h"
+#include "node_errors.h"
 #include "node_external_reference.h"
+#include "timer_wrap-inl.h"
 #include "util-inl.h"
 #include "v8.h"
 
+#include <algorithm>
 #include <cstdint>
 
 namespace node {
 namespace timers {
 
+using errors::TryCatchScope;
+using v8::ArrayBuffer;
+using v8::BackingStore;
 using v8::Context;
 using v8::Function;
 using v8::FunctionCallbackInfo;
+using v8::FunctionTemplate;
+using v8::HandleScope;
 using v8::Isolate;
 using v8::Local;
 using v8::Number;
 using v8::Object;
 using v8::ObjectTemplate;
+using v8::Uint32;
+using v8::Uint32Array;
 using v8::Value;
 
 void BindingData::SetupTimers(const FunctionCallbackInfo<Value>& args) {
@@ -95,6 +106,17 @@ void BindingData::ToggleImmediateRefImpl(BindingData* data, bool ref) {
   data->env()->ToggleImmediateRef(ref);
 }
 
+void BindingData::SetTimerSlack(const FunctionCallbackInfo<Value>& args) {
+  CHECK(args[0]->IsUint32());
+  Environment::GetCurrent(args)->set_timer_slack(
+      args[0].As<Uint32>()->Value());
+}
+
+void BindingData::GetTimerSlack(const FunctionCallbackInfo<Value>& args) {
+  args.GetReturnValue().Set(
+      static_cast<double>(Environment::GetCurrent(args)->timer_slack()));
+}
+
 BindingData::BindingData(Realm* realm, Local<Object> object)
     : SnapshotableObject(realm, object, type_int) {}
 
@@ -124,6 +146,141 @@ void BindingData::Deserialize(Local<Context> context,
   CHECK_NOT_NULL(binding);
 }
 
+TimerWheelWrap::TimerWheelWrap(Environment* env,
+                               Local<Object> wrap,
+                               Local<Function> callback)
+    : BaseObject(env, wrap),
+      wheel_(uv_now(env->event_loop())),
+      timer_(env, [this] { OnTimeout(); }),
+      callback_(env->isolate(), callback) {
+  MakeWeak();
+}
+
+void TimerWheelWrap::New(const FunctionCallbackInfo<Value>& args) {
+  Environment* env = Environment::GetCurrent(args);
+  CHECK(args.IsConstructCall());
+  CHECK(args[0]->IsFunction());
+  new TimerWheelWrap(env, args.This(), args[0].As<Function>());
+}
+
+void TimerWheelWrap::Schedule(const FunctionCallbackInfo<Value>& args) {
+  TimerWheelWrap* wrap;
+  ASSIGN_OR_RETURN_UNWRAP(&wrap, args.This());
+  CHECK(args[0]->IsUint32());
+  CHECK(args[1]->IsNumber());
+  uint32_t id = args[0].As<Uint32>()->Value();
+  // Like setTimeout(), fire after at least 1 ms.
+  double delay = args[1].As<Number>()->Value();
+  uint64_t delay_ms = 1;
+  if (delay > 1) {
+    delay_ms = static_cast<uint64_t>(
+        std::min(delay, static_cast<double>(TimerWheel::kMaxDelay)));
+  }
+
+  // The wheel only moves forward when the libuv timer fires, so catch up
+  // with the loop time first if it has been idle.
+  if (wrap->wheel_.empty()) wrap->wheel_.Advance(wrap->Now(), &wrap->expired_);
+
+  Timer* timer = &wrap->timers_[id];
+  timer->id = id;
+  wrap->wheel_.Schedule(timer, wrap->Now() + delay_ms);
+  wrap->UpdateTimer();
+}
+
+void TimerWheelWrap::Cancel(const FunctionCallbackInfo<Value>& args) {
+  TimerWheelWrap* wrap;
+  ASSIGN_OR_RETURN_UNWRAP(&wrap, args.This());
+  CHECK(args[0]->IsUint32());
+  auto it = wrap->timers_.find(args[0].As<Uint32>()->Value());
+  if (it == wrap->timers_.end()) return args.GetReturnValue().Set(false);
+
+  wrap->wheel_.Cancel(&it->second);
+  wrap->timers_.erase(it);
+  // Only stop the libuv timer once nothing is left, so that it does not keep
+  // the loop alive. Otherwise it may just fire early.
+  if (wrap->wheel_.empty()) wrap->UpdateTimer();
+  args.GetReturnValue().Set(true);
+}
+
+void TimerWheelWrap::Ref(const FunctionCallbackInfo<Value>& args) {
+  TimerWheelWrap* wrap;
+  ASSIGN_OR_RETURN_UNWRAP(&wrap, args.This());
+  wrap->timer_.Ref();
+}
+
+void TimerWheelWrap::Unref(const FunctionCallbackInfo<Value>& args) {
+  TimerWheelWrap* wrap;
+  ASSIGN_OR_RETURN_UNWRAP(&wrap, args.This());
+  wrap->timer_.Unref();
+}
+
+void TimerWheelWrap::GetSize(const FunctionCallbackInfo<Value>& args) {
+  TimerWheelWrap* wrap;
+  ASSIGN_OR_RETURN_UNWRAP(&wrap, args.This());
+  args.GetReturnValue().Set(static_cast<double>(wrap->wheel_.size()));
+}
+
+uint64_t TimerWheelWrap::Now() const {
+  return uv_now(env()->event_loop());
+}
+
+void TimerWheelWrap::UpdateTimer() {
+  if (wheel_.empty()) {
+    if (timer_expiry_ != 0) {
+      timer_.Stop();
+      timer_expiry_ = 0;
+    }
+    return;
+  }
+
+  uint64_t wakeup = wheel_.NextWakeup();
+  uint64_t now = Now();
+  uint64_t duration =
+      wakeup > now ? env()->ApplyTimerSlack(wakeup - now) : 0;
+  if (timer_expiry_ != 0 && timer_expiry_ <= now + duration) return;
+  timer_.Update(duration);
+  timer_expiry_ = now + duration;
+}
+
+void TimerWheelWrap::OnTimeout() {
+  timer_expiry_ = 0;
+  expired_.clear();
+  wheel_.Advance(Now(), &expired_);
+
+  std::unique_ptr<BackingStore> ids;
+  size_t count = expired_.size();
+  if (count > 0) {
+    ids = ArrayBuffer::NewBackingStore(env()->isolate(),
+                                       count * sizeof(uint32_t));
+    uint32_t* data = static_cast<uint32_t*>(ids->Data());
+    for (size_t i = 0; i < count; i++) {
+      data[i] = static_cast<Timer*>(expired_[i])->id;
+      timers_.erase(data[i]);
+    }
+    expired_.clear();
+  }
+  // Timers scheduled by the callback update the timer again if needed.
+  UpdateTimer();
+
+  if (count == 0 || !env()->can_call_into_js()) return;
+
+  Isolate* isolate = env()->isolate();
+  HandleScope handle_scope(isolate);
+  Context::Scope context_scope(env()->context());
+  InternalCallbackScope scope(env(), object(), {0, 0});
+  Local<Value> arg =
+      Uint32Array::New(ArrayBuffer::New(isolate, std::move(ids)), 0, count);
+  TryCatchScope try_catch(env());
+  try_catch.SetVerbose(true);
+  USE(callback_.Get(isolate)->Call(env()->context(), object(), 1, &arg));
+}
+
+void TimerWheelWrap::MemoryInfo(MemoryTracker* tracker) const {
+  tracker->TrackFieldWithSize("timers", timers_.size() * sizeof(Timer));
+  tracker->TrackField("timer", timer_);
+  tracker->TrackField("callback", callback_);
+}
+
 v8::CFunction BindingData::fast_get_libuv_now_(
     v8::CFunction::Make(FastGetLibuvNow));
 v8::CFunction BindingData::fast_schedule_timers_(
@@ -155,6 +312,19 @@ void BindingData::CreatePerIsolateProperties(IsolateData* isolate_data,
                 "toggleImmediateRef",
                 SlowToggleImmediateRef,
                 &fast_toggle_immediate_ref_);
+  SetMethod(isolate, target, "setTimerSlack", SetTimerSlack);
+  SetMethodNoSideEffect(isolate, target, "getTimerSlack", GetTimerSlack);
+
+  Local<FunctionTemplate> wheel =
+      NewFunctionTemplate(isolate, TimerWheelWrap::New);
+  wheel->InstanceTemplate()->SetInternalFieldCount(
+      TimerWheelWrap::kInternalFieldCount);
+  SetProtoMethod(isolate, wheel, "schedule", TimerWheelWrap::Schedule);
+  SetProtoMethod(isolate, wheel, "cancel", TimerWheelWrap::Cancel);
+  SetProtoMethod(isolate, wheel, "ref", TimerWheelWrap::Ref);
+  SetProtoMethod(isolate, wheel, "unref", TimerWheelWrap::Unref);
+  SetProtoMethodNoSideEffect(isolate, wheel, "size", TimerWheelWrap::GetSize);
+  SetConstructorFunction(isolate, target, "TimerWheel", wheel);
 }
 
 void BindingData::CreatePerContextProperties(Local<Object> target,
@@ -199,6 +369,16 @@ void BindingData::RegisterTimerExternalReferences(
   registry->Register(SlowToggleImmediateRef);
   registry->Register(FastToggleImmediateRef);
   registry->Register(fast_toggle_immediate_ref_.GetTypeInfo());
+
+  registry->Register(SetTimerSlack);
+  registry->Register(GetTimerSlack);
+
+  registry->Register(TimerWheelWrap::New);
+  registry->Register(TimerWheelWrap::Schedule);
+  registry->Register(TimerWheelWrap::Cancel);
+  registry->Register(TimerWheelWrap::Ref);
+  registry->Register(TimerWheelWrap::Unref);
+  registry->Register(TimerWheelWrap::GetSize);
 }
 
 }  // namespace timers
@@ -4,7 +4,12 @@
 #if defined(NODE_WANT_INTERNALS) && NODE_WANT_INTERNALS
 
 #include <cinttypes>
+#include <unordered_map>
+#include <vector>
+#include "base_object.h"
 #include "node_snapshotable.h"
+#include "timer_wheel.h"
+#include "timer_wrap.h"
 
 namespace node {
 class ExternalReferenceRegistry;
@@ -50,6 +55,11 @@ class BindingData : public SnapshotableObject {
                                      bool ref);
   static void ToggleImmediateRefImpl(BindingData* data, bool ref);
 
+  // setTimerSlack(ms): see Environment::timer_slack(). Takes effect when a
+  // timer is next scheduled.
+  static void SetTimerSlack(const v8::FunctionCallbackInfo<v8::Value>& args);
+  static void GetTimerSlack(const v8::FunctionCallbackInfo<v8::Value>& args);
+
   static void CreatePerIsolateProperties(IsolateData* isolate_data,
                                          v8::Local<v8::ObjectTemplate> target);
   static void CreatePerContextProperties(v8::Local<v8::Object> target,
@@ -66,6 +76,51 @@ class BindingData : public SnapshotableObject {
   static v8::CFunction fast_toggle_immediate_ref_;
 };
 
+// The TimerWheel class of the timers binding, which keeps timers identified
+// by uint32 ids on a TimerWheel driven by one libuv timer. Scheduling,
+// refreshing and cancelling a timer does not touch the libuv timer unless
+// the timer becomes the earliest one, so large numbers of refreshable
+// timeouts are cheap. Expired ids are passed to the callback given to the
+// constructor as a Uint32Array, in order of expiry.
+class TimerWheelWrap final : public BaseObject {
+ public:
+  TimerWheelWrap(Environment* env,
+                 v8::Local<v8::Object> wrap,
+                 v8::Local<v8::Function> callback);
+
+  static void New(const v8::FunctionCallbackInfo<v8::Value>& args);
+  // schedule(id, delay): (re)schedules the timer to expire in delay ms.
+  static void Schedule(const v8::FunctionCallbackInfo<v8::Value>& args);
+  // cancel(id): returns whether the timer was scheduled.
+  static void Cancel(const v8::FunctionCallbackInfo<v8::Value>& args);
+  static void Ref(const v8::FunctionCallbackInfo<v8::Value>& args);
+  static void Unref(const v8::FunctionCallbackInfo<v8::Value>& args);
+  static void GetSize(const v8::FunctionCallbackInfo<v8::Value>& args);
+
+  void MemoryInfo(MemoryTracker* tracker) const override;
+  SET_MEMORY_INFO_NAME(TimerWheelWrap)
+  SET_SELF_SIZE(TimerWheelWrap)
+
+ private:
+  struct Timer : public TimerWheel::Entry {
+    uint32_t id;
+  };
+
+  uint64_t Now() const;
+  void OnTimeout();
+  // Makes sure that the libuv timer fires no later than the next wakeup of
+  // the wheel, plus the Environment's timer slack.
+  void UpdateTimer();
+
+  TimerWheel wheel_;
+  std::unordered_map<uint32_t, Timer> timers_;
+  std::vector<TimerWheel::Entry*> expired_;
+  TimerWrapHandle timer_;
+  v8::Global<v8::Function> callback_;
+  // The time at which the libuv timer fires, or 0 if it is stopped.
+  uint64_t timer_expiry_ = 0;
+};
+
 }  // namespace timers
 
 }  // namespace node
@@ -1,6 +1,9 @@
 #include "tracing/agent.h"
 
+#include <algorithm>
 #include <string>
+#include <string_view>
+#include <vector>
 #include "trace_event.h"
 #include "tracing/node_trace_buffer.h"
 #include "debug_utils-inl.h"
@@ -90,6 +93,7 @@ void Agent::Start() {
   NodeTraceBuffer* trace_buffer_ = new NodeTraceBuffer(
       NodeTraceBuffer::kBufferChunks, this, &tracing_loop_);
   tracing_controller_->Initialize(trace_buffer_);
+  tracing_controller_->set_trace_buffer(trace_buffer_);
 
   // This thread should be created *after* async handles are created
   // (within NodeTraceWriter and NodeTraceBuffer constructors).
@@ -144,6 +148,7 @@ void Agent::StopTracing() {
   // Perform final Flush on TraceBuffer. We don't want the tracing controller
   // to flush the buffer again on destruction of the V8::Platform.
   tracing_controller_->StopTracing();
+  tracing_controller_->set_trace_buffer(nullptr);
   tracing_controller_->Initialize(nullptr);
   started_ = false;
 
@@ -223,6 +228,217 @@ void Agent::Flush(bool blocking) {
     id_writer.second->Flush(blocking);
 }
 
+namespace {
+
+uint64_t SplitMix64(uint64_t x) {
+  x += 0x9e3779b97f4a7c15;
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111eb;
+  return x ^ (x >> 31);
+}
+
+// Maps |x| uniformly onto [0, 1).
+double ToUnitInterval(uint64_t x) {
+  return static_cast<double>(x >> 11) * (1.0 / (UINT64_C(1) << 53));
+}
+
+bool IsAsyncPhase(char phase) {
+  switch (phase) {
+    case TRACE_EVENT_PHASE_ASYNC_BEGIN:
+    case TRACE_EVENT_PHASE_ASYNC_STEP_INTO:
+    case TRACE_EVENT_PHASE_ASYNC_STEP_PAST:
+    case TRACE_EVENT_PHASE_ASYNC_END:
+    case TRACE_EVENT_PHASE_NESTABLE_ASYNC_BEGIN:
+    case TRACE_EVENT_PHASE_NESTABLE_ASYNC_END:
+    case TRACE_EVENT_PHASE_NESTABLE_ASYNC_INSTANT:
+      return true;
+    default:
+      return false;
+  }
+}
+
+}  // namespace
+
+void TracingController::PublishSamplingTable() {
+  const SamplingTable* table = nullptr;
+  if (!sampled_categories_.empty()) {
+    static std::atomic<uint64_t> generations{0};
+    auto next = std::make_unique<SamplingTable>();
+    next->generation = ++generations;
+    next->categories = sampled_categories_;
+    table = next.get();
+    retained_tables_.push_back(std::move(next));
+  }
+  sampling_table_.store(table, std::memory_order_release);
+}
+
+void TracingController::SetSamplingConfig(const std::string& category,
+                                          const SamplingConfig& config) {
+  Mutex::ScopedLock lock(sampling_mutex_);
+  auto state = std::make_unique<SampledCategory>();
+  state->config = config;
+  // The statistics carry over; the rate limit starts afresh.
+  SampledCategory*& current = sampled_categories_[category];
+  if (current != nullptr) {
+    state->recorded = current->recorded.load(std::memory_order_relaxed);
+    state->dropped = current->dropped.load(std::memory_order_relaxed);
+  }
+  current = state.get();
+  retained_categories_.push_back(std::move(state));
+  PublishSamplingTable();
+}
+
+void TracingController::ClearSamplingConfig(const std::string& category) {
+  Mutex::ScopedLock lock(sampling_mutex_);
+  if (sampled_categories_.erase(category) > 0) PublishSamplingTable();
+}
+
+TracingController::SamplingStats TracingController::GetSamplingStats(
+    const std::string& category) {
+  Mutex::ScopedLock lock(sampling_mutex_);
+  auto it = sampled_categories_.find(category);
+  if (it == sampled_categories_.end()) return SamplingStats();
+  return SamplingStats{
+      it->second->recorded.load(std::memory_order_relaxed),
+      it->second->dropped.load(std::memory_order_relaxed)};
+}
+
+TracingController::SampledCategory* TracingController::GetSampledCategory(
+    const SamplingTable* table, const uint8_t* category_enabled_flag) {
+  // Resolved lazily for every category group, nullptr if it is not sampled.
+  thread_local uint64_t resolved_generation = 0;
+  thread_local std::unordered_map<const uint8_t*, SampledCategory*> resolved;
+  if (resolved_generation != table->generation) {
+    resolved.clear();
+    resolved_generation = table->generation;
+  }
+  auto it = resolved.find(category_enabled_flag);
+  if (it != resolved.end()) return it->second;
+
+  // The first sampled category of the group decides.
+  SampledCategory* state = nullptr;
+  std::string_view group = GetCategoryGroupName(category_enabled_flag);
+  while (!group.empty() && state == nullptr) {
+    size_t comma = group.find(',');
+    std::string category(group.substr(0, comma));
+    group = comma == std::string_view::npos ? std::string_view()
+                                            : group.substr(comma + 1);
+    auto config = table->categories.find(category);
+    if (config != table->categories.end()) state = config->second;
+  }
+  resolved.emplace(category_enabled_flag, state);
+  return state;
+}
+
+bool TracingController::ShouldRecord(char phase,
+                                     const uint8_t* category_enabled_flag,
+                                     uint64_t id) {
+  // Decisions for the currently open B/E slices of sampled categories on
+  // this thread, innermost last.
+  thread_local std::vector<bool> open_slices;
+  thread_local uint64_t random_state =
+      uv_hrtime() ^ reinterpret_cast<uintptr_t>(&open_slices);
+
+  if (phase == TRACE_EVENT_PHASE_METADATA) return true;
+
+  const SamplingTable* table =
+      sampling_table_.load(std::memory_order_acquire);
+  if (table == nullptr) return true;
+  SampledCategory* state = GetSampledCategory(table, category_enabled_flag);
+  if (state == nullptr) return true;
+
+  bool record;
+  if (phase == TRACE_EVENT_PHASE_END) {
+    record = open_slices.empty() || open_slices.back();
+    if (!open_slices.empty()) open_slices.pop_back();
+  } else {
+    const SamplingConfig& config = state->config;
+    double sample = IsAsyncPhase(phase)
+                        ? ToUnitInterval(SplitMix64(id))
+                        : ToUnitInterval(SplitMix64(random_state++));
+    record = sample < config.probability;
+    // Async end events are not rate limited, since their begin event has
+    // already been let through.
+    if (record && config.max_events_per_second > 0 &&
+        phase != TRACE_EVENT_PHASE_ASYNC_END &&
+        phase != TRACE_EVENT_PHASE_NESTABLE_ASYNC_END) {
+      // A token bucket that holds up to one second worth of events. Threads
+      // racing on the refill may credit a little more or less than the
+      // elapsed time, which only blurs the limit slightly.
+      uint64_t now = uv_hrtime();
+      uint64_t last =
+          state->last_refill.exchange(now, std::memory_order_relaxed);
+      double capacity = std::max(config.max_events_per_second, 1.0);
+      double refill = 0;
+      if (last == 0) {
+        refill = capacity;
+      } else if (now > last) {
+        refill = (now - last) / 1e9 * config.max_events_per_second;
+      }
+      double tokens = state->tokens.load(std::memory_order_relaxed);
+      double updated;
+      do {
+        updated = std::min(capacity, tokens + refill);
+        record = updated >= 1;
+        if (record) updated -= 1;
+      } while (!state->tokens.compare_exchange_weak(
+          tokens, updated, std::memory_order_relaxed));
+    }
+    if (phase == TRACE_EVENT_PHASE_BEGIN) open_slices.push_back(record);
+  }
+
+  if (record)
+    state->recorded.fetch_add(1, std::memory_order_relaxed);
+  else
+    state->dropped.fetch_add(1, std::memory_order_relaxed);
+  return record;
+}
+
+uint64_t TracingController::AddTraceEventWithTimestamp(
+    char phase,
+    const uint8_t* category_enabled_flag,
+    const char* name,
+    const char* scope,
+    uint64_t id,
+    uint64_t bind_id,
+    int32_t num_args,
+    const char** arg_names,
+    const uint8_t* arg_types,
+    const uint64_t* arg_values,
+    std::unique_ptr<v8::ConvertableToTraceFormat>* arg_convertables,
+    unsigned int flags,
+    int64_t timestamp) {
+  if (sampling_table_.load(std::memory_order_relaxed) != nullptr &&
+      !ShouldRecord(phase, category_enabled_flag, id)) {
+    // A zero handle has no event associated with it, so that
+    // UpdateTraceEventDuration() ignores it.
+    return 0;
+  }
+  uint64_t handle =
+      v8::platform::tracing::TracingController::AddTraceEventWithTimestamp(
+          phase,
+          category_enabled_flag,
+          name,
+          scope,
+          id,
+          bind_id,
+          num_args,
+          arg_names,
+          arg_types,
+          arg_values,
+          arg_convertables,
+          flags,
+          timestamp);
+  // A handle is only returned for an event that was added to the buffer, and
+  // the event has been initialized by now.
+  if (handle != 0) {
+    NodeTraceBuffer* trace_buffer =
+        node_trace_buffer_.load(std::memory_order_acquire);
+    if (trace_buffer != nullptr) trace_buffer->Publish(handle);
+  }
+  return handle;
+}
+
 void TracingController::AddMetadataEvent(
     const unsigned char* category_group_enabled,
     const char* name,
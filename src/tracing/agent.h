@@ -6,10 +6,13 @@
 #include "util.h"
 #include "node_mutex.h"
 
+#include <atomic>
 #include <list>
+#include <memory>
 #include <set>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 namespace v8 {
 class ConvertableToTraceFormat;
@@ -23,6 +26,7 @@ using v8::platform::tracing::TraceConfig;
 using v8::platform::tracing::TraceObject;
 
 class Agent;
+class NodeTraceBuffer;
 
 class AsyncTraceWriter {
  public:
@@ -39,6 +43,50 @@ class TracingController : public v8::platform::tracing::TracingController {
   int64_t CurrentTimestampMicroseconds() override {
     return uv_hrtime() / 1000;
   }
+
+  // Events of sampled categories are dropped before they reach the trace
+  // buffer, unless they are picked with |probability| and fit within
+  // |max_events_per_second| (0 meaning no limit). The decision for an async
+  // event depends only on its id, and end events follow their begin event,
+  // so that sampling does not split slices. The rate limit applies to each
+  // sampled category on its own.
+  struct SamplingConfig {
+    double probability = 1.0;
+    double max_events_per_second = 0;
+  };
+  struct SamplingStats {
+    uint64_t recorded = 0;
+    uint64_t dropped = 0;
+  };
+
+  // Applies to every category group that contains |category|.
+  void SetSamplingConfig(const std::string& category,
+                         const SamplingConfig& config);
+  void ClearSamplingConfig(const std::string& category);
+  SamplingStats GetSamplingStats(const std::string& category);
+
+  // AddTraceEvent() forwards to this, too.
+  uint64_t AddTraceEventWithTimestamp(
+      char phase,
+      const uint8_t* category_enabled_flag,
+      const char* name,
+      const char* scope,
+      uint64_t id,
+      uint64_t bind_id,
+      int32_t num_args,
+      const char** arg_names,
+      const uint8_t* arg_types,
+      const uint64_t* arg_values,
+      std::unique_ptr<v8::ConvertableToTraceFormat>* arg_convertables,
+      unsigned int flags,
+      int64_t timestamp) override;
+
+  // The buffer passed to Initialize(), which is told when an event that was
+  // added to it is initialized.
+  void set_trace_buffer(NodeTraceBuffer* trace_buffer) {
+    node_trace_buffer_.store(trace_buffer, std::memory_order_release);
+  }
+
   void AddMetadataEvent(
       const unsigned char* category_group_enabled,
       const char* name,
@@ -48,6 +96,43 @@ class TracingController : public v8::platform::tracing::TracingController {
       const uint64_t* arg_values,
       std::unique_ptr<v8::ConvertableToTraceFormat>* convertable_values,
       unsigned int flags);
+
+ private:
+  // The state of a sampled category, updated without locking by the threads
+  // that add events.
+  struct SampledCategory {
+    SamplingConfig config;
+    std::atomic<double> tokens{0};
+    std::atomic<uint64_t> last_refill{0};
+    std::atomic<uint64_t> recorded{0};
+    std::atomic<uint64_t> dropped{0};
+  };
+  // An immutable snapshot of the sampled categories. Every change publishes
+  // a new one, so that events never need to take sampling_mutex_.
+  struct SamplingTable {
+    // Unique in the process, unlike the address of the table.
+    uint64_t generation;
+    std::unordered_map<std::string, SampledCategory*> categories;
+  };
+
+  bool ShouldRecord(char phase, const uint8_t* category_enabled_flag,
+                    uint64_t id);
+  SampledCategory* GetSampledCategory(const SamplingTable* table,
+                                      const uint8_t* category_enabled_flag);
+  // Must be called with sampling_mutex_ held.
+  void PublishSamplingTable();
+
+  std::atomic<NodeTraceBuffer*> node_trace_buffer_{nullptr};
+  // nullptr while no category is sampled.
+  std::atomic<const SamplingTable*> sampling_table_{nullptr};
+  // Serializes changes to the sampling configuration.
+  Mutex sampling_mutex_;
+  std::unordered_map<std::string, SampledCategory*> sampled_categories_;
+  // Events on other threads may still be using replaced tables and
+  // categories, so they are only freed with the controller. Changes to the
+  // configuration are rare enough for that not to matter.
+  std::vector<std::unique_ptr<SamplingTable>> retained_tables_;
+  std::vector<std::unique_ptr<SampledCategory>> retained_categories_;
 };
 
 class AgentWriterHandle {
@@ -1,5 +1,6 @@
 #include "tracing/node_trace_buffer.h"
 
+#include <algorithm>
 #include <memory>
 #include "util-inl.h"
 
@@ -9,30 +10,65 @@ namespace tracing {
 InternalTraceBuffer::InternalTraceBuffer(size_t max_chunks, uint32_t id,
                                          Agent* agent)
     : flushing_(false), max_chunks_(max_chunks),
-      agent_(agent), id_(id) {
-  chunks_.resize(max_chunks);
+      agent_(agent), chunks_(new std::atomic<TraceBufferChunk*>[max_chunks]),
+      published_(new std::atomic<bool>[Capacity()]), id_(id) {
+  for (size_t i = 0; i < max_chunks_; ++i)
+    chunks_[i].store(nullptr, std::memory_order_relaxed);
+  for (size_t i = 0; i < Capacity(); ++i)
+    published_[i].store(false, std::memory_order_relaxed);
+}
+
+InternalTraceBuffer::~InternalTraceBuffer() {
+  for (size_t i = 0; i < max_chunks_; ++i)
+    delete chunks_[i].load(std::memory_order_relaxed);
+}
+
+TraceBufferChunk* InternalTraceBuffer::GetOrCreateChunk(size_t chunk_index) {
+  std::atomic<TraceBufferChunk*>& slot = chunks_[chunk_index];
+  TraceBufferChunk* chunk = slot.load(std::memory_order_acquire);
+  if (chunk != nullptr) return chunk;
+  auto created = std::make_unique<TraceBufferChunk>(0);
+  if (slot.compare_exchange_strong(
+          chunk, created.get(), std::memory_order_acq_rel)) {
+    return created.release();
+  }
+  // Another thread created the chunk first.
+  return chunk;
 }
 
 TraceObject* InternalTraceBuffer::AddTraceEvent(uint64_t* handle) {
-  Mutex::ScopedLock scoped_lock(mutex_);
-  // Create new chunk if last chunk is full or there is no chunk.
-  if (total_chunks_ == 0 || chunks_[total_chunks_ - 1]->IsFull()) {
-    auto& chunk = chunks_[total_chunks_++];
-    if (chunk) {
-      chunk->Reset(current_chunk_seq_++);
-    } else {
-      chunk = std::make_unique<TraceBufferChunk>(current_chunk_seq_++);
-    }
+  // Counted before the slot is claimed, so that a flush that no longer sees
+  // the add in flight also sees the claim.
+  adds_in_flight_.fetch_add(1);
+  size_t slot = next_slot_.fetch_add(1, std::memory_order_relaxed);
+  if (slot >= Capacity()) {
+    // Full, or being flushed.
+    adds_in_flight_.fetch_sub(1);
+    *handle = 0;
+    return nullptr;
   }
-  auto& chunk = chunks_[total_chunks_ - 1];
-  size_t event_index;
-  TraceObject* trace_object = chunk->AddTraceEvent(&event_index);
-  *handle = MakeHandle(total_chunks_ - 1, chunk->seq(), event_index);
-  return trace_object;
+  size_t chunk_index = slot / TraceBufferChunk::kChunkSize;
+  size_t event_index = slot % TraceBufferChunk::kChunkSize;
+  TraceBufferChunk* chunk = GetOrCreateChunk(chunk_index);
+  *handle = MakeHandle(chunk_index,
+                       seq_.load(std::memory_order_relaxed),
+                       event_index);
+  return chunk->GetEventAt(event_index);
+}
+
+void InternalTraceBuffer::Publish(uint64_t handle) {
+  size_t chunk_index, event_index;
+  uint32_t buffer_id, chunk_seq;
+  ExtractHandle(handle, &buffer_id, &chunk_index, &chunk_seq, &event_index);
+  CHECK_EQ(buffer_id, id_);
+  // Flush() does not start a new sequence while the add is in flight.
+  DCHECK_EQ(chunk_seq, seq_.load(std::memory_order_relaxed));
+  published_[chunk_index * TraceBufferChunk::kChunkSize + event_index].store(
+      true, std::memory_order_release);
+  adds_in_flight_.fetch_sub(1);
 }
 
 TraceObject* InternalTraceBuffer::GetEventByHandle(uint64_t handle) {
-  Mutex::ScopedLock scoped_lock(mutex_);
   if (handle == 0) {
     // A handle value of zero never has a trace event associated with it.
     return nullptr;
@@ -40,40 +76,48 @@ TraceObject* InternalTraceBuffer::GetEventByHandle(uint64_t handle) {
   size_t chunk_index, event_index;
   uint32_t buffer_id, chunk_seq;
   ExtractHandle(handle, &buffer_id, &chunk_index, &chunk_seq, &event_index);
-  if (buffer_id != id_ || chunk_index >= total_chunks_) {
-    // Either the chunk belongs to the other buffer, or is outside the current
-    // range of chunks loaded in memory (the latter being true suggests that
-    // the chunk has already been flushed and is no longer in memory.)
+  if (buffer_id != id_ || chunk_seq != seq_.load(std::memory_order_relaxed)) {
+    // Either the event belongs to the other buffer, or it has already been
+    // flushed and is no longer in memory.
     return nullptr;
   }
-  auto& chunk = chunks_[chunk_index];
-  if (chunk->seq() != chunk_seq) {
-    // Chunk is no longer in memory.
+  size_t slot = chunk_index * TraceBufferChunk::kChunkSize + event_index;
+  if (slot >= std::min(next_slot_.load(std::memory_order_relaxed),
+                       Capacity())) {
     return nullptr;
   }
+  TraceBufferChunk* chunk =
+      chunks_[chunk_index].load(std::memory_order_acquire);
+  if (chunk == nullptr) return nullptr;
   return chunk->GetEventAt(event_index);
 }
 
 void InternalTraceBuffer::Flush(bool blocking) {
   {
     Mutex::ScopedLock scoped_lock(mutex_);
-    if (total_chunks_ > 0) {
+    // Mark the buffer as full while it is flushed, so that new events go to
+    // the other buffer.
+    size_t claimed = std::min(next_slot_.exchange(Capacity()), Capacity());
+    // No slot can be claimed from here on. When no add is in flight either,
+    // every claimed slot is published, and the slots can be handed out
+    // again after this flush. Otherwise, a thread may still write to its
+    // slot.
+    const bool settled = adds_in_flight_.load() == 0;
+    if (claimed > 0) {
       flushing_ = true;
-      for (size_t i = 0; i < total_chunks_; ++i) {
-        auto& chunk = chunks_[i];
-        for (size_t j = 0; j < chunk->size(); ++j) {
-          TraceObject* trace_event = chunk->GetEventAt(j);
-          // Another thread may have added a trace that is yet to be
-          // initialized. Skip such traces.
-          // https://github.com/nodejs/node/issues/21038.
-          if (trace_event->name()) {
-            agent_->AppendTraceEvent(trace_event);
-          }
-        }
+      for (size_t slot = 0; slot < claimed; ++slot) {
+        if (!published_[slot].load(std::memory_order_acquire)) continue;
+        published_[slot].store(false, std::memory_order_relaxed);
+        TraceBufferChunk* chunk =
+            chunks_[slot / TraceBufferChunk::kChunkSize].load(
+                std::memory_order_acquire);
+        agent_->AppendTraceEvent(
+            chunk->GetEventAt(slot % TraceBufferChunk::kChunkSize));
       }
-      total_chunks_ = 0;
+      if (settled) seq_.fetch_add(1, std::memory_order_relaxed);
       flushing_ = false;
     }
+    if (settled) next_slot_.store(0, std::memory_order_release);
   }
   agent_->Flush(blocking);
 }
@@ -136,6 +180,11 @@ TraceObject* NodeTraceBuffer::GetEventByHandle(uint64_t handle) {
   return current_buf_.load()->GetEventByHandle(handle);
 }
 
+void NodeTraceBuffer::Publish(uint64_t handle) {
+  // The lowest bit of a handle is the id of its buffer.
+  ((handle & 0x1) == 0 ? buffer1_ : buffer2_).Publish(handle);
+}
+
 bool NodeTraceBuffer::Flush() {
   buffer1_.Flush(true);
   buffer2_.Flush(true);
@@ -17,18 +17,29 @@ using v8::platform::tracing::TraceObject;
 // forward declaration
 class NodeTraceBuffer;
 
+// Threads that add trace events claim slots with a single atomic increment,
+// so that events coming from the threadpool and V8's worker threads do not
+// contend on a lock. Only flushes, which are rare, take mutex_.
+//
+// A thread that got a trace object from AddTraceEvent() must call Publish()
+// once it has initialized it. Flush() only reads published events. It cannot
+// wait for the others, because V8's TracingController holds the lock that
+// events are initialized under while it flushes: while an add is in flight,
+// the buffer stays full, and a later flush picks up the rest of its events.
 class InternalTraceBuffer {
  public:
   InternalTraceBuffer(size_t max_chunks, uint32_t id, Agent* agent);
+  ~InternalTraceBuffer();
 
   TraceObject* AddTraceEvent(uint64_t* handle);
+  void Publish(uint64_t handle);
   TraceObject* GetEventByHandle(uint64_t handle);
   void Flush(bool blocking);
   bool IsFull() const {
-    return total_chunks_ == max_chunks_ && chunks_[total_chunks_ - 1]->IsFull();
+    return next_slot_.load(std::memory_order_relaxed) >= Capacity();
   }
   bool IsFlushing() const {
-    return flushing_;
+    return flushing_.load(std::memory_order_relaxed);
   }
 
  private:
@@ -37,14 +48,26 @@ class InternalTraceBuffer {
   void ExtractHandle(uint64_t handle, uint32_t* buffer_id, size_t* chunk_index,
                      uint32_t* chunk_seq, size_t* event_index) const;
   size_t Capacity() const { return max_chunks_ * TraceBufferChunk::kChunkSize; }
+  TraceBufferChunk* GetOrCreateChunk(size_t chunk_index);
 
   Mutex mutex_;
-  bool flushing_;
+  std::atomic<bool> flushing_;
   size_t max_chunks_;
   Agent* agent_;
-  std::vector<std::unique_ptr<TraceBufferChunk>> chunks_;
-  size_t total_chunks_ = 0;
-  uint32_t current_chunk_seq_ = 1;
+  // Allocated on first use, and reused after every flush.
+  std::unique_ptr<std::atomic<TraceBufferChunk*>[]> chunks_;
+  // The next slot to hand out. Slots at or past Capacity() mean that the
+  // buffer is full.
+  std::atomic<size_t> next_slot_{0};
+  // The calls to AddTraceEvent() that have not returned yet, or whose event
+  // is not published yet.
+  std::atomic<size_t> adds_in_flight_{0};
+  // Set for the slots whose event has been published, and cleared when
+  // Flush() has passed that event on.
+  std::unique_ptr<std::atomic<bool>[]> published_;
+  // Incremented by every flush, so that handles to flushed events become
+  // invalid.
+  std::atomic<uint32_t> seq_{1};
   uint32_t id_;
 };
 
@@ -56,6 +79,8 @@ class NodeTraceBuffer : public TraceBuffer {
   TraceObject* AddTraceEvent(uint64_t* handle) override;
   TraceObject* GetEventByHandle(uint64_t handle) override;
   bool Flush() override;
+  // Called by TracingController once the event of |handle| is initialized.
+  void Publish(uint64_t handle);
 
   static const size_t kBufferChunks = 1024;
 
@@ -0,0 +1,432 @@
+#include "tracing/perfetto_trace_writer.h"
+
+#include "node_internals.h"
+#include "tracing/trace_event_common.h"
+#include "util-inl.h"
+
+#include <cstring>
+#include <functional>
+
+namespace node {
+namespace tracing {
+
+namespace {
+
+// Field numbers from perfetto's protos/perfetto/trace/.
+namespace trace {
+constexpr uint32_t kPacket = 1;
+}  // namespace trace
+
+namespace trace_packet {
+constexpr uint32_t kTimestamp = 8;
+constexpr uint32_t kTrustedPacketSequenceId = 10;
+constexpr uint32_t kTrackEvent = 11;
+constexpr uint32_t kInternedData = 12;
+constexpr uint32_t kSequenceFlags = 13;
+constexpr uint32_t kTrackDescriptor = 60;
+
+constexpr uint32_t kSeqIncrementalStateCleared = 1;
+constexpr uint32_t kSeqNeedsIncrementalState = 2;
+}  // namespace trace_packet
+
+namespace track_event {
+constexpr uint32_t kCategoryIids = 3;
+constexpr uint32_t kDebugAnnotations = 4;
+constexpr uint32_t kType = 9;
+constexpr uint32_t kNameIid = 10;
+constexpr uint32_t kTrackUuid = 11;
+constexpr uint32_t kCounterValue = 30;
+constexpr uint32_t kDoubleCounterValue = 44;
+
+constexpr uint64_t kTypeSliceBegin = 1;
+constexpr uint64_t kTypeSliceEnd = 2;
+constexpr uint64_t kTypeInstant = 3;
+constexpr uint64_t kTypeCounter = 4;
+}  // namespace track_event
+
+namespace interned_data {
+constexpr uint32_t kEventCategories = 1;
+constexpr uint32_t kEventNames = 2;
+constexpr uint32_t kDebugAnnotationNames = 3;
+// EventCategory, EventName and DebugAnnotationName share these.
+constexpr uint32_t kIid = 1;
+constexpr uint32_t kName = 2;
+}  // namespace interned_data
+
+namespace debug_annotation {
+constexpr uint32_t kNameIid = 1;
+constexpr uint32_t kBoolValue = 2;
+constexpr uint32_t kUintValue = 3;
+constexpr uint32_t kIntValue = 4;
+constexpr uint32_t kDoubleValue = 5;
+constexpr uint32_t kStringValue = 6;
+constexpr uint32_t kPointerValue = 7;
+constexpr uint32_t kLegacyJsonValue = 9;
+}  // namespace debug_annotation
+
+namespace track_descriptor {
+constexpr uint32_t kUuid = 1;
+constexpr uint32_t kName = 2;
+constexpr uint32_t kProcess = 3;
+constexpr uint32_t kThread = 4;
+constexpr uint32_t kParentUuid = 5;
+constexpr uint32_t kCounter = 8;
+
+constexpr uint32_t kProcessPid = 1;
+constexpr uint32_t kProcessName = 6;
+constexpr uint32_t kThreadPid = 1;
+constexpr uint32_t kThreadTid = 2;
+constexpr uint32_t kThreadName = 5;
+}  // namespace track_descriptor
+
+constexpr uint32_t kSequenceId = 1;
+
+// Distinguishes the kinds of tracks, whose uuids are otherwise derived from
+// pids, tids, ids and names.
+constexpr uint64_t kProcessTrackTag = 1;
+constexpr uint64_t kThreadTrackTag = 2;
+constexpr uint64_t kAsyncTrackTag = 3;
+constexpr uint64_t kCounterTrackTag = 4;
+
+const char* CategoryGroupName(TraceObject* trace_event) {
+  return v8::platform::tracing::TracingController::GetCategoryGroupName(
+      trace_event->category_enabled_flag());
+}
+
+uint64_t TrackUuid(uint64_t tag, uint64_t value) {
+  return (value << 3) ^ (value >> 61) ^ tag;
+}
+
+}  // namespace
+
+PerfettoTraceWriter::PerfettoTraceWriter(std::ostream& stream)
+    : stream_(stream) {}
+
+uint64_t PerfettoTraceWriter::Intern(InternedKind kind,
+                                     std::string_view value,
+                                     ProtoWriter* interned) {
+  std::unordered_map<std::string, uint64_t>* table;
+  uint32_t field;
+  switch (kind) {
+    case InternedKind::kCategory:
+      table = &categories_;
+      field = interned_data::kEventCategories;
+      break;
+    case InternedKind::kEventName:
+      table = &event_names_;
+      field = interned_data::kEventNames;
+      break;
+    case InternedKind::kAnnotationName:
+      table = &annotation_names_;
+      field = interned_data::kDebugAnnotationNames;
+      break;
+  }
+  auto [it, inserted] = table->emplace(value, table->size() + 1);
+  if (inserted) {
+    ProtoWriter entry;
+    entry.Varint(interned_data::kIid, it->second);
+    entry.Bytes(interned_data::kName, value);
+    interned->Message(field, entry);
+  }
+  return it->second;
+}
+
+void PerfettoTraceWriter::WritePacket(ProtoWriter* packets,
+                                      uint64_t timestamp,
+                                      const ProtoWriter& track_event,
+                                      const ProtoWriter& interned) {
+  ProtoWriter packet;
+  packet.Varint(trace_packet::kTimestamp, timestamp);
+  packet.Varint(trace_packet::kTrustedPacketSequenceId, kSequenceId);
+  uint32_t flags = trace_packet::kSeqNeedsIncrementalState;
+  if (first_packet_) {
+    flags |= trace_packet::kSeqIncrementalStateCleared;
+    first_packet_ = false;
+  }
+  packet.Varint(trace_packet::kSequenceFlags, flags);
+  if (!interned.empty())
+    packet.Message(trace_packet::kInternedData, interned);
+  packet.Message(trace_packet::kTrackEvent, track_event);
+  packets->Message(trace::kPacket, packet);
+}
+
+uint64_t PerfettoTraceWriter::ProcessTrack(int pid, ProtoWriter* packets) {
+  uint64_t uuid = TrackUuid(kProcessTrackTag, static_cast<uint32_t>(pid));
+  if (tracks_.insert(uuid).second) {
+    auto it = process_names_.find(pid);
+    ProtoWriter process;
+    process.Int(track_descriptor::kProcessPid, pid);
+    process.Bytes(track_descriptor::kProcessName,
+                  it != process_names_.end() ? it->second
+                                             : GetProcessTitle("node"));
+    ProtoWriter descriptor;
+    descriptor.Varint(track_descriptor::kUuid, uuid);
+    descriptor.Message(track_descriptor::kProcess, process);
+    ProtoWriter packet;
+    packet.Message(trace_packet::kTrackDescriptor, descriptor);
+    packets->Message(trace::kPacket, packet);
+  }
+  return uuid;
+}
+
+uint64_t PerfettoTraceWriter::ThreadTrack(int pid,
+                                          int tid,
+                                          ProtoWriter* packets) {
+  uint64_t uuid =
+      TrackUuid(kThreadTrackTag,
+                (static_cast<uint64_t>(static_cast<uint32_t>(pid)) << 32) |
+                    static_cast<uint32_t>(tid));
+  if (tracks_.find(uuid) == tracks_.end()) {
+    uint64_t parent = ProcessTrack(pid, packets);
+    tracks_.insert(uuid);
+    ProtoWriter thread;
+    thread.Int(track_descriptor::kThreadPid, pid);
+    thread.Int(track_descriptor::kThreadTid, tid);
+    ProtoWriter descriptor;
+    descriptor.Varint(track_descriptor::kUuid, uuid);
+    descriptor.Varint(track_descriptor::kParentUuid, parent);
+    descriptor.Message(track_descriptor::kThread, thread);
+    ProtoWriter packet;
+    packet.Message(trace_packet::kTrackDescriptor, descriptor);
+    packets->Message(trace::kPacket, packet);
+  }
+  return uuid;
+}
+
+uint64_t PerfettoTraceWriter::AsyncTrack(TraceObject* trace_event,
+                                         ProtoWriter* packets) {
+  // Async events with the same category, scope and id belong together.
+  std::string key = CategoryGroupName(trace_event);
+  key += '\0';
+  if (trace_event->scope() != nullptr) key += trace_event->scope();
+  uint64_t uuid = TrackUuid(kAsyncTrackTag,
+                            std::hash<std::string>()(key) ^ trace_event->id());
+  if (tracks_.find(uuid) == tracks_.end()) {
+    uint64_t parent = ProcessTrack(trace_event->pid(), packets);
+    tracks_.insert(uuid);
+    ProtoWriter descriptor;
+    descriptor.Varint(track_descriptor::kUuid, uuid);
+    descriptor.Varint(track_descriptor::kParentUuid, parent);
+    descriptor.Bytes(track_descriptor::kName, trace_event->name());
+    ProtoWriter packet;
+    packet.Message(trace_packet::kTrackDescriptor, descriptor);
+    packets->Message(trace::kPacket, packet);
+  }
+  return uuid;
+}
+
+uint64_t PerfettoTraceWriter::CounterTrack(TraceObject* trace_event,
+                                           const char* arg_name,
+                                           ProtoWriter* packets) {
+  std::string name = trace_event->name();
+  if (strcmp(arg_name, "value") != 0) {
+    name += '.';
+    name += arg_name;
+  }
+  uint64_t uuid = TrackUuid(kCounterTrackTag,
+                            std::hash<std::string>()(name) ^
+                                static_cast<uint32_t>(trace_event->pid()));
+  if (tracks_.find(uuid) == tracks_.end()) {
+    uint64_t parent = ProcessTrack(trace_event->pid(), packets);
+    tracks_.insert(uuid);
+    ProtoWriter descriptor;
+    descriptor.Varint(track_descriptor::kUuid, uuid);
+    descriptor.Varint(track_descriptor::kParentUuid, parent);
+    descriptor.Bytes(track_descriptor::kName, name);
+    descriptor.Message(track_descriptor::kCounter, ProtoWriter());
+    ProtoWriter packet;
+    packet.Message(trace_packet::kTrackDescriptor, descriptor);
+    packets->Message(trace::kPacket, packet);
+  }
+  return uuid;
+}
+
+// Turns the process_name and thread_name metadata events into track names.
+void PerfettoTraceWriter::AppendMetadata(TraceObject* trace_event,
+                                         ProtoWriter* packets) {
+  if (trace_event->num_args() < 1 ||
+      (trace_event->arg_types()[0] != TRACE_VALUE_TYPE_STRING &&
+       trace_event->arg_types()[0] != TRACE_VALUE_TYPE_COPY_STRING) ||
+      trace_event->arg_values()[0].as_string == nullptr) {
+    return;
+  }
+  std::string_view value = trace_event->arg_values()[0].as_string;
+  ProtoWriter descriptor;
+  if (strcmp(trace_event->name(), "process_name") == 0) {
+    // Once the process track has been described, a new name would take a
+    // second descriptor for it, which is not written.
+    const uint64_t uuid =
+        TrackUuid(kProcessTrackTag, static_cast<uint32_t>(trace_event->pid()));
+    if (tracks_.find(uuid) == tracks_.end()) {
+      process_names_[trace_event->pid()] = value;
+      ProcessTrack(trace_event->pid(), packets);
+    }
+    return;
+  } else if (strcmp(trace_event->name(), "thread_name") == 0) {
+    uint64_t uuid =
+        ThreadTrack(trace_event->pid(), trace_event->tid(), packets);
+    ProtoWriter thread;
+    thread.Int(track_descriptor::kThreadPid, trace_event->pid());
+    thread.Int(track_descriptor::kThreadTid, trace_event->tid());
+    thread.Bytes(track_descriptor::kThreadName, value);
+    descriptor.Varint(track_descriptor::kUuid, uuid);
+    descriptor.Varint(track_descriptor::kParentUuid,
+                      ProcessTrack(trace_event->pid(), packets));
+    descriptor.Message(track_descriptor::kThread, thread);
+  } else {
+    return;
+  }
+  ProtoWriter packet;
+  packet.Message(trace_packet::kTrackDescriptor, descriptor);
+  packets->Message(trace::kPacket, packet);
+}
+
+void PerfettoTraceWriter::AppendTraceEvent(TraceObject* trace_event) {
+  ProtoWriter packets;
+  char phase = trace_event->phase();
+  if (phase == TRACE_EVENT_PHASE_METADATA) {
+    AppendMetadata(trace_event, &packets);
+    stream_ << packets.data();
+    return;
+  }
+
+  // Perfetto timestamps are in nanoseconds.
+  uint64_t timestamp = static_cast<uint64_t>(trace_event->ts()) * 1000;
+  const char** arg_names = trace_event->arg_names();
+  const uint8_t* arg_types = trace_event->arg_types();
+  TraceObject::ArgValue* arg_values = trace_event->arg_values();
+
+  if (phase == TRACE_EVENT_PHASE_COUNTER) {
+    // One counter track per argument, like the JSON viewer shows them.
+    for (int i = 0; i < trace_event->num_args(); ++i) {
+      ProtoWriter event;
+      event.Varint(track_event::kType, track_event::kTypeCounter);
+      event.Varint(track_event::kTrackUuid,
+                   CounterTrack(trace_event, arg_names[i], &packets));
+      switch (arg_types[i]) {
+        case TRACE_VALUE_TYPE_UINT:
+          event.Int(track_event::kCounterValue,
+                    static_cast<int64_t>(arg_values[i].as_uint));
+          break;
+        case TRACE_VALUE_TYPE_INT:
+          event.Int(track_event::kCounterValue, arg_values[i].as_int);
+          break;
+        case TRACE_VALUE_TYPE_DOUBLE:
+          event.Double(track_event::kDoubleCounterValue,
+                       arg_values[i].as_double);
+          break;
+        default:
+          continue;
+      }
+      WritePacket(&packets, timestamp, event, ProtoWriter());
+    }
+    stream_ << packets.data();
+    return;
+  }
+
+  uint64_t type;
+  bool async = false;
+  switch (phase) {
+    case TRACE_EVENT_PHASE_BEGIN:
+    case TRACE_EVENT_PHASE_COMPLETE:
+      type = track_event::kTypeSliceBegin;
+      break;
+    case TRACE_EVENT_PHASE_END:
+      type = track_event::kTypeSliceEnd;
+      break;
+    case TRACE_EVENT_PHASE_ASYNC_BEGIN:
+    case TRACE_EVENT_PHASE_NESTABLE_ASYNC_BEGIN:
+      type = track_event::kTypeSliceBegin;
+      async = true;
+      break;
+    case TRACE_EVENT_PHASE_ASYNC_END:
+    case TRACE_EVENT_PHASE_NESTABLE_ASYNC_END:
+      type = track_event::kTypeSliceEnd;
+      async = true;
+      break;
+    case TRACE_EVENT_PHASE_ASYNC_STEP_INTO:
+    case TRACE_EVENT_PHASE_ASYNC_STEP_PAST:
+    case TRACE_EVENT_PHASE_NESTABLE_ASYNC_INSTANT:
+      type = track_event::kTypeInstant;
+      async = true;
+      break;
+    default:
+      type = track_event::kTypeInstant;
+      break;
+  }
+
+  uint64_t track =
+      async ? AsyncTrack(trace_event, &packets)
+            : ThreadTrack(trace_event->pid(), trace_event->tid(), &packets);
+
+  ProtoWriter interned;
+  ProtoWriter event;
+  event.Varint(track_event::kType, type);
+  event.Varint(track_event::kTrackUuid, track);
+  event.Varint(track_event::kCategoryIids,
+               Intern(InternedKind::kCategory,
+                      CategoryGroupName(trace_event),
+                      &interned));
+  if (type != track_event::kTypeSliceEnd || async) {
+    event.Varint(
+        track_event::kNameIid,
+        Intern(InternedKind::kEventName, trace_event->name(), &interned));
+  }
+
+  for (int i = 0; i < trace_event->num_args(); ++i) {
+    ProtoWriter annotation;
+    annotation.Varint(
+        debug_annotation::kNameIid,
+        Intern(InternedKind::kAnnotationName, arg_names[i], &interned));
+    const TraceObject::ArgValue& value = arg_values[i];
+    switch (arg_types[i]) {
+      case TRACE_VALUE_TYPE_BOOL:
+        annotation.Varint(debug_annotation::kBoolValue, value.as_uint ? 1 : 0);
+        break;
+      case TRACE_VALUE_TYPE_UINT:
+        annotation.Varint(debug_annotation::kUintValue, value.as_uint);
+        break;
+      case TRACE_VALUE_TYPE_INT:
+        annotation.Int(debug_annotation::kIntValue, value.as_int);
+        break;
+      case TRACE_VALUE_TYPE_DOUBLE:
+        annotation.Double(debug_annotation::kDoubleValue, value.as_double);
+        break;
+      case TRACE_VALUE_TYPE_POINTER:
+        annotation.Varint(debug_annotation::kPointerValue,
+                          reinterpret_cast<uintptr_t>(value.as_pointer));
+        break;
+      case TRACE_VALUE_TYPE_STRING:
+      case TRACE_VALUE_TYPE_COPY_STRING:
+        annotation.Bytes(debug_annotation::kStringValue,
+                         value.as_string != nullptr ? value.as_string : "");
+        break;
+      case TRACE_VALUE_TYPE_CONVERTABLE: {
+        std::string json;
+        trace_event->arg_convertables()[i]->AppendAsTraceFormat(&json);
+        annotation.Bytes(debug_annotation::kLegacyJsonValue, json);
+        break;
+      }
+      default:
+        UNREACHABLE();
+    }
+    event.Message(track_event::kDebugAnnotations, annotation);
+  }
+  WritePacket(&packets, timestamp, event, interned);
+
+  if (phase == TRACE_EVENT_PHASE_COMPLETE) {
+    ProtoWriter end;
+    end.Varint(track_event::kType, track_event::kTypeSliceEnd);
+    end.Varint(track_event::kTrackUuid, track);
+    WritePacket(&packets,
+                timestamp + trace_event->duration() * 1000,
+                end,
+                ProtoWriter());
+  }
+  stream_ << packets.data();
+}
+
+void PerfettoTraceWriter::Flush() {}
+
+}  // namespace tracing
+}  // namespace node
@@ -0,0 +1,71 @@
+#ifndef SRC_TRACING_PERFETTO_TRACE_WRITER_H_
+#define SRC_TRACING_PERFETTO_TRACE_WRITER_H_
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "libplatform/v8-tracing.h"
+#include "proto_writer.h"
+
+namespace node {
+namespace tracing {
+
+using v8::platform::tracing::TraceObject;
+using v8::platform::tracing::TraceWriter;
+
+// Serializes trace events as a Perfetto trace, i.e. a protobuf `Trace`
+// message that is a plain sequence of `TracePacket`s, so that it can be
+// written out in chunks. Event names, categories and argument names are
+// interned, which makes the output much smaller than the JSON format.
+//
+// Every writer starts a new packet sequence, which is why NodeTraceWriter
+// creates one per file.
+class PerfettoTraceWriter : public TraceWriter {
+ public:
+  explicit PerfettoTraceWriter(std::ostream& stream);
+
+  void AppendTraceEvent(TraceObject* trace_event) override;
+  void Flush() override;
+
+ private:
+  enum class InternedKind { kCategory, kEventName, kAnnotationName };
+
+  // Returns the interning id of |value|, adding it to |interned| if it is
+  // seen for the first time.
+  uint64_t Intern(InternedKind kind,
+                  std::string_view value,
+                  ProtoWriter* interned);
+  uint64_t ThreadTrack(int pid, int tid, ProtoWriter* packets);
+  // The descriptor of a process track is written once, when it is first
+  // used, with the name from an earlier process_name event, or else the
+  // process title.
+  uint64_t ProcessTrack(int pid, ProtoWriter* packets);
+  uint64_t AsyncTrack(TraceObject* trace_event, ProtoWriter* packets);
+  uint64_t CounterTrack(TraceObject* trace_event,
+                        const char* arg_name,
+                        ProtoWriter* packets);
+  void AppendMetadata(TraceObject* trace_event, ProtoWriter* packets);
+  void WritePacket(ProtoWriter* packets,
+                   uint64_t timestamp,
+                   const ProtoWriter& track_event,
+                   const ProtoWriter& interned);
+
+  std::ostream& stream_;
+  bool first_packet_ = true;
+  std::unordered_map<std::string, uint64_t> categories_;
+  std::unordered_map<std::string, uint64_t> event_names_;
+  std::unordered_map<std::string, uint64_t> annotation_names_;
+  std::unordered_set<uint64_t> tracks_;
+  // Names from process_name events that arrived before the process track
+  // was first used.
+  std::unordered_map<int, std::string> process_names_;
+};
+
+}  // namespace tracing
+}  // namespace node
+
+#endif  // SRC_TRACING_PERFETTO_TRACE_WRITER_H_
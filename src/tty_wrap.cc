@@ -21,6 +21,7 @@
 
 #include "tty_wrap.h"
 
+#include "base_object-inl.h"
 #include "env-inl.h"
 #include "handle_wrap.h"
 #include "node_buffer.h"
@@ -46,6 +47,7 @@ void TTYWrap::RegisterExternalReferences(ExternalReferenceRegistry* registry) {
   registry->Register(New);
   registry->Register(GetWindowSize);
   registry->Register(SetRawMode);
+  registry->Register(SetBuffered);
   registry->Register(IsTTY);
 }
 
@@ -66,6 +68,7 @@ void TTYWrap::Initialize(Local<Object> target,
   SetProtoMethodNoSideEffect(
       isolate, t, "getWindowSize", TTYWrap::GetWindowSize);
   SetProtoMethod(isolate, t, "setRawMode", SetRawMode);
+  SetProtoMethod(isolate, t, "setBuffered", SetBuffered);
 
   SetMethodNoSideEffect(context, target, "isTTY", IsTTY);
 
@@ -131,6 +134,32 @@ void TTYWrap::SetRawMode(const FunctionCallbackInfo<Value>& args) {
 }
 
 
+void TTYWrap::SetBuffered(const FunctionCallbackInfo<Value>& args) {
+  TTYWrap* wrap;
+  ASSIGN_OR_RETURN_UNWRAP(&wrap, args.This());
+  bool enable = args[0]->IsTrue();
+  if (enable && !wrap->flush_at_exit_registered_) {
+    // The callback owns the weak reference, as at-exit callbacks cannot be
+    // removed again.
+    wrap->env()->AtExit(FlushAtExit, new BaseObjectWeakPtr<TTYWrap>(wrap));
+    wrap->flush_at_exit_registered_ = true;
+  }
+  wrap->set_write_coalescing(enable);
+}
+
+
+void TTYWrap::FlushAtExit(void* arg) {
+  std::unique_ptr<BaseObjectWeakPtr<TTYWrap>> wrap_ptr(
+      static_cast<BaseObjectWeakPtr<TTYWrap>*>(arg));
+  TTYWrap* wrap = wrap_ptr->get();
+  if (wrap == nullptr || !wrap->IsAlive() || wrap->IsClosing()) return;
+  // Nothing runs the event loop any more, so wait for the terminal instead
+  // of queueing what it does not take right away.
+  uv_stream_set_blocking(wrap->stream(), 1);
+  USE(wrap->WriteCoalescedDataForExit());
+}
+
+
 void TTYWrap::New(const FunctionCallbackInfo<Value>& args) {
   Environment* env = Environment::GetCurrent(args);
 
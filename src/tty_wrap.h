@@ -53,9 +53,18 @@ class TTYWrap : public LibuvStreamWrap {
   static void IsTTY(const v8::FunctionCallbackInfo<v8::Value>& args);
   static void GetWindowSize(const v8::FunctionCallbackInfo<v8::Value>& args);
   static void SetRawMode(const v8::FunctionCallbackInfo<v8::Value>& args);
+  // setBuffered(enable): in buffered mode, small writes are gathered and
+  // written together at the end of the loop iteration or once 64KiB have
+  // accumulated, see StreamBase::Write(). Data still gathered when the
+  // process exits, including through process.exit() or an uncaught
+  // exception, is written out synchronously.
+  static void SetBuffered(const v8::FunctionCallbackInfo<v8::Value>& args);
   static void New(const v8::FunctionCallbackInfo<v8::Value>& args);
 
+  static void FlushAtExit(void* arg);
+
   uv_tty_t handle_;
+  bool flush_at_exit_registered_ = false;
 };
 
 }  // namespace node
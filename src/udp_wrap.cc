@@ -30,6 +30,15 @@
 #include "req_wrap-inl.h"
 #include "util-inl.h"
 
+#if defined(__linux__)
+#include <netinet/in.h>
+#include <netinet/udp.h>
+#include <sys/socket.h>
+#if defined(UDP_SEGMENT)
+#define NODE_UDP_GSO 1
+#endif
+#endif
+
 namespace node {
 
 using errors::TryCatchScope;
@@ -37,6 +46,7 @@ using v8::Array;
 using v8::ArrayBuffer;
 using v8::BackingStore;
 using v8::BackingStoreInitializationMode;
+using v8::BackingStoreOnFailureMode;
 using v8::Boolean;
 using v8::Context;
 using v8::DontDelete;
@@ -46,6 +56,7 @@ using v8::HandleScope;
 using v8::Integer;
 using v8::Isolate;
 using v8::Local;
+using v8::LocalVector;
 using v8::MaybeLocal;
 using v8::Object;
 using v8::PropertyAttribute;
@@ -72,6 +83,14 @@ void SetLibuvInt32(const FunctionCallbackInfo<Value>& args) {
   int err = fn(wrap->GetLibuvHandle(), flag);
   args.GetReturnValue().Set(err);
 }
+
+#ifdef NODE_UDP_GSO
+// The kernel refuses to split a single send into more segments than this.
+constexpr unsigned int kMaxGsoSegments = 64;
+// Largest UDP payload that fits an IPv4 datagram; the super-packet handed
+// to the kernel must not exceed it.
+constexpr size_t kMaxGsoPayload = 65507;
+#endif  // NODE_UDP_GSO
 }  // namespace
 
 class SendWrap : public ReqWrap<uv_udp_send_t> {
@@ -142,7 +161,7 @@ void UDPWrapBase::RegisterExternalReferences(
   registry->Register(RecvStop);
 }
 
-UDPWrap::UDPWrap(Environment* env, Local<Object> object)
+UDPWrap::UDPWrap(Environment* env, Local<Object> object, unsigned int flags)
     : HandleWrap(env,
                  object,
                  reinterpret_cast<uv_handle_t*>(&handle_),
@@ -150,7 +169,7 @@ UDPWrap::UDPWrap(Environment* env, Local<Object> object)
   object->SetAlignedPointerInInternalField(
       UDPWrapBase::kUDPWrapBaseField, static_cast<UDPWrapBase*>(this));
 
-  int r = uv_udp_init(env->event_loop(), &handle_);
+  int r = uv_udp_init_ex(env->event_loop(), &handle_, AF_UNSPEC | flags);
   CHECK_EQ(r, 0);  // can't fail anyway
 
   set_listener(this);
@@ -189,6 +208,8 @@ void UDPWrap::Initialize(Local<Object> target,
   SetProtoMethod(isolate, t, "bind6", Bind6);
   SetProtoMethod(isolate, t, "connect6", Connect6);
   SetProtoMethod(isolate, t, "send6", Send6);
+  SetProtoMethod(isolate, t, "sendBatch", SendBatch);
+  SetProtoMethod(isolate, t, "sendBatch6", SendBatch6);
   SetProtoMethod(isolate, t, "disconnect", Disconnect);
   SetProtoMethod(isolate,
                  t,
@@ -234,6 +255,7 @@ void UDPWrap::Initialize(Local<Object> target,
   NODE_DEFINE_CONSTANT(constants, UV_UDP_IPV6ONLY);
   NODE_DEFINE_CONSTANT(constants, UV_UDP_REUSEADDR);
   NODE_DEFINE_CONSTANT(constants, UV_UDP_REUSEPORT);
+  NODE_DEFINE_CONSTANT(constants, UV_UDP_RECVMMSG);
   target->Set(context,
               env->constants_string(),
               constants).Check();
@@ -251,6 +273,8 @@ void UDPWrap::RegisterExternalReferences(ExternalReferenceRegistry* registry) {
   registry->Register(Bind6);
   registry->Register(Connect6);
   registry->Register(Send6);
+  registry->Register(SendBatch);
+  registry->Register(SendBatch6);
   registry->Register(Disconnect);
   registry->Register(GetSockOrPeerName<UDPWrap, uv_udp_getpeername>);
   registry->Register(GetSockOrPeerName<UDPWrap, uv_udp_getsockname>);
@@ -271,7 +295,12 @@ void UDPWrap::RegisterExternalReferences(ExternalReferenceRegistry* registry) {
 void UDPWrap::New(const FunctionCallbackInfo<Value>& args) {
   CHECK(args.IsConstructCall());
   Environment* env = Environment::GetCurrent(args);
-  new UDPWrap(env, args.This());
+  // new UDP([flags]); only UV_UDP_RECVMMSG is honoured here, the remaining
+  // flags are applied at bind time.
+  unsigned int flags = 0;
+  if (args.Length() > 0 && args[0]->IsUint32())
+    flags = args[0].As<Uint32>()->Value() & UV_UDP_RECVMMSG;
+  new UDPWrap(env, args.This(), flags);
 }
 
 
@@ -285,6 +314,87 @@ void UDPWrap::GetFD(const FunctionCallbackInfo<Value>& args) {
   args.GetReturnValue().Set(fd);
 }
 
+int TrySendSegmented(uv_udp_t* handle,
+                     uv_buf_t** bufs,
+                     unsigned int* nbufs,
+                     sockaddr** addrs,
+                     unsigned int count) {
+#ifdef NODE_UDP_GSO
+  if (count < 2 || count > kMaxGsoSegments) return UV_ENOTSUP;
+  // Anything already queued must go out first to preserve ordering.
+  if (uv_udp_get_send_queue_count(handle) > 0) return UV_ENOTSUP;
+  uv_os_fd_t fd;
+  if (uv_fileno(reinterpret_cast<uv_handle_t*>(handle), &fd) != 0)
+    return UV_ENOTSUP;
+
+  const size_t segment_size = bufs[0][0].len;
+  if (segment_size == 0) return UV_ENOTSUP;
+
+  const sockaddr* dest = addrs[0];
+  const size_t dest_len = dest != nullptr ? SocketAddress::GetLength(dest) : 0;
+  size_t total = 0;
+  for (unsigned int i = 0; i < count; i++) {
+    if (nbufs[i] != 1) return UV_ENOTSUP;
+    const size_t len = bufs[i][0].len;
+    if (i + 1 < count ? len != segment_size : len > segment_size)
+      return UV_ENOTSUP;
+    if ((dest == nullptr) != (addrs[i] == nullptr)) return UV_ENOTSUP;
+    if (dest != nullptr && memcmp(dest, addrs[i], dest_len) != 0)
+      return UV_ENOTSUP;
+    total += len;
+  }
+  if (total > kMaxGsoPayload) return UV_ENOTSUP;
+
+  iovec iov[kMaxGsoSegments];
+  for (unsigned int i = 0; i < count; i++) {
+    iov[i].iov_base = bufs[i][0].base;
+    iov[i].iov_len = bufs[i][0].len;
+  }
+
+  char control[CMSG_SPACE(sizeof(uint16_t))] = {};
+  msghdr msg{};
+  msg.msg_name = const_cast<sockaddr*>(dest);
+  msg.msg_namelen = dest_len;
+  msg.msg_iov = iov;
+  msg.msg_iovlen = count;
+  msg.msg_control = control;
+  msg.msg_controllen = sizeof(control);
+
+  cmsghdr* cm = CMSG_FIRSTHDR(&msg);
+  cm->cmsg_level = IPPROTO_UDP;
+  cm->cmsg_type = UDP_SEGMENT;
+  cm->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+  const uint16_t gso_size = static_cast<uint16_t>(segment_size);
+  memcpy(CMSG_DATA(cm), &gso_size, sizeof(gso_size));
+
+  ssize_t r;
+  do {
+    r = sendmsg(fd, &msg, MSG_DONTWAIT);
+  } while (r == -1 && errno == EINTR);
+  if (r >= 0) return count;
+
+  switch (errno) {
+    case EAGAIN:
+#if EAGAIN != EWOULDBLOCK
+    case EWOULDBLOCK:
+#endif
+    case ENOBUFS:
+      return UV_EAGAIN;
+    // Raised when the socket or the outgoing device lacks segmentation
+    // offload (EIO is what the kernel returns for missing checksum offload).
+    case EIO:
+    case EINVAL:
+    case ENOPROTOOPT:
+    case EOPNOTSUPP:
+      return UV_ENOSYS;
+    default:
+      return uv_translate_sys_error(errno);
+  }
+#else
+  return UV_ENOSYS;
+#endif  // NODE_UDP_GSO
+}
+
 int sockaddr_for_family(int address_family,
                         const char* address,
                         const unsigned short port,
@@ -660,6 +770,93 @@ ssize_t UDPWrap::Send(uv_buf_t* bufs_ptr,
 }
 
 
+void UDPWrap::DoSendBatch(const FunctionCallbackInfo<Value>& args,
+                          int family) {
+  Environment* env = Environment::GetCurrent(args);
+
+  UDPWrap* wrap;
+  ASSIGN_OR_RETURN_UNWRAP(
+      &wrap, args.This(), args.GetReturnValue().Set(UV_EBADF));
+
+  // Check for network permission
+  THROW_IF_INSUFFICIENT_PERMISSIONS(env,
+                                    permission::PermissionScope::kNet,
+                                    "",
+                                    args.GetReturnValue().Set(UV_EACCES));
+
+  // sendBatch(list) on a connected socket, or
+  // sendBatch(list, ports, addresses) with one destination per datagram.
+  CHECK(args.Length() == 1 || args.Length() == 3);
+  CHECK(args[0]->IsArray());
+  bool sendto = args.Length() == 3;
+  if (sendto) {
+    CHECK(args[1]->IsArray());
+    CHECK(args[2]->IsArray());
+  }
+
+  Local<Context> context = env->context();
+  Local<Array> list = args[0].As<Array>();
+  const uint32_t count = list->Length();
+  if (count == 0) return args.GetReturnValue().Set(0);
+
+  MaybeStackBuffer<uv_buf_t, 16> bufs(count);
+  MaybeStackBuffer<uv_buf_t*, 16> buf_ptrs(count);
+  MaybeStackBuffer<unsigned int, 16> nbufs(count);
+  MaybeStackBuffer<sockaddr*, 16> addrs(count);
+  MaybeStackBuffer<sockaddr_storage, 16> addr_storage(sendto ? count : 1);
+
+  for (uint32_t i = 0; i < count; i++) {
+    Local<Value> chunk;
+    if (!list->Get(context, i).ToLocal(&chunk)) return;
+    bufs[i] = uv_buf_init(Buffer::Data(chunk), Buffer::Length(chunk));
+    buf_ptrs[i] = &bufs[i];
+    nbufs[i] = 1;
+    addrs[i] = nullptr;
+
+    if (sendto) {
+      Local<Value> port;
+      Local<Value> address;
+      if (!args[1].As<Array>()->Get(context, i).ToLocal(&port) ||
+          !args[2].As<Array>()->Get(context, i).ToLocal(&address)) {
+        return;
+      }
+      CHECK(port->IsUint32());
+      CHECK(address->IsString());
+      node::Utf8Value address_str(env->isolate(), address);
+      int err = sockaddr_for_family(family,
+                                    address_str.out(),
+                                    port.As<Uint32>()->Value(),
+                                    &addr_storage[i]);
+      if (err != 0) return args.GetReturnValue().Set(err);
+      addrs[i] = reinterpret_cast<sockaddr*>(&addr_storage[i]);
+    }
+  }
+
+  args.GetReturnValue().Set(
+      wrap->TrySendBatch(*buf_ptrs, *nbufs, *addrs, count));
+}
+
+int UDPWrap::TrySendBatch(uv_buf_t** bufs,
+                          unsigned int* nbufs,
+                          sockaddr** addrs,
+                          unsigned int count) {
+  if (IsHandleClosing()) return UV_EBADF;
+
+  if (!gso_unsupported_) {
+    int err = TrySendSegmented(&handle_, bufs, nbufs, addrs, count);
+    if (err == UV_ENOSYS)
+      gso_unsupported_ = true;
+    else if (err != UV_ENOTSUP)
+      return err;
+  }
+
+  // Uses sendmmsg() where available and falls back to one send per datagram.
+  int err = uv_udp_try_send2(&handle_, count, bufs, nbufs, addrs, 0);
+  if (err == UV_ENOSYS) return 0;
+  return err;
+}
+
+
 ReqWrap<uv_udp_send_t>* UDPWrap::CreateSendWrap(size_t msg_size) {
   SendWrap* req_wrap = new SendWrap(env(),
                                     current_send_req_wrap_,
@@ -679,6 +876,16 @@ void UDPWrap::Send6(const FunctionCallbackInfo<Value>& args) {
 }
 
 
+void UDPWrap::SendBatch(const FunctionCallbackInfo<Value>& args) {
+  DoSendBatch(args, AF_INET);
+}
+
+
+void UDPWrap::SendBatch6(const FunctionCallbackInfo<Value>& args) {
+  DoSendBatch(args, AF_INET6);
+}
+
+
 AsyncWrap* UDPWrap::GetAsyncWrap() {
   return this;
 }
@@ -741,7 +948,23 @@ void UDPWrap::OnAlloc(uv_handle_t* handle,
 }
 
 uv_buf_t UDPWrap::OnAlloc(size_t suggested_size) {
-  return env()->allocate_managed_buffer(suggested_size);
+  if (!uv_udp_using_recvmmsg(&handle_))
+    return env()->allocate_managed_buffer(suggested_size);
+
+  // libuv splits the buffer into maximum-sized datagram slots for recvmmsg().
+  // The same buffer serves every read, including the final one of each
+  // readable event that finds nothing, until a batch is handed out.
+  suggested_size *= kRecvMmsgDatagrams;
+  if (!recv_store_ || recv_store_->ByteLength() < suggested_size) {
+    recv_store_ = ArrayBuffer::NewBackingStore(
+        env()->isolate(),
+        suggested_size,
+        BackingStoreInitializationMode::kUninitialized,
+        BackingStoreOnFailureMode::kReturnNull);
+    // libuv reports UV_ENOBUFS for an empty buffer.
+    if (!recv_store_) return uv_buf_init(nullptr, 0);
+  }
+  return uv_buf_init(static_cast<char*>(recv_store_->Data()), suggested_size);
 }
 
 void UDPWrap::OnRecv(uv_udp_t* handle,
@@ -750,9 +973,118 @@ void UDPWrap::OnRecv(uv_udp_t* handle,
                      const sockaddr* addr,
                      unsigned int flags) {
   UDPWrap* wrap = ContainerOf(&UDPWrap::handle_, handle);
+  // With UV_UDP_RECVMMSG, libuv reports each datagram as a chunk of the
+  // allocated buffer and then hands the whole buffer back with
+  // UV_UDP_MMSG_FREE. The chunks are gathered and delivered in one go.
+  if (flags & UV_UDP_MMSG_CHUNK) {
+    wrap->OnRecvChunk(nread, *buf, addr);
+    return;
+  }
+  if (flags & UV_UDP_MMSG_FREE) {
+    wrap->OnRecvBatchDone();
+    return;
+  }
+  if (wrap->IsRecvStore(*buf)) {
+    // Nothing was read, and the buffer is kept for the next read.
+    if (nread == 0 && addr == nullptr) return;
+    wrap->listener()->OnRecv(nread, uv_buf_init(nullptr, 0), addr, flags);
+    return;
+  }
   wrap->listener()->OnRecv(nread, *buf, addr, flags);
 }
 
+void UDPWrap::OnRecvChunk(ssize_t nread,
+                          const uv_buf_t& buf,
+                          const sockaddr* addr) {
+  CHECK_GE(nread, 0);
+  CHECK_NOT_NULL(addr);
+  CHECK(recv_store_);
+  const char* base = static_cast<const char*>(recv_store_->Data());
+  CHECK(buf.base >= base &&
+        buf.base + nread <= base + recv_store_->ByteLength());
+  RecvChunk chunk;
+  chunk.offset = buf.base - base;
+  chunk.length = nread;
+  memcpy(&chunk.addr, addr, SocketAddress::GetLength(addr));
+  recv_batch_.push_back(chunk);
+}
+
+void UDPWrap::OnRecvBatchDone() {
+  Environment* env = this->env();
+  Isolate* isolate = env->isolate();
+
+  std::vector<RecvChunk> batch;
+  batch.swap(recv_batch_);
+  if (batch.empty()) return;
+
+  HandleScope handle_scope(isolate);
+  Context::Scope context_scope(env->context());
+
+  // All of the datagrams of the batch are views into one ArrayBuffer. That
+  // is the receive buffer itself, unless they fill only a small part of it.
+  size_t total = 0;
+  for (const RecvChunk& chunk : batch) total += chunk.length;
+  Local<ArrayBuffer> ab;
+  if (total < recv_store_->ByteLength() / kRecvMmsgCompactDivisor) {
+    ab = ArrayBuffer::New(
+        isolate, total, BackingStoreInitializationMode::kUninitialized);
+    char* data = static_cast<char*>(ab->Data());
+    const char* base = static_cast<const char*>(recv_store_->Data());
+    size_t offset = 0;
+    for (RecvChunk& chunk : batch) {
+      if (chunk.length > 0)
+        memcpy(data + offset, base + chunk.offset, chunk.length);
+      chunk.offset = offset;
+      offset += chunk.length;
+    }
+  } else {
+    ab = ArrayBuffer::New(isolate, std::move(recv_store_));
+  }
+
+  Local<Value> argv[] = {
+      Integer::New(isolate, static_cast<int32_t>(batch.size())),
+      object(),
+      Undefined(isolate),
+      Undefined(isolate)};
+
+  LocalVector<Value> buffers(isolate);
+  LocalVector<Value> addresses(isolate);
+  buffers.reserve(batch.size());
+  addresses.reserve(batch.size());
+  {
+    bool has_caught = false;
+    {
+      TryCatchScope try_catch(env);
+      for (const RecvChunk& chunk : batch) {
+        Local<Object> buffer;
+        Local<Object> address;
+        if (!Buffer::New(env, ab, chunk.offset, chunk.length)
+                 .ToLocal(&buffer) ||
+            !AddressToJS(env, reinterpret_cast<const sockaddr*>(&chunk.addr))
+                 .ToLocal(&address)) {
+          DCHECK(try_catch.HasCaught() && !try_catch.HasTerminated());
+          argv[2] = try_catch.Exception();
+          DCHECK(!argv[2].IsEmpty());
+          has_caught = true;
+          break;
+        }
+        buffers.push_back(buffer);
+        addresses.push_back(address);
+      }
+    }
+    if (has_caught) {
+      DCHECK(!argv[2].IsEmpty());
+      MakeCallback(env->onerror_string(), arraysize(argv), argv);
+      return;
+    }
+  }
+
+  // onmessagebatch(count, handle, buffers, addresses)
+  argv[2] = Array::New(isolate, buffers.data(), buffers.size());
+  argv[3] = Array::New(isolate, addresses.data(), addresses.size());
+  MakeCallback(env->onmessagebatch_string(), arraysize(argv), argv);
+}
+
 void UDPWrap::OnRecv(ssize_t nread,
                      const uv_buf_t& buf_,
                      const sockaddr* addr,
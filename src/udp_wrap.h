@@ -30,6 +30,9 @@
 #include "uv.h"
 #include "v8.h"
 
+#include <memory>
+#include <vector>
+
 namespace node {
 
 class ExternalReferenceRegistry;
@@ -138,6 +141,8 @@ class UDPWrap final : public HandleWrap,
   static void Bind6(const v8::FunctionCallbackInfo<v8::Value>& args);
   static void Connect6(const v8::FunctionCallbackInfo<v8::Value>& args);
   static void Send6(const v8::FunctionCallbackInfo<v8::Value>& args);
+  static void SendBatch(const v8::FunctionCallbackInfo<v8::Value>& args);
+  static void SendBatch6(const v8::FunctionCallbackInfo<v8::Value>& args);
   static void Disconnect(const v8::FunctionCallbackInfo<v8::Value>& args);
   static void AddMembership(const v8::FunctionCallbackInfo<v8::Value>& args);
   static void DropMembership(const v8::FunctionCallbackInfo<v8::Value>& args);
@@ -189,7 +194,23 @@ class UDPWrap final : public HandleWrap,
             int (*F)(const typename T::HandleType*, sockaddr*, int*)>
   friend void GetSockOrPeerName(const v8::FunctionCallbackInfo<v8::Value>&);
 
-  UDPWrap(Environment* env, v8::Local<v8::Object> object);
+  // A single datagram received through recvmmsg(), at |offset| in
+  // recv_store_.
+  struct RecvChunk {
+    size_t offset;
+    size_t length;
+    sockaddr_storage addr;
+  };
+
+  // Number of maximum-sized datagrams the receive buffer has room for when
+  // the handle was created with UV_UDP_RECVMMSG.
+  static constexpr size_t kRecvMmsgDatagrams = 16;
+  // A batch that fills less than this fraction of the receive buffer is
+  // copied out, so that small datagrams do not keep the whole buffer alive,
+  // and the buffer is used for the next read.
+  static constexpr size_t kRecvMmsgCompactDivisor = 4;
+
+  UDPWrap(Environment* env, v8::Local<v8::Object> object, unsigned int flags);
 
   static void DoBind(const v8::FunctionCallbackInfo<v8::Value>& args,
                      int family);
@@ -197,6 +218,8 @@ class UDPWrap final : public HandleWrap,
                      int family);
   static void DoSend(const v8::FunctionCallbackInfo<v8::Value>& args,
                      int family);
+  static void DoSendBatch(const v8::FunctionCallbackInfo<v8::Value>& args,
+                          int family);
   static void SetMembership(const v8::FunctionCallbackInfo<v8::Value>& args,
                             uv_membership membership);
   static void SetSourceMembership(
@@ -212,7 +235,25 @@ class UDPWrap final : public HandleWrap,
                      const struct sockaddr* addr,
                      unsigned int flags);
 
+  // Sends as many of the given datagrams as possible without blocking and
+  // returns how many were sent, or a negative libuv error code.
+  int TrySendBatch(uv_buf_t** bufs,
+                   unsigned int* nbufs,
+                   sockaddr** addrs,
+                   unsigned int count);
+  bool IsRecvStore(const uv_buf_t& buf) const {
+    return recv_store_ && buf.base == recv_store_->Data();
+  }
+  void OnRecvChunk(ssize_t nread, const uv_buf_t& buf, const sockaddr* addr);
+  void OnRecvBatchDone();
+
   uv_udp_t handle_;
+  // With UV_UDP_RECVMMSG, the buffer that every read of the handle uses
+  // until a batch is handed out as views into it.
+  std::unique_ptr<v8::BackingStore> recv_store_;
+  std::vector<RecvChunk> recv_batch_;
+  // Set once the kernel rejects UDP_SEGMENT so later batches skip it.
+  bool gso_unsupported_ = false;
 
   bool current_send_has_callback_;
   v8::Local<v8::Object> current_send_req_wrap_;
@@ -223,6 +264,19 @@ int sockaddr_for_family(int address_family,
                         const unsigned short port,
                         sockaddr_storage* addr);
 
+// Sends a batch of single-buffer datagrams with a single sendmsg() call by
+// letting the kernel segment them (UDP generic segmentation offload). This
+// only applies when every datagram has the same destination, all but the
+// last have the same size, and nothing is queued on the handle. Returns the
+// number of datagrams sent, UV_ENOTSUP when the batch does not qualify, or
+// UV_ENOSYS when the platform or socket does not support segmentation
+// offload, so that the caller can fall back to sending datagrams one by one.
+int TrySendSegmented(uv_udp_t* handle,
+                     uv_buf_t** bufs,
+                     unsigned int* nbufs,
+                     sockaddr** addrs,
+                     unsigned int count);
+
 }  // namespace node
 
 #endif  // defined(NODE_WANT_INTERNALS) && NODE_WANT_INTERNALS
@@ -0,0 +1,54 @@
+#ifndef SRC_URL_PATTERN_REGEXP_CACHE_H_
+#define SRC_URL_PATTERN_REGEXP_CACHE_H_
+
+#if defined(NODE_WANT_INTERNALS) && NODE_WANT_INTERNALS
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include "v8.h"
+
+namespace node::url_pattern {
+
+// The regular expressions compiled for the components of the URLPatterns
+// of an Environment, keyed by their source and flags, so that constructing
+// the same pattern again, e.g. in every request handler, doesn't compile
+// them again. The regular expressions are created without the global and
+// sticky flags, so their lastIndex is never used and URLPattern instances
+// can share them.
+class RegExpCache {
+ public:
+  // Patterns created from user input may all be different, so the cache
+  // stops growing at this size and compiles any further pattern without
+  // caching it.
+  static constexpr size_t kMaxSize = 1024;
+
+  RegExpCache() = default;
+  RegExpCache(const RegExpCache&) = delete;
+  RegExpCache& operator=(const RegExpCache&) = delete;
+
+  // Returns the cached regular expression for |pattern| and |flags|, or
+  // compiles it in |context|.
+  v8::MaybeLocal<v8::RegExp> Get(v8::Local<v8::Context> context,
+                                 std::string_view pattern,
+                                 v8::RegExp::Flags flags);
+  void Clear() { regexps_.clear(); }
+
+  size_t size() const { return regexps_.size(); }
+  uint64_t hits() const { return hits_; }
+  uint64_t misses() const { return misses_; }
+
+ private:
+  std::unordered_map<std::string, v8::Global<v8::RegExp>> regexps_;
+  uint64_t hits_ = 0;
+  uint64_t misses_ = 0;
+};
+
+}  // namespace node::url_pattern
+
+#endif  // defined(NODE_WANT_INTERNALS) && NODE_WANT_INTERNALS
+
+#endif  // SRC_URL_PATTERN_REGEXP_CACHE_H_
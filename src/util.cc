@@ -50,6 +50,10 @@
 
 #include <simdutf.h>
 
+#ifdef NODE_USE_MIMALLOC
+#include <mimalloc.h>
+#endif
+
 #include <atomic>
 #include <cstdio>
 #include <cstring>
@@ -185,6 +189,26 @@ void LowMemoryNotification() {
   }
 }
 
+bool GetMallocStats(MallocStats* stats) {
+#ifdef NODE_USE_MIMALLOC
+  size_t current_commit;
+  size_t peak_commit;
+  mi_process_info(nullptr,
+                  nullptr,
+                  nullptr,
+                  nullptr,
+                  nullptr,
+                  &current_commit,
+                  &peak_commit,
+                  nullptr);
+  stats->committed = current_commit;
+  stats->peak_committed = peak_commit;
+  return true;
+#else
+  return false;
+#endif
+}
+
 std::string GetProcessTitle(const char* default_title) {
   std::string buf(16, '\0');
 
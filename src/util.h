@@ -111,6 +111,19 @@ extern bool v8_initialized;
 // whether V8 is initialized.
 void LowMemoryNotification();
 
+// Statistics of the malloc implementation behind the allocation functions,
+// in bytes.
+struct MallocStats {
+  size_t committed;
+  size_t peak_committed;
+};
+
+// Returns false when node is linked against the system malloc, which does
+// not report these. With --shared-mimalloc, mimalloc replaces malloc for the
+// whole process, so the allocation functions above and the ArrayBuffer
+// allocator use it without going through a separate API.
+bool GetMallocStats(MallocStats* stats);
+
 // The reason that Assert() takes a struct argument instead of individual
 // const char*s is to ease instruction cache pressure in calls from CHECK.
 struct AssertionInfo {
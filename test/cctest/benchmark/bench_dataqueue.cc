@@ -0,0 +1,65 @@
+#include "dataqueue/queue.h"
+#include "microbenchmark.h"
+#include "node_bob-inl.h"
+#include "util-inl.h"
+
+#include <memory>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+using node::DataQueue;
+using v8::ArrayBuffer;
+using v8::BackingStore;
+
+namespace {
+
+// Reads |queue| to the end with synchronous pulls and returns the number of
+// bytes read.
+uint64_t ReadAll(DataQueue* queue) {
+  std::shared_ptr<DataQueue::Reader> reader = queue->get_reader();
+  uint64_t total = 0;
+  int status;
+  do {
+    status = reader->Pull(
+        [&](int, const DataQueue::Vec* vecs, size_t count, auto done) {
+          for (size_t i = 0; i < count; i++) total += vecs[i].len;
+          std::move(done)(0);
+        },
+        node::bob::OPTIONS_SYNC,
+        nullptr,
+        0,
+        node::bob::kMaxCountHint);
+  } while (status == node::bob::STATUS_CONTINUE);
+  CHECK_EQ(status, node::bob::STATUS_EOS);
+  return total;
+}
+
+void BenchmarkRead(const char* name, size_t entries, size_t entry_size) {
+  std::vector<char> data(entries * entry_size, 'x');
+  std::shared_ptr<BackingStore> store = ArrayBuffer::NewBackingStore(
+      data.data(), data.size(), [](void*, size_t, void*) {}, nullptr);
+  std::vector<std::unique_ptr<DataQueue::Entry>> list;
+  for (size_t i = 0; i < entries; i++) {
+    list.push_back(DataQueue::CreateInMemoryEntryFromBackingStore(
+        store, i * entry_size, entry_size));
+  }
+  std::shared_ptr<DataQueue> queue = DataQueue::CreateIdempotent(
+      std::move(list));
+  CHECK_NOT_NULL(queue);
+
+  node_benchmark::Run(std::string("DataQueue/Read/") + name, [&](auto* state) {
+    uint64_t read = 0;
+    while (state->KeepRunning()) read = ReadAll(queue.get());
+    CHECK_EQ(read, data.size());
+    state->SetBytesProcessed(state->iterations() * data.size());
+  });
+}
+
+}  // namespace
+
+TEST(DataQueueBenchmark, Read) {
+  BenchmarkRead("1x1MiB", 1, 1024 * 1024);
+  BenchmarkRead("1024x1KiB", 1024, 1024);
+  BenchmarkRead("16384x64B", 16384, 64);
+}
@@ -0,0 +1,77 @@
+#include "env-inl.h"
+#include "microbenchmark.h"
+#include "node_test_fixture.h"
+
+#include <string>
+
+using v8::Function;
+using v8::HandleScope;
+using v8::Local;
+using v8::Value;
+
+class HttpParserBenchmark : public EnvironmentTestFixture {};
+
+namespace {
+
+// The native Parser is only reachable through its binding, so the canned
+// traffic is fed to it the way _http_server.js does: one execute() call
+// with a buffer of 16 pipelined keep-alive requests, with a headers
+// callback so that the header strings are materialized.
+const char kScript[] = R"(
+  const { HTTPParser } = require('_http_common');
+  const request =
+      'GET /api/v1/items?limit=20&offset=40 HTTP/1.1\r\n' +
+      'Host: example.com\r\n' +
+      'User-Agent: Mozilla/5.0 (X11; Linux x86_64) Gecko/20100101\r\n' +
+      'Accept: application/json, text/plain, */*\r\n' +
+      'Accept-Encoding: gzip, deflate, br\r\n' +
+      'Accept-Language: en-US,en;q=0.5\r\n' +
+      'Cookie: session=0123456789abcdef; theme=dark\r\n' +
+      'Connection: keep-alive\r\n\r\n';
+  const traffic = Buffer.from(request.repeat(16));
+  const parser = new HTTPParser();
+  let messages = 0;
+  parser[HTTPParser.kOnHeadersComplete] = () => 0;
+  parser[HTTPParser.kOnMessageComplete] = () => { messages++; };
+  globalThis.trafficLength = traffic.length;
+  globalThis.parseTraffic = () => {
+    parser.initialize(HTTPParser.REQUEST, {});
+    messages = 0;
+    parser.execute(traffic);
+    return messages;
+  };
+)";
+
+}  // namespace
+
+TEST_F(HttpParserBenchmark, PipelinedRequests) {
+  const HandleScope handle_scope(isolate_);
+  const Argv argv;
+  Env env{handle_scope, argv};
+  Local<v8::Context> context = env.context();
+
+  ASSERT_FALSE(node::LoadEnvironment(*env, kScript).IsEmpty());
+  Local<Value> parse_traffic;
+  Local<Value> traffic_length;
+  ASSERT_TRUE(context->Global()
+                  ->Get(context, node::OneByteString(isolate_, "parseTraffic"))
+                  .ToLocal(&parse_traffic));
+  ASSERT_TRUE(context->Global()
+                  ->Get(context, node::OneByteString(isolate_, "trafficLength"))
+                  .ToLocal(&traffic_length));
+  ASSERT_TRUE(parse_traffic->IsFunction());
+  Local<Function> fn = parse_traffic.As<Function>();
+
+  node_benchmark::Run("HttpParser/Execute/16-requests", [&](auto* state) {
+    while (state->KeepRunning()) {
+      HandleScope scope(isolate_);
+      Local<Value> messages;
+      CHECK(fn->Call(context, context->Global(), 0, nullptr)
+                .ToLocal(&messages));
+      CHECK_EQ(messages.As<v8::Int32>()->Value(), 16);
+    }
+    state->SetBytesProcessed(
+        state->iterations() *
+        static_cast<uint64_t>(traffic_length.As<v8::Number>()->Value()));
+  });
+}
@@ -0,0 +1,63 @@
+#include "env-inl.h"
+#include "microbenchmark.h"
+#include "node_messaging.h"
+#include "node_test_fixture.h"
+
+#include <string>
+
+using node::worker::Message;
+using node::worker::TransferList;
+using v8::HandleScope;
+using v8::JSON;
+using v8::Local;
+using v8::Value;
+
+class MessagingBenchmark : public EnvironmentTestFixture {};
+
+namespace {
+
+// A postMessage() payload of the size and shape of a typical RPC response.
+std::string MakePayload() {
+  std::string json = "[";
+  for (int i = 0; i < 100; i++) {
+    if (i > 0) json += ",";
+    json += "{\"id\":" + std::to_string(i) +
+            ",\"name\":\"item-" + std::to_string(i) +
+            "\",\"tags\":[\"a\",\"b\",\"c\"],\"price\":" +
+            std::to_string(i * 1.5) + ",\"active\":true}";
+  }
+  return json + "]";
+}
+
+}  // namespace
+
+TEST_F(MessagingBenchmark, SerializeAndDeserialize) {
+  const HandleScope handle_scope(isolate_);
+  const Argv argv;
+  Env env{handle_scope, argv};
+  Local<v8::Context> context = env.context();
+
+  Local<Value> payload;
+  ASSERT_TRUE(JSON::Parse(context, node::OneByteString(isolate_, MakePayload()))
+                  .ToLocal(&payload));
+  TransferList transfer_list;
+
+  node_benchmark::Run("MessagePort/Serialize", [&](auto* state) {
+    while (state->KeepRunning()) {
+      Message message;
+      CHECK(message.Serialize(*env, context, payload, transfer_list)
+                .FromJust());
+    }
+  });
+
+  node_benchmark::Run("MessagePort/Deserialize", [&](auto* state) {
+    while (state->KeepRunning()) {
+      HandleScope scope(isolate_);
+      // Deserialize() can only be called once per message.
+      Message message;
+      CHECK(message.Serialize(*env, context, payload, transfer_list)
+                .FromJust());
+      CHECK(!message.Deserialize(*env, context).IsEmpty());
+    }
+  });
+}
@@ -0,0 +1,115 @@
+#include "env-inl.h"
+#include "microbenchmark.h"
+#include "nbytes.h"
+#include "node_test_fixture.h"
+#include "string_bytes.h"
+
+#include <string>
+#include <vector>
+
+using node::StringBytes;
+using v8::HandleScope;
+using v8::Local;
+using v8::String;
+using v8::Value;
+
+class StringBytesBenchmark : public NodeTestFixture {};
+
+namespace {
+
+constexpr size_t kInputSize = 64 * 1024;
+
+// Mostly ASCII text with a few multi-byte characters, like typical JSON or
+// HTML payloads.
+std::string MakeText(size_t size) {
+  static const char kChunk[] =
+      "{\"id\":12345,\"name\":\"caf\xc3\xa9\",\"tags\":[\"a\",\"b\"]},";
+  std::string text;
+  text.reserve(size + sizeof(kChunk));
+  while (text.size() < size) text += kChunk;
+  return text;
+}
+
+void BenchmarkEncode(v8::Isolate* isolate,
+                     const char* name,
+                     node::encoding encoding) {
+  std::string input = MakeText(kInputSize);
+  node_benchmark::Run(
+      std::string("StringBytes/Encode/") + name, [&](auto* state) {
+        while (state->KeepRunning()) {
+          HandleScope handle_scope(isolate);
+          Local<Value> result;
+          CHECK(StringBytes::Encode(
+                    isolate, input.data(), input.size(), encoding)
+                    .ToLocal(&result));
+        }
+        state->SetBytesProcessed(state->iterations() * input.size());
+      });
+}
+
+void BenchmarkWrite(v8::Isolate* isolate,
+                    const char* name,
+                    node::encoding encoding) {
+  HandleScope handle_scope(isolate);
+  std::string text = MakeText(kInputSize);
+  Local<Value> string;
+  CHECK(StringBytes::Encode(isolate, text.data(), text.size(), encoding)
+            .ToLocal(&string));
+  std::vector<char> output(text.size() * 3);
+  node_benchmark::Run(
+      std::string("StringBytes/Write/") + name, [&](auto* state) {
+        size_t written = 0;
+        while (state->KeepRunning()) {
+          written = StringBytes::Write(
+              isolate, output.data(), output.size(), string, encoding);
+        }
+        CHECK_EQ(written, text.size());
+        state->SetBytesProcessed(state->iterations() * written);
+      });
+}
+
+template <typename Char>
+void BenchmarkSearch(const char* name) {
+  // A needle that only matches at the end, with many partial matches.
+  std::vector<Char> haystack(1024 * 1024, 'a');
+  std::vector<Char> needle(32, 'a');
+  needle.back() = 'b';
+  haystack.back() = 'b';
+  node_benchmark::Run(std::string("IndexOfString/") + name, [&](auto* state) {
+    size_t index = 0;
+    while (state->KeepRunning()) {
+      index = nbytes::SearchString(haystack.data(),
+                                   haystack.size(),
+                                   needle.data(),
+                                   needle.size(),
+                                   0,
+                                   true);
+    }
+    CHECK_EQ(index, haystack.size() - needle.size());
+    state->SetBytesProcessed(state->iterations() * haystack.size() *
+                             sizeof(Char));
+  });
+}
+
+}  // namespace
+
+TEST_F(StringBytesBenchmark, Encode) {
+  BenchmarkEncode(isolate_, "latin1", node::LATIN1);
+  BenchmarkEncode(isolate_, "utf8", node::UTF8);
+  BenchmarkEncode(isolate_, "hex", node::HEX);
+  BenchmarkEncode(isolate_, "base64", node::BASE64);
+}
+
+TEST_F(StringBytesBenchmark, Write) {
+  BenchmarkWrite(isolate_, "latin1", node::LATIN1);
+  BenchmarkWrite(isolate_, "utf8", node::UTF8);
+  BenchmarkWrite(isolate_, "hex", node::HEX);
+  BenchmarkWrite(isolate_, "base64", node::BASE64);
+}
+
+// IndexOfString() is a thin wrapper around nbytes::SearchString() for the
+// one-byte and two-byte representations of the needle.
+TEST(IndexOfStringBenchmark, Search) {
+  BenchmarkSearch<uint8_t>("one-byte");
+  BenchmarkSearch<uint16_t>("two-byte");
+}
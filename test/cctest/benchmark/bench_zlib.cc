@@ -0,0 +1,86 @@
+#include "env-inl.h"
+#include "microbenchmark.h"
+#include "node_test_fixture.h"
+
+#include <string>
+
+using v8::Function;
+using v8::HandleScope;
+using v8::Local;
+using v8::Value;
+
+class ZlibBenchmark : public EnvironmentTestFixture {};
+
+namespace {
+
+// ZlibContext is internal to node_zlib.cc, so it is driven through the
+// synchronous zlib API, which calls into it once per chunk. With 64 KiB of
+// input per call, the JS part is a small fraction of the time.
+const char kScript[] = R"(
+  const zlib = require('zlib');
+  const input = Buffer.from(
+      JSON.stringify(Array.from({ length: 800 }, (_, i) => ({
+        id: i, name: `item-${i}`, tags: ['a', 'b', 'c'], price: i * 1.5,
+      }))).slice(0, 64 * 1024));
+  const deflated = zlib.deflateSync(input);
+  const gzipped = zlib.gzipSync(input);
+  const compressed = zlib.brotliCompressSync(input);
+  globalThis.zlibInputLength = input.length;
+  globalThis.zlibBenchmarks = {
+    'deflateSync': () => zlib.deflateSync(input),
+    'inflateSync': () => zlib.inflateSync(deflated),
+    'gzipSync': () => zlib.gzipSync(input),
+    'gunzipSync': () => zlib.gunzipSync(gzipped),
+    'brotliCompressSync': () => zlib.brotliCompressSync(input),
+    'brotliDecompressSync': () => zlib.brotliDecompressSync(compressed),
+  };
+)";
+
+const char* const kBenchmarks[] = {
+    "deflateSync",
+    "inflateSync",
+    "gzipSync",
+    "gunzipSync",
+    "brotliCompressSync",
+    "brotliDecompressSync",
+};
+
+}  // namespace
+
+TEST_F(ZlibBenchmark, Sync) {
+  const HandleScope handle_scope(isolate_);
+  const Argv argv;
+  Env env{handle_scope, argv};
+  Local<v8::Context> context = env.context();
+
+  ASSERT_FALSE(node::LoadEnvironment(*env, kScript).IsEmpty());
+  Local<Value> benchmarks;
+  Local<Value> input_length;
+  ASSERT_TRUE(
+      context->Global()
+          ->Get(context, node::OneByteString(isolate_, "zlibBenchmarks"))
+          .ToLocal(&benchmarks));
+  ASSERT_TRUE(
+      context->Global()
+          ->Get(context, node::OneByteString(isolate_, "zlibInputLength"))
+          .ToLocal(&input_length));
+  ASSERT_TRUE(benchmarks->IsObject());
+  uint64_t bytes =
+      static_cast<uint64_t>(input_length.As<v8::Number>()->Value());
+
+  for (const char* name : kBenchmarks) {
+    Local<Value> value;
+    ASSERT_TRUE(benchmarks.As<v8::Object>()
+                    ->Get(context, node::OneByteString(isolate_, name))
+                    .ToLocal(&value));
+    ASSERT_TRUE(value->IsFunction());
+    Local<Function> fn = value.As<Function>();
+    node_benchmark::Run(std::string("Zlib/") + name, [&](auto* state) {
+      while (state->KeepRunning()) {
+        HandleScope scope(isolate_);
+        CHECK(!fn->Call(context, context->Global(), 0, nullptr).IsEmpty());
+      }
+      state->SetBytesProcessed(state->iterations() * bytes);
+    });
+  }
+}
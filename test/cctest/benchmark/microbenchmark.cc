@@ -0,0 +1,135 @@
+#include "microbenchmark.h"
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "json_utils.h"
+#include "uv.h"
+
+namespace node_benchmark {
+namespace {
+
+struct Result {
+  std::string name;
+  uint64_t iterations;
+  double real_time;  // Nanoseconds per iteration.
+  double cpu_time;   // Nanoseconds per iteration.
+  double bytes_per_second;
+};
+
+double min_time = 0.5;
+const char* out_file = nullptr;
+std::vector<Result> results;
+
+uint64_t ThreadCpuTime() {
+  uv_rusage_t usage;
+  if (uv_getrusage_thread(&usage) != 0) return 0;
+  return (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000000000 +
+         (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) * 1000;
+}
+
+void WriteResults(std::ostream& out) {
+  node::JSONWriter writer(out, false);
+  writer.json_start();
+  writer.json_objectstart("context");
+  char date[64];
+  time_t now = time(nullptr);
+  strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S%z", localtime(&now));
+  writer.json_keyvalue("date", date);
+  writer.json_keyvalue("num_cpus", uv_available_parallelism());
+#ifdef DEBUG
+  writer.json_keyvalue("library_build_type", "debug");
+#else
+  writer.json_keyvalue("library_build_type", "release");
+#endif
+  writer.json_objectend();
+  writer.json_arraystart("benchmarks");
+  for (const Result& result : results) {
+    writer.json_start();
+    writer.json_keyvalue("name", result.name);
+    writer.json_keyvalue("run_name", result.name);
+    writer.json_keyvalue("run_type", "iteration");
+    writer.json_keyvalue("iterations", result.iterations);
+    writer.json_keyvalue("real_time", result.real_time);
+    writer.json_keyvalue("cpu_time", result.cpu_time);
+    writer.json_keyvalue("time_unit", "ns");
+    if (result.bytes_per_second > 0) {
+      writer.json_keyvalue("bytes_per_second", result.bytes_per_second);
+    }
+    writer.json_end();
+  }
+  writer.json_arrayend();
+  writer.json_end();
+  out << "\n";
+}
+
+}  // namespace
+
+void Run(const std::string& name, const std::function<void(State*)>& body) {
+  uint64_t iterations = 1;
+  while (true) {
+    State state(iterations);
+    uint64_t real_start = uv_hrtime();
+    uint64_t cpu_start = ThreadCpuTime();
+    body(&state);
+    double real = static_cast<double>(uv_hrtime() - real_start);
+    double cpu = static_cast<double>(ThreadCpuTime() - cpu_start);
+    EXPECT_FALSE(state.KeepRunning()) << name << " did not finish its loop";
+
+    double seconds = real / 1e9;
+    if (seconds >= min_time || iterations >= 1000000000) {
+      Result result{name, iterations, real / iterations, cpu / iterations, 0};
+      if (state.bytes_processed() > 0) {
+        result.bytes_per_second = state.bytes_processed() / seconds;
+      }
+      printf("%-48s %12.1f ns %12.1f ns %12" PRIu64 "\n",
+             name.c_str(),
+             result.real_time,
+             result.cpu_time,
+             iterations);
+      results.push_back(std::move(result));
+      return;
+    }
+    // Like Google Benchmark, aim for 1.4 times the minimum time, but grow
+    // by at most 10 times per run in case the last run was very short.
+    double multiplier = seconds > 0 ? min_time * 1.4 / seconds : 10;
+    multiplier = std::clamp(multiplier, 2.0, 10.0);
+    iterations = static_cast<uint64_t>(iterations * multiplier);
+  }
+}
+
+}  // namespace node_benchmark
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  for (int i = 1; i < argc; i++) {
+    const char* arg = argv[i];
+    if (strncmp(arg, "--benchmark_out=", 16) == 0) {
+      node_benchmark::out_file = arg + 16;
+    } else if (strncmp(arg, "--benchmark_min_time=", 21) == 0) {
+      node_benchmark::min_time = atof(arg + 21);
+    } else {
+      fprintf(stderr, "Unknown option: %s\n", arg);
+      return 1;
+    }
+  }
+
+  int exit_code = RUN_ALL_TESTS();
+  if (node_benchmark::out_file != nullptr) {
+    std::ofstream out(node_benchmark::out_file);
+    node_benchmark::WriteResults(out);
+    if (!out) {
+      fprintf(stderr, "Failed to write %s\n", node_benchmark::out_file);
+      return 1;
+    }
+  }
+  return exit_code;
+}
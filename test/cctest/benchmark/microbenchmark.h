@@ -0,0 +1,58 @@
+#ifndef TEST_CCTEST_BENCHMARK_MICROBENCHMARK_H_
+#define TEST_CCTEST_BENCHMARK_MICROBENCHMARK_H_
+
+#include <cstdint>
+#include <functional>
+#include <string>
+
+// A small harness for the C++ microbenchmarks of hot paths in src/. The
+// benchmarks are gtest tests, so that they can use the node_test_fixture.h
+// fixtures and --gtest_filter, and each of them runs one or more loops
+// through node_benchmark::Run():
+//
+//   TEST_F(StringBytesBenchmark, EncodeHex) {
+//     node_benchmark::Run("StringBytes/Encode/hex", [&](auto* state) {
+//       while (state->KeepRunning()) { ... }
+//       state->SetBytesProcessed(state->iterations() * input.size());
+//     });
+//   }
+//
+// The number of iterations is increased until a loop runs for at least
+// --benchmark_min_time seconds. The results are written to stdout, and
+// with --benchmark_out=<file> also to a file in the JSON format of Google
+// Benchmark, so that the existing tools for comparing and tracking those
+// results can be used.
+namespace node_benchmark {
+
+class State {
+ public:
+  explicit State(uint64_t iterations) : iterations_(iterations) {}
+  State(const State&) = delete;
+  State& operator=(const State&) = delete;
+
+  // Returns true until the loop body ran iterations() times.
+  bool KeepRunning() {
+    if (remaining_ == 0) return false;
+    remaining_--;
+    return true;
+  }
+  uint64_t iterations() const { return iterations_; }
+
+  // The number of bytes that all iterations processed together, if
+  // throughput is relevant for the benchmark.
+  void SetBytesProcessed(uint64_t bytes) { bytes_processed_ = bytes; }
+  uint64_t bytes_processed() const { return bytes_processed_; }
+
+ private:
+  uint64_t iterations_;
+  uint64_t remaining_ = iterations_;
+  uint64_t bytes_processed_ = 0;
+};
+
+// Runs |body| and records the result under |name|. |body| must run its
+// loop until state->KeepRunning() returns false.
+void Run(const std::string& name, const std::function<void(State*)>& body);
+
+}  // namespace node_benchmark
+
+#endif  // TEST_CCTEST_BENCHMARK_MICROBENCHMARK_H_
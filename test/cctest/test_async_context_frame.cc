@@ -0,0 +1,74 @@
+#include "async_context_frame.h"
+#include "env-inl.h"
+#include "gtest/gtest.h"
+#include "node_test_fixture.h"
+
+using node::Environment;
+using node::async_context_frame::CpuTimeTracker;
+using v8::ArrayBuffer;
+using v8::Float64Array;
+using v8::HandleScope;
+using v8::Local;
+using v8::Object;
+using v8::Undefined;
+
+class AsyncContextFrameTest : public EnvironmentTestFixture {};
+
+namespace {
+
+Local<Float64Array> AttachCounter(Environment* env, Local<Object> frame) {
+  Local<Float64Array> counter =
+      Float64Array::New(ArrayBuffer::New(env->isolate(), sizeof(double)), 0, 1);
+  frame
+      ->SetPrivate(
+          env->context(), env->cpu_time_counter_private_symbol(), counter)
+      .Check();
+  return counter;
+}
+
+double Read(Local<Float64Array> counter) {
+  double value;
+  counter->CopyContents(&value, sizeof(value));
+  return value;
+}
+
+void BurnCpu() {
+  uint64_t start = uv_hrtime();
+  volatile uint64_t sink = 0;
+  while (uv_hrtime() - start < 50 * 1000 * 1000) sink = sink + 1;
+}
+
+}  // namespace
+
+TEST_F(AsyncContextFrameTest, CpuTimeIsChargedToTheCurrentFrame) {
+  const HandleScope handle_scope(isolate_);
+  const Argv argv;
+  Env env{handle_scope, argv};
+  Environment* environment = *env;
+
+  Local<Object> tracked = Object::New(isolate_);
+  Local<Object> untracked = Object::New(isolate_);
+  Local<Float64Array> counter = AttachCounter(environment, tracked);
+
+  CpuTimeTracker* tracker =
+      environment->async_context_frame_cpu_time_tracker();
+  EXPECT_FALSE(tracker->enabled());
+  tracker->Enable();
+  EXPECT_TRUE(tracker->enabled());
+
+  node::async_context_frame::set(isolate_, untracked);
+  BurnCpu();
+  node::async_context_frame::set(isolate_, tracked);
+  EXPECT_EQ(Read(counter), 0);
+
+  BurnCpu();
+  {
+    node::async_context_frame::Scope scope(isolate_, untracked);
+    double charged = Read(counter);
+    EXPECT_GT(charged, 0);
+    BurnCpu();
+    EXPECT_EQ(Read(counter), charged);
+  }
+  node::async_context_frame::set(isolate_, Undefined(isolate_));
+  EXPECT_GT(Read(counter), 0);
+}
@@ -0,0 +1,77 @@
+#include "async_wrap-inl.h"
+#include "env-inl.h"
+#include "gtest/gtest.h"
+#include "node_test_fixture.h"
+#include "req_wrap-inl.h"
+
+using node::AsyncWrap;
+using node::AsyncWrapCounters;
+using node::Environment;
+using v8::FunctionTemplate;
+using v8::HandleScope;
+using v8::Local;
+using v8::Object;
+
+class AsyncWrapCountersTest : public EnvironmentTestFixture {};
+
+namespace {
+
+class TestReqWrap : public node::ReqWrap<uv_req_t> {
+ public:
+  SET_NO_MEMORY_INFO()
+  SET_MEMORY_INFO_NAME(TestReqWrap)
+  SET_SELF_SIZE(TestReqWrap)
+
+  TestReqWrap(Environment* env, Local<Object> object)
+      : node::ReqWrap<uv_req_t>(
+            env, object, AsyncWrap::PROVIDER_FSREQCALLBACK) {}
+};
+
+Local<Object> NewWrapObject(Environment* env) {
+  Local<FunctionTemplate> tmpl = FunctionTemplate::New(env->isolate());
+  tmpl->InstanceTemplate()->SetInternalFieldCount(
+      node::BaseObject::kInternalFieldCount);
+  return tmpl->GetFunction(env->context())
+      .ToLocalChecked()
+      ->NewInstance(env->context())
+      .ToLocalChecked();
+}
+
+uint64_t Count(AsyncWrapCounters* counters,
+               AsyncWrap::ProviderType provider,
+               AsyncWrapCounters::Field field) {
+  size_t base = static_cast<size_t>(provider) * AsyncWrapCounters::kFieldCount;
+  return (*counters->counters())[base + field];
+}
+
+}  // namespace
+
+TEST_F(AsyncWrapCountersTest, CountsByProvider) {
+  const HandleScope handle_scope(isolate_);
+  const Argv argv;
+  Env env{handle_scope, argv};
+  AsyncWrapCounters* counters = (*env)->async_wrap_counters();
+  constexpr AsyncWrap::ProviderType kProvider =
+      AsyncWrap::PROVIDER_FSREQCALLBACK;
+
+  // Wraps created before the counters were enabled are not counted.
+  auto uncounted = std::make_unique<TestReqWrap>(*env, NewWrapObject(*env));
+  EXPECT_FALSE(counters->enabled());
+  counters->Enable(isolate_);
+  ASSERT_TRUE(counters->enabled());
+
+  {
+    TestReqWrap first(*env, NewWrapObject(*env));
+    TestReqWrap second(*env, NewWrapObject(*env));
+    EXPECT_EQ(Count(counters, kProvider, AsyncWrapCounters::kCreated), 2u);
+    EXPECT_EQ(Count(counters, kProvider, AsyncWrapCounters::kLive), 2u);
+    first.Dispatched();
+    second.Dispatched();
+  }
+  uncounted->Dispatched();
+  uncounted.reset();
+
+  EXPECT_EQ(Count(counters, kProvider, AsyncWrapCounters::kCreated), 2u);
+  EXPECT_EQ(Count(counters, kProvider, AsyncWrapCounters::kDestroyed), 2u);
+  EXPECT_EQ(Count(counters, kProvider, AsyncWrapCounters::kLive), 0u);
+}
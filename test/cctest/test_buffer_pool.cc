@@ -0,0 +1,93 @@
+#include "buffer_pool.h"
+
+#include <cstring>
+#include <set>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+using node::BufferPool;
+
+namespace {
+
+// BufferPool deletes itself on Detach(), so it is always heap-allocated.
+BufferPool* NewPool() {
+  return new BufferPool();
+}
+
+}  // namespace
+
+TEST(BufferPoolTest, OnlyPoolsSmallLengths) {
+  BufferPool* pool = NewPool();
+  EXPECT_EQ(pool->Allocate(0), nullptr);
+  EXPECT_EQ(pool->Allocate(BufferPool::kMaxBlockSize + 1), nullptr);
+  void* block = pool->Allocate(BufferPool::kMaxBlockSize);
+  EXPECT_NE(block, nullptr);
+  BufferPool::Release(block, BufferPool::kMaxBlockSize, pool);
+  pool->Detach();
+}
+
+TEST(BufferPoolTest, ReusesReleasedBlocks) {
+  BufferPool* pool = NewPool();
+  void* first = pool->Allocate(100);
+  ASSERT_NE(first, nullptr);
+  EXPECT_EQ(pool->outstanding_blocks(), 1u);
+  BufferPool::Release(first, 100, pool);
+  EXPECT_EQ(pool->outstanding_blocks(), 0u);
+  // Any length within the same size class gets the same block back.
+  void* second = pool->Allocate(128);
+  EXPECT_EQ(second, first);
+  BufferPool::Release(second, 128, pool);
+  pool->Detach();
+}
+
+TEST(BufferPoolTest, BlocksDoNotOverlap) {
+  BufferPool* pool = NewPool();
+  std::vector<char*> blocks;
+  std::set<char*> unique;
+  for (size_t i = 0; i < 100; i++) {
+    char* block = static_cast<char*>(pool->Allocate(1000));
+    ASSERT_NE(block, nullptr);
+    memset(block, static_cast<int>(i), 1000);
+    blocks.push_back(block);
+    unique.insert(block);
+  }
+  EXPECT_EQ(unique.size(), blocks.size());
+  for (size_t i = 0; i < blocks.size(); i++) {
+    EXPECT_EQ(blocks[i][0], static_cast<char>(i));
+    EXPECT_EQ(blocks[i][999], static_cast<char>(i));
+    BufferPool::Release(blocks[i], 1000, pool);
+  }
+  pool->Detach();
+}
+
+TEST(BufferPoolTest, SizeClassesAreBounded) {
+  BufferPool* pool = NewPool();
+  const size_t per_class = BufferPool::kMaxSlabsPerClass *
+                           BufferPool::kSlabSize / BufferPool::kMaxBlockSize;
+  std::vector<void*> blocks;
+  for (size_t i = 0; i < per_class; i++) {
+    void* block = pool->Allocate(BufferPool::kMaxBlockSize);
+    ASSERT_NE(block, nullptr);
+    blocks.push_back(block);
+  }
+  EXPECT_EQ(pool->Allocate(BufferPool::kMaxBlockSize), nullptr);
+  // Other size classes are not affected.
+  void* small = pool->Allocate(1);
+  EXPECT_NE(small, nullptr);
+  BufferPool::Release(small, 1, pool);
+  for (void* block : blocks)
+    BufferPool::Release(block, BufferPool::kMaxBlockSize, pool);
+  pool->Detach();
+}
+
+TEST(BufferPoolTest, OutlivesDetachWhileBlocksAreOutstanding) {
+  BufferPool* pool = NewPool();
+  void* block = pool->Allocate(64);
+  ASSERT_NE(block, nullptr);
+  pool->Detach();
+  // The pool is still alive and deletes itself on the last release, which
+  // is checked by running this test under ASan.
+  memset(block, 0, 64);
+  BufferPool::Release(block, 64, pool);
+}
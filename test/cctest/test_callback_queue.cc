@@ -0,0 +1,74 @@
+#include "callback_queue-inl.h"
+#include "gtest/gtest.h"
+
+#include <array>
+#include <memory>
+#include <vector>
+
+namespace CallbackFlags = node::CallbackFlags;
+
+using Queue = node::CallbackQueue<void, std::vector<int>*>;
+
+namespace {
+
+auto Append(int value) {
+  return [value](std::vector<int>* out) { out->push_back(value); };
+}
+
+void RunAll(Queue* queue, std::vector<int>* out) {
+  while (auto head = queue->Shift()) head->Call(out);
+}
+
+}  // namespace
+
+TEST(CallbackQueueTest, RunsInOrder) {
+  for (auto allocation : {Queue::kHeapAllocated, Queue::kSlabAllocated}) {
+    Queue queue(allocation);
+    for (int i = 0; i < 200; i++)
+      queue.Push(queue.CreateCallback(Append(i), CallbackFlags::kRefed));
+    EXPECT_EQ(queue.size(), 200u);
+
+    std::vector<int> out;
+    RunAll(&queue, &out);
+    EXPECT_EQ(queue.size(), 0u);
+    ASSERT_EQ(out.size(), 200u);
+    for (int i = 0; i < 200; i++) EXPECT_EQ(out[i], i);
+  }
+}
+
+TEST(CallbackQueueTest, SlabReusesSlots) {
+  Queue queue(Queue::kSlabAllocated);
+  auto first = queue.CreateCallback(Append(1), CallbackFlags::kRefed);
+  Queue::Callback* address = first.get();
+  first.reset();
+  auto second = queue.CreateCallback(Append(2), CallbackFlags::kRefed);
+  EXPECT_EQ(second.get(), address);
+}
+
+TEST(CallbackQueueTest, DestroysCallbacks) {
+  auto counter = std::make_shared<int>(0);
+  std::array<char, 256> large{};
+  {
+    Queue queue(Queue::kSlabAllocated);
+    // Too large for a slot, so this one is allocated separately.
+    queue.Push(queue.CreateCallback(
+        [counter, large](std::vector<int>* out) { out->push_back(large[0]); },
+        CallbackFlags::kRefed));
+    queue.Push(queue.CreateCallback(
+        [counter](std::vector<int>* out) { out->push_back(*counter); },
+        CallbackFlags::kUnrefed));
+    EXPECT_EQ(counter.use_count(), 3);
+
+    Queue moved;
+    moved.ConcatMove(std::move(queue));
+    EXPECT_EQ(queue.size(), 0u);
+    EXPECT_EQ(moved.size(), 2u);
+    auto head = moved.Shift();
+    EXPECT_EQ(head->flags(), CallbackFlags::kRefed);
+    head.reset();
+    EXPECT_EQ(counter.use_count(), 2);
+    // The remaining callback is destroyed with the queue, before the slab of
+    // the queue that created it.
+  }
+  EXPECT_EQ(counter.use_count(), 1);
+}
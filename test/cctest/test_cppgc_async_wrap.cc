@@ -0,0 +1,123 @@
+#include "cppgc_async_wrap-inl.h"
+#include "env-inl.h"
+#include "gtest/gtest.h"
+#include "node_test_fixture.h"
+
+#include "cppgc/allocation.h"
+
+using node::AsyncWrap;
+using node::AsyncWrapCounters;
+using node::CppgcAsyncWrap;
+using node::Environment;
+using v8::FunctionTemplate;
+using v8::HandleScope;
+using v8::Local;
+using v8::Number;
+using v8::Object;
+using v8::Value;
+
+class CppgcAsyncWrapTest : public EnvironmentTestFixture {};
+
+namespace {
+
+class TestCppgcWrap final : public CppgcAsyncWrap {
+ public:
+  static int clean_count;
+
+  SET_CPPGC_NAME(TestCppgcWrap)
+  SET_NO_MEMORY_INFO()
+  void Trace(cppgc::Visitor* visitor) const final {
+    CppgcAsyncWrap::Trace(visitor);
+  }
+
+  TestCppgcWrap(Environment* env, Local<Object> object) {
+    CppgcAsyncWrap::Wrap(this, env, object, AsyncWrap::PROVIDER_QUERYWRAP);
+  }
+  ~TestCppgcWrap() override { this->Finalize(); }
+
+  void Clean(node::Realm* realm) override {
+    clean_count++;
+    CppgcAsyncWrap::Clean(realm);
+  }
+};
+
+int TestCppgcWrap::clean_count = 0;
+
+Local<Object> NewWrapObject(Environment* env) {
+  Local<FunctionTemplate> tmpl =
+      node::BaseObject::MakeLazilyInitializedJSTemplate(env);
+  tmpl->Inherit(CppgcAsyncWrap::GetConstructorTemplate(env->isolate_data()));
+  return tmpl->GetFunction(env->context())
+      .ToLocalChecked()
+      ->NewInstance(env->context())
+      .ToLocalChecked();
+}
+
+TestCppgcWrap* NewWrap(Environment* env, Local<Object> object) {
+  return cppgc::MakeGarbageCollected<TestCppgcWrap>(
+      env->cppgc_allocation_handle(), env, object);
+}
+
+double CallMethod(Environment* env, Local<Object> object, const char* name) {
+  Local<Value> method =
+      object->Get(env->context(), node::OneByteString(env->isolate(), name))
+          .ToLocalChecked();
+  return method.As<v8::Function>()
+      ->Call(env->context(), object, 0, nullptr)
+      .ToLocalChecked()
+      .As<Number>()
+      ->Value();
+}
+
+uint64_t Count(AsyncWrapCounters* counters,
+               AsyncWrap::ProviderType provider,
+               AsyncWrapCounters::Field field) {
+  size_t base = static_cast<size_t>(provider) * AsyncWrapCounters::kFieldCount;
+  return (*counters->counters())[base + field];
+}
+
+}  // namespace
+
+TEST_F(CppgcAsyncWrapTest, RunsTheHooksOfAnAsyncWrap) {
+  const HandleScope handle_scope(isolate_);
+  const Argv argv;
+  Env env{handle_scope, argv};
+  AsyncWrapCounters* counters = (*env)->async_wrap_counters();
+  counters->Enable(isolate_);
+  constexpr AsyncWrap::ProviderType kProvider = AsyncWrap::PROVIDER_QUERYWRAP;
+
+  Local<Object> unwrapped = NewWrapObject(*env);
+  EXPECT_EQ(CallMethod(*env, unwrapped, "getAsyncId"),
+            AsyncWrap::kInvalidAsyncId);
+  EXPECT_EQ(CallMethod(*env, unwrapped, "getProviderType"),
+            static_cast<double>(AsyncWrap::PROVIDER_NONE));
+
+  Local<Object> object = NewWrapObject(*env);
+  TestCppgcWrap* wrap = NewWrap(*env, object);
+  EXPECT_EQ(wrap->provider_type(), kProvider);
+  EXPECT_GT(wrap->get_async_id(), 0);
+  EXPECT_EQ(CppgcAsyncWrap::Unwrap<TestCppgcWrap>(object), wrap);
+  EXPECT_EQ(CallMethod(*env, object, "getAsyncId"), wrap->get_async_id());
+  EXPECT_EQ(CallMethod(*env, object, "getProviderType"),
+            static_cast<double>(kProvider));
+  EXPECT_EQ(Count(counters, kProvider, AsyncWrapCounters::kLive), 1u);
+
+  // The destroy hook runs once, when the request is done.
+  wrap->EmitDestroy();
+  wrap->EmitDestroy();
+  EXPECT_EQ(wrap->get_async_id(), AsyncWrap::kInvalidAsyncId);
+  EXPECT_EQ(Count(counters, kProvider, AsyncWrapCounters::kCreated), 1u);
+  EXPECT_EQ(Count(counters, kProvider, AsyncWrapCounters::kDestroyed), 1u);
+  EXPECT_EQ(Count(counters, kProvider, AsyncWrapCounters::kLive), 0u);
+}
+
+TEST_F(CppgcAsyncWrapTest, IsCleanedUpWithTheRealm) {
+  TestCppgcWrap::clean_count = 0;
+  {
+    const HandleScope handle_scope(isolate_);
+    const Argv argv;
+    Env env{handle_scope, argv};
+    NewWrap(*env, NewWrapObject(*env));
+  }
+  EXPECT_EQ(TestCppgcWrap::clean_count, 1);
+}
@@ -0,0 +1,199 @@
+#include "crypto/crypto_bio.h"
+#include "gtest/gtest.h"
+
+// The bundled OpenSSL is built without kTLS.
+#ifdef NODE_HAVE_KTLS
+#include <linux/tls.h>
+#include <openssl/evp.h>
+#include <openssl/ssl.h>
+#include <openssl/x509.h>
+
+#include <cerrno>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+using node::crypto::NodeBIO;
+
+namespace {
+
+// Stands in for the socket under a TLSWrap, without a kernel behind it.
+class FakeSocket final : public NodeBIO::KTLSSocket {
+ public:
+  bool FlushForKTLS(NodeBIO* bio) override {
+    if (!writable) return false;
+    std::string data(bio->Length(), '\0');
+    bio->Read(data.data(), data.size());
+    wire += data;
+    return true;
+  }
+
+  int StartKTLS(const void* info, size_t size) override {
+    memcpy(&crypto_info, info, sizeof(crypto_info));
+    crypto_info_size = size;
+    return start_error;
+  }
+
+  ssize_t SendKTLSRecord(uint8_t record_type,
+                         const char* data,
+                         size_t size) override {
+    records.emplace_back(record_type, std::string(data, size));
+    return size;
+  }
+
+  bool writable = true;
+  int start_error = 0;
+  // What the peer receives before the kernel encrypts.
+  std::string wire;
+  tls_crypto_info crypto_info{};
+  size_t crypto_info_size = 0;
+  std::vector<std::pair<int, std::string>> records;
+};
+
+std::string Drain(BIO* bio) {
+  std::string data(BIO_pending(bio), '\0');
+  if (!data.empty()) BIO_read(bio, data.data(), data.size());
+  return data;
+}
+
+// A TLS 1.3 server that writes through a NodeBIO on a FakeSocket, as a
+// TLSWrap does after enableKTLS(), and a client on memory BIOs.
+class KTLSTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    EVP_PKEY* key = EVP_EC_gen("P-256");
+    ASSERT_NE(key, nullptr);
+    X509* cert = X509_new();
+    ASN1_INTEGER_set(X509_get_serialNumber(cert), 1);
+    X509_gmtime_adj(X509_getm_notBefore(cert), 0);
+    X509_gmtime_adj(X509_getm_notAfter(cert), 3600);
+    X509_set_pubkey(cert, key);
+    X509_sign(cert, key, EVP_sha256());
+
+    server_ctx_ = SSL_CTX_new(TLS_server_method());
+    client_ctx_ = SSL_CTX_new(TLS_client_method());
+    ASSERT_EQ(SSL_CTX_use_certificate(server_ctx_, cert), 1);
+    ASSERT_EQ(SSL_CTX_use_PrivateKey(server_ctx_, key), 1);
+    X509_free(cert);
+    EVP_PKEY_free(key);
+    for (SSL_CTX* ctx : {server_ctx_, client_ctx_}) {
+      SSL_CTX_set_min_proto_version(ctx, TLS1_3_VERSION);
+      SSL_CTX_set_ciphersuites(ctx, "TLS_AES_128_GCM_SHA256");
+    }
+
+    server_ = SSL_new(server_ctx_);
+    server_out_ = NodeBIO::New().release();
+    NodeBIO::FromBIO(server_out_)->set_ktls_socket(&socket_);
+    server_in_ = NodeBIO::New().release();
+    SSL_set_bio(server_, server_in_, server_out_);
+    SSL_set_options(server_, SSL_OP_ENABLE_KTLS);
+    SSL_set_accept_state(server_);
+
+    client_ = SSL_new(client_ctx_);
+    client_in_ = BIO_new(BIO_s_mem());
+    client_out_ = BIO_new(BIO_s_mem());
+    SSL_set_bio(client_, client_in_, client_out_);
+    SSL_set_connect_state(client_);
+  }
+
+  void TearDown() override {
+    SSL_free(server_);
+    SSL_free(client_);
+    SSL_CTX_free(server_ctx_);
+    SSL_CTX_free(client_ctx_);
+  }
+
+  // Passes what each side wrote to the other. |plaintext| gets what the
+  // server wrote through the kernel, which the fake socket does not encrypt.
+  void Pump(std::string* plaintext = nullptr) {
+    const std::string to_server = Drain(client_out_);
+    NodeBIO::FromBIO(server_in_)->Write(to_server.data(), to_server.size());
+    std::string to_client = std::move(socket_.wire);
+    socket_.wire.clear();
+    const std::string written = Drain(server_out_);
+    if (NodeBIO::FromBIO(server_out_)->ktls_send()) {
+      if (plaintext != nullptr) *plaintext += written;
+    } else {
+      to_client += written;
+    }
+    BIO_write(client_in_, to_client.data(), to_client.size());
+  }
+
+  void Handshake() {
+    for (int i = 0; i < 10; i++) {
+      SSL_do_handshake(client_);
+      Pump();
+      SSL_do_handshake(server_);
+      Pump();
+    }
+    ASSERT_TRUE(SSL_is_init_finished(client_));
+    ASSERT_TRUE(SSL_is_init_finished(server_));
+  }
+
+  // Writes from the server, and returns what the client reads.
+  std::string ServerToClient(const std::string& data) {
+    EXPECT_EQ(SSL_write(server_, data.data(), data.size()),
+              static_cast<int>(data.size()));
+    Pump();
+    std::string received(data.size(), '\0');
+    const int read = SSL_read(client_, received.data(), received.size());
+    received.resize(read > 0 ? read : 0);
+    return received;
+  }
+
+  FakeSocket socket_;
+  SSL_CTX* server_ctx_ = nullptr;
+  SSL_CTX* client_ctx_ = nullptr;
+  SSL* server_ = nullptr;
+  SSL* client_ = nullptr;
+  BIO* server_in_ = nullptr;
+  BIO* server_out_ = nullptr;
+  BIO* client_in_ = nullptr;
+  BIO* client_out_ = nullptr;
+};
+
+}  // namespace
+
+TEST_F(KTLSTest, HandsTheWriteSideToTheKernel) {
+  Handshake();
+  NodeBIO* bio = NodeBIO::FromBIO(server_out_);
+  EXPECT_TRUE(bio->ktls_send());
+  EXPECT_EQ(bio->ktls_error(), 0);
+  EXPECT_EQ(socket_.crypto_info.version, TLS_1_3_VERSION);
+  EXPECT_EQ(socket_.crypto_info.cipher_type, TLS_CIPHER_AES_GCM_128);
+  EXPECT_EQ(socket_.crypto_info_size, sizeof(tls12_crypto_info_aes_gcm_128));
+
+  // The session tickets are handshake records of their own.
+  ASSERT_FALSE(socket_.records.empty());
+  for (const auto& record : socket_.records)
+    EXPECT_EQ(record.first, SSL3_RT_HANDSHAKE);
+
+  // Application data is left for the kernel to encrypt.
+  ASSERT_EQ(SSL_write(server_, "hello", 5), 5);
+  std::string plaintext;
+  Pump(&plaintext);
+  EXPECT_EQ(plaintext, "hello");
+}
+
+TEST_F(KTLSTest, KeepsEncryptingWithoutTheTLSModule) {
+  socket_.start_error = ENOENT;
+  Handshake();
+  NodeBIO* bio = NodeBIO::FromBIO(server_out_);
+  EXPECT_FALSE(bio->ktls_send());
+  EXPECT_EQ(bio->ktls_error(), ENOENT);
+  EXPECT_TRUE(socket_.records.empty());
+  EXPECT_EQ(ServerToClient("hello"), "hello");
+}
+
+TEST_F(KTLSTest, KeepsEncryptingWhileWritesAreInFlight) {
+  socket_.writable = false;
+  Handshake();
+  NodeBIO* bio = NodeBIO::FromBIO(server_out_);
+  EXPECT_FALSE(bio->ktls_send());
+  EXPECT_EQ(bio->ktls_error(), EAGAIN);
+  EXPECT_EQ(socket_.crypto_info_size, 0u);
+  EXPECT_EQ(ServerToClient("hello"), "hello");
+}
+
+#endif  // NODE_HAVE_KTLS
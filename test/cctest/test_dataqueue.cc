@@ -2,6 +2,7 @@
 #include <gtest/gtest.h>
 #include <node_bob-inl.h>
 #include <util-inl.h>
+#include <uv.h>
 #include <v8.h>
 #include <memory>
 #include <vector>
@@ -658,3 +659,294 @@ TEST(DataQueue, DataQueueEntry) {
   CHECK(!pullIsPending);
   CHECK_EQ(status, node::bob::STATUS_CONTINUE);
 }
+
+TEST(DataQueue, GatheredPull) {
+  char buffer1[] = "hello world";
+  char buffer2[] = "what fun this is";
+  char buffer3[] = "appended later";
+  size_t len1 = strlen(buffer1);
+  size_t len2 = strlen(buffer2);
+  size_t len3 = strlen(buffer3);
+
+  std::shared_ptr<BackingStore> store1 = ArrayBuffer::NewBackingStore(
+      &buffer1, len1, [](void*, size_t, void*) {}, nullptr);
+  std::shared_ptr<BackingStore> store2 = ArrayBuffer::NewBackingStore(
+      &buffer2, len2, [](void*, size_t, void*) {}, nullptr);
+  std::shared_ptr<BackingStore> store3 = ArrayBuffer::NewBackingStore(
+      &buffer3, len3, [](void*, size_t, void*) {}, nullptr);
+
+  const int options = node::bob::OPTIONS_SYNC | node::bob::OPTIONS_GATHER;
+
+  // With OPTIONS_GATHER, the in-memory entries of an idempotent DataQueue
+  // come in a single pull, empty ones included, up to max_count_hint.
+  std::vector<std::unique_ptr<DataQueue::Entry>> list;
+  list.push_back(
+      DataQueue::CreateInMemoryEntryFromBackingStore(store1, 0, len1));
+  list.push_back(DataQueue::CreateInMemoryEntryFromBackingStore(store2, 0, 0));
+  list.push_back(
+      DataQueue::CreateInMemoryEntryFromBackingStore(store2, 0, len2));
+  std::shared_ptr<DataQueue> data_queue =
+      DataQueue::CreateIdempotent(std::move(list));
+  CHECK_NOT_NULL(data_queue);
+
+  std::shared_ptr<DataQueue::Reader> reader = data_queue->get_reader();
+  int calls = 0;
+  int status = reader->Pull(
+      [&](int status, const DataQueue::Vec* vecs, size_t count, auto done) {
+        calls++;
+        CHECK_EQ(status, node::bob::STATUS_CONTINUE);
+        CHECK_EQ(count, 1);
+        CHECK_EQ(vecs[0].len, len1);
+        std::move(done)(0);
+      },
+      options,
+      nullptr,
+      0,
+      1);
+  CHECK_EQ(status, node::bob::STATUS_CONTINUE);
+  status = reader->Pull(
+      [&](int status, const DataQueue::Vec* vecs, size_t count, auto done) {
+        calls++;
+        CHECK_EQ(status, node::bob::STATUS_CONTINUE);
+        CHECK_EQ(count, 1);
+        CHECK_EQ(vecs[0].len, len2);
+        CHECK_EQ(memcmp(vecs[0].base, buffer2, len2), 0);
+        std::move(done)(0);
+      },
+      options,
+      nullptr,
+      0);
+  CHECK_EQ(status, node::bob::STATUS_CONTINUE);
+  status = reader->Pull(
+      [&](int status, const DataQueue::Vec* vecs, size_t count, auto done) {
+        calls++;
+        CHECK_EQ(status, node::bob::STATUS_EOS);
+        CHECK_EQ(count, 0);
+      },
+      options,
+      nullptr,
+      0);
+  CHECK_EQ(status, node::bob::STATUS_EOS);
+  CHECK_EQ(calls, 3);
+
+  // A second reader gets both chunks at once.
+  reader = data_queue->get_reader();
+  status = reader->Pull(
+      [&](int status, const DataQueue::Vec* vecs, size_t count, auto done) {
+        CHECK_EQ(count, 2);
+        CHECK_EQ(memcmp(vecs[0].base, buffer1, len1), 0);
+        CHECK_EQ(memcmp(vecs[1].base, buffer2, len2), 0);
+        std::move(done)(0);
+      },
+      options,
+      nullptr,
+      0);
+  CHECK_EQ(status, node::bob::STATUS_CONTINUE);
+
+  // Non-idempotent DataQueues still pick up entries appended after the
+  // gathered pull drained them.
+  std::shared_ptr<DataQueue> queue = DataQueue::Create();
+  queue->append(
+      DataQueue::CreateInMemoryEntryFromBackingStore(store1, 0, len1));
+  queue->append(
+      DataQueue::CreateInMemoryEntryFromBackingStore(store2, 0, len2));
+  reader = queue->get_reader();
+  status = reader->Pull(
+      [&](int status, const DataQueue::Vec* vecs, size_t count, auto done) {
+        CHECK_EQ(status, node::bob::STATUS_CONTINUE);
+        CHECK_EQ(count, 2);
+        std::move(done)(0);
+      },
+      options,
+      nullptr,
+      0);
+  CHECK_EQ(status, node::bob::STATUS_CONTINUE);
+  queue->append(
+      DataQueue::CreateInMemoryEntryFromBackingStore(store3, 0, len3));
+  status = reader->Pull(
+      [&](int status, const DataQueue::Vec* vecs, size_t count, auto done) {
+        CHECK_EQ(count, 1);
+        CHECK_EQ(memcmp(vecs[0].base, buffer3, len3), 0);
+        std::move(done)(0);
+      },
+      options,
+      nullptr,
+      0);
+  CHECK_EQ(status, node::bob::STATUS_CONTINUE);
+
+  // Having drained the queue, the reader waits for more until it is capped.
+  status = reader->Pull(
+      [&](int status, const DataQueue::Vec* vecs, size_t count, auto done) {
+        CHECK_EQ(status, node::bob::STATUS_BLOCK);
+      },
+      options,
+      nullptr,
+      0);
+  CHECK_EQ(status, node::bob::STATUS_BLOCK);
+  queue->cap();
+  status = reader->Pull(
+      [&](int status, const DataQueue::Vec* vecs, size_t count, auto done) {
+        CHECK_EQ(status, node::bob::STATUS_EOS);
+      },
+      options,
+      nullptr,
+      0);
+  CHECK_EQ(status, node::bob::STATUS_EOS);
+}
+
+TEST(DataQueue, GatheredPullOfNestedQueues) {
+  char buffer1[] = "hello world";
+  char buffer2[] = "what fun this is";
+  char buffer3[] = "in the outer queue";
+  size_t len1 = strlen(buffer1);
+  size_t len2 = strlen(buffer2);
+  size_t len3 = strlen(buffer3);
+
+  std::shared_ptr<BackingStore> store1 = ArrayBuffer::NewBackingStore(
+      &buffer1, len1, [](void*, size_t, void*) {}, nullptr);
+  std::shared_ptr<BackingStore> store2 = ArrayBuffer::NewBackingStore(
+      &buffer2, len2, [](void*, size_t, void*) {}, nullptr);
+  std::shared_ptr<BackingStore> store3 = ArrayBuffer::NewBackingStore(
+      &buffer3, len3, [](void*, size_t, void*) {}, nullptr);
+
+  const int options = node::bob::OPTIONS_SYNC | node::bob::OPTIONS_GATHER;
+
+  // Like a Blob made of another Blob and a string.
+  std::vector<std::unique_ptr<DataQueue::Entry>> inner;
+  inner.push_back(
+      DataQueue::CreateInMemoryEntryFromBackingStore(store1, 0, len1));
+  inner.push_back(
+      DataQueue::CreateInMemoryEntryFromBackingStore(store2, 0, len2));
+  std::vector<std::unique_ptr<DataQueue::Entry>> outer;
+  outer.push_back(DataQueue::CreateDataQueueEntry(
+      DataQueue::CreateIdempotent(std::move(inner))));
+  outer.push_back(
+      DataQueue::CreateInMemoryEntryFromBackingStore(store3, 0, len3));
+  std::shared_ptr<DataQueue> data_queue =
+      DataQueue::CreateIdempotent(std::move(outer));
+  CHECK_NOT_NULL(data_queue);
+
+  // The chunks of the nested queue come with those of the outer one.
+  std::shared_ptr<DataQueue::Reader> reader = data_queue->get_reader();
+  int status = reader->Pull(
+      [&](int status, const DataQueue::Vec* vecs, size_t count, auto done) {
+        CHECK_EQ(status, node::bob::STATUS_CONTINUE);
+        CHECK_EQ(count, 3);
+        CHECK_EQ(memcmp(vecs[0].base, buffer1, len1), 0);
+        CHECK_EQ(memcmp(vecs[1].base, buffer2, len2), 0);
+        CHECK_EQ(memcmp(vecs[2].base, buffer3, len3), 0);
+        std::move(done)(0);
+      },
+      options,
+      nullptr,
+      0);
+  CHECK_EQ(status, node::bob::STATUS_CONTINUE);
+
+  // A nested queue is not split up to fit max_count_hint.
+  reader = data_queue->get_reader();
+  status = reader->Pull(
+      [&](int status, const DataQueue::Vec* vecs, size_t count, auto done) {
+        CHECK_EQ(count, 2);
+        CHECK_EQ(vecs[1].len, len2);
+        std::move(done)(0);
+      },
+      options,
+      nullptr,
+      0,
+      2);
+  CHECK_EQ(status, node::bob::STATUS_CONTINUE);
+  status = reader->Pull(
+      [&](int status, const DataQueue::Vec* vecs, size_t count, auto done) {
+        CHECK_EQ(count, 1);
+        CHECK_EQ(vecs[0].len, len3);
+        std::move(done)(0);
+      },
+      options,
+      nullptr,
+      0,
+      2);
+  CHECK_EQ(status, node::bob::STATUS_CONTINUE);
+
+  // The entries of a non-idempotent nested queue are read through its reader.
+  std::shared_ptr<DataQueue> growing = DataQueue::Create();
+  growing->append(
+      DataQueue::CreateInMemoryEntryFromBackingStore(store1, 0, len1));
+  growing->cap();
+  std::shared_ptr<DataQueue> queue = DataQueue::Create();
+  queue->append(DataQueue::CreateDataQueueEntry(growing));
+  queue->append(
+      DataQueue::CreateInMemoryEntryFromBackingStore(store3, 0, len3));
+  queue->cap();
+  reader = queue->get_reader();
+  status = reader->Pull(
+      [&](int status, const DataQueue::Vec* vecs, size_t count, auto done) {
+        CHECK_EQ(status, node::bob::STATUS_CONTINUE);
+        CHECK_EQ(count, 1);
+        CHECK_EQ(vecs[0].len, len1);
+        std::move(done)(0);
+      },
+      options,
+      nullptr,
+      0);
+  CHECK_EQ(status, node::bob::STATUS_CONTINUE);
+}
+
+TEST(DataQueue, CrossThreadNonIdempotent) {
+  static constexpr size_t kEntries = 1000;
+  char buffer[] = "hello world";
+  size_t len = strlen(buffer);
+
+  std::shared_ptr<BackingStore> store = ArrayBuffer::NewBackingStore(
+      &buffer, len, [](void*, size_t, void*) {}, nullptr);
+
+  class Listener final : public DataQueue::BackpressureListener {
+   public:
+    void EntryRead(size_t amount) override { read += amount; }
+    size_t read = 0;
+  };
+
+  std::shared_ptr<DataQueue> data_queue = DataQueue::Create();
+  Listener listener;
+  data_queue->addBackpressureListener(&listener);
+  std::shared_ptr<DataQueue::Reader> reader = data_queue->get_reader();
+
+  // One thread appends to the queue while this one drains it.
+  struct Producer {
+    std::shared_ptr<DataQueue> data_queue;
+    std::shared_ptr<BackingStore> store;
+    size_t len;
+  } producer_data{data_queue, store, len};
+  uv_thread_t producer;
+  CHECK_EQ(0, uv_thread_create(&producer, [](void* data) {
+    Producer* producer = static_cast<Producer*>(data);
+    for (size_t n = 0; n < kEntries; n++) {
+      CHECK(producer->data_queue
+                ->append(DataQueue::CreateInMemoryEntryFromBackingStore(
+                    producer->store, 0, producer->len))
+                .value());
+    }
+    producer->data_queue->cap();
+  }, &producer_data));
+
+  size_t total = 0;
+  int status;
+  do {
+    status = reader->Pull(
+        [&](int status, const DataQueue::Vec* vecs, size_t count, auto done) {
+          for (size_t n = 0; n < count; n++) {
+            CHECK_EQ(memcmp(vecs[n].base, buffer, vecs[n].len), 0);
+            total += vecs[n].len;
+          }
+          std::move(done)(0);
+        },
+        node::bob::OPTIONS_SYNC | node::bob::OPTIONS_GATHER,
+        nullptr,
+        0);
+  } while (status != node::bob::STATUS_EOS && status >= 0);
+
+  CHECK_EQ(0, uv_thread_join(&producer));
+  CHECK_EQ(status, node::bob::STATUS_EOS);
+  CHECK_EQ(total, kEntries * len);
+  CHECK_EQ(listener.read, total);
+  data_queue->removeBackpressureListener(&listener);
+}
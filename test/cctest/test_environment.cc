@@ -681,6 +681,42 @@ TEST_F(NodeZeroIsolateTestFixture, CtrlCWithOnlySafeTerminationTest) {
 }
 #endif  // _WIN32
 
+TEST_F(NodeZeroIsolateTestFixture, CommonEnvironmentSetupReset) {
+  const std::vector<std::string> args = {"node"};
+  std::vector<std::string> errors;
+  std::unique_ptr<node::CommonEnvironmentSetup> setup =
+      node::CommonEnvironmentSetup::Create(
+          platform.get(), &errors, args, std::vector<std::string>{});
+  ASSERT_TRUE(setup);
+  v8::Isolate* isolate = setup->isolate();
+  node::IsolateData* isolate_data = setup->isolate_data();
+
+  for (int i = 0; i < 3; i++) {
+    {
+      v8::Locker locker(isolate);
+      v8::Isolate::Scope isolate_scope(isolate);
+      v8::HandleScope handle_scope(isolate);
+      v8::Context::Scope context_scope(setup->context());
+      // Every Environment starts over with a new global object.
+      v8::Local<v8::Value> ret =
+          node::LoadEnvironment(setup->env(),
+                                "globalThis.runs = (globalThis.runs ?? 0) + 1;"
+                                "return globalThis.runs;")
+              .ToLocalChecked();
+      EXPECT_EQ(ret->Int32Value(setup->context()).FromJust(), 1);
+      EXPECT_EQ(node::SpinEventLoop(setup->env()).FromJust(), 0);
+    }
+
+    node::Environment* env = setup->ResetEnvironment(
+        &errors, args, std::vector<std::string>{});
+    ASSERT_NE(env, nullptr);
+    EXPECT_TRUE(errors.empty());
+    EXPECT_EQ(setup->env(), env);
+    EXPECT_EQ(setup->isolate(), isolate);
+    EXPECT_EQ(setup->isolate_data(), isolate_data);
+  }
+}
+
 TEST_F(EnvironmentTest, NestedMicrotaskQueue) {
   const v8::HandleScope handle_scope(isolate_);
   const Argv argv;
@@ -807,3 +843,55 @@ TEST_F(EnvironmentTest, EmbedderPreload) {
   node::Utf8Value main_ret_str(isolate_, main_ret);
   EXPECT_EQ(std::string(*main_ret_str), "preload");
 }
+
+TEST_F(EnvironmentTest, TimerSlack) {
+  const v8::HandleScope handle_scope(isolate_);
+  const Argv argv;
+  Env env{handle_scope, argv};
+
+  EXPECT_EQ((*env)->timer_slack(), 0u);
+  EXPECT_EQ((*env)->ApplyTimerSlack(7), 7u);
+
+  (*env)->set_timer_slack(10);
+  uint64_t now = uv_now((*env)->event_loop());
+  for (uint64_t duration : {1, 9, 10, 11, 1234}) {
+    uint64_t slacked = (*env)->ApplyTimerSlack(duration);
+    EXPECT_GE(slacked, duration);
+    EXPECT_LT(slacked, duration + 10);
+    EXPECT_EQ((now + slacked) % 10, 0u);
+  }
+}
+
+TEST_F(EnvironmentTest, CallbackBatchScopeCoalescesMicrotasks) {
+  const v8::HandleScope handle_scope(isolate_);
+  const Argv argv;
+  Env env{handle_scope, argv};
+  Local<v8::Object> resource = v8::Object::New(isolate_);
+
+  static int microtasks_run = 0;
+  auto enqueue = [&]() {
+    isolate_->EnqueueMicrotask([](void*) { microtasks_run++; }, nullptr);
+  };
+  auto run_callback = [&]() {
+    node::InternalCallbackScope scope(*env, resource, {1, 0});
+    enqueue();
+  };
+
+  microtasks_run = 0;
+  {
+    node::CallbackBatchScope batch(*env, resource);
+    run_callback();
+    EXPECT_EQ(microtasks_run, 1);
+  }
+
+  (*env)->options()->coalesce_task_queues = true;
+  microtasks_run = 0;
+  {
+    node::CallbackBatchScope batch(*env, resource);
+    run_callback();
+    run_callback();
+    EXPECT_EQ(microtasks_run, 0);
+  }
+  EXPECT_EQ(microtasks_run, 2);
+  (*env)->options()->coalesce_task_queues = false;
+}
@@ -0,0 +1,83 @@
+#include "event_loop_phases.h"
+#include "gtest/gtest.h"
+#include "histogram-inl.h"
+#include "uv.h"
+
+using node::EventLoopPhase;
+using node::EventLoopPhaseTimer;
+
+namespace {
+
+size_t Count(EventLoopPhaseTimer* timer, EventLoopPhase phase) {
+  return timer->histogram(phase)->Count();
+}
+
+}  // namespace
+
+TEST(EventLoopPhaseTimerTest, DisabledRecordsNothing) {
+  EventLoopPhaseTimer timer;
+  EXPECT_FALSE(timer.enabled());
+  EXPECT_EQ(timer.histogram(EventLoopPhase::kPoll), nullptr);
+  timer.Record(EventLoopPhase::kPoll, 1000);
+  timer.EndCheck();
+  {
+    EventLoopPhaseTimer::Scope scope(&timer, EventLoopPhase::kTimers);
+  }
+}
+
+TEST(EventLoopPhaseTimerTest, RecordsLoopPhases) {
+  uv_loop_t loop;
+  ASSERT_EQ(uv_loop_init(&loop), 0);
+  ASSERT_EQ(uv_loop_configure(&loop, UV_METRICS_IDLE_TIME), 0);
+
+  // Stand in for Environment::CheckImmediate(), which ends the check phase
+  // and is started before the EventLoopPhaseTimer is enabled.
+  EventLoopPhaseTimer timer;
+  uv_check_t check;
+  ASSERT_EQ(uv_check_init(&loop, &check), 0);
+  check.data = &timer;
+  ASSERT_EQ(uv_check_start(&check,
+                           [](uv_check_t* handle) {
+                             static_cast<EventLoopPhaseTimer*>(handle->data)
+                                 ->EndCheck();
+                           }),
+            0);
+  uv_unref(reinterpret_cast<uv_handle_t*>(&check));
+
+  timer.Enable(&loop);
+  ASSERT_TRUE(timer.enabled());
+
+  // Keep the loop alive for a few iterations.
+  uv_timer_t uv_timer;
+  int ticks = 0;
+  ASSERT_EQ(uv_timer_init(&loop, &uv_timer), 0);
+  uv_timer.data = &ticks;
+  ASSERT_EQ(uv_timer_start(&uv_timer,
+                           [](uv_timer_t* handle) {
+                             int* ticks = static_cast<int*>(handle->data);
+                             if (++*ticks == 3) uv_timer_stop(handle);
+                           },
+                           1,
+                           1),
+            0);
+  ASSERT_EQ(uv_run(&loop, UV_RUN_DEFAULT), 0);
+  EXPECT_EQ(ticks, 3);
+
+  EXPECT_GE(Count(&timer, EventLoopPhase::kPoll), 3u);
+  EXPECT_GE(Count(&timer, EventLoopPhase::kCheck), 3u);
+  // Every iteration but the first has a pending phase.
+  EXPECT_GE(Count(&timer, EventLoopPhase::kPending), 2u);
+  EXPECT_EQ(Count(&timer, EventLoopPhase::kTimers), 0u);
+
+  {
+    EventLoopPhaseTimer::Scope scope(&timer, EventLoopPhase::kTimers);
+  }
+  EXPECT_EQ(Count(&timer, EventLoopPhase::kTimers), 1u);
+
+  uv_close(timer.prepare_handle(), nullptr);
+  uv_close(timer.check_handle(), nullptr);
+  uv_close(reinterpret_cast<uv_handle_t*>(&check), nullptr);
+  uv_close(reinterpret_cast<uv_handle_t*>(&uv_timer), nullptr);
+  ASSERT_EQ(uv_run(&loop, UV_RUN_DEFAULT), 0);
+  ASSERT_EQ(uv_loop_close(&loop), 0);
+}
@@ -0,0 +1,181 @@
+#include "env-inl.h"
+#include "gtest/gtest.h"
+#include "node_realm-inl.h"
+#include "node_test_fixture.h"
+#include "util-inl.h"
+
+#ifndef _WIN32
+#include <sys/stat.h>
+#include <utime.h>
+
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+using v8::Context;
+using v8::Function;
+using v8::Local;
+using v8::Script;
+using v8::String;
+using v8::Value;
+
+namespace fs = std::filesystem;
+
+// Calls cpSyncCopyDir(src, dest, force, dereference, errorOnExist,
+// verbatimSymlinks, preserveTimestamps), and returns the code of the error
+// that it throws, or "ok".
+static const char kCopyScript[] =
+    "(function(internalBinding, src, dest, force, errorOnExist) {"
+    "  const { cpSyncCopyDir } = internalBinding('fs');"
+    "  try {"
+    "    cpSyncCopyDir(src, dest, force, false, errorOnExist, false, true);"
+    "    return 'ok';"
+    "  } catch (err) {"
+    "    return err.code;"
+    "  }"
+    "})";
+
+class FsCpSyncTest : public EnvironmentTestFixture {
+ protected:
+  static constexpr int kFiles = 200;
+
+  void SetUp() override {
+    EnvironmentTestFixture::SetUp();
+    char path[] = "/tmp/node-cp-test-XXXXXX";
+    ASSERT_NE(mkdtemp(path), nullptr);
+    root_ = path;
+    src_ = root_ / "src";
+    dest_ = root_ / "dest";
+    // Files directly in the source and in nested directories.
+    for (int i = 0; i < kFiles; i++) {
+      fs::path dir = src_ / std::to_string(i % 3) / std::to_string(i % 7);
+      fs::create_directories(dir);
+      Write(dir / ("file" + std::to_string(i)), Contents(i));
+    }
+    Write(src_ / "top", "top");
+  }
+
+  void TearDown() override {
+    fs::remove_all(root_);
+    EnvironmentTestFixture::TearDown();
+  }
+
+  std::string Copy(node::Environment* env, bool force, bool error_on_exist) {
+    Local<Context> context = env->context();
+    Local<Value> fn;
+    EXPECT_TRUE(
+        Script::Compile(context, node::OneByteString(isolate_, kCopyScript))
+            .ToLocalChecked()
+            ->Run(context)
+            .ToLocal(&fn));
+    Local<Value> argv[] = {
+        env->principal_realm()->internal_binding_loader(),
+        String::NewFromUtf8(isolate_, src_.c_str()).ToLocalChecked(),
+        String::NewFromUtf8(isolate_, dest_.c_str()).ToLocalChecked(),
+        v8::Boolean::New(isolate_, force),
+        v8::Boolean::New(isolate_, error_on_exist),
+    };
+    Local<Value> result;
+    EXPECT_TRUE(
+        fn.As<Function>()
+            ->Call(context, v8::Null(isolate_), node::arraysize(argv), argv)
+            .ToLocal(&result));
+    return *node::Utf8Value(isolate_, result);
+  }
+
+  static std::string Contents(int i) {
+    return std::string(1000 + i * 37, static_cast<char>('a' + i % 26));
+  }
+
+  static void Write(const fs::path& path, const std::string& contents) {
+    std::ofstream(path, std::ios::binary) << contents;
+  }
+
+  static std::string Read(const fs::path& path) {
+    std::ifstream in(path, std::ios::binary);
+    std::stringstream contents;
+    contents << in.rdbuf();
+    return contents.str();
+  }
+
+  // The number of files under |dest_| whose contents match the source.
+  int CountCopies() {
+    int copies = 0;
+    for (const auto& entry : fs::recursive_directory_iterator(src_)) {
+      if (!entry.is_regular_file()) continue;
+      fs::path dest = dest_ / fs::relative(entry.path(), src_);
+      if (fs::exists(dest) && Read(dest) == Read(entry.path())) copies++;
+    }
+    return copies;
+  }
+
+  fs::path root_;
+  fs::path src_;
+  fs::path dest_;
+};
+
+TEST_F(FsCpSyncTest, CopiesEveryFileWithItsTimestamps) {
+  const v8::HandleScope handle_scope(isolate_);
+  Argv argv;
+  Env env{handle_scope, argv};
+
+  // An old mtime, which the copy has to keep.
+  fs::path sample = src_ / "1" / "3" / "file10";
+  struct utimbuf times = {1000000000, 1000000000};
+  ASSERT_EQ(utime(sample.c_str(), &times), 0);
+
+  EXPECT_EQ(Copy(*env, false, false), "ok");
+  EXPECT_EQ(CountCopies(), kFiles + 1);
+  struct stat dest_stat;
+  ASSERT_EQ(stat((dest_ / "1" / "3" / "file10").c_str(), &dest_stat), 0);
+  EXPECT_EQ(dest_stat.st_mtime, 1000000000);
+}
+
+TEST_F(FsCpSyncTest, SkipsOrOverwritesExistingFiles) {
+  const v8::HandleScope handle_scope(isolate_);
+  Argv argv;
+  Env env{handle_scope, argv};
+
+  fs::create_directories(dest_);
+  Write(dest_ / "top", "existing");
+
+  // Without force or errorOnExist, the existing file is left alone.
+  EXPECT_EQ(Copy(*env, false, false), "ok");
+  EXPECT_EQ(Read(dest_ / "top"), "existing");
+  EXPECT_EQ(CountCopies(), kFiles);
+
+  EXPECT_EQ(Copy(*env, true, false), "ok");
+  EXPECT_EQ(Read(dest_ / "top"), "top");
+  EXPECT_EQ(CountCopies(), kFiles + 1);
+}
+
+TEST_F(FsCpSyncTest, ReportsExistingFilesWithErrorOnExist) {
+  const v8::HandleScope handle_scope(isolate_);
+  Argv argv;
+  Env env{handle_scope, argv};
+
+  fs::create_directories(dest_);
+  Write(dest_ / "top", "existing");
+
+  EXPECT_EQ(Copy(*env, false, true), "ERR_FS_CP_EEXIST");
+  EXPECT_EQ(Read(dest_ / "top"), "existing");
+}
+
+TEST_F(FsCpSyncTest, ReportsFailedCopies) {
+  const v8::HandleScope handle_scope(isolate_);
+  Argv argv;
+  Env env{handle_scope, argv};
+
+  // A source file that cannot be read fails its copy. Running as root, the
+  // copy succeeds anyway.
+  fs::path unreadable = src_ / "0" / "0" / "file0";
+  fs::permissions(unreadable, fs::perms::none);
+  const bool readable = std::ifstream(unreadable).good();
+
+  EXPECT_EQ(Copy(*env, false, false), readable ? "ok" : "EACCES");
+  fs::permissions(unreadable, fs::perms::owner_all);
+}
+
+#endif  // _WIN32
@@ -0,0 +1,118 @@
+#include "gtest/gtest.h"
+#include "node_dir.h"
+#include "uv.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+using node::fs_dir::DirEntry;
+using node::fs_dir::kDirEntriesPerRead;
+using node::fs_dir::ReadDirEntries;
+
+namespace {
+
+class FsDirTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    char tmpdir[1024];
+    size_t size = sizeof(tmpdir);
+    ASSERT_EQ(uv_os_tmpdir(tmpdir, &size), 0);
+    std::string tmpl = std::string(tmpdir) + "/node-fs-dir-XXXXXX";
+    uv_fs_t req;
+    ASSERT_EQ(uv_fs_mkdtemp(nullptr, &req, tmpl.c_str(), nullptr), 0);
+    root_ = req.path;
+    uv_fs_req_cleanup(&req);
+  }
+
+  void TearDown() override {
+    uv_fs_t req;
+    for (const std::string& file : files_) {
+      EXPECT_EQ(uv_fs_unlink(nullptr, &req, Path(file).c_str(), nullptr), 0);
+      uv_fs_req_cleanup(&req);
+    }
+    for (const std::string& dir : dirs_) {
+      EXPECT_EQ(uv_fs_rmdir(nullptr, &req, Path(dir).c_str(), nullptr), 0);
+      uv_fs_req_cleanup(&req);
+    }
+    EXPECT_EQ(uv_fs_rmdir(nullptr, &req, root_.c_str(), nullptr), 0);
+    uv_fs_req_cleanup(&req);
+  }
+
+  std::string Path(const std::string& name) const {
+    return root_ + "/" + name;
+  }
+
+  void CreateFile(const std::string& name) {
+    uv_fs_t req;
+    int fd = uv_fs_open(nullptr,
+                        &req,
+                        Path(name).c_str(),
+                        UV_FS_O_CREAT | UV_FS_O_WRONLY,
+                        0644,
+                        nullptr);
+    uv_fs_req_cleanup(&req);
+    ASSERT_GE(fd, 0);
+    EXPECT_EQ(uv_fs_close(nullptr, &req, fd, nullptr), 0);
+    uv_fs_req_cleanup(&req);
+    files_.push_back(name);
+  }
+
+  void CreateDir(const std::string& name) {
+    uv_fs_t req;
+    ASSERT_EQ(uv_fs_mkdir(nullptr, &req, Path(name).c_str(), 0755, nullptr),
+              0);
+    uv_fs_req_cleanup(&req);
+    dirs_.push_back(name);
+  }
+
+  std::string root_;
+  std::vector<std::string> files_;
+  std::vector<std::string> dirs_;
+};
+
+}  // namespace
+
+TEST_F(FsDirTest, ReadsEntriesAcrossSeveralReads) {
+  const size_t count = kDirEntriesPerRead * 2 + 1;
+  for (size_t i = 0; i < count; i++) CreateFile("file" + std::to_string(i));
+  CreateDir("subdir");
+
+  std::vector<DirEntry> entries;
+  const char* syscall = nullptr;
+  ASSERT_EQ(ReadDirEntries(root_.c_str(), &entries, &syscall), 0);
+  EXPECT_EQ(syscall, nullptr);
+  ASSERT_EQ(entries.size(), count + 1);
+
+  std::vector<std::string> names;
+  for (const DirEntry& entry : entries) {
+    names.push_back(entry.name);
+    if (entry.name == "subdir") {
+      EXPECT_TRUE(entry.type == UV_DIRENT_DIR ||
+                  entry.type == UV_DIRENT_UNKNOWN);
+    } else {
+      EXPECT_TRUE(entry.type == UV_DIRENT_FILE ||
+                  entry.type == UV_DIRENT_UNKNOWN);
+    }
+  }
+  std::vector<std::string> expected = files_;
+  expected.push_back("subdir");
+  std::sort(names.begin(), names.end());
+  std::sort(expected.begin(), expected.end());
+  EXPECT_EQ(names, expected);
+}
+
+TEST_F(FsDirTest, ReadsEmptyDirectory) {
+  std::vector<DirEntry> entries;
+  const char* syscall = nullptr;
+  EXPECT_EQ(ReadDirEntries(root_.c_str(), &entries, &syscall), 0);
+  EXPECT_TRUE(entries.empty());
+}
+
+TEST_F(FsDirTest, ReportsTheFailingCall) {
+  std::vector<DirEntry> entries;
+  const char* syscall = nullptr;
+  EXPECT_EQ(ReadDirEntries(Path("missing").c_str(), &entries, &syscall),
+            UV_ENOENT);
+  EXPECT_STREQ(syscall, "opendir");
+}
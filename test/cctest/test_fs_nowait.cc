@@ -0,0 +1,126 @@
+#include "env-inl.h"
+#include "gtest/gtest.h"
+#include "node_file.h"
+#include "node_realm-inl.h"
+#include "node_test_fixture.h"
+#include "util-inl.h"
+#include "uv.h"
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <string>
+#endif
+
+#if defined(__linux__) && defined(RWF_NOWAIT)
+
+using node::fs::BindingData;
+using v8::Context;
+using v8::Function;
+using v8::Integer;
+using v8::Local;
+using v8::Object;
+using v8::Script;
+using v8::Value;
+
+// Reads `fd` from the start with readBuffersWithFlags() and RWF_NOWAIT, and
+// stores what was read, or the error code, in `state.result`.
+static const char kReadScript[] =
+    "(function(internalBinding, fd, state) {"
+    "  const { readBuffersWithFlags, FSReqCallback } = internalBinding('fs');"
+    "  const { RWF_NOWAIT } = internalBinding('constants').fs;"
+    "  const buffer = Buffer.alloc(4096);"
+    "  const req = new FSReqCallback();"
+    "  req.oncomplete = (err, bytes) => {"
+    "    state.result = err ? err.code : buffer.latin1Slice(0, bytes);"
+    "  };"
+    "  readBuffersWithFlags(fd, [buffer], 0, RWF_NOWAIT, req);"
+    "})";
+
+class FsNowaitTest : public EnvironmentTestFixture {
+ protected:
+  // Runs kReadScript and the loop until the read has completed.
+  std::string Read(node::Environment* env, int fd) {
+    Local<Context> context = env->context();
+    Local<Value> fn =
+        Script::Compile(context, node::OneByteString(isolate_, kReadScript))
+            .ToLocalChecked()
+            ->Run(context)
+            .ToLocalChecked();
+    Local<Object> state = Object::New(isolate_);
+    Local<Value> argv[] = {
+        env->principal_realm()->internal_binding_loader(),
+        Integer::New(isolate_, fd),
+        state,
+    };
+    EXPECT_FALSE(
+        fn.As<Function>()
+            ->Call(context, v8::Null(isolate_), node::arraysize(argv), argv)
+            .IsEmpty());
+    Local<Value> result;
+    for (int i = 0; i < 1000; i++) {
+      uv_run(&current_loop, UV_RUN_ONCE);
+      result = state->Get(context, node::OneByteString(isolate_, "result"))
+                   .ToLocalChecked();
+      if (!result->IsUndefined()) break;
+    }
+    return *node::Utf8Value(isolate_, result);
+  }
+
+  static std::string ReadFile(const char* path) {
+    int fd = open(path, O_RDONLY);
+    EXPECT_NE(fd, -1);
+    char buf[4096];
+    ssize_t n = read(fd, buf, sizeof(buf));
+    close(fd);
+    EXPECT_GE(n, 0);
+    return std::string(buf, n);
+  }
+};
+
+// procfs does not support RWF_NOWAIT, so the read goes to the threadpool.
+TEST_F(FsNowaitTest, FallsBackWhenTheFlagIsRejected) {
+  const v8::HandleScope handle_scope(isolate_);
+  const Argv argv;
+  Env env{handle_scope, argv};
+  BindingData* binding_data =
+      node::Realm::GetBindingData<BindingData>(env.context());
+  const std::string expected = ReadFile("/proc/version");
+
+  int fd = open("/proc/version", O_RDONLY);
+  ASSERT_NE(fd, -1);
+  EXPECT_EQ(Read(*env, fd), expected);
+  EXPECT_EQ(binding_data->nowait_unsupported_fds.count(fd), 1u);
+
+  // Later reads of the descriptor skip the attempt.
+  EXPECT_EQ(Read(*env, fd), expected);
+  close(fd);
+}
+
+TEST_F(FsNowaitTest, ReadsWithTheFlagWhereSupported) {
+  const v8::HandleScope handle_scope(isolate_);
+  const Argv argv;
+  Env env{handle_scope, argv};
+  BindingData* binding_data =
+      node::Realm::GetBindingData<BindingData>(env.context());
+
+  char path[] = "/tmp/node-nowait-test-XXXXXX";
+  int fd = mkstemp(path);
+  ASSERT_NE(fd, -1);
+  unlink(path);
+  ASSERT_EQ(write(fd, "cached", 6), 6);
+  char probe[6];
+  iovec iov = {probe, sizeof(probe)};
+  if (preadv2(fd, &iov, 1, 0, RWF_NOWAIT) < 0 && errno == EOPNOTSUPP) {
+    close(fd);
+    GTEST_SKIP() << "the file system of /tmp does not support RWF_NOWAIT";
+  }
+  EXPECT_EQ(Read(*env, fd), "cached");
+  EXPECT_EQ(binding_data->nowait_unsupported_fds.count(fd), 0u);
+  close(fd);
+}
+
+#endif  // defined(__linux__) && defined(RWF_NOWAIT)
@@ -0,0 +1,43 @@
+#include "gtest/gtest.h"
+#include "permission/fs_permission.h"
+
+using node::permission::FSPermission;
+
+#ifndef _WIN32
+TEST(FSPermissionTest, RadixTreeLookup) {
+  FSPermission::RadixTree tree;
+  EXPECT_TRUE(tree.Lookup("/anything", true));
+  EXPECT_FALSE(tree.Lookup("/anything"));
+
+  tree.Insert("/home/user/file.js");
+  tree.Insert("/home/user/project/*");
+  tree.Insert("/home/users.json");
+  tree.Insert("/tmp/*");
+
+  EXPECT_TRUE(tree.Lookup("/home/user/file.js"));
+  EXPECT_TRUE(tree.Lookup("/home/users.json"));
+  EXPECT_TRUE(tree.Lookup("/home/user/project/index.js"));
+  EXPECT_TRUE(tree.Lookup("/home/user/project/src/a/b.js"));
+  EXPECT_TRUE(tree.Lookup("/home/user/project"));
+  EXPECT_TRUE(tree.Lookup("/tmp/a"));
+  EXPECT_FALSE(tree.Lookup("/home/user/file.json"));
+  EXPECT_FALSE(tree.Lookup("/home/user/other.js"));
+  EXPECT_FALSE(tree.Lookup("/home/user"));
+  EXPECT_FALSE(tree.Lookup("/etc/passwd"));
+}
+#endif  // _WIN32
+
+TEST(FSPermissionTest, CheckCache) {
+  FSPermission::CheckCache cache;
+  EXPECT_FALSE(cache.Get("/a").has_value());
+
+  cache.Set("/a", true);
+  cache.Set("/b", false);
+  EXPECT_EQ(cache.Get("/a"), std::optional<bool>(true));
+  EXPECT_EQ(cache.Get("/b"), std::optional<bool>(false));
+  EXPECT_FALSE(cache.Get("/c").has_value());
+
+  cache.Clear();
+  EXPECT_FALSE(cache.Get("/a").has_value());
+  EXPECT_FALSE(cache.Get("/b").has_value());
+}
@@ -0,0 +1,95 @@
+#include "gtest/gtest.h"
+#include "node_fs_watcher.h"
+#include "uv.h"
+
+#include <poll.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using node::fs_watcher::EventBatch;
+using node::fs_watcher::RecursiveWatcher;
+
+TEST(FsWatcherTest, EventBatchCoalesces) {
+  EventBatch batch;
+  EXPECT_TRUE(batch.empty());
+  batch.Add("b", UV_CHANGE);
+  batch.Add("a", UV_RENAME);
+  batch.Add("b", UV_CHANGE);
+  batch.Add("b", UV_RENAME);
+  EXPECT_EQ(batch.size(), 2u);
+
+  std::vector<EventBatch::Event> events = batch.Take();
+  ASSERT_EQ(events.size(), 2u);
+  EXPECT_EQ(events[0], EventBatch::Event("b", UV_CHANGE | UV_RENAME));
+  EXPECT_EQ(events[1], EventBatch::Event("a", UV_RENAME));
+  EXPECT_TRUE(batch.empty());
+
+  batch.Add("b", UV_CHANGE);
+  EXPECT_EQ(batch.Take(), std::vector<EventBatch::Event>({{"b", UV_CHANGE}}));
+}
+
+#if defined(__linux__)
+class RecursiveWatcherTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    char dir[] = "/tmp/node-fs-watcher-XXXXXX";
+    ASSERT_NE(mkdtemp(dir), nullptr);
+    root_ = dir;
+  }
+
+  void TearDown() override {
+    std::string command = "rm -rf " + root_;
+    ASSERT_EQ(system(command.c_str()), 0);
+  }
+
+  // Reads events until one for the given filename shows up.
+  bool WaitFor(RecursiveWatcher* watcher, const std::string& filename) {
+    for (int attempt = 0; attempt < 50; attempt++) {
+      struct pollfd pfd = {watcher->fd(), POLLIN, 0};
+      poll(&pfd, 1, 100);
+      EXPECT_EQ(watcher->ReadEvents([&](std::string_view name, int events) {
+        batch_.Add(name, events);
+      }), 0);
+      for (const EventBatch::Event& event : batch_.Take()) {
+        if (event.first == filename) return true;
+      }
+    }
+    return false;
+  }
+
+  std::string root_;
+  EventBatch batch_;
+};
+
+TEST_F(RecursiveWatcherTest, WatchesNewDirectories) {
+  ASSERT_EQ(mkdir((root_ + "/a").c_str(), 0700), 0);
+  RecursiveWatcher watcher;
+  ASSERT_EQ(watcher.Start(root_.c_str()), 0);
+  if (!watcher.uses_fanotify()) EXPECT_EQ(watcher.watch_count(), 2u);
+
+  std::ofstream(root_ + "/a/file") << "x";
+  EXPECT_TRUE(WaitFor(&watcher, "a/file"));
+
+  ASSERT_EQ(mkdir((root_ + "/a/b").c_str(), 0700), 0);
+  EXPECT_TRUE(WaitFor(&watcher, "a/b"));
+  std::ofstream(root_ + "/a/b/file") << "x";
+  EXPECT_TRUE(WaitFor(&watcher, "a/b/file"));
+
+  ASSERT_EQ(rename((root_ + "/a").c_str(), (root_ + "/c").c_str()), 0);
+  EXPECT_TRUE(WaitFor(&watcher, "c"));
+  std::ofstream(root_ + "/c/b/other") << "x";
+  EXPECT_TRUE(WaitFor(&watcher, "c/b/other"));
+}
+
+TEST_F(RecursiveWatcherTest, RejectsFiles) {
+  std::ofstream(root_ + "/file") << "x";
+  RecursiveWatcher watcher;
+  EXPECT_EQ(watcher.Start((root_ + "/file").c_str()), UV_ENOTDIR);
+  EXPECT_EQ(watcher.Start((root_ + "/missing").c_str()), UV_ENOENT);
+}
+#endif  // defined(__linux__)
@@ -0,0 +1,71 @@
+#include "env-inl.h"
+#include "gtest/gtest.h"
+#include "node_internals.h"
+#include "node_test_fixture.h"
+#include "zstd.h"
+
+#include <fstream>
+#include <iterator>
+#include <string>
+
+using node::Environment;
+using node::heap::SnapshotCompression;
+using v8::HandleScope;
+using v8::HeapProfiler;
+
+class HeapUtilsTest : public EnvironmentTestFixture {};
+
+static std::string ReadFile(const std::string& path) {
+  std::ifstream file(path, std::ios::binary);
+  return std::string(std::istreambuf_iterator<char>(file),
+                     std::istreambuf_iterator<char>());
+}
+
+static std::string TempPath(const char* name) {
+  char dir[1024];
+  size_t size = sizeof(dir);
+  EXPECT_EQ(uv_os_tmpdir(dir, &size), 0);
+  return std::string(dir) + "/" + name + "-" +
+         std::to_string(uv_os_getpid());
+}
+
+TEST_F(HeapUtilsTest, WriteSnapshotWithZstd) {
+  const HandleScope handle_scope(isolate_);
+  const Argv argv;
+  Env env{handle_scope, argv};
+
+  std::string json_path = TempPath("test-heap-utils.heapsnapshot");
+  std::string zstd_path = json_path + ".zst";
+  HeapProfiler::HeapSnapshotOptions options;
+  ASSERT_TRUE(node::heap::WriteSnapshot(*env, json_path.c_str(), options)
+                  .IsJust());
+  ASSERT_TRUE(node::heap::WriteSnapshot(*env,
+                                        zstd_path.c_str(),
+                                        options,
+                                        SnapshotCompression::kZstd)
+                  .IsJust());
+
+  std::string json = ReadFile(json_path);
+  std::string compressed = ReadFile(zstd_path);
+  remove(json_path.c_str());
+  remove(zstd_path.c_str());
+  ASSERT_EQ(json.compare(0, 12, "{\"snapshot\":"), 0);
+  EXPECT_LT(compressed.size(), json.size());
+
+  // The compressed snapshot is a single, complete zstd frame. The two
+  // snapshots differ slightly, so only compare how they start.
+  unsigned long long content_size =  // NOLINT(runtime/int)
+      ZSTD_getFrameContentSize(compressed.data(), compressed.size());
+  EXPECT_EQ(content_size, ZSTD_CONTENTSIZE_UNKNOWN);
+  EXPECT_EQ(ZSTD_findFrameCompressedSize(compressed.data(), compressed.size()),
+            compressed.size());
+  std::string decompressed(json.size() * 2, '\0');
+  size_t size = ZSTD_decompress(decompressed.data(),
+                                decompressed.size(),
+                                compressed.data(),
+                                compressed.size());
+  ASSERT_FALSE(ZSTD_isError(size));
+  decompressed.resize(size);
+  EXPECT_EQ(decompressed.compare(0, 12, "{\"snapshot\":"), 0);
+  EXPECT_EQ(decompressed.back(), json.back());
+}
@@ -0,0 +1,150 @@
+#include "histogram-inl.h"
+
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "uv.h"
+
+using node::Histogram;
+using node::RollingHistogram;
+
+namespace {
+
+constexpr int kThreads = 4;
+constexpr int kValuesPerThread = 10000;
+
+constexpr uint64_t kMillisecond = 1000 * 1000;
+
+// The clock of the RollingHistogram tests, so that windows rotate exactly
+// when a test advances it rather than depending on how long a sleep takes.
+uint64_t fake_now = 0;
+uint64_t FakeClock() {
+  return fake_now;
+}
+
+Histogram::Options WithMode(Histogram::Mode mode) {
+  Histogram::Options options;
+  options.mode = mode;
+  return options;
+}
+
+// Records 1..kValuesPerThread from kThreads threads at once.
+void RecordConcurrently(Histogram* histogram) {
+  std::vector<uv_thread_t> threads(kThreads);
+  for (uv_thread_t& thread : threads) {
+    ASSERT_EQ(0, uv_thread_create(&thread, [](void* data) {
+      Histogram* histogram = static_cast<Histogram*>(data);
+      for (int n = 1; n <= kValuesPerThread; n++) histogram->Record(n);
+    }, histogram));
+  }
+  for (uv_thread_t& thread : threads) ASSERT_EQ(0, uv_thread_join(&thread));
+}
+
+void ExpectAllRecorded(Histogram* histogram) {
+  EXPECT_EQ(histogram->Count(),
+            static_cast<size_t>(kThreads * kValuesPerThread));
+  EXPECT_EQ(histogram->Min(), 1);
+  EXPECT_GE(histogram->Max(), kValuesPerThread);
+  EXPECT_NEAR(histogram->Mean(), kValuesPerThread / 2.0, 50);
+  EXPECT_EQ(histogram->Exceeds(), 0u);
+}
+
+}  // namespace
+
+TEST(HistogramTest, LockedRecordsConcurrently) {
+  Histogram histogram(WithMode(Histogram::Mode::kLocked));
+  RecordConcurrently(&histogram);
+  ExpectAllRecorded(&histogram);
+}
+
+TEST(HistogramTest, ShardedRecordsConcurrently) {
+  Histogram histogram(WithMode(Histogram::Mode::kSharded));
+  RecordConcurrently(&histogram);
+  ExpectAllRecorded(&histogram);
+}
+
+TEST(HistogramTest, AtomicRecordsConcurrently) {
+  Histogram histogram(WithMode(Histogram::Mode::kAtomic));
+  RecordConcurrently(&histogram);
+  ExpectAllRecorded(&histogram);
+}
+
+TEST(HistogramTest, LockFreeModesCountExceeds) {
+  for (Histogram::Mode mode :
+       {Histogram::Mode::kSharded, Histogram::Mode::kAtomic}) {
+    Histogram::Options options = WithMode(mode);
+    options.highest = 1000;
+    Histogram histogram(options);
+    EXPECT_TRUE(histogram.Record(10));
+    EXPECT_FALSE(histogram.Record(1000000));
+    EXPECT_EQ(histogram.Count(), 1u);
+    EXPECT_EQ(histogram.Exceeds(), 1u);
+
+    histogram.Reset();
+    EXPECT_EQ(histogram.Count(), 0u);
+    EXPECT_EQ(histogram.Exceeds(), 0u);
+  }
+}
+
+TEST(HistogramTest, AddsAcrossModes) {
+  Histogram locked(WithMode(Histogram::Mode::kLocked));
+  Histogram sharded(WithMode(Histogram::Mode::kSharded));
+  for (int n = 1; n <= 100; n++) {
+    locked.Record(n);
+    sharded.Record(n + 100);
+  }
+
+  EXPECT_EQ(locked.Add(sharded), 0);
+  EXPECT_EQ(locked.Count(), 200u);
+  EXPECT_EQ(locked.Min(), 1);
+  EXPECT_EQ(locked.Max(), 200);
+
+  EXPECT_EQ(sharded.Add(locked), 0);
+  EXPECT_EQ(sharded.Count(), 300u);
+  EXPECT_EQ(sharded.Percentile(100), 200);
+}
+
+TEST(HistogramTest, RollingMergesRecentWindows) {
+  RollingHistogram::Options options;
+  options.interval = 200 * kMillisecond;
+  options.windows = 3;
+  options.clock = FakeClock;
+  fake_now = 0;
+  RollingHistogram histogram(options);
+
+  histogram.Record(10);
+  fake_now += 199 * kMillisecond;
+  EXPECT_EQ(histogram.Merge(1)->Count(), 1u);
+  fake_now += 51 * kMillisecond;
+  histogram.Record(20);
+  histogram.Record(30);
+
+  std::shared_ptr<Histogram> current = histogram.Merge(1);
+  EXPECT_EQ(current->Count(), 2u);
+  EXPECT_EQ(current->Min(), 20);
+  std::shared_ptr<Histogram> all = histogram.Merge(3);
+  EXPECT_EQ(all->Count(), 3u);
+  EXPECT_EQ(all->Min(), 10);
+  EXPECT_EQ(all->Max(), 30);
+
+  histogram.Reset();
+  EXPECT_EQ(histogram.Merge(3)->Count(), 0u);
+}
+
+TEST(HistogramTest, RollingExpiresOldWindows) {
+  RollingHistogram::Options options;
+  options.interval = 20 * kMillisecond;
+  options.windows = 2;
+  options.clock = FakeClock;
+  fake_now = 0;
+  RollingHistogram histogram(options);
+
+  histogram.Record(10);
+  fake_now += 20 * kMillisecond;
+  EXPECT_EQ(histogram.Merge(2)->Count(), 1u);
+  // Long enough for every window to have been rotated out.
+  fake_now += 40 * kMillisecond;
+  EXPECT_EQ(histogram.Merge(2)->Count(), 0u);
+  histogram.Record(20);
+  EXPECT_EQ(histogram.Merge(2)->Max(), 20);
+}
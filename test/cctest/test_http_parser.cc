@@ -0,0 +1,133 @@
+#include "env-inl.h"
+#include "gtest/gtest.h"
+#include "node_realm-inl.h"
+#include "node_test_fixture.h"
+#include "util-inl.h"
+
+#include <string>
+
+using v8::Context;
+using v8::Function;
+using v8::Local;
+using v8::Script;
+using v8::String;
+using v8::Value;
+
+class HttpParserBatchTest : public EnvironmentTestFixture {
+ protected:
+  // Calls `source`, a function expression, with the http_parser binding
+  // and returns its result as a string.
+  std::string Run(node::Environment* env, const char* source) {
+    Local<Context> context = env->context();
+    Local<Value> binding;
+    Local<Value> name = node::OneByteString(isolate_, "http_parser");
+    EXPECT_TRUE(env->principal_realm()
+                    ->internal_binding_loader()
+                    ->Call(context, v8::Null(isolate_), 1, &name)
+                    .ToLocal(&binding));
+    Local<Value> fn;
+    EXPECT_TRUE(Script::Compile(context, node::OneByteString(isolate_, source))
+                    .ToLocalChecked()
+                    ->Run(context)
+                    .ToLocal(&fn));
+    Local<Value> result;
+    EXPECT_TRUE(fn.As<Function>()
+                    ->Call(context, v8::Null(isolate_), 1, &binding)
+                    .ToLocal(&result));
+    return *node::Utf8Value(isolate_, result);
+  }
+};
+
+// Describes every call that the parser makes into JS while parsing `data`.
+#define BATCH_TEST_SCRIPT(data)                                               \
+  "(function({ HTTPParser }) {"                                               \
+  "  const parser = new HTTPParser();"                                        \
+  "  parser.initialize(HTTPParser.REQUEST, {});"                              \
+  "  parser.setBatchMode(true);"                                              \
+  "  const calls = [];"                                                       \
+  "  const buffers = [];"                                                     \
+  "  parser[HTTPParser.kOnMessages] = (buffer, entries) => {"                 \
+  "    buffers.push(buffer);"                                                 \
+  "    const str = (offset, length) =>"                                       \
+  "      buffer.toString('latin1', offset, offset + length);"                 \
+  "    const messages = [];"                                                  \
+  "    for (let i = 0; i < entries.length;) {"                                \
+  "      const flags = entries[i + HTTPParser.kBatchFlags];"                  \
+  "      let message = str(entries[i + HTTPParser.kBatchUrlOffset],"          \
+  "                        entries[i + HTTPParser.kBatchUrlLength]);"         \
+  "      const count = entries[i + HTTPParser.kBatchHeaderCount];"            \
+  "      for (let h = 0; h < count; h++) {"                                   \
+  "        const header = i + HTTPParser.kBatchHeaders + h * 4;"              \
+  "        message += ' ' + str(entries[header], entries[header + 1]) +"      \
+  "                   '=' + str(entries[header + 2], entries[header + 3]);"   \
+  "      }"                                                                   \
+  "      message += ' [' + str(entries[i + HTTPParser.kBatchBodyOffset],"     \
+  "                            entries[i + HTTPParser.kBatchBodyLength]) +"   \
+  "                 ']';"                                                     \
+  "      if (flags & HTTPParser.kBatchFlagComplete) message += ' complete';"  \
+  "      messages.push(message);"                                             \
+  "      i += HTTPParser.kBatchHeaders + count * 4;"                          \
+  "    }"                                                                     \
+  "    calls.push('batch: ' + messages.join(', '));"                          \
+  "  };"                                                                      \
+  "  parser[HTTPParser.kOnHeadersComplete] = (major, minor, headers,"         \
+  "                                           method, url) => {"              \
+  "    calls.push('headers: ' + url);"                                        \
+  "    return 0;"                                                             \
+  "  };"                                                                      \
+  "  parser[HTTPParser.kOnBody] = (body) => {"                                \
+  "    calls.push('body: ' + body.toString('latin1'));"                       \
+  "  };"                                                                      \
+  "  parser[HTTPParser.kOnMessageComplete] = () => calls.push('complete');"   \
+  "  parser.execute(Buffer.from(" data ", 'latin1'));"                        \
+  "  if (buffers.length > 1 && buffers.some((b) => b !== buffers[0]))"        \
+  "    calls.push('copied again');"                                           \
+  "  return calls.join('\\n');"                                               \
+  "})"
+
+TEST_F(HttpParserBatchTest, DeliversPipelinedRequestsTogether) {
+  const v8::HandleScope handle_scope(isolate_);
+  Argv argv;
+  Env env{handle_scope, argv};
+
+  EXPECT_EQ(Run(*env,
+                BATCH_TEST_SCRIPT(
+                    "'GET /a HTTP/1.1\\r\\nHost: x\\r\\n\\r\\n' +"
+                    "'POST /b HTTP/1.1\\r\\nContent-Length: 2\\r\\n\\r\\nhi'")),
+            "batch: /a Host=x [] complete, /b Content-Length=2 [hi] complete");
+}
+
+TEST_F(HttpParserBatchTest, KeepsOrderWithRegularCallbacks) {
+  const v8::HandleScope handle_scope(isolate_);
+  Argv argv;
+  Env env{handle_scope, argv};
+
+  // The second chunk of /b is passed to kOnBody after the batch that holds
+  // the head and first chunk of /b, and the batch of /c is delivered with
+  // the same copy of the buffer.
+  EXPECT_EQ(Run(*env,
+                BATCH_TEST_SCRIPT(
+                    "'GET /a HTTP/1.1\\r\\n\\r\\n' +"
+                    "'POST /b HTTP/1.1\\r\\nTransfer-Encoding: chunked\\r\\n' +"
+                    "'\\r\\n2\\r\\nhi\\r\\n2\\r\\nyo\\r\\n0\\r\\n\\r\\n' +"
+                    "'GET /c HTTP/1.1\\r\\n\\r\\n'")),
+            "batch: /a [] complete, /b Transfer-Encoding=chunked [hi]\n"
+            "body: yo\n"
+            "complete\n"
+            "batch: /c [] complete");
+}
+
+TEST_F(HttpParserBatchTest, UpgradesUseRegularCallbacks) {
+  const v8::HandleScope handle_scope(isolate_);
+  Argv argv;
+  Env env{handle_scope, argv};
+
+  EXPECT_EQ(Run(*env,
+                BATCH_TEST_SCRIPT(
+                    "'GET /a HTTP/1.1\\r\\n\\r\\n' +"
+                    "'GET /ws HTTP/1.1\\r\\nConnection: Upgrade\\r\\n' +"
+                    "'Upgrade: websocket\\r\\n\\r\\n'")),
+            "batch: /a [] complete\n"
+            "headers: /ws\n"
+            "complete");
+}
@@ -1,6 +1,7 @@
 #include "inspector_socket.h"
 #include "util-inl.h"
 #include "gtest/gtest.h"
+#include "zlib.h"
 
 #include <queue>
 
@@ -790,6 +791,114 @@ TEST_F(InspectorSocketTest, Send1Mb) {
                          reinterpret_cast<uv_handle_t*>(&client_socket)));
 }
 
+static void read_frame_cb(uv_stream_t* stream, ssize_t nread,
+                          const uv_buf_t* buf) {
+  std::string* frame = static_cast<std::string*>(stream->data);
+  EXPECT_GT(nread, 0);
+  if (nread > 0) frame->append(buf->base, nread);
+  delete[] buf->base;
+  // Only frames with a single byte length are expected.
+  if (frame->size() >= 2 &&
+      frame->size() >= 2u + (static_cast<uint8_t>((*frame)[1]) & 0x7F)) {
+    stream->data = nullptr;
+    uv_read_stop(stream);
+  }
+}
+
+static void read_frame_on_client(std::string* frame) {
+  client_socket.data = frame;
+  uv_read_start(reinterpret_cast<uv_stream_t*>(&client_socket),
+                buffer_alloc_cb, read_frame_cb);
+  SPIN_WHILE(client_socket.data != nullptr);
+}
+
+static const char DEFLATE_TRAILER[] = {'\x00', '\x00', '\xFF', '\xFF'};
+
+static std::string deflate_message(const std::string& message) {
+  z_stream strm = z_stream();
+  EXPECT_EQ(Z_OK, deflateInit2(&strm, Z_DEFAULT_COMPRESSION, Z_DEFLATED,
+                               -MAX_WBITS, 8, Z_DEFAULT_STRATEGY));
+  std::string output(deflateBound(&strm, message.size()) + 16, '\0');
+  strm.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(message.data()));
+  strm.avail_in = message.size();
+  strm.next_out = reinterpret_cast<Bytef*>(&output[0]);
+  strm.avail_out = output.size();
+  EXPECT_EQ(Z_OK, deflate(&strm, Z_SYNC_FLUSH));
+  output.resize(output.size() - strm.avail_out - sizeof(DEFLATE_TRAILER));
+  deflateEnd(&strm);
+  return output;
+}
+
+static std::string inflate_message(const std::string& payload) {
+  z_stream strm = z_stream();
+  EXPECT_EQ(Z_OK, inflateInit2(&strm, -MAX_WBITS));
+  std::string input = payload;
+  input.append(DEFLATE_TRAILER, sizeof(DEFLATE_TRAILER));
+  std::string output(64 * 1024, '\0');
+  strm.next_in = reinterpret_cast<Bytef*>(&input[0]);
+  strm.avail_in = input.size();
+  strm.next_out = reinterpret_cast<Bytef*>(&output[0]);
+  strm.avail_out = output.size();
+  EXPECT_EQ(Z_OK, inflate(&strm, Z_SYNC_FLUSH));
+  output.resize(output.size() - strm.avail_out);
+  inflateEnd(&strm);
+  return output;
+}
+
+TEST_F(InspectorSocketTest, PermessageDeflate) {
+  const char DEFLATE_HANDSHAKE_REQ[] =
+      "GET /ws/path HTTP/1.1\r\n"
+      "Host: localhost:9229\r\n"
+      "Upgrade: websocket\r\n"
+      "Connection: Upgrade\r\n"
+      "Sec-WebSocket-Key: aaa==\r\n"
+      "Sec-WebSocket-Extensions: permessage-deflate; client_max_window_bits\r\n"
+      "Sec-WebSocket-Version: 13\r\n\r\n";
+  do_write(DEFLATE_HANDSHAKE_REQ, sizeof(DEFLATE_HANDSHAKE_REQ) - 1);
+  SPIN_WHILE(!delegate->inspector_ready);
+  const char UPGRADE_RESPONSE[] =
+      "HTTP/1.1 101 Switching Protocols\r\n"
+      "Upgrade: websocket\r\n"
+      "Connection: Upgrade\r\n"
+      "Sec-WebSocket-Accept: Dt87H1OULVZnSJo/KgMUYI7xPCg=\r\n"
+      "Sec-WebSocket-Extensions: permessage-deflate; "
+      "server_no_context_takeover; client_no_context_takeover\r\n\r\n";
+  expect_on_client(UPGRADE_RESPONSE, sizeof(UPGRADE_RESPONSE) - 1);
+
+  // Short messages are not compressed.
+  const char SERVER_MESSAGE[] = "abcd";
+  const char CLIENT_FRAME[] = {'\x81', '\x04', 'a', 'b', 'c', 'd'};
+  delegate->Write(SERVER_MESSAGE, sizeof(SERVER_MESSAGE) - 1);
+  expect_on_client(CLIENT_FRAME, sizeof(CLIENT_FRAME));
+
+  std::string message(4000, '\0');
+  fill_message(&message);
+  for (int i = 0; i < 2; i++) {
+    delegate->Write(message.data(), message.size());
+    std::string frame;
+    read_frame_on_client(&frame);
+    ASSERT_GE(frame.size(), 2u);
+    // FIN, RSV1 for a compressed message, and the text opcode.
+    EXPECT_EQ('\xC1', frame[0]);
+    EXPECT_EQ(message, inflate_message(frame.substr(2)));
+  }
+
+  std::string deflated = deflate_message(message);
+  ASSERT_LE(deflated.size(), 125u);
+  char MASK[4] = {'W', 'h', 'O', 'a'};
+  std::string outgoing = {'\xC1', static_cast<char>(0x80 | deflated.size()),
+                          MASK[0], MASK[1], MASK[2], MASK[3]};
+  outgoing.resize(outgoing.size() + deflated.size());
+  mask_message(deflated, &outgoing[6], MASK);
+  do_write(outgoing.data(), outgoing.size());
+  delegate->ExpectData(message.data(), message.size());
+
+  const char CLIENT_CLOSE_FRAME[] = {'\x88', '\x80', '\x2D',
+                                     '\x0E', '\x1E', '\xFA'};
+  do_write(CLIENT_CLOSE_FRAME, sizeof(CLIENT_CLOSE_FRAME));
+  expect_on_client(SERVER_CLOSE_FRAME, sizeof(SERVER_CLOSE_FRAME));
+}
+
 TEST_F(InspectorSocketTest, ErrorCleansUpTheSocket) {
   do_write(const_cast<char*>(HANDSHAKE_REQ), sizeof(HANDSHAKE_REQ) - 1);
   expect_handshake();
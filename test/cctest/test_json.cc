@@ -0,0 +1,140 @@
+#include "env-inl.h"
+#include "gtest/gtest.h"
+#include "node_json.h"
+#include "node_test_fixture.h"
+
+#include <string>
+
+using v8::Context;
+using v8::HandleScope;
+using v8::JSON;
+using v8::Local;
+using v8::String;
+using v8::TryCatch;
+using v8::Value;
+
+class JSONTest : public EnvironmentTestFixture {
+ protected:
+  // Returns JSON.stringify() of the parsed value.
+  std::string Roundtrip(Local<Context> context, const std::string& json) {
+    Local<Value> value;
+    Local<String> string;
+    if (!node::json::Parse(context, json).ToLocal(&value) ||
+        !JSON::Stringify(context, value).ToLocal(&string)) {
+      return "<failed>";
+    }
+    return *String::Utf8Value(isolate_, string);
+  }
+
+  std::string V8Roundtrip(Local<Context> context, const std::string& json) {
+    Local<Value> value;
+    Local<String> string;
+    if (!JSON::Parse(context, node::OneByteString(isolate_, json))
+             .ToLocal(&value) ||
+        !JSON::Stringify(context, value).ToLocal(&string)) {
+      return "<failed>";
+    }
+    return *String::Utf8Value(isolate_, string);
+  }
+};
+
+TEST_F(JSONTest, ParseLikeJSONParse) {
+  const HandleScope handle_scope(isolate_);
+  const Argv argv;
+  Env env{handle_scope, argv};
+  Local<Context> context = (*env)->context();
+
+  const char* inputs[] = {
+      "null",
+      "true",
+      " 42 ",
+      "-1.5e3",
+      "123456789012345678901234567890",
+      "\"a\\\"b\\u00e9\\n\"",
+      "[]",
+      "{}",
+      "[1, \"two\", [3], {\"four\": 4}, null, false]",
+      "{\"a\": 1, \"b\": {\"c\": [true, {\"d\": \"e\"}]}, \"a\": 2}",
+      "{\"__proto__\": {\"x\": 1}}",
+      "{\"\\u00fcml\\u00e4ut\": \"\\u20ac\"}",
+  };
+  for (const char* input : inputs) {
+    EXPECT_EQ(Roundtrip(context, input), V8Roundtrip(context, input))
+        << input;
+  }
+
+  // __proto__ is an own property, not the prototype.
+  Local<Value> value;
+  ASSERT_TRUE(
+      node::json::Parse(context, "{\"__proto__\": 1}").ToLocal(&value));
+  EXPECT_TRUE(value.As<v8::Object>()
+                  ->HasOwnProperty(context,
+                                   node::OneByteString(isolate_, "__proto__"))
+                  .FromJust());
+}
+
+TEST_F(JSONTest, InvalidJSONThrowsSyntaxError) {
+  const HandleScope handle_scope(isolate_);
+  const Argv argv;
+  Env env{handle_scope, argv};
+  Local<Context> context = (*env)->context();
+
+  for (const char* input : {"", "{", "[1,]", "{\"a\" 1}", "1 2", "nul"}) {
+    TryCatch try_catch(isolate_);
+    EXPECT_TRUE(node::json::Parse(context, input).IsEmpty()) << input;
+    ASSERT_TRUE(try_catch.HasCaught()) << input;
+    Local<String> name;
+    ASSERT_TRUE(try_catch.Exception()
+                    .As<v8::Object>()
+                    ->Get(context, node::OneByteString(isolate_, "name"))
+                    .ToLocalChecked()
+                    ->ToString(context)
+                    .ToLocal(&name));
+    EXPECT_EQ(std::string(*String::Utf8Value(isolate_, name)), "SyntaxError");
+  }
+}
+
+TEST_F(JSONTest, Query) {
+  const HandleScope handle_scope(isolate_);
+  const Argv argv;
+  Env env{handle_scope, argv};
+  Local<Context> context = (*env)->context();
+
+  const char* json =
+      "{\"event\": {\"type\": \"push\", \"ids\": [7, 8, {\"x\": null}]},"
+      " \"a/b\": 1, \"m~n\": 2, \"payload\": {\"big\": [1, 2, 3]}}";
+  Local<v8::Array> results;
+  ASSERT_TRUE(node::json::Query(context,
+                                json,
+                                {"/event/type",
+                                 "/event/ids/1",
+                                 "/event/ids/2",
+                                 "/a~1b",
+                                 "/m~0n",
+                                 "/missing",
+                                 "/event/ids/9",
+                                 "/event/type/0",
+                                 "/event/type"})
+                  .ToLocal(&results));
+  Local<String> string;
+  ASSERT_TRUE(JSON::Stringify(context, results).ToLocal(&string));
+  EXPECT_EQ(std::string(*String::Utf8Value(isolate_, string)),
+            "[\"push\",8,{\"x\":null},1,2,null,null,null,\"push\"]");
+  EXPECT_TRUE(results->Get(context, 5).ToLocalChecked()->IsUndefined());
+
+  ASSERT_TRUE(node::json::Query(context, "[1, 2]", {""}).ToLocal(&results));
+  ASSERT_TRUE(JSON::Stringify(context, results).ToLocal(&string));
+  EXPECT_EQ(std::string(*String::Utf8Value(isolate_, string)), "[[1,2]]");
+
+  {
+    TryCatch try_catch(isolate_);
+    EXPECT_TRUE(node::json::Query(context, json, {"bad"}).IsEmpty());
+    EXPECT_TRUE(try_catch.HasCaught());
+  }
+  {
+    TryCatch try_catch(isolate_);
+    EXPECT_TRUE(
+        node::json::Query(context, "{\"a\": [1,", {"/a/0", "/b"}).IsEmpty());
+    EXPECT_TRUE(try_catch.HasCaught());
+  }
+}
@@ -0,0 +1,30 @@
+#include "gtest/gtest.h"
+#include "large_pages/node_large_page.h"
+
+#include <cstdlib>
+#include <cstring>
+
+static constexpr size_t kHugePageSize = 2 * 1024 * 1024;
+
+TEST(LargePagesTest, AdvisesAlignedPartOnly) {
+  char* data = static_cast<char*>(malloc(8 * kHugePageSize));
+  ASSERT_NE(data, nullptr);
+  // Too small to contain a whole aligned huge page.
+  EXPECT_EQ(node::AdviseTransparentHugePages(data, kHugePageSize / 2), 0u);
+
+  size_t advised = node::AdviseTransparentHugePages(data, 8 * kHugePageSize);
+  EXPECT_EQ(advised % kHugePageSize, 0u);
+  EXPECT_LE(advised, 8 * kHugePageSize);
+#ifdef __linux__
+  // Unless THP is disabled entirely, at least 7 of the pages are aligned.
+  if (advised != 0) EXPECT_GE(advised, 7 * kHugePageSize);
+#endif
+  free(data);
+}
+
+TEST(LargePagesTest, HugePageCoverage) {
+  node::HugePageCoverage coverage;
+  if (!node::GetHugePageCoverage(&coverage)) return;
+  EXPECT_GT(coverage.anonymous, 0u);
+  EXPECT_LE(coverage.anon_huge_pages, coverage.anonymous);
+}
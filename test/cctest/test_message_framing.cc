@@ -0,0 +1,206 @@
+#include "env-inl.h"
+#include "gtest/gtest.h"
+#include "node_internals.h"
+#include "node_realm-inl.h"
+#include "node_test_fixture.h"
+#include "util-inl.h"
+#include "uv.h"
+
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <string>
+
+using v8::Context;
+using v8::Function;
+using v8::Integer;
+using v8::Local;
+using v8::Script;
+using v8::Value;
+
+// Reads framed messages from `fd` and returns a function that describes what
+// has been received so far: the number of bytes read, then `length:checksum`
+// for every message and `error <nread>` for a read error.
+static const char kFramingScript[] =
+    "(function(internalBinding, fd, maxMessageSize) {"
+    "  const { Pipe, constants } = internalBinding('pipe_wrap');"
+    "  const { streamBaseState, kReadBytesOrError } ="
+    "    internalBinding('stream_wrap');"
+    "  const pipe = new Pipe(constants.SOCKET);"
+    "  const events = [];"
+    "  pipe.onread = () => {"
+    "    events.push('error ' + streamBaseState[kReadBytesOrError]);"
+    "    pipe.readStop();"
+    "  };"
+    "  const err = pipe.open(fd);"
+    "  if (err !== 0) throw new Error('open failed: ' + err);"
+    "  pipe.useMessageFraming((messages) => {"
+    "    for (const message of messages) {"
+    "      let sum = 0;"
+    "      for (const byte of message) sum = (sum * 31 + byte) % 65521;"
+    "      events.push(message.length + ':' + sum);"
+    "    }"
+    "  }, maxMessageSize);"
+    "  pipe.readStart();"
+    "  return () => [pipe.bytesRead, ...events].join(',');"
+    "})";
+
+class MessageFramingTest : public EnvironmentTestFixture {
+ protected:
+  void SetUp() override {
+    EnvironmentTestFixture::SetUp();
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds_), 0);
+  }
+
+  void TearDown() override {
+    close(fds_[0]);
+    EnvironmentTestFixture::TearDown();
+  }
+
+  // Starts reading from the second socket; `max_message_size` is left out of
+  // the call when it is 0.
+  Local<Function> Start(node::Environment* env, uint32_t max_message_size) {
+    Local<Context> context = env->context();
+    Local<Value> fn;
+    EXPECT_TRUE(
+        Script::Compile(context, node::OneByteString(isolate_, kFramingScript))
+            .ToLocalChecked()
+            ->Run(context)
+            .ToLocal(&fn));
+    Local<Value> argv[] = {
+        env->principal_realm()->internal_binding_loader(),
+        Integer::New(isolate_, fds_[1]),
+        max_message_size == 0
+            ? v8::Undefined(isolate_).As<Value>()
+            : Integer::NewFromUnsigned(isolate_, max_message_size),
+    };
+    Local<Value> poll;
+    EXPECT_TRUE(
+        fn.As<Function>()
+            ->Call(context, v8::Null(isolate_), node::arraysize(argv), argv)
+            .ToLocal(&poll));
+    return poll.As<Function>();
+  }
+
+  std::string Poll(node::Environment* env, Local<Function> poll) {
+    Local<Value> result =
+        poll->Call(env->context(), v8::Null(isolate_), 0, nullptr)
+            .ToLocalChecked();
+    return *node::Utf8Value(isolate_, result);
+  }
+
+  // Writes `data` to the first socket while running the loop, then runs the
+  // loop until `poll` returns `expected`, and returns what it last returned.
+  std::string Exchange(node::Environment* env,
+                       Local<Function> poll,
+                       const std::string& data,
+                       const std::string& expected) {
+    size_t written = 0;
+    std::string result;
+    for (int i = 0; i < 1000000; i++) {
+      if (written < data.size()) {
+        ssize_t n = send(fds_[0],
+                         data.data() + written,
+                         data.size() - written,
+                         MSG_DONTWAIT);
+        if (n > 0) written += n;
+        EXPECT_TRUE(n > 0 || errno == EAGAIN || errno == EWOULDBLOCK);
+      }
+      uv_run(&current_loop, UV_RUN_NOWAIT);
+      result = Poll(env, poll);
+      if (written == data.size() && result == expected) break;
+    }
+    return result;
+  }
+
+  // Bytes held by the backing stores of the Environment.
+  static uint64_t MemoryUsage() {
+    return static_cast<node::NodeArrayBufferAllocator*>(allocator.get())
+        ->total_mem_usage();
+  }
+
+  static std::string Frame(const std::string& message, uint32_t length) {
+    std::string frame(4, '\0');
+    for (int i = 0; i < 4; i++) frame[i] = static_cast<char>(length >> (8 * i));
+    return frame + message;
+  }
+
+  static std::string Frame(const std::string& message) {
+    return Frame(message, static_cast<uint32_t>(message.size()));
+  }
+
+  static std::string Bytes(size_t size) {
+    std::string bytes(size, '\0');
+    for (size_t i = 0; i < size; i++) bytes[i] = static_cast<char>(i % 251);
+    return bytes;
+  }
+
+  static std::string Describe(const std::string& message) {
+    uint32_t sum = 0;
+    for (unsigned char byte : message) sum = (sum * 31 + byte) % 65521;
+    return std::to_string(message.size()) + ":" + std::to_string(sum);
+  }
+
+  int fds_[2];
+};
+
+TEST_F(MessageFramingTest, DeliversSmallAndLargeMessages) {
+  const v8::HandleScope handle_scope(isolate_);
+  Argv argv;
+  Env env{handle_scope, argv};
+
+  Local<Function> poll = Start(*env, 0);
+  // The large message spans many reads, and is followed in the same write
+  // by a small one and an empty one.
+  const std::string small = Bytes(10);
+  const std::string large = Bytes(3 * 1024 * 1024 + 7);
+  const std::string data = Frame(small) + Frame(large) + Frame(small) +
+                           Frame(std::string());
+  const std::string expected = std::to_string(data.size()) + "," +
+                               Describe(small) + "," + Describe(large) + "," +
+                               Describe(small) + ",0:0";
+  EXPECT_EQ(Exchange(*env, poll, data, expected), expected);
+}
+
+TEST_F(MessageFramingTest, RejectsMessagesAboveTheLimit) {
+  const v8::HandleScope handle_scope(isolate_);
+  Argv argv;
+  Env env{handle_scope, argv};
+
+  Local<Function> poll = Start(*env, 100);
+  const std::string data = Frame(Bytes(100)) + Frame(Bytes(101));
+  const std::string expected = std::to_string(data.size()) + "," +
+                               Describe(Bytes(100)) + ",error " +
+                               std::to_string(UV_EMSGSIZE);
+  EXPECT_EQ(Exchange(*env, poll, data, expected), expected);
+}
+
+TEST_F(MessageFramingTest, DefaultLimitRejectsLargeHeaders) {
+  const v8::HandleScope handle_scope(isolate_);
+  Argv argv;
+  Env env{handle_scope, argv};
+
+  Local<Function> poll = Start(*env, 0);
+  const std::string data = Frame("", 64 * 1024 * 1024);
+  const std::string expected =
+      std::to_string(data.size()) + ",error " + std::to_string(UV_EMSGSIZE);
+  EXPECT_EQ(Exchange(*env, poll, data, expected), expected);
+}
+
+TEST_F(MessageFramingTest, AllocatesAsTheMessageArrives) {
+  const v8::HandleScope handle_scope(isolate_);
+  Argv argv;
+  Env env{handle_scope, argv};
+
+  Local<Function> poll = Start(*env, UINT32_MAX);
+  const uint64_t before = MemoryUsage();
+  // A header that announces almost 4 GiB, followed by a few bytes only.
+  const std::string data = Frame(Bytes(1000), UINT32_MAX);
+  const std::string expected = std::to_string(data.size());
+  EXPECT_EQ(Exchange(*env, poll, data, expected), expected);
+  EXPECT_LT(MemoryUsage(), before + 1024 * 1024);
+}
+
+#endif  // _WIN32
@@ -3,10 +3,15 @@
 #define NODE_OPENSSL_SYSTEM_CERT_PATH "/missing/ca.pem"
 
 #include "crypto/crypto_context.h"
+#include "crypto/crypto_scrypt.h"
+#include "crypto/crypto_x509.h"
 #include "node_options.h"
 #include "openssl/err.h"
 #include "gtest/gtest.h"
 
+#include <memory>
+#include <vector>
+
 /*
  * This test verifies that a call to NewRootCertDir with the build time
  * configuration option --openssl-system-ca-path set to an missing file, will
@@ -21,3 +26,124 @@ TEST(NodeCrypto, NewRootCertStore) {
                                       "any errors on the OpenSSL error stack\n";
   X509_STORE_free(store);
 }
+
+TEST(NodeCrypto, X509FieldsAreSharedByDer) {
+  ncrypto::EVPKeyPointer key(EVP_EC_gen("P-256"));
+  ASSERT_TRUE(key);
+  ncrypto::X509Pointer cert(X509_new());
+  ASSERT_TRUE(cert);
+  X509_NAME* name = X509_get_subject_name(cert.get());
+  ASSERT_TRUE(X509_NAME_add_entry_by_txt(
+      name,
+      "CN",
+      MBSTRING_ASC,
+      reinterpret_cast<const unsigned char*>("x509-fields.test"),
+      -1,
+      -1,
+      0));
+  ASSERT_TRUE(X509_set_issuer_name(cert.get(), name));
+  ASSERT_TRUE(ASN1_INTEGER_set(X509_get_serialNumber(cert.get()), 0x1234));
+  X509_gmtime_adj(X509_getm_notBefore(cert.get()), 0);
+  X509_gmtime_adj(X509_getm_notAfter(cert.get()), 60);
+  ASSERT_TRUE(X509_set_pubkey(cert.get(), key.get()));
+  ASSERT_GT(X509_sign(cert.get(), key.get(), EVP_sha256()), 0);
+
+  using node::crypto::X509Fields;
+  std::shared_ptr<X509Fields> fields = X509Fields::For(cert.view());
+  ASSERT_TRUE(fields);
+  const std::string* subject = fields->Get(X509Fields::kSubject, cert.view());
+  ASSERT_NE(subject, nullptr);
+  EXPECT_EQ(*subject, "CN=x509-fields.test");
+  EXPECT_EQ(fields->Get(X509Fields::kSubject, cert.view()), subject);
+  const std::string* serial =
+      fields->Get(X509Fields::kSerialNumber, cert.view());
+  ASSERT_NE(serial, nullptr);
+  EXPECT_EQ(*serial, "1234");
+  EXPECT_EQ(fields->Get(X509Fields::kInfoAccess, cert.view()), nullptr);
+  const std::string* fingerprint =
+      fields->Get(X509Fields::kFingerprint256, cert.view());
+  ASSERT_NE(fingerprint, nullptr);
+  EXPECT_EQ(*fingerprint,
+            cert.view().getFingerprint(ncrypto::Digest::SHA256).value());
+
+  // Another copy of the same certificate gets the same fields.
+  ncrypto::X509Pointer copy = cert.view().clone();
+  ASSERT_TRUE(copy);
+  EXPECT_EQ(X509Fields::For(copy.view()), fields);
+}
+
+#ifndef OPENSSL_NO_SCRYPT
+namespace {
+using node::crypto::ScryptMemoryBudget;
+
+std::shared_ptr<ScryptMemoryBudget::Waiter> NewWaiter(uint64_t memory,
+                                                      std::vector<int>* log,
+                                                      int id) {
+  auto waiter = std::make_shared<ScryptMemoryBudget::Waiter>();
+  waiter->memory = memory;
+  waiter->admit = [log, id]() { log->push_back(id); };
+  return waiter;
+}
+}  // namespace
+
+TEST(NodeCrypto, ScryptMemoryFor) {
+  node::crypto::ScryptConfig params;
+  params.N = 1024;
+  params.r = 8;
+  params.p = 16;
+  // B holds every lane, and V is shared by all of them.
+  EXPECT_EQ(ScryptMemoryBudget::MemoryFor(params),
+            128u * 8 * 16 + 128u * 8 * (1024 + 2));
+}
+
+TEST(NodeCrypto, ScryptMemoryBudgetQueuesInOrder) {
+  ScryptMemoryBudget budget(100);
+  std::vector<int> admitted;
+  EXPECT_TRUE(budget.Reserve(NewWaiter(60, &admitted, 1)));
+  // Neither the one that does not fit, nor the small one behind it, is
+  // admitted before the memory is released.
+  auto second = NewWaiter(60, &admitted, 2);
+  auto third = NewWaiter(10, &admitted, 3);
+  EXPECT_FALSE(budget.Reserve(second));
+  EXPECT_FALSE(budget.Reserve(third));
+  EXPECT_EQ(budget.queued(), 2u);
+  EXPECT_EQ(budget.reserved(), 60u);
+
+  budget.Release(60);
+  EXPECT_EQ(admitted, std::vector<int>({2, 3}));
+  EXPECT_EQ(budget.queued(), 0u);
+  EXPECT_EQ(budget.reserved(), 70u);
+  EXPECT_FALSE(budget.Unqueue(second));
+  budget.Release(60);
+  budget.Release(10);
+  EXPECT_EQ(budget.reserved(), 0u);
+}
+
+TEST(NodeCrypto, ScryptMemoryBudgetOversizedAndForced) {
+  ScryptMemoryBudget budget(100);
+  std::vector<int> admitted;
+  // A derivation that exceeds the limit on its own runs alone.
+  EXPECT_TRUE(budget.Reserve(NewWaiter(500, &admitted, 1)));
+  auto second = NewWaiter(500, &admitted, 2);
+  EXPECT_FALSE(budget.Reserve(second));
+  // Synchronous derivations take their memory anyway.
+  budget.ForceReserve(50);
+  budget.Release(500);
+  EXPECT_TRUE(admitted.empty());
+  budget.Release(50);
+  EXPECT_EQ(admitted, std::vector<int>({2}));
+  budget.Release(500);
+
+  // Unqueued waiters are never admitted, and raising the limit admits the
+  // others.
+  EXPECT_TRUE(budget.Reserve(NewWaiter(80, &admitted, 3)));
+  auto fourth = NewWaiter(80, &admitted, 4);
+  auto fifth = NewWaiter(80, &admitted, 5);
+  EXPECT_FALSE(budget.Reserve(fourth));
+  EXPECT_FALSE(budget.Reserve(fifth));
+  EXPECT_TRUE(budget.Unqueue(fourth));
+  budget.SetLimit(0);
+  EXPECT_EQ(admitted, std::vector<int>({2, 3, 5}));
+  EXPECT_EQ(budget.reserved(), 160u);
+}
+#endif  // OPENSSL_NO_SCRYPT
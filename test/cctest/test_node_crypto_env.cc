@@ -1,9 +1,15 @@
 #include <ncrypto.h>
 #include "crypto/crypto_bio.h"
+#include "crypto/crypto_scrypt.h"
+#include "env-inl.h"
 #include "gtest/gtest.h"
 #include "node_options.h"
+#include "node_realm-inl.h"
 #include "node_test_fixture.h"
 #include "openssl/err.h"
+#include "util-inl.h"
+
+#include <string>
 
 using v8::Local;
 using v8::String;
@@ -31,3 +37,78 @@ TEST_F(NodeCryptoEnv, LoadBIO) {
   ASSERT_EQ(ERR_peek_error(), 0UL) << "There should not have left "
                                       "any errors on the OpenSSL error stack\n";
 }
+
+#ifndef OPENSSL_NO_SCRYPT
+// Derives a key with a sync scrypt job, and then starts three async jobs
+// with the same params. The keys are collected as hex strings.
+static const char kScryptScript[] =
+    "(function(internalBinding, state) {"
+    "  const { ScryptJob, kCryptoJobAsync, kCryptoJobSync } ="
+    "    internalBinding('crypto');"
+    "  const pass = new Uint8Array([112, 97, 115, 115]);"
+    "  const salt = new Uint8Array([78, 97, 67, 108]);"
+    "  const args = [pass, salt, 16384, 8, 1, 32 * 1024 * 1024, 32];"
+    "  const hex = (key) => Array.from(new Uint8Array(key),"
+    "    (byte) => byte.toString(16).padStart(2, '0')).join('');"
+    "  const [err, key] = new ScryptJob(kCryptoJobSync, ...args).run();"
+    "  state.expected = hex(key);"
+    "  state.keys = [];"
+    "  for (let i = 0; i < 3; i++) {"
+    "    const job = new ScryptJob(kCryptoJobAsync, ...args);"
+    "    job.ondone = (err, key) => state.keys.push(err ? err.code : hex(key));"
+    "    job.run();"
+    "  }"
+    "})";
+
+TEST_F(NodeCryptoEnv, ScryptJobsWaitForTheMemoryBudget) {
+  using node::crypto::ScryptMemoryBudget;
+  const v8::HandleScope handle_scope(isolate_);
+  Argv argv;
+  Env env{handle_scope, argv};
+  Local<v8::Context> context = (*env)->context();
+
+  node::crypto::ScryptConfig params;
+  params.N = 16384;
+  params.r = 8;
+  params.p = 1;
+  // Room for a single derivation at a time.
+  ScryptMemoryBudget* budget = ScryptMemoryBudget::Get();
+  budget->SetLimit(ScryptMemoryBudget::MemoryFor(params));
+
+  Local<v8::Object> state = v8::Object::New(isolate_);
+  Local<v8::Value> fn;
+  ASSERT_TRUE(
+      v8::Script::Compile(context,
+                          node::OneByteString(isolate_, kScryptScript))
+          .ToLocalChecked()
+          ->Run(context)
+          .ToLocal(&fn));
+  Local<v8::Value> args[] = {
+      (*env)->principal_realm()->internal_binding_loader(), state};
+  ASSERT_FALSE(fn.As<v8::Function>()
+                   ->Call(context, v8::Null(isolate_), 2, args)
+                   .IsEmpty());
+  // The first job is running, and the others are queued rather than
+  // waiting on threadpool threads.
+  EXPECT_EQ(budget->queued(), 2u);
+
+  uv_run(&current_loop, UV_RUN_DEFAULT);
+  EXPECT_EQ(budget->queued(), 0u);
+  EXPECT_EQ(budget->reserved(), 0u);
+  budget->SetLimit(0);
+
+  auto get = [&](const char* key) {
+    return state->Get(context, node::OneByteString(isolate_, key))
+        .ToLocalChecked();
+  };
+  const std::string expected = *node::Utf8Value(isolate_, get("expected"));
+  EXPECT_EQ(expected.size(), 64u);
+  Local<v8::Array> keys = get("keys").As<v8::Array>();
+  ASSERT_EQ(keys->Length(), 3u);
+  for (uint32_t i = 0; i < keys->Length(); i++) {
+    EXPECT_EQ(*node::Utf8Value(isolate_,
+                               keys->Get(context, i).ToLocalChecked()),
+              expected);
+  }
+}
+#endif  // OPENSSL_NO_SCRYPT
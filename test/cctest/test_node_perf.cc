@@ -0,0 +1,78 @@
+#include "env-inl.h"
+#include "gtest/gtest.h"
+#include "histogram-inl.h"
+#include "node.h"
+#include "node_perf.h"
+#include "node_test_fixture.h"
+
+using node::Environment;
+using node::performance::NODE_PERFORMANCE_GC_PAUSE_FIELD_INVALID;
+using node::performance::NODE_PERFORMANCE_GC_PAUSE_FIELD_MAX;
+using node::performance::NODE_PERFORMANCE_GC_PAUSE_FIELD_MIN;
+using node::performance::NODE_PERFORMANCE_GC_PAUSE_FIELD_PAUSES;
+using node::performance::NODE_PERFORMANCE_GC_PAUSE_FIELD_TOTAL;
+using node::performance::NODE_PERFORMANCE_GC_PAUSE_MAJOR;
+using node::performance::NODE_PERFORMANCE_GC_PAUSE_MINOR;
+using node::performance::NODE_PERFORMANCE_HEAP_SPACE_FIELD_ALLOCATED;
+using node::performance::NODE_PERFORMANCE_HEAP_SPACE_FIELD_INVALID;
+using node::performance::PerformanceState;
+using v8::HandleScope;
+using v8::Isolate;
+
+class PerformanceStateTest : public EnvironmentTestFixture {};
+
+TEST_F(PerformanceStateTest, GCPauses) {
+  const HandleScope handle_scope(isolate_);
+  const Argv argv;
+  Env env{handle_scope, argv};
+  PerformanceState* state = (*env)->performance_state();
+
+  state->UpdateGCMetrics(isolate_);
+  size_t major = size_t{NODE_PERFORMANCE_GC_PAUSE_MAJOR} *
+                 NODE_PERFORMANCE_GC_PAUSE_FIELD_INVALID;
+  double pauses = state->gc_pauses[major +
+                                   NODE_PERFORMANCE_GC_PAUSE_FIELD_PAUSES];
+
+  v8::V8::SetFlagsFromString("--expose-gc");
+  isolate_->RequestGarbageCollectionForTesting(Isolate::kFullGarbageCollection);
+  isolate_->RequestGarbageCollectionForTesting(
+      Isolate::kMinorGarbageCollection);
+
+  state->UpdateGCMetrics(isolate_);
+  EXPECT_GT(state->gc_pauses[major + NODE_PERFORMANCE_GC_PAUSE_FIELD_PAUSES],
+            pauses);
+  EXPECT_GT(state->gc_pauses[major + NODE_PERFORMANCE_GC_PAUSE_FIELD_TOTAL],
+            0);
+  EXPECT_LE(state->gc_pauses[major + NODE_PERFORMANCE_GC_PAUSE_FIELD_MIN],
+            state->gc_pauses[major + NODE_PERFORMANCE_GC_PAUSE_FIELD_MAX]);
+  size_t minor = size_t{NODE_PERFORMANCE_GC_PAUSE_MINOR} *
+                 NODE_PERFORMANCE_GC_PAUSE_FIELD_INVALID;
+  EXPECT_GT(state->gc_pauses[minor + NODE_PERFORMANCE_GC_PAUSE_FIELD_PAUSES],
+            0);
+
+  // The histograms handed out are the ones that are recorded into.
+  EXPECT_EQ(
+      static_cast<double>(
+          state->gc_pause_histogram(NODE_PERFORMANCE_GC_PAUSE_MAJOR)->Count()),
+      state->gc_pauses[major + NODE_PERFORMANCE_GC_PAUSE_FIELD_PAUSES]);
+}
+
+TEST_F(PerformanceStateTest, HeapSpaces) {
+  const HandleScope handle_scope(isolate_);
+  const Argv argv;
+  Env env{handle_scope, argv};
+  PerformanceState* state = (*env)->performance_state();
+
+  v8::V8::SetFlagsFromString("--expose-gc");
+  isolate_->RequestGarbageCollectionForTesting(Isolate::kFullGarbageCollection);
+  state->UpdateGCMetrics(isolate_);
+
+  double allocated = 0;
+  for (size_t i = 0; i < isolate_->NumberOfHeapSpaces(); ++i) {
+    size_t base = i * NODE_PERFORMANCE_HEAP_SPACE_FIELD_INVALID;
+    allocated +=
+        state->heap_spaces[base + NODE_PERFORMANCE_HEAP_SPACE_FIELD_ALLOCATED];
+  }
+  // Bootstrapping the Environment alone allocates on the heap.
+  EXPECT_GT(allocated, 0);
+}
@@ -0,0 +1,166 @@
+#include "gtest/gtest.h"
+#include "node_prestart.h"
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cstring>
+#endif
+
+using node::prestart::Job;
+using node::prestart::ParseJob;
+using node::prestart::ParseResult;
+
+using std::operator""sv;
+
+TEST(PrestartTest, ParsesJobs) {
+  Job job;
+  std::string error;
+  EXPECT_EQ(ParseJob("cwd=/work\0arg=main.js\0arg=\0arg=a=b\0"
+                     "env=PATH=/bin\0env=EMPTY=\0\0"sv,
+                     &job,
+                     &error),
+            ParseResult::kComplete);
+  EXPECT_EQ(job.cwd, "/work");
+  EXPECT_EQ(job.args, (std::vector<std::string>{"main.js", "", "a=b"}));
+  EXPECT_EQ(job.env, (std::vector<std::string>{"PATH=/bin", "EMPTY="}));
+
+  EXPECT_EQ(ParseJob("\0"sv, &job, &error), ParseResult::kComplete);
+  EXPECT_TRUE(job.cwd.empty());
+  EXPECT_TRUE(job.args.empty());
+  EXPECT_TRUE(job.env.empty());
+}
+
+TEST(PrestartTest, WaitsForTheEndOfTheJob) {
+  Job job;
+  std::string error;
+  EXPECT_EQ(ParseJob(""sv, &job, &error), ParseResult::kIncomplete);
+  EXPECT_EQ(ParseJob("arg=main"sv, &job, &error), ParseResult::kIncomplete);
+  EXPECT_EQ(ParseJob("arg=main.js\0"sv, &job, &error),
+            ParseResult::kIncomplete);
+}
+
+TEST(PrestartTest, RejectsInvalidJobs) {
+  Job job;
+  std::string error;
+  EXPECT_EQ(ParseJob("arg\0\0"sv, &job, &error), ParseResult::kInvalid);
+  EXPECT_EQ(error, "invalid field \"arg\"");
+  EXPECT_EQ(ParseJob("uid=0\0\0"sv, &job, &error), ParseResult::kInvalid);
+  EXPECT_EQ(ParseJob("env=PATH\0\0"sv, &job, &error), ParseResult::kInvalid);
+  EXPECT_EQ(ParseJob("env==x\0\0"sv, &job, &error), ParseResult::kInvalid);
+  EXPECT_EQ(ParseJob("arg=a\0\0arg=b\0\0"sv, &job, &error),
+            ParseResult::kInvalid);
+  EXPECT_EQ(error, "data after the end of the job");
+}
+
+TEST(PrestartTest, RemovesTheOptionFromExecArgv) {
+  std::vector<std::string> exec_args = {
+      "--prestart-fd=3", "--no-warnings", "--prestart-fd", "4", "--fast-exit"};
+  node::prestart::RemovePrestartOption(&exec_args);
+  EXPECT_EQ(exec_args,
+            (std::vector<std::string>{"--no-warnings", "--fast-exit"}));
+}
+
+#ifndef _WIN32
+TEST(PrestartTest, ReadsJobsWithFileDescriptors) {
+  int sockets[2];
+  ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, sockets), 0);
+  int pipe_fds[2];
+  ASSERT_EQ(pipe(pipe_fds), 0);
+
+  // The job arrives in two writes, with the descriptor on the first.
+  const std::string_view first = "cwd=/tmp\0ar"sv;
+  iovec iov = {const_cast<char*>(first.data()), first.size()};
+  alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))] = {};
+  msghdr msg = {};
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = control;
+  msg.msg_controllen = sizeof(control);
+  cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+  cmsg->cmsg_level = SOL_SOCKET;
+  cmsg->cmsg_type = SCM_RIGHTS;
+  cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+  memcpy(CMSG_DATA(cmsg), &pipe_fds[1], sizeof(int));
+  ASSERT_EQ(sendmsg(sockets[0], &msg, 0), static_cast<ssize_t>(first.size()));
+  const std::string_view second = "g=main.js\0\0"sv;
+  ASSERT_EQ(write(sockets[0], second.data(), second.size()),
+            static_cast<ssize_t>(second.size()));
+
+  Job job;
+  std::vector<int> fds;
+  std::string error;
+  ASSERT_TRUE(node::prestart::ReadJob(sockets[1], &job, &fds, &error))
+      << error;
+  EXPECT_EQ(job.cwd, "/tmp");
+  EXPECT_EQ(job.args, std::vector<std::string>{"main.js"});
+  ASSERT_EQ(fds.size(), 1u);
+
+  // The descriptor is the write end of the pipe.
+  close(pipe_fds[1]);
+  ASSERT_EQ(write(fds[0], "x", 1), 1);
+  close(fds[0]);
+  char data;
+  EXPECT_EQ(read(pipe_fds[0], &data, 1), 1);
+  EXPECT_EQ(data, 'x');
+  close(pipe_fds[0]);
+
+  // Closing the socket without a job is not an error.
+  close(sockets[0]);
+  EXPECT_FALSE(node::prestart::ReadJob(sockets[1], &job, &fds, &error));
+  EXPECT_TRUE(error.empty());
+  close(sockets[1]);
+}
+
+TEST(PrestartTest, ReadsJobsFromPipes) {
+  int pipe_fds[2];
+  ASSERT_EQ(pipe(pipe_fds), 0);
+  const std::string_view partial = "arg=main.js\0"sv;
+  ASSERT_EQ(write(pipe_fds[1], partial.data(), partial.size()),
+            static_cast<ssize_t>(partial.size()));
+  close(pipe_fds[1]);
+
+  Job job;
+  std::vector<int> fds;
+  std::string error;
+  EXPECT_FALSE(node::prestart::ReadJob(pipe_fds[0], &job, &fds, &error));
+  EXPECT_EQ(error, "the job is incomplete");
+  close(pipe_fds[0]);
+}
+
+// Sets up the process for a job and reports whether it took, so it runs in
+// a child process.
+namespace {
+[[noreturn]] void RunJob() {
+  int pipe_fds[2];
+  if (pipe(pipe_fds) != 0) exit(1);
+  const std::string_view message =
+      "cwd=/\0arg=main.js\0arg=x\0env=ONLY=1\0\0"sv;
+  if (write(pipe_fds[1], message.data(), message.size()) == -1) exit(1);
+  close(pipe_fds[1]);
+  std::vector<std::string> args = {"node"};
+  std::vector<std::string> exec_args = {"--prestart-fd=3"};
+  node::ExitCode exit_code;
+  if (!node::prestart::WaitForJob(pipe_fds[0], &args, &exec_args, &exit_code))
+    exit(2);
+  const std::vector<std::string> expected_args = {"node", "main.js", "x"};
+  char cwd[2];
+  const bool ok = args == expected_args && exec_args.empty() &&
+                  getcwd(cwd, sizeof(cwd)) != nullptr &&
+                  std::string_view(cwd) == "/" && getenv("ONLY") != nullptr &&
+                  getenv("PATH") == nullptr &&
+                  fcntl(pipe_fds[0], F_GETFD) == -1;
+  exit(ok ? 0 : 3);
+}
+}  // namespace
+
+TEST(PrestartTest, SetsUpTheProcessForTheJob) {
+  EXPECT_EXIT(RunJob(), ::testing::ExitedWithCode(0), "");
+}
+#endif  // _WIN32
@@ -0,0 +1,153 @@
+#include "tracing/agent.h"
+#include "tracing/node_trace_buffer.h"
+#include "tracing/trace_event.h"
+
+#include <atomic>
+#include <memory>
+#include <unordered_set>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "uv.h"
+
+using node::tracing::Agent;
+using node::tracing::AsyncTraceWriter;
+using node::tracing::InternalTraceBuffer;
+using node::tracing::TraceBufferChunk;
+using node::tracing::TraceObject;
+
+namespace {
+
+constexpr int kThreads = 4;
+constexpr uint64_t kEventsPerThread = 20000;
+// Small, so that the buffer fills up and is flushed while events are added.
+constexpr size_t kChunks = 2;
+
+const uint8_t kCategoryEnabled = 1;
+
+// Checks every event that is flushed to it. Only the thread that flushes the
+// buffer calls it.
+class CheckingWriter : public AsyncTraceWriter {
+ public:
+  void AppendTraceEvent(TraceObject* trace_event) override {
+    // Adders set the id and the bind id to the same value, so an event that
+    // is flushed while it is initialized shows up as a mismatch.
+    if (trace_event->name() == nullptr ||
+        trace_event->id() != trace_event->bind_id() ||
+        !ids_.insert(trace_event->id()).second) {
+      broken_++;
+    }
+  }
+  void Flush(bool blocking) override {}
+
+  size_t appended() const { return ids_.size(); }
+  size_t broken() const { return broken_; }
+
+ private:
+  std::unordered_set<uint64_t> ids_;
+  size_t broken_ = 0;
+};
+
+struct Adder {
+  InternalTraceBuffer* buffer;
+  uint64_t first_id;
+  std::atomic<int>* running;
+  uint64_t added = 0;
+};
+
+void AddEvents(void* data) {
+  Adder* adder = static_cast<Adder*>(data);
+  for (uint64_t i = 0; i < kEventsPerThread; i++) {
+    uint64_t handle;
+    TraceObject* trace_event = adder->buffer->AddTraceEvent(&handle);
+    if (trace_event == nullptr) continue;
+    const uint64_t id = adder->first_id + i;
+    trace_event->Initialize(TRACE_EVENT_PHASE_INSTANT,
+                            &kCategoryEnabled,
+                            "event",
+                            nullptr,
+                            id,
+                            id,
+                            0,
+                            nullptr,
+                            nullptr,
+                            nullptr,
+                            nullptr,
+                            0,
+                            0,
+                            0);
+    adder->buffer->Publish(handle);
+    adder->added++;
+  }
+  adder->running->fetch_sub(1);
+}
+
+}  // namespace
+
+TEST(InternalTraceBufferTest, FlushesWhileEventsAreAdded) {
+  Agent agent;
+  auto writer = std::make_unique<CheckingWriter>();
+  CheckingWriter* checker = writer.get();
+  auto handle = agent.AddClient(
+      {"test"}, std::move(writer), Agent::kIgnoreDefaultCategories);
+  InternalTraceBuffer buffer(kChunks, 0, &agent);
+
+  std::atomic<int> running{kThreads};
+  std::vector<Adder> adders(kThreads);
+  std::vector<uv_thread_t> threads(kThreads);
+  for (int i = 0; i < kThreads; i++) {
+    adders[i] = {&buffer, i * kEventsPerThread, &running};
+    ASSERT_EQ(0, uv_thread_create(&threads[i], AddEvents, &adders[i]));
+  }
+  while (running.load() > 0) buffer.Flush(false);
+  for (uv_thread_t& thread : threads) ASSERT_EQ(0, uv_thread_join(&thread));
+  buffer.Flush(false);
+
+  uint64_t added = 0;
+  for (const Adder& adder : adders) added += adder.added;
+  // Slots are handed out again after the buffer has been flushed.
+  EXPECT_GT(added, kChunks * TraceBufferChunk::kChunkSize);
+  EXPECT_EQ(checker->broken(), 0u);
+  EXPECT_EQ(checker->appended(), added);
+}
+
+TEST(InternalTraceBufferTest, ReusesSlotsOnlyOnceAddsAreDone) {
+  Agent agent;
+  auto writer = std::make_unique<CheckingWriter>();
+  CheckingWriter* checker = writer.get();
+  auto handle = agent.AddClient(
+      {"test"}, std::move(writer), Agent::kIgnoreDefaultCategories);
+  InternalTraceBuffer buffer(kChunks, 0, &agent);
+
+  uint64_t pending_handle;
+  TraceObject* pending = buffer.AddTraceEvent(&pending_handle);
+  ASSERT_NE(pending, nullptr);
+  // The event is not published yet, so the flush has to skip it, and keep
+  // its slot from being handed out again.
+  buffer.Flush(false);
+  EXPECT_EQ(checker->appended(), 0u);
+  EXPECT_TRUE(buffer.IsFull());
+  uint64_t other_handle;
+  EXPECT_EQ(buffer.AddTraceEvent(&other_handle), nullptr);
+  EXPECT_EQ(other_handle, 0u);
+
+  pending->Initialize(TRACE_EVENT_PHASE_INSTANT,
+                      &kCategoryEnabled,
+                      "event",
+                      nullptr,
+                      1,
+                      1,
+                      0,
+                      nullptr,
+                      nullptr,
+                      nullptr,
+                      nullptr,
+                      0,
+                      0,
+                      0);
+  buffer.Publish(pending_handle);
+  buffer.Flush(false);
+  EXPECT_EQ(checker->appended(), 1u);
+  EXPECT_EQ(checker->broken(), 0u);
+  EXPECT_FALSE(buffer.IsFull());
+}
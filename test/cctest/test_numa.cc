@@ -0,0 +1,54 @@
+#include "gtest/gtest.h"
+#include "node_numa.h"
+#include "uv.h"
+
+#include <vector>
+
+using node::numa::ParseCpuList;
+
+TEST(NumaTest, ParseCpuList) {
+  std::vector<int> cpus;
+  EXPECT_TRUE(ParseCpuList("0-3,8,10-11\n", &cpus));
+  EXPECT_EQ(cpus, (std::vector<int>{0, 1, 2, 3, 8, 10, 11}));
+
+  cpus.clear();
+  EXPECT_TRUE(ParseCpuList("\n", &cpus));
+  EXPECT_TRUE(cpus.empty());
+
+  for (const char* list : {"1-", "3-1", "1,,2", "1,", "a", "-1"}) {
+    cpus.clear();
+    EXPECT_FALSE(ParseCpuList(list, &cpus)) << list;
+  }
+}
+
+TEST(NumaTest, SetCurrentThreadAffinity) {
+  std::vector<int> old_cpus;
+  int mask_size = uv_cpumask_size();
+  if (mask_size < 0) GTEST_SKIP() << "CPU affinity is not supported";
+  std::vector<char> mask(mask_size);
+  uv_thread_t self = uv_thread_self();
+  ASSERT_EQ(uv_thread_getaffinity(&self, mask.data(), mask.size()), 0);
+  for (int cpu = 0; cpu < mask_size; cpu++) {
+    if (mask[cpu]) old_cpus.push_back(cpu);
+  }
+  ASSERT_FALSE(old_cpus.empty());
+
+  EXPECT_EQ(node::numa::SetCurrentThreadAffinity({mask_size}), UV_EINVAL);
+  ASSERT_EQ(node::numa::SetCurrentThreadAffinity({old_cpus[0]}), 0);
+  ASSERT_EQ(uv_thread_getaffinity(&self, mask.data(), mask.size()), 0);
+  for (int cpu = 0; cpu < mask_size; cpu++)
+    EXPECT_EQ(mask[cpu], cpu == old_cpus[0]);
+
+  EXPECT_EQ(node::numa::SetCurrentThreadAffinity(old_cpus), 0);
+}
+
+TEST(NumaTest, NodeCpusAreDisjoint) {
+  std::vector<bool> seen;
+  for (const std::vector<int>& cpus : node::numa::GetNodeCpus()) {
+    for (int cpu : cpus) {
+      if (static_cast<size_t>(cpu) >= seen.size()) seen.resize(cpu + 1);
+      EXPECT_FALSE(seen[cpu]) << cpu;
+      seen[cpu] = true;
+    }
+  }
+}
@@ -0,0 +1,165 @@
+#include "env-inl.h"
+#include "gtest/gtest.h"
+#include "node_realm-inl.h"
+#include "node_test_fixture.h"
+#include "util-inl.h"
+#include "zlib.h"
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+using v8::ArrayBuffer;
+using v8::Context;
+using v8::Function;
+using v8::Integer;
+using v8::Local;
+using v8::Script;
+using v8::Uint8Array;
+using v8::Value;
+
+// Compresses `input` with a ParallelGzip stream, in chunks of `chunkSize`
+// bytes through writeSync(), and returns the output. If `level` is set, it
+// is passed to params() before the first write. Errors are returned as
+// their code.
+static const char kCompressScript[] =
+    "(function(internalBinding, input, chunkSize, level) {"
+    "  const { ParallelGzip } = internalBinding('zlib');"
+    "  const Z_NO_FLUSH = 0, Z_FINISH = 4;"
+    "  const gzip = new ParallelGzip();"
+    "  const result = new Uint32Array(2);"
+    "  let error;"
+    "  gzip.onerror = (message, errno, code) => { error = code; };"
+    "  gzip.init(6, 8, 0, 64 * 1024, result, () => {});"
+    "  if (level !== undefined) gzip.params(level, 0);"
+    "  if (error !== undefined) return error;"
+    "  const out = new Uint8Array(16 * 1024);"
+    "  const chunks = [];"
+    "  let total = 0;"
+    "  for (let offset = 0; offset <= input.length; offset += chunkSize) {"
+    "    const end = Math.min(offset + chunkSize, input.length);"
+    "    const flush = end === input.length ? Z_FINISH : Z_NO_FLUSH;"
+    "    let inOff = offset;"
+    "    let inLen = end - offset;"
+    "    do {"
+    "      gzip.writeSync(flush, input, inOff, inLen, out, 0, out.length);"
+    "      if (error !== undefined) return error;"
+    "      const [availOut, availIn] = result;"
+    "      chunks.push(out.slice(0, out.length - availOut));"
+    "      total += out.length - availOut;"
+    "      inOff += inLen - availIn;"
+    "      inLen = availIn;"
+    "      if (availOut !== 0) break;"
+    "    } while (true);"
+    "    if (flush === Z_FINISH) break;"
+    "  }"
+    "  const output = new Uint8Array(total);"
+    "  let position = 0;"
+    "  for (const chunk of chunks) {"
+    "    output.set(chunk, position);"
+    "    position += chunk.length;"
+    "  }"
+    "  return output;"
+    "})";
+
+class ParallelGzipTest : public EnvironmentTestFixture {
+ protected:
+  // Returns the output, or the error code with a leading "!".
+  std::string Compress(node::Environment* env,
+                       const std::string& input,
+                       uint32_t chunk_size,
+                       Local<Value> level) {
+    Local<Context> context = env->context();
+    Local<Value> fn;
+    EXPECT_TRUE(
+        Script::Compile(context, node::OneByteString(isolate_, kCompressScript))
+            .ToLocalChecked()
+            ->Run(context)
+            .ToLocal(&fn));
+    Local<ArrayBuffer> buffer = ArrayBuffer::New(isolate_, input.size());
+    memcpy(buffer->Data(), input.data(), input.size());
+    Local<Value> argv[] = {
+        env->principal_realm()->internal_binding_loader(),
+        Uint8Array::New(buffer, 0, input.size()),
+        Integer::NewFromUnsigned(isolate_, chunk_size),
+        level,
+    };
+    Local<Value> result;
+    EXPECT_TRUE(
+        fn.As<Function>()
+            ->Call(context, v8::Null(isolate_), node::arraysize(argv), argv)
+            .ToLocal(&result));
+    if (!result->IsUint8Array()) {
+      return "!" + std::string(*node::Utf8Value(isolate_, result));
+    }
+    Local<Uint8Array> output = result.As<Uint8Array>();
+    std::string bytes(output->ByteLength(), '\0');
+    output->CopyContents(bytes.data(), bytes.size());
+    return bytes;
+  }
+
+  // Decodes a single gzip member that has to span all of |data|.
+  static bool Gunzip(const std::string& data, std::string* result) {
+    z_stream strm{};
+    if (inflateInit2(&strm, 16 + MAX_WBITS) != Z_OK) return false;
+    std::vector<char> out(64 * 1024);
+    strm.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+    strm.avail_in = data.size();
+    int err;
+    do {
+      strm.next_out = reinterpret_cast<Bytef*>(out.data());
+      strm.avail_out = out.size();
+      err = inflate(&strm, Z_NO_FLUSH);
+      result->append(out.data(), out.size() - strm.avail_out);
+    } while (err == Z_OK);
+    const bool ok = err == Z_STREAM_END && strm.avail_in == 0;
+    inflateEnd(&strm);
+    return ok;
+  }
+
+  // Text that compresses well, but not into nothing.
+  static std::string Input(size_t size) {
+    std::string input;
+    uint32_t state = 1;
+    while (input.size() < size) {
+      state = state * 1103515245 + 12345;
+      input += "record " + std::to_string((state >> 16) % 1000) + ";\n";
+    }
+    input.resize(size);
+    return input;
+  }
+};
+
+TEST_F(ParallelGzipTest, ProducesASingleGzipMember) {
+  const v8::HandleScope handle_scope(isolate_);
+  Argv argv;
+  Env env{handle_scope, argv};
+
+  for (size_t size : {0, 1000, 64 * 1024, 3 * 1024 * 1024 + 17}) {
+    const std::string input = Input(size);
+    const std::string output =
+        Compress(*env, input, 100 * 1000, v8::Undefined(isolate_));
+    std::string decoded;
+    EXPECT_TRUE(Gunzip(output, &decoded)) << size;
+    EXPECT_EQ(decoded, input) << size;
+    if (size > 1000) EXPECT_LT(output.size(), input.size() / 2) << size;
+  }
+}
+
+TEST_F(ParallelGzipTest, AppliesParams) {
+  const v8::HandleScope handle_scope(isolate_);
+  Argv argv;
+  Env env{handle_scope, argv};
+
+  const std::string input = Input(1024 * 1024);
+  // Level 0 stores the blocks.
+  const std::string output =
+      Compress(*env, input, 100 * 1000, Integer::New(isolate_, 0));
+  std::string decoded;
+  EXPECT_TRUE(Gunzip(output, &decoded));
+  EXPECT_EQ(decoded, input);
+  EXPECT_GT(output.size(), input.size());
+
+  EXPECT_EQ(Compress(*env, input, 100 * 1000, Integer::New(isolate_, 42)),
+            "!Z_STREAM_ERROR");
+}
@@ -93,3 +93,33 @@ TEST_F(PathTest, ToNamespacedPath) {
   EXPECT_EQ(data.ToStringView(), "hello world");  // Input should not be mutated
 #endif
 }
+
+#ifndef _WIN32
+TEST_F(PathTest, NormalizePosixPath) {
+  using node::NormalizePosixPath;
+  EXPECT_EQ(NormalizePosixPath(""), ".");
+  EXPECT_EQ(NormalizePosixPath("./fixtures///b/../b/c.js"), "fixtures/b/c.js");
+  EXPECT_EQ(NormalizePosixPath("/foo/../../../bar"), "/bar");
+  EXPECT_EQ(NormalizePosixPath("a//b//../b"), "a/b");
+  EXPECT_EQ(NormalizePosixPath("a//b//./c"), "a/b/c");
+  EXPECT_EQ(NormalizePosixPath("a//b//."), "a/b");
+  EXPECT_EQ(NormalizePosixPath("/a/b/c/../../../x/y/z"), "/x/y/z");
+  EXPECT_EQ(NormalizePosixPath("///..//./foo/.//bar"), "/foo/bar");
+  EXPECT_EQ(NormalizePosixPath("bar/foo../../"), "bar/");
+  EXPECT_EQ(NormalizePosixPath("bar/foo../.."), "bar");
+  EXPECT_EQ(NormalizePosixPath("bar/foo../../baz"), "bar/baz");
+  EXPECT_EQ(NormalizePosixPath("bar/foo../"), "bar/foo../");
+  EXPECT_EQ(NormalizePosixPath("bar/foo.."), "bar/foo..");
+  EXPECT_EQ(NormalizePosixPath("../foo../../../bar"), "../../bar");
+  EXPECT_EQ(NormalizePosixPath("../.../.././.../../../bar"), "../../bar");
+  EXPECT_EQ(NormalizePosixPath("../../../foo/../../../bar"),
+            "../../../../../bar");
+  EXPECT_EQ(NormalizePosixPath("../foobar/barfoo/foo/../../../bar/../../"),
+            "../../");
+  EXPECT_EQ(NormalizePosixPath("../.../../foobar/../../../bar/../../baz"),
+            "../../../../baz");
+  EXPECT_EQ(NormalizePosixPath("foo/bar\\baz"), "foo/bar\\baz");
+  EXPECT_EQ(NormalizePosixPath("./"), "./");
+  EXPECT_EQ(NormalizePosixPath("/"), "/");
+}
+#endif  // _WIN32
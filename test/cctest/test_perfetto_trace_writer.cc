@@ -0,0 +1,305 @@
+#include "tracing/agent.h"
+#include "tracing/perfetto_trace_writer.h"
+#include "tracing/trace_event.h"
+
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+using node::tracing::Agent;
+using node::tracing::PerfettoTraceWriter;
+using node::tracing::TraceObject;
+
+namespace {
+
+// A decoded protobuf field. Fixed 64-bit values are kept as their bytes.
+struct Field {
+  uint32_t number;
+  uint64_t varint = 0;
+  std::string bytes;
+};
+
+using Message = std::vector<Field>;
+
+uint64_t ReadVarint(std::string_view* data) {
+  uint64_t value = 0;
+  for (int shift = 0; !data->empty(); shift += 7) {
+    uint8_t byte = static_cast<uint8_t>(data->front());
+    data->remove_prefix(1);
+    value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+    if ((byte & 0x80) == 0) break;
+  }
+  return value;
+}
+
+Message Parse(std::string_view data) {
+  Message message;
+  while (!data.empty()) {
+    uint64_t tag = ReadVarint(&data);
+    Field field;
+    field.number = static_cast<uint32_t>(tag >> 3);
+    switch (tag & 7) {
+      case 0:
+        field.varint = ReadVarint(&data);
+        break;
+      case 1:
+        field.bytes = std::string(data.substr(0, 8));
+        data.remove_prefix(8);
+        break;
+      case 2: {
+        size_t length = ReadVarint(&data);
+        field.bytes = std::string(data.substr(0, length));
+        data.remove_prefix(length);
+        break;
+      }
+      default:
+        ADD_FAILURE() << "unexpected wire type " << (tag & 7);
+        return message;
+    }
+    message.push_back(std::move(field));
+  }
+  return message;
+}
+
+const Field* Find(const Message& message, uint32_t number) {
+  for (const Field& field : message) {
+    if (field.number == number) return &field;
+  }
+  return nullptr;
+}
+
+std::vector<const Field*> FindAll(const Message& message, uint32_t number) {
+  std::vector<const Field*> fields;
+  for (const Field& field : message) {
+    if (field.number == number) fields.push_back(&field);
+  }
+  return fields;
+}
+
+// Field numbers from perfetto's protos/perfetto/trace/.
+constexpr uint32_t kPacket = 1;
+constexpr uint32_t kPacketTimestamp = 8;
+constexpr uint32_t kPacketTrackEvent = 11;
+constexpr uint32_t kPacketInternedData = 12;
+constexpr uint32_t kPacketSequenceFlags = 13;
+constexpr uint32_t kPacketTrackDescriptor = 60;
+constexpr uint32_t kEventType = 9;
+constexpr uint32_t kEventNameIid = 10;
+constexpr uint32_t kEventTrackUuid = 11;
+constexpr uint32_t kEventCounterValue = 30;
+constexpr uint32_t kInternedEventNames = 2;
+constexpr uint32_t kInternedIid = 1;
+constexpr uint32_t kInternedName = 2;
+constexpr uint32_t kDescriptorUuid = 1;
+constexpr uint32_t kDescriptorName = 2;
+constexpr uint32_t kDescriptorProcess = 3;
+constexpr uint32_t kDescriptorCounter = 8;
+constexpr uint32_t kProcessName = 6;
+
+constexpr uint64_t kSeqIncrementalStateCleared = 1;
+constexpr uint64_t kTypeSliceBegin = 1;
+constexpr uint64_t kTypeSliceEnd = 2;
+constexpr uint64_t kTypeCounter = 4;
+
+class PerfettoTraceWriterTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    category_ = agent_.GetTracingController()->GetCategoryGroupEnabled("cat");
+  }
+
+  void Append(char phase,
+              const char* name,
+              int64_t timestamp,
+              const char* arg_name = nullptr,
+              uint8_t arg_type = 0,
+              uint64_t arg_value = 0,
+              int64_t end_timestamp = -1) {
+    TraceObject trace_event;
+    const char* arg_names[] = {arg_name};
+    const uint8_t arg_types[] = {arg_type};
+    const uint64_t arg_values[] = {arg_value};
+    trace_event.Initialize(phase,
+                           category_,
+                           name,
+                           nullptr,
+                           0,
+                           0,
+                           arg_name != nullptr ? 1 : 0,
+                           arg_names,
+                           arg_types,
+                           arg_values,
+                           nullptr,
+                           0,
+                           timestamp,
+                           0);
+    if (end_timestamp >= 0) trace_event.UpdateDuration(end_timestamp, 0);
+    writer_.AppendTraceEvent(&trace_event);
+  }
+
+  // The TracePackets written so far.
+  std::vector<Message> Packets() {
+    std::vector<Message> packets;
+    for (const Field* packet : FindAll(Parse(stream_.str()), kPacket))
+      packets.push_back(Parse(packet->bytes));
+    return packets;
+  }
+
+  static std::vector<Message> Descriptors(const std::vector<Message>& packets,
+                                          uint32_t kind) {
+    std::vector<Message> descriptors;
+    for (const Message& packet : packets) {
+      const Field* field = Find(packet, kPacketTrackDescriptor);
+      if (field == nullptr) continue;
+      Message descriptor = Parse(field->bytes);
+      if (Find(descriptor, kind) != nullptr) descriptors.push_back(descriptor);
+    }
+    return descriptors;
+  }
+
+  static std::vector<Message> EventPackets(
+      const std::vector<Message>& packets) {
+    std::vector<Message> events;
+    for (const Message& packet : packets) {
+      if (Find(packet, kPacketTrackEvent) != nullptr) events.push_back(packet);
+    }
+    return events;
+  }
+
+  static Message Event(const Message& packet) {
+    return Parse(Find(packet, kPacketTrackEvent)->bytes);
+  }
+
+  Agent agent_;
+  const uint8_t* category_;
+  std::ostringstream stream_;
+  PerfettoTraceWriter writer_{stream_};
+};
+
+}  // namespace
+
+TEST_F(PerfettoTraceWriterTest, WritesSlicesWithInternedNames) {
+  Append(TRACE_EVENT_PHASE_BEGIN, "slice", 1000);
+  Append(TRACE_EVENT_PHASE_END, "slice", 2000);
+  Append(TRACE_EVENT_PHASE_BEGIN, "slice", 3000);
+  Append(TRACE_EVENT_PHASE_END, "slice", 4000);
+
+  std::vector<Message> events = EventPackets(Packets());
+  ASSERT_EQ(events.size(), 4u);
+  const uint64_t expected_types[] = {
+      kTypeSliceBegin, kTypeSliceEnd, kTypeSliceBegin, kTypeSliceEnd};
+  const uint64_t expected_timestamps[] = {
+      1000000, 2000000, 3000000, 4000000};
+  for (size_t i = 0; i < events.size(); i++) {
+    EXPECT_EQ(Find(Event(events[i]), kEventType)->varint, expected_types[i]);
+    EXPECT_EQ(Find(events[i], kPacketTimestamp)->varint,
+              expected_timestamps[i]);
+    // Only the first packet of the sequence clears the incremental state.
+    const uint64_t flags = Find(events[i], kPacketSequenceFlags)->varint;
+    EXPECT_EQ((flags & kSeqIncrementalStateCleared) != 0, i == 0) << i;
+  }
+
+  // The name is interned with the first event, and referred to by its id
+  // from then on.
+  const Field* interned = Find(events[0], kPacketInternedData);
+  ASSERT_NE(interned, nullptr);
+  Message interned_data = Parse(interned->bytes);
+  const Field* name_entry = Find(interned_data, kInternedEventNames);
+  ASSERT_NE(name_entry, nullptr);
+  Message name = Parse(name_entry->bytes);
+  EXPECT_EQ(Find(name, kInternedName)->bytes, "slice");
+  const uint64_t iid = Find(name, kInternedIid)->varint;
+  EXPECT_EQ(Find(Event(events[0]), kEventNameIid)->varint, iid);
+  EXPECT_EQ(Find(Event(events[2]), kEventNameIid)->varint, iid);
+  EXPECT_EQ(Find(events[2], kPacketInternedData), nullptr);
+}
+
+TEST_F(PerfettoTraceWriterTest, SplitsCompleteEvents) {
+  Append(TRACE_EVENT_PHASE_COMPLETE,
+         "complete",
+         3000,
+         nullptr,
+         0,
+         0,
+         3500);
+
+  std::vector<Message> events = EventPackets(Packets());
+  ASSERT_EQ(events.size(), 2u);
+  Message begin = Event(events[0]);
+  Message end = Event(events[1]);
+  EXPECT_EQ(Find(begin, kEventType)->varint, kTypeSliceBegin);
+  EXPECT_EQ(Find(end, kEventType)->varint, kTypeSliceEnd);
+  EXPECT_EQ(Find(events[0], kPacketTimestamp)->varint, 3000000u);
+  EXPECT_EQ(Find(events[1], kPacketTimestamp)->varint, 3500000u);
+  EXPECT_EQ(Find(begin, kEventTrackUuid)->varint,
+            Find(end, kEventTrackUuid)->varint);
+}
+
+TEST_F(PerfettoTraceWriterTest, WritesCounters) {
+  Append(TRACE_EVENT_PHASE_COUNTER,
+         "counter",
+         1000,
+         "value",
+         TRACE_VALUE_TYPE_INT,
+         7);
+  Append(TRACE_EVENT_PHASE_COUNTER,
+         "counter",
+         2000,
+         "value",
+         TRACE_VALUE_TYPE_INT,
+         static_cast<uint64_t>(-3));
+
+  std::vector<Message> packets = Packets();
+  std::vector<Message> counters = Descriptors(packets, kDescriptorCounter);
+  ASSERT_EQ(counters.size(), 1u);
+  EXPECT_EQ(Find(counters[0], kDescriptorName)->bytes, "counter");
+  const uint64_t uuid = Find(counters[0], kDescriptorUuid)->varint;
+
+  std::vector<Message> events = EventPackets(packets);
+  ASSERT_EQ(events.size(), 2u);
+  const int64_t expected_values[] = {7, -3};
+  for (size_t i = 0; i < events.size(); i++) {
+    Message event = Event(events[i]);
+    EXPECT_EQ(Find(event, kEventType)->varint, kTypeCounter);
+    EXPECT_EQ(Find(event, kEventTrackUuid)->varint, uuid);
+    EXPECT_EQ(static_cast<int64_t>(Find(event, kEventCounterValue)->varint),
+              expected_values[i]);
+  }
+}
+
+TEST_F(PerfettoTraceWriterTest, DescribesTheProcessOnceWithItsName) {
+  static const char kName[] = "my-process";
+  Append(TRACE_EVENT_PHASE_METADATA,
+         "process_name",
+         0,
+         "name",
+         TRACE_VALUE_TYPE_STRING,
+         reinterpret_cast<uint64_t>(kName));
+  Append(TRACE_EVENT_PHASE_BEGIN, "slice", 1000);
+  Append(TRACE_EVENT_PHASE_METADATA,
+         "process_name",
+         0,
+         "name",
+         TRACE_VALUE_TYPE_STRING,
+         reinterpret_cast<uint64_t>("renamed"));
+  Append(TRACE_EVENT_PHASE_END, "slice", 2000);
+
+  std::vector<Message> processes =
+      Descriptors(Packets(), kDescriptorProcess);
+  ASSERT_EQ(processes.size(), 1u);
+  Message process = Parse(Find(processes[0], kDescriptorProcess)->bytes);
+  EXPECT_EQ(Find(process, kProcessName)->bytes, kName);
+}
+
+TEST_F(PerfettoTraceWriterTest, NamesUnnamedProcessesAfterTheTitle) {
+  Append(TRACE_EVENT_PHASE_BEGIN, "slice", 1000);
+
+  std::vector<Message> processes =
+      Descriptors(Packets(), kDescriptorProcess);
+  ASSERT_EQ(processes.size(), 1u);
+  Message process = Parse(Find(processes[0], kDescriptorProcess)->bytes);
+  ASSERT_NE(Find(process, kProcessName), nullptr);
+  EXPECT_FALSE(Find(process, kProcessName)->bytes.empty());
+}
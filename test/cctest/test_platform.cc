@@ -1,7 +1,9 @@
 #include "node_internals.h"
 #include "libplatform/libplatform.h"
 
+#include <atomic>
 #include <string>
+#include <vector>
 #include "gtest/gtest.h"
 #include "node_test_fixture.h"
 
@@ -128,3 +130,125 @@ TEST_F(PlatformTest, TracingControllerNullptr) {
   node::SetTracingController(orig_controller);
   EXPECT_EQ(node::GetTracingController(), orig_controller);
 }
+
+static std::unique_ptr<node::TaskQueueEntry> MakeEntry(
+    v8::TaskPriority priority) {
+  return std::make_unique<node::TaskQueueEntry>(nullptr, priority);
+}
+
+TEST(WorkStealingDequeTest, PopIsLifoAndStealIsFifo) {
+  node::WorkStealingDeque<node::TaskQueueEntry> deque;
+  EXPECT_TRUE(deque.IsEmpty());
+  EXPECT_EQ(deque.Pop(), nullptr);
+  EXPECT_EQ(deque.Steal(), nullptr);
+
+  std::vector<node::TaskQueueEntry*> entries;
+  // Push more than the initial capacity to exercise growing the buffer.
+  for (int i = 0; i < 200; i++) {
+    auto entry = MakeEntry(v8::TaskPriority::kUserVisible);
+    entries.push_back(entry.get());
+    deque.Push(std::move(entry));
+  }
+  EXPECT_FALSE(deque.IsEmpty());
+  EXPECT_EQ(deque.Steal().get(), entries.front());
+  EXPECT_EQ(deque.Pop().get(), entries.back());
+  for (size_t i = 1; i < entries.size() - 1; i++) {
+    EXPECT_EQ(deque.Steal().get(), entries[i]);
+  }
+  EXPECT_TRUE(deque.IsEmpty());
+}
+
+class CountingTask : public v8::Task {
+ public:
+  CountingTask(node::WorkerThreadsTaskRunner* runner,
+               std::atomic<int>* run_count,
+               int children)
+      : runner_(runner), run_count_(run_count), children_(children) {}
+
+  void Run() override {
+    // Tasks posted from here go into the current worker's deque.
+    for (int i = 0; i < children_; i++) {
+      runner_->PostTask(v8::TaskPriority::kUserBlocking,
+                        std::make_unique<CountingTask>(
+                            runner_, run_count_, children_ - 1),
+                        v8::SourceLocation());
+    }
+    (*run_count_)++;
+  }
+
+ private:
+  node::WorkerThreadsTaskRunner* runner_;
+  std::atomic<int>* run_count_;
+  int children_;
+};
+
+TEST(WorkerThreadsTaskRunnerTest, BlockingDrainWaitsForNestedTasks) {
+  node::WorkerThreadsTaskRunner runner(4, node::PlatformDebugLogLevel::kNone);
+  std::atomic<int> run_count{0};
+  // Each root task spawns a tree of 1 + 3 + 3 * 2 + 3 * 2 * 1 = 16 tasks.
+  for (int i = 0; i < 8; i++) {
+    runner.PostTask(v8::TaskPriority::kUserBlocking,
+                    std::make_unique<CountingTask>(&runner, &run_count, 3),
+                    v8::SourceLocation());
+  }
+  runner.BlockingDrain();
+  EXPECT_EQ(run_count, 8 * 16);
+  runner.Shutdown();
+}
+
+class SemaphoreTask : public v8::Task {
+ public:
+  SemaphoreTask(uv_sem_t* sem, bool post) : sem_(sem), post_(post) {}
+
+  void Run() override {
+    if (post_) {
+      uv_sem_post(sem_);
+    } else {
+      uv_sem_wait(sem_);
+    }
+  }
+
+ private:
+  uv_sem_t* sem_;
+  bool post_;
+};
+
+TEST(WorkerThreadsTaskRunnerTest, ReservedThreadsRunUserBlockingTasks) {
+  // One general purpose worker and one reserved for user-blocking tasks.
+  node::WorkerThreadsTaskRunner runner(
+      1, node::PlatformDebugLogLevel::kNone, 1);
+  uv_sem_t sem;
+  ASSERT_EQ(0, uv_sem_init(&sem, 0));
+  // This occupies the only general purpose worker until the user-blocking
+  // task has run, which therefore has to run on the reserved worker.
+  runner.PostTask(v8::TaskPriority::kBestEffort,
+                  std::make_unique<SemaphoreTask>(&sem, false),
+                  v8::SourceLocation());
+  runner.PostTask(v8::TaskPriority::kUserBlocking,
+                  std::make_unique<SemaphoreTask>(&sem, true),
+                  v8::SourceLocation());
+  runner.BlockingDrain();
+  runner.Shutdown();
+  uv_sem_destroy(&sem);
+}
+
+TEST(MPSCQueueTest, PopAllReturnsItemsInPushOrder) {
+  node::MPSCQueue<v8::Task> queue;
+  EXPECT_TRUE(queue.PopAll().empty());
+
+  uv_sem_t sem;
+  ASSERT_EQ(0, uv_sem_init(&sem, 0));
+  std::vector<v8::Task*> tasks;
+  for (int i = 0; i < 10; i++) {
+    auto task = std::make_unique<SemaphoreTask>(&sem, true);
+    tasks.push_back(task.get());
+    queue.Push(std::move(task));
+  }
+  std::vector<std::unique_ptr<v8::Task>> popped = queue.PopAll();
+  ASSERT_EQ(popped.size(), tasks.size());
+  for (size_t i = 0; i < tasks.size(); i++) {
+    EXPECT_EQ(popped[i].get(), tasks[i]);
+  }
+  EXPECT_TRUE(queue.PopAll().empty());
+  uv_sem_destroy(&sem);
+}
@@ -0,0 +1,188 @@
+#include "gtest/gtest.h"
+#include "process_handle.h"
+#include "uv.h"
+
+#ifndef _WIN32
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using node::ProcessHandle;
+
+namespace {
+
+struct Exit {
+  int64_t exit_status = -1;
+  int term_signal = -1;
+};
+
+class ProcessHandleTest : public ::testing::Test {
+ protected:
+  void SetUp() override { ASSERT_EQ(uv_loop_init(&loop_), 0); }
+
+  void TearDown() override {
+    uv_run(&loop_, UV_RUN_DEFAULT);
+    EXPECT_EQ(uv_loop_close(&loop_), 0);
+  }
+
+  // Spawns |args| with the stdio of |stdio|, or none.
+  int Spawn(std::vector<const char*> args,
+            std::vector<uv_stdio_container_t> stdio = {},
+            const char* cwd = nullptr,
+            char** env = nullptr) {
+    args.push_back(nullptr);
+    uv_process_options_t options{};
+    options.file = args[0];
+    options.args = const_cast<char**>(args.data());
+    options.cwd = cwd;
+    options.env = env;
+    options.stdio = stdio.data();
+    options.stdio_count = stdio.size();
+    process_.handle()->data = &exit_;
+    return process_.Spawn(&loop_, &options, OnExit);
+  }
+
+  static void OnExit(ProcessHandle* process,
+                     int64_t exit_status,
+                     int term_signal) {
+    Exit* exit = static_cast<Exit*>(process->handle()->data);
+    exit->exit_status = exit_status;
+    exit->term_signal = term_signal;
+    process->Close(nullptr);
+  }
+
+  uv_loop_t loop_;
+  ProcessHandle process_;
+  Exit exit_;
+};
+
+}  // namespace
+
+TEST_F(ProcessHandleTest, ReportsTheExitStatus) {
+  ASSERT_EQ(Spawn({"/bin/sh", "-c", "exit 7"}), 0);
+  EXPECT_GT(process_.pid(), 0);
+  uv_run(&loop_, UV_RUN_DEFAULT);
+  EXPECT_EQ(exit_.exit_status, 7);
+  EXPECT_EQ(exit_.term_signal, 0);
+}
+
+TEST_F(ProcessHandleTest, Kills) {
+  ASSERT_EQ(Spawn({"sleep", "10"}), 0);
+  EXPECT_EQ(process_.Kill(SIGTERM), 0);
+  uv_run(&loop_, UV_RUN_DEFAULT);
+  EXPECT_EQ(exit_.exit_status, 0);
+  EXPECT_EQ(exit_.term_signal, SIGTERM);
+}
+
+TEST_F(ProcessHandleTest, PipesStdio) {
+  uv_pipe_t input;
+  uv_pipe_t output;
+  ASSERT_EQ(uv_pipe_init(&loop_, &input, 0), 0);
+  ASSERT_EQ(uv_pipe_init(&loop_, &output, 0), 0);
+  std::vector<uv_stdio_container_t> stdio(3);
+  stdio[0].flags =
+      static_cast<uv_stdio_flags>(UV_CREATE_PIPE | UV_READABLE_PIPE);
+  stdio[0].data.stream = reinterpret_cast<uv_stream_t*>(&input);
+  stdio[1].flags =
+      static_cast<uv_stdio_flags>(UV_CREATE_PIPE | UV_WRITABLE_PIPE);
+  stdio[1].data.stream = reinterpret_cast<uv_stream_t*>(&output);
+  uv_os_sock_t errors[2];
+  ASSERT_EQ(uv_socketpair(SOCK_STREAM, 0, errors, 0, 0), 0);
+  stdio[2].flags = UV_INHERIT_FD;
+  stdio[2].data.fd = errors[1];
+  ASSERT_EQ(Spawn({"sh", "-c", "read line; echo \"$line\"; echo err >&2"},
+                  stdio),
+            0);
+
+  std::string received;
+  output.data = &received;
+  ASSERT_EQ(uv_read_start(
+                reinterpret_cast<uv_stream_t*>(&output),
+                [](uv_handle_t* handle, size_t size, uv_buf_t* buf) {
+                  static char storage[1024];
+                  *buf = uv_buf_init(storage, sizeof(storage));
+                },
+                [](uv_stream_t* stream, ssize_t nread, const uv_buf_t* buf) {
+                  if (nread > 0) {
+                    static_cast<std::string*>(stream->data)
+                        ->append(buf->base, nread);
+                  } else if (nread < 0) {
+                    uv_close(reinterpret_cast<uv_handle_t*>(stream), nullptr);
+                  }
+                }),
+            0);
+  char line[] = "hello\n";
+  uv_buf_t buf = uv_buf_init(line, sizeof(line) - 1);
+  ASSERT_EQ(uv_try_write(reinterpret_cast<uv_stream_t*>(&input), &buf, 1),
+            static_cast<int>(buf.len));
+  uv_close(reinterpret_cast<uv_handle_t*>(&input), nullptr);
+
+  uv_run(&loop_, UV_RUN_DEFAULT);
+  EXPECT_EQ(received, "hello\n");
+  EXPECT_EQ(exit_.exit_status, 0);
+  close(errors[1]);
+  char error[16];
+  EXPECT_EQ(read(errors[0], error, sizeof(error)), 4);
+  EXPECT_EQ(std::string(error, 4), "err\n");
+  close(errors[0]);
+}
+
+TEST_F(ProcessHandleTest, ReportsMissingFiles) {
+  EXPECT_EQ(Spawn({"/nonexistent/file"}), UV_ENOENT);
+  process_.Close(nullptr);
+  uv_run(&loop_, UV_RUN_DEFAULT);
+  EXPECT_EQ(Spawn({"nonexistent-file-in-path"}), UV_ENOENT);
+  process_.Close(nullptr);
+  uv_run(&loop_, UV_RUN_DEFAULT);
+  EXPECT_EQ(exit_.exit_status, -1);
+}
+
+// A PATH entry that is relative is relative to the working directory of the
+// child, and a script without a #! line runs in sh.
+TEST_F(ProcessHandleTest, SearchesThePathOfTheChild) {
+  char dir[] = "/tmp/node-process-handle-XXXXXX";
+  ASSERT_NE(mkdtemp(dir), nullptr);
+  const std::string bin = std::string(dir) + "/bin";
+  ASSERT_EQ(mkdir(bin.c_str(), 0700), 0);
+  std::ofstream(bin + "/with-shebang") << "#!/bin/sh\nexit 3\n";
+  std::ofstream(bin + "/without-shebang") << "exit 4\n";
+  ASSERT_EQ(chmod((bin + "/with-shebang").c_str(), 0700), 0);
+  ASSERT_EQ(chmod((bin + "/without-shebang").c_str(), 0700), 0);
+  char path[] = "PATH=/nonexistent:bin";
+  char* env[] = {path, nullptr};
+
+  ASSERT_EQ(Spawn({"with-shebang"}, {}, dir, env), 0);
+  uv_run(&loop_, UV_RUN_DEFAULT);
+  EXPECT_EQ(exit_.exit_status, 3);
+
+  ASSERT_EQ(Spawn({"without-shebang"}, {}, dir, env), 0);
+  uv_run(&loop_, UV_RUN_DEFAULT);
+  EXPECT_EQ(exit_.exit_status, 4);
+
+  unlink((bin + "/with-shebang").c_str());
+  unlink((bin + "/without-shebang").c_str());
+  rmdir(bin.c_str());
+  rmdir(dir);
+}
+
+#ifdef __linux__
+// pidfds, and with them posix_spawn(), are in Linux 5.3 and later.
+TEST_F(ProcessHandleTest, UsesPosixSpawnWithPidfds) {
+  const int pidfd = syscall(__NR_pidfd_open, getpid(), 0);
+  if (pidfd != -1) close(pidfd);
+  ASSERT_EQ(Spawn({"/bin/sh", "-c", "exit 0"}), 0);
+  EXPECT_EQ(process_.uses_posix_spawn(), pidfd != -1);
+  uv_run(&loop_, UV_RUN_DEFAULT);
+  EXPECT_EQ(exit_.exit_status, 0);
+  EXPECT_EQ(process_.Kill(0), UV_ESRCH);
+}
+#endif  // __linux__
+
+#endif  // _WIN32
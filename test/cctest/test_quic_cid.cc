@@ -4,8 +4,10 @@
 #include <ngtcp2/ngtcp2.h>
 #include <quic/cid.h>
 #include <util-inl.h>
+#include <memory>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 using node::quic::CID;
 
@@ -93,4 +95,46 @@ TEST(CID, Basic) {
     }
   }
 }
+
+TEST(CID, Map) {
+  auto& random = CID::Factory::random();
+  std::vector<std::unique_ptr<CID>> cids;
+  for (int n = 0; n < 1000; n++)
+    cids.emplace_back(new CID(random.Generate(5 + n % 16)));
+
+  CID::Map<int> map;
+  CHECK(map.empty());
+  CHECK_EQ(map.find(*cids[0]), map.end());
+  CHECK_EQ(map.erase(*cids[0]), 0);
+
+  for (int n = 0; n < 1000; n++) CHECK(map.emplace(*cids[n], n).second);
+  CHECK_EQ(map.size(), 1000);
+  CHECK(!map.emplace(*cids[0], -1).second);
+  for (int n = 0; n < 1000; n++) CHECK_EQ(map.find(*cids[n])->second, n);
+
+  // Erase every other entry, then add them back, so that the deleted slots
+  // get reused.
+  for (int n = 0; n < 1000; n += 2) CHECK_EQ(map.erase(*cids[n]), 1);
+  CHECK_EQ(map.size(), 500);
+  for (int n = 0; n < 1000; n++)
+    CHECK_EQ(map.find(*cids[n]) == map.end(), n % 2 == 0);
+  for (int n = 0; n < 1000; n += 2) map[*cids[n]] = n;
+
+  CID::Map<int> copy = map;
+  size_t count = 0;
+  for (const auto& entry : copy) {
+    CHECK_EQ(map.find(entry.first)->second, entry.second);
+    count++;
+  }
+  CHECK_EQ(count, 1000);
+
+  map.clear();
+  CHECK(map.empty());
+  CHECK_EQ(map.begin(), map.end());
+  CHECK_EQ(copy.size(), 1000);
+
+  CID::Map<CID> cid_map;
+  cid_map[*cids[0]] = *cids[1];
+  CHECK_EQ(cid_map.find(*cids[0])->second, *cids[1]);
+}
 #endif  // HAVE_OPENSSL && NODE_OPENSSL_HAS_QUIC
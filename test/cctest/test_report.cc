@@ -123,3 +123,25 @@ TEST_F(ReportTest, ReportWithEnv) {
 
   EXPECT_TRUE(report_callback_called);
 }
+
+TEST_F(ReportTest, Vitals) {
+  const HandleScope handle_scope(isolate_);
+  const Argv argv;
+  Env env{handle_scope, argv};
+
+  std::ostringstream oss;
+  node::GetNodeReportVitals(*env, oss);
+
+  std::string actual = oss.str();
+  EXPECT_EQ(actual.front(), '{');
+  EXPECT_EQ(actual.back(), '}');
+  EXPECT_EQ(actual.find('\n'), std::string::npos);
+  EXPECT_NE(actual.find("\"vitalsVersion\":1"), std::string::npos);
+  EXPECT_NE(actual.find("\"usedMemory\":"), std::string::npos);
+  // The Environment has handles of its own, e.g. its timer handle.
+  EXPECT_NE(actual.find("\"timer\":"), std::string::npos);
+  EXPECT_NE(actual.find("\"queueDepth\":0"), std::string::npos);
+  // None of the slow parts of the report are included.
+  EXPECT_EQ(actual.find("javascriptStack"), std::string::npos);
+  EXPECT_EQ(actual.find("environmentVariables"), std::string::npos);
+}
@@ -0,0 +1,128 @@
+#include "env-inl.h"
+#include "gtest/gtest.h"
+#include "node_realm-inl.h"
+#include "node_test_fixture.h"
+#include "util-inl.h"
+
+#include <string>
+
+using v8::Context;
+using v8::Function;
+using v8::Isolate;
+using v8::Local;
+using v8::Object;
+using v8::Script;
+using v8::Value;
+
+class SqliteStatementCacheTest : public EnvironmentTestFixture {
+ protected:
+  // Calls `source`, a function expression, with the internalBinding loader
+  // and `state`, and returns its result as a string.
+  std::string Run(node::Environment* env,
+                  Local<Object> state,
+                  const char* source) {
+    Local<Context> context = env->context();
+    Local<Value> fn;
+    EXPECT_TRUE(Script::Compile(context, node::OneByteString(isolate_, source))
+                    .ToLocalChecked()
+                    ->Run(context)
+                    .ToLocal(&fn));
+    Local<Value> argv[] = {
+        env->principal_realm()->internal_binding_loader(),
+        state,
+    };
+    Local<Value> result;
+    EXPECT_TRUE(
+        fn.As<Function>()
+            ->Call(context, v8::Null(isolate_), node::arraysize(argv), argv)
+            .ToLocal(&result));
+    return *node::Utf8Value(isolate_, result);
+  }
+
+  // Collects the statements that JS no longer refers to, which hands their
+  // compiled statements back to the cache.
+  void CollectGarbage() {
+    v8::V8::SetFlagsFromString("--expose-gc");
+    isolate_->RequestGarbageCollectionForTesting(
+        Isolate::kFullGarbageCollection);
+  }
+};
+
+// Opens a database with room for two cached statements in `state.db`.
+static const char kOpenScript[] =
+    "(function(internalBinding, state) {"
+    "  const { DatabaseSync } = internalBinding('sqlite');"
+    "  state.db = new DatabaseSync(':memory:', { statementCacheSize: 2 });"
+    "  state.db.exec('CREATE TABLE t (x INTEGER); INSERT INTO t VALUES (1)');"
+    "  return '';"
+    "})";
+
+// Prepares and runs each statement of `state.queries`, without keeping any
+// of them, and returns the cache statistics and the results.
+static const char kQueryScript[] =
+    "(function(internalBinding, state) {"
+    "  const results ="
+    "    state.queries.map((sql) => state.db.prepare(sql).get().v);"
+    "  const { size, hits, misses } = state.db.statementCacheStats();"
+    "  return `size=${size} hits=${hits} misses=${misses} ${results}`;"
+    "})";
+
+TEST_F(SqliteStatementCacheTest, EveryPrepareReturnsANewStatement) {
+  const v8::HandleScope handle_scope(isolate_);
+  Argv argv;
+  Env env{handle_scope, argv};
+  Local<Object> state = Object::New(isolate_);
+
+  Run(*env, state, kOpenScript);
+  // Options set on one statement do not affect another one with the same
+  // SQL, even when both are prepared from the same cached statement.
+  EXPECT_EQ(Run(*env,
+                state,
+                "(function(internalBinding, state) {"
+                "  (() => state.db.prepare('SELECT x AS v FROM t').get())();"
+                "  return '';"
+                "})"),
+            "");
+  CollectGarbage();
+  EXPECT_EQ(Run(*env,
+                state,
+                "(function(internalBinding, state) {"
+                "  const a = state.db.prepare('SELECT x AS v FROM t');"
+                "  const b = state.db.prepare('SELECT x AS v FROM t');"
+                "  a.setReadBigInts(true);"
+                "  b.setReturnArrays(true);"
+                "  const { hits, misses } = state.db.statementCacheStats();"
+                "  return [a === b, typeof a.get().v, JSON.stringify(b.get()),"
+                "          hits, misses].join(' ');"
+                "})"),
+            "false bigint [1] 1 2");
+}
+
+TEST_F(SqliteStatementCacheTest, EvictsTheLeastRecentlyUsedStatement) {
+  const v8::HandleScope handle_scope(isolate_);
+  Argv argv;
+  Env env{handle_scope, argv};
+  Local<Object> state = Object::New(isolate_);
+
+  Run(*env, state, kOpenScript);
+  auto query = [&](const char* queries) {
+    Run(*env,
+        state,
+        (std::string("(function(internalBinding, state) {"
+                     "  state.queries = ") +
+         queries + "; return ''; })")
+            .c_str());
+    std::string result = Run(*env, state, kQueryScript);
+    CollectGarbage();
+    return result;
+  };
+
+  EXPECT_EQ(query("['SELECT 1 AS v']"), "size=0 hits=0 misses=1 1");
+  EXPECT_EQ(query("['SELECT 2 AS v']"), "size=1 hits=0 misses=2 2");
+  // Using the first statement again makes the second one the least recently
+  // used one, which the third one evicts.
+  EXPECT_EQ(query("['SELECT 1 AS v']"), "size=1 hits=1 misses=2 1");
+  EXPECT_EQ(query("['SELECT 3 AS v']"), "size=2 hits=1 misses=3 3");
+  EXPECT_EQ(query("['SELECT 2 AS v', 'SELECT 1 AS v', 'SELECT 3 AS v']"),
+            "size=0 hits=2 misses=4 2,1,3");
+}
@@ -0,0 +1,98 @@
+#include "gtest/gtest.h"
+#include "stream_base.h"
+#include "uv.h"
+
+#ifndef _WIN32
+
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <vector>
+
+using node::StreamBase;
+
+namespace {
+
+struct ReadState {
+  ssize_t nread = 0;
+  int pending_count = 0;
+};
+
+void OnAlloc(uv_handle_t* handle, size_t suggested_size, uv_buf_t* buf) {
+  static char storage[64];
+  *buf = uv_buf_init(storage, sizeof(storage));
+}
+
+void OnRead(uv_stream_t* stream, ssize_t nread, const uv_buf_t* buf) {
+  if (nread == 0) return;
+  ReadState* state = static_cast<ReadState*>(stream->data);
+  state->nread = nread;
+  state->pending_count =
+      uv_pipe_pending_count(reinterpret_cast<uv_pipe_t*>(stream));
+  uv_read_stop(stream);
+}
+
+}  // namespace
+
+// Sends kMaxHandlesPerWrite descriptors in one SCM_RIGHTS message, the way
+// LibuvStreamWrap::DoTrySendHandles() does, and checks that libuv hands all
+// of them to the receiving IPC pipe.
+TEST(StreamHandlesTest, MaxHandlesPerWriteArrive) {
+  constexpr size_t kCount = StreamBase::kMaxHandlesPerWrite;
+  static_assert(kCount > 1);
+
+  int sv[2];
+  ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, sv), 0);
+
+  std::vector<int> fds;
+  for (size_t i = 0; i < kCount; i++) {
+    int fd = open("/dev/null", O_RDONLY);
+    ASSERT_GE(fd, 0);
+    fds.push_back(fd);
+  }
+
+  char byte = 1;
+  struct iovec iov;
+  iov.iov_base = &byte;
+  iov.iov_len = 1;
+  const size_t fds_size = kCount * sizeof(int);
+  std::vector<char> control(CMSG_SPACE(fds_size));
+  struct msghdr msg;
+  memset(&msg, 0, sizeof(msg));
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = control.data();
+  msg.msg_controllen = control.size();
+  struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+  cmsg->cmsg_level = SOL_SOCKET;
+  cmsg->cmsg_type = SCM_RIGHTS;
+  cmsg->cmsg_len = CMSG_LEN(fds_size);
+  memcpy(CMSG_DATA(cmsg), fds.data(), fds_size);
+  ASSERT_EQ(sendmsg(sv[0], &msg, 0), 1);
+  for (int fd : fds) close(fd);
+
+  uv_loop_t loop;
+  ASSERT_EQ(uv_loop_init(&loop), 0);
+  uv_pipe_t pipe;
+  ASSERT_EQ(uv_pipe_init(&loop, &pipe, 1), 0);
+  ASSERT_EQ(uv_pipe_open(&pipe, sv[1]), 0);
+  ReadState state;
+  pipe.data = &state;
+  ASSERT_EQ(uv_read_start(
+                reinterpret_cast<uv_stream_t*>(&pipe), OnAlloc, OnRead),
+            0);
+  uv_run(&loop, UV_RUN_DEFAULT);
+
+  EXPECT_EQ(state.nread, 1);
+  EXPECT_EQ(static_cast<size_t>(state.pending_count), kCount);
+
+  // Closing the pipe also closes the descriptors that were never accepted.
+  uv_close(reinterpret_cast<uv_handle_t*>(&pipe), nullptr);
+  uv_run(&loop, UV_RUN_DEFAULT);
+  EXPECT_EQ(uv_loop_close(&loop), 0);
+  close(sv[0]);
+}
+
+#endif  // _WIN32
@@ -0,0 +1,80 @@
+#include "nbytes.h"
+#include "string_bytes.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+using node::StringBytes;
+
+namespace {
+
+std::vector<char> MakeInput(size_t length) {
+  std::vector<char> data(length);
+  for (size_t i = 0; i < length; i++) data[i] = static_cast<char>(i * 131 + 7);
+  return data;
+}
+
+}  // namespace
+
+TEST(StringBytesTest, HexEncodeMatchesScalar) {
+  for (size_t length = 0; length < 200; length++) {
+    std::vector<char> input = MakeInput(length);
+    std::string expected = nbytes::HexEncode(input.data(), length);
+    std::string actual(length * 2, '\0');
+    EXPECT_EQ(
+        StringBytes::HexEncode(input.data(), length, actual.data(), length * 2),
+        length * 2);
+    EXPECT_EQ(actual, expected) << "length " << length;
+  }
+}
+
+TEST(StringBytesTest, HexDecodeRoundTrip) {
+  for (size_t length = 0; length < 200; length++) {
+    std::vector<char> input = MakeInput(length);
+    std::string hex = nbytes::HexEncode(input.data(), length);
+    // Exercise both cases of the letters.
+    if (length % 2 == 0) {
+      for (char& c : hex) c = static_cast<char>(toupper(c));
+    }
+    std::vector<char> output(length);
+    EXPECT_EQ(StringBytes::HexDecode(
+                  output.data(), length, hex.data(), hex.size()),
+              length);
+    EXPECT_EQ(output, input) << "length " << length;
+  }
+}
+
+TEST(StringBytesTest, HexDecodeStopsAtInvalidPair) {
+  std::vector<char> input = MakeInput(100);
+  std::string hex = nbytes::HexEncode(input.data(), input.size());
+  const char invalid[] = {'g', 'G', '/', ':', '@', '`', ' ', '\x80'};
+  for (size_t pos = 0; pos < hex.size(); pos += 7) {
+    for (char c : invalid) {
+      std::string broken = hex;
+      broken[pos] = c;
+      std::vector<char> output(input.size());
+      EXPECT_EQ(StringBytes::HexDecode(
+                    output.data(), output.size(), broken.data(), broken.size()),
+                pos / 2);
+      EXPECT_TRUE(std::equal(output.begin(),
+                             output.begin() + pos / 2,
+                             input.begin()));
+    }
+  }
+}
+
+TEST(StringBytesTest, HexDecodeRespectsBufferLength) {
+  std::vector<char> input = MakeInput(64);
+  std::string hex = nbytes::HexEncode(input.data(), input.size());
+  std::vector<char> output(64, 0);
+  EXPECT_EQ(StringBytes::HexDecode(output.data(), 20, hex.data(), hex.size()),
+            20u);
+  EXPECT_TRUE(std::equal(output.begin(), output.begin() + 20, input.begin()));
+  EXPECT_EQ(output[20], 0);
+  // An odd trailing digit is ignored.
+  EXPECT_EQ(StringBytes::HexDecode(output.data(), 64, hex.data(), 41), 20u);
+}
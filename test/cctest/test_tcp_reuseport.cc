@@ -0,0 +1,72 @@
+#include "env-inl.h"
+#include "gtest/gtest.h"
+#include "node_internals.h"
+#include "node_realm-inl.h"
+#include "node_test_fixture.h"
+#include "util-inl.h"
+#include "uv.h"
+
+// SO_REUSEPORT only balances the load of listening sockets on Linux.
+#ifdef __linux__
+
+using v8::Context;
+using v8::Function;
+using v8::Int32;
+using v8::Local;
+using v8::Script;
+using v8::Value;
+
+// Listens on a free port, then returns the result of listening on the same
+// port with a second server.
+static const char kListenTwiceScript[] =
+    "(function(internalBinding) {"
+    "  const { TCP, constants } = internalBinding('tcp_wrap');"
+    "  const first = new TCP(constants.SERVER);"
+    "  const err = first.bind('127.0.0.1', 0) || first.listen(16);"
+    "  if (err !== 0) throw new Error('listen failed: ' + err);"
+    "  const address = {};"
+    "  first.getsockname(address);"
+    "  const second = new TCP(constants.SERVER);"
+    "  const result ="
+    "    second.bind('127.0.0.1', address.port) || second.listen(16);"
+    "  first.close();"
+    "  second.close();"
+    "  return result;"
+    "})";
+
+class TCPReusePortTest : public EnvironmentTestFixture {
+ protected:
+  int ListenTwice(node::Environment* env) {
+    Local<Context> context = env->context();
+    Local<Value> fn =
+        Script::Compile(context,
+                        node::OneByteString(isolate_, kListenTwiceScript))
+            .ToLocalChecked()
+            ->Run(context)
+            .ToLocalChecked();
+    Local<Value> argv[] = {env->principal_realm()->internal_binding_loader()};
+    Local<Value> result =
+        fn.As<Function>()
+            ->Call(context, v8::Null(isolate_), node::arraysize(argv), argv)
+            .ToLocalChecked();
+    uv_run(&current_loop, UV_RUN_NOWAIT);
+    return result.As<Int32>()->Value();
+  }
+};
+
+TEST_F(TCPReusePortTest, SharesThePortOfAServer) {
+  const v8::HandleScope handle_scope(isolate_);
+  const Argv argv;
+  Env env{handle_scope, argv};
+  (*env)->options()->tcp_reuseport = true;
+  EXPECT_EQ(ListenTwice(*env), 0);
+}
+
+TEST_F(TCPReusePortTest, IsOffByDefault) {
+  const v8::HandleScope handle_scope(isolate_);
+  const Argv argv;
+  Env env{handle_scope, argv};
+  EXPECT_EQ(ListenTwice(*env), UV_EADDRINUSE);
+}
+
+#endif  // __linux__
@@ -0,0 +1,55 @@
+#include "gtest/gtest.h"
+#include "node_thread_stats.h"
+#include "uv.h"
+
+using node::thread_stats::ParseStat;
+using node::thread_stats::ParseStatus;
+using node::thread_stats::ThreadUsage;
+
+TEST(ThreadStatsTest, ParseStat) {
+  ThreadUsage usage;
+  // The name may contain spaces and parentheses.
+  EXPECT_TRUE(ParseStat("1234 (a (b) c) S 1 1234 1234 0 -1 4194560 100 0 0 0 "
+                        "250 50 0 0 20 0 1 0\n",
+                        100,
+                        &usage));
+  EXPECT_EQ(usage.user, 2500000);
+  EXPECT_EQ(usage.system, 500000);
+
+  for (const char* stat : {"", "1234 (name", "1234 (name) S 1 2 3"}) {
+    EXPECT_FALSE(ParseStat(stat, 100, &usage)) << stat;
+  }
+}
+
+TEST(ThreadStatsTest, ParseStatus) {
+  ThreadUsage usage;
+  EXPECT_TRUE(ParseStatus("Name:\tnode\nState:\tS (sleeping)\n"
+                          "voluntary_ctxt_switches:\t12\n"
+                          "nonvoluntary_ctxt_switches:\t3\n",
+                          &usage));
+  EXPECT_EQ(usage.voluntary_switches, 12);
+  EXPECT_EQ(usage.involuntary_switches, 3);
+
+  EXPECT_FALSE(ParseStatus("Name:\tnode\n", &usage));
+  EXPECT_FALSE(ParseStatus("voluntary_ctxt_switches:\tx\n", &usage));
+}
+
+TEST(ThreadStatsTest, GetUsageByKind) {
+  std::array<ThreadUsage, node::thread_stats::kThreadKindCount> usage;
+  int err = node::thread_stats::GetUsageByKind(&usage);
+  if (err == UV_ENOSYS) GTEST_SKIP() << "Thread statistics are not supported";
+  ASSERT_EQ(err, 0);
+
+  node::thread_stats::SetCurrentThreadKind(node::thread_stats::kWorkerThread);
+  std::array<ThreadUsage, node::thread_stats::kThreadKindCount> marked;
+  ASSERT_EQ(node::thread_stats::GetUsageByKind(&marked), 0);
+  node::thread_stats::ClearCurrentThreadKind();
+  EXPECT_EQ(marked[node::thread_stats::kWorkerThread].threads,
+            usage[node::thread_stats::kWorkerThread].threads + 1);
+
+  ThreadUsage self;
+  EXPECT_EQ(node::thread_stats::GetThreadUsage(
+                node::thread_stats::GetCurrentThreadId(), &self),
+            0);
+  EXPECT_EQ(self.threads, 1);
+}
@@ -0,0 +1,195 @@
+#include "threadpool_limiter.h"
+#include "gtest/gtest.h"
+#include "histogram-inl.h"
+#include "util-inl.h"
+#include "uv.h"
+
+#include <vector>
+
+using node::ThreadPoolWorkBudget;
+using node::ThreadPoolWorkClass;
+using node::ThreadPoolWorkHistogram;
+using node::ThreadPoolWorkLimiter;
+
+namespace {
+
+class TestWork : public ThreadPoolWorkLimiter::Work {
+ public:
+  explicit TestWork(std::vector<TestWork*>* submitted, int status = 0)
+      : submitted_(submitted), status_(status) {}
+
+  int SubmitWork() override {
+    submitted_->push_back(this);
+    return status_;
+  }
+
+  void OnSubmitError(int status) override { submit_error_ = status; }
+
+  int submit_error() const { return submit_error_; }
+
+ private:
+  std::vector<TestWork*>* submitted_;
+  int status_;
+  int submit_error_ = 0;
+};
+
+}  // namespace
+
+TEST(ThreadPoolWorkLimiterTest, UnlimitedByDefault) {
+  ThreadPoolWorkLimiter limiter;
+  std::vector<TestWork*> submitted;
+  TestWork a(&submitted), b(&submitted);
+  EXPECT_EQ(limiter.Schedule(ThreadPoolWorkClass::kCrypto, &a), 0);
+  EXPECT_EQ(limiter.Schedule(ThreadPoolWorkClass::kCrypto, &b), 0);
+  EXPECT_EQ(submitted.size(), 2u);
+  EXPECT_EQ(limiter.running(ThreadPoolWorkClass::kCrypto), 2u);
+  EXPECT_EQ(limiter.queued(ThreadPoolWorkClass::kCrypto), 0u);
+}
+
+TEST(ThreadPoolWorkLimiterTest, QueuesWorkAboveTheLimit) {
+  ThreadPoolWorkLimiter limiter;
+  limiter.SetLimit(ThreadPoolWorkClass::kCrypto, 1);
+  std::vector<TestWork*> submitted;
+  TestWork a(&submitted), b(&submitted), c(&submitted), dns(&submitted);
+  limiter.Schedule(ThreadPoolWorkClass::kCrypto, &a);
+  limiter.Schedule(ThreadPoolWorkClass::kCrypto, &b);
+  limiter.Schedule(ThreadPoolWorkClass::kCrypto, &c);
+  // Other classes are not affected by the crypto limit.
+  limiter.Schedule(ThreadPoolWorkClass::kDns, &dns);
+  EXPECT_EQ(submitted, (std::vector<TestWork*>{&a, &dns}));
+  EXPECT_EQ(limiter.queued(ThreadPoolWorkClass::kCrypto), 2u);
+
+  EXPECT_TRUE(limiter.Unqueue(ThreadPoolWorkClass::kCrypto, &c));
+  EXPECT_FALSE(limiter.Unqueue(ThreadPoolWorkClass::kCrypto, &a));
+
+  limiter.Finish(ThreadPoolWorkClass::kCrypto, &a);
+  EXPECT_EQ(submitted, (std::vector<TestWork*>{&a, &dns, &b}));
+  EXPECT_EQ(limiter.running(ThreadPoolWorkClass::kCrypto), 1u);
+  EXPECT_EQ(limiter.queued(ThreadPoolWorkClass::kCrypto), 0u);
+}
+
+TEST(ThreadPoolWorkLimiterTest, ReportsErrorsOfQueuedWork) {
+  ThreadPoolWorkLimiter limiter;
+  limiter.SetLimit(ThreadPoolWorkClass::kDns, 1);
+  std::vector<TestWork*> submitted;
+  TestWork a(&submitted), failing(&submitted, -1), b(&submitted);
+  limiter.Schedule(ThreadPoolWorkClass::kDns, &a);
+  limiter.Schedule(ThreadPoolWorkClass::kDns, &failing);
+  limiter.Schedule(ThreadPoolWorkClass::kDns, &b);
+
+  // The failing work gives its slot to the next one.
+  limiter.Finish(ThreadPoolWorkClass::kDns, &a);
+  EXPECT_EQ(failing.submit_error(), -1);
+  EXPECT_EQ(submitted, (std::vector<TestWork*>{&a, &failing, &b}));
+  EXPECT_EQ(limiter.running(ThreadPoolWorkClass::kDns), 1u);
+}
+
+TEST(ThreadPoolWorkLimiterTest, CancelsQueuedWork) {
+  ThreadPoolWorkLimiter limiter;
+  limiter.SetLimit(ThreadPoolWorkClass::kCrypto, 1);
+  std::vector<TestWork*> submitted;
+  TestWork a(&submitted), b(&submitted);
+  auto deleted = std::make_unique<TestWork>(&submitted);
+  limiter.Schedule(ThreadPoolWorkClass::kCrypto, &a);
+  limiter.Schedule(ThreadPoolWorkClass::kCrypto, &b);
+  limiter.Schedule(ThreadPoolWorkClass::kCrypto, deleted.get());
+  EXPECT_FALSE(limiter.Cancel(ThreadPoolWorkClass::kCrypto, &a));
+  EXPECT_TRUE(limiter.Cancel(ThreadPoolWorkClass::kCrypto, &b));
+  EXPECT_TRUE(limiter.Cancel(ThreadPoolWorkClass::kCrypto, deleted.get()));
+  EXPECT_EQ(limiter.queued(ThreadPoolWorkClass::kCrypto), 0u);
+  EXPECT_EQ(b.submit_error(), 0);
+
+  // Work that is deleted before the cancellation is completed is forgotten.
+  deleted.reset();
+  limiter.CompleteCancelled();
+  EXPECT_EQ(b.submit_error(), UV_ECANCELED);
+  EXPECT_EQ(submitted, (std::vector<TestWork*>{&a}));
+}
+
+TEST(ThreadPoolWorkLimiterTest, CancelQueuedStopsLimiting) {
+  ThreadPoolWorkLimiter limiter;
+  limiter.SetLimit(ThreadPoolWorkClass::kZlib, 1);
+  std::vector<TestWork*> submitted;
+  TestWork a(&submitted), b(&submitted), c(&submitted);
+  limiter.Schedule(ThreadPoolWorkClass::kZlib, &a);
+  limiter.Schedule(ThreadPoolWorkClass::kZlib, &b);
+  limiter.CancelQueued();
+  EXPECT_EQ(b.submit_error(), UV_ECANCELED);
+  EXPECT_EQ(limiter.queued(ThreadPoolWorkClass::kZlib), 0u);
+
+  // Work scheduled during teardown does not wait for a slot.
+  limiter.Schedule(ThreadPoolWorkClass::kZlib, &c);
+  EXPECT_EQ(submitted, (std::vector<TestWork*>{&a, &c}));
+  EXPECT_EQ(limiter.running(ThreadPoolWorkClass::kZlib), 2u);
+}
+
+TEST(ThreadPoolWorkLimiterTest, SharesTheBudget) {
+  ThreadPoolWorkBudget budget;
+  budget.SetLimit(ThreadPoolWorkClass::kDns, 1);
+  int wakeups = 0;
+  ThreadPoolWorkLimiter first(&budget, []() {});
+  ThreadPoolWorkLimiter second(&budget, [&]() { wakeups++; });
+  std::vector<TestWork*> submitted;
+  TestWork a(&submitted), b(&submitted);
+  first.Schedule(ThreadPoolWorkClass::kDns, &a);
+  second.Schedule(ThreadPoolWorkClass::kDns, &b);
+  EXPECT_EQ(submitted, (std::vector<TestWork*>{&a}));
+  EXPECT_EQ(second.queued(ThreadPoolWorkClass::kDns), 1u);
+
+  // The slot that the first limiter releases goes to the second one, once
+  // it has been woken up.
+  first.Finish(ThreadPoolWorkClass::kDns, &a);
+  EXPECT_EQ(wakeups, 1);
+  EXPECT_EQ(submitted, (std::vector<TestWork*>{&a}));
+  second.SubmitQueued();
+  EXPECT_EQ(submitted, (std::vector<TestWork*>{&a, &b}));
+  EXPECT_EQ(second.running(ThreadPoolWorkClass::kDns), 1u);
+  EXPECT_EQ(first.limit(ThreadPoolWorkClass::kDns), 1u);
+}
+
+TEST(ThreadPoolWorkLimiterTest, FsIsNeverLimited) {
+  ThreadPoolWorkLimiter limiter;
+  limiter.SetLimit(ThreadPoolWorkClass::kFs, 1);
+  EXPECT_EQ(limiter.limit(ThreadPoolWorkClass::kFs), 0u);
+}
+
+TEST(ThreadPoolWorkLimiterTest, RecordsMetricsOnceEnabled) {
+  ThreadPoolWorkLimiter limiter;
+  std::vector<TestWork*> submitted;
+  TestWork before(&submitted), after(&submitted);
+  limiter.Schedule(ThreadPoolWorkClass::kZlib, &before);
+  EXPECT_FALSE(limiter.metrics_enabled());
+  EXPECT_EQ(before.schedule_time(), 0u);
+
+  std::shared_ptr<node::Histogram> latency = limiter.histogram(
+      ThreadPoolWorkClass::kZlib, ThreadPoolWorkHistogram::kLatency);
+  EXPECT_TRUE(limiter.metrics_enabled());
+  limiter.Schedule(ThreadPoolWorkClass::kZlib, &after);
+  EXPECT_NE(after.schedule_time(), 0u);
+
+  // Work that was scheduled before metrics were enabled is not recorded.
+  limiter.Finish(ThreadPoolWorkClass::kZlib, &before);
+  EXPECT_EQ(latency->Count(), 0u);
+  limiter.Finish(ThreadPoolWorkClass::kZlib, &after);
+  EXPECT_EQ(latency->Count(), 1u);
+
+  uint64_t start = after.schedule_time() + 5000000;
+  limiter.RecordRunTimes(ThreadPoolWorkClass::kZlib,
+                         after.schedule_time(),
+                         start,
+                         start + 2000000);
+  std::shared_ptr<node::Histogram> wait = limiter.histogram(
+      ThreadPoolWorkClass::kZlib, ThreadPoolWorkHistogram::kWait);
+  std::shared_ptr<node::Histogram> run = limiter.histogram(
+      ThreadPoolWorkClass::kZlib, ThreadPoolWorkHistogram::kRun);
+  EXPECT_EQ(wait->Count(), 1u);
+  EXPECT_NEAR(wait->Max(), 5000000, 5000);
+  EXPECT_EQ(run->Count(), 1u);
+  EXPECT_NEAR(run->Max(), 2000000, 2000);
+  // Classes have separate histograms.
+  EXPECT_EQ(limiter
+                .histogram(ThreadPoolWorkClass::kCrypto,
+                           ThreadPoolWorkHistogram::kWait)
+                ->Count(),
+            0u);
+}
@@ -0,0 +1,113 @@
+#include "gtest/gtest.h"
+#include "timer_wheel.h"
+#include "util-inl.h"
+
+#include <algorithm>
+#include <vector>
+
+using node::timers::TimerWheel;
+
+namespace {
+
+struct TestTimer : public TimerWheel::Entry {
+  int id = 0;
+};
+
+std::vector<int> Advance(TimerWheel* wheel, uint64_t now) {
+  std::vector<TimerWheel::Entry*> expired;
+  wheel->Advance(now, &expired);
+  std::vector<int> ids;
+  for (TimerWheel::Entry* entry : expired) {
+    EXPECT_FALSE(entry->scheduled());
+    ids.push_back(static_cast<TestTimer*>(entry)->id);
+  }
+  return ids;
+}
+
+}  // namespace
+
+TEST(TimerWheelTest, ExpiresInOrder) {
+  TimerWheel wheel(1000);
+  TestTimer timers[4];
+  // One timer per level of the wheel that is used, plus one that is due.
+  const uint64_t delays[] = {5, 100, 5000, 0};
+  for (int i = 0; i < 4; i++) {
+    timers[i].id = i;
+    wheel.Schedule(&timers[i], 1000 + delays[i]);
+  }
+  EXPECT_EQ(wheel.size(), 4u);
+  EXPECT_EQ(wheel.NextWakeup(), 1000u);
+
+  EXPECT_EQ(Advance(&wheel, 1000), std::vector<int>({3}));
+  EXPECT_EQ(Advance(&wheel, 1004), std::vector<int>());
+  EXPECT_EQ(Advance(&wheel, 1005), std::vector<int>({0}));
+  EXPECT_LE(wheel.NextWakeup(), 1100u);
+  // Skipping ahead fires everything in between, in order.
+  EXPECT_EQ(Advance(&wheel, 100000), std::vector<int>({1, 2}));
+  EXPECT_TRUE(wheel.empty());
+  EXPECT_EQ(wheel.NextWakeup(), 0u);
+  EXPECT_EQ(wheel.now(), 100000u);
+}
+
+TEST(TimerWheelTest, RescheduleAndCancel) {
+  TimerWheel wheel(0);
+  TestTimer a, b;
+  a.id = 1;
+  b.id = 2;
+  wheel.Schedule(&a, 10);
+  wheel.Schedule(&b, 20);
+
+  // Refreshing a timer moves it, even to another level.
+  wheel.Schedule(&a, 30);
+  wheel.Schedule(&a, 300000);
+  EXPECT_EQ(a.expiry(), 300000u);
+  EXPECT_EQ(wheel.size(), 2u);
+
+  wheel.Cancel(&b);
+  EXPECT_FALSE(b.scheduled());
+  wheel.Cancel(&b);
+  EXPECT_EQ(wheel.size(), 1u);
+  EXPECT_EQ(Advance(&wheel, 299999), std::vector<int>());
+  EXPECT_TRUE(a.scheduled());
+  EXPECT_EQ(Advance(&wheel, 300000), std::vector<int>({1}));
+}
+
+TEST(TimerWheelTest, NextWakeupIsNeverLate) {
+  TimerWheel wheel(123456);
+  std::vector<TestTimer> timers(1000);
+  uint64_t earliest = UINT64_MAX;
+  for (size_t i = 0; i < timers.size(); i++) {
+    uint64_t expiry = 123456 + 1 + (i * 7919) % 10000000;
+    timers[i].id = static_cast<int>(i);
+    wheel.Schedule(&timers[i], expiry);
+    earliest = std::min(earliest, expiry);
+  }
+
+  size_t fired = 0;
+  uint64_t last = 0;
+  while (!wheel.empty()) {
+    uint64_t wakeup = wheel.NextWakeup();
+    ASSERT_LE(wakeup, earliest);
+    std::vector<TimerWheel::Entry*> expired;
+    wheel.Advance(wakeup, &expired);
+    for (TimerWheel::Entry* entry : expired) {
+      EXPECT_EQ(entry->expiry(), wakeup);
+      EXPECT_GE(entry->expiry(), last);
+      last = entry->expiry();
+    }
+    fired += expired.size();
+    earliest = UINT64_MAX;
+    for (const TestTimer& timer : timers) {
+      if (timer.scheduled()) earliest = std::min(earliest, timer.expiry());
+    }
+  }
+  EXPECT_EQ(fired, timers.size());
+}
+
+TEST(TimerWheelTest, ClampsLongDelays) {
+  TimerWheel wheel(0);
+  TestTimer timer;
+  wheel.Schedule(&timer, UINT64_MAX);
+  EXPECT_EQ(timer.expiry(), TimerWheel::kMaxDelay);
+  EXPECT_EQ(Advance(&wheel, TimerWheel::kMaxDelay).size(), 1u);
+}
@@ -0,0 +1,357 @@
+#include "env-inl.h"
+#include "gtest/gtest.h"
+#include "node_realm-inl.h"
+#include "node_test_fixture.h"
+#include "udp_wrap.h"
+#include "util-inl.h"
+#include "uv.h"
+
+#ifndef _WIN32
+#include <poll.h>
+#include <sys/socket.h>
+
+#include <string>
+#include <vector>
+
+using node::TrySendSegmented;
+using v8::Context;
+using v8::Function;
+using v8::Local;
+using v8::Object;
+using v8::Script;
+using v8::Value;
+
+namespace {
+
+// Two UDP sockets bound to the loopback interface.
+class LoopbackPair {
+ public:
+  LoopbackPair() {
+    EXPECT_EQ(uv_loop_init(&loop_), 0);
+    sockaddr_in any;
+    EXPECT_EQ(uv_ip4_addr("127.0.0.1", 0, &any), 0);
+    for (uv_udp_t* handle : {&sender_, &receiver_}) {
+      EXPECT_EQ(uv_udp_init(&loop_, handle), 0);
+      EXPECT_EQ(uv_udp_bind(handle, reinterpret_cast<sockaddr*>(&any), 0), 0);
+    }
+    int len = sizeof(receiver_addr_);
+    EXPECT_EQ(uv_udp_getsockname(&receiver_,
+                                 reinterpret_cast<sockaddr*>(&receiver_addr_),
+                                 &len),
+              0);
+  }
+
+  ~LoopbackPair() {
+    uv_close(reinterpret_cast<uv_handle_t*>(&sender_), nullptr);
+    uv_close(reinterpret_cast<uv_handle_t*>(&receiver_), nullptr);
+    uv_run(&loop_, UV_RUN_DEFAULT);
+    EXPECT_EQ(uv_loop_close(&loop_), 0);
+  }
+
+  int Send(std::vector<std::string>* datagrams) {
+    std::vector<uv_buf_t> bufs;
+    std::vector<uv_buf_t*> buf_ptrs;
+    std::vector<unsigned int> nbufs;
+    std::vector<sockaddr*> addrs;
+    bufs.reserve(datagrams->size());
+    for (std::string& datagram : *datagrams) {
+      bufs.push_back(uv_buf_init(datagram.data(), datagram.size()));
+      buf_ptrs.push_back(&bufs.back());
+      nbufs.push_back(1);
+      addrs.push_back(reinterpret_cast<sockaddr*>(&receiver_addr_));
+    }
+    return TrySendSegmented(&sender_,
+                            buf_ptrs.data(),
+                            nbufs.data(),
+                            addrs.data(),
+                            datagrams->size());
+  }
+
+  // Queues a datagram with uv_udp_send(). It stays in the send queue of the
+  // handle until RunLoop() has run its callback.
+  int SendQueued(std::string* datagram) {
+    uv_buf_t buf = uv_buf_init(datagram->data(), datagram->size());
+    return uv_udp_send(&send_req_,
+                       &sender_,
+                       &buf,
+                       1,
+                       reinterpret_cast<sockaddr*>(&receiver_addr_),
+                       nullptr);
+  }
+
+  void RunLoop() { uv_run(&loop_, UV_RUN_NOWAIT); }
+
+  // Reads the datagrams that arrive within a short time.
+  std::vector<std::string> Receive() {
+    uv_os_fd_t fd;
+    EXPECT_EQ(uv_fileno(reinterpret_cast<uv_handle_t*>(&receiver_), &fd), 0);
+    std::vector<std::string> datagrams;
+    pollfd pfd = {fd, POLLIN, 0};
+    while (poll(&pfd, 1, 200) == 1) {
+      char buf[65536];
+      ssize_t n = recv(fd, buf, sizeof(buf), MSG_DONTWAIT);
+      if (n < 0) break;
+      datagrams.emplace_back(buf, n);
+    }
+    return datagrams;
+  }
+
+ private:
+  uv_loop_t loop_;
+  uv_udp_t sender_;
+  uv_udp_t receiver_;
+  uv_udp_send_t send_req_;
+  sockaddr_in receiver_addr_;
+};
+
+}  // namespace
+
+TEST(UDPBatchTest, SegmentedSendDeliversSeparateDatagrams) {
+  LoopbackPair pair;
+  // All but the last datagram have the same size.
+  std::vector<std::string> datagrams = {
+      std::string(100, 'a'), std::string(100, 'b'), std::string(40, 'c')};
+  int r = pair.Send(&datagrams);
+  if (r == UV_ENOSYS) {
+    // The platform, or the kernel, does not support UDP_SEGMENT.
+    EXPECT_TRUE(pair.Receive().empty());
+    return;
+  }
+  ASSERT_EQ(r, 3);
+  EXPECT_EQ(pair.Receive(), datagrams);
+}
+
+TEST(UDPBatchTest, SegmentedSendRejectsUnevenBatches) {
+  LoopbackPair pair;
+  std::vector<std::string> uneven = {std::string(40, 'a'),
+                                     std::string(100, 'b')};
+  std::vector<std::string> single = {std::string(40, 'a')};
+  int r = pair.Send(&uneven);
+  EXPECT_TRUE(r == UV_ENOTSUP || r == UV_ENOSYS) << r;
+  r = pair.Send(&single);
+  EXPECT_TRUE(r == UV_ENOTSUP || r == UV_ENOSYS) << r;
+  EXPECT_TRUE(pair.Receive().empty());
+}
+
+TEST(UDPBatchTest, SegmentedSendRejectsOversizedBatches) {
+  LoopbackPair pair;
+  std::vector<std::string> many(65, std::string(10, 'a'));
+  int r = pair.Send(&many);
+  EXPECT_TRUE(r == UV_ENOTSUP || r == UV_ENOSYS) << r;
+  std::vector<std::string> large(2, std::string(40000, 'b'));
+  r = pair.Send(&large);
+  EXPECT_TRUE(r == UV_ENOTSUP || r == UV_ENOSYS) << r;
+  EXPECT_TRUE(pair.Receive().empty());
+}
+
+TEST(UDPBatchTest, SegmentedSendWaitsForQueuedSends) {
+  LoopbackPair pair;
+  std::string first(20, 'q');
+  ASSERT_EQ(pair.SendQueued(&first), 0);
+  std::vector<std::string> datagrams = {std::string(100, 'a'),
+                                        std::string(100, 'b')};
+  // The batch must not overtake the datagram in the send queue.
+  int r = pair.Send(&datagrams);
+  EXPECT_TRUE(r == UV_ENOTSUP || r == UV_ENOSYS) << r;
+  pair.RunLoop();
+  r = pair.Send(&datagrams);
+  std::vector<std::string> expected = {first};
+  if (r != UV_ENOSYS) {
+    ASSERT_EQ(r, 2);
+    expected.insert(expected.end(), datagrams.begin(), datagrams.end());
+  }
+  EXPECT_EQ(pair.Receive(), expected);
+}
+
+// Binds a receiver with UV_UDP_RECVMMSG and a sender to `state.host`, with
+// `state.bind` being 'bind' or 'bind6'. Each datagram that arrives is noted
+// in `state.received` as `<length><first byte>@<sender port>`, then `/b` if
+// it came through onmessagebatch() as a view into the same ArrayBuffer as
+// the rest of its batch, or `/x` if not. Returns the bind errors.
+static const char kSetupScript[] =
+    "(function(internalBinding, state) {"
+    "  const { UDP, constants } = internalBinding('udp_wrap');"
+    "  state.receiver = new UDP(constants.UV_UDP_RECVMMSG);"
+    "  state.sender = new UDP();"
+    "  const errors = [state.receiver[state.bind](state.host, 0, 0),"
+    "                  state.sender[state.bind](state.host, 0, 0)];"
+    "  if (errors.some((err) => err !== 0)) return errors.join(',');"
+    "  const name = {};"
+    "  state.receiver.getsockname(name);"
+    "  state.port = name.port;"
+    "  state.sender.getsockname(name);"
+    "  state.senderPort = name.port;"
+    "  state.received = [];"
+    "  const note = (buf, rinfo, how) => state.received.push("
+    "    `${buf.length}${String.fromCharCode(buf[0])}@${rinfo.port}${how}`);"
+    "  state.receiver.onmessage = (nread, handle, buf, rinfo) => {"
+    "    if (nread >= 0) note(buf, rinfo, '');"
+    "  };"
+    "  state.receiver.onmessagebatch = (count, handle, buffers, addrs) => {"
+    "    const shared = count === buffers.length &&"
+    "      buffers.every((buf) => buf.buffer === buffers[0].buffer);"
+    "    for (let i = 0; i < buffers.length; i++)"
+    "      note(buffers[i], addrs[i], shared ? '/b' : '/x');"
+    "  };"
+    "  state.receiver.recvStart();"
+    "  return '0,0';"
+    "})";
+
+// Sends the datagrams of `state.sizes`, each filled with a different letter,
+// through `state.send`, and returns the number that went out.
+static const char kSendScript[] =
+    "(function(internalBinding, state) {"
+    "  const list = state.sizes.map((size, i) =>"
+    "    new Uint8Array(size).fill(97 + i));"
+    "  const ports = list.map(() => state.port);"
+    "  const hosts = list.map(() => state.host);"
+    "  return String(state.sender[state.send](list, ports, hosts));"
+    "})";
+
+static std::string Expected(const std::vector<int>& sizes,
+                            const std::string& sender_port) {
+  std::string expected;
+  for (size_t i = 0; i < sizes.size(); i++) {
+    if (i > 0) expected += ",";
+    expected += std::to_string(sizes[i]) + static_cast<char>('a' + i) + "@" +
+                sender_port + "/b";
+  }
+  return expected;
+}
+
+class UDPBatchEnvTest : public EnvironmentTestFixture {
+ protected:
+  std::string Run(node::Environment* env,
+                  Local<Object> state,
+                  const char* source) {
+    Local<Context> context = env->context();
+    Local<Value> fn;
+    EXPECT_TRUE(Script::Compile(context, node::OneByteString(isolate_, source))
+                    .ToLocalChecked()
+                    ->Run(context)
+                    .ToLocal(&fn));
+    Local<Value> argv[] = {
+        env->principal_realm()->internal_binding_loader(),
+        state,
+    };
+    Local<Value> result;
+    EXPECT_TRUE(
+        fn.As<Function>()
+            ->Call(context, v8::Null(isolate_), node::arraysize(argv), argv)
+            .ToLocal(&result));
+    return *node::Utf8Value(isolate_, result);
+  }
+
+  // Runs the loop until `state.received` holds `count` datagrams, or for
+  // about a second.
+  std::string Await(node::Environment* env, Local<Object> state, int count) {
+    std::string received;
+    for (int i = 0; i < 1000; i++) {
+      uv_run(&current_loop, UV_RUN_NOWAIT);
+      received = Run(env,
+                     state,
+                     "(function(internalBinding, state) {"
+                     "  return state.received.join(',');"
+                     "})");
+      if (Run(env,
+              state,
+              "(function(internalBinding, state) {"
+              "  return String(state.received.length);"
+              "})") == std::to_string(count)) {
+        break;
+      }
+      uv_sleep(1);
+    }
+    return received;
+  }
+
+  // Sends the datagrams through `send`, and checks that they all arrive in
+  // batches of the receiver.
+  void TestSendBatch(node::Environment* env,
+                     const char* bind,
+                     const char* send,
+                     const char* host,
+                     const char* sizes_js,
+                     const std::vector<int>& sizes) {
+    Local<Object> state = Object::New(isolate_);
+    Local<Context> context = env->context();
+    auto set = [&](const char* key, const char* value) {
+      state
+          ->Set(context,
+                node::OneByteString(isolate_, key),
+                node::OneByteString(isolate_, value))
+          .Check();
+    };
+    set("bind", bind);
+    set("send", send);
+    set("host", host);
+    if (Run(env, state, kSetupScript) != "0,0") {
+      // No IPv6 loopback in this environment.
+      EXPECT_EQ(std::string(bind), "bind6");
+      return;
+    }
+    Run(env,
+        state,
+        (std::string("(function(internalBinding, state) {"
+                     "  state.sizes = ") +
+         sizes_js + "; return ''; })")
+            .c_str());
+    EXPECT_EQ(Run(env, state, kSendScript), std::to_string(sizes.size()));
+    const std::string sender_port = Run(env,
+                                        state,
+                                        "(function(internalBinding, state) {"
+                                        "  return String(state.senderPort);"
+                                        "})");
+    EXPECT_EQ(Await(env, state, sizes.size()), Expected(sizes, sender_port));
+    Run(env,
+        state,
+        "(function(internalBinding, state) {"
+        "  state.receiver.close();"
+        "  state.sender.close();"
+        "  return '';"
+        "})");
+    uv_run(&current_loop, UV_RUN_NOWAIT);
+  }
+};
+
+// Datagrams of the same size take the UDP_SEGMENT path where the kernel has
+// it, and uneven ones go through sendmmsg(). Both arrive as batches.
+TEST_F(UDPBatchEnvTest, SendBatchToRecvmmsgReceiver) {
+  const v8::HandleScope handle_scope(isolate_);
+  Argv argv;
+  Env env{handle_scope, argv};
+
+  TestSendBatch(*env,
+                "bind",
+                "sendBatch",
+                "127.0.0.1",
+                "[1200, 1200, 1200, 500]",
+                {1200, 1200, 1200, 500});
+  TestSendBatch(*env,
+                "bind",
+                "sendBatch",
+                "127.0.0.1",
+                "[10, 3000, 1, 700]",
+                {10, 3000, 1, 700});
+}
+
+TEST_F(UDPBatchEnvTest, SendBatch6ToRecvmmsgReceiver) {
+  const v8::HandleScope handle_scope(isolate_);
+  Argv argv;
+  Env env{handle_scope, argv};
+
+  TestSendBatch(*env,
+                "bind6",
+                "sendBatch6",
+                "::1",
+                "[1200, 1200, 300]",
+                {1200, 1200, 300});
+  TestSendBatch(*env,
+                "bind6",
+                "sendBatch6",
+                "::1",
+                "[5, 2000]",
+                {5, 2000});
+}
+
+#endif  // _WIN32
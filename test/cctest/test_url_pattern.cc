@@ -0,0 +1,54 @@
+#include "env-inl.h"
+#include "gtest/gtest.h"
+#include "node_test_fixture.h"
+#include "node_url_pattern.h"
+
+using node::Environment;
+using node::url_pattern::RegExpCache;
+using node::url_pattern::URLPatternRegexProvider;
+using v8::HandleScope;
+using v8::Local;
+using v8::RegExp;
+
+class URLPatternTest : public EnvironmentTestFixture {};
+
+TEST_F(URLPatternTest, RegExpCache) {
+  const HandleScope handle_scope(isolate_);
+  const Argv argv;
+  Env env{handle_scope, argv};
+  RegExpCache* cache = (*env)->url_pattern_regexp_cache();
+  size_t size = cache->size();
+  uint64_t hits = cache->hits();
+  uint64_t misses = cache->misses();
+
+  auto first = URLPatternRegexProvider::create_instance("^/cached/(\\d+)$",
+                                                        false);
+  auto second = URLPatternRegexProvider::create_instance("^/cached/(\\d+)$",
+                                                         false);
+  auto ignore_case =
+      URLPatternRegexProvider::create_instance("^/cached/(\\d+)$", true);
+  ASSERT_TRUE(first && second && ignore_case);
+
+  // Instances share the compiled regular expression of the same source and
+  // flags, but not of different flags.
+  Local<RegExp> first_regexp = first->Get(isolate_);
+  EXPECT_TRUE(first_regexp->StrictEquals(second->Get(isolate_)));
+  EXPECT_FALSE(first_regexp->StrictEquals(ignore_case->Get(isolate_)));
+  EXPECT_EQ(cache->size(), size + 2);
+  EXPECT_EQ(cache->hits(), hits + 1);
+  EXPECT_EQ(cache->misses(), misses + 2);
+
+  EXPECT_TRUE(URLPatternRegexProvider::regex_match("/cached/42", *first));
+  EXPECT_FALSE(URLPatternRegexProvider::regex_match("/CACHED/42", *second));
+  EXPECT_TRUE(
+      URLPatternRegexProvider::regex_match("/CACHED/42", *ignore_case));
+
+  // Invalid patterns are not cached.
+  v8::TryCatch try_catch(isolate_);
+  EXPECT_FALSE(URLPatternRegexProvider::create_instance("(", false));
+  EXPECT_TRUE(try_catch.HasCaught());
+  EXPECT_EQ(cache->size(), size + 2);
+
+  cache->Clear();
+  EXPECT_EQ(cache->size(), 0u);
+}
@@ -0,0 +1,208 @@
+#include "env-inl.h"
+#include "gtest/gtest.h"
+#include "node.h"
+#include "node_realm-inl.h"
+#include "node_test_fixture.h"
+#include "util-inl.h"
+#include "uv.h"
+
+#ifndef _WIN32
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+using v8::Context;
+using v8::Function;
+using v8::Local;
+using v8::Object;
+using v8::Script;
+using v8::String;
+using v8::Value;
+
+class WebStorageTest : public EnvironmentTestFixture {
+ protected:
+  void SetUp() override {
+    EnvironmentTestFixture::SetUp();
+    char path[] = "/tmp/node-webstorage-test-XXXXXX";
+    ASSERT_NE(mkdtemp(path), nullptr);
+    dir_ = path;
+    path_ = dir_ + "/storage.db";
+    // Keeps the loop running while the flush timer, which is unref'd, is
+    // pending.
+    ASSERT_EQ(uv_timer_init(&current_loop, &keepalive_), 0);
+  }
+
+  void TearDown() override {
+    uv_close(reinterpret_cast<uv_handle_t*>(&keepalive_), nullptr);
+    uv_run(&current_loop, UV_RUN_DEFAULT);
+    for (const char* suffix : {"", "-wal", "-shm"}) {
+      std::remove((path_ + suffix).c_str());
+    }
+    rmdir(dir_.c_str());
+    EnvironmentTestFixture::TearDown();
+  }
+
+  // Calls `source`, a function expression, with the internalBinding loader,
+  // `state` and the path of the database, and returns its result as a string.
+  std::string Run(node::Environment* env,
+                  Local<Object> state,
+                  const char* source) {
+    Local<Context> context = env->context();
+    Local<Value> fn;
+    EXPECT_TRUE(Script::Compile(context, node::OneByteString(isolate_, source))
+                    .ToLocalChecked()
+                    ->Run(context)
+                    .ToLocal(&fn));
+    Local<Value> argv[] = {
+        env->principal_realm()->internal_binding_loader(),
+        state,
+        String::NewFromUtf8(isolate_, path_.c_str()).ToLocalChecked(),
+    };
+    Local<Value> result;
+    EXPECT_TRUE(
+        fn.As<Function>()
+            ->Call(context, v8::Null(isolate_), node::arraysize(argv), argv)
+            .ToLocal(&result));
+    return *node::Utf8Value(isolate_, result);
+  }
+
+  // Runs the loop for about `ms` milliseconds.
+  void RunLoop(uint64_t ms) {
+    uv_timer_start(&keepalive_, [](uv_timer_t*) {}, ms, 0);
+    uv_run(&current_loop, UV_RUN_DEFAULT);
+  }
+
+  std::string dir_;
+  std::string path_;
+  uv_timer_t keepalive_;
+};
+
+// Opens a storage and a separate connection to its database.
+static const char kOpenScript[] =
+    "(function(internalBinding, state, path) {"
+    "  const { Storage, kConstructorKey } = internalBinding('webstorage');"
+    "  const { DatabaseSync } = internalBinding('sqlite');"
+    "  state.storage = new Storage(kConstructorKey, path);"
+    "  state.storage.getItem('');"
+    "  state.db = new DatabaseSync(path);"
+    "  state.rows = () => state.db.prepare("
+    "    'SELECT count(*) AS n FROM nodejs_webstorage').get().n;"
+    "  return '';"
+    "})";
+
+TEST_F(WebStorageTest, FlushesWritesOnATimer) {
+  const v8::HandleScope handle_scope(isolate_);
+  Argv argv;
+  Env env{handle_scope, argv};
+  Local<Object> state = Object::New(isolate_);
+
+  Run(*env, state, kOpenScript);
+  EXPECT_EQ(Run(*env,
+                state,
+                "(function(internalBinding, state) {"
+                "  state.storage.setItem('a', '1');"
+                "  state.storage.setItem('b', '2');"
+                "  return state.rows() + ' ' + state.storage.getItem('a');"
+                "})"),
+            "0 1");
+  RunLoop(10);
+  EXPECT_EQ(Run(*env,
+                state,
+                "(function(internalBinding, state) {"
+                "  return String(state.rows());"
+                "})"),
+            "2");
+}
+
+TEST_F(WebStorageTest, SeesWritesOfOtherConnections) {
+  const v8::HandleScope handle_scope(isolate_);
+  Argv argv;
+  Env env{handle_scope, argv};
+  Local<Object> state = Object::New(isolate_);
+
+  Run(*env, state, kOpenScript);
+  EXPECT_EQ(Run(*env,
+                state,
+                "(function(internalBinding, state, path) {"
+                "  const { Storage, kConstructorKey } ="
+                "    internalBinding('webstorage');"
+                "  state.other = new Storage(kConstructorKey, path);"
+                "  state.other.setItem('shared', 'other');"
+                "  state.storage.setItem('mine', 'pending');"
+                "  return String(state.storage.getItem('shared'));"
+                "})"),
+            "null");
+  RunLoop(10);
+  // The changes of the other connection are loaded, and those that have not
+  // been written yet stay.
+  EXPECT_EQ(Run(*env,
+                state,
+                "(function(internalBinding, state) {"
+                "  state.other.setItem('late', 'x');"
+                "  return [state.storage.getItem('shared'),"
+                "          state.storage.getItem('mine'),"
+                "          state.other.getItem('mine'),"
+                "          state.storage.length].join(' ');"
+                "})"),
+            "other pending pending 2");
+}
+
+TEST_F(WebStorageTest, RetriesFlushesWhileTheDatabaseIsLocked) {
+  const v8::HandleScope handle_scope(isolate_);
+  Argv argv;
+  Env env{handle_scope, argv};
+  Local<Object> state = Object::New(isolate_);
+
+  Run(*env, state, kOpenScript);
+  Run(*env,
+      state,
+      "(function(internalBinding, state) {"
+      "  state.db.exec('BEGIN IMMEDIATE');"
+      "  state.storage.setItem('a', '1');"
+      "  return '';"
+      "})");
+  // The flush neither blocks the loop nor gives up while the lock is held.
+  uint64_t start = uv_hrtime();
+  RunLoop(50);
+  EXPECT_LT(uv_hrtime() - start, 1000u * 1000 * 1000);
+  EXPECT_EQ(Run(*env,
+                state,
+                "(function(internalBinding, state) {"
+                "  state.db.exec('COMMIT');"
+                "  return String(state.rows());"
+                "})"),
+            "0");
+  RunLoop(1100);
+  EXPECT_EQ(Run(*env,
+                state,
+                "(function(internalBinding, state) {"
+                "  return String(state.rows());"
+                "})"),
+            "1");
+}
+
+TEST_F(WebStorageTest, FlushesAtExit) {
+  const v8::HandleScope handle_scope(isolate_);
+  Argv argv;
+  Env env{handle_scope, argv};
+  Local<Object> state = Object::New(isolate_);
+
+  Run(*env, state, kOpenScript);
+  Run(*env,
+      state,
+      "(function(internalBinding, state) {"
+      "  state.storage.setItem('a', '1');"
+      "  return '';"
+      "})");
+  node::RunAtExit(*env);
+  EXPECT_EQ(Run(*env,
+                state,
+                "(function(internalBinding, state) {"
+                "  return String(state.rows());"
+                "})"),
+            "1");
+}
+
+#endif  // _WIN32
@@ -0,0 +1,11 @@
+{
+  "targets": [
+    {
+      "target_name": "test_property_key_handle",
+      "defines": [ "NAPI_EXPERIMENTAL" ],
+      "sources": [
+        "test_property_key_handle.c"
+      ]
+    }
+  ]
+}
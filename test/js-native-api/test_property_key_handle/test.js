@@ -0,0 +1,62 @@
+'use strict';
+const common = require('../../common');
+const assert = require('assert');
+
+// Testing api calls for property key handles
+const test_property_key_handle =
+  require(`./build/${common.buildType}/test_property_key_handle`);
+
+const { getByKey, setByKey, callByKey, getLength } = test_property_key_handle;
+
+const symbol = Symbol('symbol');
+const object = { name: 'value', [symbol]: 42 };
+assert.strictEqual(getByKey(object, 'name'), 'value');
+assert.strictEqual(getByKey(object, symbol), 42);
+assert.strictEqual(getByKey(object, 'missing'), undefined);
+
+// Inherited properties and getters are looked up like napi_get_property().
+assert.strictEqual(getByKey(object, 'toString'), Object.prototype.toString);
+assert.strictEqual(getByKey({ get answer() { return 42; } }, 'answer'), 42);
+assert.throws(() => getByKey({ get boom() { throw new Error('boom'); } },
+                             'boom'),
+              /^Error: boom$/);
+
+setByKey(object, 'name', 'other');
+setByKey(object, 'added', 1);
+setByKey(object, symbol, 43);
+assert.strictEqual(object.name, 'other');
+assert.strictEqual(object.added, 1);
+assert.strictEqual(object[symbol], 43);
+
+// Primitives are converted to objects like napi_get_property() does.
+assert.strictEqual(getLength('abc'), 3);
+assert.strictEqual(getLength([1, 2]), 2);
+assert.throws(() => getLength(undefined), {
+  message: 'An object was expected',
+});
+
+const receiver = {
+  base: 10,
+  add(a, b) { return this.base + a + b; },
+  [symbol]() { return this; },
+  notAFunction: 1,
+};
+assert.strictEqual(callByKey(receiver, 'add', 1, 2), 13);
+assert.strictEqual(callByKey(receiver, symbol), receiver);
+assert.strictEqual(callByKey([3, 1, 2], 'join', '-'), '3-1-2');
+assert.throws(() => callByKey(receiver, 'notAFunction'), {
+  message: 'A function was expected',
+});
+assert.throws(() => callByKey(receiver, 'missing'), {
+  message: 'A function was expected',
+});
+assert.throws(() => callByKey({ fail() { throw new Error('fail'); } }, 'fail'),
+              /^Error: fail$/);
+
+// Only strings and symbols can be used as keys.
+assert.throws(() => getByKey(object, 1), {
+  message: 'A string or symbol was expected',
+});
+assert.throws(() => setByKey(object, {}, 1), {
+  message: 'A string or symbol was expected',
+});
@@ -0,0 +1,97 @@
+#include <js_native_api.h>
+#include <stdlib.h>
+#include "../common.h"
+#include "../entry_point.h"
+
+// A key handle that lives as long as the env, to check that the handles
+// which are not deleted explicitly are released on teardown.
+static node_api_property_key length_key = NULL;
+
+static napi_value GetByKey(napi_env env, napi_callback_info info) {
+  size_t argc = 2;
+  napi_value args[2];
+  NODE_API_CALL(env, napi_get_cb_info(env, info, &argc, args, NULL, NULL));
+  NODE_API_ASSERT(env, argc == 2, "Wrong number of arguments");
+
+  node_api_property_key key;
+  NODE_API_CALL(env, node_api_create_property_key_handle(env, args[1], &key));
+
+  napi_value result;
+  napi_status status =
+      node_api_get_property_by_key(env, args[0], key, &result);
+  // Throw before deleting the handle, which clears the last error.
+  if (status != napi_ok) GET_AND_THROW_LAST_ERROR(env);
+  NODE_API_CALL(env, node_api_delete_property_key_handle(env, key));
+  return status == napi_ok ? result : NULL;
+}
+
+static napi_value SetByKey(napi_env env, napi_callback_info info) {
+  size_t argc = 3;
+  napi_value args[3];
+  NODE_API_CALL(env, napi_get_cb_info(env, info, &argc, args, NULL, NULL));
+  NODE_API_ASSERT(env, argc == 3, "Wrong number of arguments");
+
+  node_api_property_key key;
+  NODE_API_CALL(env, node_api_create_property_key_handle(env, args[1], &key));
+
+  napi_status status =
+      node_api_set_property_by_key(env, args[0], key, args[2]);
+  if (status != napi_ok) GET_AND_THROW_LAST_ERROR(env);
+  NODE_API_CALL(env, node_api_delete_property_key_handle(env, key));
+  return NULL;
+}
+
+static napi_value CallByKey(napi_env env, napi_callback_info info) {
+  size_t argc = 6;
+  napi_value args[6];
+  NODE_API_CALL(env, napi_get_cb_info(env, info, &argc, args, NULL, NULL));
+  NODE_API_ASSERT(env, argc >= 2, "Wrong number of arguments");
+
+  node_api_property_key key;
+  NODE_API_CALL(env, node_api_create_property_key_handle(env, args[1], &key));
+
+  napi_value result;
+  napi_status status = node_api_call_method_by_key(
+      env, args[0], key, argc - 2, argc > 2 ? args + 2 : NULL, &result);
+  if (status != napi_ok) GET_AND_THROW_LAST_ERROR(env);
+  NODE_API_CALL(env, node_api_delete_property_key_handle(env, key));
+  return status == napi_ok ? result : NULL;
+}
+
+static napi_value GetLength(napi_env env, napi_callback_info info) {
+  size_t argc = 1;
+  napi_value object, result;
+  NODE_API_CALL(env, napi_get_cb_info(env, info, &argc, &object, NULL, NULL));
+  NODE_API_ASSERT(env, argc == 1, "Wrong number of arguments");
+
+  NODE_API_CALL(env,
+                node_api_get_property_by_key(env, object, length_key, &result));
+  return result;
+}
+
+EXTERN_C_START
+napi_value Init(napi_env env, napi_value exports) {
+  napi_value length;
+  NODE_API_CALL(env,
+                node_api_create_property_key_latin1(
+                    env, "length", NAPI_AUTO_LENGTH, &length));
+  NODE_API_CALL(env,
+                node_api_create_property_key_handle(env, length, &length_key));
+
+  napi_property_descriptor descriptors[] = {
+      DECLARE_NODE_API_PROPERTY("getByKey", GetByKey),
+      DECLARE_NODE_API_PROPERTY("setByKey", SetByKey),
+      DECLARE_NODE_API_PROPERTY("callByKey", CallByKey),
+      DECLARE_NODE_API_PROPERTY("getLength", GetLength),
+  };
+
+  NODE_API_CALL(
+      env,
+      napi_define_properties(env,
+                             exports,
+                             sizeof(descriptors) / sizeof(*descriptors),
+                             descriptors));
+
+  return exports;
+}
+EXTERN_C_END
@@ -0,0 +1,66 @@
+#include <stdint.h>
+#include <node_api.h>
+#include "../../js-native-api/common.h"
+
+static uint32_t finalized = 0;
+
+static void Finalize(node_api_basic_env env, void* data, void* hint) {
+  // The data is still readable in the finalizer.
+  finalized += *(uint32_t*)data;
+}
+
+static napi_value Create(napi_env env, napi_callback_info info) {
+  size_t argc = 1;
+  napi_value argv[1];
+  uint32_t value;
+  NODE_API_CALL(env, napi_get_cb_info(env, info, &argc, argv, NULL, NULL));
+  NODE_API_CALL(env, napi_get_value_uint32(env, argv[0], &value));
+
+  void* data;
+  napi_value result;
+  NODE_API_CALL(env,
+                node_api_create_cppgc_object(
+                    env, sizeof(value), Finalize, NULL, &data, &result));
+  *(uint32_t*)data = value;
+  return result;
+}
+
+static napi_value GetValue(napi_env env, napi_callback_info info) {
+  size_t argc = 1;
+  napi_value argv[1];
+  NODE_API_CALL(env, napi_get_cb_info(env, info, &argc, argv, NULL, NULL));
+
+  void* data;
+  napi_value result;
+  if (node_api_get_cppgc_object_data(env, argv[0], &data) != napi_ok) {
+    NODE_API_CALL(env, napi_get_undefined(env, &result));
+    return result;
+  }
+  NODE_API_CALL(env, napi_create_uint32(env, *(uint32_t*)data, &result));
+  return result;
+}
+
+static napi_value GetFinalized(napi_env env, napi_callback_info info) {
+  napi_value result;
+  NODE_API_CALL(env, napi_create_uint32(env, finalized, &result));
+  return result;
+}
+
+// Module init
+static napi_value Init(napi_env env, napi_value exports) {
+  napi_property_descriptor properties[] = {
+      DECLARE_NODE_API_PROPERTY("create", Create),
+      DECLARE_NODE_API_PROPERTY("getValue", GetValue),
+      DECLARE_NODE_API_PROPERTY("getFinalized", GetFinalized),
+  };
+
+  NODE_API_CALL(
+      env,
+      napi_define_properties(env,
+                             exports,
+                             sizeof(properties) / sizeof(properties[0]),
+                             properties));
+
+  return exports;
+}
+NAPI_MODULE(NODE_GYP_MODULE_NAME, Init)
@@ -0,0 +1,11 @@
+{
+  'targets': [
+    {
+      'target_name': 'binding',
+      'defines': [
+        'NAPI_EXPERIMENTAL'
+      ],
+      'sources': ['binding.c']
+    }
+  ]
+}
@@ -0,0 +1,25 @@
+'use strict';
+// Flags: --expose-gc
+
+const common = require('../../common');
+const assert = require('assert');
+const { gcUntil } = require('../../common/gc');
+const binding = require(`./build/${common.buildType}/binding`);
+
+const object = binding.create(42);
+assert.strictEqual(typeof object, 'object');
+assert.strictEqual(binding.getValue(object), 42);
+
+// Only the objects created by the addon carry native data.
+assert.strictEqual(binding.getValue({}), undefined);
+assert.strictEqual(binding.getValue(1), undefined);
+
+(function() {
+  for (let i = 0; i < 100; i++) binding.create(1);
+})();
+
+gcUntil('the unreachable objects are finalized',
+        () => binding.getFinalized() === 100).then(common.mustCall(() => {
+  // The object that is still referenced is alive and intact.
+  assert.strictEqual(binding.getValue(object), 42);
+}));
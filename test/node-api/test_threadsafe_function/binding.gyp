@@ -17,6 +17,13 @@
         'NAPI_EXPERIMENTAL'
       ],
       'sources': ['test_uncaught_exception.c']
+    },
+    {
+      'target_name': 'test_batch',
+      'defines': [
+        'NAPI_EXPERIMENTAL'
+      ],
+      'sources': ['test_batch.c']
     }
   ]
 }
@@ -0,0 +1,98 @@
+#include <stdint.h>
+#include <node_api.h>
+#include "../../js-native-api/common.h"
+
+static void CallJsBatch(napi_env env,
+                        napi_value js_cb,
+                        void* context,
+                        void** data,
+                        size_t count) {
+  // The env is torn down and the items only need to be released.
+  if (env == NULL || js_cb == NULL) return;
+
+  napi_value items, undefined;
+  NODE_API_CALL_RETURN_VOID(env, napi_create_array_with_length(env, count,
+                                                               &items));
+  for (size_t i = 0; i < count; i++) {
+    napi_value item;
+    NODE_API_CALL_RETURN_VOID(
+        env, napi_create_uint32(env, (uint32_t)(uintptr_t)data[i], &item));
+    NODE_API_CALL_RETURN_VOID(env,
+                              napi_set_element(env, items, (uint32_t)i, item));
+  }
+  NODE_API_CALL_RETURN_VOID(env, napi_get_undefined(env, &undefined));
+  NODE_API_CALL_RETURN_VOID(
+      env, napi_call_function(env, undefined, js_cb, 1, &items, NULL));
+}
+
+static void ThreadSafeFunctionFinalize(napi_env env,
+                                       void* finalize_data,
+                                       void* finalize_hint) {
+  napi_ref js_func_ref = (napi_ref)finalize_data;
+  napi_value js_func, undefined;
+  NODE_API_CALL_RETURN_VOID(
+      env, napi_get_reference_value(env, js_func_ref, &js_func));
+  NODE_API_CALL_RETURN_VOID(env, napi_get_undefined(env, &undefined));
+  NODE_API_CALL_RETURN_VOID(
+      env, napi_call_function(env, undefined, js_func, 0, NULL, NULL));
+  NODE_API_CALL_RETURN_VOID(env, napi_delete_reference(env, js_func_ref));
+}
+
+// Queues count items before the loop gets to dispatch any of them, so that
+// they are delivered in batches of max_batch_size.
+static napi_value CallInBatches(napi_env env, napi_callback_info info) {
+  size_t argc = 4;
+  napi_value argv[4], resource_name;
+  uint32_t count, max_batch_size;
+  NODE_API_CALL(env, napi_get_cb_info(env, info, &argc, argv, NULL, NULL));
+  NODE_API_ASSERT(env, argc == 4, "Wrong number of arguments");
+  NODE_API_CALL(env, napi_get_value_uint32(env, argv[1], &count));
+  NODE_API_CALL(env, napi_get_value_uint32(env, argv[2], &max_batch_size));
+
+  napi_ref finalize_func;
+  NODE_API_CALL(env, napi_create_reference(env, argv[3], 1, &finalize_func));
+  NODE_API_CALL(env,
+                napi_create_string_utf8(
+                    env, "batch", NAPI_AUTO_LENGTH, &resource_name));
+
+  napi_threadsafe_function tsfn;
+  NODE_API_CALL(env,
+                napi_create_threadsafe_function(env,
+                                                argv[0],
+                                                NULL,
+                                                resource_name,
+                                                0,
+                                                1,
+                                                finalize_func,
+                                                ThreadSafeFunctionFinalize,
+                                                NULL,
+                                                NULL,
+                                                &tsfn));
+  NODE_API_CALL(env,
+                node_api_set_threadsafe_function_batch_cb(
+                    env, tsfn, CallJsBatch, max_batch_size));
+  for (uint32_t i = 0; i < count; i++) {
+    NODE_API_CALL(env,
+                  napi_call_threadsafe_function(
+                      tsfn, (void*)(uintptr_t)i, napi_tsfn_blocking));
+  }
+  NODE_API_CALL(env, napi_release_threadsafe_function(tsfn, napi_tsfn_release));
+  return NULL;
+}
+
+// Module init
+static napi_value Init(napi_env env, napi_value exports) {
+  napi_property_descriptor properties[] = {
+      DECLARE_NODE_API_PROPERTY("CallInBatches", CallInBatches),
+  };
+
+  NODE_API_CALL(
+      env,
+      napi_define_properties(env,
+                             exports,
+                             sizeof(properties) / sizeof(properties[0]),
+                             properties));
+
+  return exports;
+}
+NAPI_MODULE(NODE_GYP_MODULE_NAME, Init)
@@ -0,0 +1,31 @@
+'use strict';
+
+const common = require('../../common');
+const assert = require('assert');
+const binding = require(`./build/${common.buildType}/test_batch`);
+
+function testBatches(count, maxBatchSize) {
+  return new Promise((resolve) => {
+    const batches = [];
+    binding.CallInBatches((items) => {
+      batches.push(items);
+    }, count, maxBatchSize, common.mustCall(() => {
+      resolve(batches);
+    }));
+  });
+}
+
+(async function() {
+  // All items are queued before the first dispatch, so every batch but the
+  // last one is full.
+  let batches = await testBatches(10, 4);
+  assert.deepStrictEqual(batches, [[0, 1, 2, 3], [4, 5, 6, 7], [8, 9]]);
+
+  batches = await testBatches(5, 1);
+  assert.deepStrictEqual(batches, [[0], [1], [2], [3], [4]]);
+
+  // Without a limit, all queued items are delivered at once.
+  batches = await testBatches(1000, 0);
+  assert.strictEqual(batches.length, 1);
+  assert.deepStrictEqual(batches[0], Array.from({ length: 1000 }, (_, i) => i));
+})().then(common.mustCall());